@@ -80,6 +80,10 @@ typedef struct tc_parameters_struct tc_parameters;
 struct tc_model_struct;
 typedef struct tc_model_struct tc_model;
 
+// A method of a model, looked up once for repeated calls
+struct tc_model_method_struct;
+typedef struct tc_model_method_struct tc_model_method;
+
 struct tc_flex_enum_list_struct;
 typedef struct tc_flex_enum_list_struct tc_flex_enum_list;
 
@@ -87,6 +91,10 @@ typedef struct tc_flex_enum_list_struct tc_flex_enum_list;
 struct tc_plot_struct;
 typedef struct tc_plot_struct tc_plot;
 
+// Arrow C data interface structures, defined in the Arrow headers
+struct ArrowSchema;
+struct ArrowArray;
+
 /******************************************************************************/
 /*                                                                            */
 /*    INITIALIZATION                                                          */
@@ -582,6 +590,15 @@ tc_sframe* tc_sframe_read_json_lines(const char *url, tc_error **error);
 // Write csv etc.
 void tc_sframe_export(const tc_sframe* sf, const char *url, const char* format, const tc_parameters*, tc_error **error);
 
+// Export through the Arrow C data interface, as a struct array with one child
+// per column. Int, float, str and datetime columns are supported. The caller
+// must call the release callbacks of out_schema and out_array.
+void tc_sframe_export_arrow(const tc_sframe* sf, struct ArrowSchema* out_schema, struct ArrowArray* out_array, tc_error** error);
+
+// Import a struct array through the Arrow C data interface, with one column
+// per child. The schema and array are released.
+tc_sframe* tc_sframe_import_arrow(struct ArrowSchema* schema, struct ArrowArray* array, tc_error** error);
+
 // Head
 tc_sframe* tc_sframe_head(const tc_sframe* sf, size_t n, tc_error **error);
 
@@ -836,6 +853,23 @@ const char* tc_model_name(const tc_model*, tc_error**);
 tc_variant* tc_model_call_method(const tc_model* model, const char* method,
                                  const tc_parameters* arguments, tc_error**);
 
+/** Looks up a method of a model once, for repeated calls with
+ *  tc_model_method_call.  The method handle keeps the model alive, and must
+ *  be released with tc_release.
+ */
+tc_model_method* tc_model_method_lookup(const tc_model* model, const char* method,
+                                        tc_error**);
+
+/** Calls a method looked up with tc_model_method_lookup.  The arguments are
+ *  given positionally, in the order the method declares them; trailing
+ *  arguments with default values may be omitted.  Unlike
+ *  tc_model_call_method, this does not build or search a map of named
+ *  arguments on each call.
+ */
+tc_variant* tc_model_method_call(const tc_model_method* method,
+                                 const tc_variant* const* arguments,
+                                 uint64_t num_arguments, tc_error**);
+
 /******************************************************************************/
 /*                                                                            */
 /*   Interaction with registered functions                                    */
@@ -135,3 +135,40 @@ EXPORT tc_variant* tc_model_call_method(const tc_model* model, const char* metho
   ERROR_HANDLE_END(error, NULL);
 }
 
+EXPORT tc_model_method* tc_model_method_lookup(const tc_model* model,
+                                               const char* method,
+                                               tc_error** error) {
+  ERROR_HANDLE_START();
+  turi::ensure_server_initialized();
+  CHECK_NOT_NULL(error, model, "model", nullptr);
+  CHECK_NOT_NULL(error, method, "method", nullptr);
+
+  tc_model_method* ret = new_tc_model_method();
+  ret->value.model = model->value;
+  ret->value.call = model->value->get_method_handle(method);
+  return ret;
+
+  ERROR_HANDLE_END(error, nullptr);
+}
+
+EXPORT tc_variant* tc_model_method_call(const tc_model_method* method,
+                                        const tc_variant* const* arguments,
+                                        uint64_t num_arguments,
+                                        tc_error** error) {
+  ERROR_HANDLE_START();
+  CHECK_NOT_NULL(error, method, "method", nullptr);
+  if (num_arguments > 0) {
+    CHECK_NOT_NULL(error, arguments, "arguments", nullptr);
+  }
+
+  std::vector<turi::variant_type> args;
+  args.reserve(num_arguments);
+  for (uint64_t i = 0; i < num_arguments; ++i) {
+    CHECK_NOT_NULL(error, arguments[i], "argument", nullptr);
+    args.push_back(arguments[i]->value);
+  }
+
+  return new_tc_variant(method->value.call(args));
+
+  ERROR_HANDLE_END(error, nullptr);
+}
@@ -12,6 +12,8 @@
 #include <core/data/flexible_type/flexible_type.hpp>
 #include <core/data/sframe/gl_sarray.hpp>
 #include <core/data/sframe/gl_sframe.hpp>
+#include <core/storage/sframe_data/arrow_interchange.hpp>
+#include <core/storage/sframe_interface/unity_sframe.hpp>
 
 extern "C" {
 
@@ -501,6 +503,35 @@ EXPORT void tc_sframe_export(const tc_sframe* sf, const char* url,
   ERROR_HANDLE_END(error);
 }
 
+EXPORT void tc_sframe_export_arrow(const tc_sframe* sf, ArrowSchema* out_schema,
+                                   ArrowArray* out_array, tc_error** error) {
+  ERROR_HANDLE_START();
+  turi::ensure_server_initialized();
+
+  CHECK_NOT_NULL(error, sf, "sframe");
+  CHECK_NOT_NULL(error, out_schema, "ArrowSchema");
+  CHECK_NOT_NULL(error, out_array, "ArrowArray");
+
+  sf->value.get_proxy()->export_to_arrow(out_schema, out_array);
+
+  ERROR_HANDLE_END(error);
+}
+
+EXPORT tc_sframe* tc_sframe_import_arrow(ArrowSchema* schema, ArrowArray* array,
+                                         tc_error** error) {
+  ERROR_HANDLE_START();
+  turi::ensure_server_initialized();
+
+  CHECK_NOT_NULL(error, schema, "ArrowSchema", NULL);
+  CHECK_NOT_NULL(error, array, "ArrowArray", NULL);
+
+  auto proxy = std::make_shared<turi::unity_sframe>();
+  proxy->construct_from_arrow(schema, array);
+  return new_tc_sframe(turi::gl_sframe(proxy));
+
+  ERROR_HANDLE_END(error, NULL);
+}
+
 EXPORT tc_sframe* tc_sframe_head(const tc_sframe* sf, size_t n,
                                  tc_error** error) {
   ERROR_HANDLE_START();
@@ -1115,6 +1146,7 @@ EXPORT void tc_groupby_aggregator_add_simple_aggregator(
     AGG_OP("stdv", STDV),
     AGG_OP("select_one", SELECT_ONE),
     AGG_OP("count_distinct", COUNT_DISTINCT),
+    AGG_OP("approx_count_distinct", APPROX_COUNT_DISTINCT),
     AGG_OP("concat", CONCAT)
   };
 
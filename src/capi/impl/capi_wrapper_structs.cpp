@@ -21,5 +21,6 @@ DEFINE_CAPI_WRAPPER_STRUCT_TYPE_INFO(tc_sframe);
 DEFINE_CAPI_WRAPPER_STRUCT_TYPE_INFO(tc_variant);
 DEFINE_CAPI_WRAPPER_STRUCT_TYPE_INFO(tc_parameters);
 DEFINE_CAPI_WRAPPER_STRUCT_TYPE_INFO(tc_model);
+DEFINE_CAPI_WRAPPER_STRUCT_TYPE_INFO(tc_model_method);
 DEFINE_CAPI_WRAPPER_STRUCT_TYPE_INFO(tc_groupby_aggregator);
 DEFINE_CAPI_WRAPPER_STRUCT_TYPE_INFO(tc_plot);
@@ -75,6 +75,13 @@ struct capi_struct_type_info {
 
 typedef std::map<std::string, turi::aggregate::groupby_descriptor_type> groupby_aggregator_map_type;
 
+// A method of a model, resolved for repeated calls.  The model is held so
+// that the handle, which refers to it, stays valid.
+struct capi_model_method {
+  std::shared_ptr<turi::model_base> model;
+  turi::model_base::method_handle call;
+};
+
 DECLARE_CAPI_WRAPPER_STRUCT(tc_error, std::string);
 DECLARE_CAPI_WRAPPER_STRUCT(tc_datetime, turi::flex_date_time);
 DECLARE_CAPI_WRAPPER_STRUCT(tc_flex_dict, turi::flex_dict);
@@ -88,6 +95,7 @@ DECLARE_CAPI_WRAPPER_STRUCT(tc_sframe, turi::gl_sframe);
 DECLARE_CAPI_WRAPPER_STRUCT(tc_variant, turi::variant_type);
 DECLARE_CAPI_WRAPPER_STRUCT(tc_parameters, turi::variant_map_type);
 DECLARE_CAPI_WRAPPER_STRUCT(tc_model, std::shared_ptr<turi::model_base>);
+DECLARE_CAPI_WRAPPER_STRUCT(tc_model_method, capi_model_method);
 DECLARE_CAPI_WRAPPER_STRUCT(tc_groupby_aggregator, groupby_aggregator_map_type);
 DECLARE_CAPI_WRAPPER_STRUCT(tc_plot, std::shared_ptr<turi::visualization::Plot>);
 
@@ -0,0 +1,380 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <cstdlib>
+#include <core/data/flexible_type/date_time_format.hpp>
+
+namespace turi {
+namespace flexible_type_impl {
+
+namespace {
+
+constexpr int64_t SECONDS_PER_DAY = 86400;
+constexpr int64_t MICROSECONDS_PER_SECOND = flex_date_time::MICROSECONDS_PER_SECOND;
+/// The years boost::gregorian can represent
+constexpr int64_t MIN_YEAR = 1400;
+constexpr int64_t MAX_YEAR = 9999;
+
+/// Days since 1970-01-01 of a date of the proleptic gregorian calendar
+int64_t days_from_civil(int64_t y, int64_t m, int64_t d) {
+  y -= m <= 2;
+  int64_t era = (y >= 0 ? y : y - 399) / 400;
+  int64_t yoe = y - era * 400;
+  int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+/// Inverse of days_from_civil
+void civil_from_days(int64_t z, int64_t& y, int64_t& m, int64_t& d) {
+  z += 719468;
+  int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  int64_t doe = z - era * 146097;
+  int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  int64_t mp = (5 * doy + 2) / 153;
+  d = doy - (153 * mp + 2) / 5 + 1;
+  m = mp < 10 ? mp + 3 : mp - 9;
+  y = yoe + era * 400 + (m <= 2);
+}
+
+int64_t days_in_month(int64_t y, int64_t m) {
+  static const int64_t days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  if (m == 2 && (y % 4 == 0 && (y % 100 != 0 || y % 400 == 0))) return 29;
+  return days[m - 1];
+}
+
+int64_t floor_div(int64_t a, int64_t b) {
+  int64_t q = a / b;
+  if ((a % b != 0) && ((a < 0) != (b < 0))) --q;
+  return q;
+}
+
+/// Appends value zero padded to width digits. value is non negative.
+void append_digits(std::string& out, int64_t value, size_t width) {
+  char buf[20];
+  size_t n = 0;
+  do {
+    buf[n++] = '0' + (value % 10);
+    value /= 10;
+  } while (value > 0 && n < sizeof(buf));
+  for (size_t i = n; i < width; ++i) out.push_back('0');
+  while (n > 0) out.push_back(buf[--n]);
+}
+
+/// Reads exactly width digits at input[pos]
+bool read_digits(const char* input, size_t len, size_t& pos, size_t width, int64_t& value) {
+  if (pos + width > len) return false;
+  value = 0;
+  for (size_t i = 0; i < width; ++i) {
+    char c = input[pos + i];
+    if (c < '0' || c > '9') return false;
+    value = value * 10 + (c - '0');
+  }
+  pos += width;
+  return true;
+}
+
+bool is_alpha(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+} // anonymous namespace
+
+
+civil_time civil_time_from_timestamp(int64_t timestamp) {
+  civil_time ret;
+  int64_t days = floor_div(timestamp, SECONDS_PER_DAY);
+  int64_t second_of_day = timestamp - days * SECONDS_PER_DAY;
+  civil_from_days(days, ret.year, ret.month, ret.day);
+  ret.hour = second_of_day / 3600;
+  ret.minute = (second_of_day / 60) % 60;
+  ret.second = second_of_day % 60;
+  // 1970-01-01 was a Thursday
+  ret.weekday = days + 4 - floor_div(days + 4, 7) * 7;
+  ret.yearday = days - days_from_civil(ret.year, 1, 1) + 1;
+  return ret;
+}
+
+date_time_format::date_time_format(const std::string& format) : m_format(format) {
+  bool can_parse = true;
+  bool has_year = false, has_month = false, has_day = false;
+  for (size_t i = 0; i < format.size(); ++i) {
+    if (format[i] != '%') {
+      if (m_fields.empty() || m_fields.back().type != field_type::LITERAL) {
+        m_fields.push_back(field{field_type::LITERAL, ""});
+      }
+      m_fields.back().literal.push_back(format[i]);
+      continue;
+    }
+    if (i + 1 == format.size()) return;
+    char directive = format[++i];
+    field_type type;
+    switch (directive) {
+      case 'Y': type = field_type::YEAR; has_year = true; break;
+      case 'm': type = field_type::MONTH; has_month = true; break;
+      case 'd': type = field_type::DAY; has_day = true; break;
+      case 'H': type = field_type::HOUR; break;
+      case 'M': type = field_type::MINUTE; break;
+      case 'S': type = field_type::SECOND; break;
+      case 'F': type = field_type::FRACTION_OR_NONE; break;
+      case 'q': type = field_type::ISO_ZONE; break;
+      case 'Q': type = field_type::ISO_EXTENDED_ZONE; break;
+      case 'y': type = field_type::SHORT_YEAR; can_parse = false; break;
+      case 'j': type = field_type::DAY_OF_YEAR; can_parse = false; break;
+      case 'f': type = field_type::FRACTION; can_parse = false; break;
+      case 's': type = field_type::SECOND_WITH_FRACTION; can_parse = false; break;
+      case 'T': type = field_type::TIME; can_parse = false; break;
+      case 'Z':
+        if (i + 1 < format.size() && format[i + 1] == 'P') {
+          type = field_type::POSIX_ZONE;
+          ++i;
+          break;
+        }
+        return;
+      case '%':
+        if (m_fields.empty() || m_fields.back().type != field_type::LITERAL) {
+          m_fields.push_back(field{field_type::LITERAL, ""});
+        }
+        m_fields.back().literal.push_back('%');
+        can_parse = false;
+        continue;
+      default:
+        // anything else (names of months and days, %e, ...) is left to boost
+        return;
+    }
+    m_fields.push_back(field{type, ""});
+  }
+  // %ZP reads everything up to the end of the input
+  for (size_t i = 0; i + 1 < m_fields.size(); ++i) {
+    if (m_fields[i].type == field_type::POSIX_ZONE) can_parse = false;
+  }
+  m_can_format = true;
+  m_can_parse = can_parse && has_year && has_month && has_day;
+
+  for (int32_t tz = flex_date_time::TIMEZONE_LOW; tz <= flex_date_time::TIMEZONE_HIGH; ++tz) {
+    int64_t minutes = std::abs(tz) * flex_date_time::TIMEZONE_RESOLUTION_IN_MINUTES;
+    std::string sign = tz < 0 ? "-" : "+";
+    std::string hh, mm;
+    append_digits(hh, minutes / 60, 2);
+    append_digits(mm, minutes % 60, 2);
+    m_iso_zone.push_back(sign + hh + mm);
+    m_iso_extended_zone.push_back(sign + hh + ":" + mm);
+    // boost writes odd things for offsets which are not whole hours
+    m_posix_zone.push_back(minutes % 60 == 0 ? "GMT" + sign + hh : "");
+  }
+}
+
+bool date_time_format::parse_posix_zone(const char* input, size_t len,
+                                        bool& has_zone, int64_t& zone_seconds) const {
+  size_t pos = 0;
+  while (pos < len && is_alpha(input[pos])) ++pos;
+  bool has_name = pos > 0;
+  zone_seconds = 0;
+  if (pos == len) {
+    // a name alone is a zone at UTC
+    has_zone = has_name;
+    return true;
+  }
+  if (input[pos] != '+' && input[pos] != '-') return false;
+  int64_t sign = input[pos] == '-' ? -1 : 1;
+  ++pos;
+  int64_t hours = 0, minutes = 0;
+  if (!read_digits(input, len, pos, 2, hours) && !read_digits(input, len, pos, 1, hours)) {
+    return false;
+  }
+  if (pos < len) {
+    if (input[pos] != ':') return false;
+    ++pos;
+    if (!read_digits(input, len, pos, 2, minutes)) return false;
+  }
+  if (pos != len || hours > 12 || minutes > 59) return false;
+  has_zone = true;
+  zone_seconds = sign * (hours * 3600 + minutes * 60);
+  return true;
+}
+
+bool date_time_format::try_parse(const char* input, size_t len, flex_date_time& out) const {
+  if (!m_can_parse) return false;
+  size_t pos = 0;
+  int64_t year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+  int64_t fraction = 0;
+  bool has_zone = false;
+  int64_t zone_seconds = 0;
+  for (const auto& f: m_fields) {
+    switch (f.type) {
+      case field_type::LITERAL:
+        if (len - pos < f.literal.size() ||
+            f.literal.compare(0, f.literal.size(), input + pos, f.literal.size()) != 0) {
+          return false;
+        }
+        pos += f.literal.size();
+        break;
+      case field_type::YEAR:
+        if (!read_digits(input, len, pos, 4, year)) return false;
+        break;
+      case field_type::MONTH:
+        if (!read_digits(input, len, pos, 2, month)) return false;
+        break;
+      case field_type::DAY:
+        if (!read_digits(input, len, pos, 2, day)) return false;
+        break;
+      case field_type::HOUR:
+        if (!read_digits(input, len, pos, 2, hour)) return false;
+        break;
+      case field_type::MINUTE:
+        if (!read_digits(input, len, pos, 2, minute)) return false;
+        break;
+      case field_type::SECOND:
+        if (!read_digits(input, len, pos, 2, second)) return false;
+        break;
+      case field_type::FRACTION_OR_NONE:
+        if (pos < len && input[pos] == '.') {
+          ++pos;
+          size_t num_digits = 0;
+          fraction = 0;
+          // digits past the microseconds are truncated
+          while (pos < len && input[pos] >= '0' && input[pos] <= '9') {
+            if (num_digits < 6) fraction = fraction * 10 + (input[pos] - '0');
+            ++num_digits;
+            ++pos;
+          }
+          if (num_digits == 0) return false;
+          for (; num_digits < 6; ++num_digits) fraction *= 10;
+        }
+        break;
+      case field_type::ISO_ZONE:
+      case field_type::ISO_EXTENDED_ZONE:
+        // boost does not read these
+        break;
+      case field_type::POSIX_ZONE:
+        if (!parse_posix_zone(input + pos, len - pos, has_zone, zone_seconds)) return false;
+        pos = len;
+        break;
+      default:
+        return false;
+    }
+  }
+  if (pos != len) return false;
+  if (year < MIN_YEAR || year > MAX_YEAR || month < 1 || month > 12 ||
+      day < 1 || day > days_in_month(year, month) ||
+      hour > 23 || minute > 59 || second > 59) {
+    return false;
+  }
+
+  int64_t seconds = days_from_civil(year, month, day) * SECONDS_PER_DAY +
+                    hour * 3600 + minute * 60 + second - zone_seconds;
+  int64_t ticks = seconds * MICROSECONDS_PER_SECOND + fraction;
+  // the same truncations as ptime_to_time_t and
+  // ptime_to_fractional_microseconds
+  int64_t time = ticks / MICROSECONDS_PER_SECOND;
+  double fractional_seconds =
+      double(ticks - time * MICROSECONDS_PER_SECOND) / MICROSECONDS_PER_SECOND;
+  int32_t microseconds = (flex_int)(fractional_seconds * MICROSECONDS_PER_SECOND);
+  // fractions of seconds before 1970 make invalid values, rejected by boost
+  if (microseconds < 0) return false;
+  int32_t timezone_offset = flex_date_time::EMPTY_TIMEZONE;
+  if (has_zone) {
+    timezone_offset = static_cast<int32_t>(zone_seconds) /
+                      flex_date_time::TIMEZONE_RESOLUTION_IN_SECONDS;
+    if (timezone_offset < flex_date_time::TIMEZONE_LOW ||
+        timezone_offset > flex_date_time::TIMEZONE_HIGH) {
+      return false;
+    }
+  }
+  out = flex_date_time(time, timezone_offset, microseconds);
+  return true;
+}
+
+bool date_time_format::try_format(const flex_date_time& value, std::string& out) const {
+  if (!m_can_format) return false;
+  int32_t tz = value.time_zone_offset();
+  bool has_zone = tz != flex_date_time::EMPTY_TIMEZONE;
+  if (has_zone && (tz < flex_date_time::TIMEZONE_LOW || tz > flex_date_time::TIMEZONE_HIGH)) {
+    return false;
+  }
+  size_t zone_index = has_zone ? tz - flex_date_time::TIMEZONE_LOW : 0;
+
+  int64_t timestamp = value.posix_timestamp();
+  // way past the years boost supports, and it keeps the ticks from overflowing
+  if (timestamp > (int64_t(1) << 40) || timestamp < -(int64_t(1) << 40)) return false;
+  int64_t ticks = timestamp * MICROSECONDS_PER_SECOND + value.microsecond();
+  if (has_zone) {
+    ticks += int64_t(tz) * flex_date_time::TIMEZONE_RESOLUTION_IN_SECONDS * MICROSECONDS_PER_SECOND;
+  }
+  int64_t seconds = floor_div(ticks, MICROSECONDS_PER_SECOND);
+  int64_t fraction = ticks - seconds * MICROSECONDS_PER_SECOND;
+  civil_time t = civil_time_from_timestamp(seconds);
+  if (t.year < MIN_YEAR || t.year > MAX_YEAR) return false;
+
+  for (const auto& f: m_fields) {
+    switch (f.type) {
+      case field_type::LITERAL:
+        out.append(f.literal);
+        break;
+      case field_type::YEAR:
+        append_digits(out, t.year, 4);
+        break;
+      case field_type::SHORT_YEAR:
+        append_digits(out, t.year % 100, 2);
+        break;
+      case field_type::MONTH:
+        append_digits(out, t.month, 2);
+        break;
+      case field_type::DAY:
+        append_digits(out, t.day, 2);
+        break;
+      case field_type::DAY_OF_YEAR:
+        append_digits(out, t.yearday, 3);
+        break;
+      case field_type::HOUR:
+        append_digits(out, t.hour, 2);
+        break;
+      case field_type::MINUTE:
+        append_digits(out, t.minute, 2);
+        break;
+      case field_type::SECOND:
+        append_digits(out, t.second, 2);
+        break;
+      case field_type::FRACTION:
+        append_digits(out, fraction, 6);
+        break;
+      case field_type::FRACTION_OR_NONE:
+        if (fraction != 0) {
+          out.push_back('.');
+          append_digits(out, fraction, 6);
+        }
+        break;
+      case field_type::SECOND_WITH_FRACTION:
+        append_digits(out, t.second, 2);
+        out.push_back('.');
+        append_digits(out, fraction, 6);
+        break;
+      case field_type::TIME:
+        append_digits(out, t.hour, 2);
+        out.push_back(':');
+        append_digits(out, t.minute, 2);
+        out.push_back(':');
+        append_digits(out, t.second, 2);
+        break;
+      case field_type::ISO_ZONE:
+        out.append(has_zone ? m_iso_zone[zone_index] : "+0000");
+        break;
+      case field_type::ISO_EXTENDED_ZONE:
+        out.append(has_zone ? m_iso_extended_zone[zone_index] : "+00:00");
+        break;
+      case field_type::POSIX_ZONE:
+        if (has_zone) {
+          if (m_posix_zone[zone_index].empty()) return false;
+          out.append(m_posix_zone[zone_index]);
+        }
+        break;
+    }
+  }
+  return true;
+}
+
+} // namespace flexible_type_impl
+} // namespace turi
@@ -0,0 +1,122 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_FLEXIBLE_TYPE_DATE_TIME_FORMAT_HPP
+#define TURI_FLEXIBLE_TYPE_DATE_TIME_FORMAT_HPP
+#include <string>
+#include <vector>
+#include <core/data/flexible_type/flexible_type_base_types.hpp>
+
+namespace turi {
+namespace flexible_type_impl {
+
+/**
+ * The calendar fields of a posix timestamp, in the proleptic gregorian
+ * calendar.
+ */
+struct civil_time {
+  int64_t year;
+  int64_t month;    ///< 1 to 12
+  int64_t day;      ///< 1 to 31
+  int64_t hour;
+  int64_t minute;
+  int64_t second;
+  int64_t weekday;  ///< 0 (Sunday) to 6, as std::tm::tm_wday
+  int64_t yearday;  ///< 1 to 366
+};
+
+/**
+ * Returns the calendar fields of timestamp, without the boost::posix_time
+ * round trip (nor its 1400..9999 year range).
+ */
+civil_time civil_time_from_timestamp(int64_t timestamp);
+
+/**
+ * A date time format string, as understood by the boost::date_time facets,
+ * compiled once into a list of fields so that flex_date_time values can be
+ * parsed and formatted without going through iostreams and locale facets.
+ *
+ * Only the common fixed width directives are compiled: %Y %m %d %H %M %S,
+ * %F, literal characters, and the time zone directives %q %Q and %ZP (the
+ * latter only as the last directive when parsing). Formatting additionally
+ * supports %y %j %f %s %T and %%.
+ *
+ * try_parse() and try_format() return false whenever they cannot guarantee
+ * the result boost would produce: an unsupported directive, an input which
+ * does not match the format exactly, a date outside of the 1400..9999 range
+ * supported by boost, etc. The caller then falls back to boost, so the
+ * results are always identical to those of the boost facets.
+ */
+class date_time_format {
+ public:
+  explicit date_time_format(const std::string& format);
+
+  /// The format string
+  const std::string& format() const { return m_format; }
+
+  /// False if try_parse() always fails with this format
+  bool can_parse() const { return m_can_parse; }
+
+  /// False if try_format() always fails with this format
+  bool can_format() const { return m_can_format; }
+
+  /**
+   * Parses the len characters at input into out. Returns false if the
+   * value must be parsed by boost instead.
+   */
+  bool try_parse(const char* input, size_t len, flex_date_time& out) const;
+
+  /**
+   * Formats value, appending to out. Returns false, leaving out in an
+   * unspecified state, if the value must be formatted by boost instead.
+   */
+  bool try_format(const flex_date_time& value, std::string& out) const;
+
+ private:
+  enum class field_type {
+    LITERAL,
+    YEAR,                   ///< %Y
+    SHORT_YEAR,             ///< %y
+    MONTH,                  ///< %m
+    DAY,                    ///< %d
+    DAY_OF_YEAR,            ///< %j
+    HOUR,                   ///< %H
+    MINUTE,                 ///< %M
+    SECOND,                 ///< %S
+    FRACTION,               ///< %f
+    FRACTION_OR_NONE,       ///< %F
+    SECOND_WITH_FRACTION,   ///< %s
+    TIME,                   ///< %T
+    ISO_ZONE,               ///< %q
+    ISO_EXTENDED_ZONE,      ///< %Q
+    POSIX_ZONE              ///< %ZP
+  };
+
+  struct field {
+    field_type type;
+    std::string literal;
+  };
+
+  bool parse_posix_zone(const char* input, size_t len,
+                        bool& has_zone, int64_t& zone_seconds) const;
+
+  std::string m_format;
+  std::vector<field> m_fields;
+  bool m_can_parse = false;
+  bool m_can_format = false;
+
+  /**
+   * The %q, %Q and %ZP text of every time zone offset from TIMEZONE_LOW to
+   * TIMEZONE_HIGH. Offsets with an empty %ZP text are formatted by boost.
+   */
+  std::vector<std::string> m_iso_zone;
+  std::vector<std::string> m_iso_extended_zone;
+  std::vector<std::string> m_posix_zone;
+};
+
+} // namespace flexible_type_impl
+} // namespace turi
+
+#endif
@@ -7,6 +7,7 @@
 #include <boost/date_time/local_time/local_time.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <core/data/flexible_type/flexible_type.hpp>
+#include <core/data/flexible_type/date_time_format.hpp>
 #include <core/logging/assertions.hpp>
 #include <core/data/image/image_util_impl.hpp>
 
@@ -73,20 +74,31 @@ std::string date_time_to_string(const flex_date_time& i) {
                        i.microsecond()));
 }
 
-date_time_string_reader::date_time_string_reader(std::string format)
+date_time_string_reader::date_time_string_reader(std::string format,
+                                                 bool use_compiled_format)
     : format_(std::move(format)) {
   if (format_.empty()) {
     format_ = "%Y%m%dT%H%M%S%F%q";
   }
+  if (use_compiled_format) {
+    compiled_.reset(new date_time_format(format_));
+  }
 
   auto* facet = new boost::local_time::local_time_input_facet(format_);
   stream_.imbue(std::locale(stream_.getloc(), facet));
   stream_.exceptions(std::ios_base::failbit);
 }
 
+date_time_string_reader::~date_time_string_reader() { }
+
 flex_date_time date_time_string_reader::read(const flex_string& input) {
+  flex_date_time ret;
+  if (compiled_ && compiled_->try_parse(input.data(), input.size(), ret)) {
+    return ret;
+  }
   try {
     boost::local_time::local_date_time ldt(boost::posix_time::not_a_date_time);
+    stream_.clear(); // a previous failure leaves the stream failed
     stream_.str(input);
     stream_ >> ldt; // do the parse
 
@@ -106,6 +118,77 @@ flex_date_time date_time_string_reader::read(const flex_string& input) {
   }
 }
 
+struct date_time_string_writer::boost_writer {
+  std::ostringstream stream;
+  /// time zone of datetimes without one
+  boost::local_time::time_zone_ptr empty_zone;
+  /// by offset, from TIMEZONE_LOW. Created when first needed.
+  std::vector<boost::local_time::time_zone_ptr> zones;
+
+  explicit boost_writer(const std::string& format) {
+    using namespace boost::local_time;
+    using boost::posix_time::time_duration;
+    stream.exceptions(std::ios_base::failbit);
+    stream.imbue(std::locale(stream.getloc(), new local_time_facet(format.c_str())));
+    time_zone_names empty_names("", "", "", "");
+    dst_adjustment_offsets empty_adj_offsets(time_duration(0,0,0),
+                                             time_duration(0,0,0),
+                                             time_duration(0,0,0));
+    empty_zone.reset(new custom_time_zone(empty_names, time_duration(0,0,0),
+                                          empty_adj_offsets,
+                                          boost::shared_ptr<dst_calc_rule>()));
+    zones.resize(flex_date_time::TIMEZONE_HIGH - flex_date_time::TIMEZONE_LOW + 1);
+  }
+
+  const boost::local_time::time_zone_ptr& get_zone(int32_t offset) {
+    if (offset == flex_date_time::EMPTY_TIMEZONE) return empty_zone;
+    auto& zone = zones.at(offset - flex_date_time::TIMEZONE_LOW);
+    if (!zone) {
+      // a GMT0. or GMT-0. prefix followed by the offset in minutes
+      std::string prefix = offset < 0 ? "-0." : "0.";
+      zone.reset(new boost::local_time::posix_time_zone(
+          "GMT" + prefix +
+          std::to_string(std::abs(offset) * flex_date_time::TIMEZONE_RESOLUTION_IN_MINUTES)));
+    }
+    return zone;
+  }
+
+  flex_string write(const flex_date_time& value) {
+    boost::local_time::local_date_time az(
+        ptime_from_time_t(value.posix_timestamp(), value.microsecond()),
+        get_zone(value.time_zone_offset()));
+    stream << az;
+    flex_string ret = stream.str();
+    stream.str(std::string()); // need to clear stringstream buffer
+    return ret;
+  }
+};
+
+date_time_string_writer::date_time_string_writer(std::string format,
+                                                 bool use_compiled_format)
+    : format_(std::move(format)) {
+  if (use_compiled_format) {
+    compiled_.reset(new date_time_format(format_));
+  }
+}
+
+date_time_string_writer::~date_time_string_writer() { }
+
+flex_string date_time_string_writer::write(const flex_date_time& value) {
+  flex_string ret;
+  if (compiled_ && compiled_->try_format(value, ret)) {
+    return ret;
+  }
+  try {
+    if (!boost_writer_) boost_writer_.reset(new boost_writer(format_));
+    return boost_writer_->write(value);
+  } catch (...) {
+    // the stream may be left failed
+    boost_writer_.reset();
+    log_and_throw("Unable to format datetime with " + format_ + " format");
+  }
+}
+
 flex_date_time get_datetime_visitor::operator()(const flex_string& s) const {
   date_time_string_reader reader("ISO");
   return reader.read(s);
@@ -15,6 +15,7 @@
 #include <core/parallel/atomic.hpp>
 #include <core/util/int128_types.hpp>
 #include <core/data/flexible_type/flexible_type_base_types.hpp>
+#include <core/data/flexible_type/flexible_type_payload_cache.hpp>
 namespace turi {
 void flexible_type_fail(bool);
 }
@@ -1262,7 +1263,7 @@ class flexible_type {
        else {
          union_type prev;
          prev = val;
-         val.strval = new std::pair<atomic<size_t>, flex_string>(*(val.strval));
+         val.strval = flexible_type_impl::new_payload<std::pair<atomic<size_t>, flex_string>>(*(val.strval));
          val.strval->first.value = 1;
          decref(prev, flex_type_enum::STRING);
        }
@@ -1272,7 +1273,7 @@ class flexible_type {
        else {
          union_type prev;
          prev = val;
-         val.vecval = new std::pair<atomic<size_t>, flex_vec>(*(val.vecval));
+         val.vecval = flexible_type_impl::new_payload<std::pair<atomic<size_t>, flex_vec>>(*(val.vecval));
          val.vecval->first.value = 1;
          decref(prev, flex_type_enum::VECTOR);
        }
@@ -1282,7 +1283,7 @@ class flexible_type {
        else {
          union_type prev;
          prev = val;
-         val.ndvecval = new std::pair<atomic<size_t>, flex_nd_vec>(*(val.ndvecval));
+         val.ndvecval = flexible_type_impl::new_payload<std::pair<atomic<size_t>, flex_nd_vec>>(*(val.ndvecval));
          val.ndvecval->first.value = 1;
          decref(prev, flex_type_enum::ND_VECTOR);
        }
@@ -1292,7 +1293,7 @@ class flexible_type {
        else {
          union_type prev;
          prev = val;
-         val.recval = new std::pair<atomic<size_t>, flex_list>(*(val.recval));
+         val.recval = flexible_type_impl::new_payload<std::pair<atomic<size_t>, flex_list>>(*(val.recval));
          val.recval->first.value = 1;
          decref(prev, flex_type_enum::LIST);
        }
@@ -1302,7 +1303,7 @@ class flexible_type {
        else {
          union_type prev;
          prev = val;
-         val.dictval = new std::pair<atomic<size_t>, flex_dict>(*(val.dictval));
+         val.dictval = flexible_type_impl::new_payload<std::pair<atomic<size_t>, flex_dict>>(*(val.dictval));
          val.dictval->first.value = 1;
          decref(prev, flex_type_enum::DICT);
        }
@@ -1312,7 +1313,7 @@ class flexible_type {
        else {
          union_type prev;
          prev = val;
-         val.imgval = new std::pair<atomic<size_t>, flex_image>(*(val.imgval));
+         val.imgval = flexible_type_impl::new_payload<std::pair<atomic<size_t>, flex_image>>(*(val.imgval));
          val.imgval->first.value = 1;
          decref(prev, flex_type_enum::IMAGE);
        }
@@ -1327,37 +1328,37 @@ class flexible_type {
     switch(type){
      case flex_type_enum::STRING:
        if (v.strval->first.dec() == 0) {
-         delete v.strval;
+         flexible_type_impl::delete_payload(v.strval);
          v.strval = NULL;
         }
        break;
      case flex_type_enum::VECTOR:
        if (v.vecval->first.dec() == 0) {
-         delete v.vecval;
+         flexible_type_impl::delete_payload(v.vecval);
          v.vecval = NULL;
        }
        break;
      case flex_type_enum::ND_VECTOR:
        if (v.ndvecval->first.dec() == 0) {
-         delete v.ndvecval;
+         flexible_type_impl::delete_payload(v.ndvecval);
          v.ndvecval = NULL;
        }
        break;
      case flex_type_enum::LIST:
        if (v.recval->first.dec() == 0) {
-         delete v.recval;
+         flexible_type_impl::delete_payload(v.recval);
          v.recval = NULL;
        }
        break;
      case flex_type_enum::DICT:
        if (v.dictval->first.dec() == 0) {
-         delete v.dictval;
+         flexible_type_impl::delete_payload(v.dictval);
          v.dictval = NULL;
        }
        break;
      case flex_type_enum::IMAGE:
        if (v.imgval->first.dec() == 0) {
-         delete v.imgval;
+         flexible_type_impl::delete_payload(v.imgval);
          v.imgval = NULL;
        }
        break;
@@ -1790,30 +1791,30 @@ inline FLEX_ALWAYS_INLINE_FLATTEN void flexible_type::reset(flex_type_enum targe
   // construct the new type
   switch(get_type()) {
    case flex_type_enum::STRING:
-     val.strval = new std::pair<atomic<size_t>, flex_string>;
+     val.strval = flexible_type_impl::new_payload<std::pair<atomic<size_t>, flex_string>>();
      val.strval->first.value = 1;
      break;
    case flex_type_enum::VECTOR:
-     val.vecval = new std::pair<atomic<size_t>, flex_vec>;
+     val.vecval = flexible_type_impl::new_payload<std::pair<atomic<size_t>, flex_vec>>();
      val.vecval->first.value = 1;
      break;
    case flex_type_enum::ND_VECTOR:
-     val.ndvecval = new std::pair<atomic<size_t>, flex_nd_vec>;
+     val.ndvecval = flexible_type_impl::new_payload<std::pair<atomic<size_t>, flex_nd_vec>>();
      val.ndvecval->first.value = 1;
      break;
    case flex_type_enum::LIST:
-     val.recval = new std::pair<atomic<size_t>, flex_list>;
+     val.recval = flexible_type_impl::new_payload<std::pair<atomic<size_t>, flex_list>>();
      val.recval->first.value = 1;
      break;
    case flex_type_enum::DICT:
-     val.dictval = new std::pair<atomic<size_t>, flex_dict>;
+     val.dictval = flexible_type_impl::new_payload<std::pair<atomic<size_t>, flex_dict>>();
      val.dictval->first.value = 1;
      break;
    case flex_type_enum::DATETIME:
      new (&val.dtval) flex_date_time(0,0); // placement new to create flex_date_time
      break;
    case flex_type_enum::IMAGE:
-     val.imgval = new std::pair<atomic<size_t>, flex_image>;
+     val.imgval = flexible_type_impl::new_payload<std::pair<atomic<size_t>, flex_image>>();
      val.imgval->first.value = 1;
      break;
    default:
@@ -6,6 +6,7 @@
 #ifndef TURI_FLEXIBLE_TYPE_DETAIL_HPP
 #define TURI_FLEXIBLE_TYPE_DETAIL_HPP
 #include <typeindex>
+#include <memory>
 #include <sstream>
 #include <cmath>
 #include <string>
@@ -39,16 +40,27 @@ flex_int ptime_to_time_t(const boost::posix_time::ptime & time);
  */
 flex_int ptime_to_fractional_microseconds(const boost::posix_time::ptime & time);
 
+class date_time_format;
+
 /**
  * Helper for reading flex_date_time values from strings.
+ *
+ * The format is compiled once (see \ref date_time_format), and strings are
+ * only parsed by boost when the compiled format cannot handle them. An
+ * instance must not be used from several threads at once.
  */
 class date_time_string_reader {
 public:
   /**
    * Initializes this instance to read strings with the given format. If the
    * format string is empty, then format "%Y%m%dT%H%M%S%F%q" is used.
+   *
+   * If use_compiled_format is false, every string is parsed by boost.
    */
-  explicit date_time_string_reader(std::string format);
+  explicit date_time_string_reader(std::string format,
+                                   bool use_compiled_format = true);
+
+  ~date_time_string_reader();
 
   /**
    * Returns the flex_date_time value parsed from `input`, or throws an
@@ -59,9 +71,44 @@ public:
 
 private:
   std::string format_;
+  std::unique_ptr<date_time_format> compiled_;
   std::istringstream stream_;
 };
 
+/**
+ * Helper for writing flex_date_time values to strings, the counterpart of
+ * \ref date_time_string_reader.
+ *
+ * Values the compiled format cannot handle are written by boost, with the
+ * boost time zone of every offset created once and cached. An instance must
+ * not be used from several threads at once.
+ */
+class date_time_string_writer {
+public:
+  /**
+   * Initializes this instance to write strings with the given format.
+   *
+   * If use_compiled_format is false, every value is written by boost.
+   */
+  explicit date_time_string_writer(std::string format,
+                                   bool use_compiled_format = true);
+
+  ~date_time_string_writer();
+
+  /**
+   * Returns value formatted with the format provided to the constructor, or
+   * throws an exception if it cannot be formatted.
+   */
+  flex_string write(const flex_date_time& value);
+
+private:
+  struct boost_writer;
+
+  std::string format_;
+  std::unique_ptr<date_time_format> compiled_;
+  std::unique_ptr<boost_writer> boost_writer_;
+};
+
 /**
  * \ingroup group_gl_flexible_type
  * \internal
@@ -196,7 +243,8 @@ struct equality_operator {
   }
   inline FLEX_ALWAYS_INLINE_FLATTEN bool operator()(const flex_int t, const flex_int u) const { return t == u; }
   inline FLEX_ALWAYS_INLINE_FLATTEN bool operator()(const flex_float t, const flex_float u) const { return t == u; }
-  inline FLEX_ALWAYS_INLINE_FLATTEN bool operator()(const flex_string& t, const flex_string& u) const { return t == u; }
+  // strings decoded from a dictionary encoded block share a payload
+  inline FLEX_ALWAYS_INLINE_FLATTEN bool operator()(const flex_string& t, const flex_string& u) const { return &t == &u || t == u; }
   inline FLEX_ALWAYS_INLINE_FLATTEN bool operator()(const flex_image& t, const flex_image& u) const { return t == u; }
   inline FLEX_ALWAYS_INLINE_FLATTEN bool operator()(const flex_vec& t, const flex_vec& u) const {
     if (t.size() != u.size()) return false;
@@ -245,7 +293,8 @@ struct approx_equality_operator {
   }
   inline FLEX_ALWAYS_INLINE_FLATTEN bool operator()(const flex_int t, const flex_float u) const { return t == u; }
   inline FLEX_ALWAYS_INLINE_FLATTEN bool operator()(const flex_float t, const flex_int u) const { return t == u; }
-  inline FLEX_ALWAYS_INLINE_FLATTEN bool operator()(const flex_string& t, const flex_string& u) const { return t == u; }
+  // strings decoded from a dictionary encoded block share a payload
+  inline FLEX_ALWAYS_INLINE_FLATTEN bool operator()(const flex_string& t, const flex_string& u) const { return &t == &u || t == u; }
   inline FLEX_ALWAYS_INLINE_FLATTEN bool operator()(const flex_image& t, const flex_image& u) const { return t == u; }
   inline FLEX_ALWAYS_INLINE_FLATTEN bool operator()(const flex_vec& t, const flex_vec& u) const {
     if (t.size() != u.size()) return false;
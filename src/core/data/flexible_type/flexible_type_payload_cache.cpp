@@ -0,0 +1,111 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <core/data/flexible_type/flexible_type_payload_cache.hpp>
+#include <core/util/code_optimization.hpp>
+
+namespace turi {
+namespace flexible_type_impl {
+
+namespace {
+
+static constexpr size_t SIZE_CLASS_BYTES = 16;
+static constexpr size_t NUM_SIZE_CLASSES = PAYLOAD_CACHE_MAX_SIZE / SIZE_CLASS_BYTES;
+
+struct free_node {
+  free_node* next;
+};
+
+/*
+ * The free lists of a thread. This is trivially destructible so that it
+ * remains usable while other thread local objects are destroyed at thread
+ * exit; payload_cache_reaper empties it and turns it off.
+ */
+struct payload_cache {
+  free_node* free_lists[NUM_SIZE_CLASSES];
+  size_t num_free[NUM_SIZE_CLASSES];
+  bool active;
+  bool exited;
+};
+
+thread_local payload_cache tls_cache;
+
+struct payload_cache_reaper {
+  payload_cache_reaper() {
+    tls_cache.active = true;
+  }
+  ~payload_cache_reaper() {
+    tls_cache.active = false;
+    tls_cache.exited = true;
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+      free_node* node = tls_cache.free_lists[i];
+      while (node != nullptr) {
+        free_node* next = node->next;
+        ::operator delete(node);
+        node = next;
+      }
+      tls_cache.free_lists[i] = nullptr;
+      tls_cache.num_free[i] = 0;
+    }
+  }
+};
+
+/*
+ * Returns the cache of this thread, or nullptr if the thread is exiting.
+ * The reaper is created on first use, so that threads which never touch a
+ * payload do not register anything.
+ */
+inline payload_cache* get_cache() {
+  payload_cache& cache = tls_cache;
+  if (LIKELY(cache.active)) return &cache;
+  if (cache.exited) return nullptr;
+  static thread_local payload_cache_reaper reaper;
+  return &cache;
+}
+
+inline size_t size_class(size_t size) {
+  return (size + SIZE_CLASS_BYTES - 1) / SIZE_CLASS_BYTES - 1;
+}
+
+} // anonymous namespace
+
+void* allocate_payload(size_t size) {
+  size_t cls = size_class(size);
+  if (cls >= NUM_SIZE_CLASSES) return ::operator new(size);
+  payload_cache* cache = get_cache();
+  if (cache != nullptr && cache->free_lists[cls] != nullptr) {
+    free_node* node = cache->free_lists[cls];
+    cache->free_lists[cls] = node->next;
+    --cache->num_free[cls];
+    return node;
+  }
+  // allocate the whole size class so that the payload can be reused for
+  // any other payload of that class
+  return ::operator new((cls + 1) * SIZE_CLASS_BYTES);
+}
+
+void free_payload(void* ptr, size_t size) noexcept {
+  size_t cls = size_class(size);
+  if (cls < NUM_SIZE_CLASSES) {
+    payload_cache* cache = get_cache();
+    if (cache != nullptr && cache->num_free[cls] < PAYLOAD_CACHE_MAX_FREE) {
+      free_node* node = static_cast<free_node*>(ptr);
+      node->next = cache->free_lists[cls];
+      cache->free_lists[cls] = node;
+      ++cache->num_free[cls];
+      return;
+    }
+  }
+  ::operator delete(ptr);
+}
+
+size_t num_cached_payloads() {
+  size_t ret = 0;
+  for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) ret += tls_cache.num_free[i];
+  return ret;
+}
+
+} // namespace flexible_type_impl
+} // namespace turi
@@ -0,0 +1,74 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_FLEXIBLE_TYPE_PAYLOAD_CACHE_HPP
+#define TURI_FLEXIBLE_TYPE_PAYLOAD_CACHE_HPP
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace turi {
+namespace flexible_type_impl {
+
+/**
+ * \internal
+ * The reference counted payloads of flexible_type (strings, vectors, lists,
+ * dicts, ...) are allocated and freed once per value, which is a large part
+ * of the cost of decoding or dropping blocks of strings.
+ *
+ * Every thread therefore keeps the payloads it frees in free lists, one per
+ * size class of 16 bytes up to PAYLOAD_CACHE_MAX_SIZE bytes, and allocates
+ * from them first. A payload may be freed by a different thread than the one
+ * which allocated it. Each list holds at most PAYLOAD_CACHE_MAX_FREE
+ * payloads; the rest go back to the heap, as do all cached payloads when
+ * the thread exits.
+ *
+ * Only the payload objects are cached: the memory owned by them, such as the
+ * characters of a long string, is allocated by their own allocators.
+ */
+static constexpr size_t PAYLOAD_CACHE_MAX_SIZE = 128;
+static constexpr size_t PAYLOAD_CACHE_MAX_FREE = 4096;
+
+/**
+ * \internal
+ * Allocates size bytes for a payload, from the free list of this thread if
+ * possible.
+ */
+void* allocate_payload(size_t size);
+
+/**
+ * \internal
+ * Frees a payload of size bytes allocated by allocate_payload.
+ */
+void free_payload(void* ptr, size_t size) noexcept;
+
+/**
+ * \internal
+ * Returns the number of payloads in the free lists of this thread.
+ */
+size_t num_cached_payloads();
+
+/// \internal Allocates and constructs a payload.
+template <typename T, typename... Args>
+inline T* new_payload(Args&&... args) {
+  void* ptr = allocate_payload(sizeof(T));
+  try {
+    return new (ptr) T(std::forward<Args>(args)...);
+  } catch (...) {
+    free_payload(ptr, sizeof(T));
+    throw;
+  }
+}
+
+/// \internal Destroys and frees a payload allocated by new_payload.
+template <typename T>
+inline void delete_payload(T* ptr) noexcept {
+  ptr->~T();
+  free_payload(ptr, sizeof(T));
+}
+
+} // namespace flexible_type_impl
+} // namespace turi
+#endif
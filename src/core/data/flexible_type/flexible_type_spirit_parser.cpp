@@ -309,14 +309,144 @@ flexible_type_parser::vector_parse(const char** str, size_t len) {
   return ret;
 }
 
+namespace {
+
+/*
+ * Fast paths for the typed numeric columns of the CSV parser.
+ *
+ * They handle the plain decimal forms which make up nearly all numeric
+ * fields, exactly as qi::long_long and qi::double_ under phrase_parse would:
+ * same value, and *str left after the trailing spaces. Anything else
+ * (overflow, inf / nan, too many digits, non ASCII characters, ...) returns
+ * false and is left to the Spirit parsers.
+ */
+
+inline bool is_ascii_space(char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/// Skips the spaces at c. Returns false on a byte Spirit may see as a space.
+inline bool skip_ascii_space(const char*& c, const char* end) {
+  while (c != end && is_ascii_space(*c)) ++c;
+  return c == end || (unsigned char)(*c) < 0x80;
+}
+
+inline bool is_digit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+bool fast_int_parse(const char** str, const char* end, flex_int& out) {
+  const char* c = *str;
+  if (!skip_ascii_space(c, end) || c == end) return false;
+  bool negative = (*c == '-');
+  if (*c == '-' || *c == '+') ++c;
+  const char* digits_begin = c;
+  uint64_t value = 0;
+  while (c != end && is_digit(*c)) {
+    value = value * 10 + (*c - '0');
+    ++c;
+  }
+  // at most 18 digits cannot overflow
+  size_t num_digits = c - digits_begin;
+  if (num_digits == 0 || num_digits > 18) return false;
+  if (!skip_ascii_space(c, end)) return false;
+  out = negative ? -(flex_int)value : (flex_int)value;
+  *str = c;
+  return true;
+}
+
+bool fast_double_parse(const char** str, const char* end, double& out) {
+  // powers of 10 which are exact doubles
+  static const double exact_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  const char* c = *str;
+  if (!skip_ascii_space(c, end) || c == end) return false;
+  bool negative = (*c == '-');
+  if (*c == '-' || *c == '+') ++c;
+
+  uint64_t mantissa = 0;
+  size_t num_digits = 0;
+  int exponent = 0;
+  while (c != end && is_digit(*c)) {
+    mantissa = mantissa * 10 + (*c - '0');
+    ++num_digits;
+    ++c;
+  }
+  if (c != end && *c == '.') {
+    ++c;
+    while (c != end && is_digit(*c)) {
+      mantissa = mantissa * 10 + (*c - '0');
+      ++num_digits;
+      --exponent;
+      ++c;
+    }
+  }
+  // 19 digits cannot overflow the mantissa
+  if (num_digits == 0 || num_digits > 19) return false;
+  if (c != end && (*c == 'e' || *c == 'E')) {
+    ++c;
+    bool negative_exponent = (c != end && *c == '-');
+    if (c != end && (*c == '-' || *c == '+')) ++c;
+    int exp_value = 0;
+    const char* exp_begin = c;
+    while (c != end && is_digit(*c) && c - exp_begin < 4) {
+      exp_value = exp_value * 10 + (*c - '0');
+      ++c;
+    }
+    // no exponent digits fails in Spirit. Long exponents are left to it.
+    if (c == exp_begin || (c != end && is_digit(*c))) return false;
+    exponent += negative_exponent ? -exp_value : exp_value;
+  }
+  // the mantissa and the power of 10 are exact, so one multiplication or
+  // division is correctly rounded: the result Spirit computes this way too.
+  if (mantissa > (uint64_t(1) << 53) || exponent < -22 || exponent > 22) {
+    return false;
+  }
+  if (!skip_ascii_space(c, end)) return false;
+  double value = (double)mantissa;
+  if (exponent < 0) value /= exact_pow10[-exponent];
+  else value *= exact_pow10[exponent];
+  out = negative ? -value : value;
+  *str = c;
+  return true;
+}
+
+} // anonymous namespace
+
+bool flexible_type_parser::double_parse(const char** str, size_t len,
+                                        flex_float& out) {
+  if (fast_double_parse(str, (*str) + len, out)) return true;
+  flex_float value;
+  if (!qi::phrase_parse((*str), (*str) + len,
+                        boost::spirit::qi::double_,
+                        space,
+                        value)) {
+    return false;
+  }
+  out = value;
+  return true;
+}
+
+bool flexible_type_parser::int_parse(const char** str, size_t len,
+                                     flex_int& out) {
+  if (fast_int_parse(str, (*str) + len, out)) return true;
+  flex_int value;
+  if (!qi::phrase_parse((*str), (*str) + len,
+                        boost::spirit::qi::long_long,
+                        space,
+                        value)) {
+    return false;
+  }
+  out = value;
+  return true;
+}
+
 std::pair<flexible_type, bool>
 flexible_type_parser::double_parse(const char** str, size_t len) {
   std::pair<flexible_type, bool> ret;
   double dblval;
-  ret.second = qi::phrase_parse((*str), (*str) + len,
-                                boost::spirit::qi::double_,
-                                space,
-                                dblval);
+  ret.second = double_parse(str, len, dblval);
   if (ret.second) ret.first = dblval;
   return ret;
 }
@@ -325,10 +455,7 @@ std::pair<flexible_type, bool>
 flexible_type_parser::int_parse(const char** str, size_t len) {
   std::pair<flexible_type, bool> ret;
   flex_int intval;
-  ret.second = qi::phrase_parse((*str), (*str) + len,
-                                boost::spirit::qi::long_long,
-                                space,
-                                intval);
+  ret.second = int_parse(str, len, intval);
   if (ret.second) ret.first = intval;
   return ret;
 }
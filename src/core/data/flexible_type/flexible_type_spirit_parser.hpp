@@ -97,6 +97,24 @@ class flexible_type_parser {
   std::pair<flexible_type, bool>
       int_parse(const char** str, size_t len);
 
+  /**
+   * Parses a double from a string into out, which is left unchanged if the
+   * parse fails. The *str pointer will be updated to point to the character
+   * after the last character parsed. Returns true on success.
+   *
+   * Plain decimal numbers take a fast path which does not go through Spirit.
+   */
+  bool double_parse(const char** str, size_t len, flex_float& out);
+
+  /**
+   * Parses an integer from a string into out, which is left unchanged if the
+   * parse fails. The *str pointer will be updated to point to the character
+   * after the last character parsed. Returns true on success.
+   *
+   * Plain decimal numbers take a fast path which does not go through Spirit.
+   */
+  bool int_parse(const char** str, size_t len, flex_int& out);
+
 
   /**
    * Parses an string from a string. The *str pointer will be
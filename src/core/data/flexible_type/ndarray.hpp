@@ -5,6 +5,7 @@
  */
 #ifndef TURI_FLEXIBLE_TYPE_NDARRAY
 #define TURI_FLEXIBLE_TYPE_NDARRAY
+#include <algorithm>
 #include <tuple>
 #include <iostream>
 #include <core/logging/assertions.hpp>
@@ -60,9 +61,9 @@ static void mod_helper(T& a, const T& b,
  *
  * Note
  * ----
- * The performance of the ndarray operators is probably not particularly
- * optimized. Really, the \ref increment_index() system should be replaced
- * with an iterator.
+ * The arithmetic operators and reductions process contiguous arrays (see
+ * \ref is_contiguous()) as flat ranges. Other layouts go through the
+ * slower \ref increment_index() system.
  **/
 template <typename T>
 class ndarray {
@@ -386,6 +387,24 @@ class ndarray {
     return is_full() && has_canonical_stride();
   }
 
+  /**
+   * Returns true if the elements of the array are the num_elem() consecutive
+   * elements of the storage from start(), in the canonical order. A full
+   * canonical array is contiguous, and so is a slice of it along the first
+   * dimension.
+   */
+  bool is_contiguous() const {
+    if (!is_valid()) return false;
+    size_t expected = 1;
+    for (size_t i = m_shape.size(); i > 0; --i) {
+      // the stride of a dimension of size 1 is never used
+      if (m_shape[i - 1] == 1) continue;
+      if (m_stride[i - 1] != expected) return false;
+      expected *= m_shape[i - 1];
+    }
+    return true;
+  }
+
   /**
    * Increments a vector representing an N-D index.
    *
@@ -561,134 +580,195 @@ class ndarray {
     return true;
   }
 
-  /// element-wise addition. The other array must have the same shape.
-  ndarray<T>& operator+=(const ndarray<T>& other) {
+  /**
+   * Calls fn(x) on every element x of the array, in place.
+   *
+   * The elements are only copied if the storage is shared with another
+   * array, and a contiguous array is processed as a flat range (which the
+   * compiler can vectorize) rather than index by index.
+   */
+  template <typename Fn>
+  ndarray<T>& apply(Fn fn) {
+    if (num_elem() == 0) return *this;
+    detach();
+    T* out = m_elem->data() + m_start;
+    if (is_contiguous()) {
+      size_t n = num_elem();
+      for (size_t i = 0; i < n; ++i) fn(out[i]);
+    } else {
+      std::vector<size_t> idx(m_shape.size(), 0);
+      do {
+        fn(out[fast_index(idx)]);
+      } while(increment_index(idx));
+    }
+    return *this;
+  }
+
+  /**
+   * Calls fn(x, y) on every element x of the array and the element y of
+   * other at the same index, in place. The other array must have the same
+   * shape.
+   */
+  template <typename Fn>
+  ndarray<T>& apply(const ndarray<T>& other, Fn fn) {
     ASSERT_TRUE(same_shape(other));
     if (num_elem() == 0) return *this;
-    ensure_unique();
-    std::vector<size_t> idx(m_shape.size(), 0);
-    do {
-      (*this)[fast_index(idx)] += other[other.fast_index(idx)];
-    } while(increment_index(idx));
+    detach();
+    T* out = m_elem->data() + m_start;
+    const T* in = other.m_elem->data() + other.m_start;
+    if (is_contiguous() && other.is_contiguous()) {
+      size_t n = num_elem();
+      for (size_t i = 0; i < n; ++i) fn(out[i], in[i]);
+    } else {
+      std::vector<size_t> idx(m_shape.size(), 0);
+      do {
+        fn(out[fast_index(idx)], in[other.fast_index(idx)]);
+      } while(increment_index(idx));
+    }
     return *this;
   }
 
+  /// element-wise addition. The other array must have the same shape.
+  ndarray<T>& operator+=(const ndarray<T>& other) {
+    return apply(other, [](T& a, const T& b) { a += b; });
+  }
+
   /// scalar addition.
   ndarray<T>& operator+=(T other) {
-    if (num_elem() == 0) return *this;
-    ensure_unique();
-    std::vector<size_t> idx(m_shape.size(), 0);
-    do {
-      (*this)[fast_index(idx)] += other;
-    } while(increment_index(idx));
-    return *this;
+    return apply([other](T& a) { a += other; });
   }
 
   /// element-wise subtraction. The other array must have the same shape.
   ndarray<T>& operator-=(const ndarray<T>& other) {
-    ASSERT_TRUE(same_shape(other));
-    if (num_elem() == 0) return *this;
-    ensure_unique();
-    std::vector<size_t> idx(m_shape.size(), 0);
-    do {
-      (*this)[fast_index(idx)] -= other[other.fast_index(idx)];
-    } while(increment_index(idx));
-    return *this;
+    return apply(other, [](T& a, const T& b) { a -= b; });
   }
 
   /// scalar subtraction.
   ndarray<T>& operator-=(T other) {
-    if (num_elem() == 0) return *this;
-    ensure_unique();
-    std::vector<size_t> idx(m_shape.size(), 0);
-    do {
-      (*this)[fast_index(idx)] -= other;
-    } while(increment_index(idx));
-    return *this;
+    return apply([other](T& a) { a -= other; });
   }
 
   /// element-wise multiplication. The other array must have the same shape.
   ndarray<T>& operator*=(const ndarray<T>& other) {
-    ASSERT_TRUE(same_shape(other));
-    if (num_elem() == 0) return *this;
-    ensure_unique();
-    std::vector<size_t> idx(m_shape.size(), 0);
-    do {
-      (*this)[fast_index(idx)] *= other[other.fast_index(idx)];
-    } while(increment_index(idx));
-    return *this;
+    return apply(other, [](T& a, const T& b) { a *= b; });
   }
 
   /// scalar multiplication
   ndarray<T>& operator*=(T other) {
-    if (num_elem() == 0) return *this;
-    ensure_unique();
-    std::vector<size_t> idx(m_shape.size(), 0);
-    do {
-      (*this)[fast_index(idx)] *= other;
-    } while(increment_index(idx));
-    return *this;
+    return apply([other](T& a) { a *= other; });
   }
 
 
   /// element-wise division. The other array must have the same shape.
   ndarray<T>& operator/=(const ndarray<T>& other) {
-    ASSERT_TRUE(same_shape(other));
-    if (num_elem() == 0) return *this;
-    ensure_unique();
-    std::vector<size_t> idx(m_shape.size(), 0);
-    do {
-      (*this)[fast_index(idx)] /= other[other.fast_index(idx)];
-    } while(increment_index(idx));
-    return *this;
+    return apply(other, [](T& a, const T& b) { a /= b; });
   }
 
   /// scalar division
   ndarray<T>& operator/=(T other) {
-    if (num_elem() == 0) return *this;
-    ensure_unique();
-    std::vector<size_t> idx(m_shape.size(), 0);
-    do {
-      (*this)[fast_index(idx)] /= other;
-    } while(increment_index(idx));
-    return *this;
+    return apply([other](T& a) { a /= other; });
   }
 
   /// element-wise modulo. The other array must have the same shape.
   ndarray<T>& operator%=(const ndarray<T>& other) {
-    ASSERT_TRUE(same_shape(other));
-    if (num_elem() == 0) return *this;
-    ensure_unique();
-    std::vector<size_t> idx(m_shape.size(), 0);
-    do {
-      T& left = (*this)[fast_index(idx)];
-      mod_helper(left, other[other.fast_index(idx)]);
-    } while(increment_index(idx));
-    return *this;
+    return apply(other, [](T& a, const T& b) { mod_helper(a, b); });
   }
 
   /// scalar modulo.
   ndarray<T>& operator%=(T other) {
-    if (num_elem() == 0) return *this;
-    ensure_unique();
-    std::vector<size_t> idx(m_shape.size(), 0);
-    do {
-      T& left = (*this)[fast_index(idx)];
-      mod_helper(left, other);
-    } while(increment_index(idx));
-    return *this;
+    return apply([other](T& a) { mod_helper(a, other); });
   }
 
   /// negation
   ndarray<T>& negate() {
-    if (num_elem() == 0) return *this;
-    ensure_unique();
-    std::vector<size_t> idx(m_shape.size(), 0);
-    do {
-      T& v = (*this)[fast_index(idx)];
-      v = -v;
-    } while(increment_index(idx));
-    return *this;
+    return apply([](T& a) { a = -a; });
+  }
+
+  /**
+   * Calls fn(x) on every element x of the array, in the canonical order,
+   * without modifying the array.
+   */
+  template <typename Fn>
+  void for_each(Fn fn) const {
+    if (num_elem() == 0) return;
+    const T* in = m_elem->data() + m_start;
+    if (is_contiguous()) {
+      size_t n = num_elem();
+      for (size_t i = 0; i < n; ++i) fn(in[i]);
+    } else {
+      std::vector<size_t> idx(m_shape.size(), 0);
+      do {
+        fn(in[fast_index(idx)]);
+      } while(increment_index(idx));
+    }
+  }
+
+  /// Returns the sum of all the elements
+  T sum() const {
+    T ret = T();
+    for_each([&ret](const T& a) { ret += a; });
+    return ret;
+  }
+
+  /**
+   * Returns the sum of the products of the elements of the two arrays at
+   * the same index. The other array must have the same shape.
+   */
+  T dot(const ndarray<T>& other) const {
+    ASSERT_TRUE(same_shape(other));
+    T ret = T();
+    if (num_elem() == 0) return ret;
+    const T* a = m_elem->data() + m_start;
+    const T* b = other.m_elem->data() + other.m_start;
+    if (is_contiguous() && other.is_contiguous()) {
+      size_t n = num_elem();
+      for (size_t i = 0; i < n; ++i) ret += a[i] * b[i];
+    } else {
+      std::vector<size_t> idx(m_shape.size(), 0);
+      do {
+        ret += a[fast_index(idx)] * b[other.fast_index(idx)];
+      } while(increment_index(idx));
+    }
+    return ret;
+  }
+
+  /**
+   * Returns the array of the given shape with the elements of this array,
+   * in the canonical order. The number of elements must be unchanged.
+   *
+   * The result shares the storage of this array if it is contiguous
+   * (\ref is_contiguous()); otherwise the elements are copied once.
+   */
+  ndarray<T> reshape(const index_range_type& shape) const {
+    size_t n = 1;
+    for (size_t s: shape) n *= s;
+    ASSERT_EQ(n, num_elem());
+    if (n == 0) return ndarray<T>();
+    ndarray<T> ret = is_contiguous() ? *this : canonicalize();
+    ASSERT_TRUE(ret.is_contiguous());
+    ret.m_shape = shape;
+    ret.m_stride.resize(shape.size());
+    size_t stride = 1;
+    for (size_t i = shape.size(); i > 0; --i) {
+      ret.m_stride[i - 1] = stride;
+      stride *= shape[i - 1];
+    }
+    return ret;
+  }
+
+  /**
+   * Returns the entries [begin, end) along the first dimension, sharing the
+   * storage of this array. For a 2-D array, these are rows begin to end - 1.
+   */
+  ndarray<T> slice(size_t begin, size_t end) const {
+    ASSERT_TRUE(m_shape.size() > 0);
+    ASSERT_LE(begin, end);
+    ASSERT_LE(end, m_shape[0]);
+    if (begin == end) return ndarray<T>();
+    ndarray<T> ret = *this;
+    ret.m_shape[0] = end - begin;
+    ret.m_start += begin * m_stride[0];
+    return ret;
   }
 
 
@@ -697,6 +777,10 @@ class ndarray {
     if (&other == this) return true;
     if (!same_shape(other)) return false;
     if (num_elem() == 0) return true;
+    if (is_contiguous() && other.is_contiguous()) {
+      const T* a = m_elem->data() + m_start;
+      return std::equal(a, a + num_elem(), other.m_elem->data() + other.m_start);
+    }
     std::vector<size_t> idx(m_shape.size(), 0);
     do {
       if ((*this)[fast_index(idx)] != other[other.fast_index(idx)]) return false;
@@ -732,6 +816,24 @@ class ndarray {
   }
 
  private:
+  /**
+   * As ensure_unique(), but only copies the elements of the array when it
+   * is a view of a larger shared storage.
+   */
+  void detach() {
+    if (m_elem.use_count() <= 1) return;
+    if (is_contiguous()) {
+      if (!is_full()) {
+        m_elem = std::make_shared<container_type>(m_elem->begin() + m_start,
+                                                  m_elem->begin() + m_start + num_elem());
+        m_start = 0;
+      }
+    } else {
+      *this = canonicalize();
+    }
+    ensure_unique();
+  }
+
   /**
    * Returns one past the last valid linear index of the array according to the
    * shape and stride information.
@@ -136,6 +136,30 @@ void decode_image_impl(image_type& image) {
   image.m_format = Format::RAW_ARRAY;
 }
 
+void decode_image_impl(image_type& image, size_t min_width, size_t min_height) {
+  if (image.m_format != Format::JPG) {
+    decode_image_impl(image);
+    return;
+  }
+
+  const char* data = (const char*)image.get_image_data();
+  size_t width = 0, height = 0, channels = 0;
+  parse_jpeg_scaled(data, image.m_image_data_size, min_width, min_height,
+                    width, height, channels);
+
+  size_t length = width * height * channels;
+  boost::shared_ptr<char[]> buf(new char[length]);
+  decode_jpeg_scaled(data, image.m_image_data_size, min_width, min_height,
+                     buf.get(), length);
+
+  image.m_image_data = buf;
+  image.m_image_data_size = length;
+  image.m_width = width;
+  image.m_height = height;
+  image.m_channels = channels;
+  image.m_format = Format::RAW_ARRAY;
+}
+
 void encode_image_impl(image_type& image) {
   if (image.m_format != Format::RAW_ARRAY){
     return;
@@ -18,6 +18,12 @@ void resize_image_impl(const char* data, size_t width, size_t height,
 
 void decode_image_impl(image_type& image);
 
+/**
+ * Decode the image, possibly at a reduced size that is still at least
+ * min_width x min_height (jpegs only). Updates the size of the image.
+ */
+void decode_image_impl(image_type& image, size_t min_width, size_t min_height);
+
 void encode_image_impl(image_type& image);
 
 } // end of image_util_detail
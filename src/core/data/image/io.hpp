@@ -35,6 +35,25 @@ void parse_jpeg(const char* data, size_t length,
 
 void decode_jpeg(const char* data, size_t length, char** decoded_data, size_t& out_length);
 
+/**
+ * Like parse_jpeg, but give the size that decode_jpeg_scaled outputs: the
+ * smallest scaling of the image by 1/2, 1/4 or 1/8 that is still at least
+ * min_width x min_height, or the full size if none is.
+ */
+void parse_jpeg_scaled(const char* data, size_t length,
+                       size_t min_width, size_t min_height,
+                       size_t& width, size_t& height, size_t& channels);
+
+/**
+ * Decode a jpeg at the size given by parse_jpeg_scaled, into out_data, which
+ * must hold exactly width * height * channels bytes. The image is scaled
+ * down during the inverse DCT, which is much cheaper than decoding the full
+ * image and resizing it.
+ */
+void decode_jpeg_scaled(const char* data, size_t length,
+                        size_t min_width, size_t min_height,
+                        char* out_data, size_t out_length);
+
 /**
  * Parse the image information, set width, height and channels using libpng.
  */
@@ -19,6 +19,7 @@
 #include <jpeglib.h>
 
 #include <string.h>
+#include <algorithm>
 
 namespace turi {
 
@@ -64,6 +65,107 @@ void parse_jpeg(const char* data, size_t length,
   jpeg_destroy_decompress(&cinfo);
 }
 
+namespace {
+
+/*
+ * Use the smallest DCT scaling (1/2, 1/4 or 1/8) whose output still covers
+ * min_width x min_height, and compute the output dimensions. The scaled IDCT
+ * skips most of the work of decoding the full image.
+ */
+void set_jpeg_scale(j_decompress_ptr cinfo, size_t min_width, size_t min_height) {
+  cinfo->scale_num = 1;
+  cinfo->scale_denom = 1;
+  for (unsigned int denom = 8; denom > 1; denom /= 2) {
+    size_t scaled_width = (cinfo->image_width + denom - 1) / denom;
+    size_t scaled_height = (cinfo->image_height + denom - 1) / denom;
+    if (scaled_width >= min_width && scaled_height >= min_height) {
+      cinfo->scale_denom = denom;
+      break;
+    }
+  }
+  jpeg_calc_output_dimensions(cinfo);
+}
+
+}  // namespace
+
+void parse_jpeg_scaled(const char* data, size_t length,
+                       size_t min_width, size_t min_height,
+                       size_t& width, size_t& height, size_t& channels) {
+  struct jpeg_decompress_struct cinfo;
+  struct jpeg_error_mgr jerr;
+  memset(&cinfo, 0, sizeof(cinfo));
+  memset(&jerr, 0, sizeof(jerr));
+  cinfo.err = jpeg_std_error(&jerr);
+  jerr.error_exit = jpeg_error_exit;
+  try {
+    jpeg_create_decompress(&cinfo);
+
+    jpeg_mem_src(&cinfo, (unsigned char*)data, length);
+    jpeg_read_header(&cinfo, TRUE);
+
+    if (cinfo.out_color_space != JCS_GRAYSCALE && cinfo.out_color_space != JCS_RGB) {
+      log_and_throw(std::string("Unsupported colorspace format. Currently, only RGB and Grayscale are supported."));
+    }
+
+    set_jpeg_scale(&cinfo, min_width, min_height);
+    width = cinfo.output_width;
+    height = cinfo.output_height;
+    channels = cinfo.output_components;
+  } catch (...) {
+    jpeg_destroy_decompress(&cinfo);
+    throw;
+  }
+  jpeg_destroy_decompress(&cinfo);
+}
+
+void decode_jpeg_scaled(const char* data, size_t length,
+                        size_t min_width, size_t min_height,
+                        char* out_data, size_t out_length) {
+  struct jpeg_decompress_struct cinfo;
+  struct jpeg_error_mgr jerr;
+  memset(&cinfo, 0, sizeof(cinfo));
+  memset(&jerr, 0, sizeof(jerr));
+  cinfo.err = jpeg_std_error(&jerr);
+  jerr.error_exit = jpeg_error_exit;
+
+  if (data == NULL || out_data == NULL) {
+    log_and_throw("Trying to decode image with NULL data pointer.");
+  }
+
+  try {
+    jpeg_create_decompress(&cinfo);
+
+    jpeg_mem_src(&cinfo, (unsigned char*)data, length);
+    jpeg_read_header(&cinfo, TRUE);
+    set_jpeg_scale(&cinfo, min_width, min_height);
+
+    size_t row_stride = size_t(cinfo.output_width) * cinfo.output_components;
+    if (row_stride * cinfo.output_height != out_length) {
+      log_and_throw("Output buffer size does not match the scaled JPEG size.");
+    }
+
+    jpeg_start_decompress(&cinfo);
+
+    // Read as many rows per call as the decoder will give us.
+    JSAMPROW rowptrs[16];
+    while (cinfo.output_scanline < cinfo.output_height) {
+      size_t num_rows = std::min<size_t>(
+          16, cinfo.output_height - cinfo.output_scanline);
+      for (size_t i = 0; i < num_rows; ++i) {
+        rowptrs[i] = (unsigned char*)(out_data +
+                                      (cinfo.output_scanline + i) * row_stride);
+      }
+      jpeg_read_scanlines(&cinfo, rowptrs, num_rows);
+    }
+
+    jpeg_finish_decompress(&cinfo);
+  } catch (...) {
+    jpeg_destroy_decompress(&cinfo);
+    throw;
+  }
+  jpeg_destroy_decompress(&cinfo);
+}
+
 void decode_jpeg(const char* data, size_t length, char** out_data, size_t& out_length) {
   struct jpeg_decompress_struct cinfo;
   struct jpeg_error_mgr jerr;
@@ -530,8 +530,7 @@ gl_sarray gl_sarray::append(const gl_sarray& other) const {
 
 gl_sarray gl_sarray::unique() const {
   gl_sframe sf({{"a",(*this)}});
-  sf = sf.groupby({"a"});
-  return sf.select_column("a");
+  return sf.unique().select_column("a");
 }
 
 gl_sarray gl_sarray::item_length() const {
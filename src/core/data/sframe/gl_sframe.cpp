@@ -13,6 +13,9 @@
 #include <core/storage/sframe_interface/unity_sframe.hpp>
 #include <core/storage/sframe_data/sframe.hpp>
 #include <core/storage/sframe_data/sframe_reader.hpp>
+#include <core/storage/sframe_data/shuffle.hpp>
+#include <core/storage/sframe_data/distinct.hpp>
+#include <core/storage/sframe_data/sframe_key_index.hpp>
 #include <core/storage/sframe_data/sframe_reader_buffer.hpp>
 #include <core/storage/sframe_data/dataframe.hpp>
 #include <core/storage/query_engine/planning/planner.hpp>
@@ -101,6 +104,14 @@ groupby_descriptor_type COUNT_DISTINCT(const std::string& col) {
   return {"__builtin__count__distinct__", {col}};
 }
 
+groupby_descriptor_type APPROX_COUNT_DISTINCT(const std::string& col) {
+  return {"__builtin__approx__count__distinct__", {col}};
+}
+
+groupby_descriptor_type APPROX_TOP_K(const std::string& col, size_t k) {
+  return {"__builtin__approx__top__k__" + std::to_string(k), {col}};
+}
+
 groupby_descriptor_type QUANTILE(const std::string& col, double quantile) {
   std::vector<double> q{quantile};
   return QUANTILE(col, q);
@@ -478,9 +489,13 @@ std::pair<gl_sframe, gl_sframe> gl_sframe::random_split(double fraction, size_t
   return ret;
 }
 
+gl_sframe gl_sframe::shuffle(size_t seed) const {
+  return gl_sframe(random_shuffle(materialize_to_sframe(), seed));
+}
+
 gl_sframe gl_sframe::topk(const std::string& column_name,
                           size_t k, bool reverse) const {
-  return (*this)[(*this)[column_name].topk_index(k, reverse)].sort(column_name, reverse);
+  return get_proxy()->topk({column_name}, {reverse}, k);
 }
 
 size_t gl_sframe::column_index(const std::string &column_name) const {
@@ -643,6 +658,16 @@ gl_sframe gl_sframe::filter_by(const gl_sarray& values,
     throw std::string("Type of given values does not match type of column ") +
         column_name + " in SFrame";
   }
+  if (exclude == false) {
+    auto proxy = std::static_pointer_cast<unity_sframe>(get_proxy());
+    if (proxy->is_materialized() &&
+        sframe_key_index::get(*proxy->get_underlying_sframe(),
+                              proxy->column_index(column_name))) {
+      auto value_range = values.range_iterator();
+      std::vector<flexible_type> keys(value_range.begin(), value_range.end());
+      return gl_sframe(proxy->filter_by_key_index(column_name, keys));
+    }
+  }
   gl_sframe value_sf({{column_name, values}});
   value_sf = value_sf.unique();
   if (exclude == false) {
@@ -660,6 +685,10 @@ gl_sframe gl_sframe::filter_by(const gl_sarray& values,
 }
 
 
+void gl_sframe::create_key_index(const std::string& column_name, bool persist) {
+  std::static_pointer_cast<unity_sframe>(get_proxy())->create_key_index(column_name, persist);
+}
+
 gl_sframe gl_sframe::pack_columns(const std::vector<std::string>& columns,
                                   const std::string& new_column_name,
                                   flex_type_enum dtype,
@@ -899,8 +928,16 @@ gl_sframe gl_sframe::unstack(const std::vector<std::string>& columns,
 }
 
 gl_sframe gl_sframe::unique() const {
-  return groupby(column_names(),
-                 std::map<std::string, aggregate::groupby_descriptor_type>());
+  return gl_sframe(distinct(materialize_to_sframe()));
+}
+
+gl_sframe gl_sframe::drop_duplicates(const std::vector<std::string>& columns) const {
+  sframe sf = materialize_to_sframe();
+  std::vector<size_t> key_columns;
+  for (const auto& column: columns) {
+    key_columns.push_back(sf.column_index(column));
+  }
+  return gl_sframe(distinct(sf, key_columns));
 }
 
 gl_sframe gl_sframe::sort(const std::string& column, bool ascending) const {
@@ -940,6 +977,10 @@ gl_sframe gl_sframe::fillna(const std::string& column, flexible_type value) cons
   return ret;
 }
 
+gl_sframe gl_sframe::fillna(const std::map<std::string, flexible_type>& values) const {
+  return get_proxy()->fill_missing_values(values);
+}
+
 gl_sframe gl_sframe::add_row_number(const std::string& column_name, size_t start) const {
   auto ret = *this;
   ret.add_column(gl_sarray::from_sequence(start, size()), column_name);
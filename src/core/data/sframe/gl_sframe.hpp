@@ -290,6 +290,33 @@ groupby_descriptor_type SELECT_ONE(const std::string& col);
  */
 groupby_descriptor_type COUNT_DISTINCT(const std::string& col);
 
+/**
+ * Builtin approximate count distinct aggregator for groupby. Estimates the
+ * number of unique values with a hyperloglog sketch, in a small fraction of
+ * the memory of COUNT_DISTINCT for groups with many unique values.
+ *
+ * Example: Get the approximate number of unique movies
+ * \code
+ * sf.groupby("user",
+ *            {{"num_movies", aggregate::APPROX_COUNT_DISTINCT("movie")}});
+ * \endcode
+ */
+groupby_descriptor_type APPROX_COUNT_DISTINCT(const std::string& col);
+
+/**
+ * Builtin approximate top-k aggregator for groupby. Estimates the k most
+ * frequent values of each group with a space saving sketch, whose memory
+ * depends on k only, and returns a dictionary from each value to its
+ * estimated count.
+ *
+ * Example: Get the 3 movies each user rated most often
+ * \code
+ * sf.groupby("user",
+ *            {{"top_movies", aggregate::APPROX_TOP_K("movie", 3)}});
+ * \endcode
+ */
+groupby_descriptor_type APPROX_TOP_K(const std::string& col, size_t k);
+
 ///@{
 /**
  * Builtin aggregator that combines values from one or two columns in one group
@@ -1107,6 +1134,25 @@ class gl_sframe {
    */
   std::pair<gl_sframe, gl_sframe> random_split(double fraction, size_t seed, bool exact=false) const;
 
+  /**
+   * Returns the rows of the \ref gl_sframe in a uniformly random order.
+   *
+   * Unlike sorting on a random column, the shuffle scatters the rows into
+   * temporary buckets small enough to be shuffled in memory, so it costs
+   * two passes over the data and holds a bounded amount of memory. See
+   * \ref random_shuffle().
+   *
+   * \param seed The random seed. Deterministic output is obtained if this
+   *    is set to a constant.
+   *
+   * Example:
+   * \code
+   * auto sf = gl_sframe({{"id", gl_sarray::from_sequence(0, 1024)}});
+   * gl_sframe shuffled = sf.shuffle(12345);
+   * \endcode
+   */
+  gl_sframe shuffle(size_t seed) const;
+
   /**
    * Get top k rows according to the given column. Result is according to and
    * sorted by "column_name" in the given order (default is descending).
@@ -1904,6 +1950,30 @@ class gl_sframe {
    */
   gl_sframe filter_by(const gl_sarray& values, const std::string& column_name, bool exclude=false) const;
 
+  /**
+   * Builds a key index on a column, so that \ref filter_by() on the column,
+   * and filters comparing the column with a value (sf[sf["id"] == 5]),
+   * read only the matching rows instead of scanning the \ref gl_sframe.
+   * This materializes the \ref gl_sframe. The index also serves the
+   * \ref gl_sframe objects sharing the data of the column.
+   *
+   * Only integer, float, string and datetime columns can be indexed.
+   *
+   * \param column_name The column to index.
+   *
+   * \param persist Optional. Defaults to true. If true and the
+   * \ref gl_sframe is saved on disk, the index is also saved next to it, and
+   * used when the \ref gl_sframe is loaded again.
+   *
+   * Example:
+   * \code
+   * gl_sframe users("users.sframe");
+   * users.create_key_index("user_id");
+   * std::cout << users[users["user_id"] == 12345];
+   * \endcode
+   */
+  void create_key_index(const std::string& column_name, bool persist=true);
+
   /**
    * \overload
    * Pack two or more columns of the current \ref gl_sframe into one single
@@ -2488,6 +2558,28 @@ class gl_sframe {
    */
   gl_sframe unique() const;
 
+  /**
+   * Remove the rows of the \ref gl_sframe which have the same values in the
+   * given columns as another row, keeping one of them (any of them). Will not
+   * necessarily preserve the order of the given \ref gl_sframe in the new
+   * \ref gl_sframe.
+   *
+   * Example:
+   * \code
+   * gl_sframe sf{ {"id", {1,2,3,3,4}},
+   *               {"value", {1,2,3,5,4}} };
+   * std::cout << sf.drop_duplicates({"id"}).size() << std::endl;
+   * \endcode
+   *
+   * Produces output:
+   * \code{.txt}
+   * 4
+   * \endcode
+   *
+   * \see unique
+   */
+  gl_sframe drop_duplicates(const std::vector<std::string>& columns) const;
+
   /**
    * Sort current \ref gl_sframe by a single column, using the given sort order.
    *
@@ -2790,6 +2882,21 @@ class gl_sframe {
    */
   gl_sframe fillna(const std::string& column, flexible_type value) const;
 
+  /**
+   * Fill the missing values of several columns at once: the missing values
+   * of every column named in values are replaced by the value it maps to,
+   * converted to the type of the column as in \ref fillna(const std::string&, flexible_type) const.
+   *
+   * All the columns are filled in a single pass over the SFrame, which is
+   * cheaper than one fillna per column on wide SFrames.
+   *
+   * Example:
+   * \code
+   * sf = sf.fillna({{"a", 0}, {"b", "none"}});
+   * \endcode
+   */
+  gl_sframe fillna(const std::map<std::string, flexible_type>& values) const;
+
   /**
    * Returns a new \ref gl_sframe with a new column that numbers each row
    * sequentially. By default the count starts at 0, but this can be changed
@@ -5,8 +5,24 @@
  */
 #ifndef BLOOM_FILTER_HPP
 #define BLOOM_FILTER_HPP
+#include <algorithm>
+#include <cmath>
 #include <core/util/dense_bitset.hpp>
 
+namespace turi {
+
+namespace bloom_filter_impl {
+/// Mixes the bits of a hash, so that every bit depends on all of them.
+inline uint64_t mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+} // namespace bloom_filter_impl
+
 template <size_t len, size_t probes>
 class fixed_bloom_filter {
  private:
@@ -18,21 +34,99 @@ class fixed_bloom_filter {
     bits.clear();
   }
 
-  inline void insert(uint64_t i) {
+  inline void insert(uint64_t key) {
     for (size_t i = 0;i < probes; ++i) {
-      bits.set_bit_unsync(i % len);
-      i = i * 0x9e3779b97f4a7c13LL;
+      bits.set_bit_unsync(key % len);
+      key = key * 0x9e3779b97f4a7c13LL;
     }
   }
 
-  inline bool may_contain(size_t i) {
+  inline bool may_contain(uint64_t key) {
     for (size_t i = 0;i < probes; ++i) {
-      if (bits.get_bit_unsync(i % len) == false) return false;
-      i = i * 0x9e3779b97f4a7c13LL;
+      if (bits.get(key % len) == false) return false;
+      key = key * 0x9e3779b97f4a7c13LL;
     }
     return true;
   }
 
 };
 
+/**
+ * \ingroup util
+ * A bloom filter of hash values, sized at runtime.
+ *
+ * may_contain(h) is true for every h inserted, and false for most others:
+ * with the default 10 bits per expected key, about 1% of the hashes never
+ * inserted are reported as present.
+ *
+ * insert() may be called from many threads at once. may_contain() can be
+ * called concurrently with itself, but not with insert().
+ */
+class bloom_filter {
+ public:
+  static constexpr size_t DEFAULT_BITS_PER_KEY = 10;
+
+  /// An empty filter, which contains no hashes.
+  bloom_filter() { }
+
+  /**
+   * A filter sized for about num_keys hashes, with bits_per_key bits for
+   * each, rounded up to a power of 2.
+   */
+  explicit bloom_filter(size_t num_keys, size_t bits_per_key = DEFAULT_BITS_PER_KEY) {
+    size_t num_bits = num_bits_for(num_keys, bits_per_key);
+    m_bits.resize(num_bits);
+    m_bits.clear();
+    m_mask = num_bits - 1;
+    // the optimal number of probes is ln(2) * bits per key; the bits per
+    // key are at least the requested ones after rounding.
+    m_num_probes = std::max<size_t>(
+        1, std::min<size_t>(8, std::lround(0.693 * bits_per_key)));
+  }
+
+  /// The number of bits of a filter constructed with these arguments.
+  static inline size_t num_bits_for(size_t num_keys,
+                                    size_t bits_per_key = DEFAULT_BITS_PER_KEY) {
+    size_t num_bits = 64;
+    while (num_bits < num_keys * bits_per_key) num_bits *= 2;
+    return num_bits;
+  }
+
+  /// The number of bits of the filter.
+  inline size_t num_bits() const { return m_bits.size(); }
+
+  /// Inserts a hash. Thread safe.
+  inline void insert(uint64_t hash) {
+    if (m_bits.size() == 0) return;
+    uint64_t h1, h2;
+    probe_hashes(hash, h1, h2);
+    for (size_t i = 0; i < m_num_probes; ++i) {
+      m_bits.set_bit((h1 + i * h2) & m_mask);
+    }
+  }
+
+  /// False if hash was never inserted; true if it probably was.
+  inline bool may_contain(uint64_t hash) const {
+    if (m_bits.size() == 0) return false;
+    uint64_t h1, h2;
+    probe_hashes(hash, h1, h2);
+    for (size_t i = 0; i < m_num_probes; ++i) {
+      if (!m_bits.get((h1 + i * h2) & m_mask)) return false;
+    }
+    return true;
+  }
+
+ private:
+  /// Double hashing: probe i is at h1 + i * h2. h2 is odd, so probes differ.
+  static inline void probe_hashes(uint64_t hash, uint64_t& h1, uint64_t& h2) {
+    h1 = bloom_filter_impl::mix(hash);
+    h2 = ((h1 >> 32) | (h1 << 32)) | 1;
+  }
+
+  dense_bitset m_bits;
+  size_t m_mask = 0;
+  size_t m_num_probes = 1;
+};
+
+} // namespace turi
 #endif
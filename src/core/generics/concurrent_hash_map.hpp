@@ -0,0 +1,254 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_CONCURRENT_HASH_MAP_HPP
+#define TURI_CONCURRENT_HASH_MAP_HPP
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <core/generics/hopscotch_map.hpp>
+#include <core/parallel/pthread_tools.hpp>
+#include <core/parallel/lambda_omp.hpp>
+
+namespace turi {
+
+/**
+ * \ingroup util
+ * A hash map which many threads can insert into, update and read at the same
+ * time.
+ *
+ * The keys are split over a fixed number of shards by their hash, and every
+ * shard is a \ref hopscotch_map guarded by its own spinlock, so threads only
+ * contend when they touch the same shard at the same time. Shards are
+ * padded apart so that the locks of neighboring shards do not share a cache
+ * line.
+ *
+ * All the single key operations are safe to call concurrently. size() is
+ * only exact when no other thread modifies the map. The bulk operations
+ * (clear, for_each, parallel_for_each, copying) must not run concurrently
+ * with anything else.
+ *
+ * Values are returned by copy, since a reference into a shard is only valid
+ * while the shard is locked.
+ *
+ * \code
+ *  concurrent_hash_map<hash_value, size_t> index;
+ *  atomic<size_t> next_index = 0;
+ *  parallel_for(0, values.size(), [&](size_t i) {
+ *    index.find_or_insert(values[i], [&]() { return (++next_index) - 1; });
+ *  });
+ * \endcode
+ */
+template <typename Key,
+          typename Value,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key> >
+class concurrent_hash_map {
+ public:
+  typedef hopscotch_map<Key, Value, Hash, KeyEqual> shard_map_type;
+
+  /// The number of shards used by default.
+  static constexpr size_t DEFAULT_NUM_SHARDS = 256;
+
+  /**
+   * Creates an empty map split over num_shards shards, rounded up to a
+   * power of 2.
+   */
+  explicit concurrent_hash_map(size_t num_shards = DEFAULT_NUM_SHARDS,
+                               Hash hashfun = Hash(),
+                               KeyEqual equalfun = KeyEqual())
+      : m_hash(hashfun) {
+    m_shard_bits = 0;
+    while ((size_t(1) << m_shard_bits) < num_shards) ++m_shard_bits;
+    m_shards.reserve(size_t(1) << m_shard_bits);
+    for (size_t i = 0; i < (size_t(1) << m_shard_bits); ++i) {
+      m_shards.emplace_back(hashfun, equalfun);
+    }
+  }
+
+  /// Copies the keys and values. No thread may modify other meanwhile.
+  concurrent_hash_map(const concurrent_hash_map& other) = default;
+  concurrent_hash_map& operator=(const concurrent_hash_map& other) = default;
+
+  size_t num_shards() const { return m_shards.size(); }
+
+  /**
+   * Returns the value of key, inserting make_value() first if key is not
+   * present. make_value is called at most once, with the shard of key
+   * locked, so it must not use this map. The second element of the result
+   * is true if the value was inserted.
+   */
+  template <typename MakeValue>
+  std::pair<Value, bool> find_or_insert(const Key& key, MakeValue&& make_value) {
+    shard& s = shard_of(key);
+    std::lock_guard<simple_spinlock> guard(s.lock);
+    auto it = s.map.find(key);
+    if (it != s.map.end()) return {it->second, false};
+    Value v = make_value();
+    s.map.insert({key, v});
+    return {v, true};
+  }
+
+  /**
+   * Inserts value if key is not present, and otherwise calls update on a
+   * reference to the present value, with the shard of key locked. Returns
+   * true if the value was inserted.
+   */
+  template <typename Update>
+  bool upsert(const Key& key, const Value& value, Update&& update) {
+    shard& s = shard_of(key);
+    std::lock_guard<simple_spinlock> guard(s.lock);
+    auto it = s.map.find(key);
+    if (it != s.map.end()) {
+      update(it->second);
+      return false;
+    }
+    s.map.insert({key, value});
+    return true;
+  }
+
+  /**
+   * Inserts value if key is not present. Returns true if it was inserted,
+   * and false if key was present, in which case its value is unchanged.
+   */
+  bool insert(const Key& key, const Value& value) {
+    shard& s = shard_of(key);
+    std::lock_guard<simple_spinlock> guard(s.lock);
+    return s.map.insert({key, value}).second;
+  }
+
+  /// Sets the value of key, inserting it if not present.
+  void insert_or_assign(const Key& key, const Value& value) {
+    shard& s = shard_of(key);
+    std::lock_guard<simple_spinlock> guard(s.lock);
+    s.map[key] = value;
+  }
+
+  /**
+   * Copies the value of key into value and returns true, or returns
+   * false if key is not present.
+   */
+  bool find(const Key& key, Value& value) const {
+    const shard& s = shard_of(key);
+    std::lock_guard<simple_spinlock> guard(s.lock);
+    auto it = s.map.find(key);
+    if (it == s.map.end()) return false;
+    value = it->second;
+    return true;
+  }
+
+  /**
+   * Like find(), but without locking the shard. Only safe while no thread
+   * modifies the map, for instance when it is only read after being built,
+   * where it avoids bouncing the shard locks between the reading threads.
+   */
+  bool find_unlocked(const Key& key, Value& value) const {
+    const shard& s = shard_of(key);
+    auto it = s.map.find(key);
+    if (it == s.map.end()) return false;
+    value = it->second;
+    return true;
+  }
+
+  /// Returns true if key is present.
+  bool contains(const Key& key) const {
+    const shard& s = shard_of(key);
+    std::lock_guard<simple_spinlock> guard(s.lock);
+    return s.map.find(key) != s.map.end();
+  }
+
+  /// The number of keys in the map.
+  size_t size() const {
+    size_t ret = 0;
+    for (const auto& s : m_shards) {
+      std::lock_guard<simple_spinlock> guard(s.lock);
+      ret += s.map.size();
+    }
+    return ret;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  /// Removes all the keys.
+  void clear() {
+    for (auto& s : m_shards) s.map.clear();
+  }
+
+  /**
+   * Calls fn(const Key&, const Value&) on every key and value, one shard at
+   * a time, in no particular order.
+   */
+  template <typename Fn>
+  void for_each(Fn&& fn) const {
+    for (const auto& s : m_shards) {
+      for (const auto& kv : s.map) fn(kv.first, kv.second);
+    }
+  }
+
+  /**
+   * Calls fn(size_t shard_index, const Key&, Value&) on every key and
+   * value, with the shards divided between threads. fn is only called
+   * concurrently for keys of different shards.
+   */
+  template <typename Fn>
+  void parallel_for_each(Fn&& fn) {
+    parallel_for(0, m_shards.size(), [&](size_t i) {
+      for (auto& kv : m_shards[i].map) fn(i, kv.first, kv.second);
+    }, parallel_schedule::DYNAMIC);
+  }
+
+  /**
+   * The number of keys in each shard, in shard order. Used with
+   * parallel_for_each to give every shard its own range of some output.
+   */
+  std::vector<size_t> shard_sizes() const {
+    std::vector<size_t> ret(m_shards.size());
+    for (size_t i = 0; i < m_shards.size(); ++i) ret[i] = m_shards[i].map.size();
+    return ret;
+  }
+
+ private:
+  struct shard {
+    shard(Hash hashfun, KeyEqual equalfun) : map(hashfun, equalfun) { }
+    // the lock is never copied; see simple_spinlock
+    shard(const shard& other) : map(other.map) { }
+    shard& operator=(const shard& other) {
+      map = other.map;
+      return *this;
+    }
+    mutable simple_spinlock lock;
+    shard_map_type map;
+    // keeps the lock of the next shard off this cache line
+    char padding[64];
+  };
+
+  inline size_t shard_index(const Key& key) const {
+    if (m_shard_bits == 0) return 0;
+    // the shard maps use the low bits of the hash; use the high bits of a
+    // remix here
+    uint64_t h = uint64_t(m_hash(key)) * 0x9e3779b97f4a7c15ULL;
+    return h >> (64 - m_shard_bits);
+  }
+
+  inline shard& shard_of(const Key& key) {
+    return m_shards[shard_index(key)];
+  }
+
+  inline const shard& shard_of(const Key& key) const {
+    return m_shards[shard_index(key)];
+  }
+
+  Hash m_hash;
+  size_t m_shard_bits = 0;
+  std::vector<shard> m_shards;
+};
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+constexpr size_t concurrent_hash_map<Key, Value, Hash, KeyEqual>::DEFAULT_NUM_SHARDS;
+
+} // namespace turi
+#endif
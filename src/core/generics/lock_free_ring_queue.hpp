@@ -0,0 +1,169 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_LOCK_FREE_RING_QUEUE_HPP
+#define TURI_LOCK_FREE_RING_QUEUE_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace turi {
+
+/**
+ * \ingroup util
+ * A bounded multiple producer, multiple consumer queue on a ring buffer,
+ * which never blocks: try_enqueue fails when the queue is full and
+ * try_dequeue fails when it is empty, and the caller decides what to do
+ * instead.
+ *
+ * Every slot of the ring has a sequence number telling whether it is ready
+ * to be written or read in the current lap around the ring; producers and
+ * consumers claim slots by a compare and swap on their own position
+ * counters, so a producer and a consumer never contend unless the queue is
+ * nearly full or empty. (This is D. Vyukov's bounded MPMC queue.)
+ *
+ * The capacity is rounded up to a power of 2, and is at least 2 unless it
+ * is 0, in which case nothing can be enqueued.
+ *
+ * \tparam T The element type. Must be default constructible and move
+ *           assignable.
+ */
+template <typename T>
+class lock_free_ring_queue {
+ public:
+  explicit lock_free_ring_queue(size_t capacity = 0) {
+    reset(capacity);
+  }
+
+  /**
+   * Copies only the capacity: the new queue is empty, as the elements
+   * cannot be read consistently while other threads use the queue.
+   */
+  lock_free_ring_queue(const lock_free_ring_queue& other) {
+    reset(other.capacity());
+  }
+
+  /// Empties the queue and takes the capacity of other. Not thread safe.
+  lock_free_ring_queue& operator=(const lock_free_ring_queue& other) {
+    if (this != &other) reset(other.capacity());
+    return *this;
+  }
+
+  /**
+   * Empties the queue and changes its capacity. Not safe to call
+   * concurrently with anything else.
+   */
+  void reset(size_t capacity) {
+    size_t rounded = 0;
+    if (capacity > 0) {
+      rounded = 2;
+      while (rounded < capacity) rounded *= 2;
+    }
+    m_cells.reset(rounded > 0 ? new cell[rounded] : nullptr);
+    m_capacity = rounded;
+    for (size_t i = 0; i < rounded; ++i) {
+      m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    m_enqueue_pos.store(0, std::memory_order_relaxed);
+    m_dequeue_pos.store(0, std::memory_order_relaxed);
+  }
+
+  /// The largest number of elements the queue can hold.
+  size_t capacity() const { return m_capacity; }
+
+  /**
+   * Inserts an element at the back of the queue. Returns false, leaving
+   * value unchanged, if the queue is full.
+   */
+  bool try_enqueue(T&& value) {
+    if (m_capacity == 0) return false;
+    size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+    cell* c;
+    while (true) {
+      c = &m_cells[pos & (m_capacity - 1)];
+      size_t seq = c->sequence.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+      if (diff == 0) {
+        if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = m_enqueue_pos.load(std::memory_order_relaxed);
+      }
+    }
+    c->value = std::move(value);
+    c->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// \overload
+  bool try_enqueue(const T& value) {
+    T copy(value);
+    return try_enqueue(std::move(copy));
+  }
+
+  /**
+   * Removes the element at the front of the queue into value. Returns
+   * false if the queue is empty.
+   */
+  bool try_dequeue(T& value) {
+    if (m_capacity == 0) return false;
+    size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+    cell* c;
+    while (true) {
+      c = &m_cells[pos & (m_capacity - 1)];
+      size_t seq = c->sequence.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+      if (diff == 0) {
+        if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = m_dequeue_pos.load(std::memory_order_relaxed);
+      }
+    }
+    value = std::move(c->value);
+    // leave the slot empty rather than holding on to a moved-from value
+    c->value = T();
+    c->sequence.store(pos + m_capacity, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * The number of elements in the queue. Only exact when no other thread
+   * is using the queue.
+   */
+  size_t approx_size() const {
+    size_t enqueued = m_enqueue_pos.load(std::memory_order_relaxed);
+    size_t dequeued = m_dequeue_pos.load(std::memory_order_relaxed);
+    return enqueued > dequeued ? enqueued - dequeued : 0;
+  }
+
+ private:
+  struct cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  std::unique_ptr<cell[]> m_cells;
+  size_t m_capacity = 0;
+  // keep the producer and consumer positions on different cache lines
+  char m_padding0[64];
+  std::atomic<size_t> m_enqueue_pos;
+  char m_padding1[64];
+  std::atomic<size_t> m_dequeue_pos;
+  char m_padding2[64];
+};
+
+} // namespace turi
+#endif
@@ -0,0 +1,138 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <core/globals/memory_accounting.hpp>
+
+namespace turi {
+namespace memory_accounting {
+
+namespace {
+
+struct registry {
+  std::mutex lock;
+  std::map<std::string, std::unique_ptr<memory_tag>> tags;
+
+  // The open high_water_scopes. Guarded by scope_lock, which also guards
+  // their peaks.
+  std::mutex scope_lock;
+  std::set<high_water_scope*> scopes;
+  std::atomic<size_t> num_scopes{0};
+};
+
+registry& get_registry() {
+  static registry* r = new registry;
+  return *r;
+}
+
+}  // namespace
+
+void memory_tag::allocate(size_t bytes) {
+  int64_t now = m_current.fetch_add(int64_t(bytes), std::memory_order_relaxed)
+                + int64_t(bytes);
+  int64_t peak = m_peak.load(std::memory_order_relaxed);
+  while (now > peak &&
+         !m_peak.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+  }
+  if (get_registry().num_scopes.load(std::memory_order_relaxed) > 0 && now > 0) {
+    high_water_scope::note_allocation(this, size_t(now));
+  }
+}
+
+memory_tag& get_tag(const std::string& name) {
+  auto& r = get_registry();
+  std::lock_guard<std::mutex> guard(r.lock);
+  auto& tag = r.tags[name];
+  if (!tag) tag.reset(new memory_tag(name));
+  return *tag;
+}
+
+std::map<std::string, tag_usage> get_usage() {
+  auto& r = get_registry();
+  std::lock_guard<std::mutex> guard(r.lock);
+  std::map<std::string, tag_usage> ret;
+  for (const auto& kv : r.tags) {
+    tag_usage u;
+    u.current = kv.second->current();
+    u.peak = kv.second->peak();
+    ret[kv.first] = u;
+  }
+  return ret;
+}
+
+void reset_peaks() {
+  auto& r = get_registry();
+  std::lock_guard<std::mutex> guard(r.lock);
+  for (const auto& kv : r.tags) kv.second->reset_peak();
+}
+
+std::string format_bytes(size_t bytes) {
+  static const char* units[] = {"B", "KB", "MB", "GB", "TB"};
+  double value = double(bytes);
+  size_t unit = 0;
+  while (value >= 1024 && unit + 1 < sizeof(units) / sizeof(units[0])) {
+    value /= 1024;
+    ++unit;
+  }
+  char buf[32];
+  if (unit == 0) {
+    std::snprintf(buf, sizeof(buf), "%zu B", bytes);
+  } else {
+    std::snprintf(buf, sizeof(buf), "%.1f %s", value, units[unit]);
+  }
+  return buf;
+}
+
+high_water_scope::high_water_scope() {
+  auto& r = get_registry();
+  {
+    std::lock_guard<std::mutex> guard(r.lock);
+    for (const auto& kv : r.tags) m_start[kv.second.get()] = kv.second->current();
+  }
+  std::lock_guard<std::mutex> guard(r.scope_lock);
+  r.scopes.insert(this);
+  r.num_scopes.fetch_add(1, std::memory_order_relaxed);
+}
+
+high_water_scope::~high_water_scope() {
+  auto& r = get_registry();
+  std::lock_guard<std::mutex> guard(r.scope_lock);
+  r.scopes.erase(this);
+  r.num_scopes.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void high_water_scope::note_allocation(const memory_tag* tag, size_t current) {
+  auto& r = get_registry();
+  std::lock_guard<std::mutex> guard(r.scope_lock);
+  for (high_water_scope* scope : r.scopes) {
+    // Tags registered after the scope was opened started from nothing.
+    auto start = scope->m_start.find(tag);
+    if (start != scope->m_start.end() && current <= start->second) continue;
+    size_t& peak = scope->m_peaks[tag];
+    if (current > peak) peak = current;
+  }
+}
+
+std::map<std::string, size_t> high_water_scope::peaks() const {
+  std::lock_guard<std::mutex> guard(get_registry().scope_lock);
+  std::map<std::string, size_t> ret;
+  for (const auto& kv : m_peaks) ret[kv.first->name()] = kv.second;
+  return ret;
+}
+
+std::string high_water_scope::summary() const {
+  std::string ret;
+  for (const auto& kv : peaks()) {
+    if (!ret.empty()) ret += ", ";
+    ret += kv.first + ": " + format_bytes(kv.second);
+  }
+  return ret;
+}
+
+} // memory_accounting
+} // turi
@@ -0,0 +1,204 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_GLOBALS_MEMORY_ACCOUNTING_HPP
+#define TURI_GLOBALS_MEMORY_ACCOUNTING_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace turi {
+namespace memory_accounting {
+
+/**
+ * \defgroup memory_accounting Memory Accounting
+ *
+ * \brief Bytes held by the large in-memory structures, by tag, with
+ * high-water marks.
+ *
+ * Each kind of structure (ml_data blocks, join hash tables, sort buffers,
+ * model parameters, ...) counts the bytes it holds against a named tag. A
+ * tag knows how many bytes are held now, and the most ever held since its
+ * peak was last reset.
+ *
+ * \ref tagged_memory holds bytes of a tag for the lifetime of an object:
+ * \code
+ * static memory_accounting::memory_tag& tag =
+ *     memory_accounting::get_tag("join_hash_table");
+ * memory_accounting::tagged_memory table_memory(tag);
+ * table_memory.add(row_bytes);
+ * \endcode
+ *
+ * \ref high_water_scope measures the peaks of one operation, for instance a
+ * toolkit training, while other operations may run at the same time.
+ *
+ * The byte counts are estimates made by the structures themselves, not
+ * measurements of the allocator. All functions are thread safe.
+ */
+
+/**
+ * \ingroup memory_accounting
+ * The bytes held under one name.
+ */
+class memory_tag {
+ public:
+  explicit memory_tag(const std::string& name) : m_name(name) {}
+  memory_tag(const memory_tag&) = delete;
+  memory_tag& operator=(const memory_tag&) = delete;
+
+  const std::string& name() const { return m_name; }
+
+  /// Counts bytes as held.
+  void allocate(size_t bytes);
+
+  /// Counts bytes as no longer held.
+  void release(size_t bytes) {
+    m_current.fetch_sub(int64_t(bytes), std::memory_order_relaxed);
+  }
+
+  /// The bytes held now.
+  size_t current() const {
+    int64_t c = m_current.load(std::memory_order_relaxed);
+    return c > 0 ? size_t(c) : 0;
+  }
+
+  /// The most bytes held at once since the last \ref reset_peak().
+  size_t peak() const { return size_t(m_peak.load(std::memory_order_relaxed)); }
+
+  /// Lowers the peak to the bytes held now.
+  void reset_peak() {
+    m_peak.store(int64_t(current()), std::memory_order_relaxed);
+  }
+
+ private:
+  std::string m_name;
+  std::atomic<int64_t> m_current{0};
+  std::atomic<int64_t> m_peak{0};
+};
+
+/**
+ * \ingroup memory_accounting
+ * Returns the tag registered under this name, registering it on the first
+ * call. Tags live until the process exits.
+ */
+memory_tag& get_tag(const std::string& name);
+
+/**
+ * \ingroup memory_accounting
+ * The bytes held now and the peak of one tag.
+ */
+struct tag_usage {
+  size_t current = 0;
+  size_t peak = 0;
+};
+
+/**
+ * \ingroup memory_accounting
+ * The usage of every tag, by name.
+ */
+std::map<std::string, tag_usage> get_usage();
+
+/**
+ * \ingroup memory_accounting
+ * Lowers the peak of every tag to the bytes it holds now.
+ */
+void reset_peaks();
+
+/**
+ * \ingroup memory_accounting
+ * Formats a number of bytes for people, e.g. "1.5 GB".
+ */
+std::string format_bytes(size_t bytes);
+
+/**
+ * \ingroup memory_accounting
+ * Bytes of a tag, released when the object is destroyed. Copies hold their
+ * own bytes.
+ */
+class tagged_memory {
+ public:
+  explicit tagged_memory(memory_tag& tag) : m_tag(&tag) {}
+  tagged_memory(const tagged_memory& other) : m_tag(other.m_tag) {
+    add(other.m_bytes);
+  }
+  tagged_memory& operator=(const tagged_memory& other) {
+    if (this != &other) {
+      clear();
+      m_tag = other.m_tag;
+      add(other.m_bytes);
+    }
+    return *this;
+  }
+  ~tagged_memory() { clear(); }
+
+  /// The bytes held.
+  size_t size() const { return m_bytes; }
+
+  /// Holds bytes more.
+  void add(size_t bytes) {
+    if (bytes == 0) return;
+    m_tag->allocate(bytes);
+    m_bytes += bytes;
+  }
+
+  /// Holds exactly this many bytes.
+  void set(size_t bytes) {
+    if (bytes > m_bytes) {
+      add(bytes - m_bytes);
+    } else if (bytes < m_bytes) {
+      m_tag->release(m_bytes - bytes);
+      m_bytes = bytes;
+    }
+  }
+
+  /// Releases all the bytes.
+  void clear() { set(0); }
+
+ private:
+  memory_tag* m_tag;
+  size_t m_bytes = 0;
+};
+
+/**
+ * \ingroup memory_accounting
+ * Tracks the peak of every tag between its construction and its
+ * destruction, starting from the bytes held at construction. Scopes may
+ * nest and overlap; each sees every allocation made while it is open,
+ * whichever thread makes it.
+ */
+class high_water_scope {
+ public:
+  high_water_scope();
+  ~high_water_scope();
+  high_water_scope(const high_water_scope&) = delete;
+  high_water_scope& operator=(const high_water_scope&) = delete;
+
+  /**
+   * The peak of each tag which grew past the bytes it held when the scope
+   * was opened.
+   */
+  std::map<std::string, size_t> peaks() const;
+
+  /**
+   * The peaks as one line, e.g. "ml_data_blocks: 1.5 GB, join_hash_table:
+   * 20 MB", or an empty string if no tag grew.
+   */
+  std::string summary() const;
+
+ private:
+  friend class memory_tag;
+
+  /// Raises the peaks of the open scopes to the bytes a tag holds now.
+  static void note_allocation(const memory_tag* tag, size_t current);
+
+  std::map<const memory_tag*, size_t> m_peaks;
+  std::map<const memory_tag*, size_t> m_start;
+};
+
+} // memory_accounting
+} // turi
+#endif
@@ -0,0 +1,206 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <core/globals/metrics.hpp>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/logging/assertions.hpp>
+#include <core/parallel/thread_pool.hpp>
+
+namespace turi {
+namespace metrics {
+
+constexpr size_t histogram::NUM_BUCKETS;
+
+size_t metric_shard() {
+  static std::atomic<size_t> next_shard{0};
+  static thread_local size_t shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed) % NUM_METRIC_SHARDS;
+  return shard;
+}
+
+int64_t counter::value() const {
+  int64_t ret = 0;
+  for (const auto& s : m_shards) ret += s.value.load(std::memory_order_relaxed);
+  return ret;
+}
+
+void histogram::observe(int64_t v) {
+  if (v < 0) v = 0;
+  size_t bucket = 0;
+  while (bucket + 1 < NUM_BUCKETS && v >= bucket_bound(bucket)) ++bucket;
+  auto& s = m_shards[metric_shard()];
+  s.count.fetch_add(1, std::memory_order_relaxed);
+  s.sum.fetch_add(v, std::memory_order_relaxed);
+  s.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+int64_t histogram::count() const {
+  int64_t ret = 0;
+  for (const auto& s : m_shards) ret += s.count.load(std::memory_order_relaxed);
+  return ret;
+}
+
+int64_t histogram::sum() const {
+  int64_t ret = 0;
+  for (const auto& s : m_shards) ret += s.sum.load(std::memory_order_relaxed);
+  return ret;
+}
+
+void histogram::buckets(int64_t out[NUM_BUCKETS]) const {
+  for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+    out[i] = 0;
+    for (const auto& s : m_shards) {
+      out[i] += s.buckets[i].load(std::memory_order_relaxed);
+    }
+  }
+}
+
+namespace {
+
+enum class metric_kind { COUNTER, GAUGE, GAUGE_FUNCTION, HISTOGRAM };
+
+struct metric_entry {
+  metric_kind kind;
+  std::string help;
+  std::unique_ptr<counter> c;
+  std::unique_ptr<gauge> g;
+  std::unique_ptr<histogram> h;
+  std::function<int64_t()> fn;
+};
+
+struct registry {
+  std::mutex lock;
+  std::map<std::string, metric_entry> entries;
+
+  registry() {
+    metric_entry& e = entries["thread_pool_queue_depth"];
+    e.kind = metric_kind::GAUGE_FUNCTION;
+    e.help = "Tasks launched on the shared thread pool and not yet started.";
+    e.fn = []() -> int64_t {
+      return thread_pool::get_instance().num_queued_tasks();
+    };
+  }
+
+  metric_entry& get(const std::string& name, const std::string& help,
+                    metric_kind kind) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = entries.find(name);
+    if (it == entries.end()) {
+      metric_entry& e = entries[name];
+      e.kind = kind;
+      e.help = help;
+      switch (kind) {
+        case metric_kind::COUNTER: e.c.reset(new counter); break;
+        case metric_kind::GAUGE: e.g.reset(new gauge); break;
+        case metric_kind::HISTOGRAM: e.h.reset(new histogram); break;
+        case metric_kind::GAUGE_FUNCTION: break;
+      }
+      return e;
+    }
+    if (it->second.kind != kind) {
+      log_and_throw("Metric " + name + " is already registered as another kind.");
+    }
+    return it->second;
+  }
+};
+
+// Never destroyed, so that the metrics outlive every static that points to
+// them.
+registry& get_registry() {
+  static registry* r = new registry;
+  return *r;
+}
+
+}  // namespace
+
+counter& get_counter(const std::string& name, const std::string& help) {
+  return *get_registry().get(name, help, metric_kind::COUNTER).c;
+}
+
+gauge& get_gauge(const std::string& name, const std::string& help) {
+  return *get_registry().get(name, help, metric_kind::GAUGE).g;
+}
+
+histogram& get_histogram(const std::string& name, const std::string& help) {
+  return *get_registry().get(name, help, metric_kind::HISTOGRAM).h;
+}
+
+void register_gauge_function(const std::string& name, const std::string& help,
+                             std::function<int64_t()> fn) {
+  registry& r = get_registry();
+  metric_entry& e = r.get(name, help, metric_kind::GAUGE_FUNCTION);
+  std::lock_guard<std::mutex> guard(r.lock);
+  e.fn = std::move(fn);
+}
+
+std::map<std::string, flexible_type> list_metrics() {
+  registry& r = get_registry();
+  std::lock_guard<std::mutex> guard(r.lock);
+  std::map<std::string, flexible_type> ret;
+  for (const auto& kv : r.entries) {
+    const metric_entry& e = kv.second;
+    switch (e.kind) {
+      case metric_kind::COUNTER: ret[kv.first] = e.c->value(); break;
+      case metric_kind::GAUGE: ret[kv.first] = e.g->value(); break;
+      case metric_kind::GAUGE_FUNCTION:
+        ret[kv.first] = e.fn ? e.fn() : 0;
+        break;
+      case metric_kind::HISTOGRAM:
+        ret[kv.first + "_count"] = e.h->count();
+        ret[kv.first + "_sum"] = e.h->sum();
+        break;
+    }
+  }
+  return ret;
+}
+
+std::string prometheus_text() {
+  registry& r = get_registry();
+  std::lock_guard<std::mutex> guard(r.lock);
+  std::ostringstream out;
+  for (const auto& kv : r.entries) {
+    const metric_entry& e = kv.second;
+    const std::string name = "turi_" + kv.first;
+    if (!e.help.empty()) out << "# HELP " << name << " " << e.help << "\n";
+    switch (e.kind) {
+      case metric_kind::COUNTER:
+        out << "# TYPE " << name << " counter\n"
+            << name << " " << e.c->value() << "\n";
+        break;
+      case metric_kind::GAUGE:
+        out << "# TYPE " << name << " gauge\n"
+            << name << " " << e.g->value() << "\n";
+        break;
+      case metric_kind::GAUGE_FUNCTION:
+        out << "# TYPE " << name << " gauge\n"
+            << name << " " << (e.fn ? e.fn() : 0) << "\n";
+        break;
+      case metric_kind::HISTOGRAM: {
+        out << "# TYPE " << name << " histogram\n";
+        int64_t buckets[histogram::NUM_BUCKETS];
+        e.h->buckets(buckets);
+        // Prometheus buckets are cumulative, with inclusive upper bounds.
+        int64_t cumulative = 0;
+        for (size_t i = 0; i + 1 < histogram::NUM_BUCKETS; ++i) {
+          cumulative += buckets[i];
+          out << name << "_bucket{le=\"" << histogram::bucket_bound(i) - 1
+              << "\"} " << cumulative << "\n";
+        }
+        cumulative += buckets[histogram::NUM_BUCKETS - 1];
+        out << name << "_bucket{le=\"+Inf\"} " << cumulative << "\n"
+            << name << "_sum " << e.h->sum() << "\n"
+            << name << "_count " << cumulative << "\n";
+        break;
+      }
+    }
+  }
+  return out.str();
+}
+
+} // metrics
+} // turi
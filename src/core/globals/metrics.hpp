@@ -0,0 +1,160 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_GLOBALS_METRICS_HPP
+#define TURI_GLOBALS_METRICS_HPP
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace turi {
+
+class flexible_type;
+
+namespace metrics {
+
+/**
+ * \defgroup metrics Runtime Metrics
+ *
+ * \brief Always-on counters, gauges and histograms for the hot paths.
+ *
+ * Metrics are registered once by name, and live until the process exits.
+ * An instrumentation site keeps a reference in a function-local static:
+ * \code
+ * static metrics::counter& hits =
+ *     metrics::get_counter("block_cache_hits", "Block cache lookups that hit.");
+ * ++hits;
+ * \endcode
+ *
+ * Updates are relaxed atomic adds on a slot picked by the calling thread, so
+ * threads updating the same counter do not share a cache line. Reads sum the
+ * slots, and are only as consistent as a snapshot of concurrent updates can
+ * be.
+ */
+
+/// Number of slots a counter or histogram is spread over.
+static constexpr size_t NUM_METRIC_SHARDS = 16;
+
+/// The slot of the calling thread.
+size_t metric_shard();
+
+/**
+ * \ingroup metrics
+ * A monotonically increasing count.
+ */
+class counter {
+ public:
+  void add(int64_t n) {
+    m_shards[metric_shard()].value.fetch_add(n, std::memory_order_relaxed);
+  }
+  counter& operator++() { add(1); return *this; }
+  counter& operator+=(int64_t n) { add(n); return *this; }
+
+  /// Sum over all the slots.
+  int64_t value() const;
+
+ private:
+  // Padded rather than over-aligned, so that counters can be allocated with
+  // plain new: the values of two slots are always 64 bytes apart.
+  struct shard {
+    std::atomic<int64_t> value{0};
+    char __pad__[64 - sizeof(std::atomic<int64_t>)];
+  };
+  shard m_shards[NUM_METRIC_SHARDS];
+};
+
+/**
+ * \ingroup metrics
+ * A value that goes up and down, such as the length of a queue.
+ */
+class gauge {
+ public:
+  void add(int64_t n) { m_value.fetch_add(n, std::memory_order_relaxed); }
+  void set(int64_t n) { m_value.store(n, std::memory_order_relaxed); }
+  int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<int64_t> m_value{0};
+};
+
+/**
+ * \ingroup metrics
+ * A distribution of non-negative values, in power of two buckets: bucket i
+ * counts the values v with 2^(i-1) <= v < 2^i (bucket 0 counts zeros).
+ */
+class histogram {
+ public:
+  static constexpr size_t NUM_BUCKETS = 48;
+
+  void observe(int64_t v);
+
+  /// Number of values observed.
+  int64_t count() const;
+
+  /// Sum of the values observed.
+  int64_t sum() const;
+
+  /// Number of values observed in each bucket.
+  void buckets(int64_t out[NUM_BUCKETS]) const;
+
+  /// The exclusive upper bound of bucket i.
+  static int64_t bucket_bound(size_t i) { return int64_t(1) << i; }
+
+ private:
+  // Padded like counter::shard.
+  struct shard {
+    std::atomic<int64_t> count{0};
+    std::atomic<int64_t> sum{0};
+    std::atomic<int64_t> buckets[NUM_BUCKETS] = {};
+    char __pad__[64 - sizeof(std::atomic<int64_t>)];
+  };
+  shard m_shards[NUM_METRIC_SHARDS];
+};
+
+/**
+ * \ingroup metrics
+ * Returns the counter registered under this name, registering it on the
+ * first call. The help string is kept from the first registration.
+ * Registering a name as two different kinds of metric throws.
+ */
+counter& get_counter(const std::string& name, const std::string& help = "");
+
+/// \ingroup metrics
+/// The gauge counterpart of \ref get_counter.
+gauge& get_gauge(const std::string& name, const std::string& help = "");
+
+/// \ingroup metrics
+/// The histogram counterpart of \ref get_counter.
+histogram& get_histogram(const std::string& name, const std::string& help = "");
+
+/**
+ * \ingroup metrics
+ * Registers a gauge whose value is read by calling a function, for state that
+ * is already tracked elsewhere (such as the length of a queue). The function
+ * is called with the registry locked, so it must not register metrics.
+ * Registering the same name again replaces the function.
+ */
+void register_gauge_function(const std::string& name, const std::string& help,
+                             std::function<int64_t()> fn);
+
+/**
+ * \ingroup metrics
+ * The current value of every metric, by name. A histogram is listed as
+ * name_count and name_sum.
+ */
+std::map<std::string, flexible_type> list_metrics();
+
+/**
+ * \ingroup metrics
+ * Every metric in the Prometheus text exposition format, with names prefixed
+ * by "turi_".
+ */
+std::string prometheus_text();
+
+} // metrics
+} // turi
+#endif
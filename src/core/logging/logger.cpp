@@ -4,11 +4,16 @@
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
 #include <core/logging/logger.hpp>
+#include <atomic>
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
+#include <condition_variable>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <core/parallel/pthread_h.h>
 #include <core/logging/backtrace.hpp>
 #include <core/export.hpp>
@@ -33,6 +38,36 @@ const char* messages[] = {  "DEBUG:    ",
                             "ERROR:    ",
                             "FATAL:    "};
 
+struct file_logger::async_state {
+  struct record {
+    int loglevel;
+    std::string line;
+  };
+
+  std::mutex lock;
+  /// Signalled when there are lines to write, or the writer must stop
+  std::condition_variable work;
+  /// Signalled when the writer takes a batch off the queue
+  std::condition_variable space;
+  /// Signalled when the writer is done with a batch
+  std::condition_variable drained;
+
+  std::vector<record> pending;
+  size_t pending_bytes = 0;
+  /// The number of lines dropped since the last batch
+  size_t dropped = 0;
+  /// True while the writer writes a batch
+  bool writing = false;
+  bool stop = false;
+
+  /// Read without the lock on the logging path
+  std::atomic<bool> enabled{false};
+  std::thread writer;
+  /// The process the writer thread lives in. A forked child has no writer.
+  size_t writer_pid = 0;
+  size_t max_pending_bytes = 0;
+  bool block_when_full = false;
+};
 
 file_logger::file_logger() {
   log_file = "";
@@ -43,9 +78,11 @@ file_logger::file_logger() {
   }
   pthread_mutex_init(&mut, NULL);
   pthread_key_create(&streambuffkey, streambuffdestructor);
+  async.reset(new async_state);
 }
 
 file_logger::~file_logger() {
+  set_async(false);
   pthread_mutex_lock(&mut);
   if (fout.good()) {
     fout.flush();
@@ -57,6 +94,8 @@ file_logger::~file_logger() {
 }
 
 bool file_logger::set_log_file(std::string file) {
+  // queued lines belong in the current file
+  flush();
   // close the file if it is open
   pthread_mutex_lock(&mut);
   if (fout.good()) {
@@ -205,11 +244,131 @@ void file_logger::_logbuf(int lineloglevel,const char* file,const char* function
   }
 }
 
+void file_logger::set_async(bool enabled, size_t max_pending_bytes,
+                            bool block_when_full) {
+  std::thread writer;
+  {
+    if (async->enabled && async->writer_pid != turi::get_my_pid()) {
+      // a forked child: the writer thread, and whoever held the lock, are
+      // in the parent
+      async->enabled = false;
+      async->writer.detach();
+      async->writer = std::thread();
+      return;
+    }
+    if (!enabled) flush();
+    std::lock_guard<std::mutex> guard(async->lock);
+    async->max_pending_bytes = max_pending_bytes;
+    async->block_when_full = block_when_full;
+    if (enabled == async->enabled) return;
+    if (enabled) {
+      async->stop = false;
+      async->writer_pid = turi::get_my_pid();
+      async->writer = std::thread([this]() { async_writer_loop(); });
+      async->enabled = true;
+    } else {
+      async->enabled = false;
+      async->stop = true;
+      async->work.notify_all();
+      async->space.notify_all();
+      writer = std::move(async->writer);
+    }
+  }
+  // the writer drains the queue before exiting
+  if (writer.joinable()) writer.join();
+}
+
+bool file_logger::get_async() const {
+  return async->enabled;
+}
+
+void file_logger::flush() {
+  if (!async->enabled || async->writer_pid != turi::get_my_pid()) return;
+  std::unique_lock<std::mutex> guard(async->lock);
+  async->drained.wait(guard, [&]() {
+      return async->stop ||
+             (async->pending.empty() && async->dropped == 0 && !async->writing);
+  });
+}
+
+bool file_logger::async_enqueue(int lineloglevel, const char* buf, int len) {
+  if (!async->enabled) return false;
+  // the process may be about to die: everything must reach the file
+  if (lineloglevel >= LOG_FATAL) {
+    flush();
+    return false;
+  }
+  if (async->writer_pid != turi::get_my_pid()) return false;
+
+  std::unique_lock<std::mutex> guard(async->lock);
+  if (async->stop) return false;
+  // a line longer than the whole queue still goes through, alone
+  auto has_space = [&]() {
+    return async->pending.empty() ||
+           async->pending_bytes + len <= async->max_pending_bytes;
+  };
+  if (!has_space()) {
+    if (!async->block_when_full) {
+      ++async->dropped;
+      return true;
+    }
+    async->space.wait(guard, [&]() { return async->stop || has_space(); });
+    if (async->stop) return false;
+  }
+  async->pending.push_back({lineloglevel, std::string(buf, len)});
+  async->pending_bytes += len;
+  async->work.notify_one();
+  return true;
+}
+
+void file_logger::async_writer_loop() {
+  std::vector<async_state::record> batch;
+  std::unique_lock<std::mutex> guard(async->lock);
+  while (true) {
+    async->work.wait(guard, [&]() {
+        return async->stop || !async->pending.empty() || async->dropped > 0;
+    });
+    if (async->pending.empty() && async->dropped == 0) break;
+    batch.swap(async->pending);
+    async->pending_bytes = 0;
+    size_t dropped = async->dropped;
+    async->dropped = 0;
+    async->writing = true;
+    async->space.notify_all();
+    guard.unlock();
+
+    for (const auto& r : batch) {
+      _write_line(r.loglevel, r.line.c_str(), r.line.length(), false);
+    }
+    if (dropped > 0) {
+      std::string note = std::string(messages[LOG_WARNING]) +
+                         std::to_string(dropped) +
+                         " log lines dropped: the log queue was full\n";
+      _write_line(LOG_WARNING, note.c_str(), note.length(), false);
+    }
+    pthread_mutex_lock(&mut);
+    if (fout.good()) fout.flush();
+    pthread_mutex_unlock(&mut);
+    batch.clear();
+
+    guard.lock();
+    async->writing = false;
+    async->drained.notify_all();
+  }
+  async->drained.notify_all();
+}
+
 void file_logger::_lograw(int lineloglevel, const char* buf, int len) {
+  if (async_enqueue(lineloglevel, buf, len)) return;
+  _write_line(lineloglevel, buf, len);
+}
+
+void file_logger::_write_line(int lineloglevel, const char* buf, int len,
+                              bool flush_file) {
   pthread_mutex_lock(&mut);
   if (fout.good()) {
     fout.write(buf,len);
-    fout.flush();
+    if (flush_file) fout.flush();
   }
   pthread_mutex_unlock(&mut);
   if (log_to_console || log_to_stderr) {
@@ -45,6 +45,7 @@
 #include <system_error>
 #endif
 #include <functional>
+#include <memory>
 #include <core/parallel/pthread_h.h>
 #include <timer/timer.hpp>
 #include <core/logging/fail_method.hpp>
@@ -525,6 +526,32 @@ class file_logger{
     return log_level;
   }
 
+  /**
+   * Writes log lines on a background thread. A logging thread then only
+   * formats its line and appends it to a queue; the writes to the log file
+   * and the console, and the flushes, are done off the calling thread, a
+   * batch at a time.
+   *
+   * At most max_pending_bytes of lines are queued. Beyond that, lines are
+   * dropped (the writer notes how many), or, if block_when_full, the
+   * logging thread waits for room.
+   *
+   * LOG_FATAL lines flush the queue and are written synchronously, as are
+   * lines logged in a forked child. set_log_file() flushes the queue first,
+   * so that each line lands in the file which was current when it was
+   * logged, including across log rotations.
+   *
+   * Disabling flushes the queue and stops the thread.
+   */
+  void set_async(bool enabled, size_t max_pending_bytes = 16 * 1024 * 1024,
+                 bool block_when_full = false);
+
+  /// Returns true if log lines are written on a background thread.
+  bool get_async() const;
+
+  /// Waits until every queued log line is written. No-op if not async.
+  void flush();
+
   /**
    * Set a callback to be called whenever a log message at a particular
    * log level is issued. Only one observer can be set per log level.
@@ -645,6 +672,9 @@ class file_logger{
 
   void _lograw(int loglevel, const char* buf, int len);
 
+  /// Writes a line to the file and the console, on the calling thread.
+  void _write_line(int loglevel, const char* buf, int len, bool flush_file = true);
+
   inline void stream_flush() {
     // get the stream buffer
     logger_impl::streambuff_tls_entry* streambufentry =
@@ -690,6 +720,15 @@ class file_logger{
   // LOG_NONE is the "highest" log level
   std::function<void(int lineloglevel, const char* buf, size_t len)> callback[LOG_NONE];
   int has_callback[LOG_NONE];
+
+  /// The queue and writer thread of the asynchronous mode. See set_async().
+  struct async_state;
+  std::unique_ptr<async_state> async;
+
+  /// Queues a line if asynchronous. Returns false if it must be written now.
+  bool async_enqueue(int loglevel, const char* buf, int len);
+
+  void async_writer_loop();
 };
 
 
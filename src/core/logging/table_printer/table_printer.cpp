@@ -160,11 +160,13 @@ void table_printer::print_line_break() const {
   _p(ss);
 }
 
-/** Prints the footer.
+/** Prints the footer, followed by the peak memory of each tag of the
+ *  memory accounting which grew while the table was alive.
  *
  *  Example output:
  *
  *      +-----------+------------+----------+------------------+
+ *      Peak memory: ml_data_blocks: 120.5 MB, model_parameters: 8.0 MB
  */
 void table_printer::print_footer() const {
   // If tracking is enabled, print the last tracked row if it wasn't already
@@ -173,6 +175,13 @@ void table_printer::print_footer() const {
 
   print_line_break();
 
+  std::string memory_summary = memory_scope->summary();
+  if (!memory_summary.empty()) {
+    std::ostringstream ss;
+    ss << "Peak memory: " << memory_summary;
+    _p(ss);
+  }
+
   _os_log_event_impl(3ul /* event: ended */);
 }
 
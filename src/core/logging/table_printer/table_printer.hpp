@@ -12,6 +12,8 @@
 #include <core/parallel/pthread_tools.hpp>
 #include <core/storage/sframe_data/sframe.hpp>
 #include <core/parallel/atomic.hpp>
+#include <core/globals/memory_accounting.hpp>
+#include <memory>
 #include <sstream>
 #include <vector>
 
@@ -200,7 +202,10 @@ struct progress_time {
 class table_printer {
 
  public:
-  /** Constructor.  Must be initialized elsewise using copy assignment ops. */
+  /** Constructor.  Must be initialized elsewise using copy assignment ops.
+   *  Copies share the memory scope of the table they are copied from, so the
+   *  footer reports the peaks since that table was created.
+   */
   table_printer(){}
 
   /** Constructor.  Sets up the columns.
@@ -249,11 +254,13 @@ class table_printer {
    */
   void print_line_break() const;
 
-  /** Prints the footer.
+  /** Prints the footer, followed by the peak memory of each tag of the
+   *  \ref memory_accounting which grew while the table was alive.
    *
    *  Example output:
    *
    *      +-----------+------------+----------+------------------+
+   *      Peak memory: ml_data_blocks: 120.5 MB, model_parameters: 8.0 MB
    */
   void print_footer() const;
 
@@ -665,6 +672,11 @@ private:
   std::vector<style_type> track_row_styles_;
   size_t track_interval = 1;
 
+  // The peak memory of the operation the table reports on. Held by pointer,
+  // as a scope cannot be copied, and shared by the copies of the table.
+  std::shared_ptr<memory_accounting::high_water_scope> memory_scope
+      = std::make_shared<memory_accounting::high_water_scope>();
+
 
   /**  Record a row in the tracking SFrame.
    */
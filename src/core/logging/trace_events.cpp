@@ -0,0 +1,199 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+#include <core/logging/logger.hpp>
+#include <core/logging/trace_events.hpp>
+#include <core/globals/globals.hpp>
+#include <core/system/platform/process/process_util.hpp>
+#include <core/export.hpp>
+
+namespace turi {
+
+EXPORT std::string TRACE_EVENTS_FILE = "";
+
+REGISTER_GLOBAL_WITH_CHECKS(std::string, TRACE_EVENTS_FILE, true,
+                            +[](std::string path) {
+                              return trace::set_output_file(path);
+                            });
+
+namespace trace {
+
+std::atomic<bool> g_trace_enabled{false};
+
+namespace {
+
+// A thread writes its buffer out once it holds this many events.
+constexpr size_t THREAD_BUFFER_SIZE = 4096;
+
+struct event {
+  const char* category;
+  std::string name;
+  uint64_t start_us;
+  uint64_t duration_us;
+};
+
+struct thread_buffer {
+  std::mutex lock;
+  size_t tid;
+  std::vector<event> events;
+};
+
+std::string json_escape(const std::string& s) {
+  std::string ret;
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      ret += '\\';
+      ret += c;
+    } else if ((unsigned char)c < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", (unsigned int)c);
+      ret += buf;
+    } else {
+      ret += c;
+    }
+  }
+  return ret;
+}
+
+struct recorder {
+  // Guards everything below. Taken before a thread_buffer lock, never after.
+  std::mutex lock;
+  std::unique_ptr<std::ofstream> file;
+  std::set<thread_buffer*> buffers;
+  size_t pid = get_my_pid();
+
+  void write(size_t tid, const std::vector<event>& events) {
+    if (!file) return;
+    for (const auto& e : events) {
+      (*file) << "{\"name\":\"" << json_escape(e.name)
+              << "\",\"cat\":\"" << e.category
+              << "\",\"ph\":\"X\",\"ts\":" << e.start_us
+              << ",\"dur\":" << e.duration_us
+              << ",\"pid\":" << pid << ",\"tid\":" << tid << "},\n";
+    }
+  }
+
+  // Called with lock held.
+  void drain_all() {
+    std::vector<event> events;
+    for (thread_buffer* b : buffers) {
+      {
+        std::lock_guard<std::mutex> guard(b->lock);
+        events.swap(b->events);
+      }
+      write(b->tid, events);
+      events.clear();
+    }
+    if (file) file->flush();
+  }
+};
+
+// Never destroyed, since threads may exit after static destruction.
+recorder& get_recorder() {
+  static recorder* r = new recorder;
+  return *r;
+}
+
+// Registers the buffer of a thread, and writes out what is left in it when
+// the thread exits.
+struct thread_buffer_holder {
+  thread_buffer buffer;
+
+  thread_buffer_holder() {
+    static std::atomic<size_t> next_tid{1};
+    buffer.tid = next_tid.fetch_add(1);
+    recorder& r = get_recorder();
+    std::lock_guard<std::mutex> guard(r.lock);
+    r.buffers.insert(&buffer);
+  }
+
+  ~thread_buffer_holder() {
+    recorder& r = get_recorder();
+    std::lock_guard<std::mutex> guard(r.lock);
+    r.buffers.erase(&buffer);
+    std::lock_guard<std::mutex> buffer_guard(buffer.lock);
+    r.write(buffer.tid, buffer.events);
+  }
+};
+
+thread_buffer& get_thread_buffer() {
+  static thread_local thread_buffer_holder holder;
+  return holder.buffer;
+}
+
+}  // namespace
+
+uint64_t now_us() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void record(const char* category, const std::string& name,
+            uint64_t start_us, uint64_t duration_us) {
+  thread_buffer& b = get_thread_buffer();
+  std::vector<event> full;
+  {
+    std::lock_guard<std::mutex> guard(b.lock);
+    b.events.push_back(event{category, name, start_us, duration_us});
+    if (b.events.size() < THREAD_BUFFER_SIZE) return;
+    full.swap(b.events);
+  }
+  recorder& r = get_recorder();
+  std::lock_guard<std::mutex> guard(r.lock);
+  r.write(b.tid, full);
+}
+
+void flush() {
+  recorder& r = get_recorder();
+  std::lock_guard<std::mutex> guard(r.lock);
+  r.drain_all();
+}
+
+bool set_output_file(const std::string& path) {
+  recorder& r = get_recorder();
+  std::lock_guard<std::mutex> guard(r.lock);
+  g_trace_enabled = false;
+  if (r.file) {
+    // finish the previous file on an event without a trailing comma, so
+    // that it is valid JSON
+    r.drain_all();
+    (*r.file) << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << r.pid
+              << ",\"tid\":0,\"args\":{\"name\":\"turi\"}}\n]\n";
+    r.file.reset();
+  } else {
+    // drop what was buffered while no file was open
+    for (thread_buffer* b : r.buffers) {
+      std::lock_guard<std::mutex> buffer_guard(b->lock);
+      b->events.clear();
+    }
+  }
+  if (path.empty()) return true;
+
+  r.file.reset(new std::ofstream(path, std::ios::trunc));
+  if (!r.file->good()) {
+    logstream(LOG_WARNING) << "Unable to open trace events file " << path << std::endl;
+    r.file.reset();
+    return false;
+  }
+  (*r.file) << "[\n";
+  // write out what the threads still hold if the process exits while
+  // recording. The file then lacks its closing bracket, which the viewers
+  // accept.
+  static bool flush_at_exit = (std::atexit([]() { flush(); }), true);
+  (void)flush_at_exit;
+  g_trace_enabled = true;
+  return true;
+}
+
+} // trace
+} // turi
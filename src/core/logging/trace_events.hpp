@@ -0,0 +1,109 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_LOGGER_TRACE_EVENTS_HPP
+#define TURI_LOGGER_TRACE_EVENTS_HPP
+#include <atomic>
+#include <cstdint>
+#include <string>
+namespace turi {
+
+/**
+ * \ingroup turilogger
+ * The file trace events are written to, in the Chrome trace event format
+ * (which chrome://tracing and Perfetto open). Recording is off while this is
+ * empty. Set it with the environment variable TURI_TRACE_EVENTS_FILE, or at
+ * runtime; setting it back to empty finishes the file.
+ */
+extern std::string TRACE_EVENTS_FILE;
+
+namespace trace {
+
+/// \internal
+extern std::atomic<bool> g_trace_enabled;
+
+/**
+ * \ingroup turilogger
+ * Whether trace events are being recorded. Cheap enough to call on any path.
+ */
+inline bool enabled() {
+  return g_trace_enabled.load(std::memory_order_relaxed);
+}
+
+/// Microseconds on the clock trace events are timed with.
+uint64_t now_us();
+
+/**
+ * \ingroup turilogger
+ * Records a span of the calling thread which started at start_us and lasted
+ * duration_us. Events are buffered per thread, and written out when a
+ * thread's buffer fills up, when the thread exits and by \ref flush().
+ */
+void record(const char* category, const std::string& name,
+            uint64_t start_us, uint64_t duration_us);
+
+/**
+ * \ingroup turilogger
+ * Writes the events buffered by every thread to the trace file.
+ */
+void flush();
+
+/**
+ * \ingroup turilogger
+ * Starts writing trace events to the given file, or stops if the path is
+ * empty, finishing the previous file. Returns false if the file cannot be
+ * opened. This is what changing \ref TRACE_EVENTS_FILE calls.
+ */
+bool set_output_file(const std::string& path);
+
+/**
+ * \ingroup turilogger
+ * Records the lifetime of the object as a span, if recording was on when it
+ * was constructed.
+ * \code
+ * void block_manager::read_block(...) {
+ *   trace::scoped_span span("block_manager", "read_block");
+ *   ...
+ * }
+ * \endcode
+ * The category should be a string literal. A name given as a std::string is
+ * only copied when recording is on.
+ */
+class scoped_span {
+ public:
+  scoped_span(const char* category, const char* name)
+      : m_category(category), m_name(name) {
+    if (enabled()) m_start_us = now_us();
+  }
+
+  scoped_span(const char* category, const std::string& name)
+      : m_category(category) {
+    if (enabled()) {
+      m_name_copy = name;
+      m_start_us = now_us();
+    }
+  }
+
+  scoped_span(const scoped_span&) = delete;
+  scoped_span& operator=(const scoped_span&) = delete;
+
+  ~scoped_span() {
+    if (m_start_us != NOT_STARTED && enabled()) {
+      record(m_category, m_name ? std::string(m_name) : m_name_copy,
+             m_start_us, now_us() - m_start_us);
+    }
+  }
+
+ private:
+  static constexpr uint64_t NOT_STARTED = uint64_t(-1);
+  const char* m_category;
+  const char* m_name = nullptr;
+  std::string m_name_copy;
+  uint64_t m_start_us = NOT_STARTED;
+};
+
+} // trace
+} // turi
+#endif // TURI_LOGGER_TRACE_EVENTS_HPP
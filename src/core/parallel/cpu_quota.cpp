@@ -0,0 +1,155 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <core/parallel/cpu_quota.hpp>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace turi {
+
+namespace {
+
+bool read_file(const std::string& path, std::string& contents) {
+  std::ifstream fin(path);
+  if (!fin.good()) return false;
+  std::stringstream strm;
+  strm << fin.rdbuf();
+  contents = strm.str();
+  return true;
+}
+
+/**
+ * The directories of the cpu controller of the cgroup of this process, most
+ * specific first. cgroup v2 directories are flagged with is_v2.
+ */
+struct cgroup_dir {
+  std::string path;
+  bool is_v2;
+};
+
+std::vector<cgroup_dir> cgroup_cpu_dirs() {
+  std::vector<cgroup_dir> ret;
+#ifdef __linux__
+  std::ifstream fin("/proc/self/cgroup");
+  std::string line;
+  // Lines are "hierarchy-id:controllers:path".
+  while (std::getline(fin, line)) {
+    size_t first = line.find(':');
+    size_t second = line.find(':', first + 1);
+    if (first == std::string::npos || second == std::string::npos) continue;
+    std::string controllers = line.substr(first + 1, second - first - 1);
+    std::string path = line.substr(second + 1);
+    if (path == "/") path.clear();
+    if (controllers.empty()) {
+      ret.push_back({"/sys/fs/cgroup" + path, true});
+      ret.push_back({"/sys/fs/cgroup", true});
+      continue;
+    }
+    std::stringstream strm(controllers);
+    std::string controller;
+    while (std::getline(strm, controller, ',')) {
+      if (controller != "cpu") continue;
+      for (const char* root : {"/sys/fs/cgroup/cpu,cpuacct",
+                               "/sys/fs/cgroup/cpuacct,cpu",
+                               "/sys/fs/cgroup/cpu"}) {
+        ret.push_back({root + path, false});
+        ret.push_back({root, false});
+      }
+    }
+  }
+#endif
+  return ret;
+}
+
+} // anonymous namespace
+
+size_t cpu_quota::effective_cpus() const {
+  size_t ret = affinity_cpus;
+  if (quota_cpus > 0) {
+    size_t quota = std::max<size_t>(std::ceil(quota_cpus), 1);
+    ret = ret == 0 ? quota : std::min(ret, quota);
+  }
+  return ret;
+}
+
+double cpu_quota::parse_cpu_max(const std::string& contents) {
+  std::stringstream strm(contents);
+  std::string quota;
+  double period = 0;
+  if (!(strm >> quota >> period) || quota == "max" || period <= 0) return 0;
+  try {
+    double q = std::stod(quota);
+    return q > 0 ? q / period : 0;
+  } catch (...) {
+    return 0;
+  }
+}
+
+cpu_quota cpu_quota::read() {
+  cpu_quota ret;
+#ifdef __linux__
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+    ret.affinity_cpus = CPU_COUNT(&cpu_set);
+  }
+
+  for (const auto& dir : cgroup_cpu_dirs()) {
+    std::string contents;
+    if (dir.is_v2) {
+      if (!read_file(dir.path + "/cpu.max", contents)) continue;
+      ret.quota_cpus = parse_cpu_max(contents);
+    } else {
+      std::string period;
+      if (!read_file(dir.path + "/cpu.cfs_quota_us", contents) ||
+          !read_file(dir.path + "/cpu.cfs_period_us", period)) {
+        continue;
+      }
+      // -1 means no quota.
+      ret.quota_cpus = parse_cpu_max(contents + " " + period);
+    }
+    break;
+  }
+#endif
+  return ret;
+}
+
+cpu_throttle_stats cpu_throttle_stats::parse_cpu_stat(const std::string& contents) {
+  cpu_throttle_stats ret;
+  std::stringstream strm(contents);
+  std::string key;
+  uint64_t value;
+  while (strm >> key >> value) {
+    if (key == "nr_periods") {
+      ret.nr_periods = value;
+      ret.available = true;
+    } else if (key == "nr_throttled") {
+      ret.nr_throttled = value;
+    } else if (key == "throttled_usec") {
+      ret.throttled_usec = value;
+    } else if (key == "throttled_time") {
+      ret.throttled_usec = value / 1000;
+    }
+  }
+  return ret;
+}
+
+cpu_throttle_stats cpu_throttle_stats::read() {
+  for (const auto& dir : cgroup_cpu_dirs()) {
+    std::string contents;
+    if (!read_file(dir.path + "/cpu.stat", contents)) continue;
+    cpu_throttle_stats ret = parse_cpu_stat(contents);
+    if (ret.available) return ret;
+  }
+  return cpu_throttle_stats();
+}
+
+} // namespace turi
@@ -0,0 +1,80 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_PARALLEL_CPU_QUOTA_HPP
+#define TURI_PARALLEL_CPU_QUOTA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace turi {
+
+/**
+ * \ingroup threading
+ * The CPUs the process may use, as limited by its CPU affinity and by the
+ * CPU quota of its cgroup (as set by container runtimes such as Docker and
+ * Kubernetes).
+ *
+ * On Linux the quota is read from cpu.max (cgroup v2) or from
+ * cpu.cfs_quota_us and cpu.cfs_period_us (cgroup v1), in the cgroup of the
+ * process. Everywhere else, and if those cannot be read, there is no quota.
+ */
+struct cpu_quota {
+  /// The CPUs the quota allows, e.g. 1.5. 0 if there is no quota.
+  double quota_cpus = 0;
+
+  /// The number of CPUs in the affinity mask of the process. 0 if unknown.
+  size_t affinity_cpus = 0;
+
+  /**
+   * The number of threads which can run at once without exceeding the
+   * limits: the quota rounded up, and at most the affinity. 0 if there is
+   * neither limit.
+   */
+  size_t effective_cpus() const;
+
+  /// Reads the limits of this process.
+  static cpu_quota read();
+
+  /**
+   * Parses the contents of a cgroup v2 cpu.max file, "max 100000" or
+   * "150000 100000". Returns the quota in CPUs, 0 if there is none or the
+   * contents cannot be parsed.
+   */
+  static double parse_cpu_max(const std::string& contents);
+};
+
+/**
+ * \ingroup threading
+ * How much the cgroup of the process was throttled for exceeding its CPU
+ * quota, as counted by the kernel since the cgroup was created.
+ */
+struct cpu_throttle_stats {
+  /// False if the statistics could not be read.
+  bool available = false;
+
+  /// Number of quota periods elapsed.
+  uint64_t nr_periods = 0;
+
+  /// Number of periods in which the cgroup was throttled.
+  uint64_t nr_throttled = 0;
+
+  /// Total time the cgroup was throttled, in microseconds.
+  uint64_t throttled_usec = 0;
+
+  /// Reads the statistics of this process.
+  static cpu_throttle_stats read();
+
+  /**
+   * Parses the contents of a cgroup cpu.stat file. The throttled time is
+   * throttled_usec in cgroup v2, and throttled_time in nanoseconds in
+   * cgroup v1.
+   */
+  static cpu_throttle_stats parse_cpu_stat(const std::string& contents);
+};
+
+} // namespace turi
+#endif
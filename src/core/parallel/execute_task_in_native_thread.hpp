@@ -27,6 +27,14 @@ struct value_type {
     return ret;
   }
 
+  template <typename F>
+  void run_as_native(F f) {
+    auto except = execute_task_in_native_thread([&](void)->void {
+      ret = f();
+    });
+    if (except) std::rethrow_exception(except);
+  }
+
   template <typename F, typename A1>
   void run_as_native(F f, A1 a1) {
     auto except = execute_task_in_native_thread([&](void)->void {
@@ -89,6 +97,14 @@ struct value_type<void> {
 
   void get_result() { }
 
+  template <typename F>
+  void run_as_native(F f) {
+    auto except = execute_task_in_native_thread([&](void)->void {
+      f();
+    });
+    if (except) std::rethrow_exception(except);
+  }
+
   template <typename F, typename A1>
   void run_as_native(F f, A1 a1) {
     auto except = execute_task_in_native_thread([&](void)->void {
@@ -5,6 +5,8 @@
  */
 #ifndef TURI_PARALLEL_LAMBDA_OMP_HPP
 #define TURI_PARALLEL_LAMBDA_OMP_HPP
+#include <algorithm>
+#include <atomic>
 #include <iterator>
 #include <utility>
 #include <functional>
@@ -196,6 +198,217 @@ ReduceType fold_reduce (size_t begin,
   }
 }
 
+/**
+ * How \ref parallel_for and \ref fold_reduce divide the range between
+ * threads.
+ * \ingroup threading
+ */
+enum class parallel_schedule {
+  /// Every thread gets one contiguous range of the same length.
+  STATIC,
+  /// Threads take chunks of grain_size indices at a time until the range is
+  /// used up. Best when the cost of an index varies a lot.
+  DYNAMIC,
+  /// Like DYNAMIC, but the chunks start large and shrink as the range is
+  /// used up: every chunk is the remaining length divided by twice the number
+  /// of threads, and at least grain_size. Fewer chunks are taken than with
+  /// DYNAMIC for the same balance at the end.
+  GUIDED
+};
+
+/**
+ * Hands out the chunks of a range [begin, end) to threads in the order of
+ * the range, following a DYNAMIC or GUIDED \ref parallel_schedule. Safe to
+ * call from several threads at once.
+ * \ingroup threading
+ *
+ * This is used by the scheduled overloads of \ref parallel_for and \ref
+ * fold_reduce, and can be used directly within \ref in_parallel when every
+ * thread needs to set up its own state before the loop:
+ * \code
+ *  parallel_range_cursor cursor(0, n, parallel_schedule::DYNAMIC, 16);
+ *  in_parallel([&](size_t thread_idx, size_t num_threads) {
+ *    std::vector<double> buffer;
+ *    size_t chunk_begin, chunk_end;
+ *    while (cursor.next(chunk_begin, chunk_end)) {
+ *      for (size_t i = chunk_begin; i < chunk_end; ++i) process(i, buffer);
+ *    }
+ *  });
+ * \endcode
+ */
+class parallel_range_cursor {
+ public:
+  /**
+   * \param begin The beginning integer of the range
+   * \param end The ending integer of the range
+   * \param schedule DYNAMIC or GUIDED. STATIC is treated as GUIDED.
+   * \param grain_size The smallest number of indices in a chunk
+   * \param num_threads The number of threads sharing the range; only used
+   *                    to size GUIDED chunks.
+   */
+  parallel_range_cursor(size_t begin,
+                        size_t end,
+                        parallel_schedule schedule,
+                        size_t grain_size = 1,
+                        size_t num_threads = thread_pool::get_instance().size())
+      : m_cursor(begin), m_end(std::max(begin, end)),
+        m_guided(schedule != parallel_schedule::DYNAMIC),
+        m_grain_size(std::max<size_t>(grain_size, 1)),
+        m_num_threads(std::max<size_t>(num_threads, 1)) { }
+
+  /**
+   * Claims the next chunk [chunk_begin, chunk_end). Returns false if the
+   * range is used up.
+   */
+  inline bool next(size_t& chunk_begin, size_t& chunk_end) {
+    size_t current = m_cursor.load(std::memory_order_relaxed);
+    while (current < m_end) {
+      size_t remaining = m_end - current;
+      size_t chunk = m_grain_size;
+      if (m_guided) chunk = std::max(chunk, remaining / (2 * m_num_threads));
+      chunk = std::min(chunk, remaining);
+      if (m_cursor.compare_exchange_weak(current, current + chunk,
+                                         std::memory_order_relaxed)) {
+        chunk_begin = current;
+        chunk_end = current + chunk;
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  std::atomic<size_t> m_cursor;
+  const size_t m_end;
+  const bool m_guided;
+  const size_t m_grain_size;
+  const size_t m_num_threads;
+};
+
+/**
+ * Runs a parallel for ranging from the integers 'begin' to 'end', dividing
+ * the range according to schedule; see \ref parallel_schedule.
+ * \ingroup threading
+ *
+ * The static schedule is the same as \ref parallel_for(size_t, size_t, const
+ * FunctionType&). The dynamic and guided schedules suit loops where some
+ * indices cost much more than others, so that threads which finish early
+ * take over the rest of the range:
+ * \code
+ *  parallel_for(0, num_queries, [&](size_t i) {
+ *                 answer_query(i);
+ *               }, parallel_schedule::DYNAMIC, 16);
+ * \endcode
+ *
+ * \param begin The beginning integer of the for loop
+ * \param end The ending integer of the for loop
+ * \param fn The function to run. The function must take a single size_t
+ *           argument which is a current index.
+ * \param schedule How to divide the range between threads.
+ * \param grain_size The smallest number of consecutive indices a thread
+ *                   takes at a time.
+ */
+template <typename FunctionType>
+void parallel_for(size_t begin,
+                  size_t end,
+                  const FunctionType& fn,
+                  parallel_schedule schedule,
+                  size_t grain_size = 1) {
+  if (schedule == parallel_schedule::STATIC) {
+    parallel_for(begin, end, fn);
+    return;
+  }
+
+  size_t nworkers = thread_pool::get_instance().size();
+
+  if (thread::get_tls_data().is_in_thread() || nworkers <= 1) {
+    // we do not support recursive calls to in parallel yet.
+    for(size_t i = begin; i < end; ++i) {
+      fn(i);
+    }
+  } else {
+    parallel_task_queue threads(thread_pool::get_instance());
+    parallel_range_cursor cursor(begin, end, schedule, grain_size, nworkers);
+    for (size_t i = 0; i < nworkers; ++i) {
+      threads.launch([&fn, &cursor]() {
+        size_t chunk_begin = 0, chunk_end = 0;
+        while (cursor.next(chunk_begin, chunk_end)) {
+          for (size_t worker_iter = chunk_begin; worker_iter < chunk_end; ++worker_iter) {
+            fn(worker_iter);
+          }
+        }
+      }, i);
+    }
+    threads.join();
+  }
+}
+
+/**
+ * Runs a map reduce operation for ranging from the integers 'begin' to
+ * 'end', dividing the range according to schedule; see \ref
+ * parallel_schedule and \ref parallel_for(size_t, size_t, const
+ * FunctionType&, parallel_schedule, size_t).
+ * \ingroup threading
+ *
+ * As with the static \ref fold_reduce, every thread folds into its own
+ * accumulator starting at base, and the accumulators are summed with +=.
+ * Which indices end up in which accumulator depends on the timing, so the
+ * reduction should not depend on the order of the indices.
+ *
+ * \param begin The beginning integer of the for loop
+ * \param end The ending integer of the for loop
+ * \param fn The function to run. The function must take a size_t index and
+ *           a reference to the accumulator.
+ * \param base The initial value of every accumulator
+ * \param schedule How to divide the range between threads.
+ * \param grain_size The smallest number of consecutive indices a thread
+ *                   takes at a time.
+ */
+template <typename FunctionType, typename ReduceType>
+ReduceType fold_reduce (size_t begin,
+                  size_t end,
+                  const FunctionType& fn,
+                  ReduceType base,
+                  parallel_schedule schedule,
+                  size_t grain_size = 1) {
+  if (schedule == parallel_schedule::STATIC) {
+    return fold_reduce(begin, end, fn, base);
+  }
+
+  size_t nworkers = thread_pool::get_instance().size();
+
+  if (thread::get_tls_data().is_in_thread() || nworkers <= 1) {
+    // we do not support recursive calls to in parallel yet.
+    ReduceType acc = base;
+    for(size_t i = begin; i < end; ++i) {
+      fn(i, acc);
+    }
+    return acc;
+  } else {
+    parallel_task_queue threads(thread_pool::get_instance());
+    parallel_range_cursor cursor(begin, end, schedule, grain_size, nworkers);
+
+    std::vector<ReduceType> acc(nworkers, base);
+    for (size_t i = 0;i < nworkers; ++i) {
+      threads.launch([&fn, &acc, &cursor, i]() {
+                       size_t chunk_begin = 0, chunk_end = 0;
+                       while (cursor.next(chunk_begin, chunk_end)) {
+                         for (size_t worker_iter = chunk_begin;
+                              worker_iter < chunk_end; ++worker_iter) {
+                           fn(worker_iter, acc[i]);
+                         }
+                       }
+                     }, i);
+    }
+    threads.join();
+    ReduceType ret = base;
+    for (size_t i = 0; i < acc.size(); ++i) {
+      ret += acc[i];
+    }
+    return ret;
+  }
+}
+
 /**
  * Runs a parallel for over a random access iterator range.
  * \ingroup threading
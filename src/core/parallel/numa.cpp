@@ -0,0 +1,127 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <core/parallel/numa.hpp>
+#include <core/parallel/pthread_tools.hpp>
+#include <core/logging/logger.hpp>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace turi {
+
+namespace {
+
+/// Parses a cpu list like "0-3,8,10-11". Returns false on a syntax error.
+bool parse_cpu_list(const std::string& list, std::vector<size_t>& cpus) {
+  std::stringstream strm(list);
+  std::string range;
+  while (std::getline(strm, range, ',')) {
+    range.erase(std::remove_if(range.begin(), range.end(), ::isspace), range.end());
+    if (range.empty()) continue;
+    size_t dash = range.find('-');
+    try {
+      size_t begin = std::stoul(range.substr(0, dash));
+      size_t end = dash == std::string::npos ? begin : std::stoul(range.substr(dash + 1));
+      if (end < begin) return false;
+      for (size_t cpu = begin; cpu <= end; ++cpu) cpus.push_back(cpu);
+    } catch (...) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<std::string> read_node_cpu_lists() {
+  std::vector<std::string> ret;
+#ifdef __linux__
+  for (size_t node = 0; ; ++node) {
+    std::ifstream fin("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    if (!fin.good()) break;
+    std::string list;
+    std::getline(fin, list);
+    ret.push_back(list);
+  }
+#endif
+  return ret;
+}
+
+} // anonymous namespace
+
+
+numa_topology numa_topology::from_cpu_lists(const std::vector<std::string>& cpu_lists) {
+  numa_topology ret;
+  for (const auto& list: cpu_lists) {
+    std::vector<size_t> cpus;
+    if (!parse_cpu_list(list, cpus) || cpus.empty()) continue;
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    for (size_t cpu: cpus) {
+      if (cpu >= ret.m_cpu_node.size()) ret.m_cpu_node.resize(cpu + 1, 0);
+      ret.m_cpu_node[cpu] = ret.m_node_cpus.size();
+    }
+    ret.m_node_cpus.push_back(std::move(cpus));
+  }
+  if (ret.m_node_cpus.empty()) {
+    // a single node
+    size_t ncpus = std::max<size_t>(thread::cpu_count(), 1);
+    ret.m_node_cpus.emplace_back(ncpus);
+    for (size_t i = 0; i < ncpus; ++i) ret.m_node_cpus[0][i] = i;
+    ret.m_cpu_node.assign(ncpus, 0);
+  }
+  return ret;
+}
+
+const numa_topology& numa_topology::get() {
+  static const numa_topology topology = [] {
+    numa_topology ret = from_cpu_lists(read_node_cpu_lists());
+    logstream(LOG_INFO) << "NUMA nodes: " << ret.num_nodes() << std::endl;
+    return ret;
+  }();
+  return topology;
+}
+
+size_t numa_topology::cpu_for_worker(size_t worker_id, size_t num_workers) const {
+  size_t total_cpus = 0;
+  for (const auto& cpus: m_node_cpus) total_cpus += cpus.size();
+  num_workers = std::max<size_t>(num_workers, 1);
+  // If there are more workers than CPUs, wrap around.
+  size_t round = worker_id / num_workers;
+  worker_id %= num_workers;
+
+  // Node i takes the workers in [first_worker(i), first_worker(i + 1)).
+  auto first_worker = [&](size_t cpus_before) {
+    return (cpus_before * num_workers + total_cpus - 1) / total_cpus;
+  };
+  size_t cpus_before = 0;
+  for (const auto& cpus: m_node_cpus) {
+    size_t begin = first_worker(cpus_before);
+    size_t end = first_worker(cpus_before + cpus.size());
+    cpus_before += cpus.size();
+    if (worker_id >= end) continue;
+    size_t num_node_workers = end - begin;
+    // spread the workers of the node over its CPUs
+    size_t index = (worker_id - begin) * cpus.size() / num_node_workers;
+    return cpus[(index + round) % cpus.size()];
+  }
+  return worker_id;
+}
+
+size_t numa_current_node() {
+#ifdef __linux__
+  const numa_topology& topology = numa_topology::get();
+  if (topology.num_nodes() == 1) return 0;
+  int cpu = sched_getcpu();
+  return cpu < 0 ? 0 : topology.node_of_cpu(cpu);
+#else
+  return 0;
+#endif
+}
+
+}
@@ -0,0 +1,70 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_PARALLEL_NUMA_HPP
+#define TURI_PARALLEL_NUMA_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace turi {
+
+/**
+ * \ingroup threading
+ * The NUMA nodes of the machine and their CPUs.
+ *
+ * On Linux this is read from /sys/devices/system/node. Everywhere else, and
+ * if that cannot be read, the machine is a single node with all CPUs.
+ */
+class numa_topology {
+ public:
+  /// Returns the topology of this machine, discovered the first time.
+  static const numa_topology& get();
+
+  /// The number of NUMA nodes. At least 1.
+  size_t num_nodes() const { return m_node_cpus.size(); }
+
+  /// The CPUs of a node, in increasing order.
+  const std::vector<size_t>& node_cpus(size_t node) const {
+    return m_node_cpus[node];
+  }
+
+  /// The node of a CPU. 0 if unknown.
+  size_t node_of_cpu(size_t cpu) const {
+    return cpu < m_cpu_node.size() ? m_cpu_node[cpu] : 0;
+  }
+
+  /**
+   * The CPU worker_id of a pool of num_workers threads is pinned to.
+   *
+   * Workers are assigned to nodes in contiguous blocks, in proportion to the
+   * number of CPUs of each node, and spread over the CPUs of their node. So
+   * workers with neighboring ids, which usually process neighboring
+   * segments, share a node.
+   */
+  size_t cpu_for_worker(size_t worker_id, size_t num_workers) const;
+
+  /**
+   * Builds a topology from the cpu lists of every node, as in
+   * /sys/devices/system/node/node<i>/cpulist, e.g. "0-3,8-11". Lists which
+   * cannot be parsed are skipped.
+   */
+  static numa_topology from_cpu_lists(const std::vector<std::string>& cpu_lists);
+
+ private:
+  numa_topology() = default;
+  std::vector<std::vector<size_t>> m_node_cpus;
+  std::vector<size_t> m_cpu_node;
+};
+
+/**
+ * \ingroup threading
+ * The NUMA node the calling thread is running on. 0 if unknown.
+ */
+size_t numa_current_node();
+
+}
+#endif
@@ -0,0 +1,118 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <core/parallel/parallelism_controller.hpp>
+#include <core/parallel/pthread_tools.hpp>
+#include <core/logging/logger.hpp>
+
+namespace turi {
+
+namespace {
+
+/// Operations shorter than this say too little about contention.
+constexpr double MIN_MEASURED_SECONDS = 0.05;
+
+/// Throttled for more than this fraction of the time: back off.
+constexpr double MAX_THROTTLED_FRACTION = 0.05;
+
+/// Workers running less than this fraction of the time: one fewer.
+constexpr double MIN_UTILIZATION = 0.5;
+
+/// Workers running more than this fraction of the time: one more.
+constexpr double GROW_UTILIZATION = 0.8;
+
+uint64_t now_us() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+size_t max_workers() { return std::max<size_t>(thread::cpu_count(), 1); }
+
+} // anonymous namespace
+
+parallelism_controller::parallelism_controller() : m_target(max_workers()) { }
+
+parallelism_controller& parallelism_controller::get_instance() {
+  static parallelism_controller* controller = new parallelism_controller;
+  return *controller;
+}
+
+size_t parallelism_controller::recommended_workers(size_t max_workers) const {
+  size_t ret = target();
+  size_t external = external_workers();
+  size_t ncpus = turi::max_workers();
+  if (external > 0) {
+    ret = std::min(ret, external < ncpus ? ncpus - external : 1);
+  }
+  return std::max<size_t>(std::min(ret, max_workers), 1);
+}
+
+void parallelism_controller::report(size_t num_workers,
+                                    double elapsed_seconds,
+                                    double cpu_seconds,
+                                    double throttled_seconds) {
+  if (num_workers == 0 || elapsed_seconds < MIN_MEASURED_SECONDS) return;
+
+  std::lock_guard<std::mutex> guard(m_lock);
+  size_t old_target = target();
+  size_t new_target = old_target;
+  double throttled = throttled_seconds / elapsed_seconds;
+  // Without a process CPU clock, assume the workers kept busy.
+  double utilization = cpu_seconds > 0 ? cpu_seconds / (elapsed_seconds * num_workers) : 1;
+
+  if (throttled > MAX_THROTTLED_FRACTION) {
+    new_target = std::min(old_target, std::max<size_t>(num_workers * 3 / 4, 1));
+  } else if (num_workers > 1 && utilization < MIN_UTILIZATION) {
+    new_target = std::min(old_target, num_workers - 1);
+  } else if (utilization > GROW_UTILIZATION && num_workers >= old_target) {
+    new_target = std::min(old_target + 1, max_workers());
+  }
+
+  if (new_target != old_target) {
+    logstream(LOG_INFO) << "Parallelism target " << old_target << " -> " << new_target
+                        << " (" << num_workers << " workers, utilization " << utilization
+                        << ", throttled " << throttled << ")" << std::endl;
+    m_target.store(new_target, std::memory_order_relaxed);
+  }
+}
+
+void parallelism_controller::reset() {
+  std::lock_guard<std::mutex> guard(m_lock);
+  m_target.store(max_workers(), std::memory_order_relaxed);
+}
+
+parallelism_measurement::parallelism_measurement(size_t num_workers)
+    : m_num_workers(num_workers),
+      m_start_cpu(process_cpu_seconds()),
+      m_start_us(now_us()),
+      m_start_throttle(cpu_throttle_stats::read()) { }
+
+parallelism_measurement::~parallelism_measurement() {
+  double elapsed = (now_us() - m_start_us) * 1e-6;
+  double cpu = process_cpu_seconds() - m_start_cpu;
+  double throttled = 0;
+  if (m_start_throttle.available) {
+    cpu_throttle_stats end_throttle = cpu_throttle_stats::read();
+    if (end_throttle.throttled_usec >= m_start_throttle.throttled_usec) {
+      throttled = (end_throttle.throttled_usec - m_start_throttle.throttled_usec) * 1e-6;
+    }
+  }
+  parallelism_controller::get_instance().report(m_num_workers, elapsed, cpu, throttled);
+}
+
+double parallelism_measurement::process_cpu_seconds() {
+#ifdef _WIN32
+  return 0;
+#else
+  timespec ts;
+  if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) return 0;
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+} // namespace turi
@@ -0,0 +1,110 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_PARALLEL_PARALLELISM_CONTROLLER_HPP
+#define TURI_PARALLEL_PARALLELISM_CONTROLLER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <core/parallel/cpu_quota.hpp>
+
+namespace turi {
+
+/**
+ * \ingroup threading
+ * Picks how many worker threads a parallel operation should run, from the
+ * contention observed in the operations before it.
+ *
+ * An operation asks for \ref recommended_workers() before starting its
+ * workers, and reports how they did with a \ref parallelism_measurement. The
+ * target goes down when the workers got throttled for exceeding the CPU
+ * quota of the container, or spent most of their time waiting rather than
+ * running (the CPU time of the process over the time the workers were
+ * alive), and creeps back up by one worker at a time while they keep busy
+ * and unthrottled.
+ *
+ * The workers of other pools which use CPUs of their own, such as lambda
+ * worker processes, are registered with \ref add_external_workers(), and are
+ * subtracted from the recommendation so that together they stay within
+ * thread::cpu_count().
+ *
+ * All functions are thread safe.
+ */
+class parallelism_controller {
+ public:
+  static parallelism_controller& get_instance();
+
+  /**
+   * The number of workers the next operation should run, between 1 and
+   * max_workers.
+   */
+  size_t recommended_workers(size_t max_workers) const;
+
+  /// The current target, between 1 and thread::cpu_count().
+  size_t target() const { return m_target.load(std::memory_order_relaxed); }
+
+  /**
+   * Records how an operation ran: with num_workers workers for elapsed_seconds,
+   * using cpu_seconds of process CPU time, while the cgroup was throttled for
+   * throttled_seconds. Operations shorter than 50ms are ignored.
+   */
+  void report(size_t num_workers, double elapsed_seconds, double cpu_seconds,
+              double throttled_seconds);
+
+  /// Registers workers of another pool starting (delta > 0) or stopping work.
+  void add_external_workers(int64_t delta) {
+    m_external_workers.fetch_add(delta, std::memory_order_relaxed);
+  }
+
+  /// The number of workers of other pools currently busy.
+  size_t external_workers() const {
+    int64_t n = m_external_workers.load(std::memory_order_relaxed);
+    return n > 0 ? size_t(n) : 0;
+  }
+
+  /// Sets the target back to thread::cpu_count().
+  void reset();
+
+ private:
+  parallelism_controller();
+
+  std::atomic<size_t> m_target;
+  std::atomic<int64_t> m_external_workers{0};
+  std::mutex m_lock;
+};
+
+/**
+ * \ingroup threading
+ * Measures an operation from construction to destruction, and reports it to
+ * the \ref parallelism_controller.
+ *
+ * \code
+ * size_t num_workers = parallelism_controller::get_instance()
+ *                          .recommended_workers(max_workers);
+ * parallelism_measurement measurement(num_workers);
+ * // ... run num_workers workers ...
+ * \endcode
+ */
+class parallelism_measurement {
+ public:
+  explicit parallelism_measurement(size_t num_workers);
+  ~parallelism_measurement();
+  parallelism_measurement(const parallelism_measurement&) = delete;
+  parallelism_measurement& operator=(const parallelism_measurement&) = delete;
+
+  /// The CPU time used by the process so far, in seconds.
+  static double process_cpu_seconds();
+
+ private:
+  size_t m_num_workers;
+  double m_start_cpu;
+  uint64_t m_start_us;
+  cpu_throttle_stats m_start_throttle;
+};
+
+} // namespace turi
+#endif
@@ -5,6 +5,7 @@
  */
 
 #include <core/parallel/pthread_tools.hpp>
+#include <core/parallel/cpu_quota.hpp>
 #include <boost/bind.hpp>
 #include <core/util/any.hpp>
 #include <core/util/sys_util.hpp>
@@ -172,7 +173,17 @@ namespace turi {
       if (ncpus > 0) return (size_t)(ncpus);
     }
 #if defined __linux__
-    return sysconf(_SC_NPROCESSORS_CONF);
+    // The processors of the machine, or fewer if the affinity mask or the
+    // CPU quota of a container limits the process. Running more threads than
+    // the quota allows only gets the process throttled. Read once, as this
+    // is called often.
+    static const size_t ncpus = []() {
+      size_t ret = sysconf(_SC_NPROCESSORS_CONF);
+      size_t limit = cpu_quota::read().effective_cpus();
+      if (limit > 0 && limit < ret) ret = limit;
+      return ret;
+    }();
+    return ncpus;
 #elif defined(__MACH__) && defined(_SC_NPROCESSORS_ONLN)
     return sysconf (_SC_NPROCESSORS_ONLN);
 #elif defined(__MACH__) && defined(HW_NCPU)
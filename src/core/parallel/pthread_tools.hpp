@@ -932,7 +932,9 @@ namespace turi {
 
     /**
      * Return the number processing units (individual cores) on this
-     * system
+     * system, or the number the process may use if its affinity mask or the
+     * CPU quota of its cgroup is smaller (see \ref cpu_quota). The
+     * OMP_NUM_THREADS environment variable overrides it.
      */
     static size_t cpu_count();
 
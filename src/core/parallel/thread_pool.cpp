@@ -3,10 +3,14 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <chrono>
 #include <mutex>
+#include <thread>
 #include <core/parallel/thread_pool.hpp>
+#include <core/parallel/numa.hpp>
 #include <core/logging/assertions.hpp>
 #include <core/parallel/pthread_tools.hpp>
+#include <core/logging/trace_events.hpp>
 #include <core/system/platform/config/apple_config.hpp>
 
 namespace turi {
@@ -34,6 +38,25 @@ void parallel_task_queue::launch(const boost::function<void (void)> &spawn_funct
 }
 
 void parallel_task_queue::join() {
+  if (pool.in_pool_thread()) {
+    // Called from a task of the same pool: blocking here could leave no
+    // thread to run the tasks joined on, so run queued tasks until ours are
+    // done.
+    size_t num_idle = 0;
+    while(1) {
+      {
+        std::lock_guard<mutex> lock(mut);
+        if (tasks_completed == tasks_inserted) break;
+      }
+      if (pool.try_run_task()) {
+        num_idle = 0;
+      } else if (++num_idle < 64) {
+        std::this_thread::yield();
+      } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    }
+  }
   std::unique_lock<mutex> join_lock(mut);
   waiting_on_join = true;
   while(1) {
@@ -63,7 +86,15 @@ parallel_task_queue::~parallel_task_queue() {
 
 
 
-thread_pool::thread_pool(size_t nthreads, bool affinity) {
+namespace {
+// the pool the calling thread belongs to, if any, and its index in the pool
+thread_local thread_pool* tls_pool = nullptr;
+thread_local size_t tls_worker_id = 0;
+} // anonymous namespace
+
+
+thread_pool::thread_pool(size_t nthreads, bool affinity)
+    : num_queued(0), num_sleeping(0), next_queue(0) {
   cpu_affinity = affinity;
   pool_size = nthreads;
   spawn_thread_group();
@@ -76,23 +107,8 @@ void thread_pool::resize(size_t nthreads) {
   // threads.  \todo: If the pool size is too small just add
   // additional threads rather than destroying the pool
   if(nthreads != pool_size) {
+    stop_thread_group();
     pool_size = nthreads;
-
-    // stop the queue from blocking
-    spawn_queue.stop_blocking();
-
-    // join the threads in the thread group
-    while(true) {
-      try {
-        threads.join(); break;
-      } catch (const char* error_str) {
-        // this should not be possible!
-        logstream(LOG_FATAL)
-            << "Unexpected exception caught in thread pool destructor: "
-            << error_str << std::endl;
-      }
-    }
-    spawn_queue.start_blocking();
     spawn_thread_group();
   }
 } // end of set_nthreads
@@ -111,26 +127,40 @@ void thread_pool::spawn_thread_group() {
   config::init_cocoa_multithreaded_runtime();
 #endif
 
-  size_t ncpus = thread::cpu_count();
-  // start all the threads if CPU affinity is set
+  // the queues are empty when the threads are stopped, so they can be
+  // replaced safely.
+  queues.resize(std::max<size_t>(pool_size, 1));
+  for (auto& q: queues) {
+    if (q == nullptr) q.reset(new worker_queue);
+  }
+  {
+    std::lock_guard<mutex> lock(sleep_mut);
+    stopping = false;
+  }
+
+  const numa_topology& topology = numa_topology::get();
+  // start all the threads if CPU affinity is set. Threads are pinned socket
+  // by socket, so that neighboring workers share a NUMA node.
   for (size_t i = 0;i < pool_size; ++i) {
     if (cpu_affinity) {
-      threads.launch(boost::bind(&thread_pool::wait_for_task, this), i % ncpus);
+      threads.launch(boost::bind(&thread_pool::wait_for_task, this, i),
+                     topology.cpu_for_worker(i, pool_size));
     }
     else {
-      threads.launch(boost::bind(&thread_pool::wait_for_task, this));
+      threads.launch(boost::bind(&thread_pool::wait_for_task, this, i));
     }
   }
 } // end of spawn_thread_group
 
 
-void thread_pool::destroy_all_threads() {
-  // wait for all execution to complete
-  spawn_queue.wait_until_empty();
-  // kill the queue
-  spawn_queue.stop_blocking();
+void thread_pool::stop_thread_group() {
+  {
+    std::lock_guard<mutex> lock(sleep_mut);
+    stopping = true;
+    sleep_condition.broadcast();
+  }
 
-  // join the threads in the thread group
+  // join the threads in the thread group. They finish the queued tasks first.
   while(1) {
     try {
       threads.join();
@@ -141,30 +171,19 @@ void thread_pool::destroy_all_threads() {
       logstream(LOG_FATAL)
           << "Unexpected exception caught in thread pool destructor: "
           << c << std::endl;
-      ASSERT_TRUE(false);
     }
   }
+} // end of stop_thread_group
+
+
+void thread_pool::destroy_all_threads() {
+  stop_thread_group();
 } // end of destroy_all_threads
 
 void thread_pool::set_cpu_affinity(bool affinity) {
   if (affinity != cpu_affinity) {
     cpu_affinity = affinity;
-    // stop the queue from blocking
-    spawn_queue.stop_blocking();
-
-    // join the threads in the thread group
-    while(1) {
-      try {
-        threads.join(); break;
-      } catch (const char* c) {
-        // this should not be possible!
-        logstream(LOG_FATAL)
-            << "Unexpected exception caught in thread pool destructor: "
-            << c << std::endl;
-        // ASSERT_TRUE(false); // unnecessary
-      }
-    }
-    spawn_queue.start_blocking();
+    stop_thread_group();
     spawn_thread_group();
   }
 } // end of set_cpu_affinity
@@ -172,42 +191,104 @@ void thread_pool::set_cpu_affinity(bool affinity) {
 
 void thread_pool::launch(const boost::function<void (void)> &spawn_function,
                          int virtual_threadid) {
+  {
+    std::lock_guard<mutex> lock(mut);
+    ++tasks_inserted;
+  }
+  size_t queue_id = (tls_pool == this) ? tls_worker_id
+                                       : next_queue++ % queues.size();
+  {
+    worker_queue& q = *queues[queue_id];
+    std::lock_guard<mutex> lock(q.lock);
+    q.tasks.emplace_back();
+    q.tasks.back().fn = spawn_function;
+    q.tasks.back().virtual_threadid = virtual_threadid;
+    ++num_queued;
+  }
+  // A thread going to sleep counts itself in num_sleeping before it checks
+  // num_queued, so either it sees this task, or this sees it.
+  if (num_sleeping > 0) {
+    std::lock_guard<mutex> lock(sleep_mut);
+    sleep_condition.signal();
+  }
+}
+
+bool thread_pool::pop_task(size_t worker_id, task& t) {
+  if (num_queued == 0) return false;
+  size_t num_queues = queues.size();
+  for (size_t i = 0; i < num_queues; ++i) {
+    worker_queue& q = *queues[(worker_id + i) % num_queues];
+    std::lock_guard<mutex> lock(q.lock);
+    if (q.tasks.empty()) continue;
+    if (i == 0) {
+      // the most recently launched task of our own queue
+      t = std::move(q.tasks.back());
+      q.tasks.pop_back();
+    } else {
+      // the oldest task of another queue
+      t = std::move(q.tasks.front());
+      q.tasks.pop_front();
+    }
+    --num_queued;
+    return true;
+  }
+  return false;
+}
+
+void thread_pool::run_task(task& t) {
+  size_t cur_thread_id = thread::thread_id();
+  if (t.virtual_threadid != -1) {
+    thread::set_thread_id(t.virtual_threadid);
+  }
+  {
+    trace::scoped_span span("thread_pool", "task");
+    t.fn();
+  }
+  thread::set_thread_id(cur_thread_id);
+  t.fn.clear();
   std::lock_guard<mutex> lock(mut);
-  ++tasks_inserted;
-  spawn_queue.enqueue(std::make_pair(spawn_function, virtual_threadid));
+  ++tasks_completed;
+  if (waiting_on_join &&
+      tasks_completed == tasks_inserted) event_condition.signal();
 }
 
-void thread_pool::wait_for_task() {
+void thread_pool::wait_for_task(size_t worker_id) {
   thread::get_tls_data().set_in_thread_flag(true);
+  tls_pool = this;
+  tls_worker_id = worker_id;
+  task t;
   while(1) {
-    std::pair<std::pair<boost::function<void (void)>, int>, bool> queue_entry;
-    // pop from the queue
-    queue_entry = spawn_queue.dequeue();
-    if (queue_entry.second) {
-      // try to run the function. remember to put it in a try catch
-      int virtual_thread_id = queue_entry.first.second;
-      size_t cur_thread_id = thread::thread_id();
-      if (virtual_thread_id != -1) {
-        thread::set_thread_id(virtual_thread_id);
-      }
-      queue_entry.first.first();
-      thread::set_thread_id(cur_thread_id);
-      std::lock_guard<mutex> lock(mut);
-      ++tasks_completed;
-      if (waiting_on_join &&
-          tasks_completed == tasks_inserted) event_condition.signal();
-
-    }
-    else {
-      // quit if the queue is dead
-      break;
+    if (pop_task(worker_id, t)) {
+      run_task(t);
+      continue;
     }
+    std::unique_lock<mutex> lock(sleep_mut);
+    ++num_sleeping;
+    while (num_queued == 0 && !stopping) sleep_condition.wait(lock);
+    --num_sleeping;
+    // quit once the pool is stopped and all tasks are done
+    if (num_queued == 0 && stopping) break;
   }
+  tls_pool = nullptr;
 } // end of wait_for_task
 
-void thread_pool::join() {
-  spawn_queue.wait_until_empty();
+bool thread_pool::try_run_task() {
+  size_t worker_id = (tls_pool == this) ? tls_worker_id
+                                        : next_queue++ % queues.size();
+  task t;
+  if (!pop_task(worker_id, t)) return false;
+  run_task(t);
+  return true;
+}
+
+bool thread_pool::in_pool_thread() const {
+  return tls_pool == this;
+}
 
+void thread_pool::join() {
+  if (in_pool_thread()) {
+    while (try_run_task()) { }
+  }
   std::unique_lock<mutex> lock(mut);
   waiting_on_join = true;
   while(1) {
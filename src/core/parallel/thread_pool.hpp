@@ -6,9 +6,14 @@
 #ifndef TURI_THREAD_POOL_HPP
 #define TURI_THREAD_POOL_HPP
 
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <queue>
+#include <vector>
 #include <boost/bind.hpp>
+#include <boost/function.hpp>
 #include <core/parallel/pthread_tools.hpp>
-#include <core/util/blocking_queue.hpp>
 
 namespace turi {
 
@@ -91,6 +96,17 @@ class parallel_task_queue {
    * through the "launch" function, threads are woken up to perform the
    * tasks.
    *
+   * Tasks are scheduled by work stealing: every thread of the pool has its
+   * own queue of tasks. Tasks launched from a thread of the pool go to the
+   * back of its own queue, and tasks launched from elsewhere are spread over
+   * the queues in turn. A thread runs the tasks at the back of its own queue
+   * first, and steals from the front of the other queues when it runs out,
+   * so there is no single lock shared by all launches.
+   *
+   * A thread of the pool waiting in \ref parallel_task_queue::join() runs
+   * queued tasks while it waits instead of blocking, so tasks may launch and
+   * join tasks of their own on the same pool (see \ref try_run_task()).
+   *
    * The thread_pool object does not perform exception forwarding, use
    * parallel_task_queue for that.
    *
@@ -100,10 +116,32 @@ class parallel_task_queue {
    */
   class thread_pool {
   private:
+    struct task {
+      boost::function<void (void)> fn;
+      int virtual_threadid = -1;
+    };
+
+    /// The tasks queued on one thread of the pool
+    struct worker_queue {
+      mutex lock;
+      std::deque<task> tasks;
+    };
+
     thread_group threads;
-    blocking_queue<std::pair<boost::function<void (void)>, int> > spawn_queue;
+    std::vector<std::unique_ptr<worker_queue> > queues;
     size_t pool_size;
 
+    // the number of tasks in all queues
+    std::atomic<size_t> num_queued;
+    // the number of threads asleep waiting for tasks
+    std::atomic<size_t> num_sleeping;
+    // the queue the next task launched from outside of the pool goes to
+    std::atomic<size_t> next_queue;
+    // protects stopping, and puts threads without tasks to sleep
+    mutex sleep_mut;
+    conditional sleep_condition;
+    bool stopping = false;
+
     mutex mut;
     conditional event_condition;
     size_t tasks_inserted = 0;
@@ -116,9 +154,20 @@ class parallel_task_queue {
     thread_pool(const thread_pool&);
 
     /**
-       Called by each thread. Loops around a queue of tasks.
+       Called by each thread. Runs tasks until the pool is stopped.
+    */
+    void wait_for_task(size_t worker_id);
+
+    /**
+       Takes a task from the queue of worker_id, or steals one from the other
+       queues. Returns false if all queues are empty.
+    */
+    bool pop_task(size_t worker_id, task& t);
+
+    /**
+       Runs a task taken from a queue.
     */
-    void wait_for_task();
+    void run_task(task& t);
 
     /**
        Creates all the threads in the thread pool.
@@ -126,6 +175,11 @@ class parallel_task_queue {
     */
     void spawn_thread_group();
 
+    /**
+       Stops all threads once the queues are empty, and joins them.
+    */
+    void stop_thread_group();
+
     /**
        Destroys the thread pool.
        Also destroys the task queue
@@ -135,7 +189,8 @@ class parallel_task_queue {
 
     /** Initializes a thread pool with nthreads.
      * If affinity is set, the nthreads will by default stripe across
-     * the available cores on the system.
+     * the available cores on the system, NUMA node by NUMA node (see
+     * \ref numa_topology::cpu_for_worker).
      */
     thread_pool(size_t nthreads = 2, bool affinity = false);
 
@@ -149,6 +204,10 @@ class parallel_task_queue {
      */
     size_t size() const;
 
+    /**
+     * Get the number of tasks launched and not yet started
+     */
+    size_t num_queued_tasks() const { return num_queued; }
 
     /**
      * Queues a single task into the thread pool which calls spawn_function.
@@ -161,6 +220,20 @@ class parallel_task_queue {
 
     void join();
 
+    /**
+     * Runs one queued task of the pool on the calling thread, if there is
+     * one. Returns false if there was no task to run.
+     *
+     * Threads of the pool call this while they wait for tasks to complete,
+     * so that waiting does not take a thread away from the pool.
+     */
+    bool try_run_task();
+
+    /**
+     * Returns true if the calling thread is one of the threads of this pool.
+     */
+    bool in_pool_thread() const;
+
     /**
      * Changes the CPU affinity. Note that pthread does not provide
      * a way to change CPU affinity on a currently started thread.
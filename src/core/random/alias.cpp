@@ -42,17 +42,17 @@ alias_sampler::alias_sampler(const std::vector<double>& p) {
       L.pop_back();
     }
   }
-  /** For testing purposes
-    for (size_t i = 0; i < K; ++i) {
-      double qi = q[i];
-      for (size_t m = 0; m < K; ++m) {
-        if (J[m] == i) {
-          qi += 1 - q[m];
-        }
-      }
-      assert(std::abs(qi - p[i] * K) < 0.000001);
-    }
-    */
+  // What is left has probability 1 up to rounding error, and no alias.
+  for (size_t i : S) { q[i] = 1; J[i] = i; }
+  for (size_t i : L) { q[i] = 1; J[i] = i; }
+}
+
+double alias_sampler::probability(size_t k) const {
+  double ret = q[k];
+  for (size_t m = 0; m < K; ++m) {
+    if (J[m] == k && q[m] < 1) ret += 1 - q[m];
+  }
+  return ret / K;
 }
 
 size_t alias_sampler::sample() {
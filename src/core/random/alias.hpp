@@ -50,10 +50,19 @@ class alias_sampler {
    */
   size_t sample();
 
+  /// The number of outcomes K.
+  size_t size() const { return K; }
+
+  /**
+   * The probability with which sample() returns outcome k, as encoded in
+   * the table. This is O(K); it is meant for testing.
+   */
+  double probability(size_t k) const;
+
  private:
   std::vector<size_t> J;
   std::vector<double> q;
-  size_t K;
+  size_t K = 0;
 };
 
 } // end of random
@@ -0,0 +1,160 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_RANDOM_COUNTER_RNG_HPP
+#define TURI_RANDOM_COUNTER_RNG_HPP
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace turi {
+namespace random {
+
+/**
+ * \ingroup random
+ * The Philox4x32-10 block function (Salmon et al., "Parallel Random
+ * Numbers: As Easy as 1, 2, 3"): maps a 128 bit counter and a 64 bit key to
+ * 128 random bits.
+ */
+inline std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> ctr,
+                                          std::array<uint32_t, 2> key) {
+  const uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;
+  const uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+  for (size_t round = 0; round < 10; ++round) {
+    uint64_t p0 = uint64_t(M0) * ctr[0];
+    uint64_t p1 = uint64_t(M1) * ctr[2];
+    ctr = {{uint32_t(p1 >> 32) ^ ctr[1] ^ key[0], uint32_t(p1),
+            uint32_t(p0 >> 32) ^ ctr[3] ^ key[1], uint32_t(p0)}};
+    key[0] += W0;
+    key[1] += W1;
+  }
+  return ctr;
+}
+
+/**
+ * \ingroup random
+ * A counter based random number generator: the i-th value of a stream is a
+ * pure function of (seed, stream, i). There is no state to advance, so a
+ * parallel loop which draws the values of its rows by row index gets
+ * bit-identical results whatever the number of threads and however the rows
+ * are split between them, and a value can be drawn in any order.
+ *
+ * \code
+ * counter_rng rng(seed);
+ * parallel_for(0, n, [&](size_t i) { x[i] = rng.uniform(i); });
+ * // the same values, in batch
+ * rng.fill_uniform(0, x.data(), n);
+ * \endcode
+ *
+ * Each Philox block gives two 64 bit words, so that indices 2k and 2k + 1
+ * share a block; the fill_* functions compute each block once.
+ *
+ * Different streams of the same seed are independent.
+ */
+class counter_rng {
+ public:
+  explicit counter_rng(uint64_t seed, uint64_t stream = 0)
+    : m_key{{uint32_t(seed), uint32_t(seed >> 32)}}, m_stream(stream) { }
+
+  /// The 64 random bits of index i.
+  uint64_t operator()(uint64_t i) const {
+    auto b = block(i >> 1);
+    return (i & 1) ? (uint64_t(b[3]) << 32 | b[2]) : (uint64_t(b[1]) << 32 | b[0]);
+  }
+
+  /// A uniform double in [0, 1) for index i.
+  double uniform(uint64_t i) const {
+    return to_unit((*this)(i));
+  }
+
+  /// A uniform double in [lo, hi) for index i.
+  double uniform(uint64_t i, double lo, double hi) const {
+    return lo + (hi - lo) * uniform(i);
+  }
+
+  /// A uniform integer in [lo, hi], inclusive, for index i.
+  uint64_t uniform_int(uint64_t i, uint64_t lo, uint64_t hi) const {
+    uint64_t range = hi - lo + 1;
+    // the whole 64 bit range
+    if (range == 0) return (*this)(i);
+    return lo + (*this)(i) % range;
+  }
+
+  /// A standard normal for index i.
+  double normal(uint64_t i) const {
+    auto b = block(i >> 1);
+    double z[2];
+    box_muller(uint64_t(b[1]) << 32 | b[0], uint64_t(b[3]) << 32 | b[2], z);
+    return z[i & 1];
+  }
+
+  /**
+   * Writes the uniform values in [lo, hi) of indices first, ..., first + n - 1
+   * to out: out[k] == uniform(first + k, lo, hi).
+   */
+  void fill_uniform(uint64_t first, double* out, size_t n,
+                    double lo = 0, double hi = 1) const {
+    fill(first, out, n, [&](uint64_t a, uint64_t b, double* z) {
+      z[0] = lo + (hi - lo) * to_unit(a);
+      z[1] = lo + (hi - lo) * to_unit(b);
+    });
+  }
+
+  /**
+   * Writes the normal values of indices first, ..., first + n - 1 to out:
+   * out[k] == mean + sd * normal(first + k).
+   */
+  void fill_normal(uint64_t first, double* out, size_t n,
+                   double mean = 0, double sd = 1) const {
+    fill(first, out, n, [&](uint64_t a, uint64_t b, double* z) {
+      box_muller(a, b, z);
+      z[0] = mean + sd * z[0];
+      z[1] = mean + sd * z[1];
+    });
+  }
+
+ private:
+  std::array<uint32_t, 2> m_key;
+  uint64_t m_stream;
+
+  std::array<uint32_t, 4> block(uint64_t k) const {
+    return philox4x32({{uint32_t(k), uint32_t(k >> 32),
+                        uint32_t(m_stream), uint32_t(m_stream >> 32)}}, m_key);
+  }
+
+  /// The top 53 bits as a double in [0, 1)
+  static double to_unit(uint64_t x) {
+    return double(x >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  static void box_muller(uint64_t a, uint64_t b, double* z) {
+    // 1 - u is in (0, 1], so the log is finite
+    double r = std::sqrt(-2 * std::log(1 - to_unit(a)));
+    double theta = 2 * M_PI * to_unit(b);
+    z[0] = r * std::cos(theta);
+    z[1] = r * std::sin(theta);
+  }
+
+  /// Calls pair(word 0, word 1, z) per block, writing both values z[0..1].
+  template <typename PairFn>
+  void fill(uint64_t first, double* out, size_t n, PairFn pair) const {
+    uint64_t i = first;
+    uint64_t end = first + n;
+    double z[2];
+    while (i < end) {
+      auto b = block(i >> 1);
+      pair(uint64_t(b[1]) << 32 | b[0], uint64_t(b[3]) << 32 | b[2], z);
+      for (size_t half = (i & 1); half < 2 && i < end; ++half, ++i) {
+        *(out++) = z[half];
+      }
+    }
+  }
+};
+
+} // namespace random
+} // namespace turi
+#endif
@@ -0,0 +1,158 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <mutex>
+#include <core/export.hpp>
+#include <core/logging/logger.hpp>
+#include <core/parallel/thread_pool.hpp>
+#include <core/storage/fileio/async_reader.hpp>
+#include <core/storage/fileio/fileio_constants.hpp>
+#include <core/storage/fileio/general_fstream.hpp>
+#include <core/storage/fileio/sanitize_url.hpp>
+
+namespace turi {
+namespace fileio {
+
+bool async_read_request::ready() const {
+  std::lock_guard<turi::mutex> guard(m_lock);
+  return m_done;
+}
+
+void async_read_request::wait() const {
+  std::unique_lock<turi::mutex> guard(m_lock);
+  while (!m_done) m_cond.wait(guard);
+}
+
+std::shared_ptr<std::vector<char> > async_read_request::get() {
+  wait();
+  if (m_error) std::rethrow_exception(m_error);
+  return m_data;
+}
+
+
+EXPORT async_reader& async_reader::get_instance() {
+  static async_reader instance;
+  return instance;
+}
+
+async_reader::~async_reader() {
+  // finish the requests in flight while the idle streams still exist
+  m_pool.reset();
+}
+
+EXPORT std::shared_ptr<async_read_request> async_reader::read(
+    const std::string& url,
+    size_t offset,
+    size_t length,
+    callback_type on_done,
+    std::shared_ptr<std::vector<char> > buffer) {
+  auto request = std::make_shared<async_read_request>();
+  request->m_url = url;
+  request->m_offset = offset;
+  request->m_length = length;
+  request->m_data = buffer ? buffer : std::make_shared<std::vector<char> >();
+  {
+    std::lock_guard<turi::mutex> guard(m_lock);
+    if (!m_pool) m_pool.reset(new thread_pool(FILEIO_ASYNC_IO_THREADS));
+  }
+  ++m_num_in_flight;
+  m_pool->launch([this, request, on_done]() {
+    std::exception_ptr error;
+    try {
+      run_request(*request);
+    } catch (...) {
+      error = std::current_exception();
+      request->m_data.reset();
+    }
+    if (on_done) {
+      try {
+        on_done(request->m_data, error);
+      } catch (...) {
+        if (!error) error = std::current_exception();
+      }
+    }
+    --m_num_in_flight;
+    std::lock_guard<turi::mutex> guard(request->m_lock);
+    request->m_error = error;
+    request->m_done = true;
+    request->m_cond.broadcast();
+  });
+  return request;
+}
+
+size_t async_reader::num_in_flight() const {
+  return m_num_in_flight;
+}
+
+void async_reader::close_idle_handles(const std::string& url) {
+  // streams are closed outside of the lock
+  std::vector<std::shared_ptr<general_ifstream> > to_close;
+  {
+    std::lock_guard<turi::mutex> guard(m_lock);
+    ++m_generation;
+    auto iter = m_idle_handles.begin();
+    while (iter != m_idle_handles.end()) {
+      if (iter->first == url) {
+        to_close.push_back(std::move(iter->second));
+        iter = m_idle_handles.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+  }
+}
+
+void async_reader::run_request(async_read_request& request) {
+  size_t generation = 0;
+  std::shared_ptr<general_ifstream> fin = acquire_handle(request.m_url, generation);
+  std::vector<char>& data = *request.m_data;
+  data.resize(request.m_length);
+  fin->clear();
+  fin->seekg(request.m_offset, std::ios_base::beg);
+  size_t bytes_read = 0;
+  if (fin->good() && request.m_length > 0) {
+    fin->read(data.data(), request.m_length);
+    bytes_read = fin->gcount();
+  }
+  if (fin->bad()) {
+    log_and_throw_io_failure("Read of " + sanitize_url(request.m_url) + " failed");
+  }
+  // a short read is the end of the file
+  data.resize(bytes_read);
+  release_handle(request.m_url, generation, std::move(fin));
+}
+
+std::shared_ptr<general_ifstream>
+async_reader::acquire_handle(const std::string& url, size_t& generation) {
+  {
+    std::lock_guard<turi::mutex> guard(m_lock);
+    generation = m_generation;
+    for (auto iter = m_idle_handles.rbegin(); iter != m_idle_handles.rend(); ++iter) {
+      if (iter->first == url) {
+        auto ret = std::move(iter->second);
+        m_idle_handles.erase(std::next(iter).base());
+        return ret;
+      }
+    }
+  }
+  // ranges are read as stored: never gzip decoded
+  return std::make_shared<general_ifstream>(url, false);
+}
+
+void async_reader::release_handle(const std::string& url,
+                                  size_t generation,
+                                  std::shared_ptr<general_ifstream> handle) {
+  std::shared_ptr<general_ifstream> to_close;
+  std::lock_guard<turi::mutex> guard(m_lock);
+  if (generation != m_generation) return;
+  m_idle_handles.emplace_back(url, std::move(handle));
+  if (m_idle_handles.size() > FILEIO_ASYNC_IO_THREADS) {
+    to_close = std::move(m_idle_handles.front().second);
+    m_idle_handles.pop_front();
+  }
+}
+
+} // namespace fileio
+} // namespace turi
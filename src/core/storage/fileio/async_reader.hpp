@@ -0,0 +1,203 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_FILEIO_ASYNC_READER_HPP
+#define TURI_FILEIO_ASYNC_READER_HPP
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <core/parallel/pthread_tools.hpp>
+#include <core/util/coro.hpp>
+
+namespace turi {
+class thread_pool;
+class general_ifstream;
+
+namespace fileio {
+
+/**
+ * \ingroup fileio
+ *
+ * A range read issued on the \ref async_reader. The read completes in the
+ * background; the issuing thread polls \ref ready(), or blocks in
+ * \ref wait() or \ref get() once it runs out of other work.
+ */
+class async_read_request {
+ public:
+  /// The file read.
+  inline const std::string& url() const { return m_url; }
+
+  /// The offset of the range read.
+  inline size_t offset() const { return m_offset; }
+
+  /// The number of bytes requested.
+  inline size_t length() const { return m_length; }
+
+  /// True once the read has completed, successfully or not. Never blocks.
+  bool ready() const;
+
+  /// Waits for the read to complete.
+  void wait() const;
+
+  /**
+   * Waits for the read to complete, and returns the bytes read. Fewer than
+   * length() bytes are returned if the range goes past the end of the file.
+   * Rethrows the exception of a failed read.
+   */
+  std::shared_ptr<std::vector<char> > get();
+
+ private:
+  friend class async_reader;
+
+  std::string m_url;
+  size_t m_offset = 0;
+  size_t m_length = 0;
+
+  mutable turi::mutex m_lock;
+  mutable turi::conditional m_cond;
+  bool m_done = false;
+  std::shared_ptr<std::vector<char> > m_data;
+  std::exception_ptr m_error;
+};
+
+
+/**
+ * \ingroup fileio
+ *
+ * Non-blocking range reads of any file general_ifstream can open: local,
+ * HDFS, S3, and cache:// files.
+ *
+ * general_ifstream reads block the calling thread until the bytes arrive,
+ * which for remote files means a worker thread sits idle for a network
+ * round trip. Instead, \ref read() queues the range on a small pool of
+ * FILEIO_ASYNC_IO_THREADS I/O threads and returns immediately, so one
+ * thread can keep many reads in flight, overlapping their latency.
+ *
+ * Every request is read through its own general_ifstream, so requests of
+ * the same file proceed concurrently (for S3, as independent ranged GETs).
+ * Recently used streams are kept open and reused by later requests of the
+ * same file.
+ *
+ * Completion is signalled in two ways, which can be combined:
+ *  - The returned \ref async_read_request can be polled, or waited on.
+ *    Coroutines (see coro.hpp) suspend on it with \ref CORO_AWAIT_READ.
+ *  - A callback is called on the I/O thread with the bytes read (or the
+ *    exception of a failed read) before the request becomes ready. It should
+ *    be short: the I/O threads are shared with all other requests.
+ *
+ * \code
+ * auto& reader = fileio::async_reader::get_instance();
+ * std::vector<std::shared_ptr<fileio::async_read_request> > reads;
+ * for (size_t i = 0; i < 16; ++i) {
+ *   reads.push_back(reader.read("s3://bucket/file", i * range, range));
+ * }
+ * for (auto& r: reads) process(*r->get());
+ * \endcode
+ *
+ * All functions are thread safe.
+ */
+class async_reader {
+ public:
+  /**
+   * Called on completion with the bytes read, or an exception if the read
+   * failed (in which case data is empty). The callback may move the data
+   * out, in which case \ref async_read_request::get() returns whatever is
+   * left in its place.
+   */
+  typedef std::function<void(std::shared_ptr<std::vector<char> >& data,
+                             std::exception_ptr error)> callback_type;
+
+  static async_reader& get_instance();
+
+  ~async_reader();
+
+  /**
+   * Issues a read of length bytes at offset of a file.
+   *
+   * \param url The file to read.
+   * \param offset The offset of the first byte to read.
+   * \param length The number of bytes to read.
+   * \param on_done Optional callback called on completion.
+   * \param buffer Optional buffer to read into, for instance from a buffer
+   *               pool. It is resized to the bytes read.
+   */
+  std::shared_ptr<async_read_request> read(
+      const std::string& url,
+      size_t offset,
+      size_t length,
+      callback_type on_done = callback_type(),
+      std::shared_ptr<std::vector<char> > buffer = nullptr);
+
+  /// The number of requests issued which have not completed.
+  size_t num_in_flight() const;
+
+  /**
+   * Closes the streams kept open for a file, for instance before it is
+   * deleted or rewritten. Streams used by requests in flight are closed
+   * when those requests complete.
+   */
+  void close_idle_handles(const std::string& url);
+
+ private:
+  async_reader() = default;
+  async_reader(const async_reader&) = delete;
+  async_reader& operator=(const async_reader&) = delete;
+
+  /// Reads the range of a request into its buffer, on an I/O thread.
+  void run_request(async_read_request& request);
+
+  /**
+   * Takes an open stream of the file from the idle streams, or opens one.
+   * generation is set to the value of m_generation at the time.
+   */
+  std::shared_ptr<general_ifstream> acquire_handle(const std::string& url,
+                                                   size_t& generation);
+
+  /**
+   * Returns a stream to the idle streams, closing the oldest if over the
+   * limit. Streams acquired before the last close_idle_handles() are closed.
+   */
+  void release_handle(const std::string& url,
+                      size_t generation,
+                      std::shared_ptr<general_ifstream> handle);
+
+  mutable turi::mutex m_lock;
+  std::unique_ptr<thread_pool> m_pool;
+  std::atomic<size_t> m_num_in_flight{0};
+
+  /// Open streams not used by any request. Most recently used at the back.
+  std::list<std::pair<std::string, std::shared_ptr<general_ifstream> > > m_idle_handles;
+  /// Incremented by every close_idle_handles()
+  size_t m_generation = 0;
+};
+
+} // namespace fileio
+} // namespace turi
+
+/**
+ * \ingroup fileio
+ * Suspends a coroutine (see coro.hpp) until an \ref async_read_request is
+ * ready, yielding the remaining arguments (if any) on every call until then.
+ * request must be an expression which stays valid across calls, such as a
+ * member of the coroutine's class.
+ *
+ * \code
+ * void execute(query_context& context) {
+ *   CORO_BEGIN(execute)
+ *   m_read = fileio::async_reader::get_instance().read(m_url, m_offset, m_length);
+ *   CORO_AWAIT_READ(m_read);
+ *   consume(*m_read->get());
+ *   CORO_END
+ * }
+ * \endcode
+ */
+#define CORO_AWAIT_READ(request, ...) \
+  while (!(request)->ready()) { CORO_YIELD(__VA_ARGS__); }
+
+#endif
@@ -4,9 +4,12 @@
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
 #include <core/storage/fileio/block_cache.hpp>
+#include <core/storage/fileio/fileio_constants.hpp>
+#include <core/storage/fileio/fixed_size_cache_manager.hpp>
 #include <core/storage/fileio/fs_utils.hpp>
 #include <core/storage/fileio/general_fstream.hpp>
 #include <core/storage/fileio/temp_files.hpp>
+#include <core/globals/metrics.hpp>
 #include <core/logging/logger.hpp>
 #include <core/logging/assertions.hpp>
 #include <core/util/md5.hpp>
@@ -17,6 +20,24 @@
 namespace turi {
 constexpr size_t block_cache::KEY_LOCK_SIZE;
 
+namespace {
+metrics::counter& block_cache_hits() {
+  static metrics::counter& c = metrics::get_counter(
+      "block_cache_hits", "Block cache reads served from the cache.");
+  return c;
+}
+metrics::counter& block_cache_misses() {
+  static metrics::counter& c = metrics::get_counter(
+      "block_cache_misses", "Block cache reads of keys not in the cache.");
+  return c;
+}
+metrics::counter& block_cache_evictions() {
+  static metrics::counter& c = metrics::get_counter(
+      "block_cache_evictions", "Entries evicted from the block cache.");
+  return c;
+}
+}  // namespace
+
 
 void block_cache::init(const std::string& storage_prefix,
                        size_t max_file_handle_cache) {
@@ -26,7 +47,8 @@ void block_cache::init(const std::string& storage_prefix,
   m_initialized = true;
 }
 
-bool block_cache::write(const std::string& key, const std::string& value) {
+bool block_cache::write(const std::string& key, const std::string& value,
+                        size_t refetch_cost) {
   ASSERT_TRUE(m_initialized);
   auto strhash = md5(key);
   auto locknum = hash64(key) % KEY_LOCK_SIZE;
@@ -48,21 +70,22 @@ bool block_cache::write(const std::string& key, const std::string& value) {
     if (!fout.good()) return false;
     fout.close();
 
-    std::string to_evict;
+    std::vector<std::pair<std::string, std::string> > to_evict;
     {
       std::unique_lock<mutex> global_lock(m_lock);
       m_created_files.insert(filename);
-      m_lru_files.insert(filename, true);
-      if (m_max_capacity > 0 && m_created_files.size() > m_max_capacity) {
-        auto iter = m_lru_files.rbegin();
-        if (iter != m_lru_files.rend()) {
-          to_evict = iter->first;
-        }
+      insert_entry(filename, key, refetch_cost);
+      while (m_max_capacity > 0 &&
+             m_created_files.size() > m_max_capacity + to_evict.size()) {
+        std::string evict_key, evict_filename;
+        if (!pick_eviction(evict_key, evict_filename)) break;
+        to_evict.push_back({evict_key, evict_filename});
       }
     }
-    if (to_evict.length() > 0) {
-      logstream(LOG_INFO) << "Evicting " << to_evict << std::endl;
-      evict_key(to_evict);
+    lock.unlock();
+    for (const auto& victim: to_evict) {
+      logstream(LOG_INFO) << "Evicting " << victim.second << std::endl;
+      remove_key(victim.first, false);
     }
     return true;
   } catch (...) {
@@ -95,7 +118,13 @@ int64_t block_cache::read(const std::string& key,
   // we need to get the end size if we do not know it so that
   // we have resize the output string.
   if (end == (size_t)(-1)) end = value_length(key);
-  if (end == (size_t)(-1)) return -1;
+  if (end == (size_t)(-1)) {
+    std::unique_lock<mutex> global_lock(m_lock);
+    ++m_misses;
+    ++fileio::FILEIO_BLOCK_CACHE_MISSES;
+    ++block_cache_misses();
+    return -1;
+  }
   size_t length = end > start ? end - start : 0 ;
   output.resize(length);
   return read(key, &(output[0]), start, end);
@@ -126,7 +155,12 @@ int64_t block_cache::read(const std::string& key,
   bool from_cache = false;
   {
     std::unique_lock<mutex> global_lock(m_lock);
-    m_lru_files.query(filename);
+    auto iter = m_entries.find(filename);
+    if (iter != m_entries.end() && iter->second.is_protected) {
+      // entries on probation stay where they are
+      m_protected.splice(m_protected.begin(), m_protected, iter->second.position);
+      iter->second.credits = iter->second.initial_credits;
+    }
     auto cache_entry = m_cache.query(filename);
     if (cache_entry.first) {
       read_stream = cache_entry.second;
@@ -143,7 +177,19 @@ int64_t block_cache::read(const std::string& key,
       return -1;
     }
   }
-  if (read_stream == nullptr || read_stream->good() == false) return -1;
+  if (read_stream == nullptr || read_stream->good() == false) {
+    std::unique_lock<mutex> global_lock(m_lock);
+    ++m_misses;
+    ++fileio::FILEIO_BLOCK_CACHE_MISSES;
+    ++block_cache_misses();
+    return -1;
+  }
+  {
+    std::unique_lock<mutex> global_lock(m_lock);
+    ++m_hits;
+    ++fileio::FILEIO_BLOCK_CACHE_HITS;
+    ++block_cache_hits();
+  }
 
   // fix up the start and end positions
   if (end == (size_t)(-1)) end = read_stream->file_size();
@@ -178,6 +224,10 @@ int64_t block_cache::read(const std::string& key,
 }
 
 bool block_cache::evict_key(const std::string& key) {
+  return remove_key(key, true);
+}
+
+bool block_cache::remove_key(const std::string& key, bool forget) {
   auto strhash = md5(key);
   auto locknum = hash64(key) % KEY_LOCK_SIZE;
   auto filename = m_storage_prefix + strhash;
@@ -187,10 +237,92 @@ bool block_cache::evict_key(const std::string& key) {
   std::unique_lock<mutex> global_lock(m_lock);
   m_cache.erase(filename);             // file handle
   m_created_files.erase(filename);     // created file list
-  m_lru_files.erase(filename);
+  erase_entry(filename);
+  auto ghost = m_ghost_entries.find(filename);
+  if (forget && ghost != m_ghost_entries.end()) {
+    m_ghosts.erase(ghost->second);
+    m_ghost_entries.erase(ghost);
+  }
   return fileio::delete_path(filename); // actual file
 }
 
+void block_cache::insert_entry(const std::string& filename,
+                               const std::string& key,
+                               size_t refetch_cost) {
+  erase_entry(filename);
+  priority p = find_priority_hint(key);
+  // a key fetched again shortly after it was evicted is not a one-off
+  bool was_evicted = false;
+  auto ghost = m_ghost_entries.find(filename);
+  if (ghost != m_ghost_entries.end()) {
+    m_ghosts.erase(ghost->second);
+    m_ghost_entries.erase(ghost);
+    was_evicted = true;
+  }
+
+  entry& e = m_entries[filename];
+  e.key = key;
+  e.is_protected = p != priority::LOW && (was_evicted || p == priority::HIGH);
+  e.initial_credits = refetch_cost > 0 ? refetch_cost - 1 : 0;
+  if (p == priority::HIGH) e.initial_credits = 2 * e.initial_credits + 1;
+  e.credits = e.initial_credits;
+  auto& queue = e.is_protected ? m_protected : m_probation;
+  queue.push_front(filename);
+  e.position = queue.begin();
+
+  // in memory values which are likely to be read again should also be the
+  // last to be spilled to disk
+  if (fileio::get_protocol(filename) == "cache") {
+    fileio::fixed_size_cache_manager::get_instance().set_eviction_priority(
+        filename, e.is_protected ? e.initial_credits + 1 : 0);
+  }
+}
+
+bool block_cache::pick_eviction(std::string& key, std::string& filename) {
+  size_t probation_limit = std::max<size_t>(m_max_capacity / 4, 1);
+  if (!m_probation.empty() &&
+      (m_probation.size() > probation_limit || m_protected.empty())) {
+    filename = m_probation.back();
+    key = m_entries[filename].key;
+    bool remember = find_priority_hint(key) != priority::LOW;
+    erase_entry(filename);
+    if (remember) {
+      m_ghosts.push_front(filename);
+      m_ghost_entries[filename] = m_ghosts.begin();
+      size_t ghost_limit = std::max<size_t>(m_max_capacity / 2, 1);
+      while (m_ghosts.size() > ghost_limit) {
+        m_ghost_entries.erase(m_ghosts.back());
+        m_ghosts.pop_back();
+      }
+    }
+  } else if (!m_protected.empty()) {
+    // expensive entries get another round through the queue.
+    // Terminates since every round uses up a credit.
+    while (m_entries[m_protected.back()].credits > 0) {
+      auto& e = m_entries[m_protected.back()];
+      --e.credits;
+      m_protected.splice(m_protected.begin(), m_protected, e.position);
+    }
+    filename = m_protected.back();
+    key = m_entries[filename].key;
+    erase_entry(filename);
+  } else {
+    return false;
+  }
+  ++m_evictions;
+  ++fileio::FILEIO_BLOCK_CACHE_EVICTIONS;
+  ++block_cache_evictions();
+  return true;
+}
+
+void block_cache::erase_entry(const std::string& filename) {
+  auto iter = m_entries.find(filename);
+  if (iter == m_entries.end()) return;
+  auto& queue = iter->second.is_protected ? m_protected : m_probation;
+  queue.erase(iter->second.position);
+  m_entries.erase(iter);
+}
+
 size_t block_cache::file_handle_cache_hits() const {
   return m_cache.hits();
 }
@@ -199,6 +331,42 @@ size_t block_cache::file_handle_cache_misses() const {
   return m_cache.misses();
 }
 
+size_t block_cache::hits() const {
+  return m_hits;
+}
+
+size_t block_cache::misses() const {
+  return m_misses;
+}
+
+size_t block_cache::evictions() const {
+  return m_evictions;
+}
+
+void block_cache::set_priority_hint(const std::string& key_prefix, priority p) {
+  std::unique_lock<mutex> global_lock(m_lock);
+  if (p == priority::NORMAL) m_priority_hints.erase(key_prefix);
+  else m_priority_hints[key_prefix] = p;
+}
+
+block_cache::priority block_cache::get_priority_hint(const std::string& key) {
+  std::unique_lock<mutex> global_lock(m_lock);
+  return find_priority_hint(key);
+}
+
+block_cache::priority block_cache::find_priority_hint(const std::string& key) {
+  priority ret = priority::NORMAL;
+  size_t longest_match = 0;
+  for (const auto& hint: m_priority_hints) {
+    if (hint.first.length() >= longest_match &&
+        key.compare(0, hint.first.length(), hint.first) == 0) {
+      ret = hint.second;
+      longest_match = hint.first.length();
+    }
+  }
+  return ret;
+}
+
 size_t block_cache::get_max_capacity() {
   return m_max_capacity;
 }
@@ -6,6 +6,10 @@
 #ifndef TURI_FILEIO_BLOCK_CACHE_HPP
 #define TURI_FILEIO_BLOCK_CACHE_HPP
 #include <cstdint>
+#include <list>
+#include <map>
+#include <set>
+#include <unordered_map>
 #include <core/util/lru.hpp>
 #include <core/parallel/mutex.hpp>
 
@@ -48,9 +52,41 @@ class general_ifstream;
  * is needed to ensure atomicity, at least within the context of the same
  * block_cache object. Essentially we want write-once, but arbitrary parallel
  * reads semantics.
+ *
+ * Eviction
+ * --------
+ * When a maximum capacity is set, keys are evicted with a 2Q policy so that a
+ * single large scan cannot flush keys which are used over and over:
+ *  - A newly written key enters the probation queue (FIFO). Reads of a key
+ *    on probation do not change its position, since those typically come
+ *    from the same scan which fetched it.
+ *  - Keys evicted from probation are remembered (without their values) for
+ *    a while. If such a key is written again, it has been fetched twice and
+ *    enters the protected queue (LRU) directly.
+ *  - Keys are evicted from probation while it holds more than a quarter of
+ *    the capacity, and from the least recently used end of the protected
+ *    queue otherwise.
+ *
+ * Every key carries a re-fetch cost (see \ref write()); a protected key
+ * survives reaching the end of the protected queue (refetch_cost - 1) times
+ * before it is evicted, so expensive remote blocks outlive cheap ones.
+ * Priority hints (\ref set_priority_hint()) by key prefix further adjust
+ * this: HIGH priority keys start out protected and count double, LOW
+ * priority keys are never protected.
+ *
+ * Hits, misses and evictions are counted per block cache, and in total in
+ * the FILEIO_BLOCK_CACHE_HITS, FILEIO_BLOCK_CACHE_MISSES and
+ * FILEIO_BLOCK_CACHE_EVICTIONS globals.
  */
 class block_cache {
  public:
+  /// Priority hints for keys. See \ref set_priority_hint().
+  enum class priority: int {
+    LOW = 0,
+    NORMAL = 1,
+    HIGH = 2
+  };
+
   /**
    * Constructs the block cache. init must be called before the block_cache
    * can be used.
@@ -87,13 +123,19 @@ class block_cache {
    *
    * \param key The key to write to
    * \param value The value to write
+   * \param refetch_cost The relative cost of producing the value again
+   *        should it be evicted. 1 for values which are cheap to re-read
+   *        from local storage. See FILEIO_BLOCK_CACHE_REMOTE_REFETCH_COST.
    *
    * \returns true on success, false on failure
    */
-  bool write(const std::string& key, const std::string& value);
+  bool write(const std::string& key, const std::string& value,
+             size_t refetch_cost = 1);
 
   /**
-   * Evicts a particular key. Returns true on success, false on failure
+   * Evicts a particular key. Returns true on success, false on failure.
+   * The cache also forgets that the key was cached, so writing it again
+   * does not count as fetching it again.
    *
    * \param key The key name
    */
@@ -155,6 +197,25 @@ class block_cache {
    */
   size_t file_handle_cache_misses() const;
 
+  /// The number of reads of keys which exist.
+  size_t hits() const;
+
+  /// The number of reads of keys which do not exist.
+  size_t misses() const;
+
+  /// The number of keys evicted to stay within the maximum capacity.
+  size_t evictions() const;
+
+  /**
+   * Sets the priority of all keys beginning with key_prefix, which are
+   * written after this call. When several hints match a key, the one with
+   * the longest prefix is used. Setting NORMAL removes the hint.
+   */
+  void set_priority_hint(const std::string& key_prefix, priority p);
+
+  /// Returns the priority hint which applies to a key.
+  priority get_priority_hint(const std::string& key);
+
   /** Sets the maximum number of files managed.
    * If 0, there is no max capacity.
    */
@@ -207,8 +268,56 @@ class block_cache {
   /// A cache of files to file handles
   lru_cache<std::string, std::shared_ptr<general_ifstream> > m_cache;
 
-  /// An LRU cache of the set of files we maintain. The value_type (bool) is unused.
-  lru_cache<std::string, bool> m_lru_files;
+  /// Eviction state of a file we maintain.
+  struct entry {
+    std::string key;
+    bool is_protected = false;
+    /// Times the entry may still reach the end of the protected queue
+    size_t credits = 0;
+    /// credits is reset to this on every hit
+    size_t initial_credits = 0;
+    std::list<std::string>::iterator position;
+  };
+
+  /// Files we maintain, by filename
+  std::unordered_map<std::string, entry> m_entries;
+  /// Files on probation. Most recently written first
+  std::list<std::string> m_probation;
+  /// Protected files. Most recently used first
+  std::list<std::string> m_protected;
+  /// Filenames recently evicted from probation. Most recent first
+  std::list<std::string> m_ghosts;
+  std::unordered_map<std::string, std::list<std::string>::iterator> m_ghost_entries;
+
+  /// Priority hints by key prefix
+  std::map<std::string, priority> m_priority_hints;
+
+  size_t m_hits = 0;
+  size_t m_misses = 0;
+  size_t m_evictions = 0;
+
+  /// \ref get_priority_hint() with m_lock held.
+  priority find_priority_hint(const std::string& key);
+
+  /// Adds a newly written file to the eviction queues. m_lock must be held.
+  void insert_entry(const std::string& filename, const std::string& key,
+                    size_t refetch_cost);
+
+  /**
+   * Picks and removes the next file to evict from the eviction queues.
+   * Returns false if there is nothing to evict. m_lock must be held.
+   */
+  bool pick_eviction(std::string& key, std::string& filename);
+
+  /// Erases a file from the eviction queues. m_lock must be held.
+  void erase_entry(const std::string& filename);
+
+  /**
+   * Deletes the file of a key. If forget is false, the ghost entry recorded
+   * by \ref pick_eviction() is kept, so that a key evicted to make room
+   * and written again is promoted to the protected queue.
+   */
+  bool remove_key(const std::string& key, bool forget);
 
 }; // class block_cache
 } // turicreate
@@ -5,6 +5,9 @@
 #include <algorithm>
 #include <ctime>
 #include <sstream>
+#include <deque>
+#include <future>
+#include <core/storage/fileio/fileio_constants.hpp>
 #include <core/storage/fileio/set_curl_options.hpp>
 #include <core/storage/fileio/get_s3_endpoint.hpp>
 extern "C" {
@@ -475,11 +478,17 @@ static CURLGlobal curl_global;
 /*! \brief reader stream that can be used to read */
 class ReadStream : public CURLReadStreamBase {
  public:
+  /*!
+   * \param range_end if non-zero, only the bytes before range_end are
+   *  requested, and file_size should be range_end.
+   */
   ReadStream(const URI &path,
              const std::string &aws_id,
              const std::string &aws_key,
-             size_t file_size)
-      : path_(path), aws_id_(aws_id), aws_key_(aws_key) {
+             size_t file_size,
+             size_t range_end = 0)
+      : path_(path), aws_id_(aws_id), aws_key_(aws_key),
+        range_end_(range_end) {
         this->expect_file_size_ = file_size;
   }
   virtual ~ReadStream(void) {}
@@ -495,6 +504,8 @@ class ReadStream : public CURLReadStreamBase {
   URI path_;
   // aws access key and id
   std::string aws_id_, aws_key_;
+  // end of the requested byte range. 0 if reading to the end of the file
+  size_t range_end_;
 };
 
 // initialize the reader at begin bytes
@@ -516,6 +527,7 @@ void ReadStream::InitRequest(size_t begin_bytes,
   surl << get_bucket_path(path_.host)
        << RemoveBeginSlash(path_.name);
   srange << "Range: bytes=" << begin_bytes << "-";
+  if (range_end_ > 0) srange << range_end_ - 1;
   *slist = curl_slist_append(*slist, sdate.str().c_str());
   *slist = curl_slist_append(*slist, srange.str().c_str());
   *slist = curl_slist_append(*slist, sauth.str().c_str());
@@ -555,10 +567,9 @@ class WriteStream : public Stream {
     if (buz != NULL) {
       max_buffer_size_ = static_cast<size_t>(atol(buz)) << 20UL;
     } else {
-      // 64 MB
-      const size_t kDefaultBufferSize = 64 << 20UL;
-      max_buffer_size_ = kDefaultBufferSize;
+      max_buffer_size_ = turi::fileio::FILEIO_S3_PART_SIZE;
     }
+    max_parallel_uploads_ = std::max<size_t>(turi::fileio::FILEIO_S3_UPLOAD_THREADS, 1);
     max_error_retry_ = 3;
     ecurl_ = curl_easy_init();
     this->Init();
@@ -572,8 +583,15 @@ class WriteStream : public Stream {
   virtual ~WriteStream() {
     if (!closed_) {
       no_exception_ = true;
-      this->Upload(true);
-      this->Finish();
+      try {
+        this->Upload(true);
+        this->Finish();
+      } catch (...) {
+        logstream(LOG_ERROR) << "S3 upload failed while closing the stream"
+                             << std::endl;
+        // parts still in flight must finish before the stream goes away
+        pending_parts_.clear();
+      }
       curl_easy_cleanup(ecurl_);
     }
   }
@@ -588,6 +606,8 @@ class WriteStream : public Stream {
  private:
   // internal maximum buffer size
   size_t max_buffer_size_;
+  // maximum number of parts being uploaded at once
+  size_t max_parallel_uploads_;
   // maximum time of retry when error occurs
   int max_error_retry_;
   // path we are reading
@@ -602,8 +622,10 @@ class WriteStream : public Stream {
   std::string buffer_;
   // etags of each part we uploaded
   std::vector<std::string> etags_;
-  // part id of each part we uploaded
+  // part id of each part we uploaded, or are uploading
   std::vector<size_t> part_ids_;
+  // etags of the parts still being uploaded, in part order
+  std::deque<std::future<std::string> > pending_parts_;
 
   bool closed_ = false;
 
@@ -619,20 +641,31 @@ class WriteStream : public Stream {
    * \param out_header holds output Header
    * \param out_data holds output data
    */
-  void Run(const std::string &method,
+  void Run(CURL *&ecurl,
+           const std::string &method,
            const URI &path,
            const std::string &args,
            const std::string &content_type,
            const std::string &data,
            std::string *out_header,
            std::string *out_data);
+  /*!
+   * \brief upload a single part on its own curl handle
+   * \return the etag of the part
+   * Safe to call concurrently for different parts.
+   */
+  std::string UploadPart(size_t partno, const std::string &data);
+  /*!
+   * \brief wait for the oldest part in flight and store its etag
+   */
+  void WaitForPart(void);
   /*!
    * \brief initialize the upload request
    */
   void Init(void);
   /*!
-   * \brief upload the buffer to S3, store the etag
-   * clear the buffer
+   * \brief start uploading the buffer to S3 and clear the buffer.
+   * Blocks while max_parallel_uploads_ parts are already in flight.
    */
   void Upload(bool force_upload_even_if_zero_bytes = false);
   /*!
@@ -650,7 +683,8 @@ void WriteStream::Write(const void *ptr, size_t size) {
   }
 }
 
-void WriteStream::Run(const std::string &method,
+void WriteStream::Run(CURL *&ecurl,
+                      const std::string &method,
                       const URI &path,
                       const std::string &args,
                       const std::string &content_type,
@@ -689,38 +723,37 @@ void WriteStream::Run(const std::string &method,
   while (true) {
     // helper for read string
     ReadStringStream ss(data);
-    curl_easy_reset(ecurl_);
+    curl_easy_reset(ecurl);
     auto surlstring = surl.str();
-    ASSERT_TRUE(curl_easy_setopt(ecurl_, CURLOPT_HTTPHEADER, slist) == CURLE_OK);
-    ASSERT_TRUE(curl_easy_setopt(ecurl_, CURLOPT_URL, surlstring.c_str()) == CURLE_OK);
-    ASSERT_TRUE(curl_easy_setopt(ecurl_, CURLOPT_HEADER, 0L) == CURLE_OK);
-    ASSERT_TRUE(curl_easy_setopt(ecurl_, CURLOPT_WRITEFUNCTION, WriteSStreamCallback) == CURLE_OK);
-    ASSERT_TRUE(curl_easy_setopt(ecurl_, CURLOPT_WRITEDATA, &rdata) == CURLE_OK);
-    ASSERT_TRUE(curl_easy_setopt(ecurl_, CURLOPT_WRITEHEADER, WriteSStreamCallback) == CURLE_OK);
-    ASSERT_TRUE(curl_easy_setopt(ecurl_, CURLOPT_HEADERDATA, &rheader) == CURLE_OK);
-    set_curl_options(ecurl_);
-    curl_easy_setopt(ecurl_, CURLOPT_NOSIGNAL, 1);
+    ASSERT_TRUE(curl_easy_setopt(ecurl, CURLOPT_HTTPHEADER, slist) == CURLE_OK);
+    ASSERT_TRUE(curl_easy_setopt(ecurl, CURLOPT_URL, surlstring.c_str()) == CURLE_OK);
+    ASSERT_TRUE(curl_easy_setopt(ecurl, CURLOPT_HEADER, 0L) == CURLE_OK);
+    ASSERT_TRUE(curl_easy_setopt(ecurl, CURLOPT_WRITEFUNCTION, WriteSStreamCallback) == CURLE_OK);
+    ASSERT_TRUE(curl_easy_setopt(ecurl, CURLOPT_WRITEDATA, &rdata) == CURLE_OK);
+    ASSERT_TRUE(curl_easy_setopt(ecurl, CURLOPT_WRITEHEADER, WriteSStreamCallback) == CURLE_OK);
+    ASSERT_TRUE(curl_easy_setopt(ecurl, CURLOPT_HEADERDATA, &rheader) == CURLE_OK);
+    set_curl_options(ecurl);
+    curl_easy_setopt(ecurl, CURLOPT_NOSIGNAL, 1);
     if (method == "POST") {
-      ASSERT_TRUE(curl_easy_setopt(ecurl_, CURLOPT_POST, 0L) == CURLE_OK);
-      ASSERT_TRUE(curl_easy_setopt(ecurl_, CURLOPT_POSTFIELDSIZE, data.length()) == CURLE_OK);
-      ASSERT_TRUE(curl_easy_setopt(ecurl_, CURLOPT_POSTFIELDS, BeginPtr(data)) == CURLE_OK);
+      ASSERT_TRUE(curl_easy_setopt(ecurl, CURLOPT_POST, 0L) == CURLE_OK);
+      ASSERT_TRUE(curl_easy_setopt(ecurl, CURLOPT_POSTFIELDSIZE, data.length()) == CURLE_OK);
+      ASSERT_TRUE(curl_easy_setopt(ecurl, CURLOPT_POSTFIELDS, BeginPtr(data)) == CURLE_OK);
     } else if (method == "PUT") {
-      ASSERT_TRUE(curl_easy_setopt(ecurl_, CURLOPT_PUT, 1L) == CURLE_OK);
-      ASSERT_TRUE(curl_easy_setopt(ecurl_, CURLOPT_READDATA, &ss) == CURLE_OK);
-      ASSERT_TRUE(curl_easy_setopt(ecurl_, CURLOPT_INFILESIZE_LARGE, data.length()) == CURLE_OK);
-      ASSERT_TRUE(curl_easy_setopt(ecurl_, CURLOPT_READFUNCTION, ReadStringStream::Callback) == CURLE_OK);
+      ASSERT_TRUE(curl_easy_setopt(ecurl, CURLOPT_PUT, 1L) == CURLE_OK);
+      ASSERT_TRUE(curl_easy_setopt(ecurl, CURLOPT_READDATA, &ss) == CURLE_OK);
+      ASSERT_TRUE(curl_easy_setopt(ecurl, CURLOPT_INFILESIZE_LARGE, data.length()) == CURLE_OK);
+      ASSERT_TRUE(curl_easy_setopt(ecurl, CURLOPT_READFUNCTION, ReadStringStream::Callback) == CURLE_OK);
     }
-    CURLcode ret = curl_easy_perform(ecurl_);
+    CURLcode ret = curl_easy_perform(ecurl);
     if (ret != CURLE_OK) {
       logstream(LOG_ERROR) << "request " << "failed with error "
-                << curl_easy_strerror(ret) << " Progress "
-                << etags_.size() << " uploaded " << " retry=" << num_retry << std::endl;
+                << curl_easy_strerror(ret) << " retry=" << num_retry << std::endl;
       num_retry += 1;
       if(num_retry >= max_error_retry_) {
         log_and_throw_io_failure("Maximum retry time reached");
       }
-      curl_easy_cleanup(ecurl_);
-      ecurl_ = curl_easy_init();
+      curl_easy_cleanup(ecurl);
+      ecurl = curl_easy_init();
     } else {
       break;
     }
@@ -737,7 +770,7 @@ void WriteStream::Run(const std::string &method,
 }
 void WriteStream::Init(void) {
   std::string rheader, rdata;
-  Run("POST", path_, "?uploads",
+  Run(ecurl_, "POST", path_, "?uploads",
       "binary/octel-stream", "", &rheader, &rdata);
   XMLIter xml(rdata.c_str());
   XMLIter upid;
@@ -745,30 +778,50 @@ void WriteStream::Init(void) {
   upload_id_ = upid.str();
 }
 
-void WriteStream::Upload(bool force_upload_even_if_zero_bytes) {
-  if (buffer_.length() == 0 && !force_upload_even_if_zero_bytes) return;
+std::string WriteStream::UploadPart(size_t partno, const std::string &data) {
   std::ostringstream sarg;
   std::string rheader, rdata;
-  size_t partno = etags_.size() + 1;
-
   sarg << "?partNumber=" << partno << "&uploadId=" << upload_id_;
-  Run("PUT", path_, sarg.str(),
-      "binary/octel-stream", buffer_, &rheader, &rdata);
+  CURL *ecurl = curl_easy_init();
+  try {
+    Run(ecurl, "PUT", path_, sarg.str(),
+        "binary/octel-stream", data, &rheader, &rdata);
+  } catch (...) {
+    curl_easy_cleanup(ecurl);
+    throw;
+  }
+  curl_easy_cleanup(ecurl);
   const char *p = strcasestr(rheader.c_str(), "ETag: ");
   ASSERT_MSG((p != NULL), "cannot find ETag in header");
   p += 6;
   const char *end = strchr(p + 1, '\n');
   auto etag = std::string(p, end - p + 1);
-  etag = boost::algorithm::trim_copy_if(etag, boost::algorithm::is_any_of(" \"\r\n"));
+  return boost::algorithm::trim_copy_if(etag, boost::algorithm::is_any_of(" \"\r\n"));
+}
 
-  etags_.push_back(etag);
+void WriteStream::WaitForPart(void) {
+  // parts complete in order, so etags_ stays aligned with part_ids_
+  std::future<std::string> part = std::move(pending_parts_.front());
+  pending_parts_.pop_front();
+  etags_.push_back(part.get());
+}
+
+void WriteStream::Upload(bool force_upload_even_if_zero_bytes) {
+  if (buffer_.length() == 0 && !force_upload_even_if_zero_bytes) return;
+  size_t partno = part_ids_.size() + 1;
   part_ids_.push_back(partno);
-  buffer_.clear();
+  auto data = std::make_shared<std::string>();
+  data->swap(buffer_);
+  pending_parts_.push_back(std::async(std::launch::async, [this, partno, data]() {
+    return UploadPart(partno, *data);
+  }));
+  while (pending_parts_.size() >= max_parallel_uploads_) WaitForPart();
 }
 
 void WriteStream::Finish(void) {
   std::ostringstream sarg, sdata;
   std::string rheader, rdata;
+  while (!pending_parts_.empty()) WaitForPart();
   sarg << "?uploadId=" << upload_id_;
   sdata << "<CompleteMultipartUpload>\n";
   ASSERT_TRUE(etags_.size() == part_ids_.size());
@@ -779,7 +832,7 @@ void WriteStream::Finish(void) {
           << " </Part>\n";
   }
   sdata << "</CompleteMultipartUpload>\n";
-  Run("POST", path_, sarg.str(),
+  Run(ecurl_, "POST", path_, sarg.str(),
       "text/xml", sdata.str(), &rheader, &rdata);
 }
 /*!
@@ -937,6 +990,17 @@ Stream *S3FileSystem::Open(const URI &path, const char* const flag) {
   }
 }
 
+SeekStream *S3FileSystem::OpenRangeForRead(const URI &path,
+                                           size_t begin_bytes,
+                                           size_t end_bytes) {
+  ASSERT_MSG((path.protocol == "s3://"), " S3FileSystem.Open");
+  ASSERT_LT(begin_bytes, end_bytes);
+  SeekStream *ret = new s3::ReadStream(path, aws_access_id_, aws_secret_key_,
+                                       end_bytes, end_bytes);
+  ret->Seek(begin_bytes);
+  return ret;
+}
+
 SeekStream *S3FileSystem::OpenForRead(const URI &path) {
   ASSERT_MSG((path.protocol == "s3://"), " S3FileSystem.Open");
   FileInfo info;
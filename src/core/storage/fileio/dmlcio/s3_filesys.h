@@ -60,6 +60,17 @@ class S3FileSystem {
    * \return the created stream, can be NULL
    */
   virtual SeekStream *OpenForRead(const URI &path);
+  /*!
+   * \brief open a seekable stream over the bytes [begin_bytes, end_bytes)
+   *  of a file, positioned at begin_bytes. Only those bytes are requested
+   *  from S3, and the file is not checked for existence.
+   *  Several range streams can be read concurrently.
+   * \param path the path to the file
+   * \return the created stream
+   */
+  virtual SeekStream *OpenRangeForRead(const URI &path,
+                                       size_t begin_bytes,
+                                       size_t end_bytes);
   /*!
    * \brief get a singleton of S3FileSystem when needed
    * \return a singleton instance
@@ -9,6 +9,7 @@
 #include <core/storage/fileio/curl_downloader.hpp>
 #include <core/storage/fileio/temp_files.hpp>
 #include <core/storage/fileio/file_download_cache.hpp>
+#include <core/storage/fileio/local_disk_cache.hpp>
 #include <core/storage/fileio/s3_api.hpp>
 #include <core/storage/fileio/sanitize_url.hpp>
 #include <core/export.hpp>
@@ -52,6 +53,34 @@ std::string file_download_cache::get_file(const std::string& url) {
   }
   lock.unlock();
 
+  // a remote file whose version is known may have been kept on local disk,
+  // by this or another process
+  std::shared_ptr<local_disk_cache> disk_cache;
+  std::string version, disk_key;
+  if (boost::algorithm::contains(url, "://") &&
+      !boost::starts_with(url, "file://")) {
+    disk_cache = local_disk_cache::get_instance();
+  }
+  if (disk_cache) {
+    version = get_remote_file_version(url);
+    if (!version.empty()) disk_key = sanitize_url(url) + "////:" + version;
+  }
+  if (!disk_key.empty()) {
+    std::string localfile = get_temp_name();
+    // keep the file extension, as download_url does
+    size_t lastdot = url.find_last_of(".");
+    if (lastdot != std::string::npos && lastdot > url.find_last_of("/")) {
+      localfile = localfile + url.substr(lastdot);
+    }
+    if (disk_cache->copy_to(disk_key, localfile)) {
+      lock.lock();
+      url_to_file[url].filename = localfile;
+      url_to_file[url].last_modified = version;
+      lock.unlock();
+      return localfile;
+    }
+  }
+
   // ok. we need to download the file
   // Ok, it is either local regular file, file:///, or remote urls http://.
   // For remote urls, download_url download it into to local file.
@@ -64,10 +93,11 @@ std::string file_download_cache::get_file(const std::string& url) {
                              ". " + get_curl_error_string(status));
   }
   if (is_temp) {
+    if (!disk_key.empty()) disk_cache->write_file(disk_key, localfile);
     // if it is a remote file, we check the download status code
     lock.lock();
     url_to_file[url].filename = localfile;
-    url_to_file[url].last_modified = "";
+    url_to_file[url].last_modified = version;
     lock.unlock();
     return localfile;
   } else {
@@ -30,6 +30,10 @@ namespace turi {
  * file is still being used by another thread.
  *
  * For s3 files, cache will be updated based on last modification time.
+ *
+ * When FILEIO_LOCAL_DISK_CACHE_DIRECTORY is set, downloads of remote files
+ * whose version is known (see \ref get_remote_file_version()) are also kept
+ * in the \ref local_disk_cache, where later processes on the host find them.
  */
 class file_download_cache {
  public:
@@ -10,6 +10,7 @@
 #include <core/storage/fileio/file_ownership_handle.hpp>
 #include <core/storage/fileio/file_handle_pool.hpp>
 #include <core/storage/fileio/sanitize_url.hpp>
+#include <core/globals/metrics.hpp>
 #include <core/export.hpp>
 
 namespace turi {
@@ -97,12 +98,23 @@ bool file_handle_pool::unmark_file_for_delete(std::string file_name) {
 
 std::shared_ptr<file_ownership_handle> file_handle_pool::get_file_handle(
     const std::string& file_name) {
+  static metrics::counter& hits = metrics::get_counter(
+      "file_handle_pool_hits", "Lookups of files registered in the pool.");
+  static metrics::counter& misses = metrics::get_counter(
+      "file_handle_pool_misses", "Lookups of files not registered in the pool.");
+
   std::shared_ptr<file_ownership_handle> ret;
   bool file_in_pool = m_file_handles.find(file_name) != m_file_handles.end();
-  if (!file_in_pool) return ret;
+  if (!file_in_pool) {
+    ++misses;
+    return ret;
+  }
 
   if (!(ret = m_file_handles[file_name].lock())) {
     m_file_handles.erase(file_name);
+    ++misses;
+  } else {
+    ++hits;
   }
 
   return ret;
@@ -91,6 +91,15 @@ static bool check_cache_file_location(std::string val) {
   return true;
 }
 
+static bool check_local_disk_cache_directory(std::string val) {
+  if (val.empty()) return true;
+  boost::system::error_code ec;
+  boost::filesystem::create_directories(val, ec);
+  if (!boost::filesystem::is_directory(val))
+    throw std::string("Cannot create directory: ") + val;
+  return true;
+}
+
 #ifndef TC_DISABLE_REMOTEFS
 static bool check_cache_file_hdfs_location(std::string val) {
   if (get_protocol(val) == "hdfs") {
@@ -127,6 +136,26 @@ EXPORT size_t FILEIO_READER_BUFFER_SIZE = 16 * 1024;
 EXPORT size_t FILEIO_WRITER_BUFFER_SIZE = 96 * 1024;
 EXPORT std::string S3_ENDPOINT;
 EXPORT std::string S3_REGION;
+EXPORT size_t FILEIO_S3_PART_SIZE = 64 * 1024 * 1024;
+EXPORT size_t FILEIO_S3_UPLOAD_THREADS = 4;
+EXPORT size_t FILEIO_S3_DOWNLOAD_RANGE_SIZE = 8 * 1024 * 1024;
+EXPORT size_t FILEIO_S3_DOWNLOAD_THREADS = 4;
+EXPORT size_t FILEIO_HDFS_READ_RANGE_SIZE = 8 * 1024 * 1024;
+EXPORT size_t FILEIO_HDFS_READ_THREADS = 4;
+EXPORT std::string FILEIO_HDFS_DOMAIN_SOCKET_PATH = "";
+EXPORT std::string FILEIO_HDFS_CLIENT_LIBRARY = "";
+EXPORT size_t FILEIO_BLOCK_CACHE_REMOTE_REFETCH_COST = 4;
+EXPORT size_t FILEIO_BLOCK_CACHE_HITS = 0;
+EXPORT size_t FILEIO_BLOCK_CACHE_MISSES = 0;
+EXPORT size_t FILEIO_BLOCK_CACHE_EVICTIONS = 0;
+EXPORT size_t FILEIO_CACHE_EVICTIONS = 0;
+EXPORT size_t FILEIO_MEMORY_BUDGET = 0;
+EXPORT size_t FILEIO_MEMORY_BUDGET_WAIT_MS = 100;
+EXPORT size_t FILEIO_MEMORY_BUDGET_OVERCOMMITS = 0;
+EXPORT size_t FILEIO_ASYNC_IO_THREADS = 16;
+EXPORT size_t FILEIO_TEMP_DIRECTORY_MIN_FREE_BYTES = 1024LL * 1024 * 1024;
+EXPORT std::string FILEIO_LOCAL_DISK_CACHE_DIRECTORY = "";
+EXPORT size_t FILEIO_LOCAL_DISK_CACHE_MAX_BYTES = 10LL * 1024 * 1024 * 1024;
 // TODO: Where is the right place for this? Probably not here...
 EXPORT int64_t NUM_GPUS = -1;
 
@@ -137,6 +166,59 @@ REGISTER_GLOBAL(int64_t, FILEIO_WRITER_BUFFER_SIZE, false);
 REGISTER_GLOBAL(std::string, S3_ENDPOINT, true);
 REGISTER_GLOBAL(std::string, S3_REGION, true);
 REGISTER_GLOBAL(int64_t, NUM_GPUS, true);
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            FILEIO_S3_PART_SIZE,
+                            true,
+                            +[](int64_t val){ return val >= 5 * 1024 * 1024; });
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            FILEIO_S3_UPLOAD_THREADS,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            FILEIO_S3_DOWNLOAD_RANGE_SIZE,
+                            true,
+                            +[](int64_t val){ return val >= 64 * 1024; });
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            FILEIO_S3_DOWNLOAD_THREADS,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            FILEIO_HDFS_READ_RANGE_SIZE,
+                            true,
+                            +[](int64_t val){ return val >= 64 * 1024; });
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            FILEIO_HDFS_READ_THREADS,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+REGISTER_GLOBAL(std::string, FILEIO_HDFS_DOMAIN_SOCKET_PATH, true);
+REGISTER_GLOBAL(std::string, FILEIO_HDFS_CLIENT_LIBRARY, true);
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            FILEIO_BLOCK_CACHE_REMOTE_REFETCH_COST,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+REGISTER_GLOBAL(int64_t, FILEIO_BLOCK_CACHE_HITS, false);
+REGISTER_GLOBAL(int64_t, FILEIO_BLOCK_CACHE_MISSES, false);
+REGISTER_GLOBAL(int64_t, FILEIO_BLOCK_CACHE_EVICTIONS, false);
+REGISTER_GLOBAL(int64_t, FILEIO_CACHE_EVICTIONS, false);
+REGISTER_GLOBAL(int64_t, FILEIO_MEMORY_BUDGET, true);
+REGISTER_GLOBAL(int64_t, FILEIO_MEMORY_BUDGET_WAIT_MS, true);
+REGISTER_GLOBAL(int64_t, FILEIO_MEMORY_BUDGET_OVERCOMMITS, false);
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            FILEIO_ASYNC_IO_THREADS,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            FILEIO_TEMP_DIRECTORY_MIN_FREE_BYTES,
+                            true,
+                            +[](int64_t val){ return val >= 0; });
+REGISTER_GLOBAL_WITH_CHECKS(std::string,
+                            FILEIO_LOCAL_DISK_CACHE_DIRECTORY,
+                            true,
+                            check_local_disk_cache_directory);
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            FILEIO_LOCAL_DISK_CACHE_MAX_BYTES,
+                            true,
+                            +[](int64_t val){ return val >= 0; });
 
 
 static constexpr char CACHE_PREFIX[] = "cache://";
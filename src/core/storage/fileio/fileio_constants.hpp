@@ -96,6 +96,151 @@ extern std::string S3_ENDPOINT;
  */
 extern std::string S3_REGION;
 
+/**
+ * \ingroup fileio
+ * The size of each part of an S3 multipart upload. S3 requires every part
+ * but the last to be at least 5MB. Overridden by the DMLC_S3_WRITE_BUFFER_MB
+ * environment variable.
+ */
+extern size_t FILEIO_S3_PART_SIZE;
+
+/**
+ * \ingroup fileio
+ * The maximum number of parts of a single S3 upload which are uploaded
+ * concurrently. At most this many parts (plus the part being filled) are
+ * held in memory by each S3 output stream.
+ */
+extern size_t FILEIO_S3_UPLOAD_THREADS;
+
+/**
+ * \ingroup fileio
+ * Large S3 reads are split into ranged GETs of this size.
+ */
+extern size_t FILEIO_S3_DOWNLOAD_RANGE_SIZE;
+
+/**
+ * \ingroup fileio
+ * The maximum number of concurrent ranged GETs issued by a single large S3
+ * read. 1 reads sequentially over a single connection.
+ */
+extern size_t FILEIO_S3_DOWNLOAD_THREADS;
+
+/**
+ * \ingroup fileio
+ * Large HDFS reads are split into positional reads of at most this size,
+ * each within a single HDFS block.
+ */
+extern size_t FILEIO_HDFS_READ_RANGE_SIZE;
+
+/**
+ * \ingroup fileio
+ * The maximum number of concurrent positional reads issued by a single
+ * large HDFS read. 1 reads sequentially.
+ */
+extern size_t FILEIO_HDFS_READ_THREADS;
+
+/**
+ * \ingroup fileio
+ * The DataNode domain socket (dfs.domain.socket.path) through which HDFS
+ * blocks with a replica on this host are read directly from local disk
+ * (short-circuit local reads). Empty (the default) leaves short-circuit
+ * reads to the Hadoop configuration. Applies to new HDFS connections.
+ */
+extern std::string FILEIO_HDFS_DOMAIN_SOCKET_PATH;
+
+/**
+ * \ingroup fileio
+ * The path of an HDFS client library exporting the libhdfs C API, such as
+ * the native libhdfs3, loaded in place of the JNI based libhdfs. Empty (the
+ * default) searches for libhdfs. Only read on the first HDFS access.
+ */
+extern std::string FILEIO_HDFS_CLIENT_LIBRARY;
+
+/**
+ * \ingroup fileio
+ * The relative cost of re-fetching a block of a remote file (e.g. on S3)
+ * evicted from the block_cache, compared to a block of a local file.
+ */
+extern size_t FILEIO_BLOCK_CACHE_REMOTE_REFETCH_COST;
+
+/**
+ * \ingroup fileio
+ * The number of block_cache reads which found their key. Read only.
+ */
+extern size_t FILEIO_BLOCK_CACHE_HITS;
+
+/**
+ * \ingroup fileio
+ * The number of block_cache reads which did not find their key. Read only.
+ */
+extern size_t FILEIO_BLOCK_CACHE_MISSES;
+
+/**
+ * \ingroup fileio
+ * The number of keys evicted from block_caches. Read only.
+ */
+extern size_t FILEIO_BLOCK_CACHE_EVICTIONS;
+
+/**
+ * \ingroup fileio
+ * The number of in memory cache blocks spilled to disk by the
+ * fixed_size_cache_manager. Read only.
+ */
+extern size_t FILEIO_CACHE_EVICTIONS;
+
+/**
+ * \ingroup fileio
+ * The total number of bytes which the caches, sorts, joins and groupbys
+ * together may reserve from the \ref memory_budget. 0 means no limit.
+ */
+extern size_t FILEIO_MEMORY_BUDGET;
+
+/**
+ * \ingroup fileio
+ * How long, in milliseconds, a blocking \ref memory_budget reservation waits
+ * for other reservations to be released before going over the budget.
+ */
+extern size_t FILEIO_MEMORY_BUDGET_WAIT_MS;
+
+/**
+ * \ingroup fileio
+ * The number of memory_budget reservations which went over the budget after
+ * waiting. Read only.
+ */
+extern size_t FILEIO_MEMORY_BUDGET_OVERCOMMITS;
+
+/**
+ * \ingroup fileio
+ * The number of I/O threads of the \ref async_reader, which is the maximum
+ * number of its range reads in progress at the same time. Only read when the
+ * first asynchronous read is issued.
+ */
+extern size_t FILEIO_ASYNC_IO_THREADS;
+
+/**
+ * \ingroup fileio
+ * Temp files are placed in the directories of TURI_CACHE_FILE_LOCATIONS in
+ * turn. A directory on a file system with fewer bytes than this available
+ * is skipped, unless all of them are. 0 disables the check.
+ */
+extern size_t FILEIO_TEMP_DIRECTORY_MIN_FREE_BYTES;
+
+/**
+ * \ingroup fileio
+ * A local directory in which blocks of remote (S3) files and downloaded
+ * files are kept across processes, see \ref local_disk_cache. Processes on
+ * a host sharing the directory share the cached data. Empty (the default)
+ * disables the cache.
+ */
+extern std::string FILEIO_LOCAL_DISK_CACHE_DIRECTORY;
+
+/**
+ * \ingroup fileio
+ * The maximum number of bytes kept in FILEIO_LOCAL_DISK_CACHE_DIRECTORY.
+ * The least recently used data is deleted beyond it. 0 means no limit.
+ */
+extern size_t FILEIO_LOCAL_DISK_CACHE_MAX_BYTES;
+
 /**
  * \ingroup fileio
  * The number of GPUs.
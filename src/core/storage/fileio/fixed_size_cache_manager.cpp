@@ -5,6 +5,8 @@
  */
 #include <core/storage/fileio/fileio_constants.hpp>
 #include <core/storage/fileio/fixed_size_cache_manager.hpp>
+#include <core/storage/fileio/memory_budget.hpp>
+#include <core/globals/metrics.hpp>
 #include <core/logging/assertions.hpp>
 #include <iostream>
 #include <iomanip>
@@ -49,10 +51,17 @@ namespace fileio {
           return false;
         }
       }
+      // the memory may also be needed by other caches, sorts, joins...
+      auto& budget = memory_budget::get_instance();
+      if (!budget.try_reserve(new_capacity - capacity)) {
+        new_capacity = queried_capacity;
+        if (!budget.try_reserve(new_capacity - capacity)) return false;
+      }
       // realloc
       char* newdata = (char*)realloc(data, new_capacity);
       if (newdata == nullptr) {
         // failed failed to realloc
+        budget.release(new_capacity - capacity);
         return false;
       }
       data = newdata;
@@ -83,6 +92,9 @@ namespace fileio {
     if (capacity > 0) {
       data = (char*)malloc(capacity * sizeof(char));
       if(!data) { throw std::bad_alloc(); }
+      // this can be called with the cache manager locked, where spilling
+      // to make room would deadlock.
+      memory_budget::get_instance().force_reserve(capacity);
       owning_cache_manager->increment_utilization(capacity);
     } else {
       data = NULL;
@@ -92,6 +104,7 @@ namespace fileio {
   void cache_block::release_memory() {
     if (data) {
       free(data);
+      memory_budget::get_instance().release(capacity);
       owning_cache_manager->decrement_utilization(capacity);
     }
     data = NULL;
@@ -132,9 +145,13 @@ namespace fileio {
    return *instance;
  }
 
-  fixed_size_cache_manager::fixed_size_cache_manager() { }
+  fixed_size_cache_manager::fixed_size_cache_manager() {
+    spill_callback_id = memory_budget::get_instance().register_spill_callback(
+        [this](size_t bytes) { return spill(bytes); });
+  }
 
   fixed_size_cache_manager::~fixed_size_cache_manager() {
+    memory_budget::get_instance().unregister_spill_callback(spill_callback_id);
     clear();
   }
 
@@ -200,6 +217,15 @@ namespace fileio {
     cache_blocks.erase(iter);
   }
 
+  bool fixed_size_cache_manager::set_eviction_priority(const cache_id_type& cache_id,
+                                                       size_t priority) {
+    std::lock_guard<turi::mutex> lck(mutex);
+    auto iter = cache_blocks.find(cache_id);
+    if (iter == cache_blocks.end()) return false;
+    iter->second->eviction_priority = priority;
+    return true;
+  }
+
   std::shared_ptr<cache_block> fixed_size_cache_manager::get_cache(cache_id_type cache_id) {
     logstream(LOG_DEBUG) << "Get cache block " << cache_id << std::endl;
     std::lock_guard<turi::mutex> lck(mutex);
@@ -209,6 +235,37 @@ namespace fileio {
     throw std::out_of_range("Cannot find cache block with id " + cache_id);
   }
 
+  bool fixed_size_cache_manager::try_reserve_memory(size_t bytes) {
+    if (current_cache_utilization.value + bytes > FILEIO_MAXIMUM_CACHE_CAPACITY ||
+        !memory_budget::get_instance().try_reserve(bytes)) {
+      return false;
+    }
+    increment_utilization(bytes);
+    return true;
+  }
+
+  void fixed_size_cache_manager::release_reserved_memory(size_t bytes) {
+    memory_budget::get_instance().release(bytes);
+    decrement_utilization(bytes);
+  }
+
+  size_t fixed_size_cache_manager::spill(size_t bytes) {
+    // whoever holds the lock may be waiting on the memory budget
+    std::unique_lock<turi::mutex> lck(mutex, std::try_to_lock);
+    if (!lck.owns_lock()) return 0;
+    size_t initial_utilization = current_cache_utilization.value;
+    size_t freed = 0;
+    while (freed < bytes) {
+      size_t utilization = current_cache_utilization.value;
+      try_cache_evict();
+      // nothing left to evict
+      if (current_cache_utilization.value >= utilization) break;
+      freed = initial_utilization - std::min(initial_utilization,
+                                             (size_t)current_cache_utilization.value);
+    }
+    return freed;
+  }
+
   void fixed_size_cache_manager::increment_utilization(ssize_t increment) {
     current_cache_utilization.inc(increment);
   }
@@ -220,21 +277,34 @@ namespace fileio {
   void fixed_size_cache_manager::try_cache_evict() {
     // lock must be acquired outside of this call
     ASSERT_FALSE(mutex.try_lock());
-    // we will try to evict the largest
+    // we will try to evict the largest of the lowest priority blocks
     std::string largest_entry_name;
     std::shared_ptr<cache_block> largest_block;
     size_t current_largest_block_size = 0;
+    size_t current_lowest_priority = (size_t)(-1);
     for (auto& iter: cache_blocks) {
       // we can only evict if we are the only pointers to the cache block
-      if (iter.second.unique() && iter.second->is_pointer()) {
-        if (iter.second->get_pointer_size() > current_largest_block_size) {
+      if (iter.second.unique() && iter.second->is_pointer() &&
+          iter.second->get_pointer_size() > 0) {
+        size_t priority = iter.second->eviction_priority;
+        if (priority < current_lowest_priority ||
+            (priority == current_lowest_priority &&
+             iter.second->get_pointer_size() > current_largest_block_size)) {
           largest_entry_name = iter.first;
           largest_block = iter.second;
           current_largest_block_size = largest_block->get_pointer_size();
+          current_lowest_priority = priority;
         }
       }
     }
     if (largest_block) {
+      static metrics::counter& evictions = metrics::get_counter(
+          "cache_evictions", "Cache blocks spilled from memory to disk.");
+      static metrics::counter& evicted_bytes = metrics::get_counter(
+          "cache_evicted_bytes", "Bytes of cache blocks spilled to disk.");
+      ++FILEIO_CACHE_EVICTIONS;
+      ++evictions;
+      evicted_bytes += current_largest_block_size;
       logstream_ontick(5, LOG_INFO) << "Evicting " << largest_entry_name
                           << " with size " << current_largest_block_size << std::endl;
       largest_block->write_to_file();
@@ -142,6 +142,8 @@ struct cache_block {
   std::string filename;
   // the cache manager which created this block
   fixed_size_cache_manager* owning_cache_manager = NULL;
+  // blocks with lower priority are spilled to disk first
+  size_t eviction_priority = 0;
 
   /**
    * Clears, and reinitializes the cache block with a new maximum capacity.
@@ -185,6 +187,17 @@ struct cache_block {
  *   FILEIO_MAXIMUM_CACHE_CAPACITY_PER_FILE : the maximum size of each cache blocks
  *   FILEIO_INITIAL_CAPACITY_PER_FILE : the initial size of each cache blocks
  *
+ *  Eviction
+ *  --------
+ *  When FILEIO_MAXIMUM_CACHE_CAPACITY is reached, in memory blocks which are
+ *  not in use are spilled to disk. Blocks with the lowest eviction priority
+ *  (see \ref set_eviction_priority()) go first, and among those the largest.
+ *  Every spill is counted in the FILEIO_CACHE_EVICTIONS global.
+ *
+ *  All the memory of the cache blocks is also reserved from the \ref
+ *  memory_budget, which registers the same eviction as a spill callback:
+ *  when sorts, joins or groupbys need the memory, unused blocks go to disk.
+ *
  *  Overcommit Behavior
  *  -------------------
  *  We try our best to maintain cache utilization below the maximum. However,
@@ -228,6 +241,15 @@ class fixed_size_cache_manager {
    */
   void free(std::shared_ptr<cache_block> block);
 
+  /**
+   * Sets the eviction priority of a cache block. Blocks with a higher
+   * priority are kept in memory longer under memory pressure. Cache blocks
+   * start with priority 0. Returns false if the cache_id does not exist.
+   *
+   * Thread safe.
+   */
+  bool set_eviction_priority(const cache_id_type& cache_id, size_t priority);
+
   /**
    * Clear all cache blocks in the manager. Reset to initial state.
    */
@@ -240,6 +262,36 @@ class fixed_size_cache_manager {
     return current_cache_utilization.value;
   }
 
+  /**
+   * Accounts for bytes of memory held outside of any cache block (for
+   * instance, SFrame blocks which have been read ahead) in the cache
+   * utilization, so that caches and such buffers share the same
+   * FILEIO_MAXIMUM_CACHE_CAPACITY.
+   *
+   * Returns false, reserving nothing, if the reservation would take the
+   * cache utilization beyond FILEIO_MAXIMUM_CACHE_CAPACITY. Every successful
+   * reservation must be returned with \ref release_reserved_memory().
+   *
+   * Thread safe. Subject to the same overcommit behavior as the caches.
+   */
+  bool try_reserve_memory(size_t bytes);
+
+  /**
+   * Returns memory reserved with \ref try_reserve_memory().
+   *
+   * Thread safe.
+   */
+  void release_reserved_memory(size_t bytes);
+
+  /**
+   * Evicts unused cache blocks until at least bytes are freed or none are
+   * left. Returns the number of bytes freed. Does nothing if the cache
+   * manager is locked by another thread.
+   *
+   * The spill callback registered with the \ref memory_budget.
+   */
+  size_t spill(size_t bytes);
+
  private:
   fixed_size_cache_manager();
 
@@ -254,6 +306,8 @@ class fixed_size_cache_manager {
  private:
   size_t temp_cache_counter = 0;
 
+  size_t spill_callback_id = 0;
+
   atomic<size_t> current_cache_utilization;
 
   turi::mutex mutex;
@@ -44,6 +44,9 @@ typedef boost::iostreams::stream<fileio_impl::general_fstream_source>
  * s3://[access_key_id]:[secret_key]:[endpoint][/bucket]/[object_name]
  *
  * Endpoint URLs however, are set globally via the global variable S3_ENDPOINT.
+ *
+ * Reads block the calling thread. To issue many range reads without waiting
+ * on each, see \ref fileio::async_reader.
  */
 class EXPORT general_ifstream : public general_ifstream_base {
  private:
@@ -6,6 +6,7 @@
 #include <boost/algorithm/string.hpp>
 #include <core/logging/assertions.hpp>
 #include <core/storage/fileio/general_fstream_source.hpp>
+#include <core/globals/metrics.hpp>
 
 namespace turi {
 namespace fileio_impl {
@@ -28,6 +29,17 @@ void general_fstream_source::open_file(std::string file, bool gzip_compressed) {
     decompressor = std::make_shared<boost::iostreams::gzip_decompressor>();
   }
   underlying_stream = in_file->get_istream();
+
+  static metrics::counter& hdfs_bytes_read = metrics::get_counter(
+      "hdfs_bytes_read", "Bytes read from HDFS files.");
+  static metrics::counter& local_bytes_read = metrics::get_counter(
+      "local_bytes_read", "Bytes read from local files.");
+  if (in_file->get_type() == union_fstream::HDFS) {
+    bytes_read_counter = &hdfs_bytes_read;
+  } else if (in_file->get_type() == union_fstream::STD &&
+             !boost::starts_with(file, "s3://")) {
+    bytes_read_counter = &local_bytes_read;
+  }
 }
 
 bool general_fstream_source::is_open() const {
@@ -35,12 +47,15 @@ bool general_fstream_source::is_open() const {
 }
 
 std::streamsize general_fstream_source::read(char* c, std::streamsize bufsize) {
+  std::streamsize ret;
   if (is_gzip_compressed) {
-    return decompressor->read(*underlying_stream, c, bufsize);
+    ret = decompressor->read(*underlying_stream, c, bufsize);
   } else {
     underlying_stream->read(c, bufsize);
-    return underlying_stream->gcount();
+    ret = underlying_stream->gcount();
   }
+  if (bytes_read_counter && ret > 0) *bytes_read_counter += ret;
+  return ret;
 }
 
 general_fstream_source::~general_fstream_source() {
@@ -12,6 +12,9 @@
 #include <core/storage/fileio/fileio_constants.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
 namespace turi {
+namespace metrics {
+class counter;
+}
 namespace fileio_impl {
 
 /**
@@ -34,6 +37,10 @@ class general_fstream_source {
 
   /// Set by the constructor. whether it is gzip compressed.
   bool is_gzip_compressed = false;
+
+  /// Counter of the bytes read from the file's storage; null for S3 files,
+  /// which the S3 device counts, and for cache:// files.
+  metrics::counter* bytes_read_counter = nullptr;
  public:
   typedef char        char_type;
   struct category: public boost::iostreams::device_tag,
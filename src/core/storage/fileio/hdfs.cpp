@@ -4,9 +4,13 @@
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
 #include <core/storage/fileio/hdfs.hpp>
+#include <algorithm>
+#include <deque>
+#include <future>
 #include <map>
 #include <memory>
 #include <system_error>
+#include <core/storage/fileio/fileio_constants.hpp>
 #include <core/parallel/mutex.hpp>
 #include <pthread.h>
 #include <core/export.hpp>
@@ -59,7 +63,21 @@ hdfs& EXPORT hdfs::get_hdfs(std::string host, size_t port) {
 /**************************************************************************/
 hdfs::hdfs(const std::string& host, tPort port) {
   logstream(LOG_INFO) << "Connecting to HDFS. Host: " << host << " Port: " << port << std::endl;
-  filesystem =  hdfsConnect(host.c_str(), port);
+  const std::string& socket_path = fileio::FILEIO_HDFS_DOMAIN_SOCKET_PATH;
+  // the builder is missing from old libhdfs versions
+  struct hdfsBuilder* builder = socket_path.empty() ? NULL : hdfsNewBuilder();
+  if (builder != NULL) {
+    logstream(LOG_INFO) << "Enabling HDFS short-circuit local reads through "
+                        << socket_path << std::endl;
+    hdfsBuilderSetNameNode(builder, host.c_str());
+    hdfsBuilderSetNameNodePort(builder, port);
+    hdfsBuilderConfSetStr(builder, "dfs.client.read.shortcircuit", "true");
+    hdfsBuilderConfSetStr(builder, "dfs.domain.socket.path", socket_path.c_str());
+    // frees the builder
+    filesystem = hdfsBuilderConnect(builder);
+  } else {
+    filesystem =  hdfsConnect(host.c_str(), port);
+  }
   if (filesystem == NULL) {
     logstream(LOG_ERROR) << "Fail connecting to hdfs" << std::endl;
   }
@@ -148,7 +166,14 @@ hdfs::hdfs_device::hdfs_device(const hdfs& hdfs_fs, const std::string& filename,
   const int buffer_size = 0; // use default
   const short replication = 0; // use default
   const tSize block_size = 0; // use default;
-  m_file_size = hdfs_fs.file_size(filename);
+  m_writing = write;
+  m_file_size = (size_t)(-1);
+  hdfsFileInfo* file_info = hdfsGetPathInfo(filesystem, filename.c_str());
+  if (file_info != NULL) {
+    m_file_size = file_info->mSize;
+    m_block_size = file_info->mBlockSize;
+    hdfsFreeFileInfo(file_info, 1);
+  }
   file = hdfsOpenFile(filesystem, filename.c_str(), flags, buffer_size,
       replication, block_size);
   logstream(LOG_INFO) << "HDFS open " << filename << " write = " << write << std::endl;
@@ -160,7 +185,9 @@ hdfs::hdfs_device::hdfs_device(const hdfs& hdfs_fs, const std::string& filename,
 
 void hdfs::hdfs_device::close(std::ios_base::openmode mode) {
   if(file == NULL) return;
-  if(file->type == HDFS_STREAMTYPE_OUTPUT && mode == std::ios_base::out) {
+  // hdfsFile is opaque to native clients such as libhdfs3, so the
+  // direction of the file is not read from it
+  if(m_writing && mode == std::ios_base::out) {
     const int flush_error = hdfsFlush(filesystem, file);
     if (flush_error != 0) {
       log_and_throw_io_failure("Error on flush.");
@@ -170,7 +197,7 @@ void hdfs::hdfs_device::close(std::ios_base::openmode mode) {
     if (close_error != 0) {
       log_and_throw_io_failure("Error on close.");
     };
-  } else if (file->type == HDFS_STREAMTYPE_INPUT && mode == std::ios_base::in) {
+  } else if (!m_writing && mode == std::ios_base::in) {
     const int close_error = hdfsCloseFile(filesystem, file);
     if (close_error != 0) {
       log_and_throw_io_failure("Error on close.");
@@ -182,6 +209,12 @@ void hdfs::hdfs_device::close(std::ios_base::openmode mode) {
 }
 
 std::streamsize hdfs::hdfs_device::read(char* strm_ptr, std::streamsize n) {
+  // large reads (such as whole SFrame blocks) are split into concurrent
+  // positional reads
+  if (fileio::FILEIO_HDFS_READ_THREADS > 1 &&
+      (size_t)n >= 2 * fileio::FILEIO_HDFS_READ_RANGE_SIZE) {
+    return parallel_read(strm_ptr, n);
+  }
   std::streamsize ret = hdfsRead(filesystem, file, strm_ptr, n);
   if (ret == -1) {
     log_and_throw_io_failure("Read Error.");
@@ -189,6 +222,63 @@ std::streamsize hdfs::hdfs_device::read(char* strm_ptr, std::streamsize n) {
   return ret;
 }
 
+std::streamsize hdfs::hdfs_device::parallel_read(char* strm_ptr, std::streamsize n) {
+  tOffset position = hdfsTell(filesystem, file);
+  if (position < 0) log_and_throw_io_failure("Read Error.");
+  size_t begin = position;
+  size_t end = std::min<size_t>(begin + n, m_file_size);
+  if (end <= begin) return 0;
+  const size_t range_size = fileio::FILEIO_HDFS_READ_RANGE_SIZE;
+  const size_t max_in_flight = fileio::FILEIO_HDFS_READ_THREADS;
+  hdfsFS fs = filesystem;
+  hdfsFile f = file;
+  // positional reads do not move the file, and may be issued concurrently
+  auto read_range = [fs, f](size_t range_begin, size_t range_end,
+                            char* out) -> size_t {
+    size_t nread = 0;
+    while (range_begin + nread < range_end) {
+      tSize ret = hdfsPread(fs, f, range_begin + nread, out + nread,
+                            range_end - range_begin - nread);
+      if (ret == -1) log_and_throw_io_failure("Read Error.");
+      if (ret == 0) break;
+      nread += ret;
+    }
+    return nread;
+  };
+
+  // bytes read contiguously from begin. A short range ends the read there.
+  size_t bytes_read = 0;
+  bool short_read = false;
+  std::deque<std::pair<size_t, std::future<size_t> > > pending;
+  auto wait_for_range = [&]() {
+    size_t expected = pending.front().first;
+    size_t nread = pending.front().second.get();
+    pending.pop_front();
+    if (short_read) return;
+    bytes_read += nread;
+    if (nread < expected) short_read = true;
+  };
+  // destroying the pending futures waits for them, so an exception never
+  // leaves a range writing into strm_ptr
+  size_t range_end = begin;
+  for (size_t range_begin = begin; range_begin < end && !short_read;
+       range_begin = range_end) {
+    range_end = std::min(range_begin + range_size, end);
+    if (m_block_size > 0) {
+      size_t block_end = (range_begin / m_block_size + 1) * m_block_size;
+      range_end = std::min(range_end, block_end);
+    }
+    pending.emplace_back(range_end - range_begin,
+                         std::async(std::launch::async, read_range,
+                                    range_begin, range_end,
+                                    strm_ptr + (range_begin - begin)));
+    while (pending.size() >= max_in_flight) wait_for_range();
+  }
+  while (!pending.empty()) wait_for_range();
+  hdfsSeek(filesystem, file, begin + bytes_read);
+  return bytes_read;
+}
+
 std::streamsize hdfs::hdfs_device::write(const char* strm_ptr, std::streamsize n) {
   std::streamsize ret = hdfsWrite(filesystem, file, strm_ptr, n);
   if (ret == -1) {
@@ -72,6 +72,20 @@ namespace turi {
 
       size_t m_file_size;
 
+      /// The HDFS block size of the file. 0 if unknown.
+      size_t m_block_size = 0;
+
+      bool m_writing = false;
+
+      /**
+       * Reads n bytes from the current position with positional reads of
+       * at most FILEIO_HDFS_READ_RANGE_SIZE bytes, which never cross an HDFS
+       * block boundary, up to FILEIO_HDFS_READ_THREADS of them in flight at
+       * once. Different blocks are thus fetched from their DataNodes
+       * concurrently. The file is then positioned after the bytes read.
+       */
+      std::streamsize parallel_read(char* strm_ptr, std::streamsize n);
+
     public:
       hdfs_device() : filesystem(NULL), file(NULL) { }
 
@@ -108,7 +122,12 @@ namespace turi {
 
     /**
      * Open a connection to the filesystem. The default arguments
-     * should be sufficient for most uses
+     * should be sufficient for most uses.
+     *
+     * When FILEIO_HDFS_DOMAIN_SOCKET_PATH is set, the connection enables
+     * short-circuit local reads through that DataNode socket: blocks with a
+     * replica on this host are then read from local disk rather than
+     * streamed from the DataNode.
      */
     hdfs(const std::string& host = "default", tPort port = 0);
 
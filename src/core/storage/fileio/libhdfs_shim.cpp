@@ -5,6 +5,7 @@
  */
 // libhdfs shim library
 #include <core/globals/global_constants.hpp>
+#include <core/storage/fileio/fileio_constants.hpp>
 #include <core/logging/logger.hpp>
 #include <core/logging/assertions.hpp>
 #include <vector>
@@ -76,6 +77,12 @@ extern  "C" {
   static int (*ptr_hdfsChown)(hdfsFS fs, const char* path, const char *owner, const char *group) = NULL;
   static int (*ptr_hdfsChmod)(hdfsFS fs, const char* path, short mode) = NULL;
   static int (*ptr_hdfsUtime)(hdfsFS fs, const char* path, tTime mtime, tTime atime) = NULL;
+  static struct hdfsBuilder* (*ptr_hdfsNewBuilder)(void) = NULL;
+  static void (*ptr_hdfsBuilderSetNameNode)(struct hdfsBuilder *bld, const char *nn) = NULL;
+  static void (*ptr_hdfsBuilderSetNameNodePort)(struct hdfsBuilder *bld, tPort port) = NULL;
+  static int (*ptr_hdfsBuilderConfSetStr)(struct hdfsBuilder *bld, const char *key,
+                                          const char *val) = NULL;
+  static hdfsFS (*ptr_hdfsBuilderConnect)(struct hdfsBuilder *bld) = NULL;
 
   // Helper functions for dlopens
   static std::vector<fs::path> get_potential_libjvm_paths();
@@ -92,11 +99,20 @@ extern  "C" {
     if (shim_attempted == false) {
       shim_attempted = true;
 
-      std::vector<fs::path> libjvm_potential_paths = get_potential_libjvm_paths();
-      try_dlopen(libjvm_potential_paths, "libjvm", libjvm_handle);
+      // a native client exporting the libhdfs API (such as libhdfs3) talks
+      // to HDFS directly, without a JVM
+      const std::string& client_library = turi::fileio::FILEIO_HDFS_CLIENT_LIBRARY;
+      if (!client_library.empty()) {
+        try_dlopen({fs::path(client_library)}, "the HDFS client library", libhdfs_handle);
+      }
+
+      if (libhdfs_handle == NULL) {
+        std::vector<fs::path> libjvm_potential_paths = get_potential_libjvm_paths();
+        try_dlopen(libjvm_potential_paths, "libjvm", libjvm_handle);
 
-      std::vector<fs::path> libhdfs_potential_paths = get_potential_libhdfs_paths();
-      try_dlopen(libhdfs_potential_paths, "libhdfs", libhdfs_handle);
+        std::vector<fs::path> libhdfs_potential_paths = get_potential_libhdfs_paths();
+        try_dlopen(libhdfs_potential_paths, "libhdfs", libhdfs_handle);
+      }
 
       if(libhdfs_handle == NULL) {
         logstream(LOG_ERROR) << "Error loading libhdfs.  Please make sure the environment variable HADOOP_HOME_DIR is set properly, and that libhdfs.so, libhdfs.dylib, or hdfs.dll is found in one of $(HADOOP_HOME_DIR)/lib/native/, $(HADOOP_HOME_DIR)/lib/,$(HADOOP_HOME_DIR)/libhdfs/, or $(HADOOP_HOME_DIR)/.  Also, please make sure that CLASS_PATH is set to the output of `hadoop classpath --glob`, and JAVA_HOME is set correctly." << std::endl;
@@ -350,6 +366,34 @@ extern  "C" {
     else return 0;
   }
 
+  struct hdfsBuilder* hdfsNewBuilder(void) {
+    if(!ptr_hdfsNewBuilder) *(void**)(&ptr_hdfsNewBuilder) = get_symbol("hdfsNewBuilder");
+    if (ptr_hdfsNewBuilder) return turi::run_as_native(ptr_hdfsNewBuilder);
+    else return NULL;
+  }
+
+  void hdfsBuilderSetNameNode(struct hdfsBuilder *bld, const char *nn) {
+    if(!ptr_hdfsBuilderSetNameNode) *(void**)(&ptr_hdfsBuilderSetNameNode) = get_symbol("hdfsBuilderSetNameNode");
+    if (ptr_hdfsBuilderSetNameNode) turi::run_as_native(ptr_hdfsBuilderSetNameNode, bld, nn);
+  }
+
+  void hdfsBuilderSetNameNodePort(struct hdfsBuilder *bld, tPort port) {
+    if(!ptr_hdfsBuilderSetNameNodePort) *(void**)(&ptr_hdfsBuilderSetNameNodePort) = get_symbol("hdfsBuilderSetNameNodePort");
+    if (ptr_hdfsBuilderSetNameNodePort) turi::run_as_native(ptr_hdfsBuilderSetNameNodePort, bld, port);
+  }
+
+  int hdfsBuilderConfSetStr(struct hdfsBuilder *bld, const char *key, const char *val) {
+    if(!ptr_hdfsBuilderConfSetStr) *(void**)(&ptr_hdfsBuilderConfSetStr) = get_symbol("hdfsBuilderConfSetStr");
+    if (ptr_hdfsBuilderConfSetStr) return turi::run_as_native(ptr_hdfsBuilderConfSetStr, bld, key, val);
+    else return -1;
+  }
+
+  hdfsFS hdfsBuilderConnect(struct hdfsBuilder *bld) {
+    if(!ptr_hdfsBuilderConnect) *(void**)(&ptr_hdfsBuilderConnect) = get_symbol("hdfsBuilderConnect");
+    if (ptr_hdfsBuilderConnect) return turi::run_as_native(ptr_hdfsBuilderConnect, bld);
+    else return NULL;
+  }
+
   static std::string get_hadoop_home_dir() {
     static std::string hadoop_home = std::getenv("HADOOP_HOME_DIR");
     return hadoop_home;
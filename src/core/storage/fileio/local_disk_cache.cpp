@@ -0,0 +1,255 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/sync/file_lock.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <core/storage/fileio/local_disk_cache.hpp>
+#include <core/storage/fileio/fileio_constants.hpp>
+#include <core/globals/metrics.hpp>
+#include <core/logging/logger.hpp>
+#include <core/system/platform/process/process_util.hpp>
+#include <core/util/md5.hpp>
+#ifndef TC_DISABLE_REMOTEFS
+#include <core/storage/fileio/s3_api.hpp>
+#endif
+
+namespace fs = boost::filesystem;
+
+namespace turi {
+
+namespace {
+
+/// The name of the lock file which serializes evictions across processes
+constexpr char LOCK_FILE_NAME[] = "lock";
+
+/// Marks the temporary files values are written to
+constexpr char TEMP_MARKER[] = ".tmp-";
+
+/**
+ * Temporary files older than this (in seconds) are left over by processes
+ * which died while writing, and are deleted on eviction.
+ */
+constexpr std::time_t STALE_TEMP_FILE_AGE = 3600;
+
+metrics::counter& local_disk_cache_hits() {
+  static metrics::counter& c = metrics::get_counter(
+      "local_disk_cache_hits", "Local disk cache reads served from disk.");
+  return c;
+}
+metrics::counter& local_disk_cache_misses() {
+  static metrics::counter& c = metrics::get_counter(
+      "local_disk_cache_misses", "Local disk cache reads of keys not on disk.");
+  return c;
+}
+metrics::counter& local_disk_cache_evictions() {
+  static metrics::counter& c = metrics::get_counter(
+      "local_disk_cache_evictions", "Values evicted from the local disk cache.");
+  return c;
+}
+
+} // anonymous namespace
+
+
+local_disk_cache::local_disk_cache(const std::string& directory,
+                                   size_t max_bytes)
+    : m_directory(directory), m_max_bytes(max_bytes) {
+  boost::system::error_code ec;
+  fs::create_directories(m_directory, ec);
+  if (!fs::is_directory(m_directory)) {
+    log_and_throw("Cannot create the local disk cache directory " + m_directory);
+  }
+}
+
+std::string local_disk_cache::value_path(const std::string& key) const {
+  return (fs::path(m_directory) / md5(key)).string();
+}
+
+std::string local_disk_cache::temp_path(const std::string& key) const {
+  static std::atomic<size_t> counter{0};
+  return value_path(key) + TEMP_MARKER + std::to_string(get_my_pid()) + "-" +
+         std::to_string(counter++);
+}
+
+void local_disk_cache::count_hit(bool hit) {
+  if (hit) {
+    ++m_hits;
+    ++local_disk_cache_hits();
+  } else {
+    ++m_misses;
+    ++local_disk_cache_misses();
+  }
+}
+
+void local_disk_cache::touch(const std::string& path) {
+  boost::system::error_code ec;
+  fs::last_write_time(path, std::time(nullptr), ec);
+}
+
+bool local_disk_cache::read(const std::string& key, std::string& output) {
+  std::string path = value_path(key);
+  std::ifstream fin(path, std::ifstream::binary);
+  if (!fin.good()) {
+    count_hit(false);
+    return false;
+  }
+  fin.seekg(0, std::ios::end);
+  std::streamoff length = fin.tellg();
+  fin.seekg(0, std::ios::beg);
+  output.resize(length > 0 ? length : 0);
+  if (length > 0) fin.read(&(output[0]), length);
+  // deleted by an eviction in between
+  if (length < 0 || fin.gcount() != length) {
+    count_hit(false);
+    return false;
+  }
+  touch(path);
+  count_hit(true);
+  return true;
+}
+
+bool local_disk_cache::copy_to(const std::string& key, const std::string& path) {
+  std::string value = value_path(key);
+  boost::system::error_code ec;
+  fs::copy_file(value, path, fs::copy_option::overwrite_if_exists, ec);
+  if (ec) {
+    count_hit(false);
+    return false;
+  }
+  touch(value);
+  count_hit(true);
+  return true;
+}
+
+bool local_disk_cache::write(const std::string& key, const std::string& value) {
+  std::string temp = temp_path(key);
+  {
+    std::ofstream fout(temp, std::ofstream::binary);
+    fout.write(value.c_str(), value.length());
+    fout.close();
+    if (!fout.good()) {
+      boost::system::error_code ec;
+      fs::remove(temp, ec);
+      return false;
+    }
+  }
+  return publish(temp, key);
+}
+
+bool local_disk_cache::write_file(const std::string& key, const std::string& path) {
+  std::string temp = temp_path(key);
+  boost::system::error_code ec;
+  fs::copy_file(path, temp, fs::copy_option::overwrite_if_exists, ec);
+  if (ec) {
+    fs::remove(temp, ec);
+    return false;
+  }
+  return publish(temp, key);
+}
+
+bool local_disk_cache::publish(const std::string& temp, const std::string& key) {
+  std::string path = value_path(key);
+  boost::system::error_code ec;
+  fs::rename(temp, path, ec);
+  if (ec) {
+    fs::remove(temp, ec);
+    // renaming over an existing file fails on Windows. Since values are
+    // content addressed, the value in place is as good as ours.
+    if (!fs::exists(path)) return false;
+  }
+  try {
+    evict();
+  } catch (...) {
+    logstream(LOG_WARNING) << "Unable to evict from the local disk cache in "
+                           << m_directory << std::endl;
+  }
+  return true;
+}
+
+void local_disk_cache::evict() {
+  if (m_max_bytes == 0) return;
+  std::lock_guard<mutex> guard(m_evict_lock);
+  std::string lock_path = (fs::path(m_directory) / LOCK_FILE_NAME).string();
+  // file_lock needs an existing file
+  { std::ofstream create_lock(lock_path, std::ofstream::app); }
+  boost::interprocess::file_lock file_lock(lock_path.c_str());
+  boost::interprocess::scoped_lock<boost::interprocess::file_lock> lock(file_lock);
+
+  // (last use, size, path) of every value
+  std::vector<std::tuple<std::time_t, size_t, std::string>> values;
+  size_t total_bytes = 0;
+  std::time_t now = std::time(nullptr);
+  boost::system::error_code ec;
+  for (fs::directory_iterator iter(m_directory, ec), end; !ec && iter != end;
+       iter.increment(ec)) {
+    std::string path = iter->path().string();
+    std::string name = iter->path().filename().string();
+    if (name == LOCK_FILE_NAME) continue;
+    boost::system::error_code file_ec;
+    // deleted by another process while we were listing
+    std::time_t last_use = fs::last_write_time(path, file_ec);
+    if (file_ec) continue;
+    size_t size = fs::file_size(path, file_ec);
+    if (file_ec) continue;
+    if (name.find(TEMP_MARKER) != std::string::npos) {
+      if (now - last_use > STALE_TEMP_FILE_AGE) fs::remove(path, file_ec);
+      continue;
+    }
+    values.emplace_back(last_use, size, path);
+    total_bytes += size;
+  }
+  if (total_bytes <= m_max_bytes) return;
+
+  std::sort(values.begin(), values.end());
+  for (const auto& value: values) {
+    if (total_bytes <= m_max_bytes) break;
+    // a value still open for reading in another process stays readable
+    // where unlinking open files is allowed
+    boost::system::error_code file_ec;
+    if (fs::remove(std::get<2>(value), file_ec)) {
+      total_bytes -= std::get<1>(value);
+      ++local_disk_cache_evictions();
+    }
+  }
+}
+
+std::shared_ptr<local_disk_cache> local_disk_cache::get_instance() {
+  static mutex instance_lock;
+  static std::shared_ptr<local_disk_cache> instance;
+  std::lock_guard<mutex> guard(instance_lock);
+  const std::string& directory = fileio::FILEIO_LOCAL_DISK_CACHE_DIRECTORY;
+  if (directory.empty()) {
+    instance.reset();
+  } else if (instance == nullptr || instance->directory() != directory) {
+    try {
+      instance = std::make_shared<local_disk_cache>(
+          directory, fileio::FILEIO_LOCAL_DISK_CACHE_MAX_BYTES);
+    } catch (...) {
+      instance.reset();
+    }
+  }
+  if (instance) instance->set_max_bytes(fileio::FILEIO_LOCAL_DISK_CACHE_MAX_BYTES);
+  return instance;
+}
+
+std::string get_remote_file_version(const std::string& url) {
+#ifndef TC_DISABLE_REMOTEFS
+  if (boost::starts_with(url, "s3://")) {
+    try {
+      return get_s3_file_last_modified(url);
+    } catch (...) { }
+  }
+#endif
+  return "";
+}
+
+} // namespace turi
@@ -0,0 +1,130 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_FILEIO_LOCAL_DISK_CACHE_HPP
+#define TURI_FILEIO_LOCAL_DISK_CACHE_HPP
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <core/parallel/mutex.hpp>
+
+namespace turi {
+
+/**
+ * \ingroup fileio
+ *
+ * A bounded cache of remote data in a local directory, which outlives the
+ * process and is shared by every process on the host using the same
+ * directory (see FILEIO_LOCAL_DISK_CACHE_DIRECTORY).
+ *
+ * Values are content addressed: a key must identify the contents of its
+ * value for good (for instance the URL, the last modification time and the
+ * byte range of a block of a remote file), since a value is never updated
+ * once written. Every value is a file named after the md5 of its key.
+ *
+ * Values are written to a private temporary file which is then renamed into
+ * place, so a reader, in any process, sees either the whole value or none
+ * of it. Reading a value marks it as recently used by touching its
+ * modification time. When the values add up to more than the maximum size,
+ * the least recently used are deleted; eviction is serialized across
+ * processes by a lock file in the directory.
+ *
+ * The local_disk_cache is safe for concurrent use.
+ */
+class local_disk_cache {
+ public:
+  /**
+   * Uses the local directory, which is created if missing, to cache at most
+   * max_bytes bytes of values. 0 means no limit.
+   */
+  local_disk_cache(const std::string& directory, size_t max_bytes);
+
+  // copying is disabled
+  local_disk_cache(const local_disk_cache&) = delete;
+  local_disk_cache& operator=(const local_disk_cache&) = delete;
+
+  /**
+   * Reads the whole value of a key into output. Returns false if the key is
+   * not in the cache.
+   */
+  bool read(const std::string& key, std::string& output);
+
+  /**
+   * Copies the value of a key to the local file at path, which is
+   * overwritten. Returns false if the key is not in the cache.
+   */
+  bool copy_to(const std::string& key, const std::string& path);
+
+  /**
+   * Stores a value, then evicts values if the cache is over its maximum
+   * size. Returns false if the value could not be written, which callers
+   * may ignore: the cache is only an optimization.
+   */
+  bool write(const std::string& key, const std::string& value);
+
+  /// As \ref write(), storing the contents of the local file at path.
+  bool write_file(const std::string& key, const std::string& path);
+
+  /**
+   * Deletes least recently used values until the values add up to at most
+   * the maximum size.
+   */
+  void evict();
+
+  /// The cache directory
+  const std::string& directory() const { return m_directory; }
+
+  size_t get_max_bytes() const { return m_max_bytes; }
+  void set_max_bytes(size_t max_bytes) { m_max_bytes = max_bytes; }
+
+  /// The number of reads which found their key.
+  size_t hits() const { return m_hits.load(); }
+
+  /// The number of reads which did not find their key.
+  size_t misses() const { return m_misses.load(); }
+
+  /**
+   * Returns the cache in FILEIO_LOCAL_DISK_CACHE_DIRECTORY, bounded by
+   * FILEIO_LOCAL_DISK_CACHE_MAX_BYTES, or nullptr if the directory is not
+   * set.
+   */
+  static std::shared_ptr<local_disk_cache> get_instance();
+
+ private:
+  std::string m_directory;
+  size_t m_max_bytes = 0;
+  /// Serializes evictions within the process. The lock file only excludes
+  /// other processes.
+  mutex m_evict_lock;
+  std::atomic<size_t> m_hits{0};
+  std::atomic<size_t> m_misses{0};
+
+  /// The file holding the value of a key
+  std::string value_path(const std::string& key) const;
+
+  /// A temporary file in the directory, unique across processes
+  std::string temp_path(const std::string& key) const;
+
+  /// Renames a temporary file into place and evicts. False on failure.
+  bool publish(const std::string& temp, const std::string& key);
+
+  /// Marks a value as recently used.
+  void touch(const std::string& path);
+
+  void count_hit(bool hit);
+};
+
+/**
+ * \ingroup fileio
+ * Returns a string which changes whenever the contents of a remote file
+ * change, to make up keys of the \ref local_disk_cache. Returns an empty
+ * string if that cannot be told, in which case the file must not be cached.
+ * Only known for S3 objects, from their last modification time.
+ */
+std::string get_remote_file_version(const std::string& url);
+
+} // namespace turi
+#endif
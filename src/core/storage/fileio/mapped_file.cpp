@@ -0,0 +1,72 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <core/logging/logger.hpp>
+#include <core/storage/fileio/fs_utils.hpp>
+#include <core/storage/fileio/mapped_file.hpp>
+#include <core/storage/fileio/sanitize_url.hpp>
+
+namespace turi {
+namespace fileio {
+
+bool mapped_file::is_local_path(const std::string& path) {
+  std::string protocol = get_protocol(path);
+  return protocol.empty() || protocol == "file";
+}
+
+#ifndef _WIN32
+
+mapped_file::mapped_file(const std::string& path) {
+  if (!is_local_path(path)) return;
+  std::string local_path = remove_protocol(path);
+  int fd = ::open(local_path.c_str(), O_RDONLY);
+  if (fd < 0) return;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void* ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (ptr != MAP_FAILED) {
+      m_data = static_cast<const char*>(ptr);
+      m_size = st.st_size;
+    } else {
+      logstream(LOG_DEBUG) << "Unable to mmap " << sanitize_url(path)
+                           << ". Falling back to stream reads." << std::endl;
+    }
+  }
+  // the mapping remains valid after the descriptor is closed
+  ::close(fd);
+}
+
+mapped_file::~mapped_file() {
+  if (m_data) munmap(const_cast<char*>(m_data), m_size);
+}
+
+void mapped_file::will_need(size_t offset, size_t length) const {
+  if (!m_data || offset >= m_size) return;
+  // madvise requires a page aligned address
+  static const size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t aligned_offset = offset - (offset % page_size);
+  length = std::min(length + (offset - aligned_offset), m_size - aligned_offset);
+  madvise(const_cast<char*>(m_data) + aligned_offset, length, MADV_WILLNEED);
+}
+
+#else
+
+mapped_file::mapped_file(const std::string& path) { }
+
+mapped_file::~mapped_file() { }
+
+void mapped_file::will_need(size_t offset, size_t length) const { }
+
+#endif
+
+} // namespace fileio
+} // namespace turi
@@ -0,0 +1,72 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_FILEIO_MAPPED_FILE_HPP
+#define TURI_FILEIO_MAPPED_FILE_HPP
+#include <cstddef>
+#include <string>
+
+namespace turi {
+namespace fileio {
+
+/**
+ * \ingroup fileio
+ * A read only memory mapping of an entire file on the local file system.
+ *
+ * Reads through the mapping are served straight from the OS page cache,
+ * which is shared by every process reading the same file, and need
+ * neither a file handle nor a lock. The mapping is released on destruction.
+ *
+ * If the file cannot be mapped (it does not exist, is empty, or the
+ * platform does not support mmap), is_open() returns false and the caller
+ * should fall back to \ref general_ifstream.
+ */
+class mapped_file {
+ public:
+  /**
+   * Maps the file. The path may be a plain local path or a file:// URL.
+   */
+  explicit mapped_file(const std::string& path);
+
+  ~mapped_file();
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  /// True if the file was mapped successfully
+  inline bool is_open() const {
+    return m_data != nullptr;
+  }
+
+  /// A pointer to the start of the file contents
+  inline const char* data() const {
+    return m_data;
+  }
+
+  /// The length of the file in bytes
+  inline size_t size() const {
+    return m_size;
+  }
+
+  /**
+   * Hints to the OS that the byte range [offset, offset + length) will be
+   * read soon, so it can start paging it in.
+   */
+  void will_need(size_t offset, size_t length) const;
+
+  /**
+   * Returns true if path refers to the local file system and hence is a
+   * candidate for mapping.
+   */
+  static bool is_local_path(const std::string& path);
+
+ private:
+  const char* m_data = nullptr;
+  size_t m_size = 0;
+};
+
+} // namespace fileio
+} // namespace turi
+#endif
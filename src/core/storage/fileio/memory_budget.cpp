@@ -0,0 +1,151 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <mutex>
+#include <core/export.hpp>
+#include <core/logging/assertions.hpp>
+#include <core/logging/logger.hpp>
+#include <core/storage/fileio/fileio_constants.hpp>
+#include <core/storage/fileio/memory_budget.hpp>
+#include <timer/timer.hpp>
+
+namespace turi {
+namespace fileio {
+
+EXPORT memory_budget& memory_budget::get_instance() {
+  static memory_budget instance;
+  return instance;
+}
+
+size_t memory_budget::limit() const {
+  return FILEIO_MEMORY_BUDGET;
+}
+
+size_t memory_budget::reserved() const {
+  std::lock_guard<turi::mutex> guard(m_lock);
+  return m_reserved;
+}
+
+size_t memory_budget::available() const {
+  std::lock_guard<turi::mutex> guard(m_lock);
+  return available_locked();
+}
+
+size_t memory_budget::available_locked() const {
+  size_t budget = limit();
+  if (budget == 0) return (size_t)(-1);
+  return m_reserved < budget ? budget - m_reserved : 0;
+}
+
+bool memory_budget::try_reserve_locked(size_t bytes) {
+  size_t budget = limit();
+  if (budget != 0 && m_reserved + bytes > budget) return false;
+  m_reserved += bytes;
+  return true;
+}
+
+bool memory_budget::try_reserve(size_t bytes) {
+  size_t missing = 0;
+  {
+    std::lock_guard<turi::mutex> guard(m_lock);
+    if (try_reserve_locked(bytes)) return true;
+    missing = m_reserved + bytes - limit();
+  }
+  spill(missing);
+  std::lock_guard<turi::mutex> guard(m_lock);
+  return try_reserve_locked(bytes);
+}
+
+size_t memory_budget::reserve_up_to(size_t max_bytes, size_t min_bytes) {
+  min_bytes = std::min(min_bytes, max_bytes);
+  size_t missing = 0;
+  {
+    std::lock_guard<turi::mutex> guard(m_lock);
+    size_t free_bytes = available_locked();
+    if (free_bytes >= max_bytes) {
+      m_reserved += max_bytes;
+      return max_bytes;
+    }
+    missing = max_bytes - free_bytes;
+  }
+  // Memory held by the spillable subsystems (mostly cache blocks) can be
+  // written out: make room for all of max_bytes before settling for less.
+  spill(missing);
+  timer ti;
+  std::unique_lock<turi::mutex> guard(m_lock);
+  while (true) {
+    size_t free_bytes = available_locked();
+    if (free_bytes >= min_bytes) {
+      size_t bytes = std::min(max_bytes, free_bytes);
+      m_reserved += bytes;
+      return bytes;
+    }
+    // wait as reserve() for even min_bytes to fit
+    double waited_ms = ti.current_time_millis();
+    if (waited_ms >= FILEIO_MEMORY_BUDGET_WAIT_MS) {
+      ++FILEIO_MEMORY_BUDGET_OVERCOMMITS;
+      logstream(LOG_INFO) << "Reserving " << min_bytes << " bytes beyond the memory "
+                          << "budget of " << limit() << " bytes" << std::endl;
+      m_reserved += min_bytes;
+      return min_bytes;
+    }
+    m_released.timedwait_ms(m_lock, FILEIO_MEMORY_BUDGET_WAIT_MS - (size_t)waited_ms);
+  }
+}
+
+void memory_budget::reserve(size_t bytes) {
+  if (try_reserve(bytes)) return;
+  timer ti;
+  std::unique_lock<turi::mutex> guard(m_lock);
+  while (!try_reserve_locked(bytes)) {
+    double waited_ms = ti.current_time_millis();
+    if (waited_ms >= FILEIO_MEMORY_BUDGET_WAIT_MS) {
+      ++FILEIO_MEMORY_BUDGET_OVERCOMMITS;
+      logstream(LOG_INFO) << "Reserving " << bytes << " bytes beyond the memory "
+                          << "budget of " << limit() << " bytes" << std::endl;
+      m_reserved += bytes;
+      return;
+    }
+    m_released.timedwait_ms(m_lock, FILEIO_MEMORY_BUDGET_WAIT_MS - (size_t)waited_ms);
+  }
+}
+
+void memory_budget::force_reserve(size_t bytes) {
+  std::lock_guard<turi::mutex> guard(m_lock);
+  m_reserved += bytes;
+}
+
+void memory_budget::release(size_t bytes) {
+  std::lock_guard<turi::mutex> guard(m_lock);
+  DASSERT_LE(bytes, m_reserved);
+  m_reserved -= std::min(bytes, m_reserved);
+  m_released.broadcast();
+}
+
+size_t memory_budget::register_spill_callback(spill_callback_type callback) {
+  std::lock_guard<turi::mutex> guard(m_spill_lock);
+  size_t id = m_next_callback_id++;
+  m_spill_callbacks[id] = std::move(callback);
+  return id;
+}
+
+void memory_budget::unregister_spill_callback(size_t id) {
+  std::lock_guard<turi::mutex> guard(m_spill_lock);
+  m_spill_callbacks.erase(id);
+}
+
+void memory_budget::spill(size_t bytes) {
+  // whoever is spilling already is making room for everyone
+  if (!m_spill_lock.try_lock()) return;
+  std::lock_guard<turi::mutex> guard(m_spill_lock, std::adopt_lock);
+  size_t freed = 0;
+  for (auto& callback : m_spill_callbacks) {
+    if (freed >= bytes) break;
+    freed += callback.second(bytes - freed);
+  }
+}
+
+} // namespace fileio
+} // namespace turi
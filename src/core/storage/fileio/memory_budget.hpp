@@ -0,0 +1,215 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_FILEIO_MEMORY_BUDGET_HPP
+#define TURI_FILEIO_MEMORY_BUDGET_HPP
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <core/parallel/pthread_tools.hpp>
+
+namespace turi {
+namespace fileio {
+
+/**
+ * \ingroup fileio
+ *
+ * The one memory budget shared by everything which can hold large amounts
+ * of data in memory and put it on disk instead: the fixed_size_cache_manager,
+ * and the buffers of sorts, joins and groupbys.
+ *
+ * Every such subsystem reserves the bytes it is about to hold from the
+ * budget, and releases them when done. The total is bounded by
+ * FILEIO_MEMORY_BUDGET, which defaults to the memory the process is tuned for
+ * at startup. A budget of 0 does not limit anything, but still counts the
+ * reserved bytes.
+ *
+ * Spilling
+ * --------
+ * Subsystems holding memory which they can write to disk at any time (for
+ * instance, cache blocks no one is reading) register a spill callback. When a
+ * reservation does not fit, the callbacks are asked to free the missing
+ * bytes before it fails. Spill callbacks must release what they free with
+ * \ref release(), and must not reserve from the budget themselves. Only one
+ * thread spills at a time.
+ *
+ * Back-pressure
+ * -------------
+ * Subsystems which can size their buffers to what is free use
+ * \ref try_reserve() or \ref reserve_up_to(). Those which need a fixed amount
+ * to make progress use \ref reserve(), which waits up to
+ * FILEIO_MEMORY_BUDGET_WAIT_MS for other reservations to be released, and then
+ * goes over the budget rather than deadlocking. Those overcommits are counted
+ * in FILEIO_MEMORY_BUDGET_OVERCOMMITS.
+ *
+ * \ref memory_reservation holds a reservation for the lifetime of an object.
+ *
+ * All functions are thread safe.
+ */
+class memory_budget {
+ public:
+  /**
+   * A spill callback: asked to free at least the given number of bytes, and
+   * returns the number of bytes it released.
+   */
+  typedef std::function<size_t(size_t)> spill_callback_type;
+
+  static memory_budget& get_instance();
+
+  /// The budget in bytes, or 0 if unlimited.
+  size_t limit() const;
+
+  /// The number of bytes currently reserved.
+  size_t reserved() const;
+
+  /// The number of bytes which can still be reserved, (size_t)(-1) if unlimited.
+  size_t available() const;
+
+  /**
+   * Reserves bytes if they fit in the budget, spilling to make room if
+   * needed. Returns false, reserving nothing, if they do not fit.
+   */
+  bool try_reserve(size_t bytes);
+
+  /**
+   * Reserves between min_bytes and max_bytes, as much as fits after spilling
+   * to make room for max_bytes. Waits as \ref reserve() if even min_bytes
+   * does not fit. Returns the number of bytes reserved.
+   */
+  size_t reserve_up_to(size_t max_bytes, size_t min_bytes);
+
+  /**
+   * Reserves bytes, waiting for them to fit for up to
+   * FILEIO_MEMORY_BUDGET_WAIT_MS, and going over the budget after that.
+   */
+  void reserve(size_t bytes);
+
+  /**
+   * Counts bytes as reserved without checking the budget. For memory which
+   * is allocated whatever the budget, or allocated under a lock a spill
+   * callback needs.
+   */
+  void force_reserve(size_t bytes);
+
+  /// Returns reserved bytes to the budget.
+  void release(size_t bytes);
+
+  /**
+   * Registers a spill callback, returning an id for \ref
+   * unregister_spill_callback().
+   */
+  size_t register_spill_callback(spill_callback_type callback);
+
+  /**
+   * Unregisters a spill callback, waiting for it to return if it is
+   * running. Must not be called from a spill callback.
+   */
+  void unregister_spill_callback(size_t id);
+
+ private:
+  memory_budget() = default;
+  memory_budget(const memory_budget&) = delete;
+  memory_budget& operator=(const memory_budget&) = delete;
+
+  /// available(). m_lock must be held.
+  size_t available_locked() const;
+
+  /// Reserves bytes if they fit. m_lock must be held.
+  bool try_reserve_locked(size_t bytes);
+
+  /**
+   * Asks the spill callbacks to free bytes. Returns immediately if another
+   * thread is spilling.
+   */
+  void spill(size_t bytes);
+
+  mutable turi::mutex m_lock;
+  turi::conditional m_released;
+  size_t m_reserved = 0;
+
+  turi::mutex m_spill_lock;
+  size_t m_next_callback_id = 0;
+  std::map<size_t, spill_callback_type> m_spill_callbacks;
+};
+
+
+/**
+ * \ingroup fileio
+ *
+ * Bytes reserved from the \ref memory_budget, released when the reservation
+ * is destroyed.
+ *
+ * \code
+ * memory_reservation buffer_memory;
+ * size_t buffer_bytes = buffer_memory.reserve_up_to(wanted_bytes, wanted_bytes / 16);
+ * \endcode
+ */
+class memory_reservation {
+ public:
+  memory_reservation() = default;
+  memory_reservation(const memory_reservation&) = delete;
+  memory_reservation& operator=(const memory_reservation&) = delete;
+
+  inline memory_reservation(memory_reservation&& other) : m_bytes(other.m_bytes) {
+    other.m_bytes = 0;
+  }
+
+  inline memory_reservation& operator=(memory_reservation&& other) {
+    if (this != &other) {
+      release();
+      m_bytes = other.m_bytes;
+      other.m_bytes = 0;
+    }
+    return *this;
+  }
+
+  inline ~memory_reservation() { release(); }
+
+  /// The number of bytes held.
+  inline size_t size() const { return m_bytes; }
+
+  /// Grows the reservation by bytes if they fit. See \ref memory_budget::try_reserve().
+  inline bool try_grow(size_t bytes) {
+    if (!memory_budget::get_instance().try_reserve(bytes)) return false;
+    m_bytes += bytes;
+    return true;
+  }
+
+  /// Grows the reservation by bytes. See \ref memory_budget::reserve().
+  inline void grow(size_t bytes) {
+    memory_budget::get_instance().reserve(bytes);
+    m_bytes += bytes;
+  }
+
+  /**
+   * Grows the reservation by between min_bytes and max_bytes. Returns the
+   * number of bytes added. See \ref memory_budget::reserve_up_to().
+   */
+  inline size_t reserve_up_to(size_t max_bytes, size_t min_bytes) {
+    size_t bytes = memory_budget::get_instance().reserve_up_to(max_bytes, min_bytes);
+    m_bytes += bytes;
+    return bytes;
+  }
+
+  /// Returns bytes of the reservation to the budget.
+  inline void shrink(size_t bytes) {
+    bytes = std::min(bytes, m_bytes);
+    if (bytes == 0) return;
+    memory_budget::get_instance().release(bytes);
+    m_bytes -= bytes;
+  }
+
+  /// Returns the whole reservation to the budget.
+  inline void release() { shrink(m_bytes); }
+
+ private:
+  size_t m_bytes = 0;
+};
+
+} // namespace fileio
+} // namespace turi
+#endif
@@ -7,6 +7,9 @@
 #define TURI_FILEIO_CACHING_DEVICE_HPP
 #include <core/logging/logger.hpp>
 #include <core/storage/fileio/block_cache.hpp>
+#include <core/storage/fileio/fileio_constants.hpp>
+#include <core/storage/fileio/fs_utils.hpp>
+#include <core/storage/fileio/local_disk_cache.hpp>
 #include <core/storage/fileio/sanitize_url.hpp>
 #include <core/parallel/mutex.hpp>
 #include <core/util/basic_types.hpp>
@@ -37,6 +40,11 @@ const size_t READ_CACHING_BLOCK_SIZE = 64*1024*1024; // 64 MB
  * \endcode
  *
  * It uses the \ref block_cache to pro
+ *
+ * When FILEIO_LOCAL_DISK_CACHE_DIRECTORY is set, blocks missing from the
+ * block_cache are next looked up in the \ref local_disk_cache, and blocks
+ * read from the remote file are kept there, so that other processes on the
+ * host reading the same (unmodified) file find them on local disk.
  */
 template <typename T>
 class read_caching_device {
@@ -86,6 +94,7 @@ class read_caching_device {
       {
         std::lock_guard<mutex> file_size_guard(m_filesize_cache_mutex);
         m_filename_to_filesize_map.erase(m_filename);
+        m_filename_to_version_map.erase(m_filename);
       }
 
     } else if (mode == std::ios_base::in && !m_writing) {
@@ -178,6 +187,9 @@ class read_caching_device {
 
   static mutex m_filesize_cache_mutex;
   static std::map<std::string, size_t> m_filename_to_filesize_map;
+  /// The \ref get_remote_file_version() of every file, guarded by
+  /// m_filesize_cache_mutex
+  static std::map<std::string, std::string> m_filename_to_version_map;
 
   std::shared_ptr<T>& get_contents() {
     if (!m_contents) {
@@ -189,6 +201,29 @@ class read_caching_device {
     // we generate a key name that will never appear in any filename
     return  m_filename + "////:" + std::to_string(block_number);
   }
+  /**
+   * The \ref local_disk_cache key of a block, which identifies the contents
+   * of the file. Empty if the file cannot be cached across processes.
+   */
+  std::string get_disk_cache_key_name(size_t block_number) {
+    std::string version;
+    {
+      std::lock_guard<mutex> file_size_guard(m_filesize_cache_mutex);
+      auto iter = m_filename_to_version_map.find(m_filename);
+      if (iter != m_filename_to_version_map.end()) version = iter->second;
+    }
+    if (version.empty()) {
+      version = get_remote_file_version(m_filename);
+      if (version.empty()) return "";
+      std::lock_guard<mutex> file_size_guard(m_filesize_cache_mutex);
+      m_filename_to_version_map[m_filename] = version;
+    }
+    // credentials in the URL do not change the contents
+    return sanitize_url(m_filename) + "////:" + version + ":" +
+           std::to_string(m_file_size) + ":" +
+           std::to_string(READ_CACHING_BLOCK_SIZE) + ":" +
+           std::to_string(block_number);
+  }
   /**
    * Fetches the contents of a block.
    * Returns true on success and false on failure.
@@ -202,15 +237,32 @@ class read_caching_device {
     int64_t ret = bc.read(key, output, startpos, startpos + length);
     if (static_cast<size_t>(ret) == length) return true;
 
-    logstream(LOG_INFO) << "Fetching " << sanitize_url(m_filename) << " Block " << block_number << std::endl;
-    // ok. failure... no such block or block is bad. We read it ourselves.
-    // read the whole block
+    // ok. failure... no such block or block is bad.
     auto block_start = block_number * READ_CACHING_BLOCK_SIZE;
     auto block_end = std::min(block_start +  READ_CACHING_BLOCK_SIZE, m_file_size);
+    auto protocol = fileio::get_protocol(m_filename);
+    bool is_remote = !(protocol == "" || protocol == "file");
+    // Blocks of remote files are more expensive to get back.
+    size_t refetch_cost = is_remote ? fileio::FILEIO_BLOCK_CACHE_REMOTE_REFETCH_COST : 1;
+    std::string block_contents;
+
+    // see if this or another process kept the block on local disk
+    auto disk_cache = is_remote ? local_disk_cache::get_instance() : nullptr;
+    std::string disk_key;
+    if (disk_cache) disk_key = get_disk_cache_key_name(block_number);
+    if (!disk_key.empty() && disk_cache->read(disk_key, block_contents) &&
+        block_contents.size() == block_end - block_start) {
+      bc.write(key, block_contents, refetch_cost);
+      memcpy(output, block_contents.c_str() + startpos, length);
+      return true;
+    }
+
+    // We read it ourselves.
+    logstream(LOG_INFO) << "Fetching " << sanitize_url(m_filename) << " Block " << block_number << std::endl;
     // seek to the block and read the whole block at once
     auto& contents = get_contents();
     contents->seek(block_start, std::ios_base::beg, std::ios_base::in);
-    std::string block_contents(block_end - block_start, 0);
+    block_contents.assign(block_end - block_start, 0);
     auto bytes_read = contents->read(&(block_contents[0]),
                                      block_end - block_start);
     // read failed.
@@ -220,8 +272,9 @@ class read_caching_device {
       return false;
     }
 
-    // write the block
-    bool write_block_ok = bc.write(key, block_contents);
+    if (!disk_key.empty()) disk_cache->write(disk_key, block_contents);
+    // write the block.
+    bool write_block_ok = bc.write(key, block_contents, refetch_cost);
     if (write_block_ok == false) {
       logstream(LOG_ERROR) << "Unable to write block " << key << std::endl;
       // still ok. we can continue. but too many of these are bad.
@@ -239,5 +292,8 @@ mutex read_caching_device<T>::m_filesize_cache_mutex;
 
 template<typename T>
 std::map<std::string, size_t> read_caching_device<T>::m_filename_to_filesize_map;
+
+template<typename T>
+std::map<std::string, std::string> read_caching_device<T>::m_filename_to_version_map;
 } // namespace turi
 #endif
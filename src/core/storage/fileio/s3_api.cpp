@@ -15,6 +15,7 @@
 #include <string>
 #include <thread>
 #include <future>
+#include <mutex>
 #include <regex>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/split.hpp>
@@ -124,6 +125,19 @@ std::string string_from_s3url(const s3url& parsed_url) {
   return ret;
 }
 
+/**
+ * Initializes the AWS SDK on first use. It stays initialized until the
+ * process exits, instead of being set up and torn down around every call.
+ */
+void init_aws_sdk() {
+  static std::once_flag initialized;
+  std::call_once(initialized, []() {
+    Aws::SDKOptions options;
+    options.loggingOptions.logLevel = Aws::Utils::Logging::LogLevel::Info;
+    Aws::InitAPI(options);
+  });
+}
+
 } // anonymous namespace
 
 const std::vector<std::string> S3Operation::_enum_to_str = {
@@ -310,10 +324,7 @@ list_objects_response list_objects_impl(s3url parsed_url,
                                         std::string proxy,
                                         std::string endpoint)
 {
-    // initialization
-    Aws::SDKOptions options;
-    options.loggingOptions.logLevel = Aws::Utils::Logging::LogLevel::Info;
-    Aws::InitAPI(options);
+    init_aws_sdk();
 
     // credentials
     Aws::Auth::AWSCredentials credentials(parsed_url.access_key_id.c_str(), parsed_url.secret_key.c_str());
@@ -396,7 +407,6 @@ list_objects_response list_objects_impl(s3url parsed_url,
 
     } while (moreResults);
 
-    Aws::ShutdownAPI(options);
     for (auto& dir : ret.directories) {
       s3url dirurl = parsed_url;
       dirurl.object_name = dir;
@@ -416,10 +426,7 @@ std::string delete_object_impl(s3url parsed_url,
                                std::string endpoint) {
     std::string ret;
 
-    // initialization
-    Aws::SDKOptions options;
-    options.loggingOptions.logLevel = Aws::Utils::Logging::LogLevel::Info;
-    Aws::InitAPI(options);
+    init_aws_sdk();
 
     // credentials
     Aws::Auth::AWSCredentials credentials(parsed_url.access_key_id.c_str(), parsed_url.secret_key.c_str());
@@ -457,7 +464,6 @@ std::string delete_object_impl(s3url parsed_url,
       ret = ss.str();
     }
 
-    Aws::ShutdownAPI(options);
     return ret;
 }
 
@@ -470,10 +476,7 @@ std::string delete_prefix_impl(s3url parsed_url,
 
     std::string ret;
 
-    // initialization
-    Aws::SDKOptions options;
-    options.loggingOptions.logLevel = Aws::Utils::Logging::LogLevel::Info;
-    Aws::InitAPI(options);
+    init_aws_sdk();
 
     // credentials
     Aws::Auth::AWSCredentials credentials(parsed_url.access_key_id.c_str(), parsed_url.secret_key.c_str());
@@ -558,7 +561,6 @@ std::string delete_prefix_impl(s3url parsed_url,
         }
     }
 
-    Aws::ShutdownAPI(options);
     return ret;
 }
 
@@ -3,9 +3,13 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <deque>
 #include <fstream>
+#include <future>
 #include <core/logging/assertions.hpp>
+#include <core/storage/fileio/fileio_constants.hpp>
 #include <core/storage/fileio/s3_fstream.hpp>
+#include <core/globals/metrics.hpp>
 #include <core/logging/logger.hpp>
 #include <core/storage/fileio/sanitize_url.hpp>
 #include <core/storage/fileio/s3_api.hpp>
@@ -32,6 +36,7 @@ s3_device::s3_device(const std::string& filename, const bool write) {
   } else {
     url_without_credentials = "s3://" + url.endpoint + "/" + url.bucket + "/" + url.object_name;
   }
+  m_url_without_credentials = url_without_credentials;
   auto uri = dmlc::io::URI(url_without_credentials.c_str());
   if (write) {
     m_write_stream.reset(m_s3fs->Open(uri, "w"));
@@ -62,7 +67,70 @@ void s3_device::close(std::ios_base::openmode mode) {
 
 
 std::streamsize s3_device::read(char* strm_ptr, std::streamsize n) {
-  return m_read_stream->Read((void*)strm_ptr, n);
+  static metrics::counter& s3_bytes_read = metrics::get_counter(
+      "s3_bytes_read", "Bytes read from S3 objects.");
+  std::streamsize ret;
+  // large reads (such as the blocks fetched by read_caching_device) are
+  // split into concurrent ranged GETs
+  if (fileio::FILEIO_S3_DOWNLOAD_THREADS > 1 &&
+      (size_t)n >= 2 * fileio::FILEIO_S3_DOWNLOAD_RANGE_SIZE) {
+    ret = parallel_read(strm_ptr, n);
+  } else {
+    ret = m_read_stream->Read((void*)strm_ptr, n);
+  }
+  if (ret > 0) s3_bytes_read += ret;
+  return ret;
+}
+
+std::streamsize s3_device::parallel_read(char* strm_ptr, std::streamsize n) {
+  size_t begin = m_read_stream->Tell();
+  size_t end = std::min<size_t>(begin + n, m_filesize);
+  if (end <= begin) return 0;
+  const size_t range_size = fileio::FILEIO_S3_DOWNLOAD_RANGE_SIZE;
+  const size_t max_in_flight = fileio::FILEIO_S3_DOWNLOAD_THREADS;
+  auto s3fs = m_s3fs;
+  auto url = m_url_without_credentials;
+  auto read_range = [s3fs, url](size_t range_begin, size_t range_end,
+                                char* out) -> size_t {
+    dmlc::io::URI uri(url.c_str());
+    std::unique_ptr<dmlc::SeekStream> strm(
+        s3fs->OpenRangeForRead(uri, range_begin, range_end));
+    size_t length = range_end - range_begin;
+    size_t nread = 0;
+    while (nread < length) {
+      size_t ret = strm->Read(out + nread, length - nread);
+      if (ret == 0) break;
+      nread += ret;
+    }
+    return nread;
+  };
+
+  // bytes read contiguously from begin. A short range ends the read there.
+  size_t bytes_read = 0;
+  bool short_read = false;
+  std::deque<std::pair<size_t, std::future<size_t> > > pending;
+  auto wait_for_range = [&]() {
+    size_t expected = pending.front().first;
+    size_t nread = pending.front().second.get();
+    pending.pop_front();
+    if (short_read) return;
+    bytes_read += nread;
+    if (nread < expected) short_read = true;
+  };
+  // destroying the pending futures waits for them, so an exception never
+  // leaves a range writing into strm_ptr
+  for (size_t range_begin = begin; range_begin < end && !short_read;
+       range_begin += range_size) {
+    size_t range_end = std::min(range_begin + range_size, end);
+    pending.emplace_back(range_end - range_begin,
+                         std::async(std::launch::async, read_range,
+                                    range_begin, range_end,
+                                    strm_ptr + (range_begin - begin)));
+    while (pending.size() >= max_in_flight) wait_for_range();
+  }
+  while (!pending.empty()) wait_for_range();
+  m_read_stream->Seek(begin + bytes_read);
+  return bytes_read;
 }
 
 std::streamsize s3_device::write(const char* strm_ptr, std::streamsize n) {
@@ -38,6 +38,16 @@ class s3_device {
   std::shared_ptr<dmlc::Stream> m_write_stream;
   std::shared_ptr<dmlc::SeekStream> m_read_stream;
   size_t m_filesize = (size_t)(-1);
+  /// s3://[endpoint/]bucket/object, used to open ranged reads
+  std::string m_url_without_credentials;
+
+  /**
+   * Reads n bytes from the current position by splitting the read into
+   * FILEIO_S3_DOWNLOAD_RANGE_SIZE ranged GETs, up to
+   * FILEIO_S3_DOWNLOAD_THREADS of them in flight at once.
+   * The read stream is then positioned after the bytes read.
+   */
+  std::streamsize parallel_read(char* strm_ptr, std::streamsize n);
  public:
   s3_device() { }
 
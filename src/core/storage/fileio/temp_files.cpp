@@ -305,11 +305,42 @@ EXPORT void reap_unused_temp_files() {
 }
 
 
+/**
+ * Picks the temp directory of the next temp file. The directories are used
+ * in turn, so that the temp files (and their I/O) are striped over all of
+ * them. Directories with less than FILEIO_TEMP_DIRECTORY_MIN_FREE_BYTES
+ * available are skipped; if all of them are that full, the one with the most
+ * space available is used.
+ */
+static size_t choose_temp_directory(size_t counter) {
+  auto temp_dirs = get_temp_directories();
+  size_t num_dirs = temp_dirs.size();
+  if (num_dirs <= 1 || fileio::FILEIO_TEMP_DIRECTORY_MIN_FREE_BYTES == 0) {
+    return counter;
+  }
+  size_t best = counter;
+  uintmax_t best_available = 0;
+  for (size_t i = 0; i < num_dirs; ++i) {
+    size_t idx = counter + i;
+    boost::system::error_code ec;
+    auto space = fs::space(temp_dirs[idx % num_dirs], ec);
+    // a directory whose space cannot be queried is left to fail when used
+    if (ec) return idx;
+    if (space.available >= fileio::FILEIO_TEMP_DIRECTORY_MIN_FREE_BYTES) return idx;
+    if (space.available > best_available) {
+      best = idx;
+      best_available = space.available;
+    }
+  }
+  return best;
+}
+
 EXPORT std::string get_temp_name(const std::string& prefix, bool _prefer_hdfs) {
   std::lock_guard<mutex> lg(get_temp_info().lock);
 
   // Local system temp dir
-  fs::path path(get_current_process_temp_directory(get_temp_info().temp_file_counter++));
+  fs::path path(get_current_process_temp_directory(
+      choose_temp_directory(get_temp_info().temp_file_counter++)));
 
 #ifndef TC_DISABLE_REMOTEFS
   // hdfs temp dir
@@ -15,11 +15,17 @@
 #include <core/storage/sframe_data/group_aggregate_value.hpp>
 #include <core/storage/sframe_data/groupby_aggregate_impl.hpp>
 #include <core/storage/sframe_data/sframe_config.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
 #include <core/storage/sframe_data/groupby_aggregate.hpp>
+#include <core/storage/fileio/memory_budget.hpp>
+#include <core/globals/memory_accounting.hpp>
 
 namespace turi {
 namespace query_eval {
 
+/// Bytes of memory assumed for every value of a group in the groupby buffer.
+static constexpr size_t GROUPBY_CELL_SIZE_ESTIMATE = 64;
+
 std::shared_ptr<sframe>
     groupby_aggregate(
       const std::shared_ptr<planner_node>& source,
@@ -27,7 +33,8 @@ std::shared_ptr<sframe>
       const std::vector<std::string>& keys,
       const std::vector<std::string>& output_column_names,
       const std::vector<std::pair<std::vector<std::string>,
-                                  std::shared_ptr<group_aggregate_value>>>& groups) {
+                                  std::shared_ptr<group_aggregate_value>>>& groups,
+      bool keys_are_sorted) {
   // first, sanity checks
   // check that group keys exist
   if (output_column_names.size() != groups.size()) {
@@ -174,47 +181,111 @@ std::shared_ptr<sframe>
     column_types.push_back(output_type);
   }
 
-  size_t nsegments = thread::cpu_count() * std::max<size_t>(1, log2(thread::cpu_count()));
-
-  output->open_for_write(column_names,
-                         column_types,
-                         "",
-                         nsegments);
-
-
-  groupby_aggregate_impl::group_aggregate_container
-      container(SFRAME_GROUPBY_BUFFER_NUM_ROWS, nsegments);
-
   // ok the input sframe (frame_with_relevant_cols) contains all the values
   // we care about. However, the challenge here is to figure out how the keys
   // and values line up. By construction, all the key columns come first.
   // which is good. But group columns can be pretty much anywhere.
   size_t num_keys = keys.size();
+  std::vector<std::vector<size_t>> group_column_numbers;
   for (const auto& group: groups) {
     std::vector<size_t> column_numbers;
     for(auto& col_name : group.first) {
       column_numbers.push_back(relevant_column_to_index.at(col_name));
     }
+    group_column_numbers.push_back(column_numbers);
+  }
 
-    container.define_group(column_numbers, group.second);
+  size_t num_input_segments = thread::cpu_count();
+  if (keys_are_sorted) {
+    // every group is a run of rows: aggregate each input segment in order
+    // into the same output segment, with no hash table.
+    output->open_for_write(column_names, column_types, "", num_input_segments);
+    groupby_aggregate_impl::sorted_group_aggregator aggregator(*output,
+                                                               num_input_segments);
+    for (size_t i = 0;i < groups.size(); ++i) {
+      aggregator.define_group(group_column_numbers[i], groups[i].second);
+    }
+    logstream(LOG_INFO) << "Aggregating sorted groups: " << std::endl;
+    timer ti;
+    planner().materialize(frame_with_relevant_cols,
+                          [&](size_t segmentid,
+                              const std::shared_ptr<sframe_rows>& rows)->bool {
+                            if (rows == nullptr) return true;
+                            for (auto& row: *rows) {
+                              aggregator.add(row, num_keys, segmentid);
+                            }
+                            return false;
+                          },
+                          num_input_segments);
+    aggregator.write_boundary_groups();
+    logstream(LOG_INFO) << "Sorted groups aggregated in " << ti.current_time() << std::endl;
+    output->close();
+    return output;
+  }
+
+  size_t nsegments = thread::cpu_count() * std::max<size_t>(1, log2(thread::cpu_count()));
+
+  output->open_for_write(column_names,
+                         column_types,
+                         "",
+                         nsegments);
+
+
+  // the buffer shares the memory budget with the caches and other
+  // operators: take what is free, down to a sixteenth of the configured
+  // size. There cannot be more groups than input rows.
+  size_t buffer_num_rows = SFRAME_GROUPBY_BUFFER_NUM_ROWS;
+  int64_t num_input_rows = infer_planner_node_length(frame_with_relevant_cols);
+  if (num_input_rows >= 0) {
+    buffer_num_rows = std::min<size_t>(buffer_num_rows, std::max<int64_t>(num_input_rows, 1));
+  }
+  size_t row_bytes = GROUPBY_CELL_SIZE_ESTIMATE * column_names.size();
+  fileio::memory_reservation buffer_memory;
+  buffer_num_rows = buffer_memory.reserve_up_to(buffer_num_rows * row_bytes,
+                                                buffer_num_rows * row_bytes / 16) / row_bytes;
+  buffer_num_rows = std::max<size_t>(buffer_num_rows, 1);
+  memory_accounting::tagged_memory buffer_tagged_memory(
+      memory_accounting::get_tag("groupby_buffers"));
+  buffer_tagged_memory.set(buffer_num_rows * row_bytes);
+
+  groupby_aggregate_impl::group_aggregate_container
+      container(buffer_num_rows, nsegments);
+
+  for (size_t i = 0;i < groups.size(); ++i) {
+    container.define_group(group_column_numbers[i], groups[i].second);
   }
   // done. now we can begin parallel processing
 
   // shuffle the rows based on the value of the key column.
   logstream(LOG_INFO) << "Filling group container: " << std::endl;
   timer ti;
-  planner().materialize(frame_with_relevant_cols,
-                        [&](size_t segmentid,
-                            const std::shared_ptr<sframe_rows>& rows)->bool {
-                          container.init_tls();
-                          if (rows == nullptr) return true;
-                          for (auto& row: *rows) {
-                            container.add(row, num_keys);
-                          }
-                          container.flush_tls();
-                          return false;
-                        },
-                        thread::cpu_count());
+  if (SFRAME_GROUPBY_LOCAL_TABLE_SIZE > 0) {
+    // each input segment is written by one thread at a time
+    container.init_streams(num_input_segments);
+    planner().materialize(frame_with_relevant_cols,
+                          [&](size_t segmentid,
+                              const std::shared_ptr<sframe_rows>& rows)->bool {
+                            if (rows == nullptr) return true;
+                            for (auto& row: *rows) {
+                              container.add_to_stream(row, num_keys, segmentid);
+                            }
+                            return false;
+                          },
+                          num_input_segments);
+  } else {
+    planner().materialize(frame_with_relevant_cols,
+                          [&](size_t segmentid,
+                              const std::shared_ptr<sframe_rows>& rows)->bool {
+                            container.init_tls();
+                            if (rows == nullptr) return true;
+                            for (auto& row: *rows) {
+                              container.add(row, num_keys);
+                            }
+                            container.flush_tls();
+                            return false;
+                          },
+                          num_input_segments);
+  }
 
   logstream(LOG_INFO) << "Group container filled in " << ti.current_time() << std::endl;
   logstream(LOG_INFO) << "Writing output: " << std::endl;
@@ -40,7 +40,11 @@ struct planner_node;
  *               for each set of columns. You do not need every column in the source
  *               to be represented. This must be the same length as the
  *               'group_output_columns' parameter.
-
+ * \param keys_are_sorted If true, all the rows of every group must be
+ *               contiguous in source (for instance, source is sorted on the
+ *               keys). The groups are then aggregated in a single streaming
+ *               pass, holding one group per thread, without a hash table or
+ *               spilling to disk, and the output is in the order of source.
  */
 std::shared_ptr<sframe> groupby_aggregate(
       const std::shared_ptr<planner_node>& source,
@@ -48,7 +52,8 @@ std::shared_ptr<sframe> groupby_aggregate(
       const std::vector<std::string>& keys,
       const std::vector<std::string>& output_column_names,
       const std::vector<std::pair<std::vector<std::string>,
-                                  std::shared_ptr<group_aggregate_value>>>& groups);
+                                  std::shared_ptr<group_aggregate_value>>>& groups,
+      bool keys_are_sorted = false);
 
 /// \}
 } // namespace query_eval
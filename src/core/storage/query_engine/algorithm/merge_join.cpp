@@ -0,0 +1,74 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <boost/algorithm/string.hpp>
+#include <core/logging/logger.hpp>
+#include <core/storage/query_engine/algorithm/merge_join.hpp>
+#include <core/storage/query_engine/operators/merge_join.hpp>
+#include <core/storage/query_engine/operators/operator_properties.hpp>
+#include <core/storage/query_engine/operators/sframe_source.hpp>
+#include <core/storage/query_engine/planning/planner.hpp>
+#include <core/storage/sframe_data/join.hpp>
+
+namespace turi {
+namespace query_eval {
+
+bool can_merge_join(const sframe& sf_left,
+                    const sframe& sf_right,
+                    const std::map<std::string, std::string>& join_columns) {
+  if (join_columns.empty()) return false;
+  std::vector<size_t> left_keys, right_keys;
+  for (const auto& col_pair: join_columns) {
+    if (!sf_left.contains_column(col_pair.first) ||
+        !sf_right.contains_column(col_pair.second)) {
+      return false;
+    }
+    left_keys.push_back(sf_left.column_index(col_pair.first));
+    right_keys.push_back(sf_right.column_index(col_pair.second));
+    if (sf_left.column_type(left_keys.back()) !=
+        sf_right.column_type(right_keys.back())) {
+      return false;
+    }
+  }
+  return is_sorted_by(op_sframe_source::make_planner_node(sf_left), left_keys) &&
+      is_sorted_by(op_sframe_source::make_planner_node(sf_right), right_keys);
+}
+
+sframe join(sframe& sf_left,
+            sframe& sf_right,
+            std::string join_type,
+            const std::map<std::string, std::string>& join_columns,
+            const std::map<std::string, std::string>& alternative_names,
+            size_t max_buffer_size) {
+  if (!can_merge_join(sf_left, sf_right, join_columns)) {
+    return turi::join(sf_left, sf_right, join_type, join_columns,
+                      alternative_names, max_buffer_size);
+  }
+  // validates the join type
+  join_impl::join_type_from_string(join_type);
+  boost::algorithm::to_lower(join_type);
+
+  std::vector<size_t> left_keys, right_keys;
+  for (const auto& col_pair: join_columns) {
+    left_keys.push_back(sf_left.column_index(col_pair.first));
+    right_keys.push_back(sf_right.column_index(col_pair.second));
+  }
+
+  materialize_options exec_params;
+  std::vector<flex_type_enum> column_types;
+  join_impl::join_output_columns(sf_left, sf_right, right_keys, alternative_names,
+                                 exec_params.output_column_names, column_types);
+
+  logstream(LOG_INFO) << "Both sides are sorted by the join keys. Merge joining"
+                      << std::endl;
+  auto node = op_merge_join::make_planner_node(
+      op_sframe_source::make_planner_node(sf_left),
+      op_sframe_source::make_planner_node(sf_right),
+      left_keys, right_keys, join_type);
+  return planner().materialize(node, exec_params);
+}
+
+} // namespace query_eval
+} // namespace turi
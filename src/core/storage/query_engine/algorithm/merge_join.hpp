@@ -0,0 +1,58 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_QUERY_ENGINE_MERGE_JOIN_HPP
+#define TURI_SFRAME_QUERY_ENGINE_MERGE_JOIN_HPP
+#include <map>
+#include <string>
+#include <core/storage/sframe_data/sframe.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
+
+namespace turi {
+namespace query_eval {
+
+/**
+ * \ingroup sframe_query_engine
+ * \addtogroup Algorithms Algorithms
+ * \{
+ */
+
+/**
+ * Returns true if a join of left and right on join_columns would be
+ * executed as a merge join: both frames are known to be sorted by their
+ * join columns (see \ref is_sorted_by()).
+ */
+bool can_merge_join(const sframe& sf_left,
+                    const sframe& sf_right,
+                    const std::map<std::string, std::string>& join_columns);
+
+/**
+ * Joins two SFrames. Identical to \ref turi::join, and the result has the
+ * same rows, though not necessarily in the same order.
+ *
+ * If both frames are sorted by their join columns, as the output of a sort is,
+ * the join is a single streaming pass over both frames with an
+ * \ref op_merge_join, which uses constant memory and builds no hash table.
+ * Otherwise this is a \ref turi::join.
+ *
+ * \param sf_left Left side of the join
+ * \param sf_right Right side of the join
+ * \param join_type Either "inner", "left", "right" or "outer"
+ * \param join_columns A map of columns to equijoin on.
+ * \param alternative_names Names for clashing columns of the right side.
+ * \param max_buffer_size The maximum number of cells to buffer in memory,
+ *                        for a hash join.
+ */
+sframe join(sframe& sf_left,
+            sframe& sf_right,
+            std::string join_type,
+            const std::map<std::string, std::string>& join_columns,
+            const std::map<std::string, std::string>& alternative_names,
+            size_t max_buffer_size = SFRAME_JOIN_BUFFER_NUM_CELLS);
+
+/// \}
+} // namespace query_eval
+} // namespace turi
+#endif
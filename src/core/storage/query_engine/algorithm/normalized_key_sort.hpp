@@ -0,0 +1,221 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_QUERY_EVAL_NORMALIZED_KEY_SORT_HPP
+#define TURI_QUERY_EVAL_NORMALIZED_KEY_SORT_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <vector>
+#include <core/logging/assertions.hpp>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/parallel/lambda_omp.hpp>
+
+namespace turi {
+namespace query_eval {
+
+/**
+ * \ingroup sframe_query_engine
+ * \addtogroup Algorithms Algorithms
+ * \{
+ */
+
+namespace normalized_key_sort_impl {
+
+/// Sorts smaller than this are not split across threads.
+static constexpr size_t PARALLEL_SORT_MIN_ROWS = 64 * 1024;
+
+/**
+ * \internal
+ * The sort keys of a row reduced to fixed width integers which compare in
+ * the same order as the keys, and the position of the row.
+ */
+struct normalized_key {
+  /// The normalized first and second sort keys
+  uint64_t prefix[2] = {0, 0};
+  /**
+   * True if prefix[0] identifies the value of the first key: two rows
+   * both with exact keys and the same prefix[0] have equal first keys.
+   */
+  bool first_exact = false;
+  size_t row = 0;
+};
+
+/**
+ * \internal
+ * Maps a value to an integer such that a < b implies normalized(a) <=
+ * normalized(b) in the order of \ref less_than_full_function, with UNDEFINED
+ * first. Strings keep their first 7 bytes and their length up to 8.
+ *
+ * column_type is the type of the other values of the column, which must all
+ * be the same, or UNDEFINED if none was seen so far. Returns false if the
+ * value cannot be normalized.
+ */
+inline bool normalize_value(const flexible_type& v,
+                            bool ascending,
+                            flex_type_enum& column_type,
+                            uint64_t& out,
+                            bool& exact) {
+  static constexpr uint64_t SIGN_BIT = uint64_t(1) << 63;
+  flex_type_enum type = v.get_type();
+  if (type != flex_type_enum::UNDEFINED) {
+    if (column_type == flex_type_enum::UNDEFINED) column_type = type;
+    else if (column_type != type) return false;
+  }
+  switch (type) {
+   case flex_type_enum::UNDEFINED:
+     out = 0;
+     break;
+   case flex_type_enum::INTEGER:
+     out = uint64_t(v.get<flex_int>()) ^ SIGN_BIT;
+     break;
+   case flex_type_enum::FLOAT: {
+     double d = v.get<flex_float>();
+     if (std::isnan(d)) return false;
+     // -0.0 == 0.0
+     if (d == 0) d = 0;
+     uint64_t bits;
+     std::memcpy(&bits, &d, sizeof(bits));
+     out = (bits & SIGN_BIT) ? ~bits : (bits | SIGN_BIT);
+     break;
+   }
+   case flex_type_enum::STRING: {
+     // strings compare as unsigned bytes. The length in the last byte
+     // orders a string before the same string followed by zeros.
+     const flex_string& s = v.get<flex_string>();
+     out = 0;
+     size_t len = std::min<size_t>(s.size(), 7);
+     for (size_t i = 0; i < len; ++i) {
+       out |= uint64_t((unsigned char)s[i]) << (56 - 8 * i);
+     }
+     out |= std::min<size_t>(s.size(), 8);
+     break;
+   }
+   case flex_type_enum::DATETIME:
+     // microseconds are left to the full comparison
+     out = uint64_t(v.get<flex_date_time>().posix_timestamp()) ^ SIGN_BIT;
+     break;
+   default:
+     return false;
+  }
+  // 0 is shared by UNDEFINED and the smallest value of every type.
+  exact = out != 0 &&
+      type != flex_type_enum::DATETIME &&
+      !(type == flex_type_enum::STRING && v.get<flex_string>().size() > 7);
+  if (!ascending) out = ~out;
+  return true;
+}
+
+/**
+ * \internal
+ * std::sort split over all threads: chunks are sorted in parallel, then
+ * merged pairwise in parallel. Small inputs are sorted in place.
+ *
+ * Unlike parallel_for, this also runs in parallel when called from a task of
+ * the thread pool, such as the sort of one of several partitions: its tasks
+ * do not depend on thread ids, and idle threads steal them.
+ */
+template <typename T, typename LessThan>
+void parallel_sort(std::vector<T>& v, LessThan less_than) {
+  thread_pool& pool = thread_pool::get_instance();
+  size_t num_chunks = pool.size();
+  if (v.size() < PARALLEL_SORT_MIN_ROWS || num_chunks <= 1) {
+    std::sort(v.begin(), v.end(), less_than);
+    return;
+  }
+  auto run_tasks = [&](size_t num_tasks, const std::function<void(size_t)>& fn) {
+    parallel_task_queue tasks(pool);
+    for (size_t i = 0; i < num_tasks; ++i) tasks.launch([&fn, i]() { fn(i); });
+    tasks.join();
+  };
+  std::vector<size_t> bounds(num_chunks + 1);
+  for (size_t i = 0; i <= num_chunks; ++i) bounds[i] = v.size() * i / num_chunks;
+
+  run_tasks(num_chunks, [&](size_t i) {
+    std::sort(v.begin() + bounds[i], v.begin() + bounds[i + 1], less_than);
+  });
+  for (size_t width = 1; width < num_chunks; width *= 2) {
+    run_tasks((num_chunks + 2 * width - 1) / (2 * width), [&](size_t j) {
+      size_t lo = 2 * width * j;
+      size_t mid = std::min(lo + width, num_chunks);
+      size_t hi = std::min(lo + 2 * width, num_chunks);
+      if (mid < hi) {
+        std::inplace_merge(v.begin() + bounds[lo], v.begin() + bounds[mid],
+                           v.begin() + bounds[hi], less_than);
+      }
+    });
+  }
+}
+
+} // namespace normalized_key_sort_impl
+
+/**
+ * Sorts rows by their keys, using all threads.
+ *
+ * Instead of calling flexible_type comparisons for every comparison, the
+ * first two keys of every row are normalized once into integers which
+ * compare in the same order: INTEGER, FLOAT, DATETIME and STRING (by its
+ * first bytes) keys are supported. The rows are then sorted by those, and
+ * less_than is only called to break ties between rows whose normalized keys
+ * cannot tell them apart, such as long strings with a common prefix.
+ *
+ * If a key column has another type, or mixes types, this falls back to a
+ * plain sort with less_than.
+ *
+ * \param rows The rows to sort
+ * \param sort_orders The order of each key, true is ascending
+ * \param key A function (const T& row, size_t i) returning the i-th key of a
+ *            row as a const flexible_type&
+ * \param less_than The complete comparison of two rows in the sort order,
+ *                  such as a \ref less_than_full_function on their keys.
+ */
+template <typename T, typename KeyFunction, typename LessThan>
+void normalized_key_sort(std::vector<T>& rows,
+                         const std::vector<bool>& sort_orders,
+                         KeyFunction key,
+                         LessThan less_than) {
+  using namespace normalized_key_sort_impl;
+  size_t num_keys = std::min<size_t>(sort_orders.size(), 2);
+  std::vector<normalized_key> keys(rows.size());
+  std::vector<flex_type_enum> column_types(num_keys, flex_type_enum::UNDEFINED);
+
+  bool normalized = true;
+  for (size_t i = 0; i < rows.size() && normalized; ++i) {
+    keys[i].row = i;
+    bool exact = false;
+    for (size_t k = 0; k < num_keys && normalized; ++k) {
+      normalized = normalize_value(key(rows[i], k), sort_orders[k],
+                                   column_types[k], keys[i].prefix[k],
+                                   k == 0 ? keys[i].first_exact : exact);
+    }
+  }
+  if (!normalized) {
+    parallel_sort(rows, less_than);
+    return;
+  }
+
+  parallel_sort(keys, [&](const normalized_key& a, const normalized_key& b) {
+    if (a.prefix[0] != b.prefix[0]) return a.prefix[0] < b.prefix[0];
+    if (a.first_exact && b.first_exact) {
+      if (num_keys == 1) return false;
+      if (a.prefix[1] != b.prefix[1]) return a.prefix[1] < b.prefix[1];
+    }
+    return less_than(rows[a.row], rows[b.row]);
+  });
+
+  std::vector<T> sorted_rows(rows.size());
+  parallel_for(0, rows.size(), [&](size_t i) {
+    sorted_rows[i] = std::move(rows[keys[i].row]);
+  });
+  rows.swap(sorted_rows);
+}
+
+/// \}
+} // namespace query_eval
+} // namespace turi
+
+#endif
@@ -19,7 +19,11 @@
 #include <core/storage/query_engine/operators/project.hpp>
 #include <core/storage/query_engine/operators/union.hpp>
 #include <core/storage/query_engine/algorithm/sort_and_merge.hpp>
+#include <core/storage/fileio/memory_budget.hpp>
+#include <core/globals/memory_accounting.hpp>
+#include <core/globals/metrics.hpp>
 #include <core/storage/query_engine/algorithm/sort_comparator.hpp>
+#include <core/storage/query_engine/algorithm/normalized_key_sort.hpp>
 
 namespace turi {
 
@@ -183,9 +187,12 @@ static std::shared_ptr<sarray<std::pair<flex_list, std::string> >> scatter_parti
       sort_keys_buffers(thread::cpu_count(), std::vector<flexible_type>(num_sort_columns));
   std::vector<std::string> arcout_buffers(thread::cpu_count());
   std::vector<oarchive> oarc_buffers(thread::cpu_count());
+  static metrics::counter& sort_spill_bytes = metrics::get_counter(
+      "sort_spill_bytes", "Bytes of row values written to disk partitions by sorts.");
   auto partial_sort_callback = [&](size_t segment_id,
                                    const std::shared_ptr<sframe_rows>& data) {
     oarchive& oarc = oarc_buffers[thread::thread_id()];
+    size_t spilled = 0;
     std::vector<flexible_type>& sort_keys = sort_keys_buffers[thread::thread_id()];
     for(const auto& item: (*data)) {
       // extract sort key
@@ -234,6 +241,7 @@ static std::shared_ptr<sarray<std::pair<flex_list, std::string> >> scatter_parti
       for (size_t i = num_sort_columns; i < item.size(); ++i) oarc << item[i];
       std::string& arcout = arcout_buffers[thread::thread_id()];
       arcout.assign(oarc.buf, oarc.off);
+      spilled += oarc.off;
 
       // write to coresponding output segment
       outiter_mutexes[partition_id].lock();
@@ -250,6 +258,7 @@ static std::shared_ptr<sarray<std::pair<flex_list, std::string> >> scatter_parti
 
       outiter_mutexes[partition_id].unlock();
     }
+    sort_spill_bytes += spilled;
     return false;
   };
 
@@ -285,7 +294,10 @@ std::shared_ptr<sframe> sort_sframe_in_memory(
   sf.get_reader()->read_rows(0, sf.size(), rows);
 
   less_than_partial_function comparator(sort_columns, sort_orders);
-  std::sort(rows.begin(), rows.end(), comparator);
+  normalized_key_sort(rows, sort_orders,
+                      [&](const std::vector<flexible_type>& row, size_t i)
+                          -> const flexible_type& { return row[sort_columns[i]]; },
+                      comparator);
 
   auto ret = std::make_shared<sframe>();
   ret->open_for_write(column_names, column_types, "", 1);
@@ -351,7 +363,19 @@ std::shared_ptr<sframe> sort(
   // chunks. To account for strings, we estimate each cell is 64 bytes.
   // I'd love to estimate better.
   size_t estimated_sframe_size = num_rows * num_columns * CELL_SIZE_ESTIMATE+ num_rows * ROW_SIZE_ESTIMATE;
-  size_t num_partitions = std::ceil((1.0 * estimated_sframe_size) / sframe_config::SFRAME_SORT_BUFFER_SIZE);
+
+  // The sort buffer shares the memory budget with the caches and other
+  // operators: take what is free, down to a sixteenth of the configured size.
+  fileio::memory_reservation sort_memory;
+  size_t sort_buffer_size = sort_memory.reserve_up_to(
+      std::min<size_t>(std::max<size_t>(estimated_sframe_size, 1),
+                       sframe_config::SFRAME_SORT_BUFFER_SIZE),
+      sframe_config::SFRAME_SORT_BUFFER_SIZE / 16);
+  sort_buffer_size = std::max<size_t>(sort_buffer_size, 1);
+  memory_accounting::tagged_memory sort_buffer_memory(
+      memory_accounting::get_tag("sort_buffers"));
+  sort_buffer_memory.set(sort_buffer_size);
+  size_t num_partitions = std::ceil((1.0 * estimated_sframe_size) / sort_buffer_size);
 
   // Make partitions small enough for each thread to (theoretically) sort at once
   num_partitions = num_partitions * thread::cpu_count();
@@ -465,7 +489,8 @@ std::shared_ptr<sframe> sort(
     sort_orders,
     permute_ordering,
     column_names,
-    column_types);
+    column_types,
+    sort_buffer_size);
   logstream(LOG_INFO) << "Sort and merge step: " << ti.current_time() << std::endl;
 
   return ret;
@@ -10,6 +10,7 @@
 #include<core/storage/sframe_data/sframe_config.hpp>
 #include<core/parallel/mutex.hpp>
 #include<core/storage/query_engine/algorithm/sort_comparator.hpp>
+#include<core/storage/query_engine/algorithm/normalized_key_sort.hpp>
 
 namespace turi {
 namespace query_eval {
@@ -130,7 +131,8 @@ std::shared_ptr<sframe> sort_and_merge(
     const std::vector<bool>& sort_orders,
     const std::vector<size_t>& permute_order,
     const std::vector<std::string>& column_names,
-    const std::vector<flex_type_enum>& column_types) {
+    const std::vector<flex_type_enum>& column_types,
+    size_t sort_buffer_size) {
 
   size_t num_segments = partition_array->num_segments();
   auto reader = partition_array->get_reader();
@@ -158,8 +160,8 @@ std::shared_ptr<sframe> sort_and_merge(
         write_one_chunk(reader, permute_order, segment_id, num_columns, outiterator);
       } else {
         mem_used_mutex.lock();
-        while((mem_used+partition_sizes[segment_id]) > sframe_config::SFRAME_SORT_BUFFER_SIZE) {
-          if(((partition_sizes[segment_id] > sframe_config::SFRAME_SORT_BUFFER_SIZE) && (mem_used == 0)) ||
+        while((mem_used+partition_sizes[segment_id]) > sort_buffer_size) {
+          if(((partition_sizes[segment_id] > sort_buffer_size) && (mem_used == 0)) ||
             (partition_sizes[segment_id] == 0)) {
             break;
           }
@@ -171,7 +173,10 @@ std::shared_ptr<sframe> sort_and_merge(
         read_one_chunk(reader, segment_id, num_columns, rows);
 
         // sort one chunk
-        std::sort(rows.begin(), rows.end(), comparator);
+        normalized_key_sort(rows, sort_orders,
+                            [](const std::pair<flex_list, std::string>& row, size_t i)
+                                -> const flexible_type& { return row.first[i]; },
+                            comparator);
 
         write_one_chunk(rows, permute_order ,outiterator, num_columns);
         out_sframe.flush_write_to_segment(segment_id);
@@ -36,6 +36,8 @@ namespace query_eval {
  * will be stored in column i of the final SFrame
  * \param column_names column names of the final sframe
  * \param column_types column types of the final sframe
+ * \param sort_buffer_size the number of bytes of partitions which can be in
+ * memory at once
  *
  * \return a sorted sframe.
  */
@@ -46,7 +48,8 @@ std::shared_ptr<sframe> sort_and_merge(
     const std::vector<bool>& sort_orders,
     const std::vector<size_t>& permute_order,
     const std::vector<std::string>& column_names,
-    const std::vector<flex_type_enum>& column_types);
+    const std::vector<flex_type_enum>& column_types,
+    size_t sort_buffer_size);
 
 /// \}
 } // enfd of query_eval
@@ -0,0 +1,71 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <core/logging/logger.hpp>
+#include <core/logging/assertions.hpp>
+#include <core/util/fast_top_k.hpp>
+#include <core/storage/sframe_data/sframe.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
+#include <core/storage/query_engine/operators/sframe_source.hpp>
+#include <core/storage/query_engine/operators/topk.hpp>
+#include <core/storage/query_engine/operators/operator_properties.hpp>
+#include <core/storage/query_engine/planning/planner.hpp>
+#include <core/storage/query_engine/algorithm/ec_sort.hpp>
+#include <core/storage/query_engine/algorithm/sort_comparator.hpp>
+#include <core/storage/query_engine/algorithm/topk.hpp>
+
+namespace turi {
+namespace query_eval {
+
+std::shared_ptr<sframe> topk(
+    std::shared_ptr<planner_node> sframe_planner_node,
+    const std::vector<std::string>& column_names,
+    const std::vector<size_t>& sort_column_indices,
+    const std::vector<bool>& sort_orders,
+    size_t k) {
+  ASSERT_EQ(sort_column_indices.size(), sort_orders.size());
+  auto column_types = infer_planner_node_type(sframe_planner_node);
+  ASSERT_EQ(column_names.size(), column_types.size());
+
+  int64_t length = infer_planner_node_length(sframe_planner_node);
+  bool small_k = k * std::max<size_t>(column_types.size(), 1) <= SFRAME_TOPK_MAX_NUM_CELLS;
+  if (!small_k || (length >= 0 && k >= (size_t)length)) {
+    // everything is kept anyway
+    auto sorted = ec_sort(sframe_planner_node, column_names,
+                          sort_column_indices, sort_orders);
+    if (k >= sorted->num_rows()) return sorted;
+    materialize_options exec_params;
+    exec_params.output_column_names = column_names;
+    return std::make_shared<sframe>(planner().materialize(
+        op_sframe_source::make_planner_node(*sorted, 0, k), exec_params));
+  }
+
+  // up to k rows per parallel segment
+  auto candidates = planner().materialize(
+      op_topk::make_planner_node(sframe_planner_node, sort_column_indices,
+                                 sort_orders, k));
+  std::vector<std::vector<flexible_type>> rows;
+  candidates.get_reader()->read_rows(0, candidates.size(), rows);
+  logstream(LOG_INFO) << "Merging " << rows.size() << " candidate rows for top "
+                      << k << std::endl;
+
+  // extract_and_sort_top_k keeps the largest rows in descending order, so
+  // the comparison is reversed to keep the first ones in sort order.
+  less_than_partial_function comparator(sort_column_indices, sort_orders);
+  extract_and_sort_top_k(rows, k,
+                         [&](const std::vector<flexible_type>& a,
+                             const std::vector<flexible_type>& b) {
+                           return comparator(b, a);
+                         });
+
+  auto ret = std::make_shared<sframe>();
+  ret->open_for_write(column_names, column_types, "", 1);
+  std::move(rows.begin(), rows.end(), ret->get_output_iterator(0));
+  ret->close();
+  return ret;
+}
+
+} // namespace query_eval
+} // namespace turi
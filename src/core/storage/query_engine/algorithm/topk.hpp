@@ -0,0 +1,57 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_QUERY_EVAL_TOPK_HPP
+#define TURI_QUERY_EVAL_TOPK_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace turi {
+
+class sframe;
+
+namespace query_eval {
+
+struct planner_node;
+
+/**
+ * \ingroup sframe_query_engine
+ * \addtogroup Algorithms Algorithms
+ * \{
+ */
+
+/**
+ * Returns the first k rows of an SFrame sorted by some of its columns, in that
+ * order. Rows with equal keys may come in any order.
+ *
+ * This is the same as the first k rows of \ref ec_sort, without sorting the
+ * whole SFrame: every parallel segment of the input keeps the top k of its
+ * rows in a bounded heap with an \ref op_topk, in a single scan, and the
+ * up to k rows of every segment are then merged in memory.
+ *
+ * If k times the number of columns is above SFRAME_TOPK_MAX_NUM_CELLS, the
+ * rows kept would not fit in memory, and this falls back to an \ref ec_sort.
+ *
+ * \param sframe_planner_node The lazy sframe to take the top k of
+ * \param column_names The names of the columns of the result
+ * \param sort_column_indices The columns to sort by
+ * \param sort_orders The order for each column to be sorted, true is ascending
+ * \param k The number of rows to return
+ * \return An sframe of min(k, number of rows) rows
+ */
+std::shared_ptr<sframe> topk(
+    std::shared_ptr<planner_node> sframe_planner_node,
+    const std::vector<std::string>& column_names,
+    const std::vector<size_t>& sort_column_indices,
+    const std::vector<bool>& sort_orders,
+    size_t k);
+
+/// \}
+} // end of query_eval
+} // end of turicreate
+
+#endif //TURI_QUERY_EVAL_TOPK_HPP
@@ -0,0 +1,164 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <sstream>
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_generators.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <core/storage/query_engine/execution/distributed_executor.hpp>
+#include <core/storage/query_engine/operators/operator_properties.hpp>
+#include <core/storage/query_engine/operators/operator_transformations.hpp>
+#include <core/storage/query_engine/planning/planner.hpp>
+#include <core/storage/serialization/serialization_includes.hpp>
+#include <core/system/nanosockets/async_reply_socket.hpp>
+#include <core/system/nanosockets/async_request_socket.hpp>
+#include <core/system/nanosockets/zmq_msg_vector.hpp>
+#include <core/parallel/pthread_tools.hpp>
+#include <core/logging/logger.hpp>
+
+namespace turi {
+namespace query_eval {
+
+distributed_query_worker::distributed_query_worker(std::string bind_address,
+                                                   size_t num_threads) {
+  m_socket.reset(new nanosockets::async_reply_socket(
+      boost::bind(&distributed_query_worker::handle_request, this, _1, _2),
+      std::max<size_t>(num_threads, 1), bind_address));
+  m_address = m_socket->get_bound_address();
+  m_socket->start_polling();
+  logstream(LOG_INFO) << "Query worker listening on " << m_address << std::endl;
+}
+
+distributed_query_worker::~distributed_query_worker() {
+  m_socket->stop_polling();
+  m_socket->close();
+}
+
+std::string distributed_query_worker::address() const {
+  return m_address;
+}
+
+bool distributed_query_worker::handle_request(nanosockets::zmq_msg_vector& recv,
+                                              nanosockets::zmq_msg_vector& reply) {
+  // the reply is empty on success, and the error otherwise
+  std::string error;
+  try {
+    nanosockets::nn_msg_t* msg = recv.read_next();
+    if (msg == NULL) log_and_throw("Empty query request");
+    iarchive iarc(msg->data(), msg->length());
+    materialize_options exec_params;
+    iarc >> exec_params.output_index_file >> exec_params.output_column_names;
+    pnode_ptr plan = load_plan(iarc);
+    planner().materialize(plan, exec_params);
+  } catch (std::exception& e) {
+    error = e.what();
+  } catch (std::string& e) {
+    error = e;
+  } catch (const char* e) {
+    error = e;
+  } catch (...) {
+    error = "Unknown error";
+  }
+  reply.clear();
+  reply.insert_back(error);
+  return true;
+}
+
+distributed_executor::distributed_executor(
+    const std::vector<std::string>& worker_addresses,
+    const std::string& output_directory,
+    size_t slices_per_worker,
+    size_t request_timeout)
+    : m_output_directory(output_directory),
+      m_slices_per_worker(std::max<size_t>(slices_per_worker, 1)),
+      m_request_timeout(request_timeout) {
+  for (const auto& address: worker_addresses) {
+    // one connection per slice in flight
+    m_workers.push_back(std::make_shared<nanosockets::async_request_socket>(
+        address, m_slices_per_worker));
+  }
+}
+
+distributed_executor::~distributed_executor() {
+  for (auto& worker: m_workers) worker->close();
+}
+
+bool distributed_executor::can_distribute(const pnode_ptr& tip) const {
+  return !m_workers.empty() && !is_source_node(tip) &&
+         is_parallel_slicable(tip) && is_portable_plan(tip);
+}
+
+bool distributed_executor::run_remote(
+    nanosockets::async_request_socket& worker,
+    const pnode_ptr& slice,
+    const std::string& output_index_file,
+    const std::vector<std::string>& column_names) {
+  std::stringstream strm;
+  oarchive oarc(strm);
+  oarc << output_index_file << column_names;
+  save_plan(oarc, slice);
+
+  nanosockets::zmq_msg_vector request, reply;
+  request.insert_back(strm.str());
+  if (worker.request_master(request, reply, m_request_timeout) != 0) {
+    logstream(LOG_WARNING) << "A query worker is unreachable or timed out"
+                           << std::endl;
+    return false;
+  }
+  nanosockets::nn_msg_t* msg = reply.read_next();
+  if (msg == NULL || !msg->empty()) {
+    logstream(LOG_WARNING) << "A query worker failed: "
+                           << (msg ? *msg : std::string("no reply")) << std::endl;
+    return false;
+  }
+  return true;
+}
+
+sframe distributed_executor::materialize(pnode_ptr tip,
+                                         const std::vector<std::string>& column_names) {
+  materialize_options exec_params;
+  exec_params.output_column_names = column_names;
+  if (!can_distribute(tip)) return planner().materialize(tip, exec_params);
+
+  size_t num_slices = m_workers.size() * m_slices_per_worker;
+  std::string prefix = m_output_directory + "/" +
+      boost::lexical_cast<std::string>(boost::uuids::random_generator()());
+  std::vector<std::string> index_files(num_slices);
+  for (size_t i = 0; i < num_slices; ++i) {
+    index_files[i] = prefix + "-" + std::to_string(i) + ".frame_idx";
+  }
+
+  logstream(LOG_INFO) << "Materializing a query in " << num_slices
+                      << " slices on " << m_workers.size() << " workers" << std::endl;
+  thread_group threads;
+  for (size_t i = 0; i < num_slices; ++i) {
+    threads.launch([&, i]() {
+      std::map<pnode_ptr, pnode_ptr> memo;
+      pnode_ptr slice = make_segmented_graph(tip, i, num_slices, memo);
+      // consecutive slices go to different workers
+      auto& worker = *m_workers[i % m_workers.size()];
+      if (!run_remote(worker, slice, index_files[i], column_names)) {
+        // a worker which timed out may still be writing the slice
+        index_files[i] = prefix + "-" + std::to_string(i) + "-local.frame_idx";
+        materialize_options local_params = exec_params;
+        local_params.output_index_file = index_files[i];
+        planner().materialize(slice, local_params);
+      }
+    });
+  }
+  threads.join();
+
+  sframe ret(index_files[0]);
+  for (size_t i = 1; i < num_slices; ++i) {
+    // compacting would copy the slices out of the shared storage
+    ret = ret.append(sframe(index_files[i]), false);
+  }
+  return ret;
+}
+
+} // namespace query_eval
+} // namespace turi
@@ -0,0 +1,130 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_QUERY_ENGINE_DISTRIBUTED_EXECUTOR_HPP
+#define TURI_SFRAME_QUERY_ENGINE_DISTRIBUTED_EXECUTOR_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <core/storage/sframe_data/sframe.hpp>
+#include <core/storage/query_engine/planning/planner_node.hpp>
+
+namespace turi {
+namespace nanosockets {
+class async_reply_socket;
+class async_request_socket;
+class zmq_msg_vector;
+}
+
+namespace query_eval {
+
+/**
+ * \ingroup sframe_query_engine
+ * \addtogroup execution Execution
+ * \{
+ */
+
+/**
+ * Materializes slices of query plans sent by a \ref distributed_executor.
+ *
+ * Each request holds a portable plan (see \ref is_portable_plan) reading a
+ * range of rows of its sources, which the worker materializes with the
+ * \ref planner, on all its cores, into an SFrame at the location given by
+ * the request.
+ *
+ * \code
+ * // on every machine
+ * distributed_query_worker worker("tcp://0.0.0.0:9000");
+ * \endcode
+ */
+class distributed_query_worker {
+ public:
+  /**
+   * Listens on bind_address, or a free TCP port if empty, materializing up
+   * to num_threads slices at a time.
+   */
+  explicit distributed_query_worker(std::string bind_address = "",
+                                    size_t num_threads = 1);
+
+  ~distributed_query_worker();
+
+  /// The address to give the \ref distributed_executor.
+  std::string address() const;
+
+ private:
+  std::unique_ptr<nanosockets::async_reply_socket> m_socket;
+  std::string m_address;
+
+  bool handle_request(nanosockets::zmq_msg_vector& recv,
+                      nanosockets::zmq_msg_vector& reply);
+};
+
+/**
+ * Materializes query plans across several processes or machines, each
+ * running a \ref distributed_query_worker.
+ *
+ * A plan which is parallel slicable (see \ref is_parallel_slicable) and
+ * portable (see \ref is_portable_plan) is cut into slices of the rows of
+ * its sources, as the planner cuts a plan into segments for its threads.
+ * The slices are sent to the workers, which read their ranges of the
+ * sources straight from the shared storage, and write their results back
+ * to it. The result is the concatenation of the slices, in order. A slice
+ * a worker fails to materialize, or does not answer within the request
+ * timeout, is materialized locally instead.
+ *
+ * Any other plan, for instance one with a groupby, a join or a C++ function,
+ * is materialized locally.
+ *
+ * The sources of the plans, and the output directory, must be on storage
+ * every worker can read and write, such as HDFS, S3 or a network file
+ * system.
+ */
+class distributed_executor {
+ public:
+  /**
+   * \param worker_addresses The addresses of the workers.
+   * \param output_directory Where the workers write the slices.
+   * \param slices_per_worker The number of slices sent to each worker.
+   *        More slices balance the load better between uneven workers.
+   * \param request_timeout The number of seconds to wait for a worker to
+   *        materialize a slice, after which the slice is materialized locally.
+   */
+  distributed_executor(const std::vector<std::string>& worker_addresses,
+                       const std::string& output_directory,
+                       size_t slices_per_worker = 2,
+                       size_t request_timeout = 3600);
+
+  ~distributed_executor();
+
+  /// Returns true if materialize() would send the plan to the workers.
+  bool can_distribute(const pnode_ptr& tip) const;
+
+  /**
+   * Materializes the plan, naming the columns of the result column_names,
+   * or X1, X2, ... if empty.
+   */
+  sframe materialize(pnode_ptr tip,
+                     const std::vector<std::string>& column_names = {});
+
+ private:
+  std::vector<std::shared_ptr<nanosockets::async_request_socket>> m_workers;
+  std::string m_output_directory;
+  size_t m_slices_per_worker;
+  size_t m_request_timeout;
+
+  /// Materializes a slice on a worker. Returns false on failure.
+  bool run_remote(nanosockets::async_request_socket& worker,
+                  const pnode_ptr& slice,
+                  const std::string& output_index_file,
+                  const std::vector<std::string>& column_names);
+};
+
+/// \}
+
+} // namespace query_eval
+} // namespace turi
+
+#endif // TURI_SFRAME_QUERY_ENGINE_DISTRIBUTED_EXECUTOR_HPP
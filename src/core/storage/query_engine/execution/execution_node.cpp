@@ -9,6 +9,7 @@
 #include <core/storage/query_engine/execution/query_context.hpp>
 #include <core/storage/query_engine/execution/execution_node.hpp>
 #include <core/system/cppipc/cppipc.hpp>
+#include <core/logging/trace_events.hpp>
 #include <core/util/coro.hpp>
 
 namespace turi {
@@ -21,6 +22,7 @@ execution_node::execution_node(const std::shared_ptr<query_operator>& op,
 void execution_node::init(const std::shared_ptr<query_operator>& op,
                           const std::vector<std::shared_ptr<execution_node> >& inputs) {
   m_operator = op;
+  m_trace_name = m_operator->name();
   int num_inputs = m_operator->attributes().num_inputs;
   // num_inputs may be negative if it does not care about the number of inputs.
   if (num_inputs >= 0) {
@@ -106,6 +108,9 @@ std::shared_ptr<sframe_rows> execution_node::get_next(size_t consumer_id, bool s
     if (m_coroutines_started == false) {
       start_coroutines();
     }
+    profile_sample start;
+    if (m_profiling) start = profile_sample::now();
+    trace::scoped_span span("query", m_trace_name);
     try {
       if (m_skip_next_block) {
         if (supports_skipping || !is_linear_operator) {
@@ -125,6 +130,7 @@ std::shared_ptr<sframe_rows> execution_node::get_next(size_t consumer_id, bool s
       m_exception_occured = true;
       m_exception = std::current_exception();
     }
+    if (m_profiling) m_used += profile_sample::now() - start;
   }
 
   // end of data
@@ -141,13 +147,28 @@ std::shared_ptr<sframe_rows> execution_node::get_next(size_t consumer_id, bool s
 }
 
 void execution_node::add_operator_output(const std::shared_ptr<sframe_rows>& rows) {
+  if (m_profiling && rows) m_profile.rows_out += rows->num_rows();
   m_output_queue->push(rows);
 }
 
 std::shared_ptr<sframe_rows> execution_node::get_next_from_input(size_t input_id, bool skip) {
   ASSERT_LT(input_id, m_inputs.size());
   auto& input = m_inputs[input_id];
-  return input.m_node->get_next(input.m_consumer_id, skip);
+  if (!m_profiling) return input.m_node->get_next(input.m_consumer_id, skip);
+
+  profile_sample start = profile_sample::now();
+  auto ret = input.m_node->get_next(input.m_consumer_id, skip);
+  m_used_by_inputs += profile_sample::now() - start;
+  if (ret) m_profile.rows_in += ret->num_rows();
+  return ret;
+}
+
+operator_profile execution_node::get_profile() const {
+  operator_profile ret = m_profile;
+  ret.name = m_operator->print();
+  ret.self = m_used - m_used_by_inputs;
+  ret.input_wait_time = m_used_by_inputs.wall_time;
+  return ret;
 }
 
 size_t execution_node::register_consumer() {
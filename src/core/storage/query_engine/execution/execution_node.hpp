@@ -12,6 +12,7 @@
 
 
 #include <core/data/flexible_type/flexible_type.hpp>
+#include <core/storage/query_engine/execution/query_profile.hpp>
 #include <core/storage/query_engine/operators/operator.hpp>
 #include <core/storage/query_engine/util/broadcast_queue.hpp>
 
@@ -220,6 +221,20 @@ class execution_node  : public std::enable_shared_from_this<execution_node> {
   std::exception_ptr get_exception() const {
     return m_exception;
   }
+
+  /**
+   * Starts counting the rows, time and bytes read by this node. Must be
+   * called before the first get_next().
+   */
+  void enable_profiling() {
+    m_profiling = true;
+  }
+
+  /**
+   * Returns what this node has done so far, if \ref enable_profiling() was
+   * called. The inputs of the returned profile are left empty.
+   */
+  operator_profile get_profile() const;
  private:
   /**
    * Internal function used to add to the operator output
@@ -269,6 +284,15 @@ class execution_node  : public std::enable_shared_from_this<execution_node> {
   bool supports_skipping;
   bool is_linear_operator;
 
+  /// profiling. The resources used by the inputs are included in m_used.
+  bool m_profiling = false;
+  operator_profile m_profile;
+  profile_sample m_used;
+  profile_sample m_used_by_inputs;
+
+  /// name of the operator, for trace events
+  std::string m_trace_name;
+
   friend class query_context;
 };
 
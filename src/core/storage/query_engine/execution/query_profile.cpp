@@ -0,0 +1,198 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <chrono>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#ifdef _WIN32
+#include <cross_platform/windows_wrapper.hpp>
+#else
+#include <time.h>
+#endif
+#include <core/storage/query_engine/execution/query_profile.hpp>
+#include <core/storage/sframe_data/sarray_v2_block_manager.hpp>
+
+namespace turi { namespace query_eval {
+
+namespace {
+
+double thread_cpu_time() {
+#ifdef _WIN32
+  FILETIME creation_time, exit_time, kernel_time, user_time;
+  if (!GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time,
+                      &kernel_time, &user_time)) {
+    return 0;
+  }
+  // in units of 100ns
+  auto to_seconds = [](const FILETIME& t) {
+    return (((uint64_t)t.dwHighDateTime << 32) + t.dwLowDateTime) * 1e-7;
+  };
+  return to_seconds(kernel_time) + to_seconds(user_time);
+#else
+  timespec t;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t) != 0) return 0;
+  return t.tv_sec + t.tv_nsec * 1e-9;
+#endif
+}
+
+void print_operator(std::ostream& out,
+                    const query_profile::stage& s,
+                    size_t index,
+                    size_t depth,
+                    std::set<size_t>& printed) {
+  const operator_profile& op = s.operators[index];
+  out << std::string(2 * depth + 2, ' ') << "[" << index << "] " << op.name;
+  if (!printed.insert(index).second) {
+    // inputs shared by several operators are only expanded once
+    out << " (see above)\n";
+    return;
+  }
+  out << ": rows in " << op.rows_in
+      << ", rows out " << op.rows_out
+      << ", wall " << op.self.wall_time << "s"
+      << ", cpu " << op.self.cpu_time << "s"
+      << ", waiting on inputs " << op.input_wait_time << "s"
+      << ", read " << op.self.bytes_read << " bytes";
+  if (op.self.io.blocks_read > 0) {
+    out << " in " << op.self.io.blocks_read << " blocks ("
+        << op.self.io.blocks_reread << " re-read, sequentiality "
+        << op.self.io.sequentiality() << ")";
+  }
+  out << "\n";
+  for (size_t input: op.inputs) {
+    print_operator(out, s, input, depth + 1, printed);
+  }
+}
+
+} // anonymous namespace
+
+
+profile_sample profile_sample::now() {
+  profile_sample ret;
+  ret.wall_time = std::chrono::duration<double>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  ret.cpu_time = thread_cpu_time();
+  ret.bytes_read = v2_block_impl::block_manager::thread_bytes_read();
+  ret.io = v2_block_impl::block_manager::thread_io_stats();
+  return ret;
+}
+
+profile_sample& profile_sample::operator+=(const profile_sample& other) {
+  wall_time += other.wall_time;
+  cpu_time += other.cpu_time;
+  bytes_read += other.bytes_read;
+  io += other.io;
+  return *this;
+}
+
+profile_sample profile_sample::operator-(const profile_sample& other) const {
+  profile_sample ret;
+  ret.wall_time = wall_time - other.wall_time;
+  ret.cpu_time = cpu_time - other.cpu_time;
+  ret.bytes_read = bytes_read - other.bytes_read;
+  ret.io = io - other.io;
+  return ret;
+}
+
+
+void operator_profile::merge(const operator_profile& other) {
+  rows_in += other.rows_in;
+  rows_out += other.rows_out;
+  self += other.self;
+  input_wait_time += other.input_wait_time;
+}
+
+
+size_t query_profile::begin_stage() {
+  std::lock_guard<mutex> guard(m_lock);
+  m_stages.emplace_back();
+  return m_stages.size() - 1;
+}
+
+void query_profile::add_run(size_t stage_index,
+                            const std::vector<operator_profile>& operators) {
+  std::lock_guard<mutex> guard(m_lock);
+  ASSERT_LT(stage_index, m_stages.size());
+  stage& s = m_stages[stage_index];
+  if (s.num_runs == 0) {
+    s.operators = operators;
+  } else if (s.operators.size() != operators.size()) {
+    // not the same pipeline after all. Keep it apart.
+    stage other;
+    other.operators = operators;
+    other.num_runs = 1;
+    m_stages.push_back(std::move(other));
+    return;
+  } else {
+    for (size_t i = 0; i < operators.size(); ++i) {
+      s.operators[i].merge(operators[i]);
+    }
+  }
+  ++s.num_runs;
+}
+
+std::vector<query_profile::stage> query_profile::stages() const {
+  std::lock_guard<mutex> guard(m_lock);
+  return m_stages;
+}
+
+v2_block_impl::block_io_stats query_profile::io_stats() const {
+  v2_block_impl::block_io_stats ret;
+  for (const auto& s: stages()) {
+    for (const auto& op: s.operators) ret += op.self.io;
+  }
+  return ret;
+}
+
+std::string query_profile::to_string() const {
+  auto all_stages = stages();
+  std::stringstream out;
+  out << std::setprecision(4);
+  size_t stage_number = 0;
+  for (const auto& s: all_stages) {
+    if (s.operators.empty()) continue;
+    ++stage_number;
+    out << "Stage " << stage_number << " (" << s.num_runs
+        << (s.num_runs == 1 ? " segment" : " segments") << ")\n";
+    std::set<size_t> printed;
+    print_operator(out, s, 0, 0, printed);
+  }
+  if (stage_number == 0) {
+    out << "Nothing was executed\n";
+  } else {
+    out << "Read " << io_stats().to_string() << "\n";
+  }
+  return out.str();
+}
+
+flexible_type query_profile::to_flexible_type() const {
+  flex_list ret;
+  for (const auto& s: stages()) {
+    if (s.operators.empty()) continue;
+    flex_list operators;
+    for (const auto& op: s.operators) {
+      flex_list inputs(op.inputs.begin(), op.inputs.end());
+      operators.push_back(flex_dict{
+          {"name", op.name},
+          {"inputs", inputs},
+          {"rows_in", op.rows_in},
+          {"rows_out", op.rows_out},
+          {"wall_time", op.self.wall_time},
+          {"cpu_time", op.self.cpu_time},
+          {"input_wait_time", op.input_wait_time},
+          {"bytes_read", op.self.bytes_read},
+          {"blocks_read", op.self.io.blocks_read},
+          {"blocks_reread", op.self.io.blocks_reread},
+          {"bytes_decompressed", op.self.io.bytes_decompressed},
+          {"decode_time", op.self.io.decode_time},
+          {"sequentiality", op.self.io.sequentiality()}});
+    }
+    ret.push_back(flex_dict{{"num_runs", s.num_runs}, {"operators", operators}});
+  }
+  return ret;
+}
+
+}}
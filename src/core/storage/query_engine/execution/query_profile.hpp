@@ -0,0 +1,134 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_QUERY_ENGINE_QUERY_PROFILE_HPP
+#define TURI_SFRAME_QUERY_ENGINE_QUERY_PROFILE_HPP
+
+#include <string>
+#include <vector>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/parallel/mutex.hpp>
+#include <core/storage/sframe_data/sarray_v2_block_types.hpp>
+
+namespace turi { namespace query_eval {
+
+/**
+ * \ingroup sframe_query_engine
+ * \addtogroup execution Execution
+ * \{
+ */
+
+/**
+ * A snapshot of the resources used by the calling thread so far. The
+ * difference of two snapshots is what the thread used in between.
+ */
+struct profile_sample {
+  /// Wall clock time in seconds
+  double wall_time = 0;
+  /// CPU time of the calling thread in seconds
+  double cpu_time = 0;
+  /// Uncompressed bytes of blocks read by the calling thread
+  size_t bytes_read = 0;
+  /// The blocks read by the calling thread, and how
+  v2_block_impl::block_io_stats io;
+
+  /// Takes a snapshot of the calling thread.
+  static profile_sample now();
+
+  profile_sample& operator+=(const profile_sample& other);
+  profile_sample operator-(const profile_sample& other) const;
+};
+
+/**
+ * What one operator of an execution pipeline did while the query ran.
+ *
+ * Times and bytes are the operator's own: everything spent while one of its
+ * inputs was producing rows is left out, and accounted to that input.
+ */
+struct operator_profile {
+  /// The name of the operator, as printed by query_operator::print()
+  std::string name;
+  /// The positions of the inputs of the operator in its stage
+  std::vector<size_t> inputs;
+  /// The number of rows the operator read from its inputs
+  size_t rows_in = 0;
+  /// The number of rows the operator produced
+  size_t rows_out = 0;
+  /// The wall clock, CPU time and bytes read by the operator itself
+  profile_sample self;
+  /// The wall clock time the operator spent waiting for its inputs
+  double input_wait_time = 0;
+
+  /// Adds up the counters of the same operator in another run
+  void merge(const operator_profile& other);
+};
+
+/**
+ * The profile of a query: the operators of every pipeline executed to
+ * materialize it, and what each of them did.
+ *
+ * A profile is collected by setting materialize_options::profile before
+ * calling \ref planner::materialize. Profiling is off otherwise, and then
+ * costs nothing.
+ *
+ * A materialization may run several pipelines one after the other, for
+ * instance when the planner materializes the inputs of a node which cannot
+ * be executed as a single pipeline first. Each of those is a stage of the
+ * profile. A stage is executed in parallel segments; the counters of a
+ * stage are summed over its segments, so its times are thread time rather
+ * than elapsed time.
+ *
+ * Safe for concurrent use.
+ */
+class query_profile {
+ public:
+  struct stage {
+    /// The operators of the pipeline. operators[0] produces the output.
+    std::vector<operator_profile> operators;
+    /// The number of parallel segments (or morsels) the stage ran as
+    size_t num_runs = 0;
+  };
+
+  /// Starts a new stage, returning its index.
+  size_t begin_stage();
+
+  /**
+   * Adds the profile of one segment of a stage. All segments of a stage
+   * run the same pipeline, so operators are matched up by position.
+   */
+  void add_run(size_t stage_index, const std::vector<operator_profile>& operators);
+
+  /// Returns a copy of all stages, in the order in which they started.
+  std::vector<stage> stages() const;
+
+  /// Returns the blocks read by all operators of all stages.
+  v2_block_impl::block_io_stats io_stats() const;
+
+  /**
+   * Prints the profile as an indented tree of operators per stage, inputs
+   * below the operator reading them; similar to an EXPLAIN ANALYZE.
+   * Ends with a summary of the blocks read by the query.
+   */
+  std::string to_string() const;
+
+  /**
+   * Returns the profile as a list with a dictionary per stage, with keys
+   * "num_runs" and "operators". The latter is a list with a dictionary per
+   * operator, with keys "name", "inputs", "rows_in", "rows_out",
+   * "wall_time", "cpu_time", "input_wait_time", "bytes_read",
+   * "blocks_read", "blocks_reread", "bytes_decompressed", "decode_time" and
+   * "sequentiality".
+   */
+  flexible_type to_flexible_type() const;
+
+ private:
+  mutable mutex m_lock;
+  std::vector<stage> m_stages;
+};
+
+/// \}
+}}
+
+#endif
@@ -3,10 +3,21 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <deque>
+#include <map>
+#include <memory>
+#include <core/parallel/atomic.hpp>
 #include <core/parallel/lambda_omp.hpp>
+#include <core/parallel/parallelism_controller.hpp>
+#include <core/parallel/pthread_tools.hpp>
+#include <core/parallel/thread_pool.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
 #include <core/storage/query_engine/execution/subplan_executor.hpp>
 #include <core/storage/query_engine/execution/execution_node.hpp>
+#include <core/storage/query_engine/execution/query_profile.hpp>
+#include <core/storage/query_engine/operators/reduce.hpp>
 #include <core/storage/query_engine/operators/operator_properties.hpp>
+#include <core/storage/query_engine/operators/operator_transformations.hpp>
 
 namespace turi { namespace query_eval {
 
@@ -80,24 +91,79 @@ find_earliest_exception(std::shared_ptr<execution_node> tip,
   }
 }
 
+/**
+ * Collects the profiles of the execution node graph at tip, numbering the
+ * nodes in the order in which they are first reached from tip.
+ */
+static size_t collect_profiles(const std::shared_ptr<execution_node>& tip,
+                               std::map<execution_node*, size_t>& ids,
+                               std::vector<operator_profile>& profiles) {
+  auto it = ids.find(tip.get());
+  if (it != ids.end()) return it->second;
+  size_t id = profiles.size();
+  ids[tip.get()] = id;
+  profiles.push_back(tip->get_profile());
+  for (size_t i = 0;i < tip->num_inputs(); ++i) {
+    size_t input_id = collect_profiles(tip->get_input_node(i), ids, profiles);
+    profiles[id].inputs.push_back(input_id);
+  }
+  return id;
+}
+
+size_t subplan_executor::begin_profile_stage(const materialize_options& exec_params) {
+  if (exec_params.profile == nullptr) return 0;
+  return exec_params.profile->begin_stage();
+}
+
 void subplan_executor::generate_to_callback_function(
     const std::shared_ptr<planner_node>& plan,
     size_t output_segment_id,
-    execution_callback out_function) {
+    execution_callback out_function,
+    const materialize_options& exec_params,
+    size_t profile_stage) {
+  generate_to_callback_functions({plan}, output_segment_id, {out_function},
+                                 exec_params, profile_stage);
+}
 
-  std::map<std::shared_ptr<planner_node>, std::shared_ptr<execution_node> > memo;
-  std::shared_ptr<execution_node> ex_op = get_executor(plan, memo);
+void subplan_executor::generate_to_callback_functions(
+    const std::vector<std::shared_ptr<planner_node>>& plans,
+    size_t output_segment_id,
+    const std::vector<execution_callback>& out_functions,
+    const materialize_options& exec_params,
+    size_t profile_stage) {
+  ASSERT_EQ(plans.size(), out_functions.size());
 
-  size_t consumer_id = ex_op->register_consumer();
+  // nodes shared by the plans are executed once
+  std::map<std::shared_ptr<planner_node>, std::shared_ptr<execution_node> > memo;
+  std::vector<std::shared_ptr<execution_node>> ex_ops;
+  for (const auto& plan: plans) ex_ops.push_back(get_executor(plan, memo));
+  if (exec_params.profile != nullptr) {
+    for (auto& node: memo) node.second->enable_profiling();
+  }
 
-  while(1) {
-    auto rows = ex_op->get_next(consumer_id);
-    if (rows == nullptr)
-      break;
+  std::vector<size_t> consumer_ids;
+  for (auto& ex_op: ex_ops) consumer_ids.push_back(ex_op->register_consumer());
+
+  // The plans take turns reading a block, so that the nodes they share do
+  // not have to buffer much of their output for the plans behind.
+  std::vector<bool> running(plans.size(), true);
+  size_t num_running = plans.size();
+  while(num_running > 0) {
+    for (size_t i = 0; i < plans.size(); ++i) {
+      if (!running[i]) continue;
+      auto rows = ex_ops[i]->get_next(consumer_ids[i]);
+      if (rows == nullptr || out_functions[i](output_segment_id, rows)) {
+        running[i] = false;
+        --num_running;
+      }
+    }
+  }
 
-    bool done = out_function(output_segment_id, rows);
-    if(done)
-      break;
+  if (exec_params.profile != nullptr) {
+    std::map<execution_node*, size_t> ids;
+    std::vector<operator_profile> profiles;
+    for (auto& ex_op: ex_ops) collect_profiles(ex_op, ids, profiles);
+    exec_params.profile->add_run(profile_stage, profiles);
   }
 
   // look through the list of all nodes for exceptions
@@ -110,14 +176,18 @@ void subplan_executor::generate_to_callback_function(
       // find the earliest exception which occured.
   if (has_exception) {
     std::set<std::shared_ptr<execution_node>> memo;
-    auto earliest_exception = find_earliest_exception(ex_op, memo);
-    std::rethrow_exception(earliest_exception);
+    for (auto& ex_op: ex_ops) {
+      auto earliest_exception = find_earliest_exception(ex_op, memo);
+      if (earliest_exception != nullptr) std::rethrow_exception(earliest_exception);
+    }
   }
 }
 
 void subplan_executor::generate_to_sframe_segment(const std::shared_ptr<planner_node>& plan,
                                           sframe& out,
-                                          size_t output_segment_id) {
+                                          size_t output_segment_id,
+                                          const materialize_options& exec_params,
+                                          size_t profile_stage) {
 
   auto outiter = out.get_output_iterator(output_segment_id);
 
@@ -126,15 +196,18 @@ void subplan_executor::generate_to_sframe_segment(const std::shared_ptr<planner_
       [&](size_t segment_idx, const std::shared_ptr<sframe_rows>& rows) {
         (*outiter) = *rows;
         return false;
-      });
+      },
+      exec_params, profile_stage);
 }
 
 
 sframe subplan_executor::run(const std::shared_ptr<planner_node>& pnode,
                              const materialize_options& exec_params) {
 
+  size_t profile_stage = begin_profile_stage(exec_params);
   if(exec_params.write_callback != nullptr) {
-    generate_to_callback_function(pnode, 0, exec_params.write_callback);
+    generate_to_callback_function(pnode, 0, exec_params.write_callback,
+                                  exec_params, profile_stage);
 
     sframe ret;
     return ret;
@@ -142,7 +215,7 @@ sframe subplan_executor::run(const std::shared_ptr<planner_node>& pnode,
     sframe out = get_output_sframe_schema(pnode,
                                           1, // just 1 segment will do
                                           exec_params.output_index_file);
-    generate_to_sframe_segment(pnode, out, 0);
+    generate_to_sframe_segment(pnode, out, 0, exec_params, profile_stage);
     out.close();
     return out;
   }
@@ -171,11 +244,13 @@ sframe subplan_executor::run_concat(
     return ret;
   }
 
+  size_t profile_stage = begin_profile_stage(exec_params);
   if(exec_params.write_callback != nullptr) {
     execution_callback exec_f = exec_params.write_callback;
 
     parallel_for(0, stuff_to_run_in_parallel.size(), [&](size_t i) {
-        generate_to_callback_function(stuff_to_run_in_parallel[i], i, exec_f);
+        generate_to_callback_function(stuff_to_run_in_parallel[i], i, exec_f,
+                                      exec_params, profile_stage);
       });
 
     // make an empty sframe and return
@@ -189,7 +264,8 @@ sframe subplan_executor::run_concat(
                                           exec_params.output_column_names);
 
     parallel_for(0, stuff_to_run_in_parallel.size(), [&](size_t i) {
-        generate_to_sframe_segment(stuff_to_run_in_parallel[i], ret, i);
+        generate_to_sframe_segment(stuff_to_run_in_parallel[i], ret, i,
+                                   exec_params, profile_stage);
       });
 
     ret.close();
@@ -197,4 +273,280 @@ sframe subplan_executor::run_concat(
   }
 }
 
+
+std::vector<sframe> subplan_executor::run_shared(
+    const std::vector<std::vector<std::shared_ptr<planner_node>>>& segments,
+    const materialize_options& exec_params) {
+  ASSERT_GE(segments.size(), 1);
+  size_t num_segments = segments.size();
+  size_t num_plans = segments[0].size();
+
+  std::vector<sframe> ret(num_plans);
+  for (size_t j = 0; j < num_plans; ++j) {
+    ret[j] = get_output_sframe_schema(segments[0][j], num_segments);
+  }
+
+  size_t profile_stage = begin_profile_stage(exec_params);
+  parallel_for(0, num_segments, [&](size_t i) {
+    ASSERT_EQ(segments[i].size(), num_plans);
+    std::vector<std::shared_ptr<planner_node>> plans;
+    std::vector<execution_callback> out_functions;
+    std::vector<sframe::iterator> outiters(num_plans);
+    std::vector<std::shared_ptr<group_aggregate_value>> reducers(num_plans);
+    for (size_t j = 0; j < num_plans; ++j) {
+      const auto& plan = segments[i][j];
+      outiters[j] = ret[j].get_output_iterator(i);
+      if (plan->operator_type == planner_node_type::REDUCE_NODE) {
+        // Reduced here as the rows arrive. A reduce operator would read all
+        // of its input before returning, while the other plans wait.
+        auto aggregator = plan->any_operator_parameters.at("aggregator")
+                              .as<std::shared_ptr<group_aggregate_value>>();
+        reducers[j].reset(aggregator->new_instance());
+        plans.push_back(plan->inputs[0]);
+        out_functions.push_back(
+            [&reducers, j](size_t, const std::shared_ptr<sframe_rows>& rows) {
+              for (const auto& row : *rows) {
+                if (row.size() == 1) reducers[j]->add_element_simple(row[0]);
+                else reducers[j]->add_element(std::vector<flexible_type>(row));
+              }
+              return false;
+            });
+      } else {
+        plans.push_back(plan);
+        out_functions.push_back(
+            [&outiters, j](size_t, const std::shared_ptr<sframe_rows>& rows) {
+              *(outiters[j]) = *rows;
+              return false;
+            });
+      }
+    }
+    generate_to_callback_functions(plans, i, out_functions, exec_params, profile_stage);
+    for (size_t j = 0; j < num_plans; ++j) {
+      if (reducers[j]) *(outiters[j]) = std::vector<flexible_type>{reducers[j]->emit()};
+    }
+  });
+
+  for (auto& sf: ret) sf.close();
+  return ret;
+}
+
+
+namespace {
+
+/**
+ * The scheduling state of one output segment of \ref run_morsels.
+ *
+ * The pending morsels of a segment are always a contiguous range: the
+ * owner of the segment pops morsels from the front and streams their output
+ * directly, while thieves pop from the back. Hence the front morsel is
+ * always the next one to be written, and only the outputs of stolen morsels
+ * ever need to wait in completed.
+ */
+struct morsel_segment {
+  turi::mutex lock;
+  std::deque<size_t> pending;
+  /// The morsel whose output is to be written next
+  size_t next_to_deliver = 0;
+  /// Outputs of stolen morsels which are not yet ready to be written
+  std::map<size_t, std::vector<std::shared_ptr<sframe_rows>>> completed;
+  /// True once a worker owns the segment. Only owned segments are stolen from.
+  bool started = false;
+  /// True while a thread is writing the contents of completed
+  bool delivering = false;
+  /// True once the callback asked for this segment to stop
+  bool stopped = false;
+};
+
+} // anonymous namespace
+
+sframe subplan_executor::run_morsels(
+    const std::shared_ptr<planner_node>& pnode,
+    size_t num_segments,
+    size_t morsels_per_segment,
+    const materialize_options& exec_params) {
+  ASSERT_GE(num_segments, 1);
+  ASSERT_GE(morsels_per_segment, 1);
+  const size_t num_morsels = num_segments * morsels_per_segment;
+
+  std::vector<std::unique_ptr<morsel_segment>> segments(num_segments);
+  for (size_t i = 0; i < num_segments; ++i) {
+    segments[i].reset(new morsel_segment);
+    for (size_t j = 0; j < morsels_per_segment; ++j) {
+      segments[i]->pending.push_back(i * morsels_per_segment + j);
+    }
+    segments[i]->next_to_deliver = i * morsels_per_segment;
+  }
+
+  // where the rows go. Written to by at most one thread per segment at a time.
+  sframe ret;
+  std::vector<sframe::iterator> outiters;
+  execution_callback deliver_fn;
+  if (exec_params.write_callback != nullptr) {
+    deliver_fn = exec_params.write_callback;
+  } else {
+    ret = get_output_sframe_schema(pnode,
+                                   num_segments,
+                                   exec_params.output_index_file,
+                                   exec_params.output_column_names);
+    for (size_t i = 0; i < num_segments; ++i) {
+      outiters.push_back(ret.get_output_iterator(i));
+    }
+    deliver_fn = [&](size_t segment_idx, const std::shared_ptr<sframe_rows>& rows) {
+      *(outiters[segment_idx]) = *rows;
+      return false;
+    };
+  }
+
+  atomic<size_t> next_segment(0);
+  atomic<size_t> buffered_rows(0);
+  turi::mutex error_lock;
+  std::exception_ptr error;
+  volatile bool failed = false;
+  size_t profile_stage = begin_profile_stage(exec_params);
+
+  auto run_morsel = [&](size_t morsel_idx, execution_callback out_f) {
+    std::map<pnode_ptr, pnode_ptr> memo;
+    auto plan = make_segmented_graph(pnode, morsel_idx, num_morsels, memo);
+    generate_to_callback_function(plan, morsel_idx / morsels_per_segment, out_f,
+                                  exec_params, profile_stage);
+  };
+
+  // writes out every completed morsel which is next in line
+  auto flush = [&](size_t segment_idx) {
+    morsel_segment& seg = *segments[segment_idx];
+    std::unique_lock<turi::mutex> guard(seg.lock);
+    if (seg.delivering) return;
+    seg.delivering = true;
+    while (!seg.completed.empty() &&
+           seg.completed.begin()->first == seg.next_to_deliver) {
+      auto rows = std::move(seg.completed.begin()->second);
+      seg.completed.erase(seg.completed.begin());
+      bool stopped = seg.stopped;
+      guard.unlock();
+      size_t nrows = 0;
+      for (const auto& r: rows) {
+        nrows += r->num_rows();
+        if (!stopped && !failed) stopped = deliver_fn(segment_idx, r);
+      }
+      rows.clear();
+      buffered_rows.dec(nrows);
+      guard.lock();
+      seg.stopped = seg.stopped || stopped;
+      ++seg.next_to_deliver;
+    }
+    seg.delivering = false;
+  };
+
+  // runs the morsels of a segment in order
+  auto run_owned_segment = [&](size_t segment_idx) {
+    morsel_segment& seg = *segments[segment_idx];
+    while(!failed) {
+      size_t morsel_idx;
+      {
+        std::lock_guard<turi::mutex> guard(seg.lock);
+        seg.started = true;
+        if (seg.pending.empty() || seg.stopped) break;
+        morsel_idx = seg.pending.front();
+        seg.pending.pop_front();
+        ASSERT_EQ(morsel_idx, seg.next_to_deliver);
+      }
+      bool stopped = false;
+      run_morsel(morsel_idx,
+                 [&](size_t, const std::shared_ptr<sframe_rows>& rows) {
+                   stopped = deliver_fn(segment_idx, rows);
+                   return stopped;
+                 });
+      {
+        std::lock_guard<turi::mutex> guard(seg.lock);
+        seg.stopped = seg.stopped || stopped;
+        ++seg.next_to_deliver;
+      }
+      flush(segment_idx);
+    }
+  };
+
+  // takes the last pending morsel of the busiest segment
+  auto steal = [&](size_t& segment_idx, size_t& morsel_idx)->bool {
+    while(!failed && buffered_rows.value < SFRAME_MORSEL_MAX_BUFFERED_ROWS) {
+      size_t victim = num_segments;
+      size_t victim_pending = 0;
+      for (size_t i = 0; i < num_segments; ++i) {
+        std::lock_guard<turi::mutex> guard(segments[i]->lock);
+        if (segments[i]->started && !segments[i]->stopped &&
+            segments[i]->pending.size() > victim_pending) {
+          victim = i;
+          victim_pending = segments[i]->pending.size();
+        }
+      }
+      if (victim == num_segments) return false;
+      std::lock_guard<turi::mutex> guard(segments[victim]->lock);
+      if (segments[victim]->pending.empty()) continue;
+      segment_idx = victim;
+      morsel_idx = segments[victim]->pending.back();
+      segments[victim]->pending.pop_back();
+      return true;
+    }
+    return false;
+  };
+
+  auto run_stolen_morsel = [&](size_t segment_idx, size_t morsel_idx) {
+    morsel_segment& seg = *segments[segment_idx];
+    std::vector<std::shared_ptr<sframe_rows>> rows;
+    run_morsel(morsel_idx,
+               [&](size_t, const std::shared_ptr<sframe_rows>& r) {
+                 // the operator reuses its output buffer. Keep a copy on
+                 // write reference to the contents instead.
+                 rows.push_back(std::make_shared<sframe_rows>(*r));
+                 buffered_rows.inc(r->num_rows());
+                 return false;
+               });
+    {
+      std::lock_guard<turi::mutex> guard(seg.lock);
+      seg.completed[morsel_idx] = std::move(rows);
+    }
+    flush(segment_idx);
+  };
+
+  // Stealing only helps if the workers actually run concurrently.
+  size_t num_workers = std::min(thread_pool::get_instance().size(), num_segments);
+  bool can_steal = !thread::get_tls_data().is_in_thread() && num_workers > 1;
+
+  // Under contention, fewer workers may get as much done.
+  std::unique_ptr<parallelism_measurement> measurement;
+  if (can_steal && SFRAME_ADAPTIVE_PARALLELISM) {
+    num_workers = parallelism_controller::get_instance().recommended_workers(num_workers);
+    measurement.reset(new parallelism_measurement(num_workers));
+  }
+
+  auto worker = [&]() {
+    try {
+      while(!failed) {
+        size_t segment_idx = next_segment.inc_ret_last();
+        if (segment_idx >= num_segments) break;
+        run_owned_segment(segment_idx);
+      }
+      size_t segment_idx, morsel_idx;
+      while(can_steal && steal(segment_idx, morsel_idx)) {
+        run_stolen_morsel(segment_idx, morsel_idx);
+      }
+    } catch (...) {
+      std::lock_guard<turi::mutex> guard(error_lock);
+      if (error == nullptr) error = std::current_exception();
+      failed = true;
+    }
+  };
+
+  if (can_steal) {
+    parallel_task_queue threads(thread_pool::get_instance());
+    for (size_t i = 0; i < num_workers; ++i) threads.launch(worker, i);
+    threads.join();
+  } else {
+    worker();
+  }
+  if (error != nullptr) std::rethrow_exception(error);
+
+  if (exec_params.write_callback == nullptr) ret.close();
+  return ret;
+}
+
 }}
@@ -84,6 +84,42 @@ class subplan_executor {
       const std::vector<std::shared_ptr<planner_node> >& stuff_to_run_in_parallel,
       const materialize_options& exec_params = materialize_options());
 
+  /**
+   * Runs a parallel sliceable planner node as num_segments segments,
+   * returning an SFrame with num_segments segments (or streaming segment i
+   * into the write callback with segment id i).
+   *
+   * The result is exactly that of \ref run_concat on the segmented graphs,
+   * but each segment is further split into morsels_per_segment morsels
+   * which are scheduled dynamically: each worker runs the morsels of a
+   * segment in order, and idle workers steal the last remaining morsels of
+   * busy segments. The output of a stolen morsel is held in memory until
+   * the rows before it have been written, so that the rows of each segment
+   * are still written in order, by one thread at a time.
+   */
+  sframe run_morsels(
+      const std::shared_ptr<planner_node>& run_this,
+      size_t num_segments,
+      size_t morsels_per_segment,
+      const materialize_options& exec_params = materialize_options());
+
+  /**
+   * Runs several plans in a single pass, returning an SFrame for each of
+   * them. segments[i][j] is segment i of plan j, as made by
+   * make_segmented_graph with one memo per segment, so that the nodes the
+   * plans share are still shared by their segments. The segments are run in
+   * parallel; each returned SFrame has segments.size() segments.
+   *
+   * The nodes shared by the plans, such as a source they all read, are
+   * executed once, their output going to every plan reading it. A plan
+   * ending in a reduce node is reduced as the rows of its input arrive.
+   *
+   * The write callback and output location of exec_params are ignored.
+   */
+  std::vector<sframe> run_shared(
+      const std::vector<std::vector<std::shared_ptr<planner_node>>>& segments,
+      const materialize_options& exec_params = materialize_options());
+
  private:
 
  /**
@@ -92,16 +128,41 @@ class subplan_executor {
   */
   void generate_to_sframe_segment(const std::shared_ptr<planner_node>& run_this,
                                   sframe& out,
-                                  size_t output_segment_id);
+                                  size_t output_segment_id,
+                                  const materialize_options& exec_params,
+                                  size_t profile_stage);
 
   /**
    * \internal
    * Runs a single job sequentially, calling the callback on each output.
+   * If exec_params.profile is set, the operators executed are added to
+   * its stage profile_stage.
    */
   void generate_to_callback_function(
     const std::shared_ptr<planner_node>& plan,
     size_t output_segment_id,
-    execution_callback out_f);
+    execution_callback out_f,
+    const materialize_options& exec_params,
+    size_t profile_stage);
+
+  /**
+   * \internal
+   * Runs several jobs sequentially and together, calling out_functions[i]
+   * on each output of plans[i]. The nodes shared by the plans are executed
+   * once.
+   */
+  void generate_to_callback_functions(
+    const std::vector<std::shared_ptr<planner_node>>& plans,
+    size_t output_segment_id,
+    const std::vector<execution_callback>& out_functions,
+    const materialize_options& exec_params,
+    size_t profile_stage);
+
+  /**
+   * \internal
+   * Starts a new stage of exec_params.profile, if set.
+   */
+  size_t begin_profile_stage(const materialize_options& exec_params);
 };
 
 /// \}
@@ -24,6 +24,11 @@
 #endif
 #include <core/storage/query_engine/operators/optonly_identity_operator.hpp>
 #include <core/storage/query_engine/operators/ternary_operator.hpp>
+#include <core/storage/query_engine/operators/merge_join.hpp>
+#include <core/storage/query_engine/operators/topk.hpp>
+#include <core/storage/query_engine/operators/parquet_source.hpp>
+#include <core/storage/query_engine/operators/columnwise_transform.hpp>
+#include <core/storage/query_engine/operators/sarray_predicate_source.hpp>
 
 
 #endif /* TURI_SFRAME_QUERY_ALL_OPERATORS_H_ */
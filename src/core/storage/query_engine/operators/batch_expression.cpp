@@ -0,0 +1,445 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <cmath>
+#include <cstdint>
+#include <core/logging/assertions.hpp>
+#include <core/storage/query_engine/operators/batch_expression.hpp>
+
+namespace turi {
+namespace query_eval {
+
+namespace {
+
+enum class opcode {
+  ADD, SUBTRACT, MULTIPLY, DIVIDE,
+  LT, GT, LE, GE, EQ, NE,
+  AND, OR,
+  INVALID
+};
+
+opcode get_opcode(const std::string& op) {
+  if (op == "+") return opcode::ADD;
+  if (op == "-") return opcode::SUBTRACT;
+  if (op == "*") return opcode::MULTIPLY;
+  if (op == "/") return opcode::DIVIDE;
+  if (op == "<") return opcode::LT;
+  if (op == ">") return opcode::GT;
+  if (op == "<=") return opcode::LE;
+  if (op == ">=") return opcode::GE;
+  if (op == "==") return opcode::EQ;
+  if (op == "!=") return opcode::NE;
+  if (op == "&") return opcode::AND;
+  if (op == "|") return opcode::OR;
+  return opcode::INVALID;
+}
+
+/**
+ * The values of one expression node over a batch.
+ *
+ * Lanes with is_typed set hold their value in ints or floats (depending on
+ * type). Typed FLOAT lanes are never NaN. All other lanes hold their value
+ * in values, which is only allocated once the first such lane appears.
+ */
+struct typed_column {
+  flex_type_enum type = flex_type_enum::INTEGER;
+  size_t length = 0;
+  std::vector<int64_t> ints;
+  std::vector<double> floats;
+  std::vector<uint8_t> is_typed;
+  std::vector<flexible_type> values;
+  size_t num_untyped = 0;
+
+  void reset(flex_type_enum t, size_t n) {
+    type = t;
+    length = n;
+    if (type == flex_type_enum::INTEGER) ints.resize(n);
+    else floats.resize(n);
+    is_typed.assign(n, 1);
+    values.clear();
+    num_untyped = 0;
+  }
+
+  void set_untyped(size_t i, const flexible_type& v) {
+    if (values.empty()) values.resize(length);
+    if (is_typed[i]) {
+      is_typed[i] = 0;
+      ++num_untyped;
+    }
+    values[i] = v;
+  }
+
+  /// Stores a value produced by a scalar function, in a typed lane if possible.
+  void set_value(size_t i, const flexible_type& v) {
+    if (type == flex_type_enum::INTEGER &&
+        v.get_type() == flex_type_enum::INTEGER) {
+      ints[i] = v.get<flex_int>();
+      mark_typed(i);
+    } else if (type == flex_type_enum::FLOAT &&
+               v.get_type() == flex_type_enum::FLOAT &&
+               !std::isnan(v.get<flex_float>())) {
+      floats[i] = v.get<flex_float>();
+      mark_typed(i);
+    } else {
+      set_untyped(i, v);
+    }
+  }
+
+  void mark_typed(size_t i) {
+    if (!is_typed[i]) {
+      is_typed[i] = 1;
+      --num_untyped;
+    }
+  }
+
+  flexible_type get(size_t i) const {
+    if (!is_typed[i]) return values[i];
+    if (type == flex_type_enum::INTEGER) return flex_int(ints[i]);
+    return flex_float(floats[i]);
+  }
+
+  /**
+   * Returns the lanes as doubles; INTEGER lanes are converted into scratch.
+   */
+  const double* as_floats(std::vector<double>& scratch) const {
+    if (type == flex_type_enum::FLOAT) return floats.data();
+    scratch.resize(length);
+    for (size_t i = 0; i < length; ++i) scratch[i] = (double)ints[i];
+    return scratch.data();
+  }
+};
+
+template <typename T, typename R, typename Fn>
+inline void apply_kernel(const T* a, const T* b, R* out, size_t n, Fn fn) {
+  for (size_t i = 0; i < n; ++i) out[i] = fn(a[i], b[i]);
+}
+
+/**
+ * Computes every typed lane of a comparison or boolean operator.
+ */
+template <typename T>
+void compare_kernel(opcode op, const T* a, const T* b, int64_t* out, size_t n) {
+  switch(op) {
+   case opcode::LT: apply_kernel(a, b, out, n, [](T x, T y)->int64_t { return x < y; }); break;
+   case opcode::GT: apply_kernel(a, b, out, n, [](T x, T y)->int64_t { return x > y; }); break;
+   case opcode::LE: apply_kernel(a, b, out, n, [](T x, T y)->int64_t { return x <= y; }); break;
+   case opcode::GE: apply_kernel(a, b, out, n, [](T x, T y)->int64_t { return x >= y; }); break;
+   case opcode::EQ: apply_kernel(a, b, out, n, [](T x, T y)->int64_t { return x == y; }); break;
+   case opcode::NE: apply_kernel(a, b, out, n, [](T x, T y)->int64_t { return x != y; }); break;
+   case opcode::AND:
+     apply_kernel(a, b, out, n, [](T x, T y)->int64_t { return (x != 0) & (y != 0); });
+     break;
+   case opcode::OR:
+     apply_kernel(a, b, out, n, [](T x, T y)->int64_t { return (x != 0) | (y != 0); });
+     break;
+   default:
+     ASSERT_TRUE(false);
+  }
+}
+
+void compute_binary(opcode op, const typed_column& a, const typed_column& b,
+                    typed_column& out) {
+  const size_t n = out.length;
+  bool both_int = a.type == flex_type_enum::INTEGER &&
+                  b.type == flex_type_enum::INTEGER;
+  std::vector<double> scratch_a, scratch_b;
+  switch(op) {
+   case opcode::ADD:
+   case opcode::SUBTRACT:
+   case opcode::MULTIPLY:
+     if (both_int) {
+       // integer arithmetic wraps around on overflow
+       const int64_t* x = a.ints.data();
+       const int64_t* y = b.ints.data();
+       int64_t* z = out.ints.data();
+       if (op == opcode::ADD) {
+         apply_kernel(x, y, z, n, [](int64_t p, int64_t q)->int64_t {
+           return (int64_t)((uint64_t)p + (uint64_t)q); });
+       } else if (op == opcode::SUBTRACT) {
+         apply_kernel(x, y, z, n, [](int64_t p, int64_t q)->int64_t {
+           return (int64_t)((uint64_t)p - (uint64_t)q); });
+       } else {
+         apply_kernel(x, y, z, n, [](int64_t p, int64_t q)->int64_t {
+           return (int64_t)((uint64_t)p * (uint64_t)q); });
+       }
+       break;
+     }
+     // fall through to the floating point kernels
+   case opcode::DIVIDE: {
+     const double* x = a.as_floats(scratch_a);
+     const double* y = b.as_floats(scratch_b);
+     double* z = out.floats.data();
+     switch(op) {
+      case opcode::ADD: apply_kernel(x, y, z, n, [](double p, double q) { return p + q; }); break;
+      case opcode::SUBTRACT: apply_kernel(x, y, z, n, [](double p, double q) { return p - q; }); break;
+      case opcode::MULTIPLY: apply_kernel(x, y, z, n, [](double p, double q) { return p * q; }); break;
+      default: apply_kernel(x, y, z, n, [](double p, double q) { return p / q; }); break;
+     }
+     break;
+   }
+   default:
+     if (both_int) {
+       compare_kernel(op, a.ints.data(), b.ints.data(), out.ints.data(), n);
+     } else {
+       compare_kernel(op, a.as_floats(scratch_a), b.as_floats(scratch_b),
+                      out.ints.data(), n);
+     }
+  }
+}
+
+/**
+ * Computes every typed lane of a cast. Lanes which cannot be cast exactly
+ * the way soft_assign would have are cleared in ok.
+ */
+void compute_cast(const typed_column& a, typed_column& out,
+                  std::vector<uint8_t>& ok) {
+  const size_t n = out.length;
+  ok.assign(n, 1);
+  if (a.type == out.type) {
+    if (a.type == flex_type_enum::INTEGER) out.ints = a.ints;
+    else out.floats = a.floats;
+  } else if (out.type == flex_type_enum::FLOAT) {
+    for (size_t i = 0; i < n; ++i) out.floats[i] = (double)a.ints[i];
+  } else {
+    // values outside of the int64 range (and NaNs) use the scalar cast
+    const double* x = a.floats.data();
+    int64_t* z = out.ints.data();
+    for (size_t i = 0; i < n; ++i) {
+      bool in_range = x[i] > -9.2e18 && x[i] < 9.2e18;
+      z[i] = in_range ? (int64_t)x[i] : 0;
+      ok[i] = in_range;
+    }
+  }
+}
+
+void evaluate_node(const batch_expression& expr,
+                   const sframe_rows* const* inputs,
+                   size_t n,
+                   typed_column& out) {
+  typedef batch_expression::node_type node_type;
+  switch(expr.type) {
+   case node_type::INPUT: {
+     const auto& column = *(inputs[expr.input_index]->cget_columns()[0]);
+     out.reset(expr.value_type, n);
+     if (out.type == flex_type_enum::INTEGER) {
+       for (size_t i = 0; i < n; ++i) {
+         const flexible_type& v = column[i];
+         if (v.get_type() == flex_type_enum::INTEGER) {
+           out.ints[i] = v.get<flex_int>();
+         } else {
+           out.ints[i] = 0;
+           out.set_untyped(i, v);
+         }
+       }
+     } else {
+       for (size_t i = 0; i < n; ++i) {
+         const flexible_type& v = column[i];
+         if (v.get_type() == flex_type_enum::FLOAT &&
+             !std::isnan(v.get<flex_float>())) {
+           out.floats[i] = v.get<flex_float>();
+         } else {
+           out.floats[i] = 0;
+           out.set_untyped(i, v);
+         }
+       }
+     }
+     break;
+   }
+   case node_type::CONSTANT: {
+     out.reset(expr.value_type, n);
+     for (size_t i = 0; i < n; ++i) out.set_value(i, expr.constant);
+     break;
+   }
+   case node_type::CAST: {
+     typed_column child;
+     evaluate_node(*expr.left, inputs, n, child);
+     out.reset(expr.value_type, n);
+     std::vector<uint8_t> ok;
+     compute_cast(child, out, ok);
+     for (size_t i = 0; i < n; ++i) {
+       if (!child.is_typed[i] || !ok[i]) {
+         out.set_value(i, expr.scalar_fn(child.get(i), FLEX_UNDEFINED));
+       }
+     }
+     break;
+   }
+   case node_type::BINARY_OP: {
+     typed_column a, b;
+     evaluate_node(*expr.left, inputs, n, a);
+     evaluate_node(*expr.right, inputs, n, b);
+     out.reset(expr.value_type, n);
+     compute_binary(get_opcode(expr.op), a, b, out);
+     bool is_float = out.type == flex_type_enum::FLOAT;
+     if (a.num_untyped == 0 && b.num_untyped == 0 && !is_float) break;
+     for (size_t i = 0; i < n; ++i) {
+       if (!a.is_typed[i] || !b.is_typed[i]) {
+         out.set_value(i, expr.scalar_fn(a.get(i), b.get(i)));
+       } else if (is_float && std::isnan(out.floats[i])) {
+         out.set_untyped(i, flex_float(out.floats[i]));
+       }
+     }
+     break;
+   }
+  }
+}
+
+void evaluate_to_output(const batch_expression& expr,
+                        const sframe_rows* const* inputs,
+                        size_t n,
+                        std::vector<flexible_type>& out) {
+  out.resize(n);
+  if (n == 0) return;
+  typed_column result;
+  evaluate_node(expr, inputs, n, result);
+  if (result.type == flex_type_enum::INTEGER) {
+    for (size_t i = 0; i < n; ++i) {
+      if (result.is_typed[i]) out[i] = flex_int(result.ints[i]);
+      else out[i] = result.values[i];
+    }
+  } else {
+    for (size_t i = 0; i < n; ++i) {
+      if (result.is_typed[i]) out[i] = flex_float(result.floats[i]);
+      else out[i] = result.values[i];
+    }
+  }
+}
+
+flexible_type evaluate_row_impl(const batch_expression& expr,
+                                const sframe_rows::row* const* rows) {
+  typedef batch_expression::node_type node_type;
+  switch(expr.type) {
+   case node_type::INPUT:
+     return (*rows[expr.input_index])[0];
+   case node_type::CONSTANT:
+     return expr.constant;
+   case node_type::CAST:
+     return expr.scalar_fn(evaluate_row_impl(*expr.left, rows), FLEX_UNDEFINED);
+   case node_type::BINARY_OP:
+   default:
+     return expr.scalar_fn(evaluate_row_impl(*expr.left, rows),
+                           evaluate_row_impl(*expr.right, rows));
+  }
+}
+
+} // anonymous namespace
+
+
+bool batch_expression::supports_type(flex_type_enum t) {
+  return t == flex_type_enum::INTEGER || t == flex_type_enum::FLOAT;
+}
+
+bool batch_expression::supports_operator(const std::string& op,
+                                         flex_type_enum left,
+                                         flex_type_enum right) {
+  return supports_type(left) && supports_type(right) &&
+      get_opcode(op) != opcode::INVALID;
+}
+
+batch_expression_ptr batch_expression::make_input(size_t input_index,
+                                                  flex_type_enum type) {
+  ASSERT_TRUE(supports_type(type));
+  auto ret = std::make_shared<batch_expression>();
+  ret->type = node_type::INPUT;
+  ret->value_type = type;
+  ret->input_index = input_index;
+  return ret;
+}
+
+batch_expression_ptr batch_expression::make_constant(const flexible_type& value) {
+  ASSERT_TRUE(supports_type(value.get_type()));
+  auto ret = std::make_shared<batch_expression>();
+  ret->type = node_type::CONSTANT;
+  ret->value_type = value.get_type();
+  ret->constant = value;
+  return ret;
+}
+
+batch_expression_ptr batch_expression::make_cast(batch_expression_ptr child,
+                                                 flex_type_enum type,
+                                                 batch_scalar_fn fn) {
+  ASSERT_TRUE(supports_type(type));
+  auto ret = std::make_shared<batch_expression>();
+  ret->type = node_type::CAST;
+  ret->value_type = type;
+  ret->left = child;
+  ret->scalar_fn = fn;
+  return ret;
+}
+
+batch_expression_ptr batch_expression::make_binary(const std::string& op,
+                                                   batch_expression_ptr left,
+                                                   batch_expression_ptr right,
+                                                   batch_scalar_fn fn) {
+  ASSERT_TRUE(supports_operator(op, left->value_type, right->value_type));
+  auto ret = std::make_shared<batch_expression>();
+  ret->type = node_type::BINARY_OP;
+  ret->op = op;
+  switch(get_opcode(op)) {
+   case opcode::ADD:
+   case opcode::SUBTRACT:
+   case opcode::MULTIPLY:
+     ret->value_type = (left->value_type == flex_type_enum::INTEGER &&
+                        right->value_type == flex_type_enum::INTEGER) ?
+                       flex_type_enum::INTEGER : flex_type_enum::FLOAT;
+     break;
+   case opcode::DIVIDE:
+     ret->value_type = flex_type_enum::FLOAT;
+     break;
+   default:
+     // comparison and boolean operators return integers
+     ret->value_type = flex_type_enum::INTEGER;
+  }
+  ret->left = left;
+  ret->right = right;
+  ret->scalar_fn = fn;
+  return ret;
+}
+
+batch_expression_ptr batch_expression::with_input(size_t new_index) const {
+  auto ret = std::make_shared<batch_expression>(*this);
+  if (type == node_type::INPUT) ret->input_index = new_index;
+  if (left) ret->left = left->with_input(new_index);
+  if (right) ret->right = right->with_input(new_index);
+  return ret;
+}
+
+bool batch_expression::uses_second_input() const {
+  if (type == node_type::INPUT) return input_index == 1;
+  return (left && left->uses_second_input()) ||
+         (right && right->uses_second_input());
+}
+
+size_t batch_expression::num_nodes() const {
+  return 1 + (left ? left->num_nodes() : 0) + (right ? right->num_nodes() : 0);
+}
+
+flexible_type batch_expression::evaluate_row(const sframe_rows::row& row) const {
+  const sframe_rows::row* rows[1] = {&row};
+  return evaluate_row_impl(*this, rows);
+}
+
+flexible_type batch_expression::evaluate_row(const sframe_rows::row& left,
+                                             const sframe_rows::row& right) const {
+  const sframe_rows::row* rows[2] = {&left, &right};
+  return evaluate_row_impl(*this, rows);
+}
+
+void batch_expression::evaluate_batch(const sframe_rows& rows,
+                                      std::vector<flexible_type>& out) const {
+  ASSERT_FALSE(uses_second_input());
+  const sframe_rows* inputs[1] = {&rows};
+  evaluate_to_output(*this, inputs, rows.num_rows(), out);
+}
+
+void batch_expression::evaluate_batch(const sframe_rows& left,
+                                      const sframe_rows& right,
+                                      std::vector<flexible_type>& out) const {
+  ASSERT_EQ(left.num_rows(), right.num_rows());
+  const sframe_rows* inputs[2] = {&left, &right};
+  evaluate_to_output(*this, inputs, left.num_rows(), out);
+}
+
+} // query_eval
+} // turi
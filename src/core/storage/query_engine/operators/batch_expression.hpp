@@ -0,0 +1,141 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_QUERY_MANAGER_BATCH_EXPRESSION_HPP
+#define TURI_SFRAME_QUERY_MANAGER_BATCH_EXPRESSION_HPP
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/storage/sframe_data/sframe_rows.hpp>
+
+namespace turi {
+namespace query_eval {
+
+/**
+ * \ingroup sframe_query_engine
+ * \addtogroup operators Logical Operators
+ * \{
+ */
+
+struct batch_expression;
+typedef std::shared_ptr<const batch_expression> batch_expression_ptr;
+
+/**
+ * The scalar implementation of a \ref batch_expression node. For a BINARY_OP
+ * node this is called with the values of the two children. For a CAST node
+ * this is called with the value of the child, and an UNDEFINED second
+ * argument.
+ */
+typedef std::function<flexible_type(const flexible_type&,
+                                    const flexible_type&)> batch_scalar_fn;
+
+/**
+ * A numeric expression tree over the first column of one or two input
+ * streams, which can be evaluated a whole \ref sframe_rows batch at a time.
+ *
+ * The transform and binary transform operators evaluate their function
+ * once per row through a std::function. For the arithmetic, comparison,
+ * boolean and cast expressions built by unity_sarray, the same computation
+ * can instead be done by a handful of tight loops over contiguous int64 /
+ * double buffers, which avoids the per-row call and type dispatch, and which
+ * the compiler vectorizes. Chains of such operations (sa * 2 + sb > c) are
+ * fused by unity_sarray into a single expression.
+ *
+ * Only INTEGER and FLOAT values take the batch kernels. Every other value
+ * (UNDEFINED, NaN, or a value of an unexpected type) falls back to the
+ * scalar function of the node, so the result is always identical to
+ * evaluating the scalar functions row by row.
+ */
+struct batch_expression {
+  enum class node_type {
+    INPUT,      ///< The first column of input stream input_index
+    CONSTANT,   ///< A constant value
+    CAST,       ///< Converts the child (left) to value_type
+    BINARY_OP   ///< Applies op to the children (left, right)
+  };
+
+  node_type type = node_type::CONSTANT;
+  /// The type of the values produced. Always INTEGER or FLOAT.
+  flex_type_enum value_type = flex_type_enum::UNDEFINED;
+  size_t input_index = 0;
+  flexible_type constant;
+  std::string op;
+  batch_expression_ptr left, right;
+  batch_scalar_fn scalar_fn;
+
+  /// Returns true if values of this type can be computed by batch kernels.
+  static bool supports_type(flex_type_enum t);
+
+  /**
+   * Returns true if the binary operator op of unity_sarray_binary_operations
+   * between values of the given types can be computed by batch kernels.
+   */
+  static bool supports_operator(const std::string& op,
+                                flex_type_enum left,
+                                flex_type_enum right);
+
+  static batch_expression_ptr make_input(size_t input_index,
+                                         flex_type_enum type);
+
+  static batch_expression_ptr make_constant(const flexible_type& value);
+
+  static batch_expression_ptr make_cast(batch_expression_ptr child,
+                                        flex_type_enum type,
+                                        batch_scalar_fn fn);
+
+  /**
+   * Builds op(left, right). supports_operator(op, left->value_type,
+   * right->value_type) must be true. fn must compute the operator on a pair
+   * of values, including all UNDEFINED handling, as unity_sarray does:
+   * expressions of equal structure are assumed to compute the same values
+   * (see \ref materialization_cache).
+   */
+  static batch_expression_ptr make_binary(const std::string& op,
+                                          batch_expression_ptr left,
+                                          batch_expression_ptr right,
+                                          batch_scalar_fn fn);
+
+  /**
+   * Returns a copy of the expression in which every INPUT node reads from
+   * input stream new_index.
+   */
+  batch_expression_ptr with_input(size_t new_index) const;
+
+  /// Returns true if any INPUT node reads from input stream 1.
+  bool uses_second_input() const;
+
+  /// The number of nodes in the expression.
+  size_t num_nodes() const;
+
+  /// Evaluates the expression on a single row from a single input stream.
+  flexible_type evaluate_row(const sframe_rows::row& row) const;
+
+  /// Evaluates the expression on a single row from two input streams.
+  flexible_type evaluate_row(const sframe_rows::row& left,
+                             const sframe_rows::row& right) const;
+
+  /**
+   * Evaluates the expression on every row of a batch from a single input
+   * stream. out is resized to the number of rows.
+   */
+  void evaluate_batch(const sframe_rows& rows,
+                      std::vector<flexible_type>& out) const;
+
+  /**
+   * Evaluates the expression on every row of a pair of batches of the same
+   * length. out is resized to the number of rows.
+   */
+  void evaluate_batch(const sframe_rows& left,
+                      const sframe_rows& right,
+                      std::vector<flexible_type>& out) const;
+};
+
+/// \}
+} // query_eval
+} // turi
+
+#endif
@@ -12,6 +12,7 @@
 #include <core/storage/query_engine/operators/operator.hpp>
 #include <core/storage/query_engine/execution/query_context.hpp>
 #include <core/storage/query_engine/operators/operator_properties.hpp>
+#include <core/storage/query_engine/operators/batch_expression.hpp>
 #include <core/util/coro.hpp>
 
 namespace turi {
@@ -29,6 +30,10 @@ typedef std::function<flexible_type(const sframe_rows::row&,
 /**
  * A "binary transform" operator applys a transform function on two
  * stream of input.
+ *
+ * If a \ref batch_expression computing the same function is provided, each
+ * pair of batches is evaluated by the expression instead of calling the
+ * transform function once per row.
  */
 template<>
 class operator_impl<planner_node_type::BINARY_TRANSFORM_NODE> : public query_operator {
@@ -52,8 +57,9 @@ class operator_impl<planner_node_type::BINARY_TRANSFORM_NODE> : public query_ope
   }
 
   inline operator_impl(const binary_transform_type& f,
-                       flex_type_enum output_type)
-      : m_transform_fn(f)
+                       flex_type_enum output_type,
+                       batch_expression_ptr expression=nullptr)
+      : m_transform_fn(f), m_expression(expression)
   { }
 
   inline std::shared_ptr<query_operator> clone() const {
@@ -76,14 +82,20 @@ class operator_impl<planner_node_type::BINARY_TRANSFORM_NODE> : public query_ope
       output_buffer = context.get_output_buffer();
       output_buffer->resize(1, rows_left->num_rows());
 
-      left_iter = rows_left->cbegin();
-      right_iter = rows_right->cbegin();
-      out_iter = output_buffer->begin();
-      while(left_iter != rows_left->cend()) {
-        (*out_iter)[0] = m_transform_fn((*left_iter), (*right_iter));
-        ++left_iter;
-        ++right_iter;
-        ++out_iter;
+      if (m_expression) {
+        // the whole batch at once
+        m_expression->evaluate_batch(*rows_left, *rows_right,
+                                     *(output_buffer->get_columns()[0]));
+      } else {
+        left_iter = rows_left->cbegin();
+        right_iter = rows_right->cbegin();
+        out_iter = output_buffer->begin();
+        while(left_iter != rows_left->cend()) {
+          (*out_iter)[0] = m_transform_fn((*left_iter), (*right_iter));
+          ++left_iter;
+          ++right_iter;
+          ++out_iter;
+        }
       }
       context.emit(output_buffer);
       }
@@ -96,11 +108,14 @@ class operator_impl<planner_node_type::BINARY_TRANSFORM_NODE> : public query_ope
       std::shared_ptr<planner_node> left,
       std::shared_ptr<planner_node> right,
         binary_transform_type fn,
-      flex_type_enum output_type) {
+      flex_type_enum output_type,
+      batch_expression_ptr expression=nullptr) {
 
+    std::map<std::string, any> any_params{{"function", any(fn)}};
+    if (expression) any_params["batch_expression"] = any(expression);
     return planner_node::make_shared(planner_node_type::BINARY_TRANSFORM_NODE,
                                      {{"output_type", (int)(output_type)}},
-                                     {{"function", any(fn)}},
+                                     any_params,
                                      {left, right});
   }
 
@@ -116,7 +131,12 @@ class operator_impl<planner_node_type::BINARY_TRANSFORM_NODE> : public query_ope
         (flex_type_enum)(flex_int)(pnode->operator_parameters["output_type"]);
 
     fn = pnode->any_operator_parameters["function"].as<binary_transform_type>();
-    return std::make_shared<operator_impl>(fn, output_type);
+    batch_expression_ptr expression;
+    if (pnode->any_operator_parameters.count("batch_expression")) {
+      expression = pnode->any_operator_parameters["batch_expression"]
+                       .as<batch_expression_ptr>();
+    }
+    return std::make_shared<operator_impl>(fn, output_type, expression);
   }
 
   static std::vector<flex_type_enum> infer_type(std::shared_ptr<planner_node> pnode) {
@@ -132,6 +152,7 @@ class operator_impl<planner_node_type::BINARY_TRANSFORM_NODE> : public query_ope
 
  private:
    binary_transform_type m_transform_fn;
+   batch_expression_ptr m_expression;
 };
 
 typedef operator_impl<planner_node_type::BINARY_TRANSFORM_NODE> op_binary_transform;
@@ -0,0 +1,170 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_QUERY_MANAGER_COLUMNWISE_TRANSFORM_HPP
+#define TURI_SFRAME_QUERY_MANAGER_COLUMNWISE_TRANSFORM_HPP
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/storage/query_engine/operators/operator.hpp>
+#include <core/storage/query_engine/execution/query_context.hpp>
+#include <core/storage/query_engine/operators/operator_properties.hpp>
+#include <core/util/coro.hpp>
+
+namespace turi {
+namespace query_eval {
+
+/**
+ * Computes a column of a batch from the same column of the input batch.
+ * out is already resized to in.size().
+ */
+typedef std::function<void(const std::vector<flexible_type>& in,
+                           std::vector<flexible_type>& out)> columnwise_kernel;
+
+/**
+ * \ingroup sframe_query_engine
+ * \addtogroup operators Logical Operators
+ * \{
+ */
+
+/**
+ * The columnwise transform operator computes every output column from the
+ * input column at the same position, with a kernel of its own applied to
+ * the whole column of a batch at once. Columns without a kernel are passed
+ * through without being copied.
+ *
+ * This replaces one transform per column (and the union of all of them) by
+ * a single operator when the same kind of operation (fillna for instance)
+ * is applied to many columns of an SFrame.
+ */
+template<>
+class operator_impl<planner_node_type::COLUMNWISE_TRANSFORM_NODE> : public query_operator {
+ public:
+  DECL_CORO_STATE(execute);
+
+  planner_node_type type() const { return planner_node_type::COLUMNWISE_TRANSFORM_NODE; }
+
+  static std::string name() { return "columnwise_transform"; }
+
+  static query_operator_attributes attributes() {
+    query_operator_attributes ret;
+    ret.attribute_bitfield = query_operator_attributes::LINEAR;
+    ret.num_inputs = 1;
+    return ret;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+
+  inline operator_impl(const std::vector<columnwise_kernel>& kernels,
+                       const std::vector<flex_type_enum>& output_types)
+      : m_kernels(kernels), m_output_types(output_types) {
+    // only the computed columns are type checked
+    m_checked_types.resize(m_kernels.size(), flex_type_enum::UNDEFINED);
+    for (size_t i = 0; i < m_kernels.size(); ++i) {
+      if (m_kernels[i]) m_checked_types[i] = m_output_types[i];
+    }
+  }
+
+  inline std::shared_ptr<query_operator> clone() const {
+    return std::make_shared<operator_impl>(*this);
+  }
+
+  inline bool coro_running() const {
+    return CORO_RUNNING(execute);
+  }
+
+  inline void execute(query_context& context) {
+    CORO_BEGIN(execute)
+    while(1) {
+      {
+        auto rows = context.get_next(0);
+        if (rows == nullptr)
+          break;
+        const auto& in_columns = rows->cget_columns();
+        size_t num_rows = rows->num_rows();
+        auto output = context.get_output_buffer();
+        output->clear();
+        auto& out_columns = output->get_columns();
+        for (size_t i = 0; i < m_kernels.size(); ++i) {
+          if (m_kernels[i]) {
+            auto column = std::make_shared<sframe_rows::decoded_column_type>(num_rows);
+            m_kernels[i](*in_columns[i], *column);
+            out_columns.push_back(std::move(column));
+          } else {
+            out_columns.push_back(in_columns[i]);
+          }
+        }
+        output->type_check_inplace(m_checked_types);
+        context.emit(output);
+      }
+      CORO_YIELD();
+    }
+    CORO_END
+  }
+
+  /**
+   * kernels[i] computes output column i from input column i of source, of
+   * type output_types[i]. An empty kernel passes the column through, and
+   * its output type must be the input type.
+   */
+  static std::shared_ptr<planner_node> make_planner_node(
+      std::shared_ptr<planner_node> source,
+      const std::vector<columnwise_kernel>& kernels,
+      const std::vector<flex_type_enum>& output_types) {
+    ASSERT_EQ(kernels.size(), output_types.size());
+    flex_list type_list(output_types.size());
+    for (size_t i = 0; i < output_types.size(); ++i) {
+      type_list[i] = flex_int(output_types[i]);
+    }
+    return planner_node::make_shared(planner_node_type::COLUMNWISE_TRANSFORM_NODE,
+                                     {{"output_types", type_list}},
+                                     {{"kernels", any(kernels)}},
+                                     {source});
+  }
+
+  static std::shared_ptr<query_operator> from_planner_node(
+      std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::COLUMNWISE_TRANSFORM_NODE);
+    ASSERT_EQ(pnode->inputs.size(), 1);
+    ASSERT_TRUE(pnode->any_operator_parameters.count("kernels"));
+    auto kernels = pnode->any_operator_parameters["kernels"].as<std::vector<columnwise_kernel>>();
+    return std::make_shared<operator_impl>(kernels, infer_type(pnode));
+  }
+
+  static std::vector<flex_type_enum> infer_type(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::COLUMNWISE_TRANSFORM_NODE);
+    ASSERT_TRUE(pnode->operator_parameters.count("output_types"));
+    flex_list outtypes = pnode->operator_parameters["output_types"];
+    std::vector<flex_type_enum> ret;
+    for (auto t: outtypes) ret.push_back((flex_type_enum)(flex_int)t);
+    return ret;
+  }
+
+  static int64_t infer_length(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::COLUMNWISE_TRANSFORM_NODE);
+    return infer_planner_node_length(pnode->inputs[0]);
+  }
+
+  static std::string repr(std::shared_ptr<planner_node> pnode, pnode_tagger&) {
+    const auto& kernels =
+        pnode->any_operator_parameters["kernels"].as<std::vector<columnwise_kernel>>();
+    size_t num_computed = 0;
+    for (const auto& k: kernels) num_computed += (bool)k;
+    std::ostringstream out;
+    out << "CTr(" << num_computed << "/" << kernels.size() << ")";
+    return out.str();
+  }
+
+ private:
+  std::vector<columnwise_kernel> m_kernels;
+  std::vector<flex_type_enum> m_output_types;
+  std::vector<flex_type_enum> m_checked_types;
+};
+
+typedef operator_impl<planner_node_type::COLUMNWISE_TRANSFORM_NODE> op_columnwise_transform;
+
+/// \}
+} // query_eval
+} // turi
+
+#endif // TURI_SFRAME_QUERY_MANAGER_COLUMNWISE_TRANSFORM_HPP
@@ -24,14 +24,19 @@ namespace query_eval {
  * A "logical_filter" operator which takes two inputs of the same size:
  * "values", and "logical indices", and output the value in "values" for which
  * the logical index is 1.
+ *
+ * The positions of the rows kept from each block are collected first, and
+ * only those rows are copied, one column at a time. A full block whose rows
+ * are all kept is forwarded without any copy.
  */
 template<>
 class operator_impl<planner_node_type::LOGICAL_FILTER_NODE> : public query_operator {
  public:
   DECL_CORO_STATE(execute);
   std::shared_ptr<const sframe_rows>  rows_left, rows_right;
-  sframe_rows::const_iterator left_iter, right_iter, out_iter;
   std::shared_ptr<sframe_rows>  output_buffer;
+  std::vector<size_t> selected;
+  size_t selected_pos = 0;
   size_t cur_output_index = 0;
   size_t ncols = 0;
   size_t nrows = 0;
@@ -57,8 +62,8 @@ class operator_impl<planner_node_type::LOGICAL_FILTER_NODE> : public query_opera
   // tests if the first column of col is all zeros
   bool is_all_zero(const std::shared_ptr<const sframe_rows>& col) {
     // if it is all zero, we can skip the left data
-    for (auto& row: *col) {
-      if (!(row[0].is_zero())) return false;
+    for (const auto& value: *(col->cget_columns()[0])) {
+      if (!value.is_zero()) return false;
     }
     return true;
   }
@@ -86,12 +91,43 @@ class operator_impl<planner_node_type::LOGICAL_FILTER_NODE> : public query_opera
       ASSERT_TRUE(rows_left != nullptr && rows_right != nullptr);
       ASSERT_EQ(rows_left->num_rows(), rows_right->num_rows());
 
-      left_iter = rows_left->cbegin();
-      right_iter = rows_right->cbegin();
-      while(left_iter != rows_left->cend()) {
-        if (!(*right_iter)[0].is_zero()) {
-          (*output_buffer)[cur_output_index] = (*left_iter);
-          ++cur_output_index;
+      // the selection vector of this block: the positions of the rows kept
+      selected.clear();
+      {
+        const auto& condition = *(rows_right->cget_columns()[0]);
+        for (size_t i = 0; i < condition.size(); ++i) {
+          if (!condition[i].is_zero()) selected.push_back(i);
+        }
+      }
+
+      if (cur_output_index == 0 && selected.size() == nrows) {
+        // a full block which passes entirely: forward its columns as is
+        output_buffer->get_columns() = rows_left->cget_columns();
+        context.emit(output_buffer);
+        CORO_YIELD();
+        // the forwarded columns are still shared with the input: replace
+        // them rather than overwrite them
+        output_buffer = context.get_output_buffer();
+        output_buffer->reset_columns(ncols);
+        output_buffer->resize(ncols, nrows);
+      } else {
+        // copy the selected rows a column at a time
+        selected_pos = 0;
+        while (selected_pos < selected.size()) {
+          {
+            size_t n = std::min(nrows - cur_output_index, selected.size() - selected_pos);
+            const auto& in_columns = rows_left->cget_columns();
+            auto& out_columns = output_buffer->get_columns();
+            for (size_t c = 0; c < ncols; ++c) {
+              const auto& in = *in_columns[c];
+              auto& out = *out_columns[c];
+              for (size_t i = 0; i < n; ++i) {
+                out[cur_output_index + i] = in[selected[selected_pos + i]];
+              }
+            }
+            selected_pos += n;
+            cur_output_index += n;
+          }
           if (cur_output_index == nrows) {
             context.emit(output_buffer);
             CORO_YIELD();
@@ -100,8 +136,6 @@ class operator_impl<planner_node_type::LOGICAL_FILTER_NODE> : public query_opera
             cur_output_index = 0;
           }
         }
-        ++left_iter;
-        ++right_iter;
       }
       has_data = false;
       do {
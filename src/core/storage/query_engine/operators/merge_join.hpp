@@ -0,0 +1,357 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_QUERY_MANAGER_MERGE_JOIN_HPP
+#define TURI_SFRAME_QUERY_MANAGER_MERGE_JOIN_HPP
+
+#include <sstream>
+#include <core/logging/assertions.hpp>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/storage/query_engine/operators/operator.hpp>
+#include <core/storage/query_engine/execution/query_context.hpp>
+#include <core/storage/query_engine/operators/operator_properties.hpp>
+#include <core/util/coro.hpp>
+
+namespace turi {
+namespace query_eval {
+
+/**
+ * \ingroup sframe_query_engine
+ * \addtogroup operators Logical Operators
+ * \{
+ */
+
+/**
+ * A "merge_join" operator joins two input streams which are both sorted in
+ * ascending order by their key columns; typedefed \ref op_merge_join.
+ *
+ * The output has all the columns of the left input, followed by the columns
+ * of the right input which are not keys, the same layout as \ref turi::join.
+ * The rows of a key are output in the order of the left rows, each followed
+ * by all the right rows with the same key. Right rows without a match get
+ * their keys in the key columns of the left input.
+ *
+ * The inputs are consumed in a single pass at their own rates, and no hash
+ * table is built. Only the right rows of the current key are held in memory.
+ * Keys must not contain UNDEFINED values; see \ref is_sorted_by().
+ */
+template<>
+class operator_impl<planner_node_type::MERGE_JOIN_NODE> : public query_operator {
+ public:
+  DECL_CORO_STATE(execute);
+
+  planner_node_type type() const { return planner_node_type::MERGE_JOIN_NODE; }
+  static std::string name() { return "merge_join"; }
+
+  inline operator_impl(const std::vector<size_t>& left_keys,
+                       const std::vector<size_t>& right_keys,
+                       size_t num_left_columns,
+                       size_t num_right_columns,
+                       bool left_join,
+                       bool right_join)
+      : m_left_keys(left_keys), m_right_keys(right_keys),
+        m_num_columns{num_left_columns, num_right_columns},
+        m_is_right_key(num_right_columns, false),
+        m_left_join(left_join), m_right_join(right_join) {
+    ASSERT_EQ(m_left_keys.size(), m_right_keys.size());
+    for (size_t key: m_left_keys) ASSERT_LT(key, num_left_columns);
+    for (size_t key: m_right_keys) {
+      ASSERT_LT(key, num_right_columns);
+      m_is_right_key[key] = true;
+    }
+    m_num_output_columns = num_left_columns + num_right_columns - m_right_keys.size();
+  }
+
+  static query_operator_attributes attributes() {
+    query_operator_attributes ret;
+    ret.attribute_bitfield = query_operator_attributes::NONE;
+    ret.num_inputs = 2;
+    return ret;
+  }
+
+  inline std::shared_ptr<query_operator> clone() const {
+    return std::make_shared<operator_impl>(m_left_keys, m_right_keys,
+                                           m_num_columns[0], m_num_columns[1],
+                                           m_left_join, m_right_join);
+  }
+
+  inline bool coro_running() const {
+    return CORO_RUNNING(execute);
+  }
+
+  inline void execute(query_context& context) {
+    CORO_BEGIN(execute)
+    while (1) {
+      fill_output_buffer(context);
+      if (m_out == nullptr) break;
+      context.emit(m_out);
+      m_out.reset();
+      CORO_YIELD();
+      if (m_finished) break;
+    }
+    CORO_END
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * Creates a logical merge join node joining left and right on the
+   * columns left_keys of left and right_keys of right. join_type is one of
+   * "inner", "left", "right" or "outer".
+   *
+   * Both inputs must be sorted in ascending order by their keys, or the
+   * result is wrong.
+   */
+  static std::shared_ptr<planner_node> make_planner_node(
+      std::shared_ptr<planner_node> left,
+      std::shared_ptr<planner_node> right,
+      const std::vector<size_t>& left_keys,
+      const std::vector<size_t>& right_keys,
+      const std::string& join_type) {
+    ASSERT_EQ(left_keys.size(), right_keys.size());
+    ASSERT_FALSE(left_keys.empty());
+    ASSERT_MSG(join_type == "inner" || join_type == "left" ||
+               join_type == "right" || join_type == "outer",
+               "Invalid join type");
+    flex_list flex_left_keys(left_keys.begin(), left_keys.end());
+    flex_list flex_right_keys(right_keys.begin(), right_keys.end());
+    return planner_node::make_shared(planner_node_type::MERGE_JOIN_NODE,
+                                     {{"left_keys", flex_left_keys},
+                                      {"right_keys", flex_right_keys},
+                                      {"join_type", join_type}},
+                                     std::map<std::string, any>(),
+                                     {left, right});
+  }
+
+  static std::shared_ptr<query_operator> from_planner_node(
+      std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::MERGE_JOIN_NODE);
+    ASSERT_EQ(pnode->inputs.size(), 2);
+    std::string join_type = pnode->operator_parameters.at("join_type");
+    return std::make_shared<operator_impl>(
+        get_keys(pnode, "left_keys"), get_keys(pnode, "right_keys"),
+        infer_planner_node_num_output_columns(pnode->inputs[0]),
+        infer_planner_node_num_output_columns(pnode->inputs[1]),
+        join_type == "left" || join_type == "outer",
+        join_type == "right" || join_type == "outer");
+  }
+
+  static std::vector<flex_type_enum> infer_type(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::MERGE_JOIN_NODE);
+    std::vector<flex_type_enum> ret = infer_planner_node_type(pnode->inputs[0]);
+    std::vector<flex_type_enum> right_types = infer_planner_node_type(pnode->inputs[1]);
+    std::vector<bool> is_right_key(right_types.size(), false);
+    for (size_t key: get_keys(pnode, "right_keys")) {
+      ASSERT_LT(key, right_types.size());
+      is_right_key[key] = true;
+    }
+    for (size_t i = 0; i < right_types.size(); ++i) {
+      if (!is_right_key[i]) ret.push_back(right_types[i]);
+    }
+    return ret;
+  }
+
+  static int64_t infer_length(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::MERGE_JOIN_NODE);
+    return -1;
+  }
+
+  static std::string repr(std::shared_ptr<planner_node> pnode, pnode_tagger& get_tag) {
+    ASSERT_EQ(pnode->inputs.size(), 2);
+    std::string join_type = pnode->operator_parameters.at("join_type");
+    return std::string("MergeJoin[") + join_type + "](" +
+        get_tag(pnode->inputs[0]) + "," + get_tag(pnode->inputs[1]) + ")";
+  }
+
+ private:
+  static std::vector<size_t> get_keys(const std::shared_ptr<planner_node>& pnode,
+                                      const std::string& param) {
+    auto flex_keys = pnode->operator_parameters.at(param).get<flex_list>();
+    return std::vector<size_t>(flex_keys.begin(), flex_keys.end());
+  }
+
+  /// Makes sure the current row of an input is valid. False at the end.
+  bool has_row(query_context& context, size_t input) {
+    if (m_done[input]) return false;
+    while (m_rows[input] == nullptr || m_pos[input] >= m_rows[input]->num_rows()) {
+      m_rows[input] = context.get_next(input);
+      m_pos[input] = 0;
+      if (m_rows[input] == nullptr) {
+        m_done[input] = true;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// A value of the current row of an input.
+  inline const flexible_type& value(size_t input, size_t column) const {
+    return (*(m_rows[input]->cget_columns()[column]))[m_pos[input]];
+  }
+
+  /**
+   * Compares the key of the current left row with the key of the current
+   * right row (or with m_group_key if use_group_key).
+   */
+  int compare_keys(bool use_group_key) const {
+    for (size_t i = 0; i < m_left_keys.size(); ++i) {
+      const flexible_type& l = value(0, m_left_keys[i]);
+      const flexible_type& r = use_group_key ? m_group_key[i]
+                                             : value(1, m_right_keys[i]);
+      if (l < r) return -1;
+      if (r < l) return 1;
+    }
+    return 0;
+  }
+
+  /// Copies the current row of an input.
+  std::vector<flexible_type> copy_row(size_t input) const {
+    std::vector<flexible_type> ret(m_num_columns[input]);
+    for (size_t i = 0; i < ret.size(); ++i) ret[i] = value(input, i);
+    return ret;
+  }
+
+  /**
+   * Writes an output row. If with_left, the left part is the current left
+   * row; otherwise this is a right row without a match. right is the right
+   * row, or nullptr for a left row without a match.
+   */
+  void write_row(query_context& context,
+                 bool with_left,
+                 const std::vector<flexible_type>* right) {
+    if (m_out == nullptr) {
+      m_out = context.get_output_buffer();
+      m_out->resize(m_num_output_columns, context.block_size());
+      m_outidx = 0;
+    }
+    auto& out = m_out->get_columns();
+    size_t num_left_columns = m_num_columns[0];
+    if (with_left) {
+      for (size_t i = 0; i < num_left_columns; ++i) {
+        (*out[i])[m_outidx] = value(0, i);
+      }
+    } else {
+      for (size_t i = 0; i < num_left_columns; ++i) {
+        (*out[i])[m_outidx] = FLEX_UNDEFINED;
+      }
+      for (size_t i = 0; i < m_left_keys.size(); ++i) {
+        (*out[m_left_keys[i]])[m_outidx] = (*right)[m_right_keys[i]];
+      }
+    }
+    size_t outcol = num_left_columns;
+    for (size_t i = 0; i < m_num_columns[1]; ++i) {
+      if (m_is_right_key[i]) continue;
+      (*out[outcol++])[m_outidx] = right ? (*right)[i] : FLEX_UNDEFINED;
+    }
+    ++m_outidx;
+  }
+
+  /**
+   * Reads the current right row and every following right row with the
+   * same key into m_group.
+   */
+  void read_right_group(query_context& context) {
+    m_group.clear();
+    m_group_key.resize(m_right_keys.size());
+    for (size_t i = 0; i < m_right_keys.size(); ++i) {
+      m_group_key[i] = value(1, m_right_keys[i]);
+    }
+    do {
+      m_group.push_back(copy_row(1));
+      ++m_pos[1];
+    } while (has_row(context, 1) && same_right_key());
+  }
+
+  bool same_right_key() const {
+    for (size_t i = 0; i < m_right_keys.size(); ++i) {
+      if (!(value(1, m_right_keys[i]) == m_group_key[i])) return false;
+    }
+    return true;
+  }
+
+  /**
+   * Advances the merge until an output buffer is full or both inputs are
+   * exhausted. Leaves m_out as nullptr if there is nothing to emit.
+   */
+  void fill_output_buffer(query_context& context) {
+    bool has_left = has_row(context, 0);
+    bool has_right = has_row(context, 1);
+
+    while (m_out == nullptr || m_outidx < m_out->num_rows()) {
+      if (m_group_active) {
+        // the current left row has the key of the buffered right rows
+        if (m_group_pos < m_group.size()) {
+          write_row(context, true, &m_group[m_group_pos]);
+          ++m_group_pos;
+          continue;
+        }
+        ++m_pos[0];
+        m_group_pos = 0;
+        has_left = has_row(context, 0);
+        if (!has_left || compare_keys(true) != 0) {
+          m_group_active = false;
+          m_group.clear();
+          has_right = has_row(context, 1);
+        }
+        continue;
+      }
+      if (!has_left && !has_right) {
+        m_finished = true;
+        break;
+      }
+      int cmp = !has_left ? 1 : (!has_right ? -1 : compare_keys(false));
+      if (cmp < 0) {
+        if (m_left_join) write_row(context, true, nullptr);
+        ++m_pos[0];
+        has_left = has_row(context, 0);
+      } else if (cmp > 0) {
+        if (m_right_join) {
+          m_right_row = copy_row(1);
+          write_row(context, false, &m_right_row);
+        }
+        ++m_pos[1];
+        has_right = has_row(context, 1);
+      } else {
+        read_right_group(context);
+        m_group_active = true;
+        m_group_pos = 0;
+      }
+    }
+    if (m_out != nullptr && m_outidx < m_out->num_rows()) {
+      m_out->resize(m_num_output_columns, m_outidx);
+    }
+  }
+
+  std::vector<size_t> m_left_keys;
+  std::vector<size_t> m_right_keys;
+  size_t m_num_columns[2];
+  std::vector<bool> m_is_right_key;
+  bool m_left_join;
+  bool m_right_join;
+  size_t m_num_output_columns;
+
+  // state
+  std::shared_ptr<const sframe_rows> m_rows[2];
+  size_t m_pos[2] = {0, 0};
+  bool m_done[2] = {false, false};
+  /// The right rows with key m_group_key, while m_group_active
+  std::vector<std::vector<flexible_type>> m_group;
+  std::vector<flexible_type> m_group_key;
+  bool m_group_active = false;
+  size_t m_group_pos = 0;
+  std::vector<flexible_type> m_right_row;
+  std::shared_ptr<sframe_rows> m_out;
+  size_t m_outidx = 0;
+  bool m_finished = false;
+};
+
+typedef operator_impl<planner_node_type::MERGE_JOIN_NODE> op_merge_join;
+
+/// \}
+
+} // query_eval
+} // turicreate
+
+#endif // TURI_SFRAME_QUERY_MANAGER_MERGE_JOIN_HPP
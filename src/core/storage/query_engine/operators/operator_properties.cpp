@@ -3,6 +3,8 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <set>
+#include <sstream>
 #include <string>
 #include <core/storage/query_engine/operators/operator_properties.hpp>
 #include <core/storage/query_engine/operators/operator_properties.hpp>
@@ -56,6 +58,16 @@ RetType extract_field(planner_node_type ptype, CallArgs... call_args) {
       return FieldExtractionVisitor<planner_node_type::GENERALIZED_UNION_PROJECT_NODE>::get(call_args...);
     case planner_node_type::TERNARY_OPERATOR:
       return FieldExtractionVisitor<planner_node_type::TERNARY_OPERATOR>::get(call_args...);
+    case planner_node_type::MERGE_JOIN_NODE:
+      return FieldExtractionVisitor<planner_node_type::MERGE_JOIN_NODE>::get(call_args...);
+    case planner_node_type::TOPK_NODE:
+      return FieldExtractionVisitor<planner_node_type::TOPK_NODE>::get(call_args...);
+    case planner_node_type::PARQUET_SOURCE_NODE:
+      return FieldExtractionVisitor<planner_node_type::PARQUET_SOURCE_NODE>::get(call_args...);
+    case planner_node_type::COLUMNWISE_TRANSFORM_NODE:
+      return FieldExtractionVisitor<planner_node_type::COLUMNWISE_TRANSFORM_NODE>::get(call_args...);
+    case planner_node_type::SARRAY_PREDICATE_SOURCE_NODE:
+      return FieldExtractionVisitor<planner_node_type::SARRAY_PREDICATE_SOURCE_NODE>::get(call_args...);
     case planner_node_type::IDENTITY_NODE:
       return FieldExtractionVisitor<planner_node_type::IDENTITY_NODE>::get(call_args...);
     case planner_node_type::INVALID:
@@ -363,6 +375,63 @@ bool is_linear_graph(const pnode_ptr& n) {
   return ret;
 }
 
+/**
+ * Returns true if the zone maps of every block of the array show that it
+ * is sorted: every block is, and no block starts below the end of the one
+ * before it. This covers any range of the array.
+ */
+static bool is_sorted_sarray(const std::shared_ptr<sarray<flexible_type>>& sa) {
+  auto index_info = sa->get_index_info();
+  if (index_info.block_zone_maps.size() != index_info.nsegments) return false;
+  bool first = true;
+  flexible_type last_value;
+  for (const auto& segment: index_info.block_zone_maps) {
+    for (const auto& zone_map: segment) {
+      if (zone_map.num_elem == 0) continue;
+      if (!zone_map.valid || !zone_map.sorted) return false;
+      if (!first && zone_map.min_value < last_value) return false;
+      last_value = zone_map.max_value;
+      first = false;
+    }
+  }
+  return true;
+}
+
+bool is_sorted_by(const pnode_ptr& n, const std::vector<size_t>& columns) {
+  switch(n->operator_type) {
+   case planner_node_type::SARRAY_SOURCE_NODE: {
+     for (size_t c: columns) {
+       if (c != 0) return false;
+     }
+     return is_sorted_sarray(n->any_operator_parameters.at("sarray")
+                             .as<std::shared_ptr<sarray<flexible_type>>>());
+   }
+   case planner_node_type::SFRAME_SOURCE_NODE: {
+     const auto& sf = n->any_operator_parameters.at("sframe").as<sframe>();
+     for (size_t c: columns) {
+       if (c >= sf.num_columns() || !is_sorted_sarray(sf.select_column(c))) {
+         return false;
+       }
+     }
+     return true;
+   }
+   case planner_node_type::PROJECT_NODE: {
+     auto indices = n->operator_parameters.at("indices").get<flex_list>();
+     std::vector<size_t> input_columns;
+     for (size_t c: columns) {
+       if (c >= indices.size()) return false;
+       input_columns.push_back(indices[c].get<flex_int>());
+     }
+     return is_sorted_by(n->inputs[0], input_columns);
+   }
+   case planner_node_type::LOGICAL_FILTER_NODE:
+     // a filter only drops rows
+     return is_sorted_by(n->inputs[0], columns);
+   default:
+     return false;
+  }
+}
+
 /**************************************************************************/
 /*                                                                        */
 /*                           prove_equal_length                           */
@@ -500,6 +569,54 @@ static dot_graph& recursive_print_impl(const std::shared_ptr<planner_node>& node
   return graph;
 }
 
+// Recursively print the nodes below a current one as an indented tree.
+static void recursive_tree_print_impl(
+    const std::shared_ptr<planner_node>& node,
+    size_t depth,
+    pnode_tagger& get_tag,
+    std::set<pnode_ptr>& printed,
+    const std::function<std::string(std::shared_ptr<planner_node>)>& annotate,
+    std::ostream& out) {
+
+  out << std::string(2 * depth, ' ');
+  if (printed.count(node)) {
+    out << get_tag(node) << " (see above)\n";
+    return;
+  }
+  printed.insert(node);
+
+  out << get_tag(node) << ": "
+      << extract_field<visitor_repr, std::string>(node->operator_type, node, get_tag);
+  if (annotate) out << "  " << annotate(node);
+  out << "\n";
+
+  for (const auto& input : node->inputs) {
+    recursive_tree_print_impl(input, depth + 1, get_tag, printed, annotate, out);
+  }
+}
+
+std::string planner_node_tree_string(
+    const std::shared_ptr<planner_node>& node,
+    std::function<std::string(std::shared_ptr<planner_node>)> annotate) {
+
+  std::map<pnode_ptr, std::string> names;
+  pnode_tagger get_tag = [&](pnode_ptr p) -> std::string {
+    auto it = names.find(p);
+    if(it == names.end()) {
+      auto s = to_name(names.size());
+      names[p] = s;
+      return s;
+    } else {
+      return it->second;
+    }
+  };
+
+  std::set<pnode_ptr> printed;
+  std::ostringstream out;
+  recursive_tree_print_impl(node, 0, get_tag, printed, annotate, out);
+  return out.str();
+}
+
 std::ostream& operator<<(std::ostream& out,
                          const std::shared_ptr<planner_node>& node) {
 
@@ -10,6 +10,7 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <functional>
 #include <core/data/flexible_type/flexible_type.hpp>
 
 namespace turi { namespace query_eval {
@@ -37,6 +38,11 @@ enum class planner_node_type : int {
     GENERALIZED_UNION_PROJECT_NODE,
     REDUCE_NODE,
     TERNARY_OPERATOR,
+    MERGE_JOIN_NODE,
+    TOPK_NODE,
+    PARQUET_SOURCE_NODE,
+    COLUMNWISE_TRANSFORM_NODE,
+    SARRAY_PREDICATE_SOURCE_NODE,
 
       // These are used as logical-node-only types.  Do not actually become an operator.
       IDENTITY_NODE,
@@ -140,6 +146,18 @@ bool is_parallel_slicable(const std::shared_ptr<planner_node>& n);
  */
 bool is_linear_graph(const std::shared_ptr<planner_node>& n);
 
+/** Returns true if the output of this node is known to be sorted in
+ *  ascending order by each of the given columns on its own, and none of them
+ *  contains UNDEFINED values. The output is then also sorted
+ *  lexicographically by the columns, in any order.
+ *
+ *  Sortedness is read off the zone maps of the sources (see
+ *  \ref v2_block_impl::block_zone_map::sorted), and is preserved by
+ *  projections and logical filters. Returns false if it cannot be proven.
+ */
+bool is_sorted_by(const std::shared_ptr<planner_node>& n,
+                  const std::vector<size_t>& columns);
+
 /** Returns a set of integers giving the different parallel slicable
  *  units for the inputs of a particular node. If
  */
@@ -151,6 +169,15 @@ typedef std::function<std::string(std::shared_ptr<planner_node>)> pnode_tagger;
  */
 std::string planner_node_repr(const std::shared_ptr<planner_node>& node);
 
+/** Representation of the whole graph below a node as an indented tree,
+ *  one node per line with its inputs below it. A node with several
+ *  outputs is printed once, and referred to by its name afterwards. If
+ *  annotate is given, its result is appended to the line of every node.
+ */
+std::string planner_node_tree_string(
+    const std::shared_ptr<planner_node>& node,
+    std::function<std::string(std::shared_ptr<planner_node>)> annotate = nullptr);
+
 
 std::ostream& operator<<(std::ostream&,
                       const std::shared_ptr<planner_node>& node);
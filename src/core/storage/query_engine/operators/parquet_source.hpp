@@ -0,0 +1,288 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_QUERY_MANAGER_PARQUET_SOURCE_HPP
+#define TURI_SFRAME_QUERY_MANAGER_PARQUET_SOURCE_HPP
+
+#include <algorithm>
+#include <sstream>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/storage/fileio/async_reader.hpp>
+#include <core/storage/fileio/sanitize_url.hpp>
+#include <core/storage/query_engine/operators/operator.hpp>
+#include <core/storage/query_engine/execution/query_context.hpp>
+#include <core/storage/query_engine/operators/operator_properties.hpp>
+#include <core/storage/sframe_data/parquet_reader.hpp>
+#include <core/util/coro.hpp>
+
+namespace turi {
+namespace query_eval {
+
+/**
+ * \ingroup sframe_query_engine
+ * \addtogroup operators Logical Operators
+ * \{
+ */
+
+/**
+ * A "parquet_source" operator generates the rows of some columns and row
+ * groups of a Parquet file, read with a \ref parquet_reader; typedefed
+ * \ref op_parquet_source.
+ *
+ * The begin_index and end_index parameters are rows of the selected row
+ * groups, one after the other, so the source is sliced for parallel
+ * execution like the \ref op_sframe_source. Row groups are decoded whole
+ * when a row of theirs is first needed, and the column chunks of the next
+ * row group are fetched in the meantime. Blocks which are skipped are not
+ * decoded.
+ */
+template <>
+struct operator_impl<planner_node_type::PARQUET_SOURCE_NODE> : public query_operator {
+ public:
+  DECL_CORO_STATE(execute);
+  size_t start = 0;
+  size_t length = 0;
+
+  planner_node_type type() const { return planner_node_type::PARQUET_SOURCE_NODE; }
+
+  static std::string name() { return "parquet_source"; }
+
+  inline operator_impl(std::shared_ptr<parquet_reader> reader,
+                       const std::vector<size_t>& columns,
+                       const std::vector<size_t>& row_groups,
+                       size_t begin_index, size_t end_index)
+      : m_reader(reader)
+      , m_columns(columns)
+      , m_row_groups(row_groups)
+      , m_begin_index(begin_index)
+      , m_end_index(end_index)
+  {
+    m_group_offsets.push_back(0);
+    for (size_t group: m_row_groups) {
+      m_group_offsets.push_back(m_group_offsets.back() +
+                                m_reader->row_group_num_rows(group));
+    }
+    ASSERT_LE(m_begin_index, m_end_index);
+    ASSERT_LE(m_end_index, m_group_offsets.back());
+  }
+
+  static query_operator_attributes attributes() {
+    query_operator_attributes ret;
+    ret.attribute_bitfield = query_operator_attributes::SOURCE |
+        query_operator_attributes::SUPPORTS_SKIPPING;
+    ret.num_inputs = 0;
+    return ret;
+  }
+
+  inline std::shared_ptr<query_operator> clone() const {
+    return std::make_shared<operator_impl>(m_reader, m_columns, m_row_groups,
+                                           m_begin_index, m_end_index);
+  }
+
+  inline bool coro_running() const {
+    return CORO_RUNNING(execute);
+  }
+
+  inline void execute(query_context& context) {
+    CORO_BEGIN(execute)
+    start = m_begin_index;
+    while (start < m_end_index) {
+      length = std::min(context.block_size(), m_end_index - start);
+      if (context.should_skip()) {
+        context.emit(nullptr);
+      } else {
+        auto rows = context.get_output_buffer();
+        rows->resize(m_columns.size(), length);
+        fill_rows(*rows);
+        context.emit(rows);
+      }
+      start += length;
+      CORO_YIELD();
+    }
+    CORO_END
+  }
+
+  /**
+   * Makes a planner node reading the rows [begin_index, end_index) of the
+   * columns (indices into \ref parquet_reader::column_names()) of the row
+   * groups of the reader, the rows of the row groups counted one after the
+   * other.
+   */
+  static std::shared_ptr<planner_node> make_planner_node(
+      std::shared_ptr<parquet_reader> reader,
+      const std::vector<size_t>& columns,
+      const std::vector<size_t>& row_groups,
+      size_t begin_index, size_t end_index) {
+    flex_list column_list, group_list, type_list;
+    for (size_t column: columns) {
+      ASSERT_LT(column, reader->column_names().size());
+      column_list.push_back(flex_int(column));
+      type_list.push_back(flex_int(reader->column_types()[column]));
+    }
+    for (size_t group: row_groups) {
+      ASSERT_LT(group, reader->num_row_groups());
+      group_list.push_back(flex_int(group));
+    }
+    return planner_node::make_shared(planner_node_type::PARQUET_SOURCE_NODE,
+                                     {{"url", reader->url()},
+                                      {"columns", column_list},
+                                      {"row_groups", group_list},
+                                      {"types", type_list},
+                                      {"begin_index", begin_index},
+                                      {"end_index", end_index}},
+                                     {{"parquet_reader", any(reader)}});
+  }
+
+  /**
+   * Makes a planner node reading all the rows of the columns of the row
+   * groups of the reader.
+   */
+  static std::shared_ptr<planner_node> make_planner_node(
+      std::shared_ptr<parquet_reader> reader,
+      const std::vector<size_t>& columns,
+      const std::vector<size_t>& row_groups) {
+    size_t num_rows = 0;
+    for (size_t group: row_groups) num_rows += reader->row_group_num_rows(group);
+    return make_planner_node(reader, columns, row_groups, 0, num_rows);
+  }
+
+  /**
+   * Makes a planner node reading all the columns and row groups of the
+   * reader.
+   */
+  static std::shared_ptr<planner_node> make_planner_node(
+      std::shared_ptr<parquet_reader> reader) {
+    std::vector<size_t> columns(reader->column_names().size());
+    std::vector<size_t> row_groups(reader->num_row_groups());
+    for (size_t i = 0; i < columns.size(); ++i) columns[i] = i;
+    for (size_t i = 0; i < row_groups.size(); ++i) row_groups[i] = i;
+    return make_planner_node(reader, columns, row_groups);
+  }
+
+  static std::shared_ptr<query_operator> from_planner_node(
+      std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type,
+              (int)planner_node_type::PARQUET_SOURCE_NODE);
+    ASSERT_TRUE(pnode->any_operator_parameters.count("parquet_reader"));
+    auto reader = pnode->any_operator_parameters.at("parquet_reader")
+        .as<std::shared_ptr<parquet_reader>>();
+
+    std::vector<size_t> columns, row_groups;
+    for (const auto& c: pnode->operator_parameters.at("columns").get<flex_list>()) {
+      columns.push_back(c.get<flex_int>());
+    }
+    for (const auto& g: pnode->operator_parameters.at("row_groups").get<flex_list>()) {
+      row_groups.push_back(g.get<flex_int>());
+    }
+    size_t begin_index = pnode->operator_parameters.at("begin_index");
+    size_t end_index = pnode->operator_parameters.at("end_index");
+    return std::make_shared<operator_impl>(reader, columns, row_groups,
+                                           begin_index, end_index);
+  }
+
+  static std::vector<flex_type_enum> infer_type(
+      std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type,
+              (int)planner_node_type::PARQUET_SOURCE_NODE);
+    flex_list type = pnode->operator_parameters.at("types");
+    std::vector<flex_type_enum> ret;
+    for (auto t: type) ret.push_back((flex_type_enum)(flex_int)(t));
+    return ret;
+  }
+
+  static int64_t infer_length(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type,
+              (int)planner_node_type::PARQUET_SOURCE_NODE);
+    flex_int length = (pnode->operator_parameters.at("end_index")
+                       - pnode->operator_parameters.at("begin_index"));
+    return length;
+  }
+
+  static std::string repr(std::shared_ptr<planner_node> pnode, pnode_tagger&) {
+    std::ostringstream out;
+    out << "Parquet("
+        << sanitize_url(pnode->operator_parameters.at("url").get<flex_string>())
+        << ", " << pnode->operator_parameters.at("columns").size() << " columns, "
+        << pnode->operator_parameters.at("row_groups").size() << " row groups)";
+    size_t begin_index = pnode->operator_parameters.at("begin_index");
+    size_t end_index = pnode->operator_parameters.at("end_index");
+    out << "[" << begin_index << "," << end_index << "]";
+    return out.str();
+  }
+
+ private:
+  /**
+   * Fills rows with the rows [start, start + length), decoding row groups
+   * as needed.
+   */
+  void fill_rows(sframe_rows& rows) {
+    auto& out_columns = rows.get_columns();
+    size_t filled = 0;
+    while (filled < length) {
+      size_t row = start + filled;
+      size_t group = std::upper_bound(m_group_offsets.begin(),
+                                      m_group_offsets.end(), row)
+                     - m_group_offsets.begin() - 1;
+      load_group(group);
+      size_t offset = row - m_group_offsets[group];
+      size_t count = std::min(length - filled, m_group_offsets[group + 1] - row);
+      for (size_t c = 0; c < m_columns.size(); ++c) {
+        std::copy(m_values[c].begin() + offset,
+                  m_values[c].begin() + offset + count,
+                  out_columns[c]->begin() + filled);
+      }
+      filled += count;
+    }
+  }
+
+  /// Decodes the columns of the row group (index into m_row_groups)
+  void load_group(size_t group) {
+    if (group == m_loaded_group) return;
+    if (group != m_prefetched_group) fetch(group, m_prefetched);
+    std::vector<std::shared_ptr<fileio::async_read_request> > current;
+    current.swap(m_prefetched);
+    m_prefetched_group = size_t(-1);
+    // the next row group is read while this one is decoded
+    if (group + 1 < m_row_groups.size() && m_group_offsets[group + 1] < m_end_index) {
+      fetch(group + 1, m_prefetched);
+      m_prefetched_group = group + 1;
+    }
+    m_values.resize(m_columns.size());
+    for (size_t c = 0; c < m_columns.size(); ++c) {
+      auto data = current[c]->get();
+      m_reader->decode_column_chunk(m_row_groups[group], m_columns[c], *data,
+                                    m_values[c]);
+    }
+    m_loaded_group = group;
+  }
+
+  void fetch(size_t group,
+             std::vector<std::shared_ptr<fileio::async_read_request> >& reads) {
+    reads.clear();
+    for (size_t column: m_columns) {
+      reads.push_back(m_reader->fetch_column_chunk(m_row_groups[group], column));
+    }
+  }
+
+  std::shared_ptr<parquet_reader> m_reader;
+  std::vector<size_t> m_columns;
+  std::vector<size_t> m_row_groups;
+  size_t m_begin_index, m_end_index;
+  /// The first row of every selected row group, and the total number of rows
+  std::vector<size_t> m_group_offsets;
+
+  size_t m_loaded_group = size_t(-1);
+  std::vector<std::vector<flexible_type> > m_values;
+  size_t m_prefetched_group = size_t(-1);
+  std::vector<std::shared_ptr<fileio::async_read_request> > m_prefetched;
+};
+
+typedef operator_impl<planner_node_type::PARQUET_SOURCE_NODE> op_parquet_source;
+
+/// \}
+} // query_eval
+} // turicreate
+
+#endif // TURI_SFRAME_QUERY_MANAGER_PARQUET_SOURCE_HPP
@@ -0,0 +1,213 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_QUERY_MANAGER_SARRAY_PREDICATE_SOURCE_HPP
+#define TURI_SFRAME_QUERY_MANAGER_SARRAY_PREDICATE_SOURCE_HPP
+#include <algorithm>
+#include <sstream>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/storage/query_engine/operators/operator.hpp>
+#include <core/storage/query_engine/operators/sarray_source.hpp>
+#include <core/storage/query_engine/execution/query_context.hpp>
+#include <core/storage/query_engine/planning/planner_node.hpp>
+#include <core/storage/query_engine/operators/operator_properties.hpp>
+#include <core/storage/sframe_data/sarray.hpp>
+#include <core/storage/sframe_data/sarray_v2_type_encoding.hpp>
+#include <core/util/dense_bitset.hpp>
+#include <core/util/coro.hpp>
+
+namespace turi {
+namespace query_eval {
+
+/**
+ * \ingroup sframe_query_engine
+ * \addtogroup operators Logical Operators
+ * \{
+ */
+
+/**
+ * A "sarray_predicate_source" operator generates, for every row of a
+ * physical sarray, 1 if the row satisfies a simple predicate (see
+ * \ref v2_block_impl::block_predicate) and 0 otherwise; typedefed
+ * \ref op_sarray_predicate_source.
+ *
+ * The predicate is evaluated by \ref sarray_reader::evaluate_predicate(),
+ * so blocks whose zone maps show that they cannot match are never read.
+ * This makes it a cheap logical filter mask: the filter skips the data
+ * rows of the all zero batches such blocks produce.
+ */
+template <>
+struct operator_impl<planner_node_type::SARRAY_PREDICATE_SOURCE_NODE> : public query_operator {
+ public:
+  DECL_CORO_STATE(execute);
+  size_t start = 0;
+  size_t block_size = 0;
+  bool skip_next_block = false;
+  size_t end;
+  std::shared_ptr<sframe_rows>  rows;
+
+  planner_node_type type() const { return planner_node_type::SARRAY_PREDICATE_SOURCE_NODE; }
+
+  static std::string name() { return "sarray_predicate_source"; }
+
+  inline operator_impl(std::shared_ptr<sarray<flexible_type> > source,
+                       const v2_block_impl::block_predicate& pred,
+                       size_t begin_index, size_t end_index)
+      : m_source(source)
+      , m_predicate(pred)
+      , m_begin_index(begin_index)
+      , m_end_index(end_index)
+  { }
+
+  static query_operator_attributes attributes() {
+    query_operator_attributes ret;
+    ret.attribute_bitfield = query_operator_attributes::SOURCE |
+        query_operator_attributes::SUPPORTS_SKIPPING;
+    ret.num_inputs = 0;
+    return ret;
+  }
+
+  inline std::shared_ptr<query_operator> clone() const {
+    return std::make_shared<operator_impl>(m_source, m_predicate,
+                                           m_begin_index, m_end_index);
+  }
+
+  inline bool coro_running() const {
+    return CORO_RUNNING(execute);
+  }
+  inline void execute(query_context& context) {
+    CORO_BEGIN(execute)
+    if (!m_reader) m_reader = m_source->get_reader();
+    start = m_begin_index;
+    block_size = context.block_size();
+    skip_next_block = context.should_skip();
+
+    while (start != m_end_index) {
+      rows = context.get_output_buffer();
+      end = std::min(start + block_size, m_end_index);
+      if (skip_next_block == false) {
+        m_reader->evaluate_predicate(start, end, m_predicate, m_selection);
+        // the column is overwritten: no need to copy it if it is shared
+        rows->reset_columns(1);
+        rows->resize(1, end - start);
+        {
+          auto& column = *(rows->get_columns()[0]);
+          for (size_t i = 0; i < column.size(); ++i) {
+            column[i] = flex_int(m_selection.get(i));
+          }
+        }
+        context.emit(rows);
+        CORO_YIELD();
+      } else {
+        context.emit(nullptr);
+        CORO_YIELD();
+      }
+      skip_next_block = context.should_skip();
+      start = end;
+    }
+    CORO_END
+  }
+
+  static std::shared_ptr<planner_node> make_planner_node(
+      std::shared_ptr<sarray<flexible_type> > source,
+      const v2_block_impl::block_predicate& pred,
+      size_t begin_index = 0, size_t _end_index = -1) {
+    size_t end_index = (_end_index == size_t(-1)) ? source->size() : _end_index;
+
+    DASSERT_LE(begin_index, end_index);
+    DASSERT_LE(end_index, source->size());
+
+    return planner_node::make_shared(planner_node_type::SARRAY_PREDICATE_SOURCE_NODE,
+                                     {{"op", (flex_int)pred.op},
+                                      {"value", pred.value},
+                                      {"begin_index", begin_index},
+                                      {"end_index", end_index}},
+                                     {{"sarray", any(source)}});
+  }
+
+  static std::shared_ptr<query_operator> from_planner_node(
+      std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type,
+              (int)planner_node_type::SARRAY_PREDICATE_SOURCE_NODE);
+    ASSERT_TRUE(pnode->any_operator_parameters.count("sarray"));
+    auto source = pnode->any_operator_parameters["sarray"]
+        .as<std::shared_ptr<sarray<flexible_type>>>();
+
+    size_t begin_index = pnode->operator_parameters.at("begin_index");
+    size_t end_index = pnode->operator_parameters.at("end_index");
+
+    return std::make_shared<operator_impl>(source, get_predicate(pnode),
+                                           begin_index, end_index);
+  }
+
+  static std::vector<flex_type_enum> infer_type(
+      std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type,
+              (int)planner_node_type::SARRAY_PREDICATE_SOURCE_NODE);
+    return {flex_type_enum::INTEGER};
+  }
+
+  static int64_t infer_length(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type,
+              (int)planner_node_type::SARRAY_PREDICATE_SOURCE_NODE);
+    flex_int length = (pnode->operator_parameters.at("end_index")
+                       - pnode->operator_parameters.at("begin_index"));
+    return length;
+  }
+
+  /// Returns the predicate evaluated by a planner node
+  static v2_block_impl::block_predicate get_predicate(
+      std::shared_ptr<planner_node> pnode) {
+    v2_block_impl::block_predicate pred;
+    pred.op = (v2_block_impl::block_predicate::op_type)
+        (flex_int)(pnode->operator_parameters.at("op"));
+    pred.value = pnode->operator_parameters.at("value");
+    return pred;
+  }
+
+  static std::string repr(std::shared_ptr<planner_node> pnode, pnode_tagger&) {
+    typedef v2_block_impl::block_predicate::op_type op_type;
+    std::ostringstream out;
+
+    auto source = pnode->any_operator_parameters["sarray"]
+        .as<std::shared_ptr<sarray<flexible_type> > >();
+    auto pred = get_predicate(pnode);
+
+    out << "S" << op_sarray_source::unique_sarray_tag(source);
+    switch(pred.op) {
+     case op_type::IS_UNDEFINED: out << " is None"; break;
+     case op_type::IS_DEFINED: out << " is not None"; break;
+     case op_type::EQ: out << " == " << pred.value; break;
+     case op_type::NE: out << " != " << pred.value; break;
+     case op_type::LT: out << " < " << pred.value; break;
+     case op_type::LE: out << " <= " << pred.value; break;
+     case op_type::GT: out << " > " << pred.value; break;
+     case op_type::GE: out << " >= " << pred.value; break;
+    }
+
+    size_t begin_index = pnode->operator_parameters.at("begin_index");
+    size_t end_index = pnode->operator_parameters.at("end_index");
+
+    if(begin_index != 0 || end_index != source->size()) {
+      out << "[" << begin_index << "," << end_index << "]";
+    }
+    return out.str();
+  }
+
+ private:
+  std::shared_ptr<sarray<flexible_type>> m_source;
+  v2_block_impl::block_predicate m_predicate;
+  size_t m_begin_index, m_end_index;
+  std::shared_ptr<sarray_reader<flexible_type>> m_reader;
+  dense_bitset m_selection;
+};
+
+typedef operator_impl<planner_node_type::SARRAY_PREDICATE_SOURCE_NODE> op_sarray_predicate_source;
+
+/// \}
+} // query_eval
+} // turicreate
+
+#endif // TURI_SFRAME_QUERY_MANAGER_SARRAY_PREDICATE_SOURCE_HPP
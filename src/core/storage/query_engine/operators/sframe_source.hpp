@@ -77,6 +77,9 @@ struct operator_impl<planner_node_type::SFRAME_SOURCE_NODE> : public query_opera
         m_reader->read_rows(start, end, *rows);
         context.emit(rows);
         CORO_YIELD();
+        // the consumers are done with the rows. Columns they did not keep
+        // go back to the reader for the next read.
+        m_reader->release_rows(*rows);
       } else {
         context.emit(nullptr);
         CORO_YIELD();
@@ -0,0 +1,204 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_QUERY_MANAGER_TOPK_HPP
+#define TURI_SFRAME_QUERY_MANAGER_TOPK_HPP
+
+#include <algorithm>
+#include <core/logging/assertions.hpp>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/storage/query_engine/operators/operator.hpp>
+#include <core/storage/query_engine/execution/query_context.hpp>
+#include <core/storage/query_engine/operators/operator_properties.hpp>
+#include <core/util/coro.hpp>
+
+namespace turi {
+namespace query_eval {
+
+/**
+ * \ingroup sframe_query_engine
+ * \addtogroup operators Logical Operators
+ * \{
+ */
+
+/**
+ * A "topk" operator keeps the first k rows of its input in the order of a
+ * sort on some of its columns, and outputs them in that order; typedefed
+ * \ref op_topk.
+ *
+ * The rows are kept in a bounded heap, so the input is scanned once and at
+ * most k rows are held in memory. Rows are compared as in \ref
+ * less_than_partial_function: UNDEFINED comes first in ascending order. Ties
+ * are broken arbitrarily.
+ *
+ * Like \ref op_reduce, this is a SUB_LINEAR operator: when executed in
+ * parallel, every segment outputs the top k of its own part of the input, so
+ * the combined output has up to k rows per segment which still have to be
+ * merged. See \ref query_eval::topk for the complete algorithm.
+ */
+template<>
+class operator_impl<planner_node_type::TOPK_NODE> : public query_operator {
+ public:
+  DECL_CORO_STATE(execute);
+
+  planner_node_type type() const { return planner_node_type::TOPK_NODE; }
+  static std::string name() { return "topk"; }
+
+  inline operator_impl(const std::vector<size_t>& sort_columns,
+                       const std::vector<bool>& sort_orders,
+                       size_t k)
+      : m_sort_columns(sort_columns), m_sort_orders(sort_orders), m_k(k) {
+    ASSERT_EQ(m_sort_columns.size(), m_sort_orders.size());
+  }
+
+  static query_operator_attributes attributes() {
+    query_operator_attributes ret;
+    ret.attribute_bitfield = query_operator_attributes::SUB_LINEAR;
+    ret.num_inputs = 1;
+    return ret;
+  }
+
+  inline std::shared_ptr<query_operator> clone() const {
+    return std::make_shared<operator_impl>(m_sort_columns, m_sort_orders, m_k);
+  }
+
+  inline bool coro_running() const {
+    return CORO_RUNNING(execute);
+  }
+
+  inline void execute(query_context& context) {
+    CORO_BEGIN(execute)
+    {
+    auto heap_order = [this](const std::vector<flexible_type>& a,
+                             const std::vector<flexible_type>& b) {
+      return less_than(a, b);
+    };
+    while(1) {
+      auto rows = context.get_next(0);
+      if (rows == nullptr) break;
+      if (m_k == 0) continue;
+      for (const auto& row : *rows) {
+        if (m_heap.size() < m_k) {
+          m_heap.push_back(std::vector<flexible_type>(row));
+          std::push_heap(m_heap.begin(), m_heap.end(), heap_order);
+        } else if (less_than(row, m_heap.front())) {
+          // m_heap.front() is the last of the rows kept so far
+          std::pop_heap(m_heap.begin(), m_heap.end(), heap_order);
+          m_heap.back() = std::vector<flexible_type>(row);
+          std::push_heap(m_heap.begin(), m_heap.end(), heap_order);
+        }
+      }
+    }
+    std::sort_heap(m_heap.begin(), m_heap.end(), heap_order);
+    }
+    while (m_next_row < m_heap.size()) {
+      {
+      size_t num_rows = std::min(context.block_size(), m_heap.size() - m_next_row);
+      auto out = context.get_output_buffer();
+      out->resize(m_heap[0].size(), num_rows);
+      auto& columns = out->get_columns();
+      for (size_t i = 0; i < num_rows; ++i) {
+        auto& row = m_heap[m_next_row + i];
+        for (size_t j = 0; j < row.size(); ++j) {
+          (*columns[j])[i] = std::move(row[j]);
+        }
+      }
+      m_next_row += num_rows;
+      context.emit(out);
+      }
+      CORO_YIELD();
+    }
+    CORO_END
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * Creates a logical topk node keeping the first k rows of source sorted by
+   * sort_columns. sort_orders[i] is true if sort_columns[i] is sorted in
+   * ascending order.
+   */
+  static std::shared_ptr<planner_node> make_planner_node(
+      std::shared_ptr<planner_node> source,
+      const std::vector<size_t>& sort_columns,
+      const std::vector<bool>& sort_orders,
+      size_t k) {
+    ASSERT_EQ(sort_columns.size(), sort_orders.size());
+    ASSERT_FALSE(sort_columns.empty());
+    flex_list flex_sort_columns(sort_columns.begin(), sort_columns.end());
+    flex_list flex_sort_orders;
+    for (bool ascending: sort_orders) flex_sort_orders.push_back((flex_int)ascending);
+    return planner_node::make_shared(planner_node_type::TOPK_NODE,
+                                     {{"sort_columns", flex_sort_columns},
+                                      {"sort_ascending", flex_sort_orders},
+                                      {"k", k}},
+                                     std::map<std::string, any>(),
+                                     {source});
+  }
+
+  static std::shared_ptr<query_operator> from_planner_node(
+      std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::TOPK_NODE);
+    ASSERT_EQ(pnode->inputs.size(), 1);
+    auto flex_sort_columns = pnode->operator_parameters.at("sort_columns").get<flex_list>();
+    auto flex_sort_orders = pnode->operator_parameters.at("sort_ascending").get<flex_list>();
+    std::vector<size_t> sort_columns(flex_sort_columns.begin(), flex_sort_columns.end());
+    std::vector<bool> sort_orders;
+    for (const auto& ascending: flex_sort_orders) sort_orders.push_back((flex_int)ascending != 0);
+    size_t k = pnode->operator_parameters.at("k");
+    return std::make_shared<operator_impl>(sort_columns, sort_orders, k);
+  }
+
+  static std::vector<flex_type_enum> infer_type(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::TOPK_NODE);
+    return infer_planner_node_type(pnode->inputs[0]);
+  }
+
+  static int64_t infer_length(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::TOPK_NODE);
+    return -1;
+  }
+
+  static std::string repr(std::shared_ptr<planner_node> pnode, pnode_tagger& get_tag) {
+    ASSERT_EQ(pnode->inputs.size(), 1);
+    size_t k = pnode->operator_parameters.at("k");
+    return std::string("TopK[") + std::to_string(k) + "](" +
+        get_tag(pnode->inputs[0]) + ")";
+  }
+
+ private:
+  /// True if row a comes before row b in the sort order.
+  template <typename RowA, typename RowB>
+  inline bool less_than(const RowA& a, const RowB& b) const {
+    for (size_t i = 0; i < m_sort_columns.size(); ++i) {
+      const flexible_type& va = a[m_sort_columns[i]];
+      const flexible_type& vb = b[m_sort_columns[i]];
+      bool ascending = m_sort_orders[i];
+      if (va.get_type() == flex_type_enum::UNDEFINED) {
+        if (vb.get_type() == flex_type_enum::UNDEFINED) continue;
+        return ascending;
+      }
+      if (vb.get_type() == flex_type_enum::UNDEFINED) return !ascending;
+      if (va < vb) return ascending;
+      if (vb < va) return !ascending;
+    }
+    return false;
+  }
+
+  std::vector<size_t> m_sort_columns;
+  std::vector<bool> m_sort_orders;
+  size_t m_k = 0;
+  /// A max-heap of the rows kept so far: the front is the last of them.
+  std::vector<std::vector<flexible_type>> m_heap;
+  size_t m_next_row = 0;
+};
+
+typedef operator_impl<planner_node_type::TOPK_NODE> op_topk;
+
+/// \}
+} // query_eval
+} // turicreate
+
+#endif // TURI_SFRAME_QUERY_MANAGER_TOPK_HPP
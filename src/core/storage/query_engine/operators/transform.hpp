@@ -11,6 +11,7 @@
 #include <core/storage/query_engine/operators/operator.hpp>
 #include <core/storage/query_engine/execution/query_context.hpp>
 #include <core/storage/query_engine/operators/operator_properties.hpp>
+#include <core/storage/query_engine/operators/batch_expression.hpp>
 #include <core/util/coro.hpp>
 namespace turi {
 namespace query_eval {
@@ -26,6 +27,10 @@ typedef std::function<flexible_type(const sframe_rows::row&)> transform_type;
 /**
  * A "transform" operator applys a transform function on a
  * stream of input.
+ *
+ * If a \ref batch_expression computing the same function is provided, each
+ * batch of input is evaluated by the expression instead of calling the
+ * transform function once per row.
  */
 template<>
 class operator_impl<planner_node_type::TRANSFORM_NODE> : public query_operator {
@@ -46,8 +51,10 @@ class operator_impl<planner_node_type::TRANSFORM_NODE> : public query_operator {
 
   inline operator_impl(const transform_type& f,
                        flex_type_enum output_type,
-                       int random_seed=-1)
-      : m_transform_fn(f), m_output_type(output_type), m_random_seed(random_seed)
+                       int random_seed=-1,
+                       batch_expression_ptr expression=nullptr)
+      : m_transform_fn(f), m_output_type(output_type), m_random_seed(random_seed),
+        m_expression(expression)
   { }
 
   inline std::shared_ptr<query_operator> clone() const {
@@ -70,21 +77,36 @@ class operator_impl<planner_node_type::TRANSFORM_NODE> : public query_operator {
       auto output = context.get_output_buffer();
       output->resize(1, rows->num_rows());
 
-      auto iter = rows->cbegin();
-      auto output_iter = output->begin();
-      while(iter != rows->cend()) {
-        auto outval = m_transform_fn((*iter));
-        if (m_output_type == flex_type_enum::UNDEFINED ||
-            outval.get_type() == m_output_type ||
-            outval.get_type() == flex_type_enum::UNDEFINED) {
-          (*output_iter)[0] = outval;
-        } else {
-          flexible_type f(m_output_type);
-          f.soft_assign(outval);
-          (*output_iter)[0] = f;
+      if (m_expression) {
+        // the whole batch at once
+        auto& out_column = *(output->get_columns()[0]);
+        m_expression->evaluate_batch(*rows, out_column);
+        for (auto& outval: out_column) {
+          if (m_output_type != flex_type_enum::UNDEFINED &&
+              outval.get_type() != m_output_type &&
+              outval.get_type() != flex_type_enum::UNDEFINED) {
+            flexible_type f(m_output_type);
+            f.soft_assign(outval);
+            outval = f;
+          }
+        }
+      } else {
+        auto iter = rows->cbegin();
+        auto output_iter = output->begin();
+        while(iter != rows->cend()) {
+          auto outval = m_transform_fn((*iter));
+          if (m_output_type == flex_type_enum::UNDEFINED ||
+              outval.get_type() == m_output_type ||
+              outval.get_type() == flex_type_enum::UNDEFINED) {
+            (*output_iter)[0] = outval;
+          } else {
+            flexible_type f(m_output_type);
+            f.soft_assign(outval);
+            (*output_iter)[0] = f;
+          }
+          ++output_iter;
+          ++iter;
         }
-        ++output_iter;
-        ++iter;
       }
       context.emit(output);
       }
@@ -97,11 +119,14 @@ class operator_impl<planner_node_type::TRANSFORM_NODE> : public query_operator {
       std::shared_ptr<planner_node> source,
       transform_type fn,
       flex_type_enum output_type,
-      int random_seed=-1) {
+      int random_seed=-1,
+      batch_expression_ptr expression=nullptr) {
+    std::map<std::string, any> any_params{{"function", any(fn)}};
+    if (expression) any_params["batch_expression"] = any(expression);
     return planner_node::make_shared(planner_node_type::TRANSFORM_NODE,
                                      {{"output_type", (int)(output_type)},
                                       {"random_seed", random_seed}},
-                                     {{"function", any(fn)}},
+                                     any_params,
                                      {source});
   }
 
@@ -116,7 +141,12 @@ class operator_impl<planner_node_type::TRANSFORM_NODE> : public query_operator {
         (flex_type_enum)(flex_int)(pnode->operator_parameters["output_type"]);
     fn = pnode->any_operator_parameters["function"].as<transform_type>();
     int random_seed = (int)(flex_int)(pnode->operator_parameters["random_seed"]);
-    return std::make_shared<operator_impl>(fn, output_type, random_seed);
+    batch_expression_ptr expression;
+    if (pnode->any_operator_parameters.count("batch_expression")) {
+      expression = pnode->any_operator_parameters["batch_expression"]
+                       .as<batch_expression_ptr>();
+    }
+    return std::make_shared<operator_impl>(fn, output_type, random_seed, expression);
   }
 
   static std::vector<flex_type_enum> infer_type(std::shared_ptr<planner_node> pnode) {
@@ -134,6 +164,7 @@ class operator_impl<planner_node_type::TRANSFORM_NODE> : public query_operator {
   transform_type m_transform_fn;
   flex_type_enum m_output_type;
   int m_random_seed;
+  batch_expression_ptr m_expression;
 };
 
 typedef operator_impl<planner_node_type::TRANSFORM_NODE> op_transform;
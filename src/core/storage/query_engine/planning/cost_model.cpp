@@ -0,0 +1,268 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <map>
+#include <set>
+#include <core/storage/query_engine/planning/cost_model.hpp>
+#include <core/storage/query_engine/operators/all_operators.hpp>
+#include <core/storage/query_engine/operators/batch_expression.hpp>
+#include <core/storage/query_engine/operators/operator_properties.hpp>
+#include <core/storage/sframe_data/sarray_v2_type_encoding.hpp>
+#include <core/storage/sframe_data/sarray_v2_zone_map.hpp>
+
+namespace turi { namespace query_eval {
+
+using v2_block_impl::block_predicate;
+using v2_block_impl::block_zone_map;
+
+namespace {
+
+/// Selectivities assumed for comparisons without zone maps.
+static const double DEFAULT_EQUALITY_SELECTIVITY = 0.1;
+static const double DEFAULT_RANGE_SELECTIVITY = 1.0 / 3;
+
+/**
+ * Returns the sarray holding the first column of a source node, or nullptr
+ * if the node is not an sarray or sframe source.
+ */
+std::shared_ptr<sarray<flexible_type>> get_source_column(const pnode_ptr& n) {
+  if (n->operator_type == planner_node_type::SARRAY_SOURCE_NODE) {
+    return n->any_operator_parameters.at("sarray")
+        .as<std::shared_ptr<sarray<flexible_type>>>();
+  } else if (n->operator_type == planner_node_type::SFRAME_SOURCE_NODE) {
+    const auto& sf = n->any_operator_parameters.at("sframe").as<sframe>();
+    if (sf.num_columns() > 0) return sf.select_column(0);
+  }
+  return nullptr;
+}
+
+/**
+ * Estimates the fraction of the elements of a column satisfying pred from
+ * the zone maps of the column (over the whole array, even if the source
+ * only reads a range of it). Blocks without zone maps count as matching
+ * with the given default. Returns -1 if the column has no zone maps at all.
+ */
+double zone_map_selectivity(const std::shared_ptr<sarray<flexible_type>>& sa,
+                            const block_predicate& pred,
+                            double default_selectivity) {
+  auto index_info = sa->get_index_info();
+  double total = 0, matches = 0;
+  bool any_valid = false;
+  for (const auto& segment: index_info.block_zone_maps) {
+    for (const block_zone_map& zone_map: segment) {
+      total += zone_map.num_elem;
+      if (zone_map.valid) {
+        any_valid = true;
+        matches += zone_map.estimate_num_matches(pred);
+      } else {
+        matches += zone_map.num_elem * default_selectivity;
+      }
+    }
+  }
+  if (!any_valid) return -1;
+  if (total == 0) return 0;
+  return matches / total;
+}
+
+/**
+ * Estimates the selectivity of a comparison between the first column of
+ * input and a constant. op is the comparison with the input on the left.
+ */
+double comparison_selectivity(const std::string& op,
+                              const flexible_type& value,
+                              const pnode_ptr& input) {
+  typedef block_predicate::op_type op_type;
+  block_predicate pred;
+  pred.value = value;
+  double default_selectivity = DEFAULT_RANGE_SELECTIVITY;
+  if (op == "==") {
+    pred.op = op_type::EQ;
+    default_selectivity = DEFAULT_EQUALITY_SELECTIVITY;
+  } else if (op == "!=") {
+    pred.op = op_type::NE;
+    default_selectivity = 1 - DEFAULT_EQUALITY_SELECTIVITY;
+  } else if (op == "<") {
+    pred.op = op_type::LT;
+  } else if (op == "<=") {
+    pred.op = op_type::LE;
+  } else if (op == ">") {
+    pred.op = op_type::GT;
+  } else {
+    pred.op = op_type::GE;
+  }
+  auto sa = get_source_column(input);
+  if (sa == nullptr) return default_selectivity;
+  double ret = zone_map_selectivity(sa, pred, default_selectivity);
+  if (ret < 0) return default_selectivity;
+  if (op == "!=") {
+    // undefined values compare unequal to everything
+    block_predicate undefined;
+    undefined.op = op_type::IS_UNDEFINED;
+    ret += std::max(zone_map_selectivity(sa, undefined, 0), 0.0);
+  }
+  return std::min(ret, 1.0);
+}
+
+/**
+ * Estimates the fraction of rows for which the expression is non-zero.
+ * inputs are the input streams of the transform holding the expression.
+ */
+double expression_selectivity(const batch_expression& expr,
+                              const std::vector<pnode_ptr>& inputs) {
+  typedef batch_expression::node_type node_type;
+  if (expr.type == node_type::CONSTANT) {
+    return expr.constant.is_zero() ? 0 : 1;
+  }
+  if (expr.type != node_type::BINARY_OP) return DEFAULT_FILTER_SELECTIVITY;
+
+  if (expr.op == "&" || expr.op == "|") {
+    // assume the operands are independent
+    double l = expression_selectivity(*expr.left, inputs);
+    double r = expression_selectivity(*expr.right, inputs);
+    return expr.op == "&" ? l * r : l + r - l * r;
+  }
+
+  static const std::map<std::string, std::string> flipped_comparisons{
+    {"==", "=="}, {"!=", "!="}, {"<", ">"}, {">", "<"}, {"<=", ">="}, {">=", "<="}};
+  auto flipped = flipped_comparisons.find(expr.op);
+  if (flipped == flipped_comparisons.end()) return DEFAULT_FILTER_SELECTIVITY;
+
+  const batch_expression* input = expr.left.get();
+  const batch_expression* constant = expr.right.get();
+  std::string op = expr.op;
+  if (input->type != node_type::INPUT) {
+    std::swap(input, constant);
+    op = flipped->second;
+  }
+  if (input->type != node_type::INPUT ||
+      constant->type != node_type::CONSTANT ||
+      input->input_index >= inputs.size()) {
+    return (op == "==" || op == "!=") ?
+        DEFAULT_EQUALITY_SELECTIVITY : DEFAULT_RANGE_SELECTIVITY;
+  }
+  return comparison_selectivity(op, constant->constant, inputs[input->input_index]);
+}
+
+double estimate_length_impl(const pnode_ptr& n, std::map<pnode_ptr, double>& memo) {
+  auto it = memo.find(n);
+  if (it != memo.end()) return it->second;
+
+  double ret = 0;
+  int64_t length = infer_planner_node_length(n);
+  if (length >= 0) {
+    ret = length;
+  } else if (n->operator_type == planner_node_type::LOGICAL_FILTER_NODE) {
+    ret = estimate_length_impl(n->inputs[0], memo) * estimate_selectivity(n->inputs[1]);
+  } else if (n->operator_type == planner_node_type::APPEND_NODE) {
+    for (const auto& input: n->inputs) ret += estimate_length_impl(input, memo);
+  } else if (n->operator_type == planner_node_type::REDUCE_NODE) {
+    ret = 1;
+  } else if (n->operator_type == planner_node_type::TOPK_NODE) {
+    ret = std::min<double>(estimate_length_impl(n->inputs[0], memo),
+                           (flex_int)n->operator_parameters.at("k"));
+  } else if (!n->inputs.empty()) {
+    ret = estimate_length_impl(n->inputs[0], memo);
+  }
+  memo[n] = ret;
+  return ret;
+}
+
+double estimate_cost_impl(const pnode_ptr& n,
+                          bool include_sources,
+                          std::map<pnode_ptr, double>& length_memo,
+                          std::set<pnode_ptr>& seen) {
+  if (!seen.insert(n).second) return 0;
+  double ret = 0;
+  double rows = 0;
+  for (const auto& input: n->inputs) {
+    ret += estimate_cost_impl(input, include_sources, length_memo, seen);
+    rows = std::max(rows, estimate_length_impl(input, length_memo));
+  }
+  if (n->inputs.empty()) {
+    if (!include_sources) return 0;
+    rows = estimate_length_impl(n, length_memo);
+  }
+  return ret + rows * planner_node_row_cost(n);
+}
+
+} // anonymous namespace
+
+
+double planner_node_row_cost(const pnode_ptr& n) {
+  switch (n->operator_type) {
+   case planner_node_type::SARRAY_SOURCE_NODE:
+   case planner_node_type::SARRAY_PREDICATE_SOURCE_NODE:
+   case planner_node_type::LOGICAL_FILTER_NODE:
+   case planner_node_type::TERNARY_OPERATOR:
+   case planner_node_type::MERGE_JOIN_NODE:
+     return 1;
+   case planner_node_type::SFRAME_SOURCE_NODE:
+   case planner_node_type::PARQUET_SOURCE_NODE:
+     return std::max<double>(infer_planner_node_num_output_columns(n), 1);
+   case planner_node_type::TRANSFORM_NODE:
+   case planner_node_type::BINARY_TRANSFORM_NODE:
+     return n->any_operator_parameters.count("batch_expression") ? 1 : 10;
+   case planner_node_type::GENERALIZED_TRANSFORM_NODE:
+   case planner_node_type::COLUMNWISE_TRANSFORM_NODE:
+   case planner_node_type::REDUCE_NODE:
+   case planner_node_type::TOPK_NODE:
+     return 10;
+   case planner_node_type::LAMBDA_TRANSFORM_NODE:
+     return 100;
+   default:
+     // projections, unions, appends, ranges and constants only move
+     // values around.
+     return 0.1;
+  }
+}
+
+
+double estimate_selectivity(const pnode_ptr& mask) {
+  if ((mask->operator_type == planner_node_type::TRANSFORM_NODE ||
+       mask->operator_type == planner_node_type::BINARY_TRANSFORM_NODE) &&
+      mask->any_operator_parameters.count("batch_expression")) {
+    const auto& expr = mask->any_operator_parameters.at("batch_expression")
+        .as<batch_expression_ptr>();
+    return expression_selectivity(*expr, mask->inputs);
+  }
+  if (mask->operator_type == planner_node_type::CONSTANT_NODE) {
+    return mask->operator_parameters.at("value").is_zero() ? 0 : 1;
+  }
+  if (mask->operator_type == planner_node_type::SARRAY_PREDICATE_SOURCE_NODE) {
+    auto pred = op_sarray_predicate_source::get_predicate(mask);
+    double default_selectivity = pred.op == block_predicate::op_type::EQ ?
+        DEFAULT_EQUALITY_SELECTIVITY : DEFAULT_RANGE_SELECTIVITY;
+    auto sa = mask->any_operator_parameters.at("sarray")
+        .as<std::shared_ptr<sarray<flexible_type>>>();
+    double ret = zone_map_selectivity(sa, pred, default_selectivity);
+    return ret >= 0 ? ret : default_selectivity;
+  }
+  auto sa = get_source_column(mask);
+  if (sa != nullptr) {
+    block_predicate pred;
+    pred.op = block_predicate::op_type::NE;
+    pred.value = 0;
+    // undefined values are not selected by a logical filter
+    double ret = zone_map_selectivity(sa, pred, DEFAULT_FILTER_SELECTIVITY);
+    if (ret >= 0) return ret;
+  }
+  return DEFAULT_FILTER_SELECTIVITY;
+}
+
+
+double estimate_planner_node_length(const pnode_ptr& pnode) {
+  std::map<pnode_ptr, double> memo;
+  return estimate_length_impl(pnode, memo);
+}
+
+
+double estimate_planner_node_cost(const pnode_ptr& pnode, bool include_sources) {
+  std::map<pnode_ptr, double> length_memo;
+  std::set<pnode_ptr> seen;
+  return estimate_cost_impl(pnode, include_sources, length_memo, seen);
+}
+
+}}
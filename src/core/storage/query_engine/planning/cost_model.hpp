@@ -0,0 +1,68 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_QUERY_ENGINE_COST_MODEL_HPP
+#define TURI_SFRAME_QUERY_ENGINE_COST_MODEL_HPP
+
+#include <memory>
+#include <core/storage/query_engine/planning/planner_node.hpp>
+
+namespace turi { namespace query_eval {
+
+/**
+ * \ingroup sframe_query_engine
+ * \addtogroup planning Planning, Optimization and Execution
+ * \{
+ */
+
+/**
+ * The selectivity assumed for a logical filter mask about which nothing
+ * is known.
+ */
+static const double DEFAULT_FILTER_SELECTIVITY = 0.5;
+
+/**
+ * Returns the relative cost of pushing a single row through the operator
+ * of a planner node, ignoring its inputs. Reading a column of a source
+ * or evaluating a fused batch expression costs 1; calling back into a
+ * C++ function costs about 10, and calling into Python about 100.
+ */
+double planner_node_row_cost(const std::shared_ptr<planner_node>& pnode);
+
+/**
+ * Estimates the fraction of the rows of a logical filter mask which are
+ * true.
+ *
+ * Masks which are a fused comparison (see \ref batch_expression) of a
+ * source column against a constant, and combinations of those with & and
+ * |, are estimated from the zone maps of the source column, and so are
+ * \ref op_sarray_predicate_source masks. A materialized mask is
+ * estimated from its own zone maps. Anything else is assumed to have a
+ * selectivity of \ref DEFAULT_FILTER_SELECTIVITY.
+ */
+double estimate_selectivity(const std::shared_ptr<planner_node>& mask);
+
+/**
+ * Estimates the number of rows produced by a planner node. This is exactly
+ * \ref infer_planner_node_length() where the length is known, and is
+ * otherwise estimated from the selectivities of the logical filters on the
+ * way to the sources.
+ */
+double estimate_planner_node_length(const std::shared_ptr<planner_node>& pnode);
+
+/**
+ * Estimates the cost of materializing a planner node: the sum over every
+ * node of the graph of its \ref planner_node_row_cost() times the
+ * estimated number of rows it processes. Shared nodes are only counted
+ * once. If include_sources is false, the cost of reading the source
+ * nodes is left out.
+ */
+double estimate_planner_node_cost(const std::shared_ptr<planner_node>& pnode,
+                                  bool include_sources = true);
+
+/// \}
+}}
+
+#endif
@@ -0,0 +1,112 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <core/storage/query_engine/planning/explain.hpp>
+#include <core/storage/query_engine/planning/cost_model.hpp>
+#include <core/storage/query_engine/planning/optimization_engine.hpp>
+#include <core/storage/query_engine/operators/operator_properties.hpp>
+
+namespace turi { namespace query_eval {
+
+namespace {
+
+/**
+ * The optimization engine rewires the nodes of the graph it optimizes,
+ * so explaining works on a copy of every node, sharing the same way.
+ */
+pnode_ptr copy_graph(const pnode_ptr& n, std::map<pnode_ptr, pnode_ptr>& copies) {
+  auto it = copies.find(n);
+  if (it != copies.end()) return it->second;
+
+  pnode_ptr ret = n->clone();
+  for (auto& input : ret->inputs) input = copy_graph(input, copies);
+  copies[n] = ret;
+  return ret;
+}
+
+std::string format_estimate(double v) {
+  std::ostringstream ss;
+  if (v < 0) {
+    ss << "unknown";
+  } else {
+    ss << std::fixed << std::setprecision(0) << v;
+  }
+  return ss.str();
+}
+
+std::string annotate_rows(pnode_ptr n) {
+  return "[rows=" + format_estimate(estimate_planner_node_length(n)) + "]";
+}
+
+std::string to_dot(const pnode_ptr& n) {
+  std::ostringstream ss;
+  ss << n;
+  return ss.str();
+}
+
+} // anonymous namespace
+
+std::string query_plan_explanation::to_string() const {
+  std::ostringstream ss;
+  ss << "Logical plan (estimated rows " << format_estimate(logical_rows)
+     << ", cost " << format_estimate(logical_cost) << "):\n"
+     << logical_plan << "\n";
+
+  ss << "Optimizations applied:\n";
+  if (applied_transforms.empty()) ss << "  (none)\n";
+  for (const auto& t : applied_transforms) ss << "  " << t << "\n";
+  ss << "\n";
+
+  ss << "Optimized plan (estimated rows " << format_estimate(optimized_rows)
+     << ", cost " << format_estimate(optimized_cost) << "):\n"
+     << optimized_plan;
+  return ss.str();
+}
+
+std::map<std::string, flexible_type> query_plan_explanation::to_map() const {
+  flex_list transforms(applied_transforms.begin(), applied_transforms.end());
+  return {{"text", to_string()},
+          {"logical_plan", logical_plan},
+          {"logical_plan_dot", logical_plan_dot},
+          {"optimized_plan", optimized_plan},
+          {"optimized_plan_dot", optimized_plan_dot},
+          {"applied_transforms", transforms},
+          {"logical_rows", logical_rows},
+          {"optimized_rows", optimized_rows},
+          {"logical_cost", logical_cost},
+          {"optimized_cost", optimized_cost}};
+}
+
+query_plan_explanation explain_query_plan(const pnode_ptr& tip,
+                                          const materialize_options& exec_params) {
+  query_plan_explanation ret;
+
+  std::map<pnode_ptr, pnode_ptr> copies;
+  pnode_ptr plan = copy_graph(tip, copies);
+
+  ret.logical_plan = planner_node_tree_string(plan, annotate_rows);
+  ret.logical_plan_dot = to_dot(plan);
+  ret.logical_rows = estimate_planner_node_length(plan);
+  ret.logical_cost = estimate_planner_node_cost(plan);
+
+  pnode_ptr optimized = plan;
+  if (!exec_params.disable_optimization && !exec_params.naive_mode) {
+    materialize_options opt_params = exec_params;
+    opt_params.applied_transforms = std::make_shared<std::vector<std::string>>();
+    optimized = optimization_engine::optimize_planner_graph(plan, opt_params);
+    ret.applied_transforms = *opt_params.applied_transforms;
+  }
+
+  ret.optimized_plan = planner_node_tree_string(optimized, annotate_rows);
+  ret.optimized_plan_dot = to_dot(optimized);
+  ret.optimized_rows = estimate_planner_node_length(optimized);
+  ret.optimized_cost = estimate_planner_node_cost(optimized);
+  return ret;
+}
+
+}}
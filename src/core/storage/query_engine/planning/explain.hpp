@@ -0,0 +1,78 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_QUERY_ENGINE_EXPLAIN_HPP
+#define TURI_SFRAME_QUERY_ENGINE_EXPLAIN_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/storage/query_engine/planning/planner_node.hpp>
+#include <core/storage/query_engine/planning/materialize_options.hpp>
+
+namespace turi { namespace query_eval {
+
+/**
+ * \ingroup sframe_query_engine
+ * \addtogroup planning Planning, Optimization and Execution
+ * \{
+ */
+
+/**
+ * What the query engine would do with a lazy query plan, without
+ * executing it: the plan as built, the plan after optimization, the
+ * optimization transforms which got it there, and the estimates of the
+ * \ref cost_model for both. Returned by \ref explain_query_plan().
+ */
+struct query_plan_explanation {
+  /// The plan as built, as an indented tree with the estimated rows per node.
+  std::string logical_plan;
+
+  /// The plan as built, as a dot graph.
+  std::string logical_plan_dot;
+
+  /// The plan after optimization, as an indented tree.
+  std::string optimized_plan;
+
+  /// The plan after optimization, as a dot graph.
+  std::string optimized_plan_dot;
+
+  /// The descriptions of the optimization transforms applied, in order.
+  std::vector<std::string> applied_transforms;
+
+  /// See \ref estimate_planner_node_length().
+  double logical_rows = 0;
+  double optimized_rows = 0;
+
+  /// See \ref estimate_planner_node_cost().
+  double logical_cost = 0;
+  double optimized_cost = 0;
+
+  /// All of the above except the dot graphs, as readable text.
+  std::string to_string() const;
+
+  /**
+   * Everything as a dictionary, with keys "text" (see \ref to_string()),
+   * "logical_plan", "logical_plan_dot", "optimized_plan",
+   * "optimized_plan_dot", "applied_transforms", "logical_rows",
+   * "optimized_rows", "logical_cost" and "optimized_cost".
+   */
+  std::map<std::string, flexible_type> to_map() const;
+};
+
+/**
+ * Optimizes a copy of the plan below tip, as materializing it with
+ * exec_params would, and explains the result. The plan itself is left
+ * untouched, and nothing is executed.
+ */
+query_plan_explanation explain_query_plan(
+    const pnode_ptr& tip,
+    const materialize_options& exec_params = materialize_options());
+
+/// \}
+}}
+
+#endif
@@ -0,0 +1,205 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <map>
+#include <sstream>
+#include <core/logging/logger.hpp>
+#include <core/storage/serialization/serialization_includes.hpp>
+#include <core/storage/query_engine/planning/materialization_cache.hpp>
+#include <core/storage/query_engine/operators/batch_expression.hpp>
+#include <core/storage/query_engine/operators/operator_properties.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
+
+namespace turi { namespace query_eval {
+
+namespace {
+
+/**
+ * Keys longer than this are not cached; the key holds the serialized index
+ * of every source, which is large for sources with very many blocks.
+ */
+static const size_t MAX_KEY_LENGTH = 1024 * 1024;
+
+void write_expression(oarchive& oarc, const batch_expression& expr) {
+  // The scalar functions are determined by the operators and types.
+  oarc << (int)expr.type << (int)expr.value_type << expr.input_index
+       << expr.constant << expr.op;
+  if (expr.left) write_expression(oarc, *expr.left);
+  if (expr.right) write_expression(oarc, *expr.right);
+}
+
+/**
+ * Writes the structure of the graph at n to oarc. Every node is written
+ * once; later references to it are written as its index. Returns false if
+ * the graph cannot be cached.
+ */
+bool write_node(oarchive& oarc,
+                const pnode_ptr& n,
+                std::map<pnode_ptr, size_t>& ids,
+                std::vector<std::weak_ptr<sarray<flexible_type>>>& sources) {
+  auto it = ids.find(n);
+  if (it != ids.end()) {
+    oarc << true << it->second;
+    return true;
+  }
+  size_t id = ids.size();
+  ids[n] = id;
+  oarc << false << (int)n->operator_type;
+
+  switch (n->operator_type) {
+   case planner_node_type::SARRAY_SOURCE_NODE:
+     sources.push_back(n->any_operator_parameters.at("sarray")
+                       .as<std::shared_ptr<sarray<flexible_type>>>());
+     break;
+   case planner_node_type::SFRAME_SOURCE_NODE: {
+     const auto& sf = n->any_operator_parameters.at("sframe").as<sframe>();
+     for (size_t i = 0; i < sf.num_columns(); ++i) {
+       sources.push_back(sf.select_column(i));
+     }
+     break;
+   }
+   case planner_node_type::TRANSFORM_NODE:
+   case planner_node_type::BINARY_TRANSFORM_NODE: {
+     // only transforms with a known expression
+     auto expr = n->any_operator_parameters.find("batch_expression");
+     if (expr == n->any_operator_parameters.end()) return false;
+     auto seed = n->operator_parameters.find("random_seed");
+     if (seed != n->operator_parameters.end() && seed->second != -1) return false;
+     write_expression(oarc, *(expr->second.as<batch_expression_ptr>()));
+     break;
+   }
+   case planner_node_type::CONSTANT_NODE:
+   case planner_node_type::RANGE_NODE:
+   case planner_node_type::PROJECT_NODE:
+   case planner_node_type::UNION_NODE:
+   case planner_node_type::APPEND_NODE:
+   case planner_node_type::LOGICAL_FILTER_NODE:
+     break;
+   default:
+     return false;
+  }
+
+  // sources are identified by their serialized index, which is one of the
+  // parameters.
+  oarc << n->operator_parameters.size();
+  for (const auto& param: n->operator_parameters) {
+    oarc << param.first << param.second;
+  }
+  oarc << n->inputs.size();
+  for (const auto& input: n->inputs) {
+    if (!write_node(oarc, input, ids, sources)) return false;
+  }
+  return true;
+}
+
+} // anonymous namespace
+
+
+materialization_cache& materialization_cache::get_instance() {
+  static materialization_cache* instance = new materialization_cache();
+  return *instance;
+}
+
+
+materialization_cache::graph_key materialization_cache::make_key(const pnode_ptr& tip) {
+  graph_key ret;
+  std::stringstream strm;
+  oarchive oarc(strm);
+  std::map<pnode_ptr, size_t> ids;
+  if (write_node(oarc, tip, ids, ret.sources)) {
+    ret.key = strm.str();
+  }
+  if (ret.key.length() > MAX_KEY_LENGTH) ret.key.clear();
+  if (ret.key.empty()) ret.sources.clear();
+  return ret;
+}
+
+
+bool materialization_cache::lookup(
+    const graph_key& key,
+    std::vector<std::shared_ptr<sarray<flexible_type>>>& columns) {
+  if (key.key.empty()) return false;
+  std::lock_guard<mutex> guard(m_lock);
+  drop_expired_entries();
+  auto it = m_entries.find(key.key);
+  if (it == m_entries.end()) return false;
+  m_lru.splice(m_lru.begin(), m_lru, it->second.lru_position);
+  columns = it->second.columns;
+  return true;
+}
+
+
+void materialization_cache::insert(const graph_key& key, const sframe& result) {
+  if (key.key.empty()) return;
+  size_t num_cells = result.num_rows() * result.num_columns();
+  std::lock_guard<mutex> guard(m_lock);
+  drop_expired_entries();
+  if (SFRAME_MATERIALIZATION_CACHE_CAPACITY == 0 ||
+      num_cells > SFRAME_MATERIALIZATION_CACHE_MAX_CELLS) {
+    return;
+  }
+  auto it = m_entries.find(key.key);
+  if (it != m_entries.end()) erase_entry(it);
+
+  while (!m_lru.empty() &&
+         (m_entries.size() >= SFRAME_MATERIALIZATION_CACHE_CAPACITY ||
+          m_total_cells + num_cells > SFRAME_MATERIALIZATION_CACHE_MAX_CELLS)) {
+    erase_entry(m_entries.find(m_lru.back()));
+  }
+
+  m_lru.push_front(key.key);
+  entry& e = m_entries[key.key];
+  for (size_t i = 0; i < result.num_columns(); ++i) {
+    e.columns.push_back(result.select_column(i));
+  }
+  e.sources = key.sources;
+  e.num_cells = num_cells;
+  e.lru_position = m_lru.begin();
+  m_total_cells += num_cells;
+}
+
+
+void materialization_cache::clear() {
+  std::lock_guard<mutex> guard(m_lock);
+  m_entries.clear();
+  m_lru.clear();
+  m_total_cells = 0;
+}
+
+
+size_t materialization_cache::size() const {
+  std::lock_guard<mutex> guard(m_lock);
+  return m_entries.size();
+}
+
+
+void materialization_cache::drop_expired_entries() {
+  for (auto it = m_entries.begin(); it != m_entries.end(); ) {
+    bool expired = false;
+    for (const auto& source: it->second.sources) {
+      if (source.expired()) {
+        expired = true;
+        break;
+      }
+    }
+    auto next = std::next(it);
+    if (expired) {
+      logstream(LOG_INFO) << "Dropping cached materialization with a released source"
+                          << std::endl;
+      erase_entry(it);
+    }
+    it = next;
+  }
+}
+
+
+void materialization_cache::erase_entry(
+    std::unordered_map<std::string, entry>::iterator it) {
+  m_total_cells -= it->second.num_cells;
+  m_lru.erase(it->second.lru_position);
+  m_entries.erase(it);
+}
+
+}}
@@ -0,0 +1,113 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_QUERY_ENGINE_MATERIALIZATION_CACHE_HPP
+#define TURI_SFRAME_QUERY_ENGINE_MATERIALIZATION_CACHE_HPP
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <core/parallel/mutex.hpp>
+#include <core/storage/query_engine/planning/planner_node.hpp>
+#include <core/storage/sframe_data/sarray.hpp>
+#include <core/storage/sframe_data/sframe.hpp>
+
+namespace turi { namespace query_eval {
+
+/**
+ * \ingroup sframe_query_engine
+ * \addtogroup planning Planning, Optimization and Execution
+ * \{
+ */
+
+/**
+ * A bounded cache of the results of earlier materializations, keyed by
+ * the structure of the materialized planner graph.
+ *
+ * Once a planner node is materialized, the planner replaces it with a
+ * source node, so materializing the same node again is free. But two
+ * separately built graphs computing the same thing (for instance the
+ * same derived column, rebuilt from the same sources by re-running a
+ * notebook cell) would each be executed from the sources. The cache
+ * recognizes such graphs, and returns the columns materialized the first
+ * time.
+ *
+ * Only graphs made of nodes whose output is fully determined by their
+ * parameters can be cached: sources, projections, unions, appends,
+ * logical filters, constants, ranges, and transforms defined by a
+ * \ref batch_expression. Graphs containing opaque functions (lambdas,
+ * C++ callbacks) are never cached.
+ *
+ * An entry refers to its source sarrays only weakly. When any of them is
+ * destroyed, no equal graph can be built anymore, and the entry is dropped.
+ * The cache holds at most SFRAME_MATERIALIZATION_CACHE_CAPACITY entries,
+ * and at most SFRAME_MATERIALIZATION_CACHE_MAX_CELLS cells over all
+ * entries, evicting least recently used entries first.
+ */
+class materialization_cache {
+ public:
+  /// A structural description of a planner graph.
+  struct graph_key {
+    /// Equal for graphs computing the same result. Empty if not cacheable.
+    std::string key;
+    /// The source arrays read by the graph.
+    std::vector<std::weak_ptr<sarray<flexible_type>>> sources;
+  };
+
+  static materialization_cache& get_instance();
+
+  /**
+   * Computes the structural key of the graph rooted at tip. Returns a key
+   * with an empty string if the graph cannot be cached.
+   */
+  static graph_key make_key(const std::shared_ptr<planner_node>& tip);
+
+  /**
+   * Looks up the columns materialized for a key. Returns true and fills
+   * columns if they are cached.
+   */
+  bool lookup(const graph_key& key,
+              std::vector<std::shared_ptr<sarray<flexible_type>>>& columns);
+
+  /**
+   * Stores the result of materializing the graph with the given key.
+   */
+  void insert(const graph_key& key, const sframe& result);
+
+  /// Drops all entries.
+  void clear();
+
+  /// The number of entries in the cache.
+  size_t size() const;
+
+ private:
+  materialization_cache() = default;
+
+  struct entry {
+    std::vector<std::shared_ptr<sarray<flexible_type>>> columns;
+    std::vector<std::weak_ptr<sarray<flexible_type>>> sources;
+    size_t num_cells = 0;
+    std::list<std::string>::iterator lru_position;
+  };
+
+  /// Drops the entries with expired sources. m_lock must be held.
+  void drop_expired_entries();
+
+  /// Drops an entry. m_lock must be held.
+  void erase_entry(std::unordered_map<std::string, entry>::iterator it);
+
+  mutable mutex m_lock;
+  std::unordered_map<std::string, entry> m_entries;
+  /// Keys in order of use; the most recently used at the front.
+  std::list<std::string> m_lru;
+  size_t m_total_cells = 0;
+};
+
+/// \}
+}}
+
+#endif
@@ -14,6 +14,7 @@
 namespace turi {
 class sframe_rows;
 namespace query_eval {
+class query_profile;
 
 /**
  * \ingroup sframe_query_engine
@@ -93,6 +94,18 @@ struct materialize_options {
    * This argument has no effect if \ref write_callback is set.
    */
   std::vector<std::string> output_column_names;
+
+  /**
+   * If set, the rows, time and bytes read by every operator executed are
+   * added to this profile. See \ref query_profile.
+   */
+  std::shared_ptr<query_profile> profile;
+
+  /**
+   * If set, the description of every optimization transform applied to
+   * the query plan is appended to this list, in the order applied.
+   */
+  std::shared_ptr<std::vector<std::string>> applied_transforms;
 };
 
 /// \}
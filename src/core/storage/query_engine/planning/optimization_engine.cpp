@@ -360,6 +360,8 @@ void optimization_engine::run_stage(size_t stage, node_info_ptr tip, const mater
 #ifndef NDEBUG
           logstream(LOG_INFO) << "Applied transform: " << tr->description() << std::endl;
 #endif
+          if(exec_params.applied_transforms)
+            exec_params.applied_transforms->push_back(tr->description());
           optimization_occured = true;
 
           // Uncomment for additional (expensive) debugging info.
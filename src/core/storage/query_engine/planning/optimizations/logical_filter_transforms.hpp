@@ -9,11 +9,15 @@
 #include <core/storage/query_engine/planning/optimizations/optimization_transforms.hpp>
 #include <core/storage/query_engine/planning/optimization_engine.hpp>
 #include <core/storage/query_engine/operators/all_operators.hpp>
+#include <core/storage/query_engine/operators/batch_expression.hpp>
 #include <core/storage/query_engine/planning/optimization_node_info.hpp>
+#include <core/storage/query_engine/planning/cost_model.hpp>
 #include <core/storage/query_engine/operators/operator_properties.hpp>
 #include <core/data/flexible_type/flexible_type.hpp>
 
 #include <array>
+#include <map>
+#include <set>
 
 namespace turi {
 namespace query_eval {
@@ -91,6 +95,106 @@ class opt_logical_filter_expanding_project_exchange
   }
 };
 
+class opt_logical_filter_order_by_cost
+    : public opt_logical_filter_transform {
+
+  std::string description() {
+    return "logical_filter(logical_filter(a, m1), m2(m1)) -> "
+           "logical_filter(logical_filter(a, m2), logical_filter(m1, m2))";
+  }
+
+  /** Rebuilds n with every logical_filter(x, mask) replaced by x, so that
+   *  the result is computed over the rows before the filter.  Returns
+   *  nullptr if n is not a linear function of such filters.
+   */
+  static pnode_ptr remove_filter(const pnode_ptr& n, const pnode_ptr& mask,
+                                 std::map<pnode_ptr, pnode_ptr>& memo) {
+    auto it = memo.find(n);
+    if(it != memo.end())
+      return it->second;
+
+    pnode_ptr ret;
+    if(n->operator_type == planner_node_type::LOGICAL_FILTER_NODE
+       && n->inputs[1] == mask) {
+      ret = n->inputs[0];
+    } else if(is_linear_transform(n) && !n->inputs.empty()) {
+      ret = n->clone();
+      for(size_t i = 0; i < n->inputs.size(); ++i) {
+        ret->inputs[i] = remove_filter(n->inputs[i], mask, memo);
+        if(ret->inputs[i] == nullptr) {
+          ret.reset();
+          break;
+        }
+      }
+    }
+    memo[n] = ret;
+    return ret;
+  }
+
+  /** True if a seeded random transform is part of the graph; changing the
+   *  rows those see would change the result.
+   */
+  static bool has_random_transform(const pnode_ptr& n, std::set<pnode_ptr>& seen) {
+    if(!seen.insert(n).second)
+      return false;
+    auto it = n->operator_parameters.find("random_seed");
+    if(it != n->operator_parameters.end() && it->second != -1)
+      return true;
+    for(const auto& input : n->inputs) {
+      if(has_random_transform(input, seen))
+        return true;
+    }
+    return false;
+  }
+
+  // The filters select the same rows in either order.  The current order
+  // computes m1 on every row and m2 on the rows selected by m1, and the
+  // exchanged order the reverse, so the cheaper and more selective mask
+  // should go first.
+  bool apply_transform(optimization_engine *opt_manager, cnode_info_ptr n) {
+    DASSERT_TRUE(n->type == planner_node_type::LOGICAL_FILTER_NODE);
+
+    const cnode_info_ptr& inner = n->inputs[0];
+    if(inner->type != planner_node_type::LOGICAL_FILTER_NODE
+       || n->inputs[1]->outputs.size() > 1)
+      return false;
+
+    pnode_ptr a = inner->inputs[0]->pnode;
+    pnode_ptr m1 = inner->inputs[1]->pnode;
+
+    std::map<pnode_ptr, pnode_ptr> memo;
+    pnode_ptr m2 = remove_filter(n->inputs[1]->pnode, m1, memo);
+    if(m2 == nullptr)
+      return false;
+
+    // The inner filter may only be used here and in computing m2, or it
+    // would have to be computed anyway.
+    for(const auto& out : inner->outputs) {
+      if(out != n && !memo.count(out->pnode))
+        return false;
+    }
+
+    std::set<pnode_ptr> seen;
+    if(has_random_transform(m1, seen) || has_random_transform(m2, seen))
+      return false;
+
+    double m1_cost = estimate_planner_node_cost(m1, false);
+    double m2_cost = estimate_planner_node_cost(m2, false);
+    double current_cost = m1_cost + estimate_selectivity(m1) * m2_cost;
+    double exchanged_cost = m2_cost + estimate_selectivity(m2) * m1_cost;
+
+    // Require a clear improvement, so the exchange never flips back.
+    if(!(exchanged_cost < 0.99 * current_cost))
+      return false;
+
+    pnode_ptr new_inner = op_logical_filter::make_planner_node(a, m2);
+    pnode_ptr new_mask = op_logical_filter::make_planner_node(m1, m2);
+
+    opt_manager->replace_node(n, op_logical_filter::make_planner_node(new_inner, new_mask));
+    return true;
+  }
+};
+
 class opt_merge_identical_logical_filters
     : public opt_logical_filter_transform {
 
@@ -106,7 +210,7 @@ class opt_merge_identical_logical_filters
     // node, and only if there is one output.
 
     size_t n_logical_filter_outs = 0;
-    for(const cnode_info_ptr& nn : n->inputs[1]->outputs) {
+    for(const auto& nn : n->inputs[1]->outputs) {
       if(nn->type == planner_node_type::LOGICAL_FILTER_NODE
          && nn->inputs[1] == n->inputs[1]) {
 
@@ -123,7 +227,7 @@ class opt_merge_identical_logical_filters
 
     size_t idx = 0;
     size_t out_idx = 0;
-    for(const cnode_info_ptr& nn : n->inputs[1]->outputs) {
+    for(const auto& nn : n->inputs[1]->outputs) {
       if(nn->type == planner_node_type::LOGICAL_FILTER_NODE
          && nn->inputs[1] == n->inputs[1]) {
 
@@ -159,6 +263,81 @@ class opt_merge_identical_logical_filters
   }
 };
 
+class opt_logical_filter_source_predicate
+    : public opt_logical_filter_transform {
+
+  std::string description() {
+    return "logical_filter(a, transform(sarray_source, x op c)) -> "
+           "logical_filter(a, sarray_predicate_source)";
+  }
+
+  /** Fills pred with the equivalent of a comparison between the input and
+   *  a constant. Returns false if the expression is not such a comparison,
+   *  or if the mask it computes may select a row which the predicate does
+   *  not.
+   */
+  static bool make_predicate(const batch_expression& expr,
+                             v2_block_impl::block_predicate& pred) {
+    typedef batch_expression::node_type node_type;
+    typedef v2_block_impl::block_predicate::op_type op_type;
+    // != is left out: the mask selects undefined values, which never
+    // satisfy a block predicate comparison.
+    static const std::map<std::string, std::pair<op_type, op_type>> comparisons{
+      {"==", {op_type::EQ, op_type::EQ}},
+      {"<", {op_type::LT, op_type::GT}}, {">", {op_type::GT, op_type::LT}},
+      {"<=", {op_type::LE, op_type::GE}}, {">=", {op_type::GE, op_type::LE}}};
+
+    if(expr.type != node_type::BINARY_OP)
+      return false;
+    auto it = comparisons.find(expr.op);
+    if(it == comparisons.end())
+      return false;
+
+    if(expr.left->type == node_type::INPUT
+       && expr.right->type == node_type::CONSTANT) {
+      pred.op = it->second.first;
+      pred.value = expr.right->constant;
+    } else if(expr.left->type == node_type::CONSTANT
+              && expr.right->type == node_type::INPUT) {
+      pred.op = it->second.second;
+      pred.value = expr.left->constant;
+    } else {
+      return false;
+    }
+    return pred.value.get_type() != flex_type_enum::UNDEFINED;
+  }
+
+  // A mask comparing a source column against a constant is replaced by a
+  // source evaluating the comparison, which does not read the blocks the
+  // zone maps rule out.  The filter then skips the matching rows of the
+  // data as well.
+  bool apply_transform(optimization_engine *opt_manager, cnode_info_ptr n) {
+    DASSERT_TRUE(n->type == planner_node_type::LOGICAL_FILTER_NODE);
+
+    const cnode_info_ptr& mask = n->inputs[1];
+    if(mask->type != planner_node_type::TRANSFORM_NODE
+       || mask->outputs.size() > 1
+       || mask->inputs[0]->type != planner_node_type::SARRAY_SOURCE_NODE)
+      return false;
+
+    auto expr_it = mask->pnode->any_operator_parameters.find("batch_expression");
+    if(expr_it == mask->pnode->any_operator_parameters.end())
+      return false;
+
+    v2_block_impl::block_predicate pred;
+    if(!make_predicate(*(expr_it->second.as<batch_expression_ptr>()), pred))
+      return false;
+
+    const cnode_info_ptr& source = mask->inputs[0];
+    auto sa = source->pnode->any_operator_parameters.at("sarray")
+        .as<std::shared_ptr<sarray<flexible_type>>>();
+    pnode_ptr new_mask = op_sarray_predicate_source::make_planner_node(
+        sa, pred, source->p("begin_index"), source->p("end_index"));
+
+    opt_manager->replace_node(n, op_logical_filter::make_planner_node(n->inputs[0]->pnode, new_mask));
+    return true;
+  }
+};
 
 }}
 #endif
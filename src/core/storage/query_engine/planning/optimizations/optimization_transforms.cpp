@@ -69,6 +69,7 @@ void populate_transforms(optimization_transform_registry *otr) {
   otr->register_optimization({1, 2, 3}, std::make_shared<opt_union_merge>());
   otr->register_optimization({1, 2, 3}, std::make_shared<opt_union_on_source>());
   otr->register_optimization({1, 2, 3}, std::make_shared<opt_project_on_source>());
+  otr->register_optimization({1, 2, 3}, std::make_shared<opt_project_on_parquet_source>());
   otr->register_optimization({1, 2, 3}, std::make_shared<opt_append_on_source>());
   otr->register_optimization({1, 2, 3}, std::make_shared<opt_merge_projects>());
   otr->register_optimization({1, 2, 3}, std::make_shared<opt_union_project_merge>());
@@ -81,6 +82,9 @@ void populate_transforms(optimization_transform_registry *otr) {
   // Optimizations that are allowed to turn the graph into a state
   // which cannot be materialized.
 
+  // Cost based: apply the cheaper and more selective of two stacked filters first.
+  otr->register_optimization({2}, std::make_shared<opt_logical_filter_order_by_cost>());
+
   otr->register_optimization({2}, std::make_shared<opt_project_logical_filter_exchange>());
   otr->register_optimization({2}, std::make_shared<opt_logical_filter_linear_transform_exchange>());
 
@@ -93,6 +97,11 @@ void populate_transforms(optimization_transform_registry *otr) {
 
   otr->register_optimization({3}, std::make_shared<opt_merge_identical_logical_filters>());
 
+  // Masks comparing a column to a constant are evaluated by the source,
+  // skipping the blocks ruled out by zone maps.  This comes after the
+  // merge above, as it gives every filter its own mask.
+  otr->register_optimization({3}, std::make_shared<opt_logical_filter_source_predicate>());
+
   ////////////////////////////////////////////////////////////////////////////////
   // Cleanup part 1: merge all the same sources into common nodes.
 
@@ -65,6 +65,52 @@ class opt_project_on_source : public opt_project_transform {
 };
 
 
+/**  Transform the projection on a parquet source node to a parquet source
+ *   node reading only the projected columns.
+ */
+class opt_project_on_parquet_source : public opt_project_transform {
+
+  std::string description() { return "project(parquet_source) -> parquet_source"; }
+
+  bool apply_transform(optimization_engine *opt_manager, cnode_info_ptr n) {
+
+    if(n->inputs[0]->type != planner_node_type::PARQUET_SOURCE_NODE)
+      return false;
+
+    auto flex_indices = n->p("indices").get<flex_list>();
+    auto old_columns = n->inputs[0]->p("columns").get<flex_list>();
+
+    if(flex_indices.size() > old_columns.size())
+      return false;
+
+    std::vector<size_t> columns;
+    for(const auto& idx_f : flex_indices) {
+      size_t idx = idx_f;
+      DASSERT_LT(idx, old_columns.size());
+      columns.push_back(old_columns[idx].get<flex_int>());
+    }
+
+    DASSERT_TRUE(!columns.empty());
+
+    std::vector<size_t> row_groups;
+    for(const auto& g : n->inputs[0]->p("row_groups").get<flex_list>()) {
+      row_groups.push_back(g.get<flex_int>());
+    }
+
+    size_t begin_index = n->inputs[0]->p("begin_index");
+    size_t end_index = n->inputs[0]->p("end_index");
+
+    auto reader = n->inputs[0]->any_p<std::shared_ptr<parquet_reader> >("parquet_reader");
+
+    pnode_ptr new_pnode = op_parquet_source::make_planner_node(
+        reader, columns, row_groups, begin_index, end_index);
+
+    opt_manager->replace_node(n, new_pnode);
+    return true;
+  }
+};
+
+
 /** Eliminate unneeded projections.
  */
 class opt_eliminate_identity_project : public opt_project_transform {
@@ -11,9 +11,12 @@
 #include <core/storage/query_engine/operators/all_operators.hpp>
 #include <core/storage/query_engine/planning/planner.hpp>
 #include <core/storage/query_engine/planning/optimization_engine.hpp>
+#include <core/storage/query_engine/planning/cost_model.hpp>
+#include <core/storage/query_engine/planning/materialization_cache.hpp>
 #include <core/storage/query_engine/query_engine_lock.hpp>
 #include <core/globals/globals.hpp>
 #include <core/storage/sframe_data/sframe.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
 
 namespace turi { namespace query_eval {
 
@@ -22,6 +25,25 @@ size_t SFRAME_MAX_LAZY_NODE_SIZE = 10000;
 REGISTER_GLOBAL(int64_t, SFRAME_MAX_LAZY_NODE_SIZE, true);
 
 
+/**
+ * Returns the number of morsels each of the num_segments segments of a
+ * parallel slicable plan should be split into, such that no morsel is
+ * smaller than SFRAME_MORSEL_MIN_ROWS source rows.
+ */
+static size_t get_morsels_per_segment(pnode_ptr input_n, size_t num_segments) {
+  pnode_ptr n = input_n;
+  while (!is_source_node(n)) {
+    if (n->inputs.empty()) return 1;
+    n = n->inputs[0];
+  }
+  size_t begin_index = n->operator_parameters.at("begin_index");
+  size_t end_index = n->operator_parameters.at("end_index");
+  size_t max_morsels = (end_index - begin_index) /
+                       (num_segments * SFRAME_MORSEL_MIN_ROWS);
+  return std::max<size_t>(1, std::min<size_t>(SFRAME_MORSELS_PER_SEGMENT,
+                                              max_morsels));
+}
+
 /**
  * Directly executes a linear query plan potentially parallelizing it if possible.
  * No fast path optimizations. You should use execute_node.
@@ -31,6 +53,13 @@ static sframe execute_node_impl(pnode_ptr input_n, const materialize_options& ex
   if(is_parallel_slicable(input_n) && (exec_params.num_segments != 0)) {
     size_t num_segments = exec_params.num_segments;
 
+    // split into morsels which are load balanced between the workers
+    size_t morsels_per_segment = get_morsels_per_segment(input_n, num_segments);
+    if (morsels_per_segment > 1) {
+      return subplan_executor().run_morsels(input_n, num_segments,
+                                            morsels_per_segment, exec_params);
+    }
+
     std::vector<pnode_ptr> segments(num_segments);
 
     for(size_t segment_idx = 0; segment_idx < num_segments; ++segment_idx) {
@@ -246,6 +275,25 @@ sframe planner::materialize(pnode_ptr ptip,
     exec_params.num_segments = thread::cpu_count();
   }
   auto original_ptip = ptip;
+
+  // Reuse the result of an earlier query computing the same thing. The
+  // debugging modes always execute the query.
+  materialization_cache::graph_key cache_key;
+  if (exec_params.write_callback == nullptr &&
+      exec_params.output_index_file.empty() &&
+      !exec_params.disable_optimization &&
+      !exec_params.naive_mode &&
+      !is_source_node(ptip)) {
+    cache_key = materialization_cache::make_key(ptip);
+    std::vector<std::shared_ptr<sarray<flexible_type>>> cached_columns;
+    if (materialization_cache::get_instance().lookup(cache_key, cached_columns)) {
+      logstream(LOG_INFO) << "Reusing cached materialization of: " << ptip << std::endl;
+      sframe ret_sf(cached_columns, exec_params.output_column_names);
+      (*original_ptip) = (*(op_sframe_source::make_planner_node(ret_sf)));
+      return ret_sf;
+    }
+  }
+
   // Optimize Query Plan
   if (!is_source_node(ptip)) {
     logstream(LOG_INFO) << "Materializing: " << ptip << std::endl;
@@ -277,6 +325,7 @@ sframe planner::materialize(pnode_ptr ptip,
     // no write callback
     // Rewrite the query node to be materialized source node
     auto ret_sf = execute_node(final_node, exec_params);
+    materialization_cache::get_instance().insert(cache_key, ret_sf);
     (*original_ptip) = (*(op_sframe_source::make_planner_node(ret_sf)));
     return ret_sf;
   } else {
@@ -285,6 +334,99 @@ sframe planner::materialize(pnode_ptr ptip,
   }
 }
 
+/**
+ * Replaces the subgraphs of n with the first equal subgraph (according to
+ * the materialization cache key) seen in by_key, so that several plans
+ * share the parts they have in common. Subgraphs without a key are only
+ * shared if they are the same nodes.
+ */
+static pnode_ptr share_common_subplans(pnode_ptr n,
+                                       std::map<pnode_ptr, pnode_ptr>& memo,
+                                       std::map<std::string, pnode_ptr>& by_key) {
+  if (memo.count(n)) return memo[n];
+  for (auto& input: n->inputs) {
+    input = share_common_subplans(input, memo, by_key);
+  }
+  pnode_ptr ret = n;
+  std::string key = materialization_cache::make_key(n).key;
+  if (!key.empty()) ret = by_key.emplace(key, n).first->second;
+  memo[n] = ret;
+  return ret;
+}
+
+std::vector<sframe> planner::materialize(const std::vector<pnode_ptr>& tips,
+                                         materialize_options exec_params) {
+  std::lock_guard<recursive_mutex> GLOBAL_LOCK(global_query_lock);
+  if (exec_params.write_callback != nullptr || !exec_params.output_index_file.empty()) {
+    log_and_throw("Materializing several nodes only supports SFrame outputs");
+  }
+  exec_params.output_column_names.clear();
+  std::vector<sframe> ret(tips.size());
+  if (tips.size() <= 1 || exec_params.naive_mode) {
+    for (size_t i = 0; i < tips.size(); ++i) ret[i] = materialize(tips[i], exec_params);
+    return ret;
+  }
+  if (exec_params.num_segments == 0) {
+    exec_params.num_segments = thread::cpu_count();
+  }
+
+  std::vector<pnode_ptr> plans;
+  std::map<pnode_ptr, pnode_ptr> share_memo;
+  std::map<std::string, pnode_ptr> by_key;
+  for (const auto& tip: tips) {
+    pnode_ptr plan = tip;
+    if (!exec_params.disable_optimization) {
+      plan = optimization_engine::optimize_planner_graph(plan, exec_params);
+    }
+    plans.push_back(share_common_subplans(plan, share_memo, by_key));
+  }
+
+  // Shared nodes which cannot be executed with the rest of a plan are
+  // materialized once for all the plans.
+  if (exec_params.partial_materialize) {
+    materialize_options recursive_exec_params = exec_params;
+    recursive_exec_params.num_segments = thread::cpu_count();
+    std::map<pnode_ptr, pnode_ptr> memo;
+    for (auto& plan: plans) {
+      plan = partial_materialize_impl(plan, recursive_exec_params, memo);
+    }
+  }
+
+  // Sources are returned as they are, and plans which cannot be split into
+  // segments are run on their own. The rest are run together.
+  std::vector<size_t> shared_plans;
+  for (size_t i = 0; i < plans.size(); ++i) {
+    if (is_source_node(plans[i]) || !is_parallel_slicable(plans[i])) {
+      ret[i] = execute_node(plans[i], exec_params);
+    } else {
+      shared_plans.push_back(i);
+    }
+  }
+  if (shared_plans.size() == 1) {
+    ret[shared_plans[0]] = execute_node(plans[shared_plans[0]], exec_params);
+  } else if (shared_plans.size() > 1) {
+    logstream(LOG_INFO) << "Materializing " << shared_plans.size()
+                        << " plans in one pass" << std::endl;
+    std::vector<std::vector<pnode_ptr>> segments(exec_params.num_segments);
+    for (size_t i = 0; i < segments.size(); ++i) {
+      // one memo per segment, so that the segments of shared nodes are shared
+      std::map<pnode_ptr, pnode_ptr> memo;
+      for (size_t j: shared_plans) {
+        segments[i].push_back(make_segmented_graph(plans[j], i, segments.size(), memo));
+      }
+    }
+    auto results = subplan_executor().run_shared(segments, exec_params);
+    for (size_t j = 0; j < shared_plans.size(); ++j) {
+      ret[shared_plans[j]] = results[j];
+    }
+  }
+
+  for (size_t i = 0; i < tips.size(); ++i) {
+    (*tips[i]) = (*(op_sframe_source::make_planner_node(ret[i])));
+  }
+  return ret;
+}
+
 void planner::materialize(std::shared_ptr<planner_node> tip,
                           write_callback_type callback,
                           size_t num_segments,
@@ -337,14 +479,25 @@ bool planner::test_equal_length(std::shared_ptr<planner_node> a,
   // Checking the size of index array is the same
   auto prove_equal = prove_equal_length(a, b);
 
-  if (!prove_equal.first && infer_planner_node_length(b) == -1) {
-    logstream(LOG_INFO) << "Unable to prove equi-length. Materializing RHS" << std::endl;
-    materialize(b);
+  // If both lengths are unknown, materialize the cheaper side first; its
+  // length may be enough to settle the question.
+  bool materialize_rhs_first = true;
+  if (!prove_equal.first &&
+      infer_planner_node_length(a) == -1 && infer_planner_node_length(b) == -1) {
+    materialize_rhs_first = estimate_planner_node_cost(b) <= estimate_planner_node_cost(a);
+  }
+  auto& first = materialize_rhs_first ? b : a;
+  auto& second = materialize_rhs_first ? a : b;
+  if (!prove_equal.first && infer_planner_node_length(first) == -1) {
+    logstream(LOG_INFO) << "Unable to prove equi-length. Materializing "
+                        << (materialize_rhs_first ? "RHS" : "LHS") << std::endl;
+    materialize(first);
     prove_equal = prove_equal_length(a, b);
   }
-  if (!prove_equal.first && infer_planner_node_length(a) == -1) {
-    logstream(LOG_INFO) << "Still unable to prove equi-length. Materializing LHS" << std::endl;
-    materialize(a);
+  if (!prove_equal.first && infer_planner_node_length(second) == -1) {
+    logstream(LOG_INFO) << "Still unable to prove equi-length. Materializing "
+                        << (materialize_rhs_first ? "LHS" : "RHS") << std::endl;
+    materialize(second);
     prove_equal = prove_equal_length(a, b);
   }
   DASSERT_TRUE(prove_equal.first);
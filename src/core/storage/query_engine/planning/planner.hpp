@@ -71,6 +71,24 @@ class planner {
                    materialize_options exec_params = materialize_options());
 
 
+  /**
+   * Materializes several nodes in a single pass over their inputs,
+   * returning an SFrame for each of them.
+   *
+   * The subgraphs the nodes have in common (the same nodes, or nodes
+   * computing the same thing, as recognized by the
+   * \ref materialization_cache), such as a source they all read, are
+   * executed once for all of them. Nodes ending in a reduction are reduced
+   * in the same pass. Nodes which cannot be executed in parallel segments
+   * are materialized on their own.
+   *
+   * exec_params may not have a write callback or an output location. Like
+   * \ref materialize, each node is replaced by a source of its result.
+   */
+  std::vector<sframe> materialize(
+      const std::vector<std::shared_ptr<planner_node>>& tips,
+      materialize_options exec_params = materialize_options());
+
   /** If this returns true, it is recommended to go ahead and
    *  materialize the sframe operations on the fly to prevent memory
    *  issues.
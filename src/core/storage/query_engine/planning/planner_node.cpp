@@ -3,3 +3,152 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <sstream>
+#include <boost/algorithm/string/predicate.hpp>
+#include <core/storage/query_engine/planning/planner_node.hpp>
+#include <core/storage/query_engine/operators/operator_properties.hpp>
+#include <core/storage/sframe_data/sframe.hpp>
+#include <core/storage/sframe_data/sarray.hpp>
+#include <core/storage/fileio/fileio_constants.hpp>
+#include <core/storage/serialization/serialization_includes.hpp>
+#include <core/system/lambda/pylambda_function.hpp>
+#include <core/logging/assertions.hpp>
+
+namespace turi {
+namespace query_eval {
+
+namespace {
+
+/// Files in the in-memory cache cannot be opened by another process
+bool is_shared_file(const std::string& path) {
+  return !boost::starts_with(path, fileio::get_cache_prefix());
+}
+
+template <typename IndexInfo>
+IndexInfo read_source_index(const pnode_ptr& n) {
+  std::stringstream strm(n->operator_parameters.at("index").get<flex_string>());
+  iarchive iarc(strm);
+  IndexInfo info;
+  iarc >> info;
+  return info;
+}
+
+bool is_portable_node(const pnode_ptr& n) {
+  switch (n->operator_type) {
+    case planner_node_type::SFRAME_SOURCE_NODE: {
+      auto info = read_source_index<sframe_index_file_information>(n);
+      for (const auto& file: info.column_files) {
+        if (!is_shared_file(file)) return false;
+      }
+      return true;
+    }
+    case planner_node_type::SARRAY_SOURCE_NODE: {
+      auto info = read_source_index<index_file_information>(n);
+      for (const auto& file: info.segment_files) {
+        if (!is_shared_file(file)) return false;
+      }
+      return true;
+    }
+    case planner_node_type::LAMBDA_TRANSFORM_NODE:
+      return true;
+    default:
+      // memoizations aside, any other non-portable parameter (a function,
+      // an aggregator, a reader) cannot be recreated
+      for (const auto& kv: n->any_operator_parameters) {
+        if (!boost::starts_with(kv.first, "__")) return false;
+      }
+      return true;
+  }
+}
+
+/// Recreates the non-portable parameters of a node read by load_plan
+void reopen_node(const pnode_ptr& n) {
+  auto& params = n->operator_parameters;
+  switch (n->operator_type) {
+    case planner_node_type::SFRAME_SOURCE_NODE:
+      n->any_operator_parameters["sframe"] =
+          any(sframe(read_source_index<sframe_index_file_information>(n)));
+      break;
+    case planner_node_type::SARRAY_SOURCE_NODE: {
+      auto source = std::make_shared<sarray<flexible_type>>();
+      source->open_for_read(read_source_index<index_file_information>(n));
+      n->any_operator_parameters["sarray"] = any(source);
+      break;
+    }
+    case planner_node_type::LAMBDA_TRANSFORM_NODE: {
+      // a pickled directory belongs to the process which wrote the plan
+      auto fn = std::make_shared<lambda::pylambda_function>(
+          params.at("lambda_str").get<flex_string>(), false);
+      fn->set_skip_undefined(params.at("skip_undefined").get<flex_int>());
+      fn->set_random_seed(params.at("random_seed").get<flex_int>());
+      n->any_operator_parameters["lambda_fn"] = any(fn);
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+/// Numbers the nodes so that the inputs of a node come before it.
+void order_nodes(const pnode_ptr& n, std::map<pnode_ptr, size_t>& ids,
+                 std::vector<pnode_ptr>& order) {
+  if (ids.count(n)) return;
+  for (const auto& input: n->inputs) order_nodes(input, ids, order);
+  ids[n] = order.size();
+  order.push_back(n);
+}
+
+} // anonymous namespace
+
+bool is_portable_plan(const pnode_ptr& tip) {
+  std::map<pnode_ptr, size_t> ids;
+  std::vector<pnode_ptr> order;
+  order_nodes(tip, ids, order);
+  for (const auto& n: order) {
+    if (!is_portable_node(n)) return false;
+  }
+  return true;
+}
+
+void save_plan(oarchive& oarc, const pnode_ptr& tip) {
+  std::map<pnode_ptr, size_t> ids;
+  std::vector<pnode_ptr> order;
+  order_nodes(tip, ids, order);
+
+  oarc << order.size();
+  for (const auto& n: order) {
+    ASSERT_MSG(is_portable_node(n), "The query plan cannot be moved to another process");
+    std::vector<size_t> inputs;
+    for (const auto& input: n->inputs) inputs.push_back(ids.at(input));
+    std::map<std::string, flexible_type> params;
+    for (const auto& kv: n->operator_parameters) {
+      if (!boost::starts_with(kv.first, "__")) params.insert(kv);
+    }
+    oarc << (int)(n->operator_type) << params << inputs;
+  }
+}
+
+pnode_ptr load_plan(iarchive& iarc) {
+  size_t num_nodes = 0;
+  iarc >> num_nodes;
+  ASSERT_GT(num_nodes, 0);
+  std::vector<pnode_ptr> nodes;
+  for (size_t i = 0; i < num_nodes; ++i) {
+    int type = 0;
+    std::map<std::string, flexible_type> params;
+    std::vector<size_t> inputs;
+    iarc >> type >> params >> inputs;
+    std::vector<pnode_ptr> input_nodes;
+    for (size_t id: inputs) {
+      ASSERT_LT(id, nodes.size());
+      input_nodes.push_back(nodes[id]);
+    }
+    auto n = planner_node::make_shared((planner_node_type)type, params, {}, input_nodes);
+    reopen_node(n);
+    nodes.push_back(n);
+  }
+  return nodes.back();
+}
+
+} // namespace query_eval
+} // namespace turi
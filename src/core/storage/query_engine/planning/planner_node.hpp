@@ -15,6 +15,9 @@
 #include <core/storage/query_engine/operators/operator_properties.hpp>
 
 namespace turi {
+class oarchive;
+class iarchive;
+
 namespace query_eval {
 
 class query_operator;
@@ -116,6 +119,30 @@ struct planner_node {
 /// A handy typedef
 typedef std::shared_ptr<planner_node> pnode_ptr;
 
+/**
+ * Returns true if the plan can be rebuilt in another process, possibly on
+ * another machine, by \ref load_plan: the non-portable parameters of every
+ * node can be recreated from its portable ones (sources keep their index,
+ * lambda transforms their pickled lambda), and no source reads from the
+ * in-memory file cache.
+ *
+ * The other process must also be able to open the files of the sources,
+ * which is up to the caller: they should be on storage shared by all the
+ * machines, such as HDFS, S3 or a network file system.
+ */
+bool is_portable_plan(const pnode_ptr& tip);
+
+/**
+ * Writes a portable plan (see \ref is_portable_plan). A node which is the
+ * input of several nodes is written once.
+ */
+void save_plan(oarchive& oarc, const pnode_ptr& tip);
+
+/**
+ * Reads a plan written by \ref save_plan, reopening its sources.
+ */
+pnode_ptr load_plan(iarchive& iarc);
+
 /// \}
 
 } // namespace query_eval
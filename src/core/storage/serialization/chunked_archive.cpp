@@ -0,0 +1,78 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <lz4/lz4.h>
+#include <core/logging/logger.hpp>
+#include <core/logging/assertions.hpp>
+#include <core/globals/globals.hpp>
+#include <core/export.hpp>
+#include <core/storage/serialization/chunked_archive.hpp>
+
+namespace turi {
+
+EXPORT size_t SERIALIZATION_CHUNK_SIZE = 4 * 1024 * 1024;
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, SERIALIZATION_CHUNK_SIZE, true,
+                            +[](int64_t val){ return val >= 1024; });
+
+namespace archive_detail {
+
+void write_compressed_chunks(oarchive& oarc, std::vector<std::vector<char>>& chunks) {
+  // Chunks which do not shrink are stored as is, with a compressed size of 0.
+  std::vector<std::vector<char>> compressed(chunks.size());
+  parallel_for(0, chunks.size(), [&](size_t i) {
+      const std::vector<char>& chunk = chunks[i];
+      if (chunk.empty() || chunk.size() > LZ4_MAX_INPUT_SIZE) return;
+      compressed[i].resize(LZ4_compressBound(chunk.size()));
+      int clen = LZ4_compress_limitedOutput(chunk.data(), compressed[i].data(),
+                                            chunk.size(), compressed[i].size());
+      if (clen <= 0 || size_t(clen) >= chunk.size()) {
+        std::vector<char>().swap(compressed[i]);
+      } else {
+        compressed[i].resize(clen);
+      }
+    });
+
+  oarc << chunks.size();
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    const std::vector<char>& data = compressed[i].empty() ? chunks[i] : compressed[i];
+    oarc << chunks[i].size() << compressed[i].size();
+    oarc.write(data.data(), data.size());
+    std::vector<char>().swap(chunks[i]);
+    std::vector<char>().swap(compressed[i]);
+  }
+}
+
+std::vector<std::vector<char>> read_compressed_chunks(iarchive& iarc) {
+  size_t num_chunks = 0;
+  iarc >> num_chunks;
+  std::vector<std::vector<char>> raw(num_chunks);
+  std::vector<size_t> sizes(num_chunks);
+  for (size_t i = 0; i < num_chunks; ++i) {
+    size_t compressed_size = 0;
+    iarc >> sizes[i] >> compressed_size;
+    raw[i].resize(compressed_size == 0 ? sizes[i] : compressed_size);
+    iarc.read(raw[i].data(), raw[i].size());
+  }
+
+  std::vector<std::vector<char>> chunks(num_chunks);
+  parallel_for(0, num_chunks, [&](size_t i) {
+      if (raw[i].size() == sizes[i]) {
+        chunks[i].swap(raw[i]);
+        return;
+      }
+      chunks[i].resize(sizes[i]);
+      int len = LZ4_decompress_safe(raw[i].data(), chunks[i].data(),
+                                    raw[i].size(), sizes[i]);
+      if (len < 0 || size_t(len) != sizes[i]) {
+        log_and_throw_io_failure("Corrupted archive chunk");
+      }
+      std::vector<char>().swap(raw[i]);
+    });
+  return chunks;
+}
+
+} // namespace archive_detail
+} // namespace turi
@@ -0,0 +1,101 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SERIALIZATION_CHUNKED_ARCHIVE_HPP
+#define TURI_SERIALIZATION_CHUNKED_ARCHIVE_HPP
+
+#include <vector>
+#include <algorithm>
+#include <core/storage/serialization/serialization_includes.hpp>
+#include <core/parallel/lambda_omp.hpp>
+
+namespace turi {
+
+/**
+ * The target uncompressed size, in bytes, of each chunk written by
+ * save_chunked().
+ */
+extern size_t SERIALIZATION_CHUNK_SIZE;
+
+namespace archive_detail {
+
+/**
+ * Compresses the chunks in parallel, and writes them to the archive.
+ * The chunks are emptied.
+ */
+void write_compressed_chunks(oarchive& oarc, std::vector<std::vector<char>>& chunks);
+
+/**
+ * Reads the chunks written by write_compressed_chunks(), and decompresses
+ * them in parallel.
+ */
+std::vector<std::vector<char>> read_compressed_chunks(iarchive& iarc);
+
+} // namespace archive_detail
+
+/**
+ * \ingroup group_serialization
+ * Saves a large vector as a sequence of independent chunks, which are
+ * serialized and LZ4 compressed in parallel, and can be decompressed and
+ * deserialized in parallel by load_chunked(). Saving with oarc << values
+ * instead serializes every value in turn, on one thread.
+ *
+ * The values must be serializable to an in-memory archive, i.e. must not
+ * need the directory of a dir_archive (no SFrames, SArrays, ...).
+ *
+ * \code
+ * oarc << other_members;
+ * save_chunked(oarc, item_data);
+ * ...
+ * iarc >> other_members;
+ * load_chunked(iarc, item_data);
+ * \endcode
+ */
+template <typename T>
+void save_chunked(oarchive& oarc, const std::vector<T>& values) {
+  size_t version = 1;
+  size_t values_per_chunk =
+      std::max<size_t>(1, SERIALIZATION_CHUNK_SIZE / std::max<size_t>(1, sizeof(T)));
+  size_t num_chunks = (values.size() + values_per_chunk - 1) / values_per_chunk;
+  oarc << version << values.size() << values_per_chunk;
+
+  std::vector<std::vector<char>> chunks(num_chunks);
+  parallel_for(0, num_chunks, [&](size_t chunk_id) {
+      oarchive chunk_arc(chunks[chunk_id]);
+      size_t begin = chunk_id * values_per_chunk;
+      size_t end = std::min(values.size(), begin + values_per_chunk);
+      for (size_t i = begin; i < end; ++i) chunk_arc << values[i];
+      chunks[chunk_id].resize(chunk_arc.off);
+    });
+  archive_detail::write_compressed_chunks(oarc, chunks);
+}
+
+/**
+ * \ingroup group_serialization
+ * Loads a vector saved with save_chunked().
+ */
+template <typename T>
+void load_chunked(iarchive& iarc, std::vector<T>& values) {
+  size_t version = 0, num_values = 0, values_per_chunk = 0;
+  iarc >> version >> num_values >> values_per_chunk;
+  ASSERT_MSG(version == 1, "Unsupported chunked archive version");
+
+  std::vector<std::vector<char>> chunks = archive_detail::read_compressed_chunks(iarc);
+  ASSERT_EQ(chunks.size(),
+            (num_values + values_per_chunk - 1) / std::max<size_t>(1, values_per_chunk));
+
+  values.clear();
+  values.resize(num_values);
+  parallel_for(0, chunks.size(), [&](size_t chunk_id) {
+      iarchive chunk_arc(chunks[chunk_id].data(), chunks[chunk_id].size());
+      size_t begin = chunk_id * values_per_chunk;
+      size_t end = std::min(num_values, begin + values_per_chunk);
+      for (size_t i = begin; i < end; ++i) chunk_arc >> values[i];
+      std::vector<char>().swap(chunks[chunk_id]);
+    });
+}
+
+} // namespace turi
+#endif
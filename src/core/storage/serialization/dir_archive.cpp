@@ -5,6 +5,8 @@
  */
 #define BOOST_SPIRIT_THREADSAFE
 
+#include <atomic>
+#include <exception>
 #include <set>
 #include <string>
 #include <core/logging/logger.hpp>
@@ -21,6 +23,7 @@
 #include <core/storage/serialization/dir_archive.hpp>
 #include <core/random/random.hpp>
 #include <core/parallel/lambda_omp.hpp>
+#include <core/parallel/pthread_tools.hpp>
 
 namespace turi {
 
@@ -67,9 +70,18 @@ dir_archive_impl::archive_index_information read_index_file(std::string index_fi
   size_t num_prefixes = std::stol(data.get<std::string>("archive.num_prefixes"));
   ret.metadata = ini::read_dictionary_section<std::string>(data, "metadata");
   ret.prefixes = ini::read_sequence_section<std::string>(data, "prefixes", num_prefixes);
+  // archives written before the manifest have no components
+  auto num_components = data.get_optional<std::string>("archive.num_components");
+  if (num_components) {
+    ret.components = ini::read_sequence_section<std::string>(
+        data, "components", std::stol(*num_components));
+  }
   // make prefixes absolute
   std::string index_dir = fileio::get_dirname(index_file);
   for(auto& prefix: ret.prefixes) prefix = fileio::make_absolute_path(index_dir, prefix);
+  for(auto& component: ret.components) {
+    component = fileio::make_absolute_path(index_dir, component);
+  }
   return ret;
 }
 
@@ -82,6 +94,7 @@ void write_index_file(std::string index_file, const dir_archive_impl::archive_in
   boost::property_tree::ptree data;
   data.put("archive.version", info.version);
   data.put("archive.num_prefixes", info.prefixes.size());
+  data.put("archive.num_components", info.components.size());
   ini::write_dictionary_section<std::string>(data, "metadata", info.metadata);
   // make prefixes relative
   std::vector<std::string> relative_paths;
@@ -90,6 +103,11 @@ void write_index_file(std::string index_file, const dir_archive_impl::archive_in
     relative_paths.push_back(fileio::make_relative_path(index_dir, prefix));
   }
   ini::write_sequence_section(data, "prefixes", relative_paths);
+  relative_paths.clear();
+  for(auto component: info.components) {
+    relative_paths.push_back(fileio::make_relative_path(index_dir, component));
+  }
+  ini::write_sequence_section(data, "components", relative_paths);
 
   // now write the index
   general_ofstream fout(index_file);
@@ -204,7 +222,30 @@ void dir_archive::init_for_read(const std::string& directory) {
   // the first 2 elements of the index_info are the INI file and the object file.
   m_read_prefix_index = 2;
 
-  // quickly parallel read all the index files.
+  // quickly parallel read all the index files. The manifest lists them, and
+  // a missing one means the archive was not completely written.
+  if (!m_index_info.components.empty()) {
+    const auto& components = m_index_info.components;
+    std::vector<char> missing(components.size(), false);
+    parallel_for(0, components.size(), [&](size_t i) {
+      try {
+        general_ifstream fin(components[i]);
+        char tmp;
+        fin.read(&tmp, 1);
+        missing[i] = fin.fail();
+      } catch(...) {
+        missing[i] = true;
+      }
+    });
+    for (size_t i = 0; i < components.size(); ++i) {
+      if (missing[i]) {
+        log_and_throw_io_failure("Archive is incomplete. Unable to read " +
+                                 sanitize_url(components[i]));
+      }
+    }
+    return;
+  }
+
   auto dirlisting = fileio::get_directory_listing(directory);
   parallel_for(0, dirlisting.size(), [&](size_t i) {
     const auto& entry = dirlisting[i];
@@ -354,10 +395,66 @@ void dir_archive::set_close_callback(std::function<void()>& fn) {
   m_close_callback = fn;
 };
 
+void dir_archive::add_component_write(std::string component_file,
+                                      std::function<void()> write_fn) {
+  if (m_cache_archive) {
+    m_cache_archive->add_component_write(component_file, write_fn);
+    return;
+  }
+
+  ASSERT_TRUE(m_objects_out != nullptr);
+  m_index_info.components.push_back(component_file);
+  m_pending_writes.push_back(write_fn);
+}
+
+void dir_archive::run_pending_writes() {
+  std::vector<std::function<void()>> writes;
+  writes.swap(m_pending_writes);
+  if (writes.empty()) return;
+  if (writes.size() == 1) {
+    writes[0]();
+    return;
+  }
+
+  // The writes run on their own threads rather than on the thread pool, so
+  // that each of them can still write its columns in parallel.
+  logstream(LOG_INFO) << "Writing " << writes.size()
+                      << " archive components in parallel" << std::endl;
+  size_t num_threads = std::min(writes.size(), thread::cpu_count());
+  std::atomic<size_t> next_write(0);
+  mutex error_lock;
+  std::exception_ptr error;
+
+  thread_group threads;
+  for (size_t t = 0; t < num_threads; ++t) {
+    threads.launch([&]() {
+      for (size_t i = next_write++; i < writes.size(); i = next_write++) {
+        try {
+          writes[i]();
+        } catch (...) {
+          std::lock_guard<mutex> guard(error_lock);
+          if (!error) error = std::current_exception();
+        }
+      }
+    });
+  }
+  threads.join();
+
+  if (error) std::rethrow_exception(error);
+}
+
 void dir_archive::close() {
+  std::exception_ptr write_error;
   if (m_objects_out) {
-    // write out the index file
-    write_index_file(m_directory + "/" + DIR_ARCHIVE_INI_FILE, m_index_info);
+    try {
+      // the components must all be written before the index commits them
+      run_pending_writes();
+      // write out the index file
+      write_index_file(m_directory + "/" + DIR_ARCHIVE_INI_FILE, m_index_info);
+    } catch (...) {
+      write_error = std::current_exception();
+    }
+    m_pending_writes.clear();
     m_objects_out->close();
     m_objects_out.reset();
   }
@@ -377,6 +474,8 @@ void dir_archive::close() {
     m_cache_archive->close();
     m_cache_archive.reset();
   }
+
+  if (write_error) std::rethrow_exception(write_error);
 }
 
 
@@ -10,6 +10,7 @@
 #include <string>
 #include <memory>
 #include <map>
+#include <functional>
 #include <core/storage/fileio/fs_utils.hpp>
 #include <core/storage/fileio/general_fstream.hpp>
 namespace turi {
@@ -42,6 +43,9 @@ namespace dir_archive_impl {
  * 0001 = "objects.bin"
  * 0002 = "0001"
  * 0003 = "0002"
+ * [components]
+ * 0000 = "0001.frame_idx"
+ * 0001 = "0002.sidx"
  * \endcode
  * The prefix section basically lists all the prefixes stored inside the
  * directory archive. All files in the directory which have their file name
@@ -49,12 +53,18 @@ namespace dir_archive_impl {
  *
  * The objects.bin, and dir_archive.ini file is always in the prefix
  *
+ * The components section is the manifest of the files written in parallel
+ * by \ref dir_archive::add_component_write, in the order they were added;
+ * the archive section then also holds num_components. Archives written
+ * before the manifest have no components section.
+ *
  * Once read into the archive_index_information struct however, the prefixes
- * will all be absolute paths.
+ * and components will all be absolute paths.
  */
 struct archive_index_information {
   size_t version = (size_t)(-1);
   std::vector<std::string> prefixes;
+  std::vector<std::string> components;
   std::map<std::string, std::string> metadata;
 };
 
@@ -83,6 +93,11 @@ struct archive_index_information {
  * oarc.get_prefix()
  * etc.
  * \endcode
+ * Objects holding large data, like SFrames and SArrays, do not write their
+ * files through the object stream: they queue the writes of their files with
+ * add_component_write(), and close() runs the queued writes in parallel
+ * before committing the archive.
+ *
  * Similarly, to read:
  * \code
  * dir_archive archive;
@@ -159,8 +174,26 @@ class dir_archive {
    */
   general_ofstream* get_output_stream();
 
+  /**
+   * The directory must be opened for write.
+   * Queues write_fn, which writes the component file (for instance
+   * [prefix].frame_idx and the files beside it) of a prefix obtained from
+   * get_next_write_prefix(). The queued writes run in parallel when the
+   * archive is closed, and the component file is listed in the manifest of
+   * the archive.
+   *
+   * write_fn must not touch the object stream, and must own (a copy of)
+   * whatever it writes.
+   */
+  void add_component_write(std::string component_file,
+                           std::function<void()> write_fn);
+
   /**
    * Closes the directory archive, committing all writes.
+   *
+   * Runs the queued component writes first. If any of them fails, the index
+   * is not updated, and the first failure is rethrown once the archive is
+   * closed.
    */
   void close();
 
@@ -214,6 +247,9 @@ class dir_archive {
 
   void make_s3_read_cache(const std::string& directory);
 
+  /// Runs the queued component writes in parallel, and clears the queue.
+  void run_pending_writes();
+
   /**
    * The index information for the archive
    */
@@ -242,6 +278,9 @@ class dir_archive {
 
   /// callback on close
   std::function<void()> m_close_callback;
+
+  /// The component writes queued by add_component_write()
+  std::vector<std::function<void()>> m_pending_writes;
 };
 
 
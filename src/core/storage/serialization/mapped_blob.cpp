@@ -0,0 +1,138 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <cstring>
+#include <string>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <core/logging/logger.hpp>
+#include <core/logging/assertions.hpp>
+#include <core/storage/fileio/general_fstream.hpp>
+#include <core/storage/fileio/fs_utils.hpp>
+#include <core/storage/serialization/serialization_includes.hpp>
+#include <core/storage/serialization/mapped_blob.hpp>
+#include <core/globals/globals.hpp>
+#include <core/export.hpp>
+
+namespace turi {
+
+EXPORT size_t MAPPED_BLOB_MIN_FILE_SIZE = 1024 * 1024;
+
+REGISTER_GLOBAL(int64_t, MAPPED_BLOB_MIN_FILE_SIZE, true);
+
+namespace {
+
+const char MAPPED_BLOB_MAGIC[8] = {'T', 'C', 'B', 'L', 'O', 'B', 0, 0};
+const uint64_t MAPPED_BLOB_FILE_VERSION = 1;
+
+/**
+ * The header of a blob file. The contents follow at offset
+ * sizeof(blob_file_header), so that they are aligned in a mapping.
+ */
+struct blob_file_header {
+  char magic[8];
+  uint64_t version;
+  uint64_t size;
+  char padding[40];
+};
+static_assert(sizeof(blob_file_header) == 64, "Unexpected blob header size");
+
+const char* MAPPED_BLOB_FILE_SUFFIX = ".blob";
+
+} // anonymous namespace
+
+mapped_blob::mapped_blob(const mapped_blob& other) {
+  *this = other;
+}
+
+mapped_blob& mapped_blob::operator=(const mapped_blob& other) {
+  if (this == &other) return *this;
+  m_region.reset();
+  m_heap.assign(other.data(), other.data() + other.size());
+  m_data = m_heap.data();
+  m_size = m_heap.size();
+  return *this;
+}
+
+mapped_blob::~mapped_blob() = default;
+
+void mapped_blob::resize(size_t n) {
+  m_region.reset();
+  m_heap.assign(n, 0);
+  m_data = m_heap.data();
+  m_size = n;
+}
+
+void mapped_blob::save(oarchive& oarc) const {
+  size_t version = 1;
+  bool in_file = oarc.dir != nullptr && m_size >= MAPPED_BLOB_MIN_FILE_SIZE;
+  oarc << version << in_file << m_size;
+  if (!in_file) {
+    serialize(oarc, m_data, m_size);
+    return;
+  }
+  std::string path = oarc.get_prefix() + MAPPED_BLOB_FILE_SUFFIX;
+  blob_file_header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MAPPED_BLOB_MAGIC, sizeof(header.magic));
+  header.version = MAPPED_BLOB_FILE_VERSION;
+  header.size = m_size;
+  general_ofstream fout(path);
+  fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  fout.write(m_data, m_size);
+  if (fout.fail()) {
+    log_and_throw_io_failure("Unable to write " + path);
+  }
+  fout.close();
+}
+
+void mapped_blob::load(iarchive& iarc) {
+  size_t version = 0;
+  bool in_file = false;
+  size_t size = 0;
+  iarc >> version >> in_file >> size;
+  ASSERT_MSG(version == 1, "Unsupported mapped_blob version");
+  if (!in_file) {
+    resize(size);
+    deserialize(iarc, m_data, size);
+    return;
+  }
+
+  std::string path = iarc.get_prefix() + MAPPED_BLOB_FILE_SUFFIX;
+  blob_file_header header;
+  {
+    general_ifstream fin(path);
+    fin.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (fin.fail() ||
+        memcmp(header.magic, MAPPED_BLOB_MAGIC, sizeof(header.magic)) != 0) {
+      log_and_throw_io_failure(path + " is not a model parameter file");
+    }
+    if (header.version != MAPPED_BLOB_FILE_VERSION || header.size != size) {
+      log_and_throw_io_failure(path + " has an unsupported version or size");
+    }
+    // Files which cannot be mapped are read in full.
+    if (!fileio::get_protocol(path).empty() || size == 0) {
+      resize(size);
+      fin.read(m_data, size);
+      if (fin.fail()) log_and_throw_io_failure("Unable to read " + path);
+      return;
+    }
+  }
+
+  using namespace boost::interprocess;
+  try {
+    file_mapping mapping(path.c_str(), read_only);
+    m_region = std::make_shared<mapped_region>(
+        mapping, copy_on_write, sizeof(blob_file_header), size);
+  } catch (interprocess_exception& e) {
+    log_and_throw_io_failure("Unable to map " + path + ": " + e.what());
+  }
+  m_heap.clear();
+  m_heap.shrink_to_fit();
+  m_data = static_cast<char*>(m_region->get_address());
+  m_size = size;
+}
+
+} // namespace turi
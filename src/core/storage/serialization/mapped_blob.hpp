@@ -0,0 +1,78 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SERIALIZATION_MAPPED_BLOB_HPP
+#define TURI_SERIALIZATION_MAPPED_BLOB_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <boost/interprocess/interprocess_fwd.hpp>
+
+namespace turi {
+
+class oarchive;
+class iarchive;
+
+/**
+ * \ingroup group_serialization
+ * A block of bytes holding large dense parameters (factor matrices, etc.)
+ * which, when loaded from a directory archive on local disk, is memory mapped
+ * instead of read into heap memory.
+ *
+ * When saved to a directory archive, a blob of at least
+ * MAPPED_BLOB_MIN_FILE_SIZE bytes is written to a file of its own next to the
+ * archive, under a prefix obtained from the archive, with a small versioned
+ * header. Only a reference to the file goes into the object stream. Smaller
+ * blobs, and blobs saved to other archives, are written inline.
+ *
+ * Loading a blob stored in a local file maps it copy-on-write: nothing is
+ * read until the pages are touched, all the processes which load the same
+ * archive share the pages in the page cache, and writing to the blob gives
+ * the writer private copies of the pages written. Blobs in remote files are
+ * read into heap memory.
+ *
+ * Copying a blob copies its bytes into heap memory.
+ */
+class mapped_blob {
+ public:
+  mapped_blob() = default;
+  mapped_blob(const mapped_blob& other);
+  mapped_blob& operator=(const mapped_blob& other);
+  mapped_blob(mapped_blob&& other) = default;
+  mapped_blob& operator=(mapped_blob&& other) = default;
+  ~mapped_blob();
+
+  /**
+   * Replaces the contents with n bytes of zero initialized heap memory.
+   */
+  void resize(size_t n);
+
+  char* data() { return m_data; }
+  const char* data() const { return m_data; }
+  size_t size() const { return m_size; }
+
+  /**
+   * Returns true if the contents are mapped from a file.
+   */
+  bool is_mapped() const { return m_region != nullptr; }
+
+  void save(oarchive& oarc) const;
+  void load(iarchive& iarc);
+
+ private:
+  std::vector<char> m_heap;
+  std::shared_ptr<boost::interprocess::mapped_region> m_region;
+  char* m_data = nullptr;
+  size_t m_size = 0;
+};
+
+/**
+ * The smallest mapped_blob written to a file of its own rather than inline.
+ */
+extern size_t MAPPED_BLOB_MIN_FILE_SIZE;
+
+} // namespace turi
+#endif
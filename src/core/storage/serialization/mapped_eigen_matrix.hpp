@@ -0,0 +1,107 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SERIALIZATION_MAPPED_EIGEN_MATRIX_HPP
+#define TURI_SERIALIZATION_MAPPED_EIGEN_MATRIX_HPP
+
+#include <new>
+#include <Eigen/Core>
+#include <core/storage/serialization/mapped_blob.hpp>
+#include <core/storage/serialization/serialization_includes.hpp>
+#include <core/logging/assertions.hpp>
+
+namespace turi {
+
+/**
+ * \ingroup group_serialization
+ * A dense Eigen matrix whose coefficients are held in a \ref mapped_blob,
+ * so that a large matrix loaded from a directory archive on local disk is
+ * paged in lazily from a shared mapping rather than read into the heap.
+ *
+ * It is used like an Eigen::Map<MatrixType> (row(), block(), coefficient
+ * access and assignment, ...), except that resize() allocates new, zeroed
+ * storage, and copying the matrix copies the coefficients.
+ *
+ * The serialized form differs from the one of MatrixType.
+ */
+template <typename MatrixType>
+class mapped_eigen_matrix : public Eigen::Map<MatrixType> {
+ public:
+  typedef Eigen::Map<MatrixType> map_type;
+  typedef typename MatrixType::Scalar Scalar;
+  typedef typename MatrixType::Index Index;
+
+  mapped_eigen_matrix() : map_type(nullptr, 0, empty_cols()) { }
+
+  mapped_eigen_matrix(const mapped_eigen_matrix& other)
+      : map_type(nullptr, 0, empty_cols()) {
+    *this = other;
+  }
+
+  mapped_eigen_matrix& operator=(const mapped_eigen_matrix& other) {
+    m_storage = other.m_storage;
+    remap(other.rows(), other.cols());
+    return *this;
+  }
+
+  /// Assigns the coefficients of an Eigen expression of the same size.
+  using map_type::operator=;
+
+  /**
+   * Allocates storage for a rows x cols matrix of zeros.
+   */
+  void resize(Index rows, Index cols) {
+    m_storage.resize(sizeof(Scalar) * rows * cols);
+    remap(rows, cols);
+  }
+
+  /**
+   * Allocates storage for a vector of zeros.
+   */
+  void resize(Index size) {
+    if (MatrixType::ColsAtCompileTime == 1) {
+      resize(size, 1);
+    } else {
+      resize(1, size);
+    }
+  }
+
+  /**
+   * Returns true if the coefficients are mapped from an archive file.
+   */
+  bool is_mapped() const { return m_storage.is_mapped(); }
+
+  void save(oarchive& oarc) const {
+    size_t version = 1;
+    size_t rows = this->rows(), cols = this->cols();
+    oarc << version << rows << cols << m_storage;
+  }
+
+  void load(iarchive& iarc) {
+    size_t version = 0, rows = 0, cols = 0;
+    iarc >> version >> rows >> cols;
+    ASSERT_MSG(version == 1, "Unsupported mapped_eigen_matrix version");
+    iarc >> m_storage;
+    ASSERT_EQ(m_storage.size(), sizeof(Scalar) * rows * cols);
+    remap(rows, cols);
+  }
+
+ private:
+  mapped_blob m_storage;
+
+  static constexpr Index empty_cols() {
+    return MatrixType::ColsAtCompileTime == Eigen::Dynamic
+        ? 0 : MatrixType::ColsAtCompileTime;
+  }
+
+  /// Points the map at the storage; the documented way to re-seat an Eigen::Map.
+  void remap(Index rows, Index cols) {
+    new (static_cast<map_type*>(this)) map_type(
+        reinterpret_cast<Scalar*>(m_storage.data()), rows, cols);
+  }
+};
+
+} // namespace turi
+#endif
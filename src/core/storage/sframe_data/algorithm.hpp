@@ -655,6 +655,64 @@ void copy_range(S&& input, T&& output,
                });
 }
 
+
+
+/**
+ * Copies the rows at the given positions to the output.
+ *
+ * This class accomplishes the abstract equivalent of
+ * \code
+ * for i in rows
+ *    write row i in input to to output
+ * \endcode
+ *
+ * rows must be sorted in increasing order. Consecutive rows are read
+ * together, and only the blocks holding the rows are read from the input,
+ * so this costs about as much as the rows copied however large the input.
+ *
+ * \param input The input to read from. Must be a descendent of siterable
+ * \param output The output writer to write to. Must be a descendent of swriter_base
+ * \param rows The positions of the rows to copy, in increasing order
+ */
+template <typename S, typename T,
+typename = typename std::enable_if<sframe_impl::is_sarray_like<S>::value>::type,
+typename = typename std::enable_if<sframe_impl::is_sarray_like<T>::value>::type>
+void copy_rows(S&& input, T&& output, const std::vector<size_t>& rows) {
+  log_func_entry();
+  ASSERT_TRUE(input.is_opened_for_read());
+  ASSERT_TRUE(output.is_opened_for_write());
+
+  auto reader = input.get_reader();
+  if (!rows.empty() && rows.back() >= reader->size()) {
+    log_and_throw("Row index out of range");
+  }
+
+  parallel_for(0, output.num_segments(),
+               [&](size_t idx) {
+                 auto writer = output.get_output_iterator(idx);
+                 size_t start_idx = idx * rows.size() / output.num_segments();
+                 size_t end_idx = (idx + 1) * rows.size() / output.num_segments();
+
+                 std::vector<typename std::decay<S>::type::value_type> buffer;
+                 size_t i = start_idx;
+                 while (i < end_idx) {
+                   // a run of consecutive rows, up to a buffer full
+                   size_t run_end = i + 1;
+                   while (run_end < end_idx &&
+                          run_end - i < DEFAULT_SARRAY_READER_BUFFER_SIZE &&
+                          rows[run_end] == rows[run_end - 1] + 1) {
+                     ++run_end;
+                   }
+                   reader->read_rows(rows[i], rows[run_end - 1] + 1, buffer);
+                   for (auto& row: buffer) {
+                     (*writer) = row;
+                     ++writer;
+                   }
+                   i = run_end;
+                 }
+               });
+}
+
 /// \}
 } // namespace turi
 #endif
@@ -0,0 +1,773 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <core/logging/assertions.hpp>
+#include <core/logging/logger.hpp>
+#include <core/parallel/thread_pool.hpp>
+#include <core/storage/sframe_data/sframe.hpp>
+#include <core/storage/sframe_data/sframe_rows.hpp>
+#include <core/storage/sframe_data/arrow_interchange.hpp>
+#include <core/system/cppipc/server/cancel_ops.hpp>
+
+namespace turi {
+
+namespace {
+
+/**
+ * The number of rows converted by one task. A multiple of 64, so that the
+ * tasks of a column write distinct bytes of its validity bitmap.
+ */
+static constexpr size_t CHUNK_NUM_ROWS = 64 * 1024;
+
+/// Reads the rows [begin, end) of a column
+typedef std::function<void(size_t, size_t, std::vector<flexible_type>&)> column_read_function;
+
+/**
+ * Reads the rows [begin, end) of a numeric column straight into an array of
+ * flex_int or flex_float. Returns false if some of the rows may be
+ * UNDEFINED, the values then having to be read with a \ref
+ * column_read_function.
+ */
+typedef std::function<bool(size_t, size_t, void*)> numeric_read_function;
+
+/// A buffer of 8 byte words, the alignment required by the C data interface
+typedef std::vector<uint64_t> arrow_buffer;
+
+inline size_t num_words(size_t bytes) {
+  return (bytes + 7) / 8;
+}
+
+inline bool get_bit(const void* bitmap, size_t i) {
+  return (static_cast<const uint8_t*>(bitmap)[i / 8] >> (i % 8)) & 1;
+}
+
+inline void set_bit(void* bitmap, size_t i) {
+  static_cast<uint8_t*>(bitmap)[i / 8] |= uint8_t(1) << (i % 8);
+}
+
+/// Sets the bits [begin, end), begin being a multiple of 8
+inline void set_bits(void* bitmap, size_t begin, size_t end) {
+  memset(static_cast<uint8_t*>(bitmap) + begin / 8, 0xff, (end - begin) / 8);
+  for (size_t i = end - (end - begin) % 8; i < end; ++i) set_bit(bitmap, i);
+}
+
+/**************************************************************************/
+/*                                                                        */
+/*                                 Export                                 */
+/*                                                                        */
+/**************************************************************************/
+
+/// The private data of an exported ArrowSchema
+struct exported_schema_data {
+  std::string format;
+  std::string name;
+  std::vector<ArrowSchema> children;
+  std::vector<ArrowSchema*> child_pointers;
+};
+
+/// The private data of an exported ArrowArray, which owns its buffers
+struct exported_array_data {
+  std::vector<arrow_buffer> buffers;
+  std::vector<const void*> buffer_pointers;
+  std::vector<ArrowArray> children;
+  std::vector<ArrowArray*> child_pointers;
+};
+
+void release_exported_schema(ArrowSchema* schema) {
+  if (schema->release == nullptr) return;
+  // children moved away by the consumer are already released
+  for (int64_t i = 0; i < schema->n_children; ++i) {
+    ArrowSchema* child = schema->children[i];
+    if (child->release != nullptr) child->release(child);
+  }
+  delete static_cast<exported_schema_data*>(schema->private_data);
+  schema->release = nullptr;
+}
+
+void release_exported_array(ArrowArray* array) {
+  if (array->release == nullptr) return;
+  for (int64_t i = 0; i < array->n_children; ++i) {
+    ArrowArray* child = array->children[i];
+    if (child->release != nullptr) child->release(child);
+  }
+  delete static_cast<exported_array_data*>(array->private_data);
+  array->release = nullptr;
+}
+
+/// Fills schema, taking the ownership of data
+void init_schema(ArrowSchema* schema, exported_schema_data* data, int64_t flags) {
+  for (auto& child: data->children) data->child_pointers.push_back(&child);
+  schema->format = data->format.c_str();
+  schema->name = data->name.c_str();
+  schema->metadata = nullptr;
+  schema->flags = flags;
+  schema->n_children = data->children.size();
+  schema->children = data->child_pointers.empty() ? nullptr : data->child_pointers.data();
+  schema->dictionary = nullptr;
+  schema->release = release_exported_schema;
+  schema->private_data = data;
+}
+
+/**
+ * Fills array, taking the ownership of data. The empty buffers of data are
+ * exported as null pointers.
+ */
+void init_array(ArrowArray* array, exported_array_data* data,
+                int64_t length, int64_t null_count) {
+  for (auto& buffer: data->buffers) {
+    data->buffer_pointers.push_back(buffer.empty() ? nullptr : buffer.data());
+  }
+  for (auto& child: data->children) data->child_pointers.push_back(&child);
+  array->length = length;
+  array->null_count = null_count;
+  array->offset = 0;
+  array->n_buffers = data->buffer_pointers.size();
+  array->n_children = data->children.size();
+  array->buffers = data->buffer_pointers.empty() ? nullptr : data->buffer_pointers.data();
+  array->children = data->child_pointers.empty() ? nullptr : data->child_pointers.data();
+  array->dictionary = nullptr;
+  array->release = release_exported_array;
+  array->private_data = data;
+}
+
+/**
+ * Converts a column into Arrow buffers, one chunk of CHUNK_NUM_ROWS rows at
+ * a time. The chunks are converted concurrently by \ref convert_chunk();
+ * strings are first converted into per chunk buffers, which are then copied
+ * into the column buffers by \ref copy_chunk() once their offsets are known.
+ */
+class column_exporter {
+ public:
+  column_exporter(const std::string& name, flex_type_enum type,
+                  size_t num_rows, column_read_function read_rows,
+                  numeric_read_function read_numeric)
+      : m_name(name), m_type(type), m_num_rows(num_rows),
+        m_read_rows(read_rows), m_read_numeric(read_numeric) {
+    switch (type) {
+      case flex_type_enum::INTEGER: m_format = "l"; break;
+      case flex_type_enum::FLOAT: m_format = "g"; break;
+      case flex_type_enum::DATETIME: m_format = "tsu:"; break;
+      case flex_type_enum::STRING: m_format = "u"; break;
+      case flex_type_enum::UNDEFINED: m_format = "n"; break;
+      default:
+        log_and_throw("Column " + name + " of type " +
+                      flex_type_enum_to_name(type) +
+                      " cannot be exported to Arrow. Convert it to str first.");
+    }
+    m_num_chunks = (num_rows + CHUNK_NUM_ROWS - 1) / CHUNK_NUM_ROWS;
+    m_chunk_null_counts.resize(m_num_chunks, 0);
+    if (type == flex_type_enum::UNDEFINED) return;
+    // the validity bitmap, and the values or the offsets and characters
+    m_buffers.emplace_back(num_words((num_rows + 7) / 8), 0);
+    if (type == flex_type_enum::STRING) {
+      m_chunk_offsets.resize(m_num_chunks);
+      m_chunk_data.resize(m_num_chunks);
+    } else {
+      m_buffers.emplace_back(std::max<size_t>(num_rows, 1), 0);
+    }
+  }
+
+  size_t num_chunks() const { return m_num_chunks; }
+
+  void convert_chunk(size_t chunk) {
+    if (m_type == flex_type_enum::UNDEFINED) return;
+    size_t begin = chunk * CHUNK_NUM_ROWS;
+    size_t end = std::min(begin + CHUNK_NUM_ROWS, m_num_rows);
+    if (m_read_numeric &&
+        m_read_numeric(begin, end, m_buffers[1].data() + begin)) {
+      set_bits(m_buffers[0].data(), begin, end);
+      return;
+    }
+    std::vector<flexible_type> values;
+    m_read_rows(begin, end, values);
+    ASSERT_EQ(values.size(), end - begin);
+
+    void* validity = m_buffers[0].data();
+    size_t null_count = 0;
+    for (size_t i = 0; i < values.size(); ++i) {
+      if (values[i].get_type() == flex_type_enum::UNDEFINED) {
+        ++null_count;
+      } else {
+        set_bit(validity, begin + i);
+      }
+    }
+    m_chunk_null_counts[chunk] = null_count;
+
+    switch (m_type) {
+      case flex_type_enum::INTEGER: {
+        int64_t* out = reinterpret_cast<int64_t*>(m_buffers[1].data()) + begin;
+        for (size_t i = 0; i < values.size(); ++i) {
+          if (values[i].get_type() != flex_type_enum::UNDEFINED) {
+            out[i] = values[i].to<flex_int>();
+          }
+        }
+        break;
+      }
+      case flex_type_enum::FLOAT: {
+        double* out = reinterpret_cast<double*>(m_buffers[1].data()) + begin;
+        for (size_t i = 0; i < values.size(); ++i) {
+          if (values[i].get_type() != flex_type_enum::UNDEFINED) {
+            out[i] = values[i].to<flex_float>();
+          }
+        }
+        break;
+      }
+      case flex_type_enum::DATETIME: {
+        int64_t* out = reinterpret_cast<int64_t*>(m_buffers[1].data()) + begin;
+        for (size_t i = 0; i < values.size(); ++i) {
+          if (values[i].get_type() != flex_type_enum::UNDEFINED) {
+            const flex_date_time& dt = values[i].get<flex_date_time>();
+            out[i] = dt.posix_timestamp() * 1000000 + dt.microsecond();
+          }
+        }
+        break;
+      }
+      case flex_type_enum::STRING: {
+        std::vector<int64_t>& offsets = m_chunk_offsets[chunk];
+        std::string& data = m_chunk_data[chunk];
+        offsets.resize(values.size() + 1);
+        offsets[0] = 0;
+        for (size_t i = 0; i < values.size(); ++i) {
+          const flexible_type& v = values[i];
+          if (v.get_type() == flex_type_enum::STRING) {
+            data.append(v.get<flex_string>());
+          } else if (v.get_type() != flex_type_enum::UNDEFINED) {
+            data.append(v.to<flex_string>());
+          }
+          offsets[i + 1] = data.size();
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  /**
+   * Called once all the chunks are converted. Returns true if \ref
+   * copy_chunk() must then be called for every chunk.
+   */
+  bool prepare_copy() {
+    if (m_type == flex_type_enum::UNDEFINED) {
+      m_null_count = m_num_rows;
+      return false;
+    }
+    m_null_count = 0;
+    for (size_t n: m_chunk_null_counts) m_null_count += n;
+    // the validity bitmap may be left out without nulls
+    if (m_null_count == 0) arrow_buffer().swap(m_buffers[0]);
+    if (m_type != flex_type_enum::STRING) return false;
+
+    m_chunk_data_begin.resize(m_num_chunks);
+    size_t total = 0;
+    for (size_t chunk = 0; chunk < m_num_chunks; ++chunk) {
+      m_chunk_data_begin[chunk] = total;
+      total += m_chunk_data[chunk].size();
+    }
+    m_large_offsets = total > size_t(std::numeric_limits<int32_t>::max());
+    if (m_large_offsets) m_format = "U";
+    size_t offset_size = m_large_offsets ? sizeof(int64_t) : sizeof(int32_t);
+    m_buffers.emplace_back(num_words((m_num_rows + 1) * offset_size), 0);
+    m_buffers.emplace_back(std::max<size_t>(num_words(total), 1), 0);
+    m_total_data_size = total;
+    return true;
+  }
+
+  void copy_chunk(size_t chunk) {
+    size_t begin = chunk * CHUNK_NUM_ROWS;
+    const std::vector<int64_t>& offsets = m_chunk_offsets[chunk];
+    int64_t data_begin = m_chunk_data_begin[chunk];
+    size_t n = offsets.size() - 1;
+    memcpy(reinterpret_cast<char*>(m_buffers[2].data()) + data_begin,
+           m_chunk_data[chunk].data(), m_chunk_data[chunk].size());
+    // the last offset of a chunk is the first of the next one
+    if (m_large_offsets) {
+      int64_t* out = reinterpret_cast<int64_t*>(m_buffers[1].data()) + begin;
+      for (size_t i = 0; i < n; ++i) out[i] = data_begin + offsets[i];
+      if (chunk + 1 == m_num_chunks) out[n] = m_total_data_size;
+    } else {
+      int32_t* out = reinterpret_cast<int32_t*>(m_buffers[1].data()) + begin;
+      for (size_t i = 0; i < n; ++i) out[i] = data_begin + offsets[i];
+      if (chunk + 1 == m_num_chunks) out[n] = m_total_data_size;
+    }
+    std::vector<int64_t>().swap(m_chunk_offsets[chunk]);
+    std::string().swap(m_chunk_data[chunk]);
+  }
+
+  /// Fills the schema and array of the column
+  void export_to(ArrowSchema* schema, ArrowArray* array) {
+    std::unique_ptr<exported_schema_data> schema_data(new exported_schema_data);
+    schema_data->format = m_format;
+    schema_data->name = m_name;
+    std::unique_ptr<exported_array_data> array_data(new exported_array_data);
+    array_data->buffers = std::move(m_buffers);
+    init_schema(schema, schema_data.release(), ARROW_FLAG_NULLABLE);
+    init_array(array, array_data.release(), m_num_rows, m_null_count);
+  }
+
+ private:
+  std::string m_name;
+  flex_type_enum m_type;
+  size_t m_num_rows;
+  column_read_function m_read_rows;
+  numeric_read_function m_read_numeric;
+  std::string m_format;
+  size_t m_num_chunks = 0;
+  std::vector<size_t> m_chunk_null_counts;
+  size_t m_null_count = 0;
+  std::vector<arrow_buffer> m_buffers;
+
+  // strings
+  std::vector<std::vector<int64_t> > m_chunk_offsets;
+  std::vector<std::string> m_chunk_data;
+  std::vector<int64_t> m_chunk_data_begin;
+  int64_t m_total_data_size = 0;
+  bool m_large_offsets = false;
+};
+
+void export_columns(const std::vector<std::string>& column_names,
+                    const std::vector<flex_type_enum>& column_types,
+                    size_t num_rows,
+                    const std::vector<column_read_function>& readers,
+                    const std::vector<numeric_read_function>& numeric_readers,
+                    ArrowSchema* out_schema, ArrowArray* out_array) {
+  size_t num_columns = column_names.size();
+  ASSERT_EQ(column_types.size(), num_columns);
+  ASSERT_EQ(readers.size(), num_columns);
+  ASSERT_EQ(numeric_readers.size(), num_columns);
+  std::vector<std::unique_ptr<column_exporter> > exporters;
+  for (size_t c = 0; c < num_columns; ++c) {
+    exporters.emplace_back(new column_exporter(column_names[c], column_types[c],
+                                               num_rows, readers[c],
+                                               numeric_readers[c]));
+  }
+
+  parallel_task_queue queue(thread_pool::get_instance());
+  for (size_t c = 0; c < num_columns; ++c) {
+    for (size_t chunk = 0; chunk < exporters[c]->num_chunks(); ++chunk) {
+      queue.launch([&, c, chunk]() { exporters[c]->convert_chunk(chunk); });
+    }
+  }
+  queue.join();
+  if (cppipc::must_cancel()) {
+    log_and_throw(std::string("Arrow export cancelled"));
+  }
+  for (size_t c = 0; c < num_columns; ++c) {
+    if (!exporters[c]->prepare_copy()) continue;
+    for (size_t chunk = 0; chunk < exporters[c]->num_chunks(); ++chunk) {
+      queue.launch([&, c, chunk]() { exporters[c]->copy_chunk(chunk); });
+    }
+  }
+  queue.join();
+
+  // a struct array without a validity bitmap, one child per column
+  std::unique_ptr<exported_schema_data> schema_data(new exported_schema_data);
+  schema_data->format = "+s";
+  schema_data->children.resize(num_columns);
+  std::unique_ptr<exported_array_data> array_data(new exported_array_data);
+  array_data->buffers.resize(1);
+  array_data->children.resize(num_columns);
+  for (size_t c = 0; c < num_columns; ++c) {
+    exporters[c]->export_to(&schema_data->children[c], &array_data->children[c]);
+  }
+  init_schema(out_schema, schema_data.release(), 0);
+  init_array(out_array, array_data.release(), num_rows, 0);
+}
+
+/**************************************************************************/
+/*                                                                        */
+/*                                 Import                                 */
+/*                                                                        */
+/**************************************************************************/
+
+/// The layouts of the Arrow columns which can be imported
+enum class import_kind {
+  BOOLEAN, INT8, INT16, INT32, INT64, UINT8, UINT16, UINT32, UINT64,
+  FLOAT32, FLOAT64, STRING32, STRING64, DATE32, DATE64, TIMESTAMP, NULL_TYPE
+};
+
+/// Releases the imported structures when they go out of scope
+struct release_guard {
+  ArrowSchema* schema;
+  ArrowArray* array;
+  ~release_guard() {
+    if (array && array->release) array->release(array);
+    if (schema && schema->release) schema->release(schema);
+  }
+};
+
+/// A child of the imported struct array
+struct imported_column {
+  std::string name;
+  import_kind kind = import_kind::NULL_TYPE;
+  flex_type_enum type = flex_type_enum::UNDEFINED;
+  /// The timestamp units in a second
+  int64_t units_per_second = 1;
+  const ArrowArray* array = nullptr;
+  /// The index in the buffers of the child of the first row
+  size_t offset = 0;
+  /// The validity bitmap of the child, or nullptr
+  const void* validity = nullptr;
+  /// The validity bitmap of the struct, or nullptr
+  const void* parent_validity = nullptr;
+  size_t parent_offset = 0;
+
+  inline bool is_valid(size_t i) const {
+    return (validity == nullptr || get_bit(validity, offset + i)) &&
+           (parent_validity == nullptr || get_bit(parent_validity, parent_offset + i));
+  }
+
+  template <typename T>
+  inline const T* values(size_t buffer) const {
+    return static_cast<const T*>(array->buffers[buffer]);
+  }
+};
+
+inline bool starts_with(const std::string& s, const char* prefix) {
+  return s.compare(0, strlen(prefix), prefix) == 0;
+}
+
+imported_column make_imported_column(const ArrowSchema* schema,
+                                     const ArrowArray* array,
+                                     const ArrowArray* parent) {
+  imported_column ret;
+  ret.name = schema->name ? schema->name : "";
+  std::string format = schema->format ? schema->format : "";
+  if (schema->dictionary != nullptr) {
+    log_and_throw("Dictionary encoded Arrow column " + ret.name +
+                  " cannot be imported");
+  }
+  static const std::map<std::string, std::pair<import_kind, flex_type_enum> > formats = {
+    {"b", {import_kind::BOOLEAN, flex_type_enum::INTEGER}},
+    {"c", {import_kind::INT8, flex_type_enum::INTEGER}},
+    {"s", {import_kind::INT16, flex_type_enum::INTEGER}},
+    {"i", {import_kind::INT32, flex_type_enum::INTEGER}},
+    {"l", {import_kind::INT64, flex_type_enum::INTEGER}},
+    {"C", {import_kind::UINT8, flex_type_enum::INTEGER}},
+    {"S", {import_kind::UINT16, flex_type_enum::INTEGER}},
+    {"I", {import_kind::UINT32, flex_type_enum::INTEGER}},
+    {"L", {import_kind::UINT64, flex_type_enum::INTEGER}},
+    {"f", {import_kind::FLOAT32, flex_type_enum::FLOAT}},
+    {"g", {import_kind::FLOAT64, flex_type_enum::FLOAT}},
+    {"u", {import_kind::STRING32, flex_type_enum::STRING}},
+    {"z", {import_kind::STRING32, flex_type_enum::STRING}},
+    {"U", {import_kind::STRING64, flex_type_enum::STRING}},
+    {"Z", {import_kind::STRING64, flex_type_enum::STRING}},
+    {"tdD", {import_kind::DATE32, flex_type_enum::DATETIME}},
+    {"tdm", {import_kind::DATE64, flex_type_enum::DATETIME}},
+    {"n", {import_kind::NULL_TYPE, flex_type_enum::UNDEFINED}}};
+  auto it = formats.find(format);
+  if (it != formats.end()) {
+    ret.kind = it->second.first;
+    ret.type = it->second.second;
+  } else if (starts_with(format, "ts") && format.size() >= 4 && format[3] == ':') {
+    // the time zone after the colon is dropped
+    ret.kind = import_kind::TIMESTAMP;
+    ret.type = flex_type_enum::DATETIME;
+    switch (format[2]) {
+      case 's': ret.units_per_second = 1; break;
+      case 'm': ret.units_per_second = 1000; break;
+      case 'u': ret.units_per_second = 1000000; break;
+      case 'n': ret.units_per_second = 1000000000; break;
+      default:
+        log_and_throw("Arrow column " + ret.name + " has the unsupported format " + format);
+    }
+  } else {
+    log_and_throw("Arrow column " + ret.name + " has the unsupported format " + format);
+  }
+
+  int64_t expected_buffers = 2;
+  if (ret.kind == import_kind::NULL_TYPE) expected_buffers = 0;
+  if (ret.kind == import_kind::STRING32 || ret.kind == import_kind::STRING64) {
+    expected_buffers = 3;
+  }
+  if (array->n_buffers != expected_buffers ||
+      array->length < parent->offset + parent->length) {
+    log_and_throw("Arrow column " + ret.name + " is malformed");
+  }
+  for (int64_t i = 1; i < expected_buffers; ++i) {
+    if (array->buffers[i] == nullptr && parent->length > 0) {
+      log_and_throw("Arrow column " + ret.name + " is malformed");
+    }
+  }
+  ret.array = array;
+  ret.offset = array->offset + parent->offset;
+  if (expected_buffers > 0 && array->null_count != 0) ret.validity = array->buffers[0];
+  if (parent->n_buffers > 0 && parent->null_count != 0) {
+    ret.parent_validity = parent->buffers[0];
+  }
+  ret.parent_offset = parent->offset;
+  return ret;
+}
+
+template <typename T>
+void read_integers(const imported_column& column, size_t begin, size_t end,
+                   std::vector<flexible_type>& out) {
+  const T* values = column.values<T>(1) + column.offset;
+  for (size_t i = begin; i < end; ++i) {
+    if (column.is_valid(i)) out[i - begin] = flex_int(values[i]);
+  }
+}
+
+template <typename T>
+void read_strings(const imported_column& column, size_t begin, size_t end,
+                  std::vector<flexible_type>& out) {
+  const T* offsets = column.values<T>(1) + column.offset;
+  const char* data = column.values<char>(2);
+  for (size_t i = begin; i < end; ++i) {
+    if (column.is_valid(i)) {
+      out[i - begin] = flex_string(data + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+  }
+}
+
+inline flex_date_time make_date_time(int64_t value, int64_t units_per_second) {
+  int64_t seconds = value / units_per_second;
+  int64_t rest = value % units_per_second;
+  if (rest < 0) {
+    rest += units_per_second;
+    --seconds;
+  }
+  return flex_date_time(seconds, flex_date_time::EMPTY_TIMEZONE,
+                        rest * 1000000 / units_per_second);
+}
+
+/// Reads the rows [begin, end) of the column into out
+void read_column(const imported_column& column, size_t begin, size_t end,
+                 std::vector<flexible_type>& out) {
+  out.assign(end - begin, FLEX_UNDEFINED);
+  switch (column.kind) {
+    case import_kind::BOOLEAN: {
+      const void* values = column.array->buffers[1];
+      for (size_t i = begin; i < end; ++i) {
+        if (column.is_valid(i)) out[i - begin] = flex_int(get_bit(values, column.offset + i));
+      }
+      break;
+    }
+    case import_kind::INT8: read_integers<int8_t>(column, begin, end, out); break;
+    case import_kind::INT16: read_integers<int16_t>(column, begin, end, out); break;
+    case import_kind::INT32: read_integers<int32_t>(column, begin, end, out); break;
+    case import_kind::INT64: read_integers<int64_t>(column, begin, end, out); break;
+    case import_kind::UINT8: read_integers<uint8_t>(column, begin, end, out); break;
+    case import_kind::UINT16: read_integers<uint16_t>(column, begin, end, out); break;
+    case import_kind::UINT32: read_integers<uint32_t>(column, begin, end, out); break;
+    case import_kind::UINT64: {
+      const uint64_t* values = column.values<uint64_t>(1) + column.offset;
+      for (size_t i = begin; i < end; ++i) {
+        if (!column.is_valid(i)) continue;
+        if (values[i] > uint64_t(std::numeric_limits<flex_int>::max())) {
+          log_and_throw("Value of Arrow column " + column.name +
+                        " does not fit in an integer");
+        }
+        out[i - begin] = flex_int(values[i]);
+      }
+      break;
+    }
+    case import_kind::FLOAT32: {
+      const float* values = column.values<float>(1) + column.offset;
+      for (size_t i = begin; i < end; ++i) {
+        if (column.is_valid(i)) out[i - begin] = flex_float(values[i]);
+      }
+      break;
+    }
+    case import_kind::FLOAT64: {
+      const double* values = column.values<double>(1) + column.offset;
+      for (size_t i = begin; i < end; ++i) {
+        if (column.is_valid(i)) out[i - begin] = flex_float(values[i]);
+      }
+      break;
+    }
+    case import_kind::STRING32: read_strings<int32_t>(column, begin, end, out); break;
+    case import_kind::STRING64: read_strings<int64_t>(column, begin, end, out); break;
+    case import_kind::DATE32: {
+      const int32_t* values = column.values<int32_t>(1) + column.offset;
+      for (size_t i = begin; i < end; ++i) {
+        if (column.is_valid(i)) out[i - begin] = make_date_time(int64_t(values[i]) * 86400, 1);
+      }
+      break;
+    }
+    case import_kind::DATE64: {
+      const int64_t* values = column.values<int64_t>(1) + column.offset;
+      for (size_t i = begin; i < end; ++i) {
+        if (column.is_valid(i)) out[i - begin] = make_date_time(values[i], 1000);
+      }
+      break;
+    }
+    case import_kind::TIMESTAMP: {
+      const int64_t* values = column.values<int64_t>(1) + column.offset;
+      for (size_t i = begin; i < end; ++i) {
+        if (column.is_valid(i)) {
+          out[i - begin] = make_date_time(values[i], column.units_per_second);
+        }
+      }
+      break;
+    }
+    case import_kind::NULL_TYPE:
+      break;
+  }
+}
+
+/**
+ * Checks the imported struct array and returns its columns, which keep
+ * pointers into the array.
+ */
+std::vector<imported_column> get_imported_columns(const ArrowSchema* schema,
+                                                  const ArrowArray* array) {
+  if (schema == nullptr || array == nullptr ||
+      schema->release == nullptr || array->release == nullptr) {
+    log_and_throw("Cannot import a released Arrow array");
+  }
+  if (schema->format == nullptr || std::string(schema->format) != "+s") {
+    log_and_throw("Only Arrow struct arrays can be imported as SFrames");
+  }
+  if (schema->n_children != array->n_children) {
+    log_and_throw("The Arrow array does not match its schema");
+  }
+  std::vector<imported_column> columns;
+  for (int64_t c = 0; c < schema->n_children; ++c) {
+    columns.push_back(make_imported_column(schema->children[c],
+                                           array->children[c], array));
+    if (columns.back().name.empty()) {
+      columns.back().name = "X" + std::to_string(c + 1);
+    }
+  }
+  return columns;
+}
+
+} // anonymous namespace
+
+
+void export_sframe_to_arrow(const sframe& sf,
+                            ArrowSchema* out_schema,
+                            ArrowArray* out_array) {
+  std::vector<column_read_function> readers;
+  std::vector<numeric_read_function> numeric_readers;
+  for (size_t c = 0; c < sf.num_columns(); ++c) {
+    std::shared_ptr<sarray_reader<flexible_type> > reader =
+        sf.select_column(c)->get_reader();
+    readers.push_back([reader](size_t begin, size_t end,
+                               std::vector<flexible_type>& out) {
+      reader->read_rows(begin, end, out);
+    });
+    // numeric blocks are decoded without flexible_types. The UNDEFINED
+    // values are read as a sentinel: the chunks holding it are read again.
+    numeric_read_function numeric_reader;
+    if (sf.column_type(c) == flex_type_enum::INTEGER) {
+      numeric_reader = [reader](size_t begin, size_t end, void* out) {
+        flex_int* values = static_cast<flex_int*>(out);
+        const flex_int missing = std::numeric_limits<flex_int>::min();
+        reader->read_rows_as(begin, end, values, missing);
+        return std::find(values, values + (end - begin), missing) == values + (end - begin);
+      };
+    } else if (sf.column_type(c) == flex_type_enum::FLOAT) {
+      numeric_reader = [reader](size_t begin, size_t end, void* out) {
+        flex_float* values = static_cast<flex_float*>(out);
+        reader->read_rows_as(begin, end, values, NAN);
+        return std::none_of(values, values + (end - begin),
+                            [](flex_float v) { return std::isnan(v); });
+      };
+    }
+    numeric_readers.push_back(numeric_reader);
+  }
+  export_columns(sf.column_names(), sf.column_types(), sf.num_rows(), readers,
+                 numeric_readers, out_schema, out_array);
+}
+
+void export_sframe_rows_to_arrow(const sframe_rows& rows,
+                                 const std::vector<std::string>& column_names,
+                                 const std::vector<flex_type_enum>& column_types,
+                                 ArrowSchema* out_schema,
+                                 ArrowArray* out_array) {
+  if (column_names.size() != rows.num_columns() ||
+      column_types.size() != rows.num_columns()) {
+    log_and_throw("Expected the names and types of " +
+                  std::to_string(rows.num_columns()) + " columns");
+  }
+  std::vector<column_read_function> readers;
+  for (const auto& column: rows.cget_columns()) {
+    readers.push_back([column](size_t begin, size_t end,
+                               std::vector<flexible_type>& out) {
+      out.assign(column->begin() + begin, column->begin() + end);
+    });
+  }
+  export_columns(column_names, column_types, rows.num_rows(), readers,
+                 std::vector<numeric_read_function>(readers.size()),
+                 out_schema, out_array);
+}
+
+sframe import_sframe_from_arrow(ArrowSchema* schema, ArrowArray* array) {
+  release_guard guard{schema, array};
+  std::vector<imported_column> columns = get_imported_columns(schema, array);
+  if (columns.empty()) {
+    log_and_throw("Cannot import an Arrow struct array without children");
+  }
+  std::vector<std::string> column_names;
+  std::vector<flex_type_enum> column_types;
+  for (const auto& column: columns) {
+    column_names.push_back(column.name);
+    column_types.push_back(column.type);
+  }
+
+  // every segment is written by one thread, CHUNK_NUM_ROWS rows at a time
+  size_t num_rows = array->length;
+  size_t num_chunks = (num_rows + CHUNK_NUM_ROWS - 1) / CHUNK_NUM_ROWS;
+  size_t num_segments = std::max<size_t>(
+      1, std::min(thread_pool::get_instance().size(), num_chunks));
+  sframe frame;
+  frame.open_for_write(column_names, column_types, "", num_segments, false);
+  auto writer = frame.get_internal_writer();
+
+  parallel_task_queue queue(thread_pool::get_instance());
+  for (size_t segment = 0; segment < num_segments; ++segment) {
+    queue.launch([&, segment]() {
+      size_t end = num_rows * (segment + 1) / num_segments;
+      std::vector<flexible_type> values;
+      for (size_t begin = num_rows * segment / num_segments; begin < end;
+           begin += CHUNK_NUM_ROWS) {
+        size_t chunk_end = std::min(begin + CHUNK_NUM_ROWS, end);
+        for (size_t c = 0; c < columns.size(); ++c) {
+          read_column(columns[c], begin, chunk_end, values);
+          writer->write_column(c, segment, std::move(values));
+        }
+        if (cppipc::must_cancel()) {
+          log_and_throw(std::string("Arrow import cancelled"));
+        }
+      }
+    });
+  }
+  queue.join();
+  frame.close();
+  return frame;
+}
+
+void import_sframe_rows_from_arrow(ArrowSchema* schema, ArrowArray* array,
+                                   sframe_rows& out_rows,
+                                   std::vector<std::string>& out_column_names,
+                                   std::vector<flex_type_enum>& out_column_types) {
+  release_guard guard{schema, array};
+  std::vector<imported_column> columns = get_imported_columns(schema, array);
+  size_t num_rows = array->length;
+  out_rows.resize(columns.size(), num_rows);
+  out_column_names.clear();
+  out_column_types.clear();
+  parallel_task_queue queue(thread_pool::get_instance());
+  for (size_t c = 0; c < columns.size(); ++c) {
+    out_column_names.push_back(columns[c].name);
+    out_column_types.push_back(columns[c].type);
+    queue.launch([&, c]() {
+      read_column(columns[c], 0, num_rows, *out_rows.get_columns()[c]);
+    });
+  }
+  queue.join();
+}
+
+} // namespace turi
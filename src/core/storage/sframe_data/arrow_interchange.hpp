@@ -0,0 +1,132 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_ARROW_INTERCHANGE_HPP
+#define TURI_SFRAME_ARROW_INTERCHANGE_HPP
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <core/data/flexible_type/flexible_type.hpp>
+
+extern "C" {
+// The structures of the Arrow C data interface, as specified in
+// https://arrow.apache.org/docs/format/CDataInterface.html
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+  // Array type description
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowSchema*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+struct ArrowArray {
+  // Array data description
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowArray*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+#endif  // ARROW_C_DATA_INTERFACE
+}
+
+namespace turi {
+class sframe;
+class sframe_rows;
+
+/**
+ * \ingroup sframe_physical
+ * \addtogroup arrow Arrow Interchange
+ * \{
+ */
+
+/**
+ * Exports an SFrame through the Arrow C data interface, as a struct array
+ * with one nullable child per column (a record batch). The columns are
+ * exported as:
+ *  - flex_type_enum::INTEGER: int64 ("l")
+ *  - flex_type_enum::FLOAT: float64 ("g")
+ *  - flex_type_enum::STRING: utf8 ("u"), or large_utf8 ("U") if the column
+ *    holds more than 2GB of characters
+ *  - flex_type_enum::DATETIME: timestamp in microseconds without a time zone
+ *    ("tsu:"), the time zones being dropped
+ *  - flex_type_enum::UNDEFINED: null ("n")
+ *
+ * Throws if a column has another type. The buffers are filled in parallel
+ * and are owned by the exported structures: the consumer takes them over
+ * without copying, and must call the release callbacks of out_schema and
+ * out_array when done with them.
+ */
+void export_sframe_to_arrow(const sframe& sf,
+                            ArrowSchema* out_schema,
+                            ArrowArray* out_array);
+
+/**
+ * Exports the rows of a block of the query engine like \ref
+ * export_sframe_to_arrow(), with the given column names and types.
+ */
+void export_sframe_rows_to_arrow(const sframe_rows& rows,
+                                 const std::vector<std::string>& column_names,
+                                 const std::vector<flex_type_enum>& column_types,
+                                 ArrowSchema* out_schema,
+                                 ArrowArray* out_array);
+
+/**
+ * Imports a struct array (a record batch) through the Arrow C data
+ * interface into an SFrame with one column per child of the struct. The
+ * children may be:
+ *  - boolean, signed and unsigned integers: flex_type_enum::INTEGER
+ *  - float32 and float64: flex_type_enum::FLOAT
+ *  - utf8, large_utf8, binary and large_binary: flex_type_enum::STRING
+ *  - date32, date64 and timestamps: flex_type_enum::DATETIME, the time
+ *    zones being dropped
+ *  - null: flex_type_enum::UNDEFINED
+ *
+ * The null rows of the struct are rows of UNDEFINED values. The columns
+ * are written in parallel directly into the segments of the SFrame.
+ * Children without a name are named "X1", "X2", ...
+ *
+ * The schema and array are released once imported, also when the import
+ * fails.
+ */
+sframe import_sframe_from_arrow(ArrowSchema* schema, ArrowArray* array);
+
+/**
+ * Imports a struct array like \ref import_sframe_from_arrow() into a block
+ * of the query engine, and the names and types of its columns.
+ */
+void import_sframe_rows_from_arrow(ArrowSchema* schema, ArrowArray* array,
+                                   sframe_rows& out_rows,
+                                   std::vector<std::string>& out_column_names,
+                                   std::vector<flex_type_enum>& out_column_types);
+
+/// \}
+} // namespace turi
+
+#endif
@@ -0,0 +1,149 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <core/storage/sframe_data/csv_field_scan.hpp>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define TURI_CSV_FIELD_SCAN_HAS_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define TURI_CSV_FIELD_SCAN_HAS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace turi {
+namespace csv_field_scan {
+
+namespace {
+
+typedef bool (*find_separators_fn)(const char*, size_t, char, const char*,
+                                   std::vector<size_t>&);
+
+/**
+ * Scans str[begin, len) one character at a time. Used for the whole line by
+ * the scalar implementation, and for the last partial vector by the others.
+ */
+inline bool scan_tail(const char* str, size_t begin, size_t len,
+                      char delimiter, const char specials[4],
+                      std::vector<size_t>& separators) {
+  for (size_t i = begin; i < len; ++i) {
+    char c = str[i];
+    if (c == specials[0] || c == specials[1] ||
+        c == specials[2] || c == specials[3]) {
+      return false;
+    }
+    if (c == delimiter) separators.push_back(i);
+  }
+  return true;
+}
+
+#ifdef TURI_CSV_FIELD_SCAN_HAS_AVX2
+
+__attribute__((target("avx2")))
+bool find_separators_avx2(const char* str, size_t len,
+                          char delimiter, const char specials[4],
+                          std::vector<size_t>& separators) {
+  const __m256i d = _mm256_set1_epi8(delimiter);
+  const __m256i s0 = _mm256_set1_epi8(specials[0]);
+  const __m256i s1 = _mm256_set1_epi8(specials[1]);
+  const __m256i s2 = _mm256_set1_epi8(specials[2]);
+  const __m256i s3 = _mm256_set1_epi8(specials[3]);
+  size_t i = 0;
+  // 32 bytes at a time
+  for (; i + 32 <= len; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(str + i));
+    __m256i special = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, s0), _mm256_cmpeq_epi8(v, s1)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, s2), _mm256_cmpeq_epi8(v, s3)));
+    if (!_mm256_testz_si256(special, special)) return false;
+    uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, d));
+    while (mask) {
+      separators.push_back(i + __builtin_ctz(mask));
+      mask &= mask - 1;
+    }
+  }
+  return scan_tail(str, i, len, delimiter, specials, separators);
+}
+
+#endif
+
+#ifdef TURI_CSV_FIELD_SCAN_HAS_NEON
+
+bool find_separators_neon(const char* str, size_t len,
+                          char delimiter, const char specials[4],
+                          std::vector<size_t>& separators) {
+  const uint8x16_t d = vdupq_n_u8((uint8_t)delimiter);
+  const uint8x16_t s0 = vdupq_n_u8((uint8_t)specials[0]);
+  const uint8x16_t s1 = vdupq_n_u8((uint8_t)specials[1]);
+  const uint8x16_t s2 = vdupq_n_u8((uint8_t)specials[2]);
+  const uint8x16_t s3 = vdupq_n_u8((uint8_t)specials[3]);
+  size_t i = 0;
+  // 16 bytes at a time
+  for (; i + 16 <= len; i += 16) {
+    uint8x16_t v = vld1q_u8((const uint8_t*)(str + i));
+    uint8x16_t special = vorrq_u8(vorrq_u8(vceqq_u8(v, s0), vceqq_u8(v, s1)),
+                                  vorrq_u8(vceqq_u8(v, s2), vceqq_u8(v, s3)));
+    if (vmaxvq_u8(special)) return false;
+    // NEON has no movemask: narrowing keeps 4 bits of every byte.
+    uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(vceqq_u8(v, d)), 4);
+    uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+    while (mask) {
+      size_t bit = __builtin_ctzll(mask);
+      separators.push_back(i + bit / 4);
+      mask &= ~(uint64_t(0xF) << (bit & ~size_t(3)));
+    }
+  }
+  return scan_tail(str, i, len, delimiter, specials, separators);
+}
+
+#endif
+
+find_separators_fn select_find_separators_implementation() {
+#ifdef TURI_CSV_FIELD_SCAN_HAS_AVX2
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return find_separators_avx2;
+#endif
+#ifdef TURI_CSV_FIELD_SCAN_HAS_NEON
+  return find_separators_neon;
+#endif
+  return find_separators_scalar;
+}
+
+find_separators_fn get_find_separators_implementation() {
+  static const find_separators_fn fn = select_find_separators_implementation();
+  return fn;
+}
+
+} // anonymous namespace
+
+
+bool find_separators_scalar(const char* str, size_t len,
+                            char delimiter, const char specials[4],
+                            std::vector<size_t>& separators) {
+  return scan_tail(str, 0, len, delimiter, specials, separators);
+}
+
+bool find_separators(const char* str, size_t len,
+                     char delimiter, const char specials[4],
+                     std::vector<size_t>& separators) {
+  return get_find_separators_implementation()(str, len, delimiter, specials,
+                                              separators);
+}
+
+const char* find_separators_implementation() {
+  find_separators_fn fn = get_find_separators_implementation();
+#ifdef TURI_CSV_FIELD_SCAN_HAS_AVX2
+  if (fn == find_separators_avx2) return "avx2";
+#endif
+#ifdef TURI_CSV_FIELD_SCAN_HAS_NEON
+  if (fn == find_separators_neon) return "neon";
+#endif
+  return "scalar";
+}
+
+} // namespace csv_field_scan
+} // namespace turi
@@ -0,0 +1,61 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_CSV_FIELD_SCAN_HPP
+#define TURI_SFRAME_CSV_FIELD_SCAN_HPP
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace turi {
+
+/**
+ * \ingroup sframe_physical
+ * \addtogroup csv_utils CSV Parsing and Writing
+ * \{
+ */
+
+/**
+ * \internal
+ * Vectorized scanning of CSV lines for the \ref csv_line_tokenizer.
+ */
+namespace csv_field_scan {
+
+/**
+ * Appends to separators the position of every occurrence of the delimiter
+ * in str[0, len), many bytes at a time.
+ *
+ * Stops and returns false as soon as any of the 4 special characters is
+ * found (the characters which need the tokenizer state machine, such as
+ * quotes; repeat one to use fewer). separators is then left partially
+ * filled.
+ *
+ * The implementation is picked once at runtime: AVX2 on x86-64 processors
+ * which support it, NEON on ARM, and \ref find_separators_scalar()
+ * otherwise. All implementations produce exactly the same output.
+ */
+bool find_separators(const char* str, size_t len,
+                     char delimiter, const char specials[4],
+                     std::vector<size_t>& separators);
+
+/**
+ * The scalar reference implementation of \ref find_separators().
+ */
+bool find_separators_scalar(const char* str, size_t len,
+                            char delimiter, const char specials[4],
+                            std::vector<size_t>& separators);
+
+/**
+ * Returns the name of the implementation \ref find_separators() dispatches
+ * to. One of "avx2", "neon" or "scalar".
+ */
+const char* find_separators_implementation();
+
+} // namespace csv_field_scan
+
+/// \}
+} // namespace turi
+
+#endif
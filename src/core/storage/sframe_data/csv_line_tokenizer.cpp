@@ -15,6 +15,7 @@
 #include <core/logging/logger.hpp>
 #include <boost/config/warning_disable.hpp>
 #include <core/storage/sframe_data/csv_line_tokenizer.hpp>
+#include <core/storage/sframe_data/csv_field_scan.hpp>
 #include <core/data/flexible_type/string_escape.hpp>
 #include <core/data/flexible_type/flexible_type_spirit_parser.hpp>
 
@@ -328,10 +329,13 @@ bool csv_line_tokenizer::parse_as(char** buf, size_t len,
    */
   switch(out.get_type()) {
    case flex_type_enum::INTEGER:
-     std::tie(out, parse_success) = parser->int_parse((const char**)buf, len);
+     // parsed in place: no flexible_type temporaries for the common case
+     parse_success = parser->int_parse((const char**)buf, len,
+                                       out.mutable_get<flex_int>());
      break;
    case flex_type_enum::FLOAT:
-     std::tie(out, parse_success) = parser->double_parse((const char**)buf, len);
+     parse_success = parser->double_parse((const char**)buf, len,
+                                          out.mutable_get<flex_float>());
      break;
    case flex_type_enum::VECTOR:
      std::tie(out, parse_success) = parser->vector_parse((const char**)buf, len);
@@ -483,6 +487,13 @@ bool csv_line_tokenizer::tokenize_line_impl(char* str,
     add_token(str, len, str, len);
     return true;
   }
+  if (use_structural_scan) {
+    field_separators.clear();
+    if (csv_field_scan::find_separators(str, len, delimiter_first_character,
+                                        structural_specials, field_separators)) {
+      return tokenize_separated_fields(str, len, add_token);
+    }
+  }
 
   // this is adaptive. It can be either " or ' as we encounter it
 
@@ -637,6 +648,40 @@ REGULAR_CHARACTER:
   return true;
 }
 
+template <typename Fn>
+bool csv_line_tokenizer::tokenize_separated_fields(char* str, size_t len,
+                                                   Fn add_token) {
+  size_t num_fields = field_separators.size() + 1;
+  size_t field_begin = 0;
+  for (size_t i = 0; i < num_fields; ++i) {
+    bool last_field = (i + 1 == num_fields);
+    size_t field_end = last_field ? len : field_separators[i];
+    char* field = str + field_begin;
+    size_t field_len = field_end - field_begin;
+    if (skip_initial_space) {
+      while (field_len > 0 && is_space_but_not_tab(*field)) {
+        ++field;
+        --field_len;
+      }
+    }
+    bool success = true;
+    if (last_field && field_len == 0) {
+      // the state machine ends in START_FIELD: a trailing delimiter is
+      // followed by an empty token, and a blank line has no tokens.
+      if (num_fields > 1) success = add_token(nullptr, 0, nullptr, 0);
+    } else {
+      // with no quotes or escapes, the field is its raw text
+      success = add_token(field, field_len, field, field_len);
+    }
+    if (!success) {
+      tokenizer_impl_fail_pos = (ssize_t)(last_field ? len : field_end + 1);
+      return false;
+    }
+    field_begin = field_end + 1;
+  }
+  return true;
+}
+
 const std::string& csv_line_tokenizer::get_last_parse_error_diagnosis() const {
   return parse_error;
 }
@@ -668,6 +713,22 @@ void csv_line_tokenizer::init() {
     empty_string_in_na_values |= na_val.length() == 0;
   }
 
+  // A delimiter which is also one of the characters handled by the state
+  // machine has to go through it.
+  char comment = has_comment_char ? comment_char : quote_char;
+  use_structural_scan = structural_scan &&
+                        delimiter_is_singlechar &&
+                        !delimiter_is_new_line &&
+                        !delimiter_is_space_but_not_tab &&
+                        delimiter_first_character != quote_char &&
+                        delimiter_first_character != comment &&
+                        delimiter_first_character != '[' &&
+                        delimiter_first_character != '{';
+  structural_specials[0] = quote_char;
+  structural_specials[1] = comment;
+  structural_specials[2] = '[';
+  structural_specials[3] = '{';
+
 }
 
 } // namespace turi
@@ -140,6 +140,16 @@ struct csv_line_tokenizer {
    */
   bool only_raw_string_substitutions = false;
 
+  /**
+   * If set to true (Default), lines are first scanned for delimiters many
+   * bytes at a time (see csv_field_scan.hpp). Lines with no quote, comment or
+   * bracket characters are then split at the delimiters directly, and only
+   * the other lines go through the tokenizer state machine. The output is
+   * the same either way. Only applies to single character delimiters which
+   * are not spaces.
+   */
+  bool structural_scan = true;
+
   /**
    * Constructor. Does nothing but set up internal buffers.
    */
@@ -345,6 +355,14 @@ struct csv_line_tokenizer {
                           Fn2 lookahead,
                           Fn3 undotoken);
 
+  /**
+   * Calls add_token on the fields of a line split at the delimiter
+   * positions in field_separators, exactly as tokenize_line_impl would for a
+   * line without quote, comment or bracket characters.
+   */
+  template <typename Fn>
+  bool tokenize_separated_fields(char* str, size_t len, Fn add_token);
+
   std::shared_ptr<flexible_type_parser> parser;
 
   // some precomputed information about the delimiter so we avoid excess
@@ -357,6 +375,13 @@ struct csv_line_tokenizer {
   bool empty_string_in_na_values = false;
   bool is_regular_line_terminator = true;
 
+  // whether lines are scanned for delimiters before the state machine, and
+  // the characters which send a line to the state machine
+  bool use_structural_scan = false;
+  char structural_specials[4];
+  // the delimiter positions found by the scan of the current line
+  std::vector<size_t> field_separators;
+
 
 
   /**
@@ -3,11 +3,49 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
 #include <core/storage/sframe_data/csv_writer.hpp>
+#include <core/storage/sframe_data/sframe.hpp>
 #include <core/data/flexible_type/string_escape.hpp>
 #include <core/logging/logger.hpp>
+#include <core/parallel/thread_pool.hpp>
+#include <core/system/cppipc/server/cancel_ops.hpp>
 namespace turi {
 
+namespace {
+
+/// The number of rows formatted by each task of write_csv_rows()
+static constexpr size_t CSV_WRITE_CHUNK_ROWS = 8192;
+
+/**
+ * Formats an INTEGER or FLOAT into buf, exactly as std::string(val) does
+ * (std::ostream formatting, i.e. "%g" for floats), but without going
+ * through a stringstream. Returns the length written.
+ */
+inline size_t format_number(const flexible_type& val, char (&buf)[32]) {
+  if (val.get_type() == flex_type_enum::FLOAT) {
+    int len = snprintf(buf, sizeof(buf), "%g", val.get<flex_float>());
+    return len > 0 ? std::min<size_t>(len, sizeof(buf) - 1) : 0;
+  }
+  flex_int v = val.get<flex_int>();
+  uint64_t magnitude = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+  char* end = buf + sizeof(buf);
+  char* p = end;
+  do {
+    *--p = (char)('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude > 0);
+  if (v < 0) *--p = '-';
+  size_t len = end - p;
+  memmove(buf, p, len);
+  return len;
+}
+
+} // anonymous namespace
+
 void csv_writer::write_verbatim(std::ostream& out,
                                 const std::vector<std::string>& row) {
   for (size_t i = 0;i < row.size(); ++i) {
@@ -21,9 +59,11 @@ void csv_writer::write_verbatim(std::ostream& out,
 void csv_writer::csv_print_internal(std::string& out, const flexible_type& val) {
   switch(val.get_type()) {
     case flex_type_enum::INTEGER:
-    case flex_type_enum::FLOAT:
-      out += std::string(val);
+    case flex_type_enum::FLOAT: {
+      char buf[32];
+      out.append(buf, format_number(val, buf));
       break;
+    }
     case flex_type_enum::DATETIME:
       out += std::string(val);
       break;
@@ -75,13 +115,18 @@ void csv_writer::csv_print(std::ostream& out,
   bool str_has_quote_char = false;
   switch(val.get_type()) {
     case flex_type_enum::INTEGER:
-    case flex_type_enum::FLOAT:
+    case flex_type_enum::FLOAT: {
+      char buf[32];
+      size_t len = format_number(val, buf);
       if (quote_level == csv_quote_level::QUOTE_ALL) {
-        out << quote_char << std::string(val) << quote_char; // quote numbers only at QUOTE_ALL
+        out << quote_char; // quote numbers only at QUOTE_ALL
+        out.write(buf, len);
+        out << quote_char;
       } else {
-        out << std::string(val);
+        out.write(buf, len);
       }
       break;
+    }
     case flex_type_enum::DATETIME:
     case flex_type_enum::VECTOR:
       if (quote_level == csv_quote_level::QUOTE_NONE) {
@@ -205,6 +250,65 @@ void csv_writer::write(std::ostream& out,
   out << line_terminator;
 }
 
+void write_csv_rows(std::ostream& out,
+                    const sframe& sf,
+                    const csv_writer& writer,
+                    const std::string& line_prefix,
+                    bool no_prefix_on_first_row) {
+  size_t num_rows = sf.num_rows();
+  if (num_rows == 0 || sf.num_columns() == 0) return;
+  auto reader = sf.get_reader();
+  size_t num_chunks = (num_rows + CSV_WRITE_CHUNK_ROWS - 1) / CSV_WRITE_CHUNK_ROWS;
+  size_t wave_size = std::max<size_t>(thread_pool::get_instance().size(), 1);
+
+  // formats chunk into buffer, with a writer of its own
+  auto format_chunk = [&](size_t chunk, std::string& buffer) {
+    size_t begin = chunk * CSV_WRITE_CHUNK_ROWS;
+    size_t end = std::min(begin + CSV_WRITE_CHUNK_ROWS, num_rows);
+    std::vector<std::vector<flexible_type> > rows;
+    reader->read_rows(begin, end, rows);
+    csv_writer local_writer = writer;
+    std::ostringstream formatted;
+    for (size_t i = 0; i < rows.size(); ++i) {
+      if (!line_prefix.empty() &&
+          !(no_prefix_on_first_row && begin + i == 0)) {
+        formatted.write(line_prefix.c_str(), line_prefix.size());
+      }
+      local_writer.write(formatted, rows[i]);
+    }
+    buffer = formatted.str();
+  };
 
+  // chunks are formatted a wave (one chunk per thread) at a time. A wave is
+  // written out, in order, while the next one is formatted.
+  std::vector<std::string> buffers[2];
+  buffers[0].resize(wave_size);
+  buffers[1].resize(wave_size);
+  parallel_task_queue queue(thread_pool::get_instance());
+  auto launch_wave = [&](size_t wave) {
+    for (size_t i = 0; i < wave_size && wave * wave_size + i < num_chunks; ++i) {
+      queue.launch([&, wave, i]() {
+        format_chunk(wave * wave_size + i, buffers[wave % 2][i]);
+      });
+    }
+  };
+  size_t num_waves = (num_chunks + wave_size - 1) / wave_size;
+  launch_wave(0);
+  queue.join();
+  for (size_t wave = 0; wave < num_waves; ++wave) {
+    if (wave + 1 < num_waves) launch_wave(wave + 1);
+    for (auto& buffer: buffers[wave % 2]) {
+      out.write(buffer.data(), buffer.size());
+      buffer.clear();
+    }
+    queue.join();
+    if (!out.good()) {
+      log_and_throw_io_failure("Fail to write.");
+    }
+    if (cppipc::must_cancel()) {
+      log_and_throw(std::string("CSV writing cancelled"));
+    }
+  }
+}
 
 } // namespace turi
@@ -11,6 +11,7 @@
 #include <core/data/flexible_type/flexible_type.hpp>
 namespace turi {
 
+class sframe;
 
 /**
  * \ingroup sframe_physical
@@ -154,6 +155,21 @@ class csv_writer {
   size_t m_string_escape_buffer_len = 0;
 };
 
+/**
+ * Writes the rows of sf to out, formatted by writer, each preceded by
+ * line_prefix (except the first one if no_prefix_on_first_row is set).
+ * The header is not written.
+ *
+ * Chunks of rows are read and formatted in parallel, each by a copy of the
+ * writer, into buffers which are written to out in order. The output is
+ * the same as calling writer.write() on every row.
+ */
+void write_csv_rows(std::ostream& out,
+                    const sframe& sf,
+                    const csv_writer& writer,
+                    const std::string& line_prefix = "",
+                    bool no_prefix_on_first_row = false);
+
 /// \}
 
 } // namespace turi
@@ -0,0 +1,244 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <core/generics/bloom_filter.hpp>
+#include <core/globals/memory_accounting.hpp>
+#include <core/logging/logger.hpp>
+#include <core/parallel/atomic.hpp>
+#include <core/parallel/lambda_omp.hpp>
+#include <core/storage/fileio/buffered_writer.hpp>
+#include <core/storage/fileio/memory_budget.hpp>
+#include <core/storage/sframe_data/distinct.hpp>
+#include <core/storage/sframe_data/sframe_config.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
+#include <core/util/cityhash_tc.hpp>
+
+namespace turi {
+
+namespace {
+
+// guestimates for the size of each cell and the memory overhead of each
+// row, as for sorting
+constexpr size_t CELL_SIZE_ESTIMATE = 64;
+constexpr size_t ROW_SIZE_ESTIMATE = 32;
+
+/// Rows with the same hash take the same lock while filtered
+constexpr size_t NUM_FILTER_LOCKS = 1024;
+
+/// With fewer bits per row, the filters would let too few rows through
+constexpr size_t MIN_FILTER_BITS_PER_KEY = 4;
+
+uint64_t hash_keys(const std::vector<flexible_type>& row,
+                   const std::vector<size_t>& key_columns) {
+  uint64_t h = 0;
+  for (size_t c: key_columns) h = hash64(h, row[c].hash());
+  return h;
+}
+
+/// The partition of a hash. Partitions are ranges of hashes.
+inline size_t partition_of(uint64_t h, size_t num_partitions) {
+  return ((h >> 32) * num_partitions) >> 32;
+}
+
+/**
+ * Calls fn(thread_number, row, hash of the keys) on every row of the input,
+ * from num_workers threads.
+ */
+template <typename Fn>
+void for_each_row(sframe& sframe_in, const std::vector<size_t>& key_columns,
+                  size_t num_workers, Fn fn) {
+  size_t num_rows = sframe_in.num_rows();
+  size_t rows_per_worker = num_rows / num_workers;
+  auto reader = sframe_in.get_reader();
+  parallel_for(0, num_workers, [&](size_t worker_id) {
+    size_t start_row = worker_id * rows_per_worker;
+    size_t end_row = (worker_id == (num_workers - 1)) ? num_rows
+                                                      : (worker_id + 1) * rows_per_worker;
+    std::vector<std::vector<flexible_type>> rows;
+    while (start_row < end_row) {
+      size_t rows_to_read = std::min<size_t>(end_row - start_row,
+                                             DEFAULT_SARRAY_READER_BUFFER_SIZE);
+      size_t rows_read = reader->read_rows(start_row, start_row + rows_to_read, rows);
+      for (size_t i = 0; i < rows_read; ++i) {
+        fn(worker_id, rows[i], hash_keys(rows[i], key_columns));
+      }
+      start_row += rows_read;
+    }
+  });
+}
+
+} // anonymous namespace
+
+
+sframe distinct(sframe sframe_in,
+                const std::vector<size_t>& _key_columns,
+                size_t memory_budget) {
+  size_t num_rows = sframe_in.num_rows();
+  auto column_names = sframe_in.column_names();
+  auto column_types = sframe_in.column_types();
+  std::vector<size_t> key_columns = _key_columns;
+  if (key_columns.empty()) {
+    for (size_t i = 0; i < column_names.size(); ++i) key_columns.push_back(i);
+  }
+  for (size_t c: key_columns) {
+    if (c >= column_names.size()) log_and_throw("Key column index out of range");
+    // dictionaries with the same items may not hash the same
+    if (column_types[c] == flex_type_enum::DICT) {
+      log_and_throw("Cannot find the distinct values of dictionary column "
+                    + column_names[c]);
+    }
+  }
+  if (memory_budget == 0) memory_budget = sframe_config::SFRAME_SORT_BUFFER_SIZE;
+
+  size_t row_size = column_names.size() * CELL_SIZE_ESTIMATE + ROW_SIZE_ESTIMATE;
+  fileio::memory_reservation distinct_memory;
+  size_t buffer_size = distinct_memory.reserve_up_to(
+      std::min<size_t>(std::max<size_t>(num_rows * row_size, 1), memory_budget),
+      memory_budget / 16);
+  buffer_size = std::max<size_t>(buffer_size, 1);
+  memory_accounting::tagged_memory distinct_buffer_memory(
+      memory_accounting::get_tag("distinct_buffers"));
+  distinct_buffer_memory.set(buffer_size);
+  size_t num_workers = std::max<size_t>(thread::cpu_count(), 1);
+
+  // Pass 1: find the hashes which (probably) occur more than once. The two
+  // filters get half of the buffer.
+  size_t bits_per_key = num_rows == 0 ? 0 :
+      std::min<size_t>(bloom_filter::DEFAULT_BITS_PER_KEY, buffer_size * 8 / 4 / num_rows);
+  bool use_filter = bits_per_key >= MIN_FILTER_BITS_PER_KEY;
+  bloom_filter repeated;
+  size_t num_repeated = 0;
+  if (use_filter) {
+    bloom_filter seen(num_rows, bits_per_key);
+    repeated = bloom_filter(num_rows, bits_per_key);
+    std::vector<simple_spinlock> filter_locks(NUM_FILTER_LOCKS);
+    turi::atomic<size_t> repeated_count;
+    for_each_row(sframe_in, key_columns, num_workers,
+                 [&](size_t, std::vector<flexible_type>&, uint64_t h) {
+      // a hash is only checked and inserted under its lock. Bits set
+      // concurrently for other hashes only make may_contain() err towards
+      // true.
+      std::lock_guard<simple_spinlock> guard(filter_locks[h % NUM_FILTER_LOCKS]);
+      if (seen.may_contain(h)) {
+        repeated.insert(h);
+        repeated_count.inc();
+      } else {
+        seen.insert(h);
+      }
+    });
+    num_repeated = repeated_count.value;
+  }
+
+  // the rows which may have duplicates: the repeated ones, the first of
+  // each, and the false positives of the filter.
+  size_t num_exact_rows = num_rows;
+  if (use_filter) {
+    num_exact_rows = std::min<size_t>(
+        num_rows, 2 * num_repeated + num_rows * std::pow(0.62, bits_per_key));
+  }
+  size_t partition_buffer_size = std::max<size_t>(use_filter ? buffer_size / 2 : buffer_size, 1);
+  size_t num_partitions = std::ceil((1.0 * num_exact_rows * row_size) / partition_buffer_size);
+  num_partitions = std::min<size_t>(num_partitions * num_workers, SFRAME_SORT_MAX_SEGMENTS);
+  num_partitions = std::max<size_t>(num_partitions, 1);
+  logstream(LOG_INFO) << "Deduplicating " << num_rows << " rows: "
+                      << num_repeated << " repeated hashes, "
+                      << num_partitions << " partitions" << std::endl;
+
+  // Pass 2: write the rows which certainly are unique to the output, and
+  // scatter the others to the partitions. Output segment i < num_workers
+  // gets the unique rows read by thread i, and segment num_workers + p the
+  // rows kept from partition p.
+  sframe sframe_out;
+  sframe_out.open_for_write(column_names, column_types, "", num_workers + num_partitions);
+
+  std::vector<sframe> partitions(num_partitions);
+  std::vector<sframe::iterator> partition_iters;
+  std::vector<std::unique_ptr<turi::mutex>> partition_locks;
+  for (auto& partition: partitions) {
+    partition.open_for_write(column_names, column_types, "", 1);
+    partition_iters.push_back(partition.get_output_iterator(0));
+    partition_locks.push_back(std::unique_ptr<turi::mutex>(new turi::mutex));
+  }
+
+  typedef buffered_writer<std::vector<flexible_type>, sframe::iterator> partition_writer;
+  std::vector<std::vector<partition_writer>> writers(num_workers);
+  std::vector<sframe::iterator> unique_iters;
+  for (size_t i = 0; i < num_workers; ++i) {
+    unique_iters.push_back(sframe_out.get_output_iterator(i));
+    for (size_t p = 0; p < num_partitions; ++p) {
+      writers[i].push_back(partition_writer(
+          partition_iters[p], *partition_locks[p],
+          SFRAME_WRITER_BUFFER_SOFT_LIMIT, SFRAME_WRITER_BUFFER_HARD_LIMIT));
+    }
+  }
+  for_each_row(sframe_in, key_columns, num_workers,
+               [&](size_t worker_id, std::vector<flexible_type>& row, uint64_t h) {
+    if (use_filter && !repeated.may_contain(h)) {
+      *(unique_iters[worker_id]) = std::move(row);
+      ++unique_iters[worker_id];
+    } else {
+      writers[worker_id][partition_of(h, num_partitions)].write(std::move(row));
+    }
+  });
+  for (auto& worker_writers: writers) {
+    for (auto& writer: worker_writers) writer.flush();
+  }
+  writers.clear();
+  repeated = bloom_filter();
+  for (auto& partition: partitions) partition.close();
+
+  // Pass 3: deduplicate every partition with a hash table of the keys kept
+  // so far. The partition is streamed, and only the keys of its distinct
+  // rows are held in memory.
+  parallel_for(0, num_partitions, [&](size_t p) {
+    std::unordered_multimap<uint64_t, std::vector<flexible_type>> kept_keys;
+    auto is_kept = [&](uint64_t h, const std::vector<flexible_type>& row) {
+      auto range = kept_keys.equal_range(h);
+      for (auto it = range.first; it != range.second; ++it) {
+        bool identical = true;
+        for (size_t i = 0; i < key_columns.size() && identical; ++i) {
+          identical = it->second[i].identical(row[key_columns[i]]);
+        }
+        if (identical) return true;
+      }
+      return false;
+    };
+
+    auto out = sframe_out.get_output_iterator(num_workers + p);
+    auto reader = partitions[p].get_reader();
+    size_t partition_rows = partitions[p].num_rows();
+    std::vector<std::vector<flexible_type>> rows;
+    size_t start_row = 0;
+    while (start_row < partition_rows) {
+      size_t rows_to_read = std::min<size_t>(partition_rows - start_row,
+                                             DEFAULT_SARRAY_READER_BUFFER_SIZE);
+      size_t rows_read = reader->read_rows(start_row, start_row + rows_to_read, rows);
+      if (rows_read == 0) break;
+      for (size_t i = 0; i < rows_read; ++i) {
+        uint64_t h = hash_keys(rows[i], key_columns);
+        if (is_kept(h, rows[i])) continue;
+        std::vector<flexible_type> keys;
+        keys.reserve(key_columns.size());
+        for (size_t c: key_columns) keys.push_back(rows[i][c]);
+        kept_keys.emplace(h, std::move(keys));
+        *out = std::move(rows[i]);
+        ++out;
+      }
+      start_row += rows_read;
+    }
+    // the partition is not needed anymore
+    reader.reset();
+    partitions[p] = sframe();
+  });
+  sframe_out.close();
+  return sframe_out;
+}
+
+} // namespace turi
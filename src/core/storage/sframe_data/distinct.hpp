@@ -0,0 +1,48 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_DISTINCT_HPP
+#define TURI_SFRAME_DISTINCT_HPP
+
+#include <vector>
+#include <core/storage/sframe_data/sframe.hpp>
+
+namespace turi {
+
+/**
+ * \ingroup sframe_physical
+ * \addtogroup sframe_main Main SFrame Objects
+ * \{
+ */
+
+/**
+ * Returns the rows of sframe_in without duplicates, in no particular order.
+ *
+ * If key_columns is empty, two rows are duplicates when all their values
+ * are identical, and one of them is kept. Otherwise only the values of the
+ * key columns are compared, and one of the rows sharing them (any of them)
+ * is kept whole, as a drop_duplicates on a subset of the columns. Key
+ * columns cannot be dictionaries.
+ *
+ * Rows are deduplicated by hashing, without sorting:
+ *  - A first pass inserts the hash of every row in a bloom filter, and the
+ *    hashes seen more than once in a second one.
+ *  - A second pass writes the rows whose hash is not in the second filter
+ *    straight to the output: they are certainly unique. The others are
+ *    scattered to partitions on disk by their hash.
+ *  - Each partition is then deduplicated with a hash set, several in
+ *    parallel, and appended to the output.
+ * With few duplicates, almost every row takes the fast path. The filters
+ * and the partitions held in memory at once stay within memory_budget
+ * bytes (estimated); 0 for sframe_config::SFRAME_SORT_BUFFER_SIZE.
+ */
+sframe distinct(sframe sframe_in,
+                const std::vector<size_t>& key_columns = std::vector<size_t>(),
+                size_t memory_budget = 0);
+
+/// \}
+} // namespace turi
+
+#endif
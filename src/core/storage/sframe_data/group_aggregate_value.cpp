@@ -67,6 +67,20 @@ std::shared_ptr<group_aggregate_value> get_builtin_group_aggregator(
     return quantile_operator;
   } else if (boost::algorithm::starts_with(name, "__builtin__count__distinct__")) {
     return std::make_shared<groupby_operators::count_distinct>();
+  } else if (boost::algorithm::starts_with(name, "__builtin__approx__count__distinct__")) {
+    return std::make_shared<groupby_operators::approx_count_distinct>();
+  } else if (boost::algorithm::starts_with(name, "__builtin__approx__top__k__")) {
+    // the number of values to report follows the prefix
+    std::string str_k = name.substr(strlen("__builtin__approx__top__k__"));
+    size_t k = 0;
+    try {
+      k = std::stoul(str_k);
+    } catch (const std::exception&) {
+      log_and_throw("Unable to recognize the number of values in " + name);
+    }
+    auto top_k_operator = std::make_shared<groupby_operators::approx_top_k>();
+    top_k_operator->init(k);
+    return top_k_operator;
   } else if (boost::algorithm::starts_with(name, "__builtin__distinct__")) {
     return std::make_shared<groupby_operators::distinct>();
   } else if (boost::algorithm::starts_with(name, "__builtin__freq_count__")) {
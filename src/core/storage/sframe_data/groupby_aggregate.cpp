@@ -189,17 +189,23 @@ sframe groupby_aggregate(const sframe& source,
   auto input_reader = frame_with_relevant_cols.get_reader(thread::cpu_count());
   turi::timer ti;
   logstream(LOG_INFO) << "Filling group container: " << std::endl;
+  bool use_streams = SFRAME_GROUPBY_LOCAL_TABLE_SIZE > 0;
+  if (use_streams) container.init_streams(input_reader->num_segments());
   parallel_for (0, input_reader->num_segments(),
                 [&](size_t i) {
-                  container.init_tls();
+                  if (!use_streams) container.init_tls();
                   auto iter = input_reader->begin(i);
                   auto enditer = input_reader->end(i);
                   while(iter != enditer) {
                     auto& row = *iter;
-                    container.add(row, num_keys);
+                    if (use_streams) {
+                      container.add_to_stream(row, num_keys, i);
+                    } else {
+                      container.add(row, num_keys);
+                    }
                     ++iter;
                   }
-                  container.flush_tls();
+                  if (!use_streams) container.flush_tls();
                 });
 
   logstream(LOG_INFO) << "Group container filled in " << ti.current_time() << std::endl;
@@ -13,6 +13,8 @@
 #include <core/util/cityhash_tc.hpp>
 #include <core/util/fs_util.hpp>
 #include <core/storage/sframe_data/groupby_aggregate.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
+#include <core/globals/metrics.hpp>
 
 namespace turi {
 namespace groupby_aggregate_impl {
@@ -290,80 +292,70 @@ void group_aggregate_container::flush_tls() {
   tss_.segments_.clear();
 }
 
-void group_aggregate_container::add(const std::vector<flexible_type>& val,
-                                    size_t num_keys) {
-  throw_if_not_initialized();
+size_t group_aggregate_container::segment_of(size_t hash) const {
+  // the low bits are left to the hash tables
+  return ((hash >> 32) * num_segments) >> 32;
+}
 
-  size_t hash = groupby_element::hash_key(val, num_keys);
-  size_t target_segment = hash % num_segments;
-  // acquire lock on the segment
-  // look for the id in the group_keys structure
-  auto& segments = tss_.segments_;
-  auto& groupby_element_vec_ptr = segments[target_segment].elements_[hash];
+template <typename T>
+bool group_aggregate_container::add_to_table(segment_information& table,
+                                             size_t hash,
+                                             const T& val,
+                                             size_t num_keys) {
+  auto& groupby_element_vec_ptr = table.elements_[hash];
   if (groupby_element_vec_ptr == NULL)
     groupby_element_vec_ptr = new std::vector<groupby_element>;
   // note. not auto&. This needs to take a real value (pointer) and not a
   // reference since the auto& will make it really a reference to a pointer to
   // a vector<groupby_element> which will make it not robust to array resizes.
   auto groupby_element_vec = groupby_element_vec_ptr;
+
   for (size_t i = 0; i < groupby_element_vec->size(); ++i) {
     if (flexible_type_vector_equality((*groupby_element_vec)[i].key,
                                       (*groupby_element_vec)[i].key.size(), val,
                                       num_keys)) {
       (*groupby_element_vec)[i].add_element(val, group_descriptors);
-      if (segments[target_segment].elements_.size() >= max_buffer_size) {
-        flush_segment(target_segment);
-      }
-      return;
+      return false;
     }
   }
 
-  // element not found
-  groupby_element_vec->push_back(groupby_element{
-      std::vector<flexible_type>(val.begin(), val.begin() + num_keys),
-      group_descriptors});
+  std::vector<flexible_type> keys;
+  keys.reserve(num_keys);
+  for (size_t i = 0; i < num_keys; ++i) keys.push_back(val[i]);
+
+  groupby_element_vec->push_back(
+      groupby_element{std::move(keys), group_descriptors});
+
   (*groupby_element_vec)[groupby_element_vec->size() - 1].add_element(
       val, group_descriptors);
+  return true;
 }
 
-/* using thread_local for optimization */
-void group_aggregate_container::add(const sframe_rows::row& val,
+void group_aggregate_container::add(const std::vector<flexible_type>& val,
                                     size_t num_keys) {
   throw_if_not_initialized();
 
   size_t hash = groupby_element::hash_key(val, num_keys);
-  size_t target_segment = hash % num_segments;
-
+  size_t target_segment = segment_of(hash);
   auto& segments = tss_.segments_;
-  auto& groupby_element_vec_ptr = segments[target_segment].elements_[hash];
-  if (groupby_element_vec_ptr == NULL)
-    groupby_element_vec_ptr = new std::vector<groupby_element>;
-  // note. not auto&. This needs to take a real value (pointer) and not a
-  // reference since the auto& will make it really a reference to a pointer to
-  // a vector<groupby_element> which will make it not robust to array resizes.
-  auto groupby_element_vec = groupby_element_vec_ptr;
-
-  for (size_t i = 0; i < groupby_element_vec->size(); ++i) {
-    if (flexible_type_vector_equality((*groupby_element_vec)[i].key,
-                                      (*groupby_element_vec)[i].key.size(), val,
-                                      num_keys)) {
-      (*groupby_element_vec)[i].add_element(val, group_descriptors);
-      if (segments[target_segment].elements_.size() >= max_buffer_size) {
-        flush_segment(target_segment);
-      }
-      return;
-    }
+  if (!add_to_table(segments[target_segment], hash, val, num_keys) &&
+      segments[target_segment].elements_.size() >= max_buffer_size) {
+    flush_segment(target_segment);
   }
+}
 
-  std::vector<flexible_type> keys;
-  keys.reserve(num_keys);
-  for (size_t i = 0; i < num_keys; ++i) keys.push_back(val[i]);
-
-  groupby_element_vec->push_back(
-      groupby_element{std::move(keys), group_descriptors});
+/* using thread_local for optimization */
+void group_aggregate_container::add(const sframe_rows::row& val,
+                                    size_t num_keys) {
+  throw_if_not_initialized();
 
-  (*groupby_element_vec)[groupby_element_vec->size() - 1].add_element(
-      val, group_descriptors);
+  size_t hash = groupby_element::hash_key(val, num_keys);
+  size_t target_segment = segment_of(hash);
+  auto& segments = tss_.segments_;
+  if (!add_to_table(segments[target_segment], hash, val, num_keys) &&
+      segments[target_segment].elements_.size() >= max_buffer_size) {
+    flush_segment(target_segment);
+  }
 }
 
 void group_aggregate_container::flush_segment(size_t segmentid) {
@@ -401,6 +393,11 @@ void group_aggregate_container::flush_segment(size_t segmentid) {
       value->partial_finalize();
     }
   }
+  write_chunk(local_sorted, segmentid);
+}
+
+void group_aggregate_container::write_chunk(
+    const std::vector<groupby_element>& local_sorted, size_t segmentid) {
   // ok. now we can write! lock the file
   size_t round_robin = (++merry_go_round_) % local_buffer_set_.size();
 
@@ -412,12 +409,14 @@ void group_aggregate_container::flush_segment(size_t segmentid) {
     std::lock_guard<turi::simple_spinlock> slk(
         local_buffer.sa_seg_locks_[segmentid]);
 
-    logstream(LOG_INFO) << "flush buffer from task_id: " << tss_.id_
-                        << ", segment_id: " << segmentid
+    logstream(LOG_INFO) << "flush buffer of segment_id: " << segmentid
                         << ", on buffer: " << round_robin << std::endl;
 
     auto outiter = local_buffer.sa_buffer_ptr_->get_output_iterator(segmentid);
 
+    static metrics::counter& groupby_spill_bytes = metrics::get_counter(
+        "groupby_spill_bytes", "Bytes of partial aggregates written to disk by groupbys.");
+    size_t spilled = 0;
     std::vector<char> buffer;
     for (auto& item : local_sorted) {
       buffer.clear();
@@ -425,13 +424,138 @@ void group_aggregate_container::flush_segment(size_t segmentid) {
       out << item;
       *(outiter) = std::string(buffer.data(), buffer.size());
       ++(outiter);
+      spilled += buffer.size();
     }
+    groupby_spill_bytes += spilled;
 
     local_buffer.sa_seg_chunks_[segmentid].push_back(local_sorted.size());
   }
   local_buffer.refctr_--;
 }
 
+/**
+ * Sorts elements, combining the elements with equal keys.
+ */
+static void sort_and_combine(std::vector<groupby_element>& elements) {
+  std::sort(elements.begin(), elements.end());
+  size_t num_unique = 0;
+  for (size_t i = 0; i < elements.size(); ++i) {
+    if (num_unique > 0 && elements[num_unique - 1] == elements[i]) {
+      elements[num_unique - 1] += elements[i];
+    } else {
+      if (num_unique != i) elements[num_unique] = std::move(elements[i]);
+      ++num_unique;
+    }
+  }
+  elements.resize(num_unique);
+}
+
+void group_aggregate_container::init_streams(size_t num_streams) {
+  ASSERT_GT(num_streams, 0);
+  // The tables of a stream are allocated by the thread adding to it, on its
+  // NUMA node.
+  streams_.clear();
+  streams_.resize(num_streams);
+  stream_budget_ = std::max<size_t>(max_buffer_size / num_streams, 1);
+  local_table_size_ = std::max<size_t>(
+      std::min<size_t>(SFRAME_GROUPBY_LOCAL_TABLE_SIZE, stream_budget_), 1);
+  num_spilled_chunks_ = std::vector<turi::atomic<size_t>>(num_segments);
+}
+
+template <typename T>
+void group_aggregate_container::add_to_stream_impl(const T& val,
+                                                   size_t num_keys,
+                                                   size_t stream_id) {
+  DASSERT_LT(stream_id, streams_.size());
+  if (streams_[stream_id] == nullptr) {
+    streams_[stream_id].reset(new stream_table);
+    streams_[stream_id]->segments_.resize(num_segments);
+  }
+  stream_table& stream = *streams_[stream_id];
+  size_t hash = groupby_element::hash_key(val, num_keys);
+  if (add_to_table(stream.local_, hash, val, num_keys) &&
+      ++stream.local_size_ >= local_table_size_) {
+    evict_local_table(stream);
+    reduce_buffered(stream);
+  }
+}
+
+void group_aggregate_container::add_to_stream(const std::vector<flexible_type>& val,
+                                              size_t num_keys,
+                                              size_t stream_id) {
+  add_to_stream_impl(val, num_keys, stream_id);
+}
+
+void group_aggregate_container::add_to_stream(const sframe_rows::row& val,
+                                              size_t num_keys,
+                                              size_t stream_id) {
+  add_to_stream_impl(val, num_keys, stream_id);
+}
+
+void group_aggregate_container::evict_local_table(stream_table& stream) {
+  for (auto& hash_entries : stream.local_.elements_) {
+    for (auto& item : *hash_entries.second) {
+      for (auto& value : item.values) {
+        value->partial_finalize();
+      }
+      stream.segments_[segment_of(item.hash())].push_back(std::move(item));
+    }
+    delete hash_entries.second;
+  }
+  stream.local_.elements_.clear();
+  stream.num_buffered_ += stream.local_size_;
+  stream.local_size_ = 0;
+}
+
+void group_aggregate_container::reduce_buffered(stream_table& stream) {
+  while (stream.num_buffered_ > stream_budget_) {
+    size_t largest = 0;
+    for (size_t i = 1; i < num_segments; ++i) {
+      if (stream.segments_[i].size() > stream.segments_[largest].size()) {
+        largest = i;
+      }
+    }
+    auto& elements = stream.segments_[largest];
+    size_t original_size = elements.size();
+    sort_and_combine(elements);
+    stream.num_buffered_ -= original_size - elements.size();
+    // keep the segment in memory if it had enough repeated keys
+    if (elements.size() <= original_size / 2) continue;
+
+    write_chunk(elements, largest);
+    num_spilled_chunks_[largest].inc();
+    stream.num_buffered_ -= elements.size();
+    std::vector<groupby_element>().swap(elements);
+  }
+}
+
+std::vector<groupby_element> group_aggregate_container::gather_segment(
+    size_t segmentid) {
+  size_t total = 0;
+  for (auto& stream : streams_) {
+    if (stream != nullptr) total += stream->segments_[segmentid].size();
+  }
+  std::vector<groupby_element> ret;
+  ret.reserve(total);
+  for (auto& stream : streams_) {
+    if (stream == nullptr) continue;
+    auto& elements = stream->segments_[segmentid];
+    std::move(elements.begin(), elements.end(), std::back_inserter(ret));
+    std::vector<groupby_element>().swap(elements);
+  }
+  sort_and_combine(ret);
+  return ret;
+}
+
+/// Fills out with the keys and the aggregated values of a group.
+static void emit_group(const groupby_element& cur, std::vector<flexible_type>& out) {
+  out.resize(cur.key.size() + cur.values.size());
+  for (size_t i = 0; i < cur.key.size(); ++i) out[i] = cur.key[i];
+  for (size_t i = 0; i < cur.values.size(); ++i) {
+    out[i + cur.key.size()] = cur.values[i]->emit();
+  }
+}
+
 void group_aggregate_container::merge_local_buffer_set() {
   ASSERT_MSG(
       UNLIKELY(!gl_buffer_.is_opened_for_write()),
@@ -514,6 +638,18 @@ void group_aggregate_container::group_and_write(sframe& out) {
   ASSERT_MSG(UNLIKELY(!tss_.init_),
              "call flush_tls fisrt before write out groupby result");
 
+  if (!streams_.empty()) {
+    parallel_for(0, streams_.size(), [&](size_t i) {
+      if (streams_[i] != nullptr) evict_local_table(*streams_[i]);
+    });
+    // segments which are partly on disk are merged on disk
+    parallel_for(0, num_segments, [&](size_t i) {
+      if (num_spilled_chunks_[i].value > 0) {
+        write_chunk(gather_segment(i), i);
+      }
+    });
+  }
+
   merge_local_buffer_set();
 
   if (gl_buffer_.is_opened_for_write()) gl_buffer_.close();
@@ -528,8 +664,20 @@ void group_aggregate_container::group_and_write(sframe& out) {
   logstream(LOG_INFO) << std::endl;
 
   parallel_for(0, reader->num_segments(), [&](size_t i) {
-    this->group_and_write_segment(out, reader, i);
+    if (streams_.empty() || num_spilled_chunks_[i].value > 0) {
+      this->group_and_write_segment(out, reader, i);
+    } else {
+      // the segment never left memory
+      auto outiter = out.get_output_iterator(i);
+      std::vector<flexible_type> emission_vector;
+      for (const auto& cur : gather_segment(i)) {
+        emit_group(cur, emission_vector);
+        *outiter = emission_vector;
+        ++outiter;
+      }
+    }
   });
+  streams_.clear();
 }
 
 void group_aggregate_container::group_and_write_segment(
@@ -611,15 +759,100 @@ void group_aggregate_container::group_and_write_segment(
     }
 
     // emit
-    emission_vector.resize(cur.key.size() + cur.values.size());
-    for (size_t i = 0; i < cur.key.size(); ++i) emission_vector[i] = cur.key[i];
-    for (size_t i = 0; i < cur.values.size(); ++i) {
-      emission_vector[i + cur.key.size()] = cur.values[i]->emit();
-    }
+    emit_group(cur, emission_vector);
     *outiter = emission_vector;
     ++outiter;
   }
 }
 
+sorted_group_aggregator::sorted_group_aggregator(sframe& out,
+                                                 size_t num_segments)
+    : out(out), segments(num_segments) {
+  ASSERT_EQ(out.num_segments(), num_segments);
+  for (size_t i = 0; i < num_segments; ++i) {
+    segments[i].out = out.get_output_iterator(i);
+  }
+}
+
+void sorted_group_aggregator::define_group(
+    std::vector<size_t> column_numbers,
+    std::shared_ptr<group_aggregate_value> aggregator) {
+  group_descriptor desc;
+  desc.column_numbers = column_numbers;
+  desc.aggregator = aggregator;
+  group_descriptors.push_back(desc);
+}
+
+void sorted_group_aggregator::write_group(groupby_element& group,
+                                          size_t segmentid) {
+  std::vector<flexible_type> emission_vector;
+  emit_group(group, emission_vector);
+  auto& outiter = segments[segmentid].out;
+  *outiter = emission_vector;
+  ++outiter;
+}
+
+void sorted_group_aggregator::add(const sframe_rows::row& val,
+                                  size_t num_keys,
+                                  size_t segmentid) {
+  auto& segment = segments[segmentid];
+  auto& current = segment.current;
+  if (current == nullptr ||
+      !flexible_type_vector_equality(current->key, current->key.size(),
+                                     val, num_keys)) {
+    if (current != nullptr) {
+      for (auto& value : current->values) value->partial_finalize();
+      // the group is complete, unless it may have begun in an earlier segment
+      if (segment.current_is_first && segmentid > 0) {
+        segment.first = std::move(current);
+      } else {
+        write_group(*current, segmentid);
+      }
+      segment.current_is_first = false;
+    }
+    std::vector<flexible_type> keys;
+    keys.reserve(num_keys);
+    for (size_t i = 0; i < num_keys; ++i) keys.push_back(val[i]);
+    current.reset(new groupby_element(std::move(keys), group_descriptors));
+  }
+  current->add_element(val, group_descriptors);
+}
+
+void sorted_group_aggregator::write_boundary_groups() {
+  // A group still open at the end of a segment, and the segment it was
+  // last seen in. The boundary groups left of segment s are written at the
+  // end of output segment s - 1, after everything that precedes them.
+  std::unique_ptr<groupby_element> carry;
+  auto merge_or_write = [&](std::unique_ptr<groupby_element>& group,
+                            size_t segmentid) {
+    if (carry != nullptr &&
+        flexible_type_vector_equality(carry->key, group->key)) {
+      *carry += *group;
+    } else {
+      if (carry != nullptr) write_group(*carry, segmentid - 1);
+      carry = std::move(group);
+    }
+  };
+  for (size_t s = 0; s < segments.size(); ++s) {
+    auto& segment = segments[s];
+    if (segment.current == nullptr) continue;
+    for (auto& value : segment.current->values) value->partial_finalize();
+    if (segment.first != nullptr) {
+      // the first group ends in this segment
+      merge_or_write(segment.first, s);
+      write_group(*carry, s - 1);
+      carry.reset();
+    }
+    if (s > 0 && segment.current_is_first) {
+      // the whole segment is one group, which may continue on either side
+      merge_or_write(segment.current, s);
+    } else {
+      if (carry != nullptr) write_group(*carry, s - 1);
+      carry = std::move(segment.current);
+    }
+  }
+  if (carry != nullptr) write_group(*carry, segments.size() - 1);
+}
+
 }  // namespace groupby_aggregate_impl
 }  // namespace turi
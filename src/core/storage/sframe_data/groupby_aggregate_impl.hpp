@@ -192,6 +192,17 @@ namespace groupby_aggregate_impl {
  *
  * Then when \ref group_and_write is called, a k-way merge is performed across
  * all the sorted ranges of keys on disk to write the final output.
+ *
+ * Alternatively, after \ref init_streams, rows are added to one of a fixed
+ * number of input streams with \ref add_to_stream (radix partitioned
+ * aggregation). Each stream first aggregates into a small table of at
+ * most SFRAME_GROUPBY_LOCAL_TABLE_SIZE groups, which stays in cache. When
+ * it fills up, its groups are moved out into per-segment buffers of the
+ * stream, by the high bits of their hash. Only when a stream buffers more
+ * than its share of max_buffer_size groups is its largest segment buffer
+ * compacted, and if that does not help, written to disk. In the end, every
+ * segment is merged independently of the others: in memory if none of it
+ * was written to disk, and by the k-way merge above otherwise.
  */
 class group_aggregate_container {
 
@@ -224,6 +235,26 @@ class group_aggregate_container {
   void add(const sframe_rows::row& val,
             size_t num_keys);
 
+   /**
+    * Switches to radix partitioned aggregation over num_streams input
+    * streams. Must be called before any row is added.
+    */
+   void init_streams(size_t num_streams);
+
+   /**
+    * Adds a row to input stream stream_id. Rows of a stream must be added by
+    * one thread at a time, but different streams may be added to
+    * concurrently. init_tls() is not needed.
+    */
+   void add_to_stream(const std::vector<flexible_type>& val,
+                      size_t num_keys,
+                      size_t stream_id);
+
+   /// Adds a row to input stream stream_id.
+   void add_to_stream(const sframe_rows::row& val,
+                      size_t num_keys,
+                      size_t stream_id);
+
    /// Sort all elements in the container and writes to the output.
    void group_and_write(sframe& out);
 
@@ -241,6 +272,11 @@ class group_aggregate_container {
 
    /// Writes the content into the sarray segment backend.
    void flush_segment(size_t segmentid);
+   /**
+    * Writes sorted, partially finalized elements as a new chunk of a
+    * segment of the local buffers.
+    */
+   void write_chunk(const std::vector<groupby_element>& sorted, size_t segmentid);
    /// merge all local buffers into global buffer
    void merge_local_buffer_set();
 
@@ -260,6 +296,40 @@ class group_aggregate_container {
    using vec_segment_t = std::vector<segment_information>;
    using vec_chunk_t = std::vector<size_t>;
 
+   /// Adds a row to a table. Returns true if it is a new group.
+   template <typename T>
+   bool add_to_table(segment_information& table, size_t hash,
+                     const T& val, size_t num_keys);
+
+   /// Returns the segment of a key hash. Uses the high bits of the hash.
+   size_t segment_of(size_t hash) const;
+
+   /// The state of an input stream of radix partitioned aggregation
+   struct stream_table {
+     /// The small table rows are first aggregated into
+     segment_information local_;
+     size_t local_size_ = 0;
+     /// Partially finalized groups moved out of local_, by segment
+     std::vector<std::vector<groupby_element>> segments_;
+     size_t num_buffered_ = 0;
+   };
+
+   template <typename T>
+   void add_to_stream_impl(const T& val, size_t num_keys, size_t stream_id);
+   /// Moves the groups of the small table of a stream into its segments.
+   void evict_local_table(stream_table& stream);
+   /// Sends segments of a stream to disk until it is within its budget.
+   void reduce_buffered(stream_table& stream);
+   /// Gathers the groups of a segment from all streams, combined and sorted.
+   std::vector<groupby_element> gather_segment(size_t segmentid);
+
+   std::vector<std::unique_ptr<stream_table>> streams_;
+   /// The number of groups each stream may buffer in memory
+   size_t stream_budget_ = 0;
+   size_t local_table_size_ = 0;
+   /// The number of chunks written to disk for each segment
+   std::vector<turi::atomic<size_t>> num_spilled_chunks_;
+
    struct tls_segment_set {
      size_t id_ = 0;
      bool init_{false};
@@ -309,6 +379,74 @@ class group_aggregate_container {
 };
 
 
+/**
+ * Aggregates input in which all the rows of a group are contiguous, for
+ * instance because it is sorted on the keys.
+ *
+ * Every input segment is aggregated in order, holding only the group it is
+ * currently in: each time the key changes the group is complete and written
+ * straight to the same segment of the output. There is no hash table and
+ * nothing is ever written to disk.
+ *
+ * A group may span several segments, so the first group of every segment but
+ * the first, and the last group of every segment, are held back. After all
+ * the rows are added, \ref write_boundary_groups combines them across the
+ * segment boundaries and writes them out. The output is ordered as the input.
+ *
+ * If the rows of a group are not contiguous, the group appears several times
+ * in the output.
+ */
+class sorted_group_aggregator {
+ public:
+  /**
+   * \param out The output sframe, opened for write with num_segments
+   *            segments, one for every input segment.
+   * \param num_segments The number of input segments
+   */
+  sorted_group_aggregator(sframe& out, size_t num_segments);
+
+  /// Deleted copy constructor
+  sorted_group_aggregator(const sorted_group_aggregator& other) = delete;
+
+  /// Deleted assignment operator
+  sorted_group_aggregator& operator=(const sorted_group_aggregator& other) = delete;
+
+  /**
+   * Adds a new group operation which groups the values of a column
+   */
+  void define_group(std::vector<size_t> column_numbers,
+                    std::shared_ptr<group_aggregate_value> aggregator);
+
+  /**
+   * Adds the next row of an input segment. Rows of a segment must be added
+   * in order, by one thread at a time, but different segments may be added
+   * to concurrently.
+   */
+  void add(const sframe_rows::row& val, size_t num_keys, size_t segmentid);
+
+  /// Writes the groups held back at the segment boundaries.
+  void write_boundary_groups();
+
+ private:
+  struct segment_state {
+    /// The first group of the segment, once it is complete
+    std::unique_ptr<groupby_element> first;
+    /// The group of the last row added
+    std::unique_ptr<groupby_element> current;
+    /// Whether current is the first group of the segment
+    bool current_is_first = true;
+    sframe::iterator out;
+  };
+
+  /// Writes a complete, partially finalized group to an output segment
+  void write_group(groupby_element& group, size_t segmentid);
+
+  sframe& out;
+  std::vector<group_descriptor> group_descriptors;
+  std::vector<segment_state> segments;
+};
+
+
 } // namespace groupby_aggregate_impl
 
 /// \}
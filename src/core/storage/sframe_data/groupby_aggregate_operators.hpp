@@ -7,6 +7,8 @@
 #define TURI_SFRAME_GROUPBY_AGGREGATE_OPERATORS_HPP
 #include <core/storage/sframe_data/group_aggregate_value.hpp>
 #include <ml/sketches/streaming_quantile_sketch.hpp>
+#include <ml/sketches/hyperloglog.hpp>
+#include <ml/sketches/space_saving_flextype.hpp>
 namespace turi {
 
 
@@ -1304,6 +1306,151 @@ class distinct: public count_distinct {
 
 };
 
+/**
+ * Implements an aggregator that estimates the number of unique elements with
+ * a hyperloglog sketch of 2^12 buckets (about 1.6% relative error). Groups
+ * with few unique elements only keep a small sparse sketch, and are counted
+ * almost exactly.
+ */
+class approx_count_distinct: public group_aggregate_value {
+ public:
+  static constexpr size_t HYPERLOGLOG_BITS = 12;
+
+  /// Returns a new empty instance of approx_count_distinct
+  group_aggregate_value* new_instance() const {
+    approx_count_distinct* ret = new approx_count_distinct;
+    return ret;
+  }
+
+  void add_element_simple(const flexible_type& flex) {
+    m_sketch.add(flex);
+  }
+
+  /// combines two partial sketches
+  void combine(const group_aggregate_value& other) {
+    auto& v = dynamic_cast<const approx_count_distinct&>(other);
+    m_sketch.combine(v.m_sketch);
+  }
+
+  /// Emits the estimate, rounded to the nearest integer
+  flexible_type emit() const {
+    return flex_int(std::llround(m_sketch.estimate()));
+  }
+
+  /// All types are supported
+  bool support_type(flex_type_enum type) const {
+    return true;
+  }
+
+  flex_type_enum set_input_type(flex_type_enum type) {
+    return flex_type_enum::INTEGER;
+  }
+
+  /// Name of the class
+  std::string name() const {
+    return "Approximate Count Distinct";
+  }
+
+  /// Serializer
+  void save(oarchive& oarc) const {
+    oarc << m_sketch;
+  }
+
+  /// Deserializer
+  void load(iarchive& iarc) {
+    iarc >> m_sketch;
+  }
+
+ private:
+  sketches::hyperloglog m_sketch{HYPERLOGLOG_BITS};
+};
+
+/**
+ * Implements an aggregator that estimates the k most frequent values of a
+ * group with a space saving sketch. The sketch tracks TRACKED_VALUES_PER_K
+ * values per requested value, so its memory is bounded by k and not by the
+ * size of the group. Emits a dictionary from each of the (at most) k values
+ * to its estimated count, which may be an overestimate. Missing values are
+ * not counted.
+ */
+class approx_top_k: public group_aggregate_value {
+ public:
+  static constexpr size_t TRACKED_VALUES_PER_K = 10;
+
+  /**
+   * Used to initialize the operator with the number of values to report.
+   */
+  void init(size_t k) {
+    if (k == 0) log_and_throw("The number of values to report must be positive.");
+    m_k = k;
+    m_sketch = sketches::space_saving_flextype(
+        1.0 / double(TRACKED_VALUES_PER_K * k));
+  }
+
+  /** Returns a new empty instance of approx_top_k with the same k
+   */
+  group_aggregate_value* new_instance() const {
+    approx_top_k* ret = new approx_top_k;
+    ret->init(m_k);
+    return ret;
+  }
+
+  void add_element_simple(const flexible_type& flex) {
+    m_sketch.add(flex);
+  }
+
+  /// combines two partial sketches
+  void combine(const group_aggregate_value& other) {
+    auto& v = dynamic_cast<const approx_top_k&>(other);
+    m_sketch.combine(v.m_sketch);
+  }
+
+  /// Emits the top values, most frequent first
+  flexible_type emit() const {
+    auto items = m_sketch.frequent_items();
+    size_t n = std::min(m_k, items.size());
+    std::partial_sort(items.begin(), items.begin() + n, items.end(),
+                      [](const std::pair<flexible_type, size_t>& a,
+                         const std::pair<flexible_type, size_t>& b) {
+                        return a.second > b.second;
+                      });
+    flex_dict ret(n);
+    for (size_t i = 0; i < n; ++i) {
+      ret[i] = {items[i].first, flex_int(items[i].second)};
+    }
+    return ret;
+  }
+
+  /// All types are supported
+  bool support_type(flex_type_enum type) const {
+    return true;
+  }
+
+  flex_type_enum set_input_type(flex_type_enum type) {
+    return flex_type_enum::DICT;
+  }
+
+  /// Name of the class
+  std::string name() const {
+    return "Approximate Top K";
+  }
+
+  /// Serializer
+  void save(oarchive& oarc) const {
+    oarc << m_k << m_sketch;
+  }
+
+  /// Deserializer
+  void load(iarchive& iarc) {
+    iarc >> m_k >> m_sketch;
+  }
+
+ private:
+  size_t m_k = 10;
+  mutable sketches::space_saving_flextype m_sketch{
+      1.0 / double(TRACKED_VALUES_PER_K * 10)};
+};
+
 /**
  * Implements an aggregator that computes frequncies for each unique value.
  */
@@ -11,6 +11,7 @@
 #include <core/logging/logger.hpp>
 #include <core/logging/assertions.hpp>
 #include <core/storage/sframe_data/integer_pack_impl.hpp>
+#include <core/storage/sframe_data/integer_pack_simd.hpp>
 #include <core/util/bitops.hpp>
 
 namespace turi {
@@ -422,6 +423,9 @@ void frame_of_reference_encode_128(const uint64_t* input,
 /**
  * Performs a group decode of a collection of up to 128 64-bit numbers.
  * See \ref frame_of_reference_encode_128() for the encoding details.
+ *
+ * The bit unpacking is performed by \ref unpack_block() which uses
+ * vector instructions when the CPU supports them.
  */
 template <typename InArcType>
 void frame_of_reference_decode_128(InArcType& iarc,
@@ -458,28 +462,13 @@ void frame_of_reference_decode_128(InArcType& iarc,
   size_t nbytes_to_read = (nbits_to_read + 7) / 8;
   switch(nbits) {
    case 1:
-    iarc.read((char*)pack, nbytes_to_read);
-    unpack_1(pack, len, output);
-    break;
    case 2:
-    iarc.read((char*)pack, nbytes_to_read);
-    unpack_2(pack, len, output);
-    break;
    case 4:
-    iarc.read((char*)pack, nbytes_to_read);
-    unpack_4(pack, len, output);
-    break;
    case 8:
-    iarc.read((char*)pack, nbytes_to_read);
-    unpack_8(pack, len, output);
-    break;
    case 16:
-    iarc.read((char*)pack, nbytes_to_read);
-    unpack_16((uint16_t*)pack, len, output);
-    break;
    case 32:
     iarc.read((char*)pack, nbytes_to_read);
-    unpack_32((uint32_t*)pack, len, output);
+    unpack_block(nbits, pack, len, output);
     break;
    case 64:
     iarc.read((char*)output, sizeof(uint64_t)*len);
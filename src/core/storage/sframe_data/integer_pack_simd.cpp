@@ -0,0 +1,294 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <cstring>
+#include <core/logging/assertions.hpp>
+#include <core/storage/sframe_data/integer_pack_impl.hpp>
+#include <core/storage/sframe_data/integer_pack_simd.hpp>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define TURI_INTEGER_PACK_HAS_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define TURI_INTEGER_PACK_HAS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace turi {
+namespace integer_pack {
+
+namespace {
+
+typedef void (*unpack_fn)(unsigned char, const uint8_t*, size_t, uint64_t*);
+
+/**
+ * The sub-byte packings (1, 2 and 4 bits) store the first
+ * (nout_values % (8 / nbits)) values in the most significant bits of the
+ * first byte. After that the values form a continuous little-endian bit
+ * stream: value j lives at bit position j * nbits.
+ *
+ * This decodes that leading partial byte, and returns the number of values
+ * remaining in the bit stream. src and out are advanced past the values
+ * consumed.
+ */
+inline size_t unpack_partial_head(unsigned char nbits,
+                                  const uint8_t*& src,
+                                  size_t nout_values,
+                                  uint64_t*& out) {
+  size_t values_per_byte = 8 / nbits;
+  size_t head = nout_values % values_per_byte;
+  if (head) {
+    const uint8_t mask = (1 << nbits) - 1;
+    uint8_t c = (*src++) >> (8 - head * nbits);
+    for (size_t i = 0; i < head; ++i) {
+      (*out++) = c & mask;
+      c >>= nbits;
+    }
+  }
+  return nout_values - head;
+}
+
+/**
+ * Decodes the last few values of a sub-byte bit stream one at a time.
+ */
+inline void unpack_stream_tail(unsigned char nbits,
+                               const uint8_t* src,
+                               size_t nout_values,
+                               uint64_t* out) {
+  const uint8_t mask = (1 << nbits) - 1;
+  for (size_t i = 0; i < nout_values; ++i) {
+    size_t bitpos = i * nbits;
+    out[i] = (src[bitpos >> 3] >> (bitpos & 7)) & mask;
+  }
+}
+
+template <typename T>
+inline void unpack_widen_tail(const uint8_t* src, size_t nout_values, uint64_t* out) {
+  for (size_t i = 0; i < nout_values; ++i) {
+    T val;
+    std::memcpy(&val, src + i * sizeof(T), sizeof(T));
+    out[i] = val;
+  }
+}
+
+#ifdef TURI_INTEGER_PACK_HAS_AVX2
+
+__attribute__((target("avx2")))
+void unpack_avx2(unsigned char nbits,
+                 const uint8_t* src,
+                 size_t nout_values,
+                 uint64_t* out) {
+  switch(nbits) {
+   case 1:
+   case 2:
+   case 4: {
+    size_t n = unpack_partial_head(nbits, src, nout_values, out);
+    // 8 values at a time. This consumes exactly nbits bytes of input.
+    const __m256i mask = _mm256_set1_epi64x((1 << nbits) - 1);
+    const __m256i shift_lo = _mm256_setr_epi64x(0, nbits, 2 * nbits, 3 * nbits);
+    const __m256i shift_hi = _mm256_setr_epi64x(4 * nbits, 5 * nbits,
+                                                6 * nbits, 7 * nbits);
+    while (n >= 8) {
+      uint32_t word = 0;
+      std::memcpy(&word, src, nbits);
+      __m256i v = _mm256_set1_epi64x(word);
+      _mm256_storeu_si256((__m256i*)(out),
+                          _mm256_and_si256(_mm256_srlv_epi64(v, shift_lo), mask));
+      _mm256_storeu_si256((__m256i*)(out + 4),
+                          _mm256_and_si256(_mm256_srlv_epi64(v, shift_hi), mask));
+      src += nbits;
+      out += 8;
+      n -= 8;
+    }
+    unpack_stream_tail(nbits, src, n, out);
+    break;
+   }
+   case 8: {
+    size_t i = 0;
+    for (; i + 4 <= nout_values; i += 4) {
+      int32_t word;
+      std::memcpy(&word, src + i, sizeof(word));
+      _mm256_storeu_si256((__m256i*)(out + i),
+                          _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(word)));
+    }
+    unpack_widen_tail<uint8_t>(src + i, nout_values - i, out + i);
+    break;
+   }
+   case 16: {
+    size_t i = 0;
+    for (; i + 4 <= nout_values; i += 4) {
+      __m128i v = _mm_loadl_epi64((const __m128i*)(src + 2 * i));
+      _mm256_storeu_si256((__m256i*)(out + i), _mm256_cvtepu16_epi64(v));
+    }
+    unpack_widen_tail<uint16_t>(src + 2 * i, nout_values - i, out + i);
+    break;
+   }
+   case 32: {
+    size_t i = 0;
+    for (; i + 4 <= nout_values; i += 4) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(src + 4 * i));
+      _mm256_storeu_si256((__m256i*)(out + i), _mm256_cvtepu32_epi64(v));
+    }
+    unpack_widen_tail<uint32_t>(src + 4 * i, nout_values - i, out + i);
+    break;
+   }
+   default:
+    ASSERT_TRUE(false);
+    __builtin_unreachable();
+  }
+}
+
+#endif
+
+#ifdef TURI_INTEGER_PACK_HAS_NEON
+
+void unpack_neon(unsigned char nbits,
+                 const uint8_t* src,
+                 size_t nout_values,
+                 uint64_t* out) {
+  switch(nbits) {
+   case 1:
+   case 2:
+   case 4: {
+    size_t n = unpack_partial_head(nbits, src, nout_values, out);
+    // NEON shifts right by shifting left with a negative amount
+    const int64_t b = nbits;
+    const int64_t shift_values[8] = {0, -b, -2 * b, -3 * b,
+                                     -4 * b, -5 * b, -6 * b, -7 * b};
+    const int64x2_t shift0 = vld1q_s64(shift_values);
+    const int64x2_t shift1 = vld1q_s64(shift_values + 2);
+    const int64x2_t shift2 = vld1q_s64(shift_values + 4);
+    const int64x2_t shift3 = vld1q_s64(shift_values + 6);
+    const uint64x2_t mask = vdupq_n_u64((1 << nbits) - 1);
+    while (n >= 8) {
+      uint32_t word = 0;
+      std::memcpy(&word, src, nbits);
+      uint64x2_t v = vdupq_n_u64(word);
+      vst1q_u64(out,     vandq_u64(vshlq_u64(v, shift0), mask));
+      vst1q_u64(out + 2, vandq_u64(vshlq_u64(v, shift1), mask));
+      vst1q_u64(out + 4, vandq_u64(vshlq_u64(v, shift2), mask));
+      vst1q_u64(out + 6, vandq_u64(vshlq_u64(v, shift3), mask));
+      src += nbits;
+      out += 8;
+      n -= 8;
+    }
+    unpack_stream_tail(nbits, src, n, out);
+    break;
+   }
+   case 8: {
+    size_t i = 0;
+    for (; i + 8 <= nout_values; i += 8) {
+      uint16x8_t v16 = vmovl_u8(vld1_u8(src + i));
+      uint32x4_t lo = vmovl_u16(vget_low_u16(v16));
+      uint32x4_t hi = vmovl_u16(vget_high_u16(v16));
+      vst1q_u64(out + i,     vmovl_u32(vget_low_u32(lo)));
+      vst1q_u64(out + i + 2, vmovl_u32(vget_high_u32(lo)));
+      vst1q_u64(out + i + 4, vmovl_u32(vget_low_u32(hi)));
+      vst1q_u64(out + i + 6, vmovl_u32(vget_high_u32(hi)));
+    }
+    unpack_widen_tail<uint8_t>(src + i, nout_values - i, out + i);
+    break;
+   }
+   case 16: {
+    size_t i = 0;
+    for (; i + 4 <= nout_values; i += 4) {
+      uint16_t vals[4];
+      std::memcpy(vals, src + 2 * i, sizeof(vals));
+      uint32x4_t v32 = vmovl_u16(vld1_u16(vals));
+      vst1q_u64(out + i,     vmovl_u32(vget_low_u32(v32)));
+      vst1q_u64(out + i + 2, vmovl_u32(vget_high_u32(v32)));
+    }
+    unpack_widen_tail<uint16_t>(src + 2 * i, nout_values - i, out + i);
+    break;
+   }
+   case 32: {
+    size_t i = 0;
+    for (; i + 2 <= nout_values; i += 2) {
+      uint32_t vals[2];
+      std::memcpy(vals, src + 4 * i, sizeof(vals));
+      vst1q_u64(out + i, vmovl_u32(vld1_u32(vals)));
+    }
+    unpack_widen_tail<uint32_t>(src + 4 * i, nout_values - i, out + i);
+    break;
+   }
+   default:
+    ASSERT_TRUE(false);
+    __builtin_unreachable();
+  }
+}
+
+#endif
+
+unpack_fn select_unpack_implementation() {
+#ifdef TURI_INTEGER_PACK_HAS_AVX2
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return unpack_avx2;
+#endif
+#ifdef TURI_INTEGER_PACK_HAS_NEON
+  return unpack_neon;
+#endif
+  return unpack_block_scalar;
+}
+
+unpack_fn get_unpack_implementation() {
+  static const unpack_fn fn = select_unpack_implementation();
+  return fn;
+}
+
+} // anonymous namespace
+
+
+void unpack_block_scalar(unsigned char nbits,
+                         const uint8_t* src,
+                         size_t nout_values,
+                         uint64_t* out) {
+  switch(nbits) {
+   case 1:
+    unpack_1(src, nout_values, out);
+    break;
+   case 2:
+    unpack_2(src, nout_values, out);
+    break;
+   case 4:
+    unpack_4(src, nout_values, out);
+    break;
+   case 8:
+    unpack_8(src, nout_values, out);
+    break;
+   case 16:
+    unpack_16((const uint16_t*)src, nout_values, out);
+    break;
+   case 32:
+    unpack_32((const uint32_t*)src, nout_values, out);
+    break;
+   default:
+    ASSERT_TRUE(false);
+    __builtin_unreachable();
+  }
+}
+
+void unpack_block(unsigned char nbits,
+                  const uint8_t* src,
+                  size_t nout_values,
+                  uint64_t* out) {
+  if (nout_values == 0) return;
+  get_unpack_implementation()(nbits, src, nout_values, out);
+}
+
+const char* unpack_block_implementation() {
+  unpack_fn fn = get_unpack_implementation();
+#ifdef TURI_INTEGER_PACK_HAS_AVX2
+  if (fn == unpack_avx2) return "avx2";
+#endif
+#ifdef TURI_INTEGER_PACK_HAS_NEON
+  if (fn == unpack_neon) return "neon";
+#endif
+  return "scalar";
+}
+
+} // namespace integer_pack
+} // namespace turi
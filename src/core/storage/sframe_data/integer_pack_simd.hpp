@@ -0,0 +1,59 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_INTEGER_PACK_SIMD_HPP
+#define TURI_SFRAME_INTEGER_PACK_SIMD_HPP
+#include <cstdint>
+#include <cstddef>
+
+namespace turi {
+
+/**
+ * \ingroup sframe_physical
+ * \addtogroup Compression Integer Compression Routines
+ * \{
+ */
+
+/**
+ * \internal
+ * Integer Packing Routines
+ */
+namespace integer_pack {
+
+/**
+ * Unpacks a sequence of nout_values values of nbits each
+ * (nbits must be one of 1, 2, 4, 8, 16 or 32) from a buffer produced by the
+ * pack_1 ... pack_32 routines.
+ *
+ * The implementation is picked once at runtime: AVX2 on x86-64 processors
+ * which support it, NEON on ARM, and the scalar unpack_* routines otherwise.
+ * All implementations produce exactly the same output.
+ */
+void unpack_block(unsigned char nbits,
+                  const uint8_t* src,
+                  size_t nout_values,
+                  uint64_t* out);
+
+/**
+ * The scalar reference implementation of \ref unpack_block().
+ * Dispatches directly to the unpack_* routines in integer_pack_impl.hpp.
+ */
+void unpack_block_scalar(unsigned char nbits,
+                         const uint8_t* src,
+                         size_t nout_values,
+                         uint64_t* out);
+
+/**
+ * Returns the name of the implementation \ref unpack_block() dispatches to.
+ * One of "avx2", "neon" or "scalar".
+ */
+const char* unpack_block_implementation();
+
+} // namespace integer_pack
+
+/// \}
+} // namespace turi
+
+#endif
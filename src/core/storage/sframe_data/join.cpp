@@ -4,9 +4,13 @@
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
 #include <core/storage/sframe_data/join.hpp>
+#include <core/storage/fileio/memory_budget.hpp>
 
 namespace turi {
 
+/// Bytes of memory assumed for every cell in the join hash table.
+static constexpr size_t JOIN_CELL_SIZE_ESTIMATE = 64;
+
 sframe join(sframe& sf_left,
             sframe& sf_right,
             std::string join_type,
@@ -34,20 +38,20 @@ sframe join(sframe& sf_left,
   }
 
   // Figure out what join type we have to do
-  boost::algorithm::to_lower(join_type);
+  join_type_t in_join_type = join_impl::join_type_from_string(join_type);
 
-  join_type_t in_join_type;
-  if(join_type == "outer") {
-    in_join_type = FULL_JOIN;
-  } else if(join_type == "left") {
-    in_join_type = LEFT_JOIN;
-  } else if(join_type == "right") {
-    in_join_type = RIGHT_JOIN;
-  } else if(join_type == "inner") {
-    in_join_type = INNER_JOIN;
-  } else {
-    log_and_throw("Invalid join type given!");
-  }
+  // the hash table shares the memory budget with the caches and other
+  // operators: take what is free, down to a sixteenth of max_buffer_size.
+  // It never needs more than the smaller frame, which fits when it has
+  // fewer cells than the buffer.
+  size_t smaller_num_cells = std::min(sf_left.num_rows() * sf_left.num_columns(),
+                                      sf_right.num_rows() * sf_right.num_columns());
+  size_t buffer_num_cells = std::min(max_buffer_size, smaller_num_cells + 1);
+  fileio::memory_reservation buffer_memory;
+  buffer_num_cells = buffer_memory.reserve_up_to(
+      buffer_num_cells * JOIN_CELL_SIZE_ESTIMATE,
+      buffer_num_cells * JOIN_CELL_SIZE_ESTIMATE / 16) / JOIN_CELL_SIZE_ESTIMATE;
+  buffer_num_cells = std::max<size_t>(buffer_num_cells, 1);
 
   // execute join (perhaps multiplex algorithm based on something?)
   join_impl::hash_join_executor join_executor(sf_left,
@@ -56,7 +60,7 @@ sframe join(sframe& sf_left,
                                               right_join_positions,
                                               in_join_type,
                                               alter_names_right,
-                                              max_buffer_size);
+                                              buffer_num_cells);
 
   return join_executor.grace_hash_join();
 }
@@ -3,6 +3,9 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#ifndef TURI_SFRAME_JOIN_HPP
+#define TURI_SFRAME_JOIN_HPP
+
 #include <string>
 #include <vector>
 #include <cstdio>
@@ -33,3 +36,5 @@ sframe join(sframe& sf_left,
             size_t max_buffer_size = SFRAME_JOIN_BUFFER_NUM_CELLS);
 
 } // end of turicreate
+
+#endif
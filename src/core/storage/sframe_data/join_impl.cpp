@@ -3,10 +3,15 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <numeric>
+#include <boost/algorithm/string.hpp>
 #include <core/storage/sframe_data/join_impl.hpp>
 #include <core/system/cppipc/server/cancel_ops.hpp>
 #include <core/util/cityhash_tc.hpp>
 #include <core/storage/sframe_data/sframe_constants.hpp>
+#include <core/storage/fileio/memory_budget.hpp>
+#include <core/globals/metrics.hpp>
+#include <ml/sketches/space_saving.hpp>
 
 namespace turi {
 namespace join_impl {
@@ -15,8 +20,26 @@ namespace join_impl {
 
 const join_hash_table::value_type join_hash_table::empty_vt = {};
 
+/**
+ * The bytes a stored row takes, roughly: the cells, and the characters or
+ * elements of the strings and vectors.
+ */
+static size_t row_memory(const std::vector<flexible_type> &row) {
+  size_t ret = sizeof(row) + row.size() * sizeof(flexible_type);
+  for(const auto& v : row) {
+    if(v.get_type() == flex_type_enum::STRING) {
+      ret += v.get<flex_string>().size();
+    } else if(v.get_type() == flex_type_enum::VECTOR) {
+      ret += v.get<flex_vec>().size() * sizeof(double);
+    }
+  }
+  return ret;
+}
+
 bool join_hash_table::add_row(const std::vector<flexible_type> &row) {
 
+  _memory.add(row_memory(row));
+
   size_t the_hash_key = compute_hash_from_row(row, _hash_positions);
   bool first_entry;
 
@@ -135,44 +158,28 @@ std::unordered_map<size_t, std::list<join_hash_table::value_type>>::const_iterat
   return _hash_table.cend();
 }
 
-hash_join_executor::hash_join_executor(const sframe &left,
-                                       const sframe &right,
-                                       const std::vector<size_t> &left_join_positions,
-                                       const std::vector<size_t> &right_join_positions,
-                                       join_type_t join_type,
-                                       const std::map<std::string,std::string>& alter_names_right,
-                                       size_t max_buffer_size) :
-    _left_frame(left),
-    _right_frame(right),
-    _left_join_positions(left_join_positions),
-    _right_join_positions(right_join_positions),
-    _max_buffer_size(max_buffer_size),
-    _left_join(false),
-    _right_join(false),
-    _reverse_output_column_order(false),
-    _frames_partitioned(false),
-    _alter_names_right(alter_names_right) {
-
-
-  if(join_type == LEFT_JOIN || join_type == FULL_JOIN) {
-    _left_join = true;
+join_type_t join_type_from_string(std::string join_type) {
+  boost::algorithm::to_lower(join_type);
+  if(join_type == "outer") {
+    return FULL_JOIN;
+  } else if(join_type == "left") {
+    return LEFT_JOIN;
+  } else if(join_type == "right") {
+    return RIGHT_JOIN;
+  } else if(join_type == "inner") {
+    return INNER_JOIN;
   }
-  if(join_type == RIGHT_JOIN || join_type == FULL_JOIN) {
-    _right_join = true;
-  }
-
-  ASSERT_EQ(_left_join_positions.size(), _right_join_positions.size());
-
-  /* handy script for reverse lookup */
-  for(size_t i = 0; i < _left_join_positions.size(); ++i) {
-    auto ret = _right_to_left_join_positions.emplace(_right_join_positions[i],
-                                                     _left_join_positions[i]);
-    ASSERT_TRUE(ret.second);
+  log_and_throw("Invalid join type given!");
+}
 
-    ret = _left_to_right_join_positions.emplace(_left_join_positions[i],
-                                                _right_join_positions[i]);
-    ASSERT_TRUE(ret.second);
-  }
+void join_output_columns(const sframe &left,
+                         const sframe &right,
+                         const std::vector<size_t> &right_join_positions,
+                         const std::map<std::string,std::string>& alter_names_right,
+                         std::vector<std::string> &column_names,
+                         std::vector<flex_type_enum> &column_types) {
+  std::set<size_t> right_join_position_set(right_join_positions.begin(),
+                                           right_join_positions.end());
 
   /*
    * using names from sframe: unique and non-empty
@@ -181,14 +188,14 @@ hash_join_executor::hash_join_executor(const sframe &left,
    * this is order dependent; doing in reverse will result in
    * different result.
    *
-   * since _alter_name_right only applies to original order,
+   * since alter_names_right only applies to original order,
    * we have to obtain the original construction
    **/
 
   // get orginal left sframe's column names
   auto col_names_original_order = left.column_names();
-  _output_column_names = left.column_names();
-  _output_column_types = left.column_types();
+  column_names = left.column_names();
+  column_types = left.column_types();
 
   std::set<std::string> new_table = {
       std::make_move_iterator(col_names_original_order.begin()),
@@ -207,7 +214,7 @@ hash_join_executor::hash_join_executor(const sframe &left,
       std::begin(col_names_original_order), std::end(col_names_original_order)};
 
   std::set<std::string> unique_names_from_user;
-  for (const auto& entry : _alter_names_right) {
+  for (const auto& entry : alter_names_right) {
     if (unique_names_from_right.count(entry.first) == 0) {
           std::stringstream ss;
           ss << "user provided column name { " << entry.first
@@ -233,39 +240,82 @@ hash_join_executor::hash_join_executor(const sframe &left,
   // check the original right sframe columns
   for (auto& name : col_names_original_order) {
     // skip join_keys
-    if (_right_to_left_join_positions.count(right.column_index(name)))
+    if (right_join_position_set.count(right.column_index(name)))
       continue;
 
     if (new_table.count(name)) {
-      if (_alter_names_right.count(name)) {
+      if (alter_names_right.count(name)) {
         /*
          * user defined resolution shall not have any conflict with
          * all col names visited so far; but can be the same to col
          * names haven't seen so far.
          **/
-        auto itr = _alter_names_right.find(name);
+        auto itr = alter_names_right.find(name);
         if (!new_table.insert(itr->second).second) {
           std::stringstream ss;
           ss << "user provided column name { " << itr->second << " } conflicts with table name used in SFrame";
           log_and_throw(ss.str());
         }
-        _output_column_types.push_back(right.column_type(right.column_index(name)));
-        _output_column_names.push_back(itr->second);
+        column_types.push_back(right.column_type(right.column_index(name)));
+        column_names.push_back(itr->second);
         new_table.insert(itr->second);
       } else {
-        _output_column_types.push_back(right.column_type(right.column_index(name)));
+        column_types.push_back(right.column_type(right.column_index(name)));
         // default collision resolv. see SFrame::generate_valid_column_name.
         // if SFrame::generate_valid_column_name changes, this will break.
         name.append(".1", 2);
-        _output_column_names.push_back(name);
+        column_names.push_back(name);
         new_table.insert(std::move(name));
       }
     } else {
-      _output_column_names.push_back(name);
-      _output_column_types.push_back(right.column_type(right.column_index(name)));
+      column_names.push_back(name);
+      column_types.push_back(right.column_type(right.column_index(name)));
       new_table.insert(std::move(name));
     }
   }
+}
+
+hash_join_executor::hash_join_executor(const sframe &left,
+                                       const sframe &right,
+                                       const std::vector<size_t> &left_join_positions,
+                                       const std::vector<size_t> &right_join_positions,
+                                       join_type_t join_type,
+                                       const std::map<std::string,std::string>& alter_names_right,
+                                       size_t max_buffer_size) :
+    _left_frame(left),
+    _right_frame(right),
+    _left_join_positions(left_join_positions),
+    _right_join_positions(right_join_positions),
+    _max_buffer_size(max_buffer_size),
+    _left_join(false),
+    _right_join(false),
+    _reverse_output_column_order(false),
+    _frames_partitioned(false),
+    _alter_names_right(alter_names_right) {
+
+
+  if(join_type == LEFT_JOIN || join_type == FULL_JOIN) {
+    _left_join = true;
+  }
+  if(join_type == RIGHT_JOIN || join_type == FULL_JOIN) {
+    _right_join = true;
+  }
+
+  ASSERT_EQ(_left_join_positions.size(), _right_join_positions.size());
+
+  /* handy script for reverse lookup */
+  for(size_t i = 0; i < _left_join_positions.size(); ++i) {
+    auto ret = _right_to_left_join_positions.emplace(_right_join_positions[i],
+                                                     _left_join_positions[i]);
+    ASSERT_TRUE(ret.second);
+
+    ret = _left_to_right_join_positions.emplace(_left_join_positions[i],
+                                                _right_join_positions[i]);
+    ASSERT_TRUE(ret.second);
+  }
+
+  join_output_columns(left, right, right_join_positions, _alter_names_right,
+                      _output_column_names, _output_column_types);
 
   // Left should always be smaller than right
   if (get_num_cells(right) < get_num_cells(left)) {
@@ -367,22 +417,10 @@ sframe hash_join_executor::grace_hash_join() {
   std::tie(grace_left, grace_right) = this->grace_partition_frames();
   logstream(LOG_INFO) << "Partitioned frames in: " << ti.current_time() << std::endl;
   this->init_result_frame(result_frame);
-  ASSERT_EQ(grace_left->size(), _left_frame.size());
-  ASSERT_EQ(grace_right->size(), _right_frame.size());
-
-  size_t num_segments;
-  std::vector<size_t> right_segment_lengths;
-  if(_frames_partitioned) {
-    num_segments = grace_left->num_segments();
-    // After partitioning this needs to be true
-    ASSERT_EQ(num_segments, grace_right->num_segments());
-    for(size_t i = 0; i < num_segments; ++i) {
-      right_segment_lengths.push_back(grace_right->segment_length(i));
-    }
-  } else {
-    num_segments = 1;
-    right_segment_lengths.push_back(grace_right->num_rows());
-  }
+  ASSERT_EQ(grace_left->size() + (_heavy_left ? _heavy_left->size() : 0),
+            _left_frame.size());
+  // the bloom filter may have dropped right rows without a match
+  ASSERT_LE(grace_right->size(), _right_frame.size());
 
   // Instantiate all output iterators
   std::vector<sframe::iterator> result_output_iterators(result_frame.num_segments());
@@ -390,115 +428,14 @@ sframe hash_join_executor::grace_hash_join() {
     result_output_iterators[i] = result_frame.get_output_iterator(i);
   }
 
-  // Split each segment of the right frame into num_segments (of output frame) pieces
-  // This is so I can parallelize the hash table lookups when scanning the right
-  // frame.  There is one thread per output segment, and each SFrame segment
-  // must be split up into this many pieces to parallelize.
-  std::vector<size_t> logical_right_segment_sizes;
-  for(size_t i = 0; i < num_segments; ++i) {
-
-    size_t elements_left = right_segment_lengths[i];
-    size_t elements_per = elements_left / result_frame.num_segments();
-    size_t first_of_segment_idx = i*result_frame.num_segments();
-
-    for(size_t j = 0; j < result_frame.num_segments(); ++j) {
-      if(elements_per <= elements_left) {
-        logical_right_segment_sizes.push_back(elements_per);
-        elements_left -= elements_per;
-      } else {
-        // This makes sure we don't have a bunch of segments with a tiny
-        // amount of elements.  Better to have it all in one segment.
-        if(elements_left > MIN_SEGMENT_LENGTH) {
-          logical_right_segment_sizes.push_back(elements_left);
-          elements_left = 0;
-        } else {
-          logical_right_segment_sizes.push_back(0);
-        }
-      }
-    }
-    // Put leftovers in the first segment
-    if(elements_left > 0) {
-      logical_right_segment_sizes[first_of_segment_idx] += elements_left;
-    }
-  }
-  ASSERT_EQ(logical_right_segment_sizes.size(),
-            num_segments*result_frame.num_segments());
-
-  // Readers for the left and right SArray used in the join
-  std::unique_ptr<sframe::reader_type> l_rdr;
-  if(_frames_partitioned) {
-    l_rdr = grace_left->get_reader();
-  } else {
-    l_rdr = grace_left->get_reader(num_segments);
-  }
-  auto r_rdr = grace_right->get_reader(logical_right_segment_sizes);
-
-  // Iterate over each segment of the left frame and add to a hash table.
-  // These segments can not be read in parallel because they are
-  // meant to represent the upper bound of the memory we can read in.
   ti.start();
-  for(size_t i = 0; i < num_segments; ++i) {
-    // Load the entire left partition into a hash table
-    join_hash_table cur_ht(_left_join_positions);
-    for(auto iter = l_rdr->begin(i); iter != l_rdr->end(i); ++iter) {
-      // Must unpack the row data from the serialized string it is stored as
-      std::vector<flexible_type> row;
-      if(_frames_partitioned) {
-        row = unpack_row(std::string(iter->at(0)), _left_frame.num_columns());
-      } else {
-        row = *iter;
-      }
-      cur_ht.add_row(row);
-    }
-
-    parallel_for(0, result_frame.num_segments(),
-        [&](size_t seg_num) {
-          size_t cur_logical_segment = i*result_frame.num_segments()+seg_num;
-          auto writer = result_output_iterators[seg_num];
-
-          // Iterate through the logical segment of the current segment
-          for(auto iter = r_rdr->begin(cur_logical_segment);
-              iter != r_rdr->end(cur_logical_segment);
-              ++iter) {
-
-            // Must unpack the row data from the serialized string it is stored as
-            std::vector<flexible_type> row;
-            if(_frames_partitioned) {
-              row = unpack_row(std::string(iter->at(0)), _right_frame.num_columns());
-            } else {
-              row = *iter;
-            }
-
-            // Merge any matching rows to the corresponding left row and write
-            auto query_result = cur_ht.get_matching_rows(row, _right_join_positions);
-
-            // If our matching rows query returned something, then this result
-            // should be in the inner join.  If it didn't, this row should only
-            // be in a right join
-            if((query_result.rows.size() > 0) ||
-              ((query_result.rows.size() == 0) && _right_join)) {
-              // Match found! Add to the result set
-              merge_rows_for_output(result_frame, writer, query_result.rows, {row});
-            }
-          }
-        });
-
-    // Get an output iterator for a segment...try not to overload one segment
-    size_t seg_cntr = 0;
-    if(_left_join) {
-      for(auto iter = cur_ht.cbegin(); iter != cur_ht.cend(); ++iter) {
-        for(auto iter2 = iter->second.begin(); iter2 != iter->second.end(); ++iter2) {
-          if(!iter2->matched) {
-            auto result_writer =
-              result_output_iterators[seg_cntr % result_frame.num_segments()];
-            merge_rows_for_output(result_frame,
-                result_writer,
-                {iter2->rows},
-                std::vector<std::vector<flexible_type>>());
-          }
-        }
-      }
+  if(_frames_partitioned) {
+    partitioned_join(*grace_left, *grace_right, result_frame, result_output_iterators);
+    if(_heavy_left) {
+      broadcast_join(*_heavy_left, *_heavy_right, result_frame, result_output_iterators);
     }
+  } else {
+    broadcast_join(*grace_left, *grace_right, result_frame, result_output_iterators);
   }
   logstream(LOG_INFO) << "Hash join time: " << ti.current_time() << std::endl;
 
@@ -523,6 +460,125 @@ sframe hash_join_executor::grace_hash_join() {
   return result_frame;
 }
 
+void hash_join_executor::broadcast_join(const sframe &left,
+                                        const sframe &right,
+                                        sframe &result_frame,
+                                        std::vector<sframe::iterator> &result_output_iterators) {
+  // Split the right frame into one piece per output segment, so that the
+  // hash table lookups when scanning the right frame are parallelized.
+  size_t num_output_segments = result_frame.num_segments();
+  std::vector<size_t> logical_right_segment_sizes;
+  size_t elements_left = right.num_rows();
+  size_t elements_per = elements_left / num_output_segments;
+  for(size_t j = 0; j < num_output_segments; ++j) {
+    if(elements_per <= elements_left) {
+      logical_right_segment_sizes.push_back(elements_per);
+      elements_left -= elements_per;
+    } else {
+      // This makes sure we don't have a bunch of segments with a tiny
+      // amount of elements.  Better to have it all in one segment.
+      if(elements_left > MIN_SEGMENT_LENGTH) {
+        logical_right_segment_sizes.push_back(elements_left);
+        elements_left = 0;
+      } else {
+        logical_right_segment_sizes.push_back(0);
+      }
+    }
+  }
+  // Put leftovers in the first segment
+  if(elements_left > 0) {
+    logical_right_segment_sizes[0] += elements_left;
+  }
+
+  // Load the entire left frame into a hash table
+  join_hash_table cur_ht(_left_join_positions);
+  auto l_rdr = left.get_reader(1);
+  for(auto iter = l_rdr->begin(0); iter != l_rdr->end(0); ++iter) {
+    cur_ht.add_row(*iter);
+  }
+
+  auto r_rdr = right.get_reader(logical_right_segment_sizes);
+  parallel_for(0, num_output_segments, [&](size_t seg_num) {
+    auto writer = result_output_iterators[seg_num];
+    for(auto iter = r_rdr->begin(seg_num); iter != r_rdr->end(seg_num); ++iter) {
+      probe_row(cur_ht, *iter, result_frame, writer);
+    }
+  });
+
+  if(_left_join) emit_unmatched_rows(cur_ht, result_frame, result_output_iterators);
+}
+
+void hash_join_executor::partitioned_join(const sframe &left,
+                                          const sframe &right,
+                                          sframe &result_frame,
+                                          std::vector<sframe::iterator> &result_output_iterators) {
+  size_t num_partitions = left.num_segments();
+  // After partitioning this needs to be true
+  ASSERT_EQ(num_partitions, right.num_segments());
+  auto l_rdr = left.get_reader();
+  auto r_rdr = right.get_reader();
+
+  // Partitions are independent and joined in parallel. Each output segment
+  // is written by one thread, which joins the partitions
+  // seg_num, seg_num + num_output_segments, ... one after the other.
+  size_t num_output_segments = result_frame.num_segments();
+  parallel_for(0, num_output_segments, [&](size_t seg_num) {
+    std::vector<sframe::iterator> writer{result_output_iterators[seg_num]};
+    for(size_t i = seg_num; i < num_partitions; i += num_output_segments) {
+      // Load the entire left partition into a hash table
+      join_hash_table cur_ht(_left_join_positions);
+      for(auto iter = l_rdr->begin(i); iter != l_rdr->end(i); ++iter) {
+        // Must unpack the row data from the serialized string it is stored as
+        cur_ht.add_row(unpack_row(std::string(iter->at(0)), _left_frame.num_columns()));
+      }
+
+      for(auto iter = r_rdr->begin(i); iter != r_rdr->end(i); ++iter) {
+        probe_row(cur_ht,
+                  unpack_row(std::string(iter->at(0)), _right_frame.num_columns()),
+                  result_frame, writer[0]);
+      }
+
+      if(_left_join) emit_unmatched_rows(cur_ht, result_frame, writer);
+    }
+  });
+}
+
+void hash_join_executor::probe_row(join_hash_table &ht,
+                                   const std::vector<flexible_type> &row,
+                                   sframe &result_frame,
+                                   sframe::iterator result_iter) {
+  // Merge any matching rows to the corresponding left row and write
+  const auto& query_result = ht.get_matching_rows(row, _right_join_positions);
+
+  // If our matching rows query returned something, then this result
+  // should be in the inner join.  If it didn't, this row should only
+  // be in a right join
+  if((query_result.rows.size() > 0) || _right_join) {
+    // Match found! Add to the result set
+    merge_rows_for_output(result_frame, result_iter, query_result.rows, {row});
+  }
+}
+
+void hash_join_executor::emit_unmatched_rows(join_hash_table &ht,
+                                             sframe &result_frame,
+                                             std::vector<sframe::iterator> &result_output_iterators) {
+  // Spread the rows over the output segments...try not to overload one segment
+  size_t seg_cntr = 0;
+  for(auto iter = ht.cbegin(); iter != ht.cend(); ++iter) {
+    for(auto iter2 = iter->second.begin(); iter2 != iter->second.end(); ++iter2) {
+      if(!iter2->matched) {
+        auto result_writer =
+          result_output_iterators[seg_cntr % result_output_iterators.size()];
+        ++seg_cntr;
+        merge_rows_for_output(result_frame,
+            result_writer,
+            {iter2->rows},
+            std::vector<std::vector<flexible_type>>());
+      }
+    }
+  }
+}
+
 void hash_join_executor::merge_rows_for_output(sframe &result_frame,
                                                sframe::iterator result_iter,
                                                const std::vector<std::vector<flexible_type>> &left_rows,
@@ -612,7 +668,13 @@ size_t hash_join_executor::get_num_cells(const sframe &sf) {
 
 size_t hash_join_executor::choose_number_of_grace_partitions(const sframe &sf) {
   size_t num_cells = get_num_cells(sf);
-  return (num_cells / _max_buffer_size) + 1;
+  // Fits in memory: it is broadcast to all threads instead.
+  if (num_cells < _max_buffer_size) return 1;
+  // Partitions are joined in parallel, so each must fit in a share of the
+  // buffer.
+  size_t partition_buffer_size =
+      std::max<size_t>(_max_buffer_size / thread::cpu_count(), 1);
+  return (num_cells / partition_buffer_size) + 1;
 }
 
 
@@ -627,18 +689,124 @@ std::pair<std::shared_ptr<sframe>,std::shared_ptr<sframe>> hash_join_executor::g
   logstream(LOG_INFO) << "Chose " << num_partitions <<
     " partitions for GRACE hash join\n";
 
+  // Unless its unmatched rows are output, rows of the right frame whose key
+  // is not in the left frame are dropped before they are partitioned, with
+  // a bloom filter of the left keys built while partitioning the left frame.
+  bloom_filter left_keys;
+  fileio::memory_reservation filter_memory;
+  if (num_partitions > 1 && !_right_join && SFRAME_JOIN_BLOOM_FILTER_BITS_PER_KEY > 0) {
+    size_t num_bits = bloom_filter::num_bits_for(_left_frame.num_rows(),
+                                                 SFRAME_JOIN_BLOOM_FILTER_BITS_PER_KEY);
+    if (filter_memory.try_grow(num_bits / 8)) {
+      left_keys = bloom_filter(_left_frame.num_rows(), SFRAME_JOIN_BLOOM_FILTER_BITS_PER_KEY);
+    }
+  }
+  bool use_filter = left_keys.num_bits() > 0;
+
+  // A key in a large share of the rows would make its partition, and the
+  // one thread joining it, much larger than the others. The rows of such
+  // keys are kept out of the partitions, and joined by all threads at once.
+  std::unordered_set<size_t> heavy_keys;
+  if (num_partitions > 1) heavy_keys = find_heavy_keys();
+  const std::unordered_set<size_t>* heavy = heavy_keys.empty() ? nullptr : &heavy_keys;
+  if (heavy) {
+    _heavy_left = std::make_shared<sframe>();
+    _heavy_right = std::make_shared<sframe>();
+  }
+
   // Hash join columns into separate partitions
   // (each partition is a segment of an SFrame)
-  auto parted_left_frame = grace_partition_frame(_left_frame, _left_join_positions, num_partitions);
-  auto parted_right_frame = grace_partition_frame(_right_frame, _right_join_positions, num_partitions);
+  auto parted_left_frame = grace_partition_frame(_left_frame, _left_join_positions, num_partitions,
+                                                 use_filter ? &left_keys : nullptr, nullptr,
+                                                 heavy, _heavy_left.get());
+  auto parted_right_frame = grace_partition_frame(_right_frame, _right_join_positions, num_partitions,
+                                                  nullptr, use_filter ? &left_keys : nullptr,
+                                                  heavy, _heavy_right.get());
+  if (use_filter) {
+    logstream(LOG_INFO) << "Bloom filter kept " << parted_right_frame->size()
+                        << " of " << _right_frame.size() << " rows" << std::endl;
+  }
+  if (heavy) {
+    logstream(LOG_INFO) << heavy_keys.size() << " heavy join keys in "
+                        << _heavy_left->size() << " left and "
+                        << _heavy_right->size() << " right rows" << std::endl;
+  }
 
   return std::make_pair(parted_left_frame, parted_right_frame);
 }
 
+std::unordered_set<size_t> hash_join_executor::find_heavy_keys() {
+  std::unordered_set<size_t> ret;
+  double fraction = SFRAME_JOIN_HEAVY_KEY_FRACTION;
+  if (fraction <= 0 || _right_frame.num_rows() == 0) return ret;
+
+  // Only the join columns are read. In the selection they are in the order
+  // of the join positions, so the key hashes are those of the full rows.
+  auto select_keys = [](const sframe& sf, const std::vector<size_t>& positions) {
+    std::vector<std::string> names;
+    for (size_t i : positions) names.push_back(sf.column_name(i));
+    return sf.select_columns(names);
+  };
+  std::vector<size_t> key_positions(_right_join_positions.size());
+  std::iota(key_positions.begin(), key_positions.end(), 0);
+  mutex lock;
+
+  // Candidates: every key in at least fraction of the right rows is among
+  // the frequent items of a sketch of 2 / fraction entries.
+  sframe right_keys = select_keys(_right_frame, _right_join_positions);
+  auto r_rdr = right_keys.get_reader(thread::cpu_count());
+  sketches::space_saving<size_t> right_counts(fraction / 2);
+  parallel_for(0, r_rdr->num_segments(), [&](size_t seg_num) {
+    sketches::space_saving<size_t> local_counts(fraction / 2);
+    for (auto iter = r_rdr->begin(seg_num); iter != r_rdr->end(seg_num); ++iter) {
+      local_counts.add(compute_hash_from_row(*iter, key_positions));
+    }
+    std::lock_guard<mutex> guard(lock);
+    right_counts.combine(local_counts);
+  });
+  size_t threshold = std::max<size_t>(1, fraction * _right_frame.num_rows());
+  std::unordered_set<size_t> candidates;
+  for (const auto& item : right_counts.frequent_items()) {
+    if (item.second >= threshold) candidates.insert(item.first);
+  }
+  if (candidates.empty()) return ret;
+
+  // The exact number of left rows of each candidate
+  sframe left_keys = select_keys(_left_frame, _left_join_positions);
+  auto l_rdr = left_keys.get_reader(thread::cpu_count());
+  std::unordered_map<size_t, size_t> left_counts;
+  parallel_for(0, l_rdr->num_segments(), [&](size_t seg_num) {
+    std::unordered_map<size_t, size_t> local_counts;
+    for (auto iter = l_rdr->begin(seg_num); iter != l_rdr->end(seg_num); ++iter) {
+      size_t hash_val = compute_hash_from_row(*iter, key_positions);
+      if (candidates.count(hash_val)) ++local_counts[hash_val];
+    }
+    std::lock_guard<mutex> guard(lock);
+    for (const auto& count : local_counts) left_counts[count.first] += count.second;
+  });
+
+  std::vector<std::pair<size_t, size_t>> by_left_rows;
+  for (size_t hash_val : candidates) {
+    by_left_rows.emplace_back(left_counts[hash_val], hash_val);
+  }
+  std::sort(by_left_rows.begin(), by_left_rows.end());
+  size_t num_cells = 0;
+  for (const auto& key : by_left_rows) {
+    num_cells += key.first * _left_frame.num_columns();
+    if (num_cells > _max_buffer_size) break;
+    ret.insert(key.second);
+  }
+  return ret;
+}
+
 std::shared_ptr<sframe> hash_join_executor::grace_partition_frame(
     const sframe &sf,
     const std::vector<size_t> &join_col_nums,
-    size_t num_partitions) {
+    size_t num_partitions,
+    bloom_filter* insert_keys,
+    const bloom_filter* key_filter,
+    const std::unordered_set<size_t>* heavy_keys,
+    sframe* heavy_rows) {
   //TODO: for now
   log_func_entry();
   // We don't need to partition if only 1 is needed
@@ -662,31 +830,64 @@ std::shared_ptr<sframe> hash_join_executor::grace_partition_frame(
 
   // Iterate over each row of the given SFrame, hash on the join columns,
   // and write that row to the appropriate segment of the partitioned sframe
+  // Rows are buffered per partition, and written a batch at a time to cut
+  // down on the contention on the partition locks.
+  static constexpr size_t PARTITION_WRITE_BATCH_SIZE = 64;
+  static metrics::counter& join_spill_bytes = metrics::get_counter(
+      "join_spill_bytes", "Bytes of rows written to disk partitions by joins.");
   auto rdr = sf.get_reader(thread::cpu_count());
+  // Each thread writes the heavy rows it reads to its own segment
+  if (heavy_keys) {
+    heavy_rows->open_for_write(sf.column_names(), sf.column_types(), "",
+                               rdr->num_segments());
+  }
   parallel_for(0, rdr->num_segments(), [&](size_t seg_num) {
     oarchive oarc;
+    size_t spilled = 0;
+    std::vector<std::vector<flexible_type>> buffers(num_partitions);
+    sframe::iterator heavy_iter;
+    if (heavy_keys) heavy_iter = heavy_rows->get_output_iterator(seg_num);
+    auto write_buffer = [&](size_t partition) {
+      std::lock_guard<mutex> guard(outiter_mutexes[partition]);
+      for (auto& f: buffers[partition]) {
+        *(outiter_vector[partition]) = std::vector<flexible_type>{std::move(f)};
+        ++outiter_vector[partition];
+      }
+      buffers[partition].clear();
+    };
     for(auto j = rdr->begin(seg_num); j != rdr->end(seg_num); ++j) {
       // Hash the given columns
       size_t hash_val = compute_hash_from_row(*j, join_col_nums);
+      if (insert_keys) insert_keys->insert(hash_val);
+      if (key_filter && !key_filter->may_contain(hash_val)) continue;
+      if (heavy_keys && heavy_keys->count(hash_val)) {
+        *heavy_iter = *j;
+        ++heavy_iter;
+        continue;
+      }
       size_t which_partition = hash_val % num_partitions;
 
       // Serialize the row
       for(auto &k : *j) {
         oarc << k;
       }
-      std::string s = std::string(oarc.buf, oarc.off);
-      flexible_type f(std::move(s));
-      outiter_mutexes[which_partition].lock();
-      *(outiter_vector[which_partition]) = std::vector<flexible_type>{std::move(f)};
-      ++outiter_vector[which_partition];
-      outiter_mutexes[which_partition].unlock();
+      buffers[which_partition].emplace_back(std::string(oarc.buf, oarc.off));
+      spilled += oarc.off;
       oarc.off = 0;
+      if (buffers[which_partition].size() >= PARTITION_WRITE_BATCH_SIZE) {
+        write_buffer(which_partition);
+      }
+    }
+    for (size_t i = 0; i < num_partitions; ++i) {
+      if (!buffers[i].empty()) write_buffer(i);
     }
+    join_spill_bytes += spilled;
     free(oarc.buf);
   });
 
   // We're done writing. Close all output iterators.
   parted_array->close();
+  if (heavy_keys) heavy_rows->close();
 
   _frames_partitioned = true;
 
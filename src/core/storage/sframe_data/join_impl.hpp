@@ -3,11 +3,16 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#ifndef TURI_SFRAME_JOIN_IMPL_HPP
+#define TURI_SFRAME_JOIN_IMPL_HPP
+
 #include <cstdio>
 #include <unordered_set>
 #include <unordered_map>
 
 #include <core/storage/sframe_data/sframe.hpp>
+#include <core/generics/bloom_filter.hpp>
+#include <core/globals/memory_accounting.hpp>
 
 //TODO: What happens if a join key (or part of one) is NULL?
 enum join_type_t {INNER_JOIN = 0, LEFT_JOIN, RIGHT_JOIN, FULL_JOIN};
@@ -30,6 +35,26 @@ size_t hash_key(const std::vector<flexible_type>& key);
 size_t compute_hash_from_row(const std::vector<flexible_type> &row,
                              const std::vector<size_t> &positions);
 
+/**
+ * Converts "inner", "left", "right" or "outer" (in any case) to the join
+ * type. Throws on anything else.
+ */
+join_type_t join_type_from_string(std::string join_type);
+
+/**
+ * Computes the names and types of the columns of the result of a join: all
+ * columns of left, followed by the columns of right which are not join
+ * keys. Right columns whose names collide with an earlier name are renamed
+ * by alter_names_right, or get a ".1" suffix. Throws if alter_names_right
+ * does not describe a valid renaming.
+ */
+void join_output_columns(const sframe &left,
+                         const sframe &right,
+                         const std::vector<size_t> &right_join_positions,
+                         const std::map<std::string,std::string>& alter_names_right,
+                         std::vector<std::string> &column_names,
+                         std::vector<flex_type_enum> &column_types);
+
 typedef struct {
   std::vector<std::vector<flexible_type>> rows;
   bool matched;
@@ -51,7 +76,9 @@ class join_hash_table {
    * numbers in each row that represent the values the join is on (or the join
    * keys).  These hash positions are for the frame that each row is added from.
    */
-  join_hash_table(std::vector<size_t> hp) : _hash_positions(hp) {}
+  join_hash_table(std::vector<size_t> hp)
+      : _hash_positions(hp),
+        _memory(memory_accounting::get_tag("join_hash_table")) {}
 
   /**
    * Add a row to the hash table.  Each row must be from the same frame, or
@@ -95,6 +122,8 @@ class join_hash_table {
   std::unordered_map<size_t, std::list<value_type>> _hash_table;
   // The positions in the rows that we store taht make up the hash key
   std::vector<size_t> _hash_positions;
+  // The estimated bytes of the stored rows.
+  memory_accounting::tagged_memory _memory;
   const static value_type empty_vt;
 };
 
@@ -137,6 +166,19 @@ class hash_join_executor {
   std::unordered_map<size_t, size_t> _reverse_to_original;
   bool _frames_partitioned;
   std::map<std::string, std::string> _alter_names_right;
+  // The rows of the heavy join keys, kept out of the partitions. Null if
+  // there are none.
+  std::shared_ptr<sframe> _heavy_left;
+  std::shared_ptr<sframe> _heavy_right;
+
+  /**
+   * Returns the hashes of the join keys found in at least
+   * SFRAME_JOIN_HEAVY_KEY_FRACTION of the rows of the right frame. They are
+   * counted with a space saving sketch per thread. As all the left rows of
+   * these keys are joined in one hash table, the keys with the fewest left
+   * rows are taken first, while those rows fit in the join buffer.
+   */
+  std::unordered_set<size_t> find_heavy_keys();
 
   /**
    * Partition the left and right frames for the GRACE hash join algorithm and
@@ -147,9 +189,62 @@ class hash_join_executor {
   /**
    * Partition one SFrame for the GRACE hash join algorithm.
    *
+   * If insert_keys is not null, the hash of the join key of every row is
+   * inserted into it. If key_filter is not null, rows whose join key hash
+   * it does not contain are dropped.
+   *
+   * If heavy_keys is not null, the rows whose join key hash it contains are
+   * written, as they are, to heavy_rows instead of a partition.
+   *
    * Used by grace_partition_frames().
    */
-  std::shared_ptr<sframe> grace_partition_frame(const sframe &sf, const std::vector<size_t> &join_col_nums, size_t num_partitions);
+  std::shared_ptr<sframe> grace_partition_frame(const sframe &sf,
+                                                const std::vector<size_t> &join_col_nums,
+                                                size_t num_partitions,
+                                                bloom_filter* insert_keys = nullptr,
+                                                const bloom_filter* key_filter = nullptr,
+                                                const std::unordered_set<size_t>* heavy_keys = nullptr,
+                                                sframe* heavy_rows = nullptr);
+
+  /**
+   * Joins a left frame small enough to fit in memory with the right frame.
+   * The left frame is loaded into one hash table, which all threads probe
+   * with a part of the right frame each.
+   */
+  void broadcast_join(const sframe &left,
+                      const sframe &right,
+                      sframe &result_frame,
+                      std::vector<sframe::iterator> &result_output_iterators);
+
+  /**
+   * Joins frames partitioned by grace_partition_frames(). Partition i of
+   * the left frame is only joined with partition i of the right frame, so
+   * the pairs of partitions are joined in parallel, each by a single thread
+   * with its own hash table. The rows of the heavy keys, which would make a
+   * few partitions much larger than the others, are joined afterwards with
+   * broadcast_join().
+   */
+  void partitioned_join(const sframe &left,
+                        const sframe &right,
+                        sframe &result_frame,
+                        std::vector<sframe::iterator> &result_output_iterators);
+
+  /**
+   * Looks up a row of the right frame in a hash table of left rows, and
+   * writes out the joined rows.
+   */
+  void probe_row(join_hash_table &ht,
+                 const std::vector<flexible_type> &row,
+                 sframe &result_frame,
+                 sframe::iterator result_iter);
+
+  /**
+   * Writes out the left rows of a hash table which did not match any
+   * right row, for a left join.
+   */
+  void emit_unmatched_rows(join_hash_table &ht,
+                           sframe &result_frame,
+                           std::vector<sframe::iterator> &result_output_iterators);
 
   /**
    * Return the number of cells (rows * cols) of an sframe.
@@ -158,8 +253,9 @@ class hash_join_executor {
 
   /**
    * Estimates how many partitions this SFrame should be divided into for the
-   * GRACE hash join. The goal is for each partition to fit into memory.
-   *
+   * GRACE hash join. The goal is for each partition to fit into its share
+   * of memory when as many partitions as there are threads are joined at
+   * once. Returns 1 if the whole SFrame fits into memory.
    */
   size_t choose_number_of_grace_partitions(const sframe &sf);
 
@@ -190,3 +286,5 @@ class hash_join_executor {
 
 /// \}
 } // end of turicreate
+
+#endif
@@ -0,0 +1,701 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <boost/algorithm/string.hpp>
+#include <core/logging/logger.hpp>
+#include <core/parallel/thread_pool.hpp>
+#include <core/storage/fileio/general_fstream.hpp>
+#include <core/storage/fileio/fs_utils.hpp>
+#include <core/storage/fileio/sanitize_url.hpp>
+#include <core/storage/sframe_data/sframe.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
+#include <core/storage/sframe_data/json_lines_parser.hpp>
+#include <core/system/cppipc/server/cancel_ops.hpp>
+#include <timer/timer.hpp>
+
+namespace turi {
+
+namespace {
+
+/// Nesting deeper than this is rejected rather than overflowing the stack
+static constexpr size_t MAX_JSON_DEPTH = 512;
+
+/**
+ * A single pass recursive descent JSON parser over [p, end).
+ *
+ * Runs of plain characters, the bulk of the input, are skipped with memchr
+ * (vectorized by the C library), so string values are copied out in one go
+ * and only escapes are handled a character at a time.
+ */
+class json_value_parser {
+ public:
+  json_value_parser(const char* begin, const char* end): p(begin), end(end) { }
+
+  inline void skip_whitespace() {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) ++p;
+  }
+
+  inline bool at_end() const { return p == end; }
+
+  inline const char* position() const { return p; }
+
+  /// Consumes c, after whitespace. Returns false if it is not next.
+  inline bool consume(char c) {
+    skip_whitespace();
+    if (p < end && *p == c) {
+      ++p;
+      return true;
+    }
+    return false;
+  }
+
+  bool parse_value(flexible_type& out, size_t depth = 0) {
+    skip_whitespace();
+    if (p == end) return false;
+    switch (*p) {
+      case '{': return parse_object(out, depth + 1);
+      case '[': return parse_array(out, depth + 1);
+      case '"': {
+        out = flex_string();
+        return parse_string(out.mutable_get<flex_string>());
+      }
+      case 't':
+        if (!parse_literal("true", 4)) return false;
+        out = flex_int(1);
+        return true;
+      case 'f':
+        if (!parse_literal("false", 5)) return false;
+        out = flex_int(0);
+        return true;
+      case 'n':
+        if (!parse_literal("null", 4)) return false;
+        out = FLEX_UNDEFINED;
+        return true;
+      default:
+        return parse_number(out);
+    }
+  }
+
+  /// Parses a string, p being on its opening quote
+  bool parse_string(std::string& out) {
+    ++p;
+    out.clear();
+    while (true) {
+      const char* quote = static_cast<const char*>(memchr(p, '"', end - p));
+      if (quote == nullptr) return false;
+      const char* escape = static_cast<const char*>(memchr(p, '\\', quote - p));
+      if (escape == nullptr) {
+        out.append(p, quote);
+        p = quote + 1;
+        return true;
+      }
+      out.append(p, escape);
+      p = escape + 1;
+      if (p == end) return false;
+      char c = *p++;
+      switch (c) {
+        case '"': case '\\': case '/': out.push_back(c); break;
+        case 'b': out.push_back('\b'); break;
+        case 'f': out.push_back('\f'); break;
+        case 'n': out.push_back('\n'); break;
+        case 'r': out.push_back('\r'); break;
+        case 't': out.push_back('\t'); break;
+        case 'u': {
+          uint32_t code;
+          if (!parse_hex4(code)) return false;
+          // a surrogate pair encodes a code point above the BMP
+          if (code >= 0xD800 && code <= 0xDBFF) {
+            uint32_t low;
+            if (end - p < 6 || p[0] != '\\' || p[1] != 'u') return false;
+            p += 2;
+            if (!parse_hex4(low) || low < 0xDC00 || low > 0xDFFF) return false;
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+          } else if (code >= 0xDC00 && code <= 0xDFFF) {
+            return false;
+          }
+          append_utf8(code, out);
+          break;
+        }
+        default:
+          return false;
+      }
+    }
+  }
+
+ private:
+  const char* p;
+  const char* end;
+
+  bool parse_literal(const char* literal, size_t len) {
+    if ((size_t)(end - p) < len || memcmp(p, literal, len) != 0) return false;
+    p += len;
+    return true;
+  }
+
+  bool parse_hex4(uint32_t& code) {
+    if (end - p < 4) return false;
+    code = 0;
+    for (size_t i = 0; i < 4; ++i) {
+      char c = *p++;
+      code <<= 4;
+      if (c >= '0' && c <= '9') code |= c - '0';
+      else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+      else return false;
+    }
+    return true;
+  }
+
+  static void append_utf8(uint32_t code, std::string& out) {
+    if (code < 0x80) {
+      out.push_back((char)code);
+    } else if (code < 0x800) {
+      out.push_back((char)(0xC0 | (code >> 6)));
+      out.push_back((char)(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+      out.push_back((char)(0xE0 | (code >> 12)));
+      out.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+      out.push_back((char)(0x80 | (code & 0x3F)));
+    } else {
+      out.push_back((char)(0xF0 | (code >> 18)));
+      out.push_back((char)(0x80 | ((code >> 12) & 0x3F)));
+      out.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+      out.push_back((char)(0x80 | (code & 0x3F)));
+    }
+  }
+
+  /**
+   * Integers are accumulated directly. Anything with a fraction or an
+   * exponent, or which overflows 64 bits, is handed to strtod.
+   */
+  bool parse_number(flexible_type& out) {
+    const char* start = p;
+    bool negative = false;
+    if (p < end && *p == '-') {
+      negative = true;
+      ++p;
+    }
+    if (p == end || *p < '0' || *p > '9') return false;
+    // no leading zeros
+    if (*p == '0' && p + 1 < end && p[1] >= '0' && p[1] <= '9') return false;
+    uint64_t magnitude = 0;
+    bool overflow = false;
+    while (p < end && *p >= '0' && *p <= '9') {
+      uint64_t digit = *p - '0';
+      if (magnitude > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+        overflow = true;
+      }
+      magnitude = magnitude * 10 + digit;
+      ++p;
+    }
+    bool is_integer = true;
+    if (p < end && *p == '.') {
+      is_integer = false;
+      ++p;
+      if (p == end || *p < '0' || *p > '9') return false;
+      while (p < end && *p >= '0' && *p <= '9') ++p;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+      is_integer = false;
+      ++p;
+      if (p < end && (*p == '+' || *p == '-')) ++p;
+      if (p == end || *p < '0' || *p > '9') return false;
+      while (p < end && *p >= '0' && *p <= '9') ++p;
+    }
+    const uint64_t int_limit = (uint64_t)std::numeric_limits<flex_int>::max();
+    if (is_integer && !overflow && magnitude <= int_limit + (negative ? 1 : 0)) {
+      out = negative ? (flex_int)(0 - magnitude) : (flex_int)magnitude;
+      return true;
+    }
+    // strtod needs a terminated string
+    char buf[64];
+    size_t len = p - start;
+    if (len < sizeof(buf)) {
+      memcpy(buf, start, len);
+      buf[len] = 0;
+      out = flex_float(std::strtod(buf, nullptr));
+    } else {
+      out = flex_float(std::strtod(std::string(start, p).c_str(), nullptr));
+    }
+    return true;
+  }
+
+  bool parse_object(flexible_type& out, size_t depth) {
+    if (depth > MAX_JSON_DEPTH) return false;
+    ++p;
+    flex_dict dict;
+    if (consume('}')) {
+      out = std::move(dict);
+      return true;
+    }
+    do {
+      skip_whitespace();
+      if (p == end || *p != '"') return false;
+      flexible_type key = flex_string();
+      if (!parse_string(key.mutable_get<flex_string>())) return false;
+      if (!consume(':')) return false;
+      flexible_type value;
+      if (!parse_value(value, depth)) return false;
+      dict.emplace_back(std::move(key), std::move(value));
+    } while (consume(','));
+    if (!consume('}')) return false;
+    out = std::move(dict);
+    return true;
+  }
+
+  bool parse_array(flexible_type& out, size_t depth) {
+    if (depth > MAX_JSON_DEPTH) return false;
+    ++p;
+    flex_list list;
+    bool all_numeric = true;
+    if (!consume(']')) {
+      do {
+        flexible_type value;
+        if (!parse_value(value, depth)) return false;
+        all_numeric &= (value.get_type() == flex_type_enum::INTEGER ||
+                        value.get_type() == flex_type_enum::FLOAT);
+        list.push_back(std::move(value));
+      } while (consume(','));
+      if (!consume(']')) return false;
+    }
+    if (all_numeric) {
+      flex_vec vec(list.size());
+      for (size_t i = 0; i < list.size(); ++i) vec[i] = list[i].to<flex_float>();
+      out = std::move(vec);
+    } else {
+      out = std::move(list);
+    }
+    return true;
+  }
+};
+
+/// The types seen in the sample for one column
+struct column_sample {
+  bool seen_int = false, seen_float = false, seen_string = false;
+  bool seen_vector = false, seen_list = false, seen_dict = false;
+
+  void add(flex_type_enum type) {
+    switch (type) {
+      case flex_type_enum::UNDEFINED: break;
+      case flex_type_enum::INTEGER: seen_int = true; break;
+      case flex_type_enum::FLOAT: seen_float = true; break;
+      case flex_type_enum::STRING: seen_string = true; break;
+      case flex_type_enum::VECTOR: seen_vector = true; break;
+      case flex_type_enum::LIST: seen_list = true; break;
+      case flex_type_enum::DICT: seen_dict = true; break;
+      default: break;
+    }
+  }
+
+  flex_type_enum type() const {
+    bool numeric = seen_int || seen_float;
+    bool sequence = seen_vector || seen_list;
+    size_t kinds = (numeric ? 1 : 0) + (sequence ? 1 : 0) + (seen_string ? 1 : 0) +
+                   (seen_dict ? 1 : 0);
+    if (kinds != 1) return flex_type_enum::STRING;
+    if (numeric) return seen_float ? flex_type_enum::FLOAT : flex_type_enum::INTEGER;
+    if (sequence) return seen_list ? flex_type_enum::LIST : flex_type_enum::VECTOR;
+    if (seen_dict) return flex_type_enum::DICT;
+    return flex_type_enum::STRING;
+  }
+};
+
+/**
+ * Converts the parsed value, whose JSON text is [text_begin, text_end), to
+ * the type of its column. Returns false if it cannot be stored there.
+ */
+bool to_column_type(flexible_type& value,
+                    const char* text_begin, const char* text_end,
+                    flex_type_enum type, flexible_type& out) {
+  flex_type_enum value_type = value.get_type();
+  if (value_type == flex_type_enum::UNDEFINED || value_type == type) {
+    out = std::move(value);
+    return true;
+  }
+  switch (type) {
+    case flex_type_enum::STRING:
+      out = flex_string(text_begin, text_end);
+      return true;
+    case flex_type_enum::FLOAT:
+      if (value_type != flex_type_enum::INTEGER) return false;
+      out = value.to<flex_float>();
+      return true;
+    case flex_type_enum::INTEGER: {
+      if (value_type != flex_type_enum::FLOAT) return false;
+      // only integral floats, such as 1e3, are integers
+      flex_float v = value.get<flex_float>();
+      if (std::floor(v) != v || std::abs(v) >= 9.2e18) return false;
+      out = (flex_int)v;
+      return true;
+    }
+    case flex_type_enum::LIST: {
+      if (value_type != flex_type_enum::VECTOR) return false;
+      const flex_vec& vec = value.get<flex_vec>();
+      out = flex_list(vec.begin(), vec.end());
+      return true;
+    }
+    default:
+      try {
+        flexible_type converted(type);
+        converted.soft_assign(value);
+        out = std::move(converted);
+        return true;
+      } catch (...) {
+        return false;
+      }
+  }
+}
+
+inline bool is_blank(const char* begin, const char* end) {
+  for (; begin != end; ++begin) {
+    if (*begin != ' ' && *begin != '\t' && *begin != '\r') return false;
+  }
+  return true;
+}
+
+/// The schema inferred from the sample, and what is needed to parse records
+struct json_lines_schema {
+  /// If false, every record is a single value of column X1
+  bool records_are_objects = true;
+  std::vector<std::string> column_names;
+  std::vector<flex_type_enum> column_types;
+  std::unordered_map<std::string, size_t> column_index;
+};
+
+/**
+ * Parses the record [begin, end) into row, typed for the schema. Returns
+ * false if it is not valid JSON, or does not fit the schema.
+ */
+bool parse_record(const char* begin, const char* end,
+                  const json_lines_schema& schema,
+                  std::vector<flexible_type>& row,
+                  std::string& key,
+                  flexible_type& value) {
+  for (auto& cell: row) cell = FLEX_UNDEFINED;
+  json_value_parser parser(begin, end);
+  if (!schema.records_are_objects) {
+    parser.skip_whitespace();
+    const char* text_begin = parser.position();
+    if (!parser.parse_value(value)) return false;
+    const char* text_end = parser.position();
+    parser.skip_whitespace();
+    return parser.at_end() &&
+        to_column_type(value, text_begin, text_end, schema.column_types[0], row[0]);
+  }
+
+  if (!parser.consume('{')) return false;
+  if (!parser.consume('}')) {
+    // keys mostly come in the same order in every record: the column after
+    // the previous key is tried before the hash table
+    size_t expected_column = 0;
+    do {
+      parser.skip_whitespace();
+      if (parser.at_end() || *parser.position() != '"') return false;
+      if (!parser.parse_string(key)) return false;
+      if (!parser.consume(':')) return false;
+      parser.skip_whitespace();
+      const char* text_begin = parser.position();
+      if (!parser.parse_value(value)) return false;
+      const char* text_end = parser.position();
+
+      size_t column = (size_t)(-1);
+      if (expected_column < schema.column_names.size() &&
+          schema.column_names[expected_column] == key) {
+        column = expected_column;
+      } else {
+        auto iter = schema.column_index.find(key);
+        if (iter != schema.column_index.end()) column = iter->second;
+      }
+      if (column != (size_t)(-1)) {
+        if (!to_column_type(value, text_begin, text_end,
+                            schema.column_types[column], row[column])) {
+          return false;
+        }
+        expected_column = column + 1;
+      }
+    } while (parser.consume(','));
+    if (!parser.consume('}')) return false;
+  }
+  parser.skip_whitespace();
+  return parser.at_end();
+}
+
+/**
+ * Infers the schema from the first sample_rows records of url. Lines which
+ * do not parse are skipped here, and reported when parsed for real.
+ */
+json_lines_schema infer_schema(const std::string& url,
+                               const json_lines_options& options) {
+  json_lines_schema schema;
+  std::vector<column_sample> samples;
+  bool found_record = false;
+
+  general_ifstream fin(url);
+  if (!fin.good()) {
+    log_and_throw_io_failure("Cannot open " + sanitize_url(url));
+  }
+  std::string line;
+  size_t num_records = 0;
+  while (num_records < options.sample_rows && std::getline(fin, line)) {
+    const char* begin = line.data();
+    const char* end = begin + line.size();
+    if (is_blank(begin, end)) continue;
+    flexible_type value;
+    json_value_parser parser(begin, end);
+    if (!parser.parse_value(value)) continue;
+    parser.skip_whitespace();
+    if (!parser.at_end()) continue;
+    ++num_records;
+
+    if (!found_record) {
+      found_record = true;
+      schema.records_are_objects = value.get_type() == flex_type_enum::DICT;
+      if (!schema.records_are_objects) {
+        schema.column_names.push_back("X1");
+        samples.resize(1);
+      }
+    }
+    if (!schema.records_are_objects) {
+      samples[0].add(value.get_type());
+    } else if (value.get_type() == flex_type_enum::DICT) {
+      for (const auto& kv: value.get<flex_dict>()) {
+        const std::string& key = kv.first.get<flex_string>();
+        auto iter = schema.column_index.find(key);
+        if (iter == schema.column_index.end()) {
+          iter = schema.column_index.emplace(key, schema.column_names.size()).first;
+          schema.column_names.push_back(key);
+          samples.emplace_back();
+        }
+        samples[iter->second].add(kv.second.get_type());
+      }
+    }
+  }
+
+  for (const auto& sample: samples) schema.column_types.push_back(sample.type());
+
+  for (const auto& hint: options.column_type_hints) {
+    auto iter = schema.column_index.find(hint.first);
+    if (!schema.records_are_objects) {
+      if (hint.first == "X1") schema.column_types[0] = hint.second;
+    } else if (iter != schema.column_index.end()) {
+      schema.column_types[iter->second] = hint.second;
+    } else {
+      schema.column_index.emplace(hint.first, schema.column_names.size());
+      schema.column_names.push_back(hint.first);
+      schema.column_types.push_back(hint.second);
+    }
+  }
+  if (!schema.records_are_objects) schema.column_index.clear();
+  return schema;
+}
+
+/// A byte range of a file: the records whose line starts in [begin, end)
+struct json_lines_range {
+  std::string url;
+  size_t begin = 0;
+  size_t end = (size_t)(-1);
+};
+
+class json_lines_range_parser {
+ public:
+  json_lines_range_parser(const json_lines_schema& schema,
+                          const json_lines_options& options,
+                          size_t read_size)
+      : schema(schema), options(options), read_size(read_size) { }
+
+  /// The number of records skipped with continue_on_failure
+  size_t num_failures() const { return failures.load(); }
+
+  /**
+   * Parses the range into an sframe with a single segment. Every line break
+   * ends a record, so the first record of the range is the first line
+   * starting at or after its beginning.
+   */
+  sframe parse(const json_lines_range& range) {
+    sframe ret;
+    ret.open_for_write(schema.column_names, schema.column_types, "", 1);
+    auto out = ret.get_output_iterator(0);
+
+    general_ifstream fin(range.url);
+    size_t offset = range.begin == 0 ? 0 : range.begin - 1;
+    if (offset > 0) fin.seekg(offset, std::ios_base::beg);
+    if (!fin.good()) {
+      log_and_throw_io_failure("Cannot read " + sanitize_url(range.url));
+    }
+
+    std::vector<flexible_type> row(schema.column_names.size());
+    std::string key;
+    flexible_type value;
+    std::string buffer;
+    // the file offset of buffer[0]
+    size_t buffer_offset = offset;
+    // the next line starts at buffer[line_begin]
+    size_t line_begin = 0;
+    // a range starting mid file starts after the first line break at or
+    // after begin - 1, which keeps a line beginning exactly at begin
+    bool found_first_line = range.begin == 0;
+    bool eof = false;
+    size_t local_records = 0;
+
+    while (true) {
+      // read more, keeping the unfinished line
+      buffer.erase(0, line_begin);
+      buffer_offset += line_begin;
+      line_begin = 0;
+      if (eof) break;
+      size_t oldsize = buffer.size();
+      buffer.resize(oldsize + read_size);
+      fin.read(&(buffer[0]) + oldsize, read_size);
+      if (fin.bad()) {
+        log_and_throw_io_failure("Read of " + sanitize_url(range.url) + " failed");
+      }
+      buffer.resize(oldsize + fin.gcount());
+      if ((size_t)fin.gcount() < read_size) eof = true;
+
+      const char* data = buffer.data();
+      size_t size = buffer.size();
+      size_t scan_from = oldsize;
+      while (true) {
+        const char* newline = static_cast<const char*>(
+            memchr(data + scan_from, '\n', size - scan_from));
+        size_t line_end = newline ? newline - data : size;
+        // the last line of the file need not end with a line break
+        if (newline == nullptr && !eof) break;
+        if (newline == nullptr && line_begin == size) break;
+        if (!found_first_line) {
+          found_first_line = true;
+        } else {
+          if (buffer_offset + line_begin >= range.end) {
+            eof = true;
+            line_begin = size;
+            break;
+          }
+          parse_line(data + line_begin, data + line_end, row, key, value, out);
+          ++local_records;
+        }
+        line_begin = newline ? line_end + 1 : size;
+        scan_from = line_begin;
+        if (newline == nullptr) break;
+      }
+      records.fetch_add(local_records);
+      local_records = 0;
+      if (cppipc::must_cancel()) {
+        log_and_throw(std::string("JSON lines parsing cancelled"));
+      }
+      logprogress_stream_ontick(5) << "Read " << records.load()
+                                   << " lines." << std::endl;
+    }
+    ret.close();
+    return ret;
+  }
+
+ private:
+  const json_lines_schema& schema;
+  const json_lines_options& options;
+  size_t read_size;
+  std::atomic<size_t> failures{0};
+  std::atomic<size_t> records{0};
+
+  template <typename Iterator>
+  void parse_line(const char* begin, const char* end,
+                  std::vector<flexible_type>& row,
+                  std::string& key, flexible_type& value,
+                  Iterator& out) {
+    if (is_blank(begin, end)) return;
+    if (parse_record(begin, end, schema, row, key, value)) {
+      *out = row;
+      ++out;
+      return;
+    }
+    std::string badline(begin, end);
+    boost::algorithm::trim(badline);
+    if (badline.length() > 256) badline = badline.substr(0, 256) + "...";
+    if (!options.continue_on_failure) {
+      log_and_throw(std::string("Unable to parse line \"") + badline + "\"\n");
+    }
+    if (failures.fetch_add(1) < 10) {
+      logprogress_stream << "Unable to parse line \"" << badline << "\""
+                         << std::endl;
+    }
+  }
+};
+
+} // anonymous namespace
+
+
+bool parse_json_value(const char* begin, const char* end, flexible_type& out) {
+  json_value_parser parser(begin, end);
+  if (!parser.parse_value(out)) return false;
+  parser.skip_whitespace();
+  return parser.at_end();
+}
+
+sframe parse_json_lines(const std::string& url,
+                        const json_lines_options& options) {
+  std::vector<std::string> files;
+  for (const auto& p: fileio::get_glob_files(url)) {
+    if (p.second == fileio::file_status::REGULAR_FILE) files.push_back(p.first);
+  }
+  if (files.empty()) {
+    log_and_throw_io_failure("No files corresponding to the specified path (" +
+                             sanitize_url(url) + ").");
+  }
+  std::sort(files.begin(), files.end());
+
+  json_lines_schema schema = infer_schema(files[0], options);
+
+  // cut each uncompressed file into one range per thread
+  size_t num_threads = thread_pool::get_instance().size();
+  std::vector<json_lines_range> ranges;
+  for (const auto& file: files) {
+    general_ifstream fin(file);
+    size_t file_size = fin.file_size();
+    size_t num_ranges = 1;
+    if (!boost::algorithm::ends_with(file, ".gz") &&
+        SFRAME_CSV_PARSER_MIN_RANGE_SIZE > 0) {
+      num_ranges = std::min(num_threads, file_size / SFRAME_CSV_PARSER_MIN_RANGE_SIZE);
+      num_ranges = std::max<size_t>(num_ranges, 1);
+    }
+    for (size_t i = 0; i < num_ranges; ++i) {
+      json_lines_range range;
+      range.url = file;
+      range.begin = file_size * i / num_ranges;
+      if (i + 1 < num_ranges) range.end = file_size * (i + 1) / num_ranges;
+      ranges.push_back(range);
+    }
+  }
+  size_t read_size = std::max<size_t>(SFRAME_CSV_PARSER_READ_SIZE /
+                                      std::max<size_t>(num_threads, 1),
+                                      64 * 1024);
+
+  json_lines_range_parser parser(schema, options, read_size);
+  std::vector<sframe> parsed(ranges.size());
+  timer ti;
+  parallel_task_queue queue(thread_pool::get_instance());
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    queue.launch([&, i]() { parsed[i] = parser.parse(ranges[i]); });
+  }
+  queue.join();
+
+  sframe ret = parsed[0];
+  for (size_t i = 1; i < parsed.size(); ++i) ret = ret.append(parsed[i]);
+
+  if (parser.num_failures() > 0) {
+    logprogress_stream << parser.num_failures() << " lines failed to parse correctly"
+                       << std::endl;
+  }
+  logprogress_stream << "Parsing completed. Parsed " << ret.num_rows()
+                     << " lines in " << ti.current_time() << " secs." << std::endl;
+  return ret;
+}
+
+} // namespace turi
@@ -0,0 +1,86 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_JSON_LINES_PARSER_HPP
+#define TURI_SFRAME_JSON_LINES_PARSER_HPP
+#include <map>
+#include <string>
+#include <vector>
+#include <core/data/flexible_type/flexible_type.hpp>
+
+namespace turi {
+class sframe;
+
+/**
+ * \ingroup sframe_physical
+ * \addtogroup csv_utils CSV Parsing and Writing
+ * \{
+ */
+
+/**
+ * The options of \ref parse_json_lines().
+ */
+struct json_lines_options {
+  /**
+   * The number of records at the start of the first file the columns and
+   * their types are inferred from.
+   */
+  size_t sample_rows = 1000;
+
+  /**
+   * Types of columns, overriding the inferred ones. A hinted key which is
+   * not in the sample is a column as well.
+   */
+  std::map<std::string, flex_type_enum> column_type_hints;
+
+  /**
+   * Skip (and count) the records which cannot be parsed, or whose values
+   * cannot be stored in the types of their columns. Otherwise the first one
+   * throws.
+   */
+  bool continue_on_failure = false;
+};
+
+/**
+ * Parses a single JSON value from [begin, end) into a flexible_type:
+ *  - objects: flex_type_enum::DICT, with string keys
+ *  - arrays: flex_type_enum::VECTOR if all their values are numbers
+ *    (so empty arrays too), flex_type_enum::LIST otherwise
+ *  - integers fitting 64 bits: flex_type_enum::INTEGER, other numbers
+ *    flex_type_enum::FLOAT
+ *  - strings: flex_type_enum::STRING, unescaped to UTF-8
+ *  - true and false: the integers 1 and 0
+ *  - null: UNDEFINED
+ *
+ * Whitespace around the value is skipped. Returns false if there is no
+ * valid value, or something follows it.
+ */
+bool parse_json_value(const char* begin, const char* end, flexible_type& out);
+
+/**
+ * Reads the JSON lines file (or the files matching the glob) at url into
+ * an SFrame: every line is a JSON value, and empty lines are skipped.
+ *
+ * If the records of the sample are objects, each of their keys is a
+ * column, in the order they are first seen. The type of a column is the
+ * type of its values in the sample (see \ref parse_json_value()), integers
+ * and floats being FLOAT, vectors and lists LIST, and a mix of other types
+ * or only nulls STRING. The values of STRING columns which are not strings
+ * are their JSON text. Missing keys are UNDEFINED, and keys which are not
+ * columns are dropped. If the records are not objects, the SFrame has a
+ * single column X1 of these values.
+ *
+ * Since JSON strings cannot hold raw line breaks, every line break ends a
+ * record: the uncompressed files are cut into byte ranges, one per thread,
+ * each parsed directly into typed columns of an sframe of its own, and the
+ * sframes are appended. Compressed files are parsed in a single range.
+ */
+sframe parse_json_lines(const std::string& url,
+                        const json_lines_options& options = json_lines_options());
+
+/// \}
+} // namespace turi
+
+#endif
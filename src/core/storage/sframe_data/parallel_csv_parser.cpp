@@ -215,6 +215,7 @@ class parallel_csv_parser {
                       std::vector<size_t> column_output_order = std::vector<size_t>(),
                       size_t num_threads = thread_pool::get_instance().size()):
       nthreads(std::max<size_t>(num_threads, 2) - 1),
+      num_range_threads(std::max<size_t>(num_threads, 1)),
       parsed_buffer(nthreads), parsed_buffer_last_elem(nthreads),
       writing_buffer(nthreads), writing_buffer_last_elem(nthreads),
       error_buffer(nthreads), writing_error_buffer(nthreads),
@@ -337,6 +338,87 @@ class parallel_csv_parser {
     }
   }
 
+  /**
+   * Returns true if the files can be split into byte ranges and parsed by
+   * \ref parse_ranges. Needs the regular line terminator (which can be found
+   * from any offset), and no row limit (the first row_limit rows are only
+   * known once all the ranges before them are parsed).
+   */
+  bool can_parse_ranges() const {
+    return is_regular_line_terminator && row_limit == 0 &&
+        SFRAME_CSV_PARSER_MIN_RANGE_SIZE > 0;
+  }
+
+  /**
+   * Parses the seekable file at path from the offset data_start, the first
+   * line after its header, to its end.
+   *
+   * The file is cut into up to one byte range per thread (of at least
+   * SFRAME_CSV_PARSER_MIN_RANGE_SIZE bytes), and each thread reads and
+   * parses its own range straight into an sframe of its own. Where a range
+   * starts cannot be known without scanning everything before it: a range
+   * boundary may fall in a quoted field spanning lines, or in a comment. So
+   * every range guesses that its boundary is not quoted, and parses from
+   * the first line terminator it finds from there.
+   *
+   * The guesses are verified in order once all ranges are done: the range
+   * before is exact, and ends precisely where the next true line begins. A
+   * range which guessed wrong is then parsed again from there, and the
+   * ranges are appended (without copying) into the returned sframe.
+   *
+   * Bad lines are returned in errors if store_errors is set.
+   */
+  sframe parse_ranges(const std::string& path,
+                      size_t data_start,
+                      size_t file_size,
+                      const std::vector<std::string>& column_names,
+                      std::shared_ptr<sarray<flexible_type>>& errors) {
+    size_t data_size = file_size > data_start ? file_size - data_start : 0;
+    size_t num_ranges = std::min(num_range_threads,
+                                 data_size / SFRAME_CSV_PARSER_MIN_RANGE_SIZE);
+    num_ranges = std::max<size_t>(num_ranges, 1);
+    // the last range reads to the end of the file, whatever its size now
+    std::vector<size_t> boundaries(num_ranges + 1, (size_t)(-1));
+    for (size_t i = 0; i < num_ranges; ++i) {
+      boundaries[i] = data_start + data_size * i / num_ranges;
+    }
+    size_t read_size = std::max<size_t>(SFRAME_CSV_PARSER_READ_SIZE / num_ranges,
+                                        64 * 1024);
+
+    std::vector<csv_line_tokenizer> tokenizers(num_ranges,
+                                               thread_local_tokenizer[0]);
+    std::vector<range_result> ranges(num_ranges);
+    for (size_t i = 0; i < num_ranges; ++i) {
+      read_group.launch([&, i] {
+        ranges[i] = parse_range(path, boundaries[i], boundaries[i + 1],
+                                i == 0, read_size, tokenizers[i], column_names);
+      });
+    }
+    read_group.join();
+
+    // verify the guesses in order. The first range starts on a line.
+    size_t line_start = data_start;
+    for (size_t i = 0; i < num_ranges; ++i) {
+      if (ranges[i].first_line != line_start) {
+        logstream(LOG_INFO) << "Range " << i << " of " << sanitize_url(path)
+                            << " did not start on a line. Parsing it again."
+                            << std::endl;
+        ranges[i] = parse_range(path, line_start, boundaries[i + 1],
+                                true, read_size, tokenizers[i], column_names);
+      }
+      line_start = ranges[i].end;
+    }
+
+    sframe rows = ranges[0].rows;
+    for (size_t i = 1; i < num_ranges; ++i) rows = rows.append(ranges[i].rows);
+    errors = ranges[0].errors;
+    for (size_t i = 1; i < num_ranges; ++i) {
+      errors = std::make_shared<sarray<flexible_type>>(
+          errors->append(*ranges[i].errors));
+    }
+    return rows;
+  }
+
   /**
    * Returns the number of lines which failed to parse
    */
@@ -383,6 +465,8 @@ class parallel_csv_parser {
  private:
   /// number of threads
   size_t nthreads;
+  /// number of byte ranges parse_ranges() cuts a file into
+  size_t num_range_threads;
   /// thread local parse output buffer
   std::vector<std::vector<std::vector<flexible_type> > > parsed_buffer;
   /// Number of elements in each thread local parse output buffer
@@ -509,14 +593,19 @@ class parallel_csv_parser {
     return c;
   }
 
-  /// parses the line between pstart to pnext, using threadid's buffer
-  void parse_line(char* pstart, char* pnext, size_t threadid) {
+  /**
+   * Tokenizes the line between pstart and pnext into tokens, which is resized
+   * and typed for the output columns. Returns true if the line is a row.
+   * Lines which fail to parse are appended to errors if store_errors is set,
+   * and throw unless continue_on_failure is set. Empty and comment lines
+   * are silently skipped.
+   */
+  bool tokenize_row(char* pstart, char* pnext,
+                    csv_line_tokenizer& tokenizer,
+                    std::vector<flexible_type>& local_tokens,
+                    std::vector<flexible_type>& errors) {
     // this is the current character I am scanning
-    const char comment_char = thread_local_tokenizer[threadid].comment_char;
-    // clear local tokens
-    size_t nextelem = parsed_buffer_last_elem[threadid];
-    if (nextelem >= parsed_buffer[threadid].size()) parsed_buffer[threadid].resize(nextelem + 1);
-    std::vector<flexible_type>& local_tokens = parsed_buffer[threadid][nextelem];
+    const char comment_char = tokenizer.comment_char;
     local_tokens.resize(column_types.size());
     for (size_t i = 0;i < column_types.size(); ++i) {
       if (local_tokens[i].get_type() != column_types[i]) {
@@ -527,48 +616,57 @@ class parallel_csv_parser {
         column_output_order.empty() ? nullptr : &column_output_order;
 
     size_t num_tokens_parsed =
-        thread_local_tokenizer[threadid].
-        tokenize_line(pstart, pnext - pstart,
-                      local_tokens,
-                      true /*permit undefined*/,
-                      ptr_to_output_order);
-
-    if (num_tokens_parsed == num_input_columns()) {
-      ++parsed_buffer_last_elem[threadid];
-    } else {
-
-      // incomplete parse
-      std::string badline(pstart, pnext - pstart);
-      boost::algorithm::trim(badline);
-
-      if (!badline.empty() && badline[0] != comment_char) {
-        // keep track of line for error reporting
-        if (store_errors) error_buffer[threadid].push_back(badline);
-        if (continue_on_failure) {
-          if (num_failures.value < 10) {
-            if (!thread_local_tokenizer[threadid].get_last_parse_error_diagnosis().empty()) {
-              logprogress_stream << thread_local_tokenizer[threadid].get_last_parse_error_diagnosis()
-                                 << std::endl;
-            } else {
-              std::string badline = std::string(pstart, pnext - pstart);
-              if (badline.length() > 256) badline=badline.substr(0, 256) + "...";
-              logprogress_stream << std::string("Unable to parse line \"") +
-                                 badline + "\"" << std::endl;
-            }
-          }
-          ++num_failures;
-        } else {
-          if (!thread_local_tokenizer[threadid].get_last_parse_error_diagnosis().empty()) {
-            logprogress_stream << thread_local_tokenizer[threadid].get_last_parse_error_diagnosis()
+        tokenizer.tokenize_line(pstart, pnext - pstart,
+                                local_tokens,
+                                true /*permit undefined*/,
+                                ptr_to_output_order);
+
+    if (num_tokens_parsed == num_input_columns()) return true;
+
+    // incomplete parse
+    std::string badline(pstart, pnext - pstart);
+    boost::algorithm::trim(badline);
+
+    if (!badline.empty() && badline[0] != comment_char) {
+      // keep track of line for error reporting
+      if (store_errors) errors.push_back(badline);
+      if (continue_on_failure) {
+        if (num_failures.value < 10) {
+          if (!tokenizer.get_last_parse_error_diagnosis().empty()) {
+            logprogress_stream << tokenizer.get_last_parse_error_diagnosis()
                                << std::endl;
+          } else {
+            std::string badline = std::string(pstart, pnext - pstart);
+            if (badline.length() > 256) badline=badline.substr(0, 256) + "...";
+            logprogress_stream << std::string("Unable to parse line \"") +
+                               badline + "\"" << std::endl;
           }
-          std::string badline = std::string(pstart, pnext - pstart);
-          if (badline.length() > 256) badline=badline.substr(0, 256) + "...";
-          log_and_throw(std::string("Unable to parse line \"") +
-                        badline + "\"\n");
         }
+        ++num_failures;
+      } else {
+        if (!tokenizer.get_last_parse_error_diagnosis().empty()) {
+          logprogress_stream << tokenizer.get_last_parse_error_diagnosis()
+                             << std::endl;
+        }
+        std::string badline = std::string(pstart, pnext - pstart);
+        if (badline.length() > 256) badline=badline.substr(0, 256) + "...";
+        log_and_throw(std::string("Unable to parse line \"") +
+                      badline + "\"\n");
       }
     }
+    return false;
+  }
+
+  /// parses the line between pstart to pnext, using threadid's buffer
+  void parse_line(char* pstart, char* pnext, size_t threadid) {
+    // clear local tokens
+    size_t nextelem = parsed_buffer_last_elem[threadid];
+    if (nextelem >= parsed_buffer[threadid].size()) parsed_buffer[threadid].resize(nextelem + 1);
+    if (tokenize_row(pstart, pnext, thread_local_tokenizer[threadid],
+                     parsed_buffer[threadid][nextelem],
+                     error_buffer[threadid])) {
+      ++parsed_buffer_last_elem[threadid];
+    }
   }
 
   /**
@@ -898,6 +996,191 @@ class parallel_csv_parser {
     }
   }
 
+  /// The output of parse_range()
+  struct range_result {
+    /// File offset of the first line the range parsed from
+    size_t first_line = 0;
+    /// File offset of the first line at or after the end of the range
+    size_t end = 0;
+    sframe rows;
+    std::shared_ptr<sarray<flexible_type>> errors;
+  };
+
+  /**
+   * Parses into an sframe (and errors into an sarray) the lines of path
+   * which begin in [begin, end).
+   *
+   * If begin_is_line_start is set, begin is known to be the start of a line.
+   * Otherwise this is a guess: the range is assumed to be outside of quotes
+   * and comments at begin - 1, and starts from the first line terminator
+   * found from there (so a line beginning exactly at begin is kept).
+   *
+   * The quoting rules are the ones of find_true_new_line_positions(), applied
+   * while reading the range read_size bytes at a time.
+   */
+  range_result parse_range(const std::string& path,
+                           size_t begin, size_t end, bool begin_is_line_start,
+                           size_t read_size,
+                           csv_line_tokenizer& tokenizer,
+                           const std::vector<std::string>& column_names) {
+    range_result ret;
+    ret.rows.open_for_write(column_names, column_types, "", 1);
+    ret.errors = std::make_shared<sarray<flexible_type>>();
+    ret.errors->open_for_write(1);
+    ret.errors->set_type(flex_type_enum::STRING);
+
+    const char escape_char = tokenizer.escape_char;
+    const char quote_char = tokenizer.quote_char;
+    const char comment_char = tokenizer.comment_char;
+    const bool has_comment_char = tokenizer.has_comment_char;
+
+    // the characters which may change the scan state, in and out of quotes
+    // and comments
+    bool is_special[256] = {false};
+    bool is_special_in_quote[256] = {false};
+    bool is_special_in_comment[256] = {false};
+    is_special[(unsigned char)'\n'] = is_special[(unsigned char)'\r'] = true;
+    is_special[(unsigned char)quote_char] = true;
+    is_special[(unsigned char)escape_char] = true;
+    if (has_comment_char) is_special[(unsigned char)comment_char] = true;
+    is_special_in_quote[(unsigned char)quote_char] = true;
+    is_special_in_quote[(unsigned char)escape_char] = true;
+    is_special_in_comment[(unsigned char)'\n'] = true;
+    is_special_in_comment[(unsigned char)'\r'] = true;
+
+    size_t scan_start = begin_is_line_start ? begin : begin - 1;
+    general_ifstream fin(path);
+    fin.seekg(scan_start, std::ios_base::beg);
+    if (!fin.good()) {
+      log_and_throw_io_failure("Cannot seek in " + sanitize_url(path));
+    }
+
+    std::string buffer;
+    // file offset of buffer[0]
+    size_t buffer_offset = scan_start;
+    size_t pos = 0;
+    size_t line_begin = 0;
+    bool eof = false;
+    bool in_quote = false, in_comment = false, escaped = false;
+    bool found_first_line = begin_is_line_start;
+    ret.first_line = begin;
+
+    auto out = ret.rows.get_output_iterator(0);
+    auto errors_out = ret.errors->get_output_iterator(0);
+    std::vector<flexible_type> local_tokens;
+    std::vector<flexible_type> local_errors;
+    size_t local_lines = 0;
+
+    // reads the next read_size bytes, dropping what was already parsed
+    auto fill_buffer = [&]() {
+      size_t keep_from = found_first_line ? line_begin : pos;
+      buffer.erase(0, keep_from);
+      buffer_offset += keep_from;
+      pos -= keep_from;
+      line_begin -= std::min(line_begin, keep_from);
+      size_t oldsize = buffer.size();
+      buffer.resize(oldsize + read_size);
+      fin.read(&(buffer[0]) + oldsize, read_size);
+      if (fin.bad()) {
+        log_and_throw_io_failure("Read of " + sanitize_url(path) + " failed");
+      }
+      buffer.resize(oldsize + fin.gcount());
+      if ((size_t)fin.gcount() < read_size) eof = true;
+
+      std::copy(local_errors.begin(), local_errors.end(), errors_out);
+      local_errors.clear();
+      lines_read.inc(local_lines);
+      local_lines = 0;
+      if(cppipc::must_cancel()) {
+        log_and_throw(std::string("CSV parsing cancelled"));
+      }
+      logprogress_stream_ontick(5) << "Read " << lines_read.value
+                                   << " lines. Lines per second: "
+                                   << lines_read.value / get_time_elapsed()
+                                   << "\t" << std::endl;
+    };
+
+    // a line starting at or after end belongs to the next range
+    bool range_done = begin_is_line_start && begin >= end;
+    while (!range_done) {
+      if (pos == buffer.size()) {
+        if (eof) break;
+        fill_buffer();
+        continue;
+      }
+      // fast path. skip the characters which do not change the state
+      if (!escaped) {
+        const bool* special = in_comment ? is_special_in_comment :
+                              in_quote ? is_special_in_quote : is_special;
+        while (pos < buffer.size() && !special[(unsigned char)buffer[pos]]) ++pos;
+        if (pos == buffer.size()) continue;
+      }
+      const char c = buffer[pos];
+      const bool is_newline = (c == '\n' || c == '\r');
+      // a \r may be the first half of a \r\n in the next read
+      if (c == '\r' && pos + 1 == buffer.size() && !eof) {
+        fill_buffer();
+        continue;
+      }
+      bool line_ended = false;
+      if (in_comment) {
+        in_comment = !is_newline;
+        line_ended = is_newline;
+      } else if (has_comment_char && c == comment_char &&
+                 !escaped && !in_quote) {
+        in_comment = true;
+      } else {
+        in_quote ^= (c == quote_char && !escaped);
+        line_ended = is_newline && !in_quote;
+        escaped = !escaped && c == escape_char;
+      }
+      if (!line_ended) {
+        ++pos;
+        continue;
+      }
+
+      size_t next_line = pos + 1;
+      if (c == '\r' && next_line < buffer.size() && buffer[next_line] == '\n') {
+        ++next_line;
+      }
+      if (found_first_line) {
+        if (tokenize_row(&(buffer[0]) + line_begin, &(buffer[0]) + pos,
+                         tokenizer, local_tokens, local_errors)) {
+          *out = local_tokens;
+          ++out;
+          ++local_lines;
+        }
+      } else {
+        found_first_line = true;
+        ret.first_line = buffer_offset + next_line;
+      }
+      line_begin = pos = next_line;
+      range_done = buffer_offset + next_line >= end;
+    }
+
+    if (range_done) {
+      ret.end = buffer_offset + line_begin;
+    } else {
+      // the end of the file. The last line may have no line terminator.
+      ret.end = buffer_offset + buffer.size();
+      if (!found_first_line) {
+        ret.first_line = ret.end;
+      } else if (line_begin < buffer.size() &&
+                 tokenize_row(&(buffer[0]) + line_begin,
+                              &(buffer[0]) + buffer.size(),
+                              tokenizer, local_tokens, local_errors)) {
+        *out = local_tokens;
+        ++out;
+        ++local_lines;
+      }
+    }
+    std::copy(local_errors.begin(), local_errors.end(), errors_out);
+    lines_read.inc(local_lines);
+    ret.rows.close();
+    ret.errors->close();
+    return ret;
+  }
+
   /**
    * Spins up a background thread to write parse results from parallel_parse
    * to the output frame. First the parsed_buffer is swapped into the
@@ -1120,6 +1403,10 @@ void get_column_types(csv_info& info,
  * \param parallel_csv_parser A parallel_csv_parser
  * \param errors A reference to a map in which to store an sarray of bad lines
  * for each input file.
+ * \param parse_ranges If true, the file is cut in byte ranges parsed in
+ * parallel (see parallel_csv_parser::parse_ranges), and the rows are appended
+ * to frame, which must not be opened for write. Otherwise the rows are
+ * written to frame, which must be opened for write.
  */
 void parse_csv_to_sframe(
     const std::string& path,
@@ -1128,7 +1415,8 @@ void parse_csv_to_sframe(
     sframe& frame,
     std::string frame_sidx_file,
     parallel_csv_parser& parser,
-    std::map<std::string, std::shared_ptr<sarray<flexible_type>>>& errors) {
+    std::map<std::string, std::shared_ptr<sarray<flexible_type>>>& errors,
+    bool parse_ranges) {
   auto use_header = options.use_header;
   auto continue_on_failure = options.continue_on_failure;
   auto store_errors = options.store_errors;
@@ -1170,17 +1458,49 @@ void parse_csv_to_sframe(
 
     // store errors for this particular file in an sarray
     auto file_errors = std::make_shared<sarray<flexible_type>>();
-    if (store_errors) {
-      file_errors->open_for_write();
-      file_errors->set_type(flex_type_enum::STRING);
+    bool ranges_parsed = false;
+    if (parse_ranges) {
+      // the rest of the file is parsed from its offset by many threads
+      std::streamoff data_start = fin.tellg();
+      size_t file_size = fin.file_size();
+      if (data_start >= 0 && file_size != (size_t)(-1)) {
+        fin.close();
+        frame = frame.append(parser.parse_ranges(path, data_start, file_size,
+                                                 frame.column_names(),
+                                                 file_errors));
+        ranges_parsed = true;
+      } else {
+        logstream(LOG_INFO) << "Cannot find the size of " << sanitize_url(path)
+                            << ". Parsing it sequentially." << std::endl;
+      }
     }
 
-    try {
-      parser.parse(fin, frame, *file_errors);
-    } catch(const std::string& s) {
-      frame.close();
+    if (!ranges_parsed) {
+      // frame is not opened for write when parsing by ranges, so the rows
+      // of a file which cannot be cut into ranges go to a frame of their
+      // own, which is then appended.
+      sframe file_frame;
+      sframe& output = parse_ranges ? file_frame : frame;
+      if (parse_ranges) {
+        file_frame.open_for_write(frame.column_names(), frame.column_types(), "",
+                                  std::max<size_t>(1, num_temp_directories()));
+      }
+      if (store_errors) {
+        file_errors->open_for_write();
+        file_errors->set_type(flex_type_enum::STRING);
+      }
+      try {
+        parser.parse(fin, output, *file_errors);
+      } catch(const std::string& s) {
+        output.close();
+        if (store_errors) file_errors->close();
+        log_and_throw(s);
+      }
+      if (parse_ranges) {
+        file_frame.close();
+        frame = frame.append(file_frame);
+      }
       if (store_errors) file_errors->close();
-      log_and_throw(s);
     }
 
     if (continue_on_failure && parser.num_lines_failed() > 0) {
@@ -1190,7 +1510,6 @@ void parse_csv_to_sframe(
     }
 
     if (store_errors) {
-      file_errors->close();
       if (file_errors->size() > 0) {
         errors.insert(std::make_pair(path, file_errors));
       }
@@ -1329,7 +1648,20 @@ std::map<std::string, std::shared_ptr<sarray<flexible_type>>> parse_csvs_to_sfra
   }
   parser.set_total_input_size(total_input_file_sizes);
 
-  if (!frame.is_opened_for_write()) {
+  // files which can be read from any offset are parsed by byte ranges in
+  // parallel, and each range is appended to the frame
+  bool parse_ranges = parser.can_parse_ranges() &&
+      frame_sidx_file.empty() && !frame.is_opened_for_write();
+  for (const auto& file : files) {
+    // gzip compressed files are read sequentially
+    if (boost::algorithm::ends_with(file, ".gz")) parse_ranges = false;
+  }
+
+  if (parse_ranges) {
+    // start from an empty frame
+    frame.open_for_write(info.column_names, info.column_types, "", 1);
+    frame.close();
+  } else if (!frame.is_opened_for_write()) {
     // open as many segments as there are temp directories.
     // But at least one segment
     frame.open_for_write(info.column_names, info.column_types,
@@ -1347,7 +1679,7 @@ std::map<std::string, std::shared_ptr<sarray<flexible_type>>> parse_csvs_to_sfra
     // check that we've read < row_limit
     if (parser.num_lines_read() < row_limit || row_limit == 0) {
       parse_csv_to_sframe(file, tokenizer, options, frame,
-                          frame_sidx_file, parser, errors);
+                          frame_sidx_file, parser, errors, parse_ranges);
     } else break;
   }
 
@@ -56,6 +56,12 @@ struct csv_file_handling_options {
 /**
  * Parses a CSV file / glob of CSV files to an SFrame.
  *
+ * Unless a row limit, a custom line terminator or a frame_sidx_file is given,
+ * or a file is gzip compressed, every file is cut in byte ranges which are
+ * read and parsed in parallel (see SFRAME_CSV_PARSER_MIN_RANGE_SIZE).
+ * Otherwise the files are read sequentially, and parsed in parallel one
+ * buffer at a time.
+ *
  * \param url Path or Glob to read files
  * \param tokenizer CSV tokenization options
  * \param options Other file handling options
@@ -0,0 +1,1073 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <cstring>
+#include <zlib.h>
+#include <lz4/lz4.h>
+#include <core/logging/logger.hpp>
+#include <core/storage/sframe_data/parquet_format.hpp>
+
+namespace turi {
+namespace parquet {
+
+namespace {
+
+/// The value types of the Thrift compact protocol
+enum compact_type : uint8_t {
+  CT_STOP = 0,
+  CT_TRUE = 1,
+  CT_FALSE = 2,
+  CT_BYTE = 3,
+  CT_I16 = 4,
+  CT_I32 = 5,
+  CT_I64 = 6,
+  CT_DOUBLE = 7,
+  CT_BINARY = 8,
+  CT_LIST = 9,
+  CT_SET = 10,
+  CT_MAP = 11,
+  CT_STRUCT = 12
+};
+
+/// Deeper structures are rejected as corrupt
+static constexpr size_t MAX_NESTING_DEPTH = 64;
+
+void throw_corrupt_metadata() {
+  log_and_throw("Corrupted Parquet metadata");
+}
+
+/**
+ * Reads values of the Thrift compact protocol from a buffer, throwing if
+ * they run past its end.
+ */
+class compact_reader {
+ public:
+  compact_reader(const char* data, size_t len)
+      : m_begin((const uint8_t*)data), m_pos(m_begin), m_end(m_begin + len) { }
+
+  size_t position() const { return m_pos - m_begin; }
+
+  uint8_t read_byte() {
+    if (m_pos >= m_end) throw_corrupt_metadata();
+    return *(m_pos++);
+  }
+
+  uint64_t read_varint() {
+    uint64_t ret = 0;
+    for (size_t shift = 0; shift < 64; shift += 7) {
+      uint8_t b = read_byte();
+      ret |= uint64_t(b & 0x7F) << shift;
+      if ((b & 0x80) == 0) return ret;
+    }
+    throw_corrupt_metadata();
+    return 0;
+  }
+
+  int64_t read_i64() {
+    uint64_t v = read_varint();
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+  }
+
+  int32_t read_i32() { return (int32_t)read_i64(); }
+
+  double read_double() {
+    ensure(8);
+    double ret;
+    memcpy(&ret, m_pos, 8);
+    m_pos += 8;
+    return ret;
+  }
+
+  std::string read_binary() {
+    uint64_t len = read_varint();
+    ensure(len);
+    std::string ret((const char*)m_pos, len);
+    m_pos += len;
+    return ret;
+  }
+
+  void read_list_header(uint8_t& elem_type, size_t& size) {
+    uint8_t b = read_byte();
+    elem_type = b & 0x0F;
+    size = b >> 4;
+    if (size == 15) size = read_varint();
+    // every element is at least a byte, except for empty structs
+    if (elem_type != CT_STRUCT && size > size_t(m_end - m_pos)) {
+      throw_corrupt_metadata();
+    }
+  }
+
+  /**
+   * Reads the header of the next field of a struct. Returns false at the end
+   * of the struct. last_id is the id of the previous field of the struct.
+   */
+  bool read_field_header(int16_t& last_id, int16_t& id, uint8_t& type) {
+    uint8_t b = read_byte();
+    type = b & 0x0F;
+    if (type == CT_STOP) return false;
+    int16_t delta = b >> 4;
+    id = delta ? last_id + delta : (int16_t)read_i64();
+    last_id = id;
+    return true;
+  }
+
+  /**
+   * Skips a value of the type. Booleans are a byte in lists, and part of
+   * the field header in structs.
+   */
+  void skip(uint8_t type, bool in_list = false, size_t depth = 0) {
+    if (depth > MAX_NESTING_DEPTH) throw_corrupt_metadata();
+    switch (type) {
+      case CT_TRUE:
+      case CT_FALSE:
+        if (in_list) read_byte();
+        break;
+      case CT_BYTE:
+        read_byte();
+        break;
+      case CT_I16:
+      case CT_I32:
+      case CT_I64:
+        read_varint();
+        break;
+      case CT_DOUBLE:
+        ensure(8);
+        m_pos += 8;
+        break;
+      case CT_BINARY: {
+        uint64_t len = read_varint();
+        ensure(len);
+        m_pos += len;
+        break;
+      }
+      case CT_LIST:
+      case CT_SET: {
+        uint8_t elem_type;
+        size_t size;
+        read_list_header(elem_type, size);
+        for (size_t i = 0; i < size; ++i) skip(elem_type, true, depth + 1);
+        break;
+      }
+      case CT_MAP: {
+        size_t size = read_varint();
+        if (size == 0) break;
+        uint8_t types = read_byte();
+        for (size_t i = 0; i < size; ++i) {
+          skip(types >> 4, true, depth + 1);
+          skip(types & 0x0F, true, depth + 1);
+        }
+        break;
+      }
+      case CT_STRUCT: {
+        int16_t last_id = 0, id;
+        uint8_t field_type;
+        while (read_field_header(last_id, id, field_type)) {
+          skip(field_type, false, depth + 1);
+        }
+        break;
+      }
+      default:
+        throw_corrupt_metadata();
+    }
+  }
+
+ private:
+  void ensure(uint64_t len) {
+    if (len > uint64_t(m_end - m_pos)) throw_corrupt_metadata();
+  }
+
+  const uint8_t* m_begin;
+  const uint8_t* m_pos;
+  const uint8_t* m_end;
+};
+
+/**
+ * Calls on_field(id, type) for every field of the struct read next. Fields
+ * for which on_field returns false are skipped.
+ */
+template <typename F>
+void read_struct(compact_reader& in, F on_field) {
+  int16_t last_id = 0, id;
+  uint8_t type;
+  while (in.read_field_header(last_id, id, type)) {
+    if (!on_field(id, type)) in.skip(type);
+  }
+}
+
+/**
+ * Calls on_element() for every element of the list read next, if its
+ * elements are of the expected type. Returns false otherwise.
+ */
+template <typename F>
+bool read_list(compact_reader& in, uint8_t expected_type, F on_element) {
+  uint8_t elem_type;
+  size_t size;
+  in.read_list_header(elem_type, size);
+  if (elem_type != expected_type) {
+    for (size_t i = 0; i < size; ++i) in.skip(elem_type, true);
+    return true;
+  }
+  for (size_t i = 0; i < size; ++i) on_element();
+  return true;
+}
+
+/**
+ * Writes the values of the Thrift compact protocol.
+ */
+class compact_writer {
+ public:
+  explicit compact_writer(std::string& out): m_out(out) { }
+
+  void byte(uint8_t b) { m_out.push_back((char)b); }
+
+  void varint(uint64_t v) {
+    while (v >= 0x80) {
+      byte((uint8_t)(v | 0x80));
+      v >>= 7;
+    }
+    byte((uint8_t)v);
+  }
+
+  void zigzag(int64_t v) { varint((uint64_t(v) << 1) ^ uint64_t(v >> 63)); }
+
+  void binary(const std::string& s) {
+    varint(s.size());
+    m_out.append(s);
+  }
+
+  void field(int16_t id, uint8_t type) {
+    int16_t delta = id - m_last_id;
+    if (delta > 0 && delta <= 15) {
+      byte((uint8_t)((delta << 4) | type));
+    } else {
+      byte(type);
+      zigzag(id);
+    }
+    m_last_id = id;
+  }
+
+  void i32_field(int16_t id, int32_t v) { field(id, CT_I32); zigzag(v); }
+  void i64_field(int16_t id, int64_t v) { field(id, CT_I64); zigzag(v); }
+  void bool_field(int16_t id, bool v) { field(id, v ? CT_TRUE : CT_FALSE); }
+
+  void binary_field(int16_t id, const std::string& s) {
+    field(id, CT_BINARY);
+    binary(s);
+  }
+
+  void list_field(int16_t id, uint8_t elem_type, size_t size) {
+    field(id, CT_LIST);
+    if (size < 15) {
+      byte((uint8_t)((size << 4) | elem_type));
+    } else {
+      byte((uint8_t)(0xF0 | elem_type));
+      varint(size);
+    }
+  }
+
+  /// Starts a struct valued field, or a struct element of a list if id is 0
+  void begin_struct(int16_t id = 0) {
+    if (id) field(id, CT_STRUCT);
+    m_stack.push_back(m_last_id);
+    m_last_id = 0;
+  }
+
+  void end_struct() {
+    byte(CT_STOP);
+    m_last_id = m_stack.back();
+    m_stack.pop_back();
+  }
+
+ private:
+  std::string& m_out;
+  int16_t m_last_id = 0;
+  std::vector<int16_t> m_stack;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Metadata structures
+
+void read_statistics(compact_reader& in, statistics& out) {
+  statistics legacy;
+  read_struct(in, [&](int16_t id, uint8_t type) -> bool {
+    if (id == 1 && type == CT_BINARY) {
+      legacy.max_value = in.read_binary();
+      legacy.has_max = true;
+    } else if (id == 2 && type == CT_BINARY) {
+      legacy.min_value = in.read_binary();
+      legacy.has_min = true;
+    } else if (id == 3 && type == CT_I64) {
+      out.null_count = in.read_i64();
+    } else if (id == 5 && type == CT_BINARY) {
+      out.max_value = in.read_binary();
+      out.has_max = true;
+    } else if (id == 6 && type == CT_BINARY) {
+      out.min_value = in.read_binary();
+      out.has_min = true;
+    } else {
+      return false;
+    }
+    return true;
+  });
+  // the deprecated fields are only used if the new ones are missing
+  if (!out.has_min && !out.has_max && (legacy.has_min || legacy.has_max)) {
+    out.has_min = legacy.has_min;
+    out.has_max = legacy.has_max;
+    out.min_value = std::move(legacy.min_value);
+    out.max_value = std::move(legacy.max_value);
+    out.legacy_min_max = true;
+  }
+}
+
+void read_column_metadata(compact_reader& in, column_metadata& out) {
+  read_struct(in, [&](int16_t id, uint8_t type) -> bool {
+    if (id == 1 && type == CT_I32) {
+      out.type = (physical_type)in.read_i32();
+    } else if (id == 2 && type == CT_LIST) {
+      return read_list(in, CT_I32, [&]() {
+        out.encodings.push_back((encoding)in.read_i32());
+      });
+    } else if (id == 3 && type == CT_LIST) {
+      return read_list(in, CT_BINARY, [&]() {
+        out.path.push_back(in.read_binary());
+      });
+    } else if (id == 4 && type == CT_I32) {
+      out.codec = (compression_codec)in.read_i32();
+    } else if (id == 5 && type == CT_I64) {
+      out.num_values = in.read_i64();
+    } else if (id == 6 && type == CT_I64) {
+      out.total_uncompressed_size = in.read_i64();
+    } else if (id == 7 && type == CT_I64) {
+      out.total_compressed_size = in.read_i64();
+    } else if (id == 9 && type == CT_I64) {
+      out.data_page_offset = in.read_i64();
+    } else if (id == 11 && type == CT_I64) {
+      out.dictionary_page_offset = in.read_i64();
+    } else if (id == 12 && type == CT_STRUCT) {
+      read_statistics(in, out.stats);
+    } else {
+      return false;
+    }
+    return true;
+  });
+}
+
+void read_column_chunk(compact_reader& in, column_chunk& out) {
+  read_struct(in, [&](int16_t id, uint8_t type) -> bool {
+    if (id == 1 && type == CT_BINARY) {
+      out.file_path = in.read_binary();
+    } else if (id == 2 && type == CT_I64) {
+      out.file_offset = in.read_i64();
+    } else if (id == 3 && type == CT_STRUCT) {
+      read_column_metadata(in, out.meta_data);
+    } else {
+      return false;
+    }
+    return true;
+  });
+}
+
+void read_row_group(compact_reader& in, row_group& out) {
+  read_struct(in, [&](int16_t id, uint8_t type) -> bool {
+    if (id == 1 && type == CT_LIST) {
+      return read_list(in, CT_STRUCT, [&]() {
+        out.columns.emplace_back();
+        read_column_chunk(in, out.columns.back());
+      });
+    } else if (id == 2 && type == CT_I64) {
+      out.total_byte_size = in.read_i64();
+    } else if (id == 3 && type == CT_I64) {
+      out.num_rows = in.read_i64();
+    } else {
+      return false;
+    }
+    return true;
+  });
+}
+
+/// Reads the TimeUnit union of the TIME and TIMESTAMP logical types
+time_unit read_time_unit(compact_reader& in) {
+  time_unit ret = time_unit::NONE;
+  read_struct(in, [&](int16_t id, uint8_t type) -> bool {
+    if (type != CT_STRUCT || id < 1 || id > 3) return false;
+    in.skip(type);
+    ret = (time_unit)id;
+    return true;
+  });
+  return ret;
+}
+
+/// Reads the LogicalType union
+void read_logical_type(compact_reader& in, schema_element& out) {
+  read_struct(in, [&](int16_t id, uint8_t type) -> bool {
+    if (type != CT_STRUCT) return false;
+    out.logical = (logical_type)id;
+    if (out.logical == logical_type::DECIMAL) {
+      read_struct(in, [&](int16_t field_id, uint8_t field_type) -> bool {
+        if (field_id == 1 && field_type == CT_I32) {
+          out.scale = in.read_i32();
+        } else if (field_id == 2 && field_type == CT_I32) {
+          out.precision = in.read_i32();
+        } else {
+          return false;
+        }
+        return true;
+      });
+    } else if (out.logical == logical_type::TIME ||
+               out.logical == logical_type::TIMESTAMP) {
+      read_struct(in, [&](int16_t field_id, uint8_t field_type) -> bool {
+        if (field_id == 1 && (field_type == CT_TRUE || field_type == CT_FALSE)) {
+          out.is_adjusted_to_utc = (field_type == CT_TRUE);
+        } else if (field_id == 2 && field_type == CT_STRUCT) {
+          out.unit = read_time_unit(in);
+        } else {
+          return false;
+        }
+        return true;
+      });
+    } else {
+      in.skip(type);
+    }
+    return true;
+  });
+}
+
+void read_schema_element(compact_reader& in, schema_element& out) {
+  read_struct(in, [&](int16_t id, uint8_t type) -> bool {
+    if (id == 1 && type == CT_I32) {
+      out.type = (physical_type)in.read_i32();
+      out.has_type = true;
+    } else if (id == 2 && type == CT_I32) {
+      out.type_length = in.read_i32();
+    } else if (id == 3 && type == CT_I32) {
+      out.repetition = (repetition_type)in.read_i32();
+    } else if (id == 4 && type == CT_BINARY) {
+      out.name = in.read_binary();
+    } else if (id == 5 && type == CT_I32) {
+      out.num_children = in.read_i32();
+    } else if (id == 6 && type == CT_I32) {
+      out.converted = (converted_type)in.read_i32();
+    } else if (id == 7 && type == CT_I32) {
+      out.scale = in.read_i32();
+    } else if (id == 8 && type == CT_I32) {
+      out.precision = in.read_i32();
+    } else if (id == 10 && type == CT_STRUCT) {
+      read_logical_type(in, out);
+    } else {
+      return false;
+    }
+    return true;
+  });
+}
+
+void write_statistics(compact_writer& out, const statistics& stats) {
+  if (stats.null_count >= 0) out.i64_field(3, stats.null_count);
+  if (stats.has_max) out.binary_field(5, stats.max_value);
+  if (stats.has_min) out.binary_field(6, stats.min_value);
+}
+
+void write_schema_element(compact_writer& out, const schema_element& elem) {
+  if (elem.has_type) {
+    out.i32_field(1, (int32_t)elem.type);
+    if (elem.type == physical_type::FIXED_LEN_BYTE_ARRAY) {
+      out.i32_field(2, elem.type_length);
+    }
+  }
+  // the root has no repetition
+  if (elem.has_type || elem.num_children == 0) {
+    out.i32_field(3, (int32_t)elem.repetition);
+  }
+  out.binary_field(4, elem.name);
+  if (!elem.has_type) out.i32_field(5, elem.num_children);
+  if (elem.converted != converted_type::NONE) {
+    out.i32_field(6, (int32_t)elem.converted);
+  }
+  if (elem.converted == converted_type::DECIMAL) {
+    out.i32_field(7, elem.scale);
+    out.i32_field(8, elem.precision);
+  }
+  if (elem.logical != logical_type::NONE) {
+    out.begin_struct(10);
+    out.begin_struct((int16_t)elem.logical);
+    if (elem.logical == logical_type::DECIMAL) {
+      out.i32_field(1, elem.scale);
+      out.i32_field(2, elem.precision);
+    } else if (elem.logical == logical_type::TIME ||
+               elem.logical == logical_type::TIMESTAMP) {
+      out.bool_field(1, elem.is_adjusted_to_utc);
+      out.begin_struct(2);
+      out.begin_struct((int16_t)elem.unit);
+      out.end_struct();
+      out.end_struct();
+    }
+    out.end_struct();
+    out.end_struct();
+  }
+}
+
+void write_column_metadata(compact_writer& out, const column_metadata& meta) {
+  out.i32_field(1, (int32_t)meta.type);
+  out.list_field(2, CT_I32, meta.encodings.size());
+  for (auto e: meta.encodings) out.zigzag((int32_t)e);
+  out.list_field(3, CT_BINARY, meta.path.size());
+  for (const auto& p: meta.path) out.binary(p);
+  out.i32_field(4, (int32_t)meta.codec);
+  out.i64_field(5, meta.num_values);
+  out.i64_field(6, meta.total_uncompressed_size);
+  out.i64_field(7, meta.total_compressed_size);
+  out.i64_field(9, meta.data_page_offset);
+  if (meta.dictionary_page_offset >= 0) {
+    out.i64_field(11, meta.dictionary_page_offset);
+  }
+  out.begin_struct(12);
+  write_statistics(out, meta.stats);
+  out.end_struct();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Snappy
+
+/// Snappy compresses blocks of up to 64KB independently
+static constexpr size_t SNAPPY_BLOCK_SIZE = 1 << 16;
+static constexpr size_t SNAPPY_HASH_BITS = 14;
+
+inline uint32_t load32(const char* p) {
+  uint32_t ret;
+  memcpy(&ret, p, 4);
+  return ret;
+}
+
+void snappy_emit_literal(const char* begin, size_t len, std::string& out) {
+  if (len == 0) return;
+  size_t n = len - 1;
+  if (n < 60) {
+    out.push_back((char)(n << 2));
+  } else {
+    size_t num_bytes = n < (1 << 8) ? 1 : n < (1 << 16) ? 2 : n < (1 << 24) ? 3 : 4;
+    out.push_back((char)((59 + num_bytes) << 2));
+    for (size_t i = 0; i < num_bytes; ++i) out.push_back((char)(n >> (8 * i)));
+  }
+  out.append(begin, len);
+}
+
+void snappy_emit_copy(size_t offset, size_t len, std::string& out) {
+  while (len > 0) {
+    // copies are at most 64 bytes. Keep at least 4 for the last one.
+    size_t l = len > 64 ? (len - 64 < 4 ? 60 : 64) : len;
+    if (l >= 4 && l < 12 && offset < 2048) {
+      out.push_back((char)(1 | ((l - 4) << 2) | ((offset >> 8) << 5)));
+      out.push_back((char)(offset & 0xFF));
+    } else {
+      out.push_back((char)(2 | ((l - 1) << 2)));
+      out.push_back((char)(offset & 0xFF));
+      out.push_back((char)(offset >> 8));
+    }
+    len -= l;
+  }
+}
+
+void snappy_compress(const char* in, size_t in_len, std::string& out) {
+  compact_writer(out).varint(in_len);
+  std::vector<uint16_t> table(1 << SNAPPY_HASH_BITS);
+  for (size_t block = 0; block < in_len; block += SNAPPY_BLOCK_SIZE) {
+    const char* base = in + block;
+    size_t len = std::min(SNAPPY_BLOCK_SIZE, in_len - block);
+    std::fill(table.begin(), table.end(), 0);
+    size_t literal_start = 0;
+    size_t pos = 0;
+    // the step grows while nothing matches, to go over incompressible data
+    size_t misses = 32;
+    while (pos + 4 <= len) {
+      uint32_t v = load32(base + pos);
+      uint32_t h = (v * 0x1e35a7bd) >> (32 - SNAPPY_HASH_BITS);
+      size_t candidate = table[h];
+      table[h] = (uint16_t)pos;
+      if (candidate < pos && load32(base + candidate) == v) {
+        snappy_emit_literal(base + literal_start, pos - literal_start, out);
+        size_t match = 4;
+        while (pos + match < len && base[candidate + match] == base[pos + match]) {
+          ++match;
+        }
+        snappy_emit_copy(pos - candidate, match, out);
+        pos += match;
+        literal_start = pos;
+        misses = 32;
+      } else {
+        pos += misses++ >> 5;
+      }
+    }
+    snappy_emit_literal(base + literal_start, len - literal_start, out);
+  }
+}
+
+void throw_corrupt_page(const std::string& codec) {
+  log_and_throw("Corrupted " + codec + " compressed Parquet page");
+}
+
+void snappy_decompress(const char* in, size_t in_len, char* out, size_t out_len) {
+  const uint8_t* ip = (const uint8_t*)in;
+  const uint8_t* end = ip + in_len;
+  // the uncompressed length
+  uint64_t len = 0;
+  for (size_t shift = 0; ; shift += 7) {
+    if (ip == end || shift > 28) throw_corrupt_page("SNAPPY");
+    len |= uint64_t(*ip & 0x7F) << shift;
+    if ((*(ip++) & 0x80) == 0) break;
+  }
+  if (len != out_len) throw_corrupt_page("SNAPPY");
+
+  size_t op = 0;
+  while (ip < end) {
+    uint8_t tag = *(ip++);
+    size_t length, offset = 0;
+    switch (tag & 3) {
+      case 0: {
+        length = tag >> 2;
+        if (length >= 60) {
+          size_t num_bytes = length - 59;
+          if (size_t(end - ip) < num_bytes) throw_corrupt_page("SNAPPY");
+          length = 0;
+          for (size_t i = 0; i < num_bytes; ++i) length |= size_t(ip[i]) << (8 * i);
+          ip += num_bytes;
+        }
+        length += 1;
+        if (size_t(end - ip) < length || out_len - op < length) {
+          throw_corrupt_page("SNAPPY");
+        }
+        memcpy(out + op, ip, length);
+        ip += length;
+        op += length;
+        continue;
+      }
+      case 1:
+        if (ip == end) throw_corrupt_page("SNAPPY");
+        length = 4 + ((tag >> 2) & 7);
+        offset = (size_t(tag >> 5) << 8) | *(ip++);
+        break;
+      case 2:
+        if (end - ip < 2) throw_corrupt_page("SNAPPY");
+        length = 1 + (tag >> 2);
+        offset = ip[0] | (size_t(ip[1]) << 8);
+        ip += 2;
+        break;
+      default:
+        if (end - ip < 4) throw_corrupt_page("SNAPPY");
+        length = 1 + (tag >> 2);
+        offset = load32((const char*)ip);
+        ip += 4;
+        break;
+    }
+    if (offset == 0 || offset > op || out_len - op < length) {
+      throw_corrupt_page("SNAPPY");
+    }
+    // the source and destination may overlap
+    for (size_t i = 0; i < length; ++i, ++op) out[op] = out[op - offset];
+  }
+  if (op != out_len) throw_corrupt_page("SNAPPY");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Gzip
+
+void gzip_decompress(const char* in, size_t in_len, char* out, size_t out_len) {
+  z_stream strm;
+  memset(&strm, 0, sizeof(strm));
+  // 32 accepts both the gzip and the zlib headers
+  if (inflateInit2(&strm, 15 + 32) != Z_OK) throw_corrupt_page("GZIP");
+  strm.next_in = (Bytef*)in;
+  strm.avail_in = in_len;
+  strm.next_out = (Bytef*)out;
+  strm.avail_out = out_len;
+  int ret = inflate(&strm, Z_FINISH);
+  size_t total_out = strm.total_out;
+  inflateEnd(&strm);
+  if (ret != Z_STREAM_END || total_out != out_len) throw_corrupt_page("GZIP");
+}
+
+void gzip_compress(const char* in, size_t in_len, std::string& out) {
+  z_stream strm;
+  memset(&strm, 0, sizeof(strm));
+  // 16 writes the gzip header
+  if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    log_and_throw("GZIP compression failed");
+  }
+  size_t start = out.size();
+  out.resize(start + deflateBound(&strm, in_len));
+  strm.next_in = (Bytef*)in;
+  strm.avail_in = in_len;
+  strm.next_out = (Bytef*)(&out[start]);
+  strm.avail_out = out.size() - start;
+  int ret = deflate(&strm, Z_FINISH);
+  out.resize(start + strm.total_out);
+  deflateEnd(&strm);
+  if (ret != Z_STREAM_END) log_and_throw("GZIP compression failed");
+}
+
+} // anonymous namespace
+
+
+void read_file_metadata(const char* data, size_t len, file_metadata& out) {
+  compact_reader in(data, len);
+  out = file_metadata();
+  read_struct(in, [&](int16_t id, uint8_t type) -> bool {
+    if (id == 1 && type == CT_I32) {
+      out.version = in.read_i32();
+    } else if (id == 2 && type == CT_LIST) {
+      return read_list(in, CT_STRUCT, [&]() {
+        out.schema.emplace_back();
+        read_schema_element(in, out.schema.back());
+      });
+    } else if (id == 3 && type == CT_I64) {
+      out.num_rows = in.read_i64();
+    } else if (id == 4 && type == CT_LIST) {
+      return read_list(in, CT_STRUCT, [&]() {
+        out.row_groups.emplace_back();
+        read_row_group(in, out.row_groups.back());
+      });
+    } else if (id == 5 && type == CT_LIST) {
+      return read_list(in, CT_STRUCT, [&]() {
+        std::pair<std::string, std::string> kv;
+        read_struct(in, [&](int16_t field_id, uint8_t field_type) -> bool {
+          if (field_type != CT_BINARY || (field_id != 1 && field_id != 2)) {
+            return false;
+          }
+          (field_id == 1 ? kv.first : kv.second) = in.read_binary();
+          return true;
+        });
+        out.key_value_metadata.push_back(std::move(kv));
+      });
+    } else if (id == 6 && type == CT_BINARY) {
+      out.created_by = in.read_binary();
+    } else {
+      return false;
+    }
+    return true;
+  });
+}
+
+void write_file_metadata(const file_metadata& metadata, std::string& out) {
+  compact_writer w(out);
+  w.i32_field(1, metadata.version);
+  w.list_field(2, CT_STRUCT, metadata.schema.size());
+  for (const auto& elem: metadata.schema) {
+    w.begin_struct();
+    write_schema_element(w, elem);
+    w.end_struct();
+  }
+  w.i64_field(3, metadata.num_rows);
+  w.list_field(4, CT_STRUCT, metadata.row_groups.size());
+  for (const auto& group: metadata.row_groups) {
+    w.begin_struct();
+    w.list_field(1, CT_STRUCT, group.columns.size());
+    for (const auto& chunk: group.columns) {
+      w.begin_struct();
+      if (!chunk.file_path.empty()) w.binary_field(1, chunk.file_path);
+      w.i64_field(2, chunk.file_offset);
+      w.begin_struct(3);
+      write_column_metadata(w, chunk.meta_data);
+      w.end_struct();
+      w.end_struct();
+    }
+    w.i64_field(2, group.total_byte_size);
+    w.i64_field(3, group.num_rows);
+    w.end_struct();
+  }
+  if (!metadata.key_value_metadata.empty()) {
+    w.list_field(5, CT_STRUCT, metadata.key_value_metadata.size());
+    for (const auto& kv: metadata.key_value_metadata) {
+      w.begin_struct();
+      w.binary_field(1, kv.first);
+      w.binary_field(2, kv.second);
+      w.end_struct();
+    }
+  }
+  if (!metadata.created_by.empty()) w.binary_field(6, metadata.created_by);
+  w.byte(CT_STOP);
+}
+
+size_t read_page_header(const char* data, size_t len, page_header& out) {
+  compact_reader in(data, len);
+  out = page_header();
+  read_struct(in, [&](int16_t id, uint8_t type) -> bool {
+    if (id == 1 && type == CT_I32) {
+      out.type = (page_type)in.read_i32();
+    } else if (id == 2 && type == CT_I32) {
+      out.uncompressed_page_size = in.read_i32();
+    } else if (id == 3 && type == CT_I32) {
+      out.compressed_page_size = in.read_i32();
+    } else if (id == 5 && type == CT_STRUCT) {
+      read_struct(in, [&](int16_t field_id, uint8_t field_type) -> bool {
+        if (field_type != CT_I32 || field_id < 1 || field_id > 4) return false;
+        int32_t v = in.read_i32();
+        if (field_id == 1) out.num_values = v;
+        else if (field_id == 2) out.value_encoding = (encoding)v;
+        else if (field_id == 3) out.definition_level_encoding = (encoding)v;
+        else out.repetition_level_encoding = (encoding)v;
+        return true;
+      });
+    } else if (id == 7 && type == CT_STRUCT) {
+      read_struct(in, [&](int16_t field_id, uint8_t field_type) -> bool {
+        if (field_type != CT_I32 || field_id < 1 || field_id > 2) return false;
+        int32_t v = in.read_i32();
+        if (field_id == 1) out.num_values = v;
+        else out.value_encoding = (encoding)v;
+        return true;
+      });
+    } else if (id == 8 && type == CT_STRUCT) {
+      read_struct(in, [&](int16_t field_id, uint8_t field_type) -> bool {
+        if (field_id == 7 && (field_type == CT_TRUE || field_type == CT_FALSE)) {
+          out.is_compressed = (field_type == CT_TRUE);
+          return true;
+        }
+        if (field_type != CT_I32 || field_id < 1 || field_id > 6) return false;
+        int32_t v = in.read_i32();
+        switch (field_id) {
+          case 1: out.num_values = v; break;
+          case 2: out.num_nulls = v; break;
+          case 3: out.num_rows = v; break;
+          case 4: out.value_encoding = (encoding)v; break;
+          case 5: out.definition_levels_byte_length = v; break;
+          default: out.repetition_levels_byte_length = v; break;
+        }
+        return true;
+      });
+    } else {
+      return false;
+    }
+    return true;
+  });
+  if (out.compressed_page_size < 0 || out.uncompressed_page_size < 0 ||
+      out.num_values < 0 || out.definition_levels_byte_length < 0 ||
+      out.repetition_levels_byte_length < 0) {
+    throw_corrupt_metadata();
+  }
+  return in.position();
+}
+
+void write_page_header(const page_header& header, std::string& out) {
+  compact_writer w(out);
+  w.i32_field(1, (int32_t)header.type);
+  w.i32_field(2, header.uncompressed_page_size);
+  w.i32_field(3, header.compressed_page_size);
+  if (header.type == page_type::DATA_PAGE) {
+    w.begin_struct(5);
+    w.i32_field(1, header.num_values);
+    w.i32_field(2, (int32_t)header.value_encoding);
+    w.i32_field(3, (int32_t)header.definition_level_encoding);
+    w.i32_field(4, (int32_t)header.repetition_level_encoding);
+    w.end_struct();
+  } else if (header.type == page_type::DICTIONARY_PAGE) {
+    w.begin_struct(7);
+    w.i32_field(1, header.num_values);
+    w.i32_field(2, (int32_t)header.value_encoding);
+    w.end_struct();
+  } else if (header.type == page_type::DATA_PAGE_V2) {
+    w.begin_struct(8);
+    w.i32_field(1, header.num_values);
+    w.i32_field(2, header.num_nulls);
+    w.i32_field(3, header.num_rows);
+    w.i32_field(4, (int32_t)header.value_encoding);
+    w.i32_field(5, header.definition_levels_byte_length);
+    w.i32_field(6, header.repetition_levels_byte_length);
+    w.bool_field(7, header.is_compressed);
+    w.end_struct();
+  }
+  w.byte(CT_STOP);
+}
+
+bool is_supported_codec(compression_codec codec) {
+  return codec == compression_codec::UNCOMPRESSED ||
+         codec == compression_codec::SNAPPY ||
+         codec == compression_codec::GZIP ||
+         codec == compression_codec::LZ4_RAW;
+}
+
+std::string codec_name(compression_codec codec) {
+  switch (codec) {
+    case compression_codec::UNCOMPRESSED: return "UNCOMPRESSED";
+    case compression_codec::SNAPPY: return "SNAPPY";
+    case compression_codec::GZIP: return "GZIP";
+    case compression_codec::LZO: return "LZO";
+    case compression_codec::BROTLI: return "BROTLI";
+    case compression_codec::LZ4: return "LZ4";
+    case compression_codec::ZSTD: return "ZSTD";
+    case compression_codec::LZ4_RAW: return "LZ4_RAW";
+  }
+  return "codec " + std::to_string((int)codec);
+}
+
+void decompress(compression_codec codec,
+                const char* in, size_t in_len,
+                char* out, size_t out_len) {
+  switch (codec) {
+    case compression_codec::UNCOMPRESSED:
+      if (in_len != out_len) throw_corrupt_page("UNCOMPRESSED");
+      memcpy(out, in, in_len);
+      break;
+    case compression_codec::SNAPPY:
+      snappy_decompress(in, in_len, out, out_len);
+      break;
+    case compression_codec::GZIP:
+      gzip_decompress(in, in_len, out, out_len);
+      break;
+    case compression_codec::LZ4_RAW:
+      if (LZ4_decompress_safe(in, out, in_len, out_len) != (int)out_len) {
+        throw_corrupt_page("LZ4_RAW");
+      }
+      break;
+    default:
+      log_and_throw("Parquet pages compressed with " + codec_name(codec) +
+                    " are not supported");
+  }
+}
+
+void compress(compression_codec codec,
+              const char* in, size_t in_len,
+              std::string& out) {
+  switch (codec) {
+    case compression_codec::UNCOMPRESSED:
+      out.append(in, in_len);
+      break;
+    case compression_codec::SNAPPY:
+      snappy_compress(in, in_len, out);
+      break;
+    case compression_codec::GZIP:
+      gzip_compress(in, in_len, out);
+      break;
+    case compression_codec::LZ4_RAW: {
+      size_t start = out.size();
+      out.resize(start + LZ4_compressBound(in_len));
+      int len = LZ4_compress(in, &out[start], in_len);
+      out.resize(start + len);
+      break;
+    }
+    default:
+      log_and_throw("Parquet pages cannot be compressed with " +
+                    codec_name(codec));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// RLE / bit-packed hybrid
+
+rle_decoder::rle_decoder(const char* data, size_t len, int bit_width)
+    : m_pos((const uint8_t*)data), m_end(m_pos + len),
+      m_bit_width(bit_width), m_value_bytes((bit_width + 7) / 8) {
+  if (bit_width < 0 || bit_width > 32) {
+    log_and_throw("Invalid bit width in Parquet page");
+  }
+}
+
+bool rle_decoder::next_run() {
+  if (m_is_packed) {
+    // skip the rest of the packed run
+    m_pos += (m_bit_offset + 7) / 8;
+  }
+  if (m_pos >= m_end) return false;
+  uint64_t header = 0;
+  for (size_t shift = 0; ; shift += 7) {
+    if (m_pos >= m_end || shift > 35) return false;
+    header |= uint64_t(*m_pos & 0x7F) << shift;
+    if ((*(m_pos++) & 0x80) == 0) break;
+  }
+  if (header & 1) {
+    m_is_packed = true;
+    // groups of 8 values
+    m_remaining = (header >> 1) * 8;
+    m_bit_offset = 0;
+    // the last run may be cut short
+    size_t available_values = m_bit_width ?
+        size_t(m_end - m_pos) * 8 / m_bit_width : m_remaining;
+    m_remaining = std::min(m_remaining, available_values);
+  } else {
+    m_is_packed = false;
+    m_remaining = header >> 1;
+    if (size_t(m_end - m_pos) < m_value_bytes) return false;
+    m_repeated_value = 0;
+    for (size_t i = 0; i < m_value_bytes; ++i) {
+      m_repeated_value |= uint32_t(m_pos[i]) << (8 * i);
+    }
+    m_pos += m_value_bytes;
+  }
+  return true;
+}
+
+void rle_decoder::decode(uint32_t* out, size_t n) {
+  while (n > 0) {
+    if (m_remaining == 0) {
+      if (!next_run()) log_and_throw("Truncated RLE data in Parquet page");
+      continue;
+    }
+    size_t count = std::min(n, m_remaining);
+    if (m_is_packed) {
+      uint64_t mask = (uint64_t(1) << m_bit_width) - 1;
+      for (size_t i = 0; i < count; ++i) {
+        // values are packed from the least significant bit
+        size_t byte = m_bit_offset / 8;
+        size_t shift = m_bit_offset % 8;
+        uint64_t bits = 0;
+        size_t num_bytes = std::min<size_t>((shift + m_bit_width + 7) / 8,
+                                            m_end - m_pos - byte);
+        for (size_t b = 0; b < num_bytes; ++b) {
+          bits |= uint64_t(m_pos[byte + b]) << (8 * b);
+        }
+        out[i] = (uint32_t)((bits >> shift) & mask);
+        m_bit_offset += m_bit_width;
+      }
+    } else {
+      std::fill(out, out + count, m_repeated_value);
+    }
+    out += count;
+    n -= count;
+    m_remaining -= count;
+  }
+}
+
+void rle_encode(const uint32_t* values, size_t n, int bit_width,
+                std::string& out) {
+  compact_writer w(out);
+  size_t value_bytes = (bit_width + 7) / 8;
+  size_t i = 0;
+  while (i < n) {
+    // a repeated run is worth it from 8 values
+    size_t run = 1;
+    while (i + run < n && values[i + run] == values[i]) ++run;
+    if (run >= 8 || i + run == n) {
+      w.varint(uint64_t(run) << 1);
+      for (size_t b = 0; b < value_bytes; ++b) {
+        out.push_back((char)(values[i] >> (8 * b)));
+      }
+      i += run;
+      continue;
+    }
+    // bit pack groups of 8 until a repeated run of 8 begins
+    size_t end = i;
+    while (end < n) {
+      size_t r = 1;
+      while (end + r < n && r < 8 && values[end + r] == values[end]) ++r;
+      if (r >= 8) break;
+      end = std::min(end + 8, n);
+    }
+    size_t num_groups = (end - i + 7) / 8;
+    w.varint((uint64_t(num_groups) << 1) | 1);
+    std::string packed(num_groups * bit_width, 0);
+    size_t bit = 0;
+    for (size_t j = i; j < i + num_groups * 8; ++j, bit += bit_width) {
+      // the padding of the last group is zeros
+      uint64_t v = j < end ? values[j] : 0;
+      for (int b = 0; b < bit_width; ++b) {
+        if (v & (uint64_t(1) << b)) {
+          packed[(bit + b) / 8] |= (char)(1 << ((bit + b) % 8));
+        }
+      }
+    }
+    out.append(packed);
+    i = end;
+  }
+}
+
+} // namespace parquet
+} // namespace turi
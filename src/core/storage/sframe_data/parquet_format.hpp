@@ -0,0 +1,307 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_PARQUET_FORMAT_HPP
+#define TURI_SFRAME_PARQUET_FORMAT_HPP
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace turi {
+
+/**
+ * \ingroup sframe_physical
+ * \addtogroup parquet Parquet Reading and Writing
+ * \{
+ */
+
+/**
+ * \internal
+ * The parts of the Apache Parquet file format used by the \ref
+ * parquet_reader and \ref write_parquet(): the file metadata and page
+ * headers (Thrift compact protocol), the RLE / bit-packed hybrid encoding
+ * of levels and dictionary indices, and the compression codecs.
+ *
+ * Only the fields the reader and writer use are kept. Everything else in
+ * the metadata is skipped when reading.
+ */
+namespace parquet {
+
+/// The "PAR1" magic number at both ends of a Parquet file
+static constexpr const char* MAGIC = "PAR1";
+
+enum class physical_type : int32_t {
+  BOOLEAN = 0,
+  INT32 = 1,
+  INT64 = 2,
+  INT96 = 3,
+  FLOAT = 4,
+  DOUBLE = 5,
+  BYTE_ARRAY = 6,
+  FIXED_LEN_BYTE_ARRAY = 7
+};
+
+/// The legacy logical types of the schema elements
+enum class converted_type : int32_t {
+  NONE = -1,
+  UTF8 = 0,
+  MAP = 1,
+  MAP_KEY_VALUE = 2,
+  LIST = 3,
+  ENUM = 4,
+  DECIMAL = 5,
+  DATE = 6,
+  TIME_MILLIS = 7,
+  TIME_MICROS = 8,
+  TIMESTAMP_MILLIS = 9,
+  TIMESTAMP_MICROS = 10,
+  UINT_8 = 11,
+  UINT_16 = 12,
+  UINT_32 = 13,
+  UINT_64 = 14,
+  JSON = 19,
+  BSON = 20
+};
+
+/**
+ * The logical types of the schema elements. The values are the field ids of
+ * the LogicalType union of the format.
+ */
+enum class logical_type : int32_t {
+  NONE = 0,
+  STRING = 1,
+  MAP = 2,
+  LIST = 3,
+  ENUM = 4,
+  DECIMAL = 5,
+  DATE = 6,
+  TIME = 7,
+  TIMESTAMP = 8,
+  INTEGER = 10,
+  JSON = 12,
+  BSON = 13
+};
+
+enum class time_unit : int32_t { NONE = 0, MILLIS = 1, MICROS = 2, NANOS = 3 };
+
+enum class repetition_type : int32_t { REQUIRED = 0, OPTIONAL = 1, REPEATED = 2 };
+
+enum class encoding : int32_t {
+  PLAIN = 0,
+  PLAIN_DICTIONARY = 2,
+  RLE = 3,
+  BIT_PACKED = 4,
+  DELTA_BINARY_PACKED = 5,
+  DELTA_LENGTH_BYTE_ARRAY = 6,
+  DELTA_BYTE_ARRAY = 7,
+  RLE_DICTIONARY = 8,
+  BYTE_STREAM_SPLIT = 9
+};
+
+enum class compression_codec : int32_t {
+  UNCOMPRESSED = 0,
+  SNAPPY = 1,
+  GZIP = 2,
+  LZO = 3,
+  BROTLI = 4,
+  LZ4 = 5,
+  ZSTD = 6,
+  LZ4_RAW = 7
+};
+
+enum class page_type : int32_t {
+  DATA_PAGE = 0,
+  INDEX_PAGE = 1,
+  DICTIONARY_PAGE = 2,
+  DATA_PAGE_V2 = 3
+};
+
+/**
+ * One node of the schema tree, which is stored flattened in depth first
+ * order. The first element is the root.
+ */
+struct schema_element {
+  /// False for the group nodes, which have children instead of a type
+  bool has_type = false;
+  physical_type type = physical_type::INT32;
+  /// The length in bytes of FIXED_LEN_BYTE_ARRAY values
+  int32_t type_length = 0;
+  repetition_type repetition = repetition_type::REQUIRED;
+  std::string name;
+  int32_t num_children = 0;
+  converted_type converted = converted_type::NONE;
+  /// The scale and precision of decimals
+  int32_t scale = 0;
+  int32_t precision = 0;
+  logical_type logical = logical_type::NONE;
+  /// The unit of TIME and TIMESTAMP logical types
+  time_unit unit = time_unit::NONE;
+  bool is_adjusted_to_utc = false;
+};
+
+/**
+ * The statistics of a column chunk. The min and max values are stored PLAIN
+ * encoded (without the length prefix of byte arrays).
+ */
+struct statistics {
+  bool has_min = false;
+  bool has_max = false;
+  std::string min_value;
+  std::string max_value;
+  /**
+   * True if min_value and max_value come from the deprecated min and max
+   * fields, which were written with a signed byte order for byte arrays.
+   */
+  bool legacy_min_max = false;
+  int64_t null_count = -1;
+};
+
+struct column_metadata {
+  physical_type type = physical_type::INT32;
+  std::vector<encoding> encodings;
+  std::vector<std::string> path;
+  compression_codec codec = compression_codec::UNCOMPRESSED;
+  int64_t num_values = 0;
+  int64_t total_uncompressed_size = 0;
+  int64_t total_compressed_size = 0;
+  int64_t data_page_offset = 0;
+  /// -1 if the column chunk has no dictionary page
+  int64_t dictionary_page_offset = -1;
+  statistics stats;
+};
+
+struct column_chunk {
+  /// Set if the column chunk is stored in a different file
+  std::string file_path;
+  int64_t file_offset = 0;
+  column_metadata meta_data;
+};
+
+struct row_group {
+  std::vector<column_chunk> columns;
+  int64_t total_byte_size = 0;
+  int64_t num_rows = 0;
+};
+
+struct file_metadata {
+  int32_t version = 1;
+  std::vector<schema_element> schema;
+  int64_t num_rows = 0;
+  std::vector<row_group> row_groups;
+  std::vector<std::pair<std::string, std::string> > key_value_metadata;
+  std::string created_by;
+};
+
+/**
+ * The header in front of every page. The fields of the data page, data
+ * page v2 and dictionary page headers are merged.
+ */
+struct page_header {
+  page_type type = page_type::DATA_PAGE;
+  int32_t uncompressed_page_size = 0;
+  int32_t compressed_page_size = 0;
+  /// Including the nulls
+  int32_t num_values = 0;
+  encoding value_encoding = encoding::PLAIN;
+  encoding definition_level_encoding = encoding::RLE;
+  encoding repetition_level_encoding = encoding::RLE;
+  // data page v2 only. The levels of v2 pages are never compressed.
+  int32_t num_nulls = 0;
+  int32_t num_rows = 0;
+  int32_t definition_levels_byte_length = 0;
+  int32_t repetition_levels_byte_length = 0;
+  bool is_compressed = true;
+};
+
+/**
+ * Parses the file metadata stored in data[0, len). Throws if it is corrupt.
+ */
+void read_file_metadata(const char* data, size_t len, file_metadata& out);
+
+/**
+ * Appends the serialized file metadata to out.
+ */
+void write_file_metadata(const file_metadata& metadata, std::string& out);
+
+/**
+ * Parses the page header at the beginning of data[0, len), and returns its
+ * length in bytes. Throws if it is corrupt.
+ */
+size_t read_page_header(const char* data, size_t len, page_header& out);
+
+/**
+ * Appends the serialized page header to out.
+ */
+void write_page_header(const page_header& header, std::string& out);
+
+/**
+ * Returns true if pages compressed with the codec can be read and written.
+ * UNCOMPRESSED, SNAPPY, GZIP and LZ4_RAW are supported.
+ */
+bool is_supported_codec(compression_codec codec);
+
+/**
+ * Returns the name of the codec, as in the format specification.
+ */
+std::string codec_name(compression_codec codec);
+
+/**
+ * Decompresses in[0, in_len) into out[0, out_len). Throws unless exactly
+ * out_len bytes are decompressed.
+ */
+void decompress(compression_codec codec,
+                const char* in, size_t in_len,
+                char* out, size_t out_len);
+
+/**
+ * Compresses in[0, in_len) and appends the compressed bytes to out.
+ */
+void compress(compression_codec codec,
+              const char* in, size_t in_len,
+              std::string& out);
+
+/**
+ * Decodes values of up to 32 bits written with the RLE / bit-packed hybrid
+ * encoding, as the definition levels and the dictionary indices are.
+ */
+class rle_decoder {
+ public:
+  rle_decoder(const char* data, size_t len, int bit_width);
+
+  /**
+   * Decodes the next n values into out. Throws if the data ends first.
+   */
+  void decode(uint32_t* out, size_t n);
+
+ private:
+  bool next_run();
+
+  const uint8_t* m_pos;
+  const uint8_t* m_end;
+  int m_bit_width;
+  size_t m_value_bytes;
+  // the current run
+  bool m_is_packed = false;
+  size_t m_remaining = 0;
+  uint32_t m_repeated_value = 0;
+  /// bit offset of the next packed value from m_pos
+  size_t m_bit_offset = 0;
+};
+
+/**
+ * Appends values[0, n) encoded with the RLE / bit-packed hybrid encoding
+ * to out, using bit_width bits per value.
+ */
+void rle_encode(const uint32_t* values, size_t n, int bit_width,
+                std::string& out);
+
+} // namespace parquet
+
+/// \}
+} // namespace turi
+
+#endif
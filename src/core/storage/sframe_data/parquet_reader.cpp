@@ -0,0 +1,658 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <core/logging/logger.hpp>
+#include <core/parallel/thread_pool.hpp>
+#include <core/storage/fileio/async_reader.hpp>
+#include <core/storage/fileio/general_fstream.hpp>
+#include <core/storage/fileio/sanitize_url.hpp>
+#include <core/storage/sframe_data/sframe.hpp>
+#include <core/storage/sframe_data/parquet_reader.hpp>
+#include <core/system/cppipc/server/cancel_ops.hpp>
+
+namespace turi {
+
+using namespace parquet;
+
+namespace {
+
+/// The Julian day of the Unix epoch, for INT96 timestamps
+static constexpr int64_t JULIAN_DAY_OF_EPOCH = 2440588;
+static constexpr int64_t SECONDS_PER_DAY = 86400;
+
+template <typename T>
+inline T load(const char* p) {
+  T ret;
+  memcpy(&ret, p, sizeof(T));
+  return ret;
+}
+
+/// Rounds towards negative infinity
+inline int64_t floor_div(int64_t a, int64_t b) {
+  int64_t q = a / b;
+  return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+}
+
+inline flexible_type make_datetime(int64_t seconds, int64_t microseconds) {
+  return flex_date_time(seconds, flex_date_time::EMPTY_TIMEZONE,
+                        (int32_t)microseconds);
+}
+
+void throw_corrupt_chunk(const std::string& url) {
+  log_and_throw("Corrupted column chunk in Parquet file " + sanitize_url(url));
+}
+
+} // anonymous namespace
+
+
+parquet_reader::parquet_reader(const std::string& url): m_url(url) {
+  general_ifstream fin(url, false);
+  if (!fin.good()) {
+    log_and_throw_io_failure("Cannot open " + sanitize_url(url));
+  }
+  size_t file_size = fin.file_size();
+  // the magic numbers and the metadata length
+  char footer[8];
+  if (file_size >= 12) {
+    fin.seekg(file_size - 8, std::ios_base::beg);
+    fin.read(footer, 8);
+  }
+  if (file_size < 12 || !fin.good() || memcmp(footer + 4, MAGIC, 4) != 0) {
+    log_and_throw(sanitize_url(url) + " is not a Parquet file");
+  }
+  size_t metadata_len = load<uint32_t>(footer);
+  if (metadata_len > file_size - 12) {
+    log_and_throw("Corrupted Parquet metadata in " + sanitize_url(url));
+  }
+  std::vector<char> metadata(metadata_len);
+  fin.seekg(file_size - 8 - metadata_len, std::ios_base::beg);
+  fin.read(metadata.data(), metadata_len);
+  if (!fin.good()) {
+    log_and_throw_io_failure("Read of " + sanitize_url(url) + " failed");
+  }
+  read_file_metadata(metadata.data(), metadata.size(), m_metadata);
+
+  for (const auto& group: m_metadata.row_groups) {
+    if (group.num_rows < 0) {
+      log_and_throw("Corrupted Parquet metadata in " + sanitize_url(url));
+    }
+    m_num_rows += group.num_rows;
+  }
+  init_columns();
+}
+
+void parquet_reader::init_columns() {
+  const auto& schema = m_metadata.schema;
+  if (schema.empty()) {
+    log_and_throw("Parquet file " + sanitize_url(m_url) + " has no schema");
+  }
+  // the column chunks are stored in the order of the leaves of the schema
+  size_t pos = 1;
+  size_t num_leaves = 0;
+  std::function<void()> skip_subtree = [&]() {
+    if (pos >= schema.size()) {
+      log_and_throw("Corrupted Parquet schema in " + sanitize_url(m_url));
+    }
+    const auto& elem = schema[pos++];
+    if (elem.num_children <= 0) {
+      ++num_leaves;
+    } else {
+      for (int32_t i = 0; i < elem.num_children; ++i) skip_subtree();
+    }
+  };
+
+  for (int32_t child = 0; child < schema[0].num_children; ++child) {
+    if (pos >= schema.size()) {
+      log_and_throw("Corrupted Parquet schema in " + sanitize_url(m_url));
+    }
+    const schema_element& elem = schema[pos];
+    size_t chunk_index = num_leaves;
+    skip_subtree();
+    if (elem.num_children > 0 || !elem.has_type ||
+        elem.repetition == repetition_type::REPEATED) {
+      logstream(LOG_WARNING) << "Skipping nested or repeated column "
+                             << elem.name << " of Parquet file "
+                             << sanitize_url(m_url) << std::endl;
+      continue;
+    }
+
+    column_info info;
+    info.chunk_index = chunk_index;
+    info.schema = elem;
+    info.max_definition_level =
+        elem.repetition == repetition_type::OPTIONAL ? 1 : 0;
+    bool is_decimal = elem.converted == converted_type::DECIMAL ||
+                      elem.logical == logical_type::DECIMAL;
+    info.decimal_divisor = std::pow(10.0, elem.scale);
+    flex_type_enum type = flex_type_enum::INTEGER;
+    switch (elem.type) {
+      case physical_type::BOOLEAN:
+        info.kind = value_kind::BOOLEAN;
+        break;
+      case physical_type::INT32:
+      case physical_type::INT64:
+        if (is_decimal) {
+          info.kind = value_kind::DECIMAL_INT;
+          type = flex_type_enum::FLOAT;
+        } else if (elem.converted == converted_type::DATE ||
+                   elem.logical == logical_type::DATE) {
+          info.kind = value_kind::DATE;
+          type = flex_type_enum::DATETIME;
+        } else if (elem.type == physical_type::INT64 &&
+                   (elem.converted == converted_type::TIMESTAMP_MILLIS ||
+                    elem.converted == converted_type::TIMESTAMP_MICROS ||
+                    elem.logical == logical_type::TIMESTAMP)) {
+          info.kind = value_kind::TIMESTAMP;
+          type = flex_type_enum::DATETIME;
+          if (elem.logical == logical_type::TIMESTAMP) {
+            info.timestamp_unit_us = elem.unit == time_unit::MILLIS ? 1000 :
+                                     elem.unit == time_unit::NANOS ? 0 : 1;
+          } else {
+            info.timestamp_unit_us =
+                elem.converted == converted_type::TIMESTAMP_MILLIS ? 1000 : 1;
+          }
+        } else if (elem.converted == converted_type::UINT_8 ||
+                   elem.converted == converted_type::UINT_16 ||
+                   elem.converted == converted_type::UINT_32 ||
+                   elem.converted == converted_type::UINT_64) {
+          info.kind = value_kind::UNSIGNED;
+        } else {
+          info.kind = value_kind::INTEGER;
+        }
+        break;
+      case physical_type::INT96:
+        info.kind = value_kind::INT96;
+        type = flex_type_enum::DATETIME;
+        break;
+      case physical_type::FLOAT:
+        info.kind = value_kind::FLOAT;
+        type = flex_type_enum::FLOAT;
+        break;
+      case physical_type::DOUBLE:
+        info.kind = value_kind::DOUBLE;
+        type = flex_type_enum::FLOAT;
+        break;
+      case physical_type::BYTE_ARRAY:
+      case physical_type::FIXED_LEN_BYTE_ARRAY:
+        if (elem.type == physical_type::FIXED_LEN_BYTE_ARRAY &&
+            elem.type_length <= 0) {
+          log_and_throw("Corrupted Parquet schema in " + sanitize_url(m_url));
+        }
+        info.kind = is_decimal ? value_kind::DECIMAL_BYTES : value_kind::BYTES;
+        type = is_decimal ? flex_type_enum::FLOAT : flex_type_enum::STRING;
+        break;
+      default:
+        logstream(LOG_WARNING) << "Skipping column " << elem.name
+                               << " of unknown type in Parquet file "
+                               << sanitize_url(m_url) << std::endl;
+        continue;
+    }
+    m_columns.push_back(info);
+    m_column_names.push_back(elem.name);
+    m_column_types.push_back(type);
+  }
+
+  for (const auto& group: m_metadata.row_groups) {
+    if (group.columns.size() < num_leaves) {
+      log_and_throw("Corrupted Parquet metadata in " + sanitize_url(m_url));
+    }
+  }
+}
+
+size_t parquet_reader::row_group_num_rows(size_t row_group) const {
+  DASSERT_LT(row_group, m_metadata.row_groups.size());
+  return m_metadata.row_groups[row_group].num_rows;
+}
+
+size_t parquet_reader::column_index(const std::string& name) const {
+  for (size_t i = 0; i < m_column_names.size(); ++i) {
+    if (m_column_names[i] == name) return i;
+  }
+  log_and_throw("Column " + name + " not found in Parquet file " +
+                sanitize_url(m_url));
+  return 0;
+}
+
+const column_chunk& parquet_reader::get_chunk(size_t row_group,
+                                              size_t column) const {
+  DASSERT_LT(row_group, m_metadata.row_groups.size());
+  DASSERT_LT(column, m_columns.size());
+  return m_metadata.row_groups[row_group].columns[m_columns[column].chunk_index];
+}
+
+std::vector<size_t> parquet_reader::select_row_groups(
+    const std::vector<parquet_column_range>& ranges) const {
+  std::vector<size_t> columns;
+  for (const auto& range: ranges) {
+    size_t column = column_index(range.column);
+    flex_type_enum type = m_column_types[column];
+    bool numeric = (type == flex_type_enum::INTEGER || type == flex_type_enum::FLOAT);
+    for (const flexible_type* bound: {&range.lower, &range.upper}) {
+      flex_type_enum bound_type = bound->get_type();
+      bool bound_numeric = (bound_type == flex_type_enum::INTEGER ||
+                            bound_type == flex_type_enum::FLOAT);
+      if (bound_type != flex_type_enum::UNDEFINED && bound_type != type &&
+          !(numeric && bound_numeric)) {
+        log_and_throw("Bound of type " + std::string(flex_type_enum_to_name(bound_type)) +
+                      " cannot be compared with column " + range.column +
+                      " of type " + flex_type_enum_to_name(type));
+      }
+    }
+    columns.push_back(column);
+  }
+
+  std::vector<size_t> ret;
+  for (size_t group = 0; group < num_row_groups(); ++group) {
+    bool keep = true;
+    for (size_t i = 0; keep && i < ranges.size(); ++i) {
+      const column_info& info = m_columns[columns[i]];
+      const column_metadata& meta = get_chunk(group, columns[i]).meta_data;
+      const statistics& stats = meta.stats;
+      // only nulls, which are in no range
+      if (stats.null_count >= 0 && stats.null_count == meta.num_values &&
+          meta.num_values > 0) {
+        keep = false;
+        break;
+      }
+      // the byte order of these statistics is not usable
+      if (!stats.has_min || !stats.has_max ||
+          info.kind == value_kind::INT96 ||
+          info.kind == value_kind::DECIMAL_BYTES ||
+          info.schema.converted == converted_type::UINT_64 ||
+          (stats.legacy_min_max && info.kind == value_kind::BYTES)) {
+        continue;
+      }
+      flexible_type min_value = decode_plain_value(columns[i], stats.min_value);
+      flexible_type max_value = decode_plain_value(columns[i], stats.max_value);
+      const auto& range = ranges[i];
+      if (range.upper.get_type() != flex_type_enum::UNDEFINED &&
+          range.upper < min_value) {
+        keep = false;
+      }
+      if (range.lower.get_type() != flex_type_enum::UNDEFINED &&
+          max_value < range.lower) {
+        keep = false;
+      }
+    }
+    if (keep) ret.push_back(group);
+  }
+  if (ret.size() < num_row_groups()) {
+    logstream(LOG_INFO) << "Skipping " << num_row_groups() - ret.size()
+                        << " of " << num_row_groups() << " row groups of "
+                        << sanitize_url(m_url) << std::endl;
+  }
+  return ret;
+}
+
+std::shared_ptr<fileio::async_read_request>
+parquet_reader::fetch_column_chunk(size_t row_group, size_t column) const {
+  const column_chunk& chunk = get_chunk(row_group, column);
+  const column_metadata& meta = chunk.meta_data;
+  if (!chunk.file_path.empty()) {
+    log_and_throw("Parquet column chunks stored in other files are not supported");
+  }
+  int64_t begin = meta.data_page_offset;
+  if (meta.dictionary_page_offset > 0 && meta.dictionary_page_offset < begin) {
+    begin = meta.dictionary_page_offset;
+  }
+  if (begin < 0 || meta.total_compressed_size < 0) throw_corrupt_chunk(m_url);
+  return fileio::async_reader::get_instance().read(m_url, begin,
+                                                   meta.total_compressed_size);
+}
+
+void parquet_reader::read_column_chunk(size_t row_group, size_t column,
+                                       std::vector<flexible_type>& out) const {
+  auto data = fetch_column_chunk(row_group, column)->get();
+  decode_column_chunk(row_group, column, *data, out);
+}
+
+void parquet_reader::decode_column_chunk(size_t row_group, size_t column,
+                                         const std::vector<char>& chunk,
+                                         std::vector<flexible_type>& out) const {
+  const column_info& info = m_columns[column];
+  const column_metadata& meta = get_chunk(row_group, column).meta_data;
+  size_t num_rows = row_group_num_rows(row_group);
+  if (!is_supported_codec(meta.codec)) {
+    log_and_throw("Column " + m_column_names[column] + " of " +
+                  sanitize_url(m_url) + " is compressed with " +
+                  codec_name(meta.codec) + ", which is not supported");
+  }
+  out.clear();
+  out.reserve(num_rows);
+
+  std::vector<flexible_type> dictionary;
+  std::vector<char> buffer;
+  const char* data = chunk.data();
+  size_t len = chunk.size();
+  size_t pos = 0;
+  while (out.size() < num_rows) {
+    if (pos >= len) throw_corrupt_chunk(m_url);
+    page_header header;
+    pos += read_page_header(data + pos, len - pos, header);
+    size_t compressed_size = header.compressed_page_size;
+    size_t uncompressed_size = header.uncompressed_page_size;
+    if (compressed_size > len - pos) throw_corrupt_chunk(m_url);
+    const char* page = data + pos;
+    pos += compressed_size;
+
+    switch (header.type) {
+      case page_type::DICTIONARY_PAGE: {
+        if (header.value_encoding != encoding::PLAIN &&
+            header.value_encoding != encoding::PLAIN_DICTIONARY) {
+          throw_corrupt_chunk(m_url);
+        }
+        buffer.resize(uncompressed_size);
+        decompress(meta.codec, page, compressed_size, buffer.data(), buffer.size());
+        dictionary.clear();
+        decode_plain(info, buffer.data(), buffer.size(), header.num_values,
+                     dictionary);
+        break;
+      }
+      case page_type::DATA_PAGE: {
+        buffer.resize(uncompressed_size);
+        decompress(meta.codec, page, compressed_size, buffer.data(), buffer.size());
+        const char* levels = buffer.data();
+        size_t levels_len = 0;
+        size_t values_start = 0;
+        if (info.max_definition_level > 0) {
+          if (header.definition_level_encoding != encoding::RLE) {
+            log_and_throw("Parquet definition levels encoded with " +
+                          std::to_string((int)header.definition_level_encoding) +
+                          " are not supported");
+          }
+          if (buffer.size() < 4) throw_corrupt_chunk(m_url);
+          levels_len = load<uint32_t>(buffer.data());
+          if (levels_len > buffer.size() - 4) throw_corrupt_chunk(m_url);
+          levels += 4;
+          values_start = 4 + levels_len;
+        }
+        decode_data_page(info, header, levels, levels_len,
+                         buffer.data() + values_start,
+                         buffer.size() - values_start, dictionary, out);
+        break;
+      }
+      case page_type::DATA_PAGE_V2: {
+        size_t levels_end = size_t(header.repetition_levels_byte_length) +
+                            size_t(header.definition_levels_byte_length);
+        if (levels_end > compressed_size || levels_end > uncompressed_size) {
+          throw_corrupt_chunk(m_url);
+        }
+        const char* levels = page + header.repetition_levels_byte_length;
+        const char* values = page + levels_end;
+        size_t values_len = compressed_size - levels_end;
+        if (header.is_compressed && meta.codec != compression_codec::UNCOMPRESSED) {
+          buffer.resize(uncompressed_size - levels_end);
+          decompress(meta.codec, values, values_len, buffer.data(), buffer.size());
+          values = buffer.data();
+          values_len = buffer.size();
+        }
+        decode_data_page(info, header, levels,
+                         header.definition_levels_byte_length,
+                         values, values_len, dictionary, out);
+        break;
+      }
+      default:
+        // index pages
+        break;
+    }
+  }
+  if (out.size() != num_rows) throw_corrupt_chunk(m_url);
+}
+
+void parquet_reader::decode_data_page(const column_info& info,
+                                      const page_header& header,
+                                      const char* levels, size_t levels_len,
+                                      const char* values, size_t values_len,
+                                      const std::vector<flexible_type>& dictionary,
+                                      std::vector<flexible_type>& out) const {
+  size_t n = header.num_values;
+  std::vector<uint32_t> definition_levels;
+  size_t num_present = n;
+  if (info.max_definition_level > 0) {
+    definition_levels.resize(n);
+    rle_decoder(levels, levels_len, 1).decode(definition_levels.data(), n);
+    num_present = std::count(definition_levels.begin(),
+                             definition_levels.end(), 1);
+  }
+
+  // without nulls, the values are decoded in place
+  std::vector<flexible_type> present;
+  std::vector<flexible_type>& target = num_present == n ? out : present;
+  size_t target_start = target.size();
+
+  switch (header.value_encoding) {
+    case encoding::PLAIN:
+      decode_plain(info, values, values_len, num_present, target);
+      break;
+    case encoding::PLAIN_DICTIONARY:
+    case encoding::RLE_DICTIONARY: {
+      if (values_len < 1) throw_corrupt_chunk(m_url);
+      std::vector<uint32_t> indices(num_present);
+      rle_decoder(values + 1, values_len - 1, (uint8_t)values[0])
+          .decode(indices.data(), num_present);
+      for (uint32_t index: indices) {
+        if (index >= dictionary.size()) throw_corrupt_chunk(m_url);
+        target.push_back(dictionary[index]);
+      }
+      break;
+    }
+    case encoding::RLE: {
+      if (info.kind != value_kind::BOOLEAN || values_len < 4) {
+        throw_corrupt_chunk(m_url);
+      }
+      size_t rle_len = std::min<size_t>(load<uint32_t>(values), values_len - 4);
+      std::vector<uint32_t> bits(num_present);
+      rle_decoder(values + 4, rle_len, 1).decode(bits.data(), num_present);
+      for (uint32_t bit: bits) target.push_back((flex_int)bit);
+      break;
+    }
+    default:
+      log_and_throw("Column " + info.schema.name + " of " + sanitize_url(m_url) +
+                    " uses Parquet encoding " +
+                    std::to_string((int)header.value_encoding) +
+                    ", which is not supported");
+  }
+  if (target.size() - target_start != num_present) throw_corrupt_chunk(m_url);
+  if (&target == &out) return;
+
+  size_t j = 0;
+  for (size_t i = 0; i < n; ++i) {
+    if (definition_levels[i]) {
+      out.push_back(std::move(present[j++]));
+    } else {
+      out.push_back(FLEX_UNDEFINED);
+    }
+  }
+}
+
+size_t parquet_reader::decode_plain(const column_info& info,
+                                    const char* data, size_t len, size_t n,
+                                    std::vector<flexible_type>& out) const {
+  auto make_integer = [&](int64_t v) -> flexible_type {
+    switch (info.kind) {
+      case value_kind::DATE:
+        return make_datetime(v * SECONDS_PER_DAY, 0);
+      case value_kind::TIMESTAMP: {
+        if (info.timestamp_unit_us == 0) {
+          int64_t seconds = floor_div(v, 1000000000);
+          return make_datetime(seconds, (v - seconds * 1000000000) / 1000);
+        }
+        int64_t us = v * info.timestamp_unit_us;
+        int64_t seconds = floor_div(us, 1000000);
+        return make_datetime(seconds, us - seconds * 1000000);
+      }
+      case value_kind::DECIMAL_INT:
+        return flex_float(v / info.decimal_divisor);
+      default:
+        return flex_int(v);
+    }
+  };
+  auto make_bytes = [&](const char* p, size_t l) -> flexible_type {
+    if (info.kind == value_kind::BYTES) return flex_string(p, l);
+    // big endian two's complement
+    double unscaled = l ? (double)(int8_t)p[0] : 0;
+    for (size_t i = 1; i < l; ++i) unscaled = unscaled * 256 + (uint8_t)p[i];
+    return flex_float(unscaled / info.decimal_divisor);
+  };
+  auto ensure = [&](size_t needed) {
+    if (needed > len) throw_corrupt_chunk(m_url);
+  };
+
+  switch (info.schema.type) {
+    case physical_type::BOOLEAN:
+      ensure((n + 7) / 8);
+      for (size_t i = 0; i < n; ++i) {
+        out.push_back(flex_int((data[i / 8] >> (i % 8)) & 1));
+      }
+      return (n + 7) / 8;
+    case physical_type::INT32:
+      ensure(4 * n);
+      for (size_t i = 0; i < n; ++i) {
+        int32_t v = load<int32_t>(data + 4 * i);
+        out.push_back(make_integer(info.kind == value_kind::UNSIGNED ?
+                                   (int64_t)(uint32_t)v : (int64_t)v));
+      }
+      return 4 * n;
+    case physical_type::INT64:
+      ensure(8 * n);
+      for (size_t i = 0; i < n; ++i) {
+        out.push_back(make_integer(load<int64_t>(data + 8 * i)));
+      }
+      return 8 * n;
+    case physical_type::INT96:
+      ensure(12 * n);
+      for (size_t i = 0; i < n; ++i) {
+        int64_t nanoseconds = load<int64_t>(data + 12 * i);
+        int64_t day = load<int32_t>(data + 12 * i + 8);
+        int64_t seconds = floor_div(nanoseconds, 1000000000);
+        int64_t us = (nanoseconds - seconds * 1000000000) / 1000;
+        seconds += (day - JULIAN_DAY_OF_EPOCH) * SECONDS_PER_DAY;
+        out.push_back(make_datetime(seconds, us));
+      }
+      return 12 * n;
+    case physical_type::FLOAT:
+      ensure(4 * n);
+      for (size_t i = 0; i < n; ++i) {
+        out.push_back(flex_float(load<float>(data + 4 * i)));
+      }
+      return 4 * n;
+    case physical_type::DOUBLE:
+      ensure(8 * n);
+      for (size_t i = 0; i < n; ++i) {
+        out.push_back(flex_float(load<double>(data + 8 * i)));
+      }
+      return 8 * n;
+    case physical_type::BYTE_ARRAY: {
+      size_t pos = 0;
+      for (size_t i = 0; i < n; ++i) {
+        ensure(pos + 4);
+        size_t l = load<uint32_t>(data + pos);
+        pos += 4;
+        ensure(pos + l);
+        out.push_back(make_bytes(data + pos, l));
+        pos += l;
+      }
+      return pos;
+    }
+    case physical_type::FIXED_LEN_BYTE_ARRAY: {
+      size_t l = info.schema.type_length;
+      ensure(l * n);
+      for (size_t i = 0; i < n; ++i) out.push_back(make_bytes(data + l * i, l));
+      return l * n;
+    }
+  }
+  throw_corrupt_chunk(m_url);
+  return 0;
+}
+
+flexible_type parquet_reader::decode_plain_value(size_t column,
+                                                 const std::string& value) const {
+  const column_info& info = m_columns[column];
+  std::vector<flexible_type> ret;
+  if (info.schema.type == physical_type::BYTE_ARRAY) {
+    // statistics have no length prefix
+    std::string prefixed(4, 0);
+    uint32_t len = value.size();
+    memcpy(&prefixed[0], &len, 4);
+    prefixed.append(value);
+    decode_plain(info, prefixed.data(), prefixed.size(), 1, ret);
+  } else {
+    decode_plain(info, value.data(), value.size(), 1, ret);
+  }
+  return ret[0];
+}
+
+
+sframe read_parquet(const std::string& url, const parquet_read_options& options) {
+  parquet_reader reader(url);
+  std::vector<size_t> columns;
+  if (options.columns.empty()) {
+    for (size_t i = 0; i < reader.column_names().size(); ++i) columns.push_back(i);
+  } else {
+    for (const auto& name: options.columns) columns.push_back(reader.column_index(name));
+  }
+  if (columns.empty()) {
+    log_and_throw("No column of Parquet file " + sanitize_url(url) + " can be read");
+  }
+  std::vector<std::string> column_names;
+  std::vector<flex_type_enum> column_types;
+  for (size_t column: columns) {
+    column_names.push_back(reader.column_names()[column]);
+    column_types.push_back(reader.column_types()[column]);
+  }
+  std::vector<size_t> row_groups = reader.select_row_groups(options.row_group_filters);
+
+  // every segment is written by one thread, from a run of row groups
+  size_t num_segments = std::max<size_t>(
+      1, std::min(thread_pool::get_instance().size(), row_groups.size()));
+  sframe frame;
+  frame.open_for_write(column_names, column_types, "", num_segments);
+  auto writer = frame.get_internal_writer();
+
+  parallel_task_queue queue(thread_pool::get_instance());
+  for (size_t segment = 0; segment < num_segments; ++segment) {
+    queue.launch([&, segment]() {
+      size_t begin = row_groups.size() * segment / num_segments;
+      size_t end = row_groups.size() * (segment + 1) / num_segments;
+      std::vector<std::shared_ptr<fileio::async_read_request> > current, next;
+      auto fetch = [&](size_t i,
+                       std::vector<std::shared_ptr<fileio::async_read_request> >& reads) {
+        reads.clear();
+        for (size_t column: columns) {
+          reads.push_back(reader.fetch_column_chunk(row_groups[i], column));
+        }
+      };
+      if (begin < end) fetch(begin, current);
+      std::vector<flexible_type> values;
+      for (size_t i = begin; i < end; ++i) {
+        // the next row group is read while this one is decoded
+        if (i + 1 < end) fetch(i + 1, next);
+        for (size_t c = 0; c < columns.size(); ++c) {
+          auto data = current[c]->get();
+          reader.decode_column_chunk(row_groups[i], columns[c], *data, values);
+          data.reset();
+          current[c].reset();
+          writer->write_column(c, segment, std::move(values));
+        }
+        current.swap(next);
+        if (cppipc::must_cancel()) {
+          log_and_throw(std::string("Parquet reading cancelled"));
+        }
+      }
+    });
+  }
+  queue.join();
+  frame.close();
+  logstream(LOG_INFO) << "Read " << frame.num_rows() << " rows from "
+                      << row_groups.size() << " row groups of "
+                      << sanitize_url(url) << std::endl;
+  return frame;
+}
+
+} // namespace turi
@@ -0,0 +1,197 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_PARQUET_READER_HPP
+#define TURI_SFRAME_PARQUET_READER_HPP
+#include <memory>
+#include <string>
+#include <vector>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/storage/sframe_data/parquet_format.hpp>
+
+namespace turi {
+class sframe;
+
+namespace fileio {
+class async_read_request;
+}
+
+/**
+ * \ingroup sframe_physical
+ * \addtogroup parquet Parquet Reading and Writing
+ * \{
+ */
+
+/**
+ * Bounds on the values of a column, used to skip the row groups whose
+ * statistics show that none of their rows can be in the bounds.
+ */
+struct parquet_column_range {
+  std::string column;
+  /// The inclusive lower bound. Unbounded if UNDEFINED.
+  flexible_type lower = FLEX_UNDEFINED;
+  /// The inclusive upper bound. Unbounded if UNDEFINED.
+  flexible_type upper = FLEX_UNDEFINED;
+};
+
+/**
+ * Reads the columns of a Parquet file, one column chunk at a time.
+ *
+ * The file metadata is read when the reader is constructed. Only the flat
+ * columns at the top level of the schema can be read: the nested and
+ * repeated columns are left out of \ref column_names(). The columns are
+ * read with the types:
+ *  - BOOLEAN and the integer types: flex_type_enum::INTEGER
+ *  - FLOAT, DOUBLE and the decimals: flex_type_enum::FLOAT
+ *  - DATE, TIMESTAMP and INT96: flex_type_enum::DATETIME, without a time
+ *    zone
+ *  - BYTE_ARRAY and FIXED_LEN_BYTE_ARRAY: flex_type_enum::STRING
+ *
+ * Nulls are read as UNDEFINED. The PLAIN and dictionary encodings of data
+ * pages v1 and v2 are supported, with the codecs of \ref
+ * parquet::is_supported_codec().
+ *
+ * All the const member functions may be called concurrently.
+ */
+class parquet_reader {
+ public:
+  /**
+   * Reads the metadata of the Parquet file at url. Throws if it is not a
+   * Parquet file.
+   */
+  explicit parquet_reader(const std::string& url);
+
+  const std::string& url() const { return m_url; }
+
+  /// The total number of rows
+  size_t num_rows() const { return m_num_rows; }
+
+  size_t num_row_groups() const { return m_metadata.row_groups.size(); }
+
+  size_t row_group_num_rows(size_t row_group) const;
+
+  /// The names of the columns which can be read
+  const std::vector<std::string>& column_names() const { return m_column_names; }
+
+  /// The types the columns are read as
+  const std::vector<flex_type_enum>& column_types() const { return m_column_types; }
+
+  /**
+   * Returns the index of the column in \ref column_names(). Throws if there
+   * is no such column.
+   */
+  size_t column_index(const std::string& name) const;
+
+  /**
+   * Returns the row groups (in order) which may contain rows in all the
+   * ranges, according to the statistics in the file. Row groups without
+   * statistics for a column are always kept.
+   */
+  std::vector<size_t> select_row_groups(
+      const std::vector<parquet_column_range>& ranges) const;
+
+  /**
+   * Starts an asynchronous read of the bytes of a column chunk, to be given
+   * to \ref decode_column_chunk().
+   */
+  std::shared_ptr<fileio::async_read_request> fetch_column_chunk(
+      size_t row_group, size_t column) const;
+
+  /**
+   * Decodes the column chunk read with \ref fetch_column_chunk() into out,
+   * replacing its contents with one value per row of the row group.
+   */
+  void decode_column_chunk(size_t row_group, size_t column,
+                           const std::vector<char>& chunk,
+                           std::vector<flexible_type>& out) const;
+
+  /**
+   * Reads a column chunk: \ref fetch_column_chunk() then \ref
+   * decode_column_chunk().
+   */
+  void read_column_chunk(size_t row_group, size_t column,
+                         std::vector<flexible_type>& out) const;
+
+  /**
+   * Returns the flexible_type of a value in the plain encoding of the
+   * column, such as the statistics.
+   */
+  flexible_type decode_plain_value(size_t column, const std::string& value) const;
+
+ private:
+  /// How the values of a column are converted to flexible_types
+  enum class value_kind {
+    BOOLEAN, INTEGER, UNSIGNED, DATE, TIMESTAMP, INT96, FLOAT, DOUBLE,
+    DECIMAL_INT, DECIMAL_BYTES, BYTES
+  };
+
+  struct column_info {
+    /// The index of the column chunks in the row groups
+    size_t chunk_index = 0;
+    parquet::schema_element schema;
+    /// 1 for optional columns, 0 for required ones
+    int max_definition_level = 0;
+    value_kind kind = value_kind::BYTES;
+    /// The number of microseconds in a TIMESTAMP unit, or 0 for nanoseconds
+    int64_t timestamp_unit_us = 1;
+    /// 10^scale for decimals
+    double decimal_divisor = 1;
+  };
+
+  void init_columns();
+
+  void decode_data_page(const column_info& column,
+                        const parquet::page_header& header,
+                        const char* levels, size_t levels_len,
+                        const char* values, size_t values_len,
+                        const std::vector<flexible_type>& dictionary,
+                        std::vector<flexible_type>& out) const;
+
+  /**
+   * Appends n plain encoded values from data[0, len) to out, and returns
+   * the number of bytes read.
+   */
+  size_t decode_plain(const column_info& column,
+                      const char* data, size_t len, size_t n,
+                      std::vector<flexible_type>& out) const;
+
+  const parquet::column_chunk& get_chunk(size_t row_group, size_t column) const;
+
+  std::string m_url;
+  parquet::file_metadata m_metadata;
+  size_t m_num_rows = 0;
+  std::vector<column_info> m_columns;
+  std::vector<std::string> m_column_names;
+  std::vector<flex_type_enum> m_column_types;
+};
+
+/**
+ * The options of \ref read_parquet()
+ */
+struct parquet_read_options {
+  /// The columns to read. All the readable columns if empty.
+  std::vector<std::string> columns;
+  /**
+   * Row groups which cannot contain rows in all of these ranges are skipped.
+   * The rows of the other row groups are all read, in or out of the ranges.
+   */
+  std::vector<parquet_column_range> row_group_filters;
+};
+
+/**
+ * Reads a Parquet file into an SFrame.
+ *
+ * The row groups are decoded in parallel, each thread writing a contiguous
+ * run of row groups into its own segment of the SFrame, column by column.
+ * The column chunks of the next row group are fetched while the current one
+ * is decoded.
+ */
+sframe read_parquet(const std::string& url,
+                    const parquet_read_options& options = parquet_read_options());
+
+/// \}
+} // namespace turi
+
+#endif
@@ -0,0 +1,301 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <cmath>
+#include <cstring>
+#include <core/logging/logger.hpp>
+#include <core/parallel/thread_pool.hpp>
+#include <core/storage/fileio/general_fstream.hpp>
+#include <core/storage/fileio/sanitize_url.hpp>
+#include <core/storage/sframe_data/sframe.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
+#include <core/storage/sframe_data/parquet_writer.hpp>
+#include <core/system/cppipc/server/cancel_ops.hpp>
+
+namespace turi {
+
+using namespace parquet;
+
+namespace {
+
+/// The number of rows of a data page. Every page is encoded by one task.
+static constexpr size_t PAGE_NUM_ROWS = 64 * 1024;
+
+/// String statistics longer than this are not written
+static constexpr size_t MAX_STRING_STATISTICS_LENGTH = 64;
+
+/// The encoded data pages of a run of rows of a column
+struct encoded_pages {
+  std::string bytes;
+  int64_t uncompressed_size = 0;
+  int64_t num_values = 0;
+  int64_t null_count = 0;
+  flexible_type min_value = FLEX_UNDEFINED;
+  flexible_type max_value = FLEX_UNDEFINED;
+};
+
+bool has_statistics(flex_type_enum type) {
+  return type == flex_type_enum::INTEGER || type == flex_type_enum::FLOAT ||
+         type == flex_type_enum::STRING || type == flex_type_enum::DATETIME;
+}
+
+schema_element make_schema_element(const std::string& name, flex_type_enum type) {
+  schema_element ret;
+  ret.name = name;
+  ret.has_type = true;
+  ret.repetition = repetition_type::OPTIONAL;
+  switch (type) {
+    case flex_type_enum::INTEGER:
+      ret.type = physical_type::INT64;
+      break;
+    case flex_type_enum::FLOAT:
+      ret.type = physical_type::DOUBLE;
+      break;
+    case flex_type_enum::DATETIME:
+      ret.type = physical_type::INT64;
+      ret.converted = converted_type::TIMESTAMP_MICROS;
+      ret.logical = logical_type::TIMESTAMP;
+      ret.unit = time_unit::MICROS;
+      ret.is_adjusted_to_utc = true;
+      break;
+    default:
+      ret.type = physical_type::BYTE_ARRAY;
+      ret.converted = converted_type::UTF8;
+      ret.logical = logical_type::STRING;
+      break;
+  }
+  return ret;
+}
+
+inline void append_int64(int64_t v, std::string& out) {
+  char buf[8];
+  memcpy(buf, &v, 8);
+  out.append(buf, 8);
+}
+
+/// Appends the PLAIN encoding of a value, without a length prefix
+void append_plain_value(const flexible_type& v, flex_type_enum type,
+                        std::string& out) {
+  switch (type) {
+    case flex_type_enum::INTEGER:
+      append_int64(v.to<flex_int>(), out);
+      break;
+    case flex_type_enum::FLOAT: {
+      double d = v.to<flex_float>();
+      char buf[8];
+      memcpy(buf, &d, 8);
+      out.append(buf, 8);
+      break;
+    }
+    case flex_type_enum::DATETIME: {
+      const flex_date_time& dt = v.get<flex_date_time>();
+      append_int64(dt.posix_timestamp() * 1000000 + dt.microsecond(), out);
+      break;
+    }
+    case flex_type_enum::STRING:
+      out.append(v.get<flex_string>());
+      break;
+    default:
+      out.append(v.to<flex_string>());
+      break;
+  }
+}
+
+void encode_pages(sarray_reader<flexible_type>& reader,
+                  flex_type_enum type,
+                  compression_codec codec,
+                  size_t begin, size_t end,
+                  encoded_pages& out) {
+  std::vector<flexible_type> values;
+  reader.read_rows(begin, end, values);
+  size_t n = values.size();
+  bool is_byte_array = make_schema_element("", type).type == physical_type::BYTE_ARRAY;
+  bool stats = has_statistics(type);
+
+  std::vector<uint32_t> levels(n);
+  std::string plain;
+  std::string value;
+  for (size_t i = 0; i < n; ++i) {
+    const flexible_type& v = values[i];
+    if (v.get_type() == flex_type_enum::UNDEFINED) {
+      ++out.null_count;
+      continue;
+    }
+    levels[i] = 1;
+    value.clear();
+    append_plain_value(v, type, value);
+    if (is_byte_array) {
+      uint32_t len = value.size();
+      char buf[4];
+      memcpy(buf, &len, 4);
+      plain.append(buf, 4);
+    }
+    plain.append(value);
+    if (stats && !(type == flex_type_enum::FLOAT && std::isnan(v.to<flex_float>()))) {
+      if (out.min_value.get_type() == flex_type_enum::UNDEFINED || v < out.min_value) {
+        out.min_value = v;
+      }
+      if (out.max_value.get_type() == flex_type_enum::UNDEFINED || out.max_value < v) {
+        out.max_value = v;
+      }
+    }
+  }
+
+  // the definition levels, prefixed with their length
+  std::string body(4, 0);
+  rle_encode(levels.data(), n, 1, body);
+  uint32_t levels_len = body.size() - 4;
+  memcpy(&body[0], &levels_len, 4);
+  body.append(plain);
+
+  std::string compressed;
+  compress(codec, body.data(), body.size(), compressed);
+  page_header header;
+  header.type = page_type::DATA_PAGE;
+  header.uncompressed_page_size = body.size();
+  header.compressed_page_size = compressed.size();
+  header.num_values = n;
+  header.value_encoding = encoding::PLAIN;
+  header.definition_level_encoding = encoding::RLE;
+  header.repetition_level_encoding = encoding::RLE;
+  write_page_header(header, out.bytes);
+  out.uncompressed_size = out.bytes.size() + body.size();
+  out.bytes.append(compressed);
+  out.num_values = n;
+}
+
+/// Merges the statistics of the pages into the statistics of a column chunk
+void merge_statistics(const encoded_pages& pages,
+                      flexible_type& min_value, flexible_type& max_value) {
+  if (pages.min_value.get_type() == flex_type_enum::UNDEFINED) return;
+  if (min_value.get_type() == flex_type_enum::UNDEFINED || pages.min_value < min_value) {
+    min_value = pages.min_value;
+  }
+  if (max_value.get_type() == flex_type_enum::UNDEFINED || max_value < pages.max_value) {
+    max_value = pages.max_value;
+  }
+}
+
+} // anonymous namespace
+
+
+void write_parquet(const sframe& sf, const std::string& url,
+                   const parquet_write_options& options) {
+  if (!is_supported_codec(options.codec)) {
+    log_and_throw("Parquet pages cannot be compressed with " +
+                  codec_name(options.codec));
+  }
+  if (sf.num_columns() == 0) {
+    log_and_throw("Cannot write an SFrame without columns to Parquet");
+  }
+  size_t row_group_size = options.row_group_size ? options.row_group_size
+                                                 : SFRAME_PARQUET_ROW_GROUP_SIZE;
+  size_t num_columns = sf.num_columns();
+  std::vector<flex_type_enum> types = sf.column_types();
+
+  file_metadata metadata;
+  metadata.created_by = "turicreate";
+  schema_element root;
+  root.name = "schema";
+  root.num_children = num_columns;
+  metadata.schema.push_back(root);
+  std::vector<std::unique_ptr<sarray_reader<flexible_type> > > readers;
+  for (size_t i = 0; i < num_columns; ++i) {
+    metadata.schema.push_back(make_schema_element(sf.column_name(i), types[i]));
+    readers.push_back(sf.select_column(i)->get_reader());
+  }
+
+  general_ofstream fout(url);
+  if (!fout.good()) {
+    log_and_throw_io_failure("Cannot open " + sanitize_url(url) + " for writing");
+  }
+  fout.write(MAGIC, 4);
+  size_t offset = 4;
+
+  parallel_task_queue queue(thread_pool::get_instance());
+  size_t num_rows = sf.num_rows();
+  for (size_t group_begin = 0; group_begin < num_rows; group_begin += row_group_size) {
+    size_t group_end = std::min(group_begin + row_group_size, num_rows);
+    size_t num_pages = (group_end - group_begin + PAGE_NUM_ROWS - 1) / PAGE_NUM_ROWS;
+    std::vector<std::vector<encoded_pages> > pages(
+        num_columns, std::vector<encoded_pages>(num_pages));
+    for (size_t c = 0; c < num_columns; ++c) {
+      for (size_t p = 0; p < num_pages; ++p) {
+        queue.launch([&, c, p]() {
+          size_t begin = group_begin + p * PAGE_NUM_ROWS;
+          size_t end = std::min(begin + PAGE_NUM_ROWS, group_end);
+          encode_pages(*readers[c], types[c], options.codec, begin, end, pages[c][p]);
+        });
+      }
+    }
+    queue.join();
+
+    row_group group;
+    group.num_rows = group_end - group_begin;
+    for (size_t c = 0; c < num_columns; ++c) {
+      column_chunk chunk;
+      column_metadata& meta = chunk.meta_data;
+      meta.type = metadata.schema[c + 1].type;
+      meta.encodings = {encoding::PLAIN, encoding::RLE};
+      meta.path = {sf.column_name(c)};
+      meta.codec = options.codec;
+      meta.data_page_offset = offset;
+      chunk.file_offset = offset;
+      int64_t null_count = 0;
+      flexible_type min_value = FLEX_UNDEFINED, max_value = FLEX_UNDEFINED;
+      for (auto& page: pages[c]) {
+        fout.write(page.bytes.data(), page.bytes.size());
+        offset += page.bytes.size();
+        meta.total_compressed_size += page.bytes.size();
+        meta.total_uncompressed_size += page.uncompressed_size;
+        meta.num_values += page.num_values;
+        null_count += page.null_count;
+        merge_statistics(page, min_value, max_value);
+        std::string().swap(page.bytes);
+      }
+      meta.stats.null_count = null_count;
+      if (min_value.get_type() != flex_type_enum::UNDEFINED) {
+        append_plain_value(min_value, types[c], meta.stats.min_value);
+        append_plain_value(max_value, types[c], meta.stats.max_value);
+        meta.stats.has_min = meta.stats.has_max =
+            types[c] != flex_type_enum::STRING ||
+            (meta.stats.min_value.size() <= MAX_STRING_STATISTICS_LENGTH &&
+             meta.stats.max_value.size() <= MAX_STRING_STATISTICS_LENGTH);
+        if (!meta.stats.has_min) {
+          meta.stats.min_value.clear();
+          meta.stats.max_value.clear();
+        }
+      }
+      group.total_byte_size += meta.total_uncompressed_size;
+      group.columns.push_back(std::move(chunk));
+    }
+    metadata.row_groups.push_back(std::move(group));
+    if (!fout.good()) {
+      log_and_throw_io_failure("Write of " + sanitize_url(url) + " failed");
+    }
+    if (cppipc::must_cancel()) {
+      log_and_throw(std::string("Parquet writing cancelled"));
+    }
+  }
+  metadata.num_rows = num_rows;
+
+  std::string footer;
+  write_file_metadata(metadata, footer);
+  uint32_t footer_len = footer.size();
+  char len_buf[4];
+  memcpy(len_buf, &footer_len, 4);
+  footer.append(len_buf, 4);
+  footer.append(MAGIC, 4);
+  fout.write(footer.data(), footer.size());
+  if (!fout.good()) {
+    log_and_throw_io_failure("Write of " + sanitize_url(url) + " failed");
+  }
+  fout.close();
+  logstream(LOG_INFO) << "Wrote " << num_rows << " rows in "
+                      << metadata.row_groups.size() << " row groups to "
+                      << sanitize_url(url) << std::endl;
+}
+
+} // namespace turi
@@ -0,0 +1,52 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_PARQUET_WRITER_HPP
+#define TURI_SFRAME_PARQUET_WRITER_HPP
+#include <string>
+#include <core/storage/sframe_data/parquet_format.hpp>
+
+namespace turi {
+class sframe;
+
+/**
+ * \ingroup sframe_physical
+ * \addtogroup parquet Parquet Reading and Writing
+ * \{
+ */
+
+/**
+ * The options of \ref write_parquet()
+ */
+struct parquet_write_options {
+  /// One of the codecs of \ref parquet::is_supported_codec()
+  parquet::compression_codec codec = parquet::compression_codec::SNAPPY;
+  /// The number of rows of the row groups. SFRAME_PARQUET_ROW_GROUP_SIZE if 0.
+  size_t row_group_size = 0;
+};
+
+/**
+ * Writes an SFrame to a Parquet file.
+ *
+ * Every column is written as an optional flat column, with the types:
+ *  - flex_type_enum::INTEGER: INT64
+ *  - flex_type_enum::FLOAT: DOUBLE
+ *  - flex_type_enum::STRING: BYTE_ARRAY, as UTF8 strings
+ *  - flex_type_enum::DATETIME: INT64 timestamps in microseconds since the
+ *    epoch (UTC). The time zones are not stored.
+ *  - all the other types: BYTE_ARRAY, the values converted to strings
+ *
+ * Values are PLAIN encoded in data pages (v1) of up to 64K rows, with the
+ * minimum, maximum and null count of every column chunk, so that the row
+ * groups can be skipped by \ref parquet_reader::select_row_groups(). The
+ * pages of a row group are read and encoded in parallel.
+ */
+void write_parquet(const sframe& sf, const std::string& url,
+                   const parquet_write_options& options = parquet_write_options());
+
+/// \}
+} // namespace turi
+
+#endif
@@ -4,6 +4,8 @@
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
 #include <algorithm>
+#include <cmath>
+#include <deque>
 #include <core/data/flexible_type/flexible_type.hpp>
 #include <boost/circular_buffer.hpp>
 #include <boost/algorithm/string.hpp>
@@ -12,6 +14,261 @@
 namespace turi {
 namespace rolling_aggregate {
 
+namespace {
+
+/**
+ * A window aggregate updated in O(1) (amortized) per step, as values enter
+ * the window at the back and leave it at the front, instead of aggregating
+ * every window from scratch.
+ */
+class incremental_aggregate {
+ public:
+  virtual ~incremental_aggregate() = default;
+
+  /// Forgets every value.
+  virtual void clear() = 0;
+
+  /// Adds a value at the back of the window.
+  virtual void add(const flexible_type& value) = 0;
+
+  /// Removes the value at the front of the window.
+  virtual void remove(const flexible_type& value) = 0;
+
+  /// The aggregate of the values in the window.
+  virtual flexible_type emit() const = 0;
+
+  /// Whether rounding errors build up as values come and go, so the state
+  /// should be recomputed from the window from time to time.
+  virtual bool drifts() const { return false; }
+};
+
+/**
+ * Sum of integers, exact.
+ */
+class integer_sum : public incremental_aggregate {
+ public:
+  void clear() override { value = 0; }
+  void add(const flexible_type& v) override {
+    if (v.get_type() == flex_type_enum::INTEGER) value += v.get<flex_int>();
+  }
+  void remove(const flexible_type& v) override {
+    if (v.get_type() == flex_type_enum::INTEGER) value -= v.get<flex_int>();
+  }
+  flexible_type emit() const override { return value; }
+
+ private:
+  flex_int value = 0;
+};
+
+/**
+ * Count, sum and second central moment (Welford's update, run backwards to
+ * remove a value) of the finite values of the window. Non-finite values are
+ * counted apart, so that they stop affecting the result once they leave.
+ */
+class moments {
+ public:
+  void clear() { *this = moments(); }
+
+  void add(const flexible_type& v) {
+    if (v.get_type() == flex_type_enum::UNDEFINED) return;
+    double x = (double)v;
+    if (!std::isfinite(x)) { count_non_finite(x, 1); return; }
+    ++count;
+    sum += x;
+    double delta = x - mean;
+    mean += delta / count;
+    m2 += delta * (x - mean);
+  }
+
+  void remove(const flexible_type& v) {
+    if (v.get_type() == flex_type_enum::UNDEFINED) return;
+    double x = (double)v;
+    if (!std::isfinite(x)) { count_non_finite(x, -1); return; }
+    --count;
+    sum -= x;
+    if (count == 0) {
+      sum = 0;
+      mean = 0;
+      m2 = 0;
+      return;
+    }
+    double delta = x - mean;
+    mean -= delta / count;
+    m2 = std::max(0.0, m2 - delta * (x - mean));
+  }
+
+  /// The non-finite value the window aggregates to, or 0 if all are finite.
+  double non_finite() const {
+    if (num_nan > 0 || (num_pos_inf > 0 && num_neg_inf > 0)) return NAN;
+    if (num_pos_inf > 0) return INFINITY;
+    if (num_neg_inf > 0) return -INFINITY;
+    return 0;
+  }
+
+  bool all_finite() const {
+    return num_nan == 0 && num_pos_inf == 0 && num_neg_inf == 0;
+  }
+
+  size_t num_values() const {
+    return count + num_nan + num_pos_inf + num_neg_inf;
+  }
+
+  size_t count = 0;
+  double sum = 0;
+  double mean = 0;
+  double m2 = 0;
+
+ private:
+  void count_non_finite(double x, int delta) {
+    if (std::isnan(x)) num_nan += delta;
+    else if (x > 0) num_pos_inf += delta;
+    else num_neg_inf += delta;
+  }
+
+  size_t num_nan = 0;
+  size_t num_pos_inf = 0;
+  size_t num_neg_inf = 0;
+};
+
+class float_sum : public incremental_aggregate {
+ public:
+  void clear() override { m.clear(); }
+  void add(const flexible_type& v) override { m.add(v); }
+  void remove(const flexible_type& v) override { m.remove(v); }
+  flexible_type emit() const override {
+    return m.all_finite() ? m.sum : m.non_finite();
+  }
+  bool drifts() const override { return true; }
+
+ private:
+  moments m;
+};
+
+class mean : public incremental_aggregate {
+ public:
+  void clear() override { m.clear(); }
+  void add(const flexible_type& v) override { m.add(v); }
+  void remove(const flexible_type& v) override { m.remove(v); }
+  flexible_type emit() const override {
+    if (m.num_values() == 0) return FLEX_UNDEFINED;
+    return m.all_finite() ? m.sum / m.count : m.non_finite();
+  }
+  bool drifts() const override { return true; }
+
+ private:
+  moments m;
+};
+
+class variance : public incremental_aggregate {
+ public:
+  explicit variance(bool take_sqrt) : take_sqrt(take_sqrt) {}
+  void clear() override { m.clear(); }
+  void add(const flexible_type& v) override { m.add(v); }
+  void remove(const flexible_type& v) override { m.remove(v); }
+  flexible_type emit() const override {
+    if (!m.all_finite()) return NAN;
+    double var = m.count <= 1 ? 0.0 : m.m2 / m.count;
+    return take_sqrt ? std::sqrt(var) : var;
+  }
+  bool drifts() const override { return true; }
+
+ private:
+  bool take_sqrt;
+  moments m;
+};
+
+/**
+ * Minimum (or maximum) over a monotonic deque: the values of the window
+ * which are smaller (larger) than every value after them, with their
+ * positions.
+ */
+class extremum : public incremental_aggregate {
+ public:
+  explicit extremum(bool is_max) : is_max(is_max) {}
+  void clear() override {
+    candidates.clear();
+    num_added = 0;
+    num_removed = 0;
+  }
+  void add(const flexible_type& v) override {
+    if (v.get_type() != flex_type_enum::UNDEFINED) {
+      while (!candidates.empty() && !before(candidates.back().second, v)) {
+        candidates.pop_back();
+      }
+      candidates.emplace_back(num_added, v);
+    }
+    ++num_added;
+  }
+  void remove(const flexible_type&) override {
+    if (!candidates.empty() && candidates.front().first == num_removed) {
+      candidates.pop_front();
+    }
+    ++num_removed;
+  }
+  flexible_type emit() const override {
+    if (candidates.empty()) return FLEX_UNDEFINED;
+    return candidates.front().second;
+  }
+
+ private:
+  // whether a stays a candidate ahead of b
+  bool before(const flexible_type& a, const flexible_type& b) const {
+    return is_max ? b < a : a < b;
+  }
+
+  bool is_max;
+  std::deque<std::pair<size_t, flexible_type>> candidates;
+  size_t num_added = 0;
+  size_t num_removed = 0;
+};
+
+class non_null_count : public incremental_aggregate {
+ public:
+  void clear() override { value = 0; }
+  void add(const flexible_type& v) override {
+    if (v.get_type() != flex_type_enum::UNDEFINED) ++value;
+  }
+  void remove(const flexible_type& v) override {
+    if (v.get_type() != flex_type_enum::UNDEFINED) --value;
+  }
+  flexible_type emit() const override { return value; }
+
+ private:
+  flex_int value = 0;
+};
+
+/**
+ * The incremental version of a builtin aggregator, or nullptr if there is
+ * none for it and the input type.
+ */
+std::unique_ptr<incremental_aggregate> make_incremental_aggregate(
+    const group_aggregate_value& agg_op, flex_type_enum type) {
+  bool numeric = (type == flex_type_enum::INTEGER ||
+                  type == flex_type_enum::FLOAT);
+  std::unique_ptr<incremental_aggregate> ret;
+  if (dynamic_cast<const groupby_operators::non_null_count*>(&agg_op)) {
+    ret.reset(new non_null_count());
+  } else if (!numeric) {
+    // the others only have an incremental version for numbers
+  } else if (dynamic_cast<const groupby_operators::sum*>(&agg_op)) {
+    if (type == flex_type_enum::INTEGER) ret.reset(new integer_sum());
+    else ret.reset(new float_sum());
+  } else if (dynamic_cast<const groupby_operators::average*>(&agg_op)) {
+    ret.reset(new mean());
+  } else if (dynamic_cast<const groupby_operators::stdv*>(&agg_op)) {
+    ret.reset(new variance(true));
+  } else if (dynamic_cast<const groupby_operators::variance*>(&agg_op)) {
+    ret.reset(new variance(false));
+  } else if (dynamic_cast<const groupby_operators::min*>(&agg_op)) {
+    ret.reset(new extremum(false));
+  } else if (dynamic_cast<const groupby_operators::max*>(&agg_op)) {
+    ret.reset(new extremum(true));
+  }
+  return ret;
+}
+
+} // anonymous namespace
+
 ssize_t clip(ssize_t val, ssize_t lower, ssize_t upper) {
   return std::min(upper, std::max(lower, val));
 }
@@ -89,6 +346,8 @@ std::shared_ptr<sarray<flexible_type>> rolling_apply(
   std::vector<flex_type_enum> fn_returned_types(num_segments,
                                                 flex_type_enum::UNDEFINED);
 
+  // Segments are computed in parallel. Each one reads, in addition to its own
+  // rows, the rows before and after it that its first and last windows need.
   parallel_for(0, num_segments, [&](size_t segment_id) {
     auto range = seg_ranges[segment_id];
 
@@ -101,6 +360,27 @@ std::shared_ptr<sarray<flexible_type>> rolling_apply(
                                                    range.first,
                                                    range.second+1);
 
+    // Aggregators with an incremental version are updated as values enter
+    // and leave the window; the others aggregate every window from scratch.
+    auto incremental = make_incremental_aggregate(*agg_op, input.get_type());
+    bool refresh = incremental && incremental->drifts();
+    size_t steps_since_refresh = 0;
+    if (incremental) {
+      for (const auto& v : window_buf) incremental->add(v);
+    }
+
+    // Number of non-NULL values in the window
+    size_t num_defined = 0;
+
+    auto push_value = [&](flexible_type value) {
+      const flexible_type& oldest = window_buf.front();
+      if (oldest.get_type() != flex_type_enum::UNDEFINED) --num_defined;
+      if (incremental) incremental->remove(oldest);
+      if (value.get_type() != flex_type_enum::UNDEFINED) ++num_defined;
+      if (incremental) incremental->add(value);
+      window_buf.push_back(std::move(value));
+    };
+
     // The esteemed "current" value that all the documentation talks about
     ssize_t logical_pos = ssize_t(seg_starts[segment_id]);
     // The last row for which this thread should calculate the aggregate
@@ -117,11 +397,11 @@ std::shared_ptr<sarray<flexible_type>> rolling_apply(
         i <= my_logical_window.second;
         ++i) {
       if(i >= 0 && buf_reader.has_next()) {
-        window_buf.push_back(buf_reader.next());
+        push_value(buf_reader.next());
       } else {
         // If this is a "fake" section of the logical window, just fill with
         // NULL values
-        window_buf.push_back(flex_undefined());
+        push_value(flex_undefined());
       }
     }
 
@@ -129,12 +409,18 @@ std::shared_ptr<sarray<flexible_type>> rolling_apply(
     while(logical_pos < logical_end) {
       // First check if we have the minimum non-NULL observations. This is here
       // to remove the burden of checking from every aggregation function.
-      if(check_num_observations &&
-          !has_min_observations(min_observations,
-            window_buf.begin(), window_buf.end())) {
+      bool enough_observations = (min_observations == size_t(-1))
+          ? (num_defined == total_window_size)
+          : (num_defined >= min_observations);
+      if(check_num_observations && !enough_observations) {
         *out_iter = flex_undefined();
       } else {
-        auto result = full_window_aggregate(agg_op, window_buf.begin(), window_buf.end());
+        flexible_type result;
+        if (incremental) {
+          result = incremental->emit();
+        } else {
+          result = full_window_aggregate(agg_op, window_buf.begin(), window_buf.end());
+        }
         // Record the emitted type from the function. We just take the first
         // one that is non-NULL.
         if(fn_returned_types[segment_id] == flex_type_enum::UNDEFINED &&
@@ -151,11 +437,19 @@ std::shared_ptr<sarray<flexible_type>> rolling_apply(
 
       // Get the next value in the SArray
       if(my_logical_window.second >= 0 && buf_reader.has_next()) {
-        window_buf.push_back(buf_reader.next());
+        push_value(buf_reader.next());
       } else {
         // If this is a "fake" section of the logical window, just fill with
         // NULL values
-        window_buf.push_back(flex_undefined());
+        push_value(flex_undefined());
+      }
+
+      // Recompute floating point state once per window length, which bounds
+      // the rounding error and keeps the cost O(1) per step.
+      if (refresh && ++steps_since_refresh == total_window_size) {
+        steps_since_refresh = 0;
+        incremental->clear();
+        for (const auto& v : window_buf) incremental->add(v);
       }
     }
   }
@@ -66,10 +66,13 @@ std::shared_ptr<sarray<flexible_type>> rolling_apply(
 template<typename Iterator>
 flexible_type full_window_aggregate(std::shared_ptr<group_aggregate_value> agg_op,
     Iterator first, Iterator last) {
-  auto agg = agg_op->new_instance();
+  std::unique_ptr<group_aggregate_value> agg(agg_op->new_instance());
   for(; first != last; ++first) {
     agg->add_element_simple(*first);
   }
+  // Sketch based aggregators (e.g. quantiles) only fill their final
+  // summary once the stream is finalized.
+  agg->partial_finalize();
 
   return agg->emit();
 }
@@ -0,0 +1,68 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+#include <core/random/random.hpp>
+#include <core/storage/sframe_data/row_sampling.hpp>
+
+namespace turi {
+
+namespace {
+
+std::vector<size_t> sample_bernoulli(size_t num_rows, double fraction,
+                                     random::generator& gen) {
+  std::vector<size_t> ret;
+  ret.reserve(size_t(std::min<double>(num_rows, fraction * num_rows * 1.1 + 16)));
+  const double log_skip = std::log1p(-fraction);
+  size_t row = 0;
+  while (true) {
+    // the number of rows skipped before the next one picked is geometric
+    double u = gen.uniform<double>(0, 1);
+    double skip = std::floor(std::log(1 - u) / log_skip);
+    if (skip >= double(num_rows - row)) break;
+    row += size_t(skip);
+    ret.push_back(row);
+    if (++row >= num_rows) break;
+  }
+  return ret;
+}
+
+std::vector<size_t> sample_exact(size_t num_rows, size_t num_picked,
+                                 random::generator& gen) {
+  std::unordered_set<size_t> picked;
+  picked.reserve(num_picked);
+  for (size_t j = num_rows - num_picked; j < num_rows; ++j) {
+    size_t row = gen.uniform<size_t>(0, j);
+    if (!picked.insert(row).second) picked.insert(j);
+  }
+  std::vector<size_t> ret(picked.begin(), picked.end());
+  std::sort(ret.begin(), ret.end());
+  return ret;
+}
+
+} // anonymous namespace
+
+std::vector<size_t> sample_row_indices(size_t num_rows,
+                                       double fraction,
+                                       size_t random_seed,
+                                       bool exact) {
+  std::vector<size_t> ret;
+  if (num_rows == 0 || !(fraction > 0)) return ret;
+  size_t num_picked = exact ? size_t(fraction * num_rows) : num_rows;
+  if (fraction >= 1 || num_picked >= num_rows) {
+    ret.resize(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) ret[i] = i;
+    return ret;
+  }
+
+  random::generator gen;
+  gen.seed(random_seed);
+  if (exact) return sample_exact(num_rows, num_picked, gen);
+  return sample_bernoulli(num_rows, fraction, gen);
+}
+
+} // namespace turi
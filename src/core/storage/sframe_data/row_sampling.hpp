@@ -0,0 +1,42 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_ROW_SAMPLING_HPP
+#define TURI_SFRAME_ROW_SAMPLING_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace turi {
+
+/**
+ * \ingroup sframe_physical
+ * \addtogroup sframe_main Main SFrame Objects
+ * \{
+ */
+
+/**
+ * Picks a random sample of the row indices 0 ... num_rows-1, returned in
+ * increasing order, without looking at the rows themselves.
+ *
+ * If exact is false, every row is picked independently with probability
+ * fraction. The rows are drawn by skipping ahead geometrically distributed
+ * distances, so the cost is proportional to the number of rows picked
+ * rather than to num_rows.
+ *
+ * If exact is true, exactly (size_t)(fraction * num_rows) rows are picked,
+ * every such subset being equally likely (Floyd's algorithm).
+ *
+ * The same arguments always pick the same rows.
+ */
+std::vector<size_t> sample_row_indices(size_t num_rows,
+                                       double fraction,
+                                       size_t random_seed,
+                                       bool exact);
+
+/// \}
+} // namespace turi
+
+#endif
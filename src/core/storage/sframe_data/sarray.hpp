@@ -6,6 +6,7 @@
 #ifndef TURI_UNITY_SFRAME_SARRAY_HPP
 #define TURI_UNITY_SFRAME_SARRAY_HPP
 #include <set>
+#include <algorithm>
 #include <iterator>
 #include <type_traits>
 #include <core/logging/logger.hpp>
@@ -454,8 +455,11 @@ class sarray : public swriter_base<swriter_impl::output_iterator<T> > {
    * returning a new sarray.
    * without destroying the other array. Both SArrays can be empty, but
    * cannot be opened for writing.
+   *
+   * The result is compacted (see \ref try_compact()) unless compact is false,
+   * in which case its segments are left for a later compaction pass.
    */
-  sarray append(const sarray& other) const {
+  sarray append(const sarray& other, bool compact = true) const {
     // both cannot be writing
     ASSERT_EQ(writing, false);
     ASSERT_EQ(other.writing, false);
@@ -463,13 +467,15 @@ class sarray : public swriter_base<swriter_impl::output_iterator<T> > {
     if (!other.inited) return *this;
     if (!inited) return other;
 
-    // cannot combine across format version
-    ASSERT_EQ(index_info.version, other.index_info.version);
+    // cannot combine across block layouts. Version 3 arrays are version 2
+    // arrays using the extended integer encodings, and their union is too.
+    ASSERT_EQ(index_info.version >= 2, other.index_info.version >= 2);
     ASSERT_EQ(index_info.block_size, other.index_info.block_size);
 
     sarray ret;
     ret.inited = true;
     ret.index_info = index_info;
+    ret.index_info.version = std::max(index_info.version, other.index_info.version);
     ret.files_managed = files_managed;
 
     ret.index_info.nsegments += other.index_info.nsegments;
@@ -477,9 +483,19 @@ class sarray : public swriter_base<swriter_impl::output_iterator<T> > {
               std::inserter(ret.index_info.segment_sizes, ret.index_info.segment_sizes.end()));
     std::copy(other.index_info.segment_files.begin(), other.index_info.segment_files.end(),
               std::inserter(ret.index_info.segment_files, ret.index_info.segment_files.end()));
+    // zone maps are kept only if both sides have them
+    if (index_info.block_zone_maps.size() == index_info.nsegments &&
+        other.index_info.block_zone_maps.size() == other.index_info.nsegments) {
+      std::copy(other.index_info.block_zone_maps.begin(),
+                other.index_info.block_zone_maps.end(),
+                std::inserter(ret.index_info.block_zone_maps,
+                              ret.index_info.block_zone_maps.end()));
+    } else {
+      ret.index_info.block_zone_maps.clear();
+    }
     std::copy(other.files_managed.begin(), other.files_managed.end(),
               std::inserter(ret.files_managed, ret.files_managed.end()));
-    ret.try_compact();
+    if (compact) ret.try_compact();
     return ret;
   }
   /**
@@ -509,11 +525,19 @@ class sarray : public swriter_base<swriter_impl::output_iterator<T> > {
 
   /**
    * Sarray serializer. iarc must be associated with a directory.
-   * Saves into a prefix inside the directory.
+   * Saves into a prefix inside the directory. The data is written when the
+   * directory is closed, in parallel with the other components.
    */
   void save(oarchive& oarc) const {
     std::string prefix = oarc.get_prefix();
-    save(prefix + ".sidx");
+    ASSERT_TRUE(inited);
+    ASSERT_FALSE(writing);
+    // the copy shares the files, and keeps them alive until it is written
+    sarray<T> self(*this);
+    std::string index_file = prefix + ".sidx";
+    oarc.dir->add_component_write(index_file, [self, index_file]() {
+      self.save(index_file);
+    });
   }
 
   /**
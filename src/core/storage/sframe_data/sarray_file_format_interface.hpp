@@ -18,6 +18,8 @@
 #include <core/storage/sframe_data/sarray_index_file.hpp>
 #include <core/data/flexible_type/flexible_type.hpp>
 #include <core/storage/sframe_data/sframe_rows.hpp>
+#include <core/storage/sframe_data/sarray_v2_type_encoding.hpp>
+#include <core/util/dense_bitset.hpp>
 namespace turi {
 
 /**
@@ -110,6 +112,26 @@ class sarray_format_reader_common_base {
   virtual const index_file_information& get_index_info() const = 0;
 };
 
+/**
+ * Converts a numeric flexible_type to U (flex_int or flex_float), mapping
+ * UNDEFINED to missing_value. Throws if the value is not numeric.
+ */
+template <typename U>
+inline U flexible_type_to_numeric(const flexible_type& val, U missing_value) {
+  switch(val.get_type()) {
+   case flex_type_enum::INTEGER:
+     return static_cast<U>(val.get<flex_int>());
+   case flex_type_enum::FLOAT:
+     return static_cast<U>(val.get<flex_float>());
+   case flex_type_enum::UNDEFINED:
+     return missing_value;
+   default:
+     log_and_throw(std::string("Cannot read a value of type ") +
+                   flex_type_enum_to_name(val.get_type()) + " as a number");
+  }
+  return missing_value;
+}
+
 template <typename T>
 class sarray_format_reader : public sarray_format_reader_common_base<T> {
  public:
@@ -140,10 +162,84 @@ class sarray_format_reader<flexible_type>
                            size_t row_end,
                            sframe_rows& out_obj) {
     size_t ret = 0;
-    out_obj.resize(1);
+    // the column is overwritten: no need to copy it if it is shared
+    out_obj.reset_columns(1);
     ret = read_rows(row_start, row_end, *(out_obj.get_columns()[0]));
     return ret;
   }
+
+  /**
+   * Reads a collection of rows of a numeric column straight into a buffer
+   * of flex_float values. out must have room for (row_end - row_start)
+   * values. UNDEFINED values are written as missing_value. Values which
+   * are neither INTEGER, FLOAT nor UNDEFINED will cause an exception.
+   *
+   * The default implementation reads the flexible_type rows and converts
+   * them. File formats which can decode their blocks directly should
+   * override this.
+   *
+   * \returns Actual number of rows read.
+   */
+  virtual size_t read_rows_as(size_t row_start,
+                              size_t row_end,
+                              flex_float* out,
+                              flex_float missing_value) {
+    return read_rows_as_by_conversion(row_start, row_end, out, missing_value);
+  }
+
+  /**
+   * Reads a collection of rows of a numeric column straight into a buffer
+   * of flex_int values. See the flex_float overload for details.
+   */
+  virtual size_t read_rows_as(size_t row_start,
+                              size_t row_end,
+                              flex_int* out,
+                              flex_int missing_value) {
+    return read_rows_as_by_conversion(row_start, row_end, out, missing_value);
+  }
+
+  /**
+   * Evaluates pred on a collection of rows, resizing out to the number of
+   * rows read and setting bit i iff row (row_start + i) satisfies the
+   * predicate.
+   *
+   * The default implementation reads the flexible_type rows and evaluates
+   * the predicate on each. File formats which keep statistics about their
+   * blocks should override this to skip blocks which cannot match.
+   *
+   * \returns Actual number of rows read.
+   */
+  virtual size_t evaluate_predicate(size_t row_start,
+                                    size_t row_end,
+                                    const v2_block_impl::block_predicate& pred,
+                                    dense_bitset& out) {
+    std::vector<flexible_type> values;
+    size_t ret = read_rows(row_start, row_end, values);
+    out.resize(values.size());
+    out.clear();
+    for (size_t i = 0;i < values.size(); ++i) {
+      if (pred(values[i])) out.set_bit_unsync(i);
+    }
+    return ret;
+  }
+
+ protected:
+  /**
+   * Implements read_rows_as() by reading, then converting, flexible_type
+   * values.
+   */
+  template <typename U>
+  size_t read_rows_as_by_conversion(size_t row_start,
+                                    size_t row_end,
+                                    U* out,
+                                    U missing_value) {
+    std::vector<flexible_type> values;
+    size_t ret = read_rows(row_start, row_end, values);
+    for (size_t i = 0;i < values.size(); ++i) {
+      out[i] = flexible_type_to_numeric(values[i], missing_value);
+    }
+    return ret;
+  }
 };
 
 
@@ -5,6 +5,7 @@
  */
 #ifndef TURI_SFRAME_SARRAY_FILE_FORMAT_V2_HPP
 #define TURI_SFRAME_SARRAY_FILE_FORMAT_V2_HPP
+#include <cstring>
 #include <string>
 #include <memory>
 #include <typeinfo>
@@ -73,6 +74,7 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
     close();
     m_index_info = index;
     m_block_list.clear();
+    m_block_zone_maps.clear();
     m_start_row.clear();
     m_segment_list.clear();
     m_num_rows = 0;
@@ -88,11 +90,19 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
 
       const std::vector<std::vector<v2_block_impl::block_info>>& segment_blocks = m_manager.get_all_block_info(segment_id);
 
+      // zone maps are only usable if there is one for every block
+      bool has_zone_maps =
+          m_index_info.block_zone_maps.size() == m_index_info.nsegments &&
+          i < m_index_info.block_zone_maps.size() &&
+          m_index_info.block_zone_maps[i].size() == nblocks;
+
       for (size_t j = 0; j < nblocks; ++j) {
         block_address blockaddr{std::get<0>(columnaddr), std::get<1>(columnaddr), j};
         m_start_row.push_back(row_count);
         row_count += segment_blocks[column_id][j].num_elem;
         m_block_list.push_back(blockaddr);
+        m_block_zone_maps.push_back(has_zone_maps ?
+                                    &m_index_info.block_zone_maps[i][j] : nullptr);
       }
     }
     for (auto& ssize: m_index_info.segment_sizes) m_num_rows += ssize;
@@ -104,6 +114,8 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
     // the total # elements in the file
     m_start_row.push_back(m_num_rows);
     ASSERT_EQ(m_num_rows, row_count);
+    static atomic<size_t> reader_id_counter;
+    m_reader_id = reader_id_counter.inc();
   }
 
   /**
@@ -190,6 +202,50 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
     return out_obj.size();
   }
 
+  /**
+   * Reads a collection of rows of a numeric column straight into a buffer
+   * of flex_float values, decoding the blocks without constructing any
+   * flexible_type values. UNDEFINED values are written as missing_value.
+   * out must have room for (row_end - row_start) values.
+   *
+   * This bypasses the block cache used by read_rows(). Instead the last
+   * block decoded by each thread is retained, so reading a block in
+   * several consecutive chunks only decodes it once.
+   *
+   * \returns Actual number of rows read.
+   */
+  size_t read_rows_as(size_t row_start,
+                      size_t row_end,
+                      flex_float* out,
+                      flex_float missing_value);
+
+  /**
+   * Reads a collection of rows of a numeric column straight into a buffer
+   * of flex_int values. See the flex_float overload for details.
+   */
+  size_t read_rows_as(size_t row_start,
+                      size_t row_end,
+                      flex_int* out,
+                      flex_int missing_value);
+
+  /**
+   * Evaluates pred on a collection of rows, resizing out to the number of
+   * rows read and setting bit i iff row (row_start + i) satisfies the
+   * predicate.
+   *
+   * Blocks whose zone map shows that no element can satisfy the predicate
+   * are not read at all. The others are evaluated on their encoded values
+   * where possible, without constructing any flexible_type values. As in
+   * read_rows_as(), the selection of the last block evaluated by each
+   * thread is retained.
+   *
+   * \returns Actual number of rows read.
+   */
+  size_t evaluate_predicate(size_t row_start,
+                            size_t row_end,
+                            const v2_block_impl::block_predicate& pred,
+                            dense_bitset& out);
+
  private:
   typedef v2_block_impl::block_address block_address;
   typedef v2_block_impl::column_address column_address;
@@ -198,11 +254,19 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
   /// A reference to the manager
   v2_block_impl::block_manager& m_manager;
 
+  /// Uniquely identifies this reader (and this open()) in decoded block caches
+  size_t m_reader_id = 0;
+
   /// The index information of this array
   index_file_information m_index_info;
   /// NUmber of rows of this array
   size_t m_num_rows;
   std::vector<block_address> m_block_list;
+  /**
+   * The zone map of each block in m_block_list, pointing into
+   * m_index_info. nullptr if the index file has no zone maps for the block.
+   */
+  std::vector<const v2_block_impl::block_zone_map*> m_block_zone_maps;
   std::vector<size_t> m_start_row;
   std::vector<column_address> m_segment_list;
 
@@ -334,6 +398,31 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
 
   void fetch_cache_from_file(size_t block_number, cache_entry& ret);
 
+  /**
+   * Implements read_rows_as() for flex_int and flex_float.
+   */
+  /**
+   * Evaluates pred on every element of a block, working on the encoded
+   * block where possible. See \ref v2_block_impl::typed_evaluate_predicate().
+   */
+  void evaluate_block_predicate(size_t block_number,
+                                const v2_block_impl::block_predicate& pred,
+                                dense_bitset& selection);
+
+  template <typename U>
+  size_t read_rows_as_impl(size_t row_start,
+                           size_t row_end,
+                           U* out,
+                           U missing_value);
+
+  /**
+   * Reads and decodes an entire block into a primitive buffer.
+   */
+  template <typename U>
+  void decode_block_as(size_t block_number,
+                       std::vector<U>& values,
+                       U missing_value);
+
   size_t block_offset_containing_row(size_t row) {
     auto pos = std::lower_bound(m_start_row.begin(), m_start_row.end(), row);
     size_t blocknum = std::distance(m_start_row.begin(), pos);
@@ -572,6 +661,197 @@ read_rows(size_t row_start,
 }
 
 
+template <typename T>
+template <typename U>
+inline void sarray_format_reader_v2<T>::
+decode_block_as(size_t block_number,
+                std::vector<U>& values,
+                U missing_value) {
+  v2_block_impl::block_info* info;
+  auto buffer = m_manager.read_block(m_block_list[block_number], &info);
+  if (buffer == nullptr) {
+    log_and_throw("Unexpected block read failure. Bad file?");
+  }
+  values.resize(info->num_elem);
+  if (!v2_block_impl::typed_decode_as(*info, buffer->data(), buffer->size(),
+                                      values.data(), missing_value)) {
+    // not a simple numeric block. Decode and convert.
+    std::vector<flexible_type> decoded;
+    v2_block_impl::typed_decode(*info, buffer->data(), buffer->size(), decoded);
+    for (size_t i = 0;i < decoded.size(); ++i) {
+      values[i] = flexible_type_to_numeric(decoded[i], missing_value);
+    }
+  }
+}
+
+template <typename T>
+template <typename U>
+inline size_t sarray_format_reader_v2<T>::
+read_rows_as_impl(size_t row_start,
+                  size_t row_end,
+                  U* out,
+                  U missing_value) {
+  struct decoded_block {
+    size_t reader_id = (size_t)(-1);
+    size_t block_number = (size_t)(-1);
+    U missing_value;
+    std::vector<U> values;
+  };
+  static thread_local decoded_block last_block;
+
+  if (row_end > m_num_rows) row_end = m_num_rows;
+  if (row_start >= row_end) return 0;
+
+  size_t start_offset = block_offset_containing_row(row_start);
+  size_t end_offset = block_offset_containing_row(row_end - 1) + 1;
+  size_t output_idx = 0;
+  for (size_t i = start_offset; i < end_offset; ++i) {
+    size_t first_row_to_fetch_in_this_block = std::max(row_start, m_start_row[i]);
+    size_t last_row_to_fetch_in_this_block = std::min(row_end, m_start_row[i+1]);
+    if (last_block.reader_id != m_reader_id ||
+        last_block.block_number != i ||
+        std::memcmp(&last_block.missing_value, &missing_value, sizeof(U)) != 0) {
+      last_block.reader_id = (size_t)(-1);
+      decode_block_as(i, last_block.values, missing_value);
+      last_block.reader_id = m_reader_id;
+      last_block.block_number = i;
+      last_block.missing_value = missing_value;
+    }
+    const U* block_values = last_block.values.data();
+    std::copy(block_values + (first_row_to_fetch_in_this_block - m_start_row[i]),
+              block_values + (last_row_to_fetch_in_this_block - m_start_row[i]),
+              out + output_idx);
+    output_idx += last_row_to_fetch_in_this_block - first_row_to_fetch_in_this_block;
+  }
+
+  if(cppipc::must_cancel()) {
+    throw(std::string("Cancelled by user."));
+  }
+  return output_idx;
+}
+
+template <>
+inline size_t sarray_format_reader_v2<flexible_type>::
+read_rows_as(size_t row_start,
+             size_t row_end,
+             flex_float* out,
+             flex_float missing_value) {
+  return read_rows_as_impl(row_start, row_end, out, missing_value);
+}
+
+template <>
+inline size_t sarray_format_reader_v2<flexible_type>::
+read_rows_as(size_t row_start,
+             size_t row_end,
+             flex_int* out,
+             flex_int missing_value) {
+  return read_rows_as_impl(row_start, row_end, out, missing_value);
+}
+
+template <typename T>
+inline size_t sarray_format_reader_v2<T>::
+read_rows_as(size_t row_start,
+             size_t row_end,
+             flex_float* out,
+             flex_float missing_value) {
+  ASSERT_MSG(false, "Attempting to type decode a non-flexible_type column");
+  return 0;
+}
+
+template <typename T>
+inline size_t sarray_format_reader_v2<T>::
+read_rows_as(size_t row_start,
+             size_t row_end,
+             flex_int* out,
+             flex_int missing_value) {
+  ASSERT_MSG(false, "Attempting to type decode a non-flexible_type column");
+  return 0;
+}
+
+template <>
+inline size_t sarray_format_reader_v2<flexible_type>::
+evaluate_predicate(size_t row_start,
+                   size_t row_end,
+                   const v2_block_impl::block_predicate& pred,
+                   dense_bitset& out) {
+  if (row_end > m_num_rows) row_end = m_num_rows;
+  if (row_start >= row_end) {
+    out.resize(0);
+    return 0;
+  }
+  out.resize(row_end - row_start);
+  out.clear();
+
+  struct evaluated_block {
+    size_t reader_id = (size_t)(-1);
+    size_t block_number = (size_t)(-1);
+    v2_block_impl::block_predicate pred;
+    dense_bitset selection;
+  };
+  static thread_local evaluated_block last_block;
+
+  size_t start_offset = block_offset_containing_row(row_start);
+  size_t end_offset = block_offset_containing_row(row_end - 1) + 1;
+  for (size_t i = start_offset; i < end_offset; ++i) {
+    // no element of the block can match: leave its bits unset
+    const v2_block_impl::block_zone_map* zone_map = m_block_zone_maps[i];
+    if (zone_map != nullptr && !zone_map->may_match(pred)) continue;
+
+    size_t first_row_to_fetch_in_this_block = std::max(row_start, m_start_row[i]);
+    size_t last_row_to_fetch_in_this_block = std::min(row_end, m_start_row[i+1]);
+    if (last_block.reader_id != m_reader_id ||
+        last_block.block_number != i ||
+        last_block.pred.op != pred.op ||
+        last_block.pred.value.get_type() != pred.value.get_type() ||
+        last_block.pred.value != pred.value) {
+      last_block.reader_id = (size_t)(-1);
+      evaluate_block_predicate(i, pred, last_block.selection);
+      last_block.reader_id = m_reader_id;
+      last_block.block_number = i;
+      last_block.pred = pred;
+    }
+    size_t input_offset = m_start_row[i];
+    size_t output_offset = row_start;
+    for (size_t row = first_row_to_fetch_in_this_block;
+         row < last_row_to_fetch_in_this_block; ++row) {
+      if (last_block.selection.get(row - input_offset)) {
+        out.set_bit_unsync(row - output_offset);
+      }
+    }
+  }
+
+  if(cppipc::must_cancel()) {
+    throw(std::string("Cancelled by user."));
+  }
+  return row_end - row_start;
+}
+
+template <typename T>
+inline void sarray_format_reader_v2<T>::
+evaluate_block_predicate(size_t block_number,
+                         const v2_block_impl::block_predicate& pred,
+                         dense_bitset& selection) {
+  v2_block_impl::block_info* info;
+  auto buffer = m_manager.read_block(m_block_list[block_number], &info);
+  if (buffer == nullptr) {
+    log_and_throw("Unexpected block read failure. Bad file?");
+  }
+  if (!v2_block_impl::typed_evaluate_predicate(*info, buffer->data(), buffer->size(),
+                                               pred, selection)) {
+    log_and_throw("Unexpected block decode failure. Bad file?");
+  }
+}
+
+template <typename T>
+inline size_t sarray_format_reader_v2<T>::
+evaluate_predicate(size_t row_start,
+                   size_t row_end,
+                   const v2_block_impl::block_predicate& pred,
+                   dense_bitset& out) {
+  ASSERT_MSG(false, "Attempting to type decode a non-flexible_type column");
+  return 0;
+}
+
 /**
  * The array group writer which emits array v2 file formats.
  */
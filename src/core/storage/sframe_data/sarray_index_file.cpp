@@ -13,6 +13,7 @@
 #include <core/logging/logger.hpp>
 #include <core/logging/assertions.hpp>
 #include <core/storage/sframe_data/sarray_index_file.hpp>
+#include <core/storage/sframe_data/sarray_v2_block_types.hpp>
 #include <core/storage/fileio/general_fstream.hpp>
 #include <core/storage/fileio/fs_utils.hpp>
 #include <core/storage/fileio/sanitize_url.hpp>
@@ -52,6 +53,86 @@ index_file_information read_index_file(std::string index_file) {
 
 
 
+/*
+ * Zone maps are stored in each column as a list (one entry per segment) of
+ * lists (one entry per block) of
+ *  [num_elem, num_undefined, num_distinct]
+ * or, if the block has bounds,
+ *  [num_elem, num_undefined, num_distinct, type, min, max, sorted]
+ * where min and max are formatted by zone_map_value_to_string(). sorted is
+ * absent in older index files.
+ * Blocks without a zone map are stored as an empty list.
+ */
+static std::vector<std::vector<v2_block_impl::block_zone_map> >
+read_zone_maps(const boost::property_tree::ptree& zone_maps) {
+  std::vector<std::vector<v2_block_impl::block_zone_map> > ret;
+  for (auto& segment: zone_maps) {
+    ret.emplace_back();
+    for (auto& block: segment.second) {
+      std::vector<std::string> fields;
+      for (auto& field: block.second) {
+        fields.push_back(field.second.get_value<std::string>());
+      }
+      v2_block_impl::block_zone_map zone_map;
+      if (fields.size() >= 3) {
+        zone_map.valid = true;
+        zone_map.num_elem = std::stoull(fields[0]);
+        zone_map.num_undefined = std::stoull(fields[1]);
+        zone_map.num_distinct = std::stoull(fields[2]);
+      }
+      if (fields.size() >= 6) {
+        auto type = (flex_type_enum)std::stoi(fields[3]);
+        zone_map.has_bounds = true;
+        zone_map.min_value = v2_block_impl::zone_map_value_from_string(fields[4], type);
+        zone_map.max_value = v2_block_impl::zone_map_value_from_string(fields[5], type);
+      }
+      if (fields.size() >= 7) {
+        zone_map.sorted = std::stoi(fields[6]) != 0;
+      }
+      ret.back().push_back(zone_map);
+    }
+  }
+  return ret;
+}
+
+static bool has_valid_zone_map(
+    const std::vector<std::vector<v2_block_impl::block_zone_map> >& zone_maps) {
+  for (auto& segment: zone_maps) {
+    for (auto& zone_map: segment) {
+      if (zone_map.valid) return true;
+    }
+  }
+  return false;
+}
+
+static JSONNode write_zone_maps(
+    const std::vector<std::vector<v2_block_impl::block_zone_map> >& zone_maps) {
+  JSONNode ret(JSON_ARRAY);
+  ret.set_name("zone_maps");
+  for (auto& segment: zone_maps) {
+    JSONNode segment_node(JSON_ARRAY);
+    for (auto& zone_map: segment) {
+      JSONNode block_node(JSON_ARRAY);
+      if (zone_map.valid) {
+        block_node.push_back(JSONNode("", (unsigned long)zone_map.num_elem));
+        block_node.push_back(JSONNode("", (unsigned long)zone_map.num_undefined));
+        block_node.push_back(JSONNode("", (unsigned long)zone_map.num_distinct));
+        if (zone_map.has_bounds) {
+          block_node.push_back(JSONNode("", (int)zone_map.min_value.get_type()));
+          block_node.push_back(JSONNode("",
+              v2_block_impl::zone_map_value_to_string(zone_map.min_value)));
+          block_node.push_back(JSONNode("",
+              v2_block_impl::zone_map_value_to_string(zone_map.max_value)));
+          block_node.push_back(JSONNode("", (int)zone_map.sorted));
+        }
+      }
+      segment_node.push_back(block_node);
+    }
+    ret.push_back(segment_node);
+  }
+  return ret;
+}
+
 group_index_file_information read_array_group_index_file(std::string group_index_file) {
   group_index_file_information ret;
   ret.group_index_file = group_index_file;
@@ -87,7 +168,8 @@ group_index_file_information read_array_group_index_file(std::string group_index
   try {
     // the comon stuff are version, num_segments and segment_files
     ret.version = std::atoi(data.get<std::string>("sarray.version").c_str());
-    if (ret.version != 2) {
+    if (ret.version != 2 &&
+        ret.version != v2_block_impl::SARRAY_INTEGER_ENCODING_VERSION) {
       log_and_throw(std::string("Only v2 format is supported"));
     }
 
@@ -137,6 +219,12 @@ group_index_file_information read_array_group_index_file(std::string group_index
       if (info.segment_sizes.size() != info.nsegments) {
         log_and_throw(std::string("Malformed index_file_information. nsegments mismatch"));
       }
+      if (child.count("zone_maps")) {
+        info.block_zone_maps = read_zone_maps(child.get_child("zone_maps"));
+        if (info.block_zone_maps.size() != info.nsegments) {
+          log_and_throw(std::string("Malformed index_file_information. zone map nsegments mismatch"));
+        }
+      }
       ret.columns.push_back(info);
       ++column_number;
     }
@@ -182,7 +270,8 @@ void write_array_group_index_file(std::string group_index_file,
                                   const group_index_file_information& info) {
 #define LEGACY_INDEX_FORMAT
 
-  ASSERT_EQ(info.version, 2);
+  ASSERT_TRUE(info.version == 2 ||
+              info.version == v2_block_impl::SARRAY_INTEGER_ENCODING_VERSION);
   using boost::filesystem::path;
   using boost::algorithm::starts_with;
 
@@ -226,6 +315,10 @@ void write_array_group_index_file(std::string group_index_file,
 #else
   column.push_back(json::to_json_node("segment_sizes", info.columns[i].segment_sizes));
 #endif
+    if (info.columns[i].block_zone_maps.size() == info.nsegments &&
+        has_valid_zone_map(info.columns[i].block_zone_maps)) {
+      column.push_back(write_zone_maps(info.columns[i].block_zone_maps));
+    }
     columns.push_back(column);
   }
   data.push_back(columns);
@@ -10,6 +10,7 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <core/storage/sframe_data/sarray_v2_zone_map.hpp>
 namespace turi {
 class oarchive;
 class iarchive;
@@ -52,6 +53,13 @@ struct index_file_information {
   std::vector<std::string> segment_files;
   /// Any additional metadata stored with the array
   std::map<std::string, std::string> metadata;
+  /**
+   * Per block value statistics: block_zone_maps[segment][block].
+   * Either empty (no statistics available) or of length nsegments.
+   * Only available for version 2 arrays. Not serialized by save() / load();
+   * they are stored in the index file.
+   */
+  std::vector<std::vector<v2_block_impl::block_zone_map> > block_zone_maps;
 
   void save(oarchive& oarc) const;
   void load(iarchive& iarc);
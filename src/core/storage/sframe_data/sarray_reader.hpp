@@ -5,6 +5,7 @@
  */
 #ifndef TURI_UNITY_SFRAME_SARRAY_READER_HPP
 #define TURI_UNITY_SFRAME_SARRAY_READER_HPP
+#include <cmath>
 #include <set>
 #include <iterator>
 #include <type_traits>
@@ -474,6 +475,62 @@ class sarray_reader: public siterable<sarray_iterator<T> > {
                    size_t row_end,
                    sframe_rows& out_obj);
 
+  /**
+   * Hands the column of rows read by read_rows() back to the reader once
+   * the caller is done with it, and clears rows. See
+   * \ref sframe_reader::release_rows().
+   */
+  void release_rows(sframe_rows& rows) {
+    rows.release_columns(m_rows_column_pool);
+  }
+
+  /**
+   * Reads a collection of rows of a numeric column straight into a
+   * primitive buffer, bypassing flexible_type. out must have room for
+   * (row_end - row_start) values. UNDEFINED values are written as
+   * missing_value. INTEGER values are converted to flex_float.
+   * This function is also fully concurrent.
+   *
+   * \code
+   * std::vector<double> values(reader->size());
+   * reader->read_rows_as(0, reader->size(), values.data());
+   * \endcode
+   *
+   * Only available for sarray<flexible_type>. Throws if the column
+   * contains values which are not INTEGER, FLOAT or UNDEFINED.
+   *
+   * \returns Actual number of rows read.
+   */
+  size_t read_rows_as(size_t row_start,
+                      size_t row_end,
+                      flex_float* out,
+                      flex_float missing_value = NAN);
+
+  /**
+   * Reads a collection of rows of a numeric column straight into a
+   * buffer of flex_int values. FLOAT values are truncated.
+   * See the flex_float overload for details.
+   */
+  size_t read_rows_as(size_t row_start,
+                      size_t row_end,
+                      flex_int* out,
+                      flex_int missing_value = 0);
+
+  /**
+   * Evaluates a simple predicate on a collection of rows, resizing out to
+   * the number of rows read and setting bit i iff row (row_start + i)
+   * satisfies it. Blocks which the zone maps show cannot match are not
+   * read.
+   *
+   * Only available for sarray<flexible_type>.
+   *
+   * \returns Actual number of rows read.
+   */
+  size_t evaluate_predicate(size_t row_start,
+                            size_t row_end,
+                            const v2_block_impl::block_predicate& pred,
+                            dense_bitset& out);
+
 
   /**
    * Resets all the file handles. All existing iterators are invalidated.
@@ -521,6 +578,9 @@ class sarray_reader: public siterable<sarray_iterator<T> > {
 
   mutable std::vector<sarray_reader_buffer<T> > m_read_buffers;
 
+  /// Columns handed back by release_rows(), reused by read_rows()
+  sframe_rows_column_pool m_rows_column_pool;
+
   /**
    * Construct the format reader object from the sarray.
    * Only called by the init() functions.
@@ -538,6 +598,8 @@ class sarray_reader: public siterable<sarray_iterator<T> > {
        log_and_throw("Format version 1 deprecated");
        break;
      case 2:
+     case v2_block_impl::SARRAY_INTEGER_ENCODING_VERSION:
+       // the same block layout, with the extended integer encodings
        reader = new sarray_format_reader_v2<T>();
        reader->open(array.get_index_info());
        break;
@@ -585,9 +647,68 @@ inline size_t sarray_reader<flexible_type>::read_rows(size_t row_start,
                                                       size_t row_end,
                                                       sframe_rows& out_obj) {
   DASSERT_NE(reader, NULL);
+  // a column shared with rows read earlier is swapped for a recycled one
+  out_obj.reset_columns(1, &m_rows_column_pool);
   return reader->read_rows(row_start, row_end, out_obj);
 }
 
+template <typename T>
+inline size_t sarray_reader<T>::read_rows_as(size_t row_start,
+                                             size_t row_end,
+                                             flex_float* out,
+                                             flex_float missing_value) {
+  ASSERT_MSG(false, "read_rows_as() not implemented for "
+                    "non-flexible_type templatizations of sarray");
+  return 0;
+}
+
+template <typename T>
+inline size_t sarray_reader<T>::read_rows_as(size_t row_start,
+                                             size_t row_end,
+                                             flex_int* out,
+                                             flex_int missing_value) {
+  ASSERT_MSG(false, "read_rows_as() not implemented for "
+                    "non-flexible_type templatizations of sarray");
+  return 0;
+}
+
+template <>
+inline size_t sarray_reader<flexible_type>::read_rows_as(size_t row_start,
+                                                         size_t row_end,
+                                                         flex_float* out,
+                                                         flex_float missing_value) {
+  DASSERT_NE(reader, NULL);
+  return reader->read_rows_as(row_start, row_end, out, missing_value);
+}
+
+template <>
+inline size_t sarray_reader<flexible_type>::read_rows_as(size_t row_start,
+                                                         size_t row_end,
+                                                         flex_int* out,
+                                                         flex_int missing_value) {
+  DASSERT_NE(reader, NULL);
+  return reader->read_rows_as(row_start, row_end, out, missing_value);
+}
+
+template <typename T>
+inline size_t sarray_reader<T>::evaluate_predicate(size_t row_start,
+                                                   size_t row_end,
+                                                   const v2_block_impl::block_predicate& pred,
+                                                   dense_bitset& out) {
+  ASSERT_MSG(false, "evaluate_predicate() not implemented for "
+                    "non-flexible_type templatizations of sarray");
+  return 0;
+}
+
+template <>
+inline size_t sarray_reader<flexible_type>::evaluate_predicate(size_t row_start,
+                                                               size_t row_end,
+                                                               const v2_block_impl::block_predicate& pred,
+                                                               dense_bitset& out) {
+  DASSERT_NE(reader, NULL);
+  return reader->evaluate_predicate(row_start, row_end, pred, out);
+}
+
 /// \}
 
 } // namespace turi
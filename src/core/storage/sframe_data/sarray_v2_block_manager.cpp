@@ -7,13 +7,19 @@ extern "C" {
 #include <lz4/lz4.h>
 }
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
 #include <core/parallel/mutex.hpp>
 #include <boost/algorithm/string.hpp>
+#include <core/storage/fileio/async_reader.hpp>
+#include <core/storage/fileio/fixed_size_cache_manager.hpp>
 #include <core/storage/sframe_data/sarray_v2_block_manager.hpp>
 #include <core/storage/sframe_data/sarray_index_file.hpp>
 #include <core/storage/sframe_data/sframe_constants.hpp>
 #include <core/storage/sframe_data/sarray_v2_type_encoding.hpp>
 #include <core/storage/sframe_data/unfair_lock.hpp>
+#include <core/logging/trace_events.hpp>
 
 namespace turi {
 namespace v2_block_impl {
@@ -24,6 +30,52 @@ static unfair_lock* get_io_locks() {
   return iolocks;
 }
 
+/// The blocks read by \ref block_manager::read_block() on each thread
+static thread_local block_io_stats tls_io_stats;
+
+size_t block_manager::thread_bytes_read() {
+  return tls_io_stats.bytes_read;
+}
+
+const block_io_stats& block_manager::thread_io_stats() {
+  return tls_io_stats;
+}
+
+block_io_stats& block_io_stats::operator+=(const block_io_stats& other) {
+  blocks_read += other.blocks_read;
+  blocks_reread += other.blocks_reread;
+  sequential_reads += other.sequential_reads;
+  prefetch_hits += other.prefetch_hits;
+  bytes_on_disk += other.bytes_on_disk;
+  bytes_read += other.bytes_read;
+  bytes_decompressed += other.bytes_decompressed;
+  decode_time += other.decode_time;
+  return *this;
+}
+
+block_io_stats block_io_stats::operator-(const block_io_stats& other) const {
+  block_io_stats ret;
+  ret.blocks_read = blocks_read - other.blocks_read;
+  ret.blocks_reread = blocks_reread - other.blocks_reread;
+  ret.sequential_reads = sequential_reads - other.sequential_reads;
+  ret.prefetch_hits = prefetch_hits - other.prefetch_hits;
+  ret.bytes_on_disk = bytes_on_disk - other.bytes_on_disk;
+  ret.bytes_read = bytes_read - other.bytes_read;
+  ret.bytes_decompressed = bytes_decompressed - other.bytes_decompressed;
+  ret.decode_time = decode_time - other.decode_time;
+  return ret;
+}
+
+std::string block_io_stats::to_string() const {
+  std::stringstream out;
+  out << blocks_read << " blocks (" << blocks_reread << " re-read, "
+      << prefetch_hits << " read ahead), "
+      << bytes_on_disk << " bytes on disk, "
+      << bytes_decompressed << " bytes decompressed in " << decode_time << "s, "
+      << "sequentiality " << sequentiality();
+  return out.str();
+}
+
 block_manager& block_manager::get_instance() {
   static block_manager* manager = new block_manager();
   return *manager;
@@ -94,6 +146,8 @@ void block_manager::close_column(column_address addr) {
   }
   if (segment_destroyed) {
     m_segments.erase(segment_id);
+    std::lock_guard<turi::mutex> guard(m_prefetch_lock);
+    drop_prefetched_segment(segment_id);
   }
 }
 
@@ -124,6 +178,7 @@ const std::vector<std::vector<block_info>>& block_manager::get_all_block_info(si
 
 std::shared_ptr<std::vector<char> >
 block_manager::read_block(block_address addr, block_info** ret_info) {
+  trace::scoped_span span("block_manager", "read_block");
 
   size_t segment_id, column_id, block_id;
   std::tie(segment_id, column_id, block_id) = addr;
@@ -134,6 +189,110 @@ block_manager::read_block(block_address addr, block_info** ret_info) {
 
   if(ret_info) (*ret_info) = &info;
 
+  std::shared_ptr<std::vector<char> > ret;
+  block_access access;
+  double decode_time = 0;
+  bool prefetched = false;
+  if (!seg->mapping && SFRAME_BLOCK_PREFETCH_DEPTH > 0) {
+    auto entry = take_prefetched_and_read_ahead(seg, addr, access);
+    if (entry) {
+      std::unique_lock<turi::mutex> guard(entry->lock);
+      entry->cond.wait(guard, [&]() { return entry->done; });
+      // if the read ahead failed, retry it below
+      if (entry->data) {
+        ret = std::move(entry->data);
+        decode_time = entry->decode_time;
+        prefetched = true;
+      }
+    }
+  } else {
+    std::lock_guard<turi::mutex> guard(m_prefetch_lock);
+    access = mark_block_read(*seg, addr);
+  }
+
+  if (seg->mapping) {
+    ret = read_mapped_block(*seg->mapping, info, decode_time);
+  } else if (!ret) {
+    ret = read_block_from_segment(seg, info, decode_time);
+  }
+  if (ret) {
+    record_block_read(*seg, column_id, info, access, decode_time, prefetched);
+  }
+  return ret;
+}
+
+
+block_manager::block_access
+block_manager::mark_block_read(segment& seg, block_address addr) {
+  size_t column_id = std::get<1>(addr);
+  size_t block_id = std::get<2>(addr);
+  if (seg.blocks_read.size() < seg.blocks.size()) {
+    seg.blocks_read.resize(seg.blocks.size());
+  }
+  auto& column_read = seg.blocks_read[column_id];
+  if (column_read.size() < seg.blocks[column_id].size()) {
+    column_read.resize(seg.blocks[column_id].size(), false);
+  }
+  block_access ret;
+  ret.reread = column_read[block_id];
+  ret.sequential = block_id == 0 || column_read[block_id - 1];
+  column_read[block_id] = true;
+  return ret;
+}
+
+
+void block_manager::record_block_read(segment& seg, size_t column_id,
+                                      const block_info& info,
+                                      const block_access& access,
+                                      double decode_time, bool prefetched) {
+  block_io_stats stats;
+  stats.blocks_read = 1;
+  stats.blocks_reread = access.reread;
+  stats.sequential_reads = access.sequential;
+  stats.prefetch_hits = prefetched;
+  stats.bytes_on_disk = info.length;
+  stats.bytes_read = info.block_size;
+  if (info.flags & LZ4_COMPRESSION) stats.bytes_decompressed = info.block_size;
+  stats.decode_time = decode_time;
+  tls_io_stats += stats;
+
+  std::lock_guard<turi::mutex> guard(seg.stats_lock);
+  if (seg.column_io_stats.size() < seg.blocks.size()) {
+    seg.column_io_stats.resize(seg.blocks.size());
+  }
+  seg.column_io_stats[column_id] += stats;
+}
+
+
+std::map<std::string, block_io_stats> block_manager::get_io_stats() const {
+  std::map<std::string, block_io_stats> ret;
+  std::lock_guard<turi::mutex> guard(m_global_lock);
+  for (const auto& seg: m_segments) {
+    std::lock_guard<turi::mutex> stats_guard(seg.second->stats_lock);
+    const auto& column_stats = seg.second->column_io_stats;
+    for (size_t i = 0; i < column_stats.size(); ++i) {
+      if (column_stats[i].blocks_read == 0) continue;
+      ret[seg.second->segment_file + ":" + std::to_string(i)] = column_stats[i];
+    }
+  }
+  return ret;
+}
+
+
+void block_manager::reset_io_stats() {
+  std::lock_guard<turi::mutex> guard(m_global_lock);
+  for (const auto& seg: m_segments) {
+    std::lock_guard<turi::mutex> stats_guard(seg.second->stats_lock);
+    seg.second->column_io_stats.clear();
+  }
+}
+
+
+std::shared_ptr<std::vector<char> >
+block_manager::read_block_from_segment(std::shared_ptr<segment>& seg,
+                                       const block_info& info,
+                                       double& decode_time) {
+  trace::scoped_span span("block_manager", "read_block_from_disk");
   // get the return buffer
   // resize ret to the block length on disk
   std::shared_ptr<std::vector<char> > ret = m_buffer_pool.get_new_buffer();
@@ -155,9 +314,15 @@ block_manager::read_block(block_address addr, block_info** ret_info) {
     return ret;
   }
   guard.unlock();
+  decode_time += decompress_block(ret, info);
+  return ret;
+}
 
 
+double block_manager::decompress_block(std::shared_ptr<std::vector<char> >& ret,
+                                       const block_info& info) {
   if (info.flags & LZ4_COMPRESSION) {
+    auto start = std::chrono::steady_clock::now();
     /*
      * Decompress into another buffer.
      */
@@ -170,11 +335,192 @@ block_manager::read_block(block_address addr, block_info** ret_info) {
                         info.block_size);              // target length
     std::swap(ret, decompression_buffer);
     m_buffer_pool.release_buffer(std::move(decompression_buffer));
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+  }
+  return 0;
+}
+
+
+std::shared_ptr<block_manager::prefetch_entry>
+block_manager::take_prefetched_and_read_ahead(std::shared_ptr<segment>& seg,
+                                              block_address addr,
+                                              block_access& access) {
+  size_t segment_id, column_id, block_id;
+  std::tie(segment_id, column_id, block_id) = addr;
+  std::shared_ptr<prefetch_entry> ret;
+  std::vector<std::pair<block_address, std::shared_ptr<prefetch_entry> > > to_issue;
+  {
+    std::lock_guard<turi::mutex> guard(m_prefetch_lock);
+    auto iter = m_prefetched.find(addr);
+    if (iter != m_prefetched.end()) {
+      ret = iter->second;
+      erase_prefetched(iter);
+    }
+
+    const auto& column_blocks = seg->blocks[column_id];
+    access = mark_block_read(*seg, addr);
+
+    // only read ahead on a sequential scan
+    if (block_id > 0 && access.sequential) {
+      size_t last_block = std::min(block_id + SFRAME_BLOCK_PREFETCH_DEPTH,
+                                   column_blocks.size() - 1);
+      for (size_t b = block_id + 1; b <= last_block; ++b) {
+        block_address next_addr{segment_id, column_id, b};
+        if (m_prefetched.count(next_addr)) continue;
+        const block_info& info = column_blocks[b];
+        // the on disk bytes, and the decompressed bytes
+        size_t block_bytes = info.length;
+        if (info.flags & LZ4_COMPRESSION) block_bytes += info.block_size;
+        if (!reserve_prefetch_memory(block_bytes)) break;
+        auto entry = std::make_shared<prefetch_entry>();
+        entry->owner = this;
+        entry->reserved_bytes = block_bytes;
+        entry->order_position =
+            m_prefetch_order.insert(m_prefetch_order.end(), next_addr);
+        m_prefetched[next_addr] = entry;
+        to_issue.push_back({next_addr, entry});
+      }
+    }
+  }
+
+  // the reads overlap each other, and the read of addr by the caller.
+  // Blocks close to each other in the segment file are fetched by one ranged
+  // read: on remote files the number of requests dominates.
+  auto& reader = fileio::async_reader::get_instance();
+  size_t first = 0;
+  while (first < to_issue.size()) {
+    std::vector<std::pair<const block_info*, std::shared_ptr<prefetch_entry> > > group;
+    size_t range_begin = 0, range_end = 0;
+    for (size_t i = first; i < to_issue.size(); ++i) {
+      const block_info& info =
+          seg->blocks[std::get<1>(to_issue[i].first)][std::get<2>(to_issue[i].first)];
+      if (!group.empty() &&
+          (info.offset < range_end ||
+           info.offset - range_end > SFRAME_BLOCK_READ_COALESCE_GAP)) {
+        break;
+      }
+      if (group.empty()) range_begin = info.offset;
+      range_end = info.offset + info.length;
+      group.push_back({&info, to_issue[i].second});
+    }
+    first += group.size();
+
+    std::shared_ptr<segment> issue_seg = seg;
+    reader.read(seg->segment_file, range_begin, range_end - range_begin,
+                [this, issue_seg, group, range_begin, range_end](
+                    std::shared_ptr<std::vector<char> >& data,
+                    std::exception_ptr error) {
+      bool failed = error || data->size() != range_end - range_begin;
+      if (failed) {
+        logstream(LOG_DEBUG) << "Block read ahead of "
+                             << issue_seg->segment_file << " failed"
+                             << std::endl;
+      }
+      for (const auto& member: group) {
+        const block_info& info = *member.first;
+        std::shared_ptr<std::vector<char> > block;
+        double decode_time = 0;
+        if (!failed) {
+          if (group.size() == 1) {
+            block = std::move(data);
+          } else {
+            block = m_buffer_pool.get_new_buffer();
+            auto begin = data->begin() + (info.offset - range_begin);
+            block->assign(begin, begin + info.length);
+          }
+          decode_time = decompress_block(block, info);
+        }
+        const auto& entry = member.second;
+        std::lock_guard<turi::mutex> guard(entry->lock);
+        entry->decode_time = decode_time;
+        entry->data = std::move(block);
+        entry->done = true;
+        entry->cond.broadcast();
+      }
+      if (data) m_buffer_pool.release_buffer(std::move(data));
+      data.reset();
+    }, m_buffer_pool.get_new_buffer());
   }
   return ret;
 }
 
 
+bool block_manager::reserve_prefetch_memory(size_t bytes) {
+  auto& cache_manager = fileio::fixed_size_cache_manager::get_instance();
+  while (m_prefetch_bytes.value + bytes > SFRAME_BLOCK_PREFETCH_MEMORY_BUDGET ||
+         !cache_manager.try_reserve_memory(bytes)) {
+    // drop the oldest completed entry no one has picked up
+    if (m_prefetch_order.empty()) return false;
+    auto iter = m_prefetched.find(m_prefetch_order.front());
+    // consumed and dropped entries leave m_prefetch_order with m_prefetched
+    ASSERT_TRUE(iter != m_prefetched.end() &&
+                iter->second->order_position == m_prefetch_order.begin());
+    {
+      std::lock_guard<turi::mutex> guard(iter->second->lock);
+      // still being read. Nothing more can be dropped.
+      if (!iter->second->done) return false;
+    }
+    erase_prefetched(iter);
+  }
+  m_prefetch_bytes.inc(bytes);
+  return true;
+}
+
+
+void block_manager::drop_prefetched_segment(size_t segment_id) {
+  auto iter = m_prefetched.lower_bound(block_address{segment_id, 0, 0});
+  while (iter != m_prefetched.end() && std::get<0>(iter->first) == segment_id) {
+    iter = erase_prefetched(iter);
+  }
+}
+
+
+std::map<block_address, std::shared_ptr<block_manager::prefetch_entry> >::iterator
+block_manager::erase_prefetched(
+    std::map<block_address, std::shared_ptr<prefetch_entry> >::iterator iter) {
+  m_prefetch_order.erase(iter->second->order_position);
+  return m_prefetched.erase(iter);
+}
+
+
+block_manager::prefetch_entry::~prefetch_entry() {
+  if (reserved_bytes > 0) {
+    owner->m_prefetch_bytes.dec(reserved_bytes);
+    fileio::fixed_size_cache_manager::get_instance().release_reserved_memory(reserved_bytes);
+  }
+}
+
+
+
+std::shared_ptr<std::vector<char> >
+block_manager::read_mapped_block(const fileio::mapped_file& mapping,
+                                 const block_info& info,
+                                 double& decode_time) {
+  std::shared_ptr<std::vector<char> > ret;
+  if (info.offset > mapping.size() ||
+      info.length > mapping.size() - info.offset) {
+    // truncated file
+    return ret;
+  }
+  const char* src = mapping.data() + info.offset;
+  ret = m_buffer_pool.get_new_buffer();
+  if (info.flags & LZ4_COMPRESSION) {
+    // decompress straight out of the mapping. No intermediate copy needed.
+    ret->resize(info.block_size);
+    auto start = std::chrono::steady_clock::now();
+    LZ4_decompress_safe(src,                  // src
+                        ret->data(),          // target
+                        info.length,          // src length
+                        info.block_size);     // target length
+    decode_time += std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+  } else {
+    ret->assign(src, src + info.length);
+  }
+  return ret;
+}
+
 
 bool block_manager::read_typed_block(block_address addr,
                                      std::vector<flexible_type>& ret,
@@ -243,12 +589,48 @@ block_manager::get_segment_file_handle(std::shared_ptr<segment>& group) {
   return fin;
 }
 
+/**
+ * Refuses segments holding blocks with flags this version cannot decode,
+ * rather than misdecoding them.
+ */
+static void check_block_flags(const std::vector<std::vector<block_info> >& blocks,
+                              const std::string& segment_file) {
+  for (const auto& column_blocks: blocks) {
+    for (const auto& block: column_blocks) {
+      if (block.flags & ~(uint64_t)KNOWN_BLOCK_FLAGS) {
+        log_and_throw("Segment " + segment_file +
+                      " was written by a newer version and cannot be read");
+      }
+    }
+  }
+}
+
 void block_manager::init_segment(std::shared_ptr<block_manager::segment>& seg) {
   // fast exit
   if (seg->inited) return;
   std::lock_guard<turi::mutex> guard(seg->lock);
   // check and exit again while within the lock
   if (seg->inited) return;
+  if (SFRAME_MMAP_LOCAL_SEGMENTS &&
+      fileio::mapped_file::is_local_path(seg->segment_file)) {
+    auto mapping = std::make_shared<fileio::mapped_file>(seg->segment_file);
+    uint64_t footer_size = -1;
+    if (mapping->is_open() && mapping->size() >= sizeof(footer_size)) {
+      uint64_t filesize = mapping->size();
+      std::memcpy(&footer_size, mapping->data() + filesize - sizeof(footer_size),
+                  sizeof(footer_size));
+      if (footer_size <= filesize - sizeof(footer_size)) {
+        iarchive iarc(mapping->data() + filesize - footer_size - sizeof(footer_size),
+                      footer_size);
+        iarc >> seg->blocks;
+        check_block_flags(seg->blocks, seg->segment_file);
+        seg->mapping = mapping;
+        seg->inited = true;
+        seg->file_size = filesize;
+        return;
+      }
+    }
+  }
   // for each segment, read the block footer
   std::shared_ptr<general_ifstream> fin = get_segment_file_handle(seg);
   // jump to the footer
@@ -264,6 +646,7 @@ void block_manager::init_segment(std::shared_ptr<block_manager::segment>& seg) {
   fin->seekg(filesize - footer_size - sizeof(footer_size), std::ios_base::beg);
   iarchive iarc(*fin);
   iarc >> seg->blocks;
+  check_block_flags(seg->blocks, seg->segment_file);
 
   seg->inited = true;
   seg->file_size = filesize;
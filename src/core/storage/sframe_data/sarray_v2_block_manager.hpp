@@ -8,10 +8,15 @@
 #include <stdint.h>
 #include <vector>
 #include <fstream>
+#include <map>
+#include <deque>
+#include <list>
 #include <tuple>
+#include <memory>
 #include <core/parallel/pthread_tools.hpp>
 #include <core/parallel/atomic.hpp>
 #include <core/storage/fileio/general_fstream.hpp>
+#include <core/storage/fileio/mapped_file.hpp>
 #include <core/storage/sframe_data/sarray_index_file.hpp>
 #include <core/data/flexible_type/flexible_type.hpp>
 #include <core/util/buffer_pool.hpp>
@@ -130,8 +135,21 @@ namespace v2_block_impl {
  * are next needed, then reopen and seek) so as to avoid file handle usage
  * exceeding a certain limit (as defined in DEFAULT_FILE_HANDLE_POOL_SIZE)
  * Furthermore, the block manager can combine accesses of multiple columns in the
- * same array group into a single file handle. Future performance improvements
- * involving better IO scheduling can also be performed here.
+ * same array group into a single file handle.
+ *
+ * Read-Ahead
+ * ----------
+ * Reads of segments which are not memory mapped (for instance, segments on
+ * S3 or HDFS) are synchronous. To keep sequential scans from stalling on
+ * every block, when block b of a column is read right after block b - 1,
+ * the next SFRAME_BLOCK_PREFETCH_DEPTH blocks of the column are issued on
+ * the \ref fileio::async_reader, which reads them concurrently through
+ * their own file handles. A later \ref read_block() of one of those blocks
+ * picks up the prefetched (or in-flight) read instead of issuing its own.
+ * Prefetched blocks which are not yet consumed are bounded by
+ * SFRAME_BLOCK_PREFETCH_MEMORY_BUDGET, and are accounted for in the
+ * fixed_size_cache_manager. When the budget is exhausted, the oldest
+ * unconsumed prefetched blocks are dropped.
  *
  * When a column is opened by \ref open_column(), a \ref column_address is
  * returned. This is a pair of integers of {segment_file_id, and column_id}.
@@ -208,6 +226,35 @@ class block_manager {
   std::shared_ptr<std::vector<char> >
     read_block(block_address addr, block_info** ret_info = NULL);
 
+  /**
+   * Returns the total uncompressed size of all the blocks read with
+   * \ref read_block() by the calling thread so far. The difference between
+   * two calls is the number of bytes the thread read in between.
+   */
+  static size_t thread_bytes_read();
+
+  /**
+   * Returns the counters of all the blocks read with \ref read_block() by the
+   * calling thread so far. Like \ref thread_bytes_read(), the difference
+   * between two calls is what the thread read in between.
+   */
+  static const block_io_stats& thread_io_stats();
+
+  /**
+   * Returns the counters of the blocks read from every open column, keyed by
+   * column file name ("segment_file:column"). The counters of a column go
+   * away when its segment is closed.
+   *
+   * Safe for concurrent operation.
+   */
+  std::map<std::string, block_io_stats> get_io_stats() const;
+
+  /**
+   * Clears the counters returned by \ref get_io_stats(). Blocks read before
+   * are still counted as re-read when read again.
+   */
+  void reset_io_stats();
+
 
   /**
    * Reads a block given a block address ((array_group ID, segment ID, block
@@ -262,6 +309,25 @@ class block_manager {
 
   mutable turi::mutex m_global_lock;
   mutable turi::mutex m_file_handles_lock;
+
+  /**
+   * A block read issued ahead of time on the async_reader.
+   */
+  struct prefetch_entry {
+    turi::mutex lock;
+    turi::conditional cond;
+    bool done = false;
+    /// The block contents. Empty if the read failed.
+    std::shared_ptr<std::vector<char> > data;
+    /// Bytes of the prefetch memory budget held by this entry.
+    size_t reserved_bytes = 0;
+    /// Seconds spent decompressing data
+    double decode_time = 0;
+    block_manager* owner = nullptr;
+    /// The position of the entry in m_prefetch_order
+    std::list<block_address>::iterator order_position;
+    ~prefetch_entry();
+  };
   /**
    * Describes an array group and all the file handles pointing into
    * the array group
@@ -279,6 +345,14 @@ class block_manager {
      */
     std::weak_ptr<general_ifstream> segment_file_handle;
 
+    /**
+     * If the segment is a local file and SFRAME_MMAP_LOCAL_SEGMENTS is set,
+     * the whole segment mapped into memory. Blocks are then read from the
+     * mapping and segment_file_handle is never used.
+     * Like blocks, never modified once inited.
+     */
+    std::shared_ptr<fileio::mapped_file> mapping;
+
     bool inited = false;
 
     /** for for each column in the segment, the collection of blocks.
@@ -288,6 +362,20 @@ class block_manager {
      */
     std::vector<std::vector<block_info> > blocks;
 
+    /**
+     * blocks_read[column_id][block_id] is true if the block has been read.
+     * Used to detect sequential scans. Lazily sized, and protected by
+     * m_prefetch_lock.
+     */
+    std::vector<std::vector<bool> > blocks_read;
+
+    /**
+     * column_io_stats[column_id] counts the reads of the blocks of a column.
+     * Lazily sized, and protected by stats_lock.
+     */
+    std::vector<block_io_stats> column_io_stats;
+    turi::mutex stats_lock;
+
     turi::atomic<size_t> reference_count;
   };
 
@@ -304,6 +392,16 @@ class block_manager {
   /// Pool of buffers used for decompression, returns, etc.
   buffer_pool<std::vector<char> > m_buffer_pool;
 
+  /// Protects m_prefetched, m_prefetch_order and segment::blocks_read
+  turi::mutex m_prefetch_lock;
+  /// Blocks read ahead (or being read ahead) which have not been consumed
+  std::map<block_address, std::shared_ptr<prefetch_entry> > m_prefetched;
+  /// Addresses in m_prefetched in the order they were issued. An entry is
+  /// removed from both at once, see erase_prefetched().
+  std::list<block_address> m_prefetch_order;
+  /// Bytes reserved by all live prefetch entries
+  turi::atomic<size_t> m_prefetch_bytes;
+
 /**************************************************************************/
 /*                                                                        */
 /*                           Private Functions                            */
@@ -331,6 +429,83 @@ class block_manager {
   bool read_block_from_stream(general_ifstream& fin, std::vector<char>& ret,
                               block_info& info);
 
+  /**
+   * Reads a block out of a memory mapped segment.
+   * Decompresses the block if it was compressed, adding the time it took to
+   * decode_time.
+   * Returns an empty pointer on failure.
+   */
+  std::shared_ptr<std::vector<char> >
+      read_mapped_block(const fileio::mapped_file& mapping,
+                        const block_info& info,
+                        double& decode_time);
+
+  /**
+   * Reads a block of a segment through its file handle.
+   * Decompresses the block if it was compressed, adding the time it took to
+   * decode_time.
+   * Returns an empty pointer on failure.
+   */
+  std::shared_ptr<std::vector<char> >
+      read_block_from_segment(std::shared_ptr<segment>& seg,
+                              const block_info& info,
+                              double& decode_time);
+
+  /**
+   * Replaces a block read from disk by its decompressed contents, if it was
+   * compressed. Returns the seconds spent decompressing.
+   */
+  double decompress_block(std::shared_ptr<std::vector<char> >& ret,
+                        const block_info& info);
+
+  /// How a block read relates to the reads before it
+  struct block_access {
+    bool reread = false;
+    bool sequential = false;
+  };
+
+  /**
+   * Marks the block at addr read in segment::blocks_read, and returns how
+   * the read relates to the reads before it. m_prefetch_lock must be held.
+   */
+  block_access mark_block_read(segment& seg, block_address addr);
+
+  /**
+   * Returns the prefetched (or in-flight) read of the block at addr, if any,
+   * removing it from m_prefetched. Marks the block read, storing how the
+   * read relates to the ones before it in access. If the read of addr
+   * continues a sequential scan, issues reads of the following blocks.
+   * Only used for segments which are not memory mapped.
+   */
+  std::shared_ptr<prefetch_entry>
+      take_prefetched_and_read_ahead(std::shared_ptr<segment>& seg,
+                                     block_address addr,
+                                     block_access& access);
+
+  /**
+   * Adds a successful read of a block to the counters of its column and of
+   * the calling thread.
+   */
+  void record_block_read(segment& seg, size_t column_id,
+                         const block_info& info, const block_access& access,
+                         double decode_time, bool prefetched);
+
+  /**
+   * Reserves prefetch memory budget for a block of the given size, dropping
+   * the oldest completed prefetch entries if necessary.
+   * m_prefetch_lock must be held. Returns false if the budget is exhausted.
+   */
+  bool reserve_prefetch_memory(size_t bytes);
+
+  /// Removes a prefetch entry from m_prefetched and m_prefetch_order.
+  /// m_prefetch_lock must be held.
+  std::map<block_address, std::shared_ptr<prefetch_entry> >::iterator
+      erase_prefetched(std::map<block_address,
+                                std::shared_ptr<prefetch_entry> >::iterator iter);
+
+  /// Removes all prefetch entries of a segment. m_prefetch_lock must be held.
+  void drop_prefetched_segment(size_t segment_id);
+
   std::shared_ptr<segment> get_segment(size_t segmentid);
 
   void init_segment(std::shared_ptr<segment>& seg);
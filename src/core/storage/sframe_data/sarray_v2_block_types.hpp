@@ -6,6 +6,7 @@
 #ifndef TURI_SFRAME_SARRAY_V2_BLOCK_TYPES_HPP
 #define TURI_SFRAME_SARRAY_V2_BLOCK_TYPES_HPP
 #include <stdint.h>
+#include <string>
 #include <tuple>
 #include <core/storage/serialization/serializable_pod.hpp>
 namespace turi {
@@ -31,9 +32,26 @@ enum BLOCK_FLAGS {
   LZ4_COMPRESSION = 1,
   IS_FLEXIBLE_TYPE = 2,
   MULTIPLE_TYPE_BLOCK = 4,
-  BLOCK_ENCODING_EXTENSION = 8  // used to flag secondary compression schemes
+  BLOCK_ENCODING_EXTENSION = 8,  // used to flag secondary compression schemes
+  INTEGER_ENCODING_EXTENSION = 16 // INTEGER_RESERVED_FLAGS header present
 };
 
+/**
+ * All the block flags this version knows how to decode. Blocks with any
+ * other flag set were written by a newer version and are rejected.
+ */
+static constexpr size_t KNOWN_BLOCK_FLAGS =
+    LZ4_COMPRESSION | IS_FLEXIBLE_TYPE | MULTIPLE_TYPE_BLOCK |
+    BLOCK_ENCODING_EXTENSION | INTEGER_ENCODING_EXTENSION;
+
+/**
+ * The sarray format version of group index files holding blocks with the
+ * INTEGER_ENCODING_EXTENSION flag. The block layout is that of version 2, but
+ * readers which only know version 2 refuse the index file instead of
+ * misdecoding the integer blocks.
+ */
+static constexpr int SARRAY_INTEGER_ENCODING_VERSION = 3;
+
 /**
  * Floating point encoding formats
  */
@@ -44,6 +62,32 @@ enum FLAGS {
 };
 }
 
+/**
+ * Integer encoding formats.
+ * Stored as a one byte header in front of the values of an INTEGER or
+ * DATETIME block when INTEGER_ENCODING_EXTENSION is set. Blocks without the
+ * flag are always frame of reference encoded.
+ */
+namespace INTEGER_RESERVED_FLAGS {
+enum FLAGS {
+  FRAME_OF_REFERENCE_ENCODING = 0,
+  RUN_LENGTH_ENCODING = 1,
+  DELTA_OF_DELTA_ENCODING = 2
+};
+}
+
+/**
+ * String encoding formats.
+ * Stored as a one byte header in front of a string block
+ * (this was historically a serialized bool, hence the values).
+ */
+namespace STRING_RESERVED_FLAGS {
+enum FLAGS {
+  DIRECT_ENCODING = 0,
+  DICTIONARY_ENCODING = 1
+};
+}
+
 /**
  * Vector encoding formats
  */
@@ -83,6 +127,51 @@ struct block_info: public turi::IS_POD_TYPE {
    */
   uint16_t content_type = 0;
 };
+
+/**
+ * Counters of the blocks read by the block manager: per column of a
+ * segment, or by a thread (see block_manager::get_io_stats() and
+ * block_manager::thread_io_stats()).
+ */
+struct block_io_stats {
+  /// The number of blocks read
+  size_t blocks_read = 0;
+  /**
+   * The number of blocks read which had been read before. There is no block
+   * cache, so every one of them went back to the file.
+   */
+  size_t blocks_reread = 0;
+  /**
+   * The number of blocks read right after the block before them in the
+   * column, or which are the first block of the column.
+   */
+  size_t sequential_reads = 0;
+  /// The number of blocks which were already read ahead when asked for
+  size_t prefetch_hits = 0;
+  /// The bytes of the blocks read, as stored in the file
+  size_t bytes_on_disk = 0;
+  /// The bytes of the blocks read, uncompressed
+  size_t bytes_read = 0;
+  /// The bytes produced by decompressing the compressed blocks read
+  size_t bytes_decompressed = 0;
+  /// The time spent decompressing them, in seconds
+  double decode_time = 0;
+
+  /**
+   * The fraction of the blocks read which were read sequentially, between 0
+   * (random reads) and 1 (scans). 0 if nothing was read.
+   */
+  double sequentiality() const {
+    return blocks_read == 0 ? 0 : double(sequential_reads) / blocks_read;
+  }
+
+  block_io_stats& operator+=(const block_io_stats& other);
+  block_io_stats operator-(const block_io_stats& other) const;
+
+  /// A one line summary, such as "12 blocks (2 re-read), ..."
+  std::string to_string() const;
+};
+
 } // v2_block_impl
 
 /// \}
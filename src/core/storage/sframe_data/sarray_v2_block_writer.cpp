@@ -5,6 +5,7 @@
  */
 extern "C" {
 #include <lz4/lz4.h>
+#include <lz4/lz4hc.h>
 }
 #include <core/storage/sframe_data/sarray_v2_block_writer.hpp>
 #include <core/storage/sframe_data/sarray_index_file.hpp>
@@ -27,6 +28,8 @@ void block_writer::init(std::string group_index_file,
 
   m_blocks.resize(num_segments);
   for (auto& m_blockseg: m_blocks) m_blockseg.resize(num_columns);
+  m_zone_maps.resize(num_segments);
+  for (auto& m_zone_mapseg: m_zone_maps) m_zone_mapseg.resize(num_columns);
   m_index_info.group_index_file = group_index_file;
   m_index_info.version = 2;
   m_index_info.nsegments = num_segments;
@@ -45,6 +48,7 @@ void block_writer::init(std::string group_index_file,
       segf = segf + ":" + std::to_string(col);
     }
     m_index_info.columns[col].segment_sizes.resize(m_index_info.nsegments, 0);
+    m_index_info.columns[col].block_zone_maps.resize(m_index_info.nsegments);
   }
 }
 
@@ -71,6 +75,11 @@ void block_writer::open_segment(size_t segmentid, std::string filename) {
 void block_writer::set_options(const std::string& option, int64_t value) {
   if (option == "disable_padding") {
     m_disable_padding = value;
+  } else if (option == "compression_level") {
+    if (value < 0 || value > 16) {
+      log_and_throw("compression_level must be between 0 and 16");
+    }
+    m_compression_level = value;
   }
 }
 
@@ -80,6 +89,14 @@ size_t block_writer::write_block(size_t segment_id,
                                  size_t column_id,
                                  char* data,
                                  block_info block) {
+  return write_block(segment_id, column_id, data, block, block_zone_map());
+}
+
+size_t block_writer::write_block(size_t segment_id,
+                                 size_t column_id,
+                                 char* data,
+                                 block_info block,
+                                 const block_zone_map& zone_map) {
   DASSERT_LT(segment_id, m_index_info.nsegments);
   DASSERT_LT(column_id, m_index_info.columns.size());
   DASSERT_TRUE(m_output_files[segment_id] != NULL);
@@ -89,7 +106,15 @@ size_t block_writer::write_block(size_t segment_id,
   compression_buffer->resize(compress_bound);
   char* cbuffer = compression_buffer->data();
   size_t clen = compress_bound;
-  clen = LZ4_compress(data, cbuffer, block.block_size);
+  int compression_level = m_compression_level >= 0 ?
+      m_compression_level : (int)SFRAME_COMPRESSION_LEVEL;
+  if (compression_level > 0) {
+    // the high compression variant emits the same LZ4 block format, so
+    // the block manager decompresses it without any changes.
+    clen = LZ4_compressHC2(data, cbuffer, block.block_size, compression_level);
+  } else {
+    clen = LZ4_compress(data, cbuffer, block.block_size);
+  }
 
   char* buffer_to_write = NULL;
   size_t buffer_to_write_len = 0;
@@ -119,7 +144,9 @@ size_t block_writer::write_block(size_t segment_id,
   m_output_files[segment_id]->write(buffer_to_write, buffer_to_write_len);
   m_output_files[segment_id]->write(padding_bytes, padding);
   m_blocks[segment_id][column_id].push_back(block);
+  m_zone_maps[segment_id][column_id].push_back(zone_map);
   m_output_file_locks[segment_id].unlock();
+  if (block.flags & INTEGER_ENCODING_EXTENSION) m_integer_encoded_blocks.inc();
 
   m_buffer_pool.release_buffer(std::move(compression_buffer));
 
@@ -136,7 +163,8 @@ size_t block_writer::write_typed_block(size_t segment_id,
   auto serialization_buffer = m_buffer_pool.get_new_buffer();
   oarchive oarc(*serialization_buffer);
   typed_encode(data, block, oarc);
-  size_t ret = write_block(segment_id, column_id, serialization_buffer->data(), block);
+  size_t ret = write_block(segment_id, column_id, serialization_buffer->data(),
+                           block, compute_block_zone_map(data));
   m_buffer_pool.release_buffer(std::move(serialization_buffer));
   return ret;
 }
@@ -145,13 +173,27 @@ size_t block_writer::write_typed_block(size_t segment_id,
 void block_writer::close_segment(size_t segment_id) {
   emit_footer(segment_id);
   m_output_files[segment_id].reset();
+  for (size_t col = 0;col < m_index_info.columns.size(); ++col) {
+    m_index_info.columns[col].block_zone_maps[segment_id] =
+        std::move(m_zone_maps[segment_id][col]);
+  }
 }
 
 group_index_file_information& block_writer::get_index_info() {
+  update_format_version();
   return m_index_info;
 }
 
+void block_writer::update_format_version() {
+  if (m_integer_encoded_blocks.value == 0) return;
+  m_index_info.version = SARRAY_INTEGER_ENCODING_VERSION;
+  for (auto& column: m_index_info.columns) {
+    column.version = SARRAY_INTEGER_ENCODING_VERSION;
+  }
+}
+
 void block_writer::write_index_file() {
+  update_format_version();
   write_array_group_index_file(m_index_info.group_index_file,
                                m_index_info);
 }
@@ -16,6 +16,7 @@
 #include <core/data/flexible_type/flexible_type.hpp>
 #include <core/util/buffer_pool.hpp>
 #include <core/storage/sframe_data/sarray_v2_block_types.hpp>
+#include <core/storage/sframe_data/sarray_v2_zone_map.hpp>
 
 namespace turi {
 
@@ -74,8 +75,11 @@ class block_writer {
                     std::string filename);
 
   /**
-   * Sets write options. The only option available now is
-   * "disable_padding". If set to non-zero, disables 4K padding of blocks.
+   * Sets write options. The options available are:
+   *  - "disable_padding": If set to non-zero, disables 4K padding of blocks.
+   *  - "compression_level": 0 compresses blocks with the fast LZ4
+   *    compressor. 1 - 16 use the LZ4 high compression compressor at that
+   *    level. Defaults to \ref SFRAME_COMPRESSION_LEVEL.
    */
   void set_options(const std::string& option, int64_t value);
 
@@ -95,6 +99,17 @@ class block_writer {
                    char* data,
                    block_info block);
 
+  /**
+   * Writes a block of data into a segment, recording zone_map as the
+   * value statistics of the block in the index file.
+   * See \ref write_block(size_t, size_t, char*, block_info).
+   */
+  size_t write_block(size_t segment_id,
+                     size_t column_id,
+                     char* data,
+                     block_info block,
+                     const block_zone_map& zone_map);
+
   /**
    * Writes a block of data into a segment.
    *
@@ -103,6 +118,7 @@ class block_writer {
    * \param block_info Metadata about the block.
    *
    * No fields of block_info are required at the moment.
+   * A zone map of the values is recorded in the index file.
    * Returns the actual number of bytes written.
    */
   size_t write_typed_block(size_t segment_id,
@@ -165,14 +181,32 @@ class block_writer {
    */
   std::vector<std::vector<std::vector<block_info> > > m_blocks;
 
+  /**
+   * The zone maps of all the blocks, parallel to m_blocks.
+   * zone_maps[segment_id][column_id][block_id]
+   */
+  std::vector<std::vector<std::vector<block_zone_map> > > m_zone_maps;
+
   /// For each segment, for each column the number of rows written so far
   std::vector<std::vector<size_t> > m_column_row_counter;
 
   /// Writes the file footer
   void emit_footer(size_t segment_id);
 
+  /// Number of blocks written with the INTEGER_ENCODING_EXTENSION flag
+  turi::atomic<size_t> m_integer_encoded_blocks;
+
+  /**
+   * Raises the format version of the index to SARRAY_INTEGER_ENCODING_VERSION
+   * if any block needs it, so that older readers refuse the array.
+   */
+  void update_format_version();
+
   /// Disables 4K padding if enabled
   bool m_disable_padding = false;
+
+  /// The compression level. 0 is LZ4, 1 - 16 is LZ4HC at that level
+  int m_compression_level = -1;
 };
 
 } // namespace v2_block_impl
@@ -28,6 +28,18 @@ encoded_block_range encoded_block::get_range() {
   return encoded_block_range(*this);
 }
 
+bool encoded_block::evaluate(const block_predicate& pred,
+                             dense_bitset& selection) const {
+  if (!m_block.m_data) {
+    selection.resize(0);
+    return m_size == 0;
+  }
+  return typed_evaluate_predicate(m_block.m_block_info,
+                                  m_block.m_data->data(),
+                                  m_block.m_data->size(),
+                                  pred, selection);
+}
+
 void encoded_block::release() {
   m_block.m_data.reset();
   m_block.m_block_info = block_info();
@@ -10,6 +10,7 @@
 #include <vector>
 #include <memory>
 #include <core/data/flexible_type/flexible_type.hpp>
+#include <core/util/dense_bitset.hpp>
 #include <core/storage/sframe_data/sarray_v2_block_types.hpp>
 namespace turi {
 
@@ -28,6 +29,7 @@ namespace v2_block_impl {
 
 class encoded_block_range;
 struct typed_decode_stream;
+struct block_predicate;
 /**
  * This class provides accessors into a typed v2
  * sarray<flexible_type> encoded column block. It maintains the
@@ -91,6 +93,17 @@ class encoded_block {
    */
   encoded_block_range get_range();
 
+  /**
+   * Evaluates a predicate against every value in the block, working on the
+   * encoded representation where possible instead of decoding the values
+   * into flexible_type. selection is resized to size(), and bit i is set iff
+   * value i satisfies the predicate.
+   *
+   * Returns false if the block could not be decoded.
+   * See \ref typed_evaluate_predicate().
+   */
+  bool evaluate(const block_predicate& pred, dense_bitset& selection) const;
+
   /**
    * Release the block object. All acquired ranges are stil valid.
    */
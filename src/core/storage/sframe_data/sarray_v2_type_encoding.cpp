@@ -3,7 +3,9 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <cstring>
 #include <functional>
+#include <unordered_map>
 #include <core/data/flexible_type/flexible_type.hpp>
 #include <core/storage/sframe_data/sarray_v2_block_types.hpp>
 #include <core/storage/sframe_data/sarray_v2_type_encoding.hpp>
@@ -72,6 +74,252 @@ void decode_number(iarchive& iarc,
 }
 
 
+void decode_number_to_buffer(iarchive& iarc,
+                             size_t num_values,
+                             uint64_t* out) {
+  for (size_t i = 0; i < num_values; i += MAX_INTEGERS_PER_BLOCK) {
+    size_t buflen = std::min<size_t>(num_values - i, MAX_INTEGERS_PER_BLOCK);
+    frame_of_reference_decode_128(iarc, buflen, out + i);
+  }
+}
+
+
+namespace {
+
+/// Frame of reference encodes num_values values, 128 at a time
+template <typename OutArcType>
+void encode_frames(OutArcType& oarc, const uint64_t* values, size_t num_values) {
+  for (size_t i = 0; i < num_values; i += MAX_INTEGERS_PER_BLOCK) {
+    size_t buflen = std::min<size_t>(num_values - i, MAX_INTEGERS_PER_BLOCK);
+    frame_of_reference_encode_128(values + i, buflen, oarc);
+  }
+}
+
+void encode_run_length(oarchive& oarc, const uint64_t* values, size_t num_values) {
+  std::vector<uint64_t> run_values, run_lengths;
+  for (size_t i = 0; i < num_values; ) {
+    size_t j = i + 1;
+    while (j < num_values && values[j] == values[i]) ++j;
+    run_values.push_back(values[i]);
+    run_lengths.push_back(j - i);
+    i = j;
+  }
+  variable_encode(oarc, run_values.size());
+  encode_frames(oarc, run_values.data(), run_values.size());
+  encode_frames(oarc, run_lengths.data(), run_lengths.size());
+}
+
+void encode_delta_of_delta(oarchive& oarc, const uint64_t* values, size_t num_values) {
+  // all the arithmetic wraps, so that any sequence round trips
+  std::vector<uint64_t> residuals(num_values);
+  uint64_t prev_delta = 0;
+  for (size_t i = 0; i < num_values; ++i) {
+    if (i == 0) {
+      residuals[i] = values[0];
+      continue;
+    }
+    uint64_t delta = values[i] - values[i - 1];
+    residuals[i] = shifted_integer_encode((int64_t)(delta - prev_delta));
+    prev_delta = delta;
+  }
+  encode_frames(oarc, residuals.data(), num_values);
+}
+
+void decode_delta_of_delta(iarchive& iarc, size_t num_values, uint64_t* out) {
+  decode_number_to_buffer(iarc, num_values, out);
+  uint64_t delta = 0;
+  for (size_t i = 1; i < num_values; ++i) {
+    delta += (uint64_t)shifted_integer_decode(out[i]);
+    out[i] = out[i - 1] + delta;
+  }
+}
+
+void read_integer_format(iarchive& iarc, char& reserved) {
+  iarc.read(&(reserved), sizeof(reserved));
+  ASSERT_LT(reserved, 3);
+}
+
+} // anonymous namespace
+
+void encode_integer_buffer(oarchive& oarc,
+                           const uint64_t* values,
+                           size_t num_values) {
+  // Code the block every way which could win and keep the smallest.
+  // Run length coding only has a chance when the runs are long enough.
+  std::vector<char> best;
+  char best_format = INTEGER_RESERVED_FLAGS::FRAME_OF_REFERENCE_ENCODING;
+  {
+    oarchive candidate(best);
+    encode_frames(candidate, values, num_values);
+    best.resize(candidate.off);
+  }
+  size_t num_runs = 0;
+  for (size_t i = 0; i < num_values; ++i) {
+    num_runs += (i == 0 || values[i] != values[i - 1]);
+  }
+  auto try_format = [&](char format,
+                        void (*encoder)(oarchive&, const uint64_t*, size_t)) {
+    std::vector<char> buf;
+    oarchive candidate(buf);
+    encoder(candidate, values, num_values);
+    if (candidate.off < best.size()) {
+      buf.resize(candidate.off);
+      best.swap(buf);
+      best_format = format;
+    }
+  };
+  if (num_runs * 4 <= num_values) {
+    try_format(INTEGER_RESERVED_FLAGS::RUN_LENGTH_ENCODING, encode_run_length);
+  }
+  if (num_values > 2) {
+    try_format(INTEGER_RESERVED_FLAGS::DELTA_OF_DELTA_ENCODING, encode_delta_of_delta);
+  }
+  oarc.write(&(best_format), sizeof(best_format));
+  oarc.write(best.data(), best.size());
+}
+
+void decode_integer_buffer(iarchive& iarc,
+                           size_t num_values,
+                           uint64_t* out) {
+  char reserved = 0;
+  read_integer_format(iarc, reserved);
+  if (reserved == INTEGER_RESERVED_FLAGS::FRAME_OF_REFERENCE_ENCODING) {
+    decode_number_to_buffer(iarc, num_values, out);
+  } else if (reserved == INTEGER_RESERVED_FLAGS::RUN_LENGTH_ENCODING) {
+    uint64_t num_runs = 0;
+    variable_decode(iarc, num_runs);
+    std::vector<uint64_t> run_values(num_runs), run_lengths(num_runs);
+    decode_number_to_buffer(iarc, num_runs, run_values.data());
+    decode_number_to_buffer(iarc, num_runs, run_lengths.data());
+    size_t pos = 0;
+    for (size_t i = 0; i < num_runs; ++i) {
+      ASSERT_LE(pos + run_lengths[i], num_values);
+      std::fill(out + pos, out + pos + run_lengths[i], run_values[i]);
+      pos += run_lengths[i];
+    }
+    ASSERT_EQ(pos, num_values);
+  } else {
+    decode_delta_of_delta(iarc, num_values, out);
+  }
+}
+
+void decode_integer_runs(iarchive& iarc,
+                         size_t num_values,
+                         std::vector<uint64_t>& run_values,
+                         std::vector<size_t>& run_lengths) {
+  char reserved = 0;
+  read_integer_format(iarc, reserved);
+  if (reserved == INTEGER_RESERVED_FLAGS::RUN_LENGTH_ENCODING) {
+    uint64_t num_runs = 0;
+    variable_decode(iarc, num_runs);
+    std::vector<uint64_t> lengths(num_runs);
+    run_values.resize(num_runs);
+    decode_number_to_buffer(iarc, num_runs, run_values.data());
+    decode_number_to_buffer(iarc, num_runs, lengths.data());
+    run_lengths.assign(lengths.begin(), lengths.end());
+    return;
+  }
+  std::vector<uint64_t> values(num_values);
+  if (reserved == INTEGER_RESERVED_FLAGS::FRAME_OF_REFERENCE_ENCODING) {
+    decode_number_to_buffer(iarc, num_values, values.data());
+  } else {
+    decode_delta_of_delta(iarc, num_values, values.data());
+  }
+  run_values.clear();
+  run_lengths.clear();
+  for (size_t i = 0; i < num_values; ++i) {
+    if (i > 0 && values[i] == run_values.back()) {
+      ++run_lengths.back();
+    } else {
+      run_values.push_back(values[i]);
+      run_lengths.push_back(1);
+    }
+  }
+}
+
+namespace {
+
+/**
+ * Encodes the defined values of an INTEGER block with
+ * encode_integer_buffer().
+ */
+void encode_integer(block_info& info,
+                    oarchive& oarc,
+                    const std::vector<flexible_type>& data) {
+  std::vector<uint64_t> values;
+  values.reserve(data.size());
+  for (const auto& v: data) {
+    if (v.get_type() != flex_type_enum::UNDEFINED) values.push_back(v.get<flex_int>());
+  }
+  encode_integer_buffer(oarc, values.data(), values.size());
+}
+
+/**
+ * Decodes the values written by encode_integer() into the entries of ret
+ * which are not UNDEFINED.
+ */
+void decode_integer(iarchive& iarc,
+                    std::vector<flexible_type>& ret,
+                    size_t num_undefined) {
+  std::vector<uint64_t> values(ret.size() - num_undefined);
+  decode_integer_buffer(iarc, values.size(), values.data());
+  size_t j = 0;
+  for (auto& v: ret) {
+    if (v.get_type() != flex_type_enum::UNDEFINED) {
+      v.reinterpret_mutable_get<flex_int>() = values[j++];
+    }
+  }
+}
+
+/**
+ * Encodes the defined values of a DATETIME block as three integer columns:
+ * the timestamps, the time zone offsets and the microseconds, each with
+ * encode_integer_buffer(). The time zone and the microsecond columns are
+ * nearly always constant.
+ */
+void encode_datetime(block_info& info,
+                     oarchive& oarc,
+                     const std::vector<flexible_type>& data) {
+  std::vector<uint64_t> timestamps, time_zones, microseconds;
+  for (const auto& v: data) {
+    if (v.get_type() == flex_type_enum::UNDEFINED) continue;
+    const flex_date_time& dt = v.get<flex_date_time>();
+    timestamps.push_back(dt.posix_timestamp());
+    time_zones.push_back(shifted_integer_encode(dt.time_zone_offset()));
+    microseconds.push_back(dt.microsecond());
+  }
+  encode_integer_buffer(oarc, timestamps.data(), timestamps.size());
+  encode_integer_buffer(oarc, time_zones.data(), time_zones.size());
+  encode_integer_buffer(oarc, microseconds.data(), microseconds.size());
+}
+
+/**
+ * Decodes the values written by encode_datetime() into the entries of ret
+ * which are not UNDEFINED.
+ */
+void decode_datetime(iarchive& iarc,
+                     std::vector<flexible_type>& ret,
+                     size_t num_undefined) {
+  size_t num_values = ret.size() - num_undefined;
+  std::vector<uint64_t> timestamps(num_values), time_zones(num_values),
+      microseconds(num_values);
+  decode_integer_buffer(iarc, num_values, timestamps.data());
+  decode_integer_buffer(iarc, num_values, time_zones.data());
+  decode_integer_buffer(iarc, num_values, microseconds.data());
+  size_t j = 0;
+  for (auto& v: ret) {
+    if (v.get_type() != flex_type_enum::UNDEFINED) {
+      v = flex_date_time((int64_t)timestamps[j],
+                         (int32_t)shifted_integer_decode(time_zones[j]),
+                         (int32_t)microseconds[j]);
+      ++j;
+    }
+  }
+}
+
+} // anonymous namespace
+
+
 /**
  * Encodes a collection of doubles in data, skipping all UNDEFINED values.
  * It simply loops through the data, collecting a block of up to
@@ -201,6 +449,20 @@ void decode_double(iarchive& iarc,
   }
 }
 
+/**
+ * Returns the approximate number of bytes frame_of_reference_encode_128()
+ * needs to pack num_values values no larger than maxval.
+ */
+static size_t estimate_packed_size(size_t num_values, uint64_t maxval) {
+  size_t nbits = 64 - n_leading_zeros(maxval | 1);
+  // frame_of_reference rounds up to the next power of 2
+  size_t rounded_nbits = 1;
+  while (rounded_nbits < nbits) rounded_nbits *= 2;
+  size_t num_groups = (num_values + MAX_INTEGERS_PER_BLOCK - 1) / MAX_INTEGERS_PER_BLOCK;
+  // 1 byte header and about 2 bytes of variable encoded base per group
+  return (num_values * rounded_nbits + 7) / 8 + 3 * num_groups;
+}
+
 /**
  * Encodes a collection of strings in data, skipping all UNDEFINED values.
  *
@@ -220,6 +482,12 @@ void decode_double(iarchive& iarc,
  *  - for each entry:
  *     - write byte contents for each entry
  *
+ * The dictionary is used whenever it is estimated to be smaller than
+ * the direct encoding, as long as it has no more than
+ * MAX_STRING_DICTIONARY_SIZE entries and no more than half the values in
+ * the block are distinct. A one byte STRING_RESERVED_FLAGS header records
+ * the strategy.
+ *
  * \note The coding does not store the number of values stored. The decoder
  * \ref decode_string() requires the number of values to decode correctly.
  */
@@ -229,35 +497,59 @@ static void encode_string(block_info& info,
   bool use_dictionary_encoding = true;
   std::unordered_map<std::string, size_t> unique_values;
   std::vector<flexible_type> idx_values;
-  std::vector<std::string> str_values;
+  std::vector<const std::string*> str_values;
   idx_values.resize(data.size(), flexible_type(flex_type_enum::INTEGER));
+  size_t num_values = 0;
+  for (const auto& f: data) num_values += (f.get_type() != flex_type_enum::UNDEFINED);
+  size_t max_unique_values = std::min(MAX_STRING_DICTIONARY_SIZE,
+                                      std::max<size_t>(64, num_values / 2));
   size_t idxctr = 0;
+  size_t total_string_length = 0;
+  size_t dictionary_string_length = 0;
+  size_t max_string_length = 0;
   for (size_t i = 0;i < data.size(); ++i) {
     if (data[i].get_type() != flex_type_enum::UNDEFINED) {
-      auto iter = unique_values.find(data[i].get<std::string>());
+      const std::string& str = data[i].get<std::string>();
+      total_string_length += str.length();
+      max_string_length = std::max(max_string_length, str.length());
+      auto iter = unique_values.find(str);
       if (iter != unique_values.end()) {
         idx_values[idxctr++].mutable_get<flex_int>() = iter->second;
       } else {
         // if we have too many unique values, fail.
-        if (unique_values.size() >= 64) {
+        if (unique_values.size() >= max_unique_values) {
           use_dictionary_encoding = false;
           break;
         }
         size_t newidx = unique_values.size();
-        unique_values[data[i].get<std::string>()] = newidx;
-        str_values.push_back(data[i].get<std::string>());
+        iter = unique_values.insert({str, newidx}).first;
+        str_values.push_back(&(iter->first));
+        dictionary_string_length += str.length();
         idx_values[idxctr++].mutable_get<flex_int>() = newidx;
       }
     }
   }
-  oarc << use_dictionary_encoding;
+  if (use_dictionary_encoding && unique_values.size() > 64) {
+    // The dictionary was small enough to always be worth it before.
+    // Beyond that, only use it when it saves space.
+    size_t dictionary_size = dictionary_string_length +
+        2 * unique_values.size() +
+        estimate_packed_size(num_values, unique_values.size() - 1);
+    size_t direct_size = total_string_length +
+        estimate_packed_size(num_values, max_string_length);
+    use_dictionary_encoding = dictionary_size < direct_size;
+  }
+  char reserved = use_dictionary_encoding ?
+      STRING_RESERVED_FLAGS::DICTIONARY_ENCODING :
+      STRING_RESERVED_FLAGS::DIRECT_ENCODING;
+  oarc.write(&(reserved), sizeof(reserved));
   if (use_dictionary_encoding) {
     idx_values.resize(idxctr);
 
     variable_encode(oarc, str_values.size());
-    for (auto& str: str_values) {
-      variable_encode(oarc, str.length());
-      oarc.write(str.c_str(), str.length());
+    for (auto str: str_values) {
+      variable_encode(oarc, str->length());
+      oarc.write(str->c_str(), str->length());
     }
     encode_number(info, oarc, idx_values);
   } else {
@@ -459,7 +751,8 @@ void typed_encode(const std::vector<flexible_type>& data,
   }
   if (perform_type_encoding) {
     if (types_appeared.get((char)flex_type_enum::INTEGER)) {
-      encode_number(block, oarc, data);
+      block.flags |=  INTEGER_ENCODING_EXTENSION;
+      encode_integer(block, oarc, data);
     } else if(types_appeared.get((char)flex_type_enum::FLOAT)) {
       block.flags |=  BLOCK_ENCODING_EXTENSION;
       encode_double(block, oarc, data);
@@ -471,6 +764,9 @@ void typed_encode(const std::vector<flexible_type>& data,
     } else if (types_appeared.get((char)flex_type_enum::ND_VECTOR)) {
       block.flags |=  BLOCK_ENCODING_EXTENSION;
       encode_nd_vector(block, oarc, data);
+    } else if (types_appeared.get((char)flex_type_enum::DATETIME)) {
+      block.flags |=  INTEGER_ENCODING_EXTENSION;
+      encode_datetime(block, oarc, data);
     } else {
       flexible_type_impl::serializer s{oarc};
       for (size_t i = 0;i < data.size(); ++i) {
@@ -542,7 +838,11 @@ bool typed_decode(const block_info& info,
   if (perform_type_decoding) {
     // type decode
     if (column_type == flex_type_enum::INTEGER) {
-      decode_number(iarc, ret, num_undefined);
+      if (info.flags & INTEGER_ENCODING_EXTENSION) {
+        decode_integer(iarc, ret, num_undefined);
+      } else {
+        decode_number(iarc, ret, num_undefined);
+      }
     } else if (column_type == flex_type_enum::FLOAT) {
       if (info.flags & BLOCK_ENCODING_EXTENSION) {
         decode_double(iarc, ret, num_undefined);
@@ -557,6 +857,9 @@ bool typed_decode(const block_info& info,
     } else if (column_type == flex_type_enum::ND_VECTOR) {
       decode_nd_vector(iarc, ret, num_undefined,
                     info.flags & BLOCK_ENCODING_EXTENSION);
+    } else if (column_type == flex_type_enum::DATETIME &&
+               (info.flags & INTEGER_ENCODING_EXTENSION)) {
+      decode_datetime(iarc, ret, num_undefined);
     } else {
       flexible_type_impl::deserializer s{iarc};
       for (size_t i = 0;i < dsize; ++i) {
@@ -577,6 +880,360 @@ bool typed_decode(const block_info& info,
 }
 
 
+namespace {
+/**
+ * Converts in place the first n decoded 64-bit words stored in out to T.
+ * convert is called with the raw 64-bit word and returns the value as T.
+ */
+template <typename T, typename Fn>
+void convert_decoded_words(T* out, size_t n, Fn convert) {
+  static_assert(sizeof(T) == sizeof(uint64_t), "T must be 64 bits wide");
+  for (size_t i = 0;i < n; ++i) {
+    uint64_t word;
+    std::memcpy(&word, out + i, sizeof(word));
+    out[i] = convert(word);
+  }
+}
+
+/**
+ * Reads the type header of a single typed block.
+ * column_type is set to the type of the block (UNDEFINED if the block is
+ * empty or entirely undefined). If num_undefined is non-zero,
+ * undefined_bitmap flags the undefined entries.
+ *
+ * Returns false if this is a multiple type block or if the header is
+ * malformed.
+ */
+bool read_typed_header(iarchive& iarc,
+                       const block_info& info,
+                       flex_type_enum& column_type,
+                       dense_bitset& undefined_bitmap,
+                       size_t& num_undefined) {
+  if (!(info.flags & IS_FLEXIBLE_TYPE) || (info.flags & MULTIPLE_TYPE_BLOCK)) {
+    return false;
+  }
+  num_undefined = 0;
+  column_type = flex_type_enum::UNDEFINED;
+  char num_types; iarc >> num_types;
+  if (num_types == 0) return true;
+  if (num_types != 1 && num_types != 2) return false;
+
+  char c;
+  iarc >> c;
+  column_type = (flex_type_enum)c;
+  if (num_types == 2) {
+    undefined_bitmap.resize(info.num_elem);
+    undefined_bitmap.clear();
+    iarc.read((char*)undefined_bitmap.array, sizeof(size_t)*undefined_bitmap.arrlen);
+    num_undefined = undefined_bitmap.popcount();
+  }
+  return true;
+}
+
+/**
+ * Decodes the num_values defined values of an INTEGER or FLOAT block
+ * (positioned just after the header) into out, converting them to T.
+ */
+template <typename T>
+void decode_numeric_values_as(iarchive& iarc,
+                              const block_info& info,
+                              flex_type_enum column_type,
+                              size_t num_values,
+                              T* out) {
+  // Decode the defined values as raw 64-bit words into the output buffer,
+  // then convert each word in place.
+  uint64_t* words = reinterpret_cast<uint64_t*>(out);
+  if (column_type == flex_type_enum::INTEGER) {
+    if (info.flags & INTEGER_ENCODING_EXTENSION) {
+      decode_integer_buffer(iarc, num_values, words);
+    } else {
+      decode_number_to_buffer(iarc, num_values, words);
+    }
+    convert_decoded_words(out, num_values,
+                          [](uint64_t w) { return static_cast<T>((flex_int)w); });
+  } else {
+    char reserved = DOUBLE_RESERVED_FLAGS::LEGACY_ENCODING;
+    if (info.flags & BLOCK_ENCODING_EXTENSION) {
+      iarc.read(&(reserved), sizeof(reserved));
+      ASSERT_LT(reserved, 3);
+    }
+    decode_number_to_buffer(iarc, num_values, words);
+    if (reserved == DOUBLE_RESERVED_FLAGS::INTEGER_ENCODING) {
+      convert_decoded_words(out, num_values, [](uint64_t w) {
+                              return static_cast<T>((flex_float)(flex_int)w);
+                            });
+    } else {
+      convert_decoded_words(out, num_values, [](uint64_t w) {
+                              // right rotate. See encode_double_legacy
+                              w = (w >> 1) | (w << 63);
+                              flex_float d;
+                              std::memcpy(&d, &w, sizeof(d));
+                              return static_cast<T>(d);
+                            });
+    }
+  }
+}
+
+} // anonymous namespace
+
+template <typename T>
+bool typed_decode_as(const block_info& info,
+                     char* start, size_t len,
+                     T* out,
+                     T missing_value) {
+  turi::iarchive iarc(start, len);
+  size_t dsize = info.num_elem;
+  flex_type_enum column_type;
+  turi::dense_bitset undefined_bitmap;
+  size_t num_undefined = 0;
+  if (!read_typed_header(iarc, info, column_type,
+                         undefined_bitmap, num_undefined)) {
+    return false;
+  }
+  if (column_type == flex_type_enum::UNDEFINED) {
+    std::fill(out, out + dsize, missing_value);
+    return true;
+  }
+  if (column_type != flex_type_enum::INTEGER &&
+      column_type != flex_type_enum::FLOAT) {
+    return false;
+  }
+
+  size_t num_values = dsize - num_undefined;
+  decode_numeric_values_as(iarc, info, column_type, num_values, out);
+
+  // spread the values out from the back, filling in the undefined positions
+  if (num_undefined) {
+    size_t j = num_values;
+    for (size_t i = dsize; i > 0; --i) {
+      if (undefined_bitmap.get(i - 1)) {
+        out[i - 1] = missing_value;
+      } else {
+        out[i - 1] = out[--j];
+      }
+    }
+  }
+  return true;
+}
+
+template bool typed_decode_as<flex_int>(const block_info& info,
+                                        char* start, size_t len,
+                                        flex_int* out,
+                                        flex_int missing_value);
+template bool typed_decode_as<flex_float>(const block_info& info,
+                                          char* start, size_t len,
+                                          flex_float* out,
+                                          flex_float missing_value);
+
+
+namespace {
+
+typedef block_predicate::op_type predicate_op;
+
+template <typename T>
+inline bool compare_values(predicate_op op, const T& a, const T& b) {
+  switch(op) {
+   case predicate_op::EQ: return a == b;
+   case predicate_op::NE: return a != b;
+   case predicate_op::LT: return a < b;
+   case predicate_op::LE: return a <= b;
+   case predicate_op::GT: return a > b;
+   case predicate_op::GE: return a >= b;
+   default: return false;
+  }
+}
+
+/**
+ * Visits the defined elements of a block in order. matches(j) is called
+ * with the index j of the defined element among all defined elements,
+ * and the corresponding bit of selection is set if it returns true.
+ */
+template <typename Fn>
+void select_defined_values(size_t dsize,
+                           const dense_bitset& undefined_bitmap,
+                           size_t num_undefined,
+                           dense_bitset& selection,
+                           Fn matches) {
+  size_t j = 0;
+  for (size_t i = 0;i < dsize; ++i) {
+    if (num_undefined && undefined_bitmap.get(i)) continue;
+    if (matches(j++)) selection.set_bit_unsync(i);
+  }
+}
+
+template <typename T>
+void evaluate_numeric_predicate(iarchive& iarc,
+                                const block_info& info,
+                                flex_type_enum column_type,
+                                const dense_bitset& undefined_bitmap,
+                                size_t num_undefined,
+                                predicate_op op,
+                                T rhs,
+                                dense_bitset& selection) {
+  size_t num_values = info.num_elem - num_undefined;
+  if (column_type == flex_type_enum::INTEGER &&
+      (info.flags & INTEGER_ENCODING_EXTENSION)) {
+    // compare once per run of equal values
+    std::vector<uint64_t> run_values;
+    std::vector<size_t> run_lengths;
+    decode_integer_runs(iarc, num_values, run_values, run_lengths);
+    size_t run = 0, run_end = 0;
+    bool run_matches = false;
+    select_defined_values(info.num_elem, undefined_bitmap, num_undefined, selection,
+                          [&](size_t j) {
+                            if (j == run_end) {
+                              run_matches = compare_values(
+                                  op, static_cast<T>((flex_int)run_values[run]), rhs);
+                              run_end += run_lengths[run];
+                              ++run;
+                            }
+                            return run_matches;
+                          });
+    return;
+  }
+  std::vector<T> values(num_values);
+  decode_numeric_values_as(iarc, info, column_type, num_values, values.data());
+  select_defined_values(info.num_elem, undefined_bitmap, num_undefined, selection,
+                        [&](size_t j) { return compare_values(op, values[j], rhs); });
+}
+
+/**
+ * Compares the length len string beginning at s against rhs, returning
+ * -1, 0 or 1 as s is less than, equal to or greater than rhs.
+ */
+inline int compare_string_in_place(const char* s, size_t len,
+                                   const flex_string& rhs) {
+  int c = rhs.compare(0, rhs.length(), s, len);
+  return (c < 0) - (c > 0);
+}
+
+void evaluate_string_predicate(iarchive& iarc,
+                               const block_info& info,
+                               const dense_bitset& undefined_bitmap,
+                               size_t num_undefined,
+                               predicate_op op,
+                               const flex_string& rhs,
+                               dense_bitset& selection) {
+  size_t num_values = info.num_elem - num_undefined;
+  char reserved = 0;
+  iarc.read(&(reserved), sizeof(reserved));
+  std::vector<uint64_t> buf(num_values);
+  if (reserved == STRING_RESERVED_FLAGS::DICTIONARY_ENCODING) {
+    // evaluate the predicate once for each dictionary entry, then
+    // only the codes need to be looked at.
+    uint64_t num_entries = 0;
+    variable_decode(iarc, num_entries);
+    std::vector<char> entry_matches(num_entries);
+    for (auto& m: entry_matches) {
+      uint64_t str_len = 0;
+      variable_decode(iarc, str_len);
+      m = compare_values(op, compare_string_in_place(iarc.buf + iarc.off,
+                                                     str_len, rhs), 0);
+      iarc.off += str_len;
+    }
+    decode_number_to_buffer(iarc, num_values, buf.data());
+    select_defined_values(info.num_elem, undefined_bitmap, num_undefined, selection,
+                          [&](size_t j) { return entry_matches[buf[j]] != 0; });
+  } else {
+    // the lengths of all the strings, followed by the string contents
+    decode_number_to_buffer(iarc, num_values, buf.data());
+    const char* str = iarc.buf + iarc.off;
+    select_defined_values(info.num_elem, undefined_bitmap, num_undefined, selection,
+                          [&](size_t j) {
+                            const char* s = str;
+                            str += buf[j];
+                            return compare_values(
+                                op, compare_string_in_place(s, buf[j], rhs), 0);
+                          });
+  }
+}
+
+inline bool is_numeric_type(flex_type_enum t) {
+  return t == flex_type_enum::INTEGER || t == flex_type_enum::FLOAT;
+}
+
+} // anonymous namespace
+
+
+bool block_predicate::operator()(const flexible_type& v) const {
+  bool is_undefined = v.get_type() == flex_type_enum::UNDEFINED;
+  if (op == op_type::IS_UNDEFINED) return is_undefined;
+  if (op == op_type::IS_DEFINED) return !is_undefined;
+  if (is_undefined) return false;
+  switch(op) {
+   case op_type::EQ: return v == value;
+   case op_type::NE: return v != value;
+   case op_type::LT: return v < value;
+   case op_type::LE: return v <= value;
+   case op_type::GT: return v > value;
+   case op_type::GE: return v >= value;
+   default: return false;
+  }
+}
+
+
+bool typed_evaluate_predicate(const block_info& info,
+                              char* start, size_t len,
+                              const block_predicate& pred,
+                              dense_bitset& selection) {
+  size_t dsize = info.num_elem;
+  selection.resize(dsize);
+  selection.clear();
+
+  turi::iarchive iarc(start, len);
+  flex_type_enum column_type;
+  turi::dense_bitset undefined_bitmap;
+  size_t num_undefined = 0;
+  bool header_ok = read_typed_header(iarc, info, column_type,
+                                     undefined_bitmap, num_undefined);
+
+  if (header_ok) {
+    if (column_type == flex_type_enum::UNDEFINED) {
+      // empty, or all undefined
+      if (pred.op == predicate_op::IS_UNDEFINED) selection.fill();
+      return true;
+    }
+    if (pred.op == predicate_op::IS_UNDEFINED ||
+        pred.op == predicate_op::IS_DEFINED) {
+      if (num_undefined) selection = undefined_bitmap;
+      if (pred.op == predicate_op::IS_DEFINED) selection.invert();
+      return true;
+    }
+    flex_type_enum rhs_type = pred.value.get_type();
+    if (is_numeric_type(column_type) && is_numeric_type(rhs_type)) {
+      if (column_type == flex_type_enum::INTEGER &&
+          rhs_type == flex_type_enum::INTEGER) {
+        evaluate_numeric_predicate<flex_int>(iarc, info, column_type,
+                                             undefined_bitmap, num_undefined,
+                                             pred.op, pred.value.get<flex_int>(),
+                                             selection);
+      } else {
+        evaluate_numeric_predicate<flex_float>(iarc, info, column_type,
+                                               undefined_bitmap, num_undefined,
+                                               pred.op, (flex_float)pred.value,
+                                               selection);
+      }
+      return true;
+    }
+    if (column_type == flex_type_enum::STRING &&
+        rhs_type == flex_type_enum::STRING) {
+      evaluate_string_predicate(iarc, info, undefined_bitmap, num_undefined,
+                                pred.op, pred.value.get<flex_string>(),
+                                selection);
+      return true;
+    }
+  }
+
+  // no shortcut available. Decode everything.
+  std::vector<flexible_type> values;
+  if (!typed_decode(info, start, len, values)) return false;
+  for (size_t i = 0;i < values.size(); ++i) {
+    if (pred(values[i])) selection.set_bit_unsync(i);
+  }
+  return true;
+}
+
+
 /**************************************************************************/
 /*                                                                        */
 /*                             Stream Classes                             */
@@ -651,12 +1308,18 @@ bool typed_decode(const block_info& info,
  * Funnily it took me a little time to formalize this, but when I wrote it
  * in code the first time, it was quite intuitive...
  */
-#define PUT_BUFFER(x) \
+#define PUT_BUFFER(x) PUT_BUFFER_WITH(decodebuffer.first[decode_bufpos] = (x))
+
+/**
+ * Like \ref PUT_BUFFER, but runs the statement STMT to store the value into
+ * decodebuffer.first[decode_bufpos] instead of assigning it.
+ */
+#define PUT_BUFFER_WITH(STMT) \
    while(1) { \
      __brk = false; \
      if (skip == 0) { \
        if (decodebuffer.first[decode_bufpos].get_type() != flex_type_enum::UNDEFINED) {  \
-         decodebuffer.first[decode_bufpos] = (x);  \
+         STMT;  \
          __brk = true; \
        } \
        ++decode_bufpos; \
@@ -816,7 +1479,8 @@ bool decode_string_stream::read(size_t _num_elements,
   CORO_BEGIN(read)
   num_elements = _num_elements;
   idx_values.resize(num_elements, flexible_type(flex_type_enum::INTEGER));
-  iarc >> use_dictionary_encoding;
+  iarc.read(&(reserved), sizeof(reserved));
+  use_dictionary_encoding = (reserved == STRING_RESERVED_FLAGS::DICTIONARY_ENCODING);
   if (use_dictionary_encoding) {
     variable_decode(iarc, num_values);
     str_values.resize(num_values);
@@ -837,11 +1501,17 @@ bool decode_string_stream::read(size_t _num_elements,
     decode_number(iarc, idx_values, 0);
     for (i = 0;i < num_elements; ++i) {
       {
+        // ret is swapped with the value it replaces in the buffer. If that
+        // was a string no one else holds, its payload and characters are
+        // reused, so strings short enough to be stored inline by
+        // std::string are decoded without allocating.
+        if (ret.get_type() != flex_type_enum::STRING) ret.reset(flex_type_enum::STRING);
         size_t str_len = idx_values[i].get<flex_int>();
-        ret.mutable_get<std::string>().resize(str_len);
-        iarc.read(&(ret.mutable_get<std::string>()[0]), str_len);
+        std::string& str = ret.mutable_get<std::string>();
+        str.resize(str_len);
+        iarc.read(&(str[0]), str_len);
       }
-      PUT_BUFFER(ret);
+      PUT_BUFFER_WITH(decodebuffer.first[decode_bufpos].swap(ret));
     }
   }
   CORO_END;
@@ -1089,7 +1759,21 @@ size_t typed_decode_stream::read(const std::pair<flexible_type*, size_t>& decode
   // the interesting decoder
   if (perform_type_decoding) {
 
-    if (column_type == flex_type_enum::INTEGER) {
+    if ((column_type == flex_type_enum::INTEGER ||
+         column_type == flex_type_enum::DATETIME) &&
+        (info.flags & INTEGER_ENCODING_EXTENSION)) {
+      // the whole block is decoded at once, then handed out
+      values.resize(elements_to_decode);
+      for (auto& v: values) v.reset(column_type);
+      if (column_type == flex_type_enum::INTEGER) {
+        decode_integer(iarc, values, 0);
+      } else {
+        decode_datetime(iarc, values, 0);
+      }
+      for (i = 0; i < values.size(); ++i) {
+        PUT_BUFFER_SKIP(std::move(values[i]), i, values.size());
+      }
+    } else if (column_type == flex_type_enum::INTEGER) {
       number_decoder = new decode_number_stream;
       do {
         decode_bufpos = number_decoder->read(elements_to_decode, iarc, decodebuffer, skip);
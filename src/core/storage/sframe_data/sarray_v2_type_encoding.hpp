@@ -29,6 +29,11 @@ using namespace turi::integer_pack;
 
 static const size_t MAX_INTEGERS_PER_BLOCK = 128;
 static const size_t MAX_DOUBLES_PER_BLOCK = 512;
+/**
+ * The largest dictionary the string encoder will build for a block.
+ * See encode_string() in sarray_v2_type_encoding.cpp.
+ */
+static const size_t MAX_STRING_DICTIONARY_SIZE = 4096;
 
 /**
  * Encodes a collection of numbers in data, skipping all UNDEFINED values.
@@ -57,6 +62,56 @@ void decode_number(iarchive& iarc,
                    std::vector<flexible_type>& ret,
                    size_t num_undefined);
 
+/**
+ * Decodes num_values integers written by encode_number() directly into a
+ * contiguous buffer of length num_values, without constructing any
+ * flexible_type values. Since encode_number() does not store UNDEFINED
+ * values, out receives only the defined values, in order.
+ */
+void decode_number_to_buffer(iarchive& iarc,
+                             size_t num_values,
+                             uint64_t* out);
+
+/**
+ * Encodes the num_values integers at values, picking whichever of the
+ * INTEGER_RESERVED_FLAGS formats is the smallest:
+ * - one byte: encoding format.
+ * If FRAME_OF_REFERENCE_ENCODING:
+ *   The values, as written by encode_number().
+ * If RUN_LENGTH_ENCODING:
+ *   variable_encode() of the number of runs, then the value of every run and
+ *   the length of every run, each frame of reference encoded.
+ * If DELTA_OF_DELTA_ENCODING:
+ *   The first value, the first delta, then the differences between
+ *   consecutive deltas (all but the first value shifted_integer_encode()d),
+ *   frame of reference encoded. Evenly spaced values (such as timestamps
+ *   taken at a fixed interval) code to a few bytes per 128 values.
+ *
+ * Its use is flagged by turning on the block flag INTEGER_ENCODING_EXTENSION,
+ * which also raises the sarray format version of the group index to
+ * SARRAY_INTEGER_ENCODING_VERSION.
+ */
+void encode_integer_buffer(oarchive& oarc,
+                           const uint64_t* values,
+                           size_t num_values);
+
+/**
+ * Decodes num_values integers written by encode_integer_buffer() into out.
+ */
+void decode_integer_buffer(iarchive& iarc,
+                           size_t num_values,
+                           uint64_t* out);
+
+/**
+ * Decodes the runs of num_values integers written by encode_integer_buffer()
+ * into run_values and run_lengths, without expanding them if the block is
+ * run length encoded.
+ */
+void decode_integer_runs(iarchive& iarc,
+                         size_t num_values,
+                         std::vector<uint64_t>& run_values,
+                         std::vector<size_t>& run_lengths);
+
 /**
  * Encodes a collection of doubles in data, skipping all UNDEFINED values.
  * It simply loops through the data, collecting a block of up to
@@ -120,6 +175,66 @@ bool typed_decode(const block_info& info,
                   std::vector<flexible_type>& ret);
 
 
+/**
+ * Decodes a block of numeric values directly into a primitive buffer of
+ * length info.num_elem, without constructing any flexible_type values.
+ * T must be flex_int or flex_float. UNDEFINED entries are written as
+ * missing_value. Integer blocks are converted to T as by a static_cast,
+ * as are float blocks.
+ *
+ * Returns false (leaving out in an unspecified state) if the block is not a
+ * single typed INTEGER, FLOAT or all UNDEFINED block. The caller should then
+ * fall back to \ref typed_decode().
+ */
+template <typename T>
+bool typed_decode_as(const block_info& info,
+                     char* start, size_t len,
+                     T* out,
+                     T missing_value);
+
+
+/**
+ * A simple predicate on a single value which can be evaluated directly
+ * against an encoded block. See \ref typed_evaluate_predicate().
+ *
+ * IS_UNDEFINED and IS_DEFINED are null checks and ignore value.
+ * The comparisons compare each element of the block (on the left) against
+ * value (on the right) with the flexible_type comparison operators.
+ * UNDEFINED elements never satisfy a comparison.
+ */
+struct block_predicate {
+  enum class op_type: char {
+    IS_UNDEFINED, IS_DEFINED, EQ, NE, LT, LE, GT, GE
+  };
+  op_type op = op_type::IS_DEFINED;
+  flexible_type value;
+
+  /// Evaluates the predicate on a single decoded value
+  bool operator()(const flexible_type& v) const;
+};
+
+/**
+ * Evaluates pred on every element of a typed block, resizing selection to
+ * info.num_elem and setting bit i iff element i satisfies the predicate.
+ *
+ * Where the encoding allows it, this avoids constructing flexible_type
+ * values altogether:
+ *  - Null checks only read the block header.
+ *  - Numeric comparisons on INTEGER and FLOAT blocks run over the frame of
+ *    reference decoded buffer.
+ *  - String comparisons on dictionary encoded blocks evaluate the predicate
+ *    once per dictionary entry and then only look at the codes. Direct
+ *    encoded string blocks are compared in place.
+ * Everything else falls back to \ref typed_decode().
+ *
+ * Returns false if the block could not be decoded.
+ */
+bool typed_evaluate_predicate(const block_info& info,
+                              char* start, size_t len,
+                              const block_predicate& pred,
+                              dense_bitset& selection);
+
+
 /**
  * Encodes a collection of flexible_type values. The array must be of
  * contiguous type, but permitting undefined values.
@@ -134,7 +249,10 @@ bool typed_decode(const block_info& info,
  *   (round_op(#elem / 8) bytes) listing the positions of all the UNDEFINED
  *   fields)
  * - type specific encoding:
- *     - if integer or float, encode_number() is called
+ *     - if integer, encode_integer_buffer() is called
+ *     - if float, encode_double() is called
+ *     - if datetime, the timestamps, time zones and microseconds are each
+ *       coded with encode_integer_buffer()
  *     - if string, encode_string() is called
  *     - otherwise, direct serialization is currently used.
  *     - If UNDEFINED (i.e. array is of all UNDEFINED values, nothing is written)
@@ -236,6 +354,7 @@ struct decode_double_stream{
 struct decode_string_stream{
   DECL_CORO_STATE(read);
   size_t num_elements;
+  char reserved;
   bool use_dictionary_encoding = false;
   std::vector<flexible_type> idx_values;
   uint64_t num_values;
@@ -248,6 +367,10 @@ struct decode_string_stream{
 
 /**
  * Decodes num_elements of strings , calling the callback for each string.
+ *
+ * Dictionary encoded strings all share the payload of their dictionary
+ * entry, so decoded values are cheap to hold and identical values compare
+ * equal without comparing the string contents.
  */
   bool read(size_t num_elements,
             iarchive& iarc,
@@ -0,0 +1,226 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <unordered_set>
+#include <core/logging/assertions.hpp>
+#include <core/storage/sframe_data/sarray_v2_zone_map.hpp>
+#include <core/storage/sframe_data/sarray_v2_type_encoding.hpp>
+namespace turi {
+namespace v2_block_impl {
+
+namespace {
+
+bool is_bounded_value(const flexible_type& v) {
+  switch(v.get_type()) {
+   case flex_type_enum::INTEGER:
+   case flex_type_enum::DATETIME:
+     return true;
+   case flex_type_enum::FLOAT:
+     return !std::isnan(v.get<flex_float>());
+   case flex_type_enum::STRING:
+     return v.get<flex_string>().length() <= ZONE_MAP_MAX_STRING_LENGTH;
+   default:
+     return false;
+  }
+}
+
+/**
+ * Returns true if values of type a can be ordered against values of type b
+ */
+bool is_comparable(flex_type_enum a, flex_type_enum b) {
+  auto is_numeric = [](flex_type_enum t) {
+    return t == flex_type_enum::INTEGER || t == flex_type_enum::FLOAT;
+  };
+  return a == b || (is_numeric(a) && is_numeric(b));
+}
+
+/**
+ * The fraction of values assumed to satisfy a range predicate when the
+ * bounds do not allow interpolation.
+ */
+static const double DEFAULT_RANGE_SELECTIVITY = 1.0 / 3;
+
+bool is_numeric_value(const flexible_type& v) {
+  return v.get_type() == flex_type_enum::INTEGER ||
+         v.get_type() == flex_type_enum::FLOAT;
+}
+
+} // anonymous namespace
+
+
+bool block_zone_map::may_match(const block_predicate& pred) const {
+  typedef block_predicate::op_type op_type;
+  if (!valid) return true;
+  if (pred.op == op_type::IS_UNDEFINED) return num_undefined > 0;
+  bool has_defined = num_undefined < num_elem;
+  if (pred.op == op_type::IS_DEFINED) return has_defined;
+  // comparisons are never satisfied by undefined values
+  if (!has_defined) return false;
+  if (!has_bounds ||
+      !is_comparable(min_value.get_type(), pred.value.get_type())) {
+    return true;
+  }
+  const flexible_type& v = pred.value;
+  switch(pred.op) {
+   case op_type::EQ: return min_value <= v && v <= max_value;
+   case op_type::NE: return !(min_value == v && max_value == v);
+   case op_type::LT: return min_value < v;
+   case op_type::LE: return min_value <= v;
+   case op_type::GT: return max_value > v;
+   case op_type::GE: return max_value >= v;
+   default: return true;
+  }
+}
+
+
+double block_zone_map::estimate_num_matches(const block_predicate& pred) const {
+  typedef block_predicate::op_type op_type;
+  DASSERT_TRUE(valid);
+  if (!may_match(pred)) return 0;
+  double num_defined = num_elem - num_undefined;
+  double distinct = std::max<double>(num_distinct, 1);
+  switch(pred.op) {
+   case op_type::IS_UNDEFINED: return num_undefined;
+   case op_type::IS_DEFINED: return num_defined;
+   case op_type::EQ: return num_defined / distinct;
+   case op_type::NE:
+     // a block with a single distinct value which may match has no
+     // value equal to pred.value.
+     return num_distinct <= 1 ? num_defined : num_defined * (1 - 1 / distinct);
+   default:
+     break;
+  }
+  if (!has_bounds ||
+      !is_numeric_value(min_value) || !is_numeric_value(pred.value)) {
+    return num_defined * DEFAULT_RANGE_SELECTIVITY;
+  }
+  double lo = min_value.to<double>();
+  double hi = max_value.to<double>();
+  double v = pred.value.to<double>();
+  // may_match() guarantees the predicate is satisfied by some value
+  // in [lo, hi]; a block with a single value therefore fully matches.
+  if (hi <= lo) return num_defined;
+  double below = std::min(std::max((v - lo) / (hi - lo), 0.0), 1.0);
+  if (pred.op == op_type::LT || pred.op == op_type::LE) {
+    return num_defined * below;
+  } else {
+    return num_defined * (1 - below);
+  }
+}
+
+
+block_zone_map compute_block_zone_map(const std::vector<flexible_type>& data) {
+  block_zone_map ret;
+  ret.valid = true;
+  ret.num_elem = data.size();
+  bool bounded = true;
+  bool first = true;
+  bool sorted = true;
+  std::unordered_set<size_t> hashes;
+  for (const auto& v: data) {
+    if (v.get_type() == flex_type_enum::UNDEFINED) {
+      ++ret.num_undefined;
+      continue;
+    }
+    hashes.insert(v.hash());
+    if (!bounded) continue;
+    if (!is_bounded_value(v) ||
+        (!first && v.get_type() != ret.min_value.get_type())) {
+      bounded = false;
+    } else if (first) {
+      ret.min_value = v;
+      ret.max_value = v;
+      first = false;
+    } else {
+      // values are only ever added in increasing order while sorted
+      if (v < ret.max_value) sorted = false;
+      if (v < ret.min_value) ret.min_value = v;
+      if (v > ret.max_value) ret.max_value = v;
+    }
+  }
+  ret.num_distinct = hashes.size();
+  ret.has_bounds = bounded && !first;
+  ret.sorted = ret.has_bounds && sorted && ret.num_undefined == 0;
+  if (!ret.has_bounds) {
+    ret.min_value = flexible_type();
+    ret.max_value = flexible_type();
+  }
+  return ret;
+}
+
+
+std::string zone_map_value_to_string(const flexible_type& val) {
+  switch(val.get_type()) {
+   case flex_type_enum::INTEGER:
+     return std::to_string(val.get<flex_int>());
+   case flex_type_enum::FLOAT: {
+     // 17 significant digits round trip every double exactly
+     char buf[32];
+     snprintf(buf, sizeof(buf), "%.17g", val.get<flex_float>());
+     return buf;
+   }
+   case flex_type_enum::DATETIME: {
+     const auto& dt = val.get<flex_date_time>();
+     return std::to_string(dt.posix_timestamp()) + " " +
+         std::to_string(dt.time_zone_offset()) + " " +
+         std::to_string(dt.microsecond());
+   }
+   case flex_type_enum::STRING: {
+     // hex encoded so that arbitrary bytes survive the index file
+     static const char hexchars[] = "0123456789abcdef";
+     const auto& s = val.get<flex_string>();
+     std::string ret;
+     ret.reserve(2 * s.length());
+     for (unsigned char c: s) {
+       ret.push_back(hexchars[c >> 4]);
+       ret.push_back(hexchars[c & 15]);
+     }
+     return ret;
+   }
+   default:
+     log_and_throw("Zone maps do not support values of type " +
+                   std::string(flex_type_enum_to_name(val.get_type())));
+  }
+}
+
+
+flexible_type zone_map_value_from_string(const std::string& str,
+                                         flex_type_enum t) {
+  switch(t) {
+   case flex_type_enum::INTEGER:
+     return flex_int(std::strtoll(str.c_str(), nullptr, 10));
+   case flex_type_enum::FLOAT:
+     return flex_float(std::strtod(str.c_str(), nullptr));
+   case flex_type_enum::DATETIME: {
+     std::stringstream strm(str);
+     int64_t ts = 0;
+     int32_t tz = 0, us = 0;
+     strm >> ts >> tz >> us;
+     return flex_date_time(ts, tz, us);
+   }
+   case flex_type_enum::STRING: {
+     auto hexval = [](char c)->int {
+       return (c >= 'a') ? (c - 'a' + 10) : (c - '0');
+     };
+     ASSERT_MSG(str.length() % 2 == 0, "Malformed zone map string bound");
+     flex_string ret(str.length() / 2, '\0');
+     for (size_t i = 0;i < ret.length(); ++i) {
+       ret[i] = (char)((hexval(str[2 * i]) << 4) | hexval(str[2 * i + 1]));
+     }
+     return ret;
+   }
+   default:
+     log_and_throw("Zone maps do not support values of type " +
+                   std::string(flex_type_enum_to_name(t)));
+  }
+}
+
+} // v2_block_impl
+} // turi
@@ -0,0 +1,105 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_SARRAY_V2_ZONE_MAP_HPP
+#define TURI_SFRAME_SARRAY_V2_ZONE_MAP_HPP
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <core/data/flexible_type/flexible_type.hpp>
+namespace turi {
+
+
+/**
+ * \internal
+ * \ingroup sframe_physical
+ * \addtogroup sframe_internal SFrame Internal
+ * \{
+ */
+
+/**
+ * SFrame v2 Format Implementation Detail
+ */
+namespace v2_block_impl {
+
+struct block_predicate;
+
+/**
+ * Strings longer than this do not get min / max bounds in a zone map.
+ */
+static const size_t ZONE_MAP_MAX_STRING_LENGTH = 256;
+
+/**
+ * Value statistics about a single block of a column, stored alongside the
+ * segment sizes in the sarray index file.
+ *
+ * Zone maps are only available for blocks written through
+ * \ref block_writer::write_typed_block() (or copied along with such a
+ * block). All other blocks have valid == false.
+ */
+struct block_zone_map {
+  /// True if the statistics below were recorded for this block.
+  bool valid = false;
+  /**
+   * True if min_value and max_value bound every defined value of the block.
+   * Bounds are only recorded for blocks of INTEGER, FLOAT, DATETIME and
+   * STRING values, which contain no NaNs, and no strings longer than
+   * \ref ZONE_MAP_MAX_STRING_LENGTH.
+   */
+  bool has_bounds = false;
+  flexible_type min_value;
+  flexible_type max_value;
+  /**
+   * True if the block has bounds, no UNDEFINED elements, and its elements
+   * are in non-decreasing order.
+   */
+  bool sorted = false;
+  /// The number of elements in the block
+  uint64_t num_elem = 0;
+  /// The number of UNDEFINED elements in the block
+  uint64_t num_undefined = 0;
+  /// An estimate of the number of distinct defined values in the block.
+  uint64_t num_distinct = 0;
+
+  /**
+   * Returns false only if no element of the block can possibly satisfy
+   * the predicate. i.e. a block for which this returns false can be skipped.
+   */
+  bool may_match(const block_predicate& pred) const;
+
+  /**
+   * Returns an estimate of the number of elements of the block which
+   * satisfy the predicate, for use in query planning. Range predicates
+   * assume numeric values are uniformly distributed between the bounds,
+   * and equality predicates assume distinct values are equally frequent.
+   * Returns 0 only if may_match(pred) is false. Must only be called
+   * on valid zone maps.
+   */
+  double estimate_num_matches(const block_predicate& pred) const;
+};
+
+/**
+ * Computes the zone map of a block of values.
+ */
+block_zone_map compute_block_zone_map(const std::vector<flexible_type>& data);
+
+/**
+ * Converts a zone map bound to a string which can be stored in the
+ * index file. The conversion is exact; see \ref zone_map_value_from_string().
+ */
+std::string zone_map_value_to_string(const flexible_type& val);
+
+/**
+ * Converts a string produced by \ref zone_map_value_to_string() back to a
+ * value of type t.
+ */
+flexible_type zone_map_value_from_string(const std::string& str,
+                                         flex_type_enum t);
+
+} // v2_block_impl
+
+/// \}
+} // namespace turi
+#endif
@@ -27,7 +27,10 @@ sframe::sframe(const sframe& other) {
     } else {
       index_info = other.index_info;
       index_file = other.index_file;
+      // other may be opening a pending column
+      std::lock_guard<mutex> guard(other.lock);
       columns = other.columns;
+      pending_columns = other.pending_columns;
       inited = true;
       writing = false;
     }
@@ -36,12 +39,24 @@ sframe::sframe(const sframe& other) {
 
 sframe& sframe::operator=(const sframe& other) {
   ASSERT_MSG(!writing, "Cannot copy over an array which is currently writing");
+  if (this == &other) return *this;
+  // copy the columns out under other's lock first, so that the two locks
+  // are never held together
+  decltype(columns) other_columns;
+  decltype(pending_columns) other_pending_columns;
+  {
+    std::lock_guard<mutex> guard(other.lock);
+    other_columns = other.columns;
+    other_pending_columns = other.pending_columns;
+  }
+  std::lock_guard<mutex> guard(lock);
   reset();
   if (other.inited) {
     ASSERT_MSG(!other.writing, "Cannot copy an array which is writing");
     index_info = other.index_info;
     index_file = other.index_file;
-    columns = other.columns;
+    columns = std::move(other_columns);
+    pending_columns = std::move(other_pending_columns);
     inited = true;
     writing = false;
   } else {
@@ -89,6 +104,7 @@ sframe& sframe::operator=(sframe&& other) {
   index_info = std::move(other.index_info);
   index_file = std::move(other.index_file);
   columns = std::move(other.columns);
+  pending_columns = std::move(other.pending_columns);
   group_writer = std::move(other.group_writer);
   inited = std::move(other.inited);
   writing = std::move(other.writing);
@@ -96,6 +112,7 @@ sframe& sframe::operator=(sframe&& other) {
   other.index_info = sframe_index_file_information();
   other.index_file = "";
   other.columns.clear();
+  other.pending_columns.clear();
 
   other.inited = false;
   other.writing = false;
@@ -134,10 +151,6 @@ void sframe::create_arrays_for_reading(sframe_index_file_information frame_index
   reset();
   writing = false;
   index_info = frame_index_info;
-  // open each column for read
-  for (size_t i = 0; i < index_info.ncolumns; ++i) {
-    columns.emplace_back(new sarray<flexible_type>);
-  }
   /*
    * In a regular saved sframe, each sarray has index file of the following form:
    *  1st col : group_index.sidx:0
@@ -158,16 +171,20 @@ void sframe::create_arrays_for_reading(sframe_index_file_information frame_index
     }
   }
 
+  // The columns are opened when first used. See column().
+  columns.resize(index_info.ncolumns);
   for (size_t i = 0; i < index_info.ncolumns; ++i) {
     std::string group_index_file;
     size_t colid;
     std::tie(group_index_file, colid) =
         parse_v2_segment_filename(index_info.column_files[i]);
+    auto pending = std::make_shared<pending_column>();
     if (index_groups[group_index_file].version == 1) {
-      columns[i]->open_for_read(frame_index_info.column_files[i]);
+      pending->index_file = frame_index_info.column_files[i];
     } else {
-      columns[i]->open_for_read(index_groups[group_index_file].columns[colid]);
+      pending->info = index_groups[group_index_file].columns[colid];
     }
+    pending_columns.push_back(pending);
   }
 
   keep_array_file_ref();
@@ -185,6 +202,7 @@ void sframe::create_arrays_for_reading(
   }
   // fill index_info manually
   columns = new_columns;
+  pending_columns.resize(columns.size());
   index_info.column_files.resize(columns.size());
   index_info.version = 0;
   index_info.ncolumns = columns.size();
@@ -302,7 +320,7 @@ void sframe::create_arrays_for_writing(const std::vector<std::string>& column_na
 }
 
 
-sframe sframe::append(const sframe& other) const {
+sframe sframe::append(const sframe& other, bool compact) const {
   // both cannot be writing
   ASSERT_EQ(writing, false);
   ASSERT_EQ(other.writing, false);
@@ -321,21 +339,35 @@ sframe sframe::append(const sframe& other) const {
   }
 
   sframe ret = (*this);
+  ret.open_all_columns();
+  other.open_all_columns();
   // validated. now combine each column individually
   for (size_t i = 0;i < ret.columns.size(); ++i) {
     // append the columns
     ret.columns[i] = std::make_shared<sarray<flexible_type>>
-        (ret.columns[i]->append(*other.columns[i]));
+        (ret.columns[i]->append(*other.columns[i], false));
   }
   ret.index_info.nrows += other.index_info.nrows;
-  ret.try_compact();
+  if (compact) ret.try_compact();
   return ret;
 }
 
 void sframe::try_compact() {
+  open_all_columns();
   for (auto& col : columns) col->try_compact();
 }
 
+void sframe::set_cache_priority(block_cache::priority priority) const {
+  auto& cache = block_cache::get_instance();
+  open_all_columns();
+  for (const auto& col : columns) {
+    for (const auto& segment_file : col->get_index_info().segment_files) {
+      cache.set_priority_hint(parse_v2_segment_filename(segment_file).first,
+                              priority);
+    }
+  }
+}
+
 std::unique_ptr<sframe::reader_type> sframe::get_reader() const {
   Dlog_func_entry();
   ASSERT_MSG(inited, "Invalid SFrame");
@@ -377,7 +409,7 @@ dataframe_t sframe::to_dataframe() {
     std::string name = column_name(i);
     ret.set_column(name, std::vector<flexible_type>(), column_type(i));
     std::vector<flexible_type>& out_column = ret.values[name];
-    turi::copy(*columns[i], std::inserter(out_column, out_column.begin()));
+    turi::copy(*column(i), std::inserter(out_column, out_column.begin()));
   }
   return ret;
 }
@@ -385,7 +417,7 @@ dataframe_t sframe::to_dataframe() {
 
 std::shared_ptr<sarray<flexible_type> > sframe::select_column(size_t column_id) const {
   if (column_id < num_columns()) {
-    return columns[column_id];
+    return column(column_id);
   } else {
     log_and_throw (std::string("Select column index out of bound. " +
                        std::to_string(column_id)));
@@ -402,7 +434,7 @@ sframe sframe::select_columns(const std::vector<std::string>& names) const {
   std::vector<std::shared_ptr<sarray<flexible_type> > > new_columns;
   for (const auto& name : names) {
     size_t col_index = column_index(name);
-    new_columns.push_back(columns[col_index]);
+    new_columns.push_back(column(col_index));
   }
   return sframe(new_columns, names);
 }
@@ -423,6 +455,7 @@ sframe sframe::add_column(std::shared_ptr<sarray<flexible_type> > sarr_ptr,
     log_and_throw(std::string("Column must have the same # of rows as sframe."));
   }
 
+  open_all_columns();
   std::vector<std::shared_ptr<sarray<flexible_type> > > new_columns = columns;
   std::vector<std::string> new_column_names = index_info.column_names;
   new_columns.push_back(sarr_ptr);
@@ -474,6 +507,7 @@ void sframe::set_column_name(size_t i, const std::string& name) {
 sframe sframe::remove_column(size_t i) const {
   ASSERT_LT(i, num_columns());
 
+  open_all_columns();
   std::vector<std::shared_ptr<sarray<flexible_type> > > new_columns = columns;
   std::vector<std::string> new_column_names = index_info.column_names;
   new_columns.erase(new_columns.begin() + i);
@@ -485,6 +519,7 @@ sframe sframe::swap_columns(size_t column_1, size_t column_2) const {
   ASSERT_LT(column_1, num_columns());
   ASSERT_LT(column_2, num_columns());
 
+  open_all_columns();
   std::vector<std::shared_ptr<sarray<flexible_type> > > new_columns = columns;
   std::vector<std::string> new_column_names = index_info.column_names;
 
@@ -658,6 +693,8 @@ void sframe::close() {
   inited = true;
   writing = false;
   columns.resize(index_info.ncolumns);
+  pending_columns.clear();
+  pending_columns.resize(index_info.ncolumns);
   for (size_t i = 0;i < index_info.ncolumns; ++i) {
     columns[i].reset(new sarray<flexible_type>());
     columns[i]->open_for_read(group_index.columns[i]);
@@ -673,16 +710,8 @@ void sframe::save_as_csv(std::string csv_file,
   if (!fout.good()) {
     log_and_throw(std::string("Unable to open " + sanitize_url(csv_file) + " for write"));
   }
-  auto reader = get_reader(1);
-  auto iter_begin = reader->begin(0);
-  auto iter_end = reader->end(0);
-
   writer.write_verbatim(fout, column_names());
-
-  while(iter_begin != iter_end) {
-    writer.write(fout, (*iter_begin));
-    ++iter_begin;
-  }
+  write_csv_rows(fout, *this, writer);
 }
 
 bool sframe::set_metadata(const std::string& key, std::string val) {
@@ -699,6 +728,7 @@ void sframe::reset() {
   index_file = "";
   index_info = sframe_index_file_information();
   columns.clear();
+  pending_columns.clear();
 }
 
 
@@ -717,7 +747,7 @@ void sframe::write(size_t segmentid, const sframe_rows& t) {
   group_writer->write_segment(segmentid, t);
 }
 
-void sframe::save(std::string index_file) const {
+void sframe::save(std::string index_file, int64_t compression_level) const {
   ASSERT_TRUE(inited);
   ASSERT_FALSE(writing);
   std::string expected_ext(".frame_idx");
@@ -725,7 +755,7 @@ void sframe::save(std::string index_file) const {
     log_and_throw("Index file must end with " + expected_ext);
   }
 
-  sframe_save(*this, index_file);
+  sframe_save(*this, index_file, compression_level);
 }
 
 void sframe::debug_print() {
@@ -752,7 +782,22 @@ void sframe::debug_print() {
 
 void sframe::save(oarchive& oarc) const {
   std::string prefix = oarc.get_prefix();
-  save(prefix + ".frame_idx");
+  ASSERT_TRUE(inited);
+  ASSERT_FALSE(writing);
+  // The columns are compacted here rather than by the write, so that writes
+  // of sframes sharing columns do not compact them concurrently. (Legacy
+  // columns are not compacted; see sframe_save.)
+  bool has_legacy_sframe = false;
+  for (size_t i = 0;i < num_columns(); ++i) {
+    if (select_column(i)->get_index_info().version < 2) has_legacy_sframe = true;
+  }
+  if (!has_legacy_sframe) sframe_fast_compact(*this);
+  // the copy shares the columns, and keeps them alive until it is written
+  sframe self(*this);
+  std::string index_file = prefix + ".frame_idx";
+  oarc.dir->add_component_write(index_file, [self, index_file]() {
+    self.save(index_file);
+  });
 }
 
 void sframe::load(iarchive& iarc) {
@@ -762,6 +807,7 @@ void sframe::load(iarchive& iarc) {
 }
 
 bool sframe::delete_files_on_destruction() {
+  open_all_columns();
   for(auto &i: columns) {
     i->delete_files_on_destruction();
   }
@@ -772,6 +818,42 @@ bool sframe::delete_files_on_destruction() {
   return true;
 }
 
+const std::shared_ptr<sarray<flexible_type> >& sframe::column(size_t i) const {
+  std::lock_guard<mutex> guard(lock);
+  if (columns[i] == nullptr) {
+    pending_column& pending = *pending_columns[i];
+    std::lock_guard<mutex> pending_guard(pending.lock);
+    if (pending.array == nullptr) {
+      auto array = std::make_shared<sarray<flexible_type> >();
+      if (!pending.index_file.empty()) {
+        array->open_for_read(pending.index_file);
+      } else {
+        array->open_for_read(pending.info);
+      }
+      pending.array = array;
+    }
+    columns[i] = pending.array;
+  }
+  return columns[i];
+}
+
+void sframe::open_all_columns() const {
+  for (size_t i = 0; i < columns.size(); ++i) column(i);
+}
+
+flex_type_enum sframe::stored_column_type(size_t i) const {
+  {
+    std::lock_guard<mutex> guard(lock);
+    if (columns[i] == nullptr && pending_columns[i]->index_file.empty()) {
+      const auto& metadata = pending_columns[i]->info.metadata;
+      auto iter = metadata.find("__type__");
+      if (iter == metadata.end()) return flex_type_enum::UNDEFINED;
+      return flex_type_enum(std::stoi(iter->second));
+    }
+  }
+  return column(i)->get_type();
+}
+
 void sframe::keep_array_file_ref() {
   // Add cache entries for frame_idx
   if (!index_file.empty()) {
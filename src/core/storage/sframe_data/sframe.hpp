@@ -16,6 +16,7 @@
 #include <core/storage/sframe_data/sframe_index_file.hpp>
 #include <core/storage/sframe_data/sframe_constants.hpp>
 #include <core/storage/sframe_data/output_iterator.hpp>
+#include <core/storage/fileio/block_cache.hpp>
 
 
 namespace turi {
@@ -382,7 +383,7 @@ class sframe : public swriter_base<sframe_output_iterator> {
       if(i >= columns.size()) {
         log_and_throw("Column index out of range!");
       }
-      return columns[i]->get_type();
+      return stored_column_type(i);
     }
   }
 
@@ -392,7 +393,7 @@ class sframe : public swriter_base<sframe_output_iterator> {
    * \overload
    */
   inline flex_type_enum column_type(const std::string& column_name) const {
-    return columns[column_index(column_name)]->get_type();
+    return column_type(column_index(column_name));
   }
 
 
@@ -433,7 +434,7 @@ class sframe : public swriter_base<sframe_output_iterator> {
       return group_writer->num_segments();
     } else {
       if (index_info.ncolumns == 0) return 0;
-      return columns[0]->num_segments();
+      return column(0)->num_segments();
     }
   }
 
@@ -445,7 +446,7 @@ class sframe : public swriter_base<sframe_output_iterator> {
   inline size_t segment_length(size_t i) const {
     DASSERT_MSG(inited, "Invalid SFrame");
     if (index_info.ncolumns == 0) return 0;
-    else return columns[0]->segment_length(i);
+    else return column(0)->segment_length(i);
   }
 
 
@@ -477,8 +478,11 @@ class sframe : public swriter_base<sframe_output_iterator> {
    * Merges another SFrame with the same schema with the current SFrame
    * returning a new SFrame.
    * Both SFrames can be empty, but cannot be opened for writing.
+   *
+   * The result is compacted (see \ref try_compact()) unless compact is false,
+   * in which case its segments are left for a later compaction pass.
    */
-  sframe append(const sframe& other) const;
+  sframe append(const sframe& other, bool compact = true) const;
 
 
   /**
@@ -658,8 +662,12 @@ class sframe : public swriter_base<sframe_output_iterator> {
   /**
    * Saves a copy of the current sframe into a different location.
    * Does not modify the current sframe.
+   *
+   * \param compression_level The block compression level of the saved
+   * copy. 0 is LZ4, 1 - 16 is LZ4 high compression at that level. If
+   * negative, \ref SFRAME_COMPRESSION_LEVEL is used.
    */
-  void save(std::string index_file) const;
+  void save(std::string index_file, int64_t compression_level = -1) const;
 
   /**
    * SFrame serializer. oarc must be associated with a directory.
@@ -674,6 +682,15 @@ class sframe : public swriter_base<sframe_output_iterator> {
    */
   void try_compact();
 
+  /**
+   * Hints the block_cache to keep the blocks of this SFrame's files longer
+   * (HIGH), or to drop them first (LOW). Useful for instance to keep a
+   * small table which is joined against repeatedly cached while a large
+   * table is scanned. Only affects remote files (e.g. on S3), which are read
+   * through the block_cache, and only blocks fetched after the call.
+   */
+  void set_cache_priority(block_cache::priority priority) const;
+
   /**
    * SFrame deserializer. iarc must be associated with a directory.
    * Loads from the next prefix inside the directory.
@@ -755,14 +772,50 @@ class sframe : public swriter_base<sframe_output_iterator> {
    */
   std::string generate_valid_column_name(const std::string &column_name) const;
 
+  /**
+   * A column of a frame opened from an index file, which is only opened
+   * when first used, so that a narrow query over a wide (remote) frame does
+   * not parse and hold the index of every column. Shared by the copies of
+   * the frame, so the column is opened once.
+   */
+  struct pending_column {
+    mutex lock;
+    /// The index of a column of a v2 array group
+    index_file_information info;
+    /// The index file of a v1 array, when not empty
+    std::string index_file;
+    std::shared_ptr<sarray<flexible_type> > array;
+  };
+
+  /**
+   * Internal function. Returns column i, opening it if it is still pending.
+   */
+  const std::shared_ptr<sarray<flexible_type> >& column(size_t i) const;
+
+  /**
+   * Internal function. Opens all pending columns; for operations on every
+   * column.
+   */
+  void open_all_columns() const;
+
+  /**
+   * Internal function. The type of column i, without opening a pending v2
+   * column.
+   */
+  flex_type_enum stored_column_type(size_t i) const;
+
   sframe_index_file_information index_info;
   std::string index_file;
   std::vector<std::shared_ptr<fileio::file_ownership_handle> > index_file_handle;
 
-  std::vector<std::shared_ptr<sarray<flexible_type> > > columns;
+  /// Null for columns which are not opened yet
+  mutable std::vector<std::shared_ptr<sarray<flexible_type> > > columns;
+  /// Parallel to columns. Null for columns which were opened up front.
+  std::vector<std::shared_ptr<pending_column> > pending_columns;
   std::shared_ptr<sarray_group_format_writer<flexible_type> > group_writer;
 
-  mutex lock;
+  /// Protects the opening of pending columns
+  mutable mutex lock;
 
   bool inited = false;
   bool writing = false;
@@ -3,8 +3,10 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <core/parallel/thread_pool.hpp>
 #include <core/storage/sframe_data/sframe.hpp>
 #include <core/storage/sframe_data/sframe_compact.hpp>
+#include <core/storage/sframe_data/sframe_saving.hpp>
 namespace turi {
 
 bool sframe_fast_compact(const sframe& sf) {
@@ -56,4 +58,81 @@ void sframe_compact(sframe& sf, size_t segment_threshold) {
   }
 }
 
+sframe sframe_compacted_copy(const sframe& sf, size_t segment_threshold) {
+  sframe ret = sf;
+  for (size_t i = 0;i < sf.num_columns(); ++i) {
+    // compacting a copy of the column object leaves the shared one untouched
+    auto column = std::make_shared<sarray<flexible_type>>(*sf.select_column(i));
+    bool compacted = sarray_fast_compact(*column);
+    auto index = column->get_index_info();
+    if (index.segment_files.size() > segment_threshold) {
+      logstream(LOG_INFO) << "Rewriting column " << sf.column_name(i)
+                          << " of " << index.segment_files.size()
+                          << " segments" << std::endl;
+      auto rewritten = compact_rows(*column, 0, column->size());
+      auto rewritten_index = rewritten->get_index_info();
+      // keep the type and metadata of the column
+      index.nsegments = rewritten_index.nsegments;
+      index.segment_sizes = rewritten_index.segment_sizes;
+      index.segment_files = rewritten_index.segment_files;
+      index.block_zone_maps = rewritten_index.block_zone_maps;
+      column = std::make_shared<sarray<flexible_type>>();
+      column->open_for_read(index);
+      compacted = true;
+    }
+    if (compacted) ret = ret.replace_column(column, sf.column_name(i));
+  }
+  return ret;
+}
+
+
+sframe_compaction_service& sframe_compaction_service::get_instance() {
+  static sframe_compaction_service instance;
+  return instance;
+}
+
+sframe_compaction_service::sframe_compaction_service()
+    : m_pool(new thread_pool(SFRAME_BACKGROUND_COMPACTION_THREADS)),
+      m_pending(0) { }
+
+sframe_compaction_service::~sframe_compaction_service() {
+  wait();
+}
+
+std::shared_future<sframe> sframe_compaction_service::compact(
+    const sframe& sf, size_t segment_threshold) {
+  auto result = std::make_shared<std::promise<sframe>>();
+  std::shared_future<sframe> ret = result->get_future().share();
+  ++m_pending;
+  m_pool->launch([this, result, sf, segment_threshold]() {
+    try {
+      result->set_value(sframe_compacted_copy(sf, segment_threshold));
+    } catch (...) {
+      result->set_exception(std::current_exception());
+    }
+    --m_pending;
+  });
+  return ret;
+}
+
+std::shared_future<bool> sframe_compaction_service::compact_saved(
+    const std::string& index_file, size_t segment_threshold) {
+  auto result = std::make_shared<std::promise<bool>>();
+  std::shared_future<bool> ret = result->get_future().share();
+  ++m_pending;
+  m_pool->launch([this, result, index_file, segment_threshold]() {
+    try {
+      result->set_value(sframe_compact_saved(index_file, segment_threshold));
+    } catch (...) {
+      result->set_exception(std::current_exception());
+    }
+    --m_pending;
+  });
+  return ret;
+}
+
+void sframe_compaction_service::wait() {
+  m_pool->join();
+}
+
 }
@@ -5,10 +5,15 @@
  */
 #ifndef TURI_SFRAME_COMPACT_HPP
 #define TURI_SFRAME_COMPACT_HPP
+#include <atomic>
+#include <future>
+#include <string>
 #include <vector>
 #include <memory>
+#include <core/storage/sframe_data/sframe_constants.hpp>
 namespace turi {
 class sframe;
+class thread_pool;
 
 template <typename T>
 class sarray;
@@ -27,6 +32,69 @@ bool sframe_fast_compact(const sframe& sf);
  */
 void sframe_compact(sframe& sf, size_t segment_threshold);
 
+/**
+ * Returns a compacted copy of an SFrame, compacted as \ref sframe_compact()
+ * does. Unlike sframe_compact(), sf and the columns it shares with other
+ * SFrames are left untouched, so it can run while sf is being read. The
+ * columns which still have more than segment_threshold segments after fast
+ * compaction are rewritten into a single segment, on the calling thread.
+ */
+sframe sframe_compacted_copy(const sframe& sf, size_t segment_threshold);
+
+/**
+ * Compacts SFrames in the background, on a small pool of threads of its
+ * own (\ref SFRAME_BACKGROUND_COMPACTION_THREADS), so that merging small
+ * segments takes a bounded share of the CPU and disk bandwidth away from
+ * the foreground work. Each task compacts one column at a time.
+ *
+ * Compaction never modifies what readers are using: an in-memory SFrame is
+ * compacted into a copy which the caller swaps in when ready, and a saved
+ * SFrame gets a new version whose frame index replaces the old one in a
+ * single atomic step (see \ref sframe_compact_saved()).
+ *
+ * \code
+ * auto compacted = sframe_compaction_service::get_instance().compact(sf);
+ * // ... keep reading sf ...
+ * sf = compacted.get();
+ * \endcode
+ */
+class sframe_compaction_service {
+ public:
+  static sframe_compaction_service& get_instance();
+
+  /**
+   * Queues the compaction of sf. The returned future holds the compacted
+   * copy (see \ref sframe_compacted_copy()), or the exception raised.
+   */
+  std::shared_future<sframe> compact(
+      const sframe& sf, size_t segment_threshold = SFRAME_COMPACTION_THRESHOLD);
+
+  /**
+   * Queues the compaction of the SFrame saved at index_file (see
+   * \ref sframe_compact_saved()). The returned future holds true if the
+   * saved SFrame was rewritten.
+   */
+  std::shared_future<bool> compact_saved(
+      const std::string& index_file,
+      size_t segment_threshold = SFRAME_COMPACTION_THRESHOLD);
+
+  /// The number of queued or running compactions
+  size_t num_pending() const { return m_pending.load(); }
+
+  /// Waits for all the queued compactions to complete
+  void wait();
+
+  ~sframe_compaction_service();
+
+ private:
+  sframe_compaction_service();
+  sframe_compaction_service(const sframe_compaction_service&) = delete;
+  sframe_compaction_service& operator=(const sframe_compaction_service&) = delete;
+
+  std::unique_ptr<thread_pool> m_pool;
+  std::atomic<size_t> m_pending;
+};
+
 /**
  * sarray_fast_compact looks for runs of small segments
  * (comprising of less than FAST_COMPACT_BLOCKS_IN_SMALL_SEGMENT block), and
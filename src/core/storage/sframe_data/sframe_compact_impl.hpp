@@ -54,6 +54,8 @@ bool sarray_fast_compact(sarray<T>& column) {
   auto updated_index = index;
   updated_index.segment_sizes.clear();
   updated_index.segment_files.clear();
+  updated_index.block_zone_maps.clear();
+  bool has_zone_maps = index.block_zone_maps.size() == index.nsegments;
 
   size_t row_counter = 0;
   bool compaction_performed = false;
@@ -93,6 +95,11 @@ bool sarray_fast_compact(sarray<T>& column) {
         row_counter += runlength_in_rows;
         updated_index.segment_sizes.push_back(new_sarray_index.segment_sizes[0]);
         updated_index.segment_files.push_back(new_sarray_index.segment_files[0]);
+        if (has_zone_maps && new_sarray_index.block_zone_maps.size() == 1) {
+          updated_index.block_zone_maps.push_back(new_sarray_index.block_zone_maps[0]);
+        } else {
+          has_zone_maps = false;
+        }
 
         //remember the new sarray so that it doesn't go out of scope
         //until we actually construct the result.
@@ -107,7 +114,11 @@ bool sarray_fast_compact(sarray<T>& column) {
     row_counter += index.segment_sizes[i];
     updated_index.segment_sizes.push_back(index.segment_sizes[i]);
     updated_index.segment_files.push_back(index.segment_files[i]);
+    if (has_zone_maps) {
+      updated_index.block_zone_maps.push_back(index.block_zone_maps[i]);
+    }
   }
+  if (!has_zone_maps) updated_index.block_zone_maps.clear();
 
   if (compaction_performed) {
     sarray<T> final_array;
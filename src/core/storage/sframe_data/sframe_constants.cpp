@@ -19,6 +19,12 @@ EXPORT const size_t SFRAME_WRITER_BUFFER_HARD_LIMIT = 1024 * 10;
 EXPORT size_t SFRAME_FILE_HANDLE_POOL_SIZE = 128;
 EXPORT const size_t SFRAME_BLOCK_MANAGER_BLOCK_BUFFER_COUNT = 128;
 EXPORT const float COMPRESSION_DISABLE_THRESHOLD = 0.9;
+EXPORT size_t SFRAME_COMPRESSION_LEVEL = 0;
+EXPORT size_t SFRAME_MMAP_LOCAL_SEGMENTS = true;
+EXPORT size_t SFRAME_BLOCK_PREFETCH_DEPTH = 4;
+EXPORT size_t SFRAME_BLOCK_PREFETCH_MEMORY_BUDGET = 64 * 1024 * 1024; // 64MB
+EXPORT size_t SFRAME_BLOCK_READ_COALESCE_GAP = 256 * 1024; // 256KB
+EXPORT size_t SFRAME_ITERATOR_PREFETCH_BATCHES = 2;
 EXPORT size_t SFRAME_DEFAULT_BLOCK_SIZE =  64 * 1024;
 EXPORT const size_t SARRAY_WRITER_MIN_ELEMENTS_PER_BLOCK = 8;
 EXPORT const size_t SARRAY_WRITER_INITAL_ELEMENTS_PER_BLOCK = 16;
@@ -27,14 +33,29 @@ EXPORT size_t SFRAME_WRITER_MAX_BUFFERED_CELLS_PER_BLOCK = 256*1024; // 1M eleme
 EXPORT // will be modified at startup to be 4x nCPUS
 EXPORT size_t SFRAME_MAX_BLOCKS_IN_CACHE = 32;
 EXPORT size_t SFRAME_CSV_PARSER_READ_SIZE = 50 * 1024 * 1024; // 50MB
+EXPORT size_t SFRAME_CSV_PARSER_MIN_RANGE_SIZE = 1024 * 1024; // 1MB
+EXPORT size_t SFRAME_PARQUET_ROW_GROUP_SIZE = 1024 * 1024;
 EXPORT size_t SFRAME_GROUPBY_BUFFER_NUM_ROWS = 1024 * 1024;
+EXPORT size_t SFRAME_GROUPBY_LOCAL_TABLE_SIZE = 16 * 1024;
 EXPORT size_t SFRAME_JOIN_BUFFER_NUM_CELLS = 50*1024*1024;
+EXPORT size_t SFRAME_JOIN_BLOOM_FILTER_BITS_PER_KEY = 10;
+EXPORT double SFRAME_JOIN_HEAVY_KEY_FRACTION = 0.01;
 EXPORT size_t SFRAME_IO_READ_LOCK = false;
 EXPORT size_t SFRAME_SORT_PIVOT_ESTIMATION_SAMPLE_SIZE = 2000000;
 EXPORT size_t SFRAME_SORT_MAX_SEGMENTS = 128;
+EXPORT size_t SFRAME_TOPK_MAX_NUM_CELLS = 1024 * 1024;
+EXPORT size_t SFRAME_MORSELS_PER_SEGMENT = 8;
+EXPORT size_t SFRAME_MORSEL_MIN_ROWS = 64 * 1024;
+EXPORT size_t SFRAME_MORSEL_MAX_BUFFERED_ROWS = 4 * 1024 * 1024;
+EXPORT size_t SFRAME_ADAPTIVE_PARALLELISM = false;
+EXPORT size_t SFRAME_MATERIALIZATION_CACHE_CAPACITY = 16;
+EXPORT size_t SFRAME_MATERIALIZATION_CACHE_MAX_CELLS = 1024 * 1024 * 1024;
 EXPORT const size_t SFRAME_IO_LOCK_FILE_SIZE_THRESHOLD = 4 * 1024 * 1024;
 EXPORT size_t SFRAME_COMPACTION_THRESHOLD = 256;
 EXPORT size_t FAST_COMPACT_BLOCKS_IN_SMALL_SEGMENT = 8;
+EXPORT size_t SFRAME_BACKGROUND_COMPACTION_THREADS = 1;
+EXPORT double SFRAME_BLOCK_SAMPLE_MAX_FRACTION = 0.01;
+EXPORT size_t SFRAME_INDEX_MAPPING_CACHE_BLOCKS = 64;
 
 
 REGISTER_GLOBAL_WITH_CHECKS(int64_t,
@@ -55,6 +76,42 @@ REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             +[](int64_t val){ return val >= 1024; });
 
 
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_COMPRESSION_LEVEL,
+                            true,
+                            +[](int64_t val){ return val >= 0 && val <= 16; });
+
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_MMAP_LOCAL_SEGMENTS,
+                            true,
+                            +[](int64_t val){ return val == 0 || val == 1; });
+
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_BLOCK_PREFETCH_DEPTH,
+                            true,
+                            +[](int64_t val){ return val >= 0; });
+
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_BLOCK_PREFETCH_MEMORY_BUDGET,
+                            true,
+                            +[](int64_t val){ return val >= 0; });
+
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_BLOCK_READ_COALESCE_GAP,
+                            true,
+                            +[](int64_t val){ return val >= 0; });
+
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_ITERATOR_PREFETCH_BATCHES,
+                            true,
+                            +[](int64_t val){ return val >= 0; });
+
+
 REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             SFRAME_MAX_BLOCKS_IN_CACHE,
                             true,
@@ -66,18 +123,43 @@ REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             true,
                             +[](int64_t val){ return val >= 1024; });
 
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_CSV_PARSER_MIN_RANGE_SIZE,
+                            true,
+                            +[](int64_t val){ return val >= 0; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_PARQUET_ROW_GROUP_SIZE,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+
 
 REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             SFRAME_GROUPBY_BUFFER_NUM_ROWS,
                             true,
                             +[](int64_t val){ return val >= 64; });
 
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_GROUPBY_LOCAL_TABLE_SIZE,
+                            true,
+                            +[](int64_t val){ return val >= 0; });
+
 
 REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             SFRAME_JOIN_BUFFER_NUM_CELLS,
                             true,
                             +[](int64_t val){ return val >= 1024; });
 
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_JOIN_BLOOM_FILTER_BITS_PER_KEY,
+                            true,
+                            +[](int64_t val){ return val >= 0 && val <= 64; });
+
+REGISTER_GLOBAL_WITH_CHECKS(double,
+                            SFRAME_JOIN_HEAVY_KEY_FRACTION,
+                            true,
+                            +[](double val){ return val >= 0 && val <= 1; });
+
 
 
 REGISTER_GLOBAL_WITH_CHECKS(int64_t,
@@ -106,6 +188,42 @@ REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             true,
                             +[](int64_t val){ return val > 1; });
 
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_TOPK_MAX_NUM_CELLS,
+                            true,
+                            +[](int64_t val){ return val >= 0; });
+
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_MORSELS_PER_SEGMENT,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_MORSEL_MIN_ROWS,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_MORSEL_MAX_BUFFERED_ROWS,
+                            true,
+                            +[](int64_t val){ return val >= 0; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_ADAPTIVE_PARALLELISM,
+                            true,
+                            +[](int64_t val){ return val == 0 || val == 1 ; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_MATERIALIZATION_CACHE_CAPACITY,
+                            true,
+                            +[](int64_t val){ return val >= 0; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_MATERIALIZATION_CACHE_MAX_CELLS,
+                            true,
+                            +[](int64_t val){ return val >= 0; });
+
 
 REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             FAST_COMPACT_BLOCKS_IN_SMALL_SEGMENT,
@@ -116,4 +234,19 @@ REGISTER_GLOBAL_WITH_CHECKS(int64_t,
 REGISTER_GLOBAL(int64_t,
                 SFRAME_COMPACTION_THRESHOLD,
                 true);
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_BACKGROUND_COMPACTION_THREADS,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+
+REGISTER_GLOBAL_WITH_CHECKS(double,
+                            SFRAME_BLOCK_SAMPLE_MAX_FRACTION,
+                            true,
+                            +[](double val){ return val >= 0 && val <= 1; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_INDEX_MAPPING_CACHE_BLOCKS,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
 } // namespace turi
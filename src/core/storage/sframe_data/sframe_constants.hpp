@@ -75,6 +75,55 @@ extern const size_t SFRAME_BLOCK_MANAGER_BLOCK_BUFFER_COUNT;
  */
 extern const float COMPRESSION_DISABLE_THRESHOLD;
 
+/**
+ * The default block compression level used by the sarray v2 block writer.
+ * 0 uses the fast LZ4 compressor. 1 - 16 use the LZ4 high compression
+ * compressor at that level; higher values are slower to write but produce
+ * smaller blocks. All levels produce standard LZ4 blocks, and decompression
+ * speed is unaffected. Can be overridden per writer with the
+ * "compression_level" block writer option.
+ */
+extern size_t SFRAME_COMPRESSION_LEVEL;
+
+/**
+ * If non-zero, segment files on the local file system are memory mapped
+ * by the block manager and blocks are read straight out of the mapping,
+ * sharing the OS page cache between processes. Otherwise all segment
+ * reads go through general_ifstream.
+ */
+extern size_t SFRAME_MMAP_LOCAL_SEGMENTS;
+
+/**
+ * The number of blocks the block manager reads ahead of a sequential scan
+ * of a (non memory mapped) column. The reads are issued on the
+ * fileio::async_reader, and run on its FILEIO_ASYNC_IO_THREADS I/O threads.
+ * 0 disables read-ahead.
+ */
+extern size_t SFRAME_BLOCK_PREFETCH_DEPTH;
+
+/**
+ * The maximum number of bytes held by blocks which have been read ahead but
+ * not yet consumed. Read-ahead memory is also accounted for in the
+ * fixed_size_cache_manager, and no read-ahead is issued while the cache is
+ * at FILEIO_MAXIMUM_CACHE_CAPACITY.
+ */
+extern size_t SFRAME_BLOCK_PREFETCH_MEMORY_BUDGET;
+
+/**
+ * Blocks read ahead which are separated by at most this many bytes in their
+ * segment file are fetched with a single read, and the bytes in between
+ * discarded. On remote files a request costs far more than a few hundred KB
+ * of transfer. 0 only merges blocks which are exactly adjacent.
+ */
+extern size_t SFRAME_BLOCK_READ_COALESCE_GAP;
+
+/**
+ * The number of batches of rows that unity_sframe::iterator_get_next() and
+ * unity_sarray::iterator_get_next() read ahead on a background thread, while
+ * the caller consumes the previous batch. 0 disables read-ahead.
+ */
+extern size_t SFRAME_ITERATOR_PREFETCH_BATCHES;
+
 
 /**
  * The default size of each block in the file. This is not strict. the
@@ -128,6 +177,17 @@ extern size_t SFRAME_MAX_BLOCKS_IN_CACHE;
  */
 extern size_t SFRAME_CSV_PARSER_READ_SIZE;
 
+/**
+ * The smallest byte range the CSV parser cuts an uncompressed file into, to
+ * parse the ranges of the file in parallel. 0 reads all files sequentially.
+ */
+extern size_t SFRAME_CSV_PARSER_MIN_RANGE_SIZE;
+
+/**
+ * The number of rows of the row groups written to Parquet files.
+ */
+extern size_t SFRAME_PARQUET_ROW_GROUP_SIZE;
+
 
 
 /**
@@ -135,12 +195,33 @@ extern size_t SFRAME_CSV_PARSER_READ_SIZE;
  */
 extern size_t SFRAME_GROUPBY_BUFFER_NUM_ROWS;
 
+/**
+ * The number of groups each input stream of a groupby pre-aggregates in a
+ * small table before moving them out into hash partitions. 0 disables
+ * radix partitioned aggregation.
+ */
+extern size_t SFRAME_GROUPBY_LOCAL_TABLE_SIZE;
+
 
 /**
  * The number of bytes that a join algorithm is allowed to use during execution.
  */
 extern size_t SFRAME_JOIN_BUFFER_NUM_CELLS;
 
+/**
+ * The number of bits per row of the smaller side of a partitioned hash join
+ * used for the bloom filter which drops rows of the larger side without a
+ * match before they are partitioned. 0 disables the filter.
+ */
+extern size_t SFRAME_JOIN_BLOOM_FILTER_BITS_PER_KEY;
+
+/**
+ * The share of the rows of the larger side of a partitioned hash join above
+ * which a join key is considered heavy. The rows of heavy keys are left out
+ * of the partitions and joined by all threads together. 0 disables this.
+ */
+extern double SFRAME_JOIN_HEAVY_KEY_FRACTION;
+
 /**
  * Whether locks are used when reading from SFrames on local storage. Good
  * for spinning disks, bad for SSDs.
@@ -167,6 +248,48 @@ extern size_t SFRAME_SORT_PIVOT_ESTIMATION_SAMPLE_SIZE;
  */
 extern size_t SFRAME_SORT_MAX_SEGMENTS;
 
+/**
+ * The largest top-k, in cells (k times the number of columns), computed with
+ * in-memory heaps in a single scan. Larger ones are a full sort.
+ */
+extern size_t SFRAME_TOPK_MAX_NUM_CELLS;
+
+/**
+ * Each segment of a parallel query is split into this many morsels which
+ * idle worker threads may steal from slower ones. 1 disables stealing.
+ */
+extern size_t SFRAME_MORSELS_PER_SEGMENT;
+
+/**
+ * Queries are not split into morsels smaller than this number of rows.
+ */
+extern size_t SFRAME_MORSEL_MIN_ROWS;
+
+/**
+ * Stolen morsels are held in memory until the rows before them have been
+ * written. Workers stop stealing while more than this many rows are held.
+ */
+extern size_t SFRAME_MORSEL_MAX_BUFFERED_ROWS;
+
+/**
+ * If true, parallel queries run as many worker threads as the
+ * parallelism_controller recommends from the CPU throttling and utilization
+ * of the queries before them, rather than one per CPU.
+ */
+extern size_t SFRAME_ADAPTIVE_PARALLELISM;
+
+/**
+ * The maximum number of query results remembered for reuse by structurally
+ * identical queries. 0 disables the materialization cache.
+ */
+extern size_t SFRAME_MATERIALIZATION_CACHE_CAPACITY;
+
+/**
+ * The maximum total number of cells (rows x columns) of the query results
+ * remembered by the materialization cache.
+ */
+extern size_t SFRAME_MATERIALIZATION_CACHE_MAX_CELLS;
+
 /**
  * The maximum number of segments an SFrame can have after which compaction
  * will be attempted
@@ -178,6 +301,26 @@ extern size_t SFRAME_COMPACTION_THRESHOLD;
  * considered a small segment.
  */
 extern size_t FAST_COMPACT_BLOCKS_IN_SMALL_SEGMENT;
+
+/**
+ * The number of threads of the \ref sframe_compaction_service. Read when
+ * the service first starts.
+ */
+extern size_t SFRAME_BACKGROUND_COMPACTION_THREADS;
+
+/**
+ * SFrame::sample() and SFrame::random_split() of a materialized SFrame
+ * pick the sampled row indices up front, and read only the blocks holding
+ * them, when sampling at most this fraction of the rows. Larger samples
+ * filter every row instead. 0 disables block sampling.
+ */
+extern double SFRAME_BLOCK_SAMPLE_MAX_FRACTION;
+
+/**
+ * The number of decoded blocks an sframe_index_mapping keeps for its
+ * random access lookups, unless given.
+ */
+extern size_t SFRAME_INDEX_MAPPING_CACHE_BLOCKS;
 /// \}
 } // namespace turi
 #endif
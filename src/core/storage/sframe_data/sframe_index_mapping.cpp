@@ -0,0 +1,165 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <numeric>
+#include <core/logging/logger.hpp>
+#include <core/parallel/lambda_omp.hpp>
+#include <core/parallel/mutex.hpp>
+#include <core/util/lru.hpp>
+#include <core/storage/sframe_data/sframe_index_mapping.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
+#include <core/storage/sframe_data/sarray_v2_block_manager.hpp>
+
+namespace turi {
+
+struct sframe_index_mapping::block_cache {
+  turi::mutex lock;
+  /// decoded blocks by (column, block)
+  lru_cache<std::pair<size_t, size_t>, decoded_block> blocks;
+};
+
+sframe_index_mapping::sframe_index_mapping(const sframe& sf, size_t cache_blocks)
+    : m_sframe(sf), m_num_rows(sf.num_rows()), m_cache(new block_cache) {
+  if (cache_blocks == 0) cache_blocks = SFRAME_INDEX_MAPPING_CACHE_BLOCKS;
+  m_cache->blocks.set_size_limit(cache_blocks);
+
+  auto& manager = v2_block_impl::block_manager::get_instance();
+  m_columns.resize(sf.num_columns());
+  for (size_t c = 0; c < m_columns.size(); ++c) {
+    auto& column = m_columns[c];
+    auto index_info = sf.select_column(c)->get_index_info();
+    size_t row_count = 0;
+    for (size_t s = 0; s < index_info.segment_files.size(); ++s) {
+      auto column_addr = manager.open_column(index_info.segment_files[s]);
+      column.segment_columns.push_back(column_addr);
+      size_t segment_id, column_id;
+      std::tie(segment_id, column_id) = column_addr;
+      const auto& segment_blocks = manager.get_all_block_info(segment_id)[column_id];
+      size_t nblocks = manager.num_blocks_in_column(column_addr);
+      for (size_t b = 0; b < nblocks; ++b) {
+        column.blocks.push_back(block_address{segment_id, column_id, b});
+        column.block_segment.push_back(s);
+        column.start_row.push_back(row_count);
+        row_count += segment_blocks[b].num_elem;
+      }
+    }
+    column.start_row.push_back(row_count);
+    ASSERT_EQ(row_count, m_num_rows);
+  }
+}
+
+sframe_index_mapping::~sframe_index_mapping() {
+  auto& manager = v2_block_impl::block_manager::get_instance();
+  for (auto& column: m_columns) {
+    for (auto& column_addr: column.segment_columns) manager.close_column(column_addr);
+  }
+}
+
+size_t sframe_index_mapping::block_containing_row(const column_index& column,
+                                                  size_t row) const {
+  // the last block starting at or before row. Empty blocks are skipped
+  // since the next block starts at the same row.
+  auto pos = std::upper_bound(column.start_row.begin(), column.start_row.end(), row);
+  return std::distance(column.start_row.begin(), pos) - 1;
+}
+
+sframe_index_mapping::row_location
+sframe_index_mapping::locate(size_t column, size_t row) const {
+  if (column >= m_columns.size()) log_and_throw("Column index out of range");
+  if (row >= m_num_rows) log_and_throw("Row index out of range");
+  const auto& col = m_columns[column];
+  size_t b = block_containing_row(col, row);
+  row_location ret;
+  ret.segment = col.block_segment[b];
+  ret.block = std::get<2>(col.blocks[b]);
+  ret.offset = row - col.start_row[b];
+  return ret;
+}
+
+sframe_index_mapping::decoded_block
+sframe_index_mapping::get_block(size_t column, size_t block) {
+  auto key = std::make_pair(column, block);
+  {
+    std::lock_guard<turi::mutex> guard(m_cache->lock);
+    auto cached = m_cache->blocks.query(key);
+    if (cached.first) return cached.second;
+  }
+  // decode outside of the lock. Two threads may both decode the same block,
+  // which is only wasted work.
+  auto values = std::make_shared<std::vector<flexible_type>>();
+  auto& manager = v2_block_impl::block_manager::get_instance();
+  if (!manager.read_typed_block(m_columns[column].blocks[block], *values)) {
+    log_and_throw("Unexpected block read failure. Bad file?");
+  }
+  decoded_block ret = values;
+  std::lock_guard<turi::mutex> guard(m_cache->lock);
+  m_cache->blocks.insert(key, ret);
+  return ret;
+}
+
+void sframe_index_mapping::get_rows(const std::vector<size_t>& rows,
+                                    std::vector<std::vector<flexible_type>>& out) {
+  for (size_t row: rows) {
+    if (row >= m_num_rows) log_and_throw("Row index out of range");
+  }
+  size_t ncolumns = m_columns.size();
+  out.resize(rows.size());
+  for (auto& row: out) row.resize(ncolumns);
+  if (rows.empty()) return;
+
+  // positions in rows, by increasing row
+  std::vector<size_t> order(rows.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&](size_t a, size_t b) { return rows[a] < rows[b]; });
+
+  // every (column, block) to read, with the range of order it provides
+  struct block_task {
+    size_t column;
+    size_t block;
+    size_t begin;
+    size_t end;
+  };
+  std::vector<block_task> tasks;
+  for (size_t c = 0; c < ncolumns; ++c) {
+    const auto& column = m_columns[c];
+    size_t i = 0;
+    while (i < order.size()) {
+      size_t b = block_containing_row(column, rows[order[i]]);
+      size_t j = i + 1;
+      while (j < order.size() && rows[order[j]] < column.start_row[b + 1]) ++j;
+      tasks.push_back(block_task{c, b, i, j});
+      i = j;
+    }
+  }
+
+  parallel_for(0, tasks.size(), [&](size_t t) {
+    const auto& task = tasks[t];
+    auto block = get_block(task.column, task.block);
+    size_t block_start = m_columns[task.column].start_row[task.block];
+    for (size_t i = task.begin; i < task.end; ++i) {
+      out[order[i]][task.column] = (*block)[rows[order[i]] - block_start];
+    }
+  });
+}
+
+std::vector<flexible_type> sframe_index_mapping::get_row(size_t row) {
+  std::vector<std::vector<flexible_type>> out;
+  get_rows({row}, out);
+  return std::move(out[0]);
+}
+
+size_t sframe_index_mapping::cache_hits() const {
+  std::lock_guard<turi::mutex> guard(m_cache->lock);
+  return m_cache->blocks.hits();
+}
+
+size_t sframe_index_mapping::cache_misses() const {
+  std::lock_guard<turi::mutex> guard(m_cache->lock);
+  return m_cache->blocks.misses();
+}
+
+} // namespace turi
@@ -0,0 +1,128 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_INDEX_MAPPING_HPP
+#define TURI_SFRAME_INDEX_MAPPING_HPP
+
+#include <memory>
+#include <vector>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/storage/sframe_data/sframe.hpp>
+#include <core/storage/sframe_data/sarray_v2_block_types.hpp>
+
+namespace turi {
+
+/**
+ * \ingroup sframe_physical
+ * \addtogroup sframe_main Main SFrame Objects
+ * \{
+ */
+
+/**
+ * Random access to the rows of an sframe, for point lookups in any order.
+ *
+ * On construction, the blocks of every column are listed with the first
+ * row they hold, from the block information stored in the segment files.
+ * A row is then located with a binary search, without reading anything.
+ *
+ * Decoded blocks are kept in a small LRU cache shared by all the lookups,
+ * so rows close to each other, or looked up again, do not decode their
+ * block again.
+ *
+ * \code
+ * sframe_index_mapping index(sf);
+ * std::vector<std::vector<flexible_type>> rows;
+ * index.get_rows({5, 1000000, 6, 5}, rows);
+ * \endcode
+ *
+ * get_rows() is safe to call concurrently. The sframe must not be
+ * modified while the mapping is in use.
+ */
+class sframe_index_mapping {
+ public:
+  /// Where a row of a column is stored
+  struct row_location {
+    /// The segment of the column
+    size_t segment = 0;
+    /// The block, within the segment
+    size_t block = 0;
+    /// The row, within the block
+    size_t offset = 0;
+  };
+
+  /**
+   * Builds the row index of all the columns of sf. At most cache_blocks
+   * decoded blocks are cached; 0 for SFRAME_INDEX_MAPPING_CACHE_BLOCKS.
+   */
+  explicit sframe_index_mapping(const sframe& sf, size_t cache_blocks = 0);
+
+  ~sframe_index_mapping();
+
+  sframe_index_mapping(const sframe_index_mapping&) = delete;
+  sframe_index_mapping& operator=(const sframe_index_mapping&) = delete;
+
+  /// Number of rows of the sframe
+  size_t num_rows() const { return m_num_rows; }
+
+  /// Number of columns of the sframe
+  size_t num_columns() const { return m_columns.size(); }
+
+  /**
+   * Where a row of a column is stored. Throws if row or column are out of
+   * range.
+   */
+  row_location locate(size_t column, size_t row) const;
+
+  /**
+   * Reads the given rows, in the order given: out[i] is row rows[i]. Rows
+   * may be repeated. Every block is decoded at most once per call; the
+   * blocks are read in parallel. Throws if a row is out of range.
+   */
+  void get_rows(const std::vector<size_t>& rows,
+                std::vector<std::vector<flexible_type>>& out);
+
+  /// Reads one row. See get_rows().
+  std::vector<flexible_type> get_row(size_t row);
+
+  /// Number of blocks found in the cache
+  size_t cache_hits() const;
+
+  /// Number of blocks which had to be read and decoded
+  size_t cache_misses() const;
+
+ private:
+  typedef v2_block_impl::block_address block_address;
+  typedef v2_block_impl::column_address column_address;
+  typedef std::shared_ptr<const std::vector<flexible_type>> decoded_block;
+
+  struct column_index {
+    /// The columns opened in the block manager, one per segment
+    std::vector<column_address> segment_columns;
+    /// All the blocks of the column, in row order
+    std::vector<block_address> blocks;
+    /// The segment of each block
+    std::vector<size_t> block_segment;
+    /// The first row of each block, and the number of rows at the end
+    std::vector<size_t> start_row;
+  };
+
+  /// Index of the block of column holding row
+  size_t block_containing_row(const column_index& column, size_t row) const;
+
+  /// Returns a decoded block, from the cache or from the file
+  decoded_block get_block(size_t column, size_t block);
+
+  struct block_cache;
+
+  sframe m_sframe;
+  size_t m_num_rows = 0;
+  std::vector<column_index> m_columns;
+  std::unique_ptr<block_cache> m_cache;
+};
+
+/// \}
+} // namespace turi
+
+#endif
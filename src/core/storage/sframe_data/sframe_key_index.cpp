@@ -0,0 +1,250 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <map>
+#include <boost/algorithm/string/predicate.hpp>
+#include <core/logging/logger.hpp>
+#include <core/parallel/lambda_omp.hpp>
+#include <core/storage/fileio/fs_utils.hpp>
+#include <core/storage/fileio/general_fstream.hpp>
+#include <core/storage/fileio/sanitize_url.hpp>
+#include <core/storage/serialization/serialization_includes.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
+#include <core/storage/sframe_data/sframe_index_mapping.hpp>
+#include <core/storage/sframe_data/sframe_key_index.hpp>
+
+namespace turi {
+
+namespace {
+
+/// Bumped whenever the file format changes
+constexpr size_t KEY_INDEX_FILE_VERSION = 1;
+
+bool is_indexable_type(flex_type_enum type) {
+  return type == flex_type_enum::INTEGER || type == flex_type_enum::FLOAT ||
+         type == flex_type_enum::STRING || type == flex_type_enum::DATETIME;
+}
+
+/// The indexes of this process, by column
+struct key_index_registry {
+  turi::mutex lock;
+  std::map<std::string, std::shared_ptr<sframe_key_index>> indexes;
+};
+
+key_index_registry& get_registry() {
+  static key_index_registry* registry = new key_index_registry;
+  return *registry;
+}
+
+} // anonymous namespace
+
+
+sframe_key_index::~sframe_key_index() { }
+
+std::string sframe_key_index::column_id(const sarray<flexible_type>& column) {
+  return column.get_index_file();
+}
+
+std::string sframe_key_index::column_file_name(const sarray<flexible_type>& column) {
+  return fileio::get_filename(column.get_index_file());
+}
+
+std::shared_ptr<sframe_key_index>
+sframe_key_index::build(std::shared_ptr<sarray<flexible_type>> column) {
+  flex_type_enum type = column->get_type();
+  if (!is_indexable_type(type)) {
+    log_and_throw(std::string("Cannot build a key index on a column of type ") +
+                  flex_type_enum_to_name(type));
+  }
+  std::shared_ptr<sframe_key_index> ret(new sframe_key_index);
+  ret->m_column = column;
+  ret->m_type = type;
+  ret->m_num_rows = column->size();
+
+  // the runs of equal keys of every segment, in parallel
+  size_t num_segments = column->num_segments();
+  std::vector<size_t> segment_start(num_segments + 1, 0);
+  for (size_t i = 0; i < num_segments; ++i) {
+    segment_start[i + 1] = segment_start[i] + column->segment_length(i);
+  }
+  std::vector<std::vector<row_range>> segment_ranges(num_segments);
+  auto reader = column->get_reader();
+  parallel_for(0, num_segments, [&](size_t segment_id) {
+    auto& ranges = segment_ranges[segment_id];
+    std::vector<flexible_type> values;
+    flexible_type prev;
+    size_t row = segment_start[segment_id];
+    size_t end_row = segment_start[segment_id + 1];
+    while (row < end_row) {
+      size_t rows_read = reader->read_rows(
+          row, std::min(end_row, row + DEFAULT_SARRAY_READER_BUFFER_SIZE), values);
+      for (size_t i = 0; i < rows_read; ++i, ++row) {
+        auto& value = values[i];
+        // missing values are never looked up
+        if (value.get_type() == flex_type_enum::UNDEFINED) {
+          prev = FLEX_UNDEFINED;
+          continue;
+        }
+        if (!ranges.empty() && prev.get_type() != flex_type_enum::UNDEFINED &&
+            prev == value &&
+            ranges.back().first_row + ranges.back().num_rows == row) {
+          ++ranges.back().num_rows;
+        } else {
+          ranges.push_back(row_range{value.hash(), row, 1});
+          prev = std::move(value);
+        }
+      }
+    }
+  });
+
+  for (auto& ranges: segment_ranges) {
+    ret->m_ranges.insert(ret->m_ranges.end(), ranges.begin(), ranges.end());
+    std::vector<row_range>().swap(ranges);
+  }
+  std::sort(ret->m_ranges.begin(), ret->m_ranges.end(),
+            [](const row_range& a, const row_range& b) {
+              return a.hash < b.hash || (a.hash == b.hash && a.first_row < b.first_row);
+            });
+  logstream(LOG_INFO) << "Built a key index of " << ret->m_num_rows << " rows in "
+                      << ret->m_ranges.size() << " ranges" << std::endl;
+  return ret;
+}
+
+std::vector<size_t>
+sframe_key_index::find_rows(const std::vector<flexible_type>& keys) const {
+  // the ranges whose hash matches a key. The first row of each range tells
+  // whether the key matches, or only its hash.
+  std::vector<const row_range*> candidates;
+  std::vector<size_t> candidate_key;
+  for (size_t k = 0; k < keys.size(); ++k) {
+    if (keys[k].get_type() != m_type) continue;
+    uint64_t h = keys[k].hash();
+    auto iter = std::lower_bound(m_ranges.begin(), m_ranges.end(), h,
+                                 [](const row_range& r, uint64_t h) { return r.hash < h; });
+    for (; iter != m_ranges.end() && iter->hash == h; ++iter) {
+      candidates.push_back(&(*iter));
+      candidate_key.push_back(k);
+    }
+  }
+  std::vector<size_t> ret;
+  if (candidates.empty()) return ret;
+
+  std::vector<size_t> first_rows;
+  for (auto range: candidates) first_rows.push_back(range->first_row);
+  std::vector<std::vector<flexible_type>> values;
+  {
+    std::lock_guard<turi::mutex> guard(m_values_lock);
+    if (!m_values) {
+      m_values.reset(new sframe_index_mapping(sframe({m_column}, {"key"})));
+    }
+  }
+  m_values->get_rows(first_rows, values);
+
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (values[i][0] == keys[candidate_key[i]]) {
+      for (size_t j = 0; j < candidates[i]->num_rows; ++j) {
+        ret.push_back(candidates[i]->first_row + j);
+      }
+    }
+  }
+  std::sort(ret.begin(), ret.end());
+  ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+  return ret;
+}
+
+void sframe_key_index::save(const std::string& file) const {
+  general_ofstream fout(file);
+  oarchive oarc(fout);
+  std::vector<uint64_t> hashes;
+  std::vector<size_t> first_rows, num_rows;
+  for (const auto& range: m_ranges) {
+    hashes.push_back(range.hash);
+    first_rows.push_back(range.first_row);
+    num_rows.push_back(range.num_rows);
+  }
+  oarc << KEY_INDEX_FILE_VERSION << column_file_name(*m_column)
+       << (int)m_type << m_num_rows << hashes << first_rows << num_rows;
+  if (!fout.good()) {
+    log_and_throw_io_failure("Fail to write. Disk may be full.");
+  }
+  fout.close();
+}
+
+std::shared_ptr<sframe_key_index>
+sframe_key_index::load(const std::string& file,
+                       std::shared_ptr<sarray<flexible_type>> column) {
+  if (fileio::get_file_status(file).first != fileio::file_status::REGULAR_FILE) {
+    return nullptr;
+  }
+  general_ifstream fin(file);
+  iarchive iarc(fin);
+  size_t version = 0;
+  std::string file_name;
+  int type = 0;
+  size_t num_rows = 0;
+  iarc >> version;
+  if (version != KEY_INDEX_FILE_VERSION) {
+    logstream(LOG_WARNING) << "Ignoring key index of unknown version " << version
+                           << " in " << sanitize_url(file) << std::endl;
+    return nullptr;
+  }
+  iarc >> file_name >> type >> num_rows;
+  // a different sframe may have been saved over the one indexed
+  if (file_name != column_file_name(*column) ||
+      (flex_type_enum)type != column->get_type() ||
+      num_rows != column->size()) {
+    logstream(LOG_WARNING) << "Ignoring stale key index " << sanitize_url(file) << std::endl;
+    return nullptr;
+  }
+  std::vector<uint64_t> hashes;
+  std::vector<size_t> first_rows, range_rows;
+  iarc >> hashes >> first_rows >> range_rows;
+  std::shared_ptr<sframe_key_index> ret(new sframe_key_index);
+  ret->m_column = column;
+  ret->m_type = (flex_type_enum)type;
+  ret->m_num_rows = num_rows;
+  ret->m_ranges.resize(hashes.size());
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    ret->m_ranges[i] = row_range{hashes[i], first_rows[i], range_rows[i]};
+  }
+  return ret;
+}
+
+std::string sframe_key_index::index_file(const sframe& sf, size_t column_id) {
+  std::string frame_file = sf.get_index_file();
+  if (frame_file.empty()) return "";
+  if (boost::algorithm::ends_with(frame_file, ".frame_idx")) {
+    frame_file.resize(frame_file.size() - std::string(".frame_idx").size());
+  }
+  return frame_file + "." + std::to_string(column_id) + ".key_idx";
+}
+
+void sframe_key_index::register_index(std::shared_ptr<sframe_key_index> index) {
+  std::string id = column_id(*index->m_column);
+  if (id.empty()) return;
+  auto& registry = get_registry();
+  std::lock_guard<turi::mutex> guard(registry.lock);
+  registry.indexes[id] = index;
+}
+
+std::shared_ptr<sframe_key_index>
+sframe_key_index::get(const sframe& sf, size_t column_id) {
+  auto column = sf.select_column(column_id);
+  std::string id = sframe_key_index::column_id(*column);
+  auto& registry = get_registry();
+  if (!id.empty()) {
+    std::lock_guard<turi::mutex> guard(registry.lock);
+    auto iter = registry.indexes.find(id);
+    if (iter != registry.indexes.end()) return iter->second;
+  }
+  std::string file = index_file(sf, column_id);
+  if (file.empty() || !is_indexable_type(column->get_type())) return nullptr;
+  auto ret = load(file, column);
+  if (ret) register_index(ret);
+  return ret;
+}
+
+} // namespace turi
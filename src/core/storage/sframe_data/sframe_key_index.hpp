@@ -0,0 +1,124 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SFRAME_KEY_INDEX_HPP
+#define TURI_SFRAME_KEY_INDEX_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/parallel/mutex.hpp>
+#include <core/storage/sframe_data/sarray.hpp>
+#include <core/storage/sframe_data/sframe.hpp>
+
+namespace turi {
+
+class sframe_index_mapping;
+
+/**
+ * \ingroup sframe_physical
+ * \addtogroup sframe_main Main SFrame Objects
+ * \{
+ */
+
+/**
+ * A secondary index on a key column of an sframe, to find the rows holding
+ * given keys without scanning the column.
+ *
+ * The index maps the hash of every key to the ranges of consecutive rows
+ * holding it, sorted by hash. Looking a key up is a binary search, followed
+ * by a read of one row of every candidate range to rule out hash
+ * collisions. Keys which come in runs (a sorted or clustered column) take
+ * a single range.
+ *
+ * Only INTEGER, FLOAT, STRING and DATETIME columns can be indexed. Keys
+ * match as with operator==, and only keys of the column type match.
+ *
+ * An index can be saved next to the frame index file of its sframe (see
+ * \ref index_file()), so that it is found again when the sframe is loaded.
+ * Indexes built or loaded in this process are kept in a registry, by the
+ * column they index: see \ref register_index() and \ref get().
+ */
+class sframe_key_index {
+ public:
+  /// Builds the index of a column, scanning it once.
+  static std::shared_ptr<sframe_key_index>
+  build(std::shared_ptr<sarray<flexible_type>> column);
+
+  ~sframe_key_index();
+
+  /**
+   * Returns the rows of the column holding any of the keys, in increasing
+   * order. Keys may be repeated.
+   */
+  std::vector<size_t> find_rows(const std::vector<flexible_type>& keys) const;
+
+  /// Number of rows of the indexed column
+  size_t num_rows() const { return m_num_rows; }
+
+  /// Number of row ranges in the index
+  size_t num_ranges() const { return m_ranges.size(); }
+
+  /**
+   * Writes the index to a file. It can only be read back for the same
+   * column (see \ref load()).
+   */
+  void save(const std::string& file) const;
+
+  /**
+   * Reads an index saved with \ref save(). Returns nullptr if the file does
+   * not exist, or if it was not built for this column.
+   */
+  static std::shared_ptr<sframe_key_index>
+  load(const std::string& file, std::shared_ptr<sarray<flexible_type>> column);
+
+  /**
+   * The file next to the frame index file of sf where the index of column
+   * column_id is saved. Empty if sf has no frame index file.
+   */
+  static std::string index_file(const sframe& sf, size_t column_id);
+
+  /// Makes the index available to \ref get() in this process.
+  static void register_index(std::shared_ptr<sframe_key_index> index);
+
+  /**
+   * Returns the index of the column column_id of sf: the one registered in
+   * this process, or else the one saved next to the frame index file (which
+   * is then registered). Returns nullptr if there is none.
+   */
+  static std::shared_ptr<sframe_key_index> get(const sframe& sf, size_t column_id);
+
+ private:
+  sframe_key_index() = default;
+
+  /// Rows [first_row, first_row + num_rows) all hold keys of hash hash.
+  struct row_range {
+    uint64_t hash;
+    size_t first_row;
+    size_t num_rows;
+  };
+
+  /// Identifies the indexed column
+  static std::string column_id(const sarray<flexible_type>& column);
+
+  /// Identifies the indexed column, wherever the sframe is stored
+  static std::string column_file_name(const sarray<flexible_type>& column);
+
+  std::shared_ptr<sarray<flexible_type>> m_column;
+  flex_type_enum m_type = flex_type_enum::UNDEFINED;
+  size_t m_num_rows = 0;
+  /// sorted by hash then first_row
+  std::vector<row_range> m_ranges;
+
+  /// Reads the first row of the candidate ranges. Created when needed.
+  mutable std::unique_ptr<sframe_index_mapping> m_values;
+  mutable turi::mutex m_values_lock;
+};
+
+/// \}
+} // namespace turi
+
+#endif
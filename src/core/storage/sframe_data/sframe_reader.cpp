@@ -21,16 +21,16 @@ void sframe_reader::init(const sframe& frame, size_t num_segments) {
   }
   if (num_segments == (size_t)(-1)) {
     // use the segmentation of the first column
-    m_num_segments = frame.columns[0]->get_index_info().nsegments;
-    std::vector<size_t> segment_sizes = frame.columns[0]->get_index_info().segment_sizes;
+    m_num_segments = frame.column(0)->get_index_info().nsegments;
+    std::vector<size_t> segment_sizes = frame.column(0)->get_index_info().segment_sizes;
     for (size_t i = 0;i < index_info.column_names.size(); ++i) {
-      column_data.emplace_back(frame.columns[i]->get_reader(segment_sizes));
+      column_data.emplace_back(frame.column(i)->get_reader(segment_sizes));
     }
   } else {
     // create num_segments worth of segments
     m_num_segments = num_segments;
     for (size_t i = 0;i < index_info.column_names.size(); ++i) {
-      column_data.emplace_back(frame.columns[i]->get_reader(m_num_segments));
+      column_data.emplace_back(frame.column(i)->get_reader(m_num_segments));
     }
   }
 }
@@ -47,7 +47,7 @@ void sframe_reader::init(const sframe& frame, const std::vector<size_t>& segment
 
   m_num_segments = segment_lengths.size();
   for (size_t i = 0;i < index_info.column_names.size(); ++i) {
-    column_data.emplace_back(frame.columns[i]->get_reader(segment_lengths));
+    column_data.emplace_back(frame.column(i)->get_reader(segment_lengths));
   }
 }
 
@@ -94,14 +94,20 @@ size_t sframe_reader::read_rows(size_t row_start,
 size_t sframe_reader::read_rows(size_t row_start,
                                 size_t row_end,
                                 sframe_rows& out_obj) {
-  // sframe_rows is made up of a collection of columns
-  out_obj.resize(column_data.size());
+  // sframe_rows is made up of a collection of columns. They are all
+  // overwritten, so the ones still shared with rows read earlier are swapped
+  // for recycled ones rather than copied.
+  out_obj.reset_columns(column_data.size(), &rows_column_pool);
   for (size_t i = 0;i < column_data.size(); ++i) {
     column_data[i]->read_rows(row_start, row_end, *(out_obj.get_columns()[i]));
   }
   return out_obj.num_rows();
 }
 
+void sframe_reader::release_rows(sframe_rows& rows) {
+  rows.release_columns(rows_column_pool);
+}
+
 void sframe_reader::reset_iterators() {
   for (auto& col: column_data) {
     col->reset_iterators();
@@ -12,6 +12,7 @@
 #include <core/logging/logger.hpp>
 #include <core/data/flexible_type/flexible_type.hpp>
 #include <core/storage/sframe_data/sarray_reader.hpp>
+#include <core/storage/sframe_data/sframe_rows.hpp>
 #include <core/storage/sframe_data/sframe_index_file.hpp>
 #include <core/storage/sframe_data/sframe_constants.hpp>
 
@@ -290,6 +291,22 @@ class sframe_reader : public siterable<sframe_iterator> {
                    size_t row_end,
                    sframe_rows& out_obj);
 
+  /**
+   * Hands the columns of rows read by read_rows() back to the reader once
+   * the caller is done with them, and clears rows. The next calls to
+   * read_rows() reuse them instead of allocating new columns. Columns still
+   * shared with other sframe_rows are left to their other owners. Optional;
+   * can be called in parallel.
+   *
+   * \code
+   * sframe_rows rows;
+   * reader->read_rows(0, 1000, rows);
+   * // ... consume rows ...
+   * reader->release_rows(rows);
+   * \endcode
+   */
+  void release_rows(sframe_rows& rows);
+
 
   /**
    * Resets all the file handles. All existing iterators are invalidated.
@@ -379,6 +396,7 @@ class sframe_reader : public siterable<sframe_iterator> {
   sframe_index_file_information index_info;
   std::vector<std::shared_ptr<sarray_reader<flexible_type> > > column_data;
   buffer_pool<std::vector<flexible_type>> column_pool;
+  sframe_rows_column_pool rows_column_pool;
   size_t m_num_segments = 0;
 };
 
@@ -26,6 +26,46 @@ void sframe_rows::resize(size_t num_cols, ssize_t num_rows) {
   }
 }
 
+void sframe_rows::reset_columns(size_t num_cols, sframe_rows_column_pool* pool) {
+  if (m_decoded_columns.size() > num_cols) {
+    for (size_t i = num_cols; i < m_decoded_columns.size(); ++i) {
+      if (pool) pool->release_column(std::move(m_decoded_columns[i]));
+    }
+  }
+  m_decoded_columns.resize(num_cols);
+  for (auto& col: m_decoded_columns) {
+    if (col != nullptr && col.unique()) continue;
+    if (pool) col = pool->get_column();
+    else col = std::make_shared<decoded_column_type>();
+  }
+  m_is_unique = true;
+}
+
+void sframe_rows::release_columns(sframe_rows_column_pool& pool) {
+  for (auto& col: m_decoded_columns) pool.release_column(std::move(col));
+  m_decoded_columns.clear();
+  m_is_unique = true;
+}
+
+sframe_rows::ptr_to_decoded_column_type sframe_rows_column_pool::get_column() {
+  sframe_rows::ptr_to_decoded_column_type ret;
+  if (m_free_columns.try_dequeue(ret)) return ret;
+  return std::make_shared<sframe_rows::decoded_column_type>();
+}
+
+void sframe_rows_column_pool::release_column(
+    sframe_rows::ptr_to_decoded_column_type&& column) {
+  const size_t COLUMN_CAPACITY_LIMIT = 1024 * 1024;
+  if (column == nullptr || !column.unique()) {
+    column.reset();
+    return;
+  }
+  column->clear();
+  if (column->capacity() >= COLUMN_CAPACITY_LIMIT) column->shrink_to_fit();
+  m_free_columns.try_enqueue(std::move(column));
+  column.reset();
+}
+
 void sframe_rows::clear() {
   m_decoded_columns.clear();
 }
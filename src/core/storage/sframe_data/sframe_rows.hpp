@@ -8,9 +8,11 @@
 #include <vector>
 #include <map>
 #include <core/data/flexible_type/flexible_type.hpp>
+#include <core/generics/lock_free_ring_queue.hpp>
 namespace turi {
 class oarchive;
 class iarchive;
+class sframe_rows_column_pool;
 
 
 /**
@@ -111,6 +113,23 @@ class sframe_rows {
    */
   void resize(size_t num_cols, ssize_t num_rows = -1);
 
+  /**
+   * Sets the number of columns of sframe_rows, for columns whose contents are
+   * about to be overwritten entirely (by sframe_reader::read_rows() for
+   * instance). Unlike resize(), columns shared with other sframe_rows are
+   * never copied: they are left to their other owners and replaced by an
+   * empty column from pool (or a new one if pool is NULL or empty). Columns
+   * this sframe_rows owns alone are kept, with their contents, so their
+   * capacity is reused.
+   */
+  void reset_columns(size_t num_cols, sframe_rows_column_pool* pool = nullptr);
+
+  /**
+   * Hands the columns this sframe_rows owns alone over to pool, and clears.
+   * Shared columns are left to their other owners.
+   */
+  void release_columns(sframe_rows_column_pool& pool);
+
   /**
    * Adds to the right of the sframe_rows, a collection of decoded columns
    *
@@ -555,6 +574,34 @@ class sframe_rows {
     mutable bool m_is_unique = true;
   };  // class sframe_rows
 
+/**
+ * A bounded free list of decoded columns of \ref sframe_rows, through which
+ * a consumer hands the columns of the rows it is done with back to the
+ * producer reading the next rows (see sframe_rows::release_columns() and
+ * sframe_rows::reset_columns()), so that reading in steady state does not
+ * allocate. Can be used in parallel.
+ *
+ * Unlike \ref buffer_pool, the pool holds no reference to the columns it
+ * handed out, so they stay uniquely owned and can be modified without
+ * triggering a copy.
+ */
+class sframe_rows_column_pool {
+ public:
+  explicit sframe_rows_column_pool(size_t capacity = 128): m_free_columns(capacity) { }
+
+  /// Returns an empty column, uniquely owned
+  sframe_rows::ptr_to_decoded_column_type get_column();
+
+  /**
+   * Returns a column to the pool. Columns which are still shared, or which
+   * do not fit in the pool, are simply dropped.
+   */
+  void release_column(sframe_rows::ptr_to_decoded_column_type&& column);
+
+ private:
+  lock_free_ring_queue<sframe_rows::ptr_to_decoded_column_type> m_free_columns;
+};
+
 /// \}
 } // namespace turi
 #endif
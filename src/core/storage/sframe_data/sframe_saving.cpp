@@ -10,9 +10,14 @@
 #include <core/storage/sframe_data/sarray_v2_block_manager.hpp>
 #include <core/storage/sframe_data/sarray_v2_block_writer.hpp>
 #include <core/storage/sframe_data/sarray_v2_block_types.hpp>
+#include <core/storage/sframe_data/sframe_saving.hpp>
 #include <core/storage/sframe_data/sframe_saving_impl.hpp>
 #include <core/storage/fileio/fs_utils.hpp>
+#include <core/storage/fileio/sanitize_url.hpp>
 #include <core/logging/assertions.hpp>
+#include <core/parallel/lambda_omp.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
@@ -30,7 +35,8 @@ using namespace sframe_saving_impl;
  *
  */
 void sframe_save_naive(const sframe& sf_source,
-                       std::string index_file) {
+                       std::string index_file,
+                       int64_t compression_level) {
   std::vector<std::string> my_names;
   std::vector<flex_type_enum> my_types;
   for(size_t i = 0; i < sf_source.num_columns(); ++i) {
@@ -45,6 +51,10 @@ void sframe_save_naive(const sframe& sf_source,
 
   new_sf.open_for_write(my_names, my_types,
                         index_file, SFRAME_DEFAULT_NUM_SEGMENTS);
+  if (compression_level >= 0) {
+    new_sf.get_internal_writer()->set_options("compression_level",
+                                              compression_level);
+  }
   if (sf_source.num_segments() == 0) {
     new_sf.close();
     return;
@@ -75,8 +85,15 @@ void sframe_save_naive(const sframe& sf_source,
 
 
 
-void sframe_save_blockwise(const sframe& sf_source,
-                           std::string index_file) {
+namespace {
+
+/**
+ * Copies the blocks of the given columns of sf_source, as they are, into
+ * segment 0 of writer, whose column k is columns[k].
+ */
+void copy_column_blocks(const sframe& sf_source,
+                        const std::vector<size_t>& columns,
+                        v2_block_impl::block_writer& writer) {
   // this will hit the sframe at a lower level
   // This is slightly complicated and slightly annoying.
   //
@@ -97,32 +114,14 @@ void sframe_save_blockwise(const sframe& sf_source,
   // Now, the input number of segments may not match the output number of
   // segments and so we probably need to do some shuffling around here.
   // Also, while we are here, it might be nice to reorder the blocks a bit
-
-  // initialize reader and writer
   auto& block_manager = v2_block_impl::block_manager::get_instance();
-  v2_block_impl::block_writer writer;
-
-  // call it indexfile.0000
-  std::string base_name;
-  size_t last_dot = index_file.find_last_of(".");
-  if (last_dot != std::string::npos) {
-    base_name = index_file.substr(0, last_dot);
-  } else {
-    base_name = index_file;
-  }
-  auto index = base_name + ".sidx";
-  auto segment_file = base_name + ".0000";
-  // we are going to emit only 1 segment. We should be rather IO bound anyway
-  writer.init(index, 1, sf_source.num_columns());
-  writer.open_segment(0, segment_file);
-
 
   // this is going to be a max heap with each entry referencing a column.
   std::vector<column_blocks> cols;
   try {
-    for (size_t i = 0;i < sf_source.num_columns(); ++i) {
+    for (size_t i = 0;i < columns.size(); ++i) {
       column_blocks col;
-      auto cur_column = sf_source.select_column(i);
+      auto cur_column = sf_source.select_column(columns[i]);
       col.column_index = cur_column->get_index_info();
       if (col.column_index.segment_files.size() > 0) {
         col.segment_address =
@@ -164,8 +163,15 @@ void sframe_save_blockwise(const sframe& sf_source,
                            cur.current_block_number};
       auto data = block_manager.read_block(block_address , &infoptr);
       info = *infoptr;
+      // carry the zone map of the block over if there is one
+      v2_block_impl::block_zone_map zone_map;
+      const auto& zone_maps = cur.column_index.block_zone_maps;
+      if (cur.current_segment_number < zone_maps.size() &&
+          cur.current_block_number < zone_maps[cur.current_segment_number].size()) {
+        zone_map = zone_maps[cur.current_segment_number][cur.current_block_number];
+      }
       // write to segment 0. We have only 1 segment
-      writer.write_block(0, cur.column_number, data->data(), info);
+      writer.write_block(0, cur.column_number, data->data(), info, zone_map);
       // increment the block number
       advance_column_blocks_to_next_block(block_manager, cur);
       // increment the row number
@@ -176,21 +182,6 @@ void sframe_save_blockwise(const sframe& sf_source,
         std::push_heap(cols.begin(), cols.end(), comparator);
       }
     };
-
-    // close writers.
-    writer.close_segment(0);
-    writer.write_index_file();
-    auto output_index = writer.get_index_info();
-
-    // ok. now we need to write the actual frame index file
-    // get the original frame index
-    // and fill in the column data from the writer output
-    auto frame_index = sf_source.get_index_info();
-    frame_index.column_files.clear();
-    for (auto col : output_index.columns) {
-      frame_index.column_files.push_back(col.index_file);
-    }
-    write_sframe_index_file(index_file, frame_index);
   } catch (...) {
     // cleanup. close any open columns
     for(auto& col: cols) {
@@ -202,8 +193,65 @@ void sframe_save_blockwise(const sframe& sf_source,
   }
 }
 
+} // anonymous namespace
+
+void sframe_save_blockwise(const sframe& sf_source,
+                           std::string index_file,
+                           int64_t compression_level) {
+  // call it indexfile.0000
+  std::string base_name;
+  size_t last_dot = index_file.find_last_of(".");
+  if (last_dot != std::string::npos) {
+    base_name = index_file.substr(0, last_dot);
+  } else {
+    base_name = index_file;
+  }
+
+  // The columns are split into groups, each written to files of its own
+  // by its own thread, so that the writes (or the uploads, to remote
+  // storage) of the groups run in parallel. Each group is a single segment;
+  // we should be rather IO bound anyway. Within a group, the blocks are
+  // written in the order of their first row, so that the rows of the
+  // columns stay close to each other.
+  size_t num_groups = std::max<size_t>(1, std::min(sf_source.num_columns(),
+                                                   thread::cpu_count()));
+  std::vector<std::string> column_files(sf_source.num_columns());
+  parallel_for(0, num_groups, [&](size_t group) {
+    std::vector<size_t> columns;
+    for (size_t i = group;i < sf_source.num_columns(); i += num_groups) {
+      columns.push_back(i);
+    }
+    std::string group_base = base_name;
+    if (num_groups > 1) group_base += "-" + std::to_string(group);
+
+    v2_block_impl::block_writer writer;
+    writer.init(group_base + ".sidx", 1, columns.size());
+    writer.open_segment(0, group_base + ".0000");
+    if (compression_level >= 0) {
+      writer.set_options("compression_level", compression_level);
+    }
+    copy_column_blocks(sf_source, columns, writer);
+
+    // close writers.
+    writer.close_segment(0);
+    writer.write_index_file();
+    auto output_index = writer.get_index_info();
+    for (size_t i = 0;i < columns.size(); ++i) {
+      column_files[columns[i]] = output_index.columns[i].index_file;
+    }
+  });
+
+  // ok. now we need to write the actual frame index file
+  // get the original frame index
+  // and fill in the column data from the writer outputs
+  auto frame_index = sf_source.get_index_info();
+  frame_index.column_files = column_files;
+  write_sframe_index_file(index_file, frame_index);
+}
+
 void sframe_save(const sframe& sf_source,
-                 std::string index_file) {
+                 std::string index_file,
+                 int64_t compression_level) {
   // if there are any columns on sarray v1 format, we use the naive form
   bool has_legacy_sframe = false;
   for (size_t i = 0;i < sf_source.num_columns(); ++i) {
@@ -212,10 +260,10 @@ void sframe_save(const sframe& sf_source,
   }
 
   if (has_legacy_sframe) {
-    sframe_save_naive(sf_source, index_file);
+    sframe_save_naive(sf_source, index_file, compression_level);
   } else {
     sframe_fast_compact(sf_source);
-    sframe_save_blockwise(sf_source, index_file);
+    sframe_save_blockwise(sf_source, index_file, compression_level);
   }
 }
 
@@ -322,7 +370,7 @@ void sframe_save_weak_reference(const sframe& sf_source,
 
       // convert to a group index of 1 column
       group_index_file_information group_index;
-      group_index.version = 2;
+      group_index.version = column_index.version;
       group_index.nsegments = column_index.segment_files.size();
       group_index.segment_files = column_index.segment_files;
 
@@ -399,4 +447,158 @@ void sframe_save_weak_reference(const sframe& sf_source,
 
 }
 
+namespace {
+
+/**
+ * Returns the frame index a saved SFrame is read from: index_file itself, or
+ * the single frame index in the directory index_file.
+ */
+std::string resolve_frame_index(const std::string& index_file) {
+  // a saved directory holds a single frame index
+  if (fileio::get_file_status(index_file).first != fileio::file_status::DIRECTORY) {
+    return index_file;
+  }
+  std::string frame_index;
+  for (const auto& entry: fileio::get_directory_listing(index_file)) {
+    if (boost::algorithm::ends_with(entry.first, ".frame_idx")) {
+      if (!frame_index.empty()) {
+        log_and_throw("Directory " + sanitize_url(index_file) +
+                      " holds more than one SFrame");
+      }
+      frame_index = entry.first;
+    }
+  }
+  if (frame_index.empty()) {
+    log_and_throw("No SFrame saved in " + sanitize_url(index_file));
+  }
+  return frame_index;
+}
+
+/**
+ * Returns a unique prefix for the files of a new version of the SFrame saved
+ * at index_file, next to it.
+ */
+std::string new_version_base(const std::string& index_file,
+                             const std::string& tag) {
+  std::string base_name;
+  size_t last_dot = index_file.find_last_of(".");
+  if (last_dot != std::string::npos) {
+    base_name = index_file.substr(0, last_dot);
+  } else {
+    base_name = index_file;
+  }
+  auto uuid_generator = boost::uuids::random_generator();
+  return base_name + "-" + tag + "-" +
+      boost::lexical_cast<std::string>(uuid_generator());
+}
+
+/**
+ * Replaces the frame index at index_file by info. On a local file system,
+ * info is written to staged_index, which is renamed over index_file so the
+ * index is replaced atomically. Elsewhere, the index is a single object
+ * write.
+ */
+void publish_frame_index(const std::string& index_file,
+                         const std::string& staged_index,
+                         const sframe_index_file_information& info) {
+  std::string protocol = fileio::get_protocol(index_file);
+  if (protocol.empty() || protocol == "file") {
+    write_sframe_index_file(staged_index, info);
+    boost::filesystem::rename(fileio::remove_protocol(staged_index),
+                              fileio::remove_protocol(index_file));
+  } else {
+    write_sframe_index_file(index_file, info);
+  }
+}
+
+} // anonymous namespace
+
+void sframe_append_in_place(std::string index_file,
+                            const sframe& rows,
+                            int64_t compression_level) {
+  index_file = resolve_frame_index(index_file);
+  sframe saved(index_file);
+
+  // match the columns of the saved frame
+  for (size_t i = 0;i < saved.num_columns(); ++i) {
+    if (!rows.contains_column(saved.column_name(i))) {
+      log_and_throw("Column " + saved.column_name(i) + " is missing from the appended rows");
+    }
+  }
+  if (rows.num_columns() != saved.num_columns()) {
+    log_and_throw("The appended rows have columns not in the saved SFrame");
+  }
+  sframe delta = rows.select_columns(saved.column_names());
+  for (size_t i = 0;i < saved.num_columns(); ++i) {
+    if (delta.column_type(i) != saved.column_type(i)) {
+      log_and_throw("Column " + saved.column_name(i) + " of the appended rows is of type " +
+                    flex_type_enum_to_name(delta.column_type(i)) + ", not " +
+                    flex_type_enum_to_name(saved.column_type(i)));
+    }
+  }
+  if (delta.num_rows() == 0) return;
+
+  // every append writes files of its own, next to the frame index
+  std::string version_base = new_version_base(index_file, "append");
+  sframe_save(delta, version_base + "-rows.frame_idx", compression_level);
+  delta = sframe(version_base + "-rows.frame_idx");
+
+  // each column gets an index of its own listing the saved segments and the
+  // new ones. The zone maps are kept if both sides have them.
+  auto new_frame_index_info = saved.get_index_info();
+  for (size_t i = 0;i < saved.num_columns(); ++i) {
+    index_file_information column_index = saved.select_column(i)->get_index_info();
+    index_file_information delta_index = delta.select_column(i)->get_index_info();
+    if (column_index.block_zone_maps.size() == column_index.nsegments &&
+        delta_index.block_zone_maps.size() == delta_index.nsegments) {
+      column_index.block_zone_maps.insert(column_index.block_zone_maps.end(),
+                                          delta_index.block_zone_maps.begin(),
+                                          delta_index.block_zone_maps.end());
+    } else {
+      column_index.block_zone_maps.clear();
+    }
+    column_index.version = std::max(column_index.version, delta_index.version);
+    column_index.nsegments += delta_index.nsegments;
+    column_index.segment_sizes.insert(column_index.segment_sizes.end(),
+                                      delta_index.segment_sizes.begin(),
+                                      delta_index.segment_sizes.end());
+    column_index.segment_files.insert(column_index.segment_files.end(),
+                                      delta_index.segment_files.begin(),
+                                      delta_index.segment_files.end());
+
+    group_index_file_information group_index;
+    group_index.version = column_index.version;
+    group_index.nsegments = column_index.segment_files.size();
+    group_index.segment_files = column_index.segment_files;
+    group_index.columns.push_back(column_index);
+    std::string group_index_filename =
+        version_base + "-column-" + std::to_string(i) + ".sidx";
+    write_array_group_index_file(group_index_filename, group_index);
+    new_frame_index_info.column_files[i] = group_index_filename + ":0";
+  }
+  new_frame_index_info.nrows += delta.num_rows();
+
+  publish_frame_index(index_file, version_base + ".frame_idx",
+                      new_frame_index_info);
+}
+
+bool sframe_compact_saved(std::string index_file,
+                          size_t segment_threshold) {
+  index_file = resolve_frame_index(index_file);
+  sframe saved(index_file);
+  bool fragmented = false;
+  for (size_t i = 0;i < saved.num_columns(); ++i) {
+    auto column_index = saved.select_column(i)->get_index_info();
+    fragmented |= column_index.segment_files.size() > segment_threshold;
+  }
+  if (!fragmented) return false;
+
+  // the compacted version is a fresh blockwise save next to the frame index,
+  // staged under a name of its own and swapped in as a whole.
+  std::string staged_index = new_version_base(index_file, "compact") + ".frame_idx";
+  sframe_save_blockwise(saved, staged_index, -1);
+  publish_frame_index(index_file, staged_index, read_sframe_index_file(staged_index));
+  return true;
+}
+
 }
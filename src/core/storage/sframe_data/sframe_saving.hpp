@@ -19,22 +19,35 @@ class sframe;
 /**
  * Saves an SFrame to another index file location using the most naive method:
  * decode rows, and write them
+ *
+ * \param compression_level The block compression level (see
+ * \ref SFRAME_COMPRESSION_LEVEL). If negative, the global default is used.
  */
 void sframe_save_naive(const sframe& sf,
-                       std::string index_file);
+                       std::string index_file,
+                       int64_t compression_level = -1);
 
 /**
  * Saves an SFrame to another index file location using a more efficient method,
- * block by block.
+ * block by block. Every block is recompressed at the requested compression
+ * level.
+ *
+ * \param compression_level The block compression level (see
+ * \ref SFRAME_COMPRESSION_LEVEL). If negative, the global default is used.
  */
 void sframe_save_blockwise(const sframe& sf,
-                           std::string index_file);
+                           std::string index_file,
+                           int64_t compression_level = -1);
 
 /**
  * Automatically determines the optimal strategy to save an sframe
+ *
+ * \param compression_level The block compression level (see
+ * \ref SFRAME_COMPRESSION_LEVEL). If negative, the global default is used.
  */
 void sframe_save(const sframe& sf,
-                 std::string index_file);
+                 std::string index_file,
+                 int64_t compression_level = -1);
 
 /**
  * Performs an "incomplete save" to a target index file location.
@@ -57,6 +70,46 @@ void sframe_save(const sframe& sf,
 void sframe_save_weak_reference(const sframe& sf,
                                 std::string index_file);
 
+/**
+ * Appends the rows of an SFrame to the SFrame saved at index_file (a
+ * .frame_idx file, or a directory holding a single one) in place, without
+ * rewriting the rows already saved.
+ *
+ * The new rows are saved next to the index file as a segment of their own,
+ * and a new version of every column index (sidx) is written, listing the
+ * existing segments followed by the new one. Existing files are never
+ * modified: the frame index file is replaced last, by an atomic rename on
+ * local file systems, so concurrent readers see either the old or the new
+ * version. The superseded column indices are left in place for readers
+ * still holding the old version. Appends to the same SFrame must not run
+ * concurrently.
+ *
+ * The columns of rows must have the names and types of the saved SFrame
+ * (in any order). Every append adds a segment: see \ref sframe_compact.hpp
+ * to merge them.
+ *
+ * \param compression_level The block compression level of the new rows
+ * (see \ref SFRAME_COMPRESSION_LEVEL). If negative, the global default is
+ * used.
+ */
+void sframe_append_in_place(std::string index_file,
+                            const sframe& rows,
+                            int64_t compression_level = -1);
+
+/**
+ * Compacts the SFrame saved at index_file (a .frame_idx file, or a directory
+ * holding a single one) if any of its columns has more than
+ * segment_threshold segments, as many appends in place leave it.
+ *
+ * The rows are rewritten next to the index file and the frame index file is
+ * replaced last, as \ref sframe_append_in_place() does, so concurrent readers
+ * see either the old or the compacted version. The files of the old version
+ * are left in place. Must not run concurrently with appends to the same
+ * SFrame.
+ *
+ * Returns true if the SFrame was rewritten.
+ */
+bool sframe_compact_saved(std::string index_file, size_t segment_threshold);
 
 /// \}
 }; // naemspace turicreate
@@ -5,11 +5,28 @@
  */
 #include<core/storage/sframe_data/shuffle.hpp>
 #include<core/storage/sframe_data/sframe_rows.hpp>
+#include<core/storage/sframe_data/sframe_config.hpp>
+#include<core/storage/sframe_data/sframe_constants.hpp>
 #include<core/storage/fileio/buffered_writer.hpp>
+#include<core/storage/fileio/memory_budget.hpp>
+#include<core/globals/memory_accounting.hpp>
+#include<core/util/cityhash_tc.hpp>
+#include<algorithm>
+#include<cmath>
 #include<memory>
+#include<numeric>
 
 namespace turi {
 
+namespace {
+
+// guestimates for the size of each cell and the memory overhead of each
+// row, as for sorting
+constexpr size_t CELL_SIZE_ESTIMATE = 64;
+constexpr size_t ROW_SIZE_ESTIMATE = 32;
+
+} // anonymous namespace
+
 std::vector<sframe> shuffle(
     sframe sframe_in,
     size_t n,
@@ -82,4 +99,112 @@ std::vector<sframe> shuffle(
     }
     return sframe_out;
 }
+
+sframe random_shuffle(sframe sframe_in, size_t random_seed, size_t memory_budget) {
+  size_t num_rows = sframe_in.num_rows();
+  auto column_names = sframe_in.column_names();
+  auto column_types = sframe_in.column_types();
+  if (memory_budget == 0) memory_budget = sframe_config::SFRAME_SORT_BUFFER_SIZE;
+
+  size_t estimated_sframe_size =
+      num_rows * (column_names.size() * CELL_SIZE_ESTIMATE + ROW_SIZE_ESTIMATE);
+  fileio::memory_reservation shuffle_memory;
+  size_t buffer_size = shuffle_memory.reserve_up_to(
+      std::min<size_t>(std::max<size_t>(estimated_sframe_size, 1), memory_budget),
+      memory_budget / 16);
+  buffer_size = std::max<size_t>(buffer_size, 1);
+  memory_accounting::tagged_memory shuffle_buffer_memory(
+      memory_accounting::get_tag("shuffle_buffers"));
+  shuffle_buffer_memory.set(buffer_size);
+
+  // every thread holds one bucket at a time. As for sorting, there are at
+  // most SFRAME_SORT_MAX_SEGMENTS buckets open at once.
+  size_t num_workers = std::max<size_t>(thread::cpu_count(), 1);
+  size_t num_buckets = std::ceil((1.0 * estimated_sframe_size) / buffer_size);
+  num_buckets = std::min<size_t>(num_buckets * num_workers, SFRAME_SORT_MAX_SEGMENTS);
+  num_buckets = std::max<size_t>(num_buckets, 1);
+  logstream(LOG_INFO) << "Shuffling " << num_rows << " rows through "
+                      << num_buckets << " buckets" << std::endl;
+
+  // the buckets carry the random key of each row in an extra column
+  std::string key_column = "__shuffle_key";
+  while (std::find(column_names.begin(), column_names.end(), key_column)
+         != column_names.end()) {
+    key_column += "_";
+  }
+  auto bucket_column_names = column_names;
+  auto bucket_column_types = column_types;
+  bucket_column_names.push_back(key_column);
+  bucket_column_types.push_back(flex_type_enum::INTEGER);
+
+  // Pass 1: scatter the rows at random into the buckets. Every row gets a
+  // random key, and the buckets are ranges of keys, so that the output is
+  // ordered by key however many buckets there are.
+  std::vector<sframe> buckets(num_buckets);
+  std::vector<sframe::iterator> bucket_iters;
+  std::vector<std::unique_ptr<turi::mutex>> bucket_locks;
+  for (auto& bucket: buckets) {
+    bucket.open_for_write(bucket_column_names, bucket_column_types, "", 1);
+    bucket_iters.push_back(bucket.get_output_iterator(0));
+    bucket_locks.push_back(std::unique_ptr<turi::mutex>(new turi::mutex));
+  }
+
+  auto reader = sframe_in.get_reader();
+  size_t rows_per_worker = num_rows / num_workers;
+  parallel_for(0, num_workers, [&](size_t worker_id) {
+    size_t start_row = worker_id * rows_per_worker;
+    size_t end_row = (worker_id == (num_workers - 1)) ? num_rows
+                                                      : (worker_id + 1) * rows_per_worker;
+
+    std::vector<buffered_writer<std::vector<flexible_type>, sframe::iterator>> writers;
+    for (size_t i = 0; i < num_buckets; ++i) {
+      writers.push_back(
+        buffered_writer<std::vector<flexible_type>, sframe::iterator>
+        (bucket_iters[i], *bucket_locks[i],
+         SFRAME_WRITER_BUFFER_SOFT_LIMIT, SFRAME_WRITER_BUFFER_HARD_LIMIT));
+    }
+
+    std::vector<std::vector<flexible_type>> rows;
+    while (start_row < end_row) {
+      size_t rows_to_read = std::min<size_t>(end_row - start_row,
+                                             DEFAULT_SARRAY_READER_BUFFER_SIZE);
+      size_t rows_read = reader->read_rows(start_row, start_row + rows_to_read, rows);
+      for (size_t i = 0; i < rows_read; ++i) {
+        uint64_t key = hash64(random_seed, start_row + i);
+        size_t bucket_id = ((key >> 32) * num_buckets) >> 32;
+        rows[i].push_back(flex_int(key >> 1));
+        writers[bucket_id].write(std::move(rows[i]));
+      }
+      start_row += rows_read;
+    }
+    for (auto& writer: writers) writer.flush();
+  });
+  for (auto& bucket: buckets) bucket.close();
+
+  // Pass 2: order each bucket by its keys in memory, writing bucket i to
+  // segment i of the output
+  sframe sframe_out;
+  sframe_out.open_for_write(column_names, column_types, "", num_buckets);
+  parallel_for(0, num_buckets, [&](size_t bucket_id) {
+    std::vector<std::vector<flexible_type>> rows;
+    buckets[bucket_id].get_reader()->read_rows(
+        0, buckets[bucket_id].num_rows(), rows);
+    std::vector<size_t> order(rows.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return rows[a].back().get<flex_int>() < rows[b].back().get<flex_int>();
+    });
+    auto out = sframe_out.get_output_iterator(bucket_id);
+    for (size_t i: order) {
+      rows[i].pop_back();
+      *out = std::move(rows[i]);
+      ++out;
+    }
+    // the bucket is not needed anymore
+    buckets[bucket_id] = sframe();
+  });
+  sframe_out.close();
+  return sframe_out;
 }
+
+} // namespace turi
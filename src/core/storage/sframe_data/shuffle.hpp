@@ -51,6 +51,28 @@ std::vector<sframe> shuffle(
      std::function<void(const std::vector<flexible_type>&, size_t)> emit_call_back
       = std::function<void(const std::vector<flexible_type>&, size_t)>());
 
+/**
+ * Returns the rows of sframe_in in a uniformly random order, without
+ * sorting.
+ *
+ * The rows are first scattered at random into temporary buckets on disk,
+ * each small enough to be held in memory. Each bucket is then shuffled in
+ * memory, and written to a segment of the output, several buckets in
+ * parallel. Together, the buckets held in memory at any time stay within
+ * memory_budget bytes (estimated), which is reserved from the
+ * fileio::memory_budget like the buffers of a sort.
+ *
+ * The order only depends on random_seed and on the number of rows of the
+ * input.
+ *
+ * \param sframe_in The rows to shuffle.
+ * \param random_seed The seed of the permutation.
+ * \param memory_budget The bytes of rows held in memory at once. 0 for
+ *    sframe_config::SFRAME_SORT_BUFFER_SIZE.
+ */
+sframe random_shuffle(sframe sframe_in, size_t random_seed,
+                      size_t memory_budget = 0);
+
 /// \}
 //
 } // turi
@@ -20,12 +20,14 @@
 #include <core/util/file_line_count_estimator.hpp>
 #include <core/util/cityhash_tc.hpp>
 #include <core/util/hash_value.hpp>
+#include <core/util/string_kernels.hpp>
 #include <core/parallel/atomic.hpp>
 #include <core/parallel/lambda_omp.hpp>
 #include <core/storage/sframe_interface/unity_sarray_binary_operations.hpp>
 #include <core/storage/sframe_data/csv_line_tokenizer.hpp>
 #include <core/storage/sframe_data/parallel_csv_parser.hpp>
 #include <core/data/flexible_type/flexible_type_spirit_parser.hpp>
+#include <core/data/flexible_type/date_time_format.hpp>
 #include <core/storage/sframe_data/sframe_constants.hpp>
 #include <core/storage/serialization/oarchive.hpp>
 #include <core/storage/serialization/iarchive.hpp>
@@ -36,6 +38,7 @@
 #include <core/storage/query_engine/operators/operator_properties.hpp>
 #include <core/storage/query_engine/planning/planner.hpp>
 #include <core/storage/query_engine/planning/optimization_engine.hpp>
+#include <core/storage/query_engine/planning/explain.hpp>
 #include <core/storage/query_engine/util/aggregates.hpp>
 #include <core/storage/sframe_data/rolling_aggregate.hpp>
 #include <core/data/sframe/gl_sarray.hpp>
@@ -65,6 +68,72 @@ static std::shared_ptr<sarray<flexible_type>> get_empty_sarray() {
   return *empty_sarray;
 }
 
+/**
+ * Fused arithmetic expressions stop growing at this size; the next operation
+ * simply reads the result of the previous transform.
+ */
+static const size_t MAX_FUSED_EXPRESSION_NODES = 64;
+
+/**
+ * Returns a batch expression which reads the values of pnode (of type type),
+ * appending the planner nodes it reads from to inputs.
+ *
+ * If pnode is itself a transform computed by a batch expression, that
+ * expression is reused over the inputs of pnode, so that chains of
+ * arithmetic operations are fused into a single operator. Binary transforms
+ * are only fused if allow_two_inputs is true.
+ */
+static batch_expression_ptr get_fusable_expression(
+    const std::shared_ptr<planner_node>& pnode,
+    flex_type_enum type,
+    bool allow_two_inputs,
+    std::vector<std::shared_ptr<planner_node>>& inputs) {
+  auto iter = pnode->any_operator_parameters.find("batch_expression");
+  bool fusable = iter != pnode->any_operator_parameters.end() &&
+      (pnode->operator_type == planner_node_type::TRANSFORM_NODE ||
+       (allow_two_inputs &&
+        pnode->operator_type == planner_node_type::BINARY_TRANSFORM_NODE));
+  if (fusable) {
+    auto expr = iter->second.as<batch_expression_ptr>();
+    if (expr->value_type == type &&
+        expr->num_nodes() < MAX_FUSED_EXPRESSION_NODES) {
+      size_t offset = inputs.size();
+      inputs.insert(inputs.end(), pnode->inputs.begin(), pnode->inputs.end());
+      return offset == 0 ? expr : expr->with_input(offset);
+    }
+  }
+  inputs.push_back(pnode);
+  return batch_expression::make_input(inputs.size() - 1, type);
+}
+
+/**
+ * Builds the transform (one input) or binary transform (two inputs) which
+ * computes expr.
+ */
+static std::shared_ptr<unity_sarray> make_batch_expression_sarray(
+    batch_expression_ptr expr,
+    const std::vector<std::shared_ptr<planner_node>>& inputs,
+    flex_type_enum output_type) {
+  std::shared_ptr<planner_node> pnode;
+  if (inputs.size() == 1) {
+    transform_type fn = [expr](const sframe_rows::row& row)->flexible_type {
+      return expr->evaluate_row(row);
+    };
+    pnode = op_transform::make_planner_node(inputs[0], fn, output_type, -1, expr);
+  } else {
+    ASSERT_EQ(inputs.size(), 2);
+    binary_transform_type fn = [expr](const sframe_rows::row& left,
+                                      const sframe_rows::row& right)->flexible_type {
+      return expr->evaluate_row(left, right);
+    };
+    pnode = op_binary_transform::make_planner_node(inputs[0], inputs[1], fn,
+                                                   output_type, expr);
+  }
+  auto ret = std::make_shared<unity_sarray>();
+  ret->construct_from_planner_node(pnode);
+  return ret;
+}
+
 unity_sarray::unity_sarray() {
   // make empty sarray and keep it around, reusing it whenever
   // I need an empty sarray
@@ -1180,40 +1249,16 @@ std::shared_ptr<unity_sarray_base> unity_sarray::str_to_datetime(std::string for
     format = "%Y%m%dT%H%M%S%F%q";
   }
 
+  // one reader per thread, each compiling the format once
   const size_t max_n_threads = thread::cpu_count();
-  std::vector<std::shared_ptr<std::istringstream> > streams(max_n_threads);
+  std::vector<std::shared_ptr<flexible_type_impl::date_time_string_reader>> readers(max_n_threads);
   for (size_t index = 0; index < max_n_threads;index++) {
-    std::shared_ptr<std::istringstream> ss(new std::istringstream);
-    ss->exceptions(std::ios_base::failbit);
-    ss->imbue(std::locale(ss->getloc(),new boost::local_time::local_time_input_facet(format)));
-    streams[index] = ss;
-  }
-  auto transform_fn = [streams, format](const flexible_type& f)->flexible_type {
-    size_t thread_idx = thread::thread_id();
-    const auto& stream = streams[thread_idx];
-    try {
-      if(f.get<flex_string>() != ""){
-        boost::local_time::local_date_time ldt(boost::posix_time::not_a_date_time);
-        stream->str(f.get<flex_string>());
-        (*stream) >> ldt;
-
-        boost::posix_time::ptime p = ldt.utc_time();
-        std::time_t _time = flexible_type_impl::ptime_to_time_t(p);
-        int32_t microseconds = flexible_type_impl::ptime_to_fractional_microseconds(p);
-        int32_t timezone_offset = flex_date_time::EMPTY_TIMEZONE;
-        if(ldt.zone()) {
-          timezone_offset =
-              (int32_t)ldt.zone()->base_utc_offset().total_seconds() /
-              flex_date_time::TIMEZONE_RESOLUTION_IN_SECONDS;
-        }
-        return flexible_type(flex_date_time(_time,timezone_offset, microseconds));
-      }else{
-        return flexible_type(flex_undefined());
-      }
-    } catch(std::exception& ex) {
-      log_and_throw("Unable to interpret " + f.get<flex_string>() +
-                    " as string with " + format + " format");
-    }
+    readers[index] = std::make_shared<flexible_type_impl::date_time_string_reader>(format);
+  }
+  auto transform_fn = [readers](const flexible_type& f)->flexible_type {
+    const auto& s = f.get<flex_string>();
+    if (s.empty()) return flexible_type(flex_undefined());
+    return flexible_type(readers[thread::thread_id()]->read(s));
   };
   auto ret = transform_lambda(transform_fn,
                               flex_type_enum::DATETIME,
@@ -1230,71 +1275,14 @@ std::shared_ptr<unity_sarray_base> unity_sarray::datetime_to_str(const std::stri
     log_and_throw("input SArray must be datetime type.");
   }
 
+  // one writer per thread, each compiling the format once
   const size_t max_n_threads = thread::cpu_count();
-  std::vector<std::shared_ptr<std::ostringstream> > streams(max_n_threads);
+  std::vector<std::shared_ptr<flexible_type_impl::date_time_string_writer>> writers(max_n_threads);
   for (size_t index = 0; index < max_n_threads;index++) {
-    std::shared_ptr<std::ostringstream> ss(new std::ostringstream);
-    ss->exceptions(std::ios_base::failbit);
-    ss->imbue(std::locale(ss->getloc(),
-                          new boost::local_time::local_time_facet(format.c_str())));
-    streams[index] = ss;
-  }
-
-  using namespace boost;
-  using namespace local_time;
-  using namespace gregorian;
-  using posix_time::time_duration;
-
-  time_zone_names empty_timezone("", "", "", "");
-  time_duration empty_utc_offset(0,0,0);
-  dst_adjustment_offsets empty_adj_offsets(time_duration(0,0,0),
-                                           time_duration(0,0,0),
-                                           time_duration(0,0,0));
-  time_zone_ptr empty_tz(
-      new custom_time_zone(empty_timezone, empty_utc_offset,
-                           empty_adj_offsets,
-                           boost::shared_ptr<dst_calc_rule>()));
-
-  auto transform_fn = [format, streams, empty_tz](const flexible_type& f) -> flexible_type {
-    size_t thread_idx = thread::thread_id();
-    const auto& stream = streams[thread_idx];
-    flexible_type ret;
-    try {
-      const flex_date_time & dt = f.get<flex_date_time>();
-      if (dt.time_zone_offset() != flex_date_time::EMPTY_TIMEZONE) {
-        std::string prefix = "0.";
-        int sign_adjuster = 1;
-        if(dt.time_zone_offset() < 0) {
-          sign_adjuster = -1;
-          prefix = "-0.";
-        }
-        // prepend a GMT0. or GMT-0. to the string for the timezone information
-        // TODO: This can be optimized by precomputing this for all zones outsize
-        // of the function.
-        boost::local_time::time_zone_ptr zone(
-            new boost::local_time::posix_time_zone(
-                "GMT" + prefix +
-                std::to_string(sign_adjuster *
-                               dt.time_zone_offset() *
-                               flex_date_time::TIMEZONE_RESOLUTION_IN_MINUTES)));
-        boost::local_time::local_date_time az(
-            flexible_type_impl::ptime_from_time_t(dt.posix_timestamp(),
-                                                  dt.microsecond()), zone);
-        (*stream) << az;
-      } else {
-        boost::local_time::local_date_time az(
-            flexible_type_impl::ptime_from_time_t(dt.posix_timestamp(),
-                                                  dt.microsecond()),
-            empty_tz);
-        (*stream) << az;
-      }
-      ret = stream->str();
-      stream->str(std::string()); // need to clear stringstream buffer
-    } catch(...) {
-      log_and_throw("Unable to interpret " + f.get<flex_string>()
-                    + " as string with " + format + " format");
-    }
-    return ret;
+    writers[index] = std::make_shared<flexible_type_impl::date_time_string_writer>(format);
+  }
+  auto transform_fn = [writers](const flexible_type& f) -> flexible_type {
+    return writers[thread::thread_id()]->write(f.get<flex_date_time>());
   };
 
   auto ret = transform_lambda(transform_fn,
@@ -1421,6 +1409,22 @@ std::shared_ptr<unity_sarray_base> unity_sarray::lazy_astype(flex_type_enum dtyp
                                 0 /*random seed*/);
     return ret;
 
+  } else if (batch_expression::supports_type(current_type) &&
+             batch_expression::supports_type(dtype)) {
+    // numeric casts are evaluated a batch at a time, fused with the
+    // numeric operations before them
+    batch_scalar_fn cast_fn =
+        [dtype](const flexible_type& f, const flexible_type&)->flexible_type {
+          if (f.get_type() == flex_type_enum::UNDEFINED) return f;
+          flexible_type ret(dtype);
+          ret.soft_assign(f);
+          return ret;
+        };
+    std::vector<std::shared_ptr<planner_node>> inputs;
+    auto source_expr = get_fusable_expression(m_planner_node, current_type,
+                                              true /*allow two inputs*/, inputs);
+    return make_batch_expression_sarray(
+        batch_expression::make_cast(source_expr, dtype, cast_fn), inputs, dtype);
   } else {
     auto ret = transform_lambda([dtype, undefined_on_failure](const flexible_type& f)->flexible_type {
                                   flexible_type ret(dtype);
@@ -1530,6 +1534,18 @@ size_t unity_sarray::nnz() {
                                     reductionfn, combinefn, 0);
 }
 
+void unity_sarray::mark_equality_with_constant(const std::shared_ptr<unity_sarray>& result,
+                                               const flexible_type& other,
+                                               const std::string& op) {
+  if (op != "==" || other.get_type() == flex_type_enum::UNDEFINED) return;
+  // only when result compares this array itself (and not an expression
+  // fused with it) with the constant
+  auto pnode = result->get_planner_node();
+  if (pnode->inputs.size() == 1 && pnode->inputs[0] == m_planner_node) {
+    pnode->operator_parameters["equals_constant"] = other;
+  }
+}
+
 std::shared_ptr<unity_sarray_base> unity_sarray::scalar_operator(flexible_type other,
                                                                  std::string op,
                                                                  bool right_operator) {
@@ -1573,16 +1589,59 @@ std::shared_ptr<unity_sarray_base> unity_sarray::scalar_operator(flexible_type o
   //  - or if the binary operator does ternary logic
   //  - Or if the other scalar value is undefined.
   bool op_ternary = (op == "==" || op == "!=" || op == "in" || op == "&" || op == "|");
+
+  // numeric operations are evaluated a batch at a time, fused with
+  // the numeric operations before them
+  if (batch_expression::supports_operator(op, left_type, right_type)) {
+    batch_scalar_fn scalar_fn =
+        [=](const flexible_type& l, const flexible_type& r)->flexible_type {
+          const flexible_type& f = right_operator ? r : l;
+          if (!op_ternary && f.get_type() == flex_type_enum::UNDEFINED) return f;
+          flexible_type ret = binaryfn(l, r);
+          if (ret.get_type() == output_type ||
+              ret.get_type() == flex_type_enum::UNDEFINED) {
+            return ret;
+          }
+          flexible_type changed_ret(output_type);
+          changed_ret.soft_assign(ret);
+          return changed_ret;
+        };
+    std::vector<std::shared_ptr<planner_node>> inputs;
+    auto array_expr = get_fusable_expression(m_planner_node, dtype(),
+                                             true /*allow two inputs*/, inputs);
+    auto constant_expr = batch_expression::make_constant(other);
+    auto expr = right_operator ?
+        batch_expression::make_binary(op, constant_expr, array_expr, scalar_fn) :
+        batch_expression::make_binary(op, array_expr, constant_expr, scalar_fn);
+    auto ret = make_batch_expression_sarray(expr, inputs, output_type);
+    mark_equality_with_constant(ret, other, op);
+    return ret;
+  }
+
+  // substring search of a constant: the needle is prepared once
+  if (op == "in" && !right_operator &&
+      left_type == flex_type_enum::STRING && right_type == flex_type_enum::STRING) {
+    string_kernels::substring_searcher searcher(other.get<flex_string>());
+    auto transformfn = [searcher](const flexible_type& f)->flexible_type {
+      if (f.get_type() != flex_type_enum::STRING) return 0;
+      return searcher.contained_in(f.get<flex_string>());
+    };
+    return transform_lambda(transformfn, output_type, false /*skip undefined*/, 0);
+  }
+
   if (other.get_type() == flex_type_enum::UNDEFINED || op_ternary) {
     auto transformfn =
         [=](const flexible_type& f)->flexible_type {
           return right_operator ? binaryfn(other, f) : binaryfn(f, other);
         };
 
-    return transform_lambda(transformfn,
-                            output_type,
-                            false/*skip undefined*/,
-                            0 /*random seed*/);
+    auto ret = std::static_pointer_cast<unity_sarray>(
+        transform_lambda(transformfn,
+                         output_type,
+                         false/*skip undefined*/,
+                         0 /*random seed*/));
+    mark_equality_with_constant(ret, other, op);
+    return ret;
   } else {
     auto transformfn = [=](const flexible_type& f)->flexible_type {
           if (f.get_type() == flex_type_enum::UNDEFINED) {
@@ -1638,13 +1697,10 @@ std::shared_ptr<unity_sarray_base> unity_sarray::vector_operator(
   auto transformfn =
       unity_sarray_binary_operations::get_binary_operator(dtype(), other->dtype(), op);
 
-  query_eval::binary_transform_type transform_fn_with_undefined_checking;
+  batch_scalar_fn value_fn_with_undefined_checking;
   if (op == "==") {
-    transform_fn_with_undefined_checking =
-        [=](const sframe_rows::row& frow,
-            const sframe_rows::row& grow)->flexible_type {
-          const auto& f = frow[0];
-          const auto& g = grow[0];
+    value_fn_with_undefined_checking =
+        [=](const flexible_type& f, const flexible_type& g)->flexible_type {
           if (f.get_type() == flex_type_enum::UNDEFINED ||
               g.get_type() == flex_type_enum::UNDEFINED) {
             // this says (UNDEFINED == UNDEFINED) == True
@@ -1654,11 +1710,8 @@ std::shared_ptr<unity_sarray_base> unity_sarray::vector_operator(
           else return transformfn(f, g);
         };
   } else if (op == "!=") {
-    transform_fn_with_undefined_checking =
-        [=](const sframe_rows::row& frow,
-            const sframe_rows::row& grow)->flexible_type {
-          const auto& f = frow[0];
-          const auto& g = grow[0];
+    value_fn_with_undefined_checking =
+        [=](const flexible_type& f, const flexible_type& g)->flexible_type {
           if (f.get_type() == flex_type_enum::UNDEFINED ||
               g.get_type() == flex_type_enum::UNDEFINED) {
             // this says (UNDEFINED != UNDEFINED) == False
@@ -1669,20 +1722,11 @@ std::shared_ptr<unity_sarray_base> unity_sarray::vector_operator(
         };
   } else if (op == "&" || op == "|") {
     // these do ternary logic
-    transform_fn_with_undefined_checking =
-        [=](const sframe_rows::row& frow,
-            const sframe_rows::row& grow)->flexible_type {
-          const auto& f = frow[0];
-          const auto& g = grow[0];
-          return transformfn(f, g);
-        };
+    value_fn_with_undefined_checking = transformfn;
   } else {
     // all others constant propagate
-    transform_fn_with_undefined_checking =
-        [=](const sframe_rows::row& frow,
-            const sframe_rows::row& grow)->flexible_type {
-          const auto& f = frow[0];
-          const auto& g = grow[0];
+    value_fn_with_undefined_checking =
+        [=](const flexible_type& f, const flexible_type& g)->flexible_type {
           if (f.get_type() == flex_type_enum::UNDEFINED ||
               g.get_type() == flex_type_enum::UNDEFINED) {
             return FLEX_UNDEFINED;
@@ -1691,6 +1735,26 @@ std::shared_ptr<unity_sarray_base> unity_sarray::vector_operator(
         };
   }
 
+  // numeric operations are evaluated a batch at a time, fused with
+  // the numeric operations on either side
+  if (batch_expression::supports_operator(op, dtype(), other->dtype())) {
+    std::vector<std::shared_ptr<planner_node>> inputs;
+    auto left_expr = get_fusable_expression(m_planner_node, dtype(),
+                                            false /*allow two inputs*/, inputs);
+    auto right_expr = get_fusable_expression(other_unity_sarray->m_planner_node,
+                                             other->dtype(),
+                                             false /*allow two inputs*/, inputs);
+    auto expr = batch_expression::make_binary(op, left_expr, right_expr,
+                                              value_fn_with_undefined_checking);
+    return make_batch_expression_sarray(expr, inputs, output_type);
+  }
+
+  query_eval::binary_transform_type transform_fn_with_undefined_checking =
+      [=](const sframe_rows::row& frow,
+          const sframe_rows::row& grow)->flexible_type {
+        return value_fn_with_undefined_checking(frow[0], grow[0]);
+      };
+
   auto ret = std::make_shared<unity_sarray>();
   ret->construct_from_planner_node(
       op_binary_transform::make_planner_node(m_planner_node,
@@ -1872,63 +1936,28 @@ unity_sarray::count_bag_of_words(std::map<std::string, flexible_type> options) {
     delimiter_list = options["delimiters"];
   }
 
-  std::set<char> delimiters;
+  string_kernels::delimiter_set delimiters;
   for (auto it = delimiter_list.begin(); it != delimiter_list.end(); ++it) {
-    // iterate through flexible_types storing the delimiters
     // cast each to a string and take first char in string
-    // insert into std::set for quicker look-ups than turi::flex_list
     delimiters.insert(it->to<std::string>().at(0));
   }
 
-  auto is_delimiter = [delimiters](const char c)->bool {
-    return delimiters.find(c) != delimiters.end();
-  };
-
-  auto transformfn = [to_lower, is_delimiter](const flexible_type& f)->flexible_type {
+  auto transformfn = [to_lower, delimiters](const flexible_type& f)->flexible_type {
     flex_dict ret;
     const std::string& str = f.get<flex_string>();
 
-    // Tokenizing the string by space, and add to mape
-    // Here we optimize for speed to reduce the string malloc
-    size_t word_begin = 0;
-    // skip leading delimiters
-    while (word_begin < str.size() && (is_delimiter(str[word_begin])))
-      ++word_begin;
-
-    std::string word;
-    flexible_type word_flex;
-
     // count bag of words
     std::unordered_map<flexible_type, size_t> ret_count;
-
-    for (size_t i = word_begin; i < str.size(); ++i) {
-      if (is_delimiter(str[i])) {
-        // find the end of thw word, make a substring, and transform to lower case
-        word = std::string(str, word_begin, i - word_begin);
-        if  (to_lower)
-          std::transform(word.begin(), word.end(), word.begin(), ::tolower);
-        word_flex = std::move(word);
-
-        // add the word to map
-        ret_count[word_flex]++;
-
-        // keep skipping delimiters, and reset word_begin
-        while (i < str.size() && (is_delimiter(str[i])))
-          ++i;
-        word_begin = i;
-      }
-    }
-
-    // add the last word
-    if (word_begin < str.size()) {
-      word = std::string(str, word_begin, str.size() - word_begin);
-      if  (to_lower)
-        std::transform(word.begin(), word.end(), word.begin(), ::tolower);
-      word_flex = std::move(word);
+    flexible_type word_flex;
+    delimiters.for_each_token(str.data(), str.size(), [&](const char* word, size_t len) {
+      std::string w(word, len);
+      if (to_lower) string_kernels::ascii_to_lower(w);
+      word_flex = std::move(w);
       ret_count[word_flex]++;
-    }
+    });
 
     // convert to dictionary
+    ret.reserve(ret_count.size());
     for(auto& val : ret_count) {
       ret.push_back({val.first, flexible_type(val.second)});
     }
@@ -1967,7 +1996,8 @@ unity_sarray::count_ngrams(size_t n, std::map<std::string, flexible_type> option
     //Do a string copy if need to convert to lowercase
 
     if (to_lower){
-      lower = boost::algorithm::to_lower_copy(f.get<flex_string>());
+      lower = f.get<flex_string>();
+      string_kernels::ascii_to_lower(lower);
     }
 
     const std::string& str =  (to_lower) ? lower : f.get<flex_string>();
@@ -2108,7 +2138,8 @@ unity_sarray::count_character_ngrams(size_t n, std::map<std::string, flexible_ty
     //Do a string copy if need to convert to lowercase
 
     if (to_lower){
-      lower = boost::algorithm::to_lower_copy(f.get<flex_string>());
+      lower = f.get<flex_string>();
+      string_kernels::ascii_to_lower(lower);
     }
 
     const std::string& str =  (to_lower) ? lower : f.get<flex_string>();
@@ -2535,45 +2566,43 @@ std::shared_ptr<unity_sframe_base> unity_sarray::expand(
         if (row[0].get_type() == flex_type_enum::UNDEFINED) {
           for(size_t i = 0; i < ret.size(); i++) ret[i] = flex_undefined();
         } else {
+          // the calendar fields are computed once for all the columns
+          const flex_date_time & dt = row[0].get<flex_date_time>();
+          flexible_type_impl::civil_time _tm =
+              flexible_type_impl::civil_time_from_timestamp(dt.shifted_posix_timestamp());
           for(size_t i = 0; i < date_elements.size() ; i++) {
-            const flex_date_time & dt = row[0].get<flex_date_time>();
-            boost::posix_time::ptime ptime_val =
-                flexible_type_impl::ptime_from_time_t(dt.shifted_posix_timestamp());
-            tm _tm = boost::posix_time::to_tm(ptime_val);
             switch(date_elements[i]) {
               case date_element_type::YEAR:
-                ret[i] = _tm.tm_year + 1900;
+                ret[i] = _tm.year;
                 break;
               case date_element_type::MONTH:
-                // +1 is for adjustment with datetime object in python,
-                // tm is from 0-11 while datetime is from 1-12
-                ret[i] = _tm.tm_mon + 1;
+                ret[i] = _tm.month;
                 break;
               case date_element_type::DAY:
-                ret[i] = _tm.tm_mday;
+                ret[i] = _tm.day;
                 break;
               case date_element_type::HOUR:
-                ret[i] = _tm.tm_hour;
+                ret[i] = _tm.hour;
                 break;
               case date_element_type::MINUTE:
-                ret[i] = _tm.tm_min;
+                ret[i] = _tm.minute;
                 break;
               case date_element_type::SECOND:
-                ret[i] = _tm.tm_sec;
+                ret[i] = _tm.second;
                 break;
               case date_element_type::WEEKDAY:
                 // tm day has Sunday = 0, Sat = 6
                 // Python weekday has Monday = 0, Sun = 6
                 // so rotate by 1
-                ret[i] = (_tm.tm_wday + 6) % 7;
+                ret[i] = (_tm.weekday + 6) % 7;
                 break;
               case date_element_type::ISOWEEKDAY:
                 // tm day has Sunday = 0, Monday = 1, Sat = 6
                 // Python isoweekday has Monday = 1, Sun = 7
-                ret[i] = ((_tm.tm_wday + 6) % 7) + 1;
+                ret[i] = ((_tm.weekday + 6) % 7) + 1;
                 break;
               case date_element_type::TMWEEKDAY:
-                ret[i] = _tm.tm_wday;
+                ret[i] = _tm.weekday;
                 break;
               case date_element_type::US:
                 ret[i] = dt.microsecond();
@@ -2687,11 +2716,18 @@ void unity_sarray::begin_iterator() {
 
   // nothing to iterate over. quit
   if (!sarray_ptr || size() == 0) return;
+  // stop reading ahead of the previous iteration
+  iterator_prefetcher.reset();
   iterator_sarray_ptr = sarray_ptr->get_reader();
   // init the iterators
   iterator_current_segment_iter.reset(new sarray_iterator<flexible_type>(iterator_sarray_ptr->begin(0)));
   iterator_current_segment_enditer.reset(new sarray_iterator<flexible_type>(iterator_sarray_ptr->end(0)));
   iterator_next_segment_id = 1;
+  iterator_prefetcher.reset(new batch_prefetcher<flexible_type>(
+      [this](std::vector<flexible_type>& batch, size_t len) {
+        this->iterator_read_next(batch, len);
+      },
+      SFRAME_ITERATOR_PREFETCH_BATCHES));
 }
 
 struct slicer_impl {
@@ -2861,9 +2897,12 @@ unity_sarray::to_const(const flexible_type& value, flex_type_enum type) {
 }
 std::vector<flexible_type> unity_sarray::iterator_get_next(size_t len) {
   Dlog_func_entry();
-  std::vector<flexible_type> ret;
   // nothing to iterate over. quit
-  if (!iterator_sarray_ptr || size() == 0) return ret;
+  if (!iterator_prefetcher || size() == 0) return {};
+  return iterator_prefetcher->get_next(len);
+}
+
+void unity_sarray::iterator_read_next(std::vector<flexible_type>& ret, size_t len) {
   // try to extract len elements
   ret.reserve(len);
   // loop across segments
@@ -2884,8 +2923,6 @@ std::vector<flexible_type> unity_sarray::iterator_get_next(size_t len) {
         iterator_sarray_ptr->end(iterator_next_segment_id)));
     ++iterator_next_segment_id;
   }
-
-  return ret;
 }
 
 
@@ -2903,6 +2940,10 @@ bool unity_sarray::is_materialized() {
   return false;
 }
 
+std::map<std::string, flexible_type> unity_sarray::explain() {
+  return query_eval::explain_query_plan(get_planner_node()).to_map();
+}
+
 
 size_t unity_sarray::get_content_identifier() {
   if (is_materialized()) {
@@ -9,6 +9,7 @@
 #include <vector>
 #include <memory>
 #include <core/data/flexible_type/flexible_type.hpp>
+#include <core/util/batch_prefetcher.hpp>
 #include <model_server/lib/api/unity_sarray_interface.hpp>
 #include <visualization/server/plot.hpp>
 
@@ -739,6 +740,12 @@ class unity_sarray: public unity_sarray_base {
    * test hook to check if the array is materialized
    **/
    bool is_materialized();
+
+  /**
+   * Explains the query plan without executing it. See
+   * \ref unity_sframe::explain().
+   */
+  std::map<std::string, flexible_type> explain();
    /**
     * Returns an integer which attempts to uniquely identifies the contents of
     * the SArray.
@@ -842,6 +849,17 @@ class unity_sarray: public unity_sarray_base {
    */
   std::unique_ptr<sarray_iterator<flexible_type>> iterator_current_segment_enditer;
 
+  /**
+   * Supports \ref begin_iterator() and \ref iterator_get_next().
+   * Reads the values ahead of iterator_get_next() with
+   * \ref iterator_read_next(). Declared last, to stop before the readers are
+   * destroyed.
+   */
+  std::unique_ptr<batch_prefetcher<flexible_type>> iterator_prefetcher;
+
+  /// Appends the next len values of the iterator to ret
+  void iterator_read_next(std::vector<flexible_type>& ret, size_t len);
+
 
   /**
    * Performs either of "array [op] other" or "other [op] array",
@@ -872,6 +890,16 @@ class unity_sarray: public unity_sarray_base {
                                                      std::string op,
                                                      bool right_operator);
 
+  /**
+   * If op is "==", records on the planner node of result, which compares
+   * this array with the constant other, that it does. A logical filter by
+   * result can then use a key index of this array (see
+   * unity_sframe::create_key_index()).
+   */
+  void mark_equality_with_constant(const std::shared_ptr<unity_sarray>& result,
+                                   const flexible_type& other,
+                                   const std::string& op);
+
 
   void construct_from_unity_sarray(const unity_sarray& other);
 
@@ -9,11 +9,14 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/optional.hpp>
 #include <core/storage/sframe_interface/unity_sframe.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
 #include <core/storage/sframe_data/sframe.hpp>
 #include <core/storage/sframe_data/sframe_saving.hpp>
 #include <core/storage/sframe_data/sframe_config.hpp>
 #include <core/storage/sframe_data/sarray.hpp>
 #include <core/storage/sframe_data/algorithm.hpp>
+#include <core/storage/sframe_data/row_sampling.hpp>
+#include <core/storage/sframe_data/sframe_key_index.hpp>
 #include <core/storage/fileio/temp_files.hpp>
 #include <core/storage/fileio/sanitize_url.hpp>
 #include <model_server/lib/unity_global.hpp>
@@ -25,13 +28,17 @@
 #include <core/data/flexible_type/flexible_type_spirit_parser.hpp>
 #include <core/storage/sframe_data/join.hpp>
 #include <model_server/lib/auto_close_sarray.hpp>
+#include <core/storage/query_engine/execution/query_profile.hpp>
 #include <core/storage/query_engine/planning/planner.hpp>
 #include <core/storage/query_engine/planning/optimization_engine.hpp>
+#include <core/storage/query_engine/planning/explain.hpp>
 #include <core/storage/query_engine/operators/all_operators.hpp>
 #include <core/storage/query_engine/operators/operator_properties.hpp>
 #include <core/storage/query_engine/algorithm/sort.hpp>
 #include <core/storage/query_engine/algorithm/ec_sort.hpp>
 #include <core/storage/query_engine/algorithm/groupby_aggregate.hpp>
+#include <core/storage/query_engine/algorithm/merge_join.hpp>
+#include <core/storage/query_engine/algorithm/topk.hpp>
 #include <core/storage/query_engine/operators/operator_properties.hpp>
 #include <core/system/exceptions/error_types.hpp>
 
@@ -95,6 +102,11 @@ void unity_sframe::construct_from_sframe(const sframe& sf) {
   this->set_sframe(std::make_shared<sframe>(sf));
 }
 
+void unity_sframe::construct_from_arrow(ArrowSchema* schema, ArrowArray* array) {
+  log_func_entry();
+  construct_from_sframe(import_sframe_from_arrow(schema, array));
+}
+
 void unity_sframe::construct_from_sframe_index(std::string location) {
   logstream(LOG_INFO) << "Construct sframe from location: " << sanitize_url(location) << std::endl;
   clear();
@@ -368,6 +380,34 @@ void unity_sframe::clear() {
   m_planner_node.reset();
   m_column_names.clear();
   m_cached_sframe.reset();
+  m_sort_key_indices.clear();
+  m_sorted_planner_node.reset();
+}
+
+void unity_sframe::set_sorted_on(const std::vector<size_t>& sort_key_indices) {
+  m_sort_key_indices = sort_key_indices;
+  m_sorted_planner_node = m_planner_node;
+}
+
+void unity_sframe::replace_planner_node(const std::shared_ptr<planner_node>& node) {
+  if (m_sorted_planner_node.lock() == m_planner_node) m_sorted_planner_node = node;
+  m_planner_node = node;
+}
+
+bool unity_sframe::rows_grouped_on(const std::vector<std::string>& key_columns) {
+  if (key_columns.empty() || m_sorted_planner_node.lock() != m_planner_node ||
+      key_columns.size() > m_sort_key_indices.size()) {
+    return false;
+  }
+  std::set<size_t> key_indices;
+  for (const auto& key: key_columns) {
+    auto iter = std::find(m_column_names.begin(), m_column_names.end(), key);
+    if (iter == m_column_names.end()) return false;
+    key_indices.insert(iter - m_column_names.begin());
+  }
+  std::set<size_t> leading_sort_keys(m_sort_key_indices.begin(),
+                                     m_sort_key_indices.begin() + key_indices.size());
+  return key_indices == leading_sort_keys;
 }
 
 size_t unity_sframe::size() {
@@ -729,6 +769,47 @@ std::shared_ptr<unity_sarray_base> unity_sframe::transform_lambda(
   return ret;
 }
 
+std::shared_ptr<unity_sframe> unity_sframe::transform_columns(
+    const std::vector<query_eval::columnwise_kernel>& kernels,
+    const std::vector<flex_type_enum>& output_types) {
+  log_func_entry();
+  if (kernels.size() != num_columns() || output_types.size() != num_columns()) {
+    log_and_throw("Expecting one kernel and one output type per column");
+  }
+  auto column_types = dtype();
+  for (size_t i = 0; i < kernels.size(); ++i) {
+    if (!kernels[i] && output_types[i] != column_types[i]) {
+      log_and_throw("Column " + column_name(i) + " is kept and cannot change type");
+    }
+  }
+  auto new_planner_node = op_columnwise_transform::make_planner_node(
+      this->get_planner_node(), kernels, output_types);
+  auto ret = std::make_shared<unity_sframe>();
+  ret->construct_from_planner_node(new_planner_node, column_names());
+  return ret;
+}
+
+std::shared_ptr<unity_sframe> unity_sframe::fill_missing_values(
+    const std::map<std::string, flexible_type>& values) {
+  log_func_entry();
+  auto column_types = dtype();
+  std::vector<query_eval::columnwise_kernel> kernels(num_columns());
+  for (const auto& column_value: values) {
+    size_t i = column_index(column_value.first);
+    flexible_type default_value = column_value.second;
+    if (!flex_type_is_convertible(default_value.get_type(), column_types[i])) {
+      log_and_throw("Default value must be convertible to column type");
+    }
+    kernels[i] = [default_value](const std::vector<flexible_type>& in,
+                                 std::vector<flexible_type>& out) {
+      for (size_t j = 0; j < in.size(); ++j) {
+        out[j] = in[j].is_na() ? default_value : in[j];
+      }
+    };
+  }
+  return transform_columns(kernels, column_types);
+}
+
 std::shared_ptr<unity_sframe_base> unity_sframe::flat_map(
     const std::string& lambda,
     std::vector<std::string> column_names,
@@ -883,6 +964,9 @@ std::shared_ptr<unity_sframe_base> unity_sframe::logical_filter(
 
   std::shared_ptr<unity_sarray> filter_array = std::static_pointer_cast<unity_sarray>(index);
 
+  auto indexed_result = logical_filter_by_key_index(filter_array);
+  if (indexed_result) return indexed_result;
+
   std::shared_ptr<unity_sarray> other_array_binarized =
       std::static_pointer_cast<unity_sarray>(
       filter_array->transform_lambda(
@@ -997,20 +1081,29 @@ void unity_sframe::begin_iterator() {
     return;
 
   auto sframe_ptr = get_underlying_sframe();
+  // stop reading ahead of the previous iteration
+  iterator_prefetcher.reset();
   iterator_sframe_ptr = sframe_ptr->get_reader();
   // init the iterators
   iterator_current_segment_iter.reset(new sframe_iterator(iterator_sframe_ptr->begin(0)));
   iterator_current_segment_enditer.reset(new sframe_iterator(iterator_sframe_ptr->end(0)));
   iterator_next_segment_id = 1;
+  iterator_prefetcher.reset(new batch_prefetcher<std::vector<flexible_type>>(
+      [this](std::vector<std::vector<flexible_type>>& batch, size_t len) {
+        this->iterator_read_next(batch, len);
+      },
+      SFRAME_ITERATOR_PREFETCH_BATCHES));
 }
 
 std::vector< std::vector<flexible_type> > unity_sframe::iterator_get_next(size_t len) {
-  std::vector< std::vector<flexible_type> > ret;
-
   // Empty sframe just return
-  if (this->size() == 0)
-    return ret;
+  if (this->size() == 0 || !iterator_prefetcher)
+    return {};
+  return iterator_prefetcher->get_next(len);
+}
 
+void unity_sframe::iterator_read_next(std::vector<std::vector<flexible_type>>& ret,
+                                      size_t len) {
   // try to extract len elements
   ret.reserve(len);
   // loop across segments
@@ -1031,7 +1124,6 @@ std::vector< std::vector<flexible_type> > unity_sframe::iterator_get_next(size_t
         iterator_sframe_ptr->end(iterator_next_segment_id)));
     ++iterator_next_segment_id;
   }
-  return ret;
 }
 
 void unity_sframe::save_as_csv(const std::string& url,
@@ -1124,27 +1216,9 @@ void unity_sframe::save_as_csv(const std::string& url,
 
   if (writer.header) writer.write_verbatim(fout, this->column_names());
 
-  bool first_value = true;
-  auto write_callback = [&writer, &fout, &line_prefix,
-       &no_prefix_on_first_value, &first_value]
-      (size_t segment_id, const std::shared_ptr<sframe_rows>& data) {
-    for (const auto& row : *(data)) {
-      if (!line_prefix.empty()) {
-        if ((!first_value) || // not the first value. write the line prefix
-            (!no_prefix_on_first_value) // first value, write line prefix if
-                                        // no_prefix_on_first_value == false
-                                        // (yes the double negative is annoying)
-            ) {
-          fout.write(line_prefix.c_str(), line_prefix.size());
-        }
-      }
-      first_value = false;
-      writer.write(fout, row);
-    }
-    return false;
-  };
-
-  query_eval::planner().materialize(this->get_planner_node(), write_callback, 1);
+  // rows are formatted in parallel, and written in order
+  sframe sf = query_eval::planner().materialize(this->get_planner_node());
+  write_csv_rows(fout, sf, writer, line_prefix, no_prefix_on_first_value);
   if (!fout.good()) {
     log_and_throw_io_failure("Fail to write.");
   }
@@ -1159,6 +1233,9 @@ std::shared_ptr<unity_sframe_base> unity_sframe::sample(float percent,
   if (percent == 1.0){
     return copy();
   }
+  if (use_block_sampling(percent)) {
+    return take_rows(sample_row_indices(size(), percent, random_seed, exact));
+  }
   auto logical_filter_array = std::static_pointer_cast<unity_sarray>(
     unity_sarray::make_uniform_boolean_array(size(), percent, random_seed, exact));
 
@@ -1174,7 +1251,7 @@ bool unity_sframe::is_materialized() {
   auto optimized_node = optimization_engine::optimize_planner_graph(get_planner_node(),
                                                                     materialize_options());
   if (is_source_node(optimized_node)) {
-    m_planner_node = optimized_node;
+    replace_planner_node(optimized_node);
     return true;
   }
   return false;
@@ -1190,16 +1267,122 @@ std::string unity_sframe::query_plan_string() {
   return ss.str();
 }
 
+std::string unity_sframe::explain_analyze() {
+  materialize_options exec_params;
+  exec_params.profile = std::make_shared<query_eval::query_profile>();
+  query_eval::planner().materialize(m_planner_node, exec_params);
+  return exec_params.profile->to_string();
+}
+
+std::map<std::string, flexible_type> unity_sframe::explain() {
+  return query_eval::explain_query_plan(get_planner_node()).to_map();
+}
+
 std::list<std::shared_ptr<unity_sframe_base>>
 unity_sframe::random_split(float percent, int random_seed, bool exact) {
   log_func_entry();
   logstream(LOG_INFO) << "Args: " << percent << ", " << random_seed << std::endl;
 
+  if (use_block_sampling(percent)) {
+    auto rows = std::make_shared<std::vector<size_t>>(
+        sample_row_indices(size(), percent, random_seed, exact));
+    // the rest still has to be filtered
+    auto seq = std::static_pointer_cast<unity_sarray>(
+        unity_sarray::create_sequential_sarray(size(), 0, false));
+    auto not_picked = seq->transform_lambda(
+        [rows](const flexible_type& val)->flexible_type {
+          return !std::binary_search(rows->begin(), rows->end(),
+                                     (size_t)(val.get<flex_int>()));
+        }, flex_type_enum::INTEGER, false, 0);
+    return {take_rows(*rows), logical_filter(not_picked)};
+  }
+
   auto logical_filter_array = std::static_pointer_cast<unity_sarray>(
     unity_sarray::make_uniform_boolean_array(size(), percent, random_seed, exact));
   return logical_filter_split(logical_filter_array);
 }
 
+bool unity_sframe::use_block_sampling(float percent) {
+  return percent > 0 && percent <= SFRAME_BLOCK_SAMPLE_MAX_FRACTION &&
+         is_materialized();
+}
+
+std::shared_ptr<unity_sframe> unity_sframe::take_rows(const std::vector<size_t>& rows) {
+  auto sframe_ptr = get_underlying_sframe();
+  sframe writer;
+  writer.open_for_write(column_names(), dtype(), std::string(""),
+                        SFRAME_DEFAULT_NUM_SEGMENTS);
+  turi::copy_rows(*sframe_ptr, writer, rows);
+  writer.close();
+  std::shared_ptr<unity_sframe> ret(new unity_sframe());
+  ret->construct_from_sframe(writer);
+  return ret;
+}
+
+void unity_sframe::create_key_index(const std::string& column_name, bool persist) {
+  log_func_entry();
+  size_t column_id = column_index(column_name);
+  auto sframe_ptr = get_underlying_sframe();
+  auto index = sframe_key_index::build(sframe_ptr->select_column(column_id));
+  sframe_key_index::register_index(index);
+  if (!persist) return;
+  std::string index_file = sframe_key_index::index_file(*sframe_ptr, column_id);
+  if (index_file.empty()) {
+    logstream(LOG_INFO) << "SFrame has no index file. The key index of "
+                        << column_name << " is only kept in memory" << std::endl;
+    return;
+  }
+  try {
+    index->save(index_file);
+  } catch (...) {
+    logstream(LOG_WARNING) << "Unable to save the key index of " << column_name
+                           << " to " << sanitize_url(index_file)
+                           << ". It is only kept in memory" << std::endl;
+  }
+}
+
+std::shared_ptr<unity_sframe> unity_sframe::filter_by_key_index(
+    const std::string& column_name,
+    const std::vector<flexible_type>& keys) {
+  if (!is_materialized()) return nullptr;
+  size_t column_id = column_index(column_name);
+  auto index = sframe_key_index::get(*get_underlying_sframe(), column_id);
+  if (!index) return nullptr;
+  return take_rows(index->find_rows(keys));
+}
+
+std::shared_ptr<unity_sframe> unity_sframe::logical_filter_by_key_index(
+    const std::shared_ptr<unity_sarray>& filter_array) {
+  // set by unity_sarray on the result of comparing an array with a constant
+  auto pnode = filter_array->get_planner_node();
+  auto iter = pnode->operator_parameters.find("equals_constant");
+  if (iter == pnode->operator_parameters.end() || pnode->inputs.size() != 1) {
+    return nullptr;
+  }
+  if (!is_materialized()) return nullptr;
+  auto compared = std::make_shared<unity_sarray>();
+  compared->construct_from_planner_node(pnode->inputs[0]);
+  if (!compared->is_materialized()) return nullptr;
+  auto compared_sarray = compared->get_underlying_sarray();
+  if (compared_sarray->get_index_file().empty()) return nullptr;
+  // only keys of the column type are in the index, while == also compares
+  // integers with floats
+  if (iter->second.get_type() != compared_sarray->get_type()) return nullptr;
+
+  auto sframe_ptr = get_underlying_sframe();
+  for (size_t i = 0; i < sframe_ptr->num_columns(); ++i) {
+    if (sframe_ptr->select_column(i)->get_index_file() != compared_sarray->get_index_file()) {
+      continue;
+    }
+    auto index = sframe_key_index::get(*sframe_ptr, i);
+    if (!index) return nullptr;
+    logstream(LOG_INFO) << "Filtering on " << m_column_names[i]
+                        << " with its key index" << std::endl;
+    return take_rows(index->find_rows({iter->second}));
+  }
+  return nullptr;
+}
+
 std::shared_ptr<unity_sframe_base> unity_sframe::groupby_aggregate(
     const std::vector<std::string>& key_columns,
     const std::vector<std::vector<std::string>>& group_columns,
@@ -1248,14 +1431,26 @@ std::shared_ptr<unity_sframe_base> unity_sframe::groupby_aggregate(
     operators.push_back( {column_names, group_operations[i]} );
   }
 
+  // on rows sorted on the keys, the groups are aggregated as a stream, and
+  // come out sorted the same way
+  bool keys_are_sorted = rows_grouped_on(key_columns);
   auto grouped_sf = query_eval::groupby_aggregate(get_planner_node(),
                                                   column_names(),
                                                   key_columns,
                                                   group_output_columns,
-                                                  operators);
+                                                  operators,
+                                                  keys_are_sorted);
 
   std::shared_ptr<unity_sframe> ret(new unity_sframe());
   ret->construct_from_sframe(*grouped_sf);
+  if (keys_are_sorted) {
+    std::vector<size_t> sort_key_indices;
+    for (size_t i = 0; i < key_columns.size(); ++i) {
+      sort_key_indices.push_back(
+          grouped_sf->column_index(m_column_names[m_sort_key_indices[i]]));
+    }
+    ret->set_sorted_on(sort_key_indices);
+  }
   return ret;
 }
 
@@ -1271,8 +1466,8 @@ std::shared_ptr<unity_sframe_base> unity_sframe::join_with_custom_name(
 
   auto sframe_ptr = get_underlying_sframe();
   auto right_sframe_ptr = us_right->get_underlying_sframe();
-  sframe joined_sf = turi::join(*sframe_ptr, *right_sframe_ptr, join_type,
-                                join_keys, alternative_names);
+  sframe joined_sf = query_eval::join(*sframe_ptr, *right_sframe_ptr, join_type,
+                                      join_keys, alternative_names);
   ret->construct_from_sframe(joined_sf);
   return ret;
 }
@@ -1310,6 +1505,37 @@ unity_sframe::sort(const std::vector<std::string>& sort_keys,
                                      b_sort_ascending);
   std::shared_ptr<unity_sframe> ret(new unity_sframe());
   ret->construct_from_sframe(*sorted_sf);
+  ret->set_sorted_on(sort_indices);
+  return ret;
+}
+
+std::shared_ptr<unity_sframe_base>
+unity_sframe::topk(const std::vector<std::string>& sort_keys,
+                   const std::vector<int>& sort_ascending,
+                   size_t k) {
+  log_func_entry();
+
+  if (sort_keys.size() != sort_ascending.size()) {
+    log_and_throw("sframe::topk key vector and ascending vector size mismatch");
+  }
+
+  if (sort_keys.size() == 0) {
+    log_and_throw("sframe::topk, nothing to sort");
+  }
+
+  std::vector<size_t> sort_indices = _convert_column_names_to_indices(sort_keys);
+  std::vector<bool> b_sort_ascending;
+  for(auto sort_order: sort_ascending) {
+    b_sort_ascending.push_back((bool)sort_order);
+  }
+
+  auto top_sf = query_eval::topk(this->get_planner_node(),
+                                 this->column_names(),
+                                 sort_indices,
+                                 b_sort_ascending,
+                                 k);
+  std::shared_ptr<unity_sframe> ret(new unity_sframe());
+  ret->construct_from_sframe(*top_sf);
   return ret;
 }
 
@@ -1340,16 +1566,20 @@ std::shared_ptr<unity_sarray_base> unity_sframe::pack_columns(
   // select packing columns
   auto projected_sf = std::static_pointer_cast<unity_sframe>(this->select_columns(pack_column_names));
 
+  // the keys are shared by every dictionary, instead of copied for each
+  std::vector<flexible_type> keys(key_names.begin(), key_names.end());
+  bool has_fill_na = fill_na.get_type() != flex_type_enum::UNDEFINED;
+  double vector_fill_na = NAN;
+  if (dtype == flex_type_enum::VECTOR && has_fill_na) vector_fill_na = (double)fill_na;
+
   auto dict_transform_callback = [=](const sframe_rows::row& row)->flexible_type{
     flex_dict out_val;
     out_val.reserve(row.size());
     for (size_t col = 0; col < row.size(); col++) {
       if (row[col] != FLEX_UNDEFINED) {
-        out_val.push_back(std::make_pair(key_names[col], row[col]));
-      } else {
-        if (fill_na.get_type() != flex_type_enum::UNDEFINED) {
-          out_val.push_back(std::make_pair(key_names[col], fill_na));
-        }
+        out_val.emplace_back(keys[col], row[col]);
+      } else if (has_fill_na) {
+        out_val.emplace_back(keys[col], fill_na);
       }
     }
     return out_val;
@@ -1373,11 +1603,7 @@ std::shared_ptr<unity_sarray_base> unity_sframe::pack_columns(
       if (!row[col].is_na()) {
         out_val[col] = row[col];
       } else {
-        if (fill_na == FLEX_UNDEFINED) {
-          out_val[col] = NAN;
-        } else {
-          out_val[col] = (double)fill_na;
-        }
+        out_val[col] = vector_fill_na;
       }
     }
     return out_val;
@@ -1475,53 +1701,80 @@ std::shared_ptr<unity_sframe_base> unity_sframe::stack(
   sframe_ptr->open_for_write(ret_column_names, ret_column_types,
                              "", SFRAME_DEFAULT_NUM_SEGMENTS);
   size_t stack_col_idx = column_index(stack_column_name);
+  size_t num_out_columns = num_columns + new_column_count - 1;
 
+  // Every batch is written column by column: the number of output rows of
+  // each input row is counted first, so that the output columns are sized
+  // once, and filled without building an output row at a time.
   auto transform_callback = [&](size_t segment_id,
                                 const std::shared_ptr<sframe_rows>& data) {
-
     auto output_iter = sframe_ptr->get_output_iterator(segment_id);
-    std::vector<flexible_type> out_row_buffer(num_columns + new_column_count - 1);
+    const auto& in_columns = data->cget_columns();
+    size_t num_in_rows = data->num_rows();
+    const auto& stack_values = *(in_columns[stack_col_idx]);
 
-    for (const auto& row: (*data)) {
-      const flexible_type& val = row[stack_col_idx];
+    std::vector<size_t> out_counts(num_in_rows);
+    for (size_t i = 0; i < num_in_rows; ++i) {
+      const flexible_type& val = stack_values[i];
       if (val.get_type() == flex_type_enum::UNDEFINED || val.size() == 0) {
-        if (!drop_na) {
-          if (stack_column_type == flex_type_enum::DICT) {
-            out_row_buffer[num_columns - 1] = FLEX_UNDEFINED;
-            out_row_buffer[num_columns] = FLEX_UNDEFINED;
-          } else {
-            out_row_buffer[num_columns - 1] = FLEX_UNDEFINED;
-          }
-          // copy the rest columns
-          for(size_t i = 0, j = 0; i < num_columns; i++) {
-            if (i != stack_col_idx) {
-              out_row_buffer[j++] = row[i];
-            }
+        out_counts[i] = drop_na ? 0 : 1;
+      } else {
+        out_counts[i] = val.size();
+      }
+    }
+
+    sframe_rows out_rows;
+    // input rows [begin, end) are written at once, in batches of about
+    // DEFAULT_SARRAY_READER_BUFFER_SIZE output rows
+    size_t begin = 0;
+    while (begin < num_in_rows) {
+      size_t end = begin;
+      size_t num_rows_out = 0;
+      while (end < num_in_rows &&
+             (end == begin || num_rows_out + out_counts[end] <= DEFAULT_SARRAY_READER_BUFFER_SIZE)) {
+        num_rows_out += out_counts[end];
+        ++end;
+      }
+      if (num_rows_out > 0) {
+        out_rows.resize(num_out_columns, num_rows_out);
+        auto& out_columns = out_rows.get_columns();
+        // the other columns repeat their value for every stacked value
+        for (size_t c = 0, j = 0; c < num_columns; ++c) {
+          if (c == stack_col_idx) continue;
+          const auto& in_column = *(in_columns[c]);
+          auto out = out_columns[j++]->begin();
+          for (size_t i = begin; i < end; ++i) {
+            out = std::fill_n(out, out_counts[i], in_column[i]);
           }
-          // write to out sframe
-          *output_iter++ = out_row_buffer;
         }
-      } else {
-        for(size_t row_idx = 0; row_idx < val.size(); row_idx++) {
-          if (stack_column_type == flex_type_enum::DICT) {
-            const flex_dict& dict_val = val.get<flex_dict>();
-            out_row_buffer[num_columns - 1] = dict_val[row_idx].first;
-            out_row_buffer[num_columns] = dict_val[row_idx].second;
+        auto& first_out = *(out_columns[num_columns - 1]);
+        size_t k = 0;
+        for (size_t i = begin; i < end; ++i) {
+          if (out_counts[i] == 0) continue;
+          const flexible_type& val = stack_values[i];
+          if (val.get_type() == flex_type_enum::UNDEFINED || val.size() == 0) {
+            first_out[k] = FLEX_UNDEFINED;
+            if (stack_column_type == flex_type_enum::DICT) {
+              (*out_columns[num_columns])[k] = FLEX_UNDEFINED;
+            }
+            ++k;
+          } else if (stack_column_type == flex_type_enum::DICT) {
+            auto& second_out = *(out_columns[num_columns]);
+            for (const auto& kv: val.get<flex_dict>()) {
+              first_out[k] = kv.first;
+              second_out[k] = kv.second;
+              ++k;
+            }
           } else if (stack_column_type == flex_type_enum::LIST) {
-            out_row_buffer[num_columns - 1] = val.array_at(row_idx);
+            for (const auto& v: val.get<flex_list>()) first_out[k++] = v;
           } else {
-            out_row_buffer[num_columns - 1] = val[row_idx];
-          }
-          // copy the rest columns
-          for(size_t i = 0, j = 0; i < num_columns; i++) {
-            if (i != stack_col_idx) {
-              out_row_buffer[j++] = row[i];
-            }
+            for (double v: val.get<flex_vec>()) first_out[k++] = v;
           }
-          // write to out sframe
-          *output_iter++ = out_row_buffer;
         }
+        DASSERT_EQ(k, num_rows_out);
+        *output_iter = out_rows;
       }
+      begin = end;
     }
     return false;
   };
@@ -1550,7 +1803,7 @@ unity_sframe::copy_range(size_t start, size_t step, size_t end) {
     auto current_node = this->get_planner_node();
     auto sliced_node = query_eval::planner().slice(current_node, start, end);
     // slice may partially materialize the node. Save it to avoid repeated materialization
-    m_planner_node = current_node;
+    replace_planner_node(current_node);
     ret->construct_from_planner_node(sliced_node, this->column_names());
     return ret;
   }
@@ -1726,6 +1979,11 @@ dataframe_t unity_sframe::to_dataframe() {
   return ret;
 }
 
+void unity_sframe::export_to_arrow(ArrowSchema* out_schema, ArrowArray* out_array) {
+  log_func_entry();
+  export_sframe_to_arrow(*get_underlying_sframe(), out_schema, out_array);
+}
+
 /**
  * Convert column names to column indices.
  *
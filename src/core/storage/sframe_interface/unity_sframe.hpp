@@ -13,6 +13,7 @@
 #include <core/storage/sframe_interface/unity_sarray.hpp>
 #include <core/storage/sframe_data/group_aggregate_value.hpp>
 #include <core/storage/sframe_data/sframe_rows.hpp>
+#include <core/storage/sframe_data/arrow_interchange.hpp>
 #include <visualization/server/plot.hpp>
 
 namespace turi {
@@ -72,6 +73,14 @@ class unity_sframe : public unity_sframe_base {
    */
   void construct_from_sframe(const sframe& sf);
 
+  /**
+   * Constructs an SFrame from an Arrow struct array (a record batch) given
+   * through the Arrow C data interface, with one column per child of the
+   * struct. The schema and array are released. See \ref
+   * import_sframe_from_arrow() for the supported types.
+   */
+  void construct_from_arrow(ArrowSchema* schema, ArrowArray* array);
+
   /**
    * Constructs an SFrame from an existing directory on disk saved with
    * save_frame() or a on disk sarray prefix (saved with
@@ -304,6 +313,26 @@ class unity_sframe : public unity_sframe_base {
       flex_type_enum type,
       int seed);
 
+  /**
+   * Returns a new sframe, of the same column names, where column i is
+   * computed from column i of this sframe by kernels[i], a batch of rows at
+   * a time, and has type output_types[i]. Columns with an empty kernel are
+   * kept as they are. All the columns are computed in a single pass (see
+   * \ref query_eval::op_columnwise_transform).
+   */
+  std::shared_ptr<unity_sframe> transform_columns(
+      const std::vector<std::function<void(const std::vector<flexible_type>&,
+                                           std::vector<flexible_type>&)>>& kernels,
+      const std::vector<flex_type_enum>& output_types);
+
+  /**
+   * Returns a new sframe where the missing values of every column named in
+   * values are replaced by the value it maps to. Throws if a value is not
+   * convertible to the type of its column.
+   */
+  std::shared_ptr<unity_sframe> fill_missing_values(
+      const std::map<std::string, flexible_type>& values);
+
   /**
    * Returns a new sarray which is a transform of each row in the sframe
    * using a Python lambda function pickled into a string.
@@ -336,6 +365,25 @@ class unity_sframe : public unity_sframe_base {
    */
   std::shared_ptr<sframe> get_underlying_sframe();
 
+  /**
+   * Builds a key index on a column (see \ref sframe_key_index), materializing
+   * the SFrame. Equality filters and filter_by on the column of this SFrame,
+   * and of the SFrames sharing its data, then read only the matching rows.
+   *
+   * If persist is true, and the SFrame is backed by a frame index file, the
+   * index is also saved next to it, to be found when the SFrame is loaded
+   * again.
+   */
+  void create_key_index(const std::string& column_name, bool persist = true);
+
+  /**
+   * Returns the rows holding one of keys in column column_name, using the
+   * key index of the column. Returns nullptr if the SFrame is not
+   * materialized, or the column has no key index.
+   */
+  std::shared_ptr<unity_sframe> filter_by_key_index(const std::string& column_name,
+                                                    const std::vector<flexible_type>& keys);
+
   /**
    * Returns the underlying planner pointer
    */
@@ -411,6 +459,10 @@ class unity_sframe : public unity_sframe_base {
   /**
    * Randomly split the sframe into two parts, with ratio = percent, and  seed = random_seed.
    *
+   * When the sframe is materialized and percent is at most
+   * SFRAME_BLOCK_SAMPLE_MAX_FRACTION, the rows of the first part are picked
+   * up front and read directly, without filtering every row.
+   *
    * Returns a list of size 2 of the unity_sframes resulting from the split.
    */
   std::list<std::shared_ptr<unity_sframe_base>> random_split(float percent, int random_seed, bool exact=false) override;
@@ -418,6 +470,11 @@ class unity_sframe : public unity_sframe_base {
   /**
    * Sample the rows of sframe uniformly with ratio = percent, and seed = random_seed.
    *
+   * When the sframe is materialized and percent is at most
+   * SFRAME_BLOCK_SAMPLE_MAX_FRACTION, the sampled rows are picked up front
+   * (see \ref sample_row_indices()), and only the blocks holding them are
+   * read.
+   *
    * Returns unity_sframe* containing the sampled rows.
    */
   std::shared_ptr<unity_sframe_base> sample(float percent, int random_seed, bool exact=false) override;
@@ -439,6 +496,20 @@ class unity_sframe : public unity_sframe_base {
    */
   std::string query_plan_string() override;
 
+  /**
+   * Materializes the sframe, returning the rows, time and bytes read by
+   * every operator executed, as a tree per stage of the materialization.
+   */
+  std::string explain_analyze() override;
+
+  /**
+   * Explains the query plan without executing it: the plan as built and
+   * after optimization, as text and dot graphs, the optimizations applied,
+   * and the estimated rows and cost of both. See
+   * \ref query_eval::query_plan_explanation::to_map().
+   */
+  std::map<std::string, flexible_type> explain() override;
+
   /**
    * Return true if the sframe size is known.
    */
@@ -485,6 +556,15 @@ class unity_sframe : public unity_sframe_base {
   std::shared_ptr<unity_sframe_base> sort(const std::vector<std::string>& sort_keys,
                           const std::vector<int>& sort_ascending) override;
 
+  /**
+   * Returns the first k rows of the SFrame sorted by sort_keys, the same as the
+   * head of \ref sort, in a single scan instead of a full sort when k is small.
+   * See \ref query_eval::topk.
+   */
+  std::shared_ptr<unity_sframe_base> topk(const std::vector<std::string>& sort_keys,
+                          const std::vector<int>& sort_ascending,
+                          size_t k) override;
+
   /**
     * Pack a subset columns of current SFrame into one dictionary column, using
     * column name as key in the dictionary, and value of the column as value
@@ -570,6 +650,14 @@ class unity_sframe : public unity_sframe_base {
 
   dataframe_t to_dataframe() override;
 
+  /**
+   * Exports the SFrame through the Arrow C data interface, as a struct array
+   * with one child per column. The caller owns the exported structures and
+   * must call their release callbacks. Materializes the SFrame. See \ref
+   * export_sframe_to_arrow() for the supported types.
+   */
+  void export_to_arrow(ArrowSchema* out_schema, ArrowArray* out_array);
+
   void save(oarchive& oarc) const override;
 
   void load(iarchive& iarc) override;
@@ -603,6 +691,41 @@ class unity_sframe : public unity_sframe_base {
 
   std::shared_ptr<sframe> m_cached_sframe;
 
+  /**
+   * The indices of the columns the rows are known to be sorted on, most
+   * significant first. Only valid while m_planner_node is still
+   * m_sorted_planner_node: any change to the columns drops it.
+   */
+  std::vector<size_t> m_sort_key_indices;
+  std::weak_ptr<query_eval::planner_node> m_sorted_planner_node;
+
+  /// Replaces m_planner_node with a node producing the same rows
+  void replace_planner_node(const std::shared_ptr<query_eval::planner_node>& node);
+
+  /// Records that the rows are sorted on the columns sort_key_indices
+  void set_sorted_on(const std::vector<size_t>& sort_key_indices);
+
+  /**
+   * Returns true if the rows of every distinct value of key_columns are
+   * known to be contiguous, i.e. key_columns are the leading columns the
+   * rows are sorted on, in any order.
+   */
+  bool rows_grouped_on(const std::vector<std::string>& key_columns);
+
+  /// Whether sample() and random_split() of percent of the rows pick rows up front
+  bool use_block_sampling(float percent);
+
+  /// Returns the rows at the given positions, in increasing order
+  std::shared_ptr<unity_sframe> take_rows(const std::vector<size_t>& rows);
+
+  /**
+   * If filter_array compares a column of this SFrame with a constant, and
+   * the column has a key index, returns the filtered rows. Returns nullptr
+   * otherwise.
+   */
+  std::shared_ptr<unity_sframe> logical_filter_by_key_index(
+      const std::shared_ptr<unity_sarray>& filter_array);
+
   /**
    * Supports \ref begin_iterator() and \ref iterator_get_next().
    * The next segment I will read. (i.e. the current segment I am reading
@@ -628,6 +751,17 @@ class unity_sframe : public unity_sframe_base {
    */
   std::unique_ptr<sframe_iterator> iterator_current_segment_enditer;
 
+  /**
+   * Supports \ref begin_iterator() and \ref iterator_get_next().
+   * Reads the rows ahead of iterator_get_next() with
+   * \ref iterator_read_next(). Declared last, to stop before the readers are
+   * destroyed.
+   */
+  std::unique_ptr<batch_prefetcher<std::vector<flexible_type>>> iterator_prefetcher;
+
+  /// Appends the next len rows of the iterator to ret
+  void iterator_read_next(std::vector<std::vector<flexible_type>>& ret, size_t len);
+
 
  private:
   // Helper functions
@@ -10,7 +10,7 @@
 #include <core/parallel/lambda_omp.hpp>
 #include <core/storage/sgraph_data/hilbert_curve.hpp>
 #include <core/storage/sgraph_data/sgraph_constants.hpp>
-#include <core/util/blocking_queue.hpp>
+#include <core/generics/lock_free_ring_queue.hpp>
 
 namespace turi {
 
@@ -74,19 +74,19 @@ inline void hilbert_parallel_for(size_t n,
                                  std::function<void(std::vector<std::pair<size_t, size_t> >) > preamble,
                                  std::function<void(std::pair<size_t, size_t>)> fn) {
 
-  blocking_queue<std::pair<size_t, size_t> > coordinates_queue;
+  lock_free_ring_queue<std::pair<size_t, size_t> > coordinates_queue(n*n);
   std::vector<std::pair<size_t, size_t> > coordinates;
   for (size_t i = 0;i < n*n; i ++) {
     auto coord = hilbert_index_to_coordinate(i, n);
-    coordinates_queue.enqueue(coord);
+    ASSERT_TRUE(coordinates_queue.try_enqueue(coord));
     coordinates.push_back(coord);
   }
   preamble(coordinates);
 
   parallel_for(0, n*n, [&](size_t i) {
-    auto coord_success_pair = coordinates_queue.dequeue();
-    ASSERT_TRUE(coord_success_pair.second);
-    fn(coord_success_pair.first);
+    std::pair<size_t, size_t> coord;
+    ASSERT_TRUE(coordinates_queue.try_dequeue(coord));
+    fn(coord);
   });
 }
 
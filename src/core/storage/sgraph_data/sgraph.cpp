@@ -10,6 +10,7 @@
 #include <core/storage/sframe_data/sarray_sorted_buffer.hpp>
 #include <core/storage/sframe_data/sarray_reader_buffer.hpp>
 #include <core/storage/sframe_data/sframe_saving.hpp>
+#include <core/storage/sframe_data/sframe_compact.hpp>
 #include <atomic>
 #include <core/system/platform/timer//timer.hpp>
 #include <sparsehash/sparse_hash_set>
@@ -41,6 +42,31 @@ const char* sgraph::SRC_COLUMN_NAME = "__src_id";
 const char* sgraph::DST_COLUMN_NAME = "__dst_id";
 const flex_type_enum sgraph::INTERNAL_ID_TYPE = flex_type_enum::INTEGER;
 
+namespace {
+
+/// The largest number of segments of a column of sf
+size_t max_column_segments(const sframe& sf) {
+  size_t ret = 0;
+  for (size_t i = 0; i < sf.num_columns(); ++i) {
+    ret = std::max(ret, sf.select_column(i)->num_segments());
+  }
+  return ret;
+}
+
+/**
+ * Appends a delta to a partition without compacting it, unless the
+ * partition then has more than SGRAPH_DELTA_MAX_SEGMENTS segments.
+ */
+sframe append_delta(const sframe& partition, const sframe& delta) {
+  sframe ret = partition.append(delta, false /* compact */);
+  if (max_column_segments(ret) > SGRAPH_DELTA_MAX_SEGMENTS) {
+    sframe_compact(ret, SFRAME_COMPACTION_THRESHOLD);
+  }
+  return ret;
+}
+
+} // end of anonymous namespace
+
 /**************************************************************************/
 /*                                                                        */
 /*                              Constructors                              */
@@ -768,7 +794,7 @@ void sgraph::commit_edge_buffer(size_t groupa,
 
     sframe& old_vertices = vertex_partition(partitionid, groupid);
     ASSERT_TRUE(union_columns(old_vertices, new_vertices));
-    old_vertices = old_vertices.append(new_vertices);
+    old_vertices = append_delta(old_vertices, new_vertices);
 
     // debug print
     // std::cerr << "New vertices in partition " << i << ":\n";
@@ -883,7 +909,7 @@ void sgraph::commit_edge_buffer(size_t groupa,
         ASSERT_TRUE(union_columns(old_edges, normalized_edges));
 
         size_t prev_size = old_edges.num_rows();
-        old_edges = old_edges.append(normalized_edges);
+        old_edges = append_delta(old_edges, normalized_edges);
         edges_added += (old_edges.num_rows() - prev_size);
       });
 
@@ -896,6 +922,53 @@ void sgraph::commit_edge_buffer(size_t groupa,
   m_num_vertices += vertices_added;
 }
 
+sgraph::delta_watermark sgraph::get_delta_watermark() const {
+  delta_watermark ret;
+  for (size_t i = 0; i < m_num_partitions; ++i) {
+    ret.vertex_partition_sizes.push_back(vertex_partition(i).num_rows());
+  }
+  for (size_t i = 0; i < m_num_partitions; ++i) {
+    for (size_t j = 0; j < m_num_partitions; ++j) {
+      ret.edge_partition_sizes.push_back(edge_partition(i, j).num_rows());
+    }
+  }
+  return ret;
+}
+
+void sgraph::validate_delta_watermark(const delta_watermark& watermark) const {
+  if (watermark.vertex_partition_sizes.size() != m_num_partitions ||
+      watermark.edge_partition_sizes.size() != m_num_partitions * m_num_partitions) {
+    log_and_throw("Watermark does not match the number of partitions of the graph");
+  }
+  for (size_t i = 0; i < m_num_partitions; ++i) {
+    if (vertex_partition(i).num_rows() < watermark.vertex_partition_sizes[i]) {
+      log_and_throw("Graph has fewer vertices than the watermark");
+    }
+    for (size_t j = 0; j < m_num_partitions; ++j) {
+      size_t k = i * m_num_partitions + j;
+      if (edge_partition(i, j).num_rows() < watermark.edge_partition_sizes[k]) {
+        log_and_throw("Graph has fewer edges than the watermark");
+      }
+    }
+  }
+}
+
+void sgraph::compact(size_t segment_threshold) {
+  std::vector<sframe*> partitions;
+  for (auto& group : m_vertex_groups) {
+    for (auto& sf : group) partitions.push_back(&sf);
+  }
+  for (auto& kv : m_edge_groups) {
+    for (auto& sf : kv.second) partitions.push_back(&sf);
+  }
+  // copies of the graph share the columns, so compact into new ones
+  parallel_for(0, partitions.size(), [&](size_t i) {
+    if (max_column_segments(*partitions[i]) > segment_threshold) {
+      *partitions[i] = sframe_compacted_copy(*partitions[i], segment_threshold);
+    }
+  });
+}
+
 bool sgraph::copy_vertex_field(const std::string& field,
                                const std::string& new_field,
                                size_t group) {
@@ -502,6 +502,52 @@ class sgraph {
 
   inline flex_type_enum vertex_id_type() const { return m_vid_type; }
 
+/**************************************************************************/
+/*                                                                        */
+/*                          Incremental Updates                           */
+/*                                                                        */
+/**************************************************************************/
+  /**
+   * The number of rows of every vertex and edge partition of the default
+   * group at some point in time.
+   *
+   * add_vertices() and add_edges() only ever append rows to a partition: new
+   * vertices go at the end of their partition and existing vertices keep
+   * their row. So the rows past a watermark are exactly the vertices and
+   * edges added since, and analytics can update their results from those
+   * rows alone (see sgraph_compute::delta_edge_apply()) instead of from the
+   * whole graph. Changing fields or compacting keeps a watermark valid.
+   */
+  struct delta_watermark {
+    /// Rows of vertex partition p
+    std::vector<size_t> vertex_partition_sizes;
+    /// Rows of edge partition (i, j), at i * num_partitions + j
+    std::vector<size_t> edge_partition_sizes;
+  };
+
+  /**
+   * Returns the current watermark of the default group.
+   */
+  delta_watermark get_delta_watermark() const;
+
+  /**
+   * Throws if the graph could not have grown from watermark by appending
+   * rows: it has a different number of partitions or a partition shrank.
+   */
+  void validate_delta_watermark(const delta_watermark& watermark) const;
+
+  /**
+   * Compacts every vertex and edge partition with more than
+   * segment_threshold segments.
+   *
+   * add_vertices() and add_edges() append new segments to the partitions
+   * without compacting them, until a partition has more than
+   * \ref SGRAPH_DELTA_MAX_SEGMENTS segments, so that frequent small updates
+   * do not rewrite the partitions each time. Call this once a batch of
+   * updates is done to merge them.
+   */
+  void compact(size_t segment_threshold = SFRAME_COMPACTION_THRESHOLD);
+
 /**************************************************************************/
 /*                                                                        */
 /*                             Serialization                              */
@@ -17,6 +17,11 @@ EXPORT size_t SGRAPH_TRIPLE_APPLY_EDGE_BATCH_SIZE = 1024;
 EXPORT size_t SGRAPH_DEFAULT_NUM_PARTITIONS = 8;
 EXPORT size_t SGRAPH_INGRESS_VID_BUFFER_SIZE = 1024 * 1024 * 1;
 EXPORT size_t SGRAPH_HILBERT_CURVE_PARALLEL_FOR_NUM_THREADS = thread::cpu_count();
+EXPORT size_t SGRAPH_CSR_SNAPSHOT_MAX_MEMORY = size_t(16) * 1024 * 1024 * 1024;
+EXPORT size_t SGRAPH_FRONTIER_PULL_RATIO = 20;
+EXPORT size_t SGRAPH_DELTA_MAX_SEGMENTS = 1024;
+EXPORT size_t SGRAPH_MAX_VERTICES_PER_PARTITION = size_t(64) * 1024 * 1024;
+EXPORT size_t SGRAPH_ENGINE_MAX_RESIDENT_BLOCKS = 64;
 
 REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             SGRAPH_TRIPLE_APPLY_LOCK_ARRAY_SIZE,
@@ -49,4 +54,29 @@ REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             SGRAPH_HILBERT_CURVE_PARALLEL_FOR_NUM_THREADS,
                             true,
                             +[](int64_t val){ return val >= 1; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SGRAPH_CSR_SNAPSHOT_MAX_MEMORY,
+                            true,
+                            +[](int64_t val){ return val >= 0; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SGRAPH_FRONTIER_PULL_RATIO,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SGRAPH_DELTA_MAX_SEGMENTS,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SGRAPH_MAX_VERTICES_PER_PARTITION,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SGRAPH_ENGINE_MAX_RESIDENT_BLOCKS,
+                            true,
+                            +[](int64_t val){ return val >= 3; });
 }
@@ -48,6 +48,45 @@ extern size_t SGRAPH_INGRESS_VID_BUFFER_SIZE;
  * Number of threads used for hilber curve parallel for
  */
 extern size_t SGRAPH_HILBERT_CURVE_PARALLEL_FOR_NUM_THREADS;
+
+/**
+ * Maximum memory, in bytes, of an in memory CSR snapshot of a graph (see
+ * sgraph_compute::csr_snapshot). Graph toolkits fall back to out of core
+ * triple apply for larger graphs.
+ */
+extern size_t SGRAPH_CSR_SNAPSHOT_MAX_MEMORY;
+
+/**
+ * A frontier of changed vertices is expanded by pushing along their edges
+ * while they have less than 1 / SGRAPH_FRONTIER_PULL_RATIO of the edges of
+ * the graph, and by pulling over all the edges otherwise (see
+ * sgraph_compute::expand_frontier).
+ */
+extern size_t SGRAPH_FRONTIER_PULL_RATIO;
+
+/**
+ * Edges and vertices added to a graph are appended to its partitions as new
+ * segments, without compacting them. A partition is only compacted (down to
+ * SFRAME_COMPACTION_THRESHOLD segments) once it has more than
+ * SGRAPH_DELTA_MAX_SEGMENTS segments, or by sgraph::compact().
+ */
+extern size_t SGRAPH_DELTA_MAX_SEGMENTS;
+
+/**
+ * The most vertices a vertex partition should have. Bounds the number of
+ * partitions sgraph_compute::suggest_num_partitions() can merge the graph
+ * into, so that the vertex partitions loaded together still fit in memory.
+ */
+extern size_t SGRAPH_MAX_VERTICES_PER_PARTITION;
+
+/**
+ * The most blocks (vertex partitions, and partitions of gather results)
+ * sgraph_compute::sgraph_engine holds in memory at once. Blocks stay in
+ * memory between passes over the edge partitions until this bound forces the
+ * least recently used ones out, and a pass runs fewer edge partitions in
+ * parallel rather than load more blocks than this.
+ */
+extern size_t SGRAPH_ENGINE_MAX_RESIDENT_BLOCKS;
 }
 
 /// \}
@@ -0,0 +1,218 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <core/storage/sgraph_data/sgraph_csr.hpp>
+#include <core/storage/sgraph_data/sgraph_constants.hpp>
+#include <core/storage/sframe_data/sarray_reader.hpp>
+#include <core/parallel/atomic_ops.hpp>
+#include <core/parallel/lambda_omp.hpp>
+#include <core/logging/logger.hpp>
+#include <core/system/platform/timer/timer.hpp>
+
+namespace turi {
+namespace sgraph_compute {
+
+namespace {
+
+/// Number of edges read at once by a thread
+const size_t CSR_EDGE_BATCH_SIZE = 64 * 1024;
+
+/**
+ * Reads the edges of every edge partition of g in batches, in parallel,
+ * calling fn(src, dst, weights, n) with the vertex ids of n edges, and
+ * their weights if weight_field is not empty (nullptr otherwise).
+ */
+template <typename Fn>
+void for_each_edge_batch(const sgraph& g,
+                         const std::vector<size_t>& partition_offsets,
+                         const std::string& weight_field,
+                         Fn fn) {
+  std::vector<std::string> fields{sgraph::SRC_COLUMN_NAME, sgraph::DST_COLUMN_NAME};
+  if (!weight_field.empty()) fields.push_back(weight_field);
+  size_t nparts = g.get_num_partitions();
+  for (size_t i = 0; i < nparts; ++i) {
+    for (size_t j = 0; j < nparts; ++j) {
+      sframe edges = g.edge_partition(i, j);
+      if (edges.num_rows() == 0) continue;
+      edges = edges.select_columns(fields);
+      std::vector<std::shared_ptr<sarray_reader<flexible_type>>> readers;
+      for (size_t c = 0; c < fields.size(); ++c) {
+        readers.emplace_back(edges.select_column(c)->get_reader());
+      }
+      const size_t src_offset = partition_offsets[i];
+      const size_t dst_offset = partition_offsets[j];
+      const size_t nrows = edges.num_rows();
+      in_parallel([&](size_t thread_id, size_t num_threads) {
+        size_t row_start = nrows * thread_id / num_threads;
+        size_t row_end = nrows * (thread_id + 1) / num_threads;
+        std::vector<flex_int> src(CSR_EDGE_BATCH_SIZE), dst(CSR_EDGE_BATCH_SIZE);
+        std::vector<csr_snapshot::vertex_id_type> src_ids(CSR_EDGE_BATCH_SIZE);
+        std::vector<csr_snapshot::vertex_id_type> dst_ids(CSR_EDGE_BATCH_SIZE);
+        std::vector<flex_float> weights(readers.size() > 2 ? CSR_EDGE_BATCH_SIZE : 0);
+        while (row_start < row_end) {
+          size_t n = std::min(CSR_EDGE_BATCH_SIZE, row_end - row_start);
+          readers[0]->read_rows_as(row_start, row_start + n, src.data(), 0);
+          readers[1]->read_rows_as(row_start, row_start + n, dst.data(), 0);
+          if (readers.size() > 2) {
+            readers[2]->read_rows_as(row_start, row_start + n, weights.data(), 1.0);
+          }
+          for (size_t k = 0; k < n; ++k) {
+            src_ids[k] = src_offset + src[k];
+            dst_ids[k] = dst_offset + dst[k];
+          }
+          fn(src_ids.data(), dst_ids.data(),
+             weights.empty() ? nullptr : weights.data(), n);
+          row_start += n;
+        }
+      });
+    }
+  }
+}
+
+/// Turns counts, shifted by one, into offsets
+void prefix_sum(std::vector<size_t>& offsets) {
+  for (size_t i = 1; i < offsets.size(); ++i) offsets[i] += offsets[i - 1];
+}
+
+/// Sorts the neighbors of every vertex by id, keeping weights alongside
+void sort_neighbors(const std::vector<size_t>& offsets,
+                    std::vector<csr_snapshot::vertex_id_type>& ids,
+                    std::vector<double>& weights) {
+  if (offsets.size() < 2) return;
+  parallel_for(0, offsets.size() - 1, [&](size_t v) {
+    auto begin = ids.begin() + offsets[v];
+    auto end = ids.begin() + offsets[v + 1];
+    if (std::is_sorted(begin, end)) return;
+    if (weights.empty()) {
+      std::sort(begin, end);
+      return;
+    }
+    std::vector<std::pair<csr_snapshot::vertex_id_type, double>> edges;
+    edges.reserve(end - begin);
+    for (size_t e = offsets[v]; e < offsets[v + 1]; ++e) {
+      edges.emplace_back(ids[e], weights[e]);
+    }
+    std::sort(edges.begin(), edges.end());
+    for (size_t k = 0; k < edges.size(); ++k) {
+      ids[offsets[v] + k] = edges[k].first;
+      weights[offsets[v] + k] = edges[k].second;
+    }
+  });
+}
+
+} // end of anonymous namespace
+
+csr_snapshot::csr_snapshot(const sgraph& g,
+                           csr_direction direction,
+                           const std::string& weight_field) {
+  if (g.get_num_groups() != 1) {
+    log_and_throw("CSR snapshots of graphs with vertex groups are not supported");
+  }
+  if (!weight_field.empty()) {
+    auto fields = g.get_edge_fields();
+    auto field = std::find(fields.begin(), fields.end(), weight_field);
+    if (field == fields.end()) {
+      log_and_throw("Cannot find edge field: " + weight_field);
+    }
+    flex_type_enum weight_type = g.get_edge_field_types()[field - fields.begin()];
+    if (weight_type != flex_type_enum::INTEGER && weight_type != flex_type_enum::FLOAT) {
+      log_and_throw("Edge field " + weight_field + " must be numeric to be used as weights");
+    }
+  }
+  timer ti;
+  size_t nparts = g.get_num_partitions();
+  m_partition_offsets.resize(nparts + 1, 0);
+  for (size_t i = 0; i < nparts; ++i) {
+    m_partition_offsets[i + 1] = m_partition_offsets[i] + g.vertex_partition(i).num_rows();
+  }
+  m_num_vertices = m_partition_offsets[nparts];
+  if (m_num_vertices > std::numeric_limits<vertex_id_type>::max()) {
+    log_and_throw("Too many vertices for a CSR snapshot: " + std::to_string(m_num_vertices));
+  }
+  m_weighted = !weight_field.empty();
+  bool build_in = ((int)direction & (int)csr_direction::IN) != 0;
+  bool build_out = ((int)direction & (int)csr_direction::OUT) != 0;
+
+  // count the degrees
+  m_out_offsets.assign(m_num_vertices + 1, 0);
+  m_in_offsets.assign(m_num_vertices + 1, 0);
+  for_each_edge_batch(g, m_partition_offsets, "",
+                      [&](const vertex_id_type* src, const vertex_id_type* dst,
+                          const double*, size_t n) {
+    for (size_t k = 0; k < n; ++k) {
+      atomic_increment(m_out_offsets[src[k] + 1]);
+      atomic_increment(m_in_offsets[dst[k] + 1]);
+    }
+  });
+  prefix_sum(m_out_offsets);
+  prefix_sum(m_in_offsets);
+  m_num_edges = m_out_offsets[m_num_vertices];
+  if (!build_in && !build_out) return;
+
+  // place the edges
+  if (build_out) {
+    m_out_targets.resize(m_num_edges);
+    if (m_weighted) m_out_weights.resize(m_num_edges);
+  }
+  if (build_in) {
+    m_in_sources.resize(m_num_edges);
+    if (m_weighted) m_in_weights.resize(m_num_edges);
+  }
+  std::vector<size_t> out_cursor, in_cursor;
+  if (build_out) out_cursor.assign(m_out_offsets.begin(), m_out_offsets.end() - 1);
+  if (build_in) in_cursor.assign(m_in_offsets.begin(), m_in_offsets.end() - 1);
+  for_each_edge_batch(g, m_partition_offsets, weight_field,
+                      [&](const vertex_id_type* src, const vertex_id_type* dst,
+                          const double* weights, size_t n) {
+    for (size_t k = 0; k < n; ++k) {
+      if (build_out) {
+        size_t pos = atomic_increment(out_cursor[src[k]]);
+        m_out_targets[pos] = dst[k];
+        if (weights) m_out_weights[pos] = weights[k];
+      }
+      if (build_in) {
+        size_t pos = atomic_increment(in_cursor[dst[k]]);
+        m_in_sources[pos] = src[k];
+        if (weights) m_in_weights[pos] = weights[k];
+      }
+    }
+  });
+  if (build_out) sort_neighbors(m_out_offsets, m_out_targets, m_out_weights);
+  if (build_in) sort_neighbors(m_in_offsets, m_in_sources, m_in_weights);
+
+  logstream(LOG_INFO) << "Built CSR snapshot of " << m_num_vertices << " vertices and "
+                      << m_num_edges << " edges in " << ti.current_time()
+                      << " secs" << std::endl;
+}
+
+size_t csr_snapshot::estimate_memory(const sgraph& g,
+                                     csr_direction direction,
+                                     bool weighted) {
+  size_t nvertices = g.num_vertices();
+  size_t nedges = g.num_edges();
+  size_t ndirections = (direction == csr_direction::BOTH) ? 2 : 1;
+  size_t edge_bytes = sizeof(vertex_id_type) + (weighted ? sizeof(double) : 0);
+  return 2 * (nvertices + 1) * sizeof(size_t) + ndirections * nedges * edge_bytes;
+}
+
+bool csr_snapshot::fits_in_memory(const sgraph& g,
+                                  csr_direction direction,
+                                  bool weighted) {
+  return g.get_num_groups() == 1 &&
+      g.num_vertices() <= std::numeric_limits<vertex_id_type>::max() &&
+      estimate_memory(g, direction, weighted) <= SGRAPH_CSR_SNAPSHOT_MAX_MEMORY;
+}
+
+vertex_address csr_snapshot::address(vertex_id_type vid) const {
+  DASSERT_LT(vid, m_num_vertices);
+  auto iter = std::upper_bound(m_partition_offsets.begin(),
+                               m_partition_offsets.end(), (size_t)vid);
+  size_t partition = (iter - m_partition_offsets.begin()) - 1;
+  return {partition, vid - m_partition_offsets[partition]};
+}
+
+} // end of sgraph_compute
+} // end of turi
@@ -0,0 +1,186 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SGRAPH_SGRAPH_CSR_HPP
+#define TURI_SGRAPH_SGRAPH_CSR_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <core/storage/sgraph_data/sgraph.hpp>
+#include <core/storage/sgraph_data/sgraph_fast_triple_apply.hpp>
+
+namespace turi {
+
+/**
+ * \ingroup sgraph_physical
+ * \addtogroup sgraph_compute SGraph Compute
+ * \{
+ */
+
+/**
+ * Graph Computation Functions
+ */
+namespace sgraph_compute {
+
+/**
+ * The edge directions stored by a \ref csr_snapshot.
+ */
+enum class csr_direction {
+  IN = 1,   ///< in edges of every vertex (CSC)
+  OUT = 2,  ///< out edges of every vertex (CSR)
+  BOTH = 3
+};
+
+/**
+ * An in memory, read only snapshot of the structure of an \ref sgraph in
+ * compressed sparse row form, for iterative algorithms which visit every
+ * edge many times. Building it reads the edge partitions once; afterwards
+ * an iteration is a pass over flat arrays, with no block decoding, no
+ * flexible_type and no vertex locks (see \ref fast_triple_apply for the
+ * out of core alternative).
+ *
+ * The vertices of the graph are numbered contiguously, partition by
+ * partition: vertex local_id of partition p is
+ * partition_begin(p) + local_id, so that vertex data indexed by vertex id
+ * is laid out as the concatenation of the vertex partitions. Vertex ids
+ * are 32 bits, so the graph must have fewer than 2^32 vertices.
+ *
+ * The neighbors of every vertex are sorted by vertex id. Edge weights,
+ * if requested, are stored as doubles alongside (missing weights read as
+ * 1.0).
+ *
+ * Only graphs with a single vertex group are supported.
+ *
+ * \code
+ * if (csr_snapshot::fits_in_memory(g, csr_direction::IN)) {
+ *   csr_snapshot csr(g, csr_direction::IN);
+ *   parallel_for(0, csr.num_vertices(), [&](size_t v) {
+ *     for (auto u = csr.in_begin(v); u != csr.in_end(v); ++u) ...
+ *   });
+ * }
+ * \endcode
+ */
+class csr_snapshot {
+ public:
+  typedef uint32_t vertex_id_type;
+
+  csr_snapshot() = default;
+
+  /**
+   * Builds the snapshot of g.
+   *
+   * \param direction The edge directions to store. The in and out degrees
+   * of every vertex are available either way.
+   * \param weight_field If not empty, the numeric edge field to store as
+   * edge weights.
+   */
+  csr_snapshot(const sgraph& g,
+               csr_direction direction = csr_direction::BOTH,
+               const std::string& weight_field = "");
+
+  /// An estimate of the memory, in bytes, a snapshot of g would take.
+  static size_t estimate_memory(const sgraph& g,
+                                csr_direction direction = csr_direction::BOTH,
+                                bool weighted = false);
+
+  /**
+   * True if a snapshot of g would take at most
+   * \ref SGRAPH_CSR_SNAPSHOT_MAX_MEMORY bytes and has few enough vertices.
+   */
+  static bool fits_in_memory(const sgraph& g,
+                             csr_direction direction = csr_direction::BOTH,
+                             bool weighted = false);
+
+  inline size_t num_vertices() const { return m_num_vertices; }
+  inline size_t num_edges() const { return m_num_edges; }
+  inline size_t num_partitions() const {
+    return m_partition_offsets.empty() ? 0 : m_partition_offsets.size() - 1;
+  }
+  inline bool has_in_edges() const { return !m_in_sources.empty() || m_num_edges == 0; }
+  inline bool has_out_edges() const { return !m_out_targets.empty() || m_num_edges == 0; }
+  inline bool has_weights() const { return m_weighted; }
+
+  /// The id of the first vertex of a vertex partition
+  inline size_t partition_begin(size_t partition) const {
+    return m_partition_offsets[partition];
+  }
+
+  /// The id of vertex local_id of a vertex partition
+  inline vertex_id_type vertex_id(size_t partition, size_t local_id) const {
+    return m_partition_offsets[partition] + local_id;
+  }
+
+  /// The partition and local id of a vertex
+  vertex_address address(vertex_id_type vid) const;
+
+  inline size_t out_degree(vertex_id_type vid) const {
+    return m_out_offsets[vid + 1] - m_out_offsets[vid];
+  }
+  inline size_t in_degree(vertex_id_type vid) const {
+    return m_in_offsets[vid + 1] - m_in_offsets[vid];
+  }
+
+  /// The targets of the out edges of a vertex. Requires has_out_edges().
+  inline const vertex_id_type* out_begin(vertex_id_type vid) const {
+    return m_out_targets.data() + m_out_offsets[vid];
+  }
+  inline const vertex_id_type* out_end(vertex_id_type vid) const {
+    return m_out_targets.data() + m_out_offsets[vid + 1];
+  }
+  /// The weights of the out edges of a vertex, in the order of out_begin().
+  inline const double* out_weights(vertex_id_type vid) const {
+    return m_out_weights.data() + m_out_offsets[vid];
+  }
+
+  /// The sources of the in edges of a vertex. Requires has_in_edges().
+  inline const vertex_id_type* in_begin(vertex_id_type vid) const {
+    return m_in_sources.data() + m_in_offsets[vid];
+  }
+  inline const vertex_id_type* in_end(vertex_id_type vid) const {
+    return m_in_sources.data() + m_in_offsets[vid + 1];
+  }
+  /// The weights of the in edges of a vertex, in the order of in_begin().
+  inline const double* in_weights(vertex_id_type vid) const {
+    return m_in_weights.data() + m_in_offsets[vid];
+  }
+
+  /**
+   * Splits values indexed by vertex id into one vector per vertex partition,
+   * as \ref sgraph::add_vertex_field() takes them.
+   */
+  template <typename T>
+  std::vector<std::vector<T>> split_by_partition(const std::vector<T>& values) const {
+    ASSERT_EQ(values.size(), m_num_vertices);
+    std::vector<std::vector<T>> ret(num_partitions());
+    for (size_t i = 0; i < ret.size(); ++i) {
+      ret[i].assign(values.begin() + m_partition_offsets[i],
+                    values.begin() + m_partition_offsets[i + 1]);
+    }
+    return ret;
+  }
+
+ private:
+  size_t m_num_vertices = 0;
+  size_t m_num_edges = 0;
+  bool m_weighted = false;
+  /// m_partition_offsets[p] is the id of the first vertex of partition p
+  std::vector<size_t> m_partition_offsets;
+  /// The out edges of vertex v are [m_out_offsets[v], m_out_offsets[v + 1])
+  std::vector<size_t> m_out_offsets;
+  std::vector<vertex_id_type> m_out_targets;
+  std::vector<double> m_out_weights;
+  /// The in edges of vertex v are [m_in_offsets[v], m_in_offsets[v + 1])
+  std::vector<size_t> m_in_offsets;
+  std::vector<vertex_id_type> m_in_sources;
+  std::vector<double> m_in_weights;
+};
+
+} // end of sgraph_compute
+
+/// \}
+} // end of turi
+
+#endif
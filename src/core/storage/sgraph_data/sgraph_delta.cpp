@@ -0,0 +1,64 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <core/storage/sgraph_data/sgraph_delta.hpp>
+#include <core/storage/sframe_data/sarray_reader.hpp>
+#include <core/parallel/lambda_omp.hpp>
+
+namespace turi {
+namespace sgraph_compute {
+
+namespace {
+
+/// Number of edges read at once by a thread
+const size_t DELTA_EDGE_BATCH_SIZE = 64 * 1024;
+
+} // end of anonymous namespace
+
+void delta_edge_apply(const sgraph& g,
+                      const sgraph::delta_watermark& since,
+                      delta_edge_apply_fn_type fn) {
+  g.validate_delta_watermark(since);
+  size_t nparts = g.get_num_partitions();
+  for (size_t i = 0; i < nparts; ++i) {
+    for (size_t j = 0; j < nparts; ++j) {
+      const sframe& edges = g.edge_partition(i, j);
+      const size_t begin = since.edge_partition_sizes[i * nparts + j];
+      const size_t end = edges.num_rows();
+      if (begin == end) continue;
+      auto src_reader = edges.select_column(sgraph::SRC_COLUMN_NAME)->get_reader();
+      auto dst_reader = edges.select_column(sgraph::DST_COLUMN_NAME)->get_reader();
+      in_parallel([&](size_t thread_id, size_t num_threads) {
+        size_t row_start = begin + (end - begin) * thread_id / num_threads;
+        size_t row_end = begin + (end - begin) * (thread_id + 1) / num_threads;
+        std::vector<flex_int> src(DELTA_EDGE_BATCH_SIZE), dst(DELTA_EDGE_BATCH_SIZE);
+        while (row_start < row_end) {
+          size_t n = std::min(DELTA_EDGE_BATCH_SIZE, row_end - row_start);
+          src_reader->read_rows_as(row_start, row_start + n, src.data(), 0);
+          dst_reader->read_rows_as(row_start, row_start + n, dst.data(), 0);
+          for (size_t k = 0; k < n; ++k) {
+            fn(vertex_address{i, (size_t)src[k]}, vertex_address{j, (size_t)dst[k]});
+          }
+          row_start += n;
+        }
+      });
+    }
+  }
+}
+
+size_t num_edges_since(const sgraph& g, const sgraph::delta_watermark& since) {
+  g.validate_delta_watermark(since);
+  size_t nparts = g.get_num_partitions();
+  size_t ret = 0;
+  for (size_t i = 0; i < nparts; ++i) {
+    for (size_t j = 0; j < nparts; ++j) {
+      ret += g.edge_partition(i, j).num_rows() - since.edge_partition_sizes[i * nparts + j];
+    }
+  }
+  return ret;
+}
+
+} // end of sgraph_compute
+} // end of turi
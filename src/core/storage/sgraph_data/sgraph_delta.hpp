@@ -0,0 +1,59 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SGRAPH_SGRAPH_DELTA_HPP
+#define TURI_SGRAPH_SGRAPH_DELTA_HPP
+
+#include <functional>
+#include <core/storage/sgraph_data/sgraph.hpp>
+#include <core/storage/sgraph_data/sgraph_fast_triple_apply.hpp>
+
+namespace turi {
+
+/**
+ * \ingroup sgraph_physical
+ * \addtogroup sgraph_compute SGraph Compute
+ * \{
+ */
+
+/**
+ * Graph Computation Functions
+ */
+namespace sgraph_compute {
+
+typedef std::function<void(const vertex_address& source,
+                           const vertex_address& target)> delta_edge_apply_fn_type;
+
+/**
+ * Calls fn on the source and target of every edge added to g since the
+ * watermark (see \ref sgraph::delta_watermark), and only on those: the cost
+ * is proportional to the number of new edges, not to the size of the graph.
+ *
+ * \code
+ * auto since = g.get_delta_watermark();
+ * g.add_edges(new_edges, "src", "dst");
+ * delta_edge_apply(g, since, [&](const vertex_address& src, const vertex_address& dst) {
+ *   ...
+ * });
+ * \endcode
+ *
+ * fn is called in parallel, and may only read the vertex partitions.
+ * Only the default group is supported.
+ */
+void delta_edge_apply(const sgraph& g,
+                      const sgraph::delta_watermark& since,
+                      delta_edge_apply_fn_type fn);
+
+/**
+ * Returns the number of edges added to g since the watermark.
+ */
+size_t num_edges_since(const sgraph& g, const sgraph::delta_watermark& since);
+
+} // end of sgraph_compute
+
+/// \}
+} // end of turi
+
+#endif
@@ -7,6 +7,8 @@
 #define TURI_SGRAPH_SGRAPH_sgraph_engine_HPP
 
 #include <vector>
+#include <list>
+#include <set>
 #include <tuple>
 #include <type_traits>
 #include <core/data/flexible_type/flexible_type.hpp>
@@ -14,6 +16,7 @@
 #include <core/storage/sframe_data/sarray.hpp>
 #include <core/storage/sgraph_data/sgraph.hpp>
 #include <core/storage/sgraph_data/hilbert_parallel_for.hpp>
+#include <core/storage/sgraph_data/sgraph_constants.hpp>
 #include <core/storage/sgraph_data/sgraph_compute_vertex_block.hpp>
 #include <core/util/cityhash_tc.hpp>
 
@@ -136,53 +139,43 @@ class sgraph_engine {
                                 std::unordered_set<size_t> sgraph_compute_group = {0},
                                 size_t parallel_limit = (size_t)(-1)) {
     if (parallel_limit == static_cast<size_t>(-1)) {
-      parallel_limit = thread::cpu_count();
+      parallel_limit = SGRAPH_HILBERT_CURVE_PARALLEL_FOR_NUM_THREADS;
     }
     init_data_structures(graph, central_group, initial_value);
-    hilbert_blocked_parallel_for(
-         graph.get_num_partitions(),
-         // The preamble to each parallel for block.
-         // Thisis the collection of edges that will be executed in the next pass.
-         [&](std::vector<std::pair<size_t, size_t> > edgeparts) {
-           std::set<vertex_partition_address> vertex_partitions;
-           std::set<size_t> combine_partitions;
-           // for each partition requested, figure out exactly
-           // which partition / group I need to load
-           // That does depend on the edge direction I am
-           // executing.
-           for(auto edgepart: edgeparts) {
-           logstream(LOG_INFO) << "Planning Execution on Edge Partition: "
-                               << edgepart.first << " " << edgepart.second << std::endl;
-             for(size_t gather_vgroup: sgraph_compute_group) {
-               if (edgedir == edge_direction::ANY_EDGE ||
-                   edgedir == edge_direction::IN_EDGE) {
-                 // this is the edge partition I will read when I have to run
-                 // this edge set. this is IN-edges. So src group is
-                 // the gather_vgroup and dst group is the central group.
-                 // partition is as defined by edgepart
-                 edge_partition_address address(gather_vgroup, central_group,
-                                                edgepart.first, edgepart.second);
-                 combine_partitions.insert(address.get_dst_vertex_partition().partition);
-                 vertex_partitions.insert(address.get_src_vertex_partition());
-                 vertex_partitions.insert(address.get_dst_vertex_partition());
-               }
-               if (edgedir == edge_direction::ANY_EDGE ||
-                          edgedir == edge_direction::OUT_EDGE) {
-                 // this is the edge partition I will read when I have to run
-                 // this edge set. this is OUT-edges. So dst group is
-                 // the gather_vgroup and src group is the central group.
-                 // partition is as defined by edgepart
-                 edge_partition_address address(central_group, gather_vgroup,
-                                                edgepart.first, edgepart.second);
-                 combine_partitions.insert(address.get_src_vertex_partition().partition);
-                 vertex_partitions.insert(address.get_src_vertex_partition());
-                 vertex_partitions.insert(address.get_dst_vertex_partition());
-               }
+    cached_hilbert_parallel_for(
+         graph,
+         parallel_limit,
+         // The blocks each edge partition needs in memory.
+         // That does depend on the edge direction I am executing.
+         [&](std::pair<size_t, size_t> edgepart) {
+           std::set<block_key> blocks;
+           for(size_t gather_vgroup: sgraph_compute_group) {
+             if (edgedir == edge_direction::ANY_EDGE ||
+                 edgedir == edge_direction::IN_EDGE) {
+               // this is the edge partition I will read when I have to run
+               // this edge set. this is IN-edges. So src group is
+               // the gather_vgroup and dst group is the central group.
+               // partition is as defined by edgepart
+               edge_partition_address address(gather_vgroup, central_group,
+                                              edgepart.first, edgepart.second);
+               blocks.insert(block_key::combine(address.get_dst_vertex_partition().partition));
+               blocks.insert(block_key::vertex(address.get_src_vertex_partition()));
+               blocks.insert(block_key::vertex(address.get_dst_vertex_partition()));
+             }
+             if (edgedir == edge_direction::ANY_EDGE ||
+                        edgedir == edge_direction::OUT_EDGE) {
+               // this is the edge partition I will read when I have to run
+               // this edge set. this is OUT-edges. So dst group is
+               // the gather_vgroup and src group is the central group.
+               // partition is as defined by edgepart
+               edge_partition_address address(central_group, gather_vgroup,
+                                              edgepart.first, edgepart.second);
+               blocks.insert(block_key::combine(address.get_src_vertex_partition().partition));
+               blocks.insert(block_key::vertex(address.get_src_vertex_partition()));
+               blocks.insert(block_key::vertex(address.get_dst_vertex_partition()));
              }
            }
-           // request loading of all the vertex partitions I need
-           load_graph_vertex_blocks(graph, vertex_partitions);
-           load_combine_blocks(combine_partitions);
+           return blocks;
          },
          // This is the actual parallel for, and this is the block I am to
          // be executing
@@ -203,7 +196,7 @@ class sgraph_engine {
            }
          });
     // flush the combine blocks
-    load_combine_blocks(std::set<size_t>());
+    unload_all_blocks();
     return combine_sarrays;
   }
 
@@ -224,39 +217,23 @@ class sgraph_engine {
                                 size_t groupa = 0, size_t groupb = 0,
                                 size_t parallel_limit = (size_t)(-1)) {
     if (parallel_limit == static_cast<size_t>(-1)) {
-      parallel_limit = thread::cpu_count();
+      parallel_limit = SGRAPH_HILBERT_CURVE_PARALLEL_FOR_NUM_THREADS;
     }
     vertex_data.clear();
     vertex_data.resize(graph.get_num_groups());
     for(auto& v: vertex_data) v.resize(graph.get_num_partitions());
+    resident_blocks.clear();
 
     size_t return_size = graph.get_num_partitions() * graph.get_num_partitions();
     std::vector<std::shared_ptr<sarray<T>>> return_edge_value(return_size);
-    hilbert_blocked_parallel_for(
-         graph.get_num_partitions(),
-         // The preamble to each parallel for block.
-         // Thisis the collection of edges that will be executed in the next pass.
-         [&](std::vector<std::pair<size_t, size_t> > edgeparts) {
-           std::set<vertex_partition_address> vertex_partitions;
-           std::set<size_t> combine_partitions;
-           // for each partition requested, figure out exactly
-           // which partition / group I need to load
-           // That does depend on the edge direction I am
-           // executing.
-           for(auto edgepart: edgeparts) {
-           logstream(LOG_INFO) << "Planning Execution on Edge Partition: "
-                               << edgepart.first << " " << edgepart.second << std::endl;
-             // this is the edge partition I will read when I have to run
-             // this edge set. this is IN-edges. So src group is
-             // the gather_vgroup and dst group is the central group.
-             // partition is as defined by edgepart
-             edge_partition_address address(groupa, groupb, edgepart.first, edgepart.second);
-             combine_partitions.insert(address.get_dst_vertex_partition().partition);
-             vertex_partitions.insert(address.get_src_vertex_partition());
-             vertex_partitions.insert(address.get_dst_vertex_partition());
-           }
-           // request loading of all the vertex partitions I need
-           load_graph_vertex_blocks(graph, vertex_partitions);
+    cached_hilbert_parallel_for(
+         graph,
+         parallel_limit,
+         // The vertex blocks each edge partition needs in memory.
+         [&](std::pair<size_t, size_t> edgepart) {
+           edge_partition_address address(groupa, groupb, edgepart.first, edgepart.second);
+           return std::set<block_key>{block_key::vertex(address.get_src_vertex_partition()),
+                                      block_key::vertex(address.get_dst_vertex_partition())};
          },
          // This is the actual parallel for, and this is the block I am to
          // be executing
@@ -273,15 +250,45 @@ class sgraph_engine {
            size_t partid = edgepart.first * graph.get_num_partitions() + edgepart.second;
            return_edge_value[partid] = compute_edge_map(edgeframe, address, map_fn, ret_type);
          });
+    unload_all_blocks();
     return return_edge_value;
   }
 
  private:
+  /**
+   * Identifies a block the engine can hold in memory: the data of a vertex
+   * partition, or the combine values of a partition of the central group.
+   */
+  struct block_key {
+    bool is_combine = false;
+    vertex_partition_address address;
+
+    block_key() = default;
+    block_key(bool is_combine, vertex_partition_address address):
+        is_combine(is_combine), address(address) { }
+
+    static block_key vertex(vertex_partition_address address) {
+      return block_key(false, address);
+    }
+    static block_key combine(size_t partition) {
+      return block_key(true, vertex_partition_address(0, partition));
+    }
+    bool operator==(const block_key& other) const {
+      return is_combine == other.is_combine && address == other.address;
+    }
+    bool operator<(const block_key& other) const {
+      return is_combine < other.is_combine ||
+          (is_combine == other.is_combine && address < other.address);
+    }
+  };
+
   // vertex_data[group][partition]
   std::vector<std::vector<vertex_block<sframe> > > vertex_data;
   // combine_data[partition]
   std::vector<vertex_block<sarray<T> > > combine_data;
   std::vector<std::shared_ptr<sarray<T> > > combine_sarrays;
+  // the blocks in memory, most recently used first
+  std::list<block_key> resident_blocks;
   static constexpr size_t LOCK_ARRAY_SIZE = 1024;
   turi::mutex lock_array[LOCK_ARRAY_SIZE];
   flex_type_enum m_return_type = flex_type_enum::UNDEFINED;
@@ -306,6 +313,7 @@ class sgraph_engine {
     vertex_data.clear();
     combine_data.clear();
     combine_sarrays.clear();
+    resident_blocks.clear();
     set_return_type(initial_value);
 
     /*
@@ -337,73 +345,119 @@ class sgraph_engine {
   }
 
   /**
-   * This function will unload all graph vertex blocks which are not in the set
-   * vertex_address and load all vertex blocks which are in the set.
+   * Sweeps the edge partitions of the graph in Hilbert curve order, like
+   * hilbert_blocked_parallel_for(), calling fn on each in parallel. A pass
+   * ends at parallel_limit edge partitions, or earlier if the blocks its edge
+   * partitions need (as listed by blocks_of) would exceed
+   * SGRAPH_ENGINE_MAX_RESIDENT_BLOCKS. The blocks of a pass are loaded before
+   * it runs, evicting the least recently used ones to stay within the bound.
    */
-  void load_graph_vertex_blocks(sgraph& graph,
-                                const std::set<vertex_partition_address>& vertex_address) {
-    // look for all loaded blocks and if they are not in the vertex_address set, unload it
-    for (size_t group = 0; group < vertex_data.size(); ++group) {
-      for (size_t partition = 0; partition < vertex_data[group].size(); ++partition) {
-        if (vertex_data[group][partition].is_loaded() &&
-            vertex_address.count({group, partition}) == 0) {
-          vertex_data[group][partition].unload();
+  template <typename BlocksFn>
+  void cached_hilbert_parallel_for(sgraph& graph,
+                                   size_t parallel_limit,
+                                   BlocksFn blocks_of,
+                                   std::function<void(std::pair<size_t, size_t>)> fn) {
+    const size_t n = graph.get_num_partitions();
+    const size_t max_blocks = SGRAPH_ENGINE_MAX_RESIDENT_BLOCKS;
+    std::vector<std::pair<size_t, size_t> > coordinates;
+    std::set<block_key> pass_blocks;
+    auto run_pass = [&]() {
+      for (auto edgepart: coordinates) {
+        logstream(LOG_INFO) << "Planning Execution on Edge Partition: "
+                            << edgepart.first << " " << edgepart.second << std::endl;
+      }
+      load_blocks(graph, pass_blocks);
+      parallel_for(coordinates.begin(), coordinates.end(), fn);
+      coordinates.clear();
+      pass_blocks.clear();
+    };
+    for (size_t i = 0; i < n * n; ++i) {
+      auto edgepart = hilbert_index_to_coordinate(i, n);
+      std::set<block_key> blocks = blocks_of(edgepart);
+      if (!coordinates.empty()) {
+        std::set<block_key> merged = pass_blocks;
+        merged.insert(blocks.begin(), blocks.end());
+        if (coordinates.size() >= parallel_limit || merged.size() > max_blocks) {
+          run_pass();
+        } else {
+          blocks.swap(merged);
         }
       }
+      if (coordinates.empty() && blocks.size() > max_blocks) {
+        logstream(LOG_WARNING) << "Edge partition " << edgepart.first << " "
+                               << edgepart.second << " needs " << blocks.size()
+                               << " blocks in memory, more than "
+                               << "SGRAPH_ENGINE_MAX_RESIDENT_BLOCKS" << std::endl;
+      }
+      coordinates.push_back(edgepart);
+      pass_blocks.swap(blocks);
     }
-    std::vector<vertex_partition_address> vertex_address_vec;
-    std::copy(vertex_address.begin(), vertex_address.end(),
-              std::inserter(vertex_address_vec, vertex_address_vec.end()));
-
-    // now, for each element in vertex_address, if it is not loaded, load it
-    parallel_for(vertex_address_vec.begin(),
-                 vertex_address_vec.end(),
-                 // parallel for callback. called with each vertex address I need
-                 // to load
-                 [&](vertex_partition_address& part) {
-                   // get the frame for the vertex partition
-                   const sframe& frame = graph.vertex_partition(part.partition, part.group);
-                   // load it into the vertex data.
-                   logstream(LOG_INFO) << "Loading Vertex Partition: "
-                                       << part.group << " " << part.partition << std::endl;
-                   vertex_data[part.group][part.partition].load_if_not_loaded(frame);
-                 });
+    if (!coordinates.empty()) run_pass();
   }
 
-
   /**
-   * This function will unload all gather blocks not in the set partitions,
-   * writing them back out to the sarray if modified. It will then load
-   * all the gather blocks that are in the set.
+   * Loads every block in the set, keeping the blocks already in memory unless
+   * that would exceed SGRAPH_ENGINE_MAX_RESIDENT_BLOCKS, in which case the
+   * least recently used blocks not in the set are unloaded first.
    */
-  void load_combine_blocks(const std::set<size_t> partitions) {
-    for (size_t partition = 0; partition < combine_data.size(); ++partition) {
-      if (combine_data[partition].is_loaded() && partitions.count(partition) == 0) {
-        // reset the existing sarray and save the gather data to it.
-        combine_sarrays[partition].reset(new sarray<T>());
-        combine_sarrays[partition]->open_for_write(1);
-        if (typeid(T) == typeid(flexible_type)) {
-          combine_sarrays[partition]->set_type(m_return_type);
-        }
-        combine_data[partition].flush(*combine_sarrays[partition]);
-        // we need to do a save here.
-        combine_data[partition].unload();
-      }
+  void load_blocks(sgraph& graph, const std::set<block_key>& blocks) {
+    // move the requested blocks to the front of the LRU list
+    std::list<block_key> requested(blocks.begin(), blocks.end());
+    resident_blocks.remove_if([&](const block_key& key) { return blocks.count(key) > 0; });
+    resident_blocks.splice(resident_blocks.begin(), requested);
+    while (resident_blocks.size() > std::max(SGRAPH_ENGINE_MAX_RESIDENT_BLOCKS, blocks.size())) {
+      unload_block(resident_blocks.back());
+      resident_blocks.pop_back();
     }
 
-    std::vector<size_t> partitions_vec;
-    std::copy(partitions.begin(), partitions.end(),
-              std::inserter(partitions_vec, partitions_vec.end()));
-
-    // now, for each element in partitions, if it is not loaded, load it
-    parallel_for(partitions_vec.begin(),
-                 partitions_vec.end(),
-                 [&](size_t part) {
-                   logstream(LOG_INFO) << "Loading Combine Partition: " << part << std::endl;
-                   combine_data[part].load_if_not_loaded(*combine_sarrays[part]);
+    std::vector<block_key> blocks_vec(blocks.begin(), blocks.end());
+    // now, for each requested block, if it is not loaded, load it
+    parallel_for(blocks_vec.begin(),
+                 blocks_vec.end(),
+                 [&](block_key& key) {
+                   const vertex_partition_address& part = key.address;
+                   if (key.is_combine) {
+                     logstream(LOG_INFO) << "Loading Combine Partition: "
+                                         << part.partition << std::endl;
+                     combine_data[part.partition].load_if_not_loaded(*combine_sarrays[part.partition]);
+                   } else {
+                     // get the frame for the vertex partition
+                     const sframe& frame = graph.vertex_partition(part.partition, part.group);
+                     // load it into the vertex data.
+                     logstream(LOG_INFO) << "Loading Vertex Partition: "
+                                         << part.group << " " << part.partition << std::endl;
+                     vertex_data[part.group][part.partition].load_if_not_loaded(frame);
+                   }
                  });
   }
 
+  /**
+   * Unloads a block. Combine blocks are written back out to their sarray
+   * first, so that the partial sums survive until the block is reloaded.
+   */
+  void unload_block(const block_key& key) {
+    const vertex_partition_address& part = key.address;
+    if (!key.is_combine) {
+      vertex_data[part.group][part.partition].unload();
+      return;
+    }
+    if (!combine_data[part.partition].is_loaded()) return;
+    // reset the existing sarray and save the gather data to it.
+    combine_sarrays[part.partition].reset(new sarray<T>());
+    combine_sarrays[part.partition]->open_for_write(1);
+    if (typeid(T) == typeid(flexible_type)) {
+      combine_sarrays[part.partition]->set_type(m_return_type);
+    }
+    combine_data[part.partition].flush(*combine_sarrays[part.partition]);
+    combine_data[part.partition].unload();
+  }
+
+  /// Unloads every resident block, flushing the combine blocks
+  void unload_all_blocks() {
+    for (const block_key& key: resident_blocks) unload_block(key);
+    resident_blocks.clear();
+  }
+
   void compute_const_gather(sframe& edgeframe,
                             edge_partition_address address,
                             size_t central_group,
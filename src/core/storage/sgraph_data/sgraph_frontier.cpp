@@ -0,0 +1,84 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <core/storage/sgraph_data/sgraph_frontier.hpp>
+#include <core/storage/sgraph_data/sgraph_constants.hpp>
+
+namespace turi {
+namespace sgraph_compute {
+
+namespace {
+
+/// Marks the out neighbors (and in neighbors if undirected) of every changed vertex
+void push_frontier(const csr_snapshot& csr,
+                   const vertex_frontier& changed,
+                   vertex_frontier& next,
+                   bool undirected) {
+  changed.parallel_for_each([&](size_t v) {
+    for (auto u = csr.out_begin(v); u != csr.out_end(v); ++u) next.activate(*u);
+    if (undirected) {
+      for (auto u = csr.in_begin(v); u != csr.in_end(v); ++u) next.activate(*u);
+    }
+  });
+}
+
+/// Every vertex looks for a changed in neighbor (or out neighbor if undirected)
+void pull_frontier(const csr_snapshot& csr,
+                   const vertex_frontier& changed,
+                   vertex_frontier& next,
+                   bool undirected) {
+  // a thread owns whole words of the bitset, so plain writes are enough
+  const size_t nvertices = csr.num_vertices();
+  const size_t nwords = (nvertices + 63) / 64;
+  in_parallel([&](size_t thread_id, size_t num_threads) {
+    size_t begin = 64 * (nwords * thread_id / num_threads);
+    size_t end = std::min(nvertices, 64 * (nwords * (thread_id + 1) / num_threads));
+    for (size_t v = begin; v < end; ++v) {
+      bool found = false;
+      for (auto u = csr.in_begin(v); !found && u != csr.in_end(v); ++u) {
+        found = changed.is_active(*u);
+      }
+      if (undirected) {
+        for (auto u = csr.out_begin(v); !found && u != csr.out_end(v); ++u) {
+          found = changed.is_active(*u);
+        }
+      }
+      if (found) next.activate_unsync(v);
+    }
+  });
+}
+
+} // end of anonymous namespace
+
+void expand_frontier(const csr_snapshot& csr,
+                     const vertex_frontier& changed,
+                     vertex_frontier& next,
+                     bool undirected) {
+  ASSERT_EQ(changed.num_vertices(), csr.num_vertices());
+  ASSERT_EQ(next.num_vertices(), csr.num_vertices());
+  next.clear();
+  if (changed.empty()) return;
+
+  // what pushing would scan, against what pulling would
+  bool can_push = csr.has_out_edges() && (!undirected || csr.has_in_edges());
+  bool can_pull = csr.has_in_edges() && (!undirected || csr.has_out_edges());
+  ASSERT_MSG(can_push || can_pull, "The CSR snapshot lacks the edges to expand a frontier");
+  bool push = can_push;
+  if (can_push && can_pull) {
+    size_t changed_edges = changed.parallel_sum([&](size_t v) {
+      return csr.out_degree(v) + (undirected ? csr.in_degree(v) : 0);
+    });
+    size_t scanned_edges = csr.num_edges() * (undirected ? 2 : 1);
+    push = changed_edges * SGRAPH_FRONTIER_PULL_RATIO <= scanned_edges;
+  }
+  if (push) {
+    push_frontier(csr, changed, next, undirected);
+  } else {
+    pull_frontier(csr, changed, next, undirected);
+  }
+}
+
+} // end of sgraph_compute
+} // end of turi
@@ -0,0 +1,138 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SGRAPH_SGRAPH_FRONTIER_HPP
+#define TURI_SGRAPH_SGRAPH_FRONTIER_HPP
+
+#include <core/util/dense_bitset.hpp>
+#include <core/parallel/lambda_omp.hpp>
+#include <core/parallel/thread_pool.hpp>
+#include <core/storage/sgraph_data/sgraph_csr.hpp>
+
+namespace turi {
+
+/**
+ * \ingroup sgraph_physical
+ * \addtogroup sgraph_compute SGraph Compute
+ * \{
+ */
+
+/**
+ * Graph Computation Functions
+ */
+namespace sgraph_compute {
+
+/**
+ * A set of vertices of a \ref csr_snapshot, for iterative algorithms which
+ * only recompute the vertices whose neighborhood changed in the previous
+ * iteration ("active set" or "frontier" execution):
+ *
+ * \code
+ * vertex_frontier active(csr.num_vertices()), changed(csr.num_vertices());
+ * active.activate_all();
+ * while (!active.empty()) {
+ *   changed.clear();
+ *   active.parallel_for_each([&](size_t v) {
+ *     if (recompute(v) > tolerance) changed.activate(v);
+ *   });
+ *   expand_frontier(csr, changed, active);
+ * }
+ * \endcode
+ *
+ * activate() can be called in parallel.
+ */
+class vertex_frontier {
+ public:
+  explicit vertex_frontier(size_t num_vertices = 0) : m_bits(num_vertices) {
+    m_bits.clear();
+  }
+
+  inline size_t num_vertices() const { return m_bits.size(); }
+
+  /// Adds a vertex to the set. Thread safe.
+  inline void activate(size_t vid) { m_bits.set_bit(vid); }
+
+  /**
+   * Adds a vertex to the set. Not thread safe: threads may only call it
+   * concurrently on vertices of different 64 vertex words.
+   */
+  inline void activate_unsync(size_t vid) { m_bits.set_bit_unsync(vid); }
+
+  inline bool is_active(size_t vid) const { return m_bits.get(vid); }
+
+  /// Adds every vertex to the set
+  inline void activate_all() { m_bits.fill(); }
+
+  inline void clear() { m_bits.clear(); }
+
+  inline bool empty() const { return m_bits.empty(); }
+
+  /// The number of vertices in the set
+  inline size_t size() const { return m_bits.popcount(); }
+
+  /**
+   * Calls fn(vid) on every vertex of the set, in parallel. The set must not
+   * be modified meanwhile.
+   */
+  template <typename Fn>
+  void parallel_for_each(Fn fn) const {
+    parallel_sum([&](size_t vid) { fn(vid); return size_t(0); });
+  }
+
+  /**
+   * Returns the sum of fn(vid) over the vertices of the set, computed in
+   * parallel. The set must not be modified meanwhile.
+   */
+  template <typename T = size_t, typename Fn>
+  T parallel_sum(Fn fn) const {
+    const size_t nwords = (num_vertices() + 63) / 64;
+    std::vector<T> sum_per_thread(thread_pool::get_instance().size() + 1, T(0));
+    in_parallel([&](size_t thread_id, size_t num_threads) {
+      size_t begin = 64 * (nwords * thread_id / num_threads);
+      size_t end = std::min(num_vertices(), 64 * (nwords * (thread_id + 1) / num_threads));
+      if (begin >= end) return;
+      size_t vid = begin;
+      if (!m_bits.get(vid) && !m_bits.next_bit(vid)) return;
+      T sum = 0;
+      while (vid < end) {
+        sum += fn(vid);
+        if (!m_bits.next_bit(vid)) break;
+      }
+      sum_per_thread[thread_id] = sum;
+    });
+    T ret = 0;
+    for (const T& sum : sum_per_thread) ret += sum;
+    return ret;
+  }
+
+  const dense_bitset& bits() const { return m_bits; }
+
+ private:
+  dense_bitset m_bits;
+};
+
+/**
+ * Sets next to the vertices whose value depends on a vertex of changed:
+ * the out neighbors of the changed vertices, and their in neighbors too if
+ * undirected is true.
+ *
+ * Small frontiers are expanded by pushing along the out edges of the changed
+ * vertices. Large ones are expanded by pulling: every vertex scans its in
+ * edges until it finds a changed neighbor, which touches each edge at most
+ * once and needs no atomic writes. The switch happens when the changed
+ * vertices have more than 1 / \ref SGRAPH_FRONTIER_PULL_RATIO of the edges.
+ * Each direction is only used if the snapshot has the edges it scans.
+ */
+void expand_frontier(const csr_snapshot& csr,
+                     const vertex_frontier& changed,
+                     vertex_frontier& next,
+                     bool undirected = false);
+
+} // end of sgraph_compute
+
+/// \}
+} // end of turi
+
+#endif
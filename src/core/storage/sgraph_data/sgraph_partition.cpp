@@ -0,0 +1,197 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <set>
+#include <sstream>
+#include <algorithm>
+#include <core/storage/sgraph_data/sgraph_partition.hpp>
+#include <core/storage/sgraph_data/hilbert_curve.hpp>
+#include <core/storage/sframe_data/sarray_reader.hpp>
+#include <core/parallel/lambda_omp.hpp>
+#include <core/parallel/mutex.hpp>
+#include <core/util/dense_bitset.hpp>
+#include <core/util/bitops.hpp>
+#include <core/logging/logger.hpp>
+
+namespace turi {
+namespace sgraph_compute {
+
+namespace {
+
+/// Number of edges read at once
+const size_t PARTITION_STATS_BATCH_SIZE = 64 * 1024;
+
+/// The largest value over the mean, or 1 if all are 0
+double balance(const std::vector<size_t>& sizes) {
+  size_t total = 0;
+  size_t largest = 0;
+  for (size_t s : sizes) {
+    total += s;
+    largest = std::max(largest, s);
+  }
+  if (total == 0) return 1;
+  return (double)largest * sizes.size() / total;
+}
+
+} // end of anonymous namespace
+
+std::string sgraph_partition_stats::summary() const {
+  std::stringstream ss;
+  ss << num_partitions << " partitions, vertex balance " << vertex_balance
+     << ", edge balance " << edge_balance
+     << ", replication factor " << replication_factor
+     << ", vertex rows loaded per pass " << vertex_rows_loaded_per_pass
+     << " (" << vertex_load_factor << "x)";
+  return ss.str();
+}
+
+size_t estimate_vertex_rows_loaded(const std::vector<size_t>& vertex_partition_sizes,
+                                   size_t parallel_limit) {
+  const size_t n = vertex_partition_sizes.size();
+  if (n <= 1) return n == 0 ? 0 : vertex_partition_sizes[0];
+  parallel_limit = std::max<size_t>(parallel_limit, 1);
+  size_t ret = 0;
+  std::set<size_t> loaded;
+  for (size_t i = 0; i < n * n; i += parallel_limit) {
+    std::set<size_t> needed;
+    for (size_t j = i; j < std::min(i + parallel_limit, n * n); ++j) {
+      auto coord = hilbert_index_to_coordinate(j, n);
+      needed.insert(coord.first);
+      needed.insert(coord.second);
+    }
+    for (size_t partition : needed) {
+      if (!loaded.count(partition)) ret += vertex_partition_sizes[partition];
+    }
+    loaded.swap(needed);
+  }
+  return ret;
+}
+
+sgraph_partition_stats compute_partition_stats(const sgraph& g,
+                                               bool compute_replication) {
+  sgraph_partition_stats ret;
+  const size_t nparts = g.get_num_partitions();
+  ret.num_partitions = nparts;
+  size_t nvertices = 0;
+  for (size_t i = 0; i < nparts; ++i) {
+    ret.vertex_partition_sizes.push_back(g.vertex_partition(i).num_rows());
+    nvertices += ret.vertex_partition_sizes.back();
+  }
+  for (size_t i = 0; i < nparts; ++i) {
+    for (size_t j = 0; j < nparts; ++j) {
+      ret.edge_partition_sizes.push_back(g.edge_partition(i, j).num_rows());
+    }
+  }
+  ret.vertex_balance = balance(ret.vertex_partition_sizes);
+  ret.edge_balance = balance(ret.edge_partition_sizes);
+  ret.vertex_rows_loaded_per_pass =
+      estimate_vertex_rows_loaded(ret.vertex_partition_sizes,
+                                  SGRAPH_HILBERT_CURVE_PARALLEL_FOR_NUM_THREADS);
+  ret.vertex_load_factor =
+      nvertices == 0 ? 0 : (double)ret.vertex_rows_loaded_per_pass / nvertices;
+  if (!compute_replication) return ret;
+
+  // For every edge partition, the distinct vertices it touches
+  std::vector<dense_bitset> has_edges(nparts);
+  std::vector<turi::mutex> has_edges_locks(nparts);
+  for (size_t i = 0; i < nparts; ++i) {
+    has_edges[i].resize(ret.vertex_partition_sizes[i]);
+    has_edges[i].clear();
+  }
+  std::atomic<size_t> total_replicas(0);
+  parallel_for(0, nparts * nparts, [&](size_t k) {
+    size_t i = k / nparts;
+    size_t j = k % nparts;
+    const sframe& edges = g.edge_partition(i, j);
+    const size_t nrows = edges.num_rows();
+    if (nrows == 0) return;
+    dense_bitset sources(ret.vertex_partition_sizes[i]);
+    dense_bitset targets(ret.vertex_partition_sizes[j]);
+    sources.clear();
+    targets.clear();
+    auto src_reader = edges.select_column(sgraph::SRC_COLUMN_NAME)->get_reader();
+    auto dst_reader = edges.select_column(sgraph::DST_COLUMN_NAME)->get_reader();
+    std::vector<flex_int> src(PARTITION_STATS_BATCH_SIZE), dst(PARTITION_STATS_BATCH_SIZE);
+    for (size_t row = 0; row < nrows; row += PARTITION_STATS_BATCH_SIZE) {
+      size_t n = std::min(PARTITION_STATS_BATCH_SIZE, nrows - row);
+      src_reader->read_rows_as(row, row + n, src.data(), 0);
+      dst_reader->read_rows_as(row, row + n, dst.data(), 0);
+      for (size_t e = 0; e < n; ++e) {
+        sources.set_bit_unsync(src[e]);
+        targets.set_bit_unsync(dst[e]);
+      }
+    }
+    if (i == j) {
+      sources |= targets;
+      total_replicas += sources.popcount();
+    } else {
+      total_replicas += sources.popcount() + targets.popcount();
+    }
+    {
+      std::lock_guard<turi::mutex> guard(has_edges_locks[i]);
+      has_edges[i] |= sources;
+    }
+    if (i != j) {
+      std::lock_guard<turi::mutex> guard(has_edges_locks[j]);
+      has_edges[j] |= targets;
+    }
+  });
+  size_t vertices_with_edges = 0;
+  for (auto& bits : has_edges) vertices_with_edges += bits.popcount();
+  if (vertices_with_edges > 0) {
+    ret.replication_factor = (double)total_replicas / vertices_with_edges;
+  }
+  return ret;
+}
+
+size_t suggest_num_partitions(const sgraph& g) {
+  const size_t nvertices = g.num_vertices();
+  const size_t nthreads = SGRAPH_HILBERT_CURVE_PARALLEL_FOR_NUM_THREADS;
+  // the fewest partitions which stay under the vertex limit
+  size_t min_partitions = 1;
+  while (nvertices / min_partitions > SGRAPH_MAX_VERTICES_PER_PARTITION) {
+    min_partitions *= 2;
+  }
+  // the fewest which keep every thread busy; the blocked engines need 2
+  size_t busy_partitions = 2;
+  while (busy_partitions * busy_partitions < nthreads) busy_partitions *= 2;
+
+  // hashing balances the partitions, so estimate them as equal
+  size_t best = std::max(min_partitions, busy_partitions);
+  size_t best_loaded = std::numeric_limits<size_t>::max();
+  for (size_t p = best; p <= 4 * best; p *= 2) {
+    std::vector<size_t> sizes(p, (nvertices + p - 1) / p);
+    size_t loaded = estimate_vertex_rows_loaded(sizes, nthreads);
+    if (loaded < best_loaded) {
+      best = p;
+      best_loaded = loaded;
+    }
+  }
+  return best;
+}
+
+sgraph repartition(const sgraph& g, size_t num_partitions) {
+  if (g.get_num_groups() != 1) {
+    log_and_throw("Repartitioning graphs with vertex groups is not supported");
+  }
+  if (num_partitions == 0 || !is_power_of_2((uint64_t)num_partitions)) {
+    log_and_throw("Number of partitions must be a power of 2");
+  }
+  sgraph ret(num_partitions);
+  sframe vertices = g.get_vertices();
+  if (vertices.num_rows() > 0) {
+    ret.add_vertices(vertices, sgraph::VID_COLUMN_NAME);
+  }
+  sframe edges = g.get_edges();
+  if (edges.num_rows() > 0) {
+    ret.add_edges(edges, sgraph::SRC_COLUMN_NAME, sgraph::DST_COLUMN_NAME);
+  }
+  logstream(LOG_INFO) << "Repartitioned graph: "
+                      << compute_partition_stats(ret, false).summary() << std::endl;
+  return ret;
+}
+
+} // end of sgraph_compute
+} // end of turi
@@ -0,0 +1,104 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SGRAPH_SGRAPH_PARTITION_HPP
+#define TURI_SGRAPH_SGRAPH_PARTITION_HPP
+
+#include <string>
+#include <vector>
+#include <core/storage/sgraph_data/sgraph.hpp>
+#include <core/storage/sgraph_data/sgraph_constants.hpp>
+
+namespace turi {
+
+/**
+ * \ingroup sgraph_physical
+ * \addtogroup sgraph_compute SGraph Compute
+ * \{
+ */
+
+/**
+ * Graph Computation Functions
+ */
+namespace sgraph_compute {
+
+/**
+ * How well the partitioning of a graph suits the blocked engines
+ * (\ref sgraph_engine, triple apply), which run over the edge partitions
+ * (i, j) a batch at a time in Hilbert curve order and load vertex partitions
+ * i and j for every edge partition of the batch.
+ */
+struct sgraph_partition_stats {
+  size_t num_partitions = 0;
+  std::vector<size_t> vertex_partition_sizes;
+  /// Rows of edge partition (i, j), at i * num_partitions + j
+  std::vector<size_t> edge_partition_sizes;
+
+  /// Rows of the largest vertex partition over the mean. 1 is perfect.
+  double vertex_balance = 1;
+  /// Rows of the largest edge partition over the mean. 1 is perfect.
+  double edge_balance = 1;
+
+  /**
+   * The mean number of edge partitions holding edges of a vertex, over the
+   * vertices with edges: how many times a pass over the edges needs each
+   * vertex.
+   */
+  double replication_factor = 0;
+
+  /**
+   * Vertex rows a pass of \ref hilbert_blocked_parallel_for loads, with
+   * batches of \ref SGRAPH_HILBERT_CURVE_PARALLEL_FOR_NUM_THREADS edge
+   * partitions, and its ratio to the number of vertices (1 if every vertex
+   * partition is loaded once).
+   */
+  size_t vertex_rows_loaded_per_pass = 0;
+  double vertex_load_factor = 0;
+
+  /// A one line summary for logging
+  std::string summary() const;
+};
+
+/**
+ * Computes the partition statistics of the default group of g. Computing
+ * the replication factor reads the source and target columns of every edge
+ * partition once; the rest only reads partition sizes.
+ */
+sgraph_partition_stats compute_partition_stats(const sgraph& g,
+                                               bool compute_replication = true);
+
+/**
+ * The vertex rows a pass of hilbert_blocked_parallel_for(num_partitions, ...)
+ * loads with batches of parallel_limit edge partitions, given the rows of
+ * every vertex partition: a batch loads the vertex partitions it needs which
+ * the previous batch did not have loaded.
+ */
+size_t estimate_vertex_rows_loaded(const std::vector<size_t>& vertex_partition_sizes,
+                                   size_t parallel_limit);
+
+/**
+ * Suggests a number of partitions for g which keeps the vertex loading of
+ * blocked passes low: the power of two which minimizes the vertex rows
+ * loaded per pass, while keeping every thread busy (at least as many edge
+ * partitions as \ref SGRAPH_HILBERT_CURVE_PARALLEL_FOR_NUM_THREADS) and at
+ * most \ref SGRAPH_MAX_VERTICES_PER_PARTITION vertices per partition.
+ */
+size_t suggest_num_partitions(const sgraph& g);
+
+/**
+ * Returns a copy of g with num_partitions partitions (a power of two), with
+ * the same vertices, edges and fields. Vertices stay hashed to partitions,
+ * so the copy supports every sgraph operation.
+ *
+ * Only graphs with a single vertex group are supported.
+ */
+sgraph repartition(const sgraph& g, size_t num_partitions);
+
+} // end of sgraph_compute
+
+/// \}
+} // end of turi
+
+#endif
@@ -941,8 +941,9 @@ namespace {
       }
       std::vector<sgraph_edge_data> mutated_edge_data;
       try {
-        mutated_edge_data = m_evaluator->proxy->eval_triple_apply(all_edge_data, m_src_partition,
-                                                                  m_dst_partition, mutated_edge_field_ids);
+        mutated_edge_data = lambda::graph_pylambda_master::get_instance().eval_triple_apply(
+            *m_evaluator, all_edge_data, m_src_partition,
+            m_dst_partition, mutated_edge_field_ids);
       } catch (cppipc::ipcexception e) {
         throw(lambda::reinterpret_comm_failure(e));
       }
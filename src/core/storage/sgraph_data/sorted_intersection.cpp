@@ -0,0 +1,138 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <core/storage/sgraph_data/sorted_intersection.hpp>
+#include <algorithm>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define TURI_SORTED_INTERSECTION_HAS_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace turi {
+namespace sgraph_compute {
+
+namespace {
+
+typedef size_t (*intersect_fn)(const uint32_t*, size_t, const uint32_t*, size_t, uint32_t*);
+
+/// Gallop when the long array is this many times longer than the short one
+const size_t GALLOP_RATIO = 32;
+
+/**
+ * Looks every value of small up in large, searching from the previous match
+ * with exponentially growing steps and then binary search.
+ */
+size_t intersect_gallop(const uint32_t* small, size_t nsmall,
+                        const uint32_t* large, size_t nlarge,
+                        uint32_t* out) {
+  size_t n = 0;
+  size_t lo = 0;
+  for (size_t k = 0; k < nsmall && lo < nlarge; ++k) {
+    uint32_t x = small[k];
+    // large[0, lo) < x; find hi with large[hi] >= x
+    size_t hi = lo;
+    size_t step = 1;
+    while (hi < nlarge && large[hi] < x) {
+      lo = hi + 1;
+      hi += step;
+      step *= 2;
+    }
+    hi = std::min(hi, nlarge);
+    lo = std::lower_bound(large + lo, large + hi, x) - large;
+    if (lo < nlarge && large[lo] == x) {
+      out[n++] = x;
+      ++lo;
+    }
+  }
+  return n;
+}
+
+#ifdef TURI_SORTED_INTERSECTION_HAS_AVX2
+
+__attribute__((target("avx2")))
+size_t intersect_merge_avx2(const uint32_t* a, size_t na,
+                            const uint32_t* b, size_t nb,
+                            uint32_t* out) {
+  const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+  size_t i = 0, j = 0, n = 0;
+  // 8 values of a against 8 values of b: compare a with all 8 rotations of
+  // b, then move past the block with the smaller maximum (or both).
+  while (i + 8 <= na && j + 8 <= nb) {
+    __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+    __m256i vb = _mm256_loadu_si256((const __m256i*)(b + j));
+    __m256i eq = _mm256_cmpeq_epi32(va, vb);
+    for (size_t r = 1; r < 8; ++r) {
+      vb = _mm256_permutevar8x32_epi32(vb, rotate);
+      eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(va, vb));
+    }
+    uint32_t mask = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(eq));
+    while (mask) {
+      out[n++] = a[i + __builtin_ctz(mask)];
+      mask &= mask - 1;
+    }
+    uint32_t a_max = a[i + 7];
+    uint32_t b_max = b[j + 7];
+    if (a_max <= b_max) i += 8;
+    if (b_max <= a_max) j += 8;
+  }
+  return n + intersect_sorted_scalar(a + i, na - i, b + j, nb - j, out + n);
+}
+
+#endif
+
+intersect_fn select_merge_implementation() {
+#ifdef TURI_SORTED_INTERSECTION_HAS_AVX2
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return intersect_merge_avx2;
+#endif
+  return intersect_sorted_scalar;
+}
+
+intersect_fn get_merge_implementation() {
+  static const intersect_fn fn = select_merge_implementation();
+  return fn;
+}
+
+} // anonymous namespace
+
+size_t intersect_sorted_scalar(const uint32_t* a, size_t na,
+                               const uint32_t* b, size_t nb,
+                               uint32_t* out) {
+  size_t i = 0, j = 0, n = 0;
+  while (i < na && j < nb) {
+    if (a[i] < b[j]) {
+      ++i;
+    } else if (b[j] < a[i]) {
+      ++j;
+    } else {
+      out[n++] = a[i];
+      ++i, ++j;
+    }
+  }
+  return n;
+}
+
+size_t intersect_sorted(const uint32_t* a, size_t na,
+                        const uint32_t* b, size_t nb,
+                        uint32_t* out) {
+  if (na > nb) {
+    std::swap(a, b);
+    std::swap(na, nb);
+  }
+  if (na == 0) return 0;
+  if (nb / na >= GALLOP_RATIO) return intersect_gallop(a, na, b, nb, out);
+  return get_merge_implementation()(a, na, b, nb, out);
+}
+
+const char* intersect_sorted_implementation() {
+#ifdef TURI_SORTED_INTERSECTION_HAS_AVX2
+  if (get_merge_implementation() == intersect_merge_avx2) return "avx2";
+#endif
+  return "scalar";
+}
+
+} // end of sgraph_compute
+} // end of turi
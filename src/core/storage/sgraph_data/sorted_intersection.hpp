@@ -0,0 +1,59 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SGRAPH_SORTED_INTERSECTION_HPP
+#define TURI_SGRAPH_SORTED_INTERSECTION_HPP
+#include <cstdint>
+#include <cstddef>
+
+namespace turi {
+
+/**
+ * \ingroup sgraph_physical
+ * \addtogroup sgraph_compute SGraph Compute
+ * \{
+ */
+
+/**
+ * Graph Computation Functions
+ */
+namespace sgraph_compute {
+
+/**
+ * Writes the values common to the strictly increasing arrays a[0, na) and
+ * b[0, nb) to out, in increasing order, and returns how many there are.
+ * out must have room for min(na, nb) values.
+ *
+ * When one array is much longer than the other (a hub vertex against a low
+ * degree one) the values of the short array are looked up in the long one
+ * by galloping search, in O(short * log(long)). Otherwise both arrays are
+ * merged, 8 values against 8 at a time with AVX2 on x86-64 processors which
+ * support it (picked once at runtime), or one by one with
+ * \ref intersect_sorted_scalar(). All implementations produce exactly the
+ * same output.
+ */
+size_t intersect_sorted(const uint32_t* a, size_t na,
+                        const uint32_t* b, size_t nb,
+                        uint32_t* out);
+
+/**
+ * The plain merge implementation of \ref intersect_sorted().
+ */
+size_t intersect_sorted_scalar(const uint32_t* a, size_t na,
+                               const uint32_t* b, size_t nb,
+                               uint32_t* out);
+
+/**
+ * The name of the merge implementation intersect_sorted() uses on this
+ * machine: "avx2" or "scalar".
+ */
+const char* intersect_sorted_implementation();
+
+} // end of sgraph_compute
+
+/// \}
+} // end of turi
+
+#endif
@@ -9,10 +9,20 @@
 #include <core/system/cppipc/client/comm_client.hpp>
 #include <core/system/cppipc/common/object_factory_proxy.hpp>
 #include <minipsutil/minipsutil.h>
+#include <shmipc/shm_ring.hpp>
+#include <core/globals/globals.hpp>
+#include <timer/timer.hpp>
 #include <core/export.hpp>
 
 namespace cppipc {
 
+EXPORT int64_t CPPIPC_CLIENT_MAX_PENDING_CALLS = 8;
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            CPPIPC_CLIENT_MAX_PENDING_CALLS,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+
 EXPORT std::atomic<size_t>& get_running_command() {
   // A bit of a cleaner way to create a global variable
   static std::atomic<size_t> running_command;
@@ -33,7 +43,7 @@ comm_client::comm_client(std::vector<std::string> zkhosts,
                          const std::string secret_key,
                          const std::string server_public_key,
                          bool ops_interruptible):
-    object_socket(name, 2),
+    object_socket(name, 2 + CPPIPC_CLIENT_MAX_PENDING_CALLS),
     subscribesock(boost::bind(&comm_client::subscribe_callback, this, _1)),
     num_tolerable_ping_failures(num_tolerable_ping_failures),
     alternate_control_address(alternate_control_address),
@@ -43,7 +53,7 @@ comm_client::comm_client(std::vector<std::string> zkhosts,
     }
 
 comm_client::comm_client(std::string name, void* zmq_ctx) :
-    object_socket(name, 2),
+    object_socket(name, 2 + CPPIPC_CLIENT_MAX_PENDING_CALLS),
     subscribesock(boost::bind(&comm_client::subscribe_callback, this, _1)),
     endpoint_name(name) {
       ASSERT_MSG(boost::starts_with(name, "inproc://"), "This constructor only supports inproc address");
@@ -161,9 +171,41 @@ reply_status comm_client::start() {
       subscribesock.connect(pubaddress);
   }
 
+  start_shared_memory();
   return reply_status::OK;
 }
 
+void comm_client::start_shared_memory() {
+  if (!boost::starts_with(endpoint_name, "ipc://")) return;
+  const char* disable_shm = std::getenv("TURI_DISABLE_CPPIPC_SHM");
+  if (disable_shm != NULL && std::string(disable_shm) == "1") return;
+
+  std::string shm_address;
+  try {
+    shm_address = object_factory->get_shared_memory_address();
+  } catch (ipcexception& except) {
+    // an older server without shared memory support
+    logstream(LOG_INFO) << "Server does not support shared memory: "
+                        << except.what() << std::endl;
+    return;
+  }
+  if (shm_address.empty()) return;
+  std::unique_ptr<turi::shmipc::ring_channel> channel(new turi::shmipc::ring_channel());
+  if (!channel->connect(shm_address)) {
+    logstream(LOG_WARNING) << "Unable to connect to shared memory channel "
+                           << shm_address << ". Using " << endpoint_name << std::endl;
+    return;
+  }
+  boost::lock_guard<boost::mutex> guard(shm_lock);
+  shm_channel.swap(channel);
+  logstream(LOG_INFO) << "Object calls use shared memory channel " << shm_address << std::endl;
+}
+
+bool comm_client::using_shared_memory() {
+  boost::lock_guard<boost::mutex> guard(shm_lock);
+  return shm_channel != nullptr;
+}
+
 std::string comm_client::convert_generic_address_to_specific(std::string aux_addr) {
   std::string ret_str;
   // Has the server given us a "accept any TCP addresses" address?
@@ -207,6 +249,8 @@ comm_client::~comm_client() {
 void comm_client::stop() {
   if (!started) return;
 
+  stop_async_calls();
+
   stop_ping_thread();
 
   stop_status_callback_thread();
@@ -214,7 +258,11 @@ void comm_client::stop() {
   // clear all status callbacks
   clear_status_watch();
 
-  // close all sockets
+  // close the shared memory channel and all sockets
+  {
+    boost::lock_guard<boost::mutex> guard(shm_lock);
+    shm_channel.reset();
+  }
   object_socket.close();
   if(control_socket != NULL) {
     control_socket->close();
@@ -348,9 +396,62 @@ int comm_client::internal_call_impl(call_message& call,
   if(control && control_socket != NULL) {
     return control_socket->request_master(callmsg, ret, timeout);
   }
+  if (!control) {
+    // object calls go through the shared memory channel if there is one,
+    // and through the socket if another thread is using it
+    boost::unique_lock<boost::mutex> guard(shm_lock, boost::try_to_lock);
+    if (guard.owns_lock() && shm_channel) {
+      int status = shared_memory_call(callmsg, ret, timeout);
+      if (status != -1) return status;
+    }
+  }
   return object_socket.request_master(callmsg, ret, timeout);
 }
 
+int comm_client::shared_memory_call(nanosockets::zmq_msg_vector& callmsg,
+                                    nanosockets::zmq_msg_vector& ret,
+                                    size_t timeout) {
+  // timeout is in seconds, 0 meaning forever, like for the object socket
+  const size_t channel_timeout = (timeout == 0) ? (size_t)(-1) : timeout;
+  turi::timer ti;
+  turi::oarchive oarc;
+  callmsg.save(oarc);
+  bool sent = shm_channel->send(oarc.buf, oarc.off, channel_timeout);
+  free(oarc.buf);
+  if (!sent) {
+    logstream(LOG_WARNING) << "Unable to send on the shared memory channel. Using "
+                           << endpoint_name << std::endl;
+    shm_channel.reset();
+    return -1;
+  }
+  size_t receive_timeout = channel_timeout;
+  if (timeout > 0) {
+    size_t elapsed = ti.current_time();
+    receive_timeout = (elapsed < timeout) ? timeout - elapsed : 0;
+  }
+  const char* buf = nullptr;
+  size_t len = 0;
+  if (shm_channel->receive(&buf, &len, receive_timeout)) {
+    {
+      turi::iarchive iarc(buf, len);
+      ret.load(iarc);
+    }
+    shm_channel->release_received();
+    return 0;
+  }
+  poll_server_pid_is_running();
+  if (server_alive && shm_channel->is_connected()) {
+    // A reply cannot be abandoned without desynchronizing the channel, so
+    // later calls go through the object socket
+    logstream(LOG_WARNING) << "Timed out waiting on the shared memory channel. Using "
+                           << endpoint_name << std::endl;
+    shm_channel.reset();
+    return EAGAIN;
+  }
+  shm_channel.reset();
+  return EHOSTUNREACH;
+}
+
 int comm_client::internal_call(call_message& call, reply_message& reply, bool control) {
   if (!started) {
     return ENOTCONN;
@@ -374,6 +475,69 @@ int comm_client::internal_call(call_message& call, reply_message& reply, bool co
   return status;
 }
 
+void comm_client::submit_async_call(std::shared_ptr<call_message> call,
+                                    std::function<void(int, reply_message&)> done) {
+  boost::lock_guard<boost::mutex> guard(async_call_lock);
+  if (async_call_stopping) {
+    reply_message reply;
+    done(ECANCELED, reply);
+    return;
+  }
+  async_call_queue.push_back(async_call_job{call, done});
+  if (num_idle_async_call_threads == 0 &&
+      async_call_threads.size() < (size_t)CPPIPC_CLIENT_MAX_PENDING_CALLS) {
+    async_call_threads.emplace_back(new boost::thread([this]() {
+      this->async_call_thread_function();
+    }));
+  } else {
+    async_call_cond.notify_one();
+  }
+}
+
+void comm_client::async_call_thread_function() {
+  boost::unique_lock<boost::mutex> lock(async_call_lock);
+  while(true) {
+    while (async_call_queue.empty() && !async_call_stopping) {
+      ++num_idle_async_call_threads;
+      async_call_cond.wait(lock);
+      --num_idle_async_call_threads;
+    }
+    if (async_call_queue.empty()) break;
+    async_call_job job = async_call_queue.front();
+    async_call_queue.pop_front();
+    bool cancelled = async_call_stopping;
+    lock.unlock();
+
+    std::string command_id = job.call->properties["command_id"];
+    reply_message reply;
+    int status = cancelled ? ECANCELED : internal_call(*job.call, reply);
+    if (status == 0) {
+      // the server echoes the command id of the call it replies to
+      auto reply_id = reply.properties.find("command_id");
+      if (reply_id != reply.properties.end() && reply_id->second != command_id) {
+        logstream(LOG_ERROR) << "Reply to command " << reply_id->second
+                             << " received for command " << command_id << std::endl;
+        reply.clear();
+        status = EPROTO;
+      }
+    }
+    job.done(status, reply);
+    job.call.reset();
+
+    lock.lock();
+  }
+}
+
+void comm_client::stop_async_calls() {
+  std::vector<std::unique_ptr<boost::thread>> threads;
+  {
+    boost::lock_guard<boost::mutex> guard(async_call_lock);
+    async_call_stopping = true;
+    async_call_cond.notify_all();
+    threads.swap(async_call_threads);
+  }
+  for (auto& thread : threads) thread->join();
+}
 
 size_t comm_client::make_object(std::string object_type_name) {
   if (!started) {
@@ -383,6 +547,17 @@ size_t comm_client::make_object(std::string object_type_name) {
 }
 
 
+void comm_client::set_server_object_id_seed(size_t seed) {
+  if (!started) {
+    throw ipcexception(reply_status::COMM_FAILURE, 0, "Client not started");
+  }
+  object_factory->set_object_id_seed(seed);
+}
+
+int comm_client::raw_call(call_message& call, reply_message& reply) {
+  return internal_call(call, reply);
+}
+
 std::string comm_client::ping(std::string pingval) {
   if (!started) {
     throw ipcexception(reply_status::COMM_FAILURE, 0, "Client not started");
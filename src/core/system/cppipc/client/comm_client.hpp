@@ -6,8 +6,11 @@
 #ifndef CPPIPC_SERVER_COMM_CLIENT_HPP
 #define CPPIPC_SERVER_COMM_CLIENT_HPP
 #include <map>
+#include <deque>
 #include <memory>
 #include <chrono>
+#include <future>
+#include <functional>
 #include <core/parallel/atomic.hpp>
 #include <core/logging/logger.hpp>
 #include <boost/thread/thread.hpp>
@@ -25,9 +28,23 @@
 #include <cctype>
 #include <atomic>
 
+namespace turi {
+namespace shmipc {
+  class ring_channel;
+}
+}
+
 namespace cppipc {
 namespace nanosockets = turi::nanosockets;
 
+/**
+ * \ingroup cppipc
+ * The maximum number of calls issued with comm_client::async_call which are
+ * in flight at the same time on a connection. Further calls are queued.
+ * Defaults to 8.
+ */
+extern int64_t CPPIPC_CLIENT_MAX_PENDING_CALLS;
+
 std::atomic<size_t>& get_running_command();
 std::atomic<size_t>& get_cancelled_command();
 
@@ -62,6 +79,37 @@ struct deserialize_return_and_clear<void, false> {
   }
 };
 
+/**
+ * \ingroup cppipc
+ * \internal
+ * Sets the value of a promise to the result of fn(), or to the exception it
+ * throws. Works correctly for void types.
+ */
+template <typename RetType>
+struct fulfill_promise {
+  template <typename Fn>
+  static void exec(std::promise<RetType>& promise, Fn fn) {
+    try {
+      promise.set_value(fn());
+    } catch (...) {
+      promise.set_exception(std::current_exception());
+    }
+  }
+};
+
+template <>
+struct fulfill_promise<void> {
+  template <typename Fn>
+  static void exec(std::promise<void>& promise, Fn fn) {
+    try {
+      fn();
+      promise.set_value();
+    } catch (...) {
+      promise.set_exception(std::current_exception());
+    }
+  }
+};
+
 
 } // namespace detail
 
@@ -234,6 +282,59 @@ class EXPORT comm_client {
                          bool control,
                          size_t timeout = 0);
 
+  /**
+   * Sends an object call over the shared memory channel and waits for the
+   * reply, for up to timeout seconds (0 waits as long as the server is
+   * alive). Requires shm_lock.
+   * Returns -1 if the call could not be sent, in which case the channel is
+   * dropped and the call may be retried over the object socket. On timeout
+   * the channel is dropped as well, and EAGAIN is returned.
+   */
+  int shared_memory_call(nanosockets::zmq_msg_vector& callmsg,
+                         nanosockets::zmq_msg_vector& ret,
+                         size_t timeout = 0);
+
+  /**
+   * Moves object calls to a shared memory channel if the server is on the
+   * same host, the endpoint being an ipc:// address.
+   */
+  void start_shared_memory();
+
+  // Object calls go through this channel instead of object_socket when set
+  std::unique_ptr<turi::shmipc::ring_channel> shm_channel;
+  boost::mutex shm_lock;
+
+  /// A call issued by async_call, and the function receiving its reply
+  struct async_call_job {
+    std::shared_ptr<call_message> call;
+    std::function<void(int, reply_message&)> done;
+  };
+
+  /**
+   * Pipelined calls waiting to be sent, and the threads sending them. Each
+   * thread has one call in flight at a time, on its own connection.
+   */
+  std::deque<async_call_job> async_call_queue;
+  std::vector<std::unique_ptr<boost::thread>> async_call_threads;
+  size_t num_idle_async_call_threads = 0;
+  bool async_call_stopping = false;
+  boost::mutex async_call_lock;
+  boost::condition_variable async_call_cond;
+
+  /**
+   * Queues a call for an async call thread, starting one if all are busy and
+   * there are fewer than \ref CPPIPC_CLIENT_MAX_PENDING_CALLS.
+   * done(status, reply) is called on that thread with the result of
+   * internal_call, or with ECANCELED if the client is stopped first.
+   */
+  void submit_async_call(std::shared_ptr<call_message> call,
+                         std::function<void(int, reply_message&)> done);
+
+  void async_call_thread_function();
+
+  /// Joins the async call threads, cancelling the calls not yet sent
+  void stop_async_calls();
+
   /** Checks is the pid set with set_server_alive_watch_pid is running.
    * Sets server_running to false if pid is no longer running.
    */
@@ -408,6 +509,12 @@ class EXPORT comm_client {
    */
   void stop();
 
+  /**
+   * Returns true if object calls go through a shared memory channel rather
+   * than the object socket.
+   */
+  bool using_shared_memory();
+
   /**
    * Creates an object of a given type on the remote machine.
    * Returns an object ID. If return value is (-1), this is a failure.
@@ -431,6 +538,22 @@ class EXPORT comm_client {
    */
   void delete_object(size_t objectid);
 
+  /**
+   * Sets the state from which the server generates new object IDs. See
+   * comm_server::get_object_id_seed().
+   *
+   * \note This call redirects to the object_factory_proxy
+   */
+  void set_server_object_id_seed(size_t seed);
+
+  /**
+   * Sends a call whose arguments are already serialized, such as one from a
+   * \ref call_recording, and receives its reply. Returns 0 on success, or
+   * the error code of the communication failure. The call message is
+   * cleared.
+   */
+  int raw_call(call_message& call, reply_message& reply);
+
   /**
    * Functions for manipulating local reference counting data structure
    */
@@ -661,6 +784,15 @@ class EXPORT comm_client {
     // Reset running command
     get_running_command().store(0);
 
+    return unpack_reply<return_type>(retcode, reply);
+  }
+
+  /**
+   * Returns the value of the reply of a call, or throws the exception
+   * matching its status. retcode is the return of internal_call.
+   */
+  template <typename RetType>
+  RetType unpack_reply(int retcode, reply_message& reply) {
     bool success = (retcode == 0);
     std::string custommsg;
     if (reply.body != NULL && reply.bodylen > 0) {
@@ -687,10 +819,61 @@ class EXPORT comm_client {
       }
     } else {
       detail::set_deserializer_to_client(this);
-      return detail::deserialize_return_and_clear<return_type,
-             std::is_convertible<return_type, ipc_object_base*>::value>::exec(*this, reply);
+      return detail::deserialize_return_and_clear<RetType,
+             std::is_convertible<RetType, ipc_object_base*>::value>::exec(*this, reply);
     }
   }
+
+  /**
+   * Calls a remote function without waiting for it to complete, returning a
+   * future of its result. The future throws the same exceptions as
+   * \ref call(). Unlike call(), this can be used from any thread, and calls
+   * are not interrupted by CTRL-C.
+   *
+   * Up to \ref CPPIPC_CLIENT_MAX_PENDING_CALLS calls are in flight at once,
+   * each on its own connection, and are matched to their replies by command
+   * id. Calls in flight may complete in any order. The server runs them
+   * concurrently only if the functions were registered with
+   * REGISTER_THREAD_SAFE, and otherwise one at a time, in an unspecified
+   * order: calls which depend on each other should wait on the previous
+   * future. The remote object must not be released before the future is
+   * ready.
+   *
+   * \code
+   * std::vector<std::future<std::string>> replies;
+   * for (size_t i = 0; i < 1000; ++i) {
+   *   replies.push_back(proxy.async_call(&object_base::ping, std::to_string(i)));
+   * }
+   * for (auto& reply: replies) std::cout << reply.get();
+   * \endcode
+   */
+  template <typename MemFn, typename... Args>
+  std::future<typename detail::member_function_return_type<MemFn>::type>
+  async_call(size_t objectid, MemFn f, const Args&... args) {
+    if (!started) {
+      throw ipcexception(reply_status::COMM_FAILURE, 0, "Client not started");
+    }
+    typedef typename detail::member_function_return_type<MemFn>::type return_type;
+    auto msg = std::make_shared<call_message>();
+    prepare_call_message_structure(objectid, f, *msg);
+    turi::oarchive oarc;
+    cppipc::issue(oarc, f, args...);
+    // see call() for the padding
+    if (oarc.off & 1) oarc.write(" ", 1);
+    msg->body = oarc.buf;
+    msg->bodylen = oarc.off;
+    msg->properties.insert(std::make_pair<std::string, std::string>(
+          "command_id", std::to_string(m_command_id.inc())));
+
+    auto promise = std::make_shared<std::promise<return_type>>();
+    auto future = promise->get_future();
+    submit_async_call(msg, [this, promise](int retcode, reply_message& reply) {
+      detail::fulfill_promise<return_type>::exec(*promise, [&]() {
+        return this->template unpack_reply<return_type>(retcode, reply);
+      });
+    });
+    return future;
+  }
 };
 
 } // cppipc
@@ -7,6 +7,7 @@
 #define CPPIPC_CLIENT_CLIENT_HPP
 #include <string>
 #include <map>
+#include <future>
 #include <core/system/cppipc/client/comm_client.hpp>
 namespace cppipc {
 
@@ -139,6 +140,12 @@ class object_proxy {
     comm.register_function(f, function_string);
   }
 
+  /// \internal do not use
+  template <typename MemFn>
+  void register_thread_safe_function(MemFn f, std::string function_string) {
+    comm.register_function(f, function_string);
+  }
+
   /**
    * Calls a remote function returning the result.
    * The remote function's return is forwarded and returned here.
@@ -150,6 +157,16 @@ class object_proxy {
     return comm.call(remote_object_id, f, args...);
   }
 
+  /**
+   * Calls a remote function without waiting for it to complete, returning a
+   * future of the result. See \ref comm_client::async_call.
+   */
+  template <typename MemFn, typename... Args>
+  std::future<typename detail::member_function_return_type<MemFn>::type>
+  async_call(MemFn f, const Args&... args) {
+    return comm.async_call(remote_object_id, f, args...);
+  }
+
  private:
   comm_client& comm;
   size_t remote_object_id;
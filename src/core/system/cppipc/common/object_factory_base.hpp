@@ -59,6 +59,19 @@ class object_factory_base {
    */
   virtual void sync_objects(std::vector<size_t> object_ids, bool active_list) = 0;
 
+  /**
+   * Returns the name of a new shared memory channel for the client to send
+   * its object calls on, or an empty string if there is none. Only used by
+   * clients on the same host as the server.
+   */
+  virtual std::string get_shared_memory_address() = 0;
+
+  /**
+   * Sets the state from which the server generates the IDs of new objects,
+   * so that replaying a recording of calls creates the same object IDs.
+   */
+  virtual void set_object_id_seed(size_t seed) = 0;
+
   virtual ~object_factory_base() { }
 
   REGISTRATION_BEGIN(object_factory)
@@ -68,6 +81,8 @@ class object_factory_base {
       REGISTER(object_factory_base::get_status_publish_address)
       REGISTER(object_factory_base::get_control_address)
       REGISTER(object_factory_base::sync_objects)
+      REGISTER(object_factory_base::get_shared_memory_address)
+      REGISTER(object_factory_base::set_object_id_seed)
   REGISTRATION_END
 };
 
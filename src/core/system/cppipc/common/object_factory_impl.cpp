@@ -58,4 +58,12 @@ void object_factory_impl::sync_objects(std::vector<size_t> object_ids, bool acti
   srv.delete_unused_objects(object_ids, active_list);
 }
 
+std::string object_factory_impl::get_shared_memory_address() {
+  return srv.get_shared_memory_address();
+}
+
+void object_factory_impl::set_object_id_seed(size_t seed) {
+  srv.set_object_id_seed(seed);
+}
+
 } // namespace cppipc
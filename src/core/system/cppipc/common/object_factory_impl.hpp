@@ -57,6 +57,10 @@ class object_factory_impl: public object_factory_base {
 
   void sync_objects(std::vector<size_t> object_ids, bool input_sorted);
 
+  std::string get_shared_memory_address();
+
+  void set_object_id_seed(size_t seed);
+
   /**
    * \internal
    * Stores a constructor for an object type
@@ -47,6 +47,14 @@ class object_factory_proxy: public object_factory_base {
     clt.call(&object_factory_base::sync_objects, object_ids, input_sorted);
   }
 
+  inline std::string get_shared_memory_address() {
+    return clt.call(&object_factory_base::get_shared_memory_address);
+  }
+
+  inline void set_object_id_seed(size_t seed) {
+    clt.call(&object_factory_base::set_object_id_seed, seed);
+  }
+
 };
 
 
@@ -89,6 +89,17 @@
       reg.register_function(&FN, std::string(XSTRINGIFY(FN))); \
 }
 
+/**
+ * \ingroup cppipc
+ * Like REGISTER, but also declares the member function safe to run
+ * concurrently with any other call on the server, so that pipelined calls
+ * to it are served in parallel. Only use it on functions which do not modify
+ * shared state without their own locking.
+ */
+#define REGISTER_THREAD_SAFE(FN) { \
+      reg.register_thread_safe_function(&FN, std::string(XSTRINGIFY(FN))); \
+}
+
 
 
 #define REGISTRATION_END }
@@ -0,0 +1,36 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <core/logging/logger.hpp>
+#include <core/system/cppipc/server/call_recorder.hpp>
+
+namespace cppipc {
+
+static constexpr size_t CALL_RECORDING_VERSION = 1;
+
+void recorded_call::save(turi::oarchive& oarc) const {
+  oarc << start_us << objectid << function_name << properties
+       << body << execution_us << error;
+}
+
+void recorded_call::load(turi::iarchive& iarc) {
+  iarc >> start_us >> objectid >> function_name >> properties
+       >> body >> execution_us >> error;
+}
+
+void call_recording::save(turi::oarchive& oarc) const {
+  oarc << CALL_RECORDING_VERSION << object_id_seed << calls;
+}
+
+void call_recording::load(turi::iarchive& iarc) {
+  size_t version = 0;
+  iarc >> version;
+  if (version != CALL_RECORDING_VERSION) {
+    log_and_throw("Unsupported call recording version " + std::to_string(version));
+  }
+  iarc >> object_id_seed >> calls;
+}
+
+} // cppipc
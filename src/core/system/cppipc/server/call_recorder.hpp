@@ -0,0 +1,54 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef CPPIPC_SERVER_CALL_RECORDER_HPP
+#define CPPIPC_SERVER_CALL_RECORDER_HPP
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <core/storage/serialization/serialization_includes.hpp>
+
+namespace cppipc {
+
+/**
+ * \ingroup cppipc
+ * One object call received by a comm_server while recording, with its
+ * serialized arguments exactly as received. Arguments which are objects of
+ * the server, such as SFrames, are serialized as their object IDs, which a
+ * replay reproduces by starting from the same object ID seed.
+ */
+struct recorded_call {
+  /// Microseconds from the start of the recording to the arrival of the call
+  uint64_t start_us = 0;
+  size_t objectid = 0;
+  std::string function_name;
+  std::map<std::string, std::string> properties;
+  /// The serialized arguments
+  std::string body;
+  /// How long the call ran on the recording server, in microseconds
+  uint64_t execution_us = 0;
+  bool error = false;
+
+  void save(turi::oarchive& oarc) const;
+  void load(turi::iarchive& iarc);
+};
+
+/**
+ * \ingroup cppipc
+ * The stream of object calls received by a comm_server between
+ * comm_server::start_recording() and comm_server::stop_recording().
+ */
+struct call_recording {
+  /// The state of the object ID generator of the server when recording started
+  size_t object_id_seed = 0;
+  std::vector<recorded_call> calls;
+
+  void save(turi::oarchive& oarc) const;
+  void load(turi::iarchive& iarc);
+};
+
+} // cppipc
+#endif
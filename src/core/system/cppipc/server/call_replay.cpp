@@ -0,0 +1,168 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <core/logging/logger.hpp>
+#include <core/storage/serialization/dir_archive.hpp>
+#include <core/system/cppipc/client/comm_client.hpp>
+#include <core/system/cppipc/common/message_types.hpp>
+#include <core/system/cppipc/server/call_replay.hpp>
+
+namespace cppipc {
+
+namespace {
+
+const char* RECORDING_CONTENTS = "cppipc_call_recording";
+
+/**
+ * Calls on the object factory which only make sense to the client which
+ * made them: the server addresses, and pings.
+ */
+bool is_connection_call(const recorded_call& call) {
+  if (call.objectid != 0) return false;
+  for (const char* name : {"object_factory_base::get_status_publish_address",
+                           "object_factory_base::get_control_address",
+                           "object_factory_base::get_shared_memory_address",
+                           "object_factory_base::ping"}) {
+    if (call.function_name.compare(0, std::strlen(name), name) == 0) return true;
+  }
+  return false;
+}
+
+std::string trimmed_name(const std::string& function_name) {
+  return function_name.substr(0, function_name.find(' '));
+}
+
+} // anonymous namespace
+
+void save_call_recording(const call_recording& recording, const std::string& directory) {
+  turi::dir_archive dir;
+  dir.open_directory_for_write(directory);
+  dir.set_metadata("contents", RECORDING_CONTENTS);
+  dir.set_metadata("num_calls", std::to_string(recording.calls.size()));
+  turi::oarchive oarc(dir);
+  oarc << recording;
+  if (dir.get_output_stream()->fail()) {
+    log_and_throw_io_failure("Unable to write the call recording to " + directory);
+  }
+  dir.close();
+}
+
+call_recording load_call_recording(const std::string& directory) {
+  turi::dir_archive dir;
+  dir.open_directory_for_read(directory);
+  std::string contents;
+  if (!dir.get_metadata("contents", contents) || contents != RECORDING_CONTENTS) {
+    log_and_throw(directory + " does not hold a call recording");
+  }
+  call_recording ret;
+  turi::iarchive iarc(dir);
+  iarc >> ret;
+  dir.close();
+  return ret;
+}
+
+replay_report replay_calls(comm_client& client, const call_recording& recording) {
+  replay_report report;
+  report.call_us.resize(recording.calls.size(), 0);
+
+  client.set_server_object_id_seed(recording.object_id_seed);
+
+  for (size_t i = 0; i < recording.calls.size(); ++i) {
+    const recorded_call& recorded = recording.calls[i];
+    if (is_connection_call(recorded)) {
+      ++report.num_skipped;
+      continue;
+    }
+
+    call_message call;
+    call.objectid = recorded.objectid;
+    call.function_name = recorded.function_name;
+    call.properties = recorded.properties;
+    // the body is freed with the message
+    char* body = (char*)malloc(std::max<size_t>(recorded.body.size(), 1));
+    memcpy(body, recorded.body.data(), recorded.body.size());
+    call.body = body;
+    call.bodylen = recorded.body.size();
+
+    reply_message reply;
+    auto start = std::chrono::steady_clock::now();
+    int retcode = client.raw_call(call, reply);
+    uint64_t elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    bool error = retcode != 0 || reply.status != reply_status::OK;
+    if (error && !recorded.error) {
+      std::string message = retcode != 0 ? std::string(std::strerror(retcode))
+          : reply_status_to_string(reply.status);
+      if (reply.body != nullptr && reply.bodylen > 0) {
+        message += ": " + std::string(reply.body, reply.bodylen);
+      }
+      logstream(LOG_WARNING) << "Replayed call " << i << " to "
+                             << trimmed_name(recorded.function_name)
+                             << " failed: " << message << std::endl;
+    }
+    if (retcode != 0) {
+      log_and_throw("Lost the connection to the server replaying call " + std::to_string(i));
+    }
+
+    auto& method = report.methods[trimmed_name(recorded.function_name)];
+    ++method.num_calls;
+    method.recorded_us += recorded.execution_us;
+    method.replayed_us += elapsed_us;
+    ++report.num_calls;
+    report.recorded_us += recorded.execution_us;
+    report.replayed_us += elapsed_us;
+    report.call_us[i] = elapsed_us;
+    if (error && !recorded.error) {
+      ++method.num_errors;
+      ++report.num_errors;
+    }
+  }
+  return report;
+}
+
+std::string replay_report::to_string() const {
+  std::vector<std::pair<std::string, method_timing>> sorted(methods.begin(), methods.end());
+  std::sort(sorted.begin(), sorted.end(),
+            [](const std::pair<std::string, method_timing>& a,
+               const std::pair<std::string, method_timing>& b) {
+              return a.second.replayed_us > b.second.replayed_us;
+            });
+
+  std::ostringstream ss;
+  ss << std::fixed << std::setprecision(3);
+  ss << std::left << std::setw(60) << "method" << std::right
+     << std::setw(8) << "calls" << std::setw(8) << "errors"
+     << std::setw(14) << "recorded (s)" << std::setw(14) << "replayed (s)"
+     << std::setw(10) << "ratio" << "\n";
+  auto print_row = [&](const std::string& name, size_t calls, size_t errors,
+                       uint64_t recorded, uint64_t replayed) {
+    ss << std::left << std::setw(60) << name << std::right
+       << std::setw(8) << calls << std::setw(8) << errors
+       << std::setw(14) << recorded * 1e-6 << std::setw(14) << replayed * 1e-6
+       << std::setw(10);
+    if (recorded > 0) {
+      ss << double(replayed) / recorded;
+    } else {
+      ss << "-";
+    }
+    ss << "\n";
+  };
+  for (const auto& m : sorted) {
+    print_row(m.first, m.second.num_calls, m.second.num_errors,
+              m.second.recorded_us, m.second.replayed_us);
+  }
+  print_row("total", num_calls, num_errors, recorded_us, replayed_us);
+  if (num_skipped > 0) ss << num_skipped << " connection calls skipped\n";
+  return ss.str();
+}
+
+} // cppipc
@@ -0,0 +1,81 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef CPPIPC_SERVER_CALL_REPLAY_HPP
+#define CPPIPC_SERVER_CALL_REPLAY_HPP
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <core/system/cppipc/server/call_recorder.hpp>
+
+namespace cppipc {
+
+class comm_client;
+
+/**
+ * \ingroup cppipc
+ * Saves a recording of calls (see comm_server::start_recording()) as a
+ * directory archive, which can be handed over as a replayable bug report.
+ * Throws if the directory cannot be written.
+ */
+void save_call_recording(const call_recording& recording, const std::string& directory);
+
+/**
+ * \ingroup cppipc
+ * Loads a recording saved by \ref save_call_recording(). Throws if the
+ * directory does not hold one.
+ */
+call_recording load_call_recording(const std::string& directory);
+
+/**
+ * \ingroup cppipc
+ * The timings of a replay, against those of the recording.
+ */
+struct replay_report {
+  struct method_timing {
+    size_t num_calls = 0;
+    size_t num_errors = 0;
+    /// Execution time on the recording server
+    uint64_t recorded_us = 0;
+    /// Round trip time of the replay
+    uint64_t replayed_us = 0;
+  };
+
+  /// By function name
+  std::map<std::string, method_timing> methods;
+
+  size_t num_calls = 0;
+  size_t num_skipped = 0;
+  size_t num_errors = 0;
+  uint64_t recorded_us = 0;
+  uint64_t replayed_us = 0;
+
+  /**
+   * Per-call replayed round trip times in microseconds, in the order of
+   * the recording. Skipped calls have 0.
+   */
+  std::vector<uint64_t> call_us;
+
+  /// A table of the methods, slowest replay first, with the totals
+  std::string to_string() const;
+};
+
+/**
+ * \ingroup cppipc
+ * Re-executes the calls of a recording, in order, on the server client is
+ * connected to, which should host the same object types as the recording
+ * server. The server is first set to the object ID seed of the recording,
+ * so that the objects created by the replay get the IDs the recorded calls
+ * refer to. The calls establishing a connection to the recording server
+ * (its addresses and pings) are skipped.
+ *
+ * Calls which failed when recorded are expected to fail again, and are not
+ * counted as errors.
+ */
+replay_report replay_calls(comm_client& client, const call_recording& recording);
+
+} // cppipc
+#endif
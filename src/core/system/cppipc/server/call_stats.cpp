@@ -0,0 +1,192 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <cstdio>
+#include <boost/thread/lock_guard.hpp>
+#include <core/logging/logger.hpp>
+#include <core/globals/globals.hpp>
+#include <core/export.hpp>
+#include <core/system/cppipc/server/call_stats.hpp>
+
+namespace cppipc {
+
+EXPORT int64_t CPPIPC_SERVER_CALL_STATS = 1;
+EXPORT std::string CPPIPC_SERVER_TRACE_FILE = "";
+
+REGISTER_GLOBAL(int64_t, CPPIPC_SERVER_CALL_STATS, true);
+REGISTER_GLOBAL(std::string, CPPIPC_SERVER_TRACE_FILE, true);
+
+/**************************************************************************/
+/*                                                                        */
+/*                           latency_histogram                            */
+/*                                                                        */
+/**************************************************************************/
+
+latency_histogram::latency_histogram() : m_buckets(NUM_BUCKETS, 0) { }
+
+size_t latency_histogram::bucket_index(uint64_t value) {
+  // values below SUB_BUCKETS have a bucket each. Above, the bucket is the
+  // position of the top bit, and the SUB_BUCKET_BITS bits below it.
+  if (value < SUB_BUCKETS) return value;
+  size_t top_bit = 63 - __builtin_clzll(value);
+  size_t shift = top_bit - SUB_BUCKET_BITS;
+  size_t sub_bucket = (value >> shift) & (SUB_BUCKETS - 1);
+  return (shift + 1) * SUB_BUCKETS + sub_bucket;
+}
+
+uint64_t latency_histogram::bucket_upper_bound(size_t index) {
+  if (index < SUB_BUCKETS) return index;
+  size_t shift = index / SUB_BUCKETS - 1;
+  uint64_t sub_bucket = index % SUB_BUCKETS;
+  uint64_t lower = (SUB_BUCKETS + sub_bucket) << shift;
+  return lower + ((uint64_t(1) << shift) - 1);
+}
+
+void latency_histogram::add(uint64_t value) {
+  ++m_buckets[bucket_index(value)];
+  ++m_count;
+  m_sum += value;
+  m_max = std::max(m_max, value);
+}
+
+void latency_histogram::merge(const latency_histogram& other) {
+  for (size_t i = 0; i < NUM_BUCKETS; ++i) m_buckets[i] += other.m_buckets[i];
+  m_count += other.m_count;
+  m_sum += other.m_sum;
+  m_max = std::max(m_max, other.m_max);
+}
+
+uint64_t latency_histogram::quantile(double q) const {
+  if (m_count == 0) return 0;
+  q = std::min(std::max(q, 0.0), 1.0);
+  size_t rank = std::max<size_t>(1, size_t(std::ceil(q * m_count)));
+  size_t seen = 0;
+  for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+    seen += m_buckets[i];
+    if (seen >= rank) return std::min(bucket_upper_bound(i), m_max);
+  }
+  return m_max;
+}
+
+/**************************************************************************/
+/*                                                                        */
+/*                               call_stats                               */
+/*                                                                        */
+/**************************************************************************/
+
+call_stats& call_stats::get_instance() {
+  static call_stats* instance = new call_stats();
+  return *instance;
+}
+
+void call_stats::record(const call_record& call) {
+  {
+    boost::lock_guard<boost::mutex> guard(m_lock);
+    method_call_stats& stats = m_stats[call.name];
+    ++stats.num_calls;
+    if (call.error) ++stats.num_errors;
+    stats.queue_wait_us.add(call.queue_wait_us);
+    stats.execution_us.add(call.execution_us);
+    stats.request_bytes += call.request_bytes;
+    stats.reply_bytes += call.reply_bytes;
+    stats.max_request_bytes = std::max(stats.max_request_bytes, call.request_bytes);
+    stats.max_reply_bytes = std::max(stats.max_reply_bytes, call.reply_bytes);
+  }
+  if (!CPPIPC_SERVER_TRACE_FILE.empty()) write_trace(call);
+}
+
+std::map<std::string, method_call_stats> call_stats::get_stats() const {
+  boost::lock_guard<boost::mutex> guard(m_lock);
+  return m_stats;
+}
+
+void call_stats::reset() {
+  boost::lock_guard<boost::mutex> guard(m_lock);
+  m_stats.clear();
+}
+
+static std::string random_hex(size_t num_digits) {
+  static thread_local std::mt19937_64 rng(std::random_device{}());
+  std::string ret;
+  while (ret.size() < num_digits) {
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)rng());
+    ret += buf;
+  }
+  ret.resize(num_digits);
+  return ret;
+}
+
+std::string call_stats::make_trace_id() {
+  return random_hex(32);
+}
+
+uint64_t call_stats::now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static std::string json_escape(const std::string& s) {
+  std::string ret;
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      ret += '\\';
+      ret += c;
+    } else if ((unsigned char)c < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", (unsigned int)c);
+      ret += buf;
+    } else {
+      ret += c;
+    }
+  }
+  return ret;
+}
+
+void call_stats::write_trace(const call_record& call) {
+  uint64_t end_time_ns = call.start_time_ns
+                         + 1000 * (call.queue_wait_us + call.execution_us);
+  auto int_attribute = [](const char* key, uint64_t value) {
+    return std::string("{\"key\":\"") + key + "\",\"value\":{\"intValue\":\""
+           + std::to_string(value) + "\"}}";
+  };
+  std::ostringstream line;
+  line << "{\"traceId\":\""
+       << (call.trace_id.empty() ? make_trace_id() : call.trace_id)
+       << "\",\"spanId\":\"" << random_hex(16)
+       << "\",\"name\":\"" << json_escape(call.name)
+       << "\",\"kind\":2"
+       << ",\"startTimeUnixNano\":\"" << call.start_time_ns
+       << "\",\"endTimeUnixNano\":\"" << end_time_ns
+       << "\",\"attributes\":["
+       << int_attribute("cppipc.queue_wait_us", call.queue_wait_us) << ","
+       << int_attribute("cppipc.execution_us", call.execution_us) << ","
+       << int_attribute("cppipc.request_bytes", call.request_bytes) << ","
+       << int_attribute("cppipc.reply_bytes", call.reply_bytes)
+       << "],\"status\":{\"code\":" << (call.error ? 2 : 1) << "}}\n";
+
+  boost::lock_guard<boost::mutex> guard(m_trace_lock);
+  // the trace file can be changed at runtime
+  std::string path = CPPIPC_SERVER_TRACE_FILE;
+  if (path.empty()) return;
+  if (path != m_trace_path || m_trace_file == nullptr) {
+    m_trace_path = path;
+    m_trace_file.reset(new std::ofstream(path, std::ios::app));
+    if (!m_trace_file->good()) {
+      logstream(LOG_WARNING) << "Unable to open call trace file " << path << std::endl;
+    }
+  }
+  if (m_trace_file->good()) {
+    (*m_trace_file) << line.str();
+    m_trace_file->flush();
+  }
+}
+
+} // cppipc
@@ -0,0 +1,153 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef CPPIPC_SERVER_CALL_STATS_HPP
+#define CPPIPC_SERVER_CALL_STATS_HPP
+#include <cstdint>
+#include <string>
+#include <map>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <boost/thread/mutex.hpp>
+
+namespace cppipc {
+
+/**
+ * \ingroup cppipc
+ * If non-zero (the default), the comm_server and the toolkit function
+ * registry record the latency of every call they serve in \ref call_stats.
+ */
+extern int64_t CPPIPC_SERVER_CALL_STATS;
+
+/**
+ * \ingroup cppipc
+ * If not empty, every call recorded in \ref call_stats is also appended to
+ * this file as one JSON line, in the span layout of the OpenTelemetry JSON
+ * exporter.
+ */
+extern std::string CPPIPC_SERVER_TRACE_FILE;
+
+/**
+ * \ingroup cppipc
+ * A histogram of durations in microseconds, with log-linear buckets in the
+ * style of HdrHistogram: each power of two is split into 8 buckets, so any
+ * recorded value is known within 12.5%, over the whole range of uint64_t.
+ */
+class latency_histogram {
+ public:
+  static constexpr size_t SUB_BUCKET_BITS = 3;
+  static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+  static constexpr size_t NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  latency_histogram();
+
+  void add(uint64_t value);
+
+  void merge(const latency_histogram& other);
+
+  size_t count() const { return m_count; }
+  uint64_t max() const { return m_max; }
+  uint64_t sum() const { return m_sum; }
+
+  /**
+   * Returns an upper bound of the q-th quantile (0 <= q <= 1) of the
+   * recorded values, or 0 if there are none.
+   */
+  uint64_t quantile(double q) const;
+
+  /// The index of the bucket holding value
+  static size_t bucket_index(uint64_t value);
+
+  /// The largest value of a bucket
+  static uint64_t bucket_upper_bound(size_t index);
+
+ private:
+  std::vector<uint64_t> m_buckets;
+  size_t m_count = 0;
+  uint64_t m_max = 0;
+  uint64_t m_sum = 0;
+};
+
+/**
+ * \ingroup cppipc
+ * The statistics of all the calls to one method.
+ */
+struct method_call_stats {
+  size_t num_calls = 0;
+  size_t num_errors = 0;
+  /// time spent waiting to run, e.g. behind other object calls
+  latency_histogram queue_wait_us;
+  /// time spent running
+  latency_histogram execution_us;
+  size_t request_bytes = 0;
+  size_t reply_bytes = 0;
+  size_t max_request_bytes = 0;
+  size_t max_reply_bytes = 0;
+};
+
+/**
+ * \ingroup cppipc
+ * One call, as recorded in \ref call_stats.
+ */
+struct call_record {
+  std::string name;
+  /// wall clock time at which the call was received, in ns since the epoch
+  uint64_t start_time_ns = 0;
+  uint64_t queue_wait_us = 0;
+  uint64_t execution_us = 0;
+  size_t request_bytes = 0;
+  size_t reply_bytes = 0;
+  bool error = false;
+  /// 32 hex digit trace id, taken from the caller if it sent one
+  std::string trace_id;
+};
+
+/**
+ * \ingroup cppipc
+ * Process wide per-method call statistics: latency histograms of queue wait
+ * and execution time, and request and reply sizes.
+ *
+ * The comm_server records every object call under the name of the function
+ * called (e.g. "unity_sframe_base::head"), and unity_global records every
+ * toolkit function under "toolkit:" and its name, since all of them go
+ * through the one run_toolkit call. Recording takes a short lock, and can
+ * be turned off with \ref CPPIPC_SERVER_CALL_STATS.
+ */
+class call_stats {
+ public:
+  static call_stats& get_instance();
+
+  /// Returns true if calls should be recorded
+  static bool enabled() { return CPPIPC_SERVER_CALL_STATS != 0; }
+
+  void record(const call_record& call);
+
+  /// Returns the statistics of every method called since the last reset
+  std::map<std::string, method_call_stats> get_stats() const;
+
+  void reset();
+
+  /// Returns a new random 32 hex digit trace id
+  static std::string make_trace_id();
+
+  /// Returns the current wall clock time in ns since the epoch
+  static uint64_t now_ns();
+
+ private:
+  call_stats() = default;
+
+  mutable boost::mutex m_lock;
+  std::map<std::string, method_call_stats> m_stats;
+
+  boost::mutex m_trace_lock;
+  std::string m_trace_path;
+  std::unique_ptr<std::ofstream> m_trace_file;
+
+  void write_trace(const call_record& call);
+};
+
+} // cppipc
+#endif
@@ -4,22 +4,31 @@
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
 #include <random>
+#include <chrono>
 #include <boost/bind.hpp>
 #include <boost/range/adaptor/reversed.hpp>
 #include <boost/algorithm/string.hpp>
 #include <core/logging/logger.hpp>
+#include <core/globals/globals.hpp>
 #include <core/system/cppipc/server/comm_server.hpp>
 #include <core/system/cppipc/server/dispatch.hpp>
+#include <core/system/cppipc/server/call_stats.hpp>
 #include <core/system/cppipc/common/status_types.hpp>
 #include <core/system/cppipc/common/message_types.hpp>
 #include <core/system/cppipc/common/object_factory_impl.hpp>
 #include <core/system/nanosockets/socket_errors.hpp>
 #include <core/system/nanosockets/async_reply_socket.hpp>
 #include <core/system/nanosockets/publish_socket.hpp>
+#include <shmipc/shm_ring.hpp>
+#include <boost/thread/thread.hpp>
 
 
 namespace cppipc {
 
+EXPORT int64_t CPPIPC_SERVER_NUM_OBJECT_THREADS = 4;
+
+REGISTER_GLOBAL(int64_t, CPPIPC_SERVER_NUM_OBJECT_THREADS, false);
+
 /**
  * Generates a publish address based on an address pattern.
  * Where addr is a ZeroMQ endpoint,
@@ -58,13 +67,13 @@ comm_server::comm_server(std::vector<std::string> zkhosts,
 
 
   object_socket = new nanosockets::async_reply_socket(
-          boost::bind(&comm_server::callback, this, _1, _2),
-          1, // 2 threads. one to handle pings, one to handle real messages
+          boost::bind(&comm_server::callback, this, _1, _2, true),
+          std::max<int64_t>(CPPIPC_SERVER_NUM_OBJECT_THREADS, 1),
           alternate_bind_address);
 
   logstream(LOG_INFO) << "my alt bind address: " << alternate_bind_address << std::endl;
   control_socket = new nanosockets::async_reply_socket(
-        boost::bind(&comm_server::callback, this, _1, _2), 1,
+        boost::bind(&comm_server::callback, this, _1, _2, false), 1,
         (alternate_control_address.length()==0) ?
             generate_aux_address(alternate_bind_address, "_control") :
             alternate_control_address);
@@ -118,7 +127,104 @@ void* comm_server::get_zmq_context() {
   return nullptr;
 }
 
+std::string comm_server::get_shared_memory_address() {
+  const char* disable_shm = std::getenv("TURI_DISABLE_CPPIPC_SHM");
+  if (disable_shm != NULL && std::string(disable_shm) == "1") return "";
+
+  auto channel = std::make_shared<turi::shmipc::ring_channel>();
+  if (!channel->bind()) return "";
+  boost::lock_guard<boost::mutex> guard(shm_lock);
+  if (shm_stopping) return "";
+  shm_channels.push_back(channel);
+  shm_threads.push_back(std::make_shared<boost::thread>([this, channel]() {
+    this->serve_shared_memory_channel(channel);
+  }));
+  return channel->get_shared_memory_name();
+}
 
+void comm_server::serve_shared_memory_channel(std::shared_ptr<turi::shmipc::ring_channel> channel) {
+  if (!channel->wait_for_connect(10)) return;
+  logstream(LOG_INFO) << "Serving object calls over shared memory at "
+                      << channel->get_shared_memory_name() << std::endl;
+  while (!shm_stopping) {
+    const char* buf = nullptr;
+    size_t len = 0;
+    // blocks until a call arrives, the client goes away, or
+    // stop_shared_memory_channels() shuts the channel down
+    if (!channel->receive(&buf, &len)) break;
+    // the call is read in place, and released before running it
+    nanosockets::zmq_msg_vector recv, reply;
+    {
+      turi::iarchive iarc(buf, len);
+      recv.load(iarc);
+    }
+    channel->release_received();
+    callback(recv, reply, true);
+
+    turi::oarchive oarc;
+    reply.save(oarc);
+    bool sent = channel->send(oarc.buf, oarc.off);
+    free(oarc.buf);
+    if (!sent) break;
+  }
+  logstream(LOG_INFO) << "Shared memory channel at " << channel->get_shared_memory_name()
+                      << " closed" << std::endl;
+}
+
+void comm_server::stop_shared_memory_channels() {
+  std::vector<std::shared_ptr<boost::thread>> threads;
+  {
+    boost::lock_guard<boost::mutex> guard(shm_lock);
+    shm_stopping = true;
+    for (auto& channel : shm_channels) channel->shutdown();
+    threads.swap(shm_threads);
+  }
+  for (auto& thread : threads) {
+    // the server may be stopped by a call served on one of the channels
+    if (thread->get_id() == boost::this_thread::get_id()) {
+      thread->detach();
+    } else {
+      thread->join();
+    }
+  }
+  boost::lock_guard<boost::mutex> guard(shm_lock);
+  shm_channels.clear();
+}
+
+
+
+size_t comm_server::get_object_id_seed() {
+  boost::lock_guard<boost::mutex> guard(registered_object_lock);
+  return lcg_seed;
+}
+
+void comm_server::set_object_id_seed(size_t seed) {
+  boost::lock_guard<boost::mutex> guard(registered_object_lock);
+  lcg_seed = seed;
+}
+
+void comm_server::start_recording() {
+  size_t seed = get_object_id_seed();
+  boost::lock_guard<boost::mutex> guard(recording_lock);
+  recording.reset(new call_recording);
+  recording->object_id_seed = seed;
+  recording_start = std::chrono::steady_clock::now();
+}
+
+call_recording comm_server::stop_recording() {
+  boost::lock_guard<boost::mutex> guard(recording_lock);
+  call_recording ret;
+  if (recording) {
+    ret = std::move(*recording);
+    recording.reset();
+  }
+  return ret;
+}
+
+bool comm_server::is_recording() {
+  boost::lock_guard<boost::mutex> guard(recording_lock);
+  return recording != nullptr;
+}
 
 size_t comm_server::get_next_object_id() {
   lcg_seed = lcg_seed * 6364136223846793005LL + 1442695040888963407LL;
@@ -149,6 +255,10 @@ void comm_server::start() {
   if (!started) {
     control_socket->start_polling();
     object_socket->start_polling();
+    {
+      boost::lock_guard<boost::mutex> guard(shm_lock);
+      shm_stopping = false;
+    }
     started = true;
   }
 }
@@ -158,6 +268,7 @@ void comm_server::stop() {
   if (started) {
     control_socket->stop_polling();
     object_socket->stop_polling();
+    stop_shared_memory_channels();
     started = false;
   }
 
@@ -171,8 +282,21 @@ void comm_server::report_status(std::string status_type, std::string message) {
   publishsock->send(combined);
 }
 
+void comm_server::mark_thread_safe(const std::string& function_name) {
+  boost::lock_guard<boost::mutex> guard(thread_safe_functions_lock);
+  thread_safe_functions.insert(function_name);
+}
+
+bool comm_server::is_thread_safe(const std::string& function_name) {
+  boost::lock_guard<boost::mutex> guard(thread_safe_functions_lock);
+  return thread_safe_functions.count(function_name) > 0;
+}
+
 bool comm_server::callback(nanosockets::zmq_msg_vector& recv,
-                           nanosockets::zmq_msg_vector& reply) {
+                           nanosockets::zmq_msg_vector& reply,
+                           bool object_call) {
+  auto received_time = std::chrono::steady_clock::now();
+  uint64_t received_time_ns = call_stats::now_ns();
   // construct a call message from the received block
   call_message call;
   reply_message rep;
@@ -185,10 +309,13 @@ bool comm_server::callback(nanosockets::zmq_msg_vector& recv,
     return true;
   }
 
-  // find the object ID
+  // find the object ID. The reference keeps the object alive for the call.
+  std::shared_ptr<void> object;
   {
     boost::lock_guard<boost::mutex> guard(registered_object_lock);
-    if (registered_objects.count(call.objectid) == 0) {
+    auto iter = registered_objects.find(call.objectid);
+    if (iter != registered_objects.end()) object = iter->second;
+    if (object == nullptr) {
       std::string ret = "No such object " + std::to_string(call.objectid);
       logstream(LOG_ERROR) << ret << std::endl;
       rep.copy_body_from(ret);
@@ -231,25 +358,35 @@ bool comm_server::callback(nanosockets::zmq_msg_vector& recv,
 
   report_status(STATUS_COMM_SERVER_INFO, message);
 
+  // object calls run one at a time, unless the function is thread safe
+  bool thread_safe = is_thread_safe(call.function_name);
+  boost::unique_lock<boost::mutex> call_guard(object_call_lock, boost::defer_lock);
+  if (object_call && !thread_safe) call_guard.lock();
+  auto start_time = std::chrono::steady_clock::now();
+
   // ok we are good to go
   // create the appropriate archives
   turi::iarchive iarc(call.body, call.bodylen);
   turi::oarchive oarc;
 
   // Now set the currently running command if this is a real command (not a ping)
+  // Thread safe calls may overlap others, so they are not tracked for
+  // cancellation.
   auto ret = call.properties.find(std::string("command_id"));
   bool real_command = false;
   if(ret != call.properties.end()) {
-    unsigned long long ul = std::stoull(ret->second);
-    get_srv_running_command().store(ul);
-    real_command = true;
+    // echo the id, for the client to match pipelined replies to calls
+    rep.properties.insert(std::make_pair(std::string("command_id"), ret->second));
+    if (!thread_safe) {
+      unsigned long long ul = std::stoull(ret->second);
+      get_srv_running_command().store(ul);
+      real_command = true;
+    }
   }
 
   rep.status = reply_status::OK;
   try {
-    dispatch_map[call.function_name]->execute(
-                          registered_objects[call.objectid].get(),
-                          this, iarc, oarc);
+    dispatch_map[call.function_name]->execute(object.get(), this, iarc, oarc);
   } catch (const std::ios_base::failure& e) {
     // IO Exception
     rep.copy_body_from(e.what());
@@ -307,6 +444,44 @@ bool comm_server::callback(nanosockets::zmq_msg_vector& recv,
     rep.bodylen = oarc.off;
   }
 
+  if (call_stats::enabled()) {
+    auto end_time = std::chrono::steady_clock::now();
+    call_record record;
+    record.name = trimmed_function_name;
+    record.start_time_ns = received_time_ns;
+    record.queue_wait_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        start_time - received_time).count();
+    record.execution_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        end_time - start_time).count();
+    record.request_bytes = call.bodylen;
+    record.reply_bytes = rep.bodylen;
+    record.error = rep.status != reply_status::OK;
+    // a W3C traceparent: version-traceid-parentid-flags
+    auto traceparent = call.properties.find(std::string("traceparent"));
+    if (traceparent != call.properties.end() && traceparent->second.size() >= 35) {
+      record.trace_id = traceparent->second.substr(3, 32);
+    }
+    call_stats::get_instance().record(record);
+  }
+
+  if (object_call) {
+    boost::lock_guard<boost::mutex> guard(recording_lock);
+    if (recording) {
+      recorded_call record;
+      record.start_us = received_time > recording_start ?
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              received_time - recording_start).count() : 0;
+      record.objectid = call.objectid;
+      record.function_name = call.function_name;
+      record.properties = call.properties;
+      record.body.assign(call.body, call.bodylen);
+      record.execution_us = std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start_time).count();
+      record.error = rep.status != reply_status::OK;
+      recording->calls.push_back(std::move(record));
+    }
+  }
+
   // Command is now over, so this is not the running command anymore
   if(real_command) {
     std::atomic<bool> &cancel_checked = get_cancel_bit_checked();
@@ -14,6 +14,7 @@
 #include <algorithm>
 #include <iterator>
 #include <atomic>
+#include <chrono>
 #include <core/parallel/mutex.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/lock_guard.hpp>
@@ -23,6 +24,17 @@
 #include <core/system/cppipc/common/status_types.hpp>
 #include <core/system/cppipc/server/dispatch.hpp>
 #include <core/system/cppipc/server/cancel_ops.hpp>
+#include <core/system/cppipc/server/call_recorder.hpp>
+
+namespace boost {
+  class thread;
+}
+
+namespace turi {
+namespace shmipc {
+  class ring_channel;
+}
+}
 
 
 namespace cppipc {
@@ -30,6 +42,13 @@ namespace nanosockets = turi::nanosockets;
 struct reply_message;
 struct call_message;
 
+/**
+ * \ingroup cppipc
+ * The number of threads receiving object calls in a comm_server. Only the
+ * calls to thread safe functions run in parallel. Defaults to 4.
+ */
+extern int64_t CPPIPC_SERVER_NUM_OBJECT_THREADS;
+
 // some annoying forward declarations I need to get by some circular references
 class object_factory_impl;
 namespace detail {
@@ -132,6 +151,11 @@ namespace detail {
  *
  * The object_factory_impl manages the construction of new object types.
  *
+ * Object calls are received by \ref CPPIPC_SERVER_NUM_OBJECT_THREADS threads,
+ * but are executed one at a time, except for the functions registered with
+ * REGISTER_THREAD_SAFE or marked with \ref mark_thread_safe(), which run
+ * concurrently with any other call.
+ *
  * Interface Modification Safety
  * -----------------------------
  * The internal protocol is designed to be robust against changes in interfaces.
@@ -153,8 +177,32 @@ class EXPORT comm_server {
   nanosockets::async_reply_socket* control_socket;
   nanosockets::publish_socket* publishsock;
 
-  /// Internal callback for messages received from zeromq
-  bool callback(nanosockets::zmq_msg_vector& recv, nanosockets::zmq_msg_vector& reply);
+  /**
+   * Internal callback for messages received from zeromq.
+   * object_call is true for calls from the object socket or a shared memory
+   * channel. Those are executed one at a time, unless the function was
+   * marked thread safe (see \ref mark_thread_safe).
+   */
+  bool callback(nanosockets::zmq_msg_vector& recv,
+                nanosockets::zmq_msg_vector& reply,
+                bool object_call);
+  boost::mutex object_call_lock;
+
+  /// Functions which may run concurrently with any other call
+  std::unordered_set<std::string> thread_safe_functions;
+  boost::mutex thread_safe_functions_lock;
+
+  /// Shared memory channels to local clients, and the threads serving them
+  std::vector<std::shared_ptr<turi::shmipc::ring_channel>> shm_channels;
+  std::vector<std::shared_ptr<boost::thread>> shm_threads;
+  boost::mutex shm_lock;
+  volatile bool shm_stopping = false;
+
+  /// Serves the object calls of a shared memory channel until it disconnects
+  void serve_shared_memory_channel(std::shared_ptr<turi::shmipc::ring_channel> channel);
+
+  /// Shuts down the shared memory channels and joins their threads
+  void stop_shared_memory_channels();
 
   std::map<std::string, dispatch*> dispatch_map;
   boost::mutex registered_object_lock;
@@ -172,6 +220,11 @@ class EXPORT comm_server {
 
   bool comm_server_debug_mode = false;
 
+  /// The calls received since start_recording(), if recording
+  std::unique_ptr<call_recording> recording;
+  std::chrono::steady_clock::time_point recording_start;
+  boost::mutex recording_lock;
+
 
   /**
    * Registers a mapping from a type name to a constructor call which returns
@@ -269,6 +322,15 @@ class EXPORT comm_server {
    */
   std::string get_status_address();
 
+  /**
+   * Creates a shared memory channel for a client on the same host, and
+   * returns its name. The client has 10 seconds to connect to it; object
+   * calls received on it are served like those of the object socket.
+   * Returns an empty string if shared memory is not available, or disabled
+   * by setting the environment variable TURI_DISABLE_CPPIPC_SHM to 1.
+   */
+  std::string get_shared_memory_address();
+
   /**
    * Gets the zeromq context.. Deprecated. Returns NULL.
    */
@@ -287,6 +349,33 @@ class EXPORT comm_server {
    */
   void report_status(std::string status_type, std::string message);
 
+  /**
+   * Starts recording the object calls received, with their serialized
+   * arguments and how long they ran, to reproduce a session with a replay
+   * (see core/system/cppipc/server/call_replay.hpp). Discards any recording
+   * in progress.
+   */
+  void start_recording();
+
+  /**
+   * Stops recording, and returns the calls received since
+   * \ref start_recording(). Returns an empty recording if not recording.
+   */
+  call_recording stop_recording();
+
+  /// Returns true between start_recording() and stop_recording()
+  bool is_recording();
+
+  /**
+   * The state of the object ID generator. Object IDs are deterministic
+   * from it: a server set to the seed of a recording creates the objects
+   * of a replay with the IDs the recorded calls refer to.
+   */
+  size_t get_object_id_seed();
+
+  /// Sets the state of the object ID generator. See \ref get_object_id_seed()
+  void set_object_id_seed(size_t seed);
+
   /**
    * Deletes an object of object ID objectid.
    */
@@ -393,6 +482,29 @@ class EXPORT comm_server {
   template <typename MemFn>
   void register_function(MemFn fn, std::string function_name);
 
+  /**
+   * \internal
+   * Registers a member function pointer like \ref register_function, and
+   * marks it thread safe. Used by the REGISTER_THREAD_SAFE macro.
+   */
+  template <typename MemFn>
+  void register_thread_safe_function(MemFn fn, std::string function_name) {
+    register_function(fn, function_name);
+    mark_thread_safe(function_name);
+  }
+
+  /**
+   * Marks a registered function as safe to run concurrently with any other
+   * call, so that pipelined calls to it (see \ref comm_client::async_call)
+   * are served in parallel by the object socket threads. The name is the one
+   * used at registration, i.e. "base_class::function". All other object calls
+   * are executed one at a time.
+   */
+  void mark_thread_safe(const std::string& function_name);
+
+  /// Returns true if the function was marked thread safe
+  bool is_thread_safe(const std::string& function_name);
+
 
   template <typename RetType, typename T, typename MemFn, typename... Args>
   friend struct detail::exec_and_serialize_response;
@@ -0,0 +1,60 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <iostream>
+#include <core/system/cppipc/cppipc.hpp>
+#include <core/system/cppipc/server/call_replay.hpp>
+
+void usage() {
+  std::cerr << "./cppipc_replay recording_directory [server_address]\n\n"
+            << "Without a server address, summarizes the recorded calls. With one,\n"
+            << "replays them against the server listening there, which should host\n"
+            << "the same object types and have been started fresh." << std::endl;
+}
+
+int main(int argc, char** argv) {
+  if (argc != 2 && argc != 3) {
+    usage();
+    return 1;
+  }
+
+  try {
+    cppipc::call_recording recording = cppipc::load_call_recording(argv[1]);
+    std::cout << "Loaded " << recording.calls.size() << " calls from " << argv[1]
+              << std::endl;
+
+    if (argc == 2) {
+      // the recorded timings only
+      cppipc::replay_report report;
+      for (const auto& call : recording.calls) {
+        auto& method = report.methods[call.function_name.substr(0, call.function_name.find(' '))];
+        ++method.num_calls;
+        method.recorded_us += call.execution_us;
+        if (call.error) ++method.num_errors;
+        ++report.num_calls;
+        report.recorded_us += call.execution_us;
+        if (call.error) ++report.num_errors;
+      }
+      std::cout << report.to_string();
+      return 0;
+    }
+
+    cppipc::comm_client client({}, argv[2]);
+    if (client.start() != cppipc::reply_status::OK) {
+      std::cerr << "Unable to connect to " << argv[2] << std::endl;
+      return 1;
+    }
+    cppipc::replay_report report = cppipc::replay_calls(client, recording);
+    client.stop();
+    std::cout << report.to_string();
+    return report.num_errors == 0 ? 0 : 2;
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  } catch (const std::string& s) {
+    std::cerr << s << std::endl;
+    return 1;
+  }
+}
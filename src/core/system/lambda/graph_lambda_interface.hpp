@@ -24,6 +24,7 @@ GENERATE_INTERFACE_AND_PROXY(graph_lambda_evaluator_interface, graph_lambda_eval
       (void, update_vertex_partition, (vertex_partition_exchange&))
       (vertex_partition_exchange, get_vertex_partition_exchange, (size_t)(const std::unordered_set<size_t>&)(const std::vector<size_t>&))
       (void, clear, )
+      (std::string, initialize_shared_memory_comm, )
     )
 } // namespace lambda
 } // namespace turi
@@ -7,6 +7,7 @@
 #include <core/system/lambda/graph_pylambda.hpp>
 #include <core/system/lambda/pylambda.hpp>
 #include <core/system/lambda/python_callbacks.hpp>
+#include <shmipc/shmipc.hpp>
 
 namespace turi {
 namespace lambda {
@@ -74,10 +75,15 @@ vertex_partition_exchange pysgraph_synchronize::get_vertex_partition_exchange(si
 /*                             graph_pylambda                             */
 /*                                                                        */
 /**************************************************************************/
-graph_pylambda_evaluator::graph_pylambda_evaluator() {
+graph_pylambda_evaluator::graph_pylambda_evaluator(turi::shmipc::server* shared_memory_server) {
+  m_shared_memory_server = shared_memory_server;
 }
 
 graph_pylambda_evaluator::~graph_pylambda_evaluator() {
+  if (m_shared_memory_listener.active()) {
+    m_shared_memory_thread_terminating = true;
+    m_shared_memory_listener.join();
+  }
   if(m_lambda_id != size_t(-1)) {
     release_lambda(m_lambda_id);
   }
@@ -157,5 +163,72 @@ std::vector<sgraph_edge_data> graph_pylambda_evaluator::eval_triple_apply(
   return ret;
 }
 
+std::vector<sgraph_edge_data>
+graph_pylambda_evaluator::eval_triple_apply_serialized(const char* ptr, size_t len) {
+  iarchive iarc(ptr, len);
+  std::vector<sgraph_edge_data> all_edge_data;
+  size_t src_partition, dst_partition;
+  std::vector<size_t> mutated_edge_field_ids;
+  iarc >> all_edge_data >> src_partition >> dst_partition >> mutated_edge_field_ids;
+  return eval_triple_apply(all_edge_data, src_partition, dst_partition,
+                           mutated_edge_field_ids);
+}
+
+std::string graph_pylambda_evaluator::initialize_shared_memory_comm() {
+  if (m_shared_memory_server) {
+    if (!m_shared_memory_listener.active()) {
+      m_shared_memory_listener.launch(
+          [=]() {
+            while(!m_shared_memory_server->wait_for_connect(3)) {
+              if (m_shared_memory_thread_terminating) return;
+            }
+            char* receive_buffer = nullptr;
+            size_t receive_buffer_length = 0;
+            size_t message_length = 0;
+            char* send_buffer = nullptr;
+            size_t send_buffer_length= 0 ;
+            while(1) {
+              bool has_data =
+                  shmipc::large_receive(*m_shared_memory_server,
+                                        &receive_buffer,
+                                        &receive_buffer_length,
+                                        message_length,
+                                        3 /* timeout */);
+              if (!has_data) {
+                if (m_shared_memory_thread_terminating) break;
+                else continue;
+              } else {
+                oarchive oarc;
+                oarc.buf = send_buffer;
+                oarc.len = send_buffer_length;
+                try {
+                  auto ret = eval_triple_apply_serialized(receive_buffer, message_length);
+                  oarc << (char)(1) << ret;
+                } catch (std::string& s) {
+                  oarc << (char)(0) << s;
+                } catch (const char* s) {
+                  oarc << (char)(0) << std::string(s);
+                } catch (std::exception& e) {
+                  oarc << (char)(0) << std::string(e.what());
+                } catch (...) {
+                  oarc << (char)(0) << std::string("Unknown Runtime Exception");
+                }
+                shmipc::large_send(*m_shared_memory_server,
+                                   oarc.buf,
+                                   oarc.off);
+                send_buffer = oarc.buf;
+                send_buffer_length = oarc.len;
+              }
+            }
+            if (receive_buffer) free(receive_buffer);
+            if (send_buffer) free(send_buffer);
+          });
+    }
+    return m_shared_memory_server->get_shared_memory_name();
+  } else {
+    return "";
+  }
+}
+
 }
 }
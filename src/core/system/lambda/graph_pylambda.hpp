@@ -9,10 +9,15 @@
 #include <core/data/flexible_type/flexible_type.hpp>
 #include <vector>
 #include <core/parallel/mutex.hpp>
+#include <core/parallel/pthread_tools.hpp>
 #include <atomic>
 
 namespace turi {
 
+namespace shmipc {
+class server;
+}
+
 namespace lambda {
 
 /**
@@ -77,7 +82,7 @@ class graph_pylambda_evaluator : public graph_lambda_evaluator_interface {
   /*                       Constructor and Destructor                       */
   /*                                                                        */
   /**************************************************************************/
-  graph_pylambda_evaluator();
+  graph_pylambda_evaluator(turi::shmipc::server* shared_memory_server = nullptr);
 
   ~graph_pylambda_evaluator();
 
@@ -140,7 +145,21 @@ class graph_pylambda_evaluator : public graph_lambda_evaluator_interface {
                                                   size_t src_partition, size_t dst_partition,
                                                   const std::vector<size_t>& mutated_edge_field_ids = {});
 
+  /**
+   * Initializes shared memory communication via SHMIPC, over which
+   * eval_triple_apply() can then be called (see
+   * graph_pylambda_master::eval_triple_apply()).
+   * Returns the shared memory address to connect to, or an empty string if
+   * shared memory is not available.
+   */
+  std::string initialize_shared_memory_comm();
+
  private:
+  /**
+   * Deserializes the arguments of eval_triple_apply() and calls it.
+   */
+  std::vector<sgraph_edge_data> eval_triple_apply_serialized(const char* ptr, size_t len);
+
   mutex m_mutex;
 
   size_t m_lambda_id = size_t(-1);
@@ -151,6 +170,10 @@ class graph_pylambda_evaluator : public graph_lambda_evaluator_interface {
   size_t m_dstid_column;
 
   pysgraph_synchronize m_graph_sync;
+
+  turi::shmipc::server* m_shared_memory_server;
+  turi::thread m_shared_memory_listener;
+  volatile bool m_shared_memory_thread_terminating = false;
 };
 
 } // end of lambda
@@ -7,6 +7,9 @@
 #include <core/parallel/lambda_omp.hpp>
 #include <core/system/lambda/lambda_constants.hpp>
 #include <core/system/lambda/lambda_master.hpp>
+#include <core/system/lambda/lambda_utils.hpp>
+#include <core/util/sys_util.hpp>
+#include <shmipc/shmipc.hpp>
 
 namespace turi {
 
@@ -42,6 +45,48 @@ graph_pylambda_master::graph_pylambda_master(size_t nworkers) {
     logprogress_stream << "\"turicreate.config.set_runtime_config(\'TURI_DEFAULT_NUM_GRAPH_LAMBDA_WORKERS\', " << thread::cpu_count() << ")\"\n";
     logprogress_stream << "Note that increasing the degree of parallelism also increases the memory footprint." << std::endl;
   }
+
+  boost::optional<std::string> disable_shm = turi::getenv_str("TURI_DISABLE_LAMBDA_SHM");
+  if (!(disable_shm && *disable_shm == "1")) {
+    // Create an interprocess shared memory connection to each worker if possible.
+    auto shared_memory_setup = [](std::unique_ptr<graph_lambda_evaluator_proxy>& proxy) {
+      return std::make_pair((void*)(proxy.get()), proxy->initialize_shared_memory_comm());
+    };
+    std::vector<std::pair<void*, std::string>> shared_memory_addresses =
+        m_worker_pool->call_all_workers<std::pair<void*, std::string>>(shared_memory_setup);
+
+    for (auto shared_memory_address: shared_memory_addresses) {
+      if (!shared_memory_address.second.empty()) {
+        std::shared_ptr<shmipc::client> client = std::make_shared<shmipc::client>();
+        if (client->connect(shared_memory_address.second)) {
+          m_shared_memory_worker_connections[shared_memory_address.first] = client;
+        }
+      }
+    }
+  }
+}
+
+std::vector<sgraph_edge_data> graph_pylambda_master::eval_triple_apply(
+    worker_process<graph_lambda_evaluator_proxy>& worker,
+    const std::vector<sgraph_edge_data>& all_edge_data,
+    size_t src_partition, size_t dst_partition,
+    const std::vector<size_t>& mutated_edge_field_ids) {
+  auto shmclient_iter = m_shared_memory_worker_connections.find(worker.proxy.get());
+  if (shmclient_iter != m_shared_memory_worker_connections.end() &&
+      shmclient_iter->second.get() != nullptr) {
+    auto& shmclient = shmclient_iter->second;
+    oarchive oarc;
+    oarc << all_edge_data << src_partition << dst_partition << mutated_edge_field_ids;
+    std::vector<sgraph_edge_data> ret;
+    if (shm_call(shmclient, oarc, ret)) return ret;
+
+    // shm call failed. reset the client so we don't ever use it again
+    // and fall back to regular IPC.
+    shmclient.reset();
+    logstream(LOG_WARNING) << "Unexpected SHMIPC failure. Falling back to CPPIPC" << std::endl;
+  }
+  return worker.proxy->eval_triple_apply(all_edge_data, src_partition,
+                                         dst_partition, mutated_edge_field_ids);
 }
 
 } // end of lambda
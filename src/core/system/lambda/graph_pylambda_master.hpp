@@ -8,9 +8,14 @@
 
 #include<core/system/lambda/graph_lambda_interface.hpp>
 #include<core/system/lambda/worker_pool.hpp>
+#include<map>
 
 namespace turi {
 
+namespace shmipc {
+class client;
+}
+
 namespace lambda {
   /**
    * \ingroup lambda
@@ -34,6 +39,16 @@ namespace lambda {
       return m_worker_pool;
     }
 
+    /**
+     * Calls eval_triple_apply on a worker of the pool, over shared memory if
+     * the worker has a shared memory connection, and over cppipc otherwise.
+     */
+    std::vector<sgraph_edge_data> eval_triple_apply(
+        worker_process<graph_lambda_evaluator_proxy>& worker,
+        const std::vector<sgraph_edge_data>& all_edge_data,
+        size_t src_partition, size_t dst_partition,
+        const std::vector<size_t>& mutated_edge_field_ids);
+
    private:
 
     graph_pylambda_master(graph_pylambda_master const&) = delete;
@@ -43,6 +58,8 @@ namespace lambda {
    private:
     std::shared_ptr<worker_pool<graph_lambda_evaluator_proxy>> m_worker_pool;
 
+    std::map<void*, std::shared_ptr<shmipc::client>> m_shared_memory_worker_connections;
+
     static std::string pylambda_worker_binary;
   };
 } // end lambda
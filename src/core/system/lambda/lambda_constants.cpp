@@ -13,6 +13,10 @@ size_t DEFAULT_NUM_PYLAMBDA_WORKERS = 16;
 
 size_t DEFAULT_NUM_GRAPH_LAMBDA_WORKERS = 16;
 
+size_t NUM_PYLAMBDA_WORKERS_AT_STARTUP = 2;
+
+size_t PYLAMBDA_NUM_CACHED_LAMBDAS = 16;
+
 REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             DEFAULT_NUM_PYLAMBDA_WORKERS,
                             true,
@@ -22,4 +26,14 @@ REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             DEFAULT_NUM_GRAPH_LAMBDA_WORKERS,
                             true,
                             +[](int64_t val){ return val >= 1; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            NUM_PYLAMBDA_WORKERS_AT_STARTUP,
+                            true,
+                            +[](int64_t val){ return val >= 1; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            PYLAMBDA_NUM_CACHED_LAMBDAS,
+                            true,
+                            +[](int64_t val){ return val >= 0; });
 }
@@ -19,6 +19,18 @@ extern size_t DEFAULT_NUM_PYLAMBDA_WORKERS;
  */
 extern size_t DEFAULT_NUM_GRAPH_LAMBDA_WORKERS;
 
+/**
+ * Number of pylambda workers started with the lambda master. The pool grows
+ * up to DEFAULT_NUM_PYLAMBDA_WORKERS as parallel evaluations need them.
+ */
+extern size_t NUM_PYLAMBDA_WORKERS_AT_STARTUP;
+
+/**
+ * Number of released lambdas the lambda master keeps registered in the
+ * workers, so that a later query making the same lambda reuses them.
+ */
+extern size_t PYLAMBDA_NUM_CACHED_LAMBDAS;
+
 }
 
 #endif
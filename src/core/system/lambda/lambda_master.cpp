@@ -40,7 +40,9 @@ static lambda_master* instance_ptr = nullptr;
   }
 
   lambda_master::lambda_master(size_t nworkers) {
-    m_worker_pool.reset(new worker_pool<lambda_evaluator_proxy>(nworkers, lambda_worker_binary_and_args));
+    // start a few workers now, and the rest when parallel evaluations need them
+    m_worker_pool.reset(new worker_pool<lambda_evaluator_proxy>(
+        nworkers, lambda_worker_binary_and_args, 3, NUM_PYLAMBDA_WORKERS_AT_STARTUP));
     if (nworkers < thread::cpu_count()) {
       logprogress_stream << "Using default " << nworkers << " lambda workers.\n";
       logprogress_stream << "To maximize the degree of parallelism, add the following code to the beginning of the program:\n";
@@ -50,43 +52,98 @@ static lambda_master* instance_ptr = nullptr;
 
     boost::optional<std::string> disable_smh = turi::getenv_str("TURI_DISABLE_LAMBDA_SHM");
 
-    if(! (disable_smh && *disable_smh == "1") ) {
-      /*
-       * Create an interprocess shared memory connection if possible.
-       */
-      auto shared_memory_setup = [](std::unique_ptr<lambda_evaluator_proxy>& proxy) {
-        return std::make_pair((void*)(proxy.get()), proxy->initialize_shared_memory_comm());
-      };
-      std::vector<std::pair<void*, std::string>> shared_memory_addresses =
-          m_worker_pool->call_all_workers<std::pair<void*, std::string>>(shared_memory_setup);
-
-      for (auto shared_memory_address: shared_memory_addresses) {
-        // for each worker, try to connect and store the addresses
-        if (!shared_memory_address.second.empty()) {
-          std::shared_ptr<shmipc::client> client = std::make_shared<shmipc::client>();
-          if (client->connect(shared_memory_address.second)) {
-            m_shared_memory_worker_connections[shared_memory_address.first] = client;
-          }
+    // Interprocess shared memory connections are created on the first use
+    // of every worker, in prepare_worker().
+    if (disable_smh && *disable_smh == "1") {
+      m_use_shared_memory = false;
+      logprogress_stream << "SHM disabled; falling back to local TCP." << std::endl;
+    }
+  }
+
+  std::shared_ptr<shmipc::client> lambda_master::prepare_worker(
+      std::unique_ptr<worker_process<lambda_evaluator_proxy>>& worker,
+      size_t lambda_hash) {
+    bool needs_init, needs_lambda;
+    std::string lambda_str;
+    {
+      std::lock_guard<turi::mutex> lock(m_state_mtx);
+      auto& state = m_worker_states[worker->id];
+      needs_init = !state.initialized;
+      needs_lambda = state.lambdas.count(lambda_hash) == 0;
+      if (!needs_init && !needs_lambda) return state.shared_memory_connection;
+      if (needs_lambda) {
+        auto iter = m_lambda_strings.find(lambda_hash);
+        if (iter == m_lambda_strings.end()) {
+          log_and_throw("Unknown lambda " + std::to_string(lambda_hash));
         }
+        lambda_str = iter->second;
       }
-    } else {
-      logprogress_stream << "SHM disabled; falling back to local TCP." << std::endl;
     }
+
+    // The worker is ours until it is released, so its state cannot change
+    // while we call it.
+    std::shared_ptr<shmipc::client> client;
+    if (needs_init && m_use_shared_memory) {
+      std::string address = worker->proxy->initialize_shared_memory_comm();
+      if (!address.empty()) {
+        client = std::make_shared<shmipc::client>();
+        if (!client->connect(address)) client.reset();
+      }
+    }
+    if (needs_lambda) {
+      TURI_ATTRIBUTE_UNUSED_NDEBUG size_t ret = worker->proxy->make_lambda(lambda_str);
+      DASSERT_MSG(ret == lambda_hash, "workers should return the same lambda index");
+      logstream(LOG_INFO) << "Lambda worker " << worker->id << " make lambda: " << lambda_hash << std::endl;
+    }
+
+    std::lock_guard<turi::mutex> lock(m_state_mtx);
+    auto& state = m_worker_states[worker->id];
+    if (needs_init) {
+      state.initialized = true;
+      state.shared_memory_connection = client;
+    }
+    if (needs_lambda) state.lambdas.insert(lambda_hash);
+    return state.shared_memory_connection;
+  }
+
+  void lambda_master::disable_shared_memory(
+      std::unique_ptr<worker_process<lambda_evaluator_proxy>>& worker) {
+    std::lock_guard<turi::mutex> lock(m_state_mtx);
+    m_worker_states[worker->id].shared_memory_connection.reset();
+    logstream(LOG_WARNING) << "Unexpected SHMIPC failure. Falling back to CPPIPC" << std::endl;
   }
 
   size_t lambda_master::make_lambda(const std::string& lambda_str) {
     std::lock_guard<turi::mutex> lock(m_mtx);
-    auto make_lambda_fn = [lambda_str](std::unique_ptr<lambda_evaluator_proxy>& proxy) {
-      auto ret = proxy->make_lambda(lambda_str);
-      logstream(LOG_INFO) << "Lambda worker proxy make lambda: " << ret << std::endl;
-      return ret;
-    };
-    std::vector<size_t> returned_hashes = m_worker_pool->call_all_workers<size_t>(make_lambda_fn);
-    // validate all worker returns the same hash
-    size_t lambda_hash = returned_hashes[0];
-    for (TURI_ATTRIBUTE_UNUSED_NDEBUG auto& v : returned_hashes) {
-      DASSERT_MSG(lambda_hash == v,
-                  "workers should return the same lambda index");
+    {
+      // the same lambda is registered already: reuse it
+      std::lock_guard<turi::mutex> state_lock(m_state_mtx);
+      auto iter = m_lambda_hashes.find(lambda_str);
+      if (iter != m_lambda_hashes.end()) {
+        size_t lambda_hash = iter->second;
+        if (m_lambda_object_counter[lambda_hash]++ == 0) {
+          m_cached_lambdas.remove(lambda_hash);
+        }
+        return lambda_hash;
+      }
+    }
+
+    // Register it in one worker, which checks that it is valid. The other
+    // workers register it on their first evaluation.
+    auto worker = m_worker_pool->get_worker();
+    auto worker_guard = m_worker_pool->get_worker_guard(worker);
+    size_t lambda_hash;
+    try {
+      lambda_hash = worker->proxy->make_lambda(lambda_str);
+    } catch (const cppipc::ipcexception& e) {
+      throw reinterpret_comm_failure(e);
+    }
+    logstream(LOG_INFO) << "Lambda worker " << worker->id << " make lambda: " << lambda_hash << std::endl;
+    {
+      std::lock_guard<turi::mutex> state_lock(m_state_mtx);
+      m_lambda_strings[lambda_hash] = lambda_str;
+      m_lambda_hashes[lambda_str] = lambda_hash;
+      m_worker_states[worker->id].lambdas.insert(lambda_hash);
     }
     m_lambda_object_counter[lambda_hash]++;
     return lambda_hash;
@@ -99,16 +156,48 @@ static lambda_master* instance_ptr = nullptr;
       if (m_lambda_object_counter.find(lambda_hash) == m_lambda_object_counter.end()) {
         return;
       }
+      if (m_lambda_object_counter[lambda_hash] == 0) {
+        return;
+      }
       m_lambda_object_counter[lambda_hash]--;
       if (m_lambda_object_counter[lambda_hash] > 0) {
         return;
       }
     }
 
-    // Ok, the lambda is unique, let's issue a release lambda to all workers
-    auto release_lambda_fn = [lambda_hash](std::unique_ptr<lambda_evaluator_proxy>& proxy) {
+    // Ok, the lambda is unique. Keep it registered for a later query making
+    // the same lambda, and release the least recently used one instead if
+    // there are too many.
+    m_cached_lambdas.push_back(lambda_hash);
+    while (m_cached_lambdas.size() > PYLAMBDA_NUM_CACHED_LAMBDAS) {
+      size_t evicted = m_cached_lambdas.front();
+      m_cached_lambdas.pop_front();
+      m_lambda_object_counter.erase(evicted);
+      release_lambda_in_workers(evicted);
+    }
+  }
+
+  void lambda_master::release_lambda_in_workers(size_t lambda_hash) noexcept {
+    {
+      std::lock_guard<turi::mutex> state_lock(m_state_mtx);
+      auto iter = m_lambda_strings.find(lambda_hash);
+      if (iter != m_lambda_strings.end()) {
+        m_lambda_hashes.erase(iter->second);
+        m_lambda_strings.erase(iter);
+      }
+    }
+
+    // issue a release lambda to the workers which registered it
+    auto release_lambda_fn = [&](std::unique_ptr<worker_process<lambda_evaluator_proxy>>& worker) {
+      {
+        std::lock_guard<turi::mutex> state_lock(m_state_mtx);
+        auto state = m_worker_states.find(worker->id);
+        if (state == m_worker_states.end() || state->second.lambdas.erase(lambda_hash) == 0) {
+          return 0;
+        }
+      }
       try {
-        proxy->release_lambda(lambda_hash);
+        worker->proxy->release_lambda(lambda_hash);
       } catch (std::exception e){
         logstream(LOG_ERROR) << "Error on releasing lambda: " << e.what() << std::endl;
       } catch (std::string e) {
@@ -120,7 +209,7 @@ static lambda_master* instance_ptr = nullptr;
       }
       return 0;
     };
-    m_worker_pool->call_all_workers<size_t>(release_lambda_fn);
+    m_worker_pool->call_all_worker_processes<size_t>(release_lambda_fn);
   }
 
 
@@ -133,6 +222,7 @@ static lambda_master* instance_ptr = nullptr;
     auto worker_guard = m_worker_pool->get_worker_guard(worker);
     // catch and reinterpret comm failure
     try {
+      prepare_worker(worker, lambda_hash);
       out = worker->proxy->bulk_eval(lambda_hash, args, skip_undefined, seed);
     } catch (cppipc::ipcexception e) {
       throw reinterpret_comm_failure(e);
@@ -140,64 +230,6 @@ static lambda_master* instance_ptr = nullptr;
   }
 
 
-  /**
-   * Performs a remote call to an interprocess shared memory server
-   * deserializing the response to RetType.
-   *
-   * Note that this is not a general purpose function and only works
-   * with pylambda_master and pylambda_evaluator.
-   *
-   * Performs a remote call for bulk_eval_rows and bulk_eval_dict_rows.
-   *
-   * Arguments must be serialized into the "arguments" archive. This function
-   * will also take over management of the buffer inside of "arguments" and
-   * free it when done.
-   *
-   * Results will be deserialized into the ret.
-   *
-   * This function may throw exceptions if remote exceptions were raised.
-   */
-  template <typename RetType>
-  static bool shm_call(const std::shared_ptr<shmipc::client>& shmclient,
-                       oarchive& arguments,
-                       RetType& ret) {
-    // send the message
-    bool shmok = shmipc::large_send(*shmclient, arguments.buf, arguments.off);
-    if (shmok == false) {
-      free(arguments.buf); arguments.buf = nullptr;
-    }
-
-    // reuse the arguments buffer so we dont alloc again
-    // receive the reply
-    char* buf = arguments.buf;
-    size_t buflen = arguments.len;
-    size_t receivelen = 0;
-    arguments.buf = nullptr;
-    shmok = shmipc::large_receive(*shmclient, &buf, &buflen,
-                                  receivelen, (size_t)(-1));
-    if (shmok == false) {
-      free(buf);
-      return false;
-    }
-
-    // deserialize
-    // first byte is whether it is an error message or not
-    iarchive iarc(buf, receivelen);
-    char good_call;
-    iarc >> good_call;
-    if (good_call) {
-      iarc >> ret;
-    } else {
-      std::string message;
-      iarc >> message;
-      throw message;
-    }
-    free(buf);
-
-    return true;
-  }
-
-
   /**
    * \overload with sframe rows
    */
@@ -212,10 +244,8 @@ static lambda_master* instance_ptr = nullptr;
 
     // catch and reinterpret comm failure
     try {
-      auto shmclient_iter = m_shared_memory_worker_connections.find(worker->proxy.get());
-      if (shmclient_iter != m_shared_memory_worker_connections.end() &&
-          shmclient_iter->second.get() != nullptr) {
-        auto& shmclient = shmclient_iter->second;
+      auto shmclient = prepare_worker(worker, lambda_hash);
+      if (shmclient != nullptr) {
         oarchive oarc;
         oarc << (char)(bulk_eval_serialized_tag::BULK_EVAL_ROWS)
              << lambda_hash
@@ -226,14 +256,9 @@ static lambda_master* instance_ptr = nullptr;
         // if shmcall was good, return.
         if (good) return;
 
-        // otherwise shmcall was bad. reset the client so we don't ever use
-        // it again and fall back to regular IPC.
-        // (note. we cannot delete it from the
-        // m_shared_memory_worker_connections map because of concurency
-        // issues. There may be parallel access to it and locking seems
-        // overkill.
-        shmclient.reset();
-        logstream(LOG_WARNING) << "Unexpected SHMIPC failure. Falling back to CPPIPC" << std::endl;
+        // otherwise shmcall was bad. stop using it for this worker and fall
+        // back to regular IPC.
+        disable_shared_memory(worker);
       }
       out = worker->proxy->bulk_eval_rows(lambda_hash, args, skip_undefined, seed);
     } catch (cppipc::ipcexception e) {
@@ -251,6 +276,7 @@ static lambda_master* instance_ptr = nullptr;
     auto worker_guard = m_worker_pool->get_worker_guard(worker);
     // catch and reinterpret comm failure
     try {
+      prepare_worker(worker, lambda_hash);
       out = worker->proxy->bulk_eval_dict(lambda_hash, keys, values, skip_undefined, seed);
     } catch (cppipc::ipcexception e) {
       throw reinterpret_comm_failure(e);
@@ -267,10 +293,8 @@ static lambda_master* instance_ptr = nullptr;
     auto worker_guard = m_worker_pool->get_worker_guard(worker);
     // catch and reinterpret comm failure
     try {
-      auto shmclient_iter = m_shared_memory_worker_connections.find(worker->proxy.get());
-      if (shmclient_iter != m_shared_memory_worker_connections.end() &&
-          shmclient_iter->second.get() != nullptr) {
-        auto& shmclient = shmclient_iter->second;
+      auto shmclient = prepare_worker(worker, lambda_hash);
+      if (shmclient != nullptr) {
         oarchive oarc;
         oarc << (char)(bulk_eval_serialized_tag::BULK_EVAL_DICT_ROWS)
              << lambda_hash
@@ -283,10 +307,9 @@ static lambda_master* instance_ptr = nullptr;
         if (good) return;
 
 
-        // shmcall was bad... reset the client so we don't ever use it again
+        // shmcall was bad... stop using it for this worker
         // and fall back to regular IPC
-        shmclient.reset();
-        logstream(LOG_WARNING) << "Unexpected SHMIPC failure. Falling back to CPPIPC" << std::endl;
+        disable_shared_memory(worker);
       }
       out = worker->proxy->bulk_eval_dict_rows(lambda_hash, keys, rows, skip_undefined, seed);
     } catch (cppipc::ipcexception e) {
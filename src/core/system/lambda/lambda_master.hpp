@@ -6,7 +6,9 @@
 #ifndef TURI_LAMBDA_LAMBDA_MASTER_HPP
 #define TURI_LAMBDA_LAMBDA_MASTER_HPP
 
+#include <list>
 #include <map>
+#include <unordered_set>
 #include <core/globals/globals.hpp>
 #include <core/system/lambda/lambda_interface.hpp>
 #include <core/system/lambda/worker_pool.hpp>
@@ -158,13 +160,45 @@ namespace lambda {
 
     lambda_master& operator=(lambda_master const&) = delete;
 
+    /// What a worker has been set up with
+    struct worker_state {
+      bool initialized = false;
+      std::shared_ptr<shmipc::client> shared_memory_connection;
+      std::unordered_set<size_t> lambdas;
+    };
+
+    /**
+     * Sets up the shared memory connection of the worker on its first use,
+     * and registers the lambda in it if it has not been yet. Returns the
+     * shared memory connection of the worker, or nullptr.
+     */
+    std::shared_ptr<shmipc::client> prepare_worker(
+        std::unique_ptr<worker_process<lambda_evaluator_proxy>>& worker,
+        size_t lambda_hash);
+
+    /// Falls back to cppipc for the worker
+    void disable_shared_memory(std::unique_ptr<worker_process<lambda_evaluator_proxy>>& worker);
+
+    /// Releases the lambda in the workers which registered it
+    void release_lambda_in_workers(size_t lambda_hash) noexcept;
+
    private:
     std::shared_ptr<worker_pool<lambda_evaluator_proxy>> m_worker_pool;
-    std::map<void*, std::shared_ptr<shmipc::client>> m_shared_memory_worker_connections;
+    bool m_use_shared_memory = true;
 
     std::unordered_map<size_t, size_t> m_lambda_object_counter;
+    // released lambdas still registered in the workers, least recently used first
+    std::list<size_t> m_cached_lambdas;
     turi::mutex m_mtx;
 
+    // by worker id. Workers are set up lazily, so that workers added to the
+    // pool, or replacing crashed ones, get the lambdas they evaluate.
+    std::unordered_map<size_t, worker_state> m_worker_states;
+    std::unordered_map<size_t, std::string> m_lambda_strings;
+    std::unordered_map<std::string, size_t> m_lambda_hashes;
+    // protects the above three, and is never held over a call to a worker
+    turi::mutex m_state_mtx;
+
     /** The binary for executing the lambda_workers.
      */
     static std::vector<std::string> lambda_worker_binary_and_args;
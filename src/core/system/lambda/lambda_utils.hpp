@@ -7,6 +7,8 @@
 #define TURI_LAMBDA_LAMBDA_UTILS_HPP
 
 #include<core/system/cppipc/common/message_types.hpp>
+#include<core/storage/serialization/serialization_includes.hpp>
+#include<shmipc/shmipc.hpp>
 
 namespace turi {
 namespace lambda {
@@ -26,6 +28,62 @@ inline cppipc::ipcexception reinterpret_comm_failure(cppipc::ipcexception e) {
   }
 }
 
+/**
+ * Performs a remote call to an interprocess shared memory server
+ * deserializing the response to RetType.
+ *
+ * Note that this is not a general purpose function and only works with
+ * the shared memory listeners of pylambda_evaluator and
+ * graph_pylambda_evaluator, which reply with a leading success byte.
+ *
+ * Arguments must be serialized into the "arguments" archive. This function
+ * will also take over management of the buffer inside of "arguments" and
+ * free it when done.
+ *
+ * Results will be deserialized into the ret.
+ *
+ * This function may throw exceptions if remote exceptions were raised.
+ */
+template <typename RetType>
+inline bool shm_call(const std::shared_ptr<shmipc::client>& shmclient,
+                     oarchive& arguments,
+                     RetType& ret) {
+  // send the message
+  bool shmok = shmipc::large_send(*shmclient, arguments.buf, arguments.off);
+  if (shmok == false) {
+    free(arguments.buf); arguments.buf = nullptr;
+  }
+
+  // reuse the arguments buffer so we dont alloc again
+  // receive the reply
+  char* buf = arguments.buf;
+  size_t buflen = arguments.len;
+  size_t receivelen = 0;
+  arguments.buf = nullptr;
+  shmok = shmipc::large_receive(*shmclient, &buf, &buflen,
+                                receivelen, (size_t)(-1));
+  if (shmok == false) {
+    free(buf);
+    return false;
+  }
+
+  // deserialize
+  // first byte is whether it is an error message or not
+  iarchive iarc(buf, receivelen);
+  char good_call;
+  iarc >> good_call;
+  if (good_call) {
+    iarc >> ret;
+  } else {
+    std::string message;
+    iarc >> message;
+    throw message;
+  }
+  free(buf);
+
+  return true;
+}
+
 }
 }
 
@@ -116,15 +116,20 @@ std::vector<flexible_type> pylambda_evaluator::bulk_eval_rows(
   evaluation_functions.set_random_seed(seed);
 
   std::vector<flexible_type> ret(rows.num_rows());
+  if (rows.num_rows() == 0) return ret;
+
+  // the column is contiguous, so it is evaluated in one call, like bulk_eval
+  const auto& column = *(rows.cget_columns()[0]);
+  lambda_call_data lcd;
+  lcd.output_enum_type = flex_type_enum::UNDEFINED;
+  lcd.skip_undefined = skip_undefined;
+  lcd.input_values = column.data();
+  lcd.output_values = ret.data();
+  lcd.n_inputs = column.size();
+
+  evaluation_functions.eval_lambda(lambda_id, &lcd);
+  python::check_for_python_exception();
 
-  size_t i = 0;
-  for (const auto& x : rows) {
-    if (skip_undefined && x[0] == FLEX_UNDEFINED) {
-      ret[i++] = FLEX_UNDEFINED;
-    } else {
-      ret[i++] = eval(lambda_id, x[0]);
-    }
-  }
   return ret;
 }
 
@@ -5,6 +5,7 @@
  */
 #include <core/system/lambda/pylambda_worker.hpp>
 #include <core/system/cppipc/server/comm_server.hpp>
+#include <core/system/cppipc/server/call_replay.hpp>
 #include <core/system/lambda/pylambda.hpp>
 #include <shmipc/shmipc.hpp>
 #include <core/system/lambda/graph_pylambda.hpp>
@@ -96,22 +97,29 @@ int EXPORT pylambda_worker_main(const std::string& root_path,
     }
 
     __TRACK; turi::shmipc::server shm_comm_server;
+    // graph lambda evaluators are served on a separate channel
+    __TRACK; turi::shmipc::server graph_shm_comm_server;
     bool has_shm = false;
+    bool has_graph_shm = false;
 
     try {
       __TRACK; has_shm = use_shm ? shm_comm_server.bind() : false;
+      __TRACK; has_graph_shm = has_shm ? graph_shm_comm_server.bind() : false;
     } catch (const std::string& error) {
       logstream(LOG_ERROR) << "Internal PyLambda Error binding SHM server: "
                            << error << "; disabling SHM." << std::endl;
       has_shm = false;
+      has_graph_shm = false;
     } catch (const std::exception& error) {
       logstream(LOG_ERROR) << "Internal PyLambda Error binding SHM server: "
                            << error.what() << "; disabling SHM." << std::endl;
       has_shm = false;
+      has_graph_shm = false;
     } catch (...) {
       logstream(LOG_ERROR) << "Unknown internal PyLambda Error binding SHM server; disabling SHM."
                            << std::endl;
       has_shm = false;
+      has_graph_shm = false;
     }
 
     __TRACK; LOG_DEBUG_WITH_PID("shm_comm_server bind: has_shm=" << has_shm);
@@ -132,16 +140,38 @@ int EXPORT pylambda_worker_main(const std::string& root_path,
       });
 
     __TRACK; server.register_type<turi::lambda::graph_lambda_evaluator_interface>([&](){
-        __TRACK; auto n = new turi::lambda::graph_pylambda_evaluator();
-        __TRACK; LOG_DEBUG_WITH_PID("creation of graph_pylambda_evaluator complete.");
-        __TRACK; return n;
+        if (has_graph_shm) {
+          __TRACK; auto n = new turi::lambda::graph_pylambda_evaluator(&graph_shm_comm_server);
+          __TRACK; LOG_DEBUG_WITH_PID("creation of graph_pylambda_evaluator with SHM complete.");
+          __TRACK; return n;
+        } else {
+          __TRACK; auto n = new turi::lambda::graph_pylambda_evaluator();
+          __TRACK; LOG_DEBUG_WITH_PID("creation of graph_pylambda_evaluator without SHM complete.");
+          __TRACK; return n;
+        }
       });
 
+    /** If TURI_LAMBDA_WORKER_RECORD_DIR is set, the calls served are
+     *  recorded, and saved to [dir]/[pid] on exit for cppipc_replay.
+     */
+    boost::optional<std::string> record_dir = turi::getenv_str("TURI_LAMBDA_WORKER_RECORD_DIR");
+    if (record_dir && !record_dir->empty()) server.start_recording();
+
     __TRACK; LOG_DEBUG_WITH_PID("Starting server.");
     __TRACK; server.start();
 
     __TRACK; wait_for_parent_exit(parent_pid);
 
+    if (server.is_recording()) {
+      std::string directory = *record_dir + "/" + std::to_string(this_pid);
+      try {
+        cppipc::save_call_recording(server.stop_recording(), directory);
+        LOG_DEBUG_WITH_PID("Saved call recording to " << directory);
+      } catch (...) {
+        logstream(LOG_ERROR) << "Unable to save the call recording to " << directory << std::endl;
+      }
+    }
+
     return 0;
 
     /** Any exceptions happening?  If so, propegate back what's going
@@ -5,6 +5,10 @@
  */
 #include <core/globals/globals.hpp>
 #include <core/export.hpp>
+#include <core/logging/logger.hpp>
+#ifdef __linux__
+#include <sched.h>
+#endif
 
 namespace turi {
 
@@ -18,4 +22,43 @@ EXPORT double LAMBDA_WORKER_CONNECTION_TIMEOUT = 60;
 
 REGISTER_GLOBAL(double, LAMBDA_WORKER_CONNECTION_TIMEOUT, true)
 
+/** The number of idle lambda workers a worker pool keeps started in the
+ *  background, to replace a crashed worker or grow the pool without waiting
+ *  for a process to start.
+ */
+EXPORT size_t LAMBDA_WORKER_NUM_WARM_SPARES = 1;
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            LAMBDA_WORKER_NUM_WARM_SPARES,
+                            true,
+                            +[](int64_t val){ return val >= 0; });
+
+/** If 1, every lambda worker process is pinned to a core, round robin by
+ *  worker id. Only supported on Linux.
+ */
+EXPORT size_t LAMBDA_WORKER_PIN_TO_CORES = 0;
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            LAMBDA_WORKER_PIN_TO_CORES,
+                            true,
+                            +[](int64_t val){ return val == 0 || val == 1; });
+
+namespace lambda {
+
+void pin_process_to_core(size_t pid, size_t core) {
+#ifdef __linux__
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(core, &cpus);
+  if (sched_setaffinity((pid_t)pid, sizeof(cpus), &cpus) != 0) {
+    logstream(LOG_WARNING) << "Unable to pin lambda worker process " << pid
+                           << " to core " << core << std::endl;
+  }
+#else
+  logstream(LOG_INFO) << "Pinning lambda workers to cores is not supported on this platform"
+                      << std::endl;
+#endif
+}
+
+} // end of lambda
 }
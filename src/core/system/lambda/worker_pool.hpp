@@ -13,16 +13,30 @@
 #include<boost/filesystem/path.hpp>
 #include<core/parallel/lambda_omp.hpp>
 #include<core/parallel/pthread_tools.hpp>
+#include<core/parallel/parallelism_controller.hpp>
+#include<core/globals/metrics.hpp>
 #include<process/process.hpp>
 #include<core/system/cppipc/client/comm_client.hpp>
 #include<timer/timer.hpp>
+#include<chrono>
+#include<thread>
 
 namespace turi {
 
 extern double LAMBDA_WORKER_CONNECTION_TIMEOUT;
 
+extern size_t LAMBDA_WORKER_NUM_WARM_SPARES;
+
+extern size_t LAMBDA_WORKER_PIN_TO_CORES;
+
 namespace lambda {
 
+/**
+ * Restrict the process with the given pid to a single core. Only logs a
+ * warning where this is not supported.
+ */
+void pin_process_to_core(size_t pid, size_t core);
+
 /**
  * This class manages the all the resources of a single lambda worker.
  */
@@ -38,6 +52,8 @@ struct worker_process {
   std::string address;
   // process object
   std::unique_ptr<process> process_;
+  // when the worker was last handed out by get_worker()
+  std::chrono::steady_clock::time_point checkout_time;
 
   // next avaiable worker id
   static int get_next_id() {
@@ -251,12 +267,16 @@ class worker_guard;
  * Manage a list of worker_processes.
  *
  * - Initialize:
- * The pool is initialized with a fixed number of workers. Due to system resource
- * limitation, the actual pool may contain less workers than intended.
+ * The pool starts with num_initial_workers workers, and grows on demand up to
+ * num_workers. Due to system resource limitation, the actual pool may contain
+ * less workers than intended.
  *
  * - Acquire worker:
  * User request a worker process by calling get_worker(),
  * which returns a unique_ptr and transfers the ownership of the worker process.
+ * If no worker is available and the pool is below its maximum size, a new
+ * worker is added instead of waiting, so the pool follows the parallelism
+ * of its callers.
  *
  * - Release worker:
  * After the use of the worker, The requested worker_process must be returned
@@ -266,6 +286,11 @@ class worker_guard;
  *
  * get_worker()/release_worker() are thread safe.
  *
+ * - Warm spares:
+ * The pool keeps \ref LAMBDA_WORKER_NUM_WARM_SPARES idle processes started in
+ * a background thread. Growing the pool or replacing a dead worker takes a
+ * spare when there is one, and refills the spares in the background.
+ *
  * - Worker crash recovery:
  * On release_worker(), if the worker_process is dead, a new worker_process
  * will be started and released back to the pool. In the worst case where
@@ -288,7 +313,8 @@ class worker_pool {
 public:
   /**
    * Return the next available worker.
-   * Block until any worker is available.
+   * Block until any worker is available, or start a new one if the pool
+   * can still grow.
    * Throws error if worker_pool has zero workers.
    *
    * \note: This function must be used in pair with release_worker(), or
@@ -298,9 +324,28 @@ public:
    */
   std::unique_ptr<worker_process<ProxyType>> get_worker() {
     std::unique_lock<turi::mutex> lck(m_mutex);
+    while (m_available_workers.empty() &&
+           m_num_workers + m_num_starting < m_max_workers) {
+      // grow the pool instead of waiting
+      ++m_num_starting;
+      lck.unlock();
+      auto new_worker = start_worker();
+      lck.lock();
+      --m_num_starting;
+      cv.notify_all();
+      if (new_worker != nullptr) {
+        ++m_num_workers;
+        check_out(*new_worker);
+        return new_worker;
+      }
+      m_max_workers = m_num_workers + m_num_starting;
+      logstream(LOG_WARNING) << "Cannot grow the worker pool past "
+                             << m_max_workers << " workers" << std::endl;
+    }
     wait_for_one(lck);
     auto worker = std::move(m_available_workers.front());
     m_available_workers.pop_front();
+    check_out(*worker);
     return worker;
   }
 
@@ -315,11 +360,17 @@ public:
 
   /**
    * Put the worker back to the availablity queue.
-   * If the worker process is dead, try replace with a new worker process.
-   * If a new worker process cannot be started, decrease the pool size.
+   * If the worker process is dead, try replace with a spare or a new worker
+   * process. If a new worker process cannot be started, decrease the pool size.
    */
   void release_worker(std::unique_ptr<worker_process<ProxyType>>& worker) {
     logstream(LOG_DEBUG) << "Release worker " << worker->id << std::endl;
+    static metrics::histogram& busy_time = metrics::get_histogram(
+        "lambda_worker_busy_microseconds",
+        "Time a lambda worker was held between get_worker and release_worker.");
+    busy_time.observe(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - worker->checkout_time).count());
+    parallelism_controller::get_instance().add_external_workers(-1);
     std::unique_lock<turi::mutex> lck(m_mutex);
     if (check_alive(worker) == true) {
       // put the worker back to queue
@@ -329,18 +380,24 @@ public:
       // clear dead worker
       worker.reset(nullptr);
       // start new worker
-      auto new_worker = try_spawn_worker<ProxyType>(m_worker_binary_and_args, new_worker_address(), m_connection_timeout);
+      ++m_num_starting;
+      --m_num_workers;
+      lck.unlock();
+      auto new_worker = start_worker();
+      lck.lock();
+      --m_num_starting;
       if (new_worker != nullptr) {
         // put new worker back to queue
         m_available_workers.push_back(std::move(new_worker));
+        ++m_num_workers;
       } else {
-        --m_num_workers;
+        m_max_workers = m_num_workers + m_num_starting;
         logstream(LOG_WARNING) << "Decrease number of workers to "
                                << m_num_workers << std::endl;
       }
     }
     lck.unlock();
-    cv.notify_one();
+    cv.notify_all();
   }
 
   /**
@@ -348,6 +405,11 @@ public:
    */
   size_t num_workers() const { return m_num_workers; };
 
+  /**
+   * Return the number of workers the pool may grow to.
+   */
+  size_t max_workers() const { return m_max_workers; };
+
   /**
    * Return number of avaiable workers in the pool.
    */
@@ -362,48 +424,59 @@ public:
    */
   template<typename RetType, typename Fn>
   std::vector<RetType> call_all_workers(Fn f) {
+    return call_all_worker_processes<RetType>(
+        [&](std::unique_ptr<worker_process<ProxyType>>& worker) {
+          return f(worker->proxy);
+        });
+  }
+
+  /**
+   * Same as call_all_workers(), but the function is called on the
+   * worker_process, for callers which keep per worker state by worker id.
+   */
+  template<typename RetType, typename Fn>
+  std::vector<RetType> call_all_worker_processes(Fn f) {
     std::unique_lock<turi::mutex> lck(m_mutex);
     wait_for_all(lck);
     // take out all workers from m_avaiable_workers
     // equivalent to call get_worker() in batch with lck acquired.
     std::vector<std::unique_ptr<worker_process<ProxyType>>> temp_workers;
-    for (size_t i = 0; i < m_num_workers; ++i) {
+    while (!m_available_workers.empty()) {
       temp_workers.push_back(std::move(m_available_workers.front()));
       m_available_workers.pop_front();
+      check_out(*temp_workers.back());
     }
 
     // The following code calls release_worker() for crash recovery,
     // and release_worker() calls lock inside.
     // Because no workers is avaialable externally, we can safely release the lock.
+    // Workers added by get_worker() meanwhile are not called.
     lck.unlock();
 
-    try {
-      std::vector<std::shared_ptr<worker_guard<ProxyType>>> guards;
-      for (auto& worker: temp_workers)
-        guards.push_back(get_worker_guard(worker));
-      std::vector<RetType> ret(m_num_workers);
-      parallel_for(0, m_num_workers, [&](size_t i) {
-        try {
-          ret[i] = f(temp_workers[i]->proxy);
-        } catch (cppipc::ipcexception e) {
-          throw reinterpret_comm_failure(e);
-        }
-      });
-      return ret;
-    } catch (...) {
-      ASSERT_EQ(m_available_workers.size(), m_num_workers);
-      std::rethrow_exception(std::current_exception());
-    }
+    std::vector<std::shared_ptr<worker_guard<ProxyType>>> guards;
+    for (auto& worker: temp_workers)
+      guards.push_back(get_worker_guard(worker));
+    std::vector<RetType> ret(temp_workers.size());
+    parallel_for(0, temp_workers.size(), [&](size_t i) {
+      try {
+        ret[i] = f(temp_workers[i]);
+      } catch (const cppipc::ipcexception& e) {
+        throw reinterpret_comm_failure(e);
+      }
+    });
+    return ret;
   }
 
   /// constructor
   worker_pool(size_t num_workers,
               std::vector<std::string> worker_binary_and_args,
-              int connection_timeout = 3) {
+              int connection_timeout = 3,
+              size_t num_initial_workers = size_t(-1)) {
     m_connection_timeout = connection_timeout;
     m_worker_binary_and_args = worker_binary_and_args;
     m_num_workers = 0;
-    init(num_workers);
+    m_max_workers = num_workers;
+    init(std::max<size_t>(1, std::min(num_workers, num_initial_workers)));
   }
 
   /// destructor
@@ -412,34 +485,52 @@ public:
     try {
       wait_for_all(lck);
     } catch (...) { }
+    m_shutting_down = true;
+    lck.unlock();
+    if (m_spare_thread.joinable()) m_spare_thread.join();
     parallel_for(0, m_available_workers.size(), [&](size_t i) {
       m_available_workers[i].reset();
     });
+    parallel_for(0, m_spare_workers.size(), [&](size_t i) {
+      m_spare_workers[i].reset();
+    });
   }
 
 private:
   /**
-   * Wait until all workers are returned. Throw error if pool size become 0.
+   * Marks a worker as handed out. Busy workers run on CPUs of their own, so
+   * the parallelism_controller leaves room for them when sizing native
+   * worker threads.
+   */
+  void check_out(worker_process<ProxyType>& worker) {
+    worker.checkout_time = std::chrono::steady_clock::now();
+    parallelism_controller::get_instance().add_external_workers(1);
+  }
+
+  /**
+   * Wait until all workers are returned, and no worker is being started.
+   * Throw error if pool size become 0.
    */
   void wait_for_all(std::unique_lock<turi::mutex>& lck) {
-    while (m_available_workers.size() < m_num_workers || m_num_workers == 0) {
+    while (m_available_workers.size() < m_num_workers || m_num_starting > 0 ||
+           m_num_workers == 0) {
+      if (m_num_workers == 0 && m_num_starting == 0) {
+        throw("Worker pool is empty");
+      }
       cv.wait(lck);
     }
-    if (m_num_workers == 0) {
-      throw("Worker pool is empty");
-    }
   }
 
   /**
    * Wait until a single worker is aviailable. Throw error if pool size become 0.
    */
   void wait_for_one(std::unique_lock<turi::mutex>& lck) {
-    while (m_available_workers.empty() || m_num_workers == 0) {
+    while (m_available_workers.empty()) {
+      if (m_num_workers == 0 && m_num_starting == 0) {
+        throw("Worker pool is empty");
+      }
       cv.wait(lck);
     }
-    if (m_num_workers == 0) {
-      throw("Worker pool is empty");
-    }
   }
 
   /**
@@ -456,14 +547,73 @@ private:
     return "ipc://" + get_temp_name();
   }
 
+  /**
+   * Spawn a new worker process, pinned to a core if
+   * \ref LAMBDA_WORKER_PIN_TO_CORES is set. Return nullptr on failure.
+   */
+  std::unique_ptr<worker_process<ProxyType>> spawn_new_worker() {
+    auto new_worker = try_spawn_worker<ProxyType>(m_worker_binary_and_args,
+                                                  new_worker_address(),
+                                                  m_connection_timeout);
+    if (new_worker != nullptr && LAMBDA_WORKER_PIN_TO_CORES) {
+      pin_process_to_core(new_worker->process_->get_pid(),
+                          new_worker->id % std::max<size_t>(thread::cpu_count(), 1));
+    }
+    return new_worker;
+  }
+
+  /**
+   * Return a worker to add to the pool: a live spare if there is one,
+   * otherwise a newly spawned process. Refills the spares in the background.
+   * Must be called without holding the lock.
+   */
+  std::unique_ptr<worker_process<ProxyType>> start_worker() {
+    std::unique_ptr<worker_process<ProxyType>> new_worker;
+    {
+      std::unique_lock<turi::mutex> lck(m_mutex);
+      while (!m_spare_workers.empty() && new_worker == nullptr) {
+        new_worker = std::move(m_spare_workers.front());
+        m_spare_workers.pop_front();
+        if (!check_alive(new_worker)) new_worker.reset();
+      }
+    }
+    if (new_worker == nullptr) new_worker = spawn_new_worker();
+    refill_spares();
+    return new_worker;
+  }
+
+  /**
+   * Start a background thread spawning spare workers until there are
+   * \ref LAMBDA_WORKER_NUM_WARM_SPARES of them, unless one is running already.
+   */
+  void refill_spares() {
+    std::unique_lock<turi::mutex> lck(m_mutex);
+    if (m_refilling_spares || m_shutting_down ||
+        m_spare_workers.size() >= LAMBDA_WORKER_NUM_WARM_SPARES) {
+      return;
+    }
+    m_refilling_spares = true;
+    // the previous refill thread has cleared the flag and is exiting
+    if (m_spare_thread.joinable()) m_spare_thread.join();
+    m_spare_thread = std::thread([this]() {
+      std::unique_lock<turi::mutex> lck(m_mutex);
+      while (!m_shutting_down && m_spare_workers.size() < LAMBDA_WORKER_NUM_WARM_SPARES) {
+        lck.unlock();
+        auto spare = spawn_new_worker();
+        lck.lock();
+        if (spare == nullptr) break;
+        m_spare_workers.push_back(std::move(spare));
+      }
+      m_refilling_spares = false;
+    });
+  }
+
   /**
    * Initialize the pool with N workers.
    */
   void init(size_t num_workers) {
     parallel_for(0, num_workers, [&](size_t i) {
-      auto new_worker = try_spawn_worker<ProxyType>(m_worker_binary_and_args,
-                                                    new_worker_address(),
-                                                    m_connection_timeout);
+      auto new_worker = spawn_new_worker();
       if (new_worker != nullptr) {
         std::unique_lock<turi::mutex> lck(m_mutex);
         m_available_workers.push_back(std::move(new_worker));
@@ -474,6 +624,7 @@ private:
     if (m_num_workers == 0) {
       log_and_throw("Cannot evaluate lambda. No Lambda workers have been successfully started.");
     } else if (m_num_workers < num_workers) {
+      m_max_workers = m_num_workers;
       logprogress_stream << "Less than " << num_workers << " successfully started. "
                          << "Using only " << m_num_workers  << " workers." << std::endl;
       logprogress_stream << "All operations will proceed as normal, but "
@@ -482,13 +633,23 @@ private:
       logstream(LOG_ERROR) << "Less than " << num_workers << " successfully started."
                            << "Using only " << m_num_workers << std::endl;
     }
+    refill_spares();
   }
 
 private:
   std::vector<std::string> m_worker_binary_and_args;
   int m_connection_timeout;
   std::deque<std::unique_ptr<worker_process<ProxyType>>> m_available_workers;
+  // started processes which are not part of the pool yet
+  std::deque<std::unique_ptr<worker_process<ProxyType>>> m_spare_workers;
+  // workers in the pool, available or not
   size_t m_num_workers;
+  // workers being started by get_worker() or release_worker()
+  size_t m_num_starting = 0;
+  size_t m_max_workers;
+  bool m_refilling_spares = false;
+  bool m_shutting_down = false;
+  std::thread m_spare_thread;
   turi::condition_variable cv;
   turi::mutex m_mutex;
 }; // end of worker_pool
@@ -74,15 +74,18 @@ int async_request_socket::request_master(zmq_msg_vector& msgs,
   lock.unlock();
   create_socket(wait_socket);
   int rc = 0;
+  timer ti;
   // retry a few times
   for (size_t retry = 0; retry < 3; ++retry) {
     do {
       rc = msgs.send(sockets[wait_socket].z_socket, SEND_TIMEOUT);
+      // the send only completes once the server is reachable
+      if (rc != 0 && timeout > 0 && ti.current_time() > timeout) break;
     } while(rc == EAGAIN);
-    if (rc == 0) break;
+    // EAGAIN here means we timed out
+    if (rc == 0 || rc == EAGAIN) break;
   }
   if (rc == 0) {
-    timer ti;
     do {
       rc = ret.recv(sockets[wait_socket].z_socket, 1000);
       if (rc != 0 && receive_poller && receive_poller() == false) break;
@@ -67,7 +67,9 @@ class EXPORT async_request_socket {
    *
    * \param msgs The message to send
    * \param ret The returned message will be stored here
-   * \param timeout Number of seconds to wait before timeout. Defaults to 0
+   * \param timeout Number of seconds to wait for the request to be sent and
+   *                answered before timeout. Defaults to 0, which waits
+   *                forever.
    */
   int request_master(zmq_msg_vector& msgs,
                      zmq_msg_vector& ret,
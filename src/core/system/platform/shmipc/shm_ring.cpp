@@ -0,0 +1,437 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <atomic>
+#include <thread>
+#include <cstring>
+#include <core/parallel/atomic.hpp>
+#include <core/logging/logger.hpp>
+#include <shmipc/shm_ring.hpp>
+#include <shmipc/shmipc_garbage_collect.hpp>
+#include <process/process_util.hpp>
+#include <boost/version.hpp>
+#if BOOST_VERSION <= 105600 && defined(_WIN32)
+#define BOOST_INTERPROCESS_WIN32_PRIMITIVES_HPP
+#include "boost_alt_winapi.h"
+#endif
+
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/sync/interprocess_mutex.hpp>
+#include <boost/interprocess/sync/interprocess_condition.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/thread/thread_time.hpp>
+namespace turi {
+namespace shmipc {
+using boost::interprocess::read_write;
+using boost::interprocess::open_only;
+using boost::interprocess::create_only;
+using boost::interprocess::shared_memory_object;
+using boost::interprocess::mapped_region;
+using boost::interprocess::interprocess_mutex;
+using boost::interprocess::interprocess_condition;
+using boost::interprocess::scoped_lock;
+
+// The positions are shared between processes, which requires address free
+// atomics.
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+              "shared memory rings require lock free atomics");
+
+namespace {
+
+const size_t CACHE_LINE_SIZE = 64;
+
+/// Record header of a padding record, which skips to the start of the ring
+const uint64_t RECORD_PADDING = uint64_t(-1);
+
+/// Flags a record whose payload refers to the spill segment of the sender
+const uint64_t RECORD_SPILLED = uint64_t(1) << 63;
+
+inline size_t round_up(size_t n, size_t multiple) {
+  return (n + multiple - 1) / multiple * multiple;
+}
+
+} // anonymous namespace
+
+/**
+ * A single producer / single consumer ring of records. A record is a 64 bit
+ * header holding the payload length, followed by the payload, padded to 8
+ * bytes. Records never wrap around: a padding record fills the end of the
+ * ring instead. The positions only grow, and are taken modulo the capacity.
+ */
+struct ring_buffer {
+  // bytes consumed. Only written by the receiver
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head;
+  // bytes produced. Only written by the sender
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail;
+  alignas(CACHE_LINE_SIZE) uint64_t capacity;
+
+  explicit ring_buffer(uint64_t capacity) : head(0), tail(0), capacity(capacity) { }
+
+  char* data() {
+    return reinterpret_cast<char*>(this) + round_up(sizeof(ring_buffer), CACHE_LINE_SIZE);
+  }
+
+  static size_t total_size(size_t capacity) {
+    return round_up(sizeof(ring_buffer), CACHE_LINE_SIZE) + capacity;
+  }
+};
+
+struct ring_channel_header {
+  std::atomic<uint64_t> server_pid;
+  std::atomic<uint64_t> client_pid;
+  std::atomic<uint32_t> client_connected;
+  std::atomic<uint32_t> closed;
+  // 1 while the spill segment of a side holds a message not yet released by
+  // the receiver
+  std::atomic<uint32_t> server_spill_in_use;
+  std::atomic<uint32_t> client_spill_in_use;
+  // number of threads blocked on cond. Every change a waiter may be waiting
+  // for is followed by a notification if there is one.
+  std::atomic<uint32_t> waiters;
+  interprocess_mutex lock;
+  interprocess_condition cond;
+  uint64_t ring_size;
+
+  explicit ring_channel_header(uint64_t ring_size)
+      : server_pid(0), client_pid(0), client_connected(0), closed(0),
+        server_spill_in_use(0), client_spill_in_use(0), waiters(0),
+        ring_size(ring_size) { }
+
+  static size_t total_size(size_t ring_size) {
+    return round_up(sizeof(ring_channel_header), CACHE_LINE_SIZE) +
+        2 * ring_buffer::total_size(ring_size);
+  }
+};
+
+namespace {
+
+/**
+ * Wakes up the threads of either side blocked in wait_until(), if any.
+ * Called after every change they may be waiting for.
+ */
+void notify_waiters(ring_channel_header* header) {
+  // pairs with the fence of wait_until(): either the waiter sees the change,
+  // or we see the waiter
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (header->waiters.load(std::memory_order_relaxed) == 0) return;
+  scoped_lock<interprocess_mutex> guard(header->lock);
+  header->cond.notify_all();
+}
+
+/**
+ * Waits until done() returns true. Spins briefly, since the other side
+ * usually answers within microseconds, then blocks on the condition of the
+ * channel until notified. Gives up when timeout seconds elapse (unless it is
+ * (size_t)(-1)), or when alive() returns false; a process which exits cannot
+ * notify, so alive() is also checked every second while blocked.
+ * Returns the last value of done().
+ */
+template <typename Done, typename Alive>
+bool wait_until(ring_channel_header* header, Done done, Alive alive, size_t timeout) {
+  const size_t SPIN_ITERATIONS = 1000;
+  const size_t YIELD_ITERATIONS = 100;
+  for (size_t iter = 0; iter < SPIN_ITERATIONS + YIELD_ITERATIONS; ++iter) {
+    if (done()) return true;
+    if (iter >= SPIN_ITERATIONS) std::this_thread::yield();
+  }
+
+  const bool has_timeout = (timeout != (size_t)(-1));
+  boost::system_time timeout_time = boost::get_system_time();
+  if (has_timeout) timeout_time += boost::posix_time::seconds(timeout);
+
+  scoped_lock<interprocess_mutex> guard(header->lock);
+  header->waiters.fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while (!done()) {
+    boost::system_time cur_time = boost::get_system_time();
+    if (has_timeout && cur_time >= timeout_time) break;
+    if (!alive()) break;
+    boost::system_time wake_time = cur_time + boost::posix_time::seconds(1);
+    if (has_timeout && timeout_time < wake_time) wake_time = timeout_time;
+    header->cond.timed_wait(guard, wake_time);
+  }
+  header->waiters.fetch_sub(1);
+  return done();
+}
+
+} // anonymous namespace
+
+/*
+ * Generates unique channel names of the sort [pid]_r[counter]
+ */
+static atomic<size_t> RING_CHANNEL_COUNTER;
+
+ring_channel::ring_channel() = default;
+
+ring_channel::~ring_channel() {
+  shutdown();
+}
+
+void ring_channel::map_rings() {
+  char* base = reinterpret_cast<char*>(m_header);
+  size_t ring_size = m_header->ring_size;
+  auto client_to_server = reinterpret_cast<ring_buffer*>(
+      base + round_up(sizeof(ring_channel_header), CACHE_LINE_SIZE));
+  auto server_to_client = reinterpret_cast<ring_buffer*>(
+      reinterpret_cast<char*>(client_to_server) + ring_buffer::total_size(ring_size));
+  m_send_ring = m_is_server ? server_to_client : client_to_server;
+  m_receive_ring = m_is_server ? client_to_server : server_to_client;
+}
+
+bool ring_channel::bind(const std::string& ipcfile, size_t ring_size) {
+  ring_size = std::max<size_t>(round_up(ring_size, CACHE_LINE_SIZE), 1024);
+  try {
+    m_shmname = ipcfile;
+    if (m_shmname.empty()) {
+      m_shmname = std::to_string(get_my_pid()) + "_r" +
+          std::to_string(RING_CHANNEL_COUNTER.inc());
+    }
+    logstream(LOG_INFO) << "Ring channel binding to " << m_shmname << " "
+                        << ring_size << std::endl;
+    m_ipcfile_deleter = register_shared_memory_name(m_shmname);
+    m_shared_object.reset(new shared_memory_object(create_only,
+                                                   m_shmname.c_str(),
+                                                   read_write));
+    m_shared_object->truncate(ring_channel_header::total_size(ring_size));
+    m_mapped_region.reset(new mapped_region(*m_shared_object, read_write));
+    m_header = new (m_mapped_region->get_address()) ring_channel_header(ring_size);
+    m_is_server = true;
+    map_rings();
+    new (m_send_ring) ring_buffer(ring_size);
+    new (m_receive_ring) ring_buffer(ring_size);
+    m_header->server_pid.store(get_my_pid(), std::memory_order_release);
+    notify_waiters(m_header);
+  } catch (const std::exception& error) {
+    logstream(LOG_ERROR) << "Ring channel initialization error: " << error.what() << std::endl;
+    m_header = nullptr;
+    return false;
+  } catch (...) {
+    logstream(LOG_ERROR) << "Unknown ring channel initialization error" << std::endl;
+    m_header = nullptr;
+    return false;
+  }
+  return true;
+}
+
+std::string ring_channel::get_shared_memory_name() const {
+  return m_shmname;
+}
+
+bool ring_channel::wait_for_connect(size_t timeout) {
+  if (m_header == nullptr || !m_is_server) return false;
+  m_connected = wait_until(
+      m_header,
+      [&]() { return m_header->client_connected.load(std::memory_order_acquire) == 1; },
+      [&]() { return m_header->closed.load() == 0; },
+      timeout);
+  if (m_connected) {
+    // unlink the shared memory segment so as to minimize leakage potential
+    m_ipcfile_deleter.reset();
+    logstream(LOG_INFO) << "Ring channel connected at " << m_shmname << std::endl;
+  } else {
+    logstream(LOG_INFO) << "Ring channel connection timeout at " << m_shmname << std::endl;
+  }
+  return m_connected;
+}
+
+bool ring_channel::connect(const std::string& ipcfile, size_t timeout) {
+  logstream(LOG_INFO) << "Ring channel connecting to " << ipcfile << std::endl;
+  try {
+    m_shmname = ipcfile;
+    m_shared_object.reset(new shared_memory_object(open_only,
+                                                   ipcfile.c_str(),
+                                                   read_write));
+    m_mapped_region.reset(new mapped_region(*m_shared_object, read_write));
+  } catch (const std::exception& error) {
+    logstream(LOG_ERROR) << "Ring channel connection error: " << error.what() << std::endl;
+    return false;
+  }
+  m_header = reinterpret_cast<ring_channel_header*>(m_mapped_region->get_address());
+  if (m_header == nullptr) return false;
+  // the server publishes its pid last
+  if (!wait_until(m_header, [&]() { return m_header->server_pid.load(std::memory_order_acquire) != 0; },
+                  [&]() { return m_header->closed.load() == 0; },
+                  timeout)) {
+    m_header = nullptr;
+    return false;
+  }
+  m_is_server = false;
+  map_rings();
+  m_header->client_pid.store(get_my_pid());
+  m_header->client_connected.store(1, std::memory_order_release);
+  notify_waiters(m_header);
+  m_connected = true;
+  return true;
+}
+
+bool ring_channel::peer_alive() const {
+  if (m_header == nullptr || m_header->closed.load() != 0) return false;
+  size_t pid = m_is_server ? m_header->client_pid.load() : m_header->server_pid.load();
+  return pid == 0 || is_process_running(pid);
+}
+
+bool ring_channel::is_connected() const {
+  return m_connected && peer_alive();
+}
+
+bool ring_channel::reserve_spill(size_t len) {
+  if (m_spill_size >= len) return true;
+  size_t size = round_up(std::max<size_t>(len, 2 * m_spill_size), 1024 * 1024);
+  std::string name = m_shmname + (m_is_server ? "s" : "c") + std::to_string(m_spill_counter++);
+  try {
+    auto deleter = register_shared_memory_name(name);
+    std::shared_ptr<shared_memory_object> object(
+        new shared_memory_object(create_only, name.c_str(), read_write));
+    object->truncate(size);
+    std::shared_ptr<mapped_region> region(new mapped_region(*object, read_write));
+    // the previous segment is unlinked; the receiver keeps its mapping
+    // until it sees the new name
+    m_spill_deleter = deleter;
+    m_spill_object = object;
+    m_spill_region = region;
+    m_spill_name = name;
+    m_spill_size = size;
+  } catch (const std::exception& error) {
+    logstream(LOG_ERROR) << "Unable to allocate " << size << " bytes of shared memory: "
+                         << error.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool ring_channel::send(const char* c, size_t len, size_t timeout) {
+  if (!m_connected) return false;
+  auto alive = [&]() { return peer_alive(); };
+  ring_buffer& ring = *m_send_ring;
+  const uint64_t capacity = ring.capacity;
+
+  // large messages go through the spill segment
+  const bool spill = len > capacity / 4;
+  std::atomic<uint32_t>& spill_in_use =
+      m_is_server ? m_header->server_spill_in_use : m_header->client_spill_in_use;
+  std::string reference;
+  const char* payload = c;
+  size_t payload_len = len;
+  if (spill) {
+    // the receiver must be done with the previous spilled message
+    if (!wait_until(m_header, [&]() { return spill_in_use.load(std::memory_order_acquire) == 0; },
+                    alive, timeout)) {
+      return false;
+    }
+    if (!reserve_spill(len)) return false;
+    if (len > 0) memcpy(m_spill_region->get_address(), c, len);
+    uint64_t len64 = len;
+    reference.assign(reinterpret_cast<const char*>(&len64), sizeof(len64));
+    reference += m_spill_name;
+    payload = reference.data();
+    payload_len = reference.size();
+  }
+
+  // wait for room for the record, and the padding before it if it would wrap
+  const size_t record_size = sizeof(uint64_t) + round_up(payload_len, 8);
+  uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+  size_t pos = tail % capacity;
+  size_t contiguous = capacity - pos;
+  size_t needed = record_size + (contiguous < record_size ? contiguous : 0);
+  if (!wait_until(m_header, [&]() {
+        return capacity - (tail - ring.head.load(std::memory_order_acquire)) >= needed;
+      }, alive, timeout)) {
+    return false;
+  }
+  if (contiguous < record_size) {
+    memcpy(ring.data() + pos, &RECORD_PADDING, sizeof(uint64_t));
+    tail += contiguous;
+    pos = 0;
+  }
+  uint64_t header = payload_len | (spill ? RECORD_SPILLED : 0);
+  memcpy(ring.data() + pos, &header, sizeof(uint64_t));
+  if (payload_len > 0) memcpy(ring.data() + pos + sizeof(uint64_t), payload, payload_len);
+  if (spill) spill_in_use.store(1, std::memory_order_relaxed);
+  ring.tail.store(tail + record_size, std::memory_order_release);
+  notify_waiters(m_header);
+  return true;
+}
+
+bool ring_channel::receive(const char** c, size_t* len, size_t timeout) {
+  if (!m_connected) return false;
+  release_received();
+  ring_buffer& ring = *m_receive_ring;
+  const uint64_t capacity = ring.capacity;
+  while (true) {
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    if (!wait_until(m_header, [&]() { return ring.tail.load(std::memory_order_acquire) != head; },
+                    [&]() { return peer_alive(); }, timeout)) {
+      return false;
+    }
+    size_t pos = head % capacity;
+    uint64_t header;
+    memcpy(&header, ring.data() + pos, sizeof(uint64_t));
+    if (header == RECORD_PADDING) {
+      ring.head.store(head + (capacity - pos), std::memory_order_release);
+      notify_waiters(m_header);
+      continue;
+    }
+    const size_t payload_len = header & ~RECORD_SPILLED;
+    const size_t record_size = sizeof(uint64_t) + round_up(payload_len, 8);
+    const char* payload = ring.data() + pos + sizeof(uint64_t);
+    if ((header & RECORD_SPILLED) == 0) {
+      // read in place, and consume the record on release
+      *c = payload;
+      *len = payload_len;
+      m_received_record_size = record_size;
+      return true;
+    }
+
+    // the message is in the spill segment of the sender
+    uint64_t data_len;
+    memcpy(&data_len, payload, sizeof(uint64_t));
+    std::string name(payload + sizeof(uint64_t), payload_len - sizeof(uint64_t));
+    ring.head.store(head + record_size, std::memory_order_release);
+    notify_waiters(m_header);
+    m_received_spilled = true;
+    if (name != m_peer_spill_name) {
+      try {
+        m_peer_spill_object.reset(new shared_memory_object(open_only, name.c_str(), read_write));
+        m_peer_spill_region.reset(new mapped_region(*m_peer_spill_object, read_write));
+        m_peer_spill_name = name;
+      } catch (const std::exception& error) {
+        logstream(LOG_ERROR) << "Unable to map shared memory " << name << ": "
+                             << error.what() << std::endl;
+        release_received();
+        return false;
+      }
+    }
+    *c = reinterpret_cast<const char*>(m_peer_spill_region->get_address());
+    *len = data_len;
+    return true;
+  }
+}
+
+void ring_channel::release_received() {
+  if (m_received_record_size == 0 && !m_received_spilled) return;
+  if (m_received_record_size > 0) {
+    ring_buffer& ring = *m_receive_ring;
+    ring.head.store(ring.head.load(std::memory_order_relaxed) + m_received_record_size,
+                    std::memory_order_release);
+    m_received_record_size = 0;
+  }
+  if (m_received_spilled) {
+    auto& peer_spill_in_use =
+        m_is_server ? m_header->client_spill_in_use : m_header->server_spill_in_use;
+    peer_spill_in_use.store(0, std::memory_order_release);
+    m_received_spilled = false;
+  }
+  notify_waiters(m_header);
+}
+
+void ring_channel::shutdown() {
+  if (m_header == nullptr) return;
+  m_header->closed.store(1);
+  notify_waiters(m_header);
+}
+
+} // shmipc
+} // namespace turi
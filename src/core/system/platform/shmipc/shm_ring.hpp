@@ -0,0 +1,164 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SHMIPC_SHM_RING_HPP
+#define TURI_SHMIPC_SHM_RING_HPP
+#include <string>
+#include <cstddef>
+#include <memory>
+#include <boost/interprocess/interprocess_fwd.hpp>
+namespace turi {
+namespace shmipc {
+
+struct raii_deleter;
+struct ring_channel_header;
+struct ring_buffer;
+
+/**
+ * \ingroup shmipc
+ * A bidirectional message channel between two processes of the same host,
+ * over interprocess shared memory.
+ *
+ * Each direction is a lock-free single producer / single consumer ring of
+ * length prefixed messages: the sender and the receiver only share a pair of
+ * atomic positions, and neither takes a lock or makes a system call when the
+ * ring is neither full nor empty. Waiting spins briefly, then blocks on an
+ * interprocess condition, which the other side only signals when a thread is
+ * blocked on it.
+ *
+ * Messages larger than a quarter of the ring are not copied through it. The
+ * sender writes them into a shared memory segment it owns (the "spill"
+ * segment, grown as needed and reused across messages), and only sends a
+ * reference to it through the ring. The receiver maps the segment once and
+ * reads the message in place.
+ *
+ * receive() returns a pointer into shared memory, valid until
+ * release_received(), so messages are read without a copy in both cases.
+ *
+ * Like \ref server, one side binds a name and waits for the other side to
+ * connect, after which the name is unlinked. Each side may only be used by one
+ * thread at a time.
+ *
+ * \code
+ * // server
+ * ring_channel server;
+ * server.bind();
+ * // pass server.get_shared_memory_name() to the client process
+ * server.wait_for_connect();
+ * const char* c; size_t len;
+ * if (server.receive(&c, &len)) {
+ *   ... // use c[0 .. len)
+ *   server.release_received();
+ * }
+ *
+ * // client
+ * ring_channel client;
+ * client.connect(name);
+ * client.send("hello", 5);
+ * \endcode
+ */
+class ring_channel {
+ public:
+  ring_channel();
+  ~ring_channel();
+
+  /**
+   * Creates the channel under a shared memory name, with rings of ring_size
+   * bytes in each direction. If ipcfile is empty a name is generated, see
+   * \ref get_shared_memory_name().
+   */
+  bool bind(const std::string& ipcfile = "", size_t ring_size = 4 * 1024 * 1024);
+
+  /**
+   * Returns the shared memory name of a bound channel.
+   */
+  std::string get_shared_memory_name() const;
+
+  /**
+   * Waits up to timeout seconds for the other side to connect.
+   */
+  bool wait_for_connect(size_t timeout = 10);
+
+  /**
+   * Connects to a channel bound by another process.
+   */
+  bool connect(const std::string& ipcfile, size_t timeout = 10);
+
+  /**
+   * Sends a message of any length. Waits up to timeout seconds for room in
+   * the ring, or for the receiver to release the previous large message.
+   * Returns false on timeout, or if the other side is gone.
+   */
+  bool send(const char* c, size_t len, size_t timeout = (size_t)(-1));
+
+  /**
+   * Waits up to timeout seconds for a message, and points (*c) and (*len)
+   * to it. The message stays valid, and no other message can be received,
+   * until release_received() is called.
+   * Returns false on timeout, or if the other side is gone.
+   */
+  bool receive(const char** c, size_t* len, size_t timeout = (size_t)(-1));
+
+  /**
+   * Releases the message returned by the last receive().
+   */
+  void release_received();
+
+  /**
+   * Returns true if the channel is connected, and the other side has not
+   * shut it down or exited.
+   */
+  bool is_connected() const;
+
+  /**
+   * Shuts the channel down. Waiting calls on both sides return false.
+   */
+  void shutdown();
+
+ private:
+  // true for the side which bound the channel
+  bool m_is_server = false;
+  bool m_connected = false;
+  std::string m_shmname;
+  std::shared_ptr<raii_deleter> m_ipcfile_deleter;
+  std::shared_ptr<boost::interprocess::shared_memory_object> m_shared_object;
+  std::shared_ptr<boost::interprocess::mapped_region> m_mapped_region;
+  ring_channel_header* m_header = nullptr;
+  ring_buffer* m_send_ring = nullptr;
+  ring_buffer* m_receive_ring = nullptr;
+
+  // the spill segment of this side, for sending large messages
+  std::string m_spill_name;
+  size_t m_spill_size = 0;
+  size_t m_spill_counter = 0;
+  std::shared_ptr<raii_deleter> m_spill_deleter;
+  std::shared_ptr<boost::interprocess::shared_memory_object> m_spill_object;
+  std::shared_ptr<boost::interprocess::mapped_region> m_spill_region;
+
+  // the spill segment of the other side, mapped on first use
+  std::string m_peer_spill_name;
+  std::shared_ptr<boost::interprocess::shared_memory_object> m_peer_spill_object;
+  std::shared_ptr<boost::interprocess::mapped_region> m_peer_spill_region;
+
+  // the ring bytes taken by the message being received, 0 if none
+  size_t m_received_record_size = 0;
+  bool m_received_spilled = false;
+
+  /// Maps the channel segment and sets up the ring pointers
+  void map_rings();
+
+  /// Returns false if the channel is shut down, or the other side is gone
+  bool peer_alive() const;
+
+  /// Makes sure the spill segment holds at least len bytes
+  bool reserve_spill(size_t len);
+
+  ring_channel(const ring_channel&) = delete;
+  ring_channel& operator=(const ring_channel&) = delete;
+};
+
+} // shmipc
+} // namespace turi
+#endif
@@ -25,6 +25,7 @@
 #include <core/storage/fileio/temp_files.hpp>
 #include <core/storage/fileio/block_cache.hpp>
 #include <core/parallel/thread_pool.hpp>
+#include <core/random/random.hpp>
 #include <core/logging/logger.hpp>
 #include <core/logging/log_rotate.hpp>
 #ifdef TC_HAS_PYTHON
@@ -170,6 +171,9 @@ void configure_global_environment(std::string argv0) {
     turi::sframe_config::SFRAME_SORT_BUFFER_SIZE = total_system_memory / 4;
     turi::fileio::FILEIO_MAXIMUM_CACHE_CAPACITY_PER_FILE = total_system_memory / 2;
     turi::fileio::FILEIO_MAXIMUM_CACHE_CAPACITY = total_system_memory / 2;
+    // the limits above add up to more than the working memory; the budget
+    // makes them share it.
+    turi::fileio::FILEIO_MEMORY_BUDGET = total_system_memory;
   }
   turi::globals::initialize_globals_from_environment(argv0);
 
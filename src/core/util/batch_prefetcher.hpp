@@ -0,0 +1,156 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_UTIL_BATCH_PREFETCHER_HPP
+#define TURI_UTIL_BATCH_PREFETCHER_HPP
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <algorithm>
+#include <iterator>
+
+namespace turi {
+
+/**
+ * \ingroup util
+ * Produces batches of values on a background thread, ahead of a consumer
+ * which reads them in order, so that producing the next batch overlaps with
+ * consuming the previous one.
+ *
+ * The generator is called as generator(batch, len) and must append up to len
+ * values to batch; appending fewer than len values marks the end of the
+ * sequence. At most max_batches batches are produced ahead of the consumer:
+ * the producer waits when the consumer falls behind. With max_batches = 0,
+ * nothing is produced ahead, and get_next() calls the generator directly.
+ *
+ * \code
+ * batch_prefetcher<int> prefetcher(
+ *     [&](std::vector<int>& batch, size_t len) { ... }, 2);
+ * while(1) {
+ *   auto values = prefetcher.get_next(64);
+ *   // do stuff
+ *   if (values.size() < 64) break;
+ * }
+ * \endcode
+ *
+ * Batches are produced with the length of the last get_next() call, and
+ * get_next() returns exactly len values unless the sequence ends, whatever
+ * the lengths of the batches already produced. An exception thrown by the
+ * generator is rethrown by get_next() once the values before it are read.
+ *
+ * get_next() must not be called from several threads at once. Destroying the
+ * prefetcher stops the background thread.
+ */
+template <typename T>
+class batch_prefetcher {
+ public:
+  typedef std::function<void(std::vector<T>& batch, size_t len)> generator_type;
+
+  batch_prefetcher(generator_type generator, size_t max_batches)
+      : m_generator(generator), m_max_batches(max_batches) { }
+
+  ~batch_prefetcher() {
+    {
+      std::lock_guard<std::mutex> guard(m_lock);
+      m_stopping = true;
+      m_cond.notify_all();
+    }
+    if (m_thread.joinable()) m_thread.join();
+  }
+
+  /**
+   * Returns the next len values. Returns fewer values only at the end of the
+   * sequence.
+   */
+  std::vector<T> get_next(size_t len) {
+    std::vector<T> ret;
+    if (len == 0) return ret;
+    if (m_max_batches == 0) {
+      if (!m_finished) {
+        m_generator(ret, len);
+        m_finished = ret.size() < len;
+      }
+      return ret;
+    }
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_batch_length = len;
+    if (!m_thread.joinable()) {
+      m_thread = std::thread([this]() { this->produce(); });
+    }
+    while (ret.size() < len) {
+      while (m_batches.empty() && !m_finished) m_cond.wait(lock);
+      if (m_batches.empty()) break;
+      std::vector<T>& batch = m_batches.front();
+      size_t take = std::min(len - ret.size(), batch.size() - m_front_offset);
+      if (ret.empty() && m_front_offset == 0 && take == batch.size()) {
+        ret.swap(batch);
+      } else {
+        auto begin = batch.begin() + m_front_offset;
+        std::move(begin, begin + take, std::back_inserter(ret));
+      }
+      m_front_offset += take;
+      if (m_front_offset >= batch.size()) {
+        m_batches.pop_front();
+        m_front_offset = 0;
+        m_cond.notify_all();
+      }
+    }
+    if (ret.size() < len && m_error) {
+      std::exception_ptr error = m_error;
+      m_error = nullptr;
+      std::rethrow_exception(error);
+    }
+    return ret;
+  }
+
+ private:
+  generator_type m_generator;
+  size_t m_max_batches;
+
+  std::mutex m_lock;
+  std::condition_variable m_cond;
+  std::thread m_thread;
+  std::deque<std::vector<T>> m_batches;
+  // the number of values of the front batch already returned
+  size_t m_front_offset = 0;
+  size_t m_batch_length = 0;
+  bool m_finished = false;
+  bool m_stopping = false;
+  std::exception_ptr m_error;
+
+  void produce() {
+    std::unique_lock<std::mutex> lock(m_lock);
+    while (!m_stopping) {
+      while (m_batches.size() >= m_max_batches && !m_stopping) m_cond.wait(lock);
+      if (m_stopping) break;
+      size_t len = m_batch_length;
+      lock.unlock();
+      std::vector<T> batch;
+      std::exception_ptr error;
+      try {
+        m_generator(batch, len);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      lock.lock();
+      bool last = error || batch.size() < len;
+      if (!batch.empty()) m_batches.push_back(std::move(batch));
+      if (last) {
+        m_error = error;
+        m_finished = true;
+      }
+      m_cond.notify_all();
+      if (last) break;
+    }
+  }
+};
+
+} // namespace turi
+#endif
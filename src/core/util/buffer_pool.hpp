@@ -7,8 +7,8 @@
 #define TURI_SFRAME_BUFFER_POOL_HPP
 #include <vector>
 #include <memory>
-#include <stack>
 #include <core/parallel/pthread_tools.hpp>
+#include <core/generics/lock_free_ring_queue.hpp>
 
 namespace turi {
 
@@ -17,6 +17,11 @@ namespace turi {
  * Implements a buffer pool around collections of T.
  * The buffer is lazily allocated; but only up to 2 * buffer_size entries can
  * exist.
+ *
+ * Released buffers are handed back through a lock free ring, so that the
+ * many readers sharing a pool do not serialize on a lock for every block.
+ * The lock is only taken to allocate a buffer, or to look for buffers which
+ * were dropped rather than released.
  */
 template <typename T>
 class buffer_pool {
@@ -27,10 +32,12 @@ class buffer_pool {
 
   /**
    * Initializes the buffer pool to a certain capacity.
-   * Can be called in parallel
+   * Resets the free list: must not be called while other threads use the
+   * pool.
    */
   inline void init(size_t buffer_size) {
     m_buffer_size = buffer_size;
+    m_free_buffers.reset(buffer_size);
   }
 
   /**
@@ -38,21 +45,19 @@ class buffer_pool {
    * Can be called in parallel
    */
   inline std::shared_ptr<T> get_new_buffer() {
-    if (m_free_buffers.empty()) {
+    std::shared_ptr<T> ret;
+    if (m_free_buffers.try_dequeue(ret)) return ret;
+    {
       std::lock_guard<turi::mutex> guard(m_buffer_lock);
       // no free buffers. Loop through the buffer pool in search of unique buffer
       for (size_t i = 0;i < m_buffer_pool.size(); ++i) {
-        if (m_buffer_pool[i].unique()) m_free_buffers.push(m_buffer_pool[i]);
-      }
-    }
-    if (!m_free_buffers.empty()) {
-      std::lock_guard<turi::mutex> guard(m_buffer_lock);
-      if (!m_free_buffers.empty()) {
-        auto ret = m_free_buffers.top();
-        m_free_buffers.pop();
-        return ret;
+        if (m_buffer_pool[i].unique()) {
+          if (!ret) ret = m_buffer_pool[i];
+          else m_free_buffers.try_enqueue(m_buffer_pool[i]);
+        }
       }
     }
+    if (ret) return ret;
     // allocate a new buffer
     std::shared_ptr<T> new_buffer = std::make_shared<T>();
     std::lock_guard<turi::mutex> guard(m_buffer_lock);
@@ -70,10 +75,8 @@ class buffer_pool {
       buffer->clear();
       if (buffer->capacity() >= BUFFER_CAPACITY_LIMIT)
         buffer->shrink_to_fit();
-      if (m_buffer_pool.size() + m_free_buffers.size() < m_buffer_size) {
-        std::lock_guard<turi::mutex> guard(m_buffer_lock);
-        m_free_buffers.push(std::move(buffer));
-      }
+      // if the free list is full the buffer is simply dropped
+      m_free_buffers.try_enqueue(std::move(buffer));
       buffer.reset();
     }
   }
@@ -81,7 +84,7 @@ class buffer_pool {
  private:
   /// Lock for m_buffer_pool
   turi::mutex m_buffer_lock;
-  size_t m_buffer_size;
+  size_t m_buffer_size = 0;
   //
   /**
    * additional buffers used for returning stuff, decompression, etc.
@@ -92,7 +95,7 @@ class buffer_pool {
    * releasing has performance benefits.
    */
   std::vector<std::shared_ptr<T> > m_buffer_pool;
-  std::stack<std::shared_ptr<T> > m_free_buffers;
+  lock_free_ring_queue<std::shared_ptr<T> > m_free_buffers;
 };
 }
 #endif
@@ -3,6 +3,8 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#ifndef TURI_UTIL_LRU_HPP
+#define TURI_UTIL_LRU_HPP
 #include <utility>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/tag.hpp>
@@ -149,3 +151,4 @@ struct lru_cache {
   size_t m_misses = 0;
 };
 } // namespace turi
+#endif
@@ -0,0 +1,136 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <core/util/bitops.hpp>
+#include <core/util/string_kernels.hpp>
+
+namespace turi {
+namespace string_kernels {
+
+namespace {
+
+constexpr uint64_t ONES = 0x0101010101010101ULL;
+constexpr uint64_t HIGH_BITS = 0x8080808080808080ULL;
+
+/// The maximum number of compiled expressions kept by cached_regex()
+constexpr size_t REGEX_CACHE_SIZE = 256;
+
+inline uint64_t load_word(const char* s) {
+  uint64_t ret;
+  std::memcpy(&ret, s, sizeof(ret));
+  return ret;
+}
+
+/**
+ * Flips bit 5 (the ASCII case bit) of every byte of w between lo and hi.
+ * Bytes with their high bit set are never in range.
+ */
+inline uint64_t flip_case_in_range(uint64_t w, unsigned char lo, unsigned char hi) {
+  uint64_t heptets = w & ~HIGH_BITS;
+  uint64_t above_hi = heptets + (0x7F - hi) * ONES;
+  uint64_t at_least_lo = heptets + (0x80 - lo) * ONES;
+  uint64_t in_range = (at_least_lo ^ above_hi) & ~w & HIGH_BITS;
+  return w ^ (in_range >> 2);
+}
+
+template <unsigned char lo, unsigned char hi>
+void flip_case(char* s, size_t len) {
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t w = load_word(s + i);
+    // skip the words without any letter to change
+    uint64_t flipped = flip_case_in_range(w, lo, hi);
+    if (flipped != w) std::memcpy(s + i, &flipped, sizeof(flipped));
+  }
+  for (; i < len; ++i) {
+    unsigned char c = s[i];
+    if (c >= lo && c <= hi) s[i] = c ^ 0x20;
+  }
+}
+
+struct regex_cache {
+  std::mutex lock;
+  std::unordered_map<std::string, std::shared_ptr<const boost::regex>> expressions;
+};
+
+regex_cache& get_regex_cache() {
+  static regex_cache* cache = new regex_cache;
+  return *cache;
+}
+
+} // anonymous namespace
+
+
+substring_searcher::substring_searcher(const std::string& needle)
+    : m_needle(needle) {
+  if (!m_needle.empty()) {
+    m_first_mask = ONES * (unsigned char)m_needle.front();
+    m_last_mask = ONES * (unsigned char)m_needle.back();
+  }
+}
+
+size_t substring_searcher::find(const char* haystack, size_t len) const {
+  const size_t n = m_needle.size();
+  if (n == 0) return 0;
+  if (n > len) return std::string::npos;
+  if (n == 1) {
+    const void* p = std::memchr(haystack, m_needle[0], len);
+    return p == nullptr ? std::string::npos : (const char*)p - haystack;
+  }
+  const char* needle = m_needle.data();
+  const size_t last_start = len - n;
+  size_t i = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  // the 8 start positions i..i+7, while their last characters are all in range
+  for (; i + 7 <= last_start; i += 8) {
+    uint64_t x = (load_word(haystack + i) ^ m_first_mask) |
+                 (load_word(haystack + i + n - 1) ^ m_last_mask);
+    // a high bit for every zero byte of x. A byte above a zero byte may be
+    // flagged too, which the comparison below rules out.
+    uint64_t candidates = (x - ONES) & ~x & HIGH_BITS;
+    while (candidates) {
+      size_t pos = i + n_trailing_zeros(candidates) / 8;
+      if (std::memcmp(haystack + pos, needle, n) == 0) return pos;
+      candidates &= candidates - 1;
+    }
+  }
+#endif
+  for (; i <= last_start; ++i) {
+    if (haystack[i] == needle[0] && haystack[i + n - 1] == needle[n - 1] &&
+        std::memcmp(haystack + i + 1, needle + 1, n - 2) == 0) {
+      return i;
+    }
+  }
+  return std::string::npos;
+}
+
+void ascii_to_lower(char* s, size_t len) {
+  flip_case<'A', 'Z'>(s, len);
+}
+
+void ascii_to_upper(char* s, size_t len) {
+  flip_case<'a', 'z'>(s, len);
+}
+
+std::shared_ptr<const boost::regex> cached_regex(const std::string& pattern) {
+  auto& cache = get_regex_cache();
+  {
+    std::lock_guard<std::mutex> guard(cache.lock);
+    auto iter = cache.expressions.find(pattern);
+    if (iter != cache.expressions.end()) return iter->second;
+  }
+  // compiled outside of the lock; two threads may both compile a new
+  // pattern, and the first one in wins
+  std::shared_ptr<const boost::regex> ret = std::make_shared<boost::regex>(pattern);
+  std::lock_guard<std::mutex> guard(cache.lock);
+  if (cache.expressions.size() >= REGEX_CACHE_SIZE) cache.expressions.clear();
+  return cache.expressions.emplace(pattern, ret).first->second;
+}
+
+} // namespace string_kernels
+} // namespace turi
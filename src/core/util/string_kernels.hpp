@@ -0,0 +1,123 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_UTIL_STRING_KERNELS_HPP
+#define TURI_UTIL_STRING_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <boost/regex.hpp>
+
+namespace turi {
+namespace string_kernels {
+
+/**
+ * Searches for one needle in many strings.
+ *
+ * The candidate positions are found 8 at a time, by comparing both the first
+ * and the last character of the needle against a word of the haystack
+ * (SWAR), so that the full comparison is only made where both match. This is
+ * much faster than std::string::find on text where the first character of the
+ * needle is common.
+ */
+class substring_searcher {
+ public:
+  explicit substring_searcher(const std::string& needle);
+
+  /**
+   * Returns the position of the first occurrence of the needle in the len
+   * characters at haystack, or std::string::npos.
+   */
+  size_t find(const char* haystack, size_t len) const;
+
+  /// True if the needle occurs in haystack
+  inline bool contained_in(const std::string& haystack) const {
+    return find(haystack.data(), haystack.size()) != std::string::npos;
+  }
+
+  const std::string& needle() const { return m_needle; }
+
+ private:
+  std::string m_needle;
+  uint64_t m_first_mask = 0;
+  uint64_t m_last_mask = 0;
+};
+
+/**
+ * Converts the ASCII upper case letters of the len characters at s to lower
+ * case, in place, 8 characters at a time. Every other byte (including the
+ * bytes of multibyte UTF-8 characters) is left as is, which is what
+ * ::tolower does in the "C" locale.
+ */
+void ascii_to_lower(char* s, size_t len);
+
+/// As ascii_to_lower(), for the ASCII lower case letters
+void ascii_to_upper(char* s, size_t len);
+
+inline void ascii_to_lower(std::string& s) {
+  if (!s.empty()) ascii_to_lower(&s[0], s.size());
+}
+
+inline void ascii_to_upper(std::string& s) {
+  if (!s.empty()) ascii_to_upper(&s[0], s.size());
+}
+
+/**
+ * A set of single byte delimiters, looked up with one table access rather
+ * than through a std::set<char>.
+ */
+class delimiter_set {
+ public:
+  delimiter_set() { clear(); }
+
+  explicit delimiter_set(const std::string& delimiters) {
+    clear();
+    for (char c: delimiters) insert(c);
+  }
+
+  inline void clear() {
+    for (auto& d: m_table) d = false;
+  }
+
+  inline void insert(char c) { m_table[(unsigned char)c] = true; }
+
+  inline bool contains(char c) const { return m_table[(unsigned char)c]; }
+
+  /**
+   * Calls fn(begin, length) on every maximal run of non delimiter characters
+   * of the len characters at s, in order.
+   */
+  template <typename Fn>
+  inline void for_each_token(const char* s, size_t len, Fn&& fn) const {
+    size_t i = 0;
+    while (i < len) {
+      while (i < len && contains(s[i])) ++i;
+      size_t begin = i;
+      while (i < len && !contains(s[i])) ++i;
+      if (i > begin) fn(s + begin, i - begin);
+    }
+  }
+
+ private:
+  bool m_table[256];
+};
+
+/**
+ * Returns the compiled boost::regex of pattern, compiling it only the first
+ * time a pattern is seen. The compiled expressions are shared: matching with
+ * a const boost::regex is thread safe.
+ *
+ * The cache is bounded; when full it is emptied, and expressions still in
+ * use stay alive through their shared pointers. Throws boost::regex_error if
+ * the pattern is invalid.
+ */
+std::shared_ptr<const boost::regex> cached_regex(const std::string& pattern);
+
+} // namespace string_kernels
+} // namespace turi
+
+#endif
@@ -15,6 +15,7 @@
 #include <xgboost/src/utils/omp.h>
 #include <xgboost/src/tree/updater.h>
 #include <xgboost/src/tree/model.h>
+#include <xgboost/src/tree/flat_forest.h>
 
 // GLC parallel lambda premitive 
 #include <core/parallel/lambda_omp.hpp>
@@ -169,6 +170,11 @@ class GBTree : public IGradBooster {
     //   nthread = omp_get_num_threads();
     // }
     // InitThreadTemp(nthread);
+    // rows without a prediction buffer go through the flattened trees
+    if (buffer_offset < 0 && mparam.size_leaf_vector == 0) {
+      this->PredFlat(p_fmat, info, out_preds, ntree_limit);
+      return;
+    }
     InitThreadTemp(turi::thread::cpu_count());
     auto &preds = *out_preds;
     const size_t stride = info.num_row * mparam.num_output_group;
@@ -249,6 +255,7 @@ class GBTree : public IGradBooster {
     }
     updaters.clear();
     trees.clear();
+    flat_forest.Clear();
     pred_buffer.clear();
     pred_counter.clear();
   }
@@ -316,6 +323,7 @@ class GBTree : public IGradBooster {
       tree_info.push_back(bst_group);
     }
     mparam.num_trees += static_cast<int>(new_trees.size());
+    flat_forest.Clear();
   }
   // update buffer by pre-cached position
   inline void UpdateBufferByPosition(IFMatrix *p_fmat,
@@ -390,6 +398,65 @@ class GBTree : public IGradBooster {
       out_pred[stride * (i + 1)] = vec_psum[i];
     }
   }
+  // make predictions for all the rows from the flattened trees, a block
+  // of rows at a time
+  inline void PredFlat(IFMatrix *p_fmat,
+                       const BoosterInfo &info,
+                       std::vector<float> *out_preds,
+                       unsigned ntree_limit) {
+    if (flat_forest.NumTrees() != trees.size()) {
+      flat_forest.Init(trees);
+    }
+    const int ngroup = mparam.num_output_group;
+    // the trees of each output group, up to ntree_limit of them
+    std::vector<std::vector<unsigned> > group_trees(ngroup);
+    for (size_t i = 0; i < trees.size(); ++i) {
+      std::vector<unsigned> &t = group_trees[tree_info[i]];
+      if (ntree_limit == 0 || t.size() < ntree_limit) {
+        t.push_back(static_cast<unsigned>(i));
+      }
+    }
+    const size_t nfeat = mparam.num_feature;
+    const size_t block_rows = tree::FlatForest::BlockRows(nfeat);
+    const size_t nthread = turi::thread::cpu_count();
+    if (thread_block.size() < nthread) thread_block.resize(nthread);
+
+    auto &preds = *out_preds;
+    preds.resize(info.num_row * ngroup);
+    utils::IIterator<RowBatch> *iter = p_fmat->RowIterator();
+    iter->BeforeFirst();
+    while (iter->Next()) {
+      const RowBatch &batch = iter->Value();
+      const size_t nblock = (batch.size + block_rows - 1) / block_rows;
+      turi::parallel_for(0, nblock, [&](size_t b) {
+        tree::FlatForest::Block &block = thread_block[turi::thread::thread_id()];
+        if (block.num_feature != nfeat ||
+            block.data.size() < block_rows * nfeat) {
+          block.Init(block_rows, nfeat);
+        }
+        const size_t begin = b * block_rows;
+        const size_t nrow = std::min(batch.size - begin, block_rows);
+        unsigned root_index[tree::FlatForest::kMaxBlockRows];
+        float psum[tree::FlatForest::kMaxBlockRows];
+        for (size_t r = 0; r < nrow; ++r) {
+          const size_t ridx = batch.base_rowid + begin + r;
+          utils::Assert(ridx < info.num_row, "data row index exceed bound");
+          block.Fill(r, batch[begin + r]);
+          root_index[r] = info.GetRoot(ridx);
+        }
+        for (int gid = 0; gid < ngroup; ++gid) {
+          std::fill(psum, psum + nrow, 0.0f);
+          flat_forest.Predict(group_trees[gid], block, nrow, root_index, psum);
+          for (size_t r = 0; r < nrow; ++r) {
+            preds[(batch.base_rowid + begin + r) * ngroup + gid] = psum[r];
+          }
+        }
+        for (size_t r = 0; r < nrow; ++r) {
+          block.Drop(r, batch[begin + r]);
+        }
+      });
+    }
+  }
   // predict independent leaf index
   inline void PredPath(IFMatrix *p_fmat,
                        const BoosterInfo &info,
@@ -550,6 +617,10 @@ class GBTree : public IGradBooster {
   std::vector< std::pair<std::string, std::string> > cfg;
   // temporal storage for per thread
   std::vector<tree::RegTree::FVec> thread_temp;
+  // the trees flattened for prediction, built on first use
+  tree::FlatForest flat_forest;
+  // per thread block of rows of flattened prediction
+  std::vector<tree::FlatForest::Block> thread_block;
   // the updaters that can be applied to each of tree
   std::vector<tree::IUpdater*> updaters;
 };
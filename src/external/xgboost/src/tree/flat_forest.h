@@ -0,0 +1,164 @@
+/*!
+ * Copyright 2014 by Contributors
+ * \file flat_forest.h
+ * \brief the trees of an ensemble flattened into one array of compact
+ *  nodes, to score blocks of rows one tree at a time
+ */
+#ifndef XGBOOST_TREE_FLAT_FOREST_H_
+#define XGBOOST_TREE_FLAT_FOREST_H_
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include "./model.h"
+
+namespace xgboost {
+namespace tree {
+/*!
+ * \brief a read only copy of a list of RegTree, for prediction.
+ *
+ *  The nodes of each tree are laid out breadth first, with the two
+ *  children of a split next to each other, so that the path of a row
+ *  runs through nearby nodes and a child is found without a branch.
+ *  A node holds only what the path needs: 12 bytes, against the node
+ *  and the statistics of RegTree.
+ */
+class FlatForest {
+ public:
+  /*! \brief the rows of a block, as dense feature vectors */
+  struct Block {
+    /*! \brief feature vectors of the rows, one after another */
+    std::vector<RegTree::FVec::Entry> data;
+    /*! \brief number of features of a row */
+    size_t num_feature;
+
+    Block(void) : num_feature(0) {}
+    /*! \brief make room for nrow rows of num_feature features, all missing */
+    inline void Init(size_t nrow, size_t num_feature) {
+      RegTree::FVec::Entry e; e.flag = -1;
+      this->num_feature = num_feature;
+      data.assign(nrow * num_feature, e);
+    }
+    /*! \brief set row r to inst */
+    inline void Fill(size_t r, const RowBatch::Inst &inst) {
+      RegTree::FVec::Entry *row = &data[r * num_feature];
+      for (bst_uint i = 0; i < inst.length; ++i) {
+        if (inst[i].index >= num_feature) continue;
+        row[inst[i].index].fvalue = inst[i].fvalue;
+      }
+    }
+    /*! \brief set row r back to missing, must be called after Fill */
+    inline void Drop(size_t r, const RowBatch::Inst &inst) {
+      RegTree::FVec::Entry *row = &data[r * num_feature];
+      for (bst_uint i = 0; i < inst.length; ++i) {
+        if (inst[i].index >= num_feature) continue;
+        row[inst[i].index].flag = -1;
+      }
+    }
+  };
+
+  FlatForest(void) : tree_begin_(1, 0) {}
+
+  /*! \brief maximum number of rows of a block */
+  static const size_t kMaxBlockRows = 64;
+  /*!
+   * \return number of rows of a block, so that the block of rows with
+   *  num_feature features stays within the second level cache
+   */
+  inline static size_t BlockRows(size_t num_feature) {
+    const size_t kBlockBytes = 256 << 10;
+    const size_t max_rows = kMaxBlockRows;
+    size_t row_bytes = std::max<size_t>(1, num_feature) * sizeof(RegTree::FVec::Entry);
+    return std::max<size_t>(1, std::min(max_rows, kBlockBytes / row_bytes));
+  }
+
+  /*! \return number of trees */
+  inline size_t NumTrees(void) const {
+    return tree_begin_.size() - 1;
+  }
+  /*! \brief drop the trees */
+  inline void Clear(void) {
+    nodes_.clear();
+    tree_begin_.assign(1, 0);
+  }
+  /*! \brief flatten trees */
+  inline void Init(const std::vector<RegTree*> &trees) {
+    this->Clear();
+    std::vector<int> queue;
+    for (size_t t = 0; t < trees.size(); ++t) {
+      const RegTree &tree = *trees[t];
+      const size_t begin = nodes_.size();
+      const int nroot = tree.param.num_roots;
+      // node queue[i] of the tree is node begin + i of the forest
+      queue.clear();
+      for (int nid = 0; nid < nroot; ++nid) {
+        queue.push_back(nid);
+      }
+      for (size_t i = 0; i < queue.size(); ++i) {
+        const RegTree::Node &src = tree[queue[i]];
+        nodes_.push_back(Node());
+        Node &dst = nodes_.back();
+        if (src.is_leaf()) {
+          dst.cleft = -1;
+          dst.sindex = 0;
+          dst.value = src.leaf_value();
+        } else {
+          dst.cleft = static_cast<int>(queue.size());
+          dst.sindex = src.split_index() | (src.default_left() ? (1U << 31) : 0U);
+          dst.value = src.split_cond();
+          queue.push_back(src.cleft());
+          queue.push_back(src.cright());
+        }
+      }
+      tree_begin_.push_back(nodes_.size());
+    }
+  }
+  /*!
+   * \brief add the leaf values of some of the trees to the rows of a block
+   * \param tree_index the trees, in the order their values are added
+   * \param block the rows
+   * \param nrow number of rows of the block
+   * \param root_index root of each row
+   * \param out_pred receives the sum for each row
+   */
+  inline void Predict(const std::vector<unsigned> &tree_index,
+                      const Block &block, size_t nrow,
+                      const unsigned *root_index,
+                      float *out_pred) const {
+    const size_t nfeat = block.num_feature;
+    for (size_t k = 0; k < tree_index.size(); ++k) {
+      // every row goes through this tree before the next, which keeps
+      // its top nodes in cache across the rows
+      const Node *nodes = &nodes_[tree_begin_[tree_index[k]]];
+      const RegTree::FVec::Entry *row = block.data.data();
+      for (size_t r = 0; r < nrow; ++r, row += nfeat) {
+        int pid = static_cast<int>(root_index[r]);
+        while (nodes[pid].cleft != -1) {
+          const Node &n = nodes[pid];
+          const RegTree::FVec::Entry &e = row[n.sindex & ((1U << 31) - 1U)];
+          const bool go_right = e.flag == -1 ? (n.sindex >> 31) == 0 : !(e.fvalue < n.value);
+          pid = n.cleft + go_right;
+        }
+        out_pred[r] += nodes[pid].value;
+      }
+    }
+  }
+
+ private:
+  /*! \brief a node; the right child of a split is next to its left child */
+  struct Node {
+    /*! \brief left child within the tree, -1 for a leaf */
+    int cleft;
+    /*! \brief split feature, with the top bit set when missing goes left */
+    unsigned sindex;
+    /*! \brief split value, or leaf value */
+    float value;
+  };
+  // nodes of all the trees
+  std::vector<Node> nodes_;
+  // nodes of tree t are [tree_begin_[t], tree_begin_[t + 1])
+  std::vector<size_t> tree_begin_;
+};
+}  // namespace tree
+}  // namespace xgboost
+#endif  // XGBOOST_TREE_FLAT_FOREST_H_
@@ -11,6 +11,7 @@
 #include "./updater_sync-inl.hpp"
 #include "./updater_distcol-inl.hpp"
 #include "./updater_histmaker-inl.hpp"
+#include "./updater_quantile_histmaker-inl.hpp"
 #include "./updater_skmaker-inl.hpp"
 #endif
 
@@ -24,6 +25,7 @@ IUpdater* CreateUpdater(const char *name) {
 #ifndef XGBOOST_STRICT_CXX98_
   if (!strcmp(name, "sync")) return new TreeSyncher();
   if (!strcmp(name, "grow_histmaker")) return new CQHistMaker<GradStats>();
+  if (!strcmp(name, "grow_quantile_histmaker")) return new QuantileHistMaker();
   if (!strcmp(name, "grow_skmaker")) return new SketchMaker();
   if (!strcmp(name, "distcol")) return new DistColMaker<GradStats>();
 #endif
@@ -0,0 +1,1180 @@
+/*!
+ * Copyright 2014 by Contributors
+ * \file updater_quantile_histmaker-inl.hpp
+ * \brief grow a tree from gradient histograms over features quantized once
+ */
+#ifndef XGBOOST_TREE_UPDATER_QUANTILE_HISTMAKER_INL_HPP_
+#define XGBOOST_TREE_UPDATER_QUANTILE_HISTMAKER_INL_HPP_
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <stdint.h>
+#include "./param.h"
+#include "./updater.h"
+#include <xgboost/src/utils/io.h>
+#include <xgboost/src/utils/random.h>
+#include <xgboost/src/utils/thread_buffer.h>
+
+// GLC parallel lambda premitive
+#include <core/parallel/lambda_omp.hpp>
+#include <core/parallel/pthread_tools.hpp>
+
+namespace xgboost {
+namespace tree {
+/*!
+ * \brief the bins of every feature of a matrix
+ *
+ *  Bin k of feature f holds the values v with cut(f, k-1) <= v < cut(f, k);
+ *  the last cut of every feature is the largest float, so every value has
+ *  a bin.  The cuts are taken from the quantiles of a sample of the rows.
+ */
+struct HistCuts {
+  /*! \brief cut_ptr[f] is the index of the first bin of feature f */
+  std::vector<bst_uint> cut_ptr;
+  /*! \brief upper bound of each bin, increasing within a feature */
+  std::vector<bst_float> cut_values;
+
+  /*! \return number of features */
+  inline size_t NumCol(void) const {
+    return cut_ptr.size() - 1;
+  }
+  /*! \return number of bins of all features together */
+  inline size_t NumBin(void) const {
+    return cut_values.size();
+  }
+  /*! \return number of bins of feature fid */
+  inline bst_uint NumBin(bst_uint fid) const {
+    return cut_ptr[fid + 1] - cut_ptr[fid];
+  }
+  /*! \return the bin of value v of feature fid */
+  inline bst_uint BinOf(bst_uint fid, bst_float v) const {
+    const bst_float *begin = &cut_values[0] + cut_ptr[fid];
+    const bst_float *end = &cut_values[0] + cut_ptr[fid + 1];
+    size_t k = std::upper_bound(begin, end, v) - begin;
+    return static_cast<bst_uint>(std::min<size_t>(k, end - begin - 1));
+  }
+  /*! \return the bin whose upper bound is the split value of node nid */
+  inline int SplitBin(const RegTree::Node &node) const {
+    const bst_float *cut = &cut_values[0] + cut_ptr[node.split_index()];
+    return static_cast<int>(std::lower_bound(cut, cut + NumBin(node.split_index()),
+                                             node.split_cond()) - cut);
+  }
+  /*!
+   * \brief take the cuts of each feature from every stride-th row of fmat,
+   *  with the stride chosen to visit at most max_sample_rows rows
+   */
+  inline void Init(IFMatrix &fmat, size_t num_row, // NOLINT(*)
+                   unsigned max_bin, size_t max_sample_rows) {
+    const size_t ncol = fmat.NumCol();
+    const size_t stride = std::max<size_t>(1, num_row / std::max<size_t>(1, max_sample_rows));
+    std::vector<std::vector<bst_float> > sample(ncol);
+    utils::IIterator<RowBatch> *iter = fmat.RowIterator();
+    while (iter->Next()) {
+      const RowBatch &batch = iter->Value();
+      for (size_t i = 0; i < batch.size; ++i) {
+        if ((batch.base_rowid + i) % stride != 0) continue;
+        RowBatch::Inst inst = batch[i];
+        for (bst_uint j = 0; j < inst.length; ++j) {
+          if (inst[j].index < ncol && !std::isnan(inst[j].fvalue)) {
+            sample[inst[j].index].push_back(inst[j].fvalue);
+          }
+        }
+      }
+    }
+    std::vector<std::vector<bst_float> > cuts(ncol);
+    turi::parallel_for(0, ncol, [&](size_t fid) {
+      std::vector<bst_float> &v = sample[fid];
+      std::vector<bst_float> &c = cuts[fid];
+      std::sort(v.begin(), v.end());
+      const size_t n = v.size();
+      size_t ndistinct = 0;
+      for (size_t i = 0; i < n; ++i) {
+        if (i == 0 || v[i] != v[i - 1]) ++ndistinct;
+      }
+      if (ndistinct <= max_bin) {
+        for (size_t i = 1; i < n; ++i) {
+          if (v[i] != v[i - 1]) c.push_back(Midpoint(v[i - 1], v[i]));
+        }
+      } else {
+        for (size_t b = 1; b < max_bin; ++b) {
+          // cut before the run of equal values at this rank, or after
+          // it when the run starts the feature
+          size_t i = std::lower_bound(v.begin(), v.end(), v[b * n / max_bin]) - v.begin();
+          if (i == 0) i = std::upper_bound(v.begin(), v.end(), v[0]) - v.begin();
+          if (i == n) break;
+          bst_float cut = Midpoint(v[i - 1], v[i]);
+          if (c.empty() || cut > c.back()) c.push_back(cut);
+        }
+      }
+      // a feature missing from the sample still separates present from missing
+      if (n != 0 || fmat.GetColSize(fid) != 0) {
+        c.push_back(std::numeric_limits<bst_float>::max());
+      }
+      std::vector<bst_float>().swap(v);
+    });
+    cut_ptr.resize(ncol + 1);
+    cut_ptr[0] = 0;
+    cut_values.clear();
+    for (size_t fid = 0; fid < ncol; ++fid) {
+      cut_values.insert(cut_values.end(), cuts[fid].begin(), cuts[fid].end());
+      cut_ptr[fid + 1] = static_cast<bst_uint>(cut_values.size());
+    }
+  }
+
+ private:
+  // a cut with a <= cut and cut > a, for a < b
+  inline static bst_float Midpoint(bst_float a, bst_float b) {
+    bst_float m = a + (b - a) * 0.5f;
+    return m > a ? m : b;
+  }
+};
+
+/*!
+ * \brief a feature matrix with every value replaced by the index of its bin
+ *
+ *  Rows are stored as one bin per feature when no value is missing, and as
+ *  compressed sparse rows, sorted by feature, otherwise.
+ */
+template<typename BinType>
+struct QuantizedMatrix {
+  /*! \brief the matrix this was built from, its number of rows and max_bin */
+  const IFMatrix *source;
+  size_t num_row;
+  unsigned max_bin;
+  HistCuts cuts;
+  /*! \brief whether bins holds num_row x NumCol() entries */
+  bool dense;
+  /*! \brief row pointer and feature index of the sparse layout */
+  std::vector<size_t> row_ptr;
+  std::vector<bst_uint> findex;
+  /*! \brief bin of each entry, local to its feature */
+  std::vector<BinType> bins;
+
+  QuantizedMatrix(void) : source(NULL), num_row(0), max_bin(0), dense(false) {}
+  /*! \return the bin of feature fid in row ridx, or -1 when it is missing */
+  inline int GetBin(size_t ridx, bst_uint fid) const {
+    if (dense) return bins[ridx * cuts.NumCol() + fid];
+    const bst_uint *begin = findex.data() + row_ptr[ridx];
+    const bst_uint *end = findex.data() + row_ptr[ridx + 1];
+    const bst_uint *it = std::lower_bound(begin, end, fid);
+    if (it == end || *it != fid) return -1;
+    return bins[it - findex.data()];
+  }
+  /*!
+   * \brief quantize fmat
+   * \param fmat the feature matrix, with column access initialized
+   * \param nrow number of rows of fmat
+   * \param max_bin maximum number of bins of a feature
+   * \param max_sample_rows number of rows the cuts are computed from
+   */
+  inline void Init(IFMatrix &fmat, size_t nrow, // NOLINT(*)
+                   unsigned max_bin, size_t max_sample_rows) {
+    const size_t ncol = fmat.NumCol();
+    source = &fmat;
+    num_row = nrow;
+    this->max_bin = max_bin;
+    cuts.Init(fmat, num_row, max_bin, max_sample_rows);
+
+    const std::vector<bst_uint> &rowset = fmat.buffered_rowset();
+    dense = ncol != 0 && rowset.size() == num_row;
+    for (size_t fid = 0; fid < ncol && dense; ++fid) {
+      dense = fmat.GetColSize(fid) == num_row;
+    }
+    row_ptr.clear(); findex.clear(); bins.clear();
+
+    utils::IIterator<RowBatch> *iter = fmat.RowIterator();
+    if (dense) {
+      bins.resize(num_row * ncol);
+      while (iter->Next()) {
+        const RowBatch &batch = iter->Value();
+        turi::parallel_for(0, batch.size, [&](size_t i) {
+          RowBatch::Inst inst = batch[i];
+          utils::Assert(inst.length == ncol, "QuantizedMatrix: row is not dense");
+          BinType *out = &bins[(batch.base_rowid + i) * ncol];
+          for (bst_uint j = 0; j < inst.length; ++j) {
+            out[inst[j].index] = static_cast<BinType>(cuts.BinOf(inst[j].index, inst[j].fvalue));
+          }
+        });
+      }
+      return;
+    }
+
+    row_ptr.resize(num_row + 1, 0);
+    size_t next_row = 0;
+    while (iter->Next()) {
+      const RowBatch &batch = iter->Value();
+      utils::Assert(batch.base_rowid >= next_row, "QuantizedMatrix: rows out of order");
+      for (; next_row < batch.base_rowid; ++next_row) {
+        row_ptr[next_row + 1] = row_ptr[next_row];
+      }
+      for (size_t i = 0; i < batch.size; ++i, ++next_row) {
+        RowBatch::Inst inst = batch[i];
+        size_t length = 0;
+        for (bst_uint j = 0; j < inst.length; ++j) {
+          if (inst[j].index < ncol && cuts.NumBin(inst[j].index) != 0) ++length;
+        }
+        row_ptr[next_row + 1] = row_ptr[next_row] + length;
+      }
+      findex.resize(row_ptr[next_row]);
+      bins.resize(row_ptr[next_row]);
+      turi::parallel_for(0, batch.size, [&](size_t i) {
+        const size_t ridx = batch.base_rowid + i;
+        RowBatch::Inst inst = batch[i];
+        std::vector<std::pair<bst_uint, BinType> > row;
+        row.reserve(inst.length);
+        for (bst_uint j = 0; j < inst.length; ++j) {
+          const bst_uint fid = inst[j].index;
+          if (fid < ncol && cuts.NumBin(fid) != 0) {
+            row.push_back(std::make_pair(fid, static_cast<BinType>(
+                cuts.BinOf(fid, inst[j].fvalue))));
+          }
+        }
+        std::sort(row.begin(), row.end());
+        for (size_t j = 0; j < row.size(); ++j) {
+          findex[row_ptr[ridx] + j] = row[j].first;
+          bins[row_ptr[ridx] + j] = row[j].second;
+        }
+      });
+    }
+    for (; next_row < num_row; ++next_row) {
+      row_ptr[next_row + 1] = row_ptr[next_row];
+    }
+  }
+};
+
+/*!
+ * \brief the quantized columns of a block of consecutive rows; the unit
+ *  in which a QuantizedPages is written to and read back from disk
+ */
+template<typename BinType>
+struct QuantizedPage {
+  /*! \brief first row of the page, and number of rows */
+  size_t base_rowid;
+  size_t size;
+  /*! \brief entries of feature f are [col_ptr[f], col_ptr[f + 1]) */
+  std::vector<size_t> col_ptr;
+  /*! \brief row of each entry, less base_rowid, increasing in a column */
+  std::vector<bst_uint> row;
+  /*! \brief bin of each entry */
+  std::vector<BinType> bin;
+
+  QuantizedPage(void) : base_rowid(0), size(0) {}
+  /*! \brief quantize the columns of batch by cuts */
+  inline void Init(const RowBatch &batch, const HistCuts &cuts) {
+    const size_t ncol = cuts.NumCol();
+    const size_t nthread = turi::thread::cpu_count();
+    base_rowid = batch.base_rowid;
+    size = batch.size;
+    // each thread takes the same block of rows in both passes, so the rows
+    // of a column are in order
+    std::vector<std::vector<size_t> > count(nthread, std::vector<size_t>(ncol + 1, 0));
+    turi::parallel_for(0, nthread, [&](size_t tid) {
+      std::vector<size_t> &c = count[tid];
+      for (size_t i = size * tid / nthread; i < size * (tid + 1) / nthread; ++i) {
+        RowBatch::Inst inst = batch[i];
+        for (bst_uint j = 0; j < inst.length; ++j) {
+          if (inst[j].index < ncol && cuts.NumBin(inst[j].index) != 0) ++c[inst[j].index];
+        }
+      }
+    });
+    col_ptr.assign(ncol + 1, 0);
+    size_t total = 0;
+    for (size_t fid = 0; fid < ncol; ++fid) {
+      col_ptr[fid] = total;
+      for (size_t tid = 0; tid < nthread; ++tid) {
+        size_t n = count[tid][fid];
+        count[tid][fid] = total;
+        total += n;
+      }
+    }
+    col_ptr[ncol] = total;
+    row.resize(total);
+    bin.resize(total);
+    turi::parallel_for(0, nthread, [&](size_t tid) {
+      std::vector<size_t> &pos = count[tid];
+      for (size_t i = size * tid / nthread; i < size * (tid + 1) / nthread; ++i) {
+        RowBatch::Inst inst = batch[i];
+        for (bst_uint j = 0; j < inst.length; ++j) {
+          const bst_uint fid = inst[j].index;
+          if (fid < ncol && cuts.NumBin(fid) != 0) {
+            row[pos[fid]] = static_cast<bst_uint>(i);
+            bin[pos[fid]] = static_cast<BinType>(cuts.BinOf(fid, inst[j].fvalue));
+            ++pos[fid];
+          }
+        }
+      }
+    });
+  }
+  inline void Save(utils::IStream *fo) const {
+    fo->Write(&base_rowid, sizeof(base_rowid));
+    fo->Write(&size, sizeof(size));
+    fo->Write(col_ptr);
+    fo->Write(row);
+    fo->Write(bin);
+  }
+  inline bool Load(utils::IStream *fi) {
+    if (fi->Read(&base_rowid, sizeof(base_rowid)) == 0) return false;
+    utils::Check(fi->Read(&size, sizeof(size)) != 0 && fi->Read(&col_ptr) &&
+                 fi->Read(&row) && fi->Read(&bin), "Invalid QuantizedPage file");
+    return true;
+  }
+};
+
+/*! \brief factory of the pages of the prefetching buffer of QuantizedPages */
+template<typename BinType>
+class QuantizedPageFactory {
+ public:
+  inline void SetFile(const utils::FileStream &fi) {
+    fi_ = fi;
+  }
+  inline bool Init(void) {
+    fi_.Seek(0);
+    return true;
+  }
+  inline void SetParam(const char *name, const char *val) {}
+  inline bool LoadNext(QuantizedPage<BinType> *val) {
+    return val->Load(&fi_);
+  }
+  inline QuantizedPage<BinType> *Create(void) {
+    return new QuantizedPage<BinType>();
+  }
+  inline void FreeSpace(QuantizedPage<BinType> *a) {
+    delete a;
+  }
+  inline void Destroy(void) {
+    fi_.Close();
+  }
+  inline void BeforeFirst(void) {
+    fi_.Seek(0);
+  }
+
+ private:
+  utils::FileStream fi_;
+};
+
+/*!
+ * \brief a matrix quantized as QuantizedMatrix is, kept on disk as one
+ *  column major QuantizedPage per row batch of the source, and read back
+ *  with the next pages prefetched by a loader thread
+ */
+template<typename BinType>
+struct QuantizedPages {
+  /*! \brief the matrix this was built from, its number of rows and max_bin */
+  const IFMatrix *source;
+  size_t num_row;
+  unsigned max_bin;
+  HistCuts cuts;
+
+  QuantizedPages(void) : source(NULL), num_row(0), max_bin(0), is_open(false) {
+    itr.SetParam("buffer_size", "2");
+  }
+  ~QuantizedPages(void) {
+    this->Close();
+  }
+  /*!
+   * \brief quantize fmat into pages written to the file path
+   * \param fmat the feature matrix, with column sizes initialized
+   * \param nrow number of rows of fmat
+   * \param max_bin maximum number of bins of a feature
+   * \param max_sample_rows number of rows the cuts are computed from
+   * \param path file of the pages, removed when they are closed
+   */
+  inline void Init(IFMatrix &fmat, size_t nrow, // NOLINT(*)
+                   unsigned max_bin, size_t max_sample_rows,
+                   const std::string &path) {
+    this->Close();
+    source = &fmat;
+    num_row = nrow;
+    this->max_bin = max_bin;
+    cuts.Init(fmat, num_row, max_bin, max_sample_rows);
+
+    this->path = path;
+    utils::FileStream fs(utils::FopenCheck(path.c_str(), "w+b"));
+    QuantizedPage<BinType> page;
+    utils::IIterator<RowBatch> *iter = fmat.RowIterator();
+    while (iter->Next()) {
+      page.Init(iter->Value(), cuts);
+      page.Save(&fs);
+    }
+    std::fflush(NULL);
+    itr.get_factory().SetFile(fs);
+    itr.Init();
+    is_open = true;
+  }
+  /*! \brief place the iterator before the first page */
+  inline void BeforeFirst(void) {
+    itr.BeforeFirst();
+  }
+  /*! \brief the next page, valid until the next call */
+  inline bool Next(const QuantizedPage<BinType> **page) {
+    QuantizedPage<BinType> *p;
+    if (!itr.Next(p)) return false;
+    *page = p;
+    return true;
+  }
+
+ private:
+  std::string path;
+  bool is_open;
+  utils::ThreadBuffer<QuantizedPage<BinType>*, QuantizedPageFactory<BinType> > itr;
+
+  inline void Close(void) {
+    if (!is_open) return;
+    itr.Destroy();
+    std::remove(path.c_str());
+    is_open = false;
+  }
+};
+
+/*!
+ * \brief grow trees depthwise from per node histograms of the gradient over
+ *  the bins of the features, quantized once and reused for every tree.
+ *
+ *  Only the histogram of the smaller child of a split is accumulated over
+ *  its rows; the larger one is the parent's histogram less the smaller.
+ *  With the parameter hist_page_file set, the quantized data is kept in
+ *  that file and streamed once per level of a tree, so that the gradient
+ *  and the node of each row are all that is held in memory per row.
+ */
+class QuantileHistMaker: public IUpdater {
+ public:
+  QuantileHistMaker(void) : max_bin(256) {}
+  virtual ~QuantileHistMaker(void) {}
+  // set training parameter
+  virtual void SetParam(const char *name, const char *val) {
+    param.SetParam(name, val);
+    if (!strcmp(name, "max_bin")) {
+      max_bin = std::min(std::max(atoi(val), 2), 1 << 16);
+    }
+    if (!strcmp(name, "hist_page_file")) page_file = val;
+  }
+  virtual void Update(const std::vector<bst_gpair> &gpair,
+                      IFMatrix *p_fmat,
+                      const BoosterInfo &info,
+                      const std::vector<RegTree*> &trees) {
+    GradStats::CheckInfo(info);
+    // rescale learning rate according to size of trees
+    float lr = param.learning_rate;
+    param.learning_rate = lr / trees.size();
+    if (page_file.length() != 0) {
+      if (max_bin <= 256) {
+        this->UpdatePagedTrees(&pages8_, gpair, p_fmat, info, trees);
+      } else {
+        this->UpdatePagedTrees(&pages16_, gpair, p_fmat, info, trees);
+      }
+    } else if (max_bin <= 256) {
+      this->UpdateTrees(&qmat8_, gpair, p_fmat, info, trees);
+    } else {
+      this->UpdateTrees(&qmat16_, gpair, p_fmat, info, trees);
+    }
+    param.learning_rate = lr;
+  }
+
+ protected:
+  /*! \brief number of rows the bin cuts are computed from */
+  static const size_t kMaxSampleRows = 200000;
+  /*! \brief nodes with fewer rows are processed by a single thread */
+  static const size_t kParallelRows = 16384;
+
+  // training parameter
+  TrainParam param;
+  // maximum number of bins of a feature
+  int max_bin;
+  // file of the quantized pages; empty to keep the data in memory
+  std::string page_file;
+  // the quantized training data, by width of the bins
+  QuantizedMatrix<uint8_t> qmat8_;
+  QuantizedMatrix<uint16_t> qmat16_;
+  QuantizedPages<uint8_t> pages8_;
+  QuantizedPages<uint16_t> pages16_;
+
+  template<typename BinType>
+  inline void UpdateTrees(QuantizedMatrix<BinType> *qmat,
+                          const std::vector<bst_gpair> &gpair,
+                          IFMatrix *p_fmat,
+                          const BoosterInfo &info,
+                          const std::vector<RegTree*> &trees) {
+    if (qmat->source != p_fmat || qmat->num_row != gpair.size() ||
+        qmat->max_bin != static_cast<unsigned>(max_bin)) {
+      qmat->Init(*p_fmat, gpair.size(), max_bin, kMaxSampleRows);
+    }
+    for (size_t i = 0; i < trees.size(); ++i) {
+      Builder<BinType> builder(param, *qmat);
+      builder.Update(gpair, p_fmat, info, trees[i]);
+    }
+  }
+  template<typename BinType>
+  inline void UpdatePagedTrees(QuantizedPages<BinType> *pages,
+                               const std::vector<bst_gpair> &gpair,
+                               IFMatrix *p_fmat,
+                               const BoosterInfo &info,
+                               const std::vector<RegTree*> &trees) {
+    if (pages->source != p_fmat || pages->num_row != gpair.size() ||
+        pages->max_bin != static_cast<unsigned>(max_bin)) {
+      pages->Init(*p_fmat, gpair.size(), max_bin, kMaxSampleRows, page_file);
+    }
+    for (size_t i = 0; i < trees.size(); ++i) {
+      PagedBuilder<BinType> builder(param, pages);
+      builder.Update(gpair, p_fmat, info, trees[i]);
+    }
+  }
+
+  struct NodeEntry {
+    /*! \brief statics for node entry */
+    GradStats stats;
+    /*! \brief loss of this node, without split */
+    bst_float root_gain;
+    /*! \brief weight calculated related to current data */
+    float weight;
+    /*! \brief current best solution */
+    SplitEntry best;
+    // constructor
+    explicit NodeEntry(const TrainParam &param)
+        : stats(param), root_gain(0.0f), weight(0.0f) {
+    }
+  };
+
+  /*!
+   * \brief the part of growing a tree common to the data in memory and on
+   *  disk: the node statistics and histograms, and finding the splits
+   */
+  struct HistBuilder {
+   public:
+    HistBuilder(const TrainParam &param, const HistCuts &cuts)
+        : param(param), cuts(cuts) {}
+
+   protected:
+    const TrainParam &param;
+    const HistCuts &cuts;
+    // histogram of each node being expanded or split, by global bin
+    std::vector<std::vector<GradStats> > hist;
+    std::vector<NodeEntry> snode;
+    std::vector<bst_uint> feat_index;
+    std::vector<int> qexpand_;
+    size_t nthread;
+
+    inline void InitFeatures(const IFMatrix &fmat, const RegTree &tree) {
+      utils::Assert(tree.param.num_nodes == tree.param.num_roots,
+                    "QuantileHistMaker: can only grow new tree");
+      // initialize feature index
+      const unsigned ncol = static_cast<unsigned>(cuts.NumCol());
+      for (unsigned i = 0; i < ncol; ++i) {
+        if (fmat.GetColSize(i) != 0 && cuts.NumBin(i) != 0) {
+          feat_index.push_back(i);
+        }
+      }
+      unsigned n = static_cast<unsigned>(param.colsample_bytree * feat_index.size());
+      random::Shuffle(feat_index);
+      feat_index.resize(std::max<unsigned>(n, 1));
+
+      nthread = turi::thread::cpu_count();
+      hist.resize(tree.param.num_roots);
+      snode.resize(tree.param.num_roots, NodeEntry(param));
+      qexpand_.clear();
+      for (int i = 0; i < tree.param.num_roots; ++i) {
+        qexpand_.push_back(i);
+      }
+    }
+    // grow the node vectors to the nodes of the tree
+    inline void ResizeNodes(const RegTree &tree) {
+      hist.resize(tree.param.num_nodes);
+      snode.resize(tree.param.num_nodes, NodeEntry(param));
+    }
+    // statistics and histogram of nid from its parent and sibling
+    inline void DeriveFromSibling(int nid, const RegTree &tree, bool with_hist) {
+      const int parent = tree[nid].parent();
+      const int sibling = tree[parent].cleft() == nid ?
+          tree[parent].cright() : tree[parent].cleft();
+      snode[nid].stats.SetSubstract(snode[parent].stats, snode[sibling].stats);
+      if (with_hist) {
+        const std::vector<GradStats> &hp = hist[parent], &hs = hist[sibling];
+        std::vector<GradStats> &h = hist[nid];
+        h.resize(hp.size(), GradStats(param));
+        turi::parallel_for(0, h.size(), [&](size_t k) {
+          h[k].SetSubstract(hp[k], hs[k]);
+        });
+      }
+      this->InitNodeGain(nid);
+    }
+    inline void InitNodeGain(int nid) {
+      snode[nid].root_gain = static_cast<float>(snode[nid].stats.CalcGain(param));
+      snode[nid].weight = static_cast<float>(snode[nid].stats.CalcWeight(param));
+    }
+    // best split of node nid on feature fid
+    inline SplitEntry EnumerateSplit(int nid, bst_uint fid, const IFMatrix &fmat) const {
+      SplitEntry best;
+      const NodeEntry &e = snode[nid];
+      const GradStats *h = hist[nid].data() + cuts.cut_ptr[fid];
+      const bst_float *cut = cuts.cut_values.data() + cuts.cut_ptr[fid];
+      const bst_uint nb = cuts.NumBin(fid);
+      const float density = fmat.GetColDensity(fid);
+      GradStats sum(param), c(param), missing(param);
+      for (bst_uint k = 0; k < nb; ++k) {
+        sum.Add(h[k]);
+      }
+      missing.SetSubstract(e.stats, sum);
+      if (param.need_forward_search(density, false)) {
+        // missing values go right; the last bin splits present from missing
+        sum.Clear();
+        for (bst_uint k = 0; k < nb; ++k) {
+          if (k + 1 == nb && !(missing.sum_hess > rt_eps)) break;
+          sum.Add(h[k]);
+          c.SetSubstract(e.stats, sum);
+          if (sum.sum_hess >= param.min_child_weight &&
+              c.sum_hess >= param.min_child_weight) {
+            bst_float loss_chg = static_cast<bst_float>(sum.CalcGain(param) +
+                                                        c.CalcGain(param) - e.root_gain);
+            best.Update(loss_chg, fid, cut[k], false);
+          }
+        }
+      }
+      if (param.need_backward_search(density, false)) {
+        // missing values go left
+        sum.Clear();
+        for (bst_uint k = nb - 1; k > 0; --k) {
+          sum.Add(h[k]);
+          c.SetSubstract(e.stats, sum);
+          if (sum.sum_hess >= param.min_child_weight &&
+              c.sum_hess >= param.min_child_weight) {
+            bst_float loss_chg = static_cast<bst_float>(sum.CalcGain(param) +
+                                                        c.CalcGain(param) - e.root_gain);
+            best.Update(loss_chg, fid, cut[k - 1], true);
+          }
+        }
+      }
+      return best;
+    }
+    inline void FindSplit(int depth, const IFMatrix &fmat, RegTree *p_tree) {
+      std::vector<bst_uint> feat_set = feat_index;
+      if (param.colsample_bylevel != 1.0f) {
+        random::Shuffle(feat_set);
+        unsigned n = static_cast<unsigned>(param.colsample_bylevel * feat_index.size());
+        utils::Check(n > 0, "colsample_bylevel is too small that no feature can be included");
+        feat_set.resize(n);
+      }
+      const std::vector<int> &qexpand = qexpand_;
+      const size_t nfeat = feat_set.size();
+      std::vector<SplitEntry> cand(qexpand.size() * nfeat);
+      turi::parallel_for(0, cand.size(), [&](size_t i) {
+        cand[i] = this->EnumerateSplit(qexpand[i / nfeat], feat_set[i % nfeat], fmat);
+      });
+      for (size_t i = 0; i < qexpand.size(); ++i) {
+        const int nid = qexpand[i];
+        NodeEntry &e = snode[nid];
+        for (size_t j = 0; j < nfeat; ++j) {
+          e.best.Update(cand[i * nfeat + j]);
+        }
+        // now we know the solution in snode[nid], set split
+        if (e.best.loss_chg > rt_eps) {
+          p_tree->AddChilds(nid);
+          (*p_tree)[nid].set_split(e.best.split_index(), e.best.split_value, e.best.default_left());
+          // mark right child as 0, to indicate fresh leaf
+          (*p_tree)[(*p_tree)[nid].cleft()].set_leaf(0.0f, 0);
+          (*p_tree)[(*p_tree)[nid].cright()].set_leaf(0.0f, 0);
+        } else {
+          (*p_tree)[nid].set_leaf(e.weight * param.learning_rate);
+        }
+      }
+    }
+    // set the rest of the nodes to expand to leaves, and remember the
+    // statistics of all nodes in the tree
+    inline void Finalize(RegTree *p_tree) {
+      RegTree &tree = *p_tree;
+      for (size_t i = 0; i < qexpand_.size(); ++i) {
+        const int nid = qexpand_[i];
+        tree[nid].set_leaf(snode[nid].weight * param.learning_rate);
+      }
+      for (int nid = 0; nid < tree.param.num_nodes; ++nid) {
+        tree.stat(nid).loss_chg = snode[nid].best.loss_chg;
+        tree.stat(nid).base_weight = snode[nid].weight;
+        tree.stat(nid).sum_hess = static_cast<float>(snode[nid].stats.sum_hess);
+        snode[nid].stats.SetLeafVec(param, tree.leafvec(nid));
+      }
+    }
+  };
+
+  // builder over a QuantizedMatrix, with the rows grouped by node
+  template<typename BinType>
+  struct Builder : public HistBuilder {
+   public:
+    Builder(const TrainParam &param, const QuantizedMatrix<BinType> &qmat)
+        : HistBuilder(param, qmat.cuts), qmat(qmat) {}
+    // update one tree, growing
+    inline void Update(const std::vector<bst_gpair> &gpair,
+                       IFMatrix *p_fmat,
+                       const BoosterInfo &info,
+                       RegTree *p_tree) {
+      RegTree &tree = *p_tree;
+      this->InitFeatures(*p_fmat, tree);
+      this->InitData(gpair, *p_fmat, info.root_index, tree);
+      this->BuildHists(this->qexpand_, gpair, true);
+      for (int depth = 0; depth < this->param.max_depth; ++depth) {
+        this->FindSplit(depth, *p_fmat, &tree);
+        std::vector<int> built, derived;
+        this->ApplySplit(tree, &built, &derived);
+        if (this->qexpand_.size() == 0) break;
+        // children at the maximum depth only need their statistics
+        const bool with_hist = depth + 1 < this->param.max_depth;
+        this->BuildHists(built, gpair, with_hist);
+        for (size_t i = 0; i < derived.size(); ++i) {
+          this->DeriveFromSibling(derived[i], tree, with_hist);
+        }
+        for (size_t i = 0; i < this->qexpand_.size(); ++i) {
+          std::vector<GradStats>().swap(this->hist[tree[this->qexpand_[i]].parent()]);
+        }
+      }
+      this->Finalize(p_tree);
+    }
+
+   private:
+    const QuantizedMatrix<BinType> &qmat;
+    // rows of the training set, grouped by node
+    std::vector<bst_uint> row_index;
+    // scratch space of the partition, aligned with row_index
+    std::vector<bst_uint> row_buf;
+    std::vector<uint8_t> go_left;
+    // the rows of node nid are row_index[node_begin[nid], node_end[nid])
+    std::vector<size_t> node_begin, node_end;
+    // per thread histogram of the node being built
+    std::vector<std::vector<GradStats> > thread_hist;
+
+    inline void InitData(const std::vector<bst_gpair> &gpair,
+                         const IFMatrix &fmat,
+                         const std::vector<unsigned> &root_index,
+                         const RegTree &tree) {
+      const int nroot = tree.param.num_roots;
+      const std::vector<bst_uint> &rowset = fmat.buffered_rowset();
+      // rows that are neither deleted nor left out by subsampling,
+      // stably grouped by root
+      std::vector<bst_uint> rows;
+      rows.reserve(rowset.size());
+      for (size_t i = 0; i < rowset.size(); ++i) {
+        const bst_uint ridx = rowset[i];
+        if (gpair[ridx].hess < 0.0f) continue;
+        if (this->param.subsample < 1.0f &&
+            random::SampleBinary(this->param.subsample) == 0) continue;
+        rows.push_back(ridx);
+      }
+      node_begin.assign(nroot, 0);
+      node_end.assign(nroot, 0);
+      if (root_index.size() == 0) {
+        node_end[0] = rows.size();
+        row_index.swap(rows);
+      } else {
+        std::vector<size_t> count(nroot + 1, 0);
+        for (size_t i = 0; i < rows.size(); ++i) {
+          utils::Assert(root_index[rows[i]] < static_cast<unsigned>(nroot),
+                        "root index exceed setting");
+          ++count[root_index[rows[i]] + 1];
+        }
+        for (int i = 0; i < nroot; ++i) {
+          count[i + 1] += count[i];
+          node_begin[i] = node_end[i] = count[i];
+        }
+        row_index.resize(rows.size());
+        for (size_t i = 0; i < rows.size(); ++i) {
+          row_index[node_end[root_index[rows[i]]]++] = rows[i];
+        }
+      }
+      row_buf.resize(row_index.size());
+      go_left.resize(row_index.size());
+      thread_hist.resize(this->nthread);
+    }
+    // add the rows [begin, end) of row_index to the histogram h and to stats
+    inline void AddRows(size_t begin, size_t end,
+                        const std::vector<bst_gpair> &gpair,
+                        GradStats *h, GradStats *stats) const {
+      const size_t ncol = this->cuts.NumCol();
+      const bst_uint *cut_ptr = this->cuts.cut_ptr.data();
+      for (size_t i = begin; i < end; ++i) {
+        const bst_uint ridx = row_index[i];
+        const bst_gpair &g = gpair[ridx];
+        stats->Add(g);
+        if (h == NULL) continue;
+        if (qmat.dense) {
+          const BinType *row = &qmat.bins[ridx * ncol];
+          for (size_t fid = 0; fid < ncol; ++fid) {
+            h[cut_ptr[fid] + row[fid]].Add(g.grad, g.hess);
+          }
+        } else {
+          for (size_t j = qmat.row_ptr[ridx]; j < qmat.row_ptr[ridx + 1]; ++j) {
+            h[cut_ptr[qmat.findex[j]] + qmat.bins[j]].Add(g.grad, g.hess);
+          }
+        }
+      }
+    }
+    // accumulate the statistics, and the histograms if with_hist, of nodes
+    inline void BuildHists(const std::vector<int> &nodes,
+                           const std::vector<bst_gpair> &gpair,
+                           bool with_hist) {
+      const size_t nbin = this->cuts.NumBin();
+      const TrainParam &param = this->param;
+      std::vector<std::vector<GradStats> > &hist = this->hist;
+      std::vector<int> small, large;
+      for (size_t i = 0; i < nodes.size(); ++i) {
+        const int nid = nodes[i];
+        if (with_hist) hist[nid].assign(nbin, GradStats(param));
+        if (node_end[nid] - node_begin[nid] < kParallelRows) {
+          small.push_back(nid);
+        } else {
+          large.push_back(nid);
+        }
+      }
+      // small nodes in parallel, one thread each
+      turi::parallel_for(0, small.size(), [&](size_t i) {
+        const int nid = small[i];
+        GradStats stats(param);
+        this->AddRows(node_begin[nid], node_end[nid], gpair,
+                      with_hist ? hist[nid].data() : NULL, &stats);
+        this->snode[nid].stats = stats;
+      });
+      // large nodes one after another, split across the threads
+      for (size_t i = 0; i < large.size(); ++i) {
+        const int nid = large[i];
+        const size_t begin = node_begin[nid], n = node_end[nid] - begin;
+        std::vector<GradStats> thread_stats(this->nthread, GradStats(param));
+        turi::in_parallel([&](size_t tid, size_t num_threads) {
+          size_t step = (n + num_threads - 1) / num_threads;
+          size_t lo = std::min(n, tid * step), hi = std::min(n, lo + step);
+          if (with_hist) thread_hist[tid].assign(nbin, GradStats(param));
+          this->AddRows(begin + lo, begin + hi, gpair,
+                        with_hist ? thread_hist[tid].data() : NULL, &thread_stats[tid]);
+        });
+        GradStats stats(param);
+        for (size_t tid = 0; tid < this->nthread; ++tid) {
+          stats.Add(thread_stats[tid]);
+        }
+        this->snode[nid].stats = stats;
+        if (with_hist) {
+          std::vector<GradStats> &h = hist[nid];
+          turi::parallel_for(0, nbin, [&](size_t k) {
+            for (size_t tid = 0; tid < this->nthread; ++tid) {
+              if (thread_hist[tid].size() != 0) h[k].Add(thread_hist[tid][k]);
+            }
+          });
+        }
+      }
+      for (size_t i = 0; i < nodes.size(); ++i) {
+        this->InitNodeGain(nodes[i]);
+      }
+    }
+    // stable partition of the rows of node nid into those of its children,
+    // using chunks of the rows in parallel when parallel is set
+    inline void PartitionRows(int nid, const RegTree &tree, bool parallel) {
+      const bst_uint fid = tree[nid].split_index();
+      const bool default_left = tree[nid].default_left();
+      const int split_bin = this->cuts.SplitBin(tree[nid]);
+      const size_t begin = node_begin[nid], n = node_end[nid] - begin;
+      const size_t nchunk = parallel ? this->nthread : 1;
+      const size_t step = (n + nchunk - 1) / std::max<size_t>(nchunk, 1);
+      std::vector<size_t> nleft(nchunk, 0), left_pos(nchunk), right_pos(nchunk);
+
+      auto mark = [&](size_t c) {
+        for (size_t i = begin + std::min(n, c * step); i < begin + std::min(n, (c + 1) * step); ++i) {
+          const int bin = qmat.GetBin(row_index[i], fid);
+          go_left[i] = bin < 0 ? default_left : bin <= split_bin;
+          nleft[c] += go_left[i];
+        }
+      };
+      auto scatter = [&](size_t c) {
+        size_t l = left_pos[c], r = right_pos[c];
+        for (size_t i = begin + std::min(n, c * step); i < begin + std::min(n, (c + 1) * step); ++i) {
+          row_buf[go_left[i] ? l++ : r++] = row_index[i];
+        }
+      };
+      if (parallel) {
+        turi::parallel_for(0, nchunk, mark);
+      } else {
+        mark(0);
+      }
+      size_t total_left = 0;
+      for (size_t c = 0; c < nchunk; ++c) total_left += nleft[c];
+      for (size_t c = 0, l = begin, r = begin + total_left; c < nchunk; ++c) {
+        left_pos[c] = l;
+        right_pos[c] = r;
+        l += nleft[c];
+        r += std::min(n, (c + 1) * step) - std::min(n, c * step) - nleft[c];
+      }
+      if (parallel) {
+        turi::parallel_for(0, nchunk, scatter);
+      } else {
+        scatter(0);
+      }
+      std::copy(row_buf.begin() + begin, row_buf.begin() + begin + n, row_index.begin() + begin);
+
+      const int cleft = tree[nid].cleft(), cright = tree[nid].cright();
+      node_begin[cleft] = begin;
+      node_end[cleft] = node_begin[cright] = begin + total_left;
+      node_end[cright] = begin + n;
+    }
+    // partition the rows of the nodes that were split, and set up their
+    // children; built gets the smaller child of each split, derived the other
+    inline void ApplySplit(const RegTree &tree,
+                           std::vector<int> *built, std::vector<int> *derived) {
+      std::vector<int> &qexpand = this->qexpand_;
+      this->ResizeNodes(tree);
+      node_begin.resize(tree.param.num_nodes, 0);
+      node_end.resize(tree.param.num_nodes, 0);
+
+      std::vector<int> split, small, large;
+      for (size_t i = 0; i < qexpand.size(); ++i) {
+        const int nid = qexpand[i];
+        if (tree[nid].is_leaf()) {
+          std::vector<GradStats>().swap(this->hist[nid]);
+          continue;
+        }
+        split.push_back(nid);
+        if (node_end[nid] - node_begin[nid] < kParallelRows) {
+          small.push_back(nid);
+        } else {
+          large.push_back(nid);
+        }
+      }
+      turi::parallel_for(0, small.size(), [&](size_t i) {
+        this->PartitionRows(small[i], tree, false);
+      });
+      for (size_t i = 0; i < large.size(); ++i) {
+        this->PartitionRows(large[i], tree, true);
+      }
+      qexpand.clear();
+      for (size_t i = 0; i < split.size(); ++i) {
+        const int cleft = tree[split[i]].cleft(), cright = tree[split[i]].cright();
+        qexpand.push_back(cleft);
+        qexpand.push_back(cright);
+        const bool left_smaller = node_end[cleft] - node_begin[cleft] <=
+            node_end[cright] - node_begin[cright];
+        built->push_back(left_smaller ? cleft : cright);
+        derived->push_back(left_smaller ? cright : cleft);
+      }
+    }
+  };
+
+  /*!
+   * \brief builder over QuantizedPages; keeps the node of each row, and
+   *  makes one pass over the pages per level, both moving the rows of the
+   *  nodes split at the level above to their children and accumulating
+   *  the histograms of the nodes of this level
+   */
+  template<typename BinType>
+  struct PagedBuilder : public HistBuilder {
+   public:
+    PagedBuilder(const TrainParam &param, QuantizedPages<BinType> *pages)
+        : HistBuilder(param, pages->cuts), pages(*pages) {}
+    // update one tree, growing
+    inline void Update(const std::vector<bst_gpair> &gpair,
+                       IFMatrix *p_fmat,
+                       const BoosterInfo &info,
+                       RegTree *p_tree) {
+      RegTree &tree = *p_tree;
+      this->InitFeatures(*p_fmat, tree);
+      this->InitData(gpair, *p_fmat, info.root_index, tree);
+      this->Pass(this->qexpand_, gpair, tree);
+      for (size_t i = 0; i < this->qexpand_.size(); ++i) {
+        this->InitNodeGain(this->qexpand_[i]);
+      }
+      for (int depth = 0; depth < this->param.max_depth; ++depth) {
+        this->FindSplit(depth, *p_fmat, &tree);
+        std::vector<int> built, derived;
+        this->SetChildStats(tree, &built, &derived);
+        if (this->qexpand_.size() == 0) break;
+        // children at the maximum depth only need their statistics, which
+        // come from the histograms of their parents
+        if (depth + 1 < this->param.max_depth) {
+          this->Pass(built, gpair, tree);
+          for (size_t i = 0; i < derived.size(); ++i) {
+            this->DeriveFromSibling(derived[i], tree, true);
+          }
+        }
+        for (size_t i = 0; i < this->qexpand_.size(); ++i) {
+          std::vector<GradStats>().swap(this->hist[tree[this->qexpand_[i]].parent()]);
+        }
+      }
+      this->Finalize(p_tree);
+    }
+
+   private:
+    QuantizedPages<BinType> &pages;
+    // node of each row, or ~nid when the row is left out of the tree
+    std::vector<int> position;
+    // whether a node was split at the level above, and its split bin
+    std::vector<char> is_split;
+    std::vector<int> split_bin;
+    // slot of a node in the histograms being built this pass, or -1
+    std::vector<int> build_slot;
+
+    inline void InitData(const std::vector<bst_gpair> &gpair,
+                         const IFMatrix &fmat,
+                         const std::vector<unsigned> &root_index,
+                         const RegTree &tree) {
+      const std::vector<bst_uint> &rowset = fmat.buffered_rowset();
+      // rows not buffered stay out of the tree
+      position.assign(gpair.size(), ~0);
+      for (size_t i = 0; i < rowset.size(); ++i) {
+        const bst_uint ridx = rowset[i];
+        int nid = 0;
+        if (root_index.size() != 0) {
+          nid = root_index[ridx];
+          utils::Assert(nid < tree.param.num_roots, "root index exceed setting");
+        }
+        if (gpair[ridx].hess < 0.0f ||
+            (this->param.subsample < 1.0f &&
+             random::SampleBinary(this->param.subsample) == 0)) {
+          nid = ~nid;
+        }
+        position[ridx] = nid;
+      }
+      is_split.assign(tree.param.num_nodes, 0);
+    }
+    // statistics of the children of the nodes just split, from the
+    // histograms of their parents; built gets the child of each split with
+    // the smaller hessian, derived the other
+    inline void SetChildStats(const RegTree &tree,
+                              std::vector<int> *built, std::vector<int> *derived) {
+      std::vector<int> &qexpand = this->qexpand_;
+      this->ResizeNodes(tree);
+      is_split.assign(tree.param.num_nodes, 0);
+      split_bin.resize(tree.param.num_nodes, 0);
+      std::vector<int> children;
+      for (size_t i = 0; i < qexpand.size(); ++i) {
+        const int nid = qexpand[i];
+        if (tree[nid].is_leaf()) {
+          std::vector<GradStats>().swap(this->hist[nid]);
+          continue;
+        }
+        is_split[nid] = 1;
+        split_bin[nid] = this->cuts.SplitBin(tree[nid]);
+        const bst_uint fid = tree[nid].split_index();
+        const GradStats *h = this->hist[nid].data() + this->cuts.cut_ptr[fid];
+        GradStats left(this->param), present(this->param);
+        for (bst_uint k = 0; k < this->cuts.NumBin(fid); ++k) {
+          present.Add(h[k]);
+          if (static_cast<int>(k) <= split_bin[nid]) left.Add(h[k]);
+        }
+        if (tree[nid].default_left()) {
+          // the missing values
+          GradStats missing(this->param);
+          missing.SetSubstract(this->snode[nid].stats, present);
+          left.Add(missing);
+        }
+        const int cleft = tree[nid].cleft(), cright = tree[nid].cright();
+        this->snode[cleft].stats = left;
+        this->snode[cright].stats.SetSubstract(this->snode[nid].stats, left);
+        this->InitNodeGain(cleft);
+        this->InitNodeGain(cright);
+        children.push_back(cleft);
+        children.push_back(cright);
+        const bool left_smaller = left.sum_hess <= this->snode[cright].stats.sum_hess;
+        built->push_back(left_smaller ? cleft : cright);
+        derived->push_back(left_smaller ? cright : cleft);
+      }
+      qexpand.swap(children);
+    }
+    // move the rows of page whose nodes were split to the children
+    inline void UpdatePosition(const QuantizedPage<BinType> &page, const RegTree &tree,
+                               const std::vector<bst_uint> &split_feats) {
+      int *pos = &position[page.base_rowid];
+      // first to the default child
+      turi::parallel_for(0, page.size, [&](size_t i) {
+        const int nid = pos[i];
+        if (nid >= 0 && is_split[nid]) {
+          pos[i] = tree[nid].default_left() ? tree[nid].cleft() : tree[nid].cright();
+        }
+      });
+      // then by the values that are present
+      for (size_t k = 0; k < split_feats.size(); ++k) {
+        const bst_uint fid = split_feats[k];
+        const size_t begin = page.col_ptr[fid], end = page.col_ptr[fid + 1];
+        turi::parallel_for(begin, end, [&](size_t j) {
+          int &nid = pos[page.row[j]];
+          if (nid < 0 || tree[nid].is_root()) return;
+          const int parent = tree[nid].parent();
+          if (!is_split[parent] || tree[parent].split_index() != fid) return;
+          nid = static_cast<int>(page.bin[j]) <= split_bin[parent] ?
+              tree[parent].cleft() : tree[parent].cright();
+        });
+      }
+    }
+    // one pass over the pages: move rows to the nodes split last, then
+    // accumulate the histograms of nodes, and their statistics when they
+    // are the roots
+    inline void Pass(const std::vector<int> &nodes,
+                     const std::vector<bst_gpair> &gpair,
+                     const RegTree &tree) {
+      const size_t nbin = this->cuts.NumBin();
+      const TrainParam &param = this->param;
+      std::vector<std::vector<GradStats> > &hist = this->hist;
+      const bool is_root_pass = tree.param.num_nodes == tree.param.num_roots;
+
+      std::vector<bst_uint> split_feats;
+      for (int nid = 0; nid < static_cast<int>(is_split.size()); ++nid) {
+        if (is_split[nid]) split_feats.push_back(tree[nid].split_index());
+      }
+      std::sort(split_feats.begin(), split_feats.end());
+      split_feats.resize(std::unique(split_feats.begin(), split_feats.end()) - split_feats.begin());
+
+      build_slot.assign(tree.param.num_nodes, -1);
+      std::vector<GradStats*> slot_hist(nodes.size());
+      for (size_t i = 0; i < nodes.size(); ++i) {
+        build_slot[nodes[i]] = static_cast<int>(i);
+        hist[nodes[i]].assign(nbin, GradStats(param));
+        slot_hist[i] = hist[nodes[i]].data();
+      }
+      std::vector<std::vector<GradStats> > thread_stats(
+          this->nthread, std::vector<GradStats>(nodes.size(), GradStats(param)));
+
+      const QuantizedPage<BinType> *page;
+      pages.BeforeFirst();
+      while (pages.Next(&page)) {
+        if (split_feats.size() != 0) {
+          this->UpdatePosition(*page, tree, split_feats);
+        }
+        const int *pos = &position[page->base_rowid];
+        const bst_gpair *g = &gpair[page->base_rowid];
+        if (is_root_pass) {
+          const size_t nthread = this->nthread;
+          turi::parallel_for(0, nthread, [&](size_t tid) {
+            for (size_t i = page->size * tid / nthread;
+                 i < page->size * (tid + 1) / nthread; ++i) {
+              if (pos[i] >= 0) thread_stats[tid][build_slot[pos[i]]].Add(g[i]);
+            }
+          });
+        }
+        // the columns in parallel, so no two threads add to the same bin
+        turi::parallel_for(0, this->feat_index.size(), [&](size_t k) {
+          const bst_uint fid = this->feat_index[k];
+          const bst_uint offset = this->cuts.cut_ptr[fid];
+          for (size_t j = page->col_ptr[fid]; j < page->col_ptr[fid + 1]; ++j) {
+            const bst_uint r = page->row[j];
+            const int nid = pos[r];
+            if (nid < 0 || build_slot[nid] < 0) continue;
+            slot_hist[build_slot[nid]][offset + page->bin[j]].Add(g[r].grad, g[r].hess);
+          }
+        });
+      }
+      if (is_root_pass) {
+        for (size_t i = 0; i < nodes.size(); ++i) {
+          GradStats stats(param);
+          for (size_t tid = 0; tid < this->nthread; ++tid) {
+            stats.Add(thread_stats[tid][i]);
+          }
+          this->snode[nodes[i]].stats = stats;
+        }
+      }
+      for (size_t i = 0; i < nodes.size(); ++i) {
+        this->InitNodeGain(nodes[i]);
+      }
+      std::fill(is_split.begin(), is_split.end(), 0);
+    }
+  };
+};
+
+}  // namespace tree
+}  // namespace xgboost
+#endif  // XGBOOST_TREE_UPDATER_QUANTILE_HISTMAKER_INL_HPP_
@@ -8,8 +8,16 @@
 #include <core/storage/sframe_data/sframe.hpp>
 #include <model_server/lib/variant.hpp>
 #include <model_server/lib/variant_deep_serialize.hpp>
+#include <ml/ml_data/parallel_column_indexing.hpp>
+#include <core/globals/globals.hpp>
 
-namespace turi { namespace ml_data_internal {
+namespace turi {
+
+size_t ML_DATA_PARALLEL_INDEXING_MIN_ROWS = 1024*1024;
+
+REGISTER_GLOBAL(int64_t, ML_DATA_PARALLEL_INDEXING_MIN_ROWS, true);
+
+namespace ml_data_internal {
 
 /**
  *  Default constructor; does nothing;
@@ -17,10 +25,12 @@ namespace turi { namespace ml_data_internal {
  */
 column_indexer::column_indexer(std::string _column_name,
                  ml_column_mode _mode,
-                 flex_type_enum _original_column_type)
+                 flex_type_enum _original_column_type,
+                 size_t _hash_buckets)
     : column_name(_column_name)
     , mode(_mode)
     , original_column_type(_original_column_type)
+    , hash_buckets(_hash_buckets)
 {}
 
 /** Initialize the index mapping and setup.  There are certain
@@ -33,10 +43,6 @@ void column_indexer::initialize() {
 
   DASSERT_TRUE(values_by_index_threadlocal_accumulator.empty());
 
-  // Init the lookup tables.
-  index_by_values_lookup.resize(
-      1 << _column_indexer_first_level_lookup_size_n_bits);
-
   size_t num_threads = thread::cpu_count();
 
   // Initialize the value trackers
@@ -64,6 +70,7 @@ void column_indexer::finalize() {
   }
 
   values_by_index_threadlocal_accumulator.clear();
+  all_values_indexed = false;
   index_modification_lock.unlock();
 }
 
@@ -122,6 +129,18 @@ void column_indexer::insert_values_into_index(
   }
 }
 
+const flexible_type& column_indexer::hash_bucket_value(size_t idx) const {
+  DASSERT_LT(idx, hash_buckets);
+
+  std::call_once(hash_bucket_values_built, [&]() {
+      hash_bucket_values.resize(hash_buckets);
+      for(size_t i = 0; i < hash_buckets; ++i)
+        hash_bucket_values[i] = flex_int(i);
+    });
+
+  return hash_bucket_values[idx];
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 std::set<flex_type_enum> column_indexer::extract_key_types() const {
@@ -171,8 +190,7 @@ void column_indexer::set_indices(std::vector<flexible_type>&& values) {
 
   // Now, we need to rebuild the index.
 
-  // Set the first level of the index_by_values hash lookup
-  index_by_values_lookup.resize(1 << _column_indexer_first_level_lookup_size_n_bits);
+  index_by_values_lookup.clear();
 
   // Fill the hash table map with the loaded list of values
   in_parallel([&](size_t thread_idx, size_t num_threads) {
@@ -180,17 +198,8 @@ void column_indexer::set_indices(std::vector<flexible_type>&& values) {
       size_t end_idx = ((thread_idx + 1) * values_by_index_lookup.size()) / num_threads;
 
       for(size_t i = start_idx; i < end_idx; ++i) {
-        hash_value wt(values_by_index_lookup[i]);
-
-        // Lock the first level
-        size_t first_index = wt.n_bit_index(_column_indexer_first_level_lookup_size_n_bits);
-        DASSERT_LT(first_index, index_by_values_lookup.size());
-        auto& lock_ht_pair = index_by_values_lookup[first_index];
-
-        {
-          std::lock_guard<simple_spinlock> wg(lock_ht_pair.first);
-          lock_ht_pair.second[wt] = i;
-        }
+        index_by_values_lookup.insert_or_assign(
+            hash_value(values_by_index_lookup[i]), i);
       }
     });
 }
@@ -218,6 +227,7 @@ void column_indexer::debug_check_is_equal(std::shared_ptr<column_indexer> other)
   ASSERT_TRUE(column_name == other->column_name);
   ASSERT_TRUE(original_column_type == other->original_column_type);
   ASSERT_TRUE(_column_size == other->_column_size);
+  ASSERT_TRUE(hash_buckets == other->hash_buckets);
 
   for(size_t i = 0; i < values_by_index_lookup.size(); ++i) {
     DASSERT_TRUE(values_by_index_lookup[i] == other->values_by_index_lookup[i]);
@@ -230,7 +240,7 @@ void column_indexer::debug_check_is_equal(std::shared_ptr<column_indexer> other)
 // Serialization routines
 
 size_t column_indexer::get_version() const {
-  return 2;
+  return 3;
 }
 
 /**
@@ -239,6 +249,7 @@ size_t column_indexer::get_version() const {
 void column_indexer::save_impl(turi::oarchive& oarc) const {
   oarc << column_name << mode << original_column_type;
   oarc << values_by_index_lookup << _column_size;
+  oarc << hash_buckets;
 }
 
 /**
@@ -246,13 +257,19 @@ void column_indexer::save_impl(turi::oarchive& oarc) const {
  */
 void column_indexer::load_version(turi::iarchive& iarc, size_t version) {
 
-  if(version == 2) {
+  if(version == 2 || version == 3) {
 
     std::vector<flexible_type> values;
 
     iarc >> column_name >> mode >> original_column_type;
     iarc >> values >> _column_size;
 
+    if(version >= 3) {
+      iarc >> hash_buckets;
+    } else {
+      hash_buckets = 0;
+    }
+
     if(mode == ml_column_mode::CATEGORICAL
        || mode == ml_column_mode::CATEGORICAL_VECTOR
        || mode == ml_column_mode::DICTIONARY) {
@@ -269,7 +286,7 @@ void column_indexer::load_version(turi::iarchive& iarc, size_t version) {
 
     std::string indexer_type = variant_get_value<std::string>(creation_options.at("indexer_type"));
 
-    ASSERT_TRUE(indexer_type == "unique");
+    ASSERT_TRUE(indexer_type == "unique" || indexer_type == "hash");
 
 #define __EXTRACT(var)                                                  \
     var = variant_get_value<decltype(var)>(creation_options.at(#var));
@@ -280,6 +297,14 @@ void column_indexer::load_version(turi::iarchive& iarc, size_t version) {
 
 #undef __EXTRACT
 
+    // The hash indexer of ml_data_2 stores only its bucket count.
+    if(indexer_type == "hash") {
+      iarc >> hash_buckets;
+      _column_size = 0;
+      set_indices({});
+      return;
+    }
+
     variant_type data_v;
     variant_deep_load(data_v, iarc);
 
@@ -8,12 +8,14 @@
 
 #include <core/data/flexible_type/flexible_type.hpp>
 #include <core/util/hash_value.hpp>
+#include <core/util/cityhash_tc.hpp>
 #include <core/logging/assertions.hpp>
 #include <core/util/bitops.hpp>
 #include <ml/ml_data/ml_data_column_modes.hpp>
 #include <core/storage/serialization/serialization_includes.hpp>
-#include <core/generics/hopscotch_map.hpp>
+#include <core/generics/concurrent_hash_map.hpp>
 #include <core/parallel/pthread_tools.hpp>
+#include <mutex>
 
 namespace turi {
 
@@ -27,15 +29,6 @@ namespace ml_data_internal {
  */
 
 
-/**  Use a two-level hash table to store the index mappings.  The
- *  first level is constant size and unlocked, determined by an n-bit
- *  hash.  Each leaf in this one contains a hash table and lock.  This
- *  significantly reduces lock contention.  This
- *  _column_metadata_first_level_lookup_size_n_bits gives the number
- *  of bits used for this first lookup.
- */
-static constexpr int _column_indexer_first_level_lookup_size_n_bits = 8;
-
 /**
  * column_metadata contains "meta data" concerning indexing of a single column
  * of an SFrame. A collection of meta_data column objects is "all" the
@@ -49,10 +42,16 @@ class column_indexer {
 
   /**
    *  Default constructor; does nothing;
+   *
+   *  If hash_buckets is nonzero, the values are not indexed; each is
+   *  mapped to one of hash_buckets indices by its hash instead.  The
+   *  indexer then holds no state beyond the bucket count, and new
+   *  values never need to be added.
    */
   column_indexer(std::string column_name,
                  ml_column_mode mode,
-                 flex_type_enum original_column_type);
+                 flex_type_enum original_column_type,
+                 size_t hash_buckets = 0);
 
   /**
    * Copy constructor: Don't want to risk making copies of this.
@@ -107,25 +106,23 @@ class column_indexer {
 
     hash_value wt(feature);
 
-    // Lock the first level
-    size_t first_index = wt.n_bit_index(_column_indexer_first_level_lookup_size_n_bits);
-    DASSERT_LT(first_index, index_by_values_lookup.size());
-    auto& lock_ht_pair = index_by_values_lookup[first_index];
-
-    std::lock_guard<simple_spinlock> lg(lock_ht_pair.first);
-    auto it = lock_ht_pair.second.find(wt);
+    if(hash_buckets != 0)
+      return hash64(wt.hash()) % hash_buckets;
 
-    size_t index;
-
-    if(it == lock_ht_pair.second.end()) {
-      index = (++_column_size) - 1;
-      values_by_index_threadlocal_accumulator[thread_idx].push_back({index, feature});
-      lock_ht_pair.second[wt] = index;
-    } else {
-      index = it->second;
+    // Once every value is in the index, nothing is inserted; look the
+    // value up without locking its shard.
+    if(all_values_indexed) {
+      size_t index;
+      if(LIKELY(index_by_values_lookup.find_unlocked(wt, index)))
+        return index;
+      DASSERT_MSG(false, "Value missing from a column marked as fully indexed.");
     }
 
-    return index;
+    return index_by_values_lookup.find_or_insert(wt, [&]() {
+        size_t index = (++_column_size) - 1;
+        values_by_index_threadlocal_accumulator[thread_idx].push_back({index, feature});
+        return index;
+      }).first;
   }
 
   /** Returns the index associated with the "feature" value.
@@ -164,22 +161,16 @@ class column_indexer {
 
     hash_value wt(feature);
 
-    // Lock the first level
-    size_t first_index = wt.n_bit_index(_column_indexer_first_level_lookup_size_n_bits);
-    DASSERT_LT(first_index, index_by_values_lookup.size());
-    auto& lock_ht_pair = index_by_values_lookup[first_index];
-
-    auto it = lock_ht_pair.second.find(wt);
-
-    if(it == lock_ht_pair.second.end()) {
+    if(hash_buckets != 0)
+      return hash64(wt.hash()) % hash_buckets;
 
+    size_t index;
+    if(index_by_values_lookup.find_unlocked(wt, index)) {
+      // Value found. Returning the index.
+      return index;
+    } else {
       // Value not found.
       return (size_t)(-1);
-
-    } else {
-
-      // Value found. Returning the index.
-      return it->second;
     }
   }
 
@@ -194,6 +185,13 @@ class column_indexer {
    */
   void insert_values_into_index(const std::vector<flexible_type>& features);
 
+  /** Declares that every value map_value_to_index will be called
+   *  with until finalize() is already in the index, for instance after
+   *  build_column_index_in_parallel.  map_value_to_index then looks
+   *  values up without taking any locks.
+   */
+  void set_all_values_indexed(bool v) { all_values_indexed = v; }
+
   /** Call this when all calls to map_value_to_index are completed.
    */
   void finalize();
@@ -214,6 +212,9 @@ class column_indexer {
     DASSERT_MSG(idx != size_t(-1),
                 "Index not tracked in metadata table!");
 
+    if(hash_buckets != 0)
+      return hash_bucket_value(idx);
+
     DASSERT_MSG(idx < values_by_index_lookup.size(),
                 "Index not in metadata table; using correct metadata?");
 
@@ -234,15 +235,20 @@ class column_indexer {
   /** Returns the size of the column.
    *
    * Numeric     : 1
-   * Categorical : # Unique categories
+   * Categorical : # Unique categories, or the number of hash buckets
    * Vector      : Size of the vector.
    *
    * \return Column size.
    */
   inline size_t indexed_column_size() const {
-    return _column_size;
+    return (hash_buckets != 0) ? hash_buckets : size_t(_column_size);
   }
 
+  /** The number of hash buckets the values are mapped to, or 0 if the
+   *  values are indexed.
+   */
+  size_t num_hash_buckets() const { return hash_buckets; }
+
   /** Returns the current version used for the serialization.
    */
   size_t get_version() const;
@@ -280,6 +286,11 @@ class column_indexer {
   const flex_type_enum& column_type() const { return original_column_type;}
  private:
 
+  /** The value of a hash bucket, which is just its index.  Built on
+   *  first use, as only reporting feature names needs them.
+   */
+  const flexible_type& hash_bucket_value(size_t idx) const;
+
   /**  The name of the column.
    */
   std::string column_name;
@@ -292,8 +303,10 @@ class column_indexer {
    */
   flex_type_enum original_column_type;
 
-  std::vector<std::pair<simple_spinlock, hopscotch_map<hash_value, size_t> > >
-  index_by_values_lookup;
+  /** The index of every value, sharded so that threads indexing
+   *  different values rarely wait on each other.
+   */
+  concurrent_hash_map<hash_value, size_t> index_by_values_lookup;
 
   std::vector<std::vector<std::pair<size_t, flexible_type> > >
   values_by_index_threadlocal_accumulator;
@@ -304,6 +317,15 @@ class column_indexer {
   atomic<size_t> _column_size = 0;
 
   mutex index_modification_lock;
+
+  // Set between initialize() and finalize() when no value is new.
+  bool all_values_indexed = false;
+
+  // If nonzero, values are hashed to this many indices instead.
+  size_t hash_buckets = 0;
+
+  mutable std::vector<flexible_type> hash_bucket_values;
+  mutable std::once_flag hash_bucket_values_built;
 };
 
 /// \}
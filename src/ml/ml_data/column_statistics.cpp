@@ -11,7 +11,13 @@
 #include <model_server/lib/variant.hpp>
 #include <model_server/lib/variant_deep_serialize.hpp>
 
-namespace turi { namespace ml_data_internal {
+namespace turi {
+
+size_t ML_DATA_STATS_THREAD_LOCAL_MEMORY_BUDGET = 256*1024*1024;
+
+REGISTER_GLOBAL(int64_t, ML_DATA_STATS_THREAD_LOCAL_MEMORY_BUDGET, true);
+
+namespace ml_data_internal {
 
 size_t ML_DATA_STATS_PARALLEL_ACCESS_THRESHOLD = 1024*1024;
 
@@ -43,8 +49,13 @@ void column_statistics::initialize() {
   by_thread_row_counts.assign(num_threads, 0);
   by_thread_mean_var_acc.resize(num_threads);
 
-  // Pull in the parallel_threshhold point.
-  parallel_threshhold = ML_DATA_STATS_PARALLEL_ACCESS_THRESHOLD;
+  // Pull in the parallel_threshhold point, lowered so the thread-local
+  // accumulators of all the threads fit in the memory budget.
+  size_t bytes_per_index = sizeof(size_t) + sizeof(element_statistics_accumulator);
+  parallel_threshhold = std::min<size_t>(
+      ML_DATA_STATS_PARALLEL_ACCESS_THRESHOLD,
+      std::max<size_t>(1024, ML_DATA_STATS_THREAD_LOCAL_MEMORY_BUDGET
+                                 / (num_threads * bytes_per_index)));
 }
 
 void column_statistics::_finalize_threadlocal(
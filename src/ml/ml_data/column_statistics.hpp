@@ -14,7 +14,18 @@
 #include <boost/thread/lock_algorithms.hpp>
 #include <set>
 
-namespace turi { namespace ml_data_internal {
+namespace turi {
+
+/**
+ * The most memory, in bytes, that the thread-local statistics
+ * accumulators of one column may take across all the threads.  The
+ * number of indices accumulated thread-locally (at most
+ * ML_DATA_STATS_PARALLEL_ACCESS_THRESHOLD) is reduced to fit; the rest
+ * go to the shared accumulators.  Shared by both ml_data APIs.
+ */
+extern size_t ML_DATA_STATS_THREAD_LOCAL_MEMORY_BUDGET;
+
+namespace ml_data_internal {
 
 extern size_t ML_DATA_STATS_PARALLEL_ACCESS_THRESHOLD;
 
@@ -415,9 +426,10 @@ class column_statistics {
 
   // The issue with having seperate accumulators for each thread is
   // that it can take an inordinate amount of memory.  Thus we use
-  // parallel access for the first million or so items, which are
-  // likely to be the most common.  For the rest, we use a larger one
-  // with locking.
+  // parallel access for the first million or so items (fewer with
+  // many threads; see ML_DATA_STATS_THREAD_LOCAL_MEMORY_BUDGET), which
+  // are likely to be the most common.  For the rest, we use a larger
+  // one with locking.
 
   size_t parallel_threshhold = 1024*1024;
 
@@ -484,7 +496,7 @@ class column_statistics {
     if(UNLIKELY(idx >= v.size() )) {
 
       // Grow aggressively, since a resize is really expensive.
-      size_t new_size = 2 * (parallel_threshhold + idx + 1);
+      size_t new_size = std::max<size_t>(1024, 2 * (idx + 1));
 
       {
         std::array<std::unique_lock<simple_spinlock>, n_locks> all_locks;
@@ -0,0 +1,200 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <ml/ml_data/data_storage/entry_data_codec.hpp>
+#include <core/storage/sframe_data/integer_pack.hpp>
+#include <core/util/dense_bitset.hpp>
+#include <core/logging/assertions.hpp>
+#include <core/globals/globals.hpp>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace turi { namespace ml_data_internal {
+
+size_t ML_DATA_ROUND_VALUES_TO_FLOAT32 = 0;
+
+REGISTER_GLOBAL(int64_t, ML_DATA_ROUND_VALUES_TO_FLOAT32, true);
+
+static constexpr size_t N_INTEGERS_PER_REFERENCE_BLOCK = 128;
+
+static void save_integers(turi::oarchive& oarc, const uint64_t* data, size_t n) {
+  for (size_t i = 0; i < n; i += N_INTEGERS_PER_REFERENCE_BLOCK) {
+    size_t limit = std::min<size_t>(n - i, N_INTEGERS_PER_REFERENCE_BLOCK);
+    integer_pack::frame_of_reference_encode_128(data + i, limit, oarc);
+  }
+}
+
+static void load_integers(turi::iarchive& iarc, uint64_t* data, size_t n) {
+  for (size_t i = 0; i < n; i += N_INTEGERS_PER_REFERENCE_BLOCK) {
+    size_t limit = std::min<size_t>(n - i, N_INTEGERS_PER_REFERENCE_BLOCK);
+    integer_pack::frame_of_reference_decode_128(iarc, limit, data + i);
+  }
+}
+
+void save_entry_data(turi::oarchive& oarc, const uint64_t* data, size_t n,
+                     size_t version) {
+
+  DASSERT_TRUE(version == 1 || version == 2);
+
+  // Separate the indices (anything that fits in 32 bits) from the
+  // values.
+  std::vector<uint64_t> integers;
+  std::vector<double> doubles;
+
+  integers.reserve(n);
+
+  dense_bitset bs(n);
+  bs.clear();
+
+  for (size_t i = 0; i < n; ++i) {
+    if (data[i] <= std::numeric_limits<uint32_t>::max()) {
+      integers.push_back(data[i]);
+      bs.set_bit_unsync(i);
+    } else {
+      double v;
+      std::memcpy(&v, data + i, sizeof(double));
+      doubles.push_back(v);
+    }
+  }
+
+  // Now, split off the values that can be encoded as integers.
+  std::vector<uint64_t> doubles_as_ints;
+  doubles_as_ints.reserve(doubles.size());
+  dense_bitset bs_dbl(doubles.size());
+  bs_dbl.clear();
+
+  size_t dbl_write_pos = 0;
+  for (size_t i = 0; i < doubles.size(); ++i) {
+    if (double(uint64_t(doubles[i])) == doubles[i]) {
+      doubles_as_ints.push_back(doubles[i]);
+      bs_dbl.set_bit_unsync(i);
+    } else {
+      doubles[dbl_write_pos++] = doubles[i];
+    }
+  }
+  doubles.resize(dbl_write_pos);
+
+  // Then the ones that are 32 bit floats, exactly or by request.
+  std::vector<float> floats;
+  dense_bitset bs_flt(version >= 2 ? doubles.size() : 0);
+  bs_flt.clear();
+
+  if (version >= 2) {
+    const bool round_values = (ML_DATA_ROUND_VALUES_TO_FLOAT32 != 0);
+    floats.reserve(doubles.size());
+
+    dbl_write_pos = 0;
+    for (size_t i = 0; i < doubles.size(); ++i) {
+      float f = float(doubles[i]);
+      double back = f;
+
+      bool exact = (std::memcmp(&back, &doubles[i], sizeof(double)) == 0);
+
+      if (exact || (round_values && std::isfinite(doubles[i]) && std::isfinite(f))) {
+        floats.push_back(f);
+        bs_flt.set_bit_unsync(i);
+      } else {
+        doubles[dbl_write_pos++] = doubles[i];
+      }
+    }
+    doubles.resize(dbl_write_pos);
+  }
+
+  bool all_integers = (doubles.empty() && doubles_as_ints.empty() && floats.empty());
+
+  oarc << all_integers;
+  oarc << n;
+
+  if (all_integers) {
+    save_integers(oarc, data, n);
+    return;
+  }
+
+  // Store all the quantities first in case we want to specialize
+  // the decoding based on what is present.
+  oarc << integers.size() << doubles.size() << doubles_as_ints.size();
+  if (version >= 2) oarc << floats.size();
+
+  oarc << bs << bs_dbl;
+  if (version >= 2) oarc << bs_flt;
+
+  turi::serialize(oarc, doubles.data(), doubles.size() * sizeof(double));
+  if (version >= 2) {
+    turi::serialize(oarc, floats.data(), floats.size() * sizeof(float));
+  }
+
+  save_integers(oarc, doubles_as_ints.data(), doubles_as_ints.size());
+  save_integers(oarc, integers.data(), integers.size());
+}
+
+void load_entry_data(turi::iarchive& iarc,
+                     const std::function<uint64_t*(size_t)>& allocate,
+                     size_t version) {
+
+  ASSERT_MSG(version == 1 || version == 2,
+             "Row block format not recognized; saved with a newer version?");
+
+  bool all_integers;
+  iarc >> all_integers;
+
+  size_t n = 0;
+  iarc >> n;
+  uint64_t* out = allocate(n);
+
+  if (all_integers) {
+    load_integers(iarc, out, n);
+    return;
+  }
+
+  size_t n_integers = 0, n_doubles = 0, n_doubles_as_ints = 0, n_floats = 0;
+  iarc >> n_integers >> n_doubles >> n_doubles_as_ints;
+  if (version >= 2) iarc >> n_floats;
+
+  ASSERT_EQ(n_integers + n_doubles + n_doubles_as_ints + n_floats, n);
+
+  dense_bitset bs, bs_dbl, bs_flt;
+  iarc >> bs >> bs_dbl;
+  if (version >= 2) iarc >> bs_flt;
+
+  std::vector<double> doubles(n_doubles);
+  turi::deserialize(iarc, doubles.data(), n_doubles * sizeof(double));
+
+  std::vector<float> floats(n_floats);
+  turi::deserialize(iarc, floats.data(), n_floats * sizeof(float));
+
+  std::vector<uint64_t> doubles_as_ints(n_doubles_as_ints);
+  load_integers(iarc, doubles_as_ints.data(), n_doubles_as_ints);
+
+  std::vector<uint64_t> integers(n_integers);
+  load_integers(iarc, integers.data(), n_integers);
+
+  // Now interleave them again.
+  const uint64_t* integer_read_ptr = integers.data();
+  const uint64_t* double_as_int_read_ptr = doubles_as_ints.data();
+  const double* double_read_ptr = doubles.data();
+  const float* float_read_ptr = floats.data();
+
+  for (size_t i = 0, dbl_i = 0, flt_i = 0; i < n; ++i) {
+    if (bs.get(i)) {
+      out[i] = *(integer_read_ptr++);
+      continue;
+    }
+
+    double v;
+    if (bs_dbl.get(dbl_i++)) {
+      // It's a double masquerading as an int!
+      v = double(*(double_as_int_read_ptr++));
+    } else if (version >= 2 && bs_flt.get(flt_i++)) {
+      v = *(float_read_ptr++);
+    } else {
+      v = *(double_read_ptr++);
+    }
+    std::memcpy(out + i, &v, sizeof(double));
+  }
+}
+
+}}
@@ -0,0 +1,67 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_DML_DATA_ENTRY_DATA_CODEC_H_
+#define TURI_DML_DATA_ENTRY_DATA_CODEC_H_
+
+#include <cstdint>
+#include <functional>
+#include <core/storage/serialization/serialization_includes.hpp>
+
+namespace turi { namespace ml_data_internal {
+
+/**
+ * If nonzero, values of row blocks which are neither integers nor
+ * exactly representable as 32 bit floats are rounded to 32 bit floats
+ * when the blocks are written.  This loses precision, so it is off by
+ * default.
+ */
+extern size_t ML_DATA_ROUND_VALUES_TO_FLOAT32;
+
+/** The compact storage format of the 8 byte entries of a row block
+ *  (the entry_value unions of both ml_data APIs).
+ *
+ *  The entries are split into integer indices, values that are
+ *  integers, values that are exactly 32 bit floats, and other values.
+ *  Indices and integer values are frame of reference coded in groups
+ *  of 128, with delta coding when it is smaller; floats take 4 bytes;
+ *  only the other values take 8.  Two bitsets record which kind each
+ *  entry is.
+ *
+ *  Version 1 has no float group; it is the format of the version 1 row
+ *  blocks of ml_data, and is still read.
+ */
+static constexpr size_t ENTRY_DATA_CODEC_VERSION = 2;
+
+/** Writes n entries at data in the given format version.
+ */
+void save_entry_data(turi::oarchive& oarc, const uint64_t* data, size_t n,
+                     size_t version = ENTRY_DATA_CODEC_VERSION);
+
+/** Reads entries written by save_entry_data.  allocate(n) is called
+ *  with the number of entries once it is known, and must return space
+ *  for them.
+ */
+void load_entry_data(turi::iarchive& iarc,
+                     const std::function<uint64_t*(size_t)>& allocate,
+                     size_t version = ENTRY_DATA_CODEC_VERSION);
+
+/** Reads entries written by save_entry_data into a vector of 8 byte
+ *  entries.
+ */
+template <typename EntryValue>
+void load_entry_data(turi::iarchive& iarc, std::vector<EntryValue>& entries,
+                     size_t version = ENTRY_DATA_CODEC_VERSION) {
+  static_assert(sizeof(EntryValue) == sizeof(uint64_t), "Entries must be 8 bytes.");
+
+  load_entry_data(iarc, [&](size_t n) {
+      entries.resize(n);
+      return reinterpret_cast<uint64_t*>(entries.data());
+    }, version);
+}
+
+}}
+
+#endif
@@ -15,7 +15,8 @@ void column_metadata::setup(
     bool is_target_column,
     const std::string& column_name,
     const std::shared_ptr<sarray<flexible_type> >& column,
-    const std::map<std::string, ml_column_mode>& mode_overrides)
+    const std::map<std::string, ml_column_mode>& mode_overrides,
+    size_t hash_buckets)
 {
 
   ////////////////////////////////////////////////////////////////////////////////
@@ -28,7 +29,13 @@ void column_metadata::setup(
   ////////////////////////////////////////////////////////////////////////////////
   // Step 2: Set the column indexer
 
-  indexer.reset(new column_indexer(column_name, mode, original_column_type));
+  bool hash_values = (!is_target_column
+                      && (mode == ml_column_mode::CATEGORICAL
+                          || mode == ml_column_mode::CATEGORICAL_VECTOR
+                          || mode == ml_column_mode::DICTIONARY));
+
+  indexer.reset(new column_indexer(column_name, mode, original_column_type,
+                                   hash_values ? hash_buckets : 0));
   statistics.reset(new column_statistics(column_name, mode, original_column_type));
 
   ////////////////////////////////////////////////////////////////////////////////
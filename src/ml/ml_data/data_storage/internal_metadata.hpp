@@ -44,11 +44,14 @@ struct column_metadata {
   // Construction
 
   /** Generates a new column_metadata class using the data arrays and
-   *  the types.
+   *  the types.  If hash_buckets is nonzero, the values of a
+   *  categorical or dictionary feature column are hashed to that many
+   *  indices rather than indexed.
    */
   void setup(bool is_target_column, const std::string& name,
              const std::shared_ptr<sarray<flexible_type> >& column,
-             const std::map<std::string, ml_column_mode>& mode_overrides);
+             const std::map<std::string, ml_column_mode>& mode_overrides,
+             size_t hash_buckets = 0);
 
   /** Finalize training.
    */
@@ -5,8 +5,22 @@
  */
 #include <ml/ml_data/data_storage/ml_data_block_manager.hpp>
 #include <ml/ml_data/ml_data.hpp>
+#include <core/parallel/numa.hpp>
+#include <core/globals/globals.hpp>
+#include <core/globals/memory_accounting.hpp>
+#include <algorithm>
 
-namespace turi { namespace ml_data_internal {
+namespace turi {
+
+size_t ML_DATA_PREFETCH_BLOCKS = 2;
+
+REGISTER_GLOBAL(int64_t, ML_DATA_PREFETCH_BLOCKS, true);
+
+size_t ML_DATA_PREFETCH_MEMORY_BUDGET = 256*1024*1024;
+
+REGISTER_GLOBAL(int64_t, ML_DATA_PREFETCH_MEMORY_BUDGET, true);
+
+namespace ml_data_internal {
 
 ml_data_block_manager::ml_data_block_manager(
     std::shared_ptr<ml_metadata> _metadata,
@@ -29,6 +43,72 @@ ml_data_block_manager::ml_data_block_manager(
   }
 }
 
+/** Stops the background loading.
+ */
+ml_data_block_manager::~ml_data_block_manager() {
+  {
+    std::lock_guard<turi::mutex> guard(cache_lock);
+    prefetch_stopping = true;
+    prefetch_cond.notify_all();
+  }
+  if(prefetch_thread.joinable()) prefetch_thread.join();
+}
+
+/** The memory held by a block, roughly.
+ */
+static size_t block_memory(const ml_data_block& block) {
+  size_t ret = block.translated_rows.entry_data.size() * sizeof(entry_value)
+      + block.translated_rows.additional_data.size() * sizeof(flexible_type);
+  for(const auto& c : block.untranslated_columns) {
+    ret += c.size() * sizeof(flexible_type);
+  }
+  return ret;
+}
+
+/** Reads a block from disk.
+ */
+std::shared_ptr<ml_data_block> ml_data_block_manager::load_block(size_t block_index) {
+
+  std::vector<row_data_block> row_block_buffer;
+
+  data_reader->read_rows(block_index, block_index + 1, row_block_buffer);
+
+  ////////////////////////////////////////////////////////////
+  // Step 1.1: Do we have any untranslated columns?
+
+  std::vector<std::vector<flexible_type> >
+      untranslated_column_buffers(untranslated_column_readers.size());
+
+  if(!untranslated_column_buffers.empty()) {
+
+    // Fill out the untranslated column buffers
+    size_t row_start_idx = block_index * row_block_size;
+    size_t row_end_idx = (block_index + 1) * row_block_size;
+
+    for(size_t i = 0; i < untranslated_column_readers.size(); ++i) {
+      untranslated_column_readers[i]->read_rows(
+          row_start_idx, row_end_idx, untranslated_column_buffers[i]);
+    }
+  }
+
+  std::unique_ptr<ml_data_block> block(
+      new ml_data_block{metadata,
+            rm,
+            std::move(row_block_buffer[0]),
+            std::move(untranslated_column_buffers)});
+
+  // Account for the block until its last reference is dropped.
+  static memory_accounting::memory_tag& tag =
+      memory_accounting::get_tag("ml_data_blocks");
+  size_t bytes = block_memory(*block);
+  tag.allocate(bytes);
+  return std::shared_ptr<ml_data_block>(
+      block.release(), [bytes](ml_data_block* b) {
+        tag.release(bytes);
+        delete b;
+      });
+}
+
 /** Returns a block corresponding to the block index.  Loads from
  *  disk if not in cache.
  */
@@ -53,7 +133,14 @@ std::shared_ptr<ml_data_block> ml_data_block_manager::get_block(size_t block_ind
     }
   }
 
-  auto it = row_block_cache.find(block_index);
+  // If the block is being loaded in the background, wait for it.
+  while(block_being_prefetched == block_index) {
+    prefetch_cond.wait(guard);
+  }
+
+  // Every NUMA node keeps its own copy of a block, read by its own threads.
+  auto cache_key = std::make_pair(numa_current_node(), block_index);
+  auto it = row_block_cache.find(cache_key);
   std::shared_ptr<ml_data_block> ret;
 
   if(it != row_block_cache.end()) {
@@ -66,6 +153,22 @@ std::shared_ptr<ml_data_block> ml_data_block_manager::get_block(size_t block_ind
     }
   }
 
+  // Take it from the prefetched blocks if it is there.  It then lives
+  // as long as the iterators using it, like any other block.  A
+  // prefetched copy of a block found in cache is dropped.
+  auto p_it = prefetched_blocks.find(block_index);
+
+  if(p_it != prefetched_blocks.end()) {
+    prefetched_bytes -= std::min(prefetched_bytes, block_memory(*p_it->second));
+
+    if(ret == nullptr) {
+      ret = std::move(p_it->second);
+      row_block_cache[cache_key] = ret;
+    }
+
+    prefetched_blocks.erase(p_it);
+  }
+
   // It's not in cache, so create it.
   if(ret == nullptr) {
 
@@ -74,37 +177,11 @@ std::shared_ptr<ml_data_block> ml_data_block_manager::get_block(size_t block_ind
     guard.unlock();
 
     // Need to instantiate it.
-    std::vector<row_data_block> row_block_buffer;
-
-    data_reader->read_rows(block_index, block_index + 1, row_block_buffer);
-
-    ////////////////////////////////////////////////////////////
-    // Step 1.1: Do we have any untranslated columns?
-
-    std::vector<std::vector<flexible_type> >
-        untranslated_column_buffers(untranslated_column_readers.size());
-
-    if(!untranslated_column_buffers.empty()) {
-
-      // Fill out the untranslated column buffers
-      size_t row_start_idx = block_index * row_block_size;
-      size_t row_end_idx = (block_index + 1) * row_block_size;
-
-      for(size_t i = 0; i < untranslated_column_readers.size(); ++i) {
-        untranslated_column_readers[i]->read_rows(
-            row_start_idx, row_end_idx, untranslated_column_buffers[i]);
-      }
-    }
-
-    ret.reset(new ml_data_block
-              {metadata,
-                    rm,
-                    std::move(row_block_buffer[0]),
-                    std::move(untranslated_column_buffers)});
+    ret = load_block(block_index);
 
     // Reaquire the lock on the cache.
     guard.lock();
-    auto new_it = row_block_cache.insert({block_index, ret});
+    auto new_it = row_block_cache.insert({cache_key, ret});
 
     auto map_it = new_it.first;
     bool ret_value_inserted = new_it.second;
@@ -120,7 +197,7 @@ std::shared_ptr<ml_data_block> ml_data_block_manager::get_block(size_t block_ind
 
         // The one in there is bad; replace it.
         row_block_cache.erase(map_it);
-        row_block_cache.insert({block_index, ret});
+        row_block_cache.insert({cache_key, ret});
       }
     }
   }
@@ -128,4 +205,95 @@ std::shared_ptr<ml_data_block> ml_data_block_manager::get_block(size_t block_ind
   return ret;
 }
 
+/** Queues blocks for loading in the background.
+ */
+void ml_data_block_manager::prefetch_blocks(size_t block_begin, size_t block_end) {
+
+  if(ML_DATA_PREFETCH_BLOCKS == 0 || block_begin >= block_end) {
+    return;
+  }
+
+  std::lock_guard<turi::mutex> guard(cache_lock);
+
+  if(prefetch_stopping || prefetched_bytes >= ML_DATA_PREFETCH_MEMORY_BUDGET) {
+    return;
+  }
+
+  bool queued = false;
+
+  for(size_t block_index = block_begin; block_index < block_end; ++block_index) {
+    if(block_index == block_being_prefetched
+       || prefetched_blocks.count(block_index)
+       || std::find(prefetch_queue.begin(), prefetch_queue.end(), block_index)
+           != prefetch_queue.end()) {
+      continue;
+    }
+
+    auto it = row_block_cache.find(std::make_pair(numa_current_node(), block_index));
+    if(it != row_block_cache.end() && !it->second.expired()) {
+      continue;
+    }
+
+    prefetch_queue.push_back(block_index);
+    queued = true;
+  }
+
+  if(!queued) {
+    return;
+  }
+
+  if(!prefetch_thread.joinable()) {
+    prefetch_thread = std::thread([this]() { this->prefetch_loop(); });
+  }
+
+  prefetch_cond.notify_all();
+}
+
+/** The loop of the background loading thread.
+ */
+void ml_data_block_manager::prefetch_loop() {
+
+  std::unique_lock<turi::mutex> guard(cache_lock);
+
+  while(true) {
+    while(!prefetch_stopping && prefetch_queue.empty()) {
+      prefetch_cond.wait(guard);
+    }
+
+    if(prefetch_stopping) {
+      return;
+    }
+
+    size_t block_index = prefetch_queue.front();
+    prefetch_queue.pop_front();
+
+    if(prefetched_blocks.count(block_index)
+       || prefetched_bytes >= ML_DATA_PREFETCH_MEMORY_BUDGET) {
+      continue;
+    }
+
+    block_being_prefetched = block_index;
+    guard.unlock();
+
+    std::shared_ptr<ml_data_block> block;
+
+    try {
+      block = load_block(block_index);
+    } catch(...) {
+      // Any error is raised again when an iterator loads the block
+      // itself.
+    }
+
+    guard.lock();
+    block_being_prefetched = size_t(-1);
+
+    if(block != nullptr) {
+      prefetched_bytes += block_memory(*block);
+      prefetched_blocks[block_index] = std::move(block);
+    }
+
+    prefetch_cond.notify_all();
+  }
+}
+
 }}
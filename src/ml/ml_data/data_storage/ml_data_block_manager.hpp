@@ -7,8 +7,24 @@
 #define TURI_DML_DATA_BLOCK_MANAGER_H_
 
 #include <ml/ml_data/data_storage/ml_data_row_format.hpp>
+#include <condition_variable>
+#include <deque>
+#include <thread>
 
 namespace turi {
+
+/** The number of blocks past the current one that each ml_data
+ *  iterator has loaded in the background.  0 disables prefetching.
+ *  Shared by both ml_data APIs.
+ */
+extern size_t ML_DATA_PREFETCH_BLOCKS;
+
+/** The most memory, in bytes, that each block manager holds in
+ *  prefetched blocks not yet read by an iterator.  Past it, blocks are
+ *  not prefetched.
+ */
+extern size_t ML_DATA_PREFETCH_MEMORY_BUDGET;
+
 namespace ml_data_internal {
 
 
@@ -51,6 +67,17 @@ class ml_data_block_manager {
    */
   std::shared_ptr<ml_data_block> get_block(size_t block_index);
 
+  /** Loads the blocks [block_begin, block_end) on a background thread,
+   *  so that get_block() finds them loaded.  Blocks already loaded or
+   *  queued are skipped, and nothing is queued while the prefetched
+   *  blocks not yet read hold ML_DATA_PREFETCH_MEMORY_BUDGET bytes.
+   */
+  void prefetch_blocks(size_t block_begin, size_t block_end);
+
+  /** Stops the background loading.
+   */
+  ~ml_data_block_manager();
+
   typedef std::shared_ptr<typename sarray<ml_data_internal::row_data_block>::reader_type> block_reader;
 
   block_reader get_reader() const { return data_reader; }
@@ -89,9 +116,38 @@ class ml_data_block_manager {
    */
   size_t num_accesses = 0;
 
-  /**  The map of cached blocks.
+  /**  The map of cached blocks, by NUMA node and block index.  Threads on
+   *   different NUMA nodes load their own copy of a block, so that the
+   *   rows they iterate over are in memory local to them.
+   */
+  std::map<std::pair<size_t, size_t>, std::weak_ptr<ml_data_block> > row_block_cache;
+
+  /** Reads a block from disk.
+   */
+  std::shared_ptr<ml_data_block> load_block(size_t block_index);
+
+  /** The loop of the background loading thread.
+   */
+  void prefetch_loop();
+
+  /** Blocks to be loaded in the background, in order.  All the
+   *  prefetching state is guarded by cache_lock.
    */
-  std::map<size_t, std::weak_ptr<ml_data_block> > row_block_cache;
+  std::deque<size_t> prefetch_queue;
+
+  /** Blocks loaded in the background and not yet returned by
+   *  get_block(), and the memory they take.
+   */
+  std::map<size_t, std::shared_ptr<ml_data_block> > prefetched_blocks;
+  size_t prefetched_bytes = 0;
+
+  /** The block the background thread is loading, or -1.
+   */
+  size_t block_being_prefetched = size_t(-1);
+
+  std::condition_variable_any prefetch_cond;
+  std::thread prefetch_thread;
+  bool prefetch_stopping = false;
 
 };
 
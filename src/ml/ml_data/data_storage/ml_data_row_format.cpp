@@ -7,6 +7,7 @@
 #include <cstdint>
 #include <core/globals/globals.hpp>
 #include <ml/ml_data/data_storage/ml_data_row_format.hpp>
+#include <ml/ml_data/data_storage/entry_data_codec.hpp>
 #include <ml/ml_data/metadata.hpp>
 #include <ml/ml_data/ml_data.hpp>
 #include <core/util/basic_types.hpp>
@@ -17,122 +18,16 @@ namespace turi {
 namespace ml_data_internal {
 
 static const size_t ROW_READ_CHECKSUM = 0x259e2e6d7a32c5c0ULL;
-static constexpr size_t N_INTEGERS_PER_REFERENCE_BLOCK = 128;
 
 void row_data_block::load(turi::iarchive& iarc) {
   size_t version;
   iarc >> version;
 
-  ASSERT_EQ(version, 1);
+  ASSERT_MSG(version == 1 || version == 2,
+             "Row block format not recognized; saved with a newer version?");
 
-  bool all_integers;
-  iarc >> all_integers;
-
-  size_t entry_data_size = 0;
-  iarc >> entry_data_size;
-  entry_data.resize(entry_data_size);
-
-  if (all_integers) {
-    // All integers.  Just do it directly,
-    for (size_t i = 0; i < entry_data_size;
-         i += N_INTEGERS_PER_REFERENCE_BLOCK) {
-      size_t limit =
-          std::min<size_t>(entry_data_size - i, N_INTEGERS_PER_REFERENCE_BLOCK);
-      integer_pack::frame_of_reference_decode_128(
-          iarc, limit, reinterpret_cast<uint64_t*>(entry_data.data() + i));
-    }
-  } else {
-    // A mix.  The most complicated one.
-    size_t n_integers = 0;
-    iarc >> n_integers;
-
-    size_t n_doubles = 0;
-    iarc >> n_doubles;
-
-    size_t n_doubles_as_ints;
-    iarc >> n_doubles_as_ints;
-
-    DASSERT_EQ(n_doubles + n_integers + n_doubles_as_ints, entry_data_size);
-
-    // First, unpack the bitset.  This specifies whether things
-    // are doubles or integers.
-
-    dense_bitset bs, bs_dbl;
-    iarc >> bs >> bs_dbl;
-
-    std::vector<uint64_t> other_doubles;
-
-    typedef const uint64_t* __restrict__ read_ptr_type;
-    typedef uint64_t* __restrict__ write_ptr_type;
-
-    read_ptr_type double_read_ptr;
-    read_ptr_type double_as_int_read_ptr;
-
-    {
-      double* double_write_ptr;
-      uint64_t* double_as_int_write_ptr;
-
-      if (n_doubles < n_doubles_as_ints) {
-        other_doubles.resize(n_doubles);
-        double_write_ptr = reinterpret_cast<double*>(other_doubles.data());
-        double_as_int_write_ptr = reinterpret_cast<uint64_t*>(
-            entry_data.data() + (entry_data_size - n_doubles_as_ints));
-      } else {
-        other_doubles.resize(n_doubles_as_ints);
-        double_as_int_write_ptr =
-            reinterpret_cast<uint64_t*>(other_doubles.data());
-        double_write_ptr = reinterpret_cast<double*>(
-            entry_data.data() + (entry_data_size - n_doubles));
-      }
-
-      double_read_ptr = reinterpret_cast<read_ptr_type>(double_write_ptr);
-      double_as_int_read_ptr =
-          reinterpret_cast<read_ptr_type>(double_as_int_write_ptr);
-
-      // Unpack the doubles
-      turi::deserialize(iarc, double_write_ptr, n_doubles * sizeof(double));
-
-      // Unpack the doubles as integers.
-      for (size_t i = 0; i < n_doubles_as_ints;
-           i += N_INTEGERS_PER_REFERENCE_BLOCK) {
-        size_t read_count = std::min<size_t>(n_doubles_as_ints - i,
-                                             N_INTEGERS_PER_REFERENCE_BLOCK);
-        integer_pack::frame_of_reference_decode_128(
-            iarc, read_count, double_as_int_write_ptr + i);
-      }
-    }
-
-    // Now, go through and pull all the integers out.
-    std::vector<uint64_t> integer_buffer;
-    integer_buffer.resize(n_integers);
-
-    // All integers.  Just do it directly,
-    for (size_t i = 0; i < n_integers; i += N_INTEGERS_PER_REFERENCE_BLOCK) {
-      size_t limit =
-          std::min<size_t>(n_integers - i, N_INTEGERS_PER_REFERENCE_BLOCK);
-      integer_pack::frame_of_reference_decode_128(iarc, limit,
-                                                  integer_buffer.data() + i);
-    }
-
-    read_ptr_type integer_read_ptr =
-        reinterpret_cast<read_ptr_type>(integer_buffer.data());
-    write_ptr_type write_ptr =
-        reinterpret_cast<write_ptr_type>(entry_data.data());
-
-    for (size_t i = 0, dbl_i = 0; i < entry_data_size; ++i, ++write_ptr) {
-      if (bs.get(i)) {
-        *write_ptr = *(integer_read_ptr++);
-      } else {
-        if (bs_dbl.get(dbl_i++)) {
-          // It's a double masquerading as an int!
-          double v = double(*(double_as_int_read_ptr++));
-          memcpy(write_ptr, &v, sizeof(double));
-        } else {
-          *write_ptr = *(double_read_ptr++);
-        }
-      }
-    }
-  }
+  // The version of the block is that of its entry data format.
+  load_entry_data(iarc, entry_data, version);
 
   iarc >> additional_data;
 
@@ -143,106 +38,11 @@ void row_data_block::load(turi::iarchive& iarc) {
 
 void row_data_block::save(turi::oarchive& oarc) const {
   // Save the version.
-  size_t version = 1;
+  size_t version = ENTRY_DATA_CODEC_VERSION;
   oarc << version;
 
-  ////////////////////////////////////////////////////////////////////////////////
-
-  // Seperate all the integers and all the doubles.
-  std::vector<uint64_t> integers;
-  std::vector<double> doubles;
-
-  integers.reserve(entry_data.size());
-  doubles.reserve(entry_data.size());
-
-  dense_bitset bs(entry_data.size());
-  bs.clear();
-
-  for (size_t i = 0; i < entry_data.size(); ++i) {
-    if (entry_data[i].index_value <= std::numeric_limits<uint32_t>::max()) {
-      integers.push_back(entry_data[i].index_value);
-      bs.set_bit_unsync(i);
-    } else {
-      doubles.push_back(entry_data[i].double_value);
-    }
-  }
-
-  // Now, split off the doubles that can be encoded as integers.
-  std::vector<uint64_t> doubles_as_ints;
-  doubles_as_ints.reserve(doubles.size());
-  dense_bitset bs_dbl(doubles.size());
-  bs_dbl.clear();
-
-  size_t dbl_write_pos = 0;
-  for (size_t i = 0; i < doubles.size(); ++i) {
-    if (double(uint64_t(doubles[i])) == doubles[i]) {
-      doubles_as_ints.push_back(doubles[i]);
-      bs_dbl.set_bit_unsync(i);
-    } else {
-      doubles[dbl_write_pos++] = doubles[i];
-    }
-  }
-  doubles.resize(dbl_write_pos);
-
-  // Now, based on the distribution of the integers, choose one
-  // mode.  Almost all doubles? just do all doubles.
-
-  bool all_integers = (doubles.size() == 0 && doubles_as_ints.size() == 0);
-
-  oarc << all_integers;
-
-  ////////////////////////////////////////////////////////////////////////////////
-  // Now, we need to actually go through and save all the data in one of several
-  // ways.
-
-  size_t entry_data_size = entry_data.size();
-  oarc << entry_data_size;
-
-  if (all_integers) {
-    // All integers.  Just do it directly,
-    for (size_t i = 0; i < entry_data_size;
-         i += N_INTEGERS_PER_REFERENCE_BLOCK) {
-      size_t limit =
-          std::min<size_t>(entry_data_size - i, N_INTEGERS_PER_REFERENCE_BLOCK);
-      integer_pack::frame_of_reference_encode_128(
-          reinterpret_cast<const uint64_t*>(entry_data.data() + i), limit,
-          oarc);
-    }
-  } else {
-    // Store all the quantities first in case we want to specialize
-    // the decoding based on what is present.
-    size_t n_integers = integers.size();
-    oarc << n_integers;
-
-    size_t n_doubles = doubles.size();
-    oarc << n_doubles;
-
-    size_t n_doubles_as_ints = doubles_as_ints.size();
-    oarc << n_doubles_as_ints;
-
-    // Store the bitmasks.
-    oarc << bs << bs_dbl;
-
-    // Store the doubles.
-    turi::serialize(oarc, doubles.data(), n_doubles * sizeof(double));
-
-    // Store the doubles_as_ints.
-    for (size_t i = 0; i < n_doubles_as_ints;
-         i += N_INTEGERS_PER_REFERENCE_BLOCK) {
-      size_t limit = std::min<size_t>(n_doubles_as_ints - i,
-                                      N_INTEGERS_PER_REFERENCE_BLOCK);
-      integer_pack::frame_of_reference_encode_128(doubles_as_ints.data() + i,
-                                                  limit, oarc);
-    }
-
-    // Store the integers.
-    for (size_t i = 0; i < n_integers; i += N_INTEGERS_PER_REFERENCE_BLOCK) {
-      size_t limit =
-          std::min<size_t>(n_integers - i, N_INTEGERS_PER_REFERENCE_BLOCK);
-      integer_pack::frame_of_reference_encode_128(integers.data() + i, limit,
-                                                  oarc);
-    }
-  }
+  save_entry_data(oarc, reinterpret_cast<const uint64_t*>(entry_data.data()),
+                  entry_data.size(), version);
 
   oarc << additional_data;
 
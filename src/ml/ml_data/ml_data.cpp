@@ -9,8 +9,11 @@
 #include <ml/ml_data/data_storage/ml_data_row_translation.hpp>
 #include <ml/ml_data/data_storage/ml_data_block_manager.hpp>
 #include <ml/ml_data/data_storage/util.hpp>
+#include <ml/ml_data/ml_data_cache.hpp>
+#include <ml/ml_data/parallel_column_indexing.hpp>
 #include <core/util/basic_types.hpp>
 #include <core/util/try_finally.hpp>
+#include <core/logging/trace_events.hpp>
 
 using namespace turi::ml_data_internal;
 
@@ -52,6 +55,7 @@ const ml_data& ml_data::operator=(const ml_data& other) {
   _row_end                    = other._row_end;
   _original_num_rows          = other._original_num_rows;
   _max_row_size               = other._max_row_size;
+  _feature_hash_buckets       = other._feature_hash_buckets;
   row_block_size              = other.row_block_size;
   data_blocks                 = other.data_blocks;
   block_manager               = other.block_manager;
@@ -78,6 +82,35 @@ void ml_data::fill(const sframe& raw_data,
                    bool immutable_metadata,
                    ml_missing_value_action mva) {
 
+  trace::scoped_span span("ml_data", "fill");
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Step 0.  A training fill of data filled the same way before is taken
+  // from the cache.
+
+  std::unique_ptr<ml_data_cache_key> cache_key;
+
+  if(_metadata == nullptr && ML_DATA_CACHE_CAPACITY != 0) {
+    cache_key.reset(new ml_data_cache_key("ml_data"));
+    cache_key->add_data(raw_data);
+    cache_key->add(row_bounds.first);
+    cache_key->add(row_bounds.second);
+    cache_key->add(target_column_name);
+    for(const auto& p : mode_overrides) {
+      cache_key->add(p.first);
+      cache_key->add(int(p.second));
+    }
+    cache_key->add(int(mva));
+    cache_key->add(_feature_hash_buckets);
+
+    auto cached = ml_data_cache::get_instance().lookup<ml_data>(*cache_key);
+    if(cached != nullptr) {
+      logstream(LOG_INFO) << "Reusing cached ml_data." << std::endl;
+      *this = cached->_copy_with_independent_metadata();
+      return;
+    }
+  }
+
   ////////////////////////////////////////////////////////////////////////////////
   // Step 1.  Set up the metadata if need be.
 
@@ -237,6 +270,16 @@ void ml_data::fill(const sframe& raw_data,
   // Step 8.  Set up the block manager
 
   _reset_block_manager();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Step 9.  Store the result for the next identical fill.
+
+  // Untranslated columns refer to the source columns, which would then
+  // never be released, so those fills are not stored.
+  if(cache_key != nullptr && untranslated_columns.empty()) {
+    ml_data_cache::get_instance().insert<ml_data>(
+        *cache_key, std::make_shared<ml_data>(_copy_with_independent_metadata()));
+  }
 }
 
 
@@ -314,7 +357,8 @@ void ml_data::_setup_ml_metadata(const sframe& data,
         false,
         column_names[c_idx],
         data.select_column(column_names[c_idx]),
-        mode_overrides);
+        mode_overrides,
+        _feature_hash_buckets);
   }
 
   ////////////////////////////////////////////////////////////////////////////////
@@ -445,6 +489,7 @@ void ml_data::_fill_data_blocks(const sframe& raw_data,
         // values into the index in order.  This makes a number of
         // test cases much easier to write.
         if(mode_is_indexed(m->mode)
+           && m->indexer->num_hash_buckets() == 0
            && (sorted_columns.empty() || (sorted_columns.count(m->name) == 0))) {
           std::vector<flexible_type> vv;
           column_readers[c_idx]->read_rows(row_lb, std::min(row_lb + 10000, row_ub), vv);
@@ -510,6 +555,31 @@ void ml_data::_fill_data_blocks(const sframe& raw_data,
     }
   }
 
+  // With enough rows, index the remaining columns in full before
+  // translating; the translation pass below then only looks values
+  // up, without any contention on the indices.
+  if(!immutable_metadata && num_rows >= ML_DATA_PARALLEL_INDEXING_MIN_ROWS) {
+    for(size_t c_idx = 0; c_idx < rm.total_num_columns; ++c_idx) {
+
+      const auto& m = rm.metadata_vect[c_idx];
+
+      if(m->is_untranslated_column() || !mode_is_indexed(m->mode))
+        continue;
+
+      // Hashed columns have nothing to index.
+      if(m->indexer->num_hash_buckets() != 0)
+        continue;
+
+      // Sorted columns were indexed in full above.
+      if(sorted_columns.count(m->name) == 0) {
+        build_column_index_in_parallel(
+            *m->indexer, m->mode, *column_readers[c_idx], row_lb, row_ub);
+      }
+
+      m->indexer->set_all_values_indexed(true);
+    }
+  }
+
 
   ////////////////////////////////////////////////////////////////////////////////
   // Set the number of rows in each row block.
@@ -534,6 +604,8 @@ void ml_data::_fill_data_blocks(const sframe& raw_data,
   // everything as needed for the metadata statistics.
   in_parallel([&](size_t thread_idx, size_t num_threads) {
 
+      trace::scoped_span thread_span("ml_data", "fill_rows");
+
       // Set up start points for the segments.  To make the indexing sane, the
       // rows are stored in blocks of row_block_size rows. This must be true
       // across segments.  Thus we must set up the row indexing so that each
@@ -920,6 +992,35 @@ ml_data ml_data::slice(size_t slice_row_start, size_t slice_row_end) const {
   return out;
 }
 
+/** Returns a copy sharing the data, but with its own copy of the metadata,
+ *  which a later fill can modify.
+ */
+ml_data ml_data::_copy_with_independent_metadata() const {
+  ml_data ret(*this);
+
+  std::stringstream strm;
+  {
+    turi::oarchive oarc(strm);
+    _metadata->save(oarc);
+  }
+  ret._metadata = std::make_shared<ml_metadata>();
+  {
+    turi::iarchive iarc(strm);
+    ret._metadata->load(iarc);
+  }
+
+  // The row metadata refers to the column metadata, with the target last.
+  for(size_t c_idx = 0; c_idx < ret.rm.metadata_vect.size(); ++c_idx) {
+    ret.rm.metadata_vect[c_idx] =
+        (c_idx < ret._metadata->num_columns()
+         ? ret._metadata->columns[c_idx]
+         : ret._metadata->target);
+  }
+
+  ret._reset_block_manager();
+  return ret;
+}
+
 /** Convenience function to create the block manager given the current
  *  data in the model.
  */
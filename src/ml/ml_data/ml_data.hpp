@@ -355,6 +355,19 @@ class ml_data {
             bool immutable_metadata = false,
             ml_missing_value_action _mva = ml_missing_value_action::ERROR);
 
+  /** Hashes the values of the categorical, categorical vector and
+   *  dictionary feature columns to n_buckets indices each, instead of
+   *  indexing every distinct value.  The metadata of these columns is
+   *  then constant size, and translating new data never adds to it;
+   *  distinct values may share an index.  0 (the default) indexes the
+   *  values.  The target column is always indexed.
+   *
+   *  Only used when the metadata is built, i.e. on the first fill.
+   */
+  void set_feature_hash_buckets(size_t n_buckets) {
+    _feature_hash_buckets = n_buckets;
+  }
+
 
   ////////////////////////////////////////////////////////////////////////////////
   //
@@ -498,6 +511,7 @@ class ml_data {
   size_t _row_end                        = 0;
   size_t _original_num_rows              = 0;
   size_t _max_row_size                   = 0;
+  size_t _feature_hash_buckets           = 0;
 
 
   /** The row metadata.  This is what is needed to interact with the
@@ -532,6 +546,11 @@ class ml_data {
    */
   void _reset_block_manager();
 
+  /** A copy sharing the data, with its own copy of the metadata.  Used for
+   *  the values stored in, and returned from, the ml_data_cache.
+   */
+  ml_data _copy_with_independent_metadata() const;
+
   ////////////////////////////////////////////////////////////////////////////////
   //
   //  Internal routines for setting up and filling the ml_data.  These
@@ -0,0 +1,109 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <ml/ml_data/ml_data_cache.hpp>
+#include <core/logging/logger.hpp>
+#include <core/globals/globals.hpp>
+
+namespace turi {
+
+size_t ML_DATA_CACHE_CAPACITY = 0;
+
+REGISTER_GLOBAL(int64_t, ML_DATA_CACHE_CAPACITY, true);
+
+ml_data_cache_key::ml_data_cache_key(const std::string& api)
+    : m_oarc(m_strm) {
+  m_oarc << api;
+}
+
+void ml_data_cache_key::add_data(const sframe& data) {
+  m_oarc << data.num_rows() << data.num_columns();
+  for (size_t i = 0; i < data.num_columns(); ++i) {
+    auto column = data.select_column(i);
+    const index_file_information info = column->get_index_info();
+    m_oarc << data.column_name(i) << info.index_file
+           << info.segment_files << info.segment_sizes;
+    m_sources.push_back(column);
+  }
+}
+
+
+ml_data_cache& ml_data_cache::get_instance() {
+  static ml_data_cache* instance = new ml_data_cache();
+  return *instance;
+}
+
+
+std::shared_ptr<const void> ml_data_cache::lookup_impl(const std::string& key) {
+  std::lock_guard<mutex> guard(m_lock);
+  drop_expired_entries();
+  auto it = m_entries.find(key);
+  if (it == m_entries.end()) return nullptr;
+  m_lru.splice(m_lru.begin(), m_lru, it->second.lru_position);
+  return it->second.value;
+}
+
+
+void ml_data_cache::insert_impl(
+    const std::string& key,
+    const std::vector<std::weak_ptr<sarray<flexible_type>>>& sources,
+    std::shared_ptr<const void> value) {
+  std::lock_guard<mutex> guard(m_lock);
+  drop_expired_entries();
+  if (ML_DATA_CACHE_CAPACITY == 0) return;
+
+  auto it = m_entries.find(key);
+  if (it != m_entries.end()) erase_entry(it);
+
+  while (!m_lru.empty() && m_entries.size() >= ML_DATA_CACHE_CAPACITY) {
+    erase_entry(m_entries.find(m_lru.back()));
+  }
+
+  m_lru.push_front(key);
+  entry& e = m_entries[key];
+  e.value = value;
+  e.sources = sources;
+  e.lru_position = m_lru.begin();
+}
+
+
+void ml_data_cache::clear() {
+  std::lock_guard<mutex> guard(m_lock);
+  m_entries.clear();
+  m_lru.clear();
+}
+
+
+size_t ml_data_cache::size() const {
+  std::lock_guard<mutex> guard(m_lock);
+  return m_entries.size();
+}
+
+
+void ml_data_cache::drop_expired_entries() {
+  for (auto it = m_entries.begin(); it != m_entries.end(); ) {
+    bool expired = false;
+    for (const auto& source : it->second.sources) {
+      if (source.expired()) {
+        expired = true;
+        break;
+      }
+    }
+    auto next = std::next(it);
+    if (expired) {
+      logstream(LOG_INFO) << "Dropping cached ml_data with a released source" << std::endl;
+      erase_entry(it);
+    }
+    it = next;
+  }
+}
+
+
+void ml_data_cache::erase_entry(std::unordered_map<std::string, entry>::iterator it) {
+  m_lru.erase(it->second.lru_position);
+  m_entries.erase(it);
+}
+
+}
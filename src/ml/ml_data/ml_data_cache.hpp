@@ -0,0 +1,139 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_ML_DATA_CACHE_H_
+#define TURI_ML_DATA_CACHE_H_
+
+#include <list>
+#include <memory>
+#include <string>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include <core/parallel/mutex.hpp>
+#include <core/storage/serialization/serialization_includes.hpp>
+#include <core/storage/sframe_data/sarray.hpp>
+#include <core/storage/sframe_data/sframe.hpp>
+
+namespace turi {
+
+/**
+ * The maximum number of filled ml_data objects kept by the \ref
+ * ml_data_cache. 0, the default, disables the cache: a filled ml_data can be
+ * as large as its source data, so keeping several of them alive must be
+ * asked for.
+ */
+extern size_t ML_DATA_CACHE_CAPACITY;
+
+/**
+ * The key of a filled ml_data in the \ref ml_data_cache: an exact
+ * serialization of the source data identity and of every filling parameter.
+ *
+ * Columns are identified by their index information (index file, segment
+ * files and segment sizes), which changes whenever the data does.
+ */
+class ml_data_cache_key {
+ public:
+  /**
+   * Starts a key for the given filling API; keys of different APIs never
+   * match.
+   */
+  explicit ml_data_cache_key(const std::string& api);
+
+  /// Adds the identity and the column names of data.
+  void add_data(const sframe& data);
+
+  /// Adds a filling parameter.
+  template <typename T>
+  void add(const T& value) {
+    m_oarc << value;
+  }
+
+  /// The serialized key.
+  std::string str() const { return m_strm.str(); }
+
+  /// The source arrays of the key; the entry is dropped when one is released.
+  const std::vector<std::weak_ptr<sarray<flexible_type>>>& sources() const {
+    return m_sources;
+  }
+
+ private:
+  std::stringstream m_strm;
+  oarchive m_oarc;
+  std::vector<std::weak_ptr<sarray<flexible_type>>> m_sources;
+};
+
+/**
+ * A process wide cache of filled ml_data objects, shared by ml_data (ml/ml_data)
+ * and v2::ml_data (toolkits/ml_data_2).
+ *
+ * Filling indexes, gathers statistics and translates every row of the data.
+ * Toolkits run one after another on the same SFrame (a model and its
+ * evaluation, or several models trained on the same table) fill the same
+ * data with the same parameters each time. Each API stores the result of
+ * a training fill here, keyed by \ref ml_data_cache_key, and returns the
+ * stored result for the next fill with an equal key.
+ *
+ * The values are opaque to the cache. The filling API is responsible for
+ * handing out copies which do not share mutable state (the metadata) with
+ * the stored value.
+ *
+ * An entry refers to its source arrays only weakly, and is dropped once any
+ * of them is released. Values must therefore not hold the source arrays
+ * themselves. The cache holds at most ML_DATA_CACHE_CAPACITY
+ * entries, and evicts the least recently used one first.
+ */
+class ml_data_cache {
+ public:
+  static ml_data_cache& get_instance();
+
+  /// Returns the value stored for key, or nullptr.
+  template <typename T>
+  std::shared_ptr<const T> lookup(const ml_data_cache_key& key) {
+    return std::static_pointer_cast<const T>(lookup_impl(key.str()));
+  }
+
+  /// Stores a value for key, replacing any previous one.
+  template <typename T>
+  void insert(const ml_data_cache_key& key, std::shared_ptr<const T> value) {
+    insert_impl(key.str(), key.sources(), std::static_pointer_cast<const void>(value));
+  }
+
+  /// Drops all entries.
+  void clear();
+
+  /// The number of entries in the cache.
+  size_t size() const;
+
+ private:
+  ml_data_cache() = default;
+
+  struct entry {
+    std::shared_ptr<const void> value;
+    std::vector<std::weak_ptr<sarray<flexible_type>>> sources;
+    std::list<std::string>::iterator lru_position;
+  };
+
+  std::shared_ptr<const void> lookup_impl(const std::string& key);
+
+  void insert_impl(const std::string& key,
+                   const std::vector<std::weak_ptr<sarray<flexible_type>>>& sources,
+                   std::shared_ptr<const void> value);
+
+  /// Drops the entries with released sources. m_lock must be held.
+  void drop_expired_entries();
+
+  /// Drops an entry. m_lock must be held.
+  void erase_entry(std::unordered_map<std::string, entry>::iterator it);
+
+  mutable mutex m_lock;
+  std::unordered_map<std::string, entry> m_entries;
+  /// Keys in order of use; the most recently used at the front.
+  std::list<std::string> m_lru;
+};
+
+}
+
+#endif
@@ -53,6 +53,12 @@ void ml_data_iterator::setup_block_containing_current_row_index() {
 
     row.data_block.reset();
     row.data_block = data.block_manager->get_block(current_block_index);
+
+    // Have the next blocks of this iterator loaded in the background.
+    size_t block_end = (iter_row_index_end - 1) / data.row_block_size + 1;
+    data.block_manager->prefetch_blocks(
+        current_block_index + 1,
+        std::min(block_end, current_block_index + 1 + ML_DATA_PREFETCH_BLOCKS));
   }
 
   size_t desired_current_row = current_row_index;
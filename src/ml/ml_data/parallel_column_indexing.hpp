@@ -0,0 +1,148 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_ML_DATA_PARALLEL_COLUMN_INDEXING_H_
+#define TURI_ML_DATA_PARALLEL_COLUMN_INDEXING_H_
+
+#include <unordered_map>
+#include <vector>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/util/hash_value.hpp>
+#include <core/util/bitops.hpp>
+#include <core/parallel/lambda_omp.hpp>
+#include <core/parallel/pthread_tools.hpp>
+#include <core/storage/sframe_data/sarray.hpp>
+
+namespace turi {
+
+/**
+ * Fills with at least this many rows index their categorical columns
+ * with \ref build_column_index_in_parallel before translating the rows.
+ */
+extern size_t ML_DATA_PARALLEL_INDEXING_MIN_ROWS;
+
+/**
+ * Calls fn on each value of the cell v which gets an index in a
+ * column of the given mode, in the same way as the column indexers'
+ * insert_values_into_index.
+ *
+ * ColumnMode is the ml_column_mode of either ml_data API.
+ */
+template <typename ColumnMode, typename Function>
+GL_HOT_INLINE_FLATTEN
+inline void for_each_indexed_value(ColumnMode mode, const flexible_type& v, Function&& fn) {
+  switch(mode) {
+    case ColumnMode::CATEGORICAL:
+      fn(v);
+      return;
+
+    case ColumnMode::CATEGORICAL_VECTOR:
+      if(v.get_type() == flex_type_enum::UNDEFINED)
+        return;
+      for(const auto& x : v.get<flex_list>())
+        fn(x);
+      return;
+
+    case ColumnMode::DICTIONARY:
+      if(v.get_type() == flex_type_enum::UNDEFINED)
+        return;
+      if(v.get_type() == flex_type_enum::DICT) {
+        for(const auto& kv : v.get<flex_dict>())
+          fn(kv.first);
+      } else {
+        fn(v);
+      }
+      return;
+
+    default:
+      return;
+  }
+}
+
+/**
+ * Adds every value in rows [row_lb, row_ub) of a column to its
+ * indexer, so that the translation pass only ever finds values
+ * already in the index.
+ *
+ * Indexing while translating has every thread insert into the shared
+ * index as it goes; with many distinct values, the threads contend on
+ * the index for each new value.  Here, the indexing is done in two
+ * phases instead:
+ *
+ *  1. Each thread reads a range of the rows and collects the distinct
+ *     values of its range in dictionaries of its own, partitioned by
+ *     hash, without touching the shared index.
+ *
+ *  2. Each thread takes a set of the partitions, merges them across
+ *     the threads, and inserts each distinct value once.  Different
+ *     threads insert disjoint sets of values.
+ *
+ * The indexer must be initialized.  Values that cannot be indexed
+ * raise the indexer's usual error in phase 2.
+ */
+template <typename Indexer, typename ColumnMode>
+void build_column_index_in_parallel(
+    Indexer& indexer, ColumnMode mode,
+    sarray<flexible_type>::reader_type& reader,
+    size_t row_lb, size_t row_ub) {
+
+  typedef std::unordered_map<hash_value, flexible_type> value_map;
+
+  const size_t max_num_threads = thread::cpu_count();
+
+  // A power of two, so that a partition is a number of hash bits.
+  const size_t partition_bits = bitwise_log2_ceil(std::max<size_t>(2, max_num_threads));
+  const size_t num_partitions = size_t(1) << partition_bits;
+
+  // Phase 1: The distinct values of each thread's rows, by partition.
+  std::vector<std::vector<value_map> > local_values(
+      max_num_threads, std::vector<value_map>(num_partitions));
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+
+      size_t n_rows = row_ub - row_lb;
+      size_t start_idx = row_lb + (thread_idx * n_rows) / num_threads;
+      size_t end_idx = row_lb + ((thread_idx + 1) * n_rows) / num_threads;
+
+      auto& partitions = local_values[thread_idx];
+      std::vector<flexible_type> vv;
+
+      for(size_t row_idx = start_idx; row_idx < end_idx; row_idx += 4096) {
+
+        reader.read_rows(row_idx, std::min(end_idx, row_idx + 4096), vv);
+
+        for(const flexible_type& v : vv) {
+          for_each_indexed_value(mode, v, [&](const flexible_type& x) {
+              hash_value h(x);
+              auto& part = partitions[h.n_bit_index(partition_bits)];
+              if(part.find(h) == part.end())
+                part.emplace(h, x);
+            });
+        }
+      }
+    });
+
+  // Phase 2: Merge each partition and index its values.
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+
+      for(size_t p = thread_idx; p < num_partitions; p += num_threads) {
+
+        value_map merged = std::move(local_values[0][p]);
+
+        for(size_t t = 1; t < local_values.size(); ++t) {
+          for(auto& hv : local_values[t][p])
+            merged.emplace(hv.first, std::move(hv.second));
+          value_map().swap(local_values[t][p]);
+        }
+
+        for(const auto& hv : merged)
+          indexer.map_value_to_index(thread_idx, hv.second);
+      }
+    });
+}
+
+}
+
+#endif
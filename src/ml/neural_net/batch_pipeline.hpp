@@ -0,0 +1,227 @@
+/* Copyright © 2019 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#ifndef TURI_NEURAL_NET_BATCH_PIPELINE_HPP_
+#define TURI_NEURAL_NET_BATCH_PIPELINE_HPP_
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace turi {
+namespace neural_net {
+
+/**
+ * Prepares batches on background threads, ahead of the thread that consumes
+ * them (typically the thread feeding the GPU).
+ *
+ * Each batch is made in two steps. A read function, called by one worker at a
+ * time, takes the next raw batch from the data source (e.g. the next rows of
+ * an SFrame); it returns false once the source is exhausted. A process
+ * function then turns the raw batch into the final batch (e.g. loading and
+ * parsing the images), in parallel across the workers.
+ *
+ * At most queue_depth batches are read but not yet consumed, so the memory
+ * used stays bounded however far the workers get ahead. In ordered mode, the
+ * batches come out in the order they were read; otherwise, in the order they
+ * are finished.
+ *
+ * An exception thrown by either function is rethrown by the call to next()
+ * that would have returned the batch. No batch is read after a failure, so
+ * the pipeline then ends once the batches already read have come out.
+ *
+ * The destructor stops the workers, once they finish the batch at hand.
+ */
+template <typename RawBatch, typename Batch>
+class batch_pipeline {
+ public:
+
+  struct options {
+
+    /** Number of background threads. */
+    size_t num_workers = 2;
+
+    /** Maximum number of batches read and not yet consumed. */
+    size_t queue_depth = 4;
+
+    /** Whether to return the batches in the order they were read. */
+    bool ordered = true;
+  };
+
+  typedef std::function<bool(RawBatch*)> read_function;
+  typedef std::function<Batch(RawBatch)> process_function;
+
+  batch_pipeline(read_function read, process_function process,
+                 const options& opts)
+    : read_(std::move(read)), process_(std::move(process)), opts_(opts) {
+
+    if (opts_.num_workers == 0) opts_.num_workers = 1;
+    if (opts_.queue_depth == 0) opts_.queue_depth = 1;
+
+    workers_.reserve(opts_.num_workers);
+    for (size_t i = 0; i < opts_.num_workers; ++i) {
+      workers_.emplace_back([this]() { this->worker_loop(); });
+    }
+  }
+
+  // Not copyable or movable: the workers point back to this instance.
+  batch_pipeline(const batch_pipeline&) = delete;
+  batch_pipeline& operator=(const batch_pipeline&) = delete;
+
+  ~batch_pipeline() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    space_cond_.notify_all();
+    for (std::thread& t : workers_) {
+      t.join();
+    }
+  }
+
+  /**
+   * Waits for the next batch. Returns false once every batch of the source
+   * has been returned.
+   */
+  bool next(Batch* out) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_cond_.wait(lock, [this]() { return is_known(); });
+    if (is_done()) return false;
+
+    auto it = opts_.ordered ? ready_.find(num_delivered_) : ready_.begin();
+    slot s = std::move(it->second);
+    ready_.erase(it);
+    ++num_delivered_;
+    lock.unlock();
+    space_cond_.notify_all();
+
+    if (s.error) std::rethrow_exception(s.error);
+    *out = std::move(s.batch);
+    return true;
+  }
+
+  /**
+   * Waits until the next batch is ready or the source is exhausted. Returns
+   * false in the latter case.
+   */
+  bool has_next() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_cond_.wait(lock, [this]() { return is_known(); });
+    return !is_done();
+  }
+
+ private:
+
+  struct slot {
+    Batch batch;
+    std::exception_ptr error;
+  };
+
+  // Whether next() can return without waiting. Called with mutex_ held.
+  bool is_done() const {
+    return done_reading_ && num_delivered_ == num_read_ && ready_.empty();
+  }
+
+  bool is_known() const {
+    if (is_done()) return true;
+    return opts_.ordered ? ready_.count(num_delivered_) > 0 : !ready_.empty();
+  }
+
+  void worker_loop() {
+    while (true) {
+      // Read one raw batch, one worker at a time.
+      std::unique_lock<std::mutex> read_lock(read_mutex_);
+
+      size_t seq;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_cond_.wait(lock, [this]() {
+          return stop_ || done_reading_ ||
+                 num_read_ < num_delivered_ + opts_.queue_depth;
+        });
+        if (stop_ || done_reading_) return;
+        seq = num_read_;
+      }
+
+      RawBatch raw;
+      bool has_raw = false;
+      std::exception_ptr error;
+      try {
+        has_raw = read_(&raw);
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (error) {
+          ready_[seq].error = error;
+          num_read_ = seq + 1;
+          done_reading_ = true;
+        } else if (!has_raw) {
+          done_reading_ = true;
+        } else {
+          num_read_ = seq + 1;
+        }
+      }
+      read_lock.unlock();
+
+      if (!has_raw) {
+        // Wake the consumer, and the workers waiting for space.
+        ready_cond_.notify_all();
+        space_cond_.notify_all();
+        return;
+      }
+
+      slot result;
+      try {
+        result.batch = process_(std::move(raw));
+      } catch (...) {
+        result.error = std::current_exception();
+      }
+
+      bool failed = static_cast<bool>(result.error);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (failed) {
+          // Stop reading; the batches already read still come out.
+          done_reading_ = true;
+        }
+        ready_[seq] = std::move(result);
+      }
+      ready_cond_.notify_all();
+      if (failed) space_cond_.notify_all();
+    }
+  }
+
+  read_function read_;
+  process_function process_;
+  options opts_;
+
+  std::mutex read_mutex_;
+
+  // Guards the members below.
+  std::mutex mutex_;
+  std::condition_variable ready_cond_;
+  std::condition_variable space_cond_;
+  std::map<size_t, slot> ready_;
+  size_t num_read_ = 0;
+  size_t num_delivered_ = 0;
+  bool done_reading_ = false;
+  bool stop_ = false;
+
+  std::vector<std::thread> workers_;
+};
+
+}  // neural_net
+}  // turi
+
+#endif  // TURI_NEURAL_NET_BATCH_PIPELINE_HPP_
@@ -8,6 +8,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <numeric>
 
 #include <core/logging/assertions.hpp>
@@ -128,6 +129,83 @@ std::shared_ptr<float_array> shared_float_array::default_value() {
   return *singleton;
 }
 
+// A float_buffer whose vector goes back to a float_buffer_pool on destruction.
+class float_buffer_pool::pooled_float_buffer: public float_array {
+public:
+  pooled_float_buffer(std::vector<float> data, std::vector<size_t> shape,
+                      std::shared_ptr<free_list> owner)
+    : shape_(std::move(shape)),
+      size_(std::accumulate(shape_.begin(), shape_.end(), 1u, multiply)),
+      data_(std::move(data)),
+      owner_(std::move(owner))
+  {
+    assert(data_.size() == size_);
+  }
+
+  ~pooled_float_buffer() override {
+    owner_->release(std::move(data_));
+  }
+
+  const float* data() const override { return data_.data(); }
+  size_t size() const override { return size_; }
+
+  const size_t* shape() const override { return shape_.data(); }
+  size_t dim() const override { return shape_.size(); }
+
+private:
+  std::vector<size_t> shape_;
+  size_t size_ = 0;
+  std::vector<float> data_;
+  std::shared_ptr<free_list> owner_;
+};
+
+void float_buffer_pool::free_list::release(std::vector<float> buffer) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (buffers.size() < max_buffers) {
+    buffers.push_back(std::move(buffer));
+  }
+}
+
+float_buffer_pool::float_buffer_pool(size_t max_free_buffers)
+  : free_list_(std::make_shared<free_list>())
+{
+  free_list_->max_buffers = max_free_buffers;
+}
+
+std::vector<float> float_buffer_pool::acquire(size_t size) {
+  std::vector<float> result;
+  {
+    std::lock_guard<std::mutex> lock(free_list_->mutex);
+    // Take the smallest vector that is large enough, so that small requests
+    // do not use up the large vectors.
+    auto& buffers = free_list_->buffers;
+    auto it = buffers.end();
+    for (auto b = buffers.begin(); b != buffers.end(); ++b) {
+      if (b->capacity() >= size &&
+          (it == buffers.end() || b->capacity() < it->capacity())) {
+        it = b;
+      }
+    }
+    if (it != buffers.end()) {
+      result = std::move(*it);
+      buffers.erase(it);
+    }
+  }
+  result.assign(size, 0.f);
+  return result;
+}
+
+shared_float_array float_buffer_pool::wrap(std::vector<float> data,
+                                           std::vector<size_t> shape) {
+  return shared_float_array(std::make_shared<pooled_float_buffer>(
+      std::move(data), std::move(shape), free_list_));
+}
+
+size_t float_buffer_pool::num_free_buffers() const {
+  std::lock_guard<std::mutex> lock(free_list_->mutex);
+  return free_list_->buffers.size();
+}
+
 deferred_float_array::deferred_float_array(
     std::shared_future<shared_float_array> data_future,
     std::vector<size_t> shape)
@@ -150,5 +228,121 @@ const float* deferred_float_array::data() const {
   return float_array.data();
 }
 
+uint16_t float_to_half(float value, half_float_type type) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+
+  if (type == half_float_type::BFLOAT16) {
+    if ((bits & 0x7fffffff) > 0x7f800000) {
+      // Keep NaNs quiet, instead of rounding them to infinity.
+      return static_cast<uint16_t>((bits >> 16) | 0x40);
+    }
+    uint32_t rounding = 0x7fff + ((bits >> 16) & 1);
+    return static_cast<uint16_t>((bits + rounding) >> 16);
+  }
+
+  uint32_t sign = (bits >> 16) & 0x8000;
+  int exponent = static_cast<int>((bits >> 23) & 0xff);
+  uint32_t mantissa = bits & 0x7fffff;
+
+  if (exponent == 0xff) {
+    // Infinity or NaN.
+    return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+  }
+
+  int half_exponent = exponent - 127 + 15;
+  if (half_exponent >= 31) {
+    return static_cast<uint16_t>(sign | 0x7c00);
+  }
+
+  uint32_t half;
+  uint32_t remainder;
+  uint32_t halfway;
+  if (half_exponent <= 0) {
+    // Subnormal, or too small even for that.
+    if (half_exponent < -10) return static_cast<uint16_t>(sign);
+    mantissa |= 0x800000;
+    int shift = 14 - half_exponent;
+    half = sign | (mantissa >> shift);
+    remainder = mantissa & ((1u << shift) - 1);
+    halfway = 1u << (shift - 1);
+  } else {
+    half = sign | (static_cast<uint32_t>(half_exponent) << 10) |
+           (mantissa >> 13);
+    remainder = mantissa & 0x1fff;
+    halfway = 0x1000;
+  }
+
+  // A carry out of the mantissa correctly bumps the exponent, up to infinity.
+  if (remainder > halfway || (remainder == halfway && (half & 1))) {
+    ++half;
+  }
+  return static_cast<uint16_t>(half);
+}
+
+float half_to_float(uint16_t value, half_float_type type) {
+  uint32_t bits;
+
+  if (type == half_float_type::BFLOAT16) {
+    bits = static_cast<uint32_t>(value) << 16;
+  } else {
+    uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+
+    if (exponent == 0x1f) {
+      bits = sign | 0x7f800000 | (mantissa << 13);
+    } else if (exponent != 0) {
+      bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    } else if (mantissa == 0) {
+      bits = sign;
+    } else {
+      // Normalize the subnormal value.
+      exponent = 127 - 15 + 1;
+      while (!(mantissa & 0x400)) {
+        mantissa <<= 1;
+        --exponent;
+      }
+      bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+    }
+  }
+
+  float result;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+half_float_buffer::half_float_buffer(const float_array& source,
+                                     half_float_type type)
+  : type_(type),
+    shape_(source.shape(), source.shape() + source.dim()),
+    data_(source.size())
+{
+  const float* src = source.data();
+  for (size_t i = 0; i < data_.size(); ++i) {
+    data_[i] = float_to_half(src[i], type_);
+  }
+}
+
+half_float_buffer::half_float_buffer(const uint16_t* data,
+                                     std::vector<size_t> shape,
+                                     half_float_type type)
+  : type_(type),
+    shape_(std::move(shape)),
+    data_(data, data + std::accumulate(shape_.begin(), shape_.end(), 1u,
+                                       multiply))
+{}
+
+shared_float_array half_float_buffer::to_float() const {
+  if (shape_.empty()) {
+    return shared_float_array::wrap(value(0));
+  }
+  std::vector<float> values(data_.size());
+  for (size_t i = 0; i < data_.size(); ++i) {
+    values[i] = value(i);
+  }
+  return shared_float_array::wrap(std::move(values), shape_);
+}
+
 }  // namespace neural_net
 }  // namespace turi
@@ -8,9 +8,11 @@
 #define UNITY_TOOLKITS_NEURAL_NET_FLOAT_ARRAY_HPP_
 
 #include <cstddef>
+#include <cstdint>
 #include <future>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -179,6 +181,41 @@ private:
   size_t size_ = 0;
 };
 
+// Recycles the float vectors backing batches of data, so that producing a
+// batch of the same size as a previous one does not allocate (and fault in)
+// fresh memory. A vector acquired from the pool and wrapped by it returns to
+// the pool once the last shared_float_array viewing it is destroyed, even if
+// the pool itself is gone by then. Safe to use from several threads.
+class float_buffer_pool {
+public:
+  // Keeps at most `max_free_buffers` unused vectors; others are freed.
+  explicit float_buffer_pool(size_t max_free_buffers = 8);
+
+  // Returns a vector of `size` zeros, reusing the storage of a released
+  // vector when one is large enough.
+  std::vector<float> acquire(size_t size);
+
+  // Wraps `data`, which must have size consistent with the provided `shape`,
+  // returning its storage to the pool when no longer used.
+  shared_float_array wrap(std::vector<float> data, std::vector<size_t> shape);
+
+  // Returns the number of unused vectors held by the pool.
+  size_t num_free_buffers() const;
+
+private:
+  struct free_list {
+    mutable std::mutex mutex;
+    std::vector<std::vector<float>> buffers;
+    size_t max_buffers = 0;
+
+    void release(std::vector<float> buffer);
+  };
+
+  class pooled_float_buffer;
+
+  std::shared_ptr<free_list> free_list_;
+};
+
 // A float_array implementation that wraps a future shared_float_array.
 class deferred_float_array: public float_array {
 public:
@@ -204,6 +241,52 @@ private:
   size_t size_ = 0;
 };
 
+// 16-bit floating-point formats for half_float_buffer.
+enum class half_float_type {
+  FLOAT16,   // IEEE 754 binary16: 5 exponent bits, 10 mantissa bits.
+  BFLOAT16,  // The upper half of a float: 8 exponent bits, 7 mantissa bits.
+};
+
+// Converts a float to the given 16-bit format, rounding to the nearest value
+// (ties to even). FLOAT16 values too large to represent become infinite.
+uint16_t float_to_half(float value, half_float_type type);
+
+// Converts a value in the given 16-bit format to a float, exactly.
+float half_to_float(uint16_t value, half_float_type type);
+
+// An n-dimensional array stored in a 16-bit floating-point format, taking half
+// the memory of a float_buffer. Used to pass activations and weights to and
+// from backends that train in mixed precision. It is not a float_array, since
+// its values are not floats; to_float() widens it into one.
+class half_float_buffer {
+public:
+  // Rounds the values of a float_array to the given format.
+  half_float_buffer(const float_array& source, half_float_type type);
+
+  // Copies enough 16-bit values from `data` to fill the given `shape`.
+  half_float_buffer(const uint16_t* data, std::vector<size_t> shape,
+                    half_float_type type);
+
+  half_float_type type() const { return type_; }
+
+  const uint16_t* data() const { return data_.data(); }
+  size_t size() const { return data_.size(); }
+
+  const size_t* shape() const { return shape_.data(); }
+  size_t dim() const { return shape_.size(); }
+
+  // Returns the value at the given (flat) index, as a float.
+  float value(size_t idx) const { return half_to_float(data_[idx], type_); }
+
+  // Returns a float copy of this array.
+  shared_float_array to_float() const;
+
+private:
+  half_float_type type_;
+  std::vector<size_t> shape_;
+  std::vector<uint16_t> data_;
+};
+
 // Convenient typedef for data structure used to pass configuration and weights.
 using float_array_map = std::map<std::string, shared_float_array>;
 
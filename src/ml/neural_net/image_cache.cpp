@@ -0,0 +1,148 @@
+/* Copyright © 2019 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#include <ml/neural_net/image_cache.hpp>
+
+#include <sstream>
+#include <vector>
+
+#include <core/data/image/io.hpp>
+#include <core/logging/logger.hpp>
+#include <core/parallel/lambda_omp.hpp>
+#include <core/parallel/pthread_tools.hpp>
+#include <core/storage/fileio/fs_utils.hpp>
+#include <core/util/cityhash_tc.hpp>
+#include <model_server/lib/image_util.hpp>
+
+namespace turi {
+namespace neural_net {
+
+namespace {
+
+flex_image get_image(const flexible_type& image_feature) {
+  if (image_feature.get_type() == flex_type_enum::STRING) {
+    return read_image(image_feature, /* format_hint */ "");
+  } else {
+    return image_feature;
+  }
+}
+
+uint64_t image_hash(const flexible_type& image_feature) {
+  if (image_feature.get_type() == flex_type_enum::STRING) {
+    return hash64(image_feature.get<flex_string>());
+  }
+
+  const flex_image& image = image_feature.get<flex_image>();
+  uint64_t h = hash64(reinterpret_cast<const char*>(image.get_image_data()),
+                      image.m_image_data_size);
+  h = hash64_combine(h, hash64(image.m_width, image.m_height, image.m_channels));
+  return hash64_combine(h, static_cast<uint64_t>(image.m_format));
+}
+
+}  // namespace
+
+uint64_t image_column_hash(const gl_sarray& images) {
+  if (images.dtype() != flex_type_enum::IMAGE &&
+      images.dtype() != flex_type_enum::STRING) {
+    log_and_throw("Expected a column of images or of paths to images.");
+  }
+
+  const size_t num_rows = images.size();
+  std::vector<uint64_t> thread_hashes(thread::cpu_count(), 0);
+
+  // Combining the rows with xor lets each thread hash its own range.
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    size_t start_idx = num_rows * thread_idx / num_threads;
+    size_t end_idx = num_rows * (thread_idx + 1) / num_threads;
+
+    uint64_t h = 0;
+    size_t row = start_idx;
+    for (const flexible_type& v : images.range_iterator(start_idx, end_idx)) {
+      uint64_t row_hash = (v.get_type() == flex_type_enum::UNDEFINED)
+                          ? 0 : image_hash(v);
+      h ^= hash64(row, row_hash);
+      ++row;
+    }
+    thread_hashes[thread_idx] = h;
+  });
+
+  uint64_t result = hash64(num_rows);
+  for (uint64_t h : thread_hashes) {
+    result ^= h;
+  }
+  return result;
+}
+
+gl_sframe resize_images_for_cache(const gl_sarray& images, size_t width,
+                                  size_t height, size_t channels,
+                                  const std::string& cache_directory,
+                                  bool decode) {
+  if (width == 0 || height == 0 || channels == 0) {
+    log_and_throw("The size of the cached images must be positive.");
+  }
+
+  std::string cache_path;
+  if (!cache_directory.empty()) {
+    std::stringstream ss;
+    ss << cache_directory << "/resized_images_" << std::hex
+       << image_column_hash(images) << std::dec << "_" << width << "x"
+       << height << "x" << channels << (decode ? "_raw" : "_png");
+    cache_path = ss.str();
+
+    if (fileio::get_file_status(cache_path).first ==
+        fileio::file_status::DIRECTORY) {
+      gl_sframe cached(cache_path);
+      if (cached.size() == images.size()) {
+        logprogress_stream << "Using the resized images cached in "
+                           << cache_path << std::endl;
+        return cached;
+      }
+    }
+  } else if (images.dtype() != flex_type_enum::IMAGE &&
+             images.dtype() != flex_type_enum::STRING) {
+    log_and_throw("Expected a column of images or of paths to images.");
+  }
+
+  const size_t num_rows = images.size();
+  const size_t num_segments = thread::cpu_count();
+  gl_sframe_writer writer(
+      {"image", "original_width", "original_height"},
+      {flex_type_enum::IMAGE, flex_type_enum::INTEGER, flex_type_enum::INTEGER},
+      num_segments);
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    size_t start_idx = num_rows * thread_idx / num_threads;
+    size_t end_idx = num_rows * (thread_idx + 1) / num_threads;
+
+    std::vector<flexible_type> row(3);
+    for (const flexible_type& v : images.range_iterator(start_idx, end_idx)) {
+      if (v.get_type() == flex_type_enum::UNDEFINED) {
+        row[0] = FLEX_UNDEFINED;
+        row[1] = FLEX_UNDEFINED;
+        row[2] = FLEX_UNDEFINED;
+      } else {
+        flex_image image = get_image(v);
+        row[1] = image.m_width;
+        row[2] = image.m_height;
+        row[0] = image_util::resize_image(image, width, height, channels,
+                                          decode);
+      }
+      writer.write(row, thread_idx);
+    }
+  });
+
+  gl_sframe result = writer.close();
+
+  if (!cache_path.empty()) {
+    result.save(cache_path);
+    result = gl_sframe(cache_path);
+  }
+
+  return result;
+}
+
+}  // neural_net
+}  // turi
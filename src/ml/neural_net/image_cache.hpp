@@ -0,0 +1,52 @@
+/* Copyright © 2019 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#ifndef TURI_NEURAL_NET_IMAGE_CACHE_HPP_
+#define TURI_NEURAL_NET_IMAGE_CACHE_HPP_
+
+#include <cstdint>
+#include <string>
+
+#include <core/data/sframe/gl_sarray.hpp>
+#include <core/data/sframe/gl_sframe.hpp>
+
+namespace turi {
+namespace neural_net {
+
+/**
+ * Returns a hash of the contents of a column of images (or of paths to
+ * images), which changes whenever any image or the order of the rows does.
+ * For paths, only the path is hashed, not the file it names.
+ */
+uint64_t image_column_hash(const gl_sarray& images);
+
+/**
+ * Decodes and resizes every image of a column once, so that the training
+ * epochs can read the pixels directly instead of decoding the images again.
+ *
+ * Returns an SFrame with one row per image and the columns:
+ *
+ * - "image": the image resized to width x height x channels, and decoded
+ *   (raw uint8 pixels) unless decode is false, in which case it is encoded
+ *   as png, for consumers that must decode the images themselves.
+ * - "original_width", "original_height": the size of the image before
+ *   resizing, e.g. to interpret annotations in pixel coordinates.
+ *
+ * If cache_directory is not empty, the SFrame is saved there under the hash
+ * of the column and the size, and loaded back instead of being recomputed as
+ * long as neither changes.
+ *
+ * \param[in] images Column of images or of paths to images.
+ */
+gl_sframe resize_images_for_cache(const gl_sarray& images, size_t width,
+                                  size_t height, size_t channels,
+                                  const std::string& cache_directory = "",
+                                  bool decode = true);
+
+}  // neural_net
+}  // turi
+
+#endif  // TURI_NEURAL_NET_IMAGE_CACHE_HPP_
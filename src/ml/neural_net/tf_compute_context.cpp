@@ -21,6 +21,8 @@ namespace neural_net {
 
 using turi::neural_net::float_array;
 using turi::neural_net::float_array_map;
+using turi::neural_net::half_float_buffer;
+using turi::neural_net::half_float_type;
 using turi::neural_net::labeled_image;
 using turi::neural_net::shared_float_array;
 using turi::neural_net::float_array_image_augmenter;
@@ -46,19 +48,57 @@ static std::vector<size_t> get_shape(const float_array& num) {
   return std::vector<size_t>(num.shape(), num.shape() + num.dim());
 }
 
-static std::vector<size_t> get_strides(const float_array& num) {
-  if (num.dim() == 0) {
+static std::vector<size_t> get_strides(const size_t* shape, size_t dim,
+                                       size_t item_size) {
+  if (dim == 0) {
     return {};
   }
-  std::vector<size_t> result(num.dim());
-  const size_t* shape = num.shape();
-  result[num.dim() - 1] = sizeof(float);
-  for (size_t i = num.dim() - 1; i > 0; --i) {
+  std::vector<size_t> result(dim);
+  result[dim - 1] = item_size;
+  for (size_t i = dim - 1; i > 0; --i) {
     result[i - 1] = result[i] * shape[i];
   }
   return result;
 }
 
+static std::vector<size_t> get_strides(const float_array& num) {
+  return get_strides(num.shape(), num.dim(), sizeof(float));
+}
+
+// Copies a contiguous buffer returned by Python into a float array. Backends
+// training in mixed precision may return float16 (or float64) values, which
+// are converted to float.
+static shared_float_array copy_from_buffer(const pybind11::buffer_info& buf) {
+  std::vector<size_t> shape(buf.shape.begin(), buf.shape.end());
+
+  // Ignore the byte order prefix, if any; the buffer is in native order.
+  std::string format = buf.format;
+  if (!format.empty() && (format[0] == '<' || format[0] == '=' ||
+                          format[0] == '@')) {
+    format.erase(0, 1);
+  }
+
+  if (format == pybind11::format_descriptor<float>::format()) {
+    return shared_float_array::copy(static_cast<float*>(buf.ptr),
+                                    std::move(shape));
+  }
+
+  if (format == "e") {
+    return half_float_buffer(static_cast<uint16_t*>(buf.ptr), std::move(shape),
+                             half_float_type::FLOAT16).to_float();
+  }
+
+  if (format == pybind11::format_descriptor<double>::format()) {
+    const double* data = static_cast<double*>(buf.ptr);
+    std::vector<float> values(data, data + buf.size);
+    if (shape.empty()) return shared_float_array::wrap(values[0]);
+    return shared_float_array::wrap(std::move(values), std::move(shape));
+  }
+
+  log_and_throw("Unsupported buffer format returned by TensorFlow: " +
+                buf.format);
+}
+
 PYBIND11_MODULE(libtctensorflow, m) {
   pybind11::class_<float_array>(m, "FloatArray", pybind11::buffer_protocol())
       .def_buffer([](float_array& m) -> pybind11::buffer_info {
@@ -85,6 +125,22 @@ PYBIND11_MODULE(libtctensorflow, m) {
 
         );
       });
+  pybind11::class_<half_float_buffer>(m, "HalfFloatArray",
+                                      pybind11::buffer_protocol())
+      .def_buffer([](half_float_buffer& m) -> pybind11::buffer_info {
+        // numpy has no bfloat16 type; such arrays come out as their raw
+        // uint16 bits, for the model to bitcast.
+        bool is_float16 = (m.type() == half_float_type::FLOAT16);
+        return pybind11::buffer_info(
+            const_cast<uint16_t*>(m.data()), /* Pointer to buffer */
+            sizeof(uint16_t),                /* Size of one scalar */
+            is_float16 ? std::string("e")
+                       : pybind11::format_descriptor<uint16_t>::format(),
+            m.dim(),              /* Number of dimensions */
+            std::vector<size_t>(m.shape(), m.shape() + m.dim()),
+            get_strides(m.shape(), m.dim(), sizeof(uint16_t))
+        );
+      });
 }
 
 
@@ -117,12 +173,7 @@ float_array_map tf_model_backend::train(const float_array_map& inputs) {
         output.cast<std::map<std::string, pybind11::buffer>>();
 
     for (auto& kv : buf_output) {
-      pybind11::buffer_info buf = kv.second.request();
-      turi::neural_net::shared_float_array value =
-          turi::neural_net::shared_float_array::copy(
-              static_cast<float*>(buf.ptr),
-              std::vector<size_t>(buf.shape.begin(), buf.shape.end()));
-      result[kv.first] = value;
+      result[kv.first] = copy_from_buffer(kv.second.request());
     }
   });
 
@@ -139,12 +190,7 @@ float_array_map tf_model_backend::predict(const float_array_map& inputs) const {
         output.cast<std::map<std::string, pybind11::buffer>>();
 
     for (auto& kv : buf_output) {
-      pybind11::buffer_info buf = kv.second.request();
-      turi::neural_net::shared_float_array value =
-          turi::neural_net::shared_float_array::copy(
-              static_cast<float*>(buf.ptr),
-              std::vector<size_t>(buf.shape.begin(), buf.shape.end()));
-      result[kv.first] = value;
+      result[kv.first] = copy_from_buffer(kv.second.request());
     }
   });
 
@@ -160,12 +206,7 @@ float_array_map tf_model_backend::export_weights() const {
         exported_weights.cast<std::map<std::string, pybind11::buffer>>();
 
     for (auto& kv : buf_output) {
-      pybind11::buffer_info buf = kv.second.request();
-      turi::neural_net::shared_float_array value =
-          turi::neural_net::shared_float_array::copy(
-              static_cast<float*>(buf.ptr),
-              std::vector<size_t>(buf.shape.begin(), buf.shape.end()));
-      result[kv.first] = value;
+      result[kv.first] = copy_from_buffer(kv.second.request());
     }
   });
 
@@ -222,20 +263,14 @@ tf_image_augmenter::prepare_augmented_images(
         augmented_data
             .cast<std::pair<pybind11::buffer, std::vector<pybind11::buffer>>>();
 
-    pybind11::buffer_info buf_img = std::get<0>(aug_data).request();
-    image_annotations.images = turi::neural_net::shared_float_array::copy(
-        static_cast<float*>(buf_img.ptr),
-        std::vector<size_t>(buf_img.shape.begin(), buf_img.shape.end()));
+    image_annotations.images =
+        copy_from_buffer(std::get<0>(aug_data).request());
     std::vector<turi::neural_net::shared_float_array> annotations_per_batch;
     std::vector<pybind11::buffer> aug_annotations = std::get<1>(aug_data);
 
     for (size_t i = 0; i < aug_annotations.size(); i++) {
-      pybind11::buffer_info buf_ann = aug_annotations[i].request();
-      turi::neural_net::shared_float_array annotate =
-          turi::neural_net::shared_float_array::copy(
-              static_cast<float*>(buf_ann.ptr),
-              std::vector<size_t>(buf_ann.shape.begin(), buf_ann.shape.end()));
-      annotations_per_batch.push_back(annotate);
+      annotations_per_batch.push_back(
+          copy_from_buffer(aug_annotations[i].request()));
     }
     image_annotations.annotations = annotations_per_batch;
   });
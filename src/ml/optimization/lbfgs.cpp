@@ -1,9 +1,82 @@
 #include <ml/optimization/lbfgs.hpp>
 #include <core/logging/table_printer/table_printer.hpp>
+#include <core/parallel/lambda_omp.hpp>
+#include <core/parallel/pthread_tools.hpp>
+#include <core/globals/globals.hpp>
+#include <core/logging/trace_events.hpp>
+#include <numeric>
+#include <type_traits>
 
 namespace turi {
 namespace optimization {
 
+size_t LBFGS_FLOAT32_HISTORY = 0;
+size_t LBFGS_PARALLEL_VECTOR_OPS_MIN_SIZE = 256*1024;
+
+REGISTER_GLOBAL(int64_t, LBFGS_FLOAT32_HISTORY, true);
+REGISTER_GLOBAL(int64_t, LBFGS_PARALLEL_VECTOR_OPS_MIN_SIZE, true);
+
+////////////////////////////////////////////////////////////////////////////////
+// Vector operations over the history, split across threads for large
+// problems.  The history may be held in single precision; the
+// arithmetic is always done in double.
+
+namespace {
+
+template <typename RangeFunction>
+void for_each_range(size_t n, RangeFunction&& fn) {
+  if (n < LBFGS_PARALLEL_VECTOR_OPS_MIN_SIZE) {
+    fn(0, 0, n);
+    return;
+  }
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    size_t start = (thread_idx * n) / num_threads;
+    size_t end = ((thread_idx + 1) * n) / num_threads;
+    fn(thread_idx, start, end - start);
+  });
+}
+
+template <typename A, typename B>
+double parallel_dot(const A& a, const B& b) {
+  DASSERT_EQ(a.size(), b.size());
+
+  std::vector<double> partial_sums(thread::cpu_count(), 0);
+
+  for_each_range(a.size(), [&](size_t thread_idx, size_t start, size_t n) {
+    partial_sums[thread_idx] = a.segment(start, n).template cast<double>().dot(
+        b.segment(start, n).template cast<double>());
+  });
+
+  return std::accumulate(partial_sums.begin(), partial_sums.end(), 0.0);
+}
+
+// y += alpha * x
+template <typename X, typename Y>
+void parallel_axpy(double alpha, const X& x, Y&& y) {
+  DASSERT_EQ(x.size(), y.size());
+  typedef typename std::decay<Y>::type::Scalar Scalar;
+
+  for_each_range(x.size(), [&](size_t, size_t start, size_t n) {
+    y.segment(start, n) = (y.segment(start, n).template cast<double>()
+                           + alpha * x.segment(start, n).template cast<double>())
+                              .template cast<Scalar>();
+  });
+}
+
+// y = x
+template <typename X, typename Y>
+void parallel_assign(const X& x, Y&& y) {
+  DASSERT_EQ(x.size(), y.size());
+  typedef typename std::decay<Y>::type::Scalar Scalar;
+
+  for_each_range(x.size(), [&](size_t, size_t start, size_t n) {
+    y.segment(start, n) = x.segment(start, n).template cast<Scalar>();
+  });
+}
+
+}  // namespace
+
 // This version is provided to ease the transition between the non-iterative
 // solver (which includes significant printing stuff) and the iterative solver.
 solver_return lbfgs_compat(
@@ -147,15 +220,34 @@ void lbfgs_solver::setup(
   convergence_threshold = get_param("convergence_threshold");
   m_status.step_size = 1.0;
 
+  float32_history = (opts.count("lbfgs_float32_history")
+                     ? bool(opts.at("lbfgs_float32_history"))
+                     : (LBFGS_FLOAT32_HISTORY != 0));
+
   num_variables = model->num_variables();  // Dimension of point
   DASSERT_EQ(num_variables, init_point.size());
 
-  // Set up the internal parts of the LBFGS information.
-  y.resize(num_variables, lbfgs_memory_level);
-  y.setZero();
+  // Set up the internal parts of the LBFGS information.  Only one of the
+  // two precisions is kept.
+  if (float32_history) {
+    y.resize(0, 0);
+    s.resize(0, 0);
 
-  s.resize(num_variables, lbfgs_memory_level);
-  s.setZero();
+    y_f.resize(num_variables, lbfgs_memory_level);
+    y_f.setZero();
+
+    s_f.resize(num_variables, lbfgs_memory_level);
+    s_f.setZero();
+  } else {
+    y_f.resize(0, 0);
+    s_f.resize(0, 0);
+
+    y.resize(num_variables, lbfgs_memory_level);
+    y.setZero();
+
+    s.resize(num_variables, lbfgs_memory_level);
+    s.setZero();
+  }
 
   q.resize(num_variables);
   q.setZero();
@@ -185,6 +277,7 @@ void lbfgs_solver::setup(
 /////////////////////////////////////////////////////////////////////////////////
 
 bool lbfgs_solver::next_iteration() {
+  trace::scoped_span span("lbfgs", "iteration");
   compute_timer.start();
 
   // Set up some convenience notations to make the expressions below more
@@ -214,8 +307,11 @@ bool lbfgs_solver::next_iteration() {
 RECOMPUTE_AT_NEW_POINT:;
   // Computing the gradient and value of the current point.  These get scaled
   // for use in our problem.
-  model->compute_first_order_statistics(point, m_status.gradient,
-                                        m_status.function_value);
+  {
+    trace::scoped_span gradient_span("lbfgs", "compute_first_order_statistics");
+    model->compute_first_order_statistics(point, m_status.gradient,
+                                          m_status.function_value);
+  }
   ++m_status.num_function_evaluations;
   ++m_status.num_gradient_evaluations;
 
@@ -352,43 +448,12 @@ RECOMPUTE_AT_NEW_POINT:;
   } else {
     size_t store_point = (current_iteration - 1) % m;
 
-    // Store the gradient differences, step difference and rho for the next
-    // iteration.
-    s.col(store_point) = delta_point;
-    y.col(store_point) = gradient - previous_gradient;
-    rho(store_point) = 1.0 / (delta_point.dot(y.col(store_point)));
-
-    // Two loop recursion to compute the direction
-    // Algorithm 7.4 of Reference [1]
-
-    q = gradient;
-
-    /**
-     *  Data is stored in a cyclic format using the following indexiing:
-     *
-     *   Iteration              Storage location
-     *  *****************************************************
-     *     iter-1               store_point
-     *     iter-2               (store_point + 1) % m
-     *      ...                  ...
-     *     iter-m               (store_point + m - 1) % m
-     *
-     **/
-
-    for (size_t j = 0; j < std::min(current_iteration, m); ++j) {
-      size_t i = (store_point + m - j) % m;
-      alpha(i) = rho(i) * s.col(i).dot(q);
-      q -= alpha(i) * y.col(i);
-    }
-
-    // Scaling factor according to Pg 178 of [1]. This ensures that the
-    // problem is better scaled and that a step size of 1 is mostly accepted.
-    q *= 1.0 / (y.col(store_point).squaredNorm() * rho(store_point));
-
-    for (size_t j = std::min(current_iteration, m); (j--) > 0;) {
-      size_t i = (store_point + m - j) % m;
-      double beta = rho(i) * y.col(i).dot(q);
-      q += s.col(i) * (alpha(i) - beta);
+    if (float32_history) {
+      update_history_and_direction(s_f, y_f, store_point,
+                                   std::min(current_iteration, m));
+    } else {
+      update_history_and_direction(s, y, store_point,
+                                   std::min(current_iteration, m));
     }
 
     // Check if we need to retune the step size.  Doing this is a bit
@@ -460,5 +525,54 @@ RECOMPUTE_AT_NEW_POINT:;
   return false;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename HistoryMatrix>
+void lbfgs_solver::update_history_and_direction(
+    HistoryMatrix& s, HistoryMatrix& y, size_t store_point, size_t n_history) {
+
+  const size_t m = lbfgs_memory_level;
+
+  // Store the gradient differences, step difference and rho for the next
+  // iteration.  rho is computed from the stored values, so that it is
+  // consistent with them when the history is in single precision.
+  parallel_assign(delta_point, s.col(store_point));
+  parallel_assign(gradient - previous_gradient, y.col(store_point));
+  rho(store_point) = 1.0 / parallel_dot(s.col(store_point), y.col(store_point));
+
+  // Two loop recursion to compute the direction
+  // Algorithm 7.4 of Reference [1]
+
+  q = gradient;
+
+  /**
+   *  Data is stored in a cyclic format using the following indexiing:
+   *
+   *   Iteration              Storage location
+   *  *****************************************************
+   *     iter-1               store_point
+   *     iter-2               (store_point + 1) % m
+   *      ...                  ...
+   *     iter-m               (store_point + m - 1) % m
+   *
+   **/
+
+  for (size_t j = 0; j < n_history; ++j) {
+    size_t i = (store_point + m - j) % m;
+    alpha(i) = rho(i) * parallel_dot(s.col(i), q);
+    parallel_axpy(-alpha(i), y.col(i), q);
+  }
+
+  // Scaling factor according to Pg 178 of [1]. This ensures that the
+  // problem is better scaled and that a step size of 1 is mostly accepted.
+  q *= 1.0 / (parallel_dot(y.col(store_point), y.col(store_point)) * rho(store_point));
+
+  for (size_t j = n_history; (j--) > 0;) {
+    size_t i = (store_point + m - j) % m;
+    double beta = rho(i) * parallel_dot(y.col(i), q);
+    parallel_axpy(alpha(i) - beta, s.col(i), q);
+  }
+}
+
 }  // namespace optimization
 }  // namespace turi
@@ -23,6 +23,20 @@ namespace turi {
 
 namespace optimization {
 
+/**
+ * If nonzero, the L-BFGS history (the last lbfgs_memory_level steps and
+ * gradient differences) is stored in single precision, halving the
+ * largest allocation of the solver on models with many variables.  The
+ * solver option "lbfgs_float32_history" overrides this.
+ */
+extern size_t LBFGS_FLOAT32_HISTORY;
+
+/**
+ * The number of variables above which the vector operations over the
+ * L-BFGS history are split across threads.
+ */
+extern size_t LBFGS_PARALLEL_VECTOR_OPS_MIN_SIZE;
+
 /**
  * Solver status.
  */
@@ -103,9 +117,11 @@ class lbfgs_solver {
   /** Sets up (or resets) the solver.
    *
    * \param[in] init_point Starting point for the solver.
-   * \param[in]     opts   Solver options.  Options are "lbfgs_memory_level" and
-   *                       "convergence_threshold".  If not given, defaults are
-   *                       taken from the table in optimization_interface.hpp.
+   * \param[in]     opts   Solver options.  Options are "lbfgs_memory_level",
+   *                       "convergence_threshold" and "lbfgs_float32_history".
+   *                       If not given, defaults are taken from the table in
+   *                       optimization_interface.hpp (and from
+   *                       LBFGS_FLOAT32_HISTORY for the last).
    *
    * \param[in]      reg   Shared ptr to an interface to a smooth regularizer.
    */
@@ -145,13 +161,17 @@ class lbfgs_solver {
 
   // LBFGS storage
   // The search steps and gradient differences are stored in a order
-  // controlled by the start point.
+  // controlled by the start point.  Only one of the double and the
+  // float versions is allocated, depending on lbfgs_float32_history.
+  bool float32_history = false;
 
   // Step difference (prev m iters)
   Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor> y;
+  Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor> y_f;
 
   // Gradient difference (prev m iters)
   Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor> s;
+  Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor> s_f;
 
   DenseVector q;         // Storage required for the 2-loop recursion
   DenseVector rho;       // Scaling factors (prev m iters)
@@ -162,6 +182,13 @@ class lbfgs_solver {
   DenseVector delta_point, gradient, delta_grad, previous_gradient;
 
   double convergence_threshold = 0;
+
+  /** Stores the latest step and gradient difference in the history, then
+   *  computes the search direction into q with the two loop recursion.
+   */
+  template <typename HistoryMatrix>
+  void update_history_and_direction(HistoryMatrix& s, HistoryMatrix& y,
+                                    size_t store_point, size_t n_history);
 };
 
 // Old version for backwards compatibility with the previous interface.
@@ -202,6 +202,208 @@ inline solver_return newton_method(second_order_opt_interface& model,
 }
 
 
+/**
+ *
+ * Solve a second_order_optimization_interface model with a truncated Newton
+ * (Newton-CG) method.
+ *
+ * Each Newton step is found by running conjugate gradient on the Newton
+ * system, using only hessian-vector products from the model
+ * (compute_hessian_vector_product), and is stopped early once the residual
+ * is small relative to the gradient.  The hessian is never formed, so the
+ * memory used is linear in the number of variables; the step is then
+ * scaled by a More-Thuente line search.
+ *
+ * References:
+ *
+ * (1) Wright S.J  and J. Nocedal. Numerical optimization. Vol. 2.
+ *                         New York: Springer, 1999. (Algorithm 7.1)
+ *
+ * \param[in,out] model  Model with second order optimization interface.
+ * \param[in] init_point Starting point for the solver.
+ * \param[in,out] opts   Solver options.  Uses "max_iterations",
+ *                       "convergence_threshold", and optionally
+ *                       "newton_cg_max_iterations", the limit on the
+ *                       conjugate gradient iterations per step.
+ * \param[in]      reg   Shared ptr to an interface to a smooth regularizer.
+ * \param[out] stats     Solver return stats.  No hessian is returned.
+ *
+*/
+inline solver_return newton_cg_method(second_order_opt_interface& model,
+    const DenseVector& init_point,
+    std::map<std::string, flexible_type>& opts,
+    const std::shared_ptr<smooth_regularizer_interface> reg=NULL){
+
+    // Benchmarking utils.
+    timer t;
+    double start_time = t.current_time();
+    solver_return stats;
+
+    logprogress_stream << "Starting Newton-CG Method " << std::endl;
+    logprogress_stream << "--------------------------------------------------------" << std::endl;
+
+    // Step 1: Algorithm option init
+    // ------------------------------------------------------------------------
+    size_t iter_limit = opts["max_iterations"];
+    double convergence_threshold = opts["convergence_threshold"];
+    size_t cg_iter_limit = (opts.count("newton_cg_max_iterations")
+                            ? size_t(opts["newton_cg_max_iterations"])
+                            : std::min<size_t>(init_point.size(), 100));
+    size_t iters = 0;
+
+    table_printer printer(model.get_status_header(
+                        {"Iteration", "Passes", "Step size", "Elapsed Time"}));
+    printer.print_header();
+
+    const size_t n = init_point.size();
+    DenseVector point = init_point;
+    DenseVector gradient(n), reg_gradient(n);
+    DenseVector direction(n), residual_vec(n), cg_direction(n), hv(n);
+    DiagonalMatrix reg_hessian(n);
+    double func_value = 0;
+    double step_size = 1;
+
+    // The objective (with the regularizer) and its gradient at the point.
+    auto compute_objective = [&]() {
+      model.compute_first_order_statistics(point, gradient, func_value);
+      stats.num_passes++;
+      double reg_func_value = 0;
+      if (reg != NULL){
+        reg->compute_gradient(point, reg_gradient);
+        gradient += reg_gradient;
+        reg_func_value = reg->compute_function_value(point);
+      }
+      return func_value + reg_func_value;
+    };
+
+    double objective = compute_objective();
+    double residual = compute_residual(gradient);
+
+    // Nan Checking!
+    if (!std::isfinite(residual)){
+      stats.status = OPTIMIZATION_STATUS::OPT_NUMERIC_OVERFLOW;
+    }
+
+    // Step 2: Algorithm starts here
+    // ------------------------------------------------------------------------
+    while(stats.status == OPTIMIZATION_STATUS::OPT_UNSET
+          && (residual >= convergence_threshold) && (iters < iter_limit)){
+
+      if (reg != NULL){
+        reg->compute_hessian(point, reg_hessian);
+      }
+
+      // Conjugate gradient on H * direction = -gradient, starting from zero,
+      // and stopped once the residual is below a forcing term that shrinks
+      // with the gradient.
+      double gradient_norm = gradient.norm();
+      double cg_tolerance = std::min(0.5, std::sqrt(gradient_norm)) * gradient_norm;
+
+      direction.setZero();
+      residual_vec = -gradient;
+      cg_direction = residual_vec;
+      double rr = residual_vec.squaredNorm();
+
+      for (size_t cg_iter = 0; cg_iter < cg_iter_limit; ++cg_iter) {
+        model.compute_hessian_vector_product(point, cg_direction, hv);
+        stats.num_passes++;
+        if (reg != NULL){
+          hv += reg_hessian * cg_direction;
+        }
+
+        double curvature = cg_direction.dot(hv);
+
+        // Negative curvature; stop with what we have, or with the steepest
+        // descent direction if that is nothing.
+        if (curvature <= 0) {
+          if (cg_iter == 0) direction = -gradient;
+          break;
+        }
+
+        double alpha = rr / curvature;
+        direction += alpha * cg_direction;
+        residual_vec -= alpha * hv;
+
+        double rr_new = residual_vec.squaredNorm();
+        if (std::sqrt(rr_new) <= cg_tolerance) {
+          break;
+        }
+
+        cg_direction = residual_vec + (rr_new / rr) * cg_direction;
+        rr = rr_new;
+      }
+
+      // Line search along the Newton-CG direction, starting at the full step.
+      ls_return ls_stats = more_thuente(model, 1.0, objective, point,
+                                        gradient, direction, 1.0, reg);
+      stats.num_passes += ls_stats.func_evals;
+
+      if (ls_stats.status == false) {
+        stats.status = OPTIMIZATION_STATUS::OPT_LS_FAILURE;
+        break;
+      }
+      step_size = ls_stats.step_size;
+
+      direction *= step_size;
+
+      // Numerical overflow. (Step size was too large)
+      if (!direction.array().isFinite().all()) {
+        stats.status = OPTIMIZATION_STATUS::OPT_NUMERIC_OVERFLOW;
+        break;
+      }
+
+      point += direction;
+      objective = compute_objective();
+      residual = compute_residual(gradient);
+      iters++;
+
+      // Log info for debugging.
+      logstream(LOG_INFO) << "Iters  (" << iters << ") "
+                          << "Passes (" << stats.num_passes << ") "
+                          << "Residual (" << residual << ") "
+                          << "Loss (" << func_value << ") "
+                          << std::endl;
+
+      // Check for nan's in the function value.
+      if(!std::isfinite(func_value)) {
+        stats.status = OPTIMIZATION_STATUS::OPT_NUMERIC_ERROR;
+        break;
+      }
+
+      // Print progress
+      auto stat_info = {std::to_string(iters),
+                        std::to_string(stats.num_passes),
+                        std::to_string(step_size),
+                        std::to_string(t.current_time())};
+      auto row = model.get_status(point, stat_info);
+      printer.print_progress_row_strs(iters, row);
+    }
+    printer.print_footer();
+
+    // Step 3: Return optimization model status.
+    // ------------------------------------------------------------------------
+    if (stats.status == OPTIMIZATION_STATUS::OPT_UNSET) {
+      if (iters < iter_limit){
+        stats.status = OPTIMIZATION_STATUS::OPT_OPTIMAL;
+      } else {
+        stats.status = OPTIMIZATION_STATUS::OPT_ITERATION_LIMIT;
+      }
+    }
+    stats.iters = iters;
+    stats.residual = residual;
+    stats.func_value = func_value;
+    stats.solve_time = t.current_time() - start_time;
+    stats.solution = point;
+    stats.gradient = gradient;
+    stats.progress_table = printer.get_tracked_table();
+
+    // Display solver stats
+    log_solver_summary_stats(stats);
+
+    return stats;
+}
+
+
 } // optimizaiton
 
 /// \}
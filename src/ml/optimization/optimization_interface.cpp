@@ -4,6 +4,8 @@
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
 #include <ml/optimization/optimization_interface.hpp>
+#include <cmath>
+#include <limits>
 
 namespace turi {
 
@@ -111,6 +113,37 @@ void second_order_opt_interface::compute_hessian(
     compute_second_order_statistics(point, hessian, gradient, func);
 }
 
+/**
+ *
+ * Default implementation of compute_hessian_vector_product.
+ *
+ * \note Takes a central difference of the gradient along the direction.
+ *
+ * \warning Not efficient, and not exact. Requires an overwrite by the model
+ * writer.
+ */
+void second_order_opt_interface::compute_hessian_vector_product(
+    const DenseVector& point, const DenseVector& direction,
+    DenseVector& product) {
+
+  double direction_norm = direction.norm();
+  product.resize(point.size());
+  if (direction_norm == 0) {
+    product.setZero();
+    return;
+  }
+
+  double h = std::sqrt(std::numeric_limits<double>::epsilon())
+             * (1 + point.norm()) / direction_norm;
+
+  DenseVector gradient_plus(point.size()), gradient_minus(point.size());
+  double func = 0.0;
+  compute_first_order_statistics(point + h * direction, gradient_plus, func);
+  compute_first_order_statistics(point - h * direction, gradient_minus, func);
+
+  product = (gradient_plus - gradient_minus) / (2 * h);
+}
+
 
 } // optimization
 
@@ -290,6 +290,24 @@ class second_order_opt_interface: public first_order_opt_interface {
    */
   virtual void compute_hessian(const DenseVector& point, DenseMatrix& hessian);
 
+  /**
+   *
+   * Compute the product of the hessian at the given point with a direction,
+   * without forming the hessian.  Used by the truncated Newton
+   * (Newton-CG) solver.
+   *
+   * \param[in]  point      Point at which the hessian is taken.
+   * \param[in]  direction  Vector to multiply the hessian with.
+   * \param[out] product    Hessian times direction.
+   *
+   * \warning The default implementation takes a central difference of two
+   * gradients, each a pass over the data.  Models should override it with
+   * an exact product.
+   *
+   */
+  virtual void compute_hessian_vector_product(const DenseVector& point,
+      const DenseVector& direction, DenseVector& product);
+
 
 };
 
@@ -5,11 +5,17 @@
  */
 #ifndef TURI_SKETCH_HYPERLOGLOG_HPP
 #define TURI_SKETCH_HYPERLOGLOG_HPP
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <functional>
+#include <limits>
+#include <string>
+#include <vector>
 #include <core/util/cityhash_tc.hpp>
 #include <core/logging/assertions.hpp>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/storage/serialization/serialization_includes.hpp>
 namespace turi {
 namespace sketches {
 /**
@@ -22,12 +28,26 @@ namespace sketches {
  *   HyperLogLog: the analysis of a near-optimal cardinality
  *   estimation algorithm. Conference on Analysis of Algorithms (AofA) 2007.
  *
- * with further reference from:
+ * with the HLL++ refinements of:
  *   Stefan Heule, Marc Nunkesser and Alexander Hall.
  *   HyperLogLog in Practice: Algorithmic Engineering of a State of The
  *   Art Cardinality Estimation Algorithm.
  *   Proceedings of the EDBT 2013 Conference.
  *
+ * and the bias corrected estimator of:
+ *   Otmar Ertl. New cardinality estimation algorithms for HyperLogLog
+ *   sketches. arXiv:1702.01284, 2017.
+ *
+ * A new sketch is sparse: it keeps a sorted list of (index, rank) pairs at
+ * a precision of 2^25 buckets, so a sketch of a few elements only takes a
+ * few bytes, and small cardinalities are estimated almost exactly. Once the
+ * list would take more memory than the dense registers, the sketch turns
+ * dense: 2^b registers of 6 bits, packed ten to a 64-bit word. Dense
+ * sketches are merged a word at a time, taking the register-wise maximum
+ * of ten registers with a few integer operations.
+ *
+ * The estimate corrects the bias of the raw estimator over the whole range
+ * of cardinalities, without the empirical tables of HLL++.
  *
  * Usage is simple.
  * \code
@@ -41,35 +61,37 @@ namespace sketches {
  */
 class hyperloglog {
  private:
+  static constexpr size_t SPARSE_PRECISION = 25;
+  static constexpr size_t REGISTER_BITS = 6;
+  static constexpr size_t REGISTERS_PER_WORD = 10;
+  static constexpr uint64_t REGISTER_MASK = 63;
+  static constexpr uint64_t REGISTER_HIGH_BITS = 0x0820820820820820ULL;
+
   size_t m_b = 0; /// 2^b is the number of hash bins
   size_t m_m = 0; /// equal to 2^b: The number of buckets
-  double m_alpha = 0;
-  std::vector<unsigned char> m_buckets; /// Buckets
+  bool m_sparse = true;
+
+  /// Sparse entries, (index << 6) | rank at SPARSE_PRECISION, sorted, one
+  /// per index. The buffer holds the entries added since the last merge.
+  /// Merging the buffer does not change the value of the sketch, so it is
+  /// also done on const sketches.
+  mutable std::vector<uint32_t> m_sparse_list;
+  mutable std::vector<uint32_t> m_sparse_buffer;
+
+  /// Dense registers, REGISTERS_PER_WORD to a word
+  std::vector<uint64_t> m_registers;
 
  public:
   /**
    * Constructs a hyperloglog sketch using 2^b buckets.
-   * The resultant hyperloglog datastructure will require
-   * 2^b bytes of memory. b must be at least 4. (i.e. 2^4 buckets).
+   * The resultant hyperloglog datastructure will require at most
+   * 0.8 * 2^b bytes of memory. b must be between 4 and 25.
    */
   explicit inline hyperloglog(size_t b = 16):
-      m_b(b), m_m(1 << b), m_buckets(m_m, 0) {
-     ASSERT_GE(m_m, 16);
-      // constants from SFlajolet et al. Fig 3
-     switch(m_m) {
-      case 16:
-       m_alpha = 0.673;
-       break;
-      case 32:
-       m_alpha = 0.697;
-       break;
-      case 64:
-       m_alpha = 0.709;
-       break;
-      default:
-       m_alpha = 0.7213 / (1 + 1.079 / (double)m_m);
-     }
-   };
+      m_b(b), m_m(size_t(1) << b) {
+    ASSERT_GE(m_b, 4);
+    ASSERT_LE(m_b, SPARSE_PRECISION);
+  }
 
   /**
    * Adds an arbitrary object to be counted. Any object type can be used,
@@ -82,11 +104,39 @@ class hyperloglog {
     // Then cityhash's hash64 twice to distribute the hash.
     // empirically, one hash64 does not produce enough scattering to
     // get a good estimate
-    size_t h = hash64(hash64(std::hash<T>()(t)));
-    size_t index = h >> (64 - m_b);
-    DASSERT_LT(index, m_buckets.size());
-    unsigned char pos = h != 0 ? 1 + __builtin_clz(h) : sizeof(size_t);
-    m_buckets[index] = std::max(m_buckets[index], pos);
+    add_hash(hash64(hash64(std::hash<T>()(t))));
+  }
+
+  /**
+   * Adds a flexible_type value, hashing it once with its own hash.
+   */
+  void add(const flexible_type& t) {
+    add_hash(mix(t.hash()));
+  }
+
+  /**
+   * Adds a string, hashing its characters directly.
+   */
+  void add(const std::string& t) {
+    add_hash(mix(hash64(t.data(), t.size())));
+  }
+
+  /**
+   * Adds an element by its 64-bit hash. The bits of the hash must be
+   * uniformly distributed.
+   */
+  void add_hash(uint64_t h) {
+    if (m_sparse) {
+      m_sparse_buffer.push_back(sparse_entry(h));
+      if (m_sparse_buffer.size() >= sparse_buffer_size()) {
+        merge_sparse();
+        if (m_sparse_list.size() > max_sparse_entries()) to_dense();
+      }
+    } else {
+      uint64_t w = h << m_b;
+      size_t rank = (w != 0) ? __builtin_clzll(w) + 1 : 64 - m_b + 1;
+      update_register(h >> (64 - m_b), rank);
+    }
   }
 
   /**
@@ -97,38 +147,229 @@ class hyperloglog {
    * data streams.
    */
   void combine(const hyperloglog& other) {
-    ASSERT_EQ(m_buckets.size(), other.m_buckets.size());
-    for (size_t i = 0;i < m_buckets.size(); ++i) {
-      m_buckets[i] = std::max(m_buckets[i], other.m_buckets[i]);
+    ASSERT_EQ(m_m, other.m_m);
+    if (other.m_sparse) {
+      if (m_sparse) {
+        m_sparse_buffer.insert(m_sparse_buffer.end(),
+                               other.m_sparse_list.begin(),
+                               other.m_sparse_list.end());
+        m_sparse_buffer.insert(m_sparse_buffer.end(),
+                               other.m_sparse_buffer.begin(),
+                               other.m_sparse_buffer.end());
+        merge_sparse();
+        if (m_sparse_list.size() > max_sparse_entries()) to_dense();
+      } else {
+        for (uint32_t e: other.m_sparse_list) add_sparse_entry(e);
+        for (uint32_t e: other.m_sparse_buffer) add_sparse_entry(e);
+      }
+      return;
     }
-  }
 
+    if (m_sparse) to_dense();
+
+    // Register-wise maximum, ten registers at a time. A register of a is
+    // at least the one of b if its top bit is set and b's is not, or if the
+    // top bits are equal and the borrow-free difference of the low bits
+    // keeps the top bit set.
+    uint64_t* a_ptr = m_registers.data();
+    const uint64_t* b_ptr = other.m_registers.data();
+    for (size_t i = 0; i < m_registers.size(); ++i) {
+      uint64_t a = a_ptr[i];
+      uint64_t b = b_ptr[i];
+      uint64_t low_ge = (a | REGISTER_HIGH_BITS) - (b & ~REGISTER_HIGH_BITS);
+      uint64_t ge = ((a & ~b) | (~(a ^ b) & low_ge)) & REGISTER_HIGH_BITS;
+      uint64_t mask = (ge >> (REGISTER_BITS - 1)) * REGISTER_MASK;
+      a_ptr[i] = (a & mask) | (b & ~mask);
+    }
+  }
 
   /**
    * Returns the standard error of the estimate.
    */
-  inline double error_bound() {
+  inline double error_bound() const {
     return estimate() * 1.04 / std::sqrt(m_m);
   }
 
   /**
    * Returns the estimate of the number of unique items.
    */
-  inline double estimate() {
-    double E = 0;
-    for (size_t i = 0;i < m_buckets.size(); ++i) {
-      E += std::pow(2.0, -(double)m_buckets[i]);
+  inline double estimate() const {
+    if (!m_sparse) return dense_estimate(m_registers);
+
+    merge_sparse();
+    if (m_sparse_list.size() > max_sparse_entries()) {
+      // The sketch would be dense if its buffer had been merged.
+      std::vector<uint64_t> registers(num_words(), 0);
+      for (uint32_t e: m_sparse_list) {
+        update_register(registers, dense_index(e), dense_rank(e));
+      }
+      return dense_estimate(registers);
+    }
+
+    // Linear counting over the sparse buckets.
+    double m = double(size_t(1) << SPARSE_PRECISION);
+    return m * std::log(m / (m - double(m_sparse_list.size())));
+  }
+
+  /**
+   * Returns true while the sketch still uses the sparse representation.
+   */
+  inline bool is_sparse() const {
+    return m_sparse;
+  }
+
+  /// Serializer
+  void save(oarchive& oarc) const {
+    merge_sparse();
+    oarc << m_b << m_sparse << m_sparse_list << m_registers;
+  }
+
+  /// Deserializer
+  void load(iarchive& iarc) {
+    iarc >> m_b >> m_sparse >> m_sparse_list >> m_registers;
+    m_m = size_t(1) << m_b;
+    m_sparse_buffer.clear();
+  }
+
+ private:
+  /// Murmur3's 64-bit finalizer.
+  static inline uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  inline size_t num_words() const {
+    return (m_m + REGISTERS_PER_WORD - 1) / REGISTERS_PER_WORD;
+  }
+
+  /// The sparse list is kept while it is smaller than the dense registers.
+  inline size_t max_sparse_entries() const {
+    return num_words() * sizeof(uint64_t) / sizeof(uint32_t);
+  }
+
+  inline size_t sparse_buffer_size() const {
+    return std::max<size_t>(16, max_sparse_entries() / 4);
+  }
+
+  static inline uint32_t sparse_entry(uint64_t h) {
+    uint64_t w = h << SPARSE_PRECISION;
+    uint32_t rank = (w != 0) ? __builtin_clzll(w) + 1
+                             : 64 - SPARSE_PRECISION + 1;
+    return uint32_t(h >> (64 - SPARSE_PRECISION)) << REGISTER_BITS | rank;
+  }
+
+  inline size_t dense_index(uint32_t e) const {
+    return (e >> REGISTER_BITS) >> (SPARSE_PRECISION - m_b);
+  }
+
+  /// The rank at precision b of a sparse entry: from the bits of the sparse
+  /// index below the dense index if any is set, from the sparse rank
+  /// otherwise.
+  inline size_t dense_rank(uint32_t e) const {
+    size_t extra_bits = SPARSE_PRECISION - m_b;
+    uint64_t low = (e >> REGISTER_BITS) & ((uint64_t(1) << extra_bits) - 1);
+    if (low != 0) {
+      return extra_bits - (64 - __builtin_clzll(low)) + 1;
+    }
+    return (e & REGISTER_MASK) + extra_bits;
+  }
+
+  static inline void update_register(std::vector<uint64_t>& registers,
+                                     size_t i, uint64_t rank) {
+    uint64_t& word = registers[i / REGISTERS_PER_WORD];
+    size_t shift = (i % REGISTERS_PER_WORD) * REGISTER_BITS;
+    uint64_t current = (word >> shift) & REGISTER_MASK;
+    if (rank > current) word += (rank - current) << shift;
+  }
+
+  inline void update_register(size_t i, uint64_t rank) {
+    DASSERT_LT(i, m_m);
+    update_register(m_registers, i, rank);
+  }
+
+  inline void add_sparse_entry(uint32_t e) {
+    update_register(dense_index(e), dense_rank(e));
+  }
+
+  /// Sorts the buffer into the list, keeping the largest rank per index.
+  void merge_sparse() const {
+    if (m_sparse_buffer.empty()) return;
+    m_sparse_list.insert(m_sparse_list.end(),
+                         m_sparse_buffer.begin(), m_sparse_buffer.end());
+    m_sparse_buffer.clear();
+    std::sort(m_sparse_list.begin(), m_sparse_list.end());
+    size_t out = 0;
+    for (size_t i = 0; i < m_sparse_list.size(); ++i) {
+      uint32_t e = m_sparse_list[i];
+      if (out > 0 &&
+          (m_sparse_list[out - 1] >> REGISTER_BITS) == (e >> REGISTER_BITS)) {
+        // Same index, and the entries are sorted by rank within an index.
+        m_sparse_list[out - 1] = e;
+      } else {
+        m_sparse_list[out++] = e;
+      }
     }
-    E = m_alpha * m_m * m_m / E;
-    // perform bias correction for small values
-    if (E <= 2.5 * m_m) {
-      size_t zero_count = 0;
-      for(auto i: m_buckets) zero_count += (i == 0);
-      if (zero_count != 0) E = m_m * std::log((double)m_m / zero_count);
+    m_sparse_list.resize(out);
+  }
+
+  void to_dense() {
+    merge_sparse();
+    m_registers.assign(num_words(), 0);
+    for (uint32_t e: m_sparse_list) add_sparse_entry(e);
+    std::vector<uint32_t>().swap(m_sparse_list);
+    std::vector<uint32_t>().swap(m_sparse_buffer);
+    m_sparse = false;
+  }
+
+  static double sigma(double x) {
+    if (x == 1) return std::numeric_limits<double>::infinity();
+    double y = 1;
+    double z = x;
+    double z_prev;
+    do {
+      x *= x;
+      z_prev = z;
+      z += x * y;
+      y += y;
+    } while (z != z_prev);
+    return z;
+  }
+
+  static double tau(double x) {
+    if (x == 0 || x == 1) return 0;
+    double y = 1;
+    double z = 1 - x;
+    double z_prev;
+    do {
+      x = std::sqrt(x);
+      z_prev = z;
+      y *= 0.5;
+      z -= (1 - x) * (1 - x) * y;
+    } while (z != z_prev);
+    return z / 3;
+  }
+
+  /// Ertl's improved estimator, from the histogram of the register values.
+  double dense_estimate(const std::vector<uint64_t>& registers) const {
+    const size_t q = 64 - m_b;
+    std::vector<size_t> counts(q + 2, 0);
+    for (size_t i = 0; i < m_m; ++i) {
+      uint64_t word = registers[i / REGISTERS_PER_WORD];
+      size_t shift = (i % REGISTERS_PER_WORD) * REGISTER_BITS;
+      ++counts[(word >> shift) & REGISTER_MASK];
+    }
+
+    double m = double(m_m);
+    double z = m * tau(1 - double(counts[q + 1]) / m);
+    for (size_t k = q; k >= 1; --k) {
+      z = 0.5 * (z + double(counts[k]));
     }
-    // we do not need correction for large values 64-bit hash, assume
-    // collisions are unlikely
-    return E;
+    z += m * sigma(double(counts[0]) / m);
+    return (0.5 / std::log(2.0)) * m * m / z;
   }
 }; // hyperloglog
 } // namespace sketch
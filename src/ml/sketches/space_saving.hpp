@@ -11,6 +11,7 @@
 #include <cmath>
 #include <set>
 #include <core/generics/value_container_mapper.hpp>
+#include <core/storage/serialization/serialization_includes.hpp>
 
 
 namespace turi {
@@ -161,6 +162,37 @@ class space_saving {
     _combine(other);
   }
 
+  /**
+   * Serializes the tracked entries with their counts and errors.
+   */
+  void save(oarchive& oarc) const {
+    oarc << m_epsilon << m_size << n_entries;
+    for(size_t i = 0; i < n_entries; ++i) {
+      const entry& e = entries[i];
+      oarc << e.value() << e.count << e.error;
+    }
+  }
+
+  /**
+   * Loads a sketch saved by save().
+   */
+  void load(iarchive& iarc) {
+    double epsilon;
+    size_t size, num_entries;
+    iarc >> epsilon >> size >> num_entries;
+    initialize(epsilon);
+    init_data_structures();
+    // Every entry is new, and there is room for all of them, so each one is
+    // inserted with its count and error as they were.
+    for(size_t i = 0; i < num_entries; ++i) {
+      T value;
+      size_t count, error;
+      iarc >> value >> count >> error;
+      add_impl(value, count, error);
+    }
+    m_size = size;
+  }
+
   ~space_saving() { }
 
  private:
@@ -112,13 +112,22 @@ class space_saving_flextype {
   /**
    * Merges a second space saving sketch into the current sketch
    */
-  void combine(space_saving_flextype& other) {
+  void combine(const space_saving_flextype& other) {
     if(!is_combined)
       _combine_integer_and_general();
-    if(!other.is_combined)
-      other._combine_integer_and_general();
 
     ss_general->combine(*other.ss_general);
+    ss_general->combine(*other.ss_integer);
+  }
+
+  /// Serializer
+  void save(oarchive& oarc) const {
+    oarc << m_epsilon << is_combined << *ss_integer << *ss_general;
+  }
+
+  /// Deserializer
+  void load(iarchive& iarc) {
+    iarc >> m_epsilon >> is_combined >> *ss_integer >> *ss_general;
   }
 
   void clear() {
@@ -3,7 +3,9 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <deque>
 #include <future>
+#include <set>
 #include <thread>
 #include <unordered_set>
 #include <core/parallel/mutex.hpp>
@@ -21,9 +23,63 @@ namespace turi {
 
 const double unity_sketch::SKETCH_COMMIT_INTERVAL = 3.0;
 
+namespace {
+
+/*
+ * The most recently finished sketches, by SArray index file and sub sketch
+ * keys. SArrays are immutable, so a finished sketch stays valid for as long
+ * as its index file exists.
+ */
+const size_t SKETCH_CACHE_SIZE = 16;
+turi::mutex sketch_cache_lock;
+std::deque<std::pair<std::string, std::shared_ptr<unity_sketch>>> sketch_cache;
+
+std::string sketch_cache_key(const std::string& index_file,
+                             const std::vector<flexible_type>& keys) {
+  std::set<std::string> key_names;
+  for (const flexible_type& key : keys) {
+    key_names.insert(std::string(flex_type_enum_to_name(key.get_type())) +
+                     ":" + std::string(key));
+  }
+
+  std::string ret = index_file;
+  for (const std::string& name : key_names) {
+    ret += "\n" + name;
+  }
+  return ret;
+}
+
+std::shared_ptr<unity_sketch> find_cached_sketch(const std::string& key) {
+  std::lock_guard<turi::mutex> guard(sketch_cache_lock);
+  for (const auto& entry : sketch_cache) {
+    if (entry.first == key) return entry.second;
+  }
+  return nullptr;
+}
+
+void insert_cached_sketch(const std::string& key,
+                          std::shared_ptr<unity_sketch> sketch) {
+  std::lock_guard<turi::mutex> guard(sketch_cache_lock);
+  for (const auto& entry : sketch_cache) {
+    if (entry.first == key) return;
+  }
+  sketch_cache.emplace_back(key, std::move(sketch));
+  if (sketch_cache.size() > SKETCH_CACHE_SIZE) sketch_cache.pop_front();
+}
+
+}  // namespace
+
 void unity_sketch::construct_from_sarray(
     std::shared_ptr<unity_sarray_base> uarray, bool background, const std::vector<flexible_type>& keys) {
   auto array = std::static_pointer_cast<unity_sarray>(uarray)->get_underlying_sarray();
+
+  std::string cache_key = sketch_cache_key(array->get_index_file(), keys);
+  auto cached = find_cached_sketch(cache_key);
+  if (cached) {
+    copy_finished_sketch(*cached);
+    return;
+  }
+
   std::shared_ptr<sarray<flexible_type>::reader_type>
       reader(array->get_reader());
 
@@ -38,6 +94,8 @@ void unity_sketch::construct_from_sarray(
     return;
   }
 
+  m_cache_key = cache_key;
+
   // build up the thread local datastructures
   m_commit_timer.start();
   m_background_future =
@@ -460,22 +518,65 @@ void unity_sketch::reset_global_sketches_and_statistics() {
   m_num_elements_processed = 0;
 }
 
-void unity_sketch::combine_global(std::vector<turi::mutex>& thr_locks) {
+void unity_sketch::merge_thread_local_sketches(std::vector<turi::mutex>& thr_locks) {
+  size_t n = m_thrlocal.size();
+
+  if (m_is_numeric) {
+    parallel_for(0, n, [&](size_t i) {
+      std::unique_lock<turi::mutex> thrlocal_lock(thr_locks[i]);
+      m_thrlocal[i].numeric_sketch.substream_finalize();
+    });
+  }
+
+  // merge sketch i + stride into sketch i, for i a multiple of 2 * stride,
+  // until everything is in sketch 0
+  for (size_t stride = 1; stride < n; stride *= 2) {
+    size_t num_merges = (n - stride + 2 * stride - 1) / (2 * stride);
+    parallel_for(0, num_merges, [&](size_t m) {
+      size_t dst = 2 * stride * m;
+      size_t src = dst + stride;
+      std::unique_lock<turi::mutex> dst_lock(thr_locks[dst]);
+      std::unique_lock<turi::mutex> src_lock(thr_locks[src]);
+
+      thr_local_data& to = m_thrlocal[dst];
+      thr_local_data& from = m_thrlocal[src];
+      to.num_elements_processed += from.num_elements_processed;
+      to.undefined_count += from.undefined_count;
+      to.discrete_sketch.combine(from.discrete_sketch);
+      if (m_is_numeric) {
+        to.numeric_sketch.combine_finalized(from.numeric_sketch);
+      }
+      from = thr_local_data();
+    });
+  }
+}
+
+void unity_sketch::combine_global(std::vector<turi::mutex>& thr_locks, bool finished) {
   // acquire lock on the globals and combine with the threads.
   std::unique_lock<turi::mutex> global_lock(lock);
   reset_global_sketches_and_statistics();
 
-  // merge all the sketches
-  for (size_t i = 0;i < m_thrlocal.size(); ++i) {
-    std::unique_lock<turi::mutex> thrlocal_lock(thr_locks[i]);
-    m_num_elements_processed += m_thrlocal[i].num_elements_processed;
-    m_discrete_sketch.combine(m_thrlocal[i].discrete_sketch);
-    m_undefined_count += m_thrlocal[i].undefined_count;
+  if (finished && !m_thrlocal.empty()) {
+    merge_thread_local_sketches(thr_locks);
+
+    std::unique_lock<turi::mutex> thrlocal_lock(thr_locks[0]);
+    m_num_elements_processed += m_thrlocal[0].num_elements_processed;
+    m_discrete_sketch.combine(m_thrlocal[0].discrete_sketch);
+    m_undefined_count += m_thrlocal[0].undefined_count;
     if (m_is_numeric) {
-      m_numeric_sketch.combine(m_thrlocal[i].numeric_sketch);
+      m_numeric_sketch.combine_finalized(m_thrlocal[0].numeric_sketch);
+    }
+  } else {
+    // merge all the sketches
+    for (size_t i = 0;i < m_thrlocal.size(); ++i) {
+      std::unique_lock<turi::mutex> thrlocal_lock(thr_locks[i]);
+      m_num_elements_processed += m_thrlocal[i].num_elements_processed;
+      m_discrete_sketch.combine(m_thrlocal[i].discrete_sketch);
+      m_undefined_count += m_thrlocal[i].undefined_count;
+      if (m_is_numeric) {
+        m_numeric_sketch.combine(m_thrlocal[i].numeric_sketch);
+      }
     }
-
-
   }
 
   if (m_is_child_sketch) {
@@ -487,21 +588,21 @@ void unity_sketch::combine_global(std::vector<turi::mutex>& thr_locks) {
   }
 
   if (m_is_list) {
-    m_element_len_sketch->combine_global(thr_locks);
+    m_element_len_sketch->combine_global(thr_locks, finished);
   }
 
   if (m_stored_type == flex_type_enum::DICT) {
-    m_dict_key_sketch->combine_global(thr_locks);
-    m_dict_value_sketch->combine_global(thr_locks);
+    m_dict_key_sketch->combine_global(thr_locks, finished);
+    m_dict_value_sketch->combine_global(thr_locks, finished);
   }
 
   if (m_element_sketch) {
-    m_element_sketch->combine_global(thr_locks);
+    m_element_sketch->combine_global(thr_locks, finished);
   }
 
   if (!m_element_sub_sketch.empty()) {
     for(auto sub_sketch : m_element_sub_sketch) {
-      m_element_sub_sketch[sub_sketch.first]->combine_global(thr_locks);
+      m_element_sub_sketch[sub_sketch.first]->combine_global(thr_locks, finished);
     }
   }
 }
@@ -514,7 +615,9 @@ void unity_sketch::commit_global_if_out_of_date() {
                        << "rows_processed: " << m_rows_processed_by_threads.value << "\t"
                        << "time:" << m_commit_timer.current_time() << std::endl;
 
-    combine_global(m_thrlocks);
+    // once every row is in, the threads are done with their sketches
+    bool finished = (m_rows_processed_by_threads == m_size);
+    combine_global(m_thrlocks, finished);
 
     // done with all of my allocated rows.
     m_commit_timer.start();
@@ -523,10 +626,36 @@ void unity_sketch::commit_global_if_out_of_date() {
     if (m_num_elements_processed == m_size && !m_is_child_sketch) {
       m_background_future.wait();
       m_thrlocal.clear();
+
+      if (!m_cache_key.empty()) {
+        auto finished = std::make_shared<unity_sketch>();
+        finished->copy_finished_sketch(*this);
+        insert_cached_sketch(m_cache_key, finished);
+      }
     }
   }
 }
 
+void unity_sketch::copy_finished_sketch(const unity_sketch& src) {
+  m_is_child_sketch = src.m_is_child_sketch;
+  m_sketch_ready = src.m_sketch_ready;
+  m_is_numeric = src.m_is_numeric;
+  m_is_list = src.m_is_list;
+  m_size = src.m_size;
+  m_stored_type = src.m_stored_type;
+  m_dict_value_sketch_type = src.m_dict_value_sketch_type;
+  m_discrete_sketch = src.m_discrete_sketch;
+  m_numeric_sketch = src.m_numeric_sketch;
+  m_undefined_count = src.m_undefined_count;
+  m_num_elements_processed = src.m_num_elements_processed;
+  m_rows_processed_by_threads = src.m_rows_processed_by_threads;
+  m_element_len_sketch = src.m_element_len_sketch;
+  m_element_sketch = src.m_element_sketch;
+  m_dict_key_sketch = src.m_dict_key_sketch;
+  m_dict_value_sketch = src.m_dict_value_sketch;
+  m_element_sub_sketch = src.m_element_sub_sketch;
+}
+
 void unity_sketch::cancel() {
   if (m_background_future.valid()) {
     m_cancel = true;
@@ -554,10 +683,15 @@ void unity_sketch::numeric_sketch_struct::reset() {
 void unity_sketch::numeric_sketch_struct::combine(const numeric_sketch_struct& other) {
   // make a temp copy of the qunatile we may do finalize multiple times for
   // background sketch, and sketch doesn't like that
-  sketches::streaming_quantile_sketch<double> tmp(*(other.quantiles));
+  numeric_sketch_struct tmp(other);
+  tmp.quantiles = std::make_shared<sketches::streaming_quantile_sketch<double>>(*(other.quantiles));
   tmp.substream_finalize();
 
-  quantiles->combine(tmp);
+  combine_finalized(tmp);
+}
+
+void unity_sketch::numeric_sketch_struct::combine_finalized(const numeric_sketch_struct& other) {
+  quantiles->combine(*(other.quantiles));
 
   min = std::min(other.min, min);
   max = std::max(other.max, max);
@@ -590,6 +724,10 @@ void unity_sketch::numeric_sketch_struct::accumulate(double dval) {
   m2 += delta * (dval - mean);
 }
 
+void unity_sketch::numeric_sketch_struct::substream_finalize() {
+  quantiles->substream_finalize();
+}
+
 void unity_sketch::numeric_sketch_struct::finalize() {
   quantiles->combine_finalize();
 }
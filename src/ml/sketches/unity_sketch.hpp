@@ -150,6 +150,12 @@ class unity_sketch: public unity_sketch_base {
    * If background is true, the sketch will be constructed in the background.
    * While the sketch is being constructed in a background thread, queries can
    * be executed on the sketch, but none of the quality guarantees will apply.
+   *
+   * Each thread sketches a contiguous segment of the rows, and the segment
+   * sketches are merged pairwise in parallel once all are done. Finished
+   * sketches are kept in a small in-memory cache keyed by the index file of
+   * the SArray (and the sub sketch keys), so sketching the same SArray again,
+   * e.g. for repeated summaries, reuses the finished sketch.
    */
   void construct_from_sarray(std::shared_ptr<unity_sarray_base> uarray, bool background = false, const std::vector<flexible_type>& keys = {});
 
@@ -335,8 +341,13 @@ class unity_sketch: public unity_sketch_base {
 
     void combine(const numeric_sketch_struct& other);
 
+    // combine with a sketch whose quantiles are already substream finalized
+    void combine_finalized(const numeric_sketch_struct& other);
+
     void accumulate(double dval);
 
+    void substream_finalize();
+
     void finalize();
   };
 
@@ -391,6 +402,9 @@ class unity_sketch: public unity_sketch_base {
   std::future<void> m_background_future;
   turi::timer m_commit_timer;
 
+  // key of the finished sketch in the sketch cache, empty if not cached
+  std::string m_cache_key;
+
   // for vector/list/dict type, maintain a separate sketch for element length
   std::shared_ptr<unity_sketch> m_element_len_sketch;
   std::shared_ptr<unity_sketch> m_element_sketch;
@@ -432,7 +446,19 @@ class unity_sketch: public unity_sketch_base {
     const std::unordered_set<flexible_type>& keys = std::unordered_set<flexible_type>(),
     std::shared_ptr<sarray<flexible_type>::reader_type> reader = NULL);
 
-  inline void combine_global(std::vector<turi::mutex>& thr_locks);
+  /*
+   * Copies the results of a finished sketch, sharing its sketches and
+   * nested sketches, which are no longer modified.
+   */
+  void copy_finished_sketch(const unity_sketch& src);
+
+  /*
+   * Combines the thread local sketches into the global ones. With finished set,
+   * all the threads are done, and their sketches are first merged pairwise in
+   * parallel, then only the result is combined into the global sketches.
+   */
+  inline void combine_global(std::vector<turi::mutex>& thr_locks, bool finished = false);
+  inline void merge_thread_local_sketches(std::vector<turi::mutex>& thr_locks);
   inline void accumulate_dict_value(const flexible_type& dict_val, size_t thr, const std::unordered_set<flexible_type>& keys);
   inline void accumulate_vector_value(const flexible_type& vect_val, size_t thr, const std::unordered_set<flexible_type>& keys);
   inline void accumulate_list_value(const flexible_type& rec_val, size_t thr);
@@ -3,10 +3,30 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <algorithm>
 #include <model_server/extensions/grouped_sframe.hpp>
+#include <core/storage/sframe_data/shuffle.hpp>
 
 namespace turi {
 
+namespace {
+
+/// Rows of each hash partition, so one partition fits in memory.
+constexpr size_t HASH_GROUP_PARTITION_ROWS = 256 * 1024;
+
+/// Orders the rows of a group, missing values first.
+bool order_value_less(const flexible_type& a, const flexible_type& b) {
+  if (a.get_type() == flex_type_enum::UNDEFINED) {
+    return b.get_type() != flex_type_enum::UNDEFINED;
+  }
+  if (b.get_type() == flex_type_enum::UNDEFINED) {
+    return false;
+  }
+  return a < b;
+}
+
+}  // namespace
+
 /// Public methods
 void grouped_sframe::group(const gl_sframe &sf, const std::vector<std::string>
     column_names, bool is_grouped) {
@@ -71,6 +91,129 @@ void grouped_sframe::group(const gl_sframe &sf, const std::vector<std::string>
   m_inited = true;
 }
 
+void grouped_sframe::group_by_hash(const gl_sframe &sf,
+    const std::vector<std::string>& column_names,
+    const std::string& order_column) {
+  if(m_inited)
+    log_and_throw("Group has already been called on this object!");
+
+  std::vector<size_t> col_ids;
+  std::unordered_set<size_t> dedup_set;
+  for(const auto &i : column_names) {
+    auto col_id = sf.column_index(i);
+    col_ids.push_back(col_id);
+    auto ins_ret = dedup_set.insert(col_id);
+    if(!ins_ret.second)
+      log_and_throw("Found duplicate column name: " + i);
+  }
+  size_t order_col_id = size_t(-1);
+  if (!order_column.empty()) {
+    order_col_id = sf.column_index(order_column);
+  }
+
+  // Number the rows, so the rows of a group can be put back in order after
+  // the partitions are written concurrently.
+  std::string row_col_name = "__row_number__";
+  while (sf.contains_column(row_col_name)) {
+    row_col_name += "_";
+  }
+  gl_sframe numbered_sf = sf;
+  numbered_sf.add_column(gl_sarray::from_sequence(0, sf.size()), row_col_name);
+  const size_t num_columns = sf.num_columns();
+  const size_t row_col_id = num_columns;
+
+  // Pass 1: hash partition the rows on their key.
+  size_t num_partitions = std::max<size_t>(thread::cpu_count(),
+      (sf.size() + HASH_GROUP_PARTITION_ROWS - 1) / HASH_GROUP_PARTITION_ROWS);
+  std::vector<sframe> partitions = shuffle(
+      numbered_sf.materialize_to_sframe(), num_partitions,
+      [&](const std::vector<flexible_type>& row) {
+        size_t key_hash = 0;
+        for (size_t i : col_ids) {
+          key_hash = hash64_combine(key_hash, row[i].hash());
+        }
+        return key_hash;
+      });
+
+  // Pass 2: group each partition in memory and write it as one segment.
+  typedef std::unordered_map<std::vector<flexible_type>, size_t, GroupKeyHash>
+      key_map;
+  std::vector<std::vector<std::vector<flexible_type>>> partition_keys(
+      num_partitions);
+  std::vector<std::vector<size_t>> partition_sizes(num_partitions);
+
+  gl_sframe_writer writer(sf.column_names(), sf.column_types(), num_partitions);
+
+  parallel_for(0, num_partitions, [&](size_t p) {
+    std::vector<std::vector<flexible_type>> rows;
+    partitions[p].get_reader()->read_rows(0, partitions[p].num_rows(), rows);
+    partitions[p] = sframe();
+
+    key_map local_groups;
+    std::vector<std::vector<size_t>> group_rows;
+    std::vector<flexible_type> key(col_ids.size());
+    for (size_t r = 0; r < rows.size(); ++r) {
+      for (size_t k = 0; k < col_ids.size(); ++k) {
+        key[k] = rows[r][col_ids[k]];
+      }
+      auto it = local_groups.find(key);
+      if (it == local_groups.end()) {
+        it = local_groups.emplace(key, group_rows.size()).first;
+        group_rows.emplace_back();
+        partition_keys[p].push_back(key);
+      }
+      group_rows[it->second].push_back(r);
+    }
+
+    std::vector<flexible_type> out_row(num_columns);
+    for (auto& members : group_rows) {
+      std::sort(members.begin(), members.end(), [&](size_t a, size_t b) {
+        if (order_col_id != size_t(-1)) {
+          const auto& va = rows[a][order_col_id];
+          const auto& vb = rows[b][order_col_id];
+          if (order_value_less(va, vb)) return true;
+          if (order_value_less(vb, va)) return false;
+        }
+        return rows[a][row_col_id].get<flex_int>() <
+               rows[b][row_col_id].get<flex_int>();
+      });
+      for (size_t r : members) {
+        std::copy(rows[r].begin(), rows[r].begin() + num_columns,
+                  out_row.begin());
+        writer.write(out_row, p);
+      }
+      partition_sizes[p].push_back(members.size());
+    }
+  });
+
+  m_grouped_sf = writer.close();
+  m_key_col_names = column_names;
+
+  // The segments are concatenated in order: record where each group starts.
+  size_t offset = 0;
+  for (size_t p = 0; p < num_partitions; ++p) {
+    for (size_t g = 0; g < partition_keys[p].size(); ++g) {
+      auto& key = partition_keys[p][g];
+      m_key2range.insert(std::make_pair(key, m_range_directory.size()));
+      m_range_directory.push_back(offset);
+      if(key.size() == 1)
+        m_group_names.push_back(key[0]);
+      else
+        m_group_names.push_back(key);
+      offset += partition_sizes[p][g];
+    }
+  }
+  DASSERT_EQ(offset, m_grouped_sf.size());
+
+  if(col_ids.size() > 1) {
+    m_group_type = flex_type_enum::LIST;
+  } else {
+    m_group_type = sf[column_names[0]].dtype();
+  }
+
+  m_inited = true;
+}
+
 gl_sframe grouped_sframe::get_group(std::vector<flexible_type> key) {
   if(!m_inited) {
     log_and_throw("The 'group' operation needs to occur before getting a "
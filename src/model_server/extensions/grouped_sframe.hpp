@@ -47,6 +47,27 @@ class EXPORT grouped_sframe: public model_base {
   void group(const gl_sframe &sf, const std::vector<std::string> column_names,
       bool is_grouped);
 
+  /**
+   * Groups an SFrame like \ref group(), by hashing the keys instead of
+   * sorting the SFrame on them.
+   *
+   * One parallel pass hash partitions the rows on their key, then each
+   * partition is grouped in memory and written as one segment of the grouped
+   * SFrame, with the rows of each group contiguous. The ranges of the groups
+   * are recorded as the partitions are written, so there is no global sort
+   * and no extra pass to find the group boundaries.
+   *
+   * The groups are not in key order. Within a group, the rows are sorted by
+   * order_column (missing values first) if one is given, and otherwise keep
+   * their order in sf.
+   *
+   * Throws if group has already been called on this object, or the column
+   * names are not valid.
+   */
+  void group_by_hash(const gl_sframe &sf,
+      const std::vector<std::string>& column_names,
+      const std::string& order_column = "");
+
 
   /**
    * Get the SFrame that corresponds to the group named `key`.
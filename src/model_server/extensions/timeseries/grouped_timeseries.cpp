@@ -48,14 +48,9 @@ void gl_grouped_timeseries::group(const gl_sframe &sf,
                       m_time_index_name);
   m_value_col_names.erase(it); // remove index.
 
-  // Add the time index as the last sort column
-  std::vector<std::string> sort_columns(column_names.size() + 1);
-  std::copy(column_names.begin(), column_names.end(), sort_columns.begin());
-  sort_columns[column_names.size()] = m_time_index_name;
-  auto grouped_sf = sf.sort(sort_columns);
-
+  // Hash group on the key columns, keeping each group sorted by time.
   m_grouped_sframe = turi::grouped_sframe();
-  m_grouped_sframe.group(grouped_sf, column_names, true);
+  m_grouped_sframe.group_by_hash(sf, column_names, m_time_index_name);
 }
 
 gl_sframe gl_grouped_timeseries::get_group(const std::vector<flexible_type> key) {
@@ -4,9 +4,11 @@
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
 #include <unordered_set>
+#include <algorithm>
 #include <cmath>
 
 #include <core/util/hash_value.hpp>
+#include <core/parallel/lambda_omp.hpp>
 #include <core/storage/sframe_data/groupby_aggregate.hpp>
 #include <model_server/extensions/timeseries/timeseries.hpp>
 
@@ -976,6 +978,76 @@ gl_timeseries gl_timeseries::index_join(const gl_timeseries & other_ts,const
   return g_ts;
 }
 
+constexpr size_t time_index::BLOCK_SIZE;
+
+std::shared_ptr<time_index> time_index::build(
+    std::shared_ptr<sarray<flexible_type>> column) {
+  auto ret = std::make_shared<time_index>();
+  ret->column = column;
+  ret->reader = column->get_reader();
+  ret->num_rows = column->size();
+
+  size_t num_blocks = (ret->num_rows + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  ret->block_first.resize(num_blocks);
+  ret->block_last.resize(num_blocks);
+  std::vector<char> has_missing(num_blocks, false);
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    size_t block_begin = num_blocks * thread_idx / num_threads;
+    size_t block_end = num_blocks * (thread_idx + 1) / num_threads;
+    std::vector<flexible_type> rows;
+    for (size_t b = block_begin; b < block_end; ++b) {
+      ret->reader->read_rows(b * BLOCK_SIZE, (b + 1) * BLOCK_SIZE, rows);
+      ret->block_first[b] = rows.front();
+      ret->block_last[b] = rows.back();
+      for (const auto& v : rows) {
+        if (v.get_type() == flex_type_enum::UNDEFINED) {
+          has_missing[b] = true;
+          break;
+        }
+      }
+    }
+  });
+
+  ret->usable = std::find(has_missing.begin(), has_missing.end(), true)
+                == has_missing.end();
+  return ret;
+}
+
+size_t time_index::find(const flexible_type& t, bool strict) const {
+  DASSERT_TRUE(usable);
+  auto past = [&](const flexible_type& v) {
+    return strict ? (t < v) : !(v < t);
+  };
+
+  // The first block that ends past t holds the row.
+  auto it = std::partition_point(block_last.begin(), block_last.end(),
+      [&](const flexible_type& v) { return !past(v); });
+  if (it == block_last.end()) {
+    return num_rows;
+  }
+  size_t b = it - block_last.begin();
+  if (past(block_first[b])) {
+    return b * BLOCK_SIZE;
+  }
+
+  std::vector<flexible_type> rows;
+  reader->read_rows(b * BLOCK_SIZE, (b + 1) * BLOCK_SIZE, rows);
+  auto row = std::partition_point(rows.begin(), rows.end(),
+      [&](const flexible_type& v) { return !past(v); });
+  return b * BLOCK_SIZE + (row - rows.begin());
+}
+
+std::shared_ptr<time_index> gl_timeseries::get_time_index() const {
+  auto column = m_sframe[m_index_col_name].materialize_to_sarray();
+  auto index = std::atomic_load(&m_time_index);
+  if (!index || index->column != column) {
+    index = time_index::build(column);
+    std::atomic_store(&m_time_index, index);
+  }
+  return index;
+}
+
 gl_timeseries gl_timeseries::slice(const flexible_type &start_time, const
     flexible_type &end_time, const std::string &closed) const {
 
@@ -986,26 +1058,39 @@ gl_timeseries gl_timeseries::slice(const flexible_type &start_time, const
     log_and_throw("Parameter 'end_time' must be flex_date_time");
   }
 
-  auto index_col = m_sframe[m_index_col_name];
-  gl_sarray sel1;
-  gl_sarray sel2;
+  bool start_strict, end_strict;
   if(closed == "left") {
-    sel1 = (index_col >= start_time);
-    sel2 = (index_col < end_time);
+    start_strict = false;
+    end_strict = false;
   } else if(closed == "right") {
-    sel1 = (index_col > start_time);
-    sel2 = (index_col <= end_time);
+    start_strict = true;
+    end_strict = true;
   } else if(closed == "both") {
-    sel1 = (index_col >= start_time);
-    sel2 = (index_col <= end_time);
+    start_strict = false;
+    end_strict = true;
   } else if(closed == "neither") {
-    sel1 = (index_col > start_time);
-    sel2 = (index_col < end_time);
+    start_strict = true;
+    end_strict = false;
   } else {
     log_and_throw("Invalid value for parameter 'closed'");
   }
 
-  gl_sframe range_sf = m_sframe[sel1 && sel2];
+  gl_sframe range_sf;
+  auto index = get_time_index();
+  if (index->usable) {
+    // The index column is sorted: the slice is a contiguous range of rows.
+    size_t begin = index->find(start_time, start_strict);
+    size_t end = std::max(begin, index->find(end_time, end_strict));
+    range_sf = m_sframe[{int64_t(begin), int64_t(end)}];
+  } else {
+    auto index_col = m_sframe[m_index_col_name];
+    gl_sarray sel1 = start_strict ? (index_col > start_time)
+                                  : (index_col >= start_time);
+    gl_sarray sel2 = end_strict ? (index_col <= end_time)
+                                : (index_col < end_time);
+    range_sf = m_sframe[sel1 && sel2];
+  }
+
   gl_timeseries ret_ts;
   ret_ts.init(range_sf, m_index_col_name, true);
   return ret_ts;
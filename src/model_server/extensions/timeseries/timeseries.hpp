@@ -17,7 +17,9 @@
 #include <core/storage/sframe_data/group_aggregate_value.hpp>
 #include <model_server/lib/toolkit_class_macros.hpp>
 #include <core/data/sframe/gl_sarray.hpp>
+#include <memory>
 #include <core/data/sframe/gl_sframe.hpp>
+#include <core/storage/sframe_data/sarray.hpp>
 #include <model_server/lib/extensions/model_base.hpp>
 #include <model_server/extensions/timeseries/grouped_timeseries.hpp>
 #include <model_server/extensions/timeseries/interpolate_value.hpp>
@@ -34,6 +36,37 @@ EXPORT gl_sarray date_range(const flexible_type &start_time,
 typedef std::shared_ptr<interpolator_value> interpolator_type;
 class grouped_timeseries;
 
+/**
+ * Sparse index over the sorted index column of a timeseries: the first and
+ * last time of every block of rows. Finding the row of a time is a binary
+ * search over the blocks, then within the one block that holds it, so only
+ * that block of the column is read.
+ */
+struct time_index {
+  static constexpr size_t BLOCK_SIZE = 4096;
+
+  std::shared_ptr<sarray<flexible_type>> column;
+  std::shared_ptr<sarray_reader<flexible_type>> reader;
+  size_t num_rows = 0;
+  std::vector<flexible_type> block_first;
+  std::vector<flexible_type> block_last;
+
+  /// False if the column has missing values, which a range cannot skip.
+  bool usable = true;
+
+  /**
+   * Build the index with one parallel pass over the column.
+   */
+  static std::shared_ptr<time_index> build(
+      std::shared_ptr<sarray<flexible_type>> column);
+
+  /**
+   * The first row whose time is not less than t (or greater than t if
+   * strict is true), or num_rows if there is none.
+   */
+  size_t find(const flexible_type& t, bool strict) const;
+};
+
 /***
  * gl_timeseries is the fundamental data-structure to hold multi-variate
  * timeseries data.  It is backed by a single gl_sframe and some meta-data.
@@ -48,6 +81,11 @@ class EXPORT gl_timeseries : public model_base {
       gl_sframe m_sframe;                 // The backend gl_sframe
       bool m_initialized = false;
 
+      // Built on the first slice, and rebuilt when the index column changes.
+      mutable std::shared_ptr<time_index> m_time_index;
+
+      std::shared_ptr<time_index> get_time_index() const;
+
       void _check_if_initialized() const {
         if(!m_initialized)
          throw std::string("Timeseries is not initialized.");
@@ -68,6 +68,10 @@ typedef std::map<std::string, flexible_type> global_configuration_type;
       (void, set_log_level, (size_t))
       (global_configuration_type, list_globals, (bool))
       (std::string, set_global, (std::string)(flexible_type))
+      (global_configuration_type, get_call_stats, (bool))
+      (global_configuration_type, get_metrics, )
+      (std::string, get_prometheus_metrics, )
+      (global_configuration_type, get_memory_usage, (bool))
       (std::shared_ptr<unity_sarray_base>, create_sequential_sarray, (ssize_t)(ssize_t)(bool))
       (std::string, load_toolkit, (std::string)(std::string))
       (std::vector<std::string>, list_toolkit_functions_in_dynamic_module, (std::string))
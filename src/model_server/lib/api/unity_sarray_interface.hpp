@@ -16,6 +16,7 @@ namespace turi {
 
 class unity_sframe_base;
 typedef std::map<std::string, flexible_type> func_options_map;
+typedef std::map<std::string, flexible_type> query_plan_explanation_map;
 
 GENERATE_INTERFACE_AND_PROXY(unity_sarray_base, unity_sarray_proxy,
       (void, construct_from_vector, (const std::vector<flexible_type>&)(flex_type_enum))
@@ -65,6 +66,7 @@ GENERATE_INTERFACE_AND_PROXY(unity_sarray_base, unity_sarray_proxy,
       (std::vector<flexible_type>, iterator_get_next, (size_t))
       (void, materialize, )
       (bool, is_materialized, )
+      (query_plan_explanation_map, explain, )
       (std::shared_ptr<unity_sarray_base>, append, (std::shared_ptr<unity_sarray_base>))
       (std::shared_ptr<unity_sarray_base>, count_bag_of_words, (func_options_map))
       (std::shared_ptr<unity_sarray_base>, count_character_ngrams, (size_t) (func_options_map))
@@ -64,9 +64,12 @@ GENERATE_INTERFACE_AND_PROXY(unity_sframe_base, unity_sframe_proxy,
       (bool, is_materialized, )
       (bool, has_size, )
       (std::string, query_plan_string, )
+      (std::string, explain_analyze, )
+      (query_plan_explanation_map, explain, )
       (std::shared_ptr<unity_sframe_base>, join, (std::shared_ptr<unity_sframe_base>)(const std::string)(const string_map&))
       (std::shared_ptr<unity_sframe_base>, join_with_custom_name, (std::shared_ptr<unity_sframe_base>)(const std::string)(const string_map&)(const string_map&))
       (std::shared_ptr<unity_sframe_base>, sort, (const std::vector<std::string>&)(const std::vector<int>&))
+      (std::shared_ptr<unity_sframe_base>, topk, (const std::vector<std::string>&)(const std::vector<int>&)(size_t))
       (std::shared_ptr<unity_sarray_base>, pack_columns, (const std::vector<std::string>&)(const std::vector<std::string>&)(flex_type_enum)(const flexible_type&))
       (std::shared_ptr<unity_sframe_base>, stack,  (const std::string&)(const std::vector<std::string>&)(const std::vector<flex_type_enum>&)(bool))
       (std::shared_ptr<unity_sframe_base>, copy_range, (size_t)(size_t)(size_t))
@@ -5,6 +5,7 @@
  * https://opensource.org/licenses/BSD-3-Clause
  */
 #include <model_server/lib/extensions/model_base.hpp>
+#include <algorithm>
 #include <model_server/lib/unity_global.hpp>
 
 namespace turi {
@@ -160,6 +161,74 @@ variant_type model_base::call_function(const std::string& function,
   return m_function_list.at(function)(this, std::move(argument));
 }
 
+model_base::method_handle model_base::get_method_handle(
+    const std::string& function) {
+  _check_registration();
+
+  auto it = m_function_args.find(function);
+  if (it == m_function_args.end()) {
+    _raise_not_found_error(function, m_function_args);
+  }
+  const std::vector<std::string>& function_args = it->second;
+
+  // The default values of the trailing arguments which have one.
+  std::vector<variant_type> trailing_defaults;
+  auto default_arg_it = m_function_default_args.find(function);
+  if (default_arg_it != m_function_default_args.end()) {
+    const auto& default_args = default_arg_it->second;
+    for (auto a = function_args.rbegin(); a != function_args.rend(); ++a) {
+      auto d_it = default_args.find(*a);
+      if (d_it == default_args.end()) break;
+      trailing_defaults.push_back(d_it->second);
+    }
+    std::reverse(trailing_defaults.begin(), trailing_defaults.end());
+  }
+
+  size_t num_args = function_args.size();
+  size_t min_args = num_args - trailing_defaults.size();
+  std::string method_name = _make_method_name(function);
+  std::string model_name = name();
+
+  auto check_arguments = [=](const std::vector<variant_type>& arguments) {
+    if (arguments.size() < min_args || arguments.size() > num_args) {
+      std::ostringstream ss;
+      ss << "Error: method " << method_name << " in model " << model_name
+         << " expects " << min_args;
+      if (min_args != num_args) ss << " to " << num_args;
+      ss << " arguments, got " << arguments.size();
+      std_log_and_throw(std::invalid_argument, ss.str());
+    }
+  };
+
+  auto native_it = m_native_function_list.find(function);
+  if (native_it != m_native_function_list.end() && native_it->second) {
+    native_impl_fn fn = native_it->second;
+    return [=](const std::vector<variant_type>& arguments) {
+      check_arguments(arguments);
+      if (arguments.size() == num_args) return fn(this, arguments);
+      std::vector<variant_type> filled_arguments(arguments);
+      filled_arguments.insert(
+          filled_arguments.end(),
+          trailing_defaults.end() - (num_args - arguments.size()),
+          trailing_defaults.end());
+      return fn(this, filled_arguments);
+    };
+  }
+
+  // No positional wrapper; name the arguments and call the generic one.
+  impl_fn fn = m_function_list.at(function);
+  return [=](const std::vector<variant_type>& arguments) {
+    check_arguments(arguments);
+    variant_map_type argument;
+    for (size_t i = 0; i < num_args; ++i) {
+      argument[function_args[i]] = (i < arguments.size())
+                                       ? arguments[i]
+                                       : trailing_defaults[i - min_args];
+    }
+    return fn(this, std::move(argument));
+  };
+}
+
 variant_type model_base::get_property(const std::string& property) {
   _check_registration();
 
@@ -201,7 +270,7 @@ const std::string& model_base::get_docstring(const std::string& symbol) {
 
 void model_base::register_function(std::string fnname,
                                    const std::vector<std::string>& arguments,
-				   impl_fn fn) {
+				   impl_fn fn, native_impl_fn native_fn) {
 
   auto last_colon = fnname.find_last_of(":");
   if (last_colon != std::string::npos) {
@@ -210,6 +279,11 @@ void model_base::register_function(std::string fnname,
 
   m_function_args[fnname] = arguments;
   m_function_list[fnname] = std::move(fn);
+  if (native_fn) {
+    m_native_function_list[fnname] = std::move(native_fn);
+  } else {
+    m_native_function_list.erase(fnname);
+  }
 }
 
 void model_base::register_defaults(const std::string& fnname,
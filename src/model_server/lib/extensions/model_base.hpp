@@ -150,6 +150,22 @@ class EXPORT model_base: public cppipc::ipc_object_base {
    */
   variant_type call_function(const std::string& function, variant_map_type argument);
 
+  /**
+   * A resolved user defined function, called with its arguments in the order
+   * of the argument names registered for it. Trailing arguments may be
+   * omitted if they have default values.
+   */
+  using method_handle =
+      std::function<variant_type(const std::vector<variant_type>& arguments)>;
+
+  /**
+   * Looks up a user defined function once, for repeated calls. Unlike
+   * call_function(), calls through the handle do not build or search an
+   * argument map, unless the function was registered without a positional
+   * wrapper. The handle refers to this object, and must not outlive it.
+   */
+  method_handle get_method_handle(const std::string& function);
+
   /**
    * Reads a property.
    */
@@ -179,6 +195,8 @@ class EXPORT model_base: public cppipc::ipc_object_base {
 
  protected:
   using impl_fn = std::function<variant_type(model_base*, variant_map_type)>;
+  using native_impl_fn = std::function<variant_type(
+      model_base*, const std::vector<variant_type>&)>;
 
   // The macros defined in toolkit_class_macros.h use these functions to
   // conveniently define this instance's collection of client-level methods
@@ -192,9 +210,12 @@ class EXPORT model_base: public cppipc::ipc_object_base {
 
   /**
    * Adds a function with the specified name, and argument list.
+   * native_fn, if given, takes the same arguments positionally and is used
+   * by get_method_handle().
    */
   void register_function(std::string fnname,
-                         const std::vector<std::string>& arguments, impl_fn fn);
+                         const std::vector<std::string>& arguments, impl_fn fn,
+                         native_impl_fn native_fn = native_impl_fn());
 
   /**
    * Registers default argument values
@@ -229,6 +250,8 @@ class EXPORT model_base: public cppipc::ipc_object_base {
   std::map<std::string, variant_map_type> m_function_default_args;
   // The implementation of each function
   std::map<std::string, impl_fn> m_function_list;
+  // The positional implementation of each function, if any
+  std::map<std::string, native_impl_fn> m_native_function_list;
   // The implementation of each setter function
   std::map<std::string, impl_fn> m_set_property_list;
   mutable std::vector<std::string> m_set_property_cache;
@@ -468,9 +468,10 @@ flexible_type resize_image(const flexible_type& input, size_t resized_width,
     return input;
   }
 
-  // Decode if necessary.
+  // Decode if necessary. When shrinking, jpegs are decoded directly at a
+  // fraction of their size, no smaller than the requested size.
   if (!image.is_decoded()) {
-    image_util_detail::decode_image_impl(image);
+    image_util_detail::decode_image_impl(image, resized_width, resized_height);
   }
 
   // Resize if necessary.
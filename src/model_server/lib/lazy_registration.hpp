@@ -0,0 +1,78 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_UNITY_LAZY_REGISTRATION_HPP
+#define TURI_UNITY_LAZY_REGISTRATION_HPP
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <core/logging/logger.hpp>
+#include <timer/timer.hpp>
+
+namespace turi {
+
+/**
+ * Registrations deferred until a registry is first used.
+ *
+ * Filling the registries of the built-in toolkits builds the description of
+ * every function and class, which is a noticeable part of the server start.
+ * A registry instead keeps the functions that would fill it, and runs them
+ * all the first time it is read or written, so that a process which never
+ * calls a toolkit does not pay for them.
+ */
+template <typename Registry>
+class lazy_registrations {
+ public:
+  typedef std::function<void(Registry&)> loader_type;
+
+  /// Adds a function which fills the registry, described by name in the log.
+  void add(const std::string& name, loader_type loader) {
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+    m_loaders.emplace_back(name, std::move(loader));
+    m_pending = true;
+  }
+
+  /**
+   * Runs the functions added so far, once. Other threads calling this wait
+   * until they are done. A function may use the registry it fills.
+   */
+  void load(Registry& registry) {
+    if (!m_pending.load(std::memory_order_acquire)) return;
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+    // called back by a loader; the outer call finishes the work
+    if (m_loading) return;
+    m_loading = true;
+    try {
+      while (!m_loaders.empty()) {
+        std::vector<std::pair<std::string, loader_type>> loaders;
+        loaders.swap(m_loaders);
+        for (auto& loader : loaders) {
+          timer ti;
+          loader.second(registry);
+          logstream(LOG_INFO) << "Registered " << loader.first << " in "
+                              << ti.current_time_millis() << "ms" << std::endl;
+        }
+      }
+    } catch (...) {
+      m_loading = false;
+      throw;
+    }
+    m_loading = false;
+    m_pending.store(false, std::memory_order_release);
+  }
+
+ private:
+  std::atomic<bool> m_pending{false};
+  std::recursive_mutex m_lock;
+  bool m_loading = false;
+  std::vector<std::pair<std::string, loader_type>> m_loaders;
+};
+
+} // turi
+
+#endif
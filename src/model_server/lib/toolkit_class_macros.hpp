@@ -114,6 +114,8 @@
   register_function(#function,  \
                     std::vector<std::string>{__VA_ARGS__}, \
                     toolkit_class_wrapper_impl::generate_member_function_wrapper_indirect( \
+                    &function, ##__VA_ARGS__), \
+                    toolkit_class_wrapper_impl::generate_native_member_function_wrapper_indirect( \
                     &function, ##__VA_ARGS__));
 
 /**
@@ -133,6 +135,8 @@
   register_function(name,  \
                     std::vector<std::string>{__VA_ARGS__}, \
                     toolkit_class_wrapper_impl::generate_member_function_wrapper_indirect( \
+                    &function, ##__VA_ARGS__), \
+                    toolkit_class_wrapper_impl::generate_native_member_function_wrapper_indirect( \
                     &function, ##__VA_ARGS__));
 
 /**
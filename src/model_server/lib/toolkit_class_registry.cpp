@@ -13,6 +13,7 @@ bool toolkit_class_registry::register_toolkit_class(
     std::function<model_base*()> constructor,
     std::map<std::string, flexible_type> description) {
   log_func_entry();
+  lazy.load(*this);
   if (registry.count(class_name)) {
     return false;
   } else {
@@ -39,8 +40,15 @@ bool toolkit_class_registry::register_toolkit_class(
   return success;
 }
 
+void toolkit_class_registry::register_lazy(
+    const std::string& name,
+    std::function<void(toolkit_class_registry&)> loader) {
+  lazy.add(name, std::move(loader));
+}
+
 std::shared_ptr<model_base> toolkit_class_registry::get_toolkit_class(
     const std::string& class_name) {
+  lazy.load(*this);
   if (registry.count(class_name)) {
     return std::shared_ptr<model_base>(registry[class_name]());
   } else {
@@ -50,6 +58,7 @@ std::shared_ptr<model_base> toolkit_class_registry::get_toolkit_class(
 
 std::map<std::string, flexible_type>
 toolkit_class_registry::get_toolkit_class_description(const std::string& class_name) {
+  lazy.load(*this);
   if (descriptions.count(class_name)) {
     return descriptions[class_name];
   } else {
@@ -57,6 +66,7 @@ toolkit_class_registry::get_toolkit_class_description(const std::string& class_n
   }
 }
 std::vector<std::string> toolkit_class_registry::available_toolkit_classes() {
+  lazy.load(*this);
   std::vector<std::string> ret;
   for (const auto& kv : registry) {
     ret.push_back(kv.first);
@@ -6,6 +6,7 @@
 #ifndef TURI_UNITY_TOOLKIT_CLASS_REGISTRY_HPP
 #define TURI_UNITY_TOOLKIT_CLASS_REGISTRY_HPP
 #include <model_server/lib/toolkit_class_specification.hpp>
+#include <model_server/lib/lazy_registration.hpp>
 
 namespace turi {
 class model_base;
@@ -43,6 +44,14 @@ class toolkit_class_registry {
   bool register_toolkit_class(std::vector<toolkit_class_specification> classes,
                               std::string prefix = "");
 
+  /**
+   * Defers a registration until the registry is first used. The loader is
+   * called with this registry, and name is used in the log, which records how
+   * long each loader took. See \ref lazy_registrations.
+   */
+  void register_lazy(const std::string& name,
+                     std::function<void(toolkit_class_registry&)> loader);
+
   /**
    * Creates a new model object with the given model_name.
    *
@@ -66,6 +75,7 @@ class toolkit_class_registry {
  private:
   std::map<std::string, std::function<model_base*()> > registry;
   std::map<std::string, std::map<std::string, flexible_type> > descriptions;
+  lazy_registrations<toolkit_class_registry> lazy;
 };
 
 } // turicreate
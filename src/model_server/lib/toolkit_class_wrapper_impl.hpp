@@ -12,6 +12,7 @@ class model_base;
 namespace toolkit_class_wrapper_impl {
 using turi::toolkit_function_wrapper_impl::generate_member_function_wrapper;
 using turi::toolkit_function_wrapper_impl::generate_const_member_function_wrapper;
+using turi::toolkit_function_wrapper_impl::generate_native_member_function_wrapper;
 
 /**
  * Wraps a member function T::f(...) with a function that takes a
@@ -88,6 +89,35 @@ generate_member_function_wrapper_indirect(Ret (T::* fn)(Args...) const, VarArgs.
  * }
  * \endcode
  */
+/**
+ * Generates a wrapper of a member function which takes its arguments
+ * positionally, for model_base::get_method_handle(). The names are only used
+ * to check their count against the arguments of the function; if they do not
+ * match, no wrapper is generated and calls fall back to the named wrapper.
+ */
+template <typename T, typename Ret, typename... Args, typename... VarArgs>
+std::function<variant_type(model_base*, const std::vector<variant_type>&)>
+generate_native_member_function_wrapper_indirect(Ret (T::* fn)(Args...), VarArgs... args) {
+  // Without a name for each argument, there is no positional order to use.
+  if (sizeof...(Args) != sizeof...(VarArgs)) return nullptr;
+  auto newfn = generate_native_member_function_wrapper<sizeof...(Args), T, Ret, Args...>(fn);
+  return [newfn](model_base* curthis, const std::vector<variant_type>& in)->variant_type {
+    return newfn(dynamic_cast<T*>(curthis), in);
+  };
+}
+
+template <typename T, typename Ret, typename... Args, typename... VarArgs>
+std::function<variant_type(model_base*, const std::vector<variant_type>&)>
+generate_native_member_function_wrapper_indirect(Ret (T::* fn)(Args...) const, VarArgs... args) {
+  // Without a name for each argument, there is no positional order to use.
+  if (sizeof...(Args) != sizeof...(VarArgs)) return nullptr;
+  auto newfn = generate_native_member_function_wrapper<sizeof...(Args), T, Ret, Args...>(fn);
+  return [newfn](model_base* curthis, const std::vector<variant_type>& in)->variant_type {
+    return newfn(dynamic_cast<T*>(curthis), in);
+  };
+}
+
+
 template <typename T, typename Ret>
 std::function<variant_type(model_base*, variant_map_type)>
 generate_getter(Ret (T::* fn)()) {
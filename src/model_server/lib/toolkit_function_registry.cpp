@@ -14,6 +14,7 @@ bool toolkit_function_registry::register_toolkit_function(
     toolkit_function_specification spec,
     std::string prefix) {
   log_func_entry();
+  lazy.load(*this);
   // if there is something in the registry with this name, fail
   if (prefix.length() > 0) {
     spec.name = prefix + "." + spec.name;
@@ -28,6 +29,7 @@ bool toolkit_function_registry::register_toolkit_function(
     std::vector<toolkit_function_specification> specvec,
     std::string prefix) {
   log_func_entry();
+  lazy.load(*this);
   // if there is something in the registry with this name, fail
   for (auto& spec: specvec) {
     if (prefix.length() > 0) {
@@ -43,8 +45,16 @@ bool toolkit_function_registry::register_toolkit_function(
 }
 
 
+void toolkit_function_registry::register_lazy(
+    const std::string& name,
+    std::function<void(toolkit_function_registry&)> loader) {
+  lazy.add(name, std::move(loader));
+}
+
+
 bool toolkit_function_registry::unregister_toolkit_function(std::string name) {
   log_func_entry();
+  lazy.load(*this);
   // look for the name
   auto iter = registry.find(name);
   if (iter != registry.end()) {
@@ -60,6 +70,7 @@ bool toolkit_function_registry::unregister_toolkit_function(std::string name) {
 
 
 const toolkit_function_specification* toolkit_function_registry::get_toolkit_function_info(std::string name) {
+  lazy.load(*this);
   // look for the name
   auto iter = registry.find(name);
   return iter == registry.end() ? NULL : &(iter->second);
@@ -152,6 +163,7 @@ toolkit_function_registry::get_native_function(const function_closure_info& clos
 }
 
 std::vector<std::string> toolkit_function_registry::available_toolkit_functions() {
+  lazy.load(*this);
   std::vector<std::string> ret;
   for(auto entry : registry) {
     ret.push_back(entry.first);
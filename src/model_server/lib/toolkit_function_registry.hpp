@@ -9,6 +9,7 @@
 #include <string>
 #include <model_server/lib/toolkit_function_specification.hpp>
 #include <model_server/lib/api/function_closure_info.hpp>
+#include <model_server/lib/lazy_registration.hpp>
 namespace turi {
 
 /**
@@ -19,6 +20,7 @@ namespace turi {
 class toolkit_function_registry {
  private:
   std::map<std::string, toolkit_function_specification> registry;
+  lazy_registrations<toolkit_function_registry> lazy;
 
  public:
 
@@ -50,6 +52,14 @@ class toolkit_function_registry {
   bool register_toolkit_function(std::vector<toolkit_function_specification> spec,
                                  std::string prefix = "");
 
+  /**
+   * Defers a registration until the registry is first used. The loader is
+   * called with this registry, and name is used in the log, which records how
+   * long each loader took. See \ref lazy_registrations.
+   */
+  void register_lazy(const std::string& name,
+                     std::function<void(toolkit_function_registry&)> loader);
+
 
   /**
    * Unregisters a previously registered toolkit.
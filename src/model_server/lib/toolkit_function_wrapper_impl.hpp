@@ -272,6 +272,22 @@ struct fill_in_args {
  * a sequence from 0 to N exclusive.
  *
  */
+/**
+ * Like fill_in_args, but for the arguments of a member function, which
+ * follow the "this" argument.
+ */
+template <typename InArgType>
+struct fill_in_member_args {
+  InArgType* inargs; // pointer to the input arguments, "this" first
+  const std::vector<variant_type>* params;  // the arguments, without "this"
+
+  template<int n>
+  void operator()(boost::mpl::integral_c<int, n> t) const {
+    typedef typename std::decay<decltype(boost::fusion::at_c<n>(*inargs))>::type element_type;
+    boost::fusion::at_c<n>(*inargs) = read_arg<element_type>((*params)[n - 1]);
+  }
+};
+
 template <size_t N>
 struct make_range {
   typedef typename boost::mpl::range_c<int, 0, N>::type type;
@@ -590,6 +606,67 @@ generate_const_member_function_wrapper(Ret (T::* fn)(Args...) const,
 }
 
 
+/**
+ * Generates a wrapper around a member function, which takes the arguments
+ * positionally, in declaration order, rather than by name. This skips
+ * building and searching a variant_map_type on every call.
+ * Used by both the const and non-const overloads below.
+ */
+template <size_t NumInArgs, typename T, typename Ret, typename MemFn, typename... Args>
+std::function<variant_type(T*, const std::vector<variant_type>&)>
+generate_native_member_function_wrapper_impl(MemFn member_fn) {
+  using boost::mpl::size;
+  using boost::mpl::_1;
+  // Get an mpl::vector containing all the arguments of the member function
+  typedef typename boost::mpl::vector<T*, Args...>::type fn_args_type_original;
+  // decay it to element const, references, etc.
+  typedef typename boost::mpl::transform<fn_args_type_original, std::decay<_1>>::type fn_args_type;
+
+  static_assert(size<fn_args_type>::value == NumInArgs + 1,
+                "Invalid number arguments. #input != #function arguments.");
+  typedef fn_args_type in_arg_types;
+
+  return [member_fn](T* t, const std::vector<variant_type>& args)->variant_type {
+        if (args.size() != NumInArgs) {
+          std_log_and_throw(std::invalid_argument,
+              "Expected " + std::to_string(NumInArgs) + " arguments, got "
+              + std::to_string(args.size()));
+        }
+        typename boost::fusion::result_of::as_vector<in_arg_types>::type in_args;
+        boost::fusion::at_c<0>(in_args) = t;
+        fill_in_member_args<decltype(in_args)> in_arg_filler;
+        in_arg_filler.params = &args;
+        in_arg_filler.inargs = &in_args;
+        typename make_range2<1, size<decltype(in_args)>::value>::type in_arg_range;
+        boost::fusion::for_each(in_arg_range, in_arg_filler);
+
+        // Invoke the function call, storing the return value
+        result_of_function_wrapper<typename std::decay<Ret>::type> retval;
+        retval.call([&](){
+          return boost::fusion::invoke(member_fn, in_args);
+        });
+        if (retval.is_void) return to_variant(FLEX_UNDEFINED);
+        else return to_variant(retval.ret_value);
+      };
+}
+
+template <size_t NumInArgs, typename T, typename Ret, typename... Args>
+std::function<variant_type(T*, const std::vector<variant_type>&)>
+generate_native_member_function_wrapper(Ret (T::* fn)(Args...)) {
+  auto member_fn = std::mem_fn(fn);
+  return generate_native_member_function_wrapper_impl<
+      NumInArgs, T, Ret, decltype(member_fn), Args...>(member_fn);
+}
+
+template <size_t NumInArgs, typename T, typename Ret, typename... Args>
+std::function<variant_type(T*, const std::vector<variant_type>&)>
+generate_native_member_function_wrapper(Ret (T::* fn)(Args...) const) {
+  auto member_fn = std::mem_fn(fn);
+  return generate_native_member_function_wrapper_impl<
+      NumInArgs, T, Ret, decltype(member_fn), Args...>(member_fn);
+}
+
+
 /**
  * Generates a toolkit specification object for a user defined function which
  * wraps the user defined function with a helper that provides type checking,
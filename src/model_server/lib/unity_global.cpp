@@ -9,6 +9,7 @@
 #include <cross_platform/windows_wrapper.hpp>
 #endif
 
+#include <chrono>
 #include <core/util/syserr_reporting.hpp>
 #include <core/data/image/io.hpp>
 #include <core/logging/logger.hpp>
@@ -26,6 +27,9 @@
 #include <model_server/lib/unity_global.hpp>
 #include <perf/memory_info.hpp>
 #include <core/globals/globals.hpp>
+#include <core/globals/metrics.hpp>
+#include <core/globals/memory_accounting.hpp>
+#include <core/system/cppipc/server/call_stats.hpp>
 #include <core/storage/sframe_interface/unity_sgraph.hpp>
 #include <core/storage/sframe_interface/unity_sarray.hpp>
 #include <core/storage/sframe_interface/unity_sframe.hpp>
@@ -462,8 +466,26 @@ namespace turi {
       }
     }
 
+    // all toolkit functions go through this one call, so they are timed
+    // individually here
+    struct toolkit_call_timer {
+      cppipc::call_record record;
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      ~toolkit_call_timer() {
+        if (!cppipc::call_stats::enabled()) return;
+        record.execution_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        cppipc::call_stats::get_instance().record(record);
+      }
+    } timer;
+    timer.record.name = "toolkit:" + toolkit_name;
+    timer.record.start_time_ns = cppipc::call_stats::now_ns();
+    timer.record.error = true;
+
     try {
-      return spec->toolkit_execute_function(invocation);
+      auto ret = spec->toolkit_execute_function(invocation);
+      timer.record.error = !ret.success;
+      return ret;
     } catch (std::string s) {
       toolkit_function_response_type ret;
       ret.success = false;
@@ -608,6 +630,58 @@ namespace turi {
     }
   }
 
+  static flexible_type histogram_to_flex(const cppipc::latency_histogram& hist) {
+    flex_dict ret;
+    ret.push_back({"mean", hist.count() ? double(hist.sum()) / hist.count() : 0.0});
+    ret.push_back({"p50", flex_int(hist.quantile(0.5))});
+    ret.push_back({"p90", flex_int(hist.quantile(0.9))});
+    ret.push_back({"p99", flex_int(hist.quantile(0.99))});
+    ret.push_back({"p999", flex_int(hist.quantile(0.999))});
+    ret.push_back({"max", flex_int(hist.max())});
+    ret.push_back({"total", flex_int(hist.sum())});
+    return ret;
+  }
+
+  std::map<std::string, flexible_type> unity_global::get_call_stats(bool reset) {
+    auto& stats = cppipc::call_stats::get_instance();
+    std::map<std::string, flexible_type> ret;
+    for (const auto& method : stats.get_stats()) {
+      const cppipc::method_call_stats& s = method.second;
+      flex_dict d;
+      d.push_back({"num_calls", flex_int(s.num_calls)});
+      d.push_back({"num_errors", flex_int(s.num_errors)});
+      d.push_back({"queue_wait_us", histogram_to_flex(s.queue_wait_us)});
+      d.push_back({"execution_us", histogram_to_flex(s.execution_us)});
+      d.push_back({"request_bytes", flex_int(s.request_bytes)});
+      d.push_back({"reply_bytes", flex_int(s.reply_bytes)});
+      d.push_back({"max_request_bytes", flex_int(s.max_request_bytes)});
+      d.push_back({"max_reply_bytes", flex_int(s.max_reply_bytes)});
+      ret[method.first] = d;
+    }
+    if (reset) stats.reset();
+    return ret;
+  }
+
+  std::map<std::string, flexible_type> unity_global::get_metrics() {
+    return metrics::list_metrics();
+  }
+
+  std::string unity_global::get_prometheus_metrics() {
+    return metrics::prometheus_text();
+  }
+
+  std::map<std::string, flexible_type> unity_global::get_memory_usage(bool reset_peaks) {
+    std::map<std::string, flexible_type> ret;
+    for (const auto& tag : memory_accounting::get_usage()) {
+      flex_dict d;
+      d.push_back({"current", flex_int(tag.second.current)});
+      d.push_back({"peak", flex_int(tag.second.peak)});
+      ret[tag.first] = d;
+    }
+    if (reset_peaks) memory_accounting::reset_peaks();
+    return ret;
+  }
+
   std::shared_ptr<unity_sarray_base> unity_global::create_sequential_sarray(ssize_t size, ssize_t start, bool reverse) {
     return unity_sarray::create_sequential_sarray(size, start, reverse);
   }
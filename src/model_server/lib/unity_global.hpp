@@ -260,6 +260,40 @@ class unity_global: public unity_global_base {
    */
   std::string set_global(std::string key, flexible_type value);
 
+  /**
+   * \internal
+   * Returns the latency statistics of every call served by this process,
+   * by method name: the number of calls and errors, percentiles of queue
+   * wait and execution time in microseconds, and request and reply bytes.
+   * Toolkit functions are listed as "toolkit:<name>". If reset is true, the
+   * statistics are cleared after being read.
+   */
+  std::map<std::string, flexible_type> get_call_stats(bool reset);
+
+  /**
+   * \internal
+   * Returns the current value of every runtime metric (cache hits and
+   * misses, bytes read, spill bytes, queue depths, ...), by name.
+   * See core/globals/metrics.hpp.
+   */
+  std::map<std::string, flexible_type> get_metrics();
+
+  /**
+   * \internal
+   * Returns the runtime metrics in the Prometheus text exposition format.
+   */
+  std::string get_prometheus_metrics();
+
+  /**
+   * \internal
+   * Returns the estimated bytes held by the large in-memory structures (ml_data
+   * blocks, join hash tables, sort and groupby buffers, model parameters,
+   * ...), by tag: a dictionary of the "current" bytes and the "peak" bytes
+   * held at once. If reset_peaks is true, the peaks are lowered to the
+   * current bytes after being read. See core/globals/memory_accounting.hpp.
+   */
+  std::map<std::string, flexible_type> get_memory_usage(bool reset_peaks);
+
   /**
    * \internal
    * Create a sequentially increasing (or decreasing) SArray.
@@ -18,6 +18,7 @@
 #include <model_server/lib/toolkit_class_registry.hpp>
 #include <model_server/lib/toolkit_function_registry.hpp>
 #include <core/system/startup_teardown/startup_teardown.hpp>
+#include <timer/timer.hpp>
 #ifdef TC_HAS_PYTHON
 #include <core/system/lambda/lambda_master.hpp>
 #endif
@@ -43,27 +44,53 @@ void unity_server::start(const unity_server_initializer& server_initializer) {
       global_logger().set_log_file(options.log_file);
     }
   }
+  if (options.log_async || std::getenv("TURI_LOG_ASYNC") != NULL) {
+    global_logger().set_async(true);
+  }
+
+  // time each step, to log where the startup time goes
+  std::vector<std::pair<std::string, double>> startup_profile;
+  timer step_timer;
+  auto end_step = [&](const char* step) {
+    startup_profile.push_back({step, step_timer.current_time_millis()});
+    step_timer.start();
+  };
 
   turi::configure_global_environment(options.root_path);
+  end_step("configure_global_environment");
   turi::global_startup::get_instance().perform_startup();
+  end_step("global_startup");
 
   // initialize built-in data structures, toolkits and models,
-  // defined in registration.cpp
+  // defined in registration.cpp. The default initializer defers the
+  // registrations until the registries are first used.
   server_initializer.init_toolkits(*toolkit_functions);
+  end_step("init_toolkits");
   server_initializer.init_models(*toolkit_classes);
+  end_step("init_models");
 
   create_unity_global_singleton(toolkit_functions,
                                 toolkit_classes);
+  end_step("create_unity_global");
 
   auto unity_global_ptr = get_unity_global_singleton();
 
   // initialize extension modules and lambda workers
   server_initializer.init_extensions(options.root_path, unity_global_ptr);
+  end_step("init_extensions");
 
 #ifdef TC_HAS_PYTHON
   lambda::set_pylambda_worker_binary_from_environment_variables();
 #endif
 
+  double total_ms = 0;
+  for (const auto& step : startup_profile) total_ms += step.second;
+  logstream(LOG_INFO) << "Server started in " << total_ms << "ms" << std::endl;
+  for (const auto& step : startup_profile) {
+    logstream(LOG_INFO) << "  " << step.first << ": " << step.second << "ms"
+                        << std::endl;
+  }
+
   log_thread.launch([=]() {
                       do {
                         std::pair<std::string, bool> queueelem = this->log_queue.dequeue();
@@ -20,11 +20,12 @@ namespace turi {
 unity_server_initializer::~unity_server_initializer() {}
 
 void unity_server_initializer::init_toolkits(toolkit_function_registry& registry) const {
-  register_functions(registry);
+  // filled on first use, see lazy_registrations
+  registry.register_lazy("built-in toolkit functions", register_functions);
 };
 
 void unity_server_initializer::init_models(toolkit_class_registry& registry) const {
-  register_models(registry);
+  registry.register_lazy("built-in toolkit classes", register_models);
 };
 
 void unity_server_initializer::init_extensions(
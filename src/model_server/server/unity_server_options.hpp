@@ -16,6 +16,8 @@ struct unity_server_options {
   bool daemon = false;
   size_t log_rotation_interval = 0;
   size_t log_rotation_truncate = 0;
+  /// Write log lines on a background thread. Also set by TURI_LOG_ASYNC.
+  bool log_async = false;
 };
 
 
@@ -6,6 +6,7 @@
 #cython: boundscheck=False, wraparound=False
 
 from cy_flexible_type cimport flexible_type, flex_type_enum, UNDEFINED, flex_int
+from cy_flexible_type cimport INTEGER, FLOAT
 from cy_flexible_type cimport flexible_type_from_pyobject
 from cy_flexible_type cimport process_common_typed_list
 from cy_flexible_type cimport pyobject_from_flexible_type
@@ -98,6 +99,70 @@ cdef extern from "<core/system/lambda/pylambda.hpp>" namespace "turi::lambda":
     void set_pylambda_evaluation_functions(pylambda_evaluation_functions* eval_function_struct)
 
 
+################################################################################
+# Columnar conversions for vectorized lambdas.
+
+cdef object _values_to_array(const flexible_type* values, long n):
+    """
+    Returns the n values as a numpy array: int64 if they are all integers,
+    float64 if they are all numbers, and an object array otherwise.
+    """
+    import numpy as np
+
+    cdef long i
+    cdef bint all_int = True, all_numeric = True
+    cdef flex_type_enum t
+
+    for i in range(n):
+        t = values[i].get_type()
+        if t != INTEGER:
+            all_int = False
+            if t != FLOAT:
+                all_numeric = False
+                break
+
+    cdef long long[:] int_view
+    cdef double[:] float_view
+
+    if all_int:
+        ret = np.empty(n, dtype=np.int64)
+        int_view = ret
+        for i in range(n):
+            int_view[i] = values[i].get_int()
+    elif all_numeric:
+        ret = np.empty(n, dtype=np.float64)
+        float_view = ret
+        for i in range(n):
+            float_view[i] = values[i].as_double()
+    else:
+        ret = np.empty(n, dtype=object)
+        for i in range(n):
+            ret[i] = pyobject_from_flexible_type(values[i])
+    return ret
+
+cdef object _rows_column_to_array(const vector[vector[flexible_type]]* rows,
+                                  list row_ids, long column):
+    """
+    Returns column of the rows listed in row_ids as a numpy array.
+    """
+    cdef long i
+    cdef vector[flexible_type] values
+    values.resize(len(row_ids))
+    for i in range(len(row_ids)):
+        values[i] = rows[0][<long>row_ids[i]][column]
+    return _values_to_array(values.data(), values.size())
+
+cdef list _array_to_list(object ret, long n):
+    """
+    Checks that a vectorized lambda returned one value per input row, and
+    returns them as a list of python objects.
+    """
+    cdef list values = list(ret.tolist() if hasattr(ret, "tolist") else ret)
+    if len(values) != n:
+        raise ValueError("Vectorized lambda function returned %d values; "
+                         "expected one per row (%d)." % (len(values), n))
+    return values
+
 ################################################################################
 # Lambda evaluation class.
 
@@ -113,6 +178,8 @@ cdef class lambda_evaluator(object):
     cdef list keys
     cdef dict arg_dict_base
     cdef bytes lambda_string
+    cdef bint vectorized_apply
+    cdef bint vectorized_triple_apply
 
     def __init__(self, bytes lambda_string):
 
@@ -135,6 +202,13 @@ cdef class lambda_evaluator(object):
 
         self.output_buffer = []
 
+        # Functions can opt into being called once per batch with numpy
+        # arrays (one per column) instead of once per row.
+        self.vectorized_apply = bool(
+            getattr(self.lambda_function, "vectorized_apply", False))
+        self.vectorized_triple_apply = bool(
+            getattr(self.lambda_function, "vectorized_triple_apply", False))
+
     @cython.boundscheck(False)
     cdef _set_dict_keys(self, const vector[string]* input_keys):
         cdef long n_keys = input_keys[0].size()
@@ -149,6 +223,18 @@ cdef class lambda_evaluator(object):
         # Now, build the base arg_dict_base
         self.arg_dict_base = {k : None for k in self.keys}
 
+    cdef _skip_undefined_rows(self, bint skip_undefined, const flexible_type* v_in, long n):
+        """
+        Sets the outputs of undefined inputs to None, for vectorized lambdas,
+        which are called on undefined values too.
+        """
+        cdef long i
+        if not skip_undefined:
+            return
+        for i in range(n):
+            if v_in[i].get_type() == UNDEFINED:
+                self.output_buffer[i] = None
+
     @cython.boundscheck(False)
     cdef eval_simple(self, lambda_call_data* lcd):
 
@@ -158,6 +244,13 @@ cdef class lambda_evaluator(object):
         if len(self.output_buffer) != n:
             self.output_buffer = [None]*n
 
+        if self.vectorized_apply:
+            self.output_buffer = _array_to_list(
+                self.lambda_function(_values_to_array(v_in, n)), n)
+            self._skip_undefined_rows(lcd.skip_undefined, v_in, n)
+            process_common_typed_list(lcd.output_values, self.output_buffer, lcd.output_enum_type)
+            return
+
         cdef long i
         cdef object x
 
@@ -184,6 +277,17 @@ cdef class lambda_evaluator(object):
         if len(self.output_buffer) != n:
             self.output_buffer = [None]*n
 
+        cdef dict columns
+        cdef list rows
+        if self.vectorized_apply:
+            columns = {}
+            rows = list(range(n))
+            for j in range(n_keys):
+                columns[self.keys[j]] = _rows_column_to_array(lcd.input_rows, rows, j)
+            self.output_buffer = _array_to_list(self.lambda_function(columns), n)
+            process_common_typed_list(lcd.output_values, self.output_buffer, lcd.output_enum_type)
+            return
+
         for i in range(n):
             if lcd.input_keys[0][i].size() != n_keys:
                 raise ValueError("Row %d does not have the correct number of rows (%d, should be %d)"
@@ -213,6 +317,19 @@ cdef class lambda_evaluator(object):
         if len(self.output_buffer) != n:
             self.output_buffer = [None]*n
 
+        cdef vector[flexible_type] column
+        cdef dict columns
+        if self.vectorized_apply:
+            columns = {}
+            column.resize(n)
+            for j in range(n_keys):
+                for i in range(n):
+                    column[i] = lcd.input_rows[0].at(i).at(j)
+                columns[self.keys[j]] = _values_to_array(column.data(), n)
+            self.output_buffer = _array_to_list(self.lambda_function(columns), n)
+            process_common_typed_list(lcd.output_values, self.output_buffer, lcd.output_enum_type)
+            return
+
         for i in range(n):
             arg_dict = self.arg_dict_base.copy()
 
@@ -273,6 +390,10 @@ cdef class lambda_evaluator(object):
     @cython.boundscheck(False)
     cdef eval_graph_triple_apply(self, lambda_graph_triple_apply_data* lcg):
 
+        if self.vectorized_triple_apply:
+            self.eval_graph_triple_apply_vectorized(lcg)
+            return
+
         cdef long i, j
         cdef long n_edges = lcg.all_edge_data[0].size()
         cdef long n_edge_keys = lcg.edge_keys[0].size()
@@ -347,6 +468,105 @@ cdef class lambda_evaluator(object):
 
         # And we're done!
 
+    cdef list _returned_columns(self, object ret_dict, list keys, long n_edges, str name):
+        """
+        Validates a dictionary of columns returned by a vectorized triple
+        apply lambda, and returns a list of (key index, values) pairs.
+        """
+        cdef list ret = []
+        cdef list decoded_keys = [k.decode() for k in keys]
+
+        if ret_dict is None:
+            return ret
+        if type(ret_dict) is not dict:
+            raise TypeError("%s return argument of lambda function not a dictionary." % name)
+
+        for k, v in (<dict>ret_dict).items():
+            try:
+                key_index = decoded_keys.index(k)
+            except ValueError:
+                raise KeyError("Return dictionary has invalid key '%s'; possible keys are: %s" %
+                               (str(k), ", ".join("'%s'" % k2 for k2 in decoded_keys)))
+            values = list(v.tolist() if hasattr(v, "tolist") else v)
+            if len(values) != n_edges:
+                raise ValueError("Column '%s' returned by the lambda function has %d values; "
+                                 "expected one per edge (%d)." % (k, len(values), n_edges))
+            ret.append((key_index, values))
+        return ret
+
+    @cython.boundscheck(False)
+    cdef eval_graph_triple_apply_vectorized(self, lambda_graph_triple_apply_data* lcg):
+        """
+        Evaluates a lambda function with a true "vectorized_triple_apply"
+        attribute once on the whole batch of edges, instead of once per edge.
+
+        The function is called with (source, edge, target) dictionaries
+        mapping each field to a numpy array with one value per edge of the
+        batch, and must return a tuple of 3 dictionaries (or None) mapping
+        the fields it changes to arrays of the same length. When several
+        edges of the batch write a field of the same vertex, the value of the
+        last edge wins, as with numpy fancy-index assignment.
+        """
+        cdef long i, j
+        cdef long n_edges = lcg.all_edge_data[0].size()
+        cdef long n_edge_keys = lcg.edge_keys[0].size()
+        cdef long n_vertex_keys = lcg.vertex_keys[0].size()
+        cdef long n_mutated_edges = lcg.mutated_edge_keys[0].size()
+
+        cdef list edge_keys = [lcg.edge_keys[0][j] for j in range(n_edge_keys)]
+        cdef list vertex_keys = [lcg.vertex_keys[0][j] for j in range(n_vertex_keys)]
+        cdef list mutated_edge_key_index = [edge_keys.index(lcg.mutated_edge_keys[0][j])
+                                            for j in range(n_mutated_edges)]
+
+        cdef list edge_rows = list(range(n_edges))
+        cdef list srcids = [lcg.all_edge_data[0][i][lcg.srcid_column].get_int()
+                            for i in range(n_edges)]
+        cdef list dstids = [lcg.all_edge_data[0][i][lcg.dstid_column].get_int()
+                            for i in range(n_edges)]
+
+        cdef dict edge_columns = {}, source_columns = {}, target_columns = {}
+        for j in range(n_edge_keys):
+            edge_columns[edge_keys[j].decode()] = \
+                _rows_column_to_array(lcg.all_edge_data, edge_rows, j)
+        for j in range(n_vertex_keys):
+            source_columns[vertex_keys[j].decode()] = \
+                _rows_column_to_array(lcg.source_partition, srcids, j)
+            target_columns[vertex_keys[j].decode()] = \
+                _rows_column_to_array(lcg.target_partition, dstids, j)
+
+        _ret = self.lambda_function(source_columns, edge_columns, target_columns)
+
+        if _ret is None or type(_ret) is not tuple or len(<tuple>_ret) != 3:
+            raise TypeError("Lambda function must return a tuple of 3 dictionaries of the form "
+                            "(source_data, edge_data, target_data).")
+        cdef tuple ret = <tuple>_ret
+
+        cdef list source_updates = self._returned_columns(ret[0], vertex_keys, n_edges, "First")
+        cdef list edge_updates = self._returned_columns(ret[1], edge_keys, n_edges, "Second")
+        cdef list target_updates = self._returned_columns(ret[2], vertex_keys, n_edges, "Third")
+
+        # edges are applied in order, so the last write to a vertex wins
+        cdef dict edge_values = dict(edge_updates)
+        cdef long key_index
+        cdef flexible_type* out
+        for i in range(n_edges):
+            out = lcg.source_partition[0][<long>srcids[i]].data()
+            for key_index, values in source_updates:
+                out[key_index] = flexible_type_from_pyobject(values[i])
+            out = lcg.target_partition[0][<long>dstids[i]].data()
+            for key_index, values in target_updates:
+                out[key_index] = flexible_type_from_pyobject(values[i])
+
+            if n_mutated_edges != 0:
+                lcg.out_edge_data[0][i].resize(n_mutated_edges)
+                out = lcg.out_edge_data[0][i].data()
+                for j in range(n_mutated_edges):
+                    key_index = mutated_edge_key_index[j]
+                    if key_index in edge_values:
+                        out[j] = flexible_type_from_pyobject(edge_values[key_index][i])
+                    else:
+                        out[j] = lcg.all_edge_data[0][i][key_index]
+
 
 ################################################################################
 # Wrapping functions
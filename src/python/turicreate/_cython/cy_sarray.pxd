@@ -63,6 +63,7 @@ cdef extern from "<core/storage/sframe_interface/unity_sarray.hpp>" namespace "t
         unity_sarray_base_ptr hash(int) except +
         void materialize() except +
         bint is_materialized() except +
+        gl_options_map explain() except +
         unity_sarray_base_ptr append(unity_sarray_base_ptr) except +
         unity_sarray_base_ptr count_bag_of_words(gl_options_map) except +
         unity_sarray_base_ptr count_character_ngrams(size_t, gl_options_map) except +
@@ -180,6 +181,8 @@ cdef class UnitySArrayProxy:
 
     cpdef is_materialized(self)
 
+    cpdef explain(self)
+
     cpdef append(self, UnitySArrayProxy other)
 
     cpdef count_bag_of_words(self, object op)
@@ -331,6 +331,9 @@ cdef class UnitySArrayProxy:
     cpdef is_materialized(self):
         return self.thisptr.is_materialized()
 
+    cpdef explain(self):
+        return pydict_from_gl_options_map(self.thisptr.explain())
+
     cpdef append(self, UnitySArrayProxy other):
         cdef unity_sarray_base_ptr proxy
         with nogil:
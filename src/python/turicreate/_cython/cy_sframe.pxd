@@ -58,11 +58,14 @@ cdef extern from "<core/storage/sframe_interface/unity_sframe.hpp>" namespace "t
         bint is_materialized() except +
         bint has_size() except +
         string query_plan_string() except +
+        string explain_analyze() except +
+        gl_options_map explain() except +
         unity_sframe_base_ptr join(unity_sframe_base_ptr, const string, map[string, string]) except +
         unity_sframe_base_ptr join_with_custom_name(unity_sframe_base_ptr, const string, map[string, string], map[string, string]) except +
         unity_sarray_base_ptr pack_columns(const vector[string]&, const vector[string]&, flex_type_enum , const flexible_type&) except +
         unity_sframe_base_ptr stack (const string& , const vector[string]& , const vector[flex_type_enum]&, bint) except +
         unity_sframe_base_ptr sort(const vector[string]&, const vector[int]&) except +
+        unity_sframe_base_ptr topk(const vector[string]&, const vector[int]&, size_t) except +
         unity_sframe_base_ptr copy_range(size_t, size_t, size_t) except +
         cpplist[unity_sframe_base_ptr] drop_missing_values(const vector[string]&, bint, bint, bint) except +
         void delete_on_close() except +
@@ -142,6 +145,10 @@ cdef class UnitySFrameProxy:
 
     cpdef query_plan_string(self)
 
+    cpdef explain_analyze(self)
+
+    cpdef explain(self)
+
     cpdef join(self, UnitySFrameProxy right, how, dict on)
 
     cpdef join_with_custom_name(self, UnitySFrameProxy right, how, dict on, dict alter_name)
@@ -152,6 +159,8 @@ cdef class UnitySFrameProxy:
 
     cpdef sort(self, column_names, vector[int] sort_orders)
 
+    cpdef topk(self, column_names, vector[int] sort_orders, size_t k)
+
     cpdef copy_range(self, size_t start, size_t step, size_t end)
 
     cpdef drop_missing_values(self, columns, bint is_all, bint split, bint recursive)
@@ -287,6 +287,12 @@ cdef class UnitySFrameProxy:
     cpdef query_plan_string(self):
         return cpp_to_str(self.thisptr.query_plan_string())
 
+    cpdef explain_analyze(self):
+        return cpp_to_str(self.thisptr.explain_analyze())
+
+    cpdef explain(self):
+        return pydict_from_gl_options_map(self.thisptr.explain())
+
     cpdef join(self, UnitySFrameProxy right, _how, dict _on):
         cdef unity_sframe_base_ptr proxy
         cdef map[string,string] on = dict_to_string_string_map(_on)
@@ -340,6 +346,15 @@ cdef class UnitySFrameProxy:
 
         return create_proxy_wrapper_from_existing_proxy(proxy)
 
+    cpdef topk(self, _sort_columns, vector[int] sort_orders, size_t k):
+        cdef vector[string] sort_columns = to_vector_of_strings(_sort_columns)
+        cdef unity_sframe_base_ptr proxy
+        cdef vector[int] orders = [int(i) for i in sort_orders]
+        with nogil:
+            proxy = (self.thisptr.topk(sort_columns, orders, k))
+
+        return create_proxy_wrapper_from_existing_proxy(proxy)
+
     cpdef drop_missing_values(self, _columns, bint is_all, bint split, bint recursive):
         cdef vector[string] columns = to_vector_of_strings(_columns)
         cdef cpplist[unity_sframe_base_ptr] sf_array
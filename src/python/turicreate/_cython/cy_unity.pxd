@@ -74,6 +74,14 @@ cdef extern from "<model_server/lib/unity_global.hpp>" namespace "turi":
 
         string set_global(string, flexible_type) except +
 
+        gl_options_map get_call_stats(bint) except +
+
+        gl_options_map get_metrics() except +
+
+        string get_prometheus_metrics() except +
+
+        gl_options_map get_memory_usage(bint) except +
+
         unity_sarray_base_ptr create_sequential_sarray(ssize_t, ssize_t, bint) except +
 
         string load_toolkit(string soname, string module_subpath) except +
@@ -143,6 +151,14 @@ cdef class UnityGlobalProxy:
 
     cpdef set_global(self, key, object value)
 
+    cpdef get_call_stats(self, bint reset)
+
+    cpdef get_metrics(self)
+
+    cpdef get_prometheus_metrics(self)
+
+    cpdef get_memory_usage(self, bint reset_peaks)
+
     cpdef create_sequential_sarray(self, ssize_t size, ssize_t start, bint reverse)
 
     cpdef load_toolkit(self, soname, module_subpath)
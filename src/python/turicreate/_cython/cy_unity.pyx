@@ -181,6 +181,18 @@ cdef class UnityGlobalProxy:
         return cpp_to_str(self.thisptr.set_global(str_to_cpp(key),
                                                   flexible_type_from_pyobject(value)))
 
+    cpdef get_call_stats(self, bint reset):
+        return pydict_from_gl_options_map(self.thisptr.get_call_stats(reset))
+
+    cpdef get_metrics(self):
+        return pydict_from_gl_options_map(self.thisptr.get_metrics())
+
+    cpdef get_prometheus_metrics(self):
+        return cpp_to_str(self.thisptr.get_prometheus_metrics())
+
+    cpdef get_memory_usage(self, bint reset_peaks):
+        return pydict_from_gl_options_map(self.thisptr.get_memory_usage(reset_peaks))
+
     cpdef create_sequential_sarray(self, ssize_t size, ssize_t start, bint reverse):
         cdef unity_sarray_base_ptr proxy
         with nogil:
@@ -22,8 +22,6 @@ namespace activity_classification {
 
 namespace {
 
-using ::turi::neural_net::shared_float_array;
-
 static std::map<std::string,size_t> generate_column_index_map(const std::vector<std::string>& column_names) {
     std::map<std::string,size_t> index_map;
     for (size_t k=0; k < column_names.size(); ++k) {
@@ -281,143 +279,6 @@ variant_map_type _activity_classifier_prepare_data_impl(const gl_sframe &data,
     return result_dict;
 }
 
-variant_map_type _activity_classifier_prepare_data_aug_impl(
-    const gl_sframe &data, const std::vector<std::string> &features,
-    const std::string &session_id, int prediction_window,
-    int predictions_in_chunk, const std::string &target, bool verbose) {
-
-#ifndef NDEBUG
-  DASSERT_GT(features.size(), 0);
-  DASSERT_TRUE(prediction_window > 0);
-  DASSERT_TRUE(predictions_in_chunk > 0);
-  DASSERT_TRUE(data.contains_column(session_id));
-  for (auto &feat : features) {
-    DASSERT_TRUE(data.contains_column(feat));
-  }
-#endif
-
-  bool use_target = (target != "");
-  DASSERT_TRUE(!use_target || data.contains_column(target));
-
-  if (verbose) {
-    logprogress_stream << "Pre-processing " << data.size() << " samples..."
-                       << std::endl;
-  }
-
-  // Build a dict of the column order by column name, to later access within
-  // the iterator
-  auto column_index_map = generate_column_index_map(data.column_names());
-  size_t chunk_length = prediction_window * predictions_in_chunk;
-
-  flex_vec curr_chunk_targets;
-  flex_vec curr_chunk_features;
-
-  flexible_type last_session_id = data[session_id][0];
-  size_t number_of_sessions = 0;
-
-  // Prepare an output SFrame writer, that will write a new SFrame in the
-  // converted batch-processing ready format.
-  std::vector<std::string> output_column_names = {"features", "chunk_len",
-                                                  "session_id"};
-  std::vector<flex_type_enum> output_column_types = {flex_type_enum::VECTOR,
-                                                     flex_type_enum::INTEGER,
-                                                     data[session_id].dtype()};
-  if (use_target) {
-    output_column_names.push_back("target");
-    output_column_types.push_back(flex_type_enum::VECTOR);
-  }
-
-  gl_sframe_writer output_writer(output_column_names, output_column_types, 1);
-
-  if (verbose) {
-    logprogress_stream << "Using sequences of size " << chunk_length
-                       << " for model creation." << std::endl;
-  }
-
-  time_t last_print_time = time(0);
-  size_t processed_lines = 0;
-
-  // Iterate over the user data. The features and targets are aggregated, and
-  // handled whenever at the ending of a session is reached.
-  size_t chunk_size = 0;
-  for (const auto &line : data.range_iterator()) {
-    flexible_type curr_session_id = line[column_index_map[session_id]];
-
-    if (curr_session_id != last_session_id) {
-
-      // Write the aggregated data of the current chunk (which includes all
-      // the samples in the current session) as a single new vector in the
-      // converted SFrame, and init all aggregation vectors to begin a new
-      // chunk.
-      if (curr_chunk_features.size() > 0) {
-        if (use_target) {
-          output_writer.write({curr_chunk_features, chunk_size, last_session_id,
-                               curr_chunk_targets},
-                              0);
-        } else {
-          output_writer.write(
-              {curr_chunk_features, chunk_size, last_session_id}, 0);
-        }
-        curr_chunk_features.clear();
-        curr_chunk_targets.clear();
-      }
-
-      chunk_size = 0;
-      last_session_id = curr_session_id;
-      number_of_sessions++;
-    }
-
-    chunk_size += 1;
-
-    for (const std::string &feature_name : features) {
-      curr_chunk_features.push_back(line[column_index_map[feature_name]]);
-    }
-
-    if (use_target) {
-      curr_chunk_targets.push_back(line[column_index_map[target]]);
-    }
-
-    time_t now = time(0);
-    if (verbose && difftime(now, last_print_time) > 10) {
-      logprogress_stream << "Pre-processing: " << std::setw(3)
-                         << (100 * processed_lines / data.size())
-                         << "% complete" << std::endl;
-      last_print_time = now;
-    }
-    processed_lines += 1;
-  }
-
-
-  if (curr_chunk_features.size() > 0) {
-    if (use_target) {
-      output_writer.write({curr_chunk_features, chunk_size, last_session_id,
-                           curr_chunk_targets},
-                          0);
-    } else {
-      output_writer.write({curr_chunk_features, chunk_size, last_session_id},
-                          0);
-    }
-    curr_chunk_features.clear();
-    curr_chunk_targets.clear();
-  }
-
-  // Update the count of the last session in the dataset
-  number_of_sessions++;
-
-  if (verbose) {
-    logprogress_stream << "Processed a total of " << number_of_sessions
-                       << " sessions." << std::endl;
-  }
-  gl_sframe converted_sframe = output_writer.close();
-  converted_sframe.materialize();
-
-  variant_map_type result_dict;
-  result_dict["converted_data"] = converted_sframe;
-  result_dict["num_of_sessions"] = number_of_sessions;
-
-  return result_dict;
-}
-
 }  // namespace
 
 variant_map_type _activity_classifier_prepare_data( const gl_sframe &data,
@@ -488,18 +349,48 @@ simple_data_iterator::preprocessed_data simple_data_iterator::preprocess_data(
       data[params.target_column_name].apply(encoding_fn, flex_type_enum::FLOAT);
   }
 
-  // Chunk the data, so that each row of the resulting SFrame corresponds to a
-  // all samples in a session from the original SFrame.
-  variant_map_type result_map = _activity_classifier_prepare_data_aug_impl(
-      data, feature_column_names, params.session_id_column_name,
-      static_cast<int>(params.prediction_window),
-      static_cast<int>(params.predictions_in_chunk), params.target_column_name,
-      /* verbose */ params.is_train);
+  if (params.is_train) {
+    logprogress_stream << "Pre-processing " << data.size() << " samples..."
+                       << std::endl;
+    logprogress_stream << "Using sequences of size "
+                       << params.prediction_window * params.predictions_in_chunk
+                       << " for model creation." << std::endl;
+  }
+
+  // Keep just the columns read by the iterator: the features, then the
+  // session ID, then the encoded target. The chunks are cut from these rows
+  // while traversing them, so no row ever holds more than one sample.
+  std::vector<std::string> column_names = feature_column_names;
+  column_names.push_back(params.session_id_column_name);
+  if (has_target) {
+    column_names.push_back(params.target_column_name);
+  }
+  gl_sframe samples = data.select_columns(column_names);
+
+  // Write the encoded targets out once, rather than on every traversal.
+  samples.materialize();
+
+  // Find the length of each session, assuming the rows of each session are
+  // contiguous.
+  std::vector<size_t> session_lengths;
+  flexible_type last_session_id = FLEX_UNDEFINED;
+  for (const flexible_type& session_id :
+       samples[params.session_id_column_name].range_iterator()) {
+    if (session_lengths.empty() || session_id != last_session_id) {
+      session_lengths.push_back(0);
+      last_session_id = session_id;
+    }
+    ++session_lengths.back();
+  }
+
+  if (params.is_train) {
+    logprogress_stream << "Processed a total of " << session_lengths.size()
+                       << " sessions." << std::endl;
+  }
 
   preprocessed_data result;
-  result.chunks = variant_get_value<gl_sframe>(result_map.at("converted_data"));
-  result.num_sessions =
-      variant_get_value<size_t>(result_map.at("num_of_sessions"));
+  result.samples = std::move(samples);
+  result.session_lengths = std::move(session_lengths);
   result.session_id_type = data[params.session_id_column_name].dtype();
   result.has_target = has_target;
   result.feature_names = flex_list(feature_column_names.begin(),
@@ -512,13 +403,13 @@ simple_data_iterator::simple_data_iterator(const parameters &params)
     : data_(preprocess_data(params)),
       num_samples_per_prediction_(params.prediction_window),
       num_predictions_per_chunk_(params.predictions_in_chunk),
-      range_iterator_(data_.chunks.range_iterator()),
+      range_iterator_(data_.samples.range_iterator()),
       next_row_(range_iterator_.begin()),
       end_of_rows_(range_iterator_.end()),
-      sample_in_row_(0),
       is_train_(params.is_train),
       use_data_augmentation_(params.use_data_augmentation),
-      random_engine_(params.random_seed)
+      random_engine_(params.random_seed),
+      num_prefetch_workers_(params.num_prefetch_workers)
 {}
 
 const flex_list& simple_data_iterator::feature_names() const {
@@ -534,11 +425,41 @@ flex_type_enum simple_data_iterator::session_id_type() const {
 }
 
 bool simple_data_iterator::has_next_batch() const {
+  if (prefetcher_) return prefetcher_->has_next();
   return next_row_ != end_of_rows_;
 }
 
 data_iterator::batch simple_data_iterator::next_batch(size_t batch_size) {
+  if (num_prefetch_workers_ == 0) {
+    return read_batch(batch_size);
+  }
+
+  if (!prefetcher_) {
+    // Start reading ahead, now that we know the batch size.
+    prefetch_pipeline::options opts;
+    opts.num_workers = num_prefetch_workers_;
+    opts.queue_depth = 2 * num_prefetch_workers_;
+    prefetch_batch_size_ = batch_size;
+    prefetcher_.reset(new prefetch_pipeline(
+        [this, batch_size](batch* out) {
+          if (next_row_ == end_of_rows_) return false;
+          *out = read_batch(batch_size);
+          return true;
+        },
+        [](batch b) { return b; }, opts));
+  } else if (batch_size != prefetch_batch_size_) {
+    log_and_throw("The batch size must not change while prefetching batches.");
+  }
+
+  batch result;
+  if (!prefetcher_->next(&result)) {
+    // The traversal is over, and the workers no longer read the rows.
+    result = read_batch(batch_size);
+  }
+  return result;
+}
 
+data_iterator::batch simple_data_iterator::read_batch(size_t batch_size) {
 
   size_t num_samples_per_chunk =
       num_samples_per_prediction_ * num_predictions_per_chunk_;
@@ -546,34 +467,31 @@ data_iterator::batch simple_data_iterator::next_batch(size_t batch_size) {
   size_t features_stride = num_samples_per_chunk * num_features;
   size_t features_size = batch_size * features_stride;
 
-  // Identify column indices for future reference.
-  size_t features_column_index = data_.chunks.column_index("features");
-  size_t chunk_len_column_index = data_.chunks.column_index("chunk_len");
-  size_t session_id_column_index = data_.chunks.column_index("session_id");
-  size_t labels_column_index = 0;
+  // The columns of data_.samples: the features, the session ID, the target.
+  size_t session_id_column_index = num_features;
+  size_t labels_column_index = num_features + 1;
 
-  if (data_.has_target) {
-    labels_column_index = data_.chunks.column_index("target");
-  }
-
-  // Allocate buffers for the resulting batch data.
-  std::vector<float> features(features_size, 0.f);
+  // Take zeroed buffers for the resulting batch data from the pool.
+  std::vector<float> features = buffer_pool_.acquire(features_size);
   std::vector<float> labels;
   std::vector<float> weights;
   std::vector<float> labels_per_row;
   if (data_.has_target) {
     size_t labels_size = batch_size * num_predictions_per_chunk_;
     size_t labels_per_row_size = batch_size * num_samples_per_chunk;
-    labels.resize(labels_size, 0.f);
-    weights.resize(labels_size, 0.f);
-    labels_per_row.resize(labels_per_row_size, 0.f);
-
+    labels = buffer_pool_.acquire(labels_size);
+    weights = buffer_pool_.acquire(labels_size);
+    labels_per_row = buffer_pool_.acquire(labels_per_row_size);
   }
   std::vector<batch::chunk_info> batch_info;
   batch_info.reserve(batch_size);
 
-  // Iterate through SFrame rows until filling the batch or reaching the end of
-  // the data.
+  // The labels of the samples of the current chunk.
+  flex_vec chunk_labels;
+  chunk_labels.reserve(num_samples_per_chunk);
+
+  // Cut chunks from the samples, one session at a time, until filling the
+  // batch or reaching the end of the data.
   float* features_out = features.data();
   float* labels_out = labels.data();
   float* weights_out = weights.data();
@@ -581,76 +499,88 @@ data_iterator::batch simple_data_iterator::next_batch(size_t batch_size) {
 
   while (batch_info.size() < batch_size && next_row_ != end_of_rows_) {
 
-    const sframe_rows::row& row = *next_row_;
+    size_t session_length = data_.session_lengths[session_index_];
 
-    flex_int chunk_length = row[chunk_len_column_index].get<flex_int>();
-
-    // Only for training, we introduce a random offset
-    if (sample_in_row_ == 0 &&
-        static_cast<size_t>(chunk_length) > num_samples_per_prediction_ &&
+    // Only for training, we introduce a random offset, skipping the first
+    // samples of the session.
+    if (sample_in_session_ == 0 &&
+        session_length > num_samples_per_prediction_ &&
         is_train_ && use_data_augmentation_) {
       std::uniform_int_distribution<size_t> dist(
           0, num_samples_per_prediction_ - 1);
-      sample_in_row_ = dist(random_engine_);
+      size_t offset = dist(random_engine_);
+      for (size_t i = 0; i < offset; ++i) {
+        ++next_row_;
+      }
+      sample_in_session_ = offset;
     }
 
-    // Stores the start of next instance
-    size_t jump = sample_in_row_ + num_samples_per_chunk;
+    // The chunk ends after num_samples_per_chunk samples or with the session.
+    size_t chunk_begin = sample_in_session_;
+    size_t chunk_end =
+        std::min(chunk_begin + num_samples_per_chunk, session_length);
 
-    // End keeps track of the start of next instance if the last instance is
-    // smaller
-    size_t end = std::min(jump, static_cast<size_t>(chunk_length));
-
-    // Copy the feature values (converting from double to float).
-    const flex_vec& feature_vec = row[features_column_index].get<flex_vec>();
+    batch_info.emplace_back();
+    batch_info.back().session_id = (*next_row_)[session_id_column_index];
+    batch_info.back().num_samples = chunk_end - chunk_begin;
+
+    // Copy the feature values (converting from double to float), and the
+    // labels of the samples.
+    chunk_labels.clear();
+    float* sample_out = features_out;
+    for (size_t i = chunk_begin; i < chunk_end; ++i) {
+      const sframe_rows::row& row = *next_row_;
+      for (size_t j = 0; j < num_features; ++j) {
+        sample_out[j] = static_cast<float>(row[j].to<flex_float>());
+      }
+      sample_out += num_features;
 
-    std::copy(feature_vec.begin() + sample_in_row_ * num_features,
-              feature_vec.begin() + end * num_features, features_out);
-    features_out += num_features * num_samples_per_chunk;
+      if (data_.has_target) {
+        chunk_labels.push_back(row[labels_column_index].to<flex_float>());
+      }
+      ++next_row_;
+    }
+    features_out += features_stride;
 
     if (data_.has_target) {
 
-      const flex_vec &label_vec = row[labels_column_index].get<flex_vec>();
-      std::copy(label_vec.begin() + sample_in_row_, label_vec.begin() + end, labels_per_row_out);
+      std::copy(chunk_labels.begin(), chunk_labels.end(), labels_per_row_out);
       labels_per_row_out += num_samples_per_chunk;
 
       // The label is picked using majority voting for every prediction_window
-      for (size_t i = sample_in_row_; i < end;
+      for (size_t i = 0; i < chunk_labels.size();
            i += num_samples_per_prediction_) {
-        size_t window_end = std::min(i + num_samples_per_prediction_, end);
-        double label =
-            vec_mode(label_vec.begin() + i, label_vec.begin() + window_end);
-        labels_out[(i - sample_in_row_) / num_samples_per_prediction_] =
-            static_cast<float>(label);
-        weights_out[(i - sample_in_row_) / num_samples_per_prediction_] = 1.f;
+        size_t window_end =
+            std::min(i + num_samples_per_prediction_, chunk_labels.size());
+        double label = vec_mode(chunk_labels.begin() + i,
+                                chunk_labels.begin() + window_end);
+        labels_out[i / num_samples_per_prediction_] = static_cast<float>(label);
+        weights_out[i / num_samples_per_prediction_] = 1.f;
       }
       labels_out += num_predictions_per_chunk_;
       weights_out += num_predictions_per_chunk_;
     }
 
-    batch_info.emplace_back();
-    batch_info.back().session_id = row[session_id_column_index];
-    batch_info.back().num_samples = end - sample_in_row_;
-
-    sample_in_row_ = end;
+    sample_in_session_ = chunk_end;
 
-    if (sample_in_row_ >= static_cast<size_t>(chunk_length)) {
-      ++next_row_;
-      sample_in_row_ = 0;
+    if (sample_in_session_ >= session_length) {
+      ++session_index_;
+      sample_in_session_ = 0;
     }
   }
 
-  // Wrap the buffers as float_array values.
+  // Wrap the buffers as float_array values, which return them to the pool
+  // once the batch is no longer used.
   batch result;
-  result.features = shared_float_array::wrap(
+  result.features = buffer_pool_.wrap(
       std::move(features),
       { batch_size, 1, num_samples_per_chunk, num_features });
   if (data_.has_target) {
-    result.labels = shared_float_array::wrap(
+    result.labels = buffer_pool_.wrap(
         std::move(labels), { batch_size, 1, num_predictions_per_chunk_, 1 });
-    result.weights = shared_float_array::wrap(
+    result.weights = buffer_pool_.wrap(
         std::move(weights), { batch_size, 1, num_predictions_per_chunk_, 1 });
-    result.labels_per_row = shared_float_array::wrap( 
+    result.labels_per_row = buffer_pool_.wrap(
         std::move(labels_per_row), { batch_size, 1, num_samples_per_chunk, 1 });
   }
 
@@ -661,9 +591,14 @@ data_iterator::batch simple_data_iterator::next_batch(size_t batch_size) {
 
 void simple_data_iterator::reset() {
 
-  range_iterator_ = data_.chunks.range_iterator();
+  // Stop reading ahead before moving back to the first row.
+  prefetcher_.reset();
+
+  range_iterator_ = data_.samples.range_iterator();
   next_row_ = range_iterator_.begin();
   end_of_rows_ = range_iterator_.end();
+  session_index_ = 0;
+  sample_in_session_ = 0;
 
   // TODO: If gl_sframe_range::end() were a const method, we wouldn't need to
   // store end_of_rows_ separately.
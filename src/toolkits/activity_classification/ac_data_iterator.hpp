@@ -7,11 +7,13 @@
 #ifndef TURI_ACTIVITY_CLASSIFICATION_AC_DATA_ITERATOR_HPP_
 #define TURI_ACTIVITY_CLASSIFICATION_AC_DATA_ITERATOR_HPP_
 
+#include <memory>
 #include <random>
 #include <string>
 #include <vector>
 
 #include <core/data/sframe/gl_sframe.hpp>
+#include <ml/neural_net/batch_pipeline.hpp>
 #include <ml/neural_net/float_array.hpp>
 
 namespace turi {
@@ -70,6 +72,14 @@ public:
 
     /** Determines results of data augmentation if enabled. */
     int random_seed = 0;
+
+    /**
+     * Number of background threads preparing the batches ahead of
+     * next_batch, or 0 to prepare each batch on the calling thread. When
+     * prefetching, every call to next_batch must request the same batch size
+     * until the next reset.
+     */
+    size_t num_prefetch_workers = 0;
   };
 
   /** Defines the output of a data_iterator. */
@@ -157,8 +167,15 @@ public:
 };
 
 /**
- * Concrete data_iterator implementation that doesn't attempt any
- * parallelization or background I/O.
+ * Concrete data_iterator implementation.
+ *
+ * The chunks are cut from the rows of the data while traversing them, one
+ * sample per row, so memory use does not depend on the length of the
+ * sessions or of the data. Only the length of each session is computed
+ * ahead, and the rows of each session must be contiguous.
+ *
+ * With num_prefetch_workers > 0, a neural_net::batch_pipeline prepares the
+ * upcoming batches of the current traversal in the background.
  */
 class simple_data_iterator: public data_iterator {
 public:
@@ -179,16 +196,21 @@ public:
 private:
 
   struct preprocessed_data {
-    gl_sframe chunks;
-    size_t num_sessions = 0;
+    gl_sframe samples;  // The features, the session ID and the encoded target
+    std::vector<size_t> session_lengths;
     flex_type_enum session_id_type = flex_type_enum::UNDEFINED;
     bool has_target = false;
     flex_list feature_names;
     flex_list class_labels;
   };
 
+  typedef neural_net::batch_pipeline<batch, batch> prefetch_pipeline;
+
   static preprocessed_data preprocess_data(const parameters& params);
 
+  // Prepares the next batch on the calling thread.
+  batch read_batch(size_t batch_size);
+
   const preprocessed_data data_;
   const size_t num_samples_per_prediction_;
   const size_t num_predictions_per_chunk_;
@@ -196,10 +218,20 @@ private:
   gl_sframe_range range_iterator_;
   gl_sframe_range::iterator next_row_;
   gl_sframe_range::iterator end_of_rows_;
-  size_t sample_in_row_ = 0;
+  size_t session_index_ = 0;      // The session of next_row_
+  size_t sample_in_session_ = 0;  // The index of next_row_ in its session
   bool is_train_ = false;
   bool use_data_augmentation_ = false;
   std::default_random_engine random_engine_;
+
+  // Recycles the buffers of the batches once they are consumed.
+  neural_net::float_buffer_pool buffer_pool_;
+
+  const size_t num_prefetch_workers_;
+  size_t prefetch_batch_size_ = 0;
+
+  // Declared last, so that its workers stop before the state they read.
+  std::unique_ptr<prefetch_pipeline> prefetcher_;
 };
 
 /**
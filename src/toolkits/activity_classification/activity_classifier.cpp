@@ -50,6 +50,10 @@ constexpr size_t LSTM_HIDDEN_SIZE = 200;
 constexpr size_t FULLY_CONNECTED_HIDDEN_SIZE = 128;
 constexpr float LSTM_CELL_CLIP_THRESHOLD = 50000.f;
 
+// Training batches submitted to the model whose loss has not been read yet.
+// The next batch is prepared while this many are in flight.
+constexpr size_t NUM_TRAINING_BATCHES_IN_FLIGHT = 3;
+
 
 // These are the fixed values that the Python implementation currently passes
 // into TCMPS.
@@ -839,6 +843,7 @@ std::unique_ptr<data_iterator> activity_classifier::create_iterator(
   } else {
     data_params.random_seed = 0;
   }
+  data_params.num_prefetch_workers = 1;
   return std::unique_ptr<data_iterator>(new simple_data_iterator(data_params));
 }
 
@@ -1099,7 +1104,8 @@ void activity_classifier::perform_training_iteration() {
   size_t prediction_window = read_state<size_t>("prediction_window");
 
 
-  // To support double buffering, use a queue of pending inference results.
+  // To keep several batches in flight, use a queue of pending training
+  // results, whose losses and outputs are only read once the queue is full.
   std::queue<result> pending_batches;
 
   auto pop_until_size = [&](size_t remaining) {
@@ -1130,12 +1136,12 @@ void activity_classifier::perform_training_iteration() {
 
   while (training_data_iterator_->has_next_batch()) {
 
-    // Wait until we have just one asynchronous batch outstanding. The work
-    // below should be concurrent with the neural net inference for that batch.
-    pop_until_size(1);
-
+    // Prepare the next batch, concurrently with the batches in flight.
     result result_batch;
-    result_batch.data_info = training_data_iterator_->next_batch(batch_size);;
+    result_batch.data_info = training_data_iterator_->next_batch(batch_size);
+
+    // Wait until there is room for one more batch in flight.
+    pop_until_size(NUM_TRAINING_BATCHES_IN_FLIGHT - 1);
 
     // Submit the batch to the neural net model.
     std::map<std::string, shared_float_array> results = training_model_->train(
@@ -8,6 +8,13 @@
 namespace turi {
 namespace kmeans {
 
+size_t KMEANS_PARALLEL_INIT_MIN_CLUSTERS = 1000;
+
+REGISTER_GLOBAL(int64_t, KMEANS_PARALLEL_INIT_MIN_CLUSTERS, true);
+
+size_t KMEANS_MINIBATCH_RUN_LENGTH = 32;
+
+REGISTER_GLOBAL(int64_t, KMEANS_MINIBATCH_RUN_LENGTH, true);
 
 // **************************
 // *** Distance functions ***
@@ -656,7 +663,10 @@ void kmeans_model::process_custom_centers(const sframe& init_centers) {
  */
 void kmeans_model::choose_random_centers() {
 
-  logprogress_stream << "Choosing initial cluster centers with Kmeans++."
+  bool use_kmeans_parallel = (num_clusters >= KMEANS_PARALLEL_INIT_MIN_CLUSTERS);
+
+  logprogress_stream << "Choosing initial cluster centers with "
+                     << (use_kmeans_parallel ? "Kmeans||." : "Kmeans++.")
                      << std::endl;
 
   clusters.assign(num_clusters, cluster(metadata->num_dimensions()));
@@ -679,6 +689,14 @@ void kmeans_model::choose_random_centers() {
   }
 
 
+  // Many clusters: sample candidate centers in a few passes over the data
+  // rather than one center per pass over a sample.
+  if (use_kmeans_parallel && num_clusters <= max_mem_rows) {
+    choose_centers_kmeans_parallel(max_mem_rows);
+    return;
+  }
+
+
   // If the number of clusters is larger than the maximum number of rows that
   // can be held in memory, just use the random sample as the initial centers.
   // Remember that if num_clusters is larger than num_examples, we've already
@@ -758,6 +776,171 @@ void kmeans_model::choose_random_centers() {
 }
 
 
+/**
+ * Choose initial cluster centers with k-means||.
+ */
+void kmeans_model::choose_centers_kmeans_parallel(size_t max_mem_rows) {
+
+  const size_t num_dims = metadata->num_dimensions();
+  const size_t num_rounds = 2;
+  const double oversampling = 2.0 * num_clusters;
+
+  // Candidate centers. While they are sampled, 'upper_bounds' holds the
+  // squared distance from each point to its nearest candidate, and
+  // 'assignments' the index of that candidate.
+  std::vector<dense_vector> candidates;
+  std::fill(upper_bounds.begin(), upper_bounds.end(),
+            std::numeric_limits<float>::max());
+  std::fill(assignments.begin(), assignments.end(), 0);
+
+  // Update the nearest candidates of all points with the candidates from
+  // 'begin' on, and return the sum of the squared distances.
+  auto update_nearest_candidates = [&](size_t begin) {
+    double cost = 0;
+    turi::mutex cost_lock;
+
+    in_parallel([&](size_t thread_idx, size_t num_threads) {
+      dense_vector x(num_dims);
+      double thread_cost = 0;
+
+      for (auto it = mldata.get_iterator(thread_idx, num_threads); !it.done(); ++it) {
+        size_t i = it.row_index();
+        it.fill_observation(x);
+
+        for (size_t c = begin; c < candidates.size(); ++c) {
+          float d = squared_euclidean(x, candidates[c]);
+
+          if (d < upper_bounds[i]) {
+            upper_bounds[i] = d;
+            assignments[i] = c;
+          }
+        }
+        thread_cost += upper_bounds[i];
+      }
+
+      std::lock_guard<turi::mutex> guard(cost_lock);
+      cost += thread_cost;
+    });
+
+    return cost;
+  };
+
+  table_printer progress_table({{"Round", 0}, {"Number of candidates", 0}});
+  progress_table.print_header();
+
+  // The first candidate is a uniformly random point.
+  size_t idx_first = turi::random::fast_uniform<size_t>(0, num_examples - 1);
+  candidates.push_back(dense_vector(num_dims));
+  mldata.slice(idx_first, idx_first + 1).get_iterator().fill_observation(candidates[0]);
+
+  double cost = update_nearest_candidates(0);
+  progress_table.print_row(0, candidates.size());
+
+  for (size_t round = 1; round <= num_rounds && cost > 0; ++round) {
+    size_t begin = candidates.size();
+    turi::mutex candidates_lock;
+
+    // Sample each point independently, with probability proportional to the
+    // squared distance to its nearest candidate.
+    in_parallel([&](size_t thread_idx, size_t num_threads) {
+      std::vector<dense_vector> sampled;
+
+      for (auto it = mldata.get_iterator(thread_idx, num_threads); !it.done(); ++it) {
+        size_t i = it.row_index();
+
+        if (turi::random::fast_uniform<double>(0, 1) * cost < oversampling * upper_bounds[i]) {
+          sampled.push_back(dense_vector(num_dims));
+          it.fill_observation(sampled.back());
+        }
+      }
+
+      std::lock_guard<turi::mutex> guard(candidates_lock);
+      candidates.insert(candidates.end(), sampled.begin(), sampled.end());
+    });
+
+    if (candidates.size() > max_mem_rows) {
+      candidates.resize(max_mem_rows);
+    }
+
+    cost = update_nearest_candidates(begin);
+    progress_table.print_row(round, candidates.size());
+
+    // Break if Ctrl-C has been pressed.
+    if (cppipc::must_cancel()) {
+       log_and_throw(std::string("Toolkit canceled by user."));
+    }
+
+    if (candidates.size() == max_mem_rows) {
+      break;
+    }
+  }
+
+  progress_table.print_footer();
+
+  // Weight each candidate by the number of points nearest to it.
+  std::vector<double> weights(candidates.size(), 0);
+  turi::mutex weights_lock;
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    size_t start_idx = (thread_idx * num_examples) / num_threads;
+    size_t end_idx = ((thread_idx + 1) * num_examples) / num_threads;
+    std::vector<double> thread_weights(candidates.size(), 0);
+
+    for (size_t i = start_idx; i < end_idx; ++i) {
+      thread_weights[assignments[i]] += 1;
+    }
+
+    std::lock_guard<turi::mutex> guard(weights_lock);
+    for (size_t c = 0; c < candidates.size(); ++c) {
+      weights[c] += thread_weights[c];
+    }
+  });
+
+  // With few distinct points there may be fewer candidates than clusters;
+  // the rest are drawn uniformly.
+  if (candidates.size() < num_clusters) {
+    v2::ml_data extra_data = mldata.create_subsampled_copy(
+        num_clusters - candidates.size(), 0);
+
+    for (auto it = extra_data.get_iterator(); !it.done(); ++it) {
+      candidates.push_back(dense_vector(num_dims));
+      it.fill_observation(candidates.back());
+      weights.push_back(1);
+    }
+  }
+
+  // Weighted Kmeans++ over the candidates.
+  std::vector<double> min_squared_dists(candidates.size(),
+                                        std::numeric_limits<double>::max());
+  std::vector<double> probs(candidates.size());
+
+  size_t idx_center = turi::random::multinomial(weights);
+  clusters[0].center = candidates[idx_center];
+
+  for (size_t k = 1; k < num_clusters; ++k) {
+    parallel_for(0, candidates.size(), [&](size_t c) {
+      double d = squared_euclidean(clusters[k-1].center, candidates[c]);
+      if (d < min_squared_dists[c]) {
+        min_squared_dists[c] = d;
+      }
+      probs[c] = weights[c] * min_squared_dists[c] + 1e-16;
+    });
+
+    idx_center = turi::random::multinomial(probs);
+    clusters[k].center = candidates[idx_center];
+
+    // Break if Ctrl-C has been pressed.
+    if (cppipc::must_cancel()) {
+       log_and_throw(std::string("Toolkit canceled by user."));
+    }
+  }
+
+  // Leave the bounds as the training methods expect them.
+  assignments.assign(num_examples, 0);
+  upper_bounds.assign(num_examples, std::numeric_limits<float>::max());
+}
+
+
 /**
  * Low-memory version of main Kmeans iterations, using Lloyd's algorithm.
  */
@@ -872,34 +1055,45 @@ size_t kmeans_model::compute_clusters_minibatch() {
     progress_table.print_header();
   }
 
-  // Main training iterations
-  std::vector<float> batch_distances(batch_size, std::numeric_limits<float>::max());
+  // Main training iterations. A batch is read as runs of consecutive rows
+  // starting at random positions, each run its own slice of the data, so
+  // that only the rows of the batch are read.
+  const size_t num_dims = metadata->num_dimensions();
+  const size_t run_length = std::max<size_t>(
+      1, std::min<size_t>(KMEANS_MINIBATCH_RUN_LENGTH, batch_size));
+  const size_t num_runs = (batch_size + run_length - 1) / run_length;
+
+  std::vector<dense_vector> batch_points(batch_size, dense_vector(num_dims));
   std::vector<size_t> batch_assignments(batch_size, 0);
+  std::vector<size_t> run_starts(num_runs);
 
   for (size_t iter = 0; iter < max_iterations; ++iter) {
 
-    // Randomly select a batch of data. This is probably expensive, so think
-    // about doing all of the batches at once outside of the main loop.
-    v2::ml_data batch_data = mldata.create_subsampled_copy(batch_size, iter);
+    for (size_t r = 0; r < num_runs; ++r) {
+      size_t n = std::min(run_length, batch_size - r * run_length);
+      run_starts[r] = turi::random::fast_uniform<size_t>(0, num_examples - n);
+    }
 
 
-    // 1st pass - assign the current batch of points to a cluster. This could
-    // potentially be faster with the triangle inequality on center distances,
-    // but for the first draft it's not worth the code complexity.
-    in_parallel([&](size_t thread_idx, size_t num_threads) {
-      dense_vector x(metadata->num_dimensions());
+    // 1st pass - read the current batch of points and assign each to a
+    // cluster. This could potentially be faster with the triangle inequality
+    // on center distances, but for the first draft it's not worth the code
+    // complexity.
+    parallel_for(size_t(0), num_runs, [&](size_t r) {
+      size_t i = r * run_length;
+      size_t n = std::min(run_length, batch_size - i);
+      v2::ml_data run_data = mldata.slice(run_starts[r], run_starts[r] + n);
 
-      for (auto it = batch_data.get_iterator(thread_idx, num_threads); !it.done(); ++it) {
-        size_t i = it.row_index();
-        it.fill_observation(x);
-        batch_distances[i] = std::numeric_limits<float>::max();
+      for (auto it = run_data.get_iterator(); !it.done(); ++it, ++i) {
+        it.fill_observation(batch_points[i]);
+        float best_distance = std::numeric_limits<float>::max();
 
         for (size_t k = 0; k < num_clusters; ++k) {
-          float d = squared_euclidean(x, clusters[k].center);
+          float d = squared_euclidean(batch_points[i], clusters[k].center);
 
-          if (d < batch_distances[i]) {
+          if (d < best_distance) {
             batch_assignments[i] = k;
-            batch_distances[i] = d;
+            best_distance = d;
           }
         }
       }
@@ -909,14 +1103,8 @@ size_t kmeans_model::compute_clusters_minibatch() {
     // 2nd pass - update cluster centers. Note: the `safe_update_center` method
     // looks different than what's in the paper, but it is arithmetically
     // identical.
-    in_parallel([&](size_t thread_idx, size_t num_threads) {
-      dense_vector x(metadata->num_dimensions());
-
-      for (auto it = batch_data.get_iterator(thread_idx, num_threads); !it.done(); ++it) {
-        size_t i = it.row_index();
-        it.fill_observation(x);
-        clusters[batch_assignments[i]].safe_update_center(x);
-      }
+    parallel_for(size_t(0), batch_size, [&](size_t i) {
+      clusters[batch_assignments[i]].safe_update_center(batch_points[i]);
     });
 
     progress_table.print_row(iter);
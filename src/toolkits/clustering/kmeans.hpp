@@ -43,6 +43,20 @@ namespace kmeans {
 typedef Eigen::Matrix<double, Eigen::Dynamic, 1>  dense_vector;
 typedef Eigen::SparseVector<double>  sparse_vector;
 
+/**
+ * Randomly initialized models with at least this many clusters choose their
+ * initial centers with k-means|| (scalable k-means++), which samples many
+ * candidate centers per pass over the data, instead of one center per pass
+ * over an in-memory sample.
+ */
+extern size_t KMEANS_PARALLEL_INIT_MIN_CLUSTERS;
+
+/**
+ * Number of consecutive rows read from each random position of the data for
+ * a minibatch.
+ */
+extern size_t KMEANS_MINIBATCH_RUN_LENGTH;
+
 
 /**
  * ----------------
@@ -223,6 +237,19 @@ class EXPORT kmeans_model : public ml_model_base {
    */
   void choose_random_centers();
 
+  /**
+   * Choose initial cluster centers with k-means|| (Bahmani et al. 2012). A
+   * few passes over the data each sample about 2K candidate centers, with
+   * probability proportional to the squared distance to the nearest
+   * candidate so far. The candidates are weighted by the number of points
+   * nearest to them, and the K centers are chosen from them with weighted
+   * k-means++.
+   *
+   * \param max_mem_rows Most candidates that may be held in memory; beyond
+   * that, a uniform random sample of the data is used instead.
+   */
+  void choose_centers_kmeans_parallel(size_t max_mem_rows);
+
   /**
    * High-memory version of main Kmeans iterations, using Elkan's algorithm.
    *
@@ -238,6 +265,9 @@ class EXPORT kmeans_model : public ml_model_base {
   /**
    * Minibatch version of main Kmeans iterations, using the D. Sculley
    * algorithm (http://www.eecs.tufts.edu/~dsculley/papers/fastkmeans.pdf).
+   * Each batch is read from short runs of rows at random positions in the
+   * data, so that an iteration reads about 'batch_size' rows and keeps only
+   * the batch and the centers in memory.
    *
    * \returns iter Number of iterations in the main training loop.
    */
@@ -23,6 +23,12 @@ void setup_pipeline_from_mldata(
 
     std::string column_name = metadata->column_name(column_idx);
 
+    if(mode_is_indexed(metadata->column_mode(column_idx))
+       && metadata->indexer(column_idx)->num_hash_buckets() != 0) {
+      log_and_throw("Column " + column_name
+                    + ": Models using feature hashing cannot be exported to Core ML.");
+    }
+
     switch(metadata->column_mode(column_idx)) {
       case ml_column_mode::NUMERIC:
         {
@@ -9,6 +9,8 @@
 #include <math.h>
 #include <core/logging/assertions.hpp>
 #include <core/data/image/image_type.hpp>
+#include <core/parallel/lambda_omp.hpp>
+#include <core/parallel/pthread_tools.hpp>
 #include <core/util/sys_util.hpp>
 #ifdef __APPLE__
 #include <CoreGraphics/CoreGraphics.h>
@@ -100,228 +102,216 @@ private:
     float m_y = 0.0f;
 };
 
-class Line {
-public:
-    Line(const flex_dict &p1, const flex_dict &p2) {
-        Point P1(p1);
-        Point P2(p2);
-        float start_x = P1.get_x();
-        float start_y = P1.get_y();
-        float end_x = P2.get_x();
-        float end_y = P2.get_y();
-        if (start_x == end_x) {
-            m_a = std::numeric_limits<float>::max();
-        } else {
-            m_a = (end_y - start_y)/(end_x - start_x);
-        }
-        m_b = -1;
-        m_c = start_y - m_a * start_x;
-    }
+/**
+ * A drawing with its points normalized to [0, 255] and simplified, as flat
+ * coordinate arrays. The points of stroke i end at stroke_ends[i].
+ *
+ * The buffers are reused from one drawing to the next, so that a thread
+ * parsing many drawings does not allocate per drawing.
+ */
+struct parsed_drawing {
+    std::vector<float> xs;
+    std::vector<float> ys;
+    std::vector<size_t> stroke_ends;
 
-    float distance_to_point(const flex_dict &point) {
-        Point P(point);
-        float x = P.get_x();
-        float y = P.get_y();
-        float distance = (fabs(m_a * x + m_b * y + m_c))/sqrtf(
-            m_a * m_a + m_b * m_b);
-        return floorf(distance);
-    }
-private:
-    // ax + by + c = 0
-    float m_a;
-    float m_b;
-    float m_c;
+    // Scratch space for parse_drawing.
+    std::vector<float> raw_xs;
+    std::vector<float> raw_ys;
+    std::vector<size_t> raw_stroke_ends;
+    std::vector<char> keep;
+    std::vector<std::pair<size_t, size_t>> ranges;
 };
 
-} // namespace
+// Distance from (x, y) to the line through (x1, y1) and (x2, y2), rounded
+// down to whole pixels.
+float distance_to_line(float x, float y,
+    float x1, float y1, float x2, float y2) {
+    float dx = x2 - x1;
+    float dy = y2 - y1;
+    float length = sqrtf(dx * dx + dy * dy);
+    if (length == 0.0f) {
+        float ex = x - x1;
+        float ey = y - y1;
+        return floorf(sqrtf(ex * ex + ey * ey));
+    }
+    return floorf(fabsf(dy * (x - x1) - dx * (y - y1)) / length);
+}
 
 /* Ramer Douglas Peucker Algorithm:
  * https://en.wikipedia.org/wiki/Ramer–Douglas–Peucker_algorithm
+ *
+ * Marks in keep the points of [begin, end) that survive the simplification.
+ * Uses an explicit stack of ranges instead of recursion.
  */
-flex_list ramer_douglas_peucker(
-    flex_list::iterator begin,
-    flex_list::iterator end,
-    float epsilon) {
-    float dmax = 0;
-    flex_list compressed_stroke;
-    if (begin == end) {
-        return compressed_stroke;
-    }
-    const flex_dict &first_point = begin->get<flex_dict>();
-    const flex_dict &last_point = (end-1)->get<flex_dict>();
-    Line L(first_point, last_point);
-    flex_list::iterator index_iterator;
-    for (auto it = begin; it != end; it++) {
-        float d = L.distance_to_point(it->get<flex_dict>());
-        if (d > dmax) {
-            index_iterator = it;
-            dmax = d;
+void ramer_douglas_peucker(const std::vector<float> &xs,
+    const std::vector<float> &ys,
+    size_t begin, size_t end, float epsilon,
+    std::vector<char> &keep,
+    std::vector<std::pair<size_t, size_t>> &ranges) {
+    if (begin == end) return;
+    ranges.clear();
+    ranges.emplace_back(begin, end - 1);
+    while (!ranges.empty()) {
+        size_t first = ranges.back().first;
+        size_t last = ranges.back().second;
+        ranges.pop_back();
+        float dmax = 0;
+        size_t index = first;
+        for (size_t i = first; i <= last; i++) {
+            float d = distance_to_line(xs[i], ys[i],
+                xs[first], ys[first], xs[last], ys[last]);
+            if (d > dmax) {
+                index = i;
+                dmax = d;
+            }
+        }
+        if (dmax > epsilon) {
+            ranges.emplace_back(index, last);
+            ranges.emplace_back(first, index);
+        } else {
+            keep[first] = 1;
+            keep[last] = 1;
         }
     }
-    if (dmax > epsilon) {
-        compressed_stroke = ramer_douglas_peucker(
-            begin, index_iterator, epsilon);
-        flex_list rec_results_2 = ramer_douglas_peucker(
-            index_iterator, end, epsilon);
-        compressed_stroke.insert(compressed_stroke.end(),
-            rec_results_2.begin(), rec_results_2.end());
-    } else {
-        compressed_stroke.push_back(first_point);
-        compressed_stroke.push_back(last_point);
-    }
-    return compressed_stroke;
 }
 
-flex_list simplify_drawing(flex_list raw_drawing, int row_number) {
-    size_t num_strokes = raw_drawing.size();
+/**
+ * Reads the strokes of a drawing, aligns the drawing to the top-left corner,
+ * scales it to [0, 255] and simplifies each stroke.
+ */
+void parse_drawing(const flex_list &raw_drawing, int row_number,
+    parsed_drawing &out) {
+    out.raw_xs.clear();
+    out.raw_ys.clear();
+    out.raw_stroke_ends.clear();
     float min_x = std::numeric_limits<float>::max();
     float max_x = 0;
     float min_y = std::numeric_limits<float>::max();
     float max_y = 0;
-    flex_list simplified_drawing;
-    // Compute bounds of the drawing
-    for (size_t i = 0; i < num_strokes; i++) {
+    for (size_t i = 0; i < raw_drawing.size(); i++) {
         const flex_list &stroke = raw_drawing[i].get<flex_list>();
         for (size_t j = 0; j < stroke.size(); j++) {
-            const flex_dict &point = stroke[j].get<flex_dict>();
-            Point P(point, row_number, i, j);
+            Point P(stroke[j].get<flex_dict>(), row_number, i, j);
             float x = P.get_x();
             float y = P.get_y();
             min_x = std::min(x, min_x);
             max_x = std::max(x, max_x);
             min_y = std::min(y, min_y);
             max_y = std::max(y, max_y);
+            out.raw_xs.push_back(x);
+            out.raw_ys.push_back(y);
         }
-    }
-    // Align the drawing to top-left corner and scale to [0,255]
-    for (size_t i = 0; i < num_strokes; i++) {
-        flex_list &stroke = raw_drawing[i].mutable_get<flex_list>();
-        flex_list new_stroke;
-        for (size_t j = 0; j < stroke.size(); j++) {
-            float new_x;
-            float new_y;
-            flex_dict &point = stroke[j].mutable_get<flex_dict>();
-            Point P(point);
-            if (max_x == min_x) {
-                // vertical straight line
-                new_x = min_x;
-            } else {
-                new_x = ((P.get_x() - min_x) * 255.0) / (max_x - min_x);
-            }
-            if (max_y == min_y) {
-                // horizontal straight line
-                new_y = min_y;
-            } else {
-                new_y = ((P.get_y() - min_y) * 255.0) / (max_y - min_y);
-            }
-            flex_dict new_point;
-            new_point.push_back(std::make_pair("x", new_x));
-            new_point.push_back(std::make_pair("y", new_y));
-            new_stroke.push_back(new_point);
-        }
-        // Apply RDP Line Algorithm
+        // Empty strokes are dropped.
         if (stroke.size() > 0) {
-            simplified_drawing.push_back(ramer_douglas_peucker(
-                new_stroke.begin(),
-                new_stroke.end(),
-                2.0));
+            out.raw_stroke_ends.push_back(out.raw_xs.size());
         }
     }
-    return simplified_drawing;
-}
 
-bool in_bounds(int x, int y, int dim) {
-    return (x >= 0 && x < dim && y >= 0 && y < dim);
-}
+    // Align the drawing to top-left corner and scale to [0,255]. A drawing
+    // that is a vertical or horizontal straight line is left as is along
+    // the other axis.
+    size_t num_points = out.raw_xs.size();
+    for (size_t i = 0; i < num_points; i++) {
+        if (max_x != min_x) {
+            out.raw_xs[i] = ((out.raw_xs[i] - min_x) * 255.0f) / (max_x - min_x);
+        }
+        if (max_y != min_y) {
+            out.raw_ys[i] = ((out.raw_ys[i] - min_y) * 255.0f) / (max_y - min_y);
+        }
+    }
 
-void paint_point(flex_nd_vec &bitmap, int x, int y, int pad) {
-    size_t dimension = bitmap.shape()[1];
-    for (int dx = -pad; dx < pad; dx++) {
-        for (int dy = -pad; dy < pad; dy++) {
-            if (in_bounds(x+dx, y+dy, dimension)) {
-                bitmap[(y+dy) * dimension + (x+dx)] = 1.0;
+    // Apply RDP Line Algorithm
+    out.keep.assign(num_points, 0);
+    out.xs.clear();
+    out.ys.clear();
+    out.stroke_ends.clear();
+    size_t stroke_begin = 0;
+    for (size_t stroke_end : out.raw_stroke_ends) {
+        ramer_douglas_peucker(out.raw_xs, out.raw_ys, stroke_begin, stroke_end,
+            2.0f, out.keep, out.ranges);
+        for (size_t i = stroke_begin; i < stroke_end; i++) {
+            if (out.keep[i]) {
+                out.xs.push_back(out.raw_xs[i]);
+                out.ys.push_back(out.raw_ys[i]);
             }
         }
+        out.stroke_ends.push_back(out.xs.size());
+        stroke_begin = stroke_end;
     }
 }
 
-flex_nd_vec paint_stroke(
-    flex_nd_vec bitmap, Point start, Point end, float stroke_width) {
-    bool along_x;
-    float slope;
-    if (floorf(end.get_x()) == floorf(start.get_x())) {
-        slope = std::numeric_limits<float>::max();
-    } else {
-        slope = (end.get_y() - start.get_y())/(end.get_x() - start.get_x());
-    }
-    int pad = (int)(stroke_width/2);
-    along_x = (fabs(slope) < 1);
-    if ((along_x && (start.get_x() > end.get_x()))
-        || (!along_x && (start.get_y() > end.get_y()))) {
-        std::swap(start, end);
-    }
-    int x1 = (int)(start.get_x());
-    int y1 = (int)(start.get_y());
-    int x2 = (int)(end.get_x());
-    int y2 = (int)(end.get_y());
-    if (along_x) {
-        for (int x = x1; x <= x2; x++) {
-            int y = (int)(slope * (x - x1) + y1);
-            paint_point(bitmap, x, y, pad);
-        }
-    } else {
-        for (int y = y1; y <= y2; y++) {
-            int x = (int)(x1 + ((y - y1) / slope));
-            paint_point(bitmap, x, y, pad);
+/**
+ * Paints one anti-aliased segment, STROKE_WIDTH wide on the intermediate
+ * scale, with round caps, into a FINAL_BITMAP_WIDTH x FINAL_BITMAP_HEIGHT
+ * bitmap of intensities in [0, 255].
+ *
+ * The segment is drawn scanline by scanline over its bounding box. Each
+ * pixel is covered by how far its center is inside the stroke, so the inner
+ * loop has no branches and vectorizes.
+ */
+void paint_segment(float *bitmap, float x1, float y1, float x2, float y2) {
+    const float scale = ((float)FINAL_BITMAP_WIDTH) / INTERMEDIATE_BITMAP_WIDTH;
+    const float half_width = STROKE_WIDTH * scale / 2;
+    x1 *= scale;
+    y1 *= scale;
+    x2 *= scale;
+    y2 *= scale;
+    float dx = x2 - x1;
+    float dy = y2 - y1;
+    float length_squared = dx * dx + dy * dy;
+    float inv_length_squared =
+        (length_squared > 0.0f) ? 1.0f / length_squared : 0.0f;
+
+    float reach = half_width + 1.0f;
+    int row_begin = std::max(0, (int)floorf(std::min(y1, y2) - reach));
+    int row_end = std::min((int)FINAL_BITMAP_HEIGHT,
+        (int)ceilf(std::max(y1, y2) + reach));
+    int col_begin = std::max(0, (int)floorf(std::min(x1, x2) - reach));
+    int col_end = std::min((int)FINAL_BITMAP_WIDTH,
+        (int)ceilf(std::max(x1, x2) + reach));
+
+    for (int row = row_begin; row < row_end; row++) {
+        float py = row + 0.5f - y1;
+        float *row_ptr = bitmap + row * FINAL_BITMAP_WIDTH;
+        for (int col = col_begin; col < col_end; col++) {
+            float px = col + 0.5f - x1;
+            float t = (px * dx + py * dy) * inv_length_squared;
+            t = std::min(1.0f, std::max(0.0f, t));
+            float ex = px - t * dx;
+            float ey = py - t * dy;
+            float coverage = half_width + 0.5f - sqrtf(ex * ex + ey * ey);
+            coverage = std::min(1.0f, std::max(0.0f, coverage));
+            row_ptr[col] = std::max(row_ptr[col], 255.0f * coverage);
         }
     }
-    return bitmap;
 }
 
-flex_image blur_bitmap(flex_nd_vec bitmap, int ksize) {
-    std::vector<size_t> bitmap_shape = bitmap.shape();
-    flex_nd_vec blurred_bitmap(bitmap_shape, 0.0);
-    int dimension = bitmap_shape[1];
-    int pad = ksize/2;
-    for (int row = 0; row < dimension; row++) {
-        for (int col = 0; col < dimension; col++) {
-            int index = row * dimension + col;
-            if (row < pad
-                || row >= dimension-pad
-                || col < pad
-                || col >= dimension-pad) {
-                blurred_bitmap[index] = std::min(255.0, 255 * bitmap[index]);
-                continue;
-            }
-            double sum_for_blur = 0.0;
-            int num_values_in_sum = 0;
-            for (int dr = -pad; dr <= pad; dr++) {
-                for (int dc = -pad; dc <= pad; dc++) {
-                    sum_for_blur += bitmap[(row+dr) * dimension + (col+dc)];
-                    num_values_in_sum += 1;
-                }
-            }
-            blurred_bitmap[index] = std::min(255.0,
-                255 * sum_for_blur / num_values_in_sum);
+/**
+ * Rasterizes a parsed drawing into a FINAL_BITMAP_WIDTH x FINAL_BITMAP_HEIGHT
+ * bitmap of intensities in [0, 255], row major.
+ */
+void rasterize(const parsed_drawing &drawing, float *bitmap) {
+    std::fill(bitmap, bitmap + FINAL_BITMAP_WIDTH * FINAL_BITMAP_HEIGHT, 0.0f);
+    size_t stroke_begin = 0;
+    for (size_t stroke_end : drawing.stroke_ends) {
+        if (stroke_end - stroke_begin == 1) {
+            // A single point is painted as a dot.
+            paint_segment(bitmap, drawing.xs[stroke_begin],
+                drawing.ys[stroke_begin], drawing.xs[stroke_begin],
+                drawing.ys[stroke_begin]);
         }
+        for (size_t j = stroke_begin + 1; j < stroke_end; j++) {
+            paint_segment(bitmap, drawing.xs[j - 1], drawing.ys[j - 1],
+                drawing.xs[j], drawing.ys[j]);
+        }
+        stroke_begin = stroke_end;
     }
-    uint8_t image_data[dimension * dimension];
-    for (int idx=0; idx < dimension * dimension; idx++) {
-        image_data[idx] = ((uint8_t)(blurred_bitmap[idx]));
-    }
-    return flex_image((const char *)image_data,
-        dimension,                  // height
-        dimension,                  // width
-        1,                          // channels
-        dimension*dimension,        // image_data_size
-        IMAGE_TYPE_CURRENT_VERSION, // version
-        2);                         // format
-        // last argument is turi::Format::RAW_ARRAY, which has a value of 2
 }
 
+} // namespace
+
 #ifdef __APPLE__
-flex_image rasterize_on_mac(flex_list simplified_drawing) {
-    size_t num_strokes = simplified_drawing.size();
+static flex_image rasterize_on_mac(const parsed_drawing &drawing) {
     int MAC_OS_STRIDE = 64;
     CGColorSpaceRef grayscale = CGColorSpaceCreateDeviceGray();
     CGContextRef intermediate_bitmap_context = CGBitmapContextCreate(
@@ -330,22 +320,18 @@ flex_image rasterize_on_mac(flex_list simplified_drawing) {
     CGContextSetRGBStrokeColor(intermediate_bitmap_context, 1.0, 1.0, 1.0, 1.0);
     CGAffineTransform transform = CGAffineTransformIdentity;
     CGMutablePathRef path = CGPathCreateMutable();
-    for (size_t i = 0; i < num_strokes; i++) {
-        const flex_list &stroke = simplified_drawing[i].get<flex_list>();
-        const flex_dict &start_point_dict = stroke[0].get<flex_dict>();
-        size_t num_points_in_stroke = stroke.size();
-        Point P(start_point_dict);
+    size_t stroke_begin = 0;
+    for (size_t stroke_end : drawing.stroke_ends) {
         // @TODO: When we make a dylib, we'll need some sophisticated
         // iOS/macOS checking here to figure out whether we need to
         // subtract 256 or not........
-        CGPathMoveToPoint(path, &transform,
-            P.get_x(), ((float)(INTERMEDIATE_BITMAP_WIDTH))-P.get_y());
-        for (size_t j = 1; j < num_points_in_stroke; j++) {
-            const flex_dict &point_dict = stroke[j].get<flex_dict>();
-            Point P(point_dict);
-            CGPathAddLineToPoint(path, &transform,
-                P.get_x(), ((float)(INTERMEDIATE_BITMAP_WIDTH))-P.get_y());
+        CGPathMoveToPoint(path, &transform, drawing.xs[stroke_begin],
+            ((float)(INTERMEDIATE_BITMAP_WIDTH))-drawing.ys[stroke_begin]);
+        for (size_t j = stroke_begin + 1; j < stroke_end; j++) {
+            CGPathAddLineToPoint(path, &transform, drawing.xs[j],
+                ((float)(INTERMEDIATE_BITMAP_WIDTH))-drawing.ys[j]);
         }
+        stroke_begin = stroke_end;
     }
     CGContextSetLineWidth(intermediate_bitmap_context, STROKE_WIDTH);
     CGContextBeginPath(intermediate_bitmap_context);
@@ -390,72 +376,74 @@ flex_image rasterize_on_mac(flex_list simplified_drawing) {
 }
 #endif // __APPLE__
 
-flex_image rasterize(flex_list simplified_drawing) {
-    flex_image final_bitmap; // 1 x 28 x 28
-    size_t num_strokes = simplified_drawing.size();
-#ifdef __APPLE__
-    return rasterize_on_mac(simplified_drawing);
-#endif // __APPLE__
-    std::vector<size_t> intermediate_bitmap_shape {1, INTERMEDIATE_BITMAP_WIDTH, INTERMEDIATE_BITMAP_HEIGHT};
-    flex_nd_vec intermediate_bitmap(intermediate_bitmap_shape, 0.0);
-    for (size_t i = 0; i < num_strokes; i++) {
-        const flex_list &stroke = simplified_drawing[i].get<flex_list>();
-        const flex_dict &start_point_dict = stroke[0].get<flex_dict>();
-        size_t num_points_in_stroke = stroke.size();
-        Point last_point(start_point_dict);
-        for (size_t j = 1; j < num_points_in_stroke; j++) {
-            const flex_dict &next_point_dict = stroke[j].get<flex_dict>();
-            Point next(next_point_dict);
-            intermediate_bitmap = paint_stroke(
-                intermediate_bitmap, last_point, next, STROKE_WIDTH);
-            last_point = next;
-        }
+static flex_image bitmap_to_image(const float *bitmap) {
+    uint8_t image_data[FINAL_BITMAP_WIDTH * FINAL_BITMAP_HEIGHT];
+    for (size_t idx = 0; idx < FINAL_BITMAP_WIDTH * FINAL_BITMAP_HEIGHT; idx++) {
+        image_data[idx] = (uint8_t)(bitmap[idx]);
     }
-    int CHOSEN_KERNEL_SIZE = 7;
-    final_bitmap = blur_bitmap(intermediate_bitmap, CHOSEN_KERNEL_SIZE);
-    final_bitmap = image_util::resize_image(
-        final_bitmap,
-        FINAL_BITMAP_WIDTH,
-        FINAL_BITMAP_HEIGHT,
-        1, true).get<flex_image>();
-    return final_bitmap;
-}
-
-flex_image convert_stroke_based_drawing_to_bitmap(
-    flex_list stroke_based_drawing, int row_number) {
-    flex_list normalized_drawing = simplify_drawing(
-        stroke_based_drawing, row_number);
-    flex_image bitmap = rasterize(normalized_drawing);
-    return bitmap;
+    return flex_image((const char *)image_data,
+        FINAL_BITMAP_HEIGHT,                        // height
+        FINAL_BITMAP_WIDTH,                         // width
+        1,                                          // channels
+        FINAL_BITMAP_WIDTH * FINAL_BITMAP_HEIGHT,   // image_data_size
+        IMAGE_TYPE_CURRENT_VERSION,                 // version
+        2);                                         // format
+        // last argument is turi::Format::RAW_ARRAY, which has a value of 2
 }
 
-static std::map<std::string,size_t> generate_column_index_map(
-    const std::vector<std::string>& column_names) {
-    std::map<std::string,size_t> index_map;
-    for (size_t k=0; k < column_names.size(); ++k) {
-        index_map[column_names[k]] = k;
+gl_sarray rasterize_drawings(const gl_sarray &drawings,
+                             flex_type_enum output_type) {
+    if (output_type != flex_type_enum::IMAGE
+        && output_type != flex_type_enum::ND_VECTOR) {
+        log_and_throw("Drawings can only be rasterized to images or arrays.");
     }
-    return index_map;
+
+    const size_t num_rows = drawings.size();
+    const size_t num_segments = thread::cpu_count();
+    const std::vector<size_t> array_shape {
+        FINAL_BITMAP_HEIGHT, FINAL_BITMAP_WIDTH, 1};
+    gl_sarray_writer writer(output_type, num_segments);
+
+    in_parallel([&](size_t thread_idx, size_t num_threads) {
+        size_t start_idx = num_rows * thread_idx / num_threads;
+        size_t end_idx = num_rows * (thread_idx + 1) / num_threads;
+
+        parsed_drawing drawing;
+        std::vector<float> bitmap(FINAL_BITMAP_WIDTH * FINAL_BITMAP_HEIGHT);
+        size_t row_number = start_idx;
+        for (const auto &strokes : drawings.range_iterator(start_idx, end_idx)) {
+            if (strokes.get_type() != flex_type_enum::LIST) {
+                log_and_throw("The drawing in row " + std::to_string(row_number)
+                    + " is not a list of strokes.");
+            }
+            parse_drawing(strokes.get<flex_list>(), row_number, drawing);
+            if (output_type == flex_type_enum::IMAGE) {
+#ifdef __APPLE__
+                writer.write(rasterize_on_mac(drawing), thread_idx);
+#else
+                rasterize(drawing, bitmap.data());
+                writer.write(bitmap_to_image(bitmap.data()), thread_idx);
+#endif // __APPLE__
+            } else {
+                rasterize(drawing, bitmap.data());
+                writer.write(flex_nd_vec(
+                    flex_nd_vec::container_type(bitmap.begin(), bitmap.end()),
+                    array_shape), thread_idx);
+            }
+            row_number++;
+        }
+    });
+
+    return writer.close();
 }
 
 gl_sframe _drawing_classifier_prepare_data(const gl_sframe &data,
                                            const std::string &feature) {
     DASSERT_TRUE(data.contains_column(feature));
 
-    std::vector<flexible_type> bitmaps;
-    auto column_index_map = generate_column_index_map(data.column_names());
-    int row_number = 0;
-    for (const auto& row: data.range_iterator()) {
-        const flexible_type &strokes = row[column_index_map[feature]];
-        flex_list current_stroke_based_drawing = strokes.to<flex_list>();
-        bitmaps.push_back(convert_stroke_based_drawing_to_bitmap(
-            current_stroke_based_drawing, row_number)
-        );
-        row_number++;
-    }
-    gl_sarray bitmaps_sarray(bitmaps);
     gl_sframe converted_sframe = gl_sframe(data);
-    converted_sframe[feature] = bitmaps_sarray;
+    converted_sframe[feature] = rasterize_drawings(
+        data[feature], flex_type_enum::IMAGE);
     converted_sframe.materialize();
     return converted_sframe;
 }
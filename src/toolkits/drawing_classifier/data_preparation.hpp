@@ -32,6 +32,25 @@ namespace drawing_classifier {
 EXPORT gl_sframe _drawing_classifier_prepare_data(const gl_sframe &data,
 												  const std::string &feature);
 
+/**
+ *  Rasterizes a column of stroke-based drawings into 28x28 grayscale bitmaps,
+ *  in parallel segments of the column.
+ *
+ *  Each drawing is read straight from its list of strokes into flat arrays
+ *  of coordinates, normalized and simplified, and its segments are painted
+ *  anti-aliased, scanline by scanline, directly at 28x28.
+ *
+ * \param[in] drawings: SArray of stroke-based drawings, in the format
+ *					   described above.
+ * \param[in] output_type: flex_type_enum::IMAGE for grayscale tc.Image, or
+ *						  flex_type_enum::ND_VECTOR for 28x28x1 arrays of
+ *						  intensities in [0, 255].
+ *
+ * \return: SArray of the bitmaps, in the order of the drawings.
+ */
+EXPORT gl_sarray rasterize_drawings(const gl_sarray &drawings,
+									flex_type_enum output_type);
+
 
 }
 }
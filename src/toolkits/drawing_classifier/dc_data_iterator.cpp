@@ -27,7 +27,20 @@ namespace {
 using neural_net::shared_float_array;
 
 void add_drawing_pixel_data_to_batch(float* next_drawing_pointer,
-                                     const flex_image& bitmap) {
+                                     const flexible_type& drawing) {
+  // Bitmaps rasterized to arrays are already 28x28x1, row major.
+  if (drawing.get_type() == flex_type_enum::ND_VECTOR) {
+    const flex_nd_vec& bitmap = drawing.get<flex_nd_vec>();
+    if (bitmap.num_elem() != kDrawingHeight * kDrawingWidth * kDrawingChannels) {
+      log_and_throw("Drawing arrays must have 28x28x1 elements.");
+    }
+    flex_nd_vec compact = bitmap.canonicalize();
+    std::copy(compact.elements().begin(), compact.elements().end(),
+              next_drawing_pointer);
+    return;
+  }
+
+  flex_image bitmap = drawing.to<flex_image>();
   image_util::copy_image_to_memory(
       /* image input    */ bitmap,
       /* output pointer */ next_drawing_pointer,
@@ -98,15 +111,21 @@ simple_data_iterator::simple_data_iterator(const parameters& params)
       next_row_(range_iterator_.begin()),
 
       // Initialize random number generator.
-      random_engine_(params.random_seed)
+      random_engine_(params.random_seed),
+
+      num_prefetch_workers_(params.num_prefetch_workers)
 
 {}
 
 bool simple_data_iterator::has_next_batch() {
+  if (prefetcher_) return prefetcher_->has_next();
   return (next_row_ != end_of_rows_);
 }
 
 void simple_data_iterator::reset() {
+  // Stop reading ahead before moving back to the first row.
+  prefetcher_.reset();
+
   range_iterator_ = data_.range_iterator();
   next_row_ = range_iterator_.begin();
   end_of_rows_ = range_iterator_.end();
@@ -116,6 +135,36 @@ void simple_data_iterator::reset() {
 }
 
 data_iterator::batch simple_data_iterator::next_batch(size_t batch_size) {
+  if (num_prefetch_workers_ == 0) {
+    return read_batch(batch_size);
+  }
+
+  if (!prefetcher_) {
+    // Start reading ahead, now that we know the batch size.
+    prefetch_pipeline::options opts;
+    opts.num_workers = num_prefetch_workers_;
+    opts.queue_depth = 2 * num_prefetch_workers_;
+    prefetch_batch_size_ = batch_size;
+    prefetcher_.reset(new prefetch_pipeline(
+        [this, batch_size](batch* out) {
+          if (next_row_ == end_of_rows_) return false;
+          *out = read_batch(batch_size);
+          return true;
+        },
+        [](batch b) { return b; }, opts));
+  } else if (batch_size != prefetch_batch_size_) {
+    log_and_throw("The batch size must not change while prefetching batches.");
+  }
+
+  batch result;
+  if (!prefetcher_->next(&result)) {
+    // The traversal is over, and the workers no longer read the rows.
+    result = read_batch(batch_size);
+  }
+  return result;
+}
+
+data_iterator::batch simple_data_iterator::read_batch(size_t batch_size) {
   size_t image_data_size = kDrawingHeight * kDrawingWidth * kDrawingChannels;
   std::vector<float> batch_drawings(batch_size * image_data_size, 0.f);
   std::vector<float> batch_targets;
@@ -138,7 +187,7 @@ data_iterator::batch simple_data_iterator::next_batch(size_t batch_size) {
     }
 
     add_drawing_pixel_data_to_batch(next_drawing_pointer,
-                                    row[feature_index_].to<flex_image>());
+                                    row[feature_index_]);
     next_drawing_pointer += image_data_size;
 
     batch_targets.emplace_back(
@@ -148,23 +197,8 @@ data_iterator::batch simple_data_iterator::next_batch(size_t batch_size) {
     if (++next_row_ == range_iterator_.end() && repeat_) {
       if (shuffle_) {
         // Shuffle the data.
-        // TODO: This heavyweight shuffle operation introduces spikes into the
-        // wall-clock time of this function. SFrame should either provide an
-        // optimized implementation, or we should implement an approach that
-        // amortizes the cost across calls.
-        gl_sarray indices = gl_sarray::from_sequence(0, data_.size());
         std::uniform_int_distribution<uint64_t> dist(0);  // 0 to max uint64_t
-        uint64_t random_mask = dist(random_engine_);
-        auto randomize_indices = [random_mask](const flexible_type& x) {
-          uint64_t masked_index = random_mask ^ x.to<uint64_t>();
-          return flexible_type(hash64(masked_index));
-        };
-        data_.add_column(
-            indices.apply(randomize_indices, flex_type_enum::INTEGER,
-                          /* skip_undefined */ false),
-            "_random_order");
-        data_ = data_.sort("_random_order");
-        data_.remove_column("_random_order");
+        data_ = data_.shuffle(dist(random_engine_));
       }
 
       // Reset iteration.
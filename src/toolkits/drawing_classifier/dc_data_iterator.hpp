@@ -8,11 +8,13 @@
 #ifndef TURI_DRAWING_CLASSIFICATION_DC_DATA_ITERATOR_HPP_
 #define TURI_DRAWING_CLASSIFICATION_DC_DATA_ITERATOR_HPP_
 
+#include <memory>
 #include <random>
 #include <string>
 #include <vector>
 
 #include <core/data/sframe/gl_sframe.hpp>
+#include <ml/neural_net/batch_pipeline.hpp>
 #include <ml/neural_net/float_array.hpp>
 
 namespace turi {
@@ -67,6 +69,14 @@ class data_iterator {
 
     /** Determines results of shuffle operations if enabled. */
     int random_seed = 0;
+
+    /**
+     * Number of background threads preparing the batches ahead of
+     * next_batch, or 0 to prepare each batch on the calling thread. When
+     * prefetching, every call to next_batch must request the same batch size
+     * until the next reset.
+     */
+    size_t num_prefetch_workers = 0;
   };
 
   /** Defines the output of a data_iterator. */
@@ -129,11 +139,10 @@ class data_iterator {
 };
 
 /**
- * Concrete data_iterator implementation that doesn't attempt any
- * parallelization or background I/O.
+ * Concrete data_iterator implementation.
  *
- * \todo This classs should become an abstract_data_iterator base class with
- *       override points for dispatching work to other threads.
+ * With num_prefetch_workers > 0, a neural_net::batch_pipeline prepares the
+ * upcoming batches of the current traversal in the background.
  */
 class simple_data_iterator : public data_iterator {
  public:
@@ -164,9 +173,14 @@ class simple_data_iterator : public data_iterator {
     std::unordered_map<std::string, int> class_to_index_map;
   };
 
+  typedef neural_net::batch_pipeline<batch, batch> prefetch_pipeline;
+
   target_properties compute_properties(
       const gl_sarray& targets, std::vector<std::string> expected_class_labels);
 
+  // Prepares the next batch on the calling thread.
+  batch read_batch(size_t batch_size);
+
   gl_sframe data_;
   const int target_index_;
   const int predictions_index_;
@@ -181,6 +195,12 @@ class simple_data_iterator : public data_iterator {
   gl_sframe_range::iterator end_of_rows_;
 
   std::default_random_engine random_engine_;
+
+  const size_t num_prefetch_workers_;
+  size_t prefetch_batch_size_ = 0;
+
+  // Declared last, so that its workers stop before the state they read.
+  std::unique_ptr<prefetch_pipeline> prefetcher_;
 };
 
 }  // namespace drawing_classifier
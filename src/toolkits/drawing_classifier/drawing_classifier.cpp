@@ -255,6 +255,7 @@ std::unique_ptr<data_iterator> drawing_classifier::create_iterator(
   data_params.is_train = is_train;
   data_params.target_column_name = read_state<flex_string>("target");
   data_params.feature_column_name = read_state<flex_string>("feature");
+  data_params.num_prefetch_workers = 1;
   return create_iterator(data_params);
 }
 
@@ -1446,7 +1446,9 @@ class flexible_accuracy : public precision_recall_base {
 /**
  * Computes the ROC curve. An aggregated version is computed, where we
  * compute the true positive rate and false positive rate for a set of
- * 1000 predefined thresholds equally spaced from 0 to 1.
+ * num_bins predefined thresholds equally spaced from 0 to 1 (100000 by
+ * default). The bin counts are kept per thread and summed at the end, so
+ * the examples can be registered in parallel without sorting them.
  * For each prediction, we find which bin it belongs to and we increment
  * the count of true positives (where y=1 and yhat is greater than the lower
  * bound for that bin) and the number of false positives.
@@ -1480,7 +1482,7 @@ class roc_curve: public supervised_evaluation_interface {
   // Options
   average_type_enum average = average_type_enum::NONE;
   bool binary = false;
-  const size_t NUM_BINS=100000;
+  size_t num_bins = 100000;
   size_t n_threads = 0;
   size_t num_classes = 0;
 
@@ -1500,16 +1502,19 @@ class roc_curve: public supervised_evaluation_interface {
    * \param[in] index_map Dictionary from flexible_type -> size_t for classes.
    * \param[in] average   Averaging mode
    * \param[in] binary    Is the input mode expected to be binary?
+   * \param[in] num_bins  Number of thresholds (precision of the curve).
    */
   roc_curve(
       std::unordered_map<flexible_type, size_t> index_map =
                   std::unordered_map<flexible_type, size_t>(),
       flexible_type average = FLEX_UNDEFINED,
       bool binary = true,
-      size_t num_classes = size_t(-1)) {
+      size_t num_classes = size_t(-1),
+      size_t num_bins = 100000) {
     this->average = average_type_enum_from_name(average);
     this->binary = binary;
     this->index_map = index_map;
+    this->num_bins = num_bins;
     if (num_classes == size_t(-1)) {
       this->num_classes = index_map.size();
     } else {
@@ -1560,10 +1565,10 @@ class roc_curve: public supervised_evaluation_interface {
       num_examples[i].resize(num_classes);
       for (size_t c = 0; c < num_classes; c++) {
 
-        tpr[i][c].resize(NUM_BINS);
-        fpr[i][c].resize(NUM_BINS);
+        tpr[i][c].resize(num_bins);
+        fpr[i][c].resize(num_bins);
         num_examples[i][c] = 0;
-        for (size_t j = 0; j < NUM_BINS; j++) {
+        for (size_t j = 0; j < num_bins; j++) {
           tpr[i][c][j] = 0;
           fpr[i][c][j] = 0;
         }
@@ -1576,9 +1581,9 @@ class roc_curve: public supervised_evaluation_interface {
     total_examples.resize(num_classes);
     for (size_t c = 0; c < num_classes; c++) {
       total_examples[c] = 0;
-      total_fp[c].resize(NUM_BINS);
-      total_tp[c].resize(NUM_BINS);
-      for (size_t j = 0; j < NUM_BINS; j++) {
+      total_fp[c].resize(num_bins);
+      total_tp[c].resize(num_bins);
+      for (size_t j = 0; j < num_bins; j++) {
        total_fp[c][j] = 0;
        total_tp[c][j] = 0;
       }
@@ -1588,19 +1593,19 @@ class roc_curve: public supervised_evaluation_interface {
 
   const float get_bin(double prediction) const {
     // Assign this prediction to an integer that indicates a "bin" id.
-    size_t bin = std::floor((double) std::max(0.0, prediction * NUM_BINS));
+    size_t bin = std::floor((double) std::max(0.0, prediction * num_bins));
 
     // This effectively makes the upper bin [0.999, 1] instead of [0.999, 1).
     // If a prediction is exactly 1.0, then it would get assigned to
     // a bin with lower bound 1.0, but since we want 1000 bins, we move
     // these into the bin with lower bound 0.999.
-    if (bin >= NUM_BINS) bin = NUM_BINS - 1;
+    if (bin >= num_bins) bin = num_bins - 1;
     return bin;
   }
 
   const float get_lower_bound(size_t bin) const {
     // Get the lower threshold of predictions that fall into this bin.
-    return bin/((double)NUM_BINS);
+    return bin/((double)num_bins);
   }
 
   /**
@@ -1700,7 +1705,7 @@ class roc_curve: public supervised_evaluation_interface {
     for (size_t i = 0; i < n_threads; ++i) {
       for (size_t c = 0; c < num_classes; c++) {
         total_examples[c]  += num_examples[i][c];
-        for (size_t j = 0; j < NUM_BINS; ++j) {
+        for (size_t j = 0; j < num_bins; ++j) {
           total_fp[c][j] += fpr[i][c][j];
           total_tp[c][j] += tpr[i][c][j];
         }
@@ -1710,7 +1715,7 @@ class roc_curve: public supervised_evaluation_interface {
     // Get the number of false positives and true positives for all
     // bins above the current bin.
     for (size_t c = 0; c < num_classes; c++) {
-      for (int j = NUM_BINS-2; j >= 0; --j) {
+      for (int j = num_bins-2; j >= 0; --j) {
         total_fp[c][j] += total_fp[c][j+1];
         total_tp[c][j] += total_tp[c][j+1];
       }
@@ -1726,7 +1731,7 @@ class roc_curve: public supervised_evaluation_interface {
     this->gather_global_metrics();
 
     // Helper function for computing the roc curve from the statistics
-    size_t total_bins = NUM_BINS;
+    size_t total_bins = num_bins;
     size_t _num_classes = this->num_classes;
     auto compute_roc_curve = [total_bins, _num_classes](
           const std::vector<std::vector<size_t>>& total_fp,
@@ -1851,16 +1856,19 @@ class auc: public roc_curve {
    * \param[in] index_map Dictionary from flexible_type -> size_t for classes.
    * \param[in] average   Averaging mode
    * \param[in] binary    Is the input mode expected to be binary?
+   * \param[in] num_bins  Number of thresholds (precision of the score).
    */
   auc(
       std::unordered_map<flexible_type, size_t> index_map =
                   std::unordered_map<flexible_type, size_t>(),
       flexible_type average = "micro",
       bool binary = true,
-      size_t num_classes = size_t(-1)) {
+      size_t num_classes = size_t(-1),
+      size_t num_bins = 100000) {
     this->average = average_type_enum_from_name(average);
     this->binary = binary;
     this->index_map = index_map;
+    this->num_bins = num_bins;
     if (num_classes == size_t(-1)) {
       this->num_classes = index_map.size();
     } else {
@@ -1891,7 +1899,7 @@ class auc: public roc_curve {
     this->gather_global_metrics();
 
     // Compute the auc-score.
-    size_t total_bins = NUM_BINS;
+    size_t total_bins = num_bins;
     auto compute_auc = [total_bins](
           const std::vector<std::vector<size_t>>& total_fp,
           const std::vector<std::vector<size_t>>& total_tp,
@@ -1959,6 +1967,20 @@ class auc: public roc_curve {
   }
 };
 
+/**
+ * The "num_bins" option of roc_curve and auc, if given.
+ */
+inline size_t get_roc_num_bins(const std::map<std::string, variant_type>& kwargs) {
+  if (kwargs.count("num_bins") == 0) {
+    return 100000;
+  }
+  flexible_type num_bins = variant_get_value<flexible_type>(kwargs.at("num_bins"));
+  if (num_bins.get_type() != flex_type_enum::INTEGER || num_bins.get<flex_int>() < 2) {
+    log_and_throw("Option 'num_bins' must be an integer of at least 2.");
+  }
+  return num_bins.get<flex_int>();
+}
+
 /*
  * Factory method to get the set of evaluation metrics.
  * \param[in] metric Name of the metric
@@ -2033,8 +2055,9 @@ inline std::shared_ptr<supervised_evaluation_interface> get_evaluator_metric(
     if (kwargs.count("num_classes") > 0) {
       num_classes = variant_get_value<size_t>(kwargs.at("num_classes"));
     }
+    size_t num_bins = get_roc_num_bins(kwargs);
     evaluator = std::make_shared<roc_curve>(
-                    roc_curve(index_map, average, binary, num_classes));
+          roc_curve(index_map, average, binary, num_classes, num_bins));
 
   } else if(metric == "auc"){
     DASSERT_TRUE(kwargs.count("average") > 0);
@@ -2048,7 +2071,9 @@ inline std::shared_ptr<supervised_evaluation_interface> get_evaluator_metric(
     if (kwargs.count("num_classes") > 0) {
       num_classes = variant_get_value<size_t>(kwargs.at("num_classes"));
     }
-    evaluator = std::make_shared<auc>(auc(index_map, average, binary, num_classes));
+    size_t num_bins = get_roc_num_bins(kwargs);
+    evaluator = std::make_shared<auc>(
+          auc(index_map, average, binary, num_classes, num_bins));
 
   } else if(metric == "flexible_accuracy"){
     DASSERT_TRUE(kwargs.count("average") > 0);
@@ -8,6 +8,7 @@
 #include <core/data/sframe/gl_sframe.hpp>
 #include <core/data/sframe/gl_sarray.hpp>
 #include <toolkits/util/precision_recall.hpp>
+#include <core/parallel/lambda_omp.hpp>
 
 // ML-Data
 #include <ml/ml_data/column_indexer.hpp>
@@ -167,27 +168,34 @@ variant_type _supervised_streaming_evaluator(
   std::shared_ptr<supervised_evaluation_interface> evaluator =
                              get_evaluator_metric(metric, opts);
 
-  // Iterate
+  // Each thread feeds its own range of rows into its own accumulators; the
+  // evaluator merges them in get_metric().
   auto true_reader = targets->get_reader();
   auto pred_reader = predictions->get_reader();
-  size_t current_row = 0;
-  size_t nrows_y = MBSIZE;
-  TURI_ATTRIBUTE_UNUSED_NDEBUG size_t nrows_yhat = MBSIZE;
+  const size_t num_rows = targets->size();
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    // At least a block of rows per thread.
+    num_threads = std::min(num_threads, (num_rows + MBSIZE - 1) / MBSIZE);
+    if (thread_idx >= num_threads) return;
+    size_t start_row = num_rows * thread_idx / num_threads;
+    size_t end_row = num_rows * (thread_idx + 1) / num_threads;
 
-  while (nrows_y == MBSIZE) {
     std::vector<flexible_type> current_yhat;
     std::vector<flexible_type> current_y;
-    nrows_y = true_reader->read_rows(current_row, current_row + MBSIZE,
-        current_y);
-    nrows_yhat = pred_reader->read_rows(current_row, current_row + MBSIZE,
-        current_yhat);
-    DASSERT_EQ(nrows_y, nrows_yhat);
-
-    for (size_t i = 0; i < nrows_y; ++i) {
-      evaluator->register_example(current_y[i], current_yhat[i]);
+    for (size_t row = start_row; row < end_row; row += MBSIZE) {
+      size_t block_end = std::min(row + MBSIZE, end_row);
+      TURI_ATTRIBUTE_UNUSED_NDEBUG size_t nrows_y =
+          true_reader->read_rows(row, block_end, current_y);
+      TURI_ATTRIBUTE_UNUSED_NDEBUG size_t nrows_yhat =
+          pred_reader->read_rows(row, block_end, current_yhat);
+      DASSERT_EQ(nrows_y, nrows_yhat);
+
+      for (size_t i = 0; i < current_y.size(); ++i) {
+        evaluator->register_example(current_y[i], current_yhat[i], thread_idx);
+      }
     }
-    current_row += MBSIZE;
-  }
+  });
   return evaluator->get_metric();
 }
 
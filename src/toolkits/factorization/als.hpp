@@ -299,7 +299,12 @@ inline std::shared_ptr<factorization::factorization_model> als(
  * References:
  *
  * [1] Collaborative Filtering for Implicit Feedback Datasets (Yifan Hu et. al)
+ * [2] Applications of the Conjugate Gradient Method for Implicit Feedback
+ *     Collaborative Filtering (Takacs et. al)
  *
+ * With ials_linear_solver = "cg", each user and item system is solved
+ * approximately with ials_cg_iterations conjugate gradient steps [2]
+ * instead of an LDLT factorization.
  *
  * Python Pseudo code for this method is:
  * ---------------------------------------------------------------------------
@@ -355,7 +360,6 @@ inline std::shared_ptr<factorization::factorization_model> implicit_als(
 
 
   // Global variables needed
-  DenseMatrix eye = DenseMatrix::Identity(num_factors, num_factors);
   double rmse, best_rmse = 1e20;
   std::vector<double>rmse_per_thread
           (turi::thread_pool::get_instance().size(), 0.0);
@@ -381,28 +385,110 @@ inline std::shared_ptr<factorization::factorization_model> implicit_als(
 	double reset_fraction = 1;
 	double reset_fraction_reduction_rate = 1e-2;
 
+  // The linear system of each user (item) is G + sum_j c_j y_j y_j^T,
+  // where G = lambda * I + Y^T Y is shared by all of them. With the
+  // conjugate gradient solver, it is never formed: each CG step only
+  // multiplies by G and by the rows y_j, and starts from the previous
+  // factors, which are already close to the solution after the first
+  // iterations. That costs O(k^2 + n k) per step, instead of the
+  // O(n k^2 + k^3) of building and factoring the system.
+  std::string linear_solver = (options.count("ials_linear_solver")
+                               ? std::string(options.at("ials_linear_solver"))
+                               : std::string("auto"));
+  bool use_cg = (linear_solver == "cg"
+                 || (linear_solver == "auto" && num_factors >= 64));
+  size_t cg_iterations = (options.count("ials_cg_iterations")
+                          ? size_t(options.at("ials_cg_iterations")) : 3);
+
+  DenseMatrix G(num_factors, num_factors);
+
+  // Per thread buffers, reused for every user and item.
+  struct solve_workspace {
+    DenseMatrix A;
+    DenseVector b, x, r, p, Ap;
+    std::vector<size_t> rows;
+    std::vector<float> confidence;
+  };
+  std::vector<solve_workspace> workspaces(turi::thread_pool::get_instance().size());
+  for (auto& ws : workspaces) {
+    ws.A.resize(num_factors, num_factors);
+    ws.b.resize(num_factors);
+    ws.x.resize(num_factors);
+    ws.r.resize(num_factors);
+    ws.p.resize(num_factors);
+    ws.Ap.resize(num_factors);
+  }
+
+  // Solve for the factors of target_row, given the rows and the
+  // confidences gathered in ws.
+  auto solve_row = [&](size_t target_row, solve_workspace& ws) {
+    ws.b.setZero();
+    for (size_t j = 0; j < ws.rows.size(); ++j) {
+      ws.b += (1 + ws.confidence[j]) * model->V.row(ws.rows[j]).transpose();
+    }
+
+    if (!use_cg) {
+      ws.A.triangularView<Eigen::Upper>() = G;
+      for (size_t j = 0; j < ws.rows.size(); ++j) {
+        ws.A.triangularView<Eigen::Upper>() += ws.confidence[j] *
+            model->V.row(ws.rows[j]).transpose() * model->V.row(ws.rows[j]);
+      }
+      model->V.row(target_row) =
+          (ws.A.selfadjointView<Eigen::Upper>().ldlt().solve(ws.b)).transpose();
+      return;
+    }
+
+    auto multiply = [&](const DenseVector& v, DenseVector& out) {
+      out.noalias() = G * v;
+      for (size_t j = 0; j < ws.rows.size(); ++j) {
+        auto y = model->V.row(ws.rows[j]);
+        out += (ws.confidence[j] * y.dot(v.transpose())) * y.transpose();
+      }
+    };
+
+    ws.x = model->V.row(target_row).transpose();
+    multiply(ws.x, ws.Ap);
+    ws.r = ws.b - ws.Ap;
+    ws.p = ws.r;
+    float rs = ws.r.squaredNorm();
+
+    for (size_t t = 0; t < cg_iterations && rs > 1e-20; ++t) {
+      multiply(ws.p, ws.Ap);
+      float pAp = ws.p.dot(ws.Ap);
+      if (pAp <= 0) break;
+
+      float step = rs / pAp;
+      ws.x += step * ws.p;
+      ws.r -= step * ws.Ap;
+
+      float rs_new = ws.r.squaredNorm();
+      ws.p = ws.r + (rs_new / rs) * ws.p;
+      rs = rs_new;
+    }
+
+    model->V.row(target_row) = ws.x.transpose();
+  };
+
   // Each iteration of ALS
   // --------------------------------------------------------------------------
   size_t iter = 0;
   for (iter = 0; iter < max_iters; iter++){
 
     // Calcuate the common base matrix to use.
-    DenseMatrix A_cached(num_factors, num_factors);
-    A_cached.triangularView<Eigen::Upper>() = lambda * eye +
-          model->V.bottomRows(num_items).transpose() * model->V.bottomRows(num_items);
+    G.noalias() = model->V.bottomRows(num_items).transpose()
+                    * model->V.bottomRows(num_items);
+    G.diagonal().array() += float(lambda);
 
     // Step 1: User step
     // ------------------------------------------------------------------------
     in_parallel([&](size_t thread_idx, size_t num_threads) {
-    DenseMatrix A(num_factors, num_factors);
-    DenseVector b(num_factors);
+    solve_workspace& ws = workspaces[thread_idx];
+    ws.rows.clear();
+    ws.confidence.clear();
 
     std::vector<v2::ml_data_entry> x;
     double scaling = 0.0;
     size_t user_id, item_id = 0;
-    A.triangularView<Eigen::Upper>() = A_cached;
-
-    b.setZero();
 
     for(auto it =
         training_data_by_user.get_block_iterator(thread_idx, num_threads);
@@ -415,38 +501,36 @@ inline std::shared_ptr<factorization::factorization_model> implicit_als(
       } else {
         scaling = alpha * it.target_value();
       }
-      A.triangularView<Eigen::Upper>() += scaling *
-                    model->V.row(item_id).transpose() * model->V.row(item_id);
-      b += (1 + scaling) * model->V.row(item_id);
+      ws.rows.push_back(item_id);
+      ws.confidence.push_back(scaling);
       ++it;
 
       // Update user factor
       if(it.is_start_of_new_block() || it.done()){
-        model->V.row(user_id) =
-            (A.selfadjointView<Eigen::Upper>().ldlt().solve(b)).transpose();
+        solve_row(user_id, ws);
         if (it.done()) break;
 
         // Reset for the next user
-        A.triangularView<Eigen::Upper>() = A_cached;
-        b.setZero();
+        ws.rows.clear();
+        ws.confidence.clear();
       }
     }});
 
     // Step 2: Item Step
     // ------------------------------------------------------------------------
     // Compute Yt C Y using equation (4) of [1]
+    G.noalias() = model->V.topRows(num_users).transpose()
+                    * model->V.topRows(num_users);
+    G.diagonal().array() += float(lambda);
+
     in_parallel([&](size_t thread_idx, size_t num_threads) {
-    DenseMatrix A(num_factors, num_factors);
-    DenseMatrix A_cached(num_factors, num_factors);
-    DenseVector b(num_factors);
+    solve_workspace& ws = workspaces[thread_idx];
+    ws.rows.clear();
+    ws.confidence.clear();
 
     std::vector<v2::ml_data_entry> x;
     size_t user_id, item_id = 0;
     double scaling = 0.0;
-    A_cached.triangularView<Eigen::Upper>() = lambda * eye +
-          model->V.topRows(num_users).transpose() * model->V.topRows(num_users);
-    A.triangularView<Eigen::Upper>() = A_cached;
-    b.setZero();
 
     for(auto it =
         training_data_by_item.get_block_iterator(thread_idx, num_threads);
@@ -460,20 +544,18 @@ inline std::shared_ptr<factorization::factorization_model> implicit_als(
       } else {
         scaling = alpha * std::max(it.target_value(), 0.0);
       }
-      A.triangularView<Eigen::Upper>() += scaling *
-                    model->V.row(user_id).transpose() * model->V.row(user_id);
-      b += (1 + scaling) * model->V.row(user_id);
+      ws.rows.push_back(user_id);
+      ws.confidence.push_back(scaling);
       ++it;
 
       // Solve the system
       if(it.is_start_of_new_block() || it.done()){
-        model->V.row(item_id) =
-          (A.selfadjointView<Eigen::Upper>().ldlt().solve(b)).transpose();
+        solve_row(item_id, ws);
         if (it.done()) break;
 
         // Reset for the next item
-        A.triangularView<Eigen::Upper>() = A_cached;
-        b.setZero();
+        ws.rows.clear();
+        ws.confidence.clear();
       }
     }});
 
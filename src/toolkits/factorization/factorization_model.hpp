@@ -150,6 +150,37 @@ class factorization_model {
       size_t top_k,
       const std::shared_ptr<v2::ml_data_side_features>& known_side_features) const = 0;
 
+  /** The latent factors and the linear term of one index of a column;
+   *  zeros for an index not seen in training.
+   */
+  virtual void get_factors(size_t column_index, size_t index,
+                           std::vector<double>& factors,
+                           double& linear_term) const = 0;
+
+  /** True if score_top_k_items and score_items can be used, i.e. a
+   *  query of only a user and an item is scored from their factors and
+   *  linear terms.
+   */
+  virtual bool can_score_users_in_blocks() const = 0;
+
+  /** Scores the given items for one user, as score_top_k_items does,
+   *  and sorts them best first.
+   */
+  virtual void score_items(std::vector<std::pair<size_t, double> >& item_scores,
+                           size_t user) const = 0;
+
+  /** Scores all the items [0, num_items) for each of the users, as a
+   *  matrix product over tiles of items, and keeps the top_k of each
+   *  user, best first, skipping the items in the user's sorted
+   *  excluded_items.  Used by the recommender system.
+   */
+  virtual void score_top_k_items(
+      std::vector<std::vector<std::pair<size_t, double> > >& top_items,
+      const std::vector<size_t>& users,
+      size_t num_items,
+      size_t top_k,
+      const std::vector<std::vector<size_t> >& excluded_items) const = 0;
+
   /**  Resets the state with an initial random seed and standard
    *  deviation.
    */
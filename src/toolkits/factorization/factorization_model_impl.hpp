@@ -17,11 +17,14 @@
 #include <core/data/flexible_type/flexible_type.hpp>
 #include <toolkits/ml_data_2/ml_data.hpp>
 #include <core/storage/serialization/serialization_includes.hpp>
+#include <core/storage/serialization/mapped_eigen_matrix.hpp>
 #include <toolkits/ml_data_2/ml_data_iterators.hpp>
 #include <toolkits/factorization/factorization_model.hpp>
 #include <toolkits/factorization/factors_to_sframe.hpp>
 #include <model_server/lib/extensions/model_base.hpp>
 #include <core/util/fast_top_k.hpp>
+#include <core/random/counter_rng.hpp>
+#include <core/globals/memory_accounting.hpp>
 
 namespace turi { namespace factorization {
 
@@ -70,8 +73,14 @@ public:
   // Declare model variables.
 
   volatile double w0 = NAN;
-  vector_type w;
-  factor_matrix_type V;
+  // Held in mapped storage, so that the parameters of a large model loaded
+  // from a local archive are paged in lazily and shared between processes.
+  mapped_eigen_matrix<vector_type> w;
+  mapped_eigen_matrix<factor_matrix_type> V;
+
+  // The bytes of w and V, counted as model parameters.
+  memory_accounting::tagged_memory parameter_memory{
+      memory_accounting::get_tag("model_parameters")};
 
   ////////////////////////////////////////////////////////////////////////////////
   // Declare variables for calculating things.
@@ -152,12 +161,15 @@ public:
 
     w.resize(n_total_dimensions);
     V.resize(num_factor_dimensions, num_factors());
+    parameter_memory.set((w.size() + V.size()) * sizeof(float));
 
     reset_state(options.at("random_seed"), 0.001);
   }
 
   /** Initialize the model at a random starting point.  Is
-   *  deterministic based on the random seed and num_threads.
+   *  deterministic based on the random seed alone: every parameter is
+   *  drawn from a counter based generator keyed on its index, so the
+   *  number of threads does not matter.
    */
   void reset_state(size_t random_seed, double sd) GL_HOT {
 
@@ -168,8 +180,13 @@ public:
     size_t num_factor_init_random = index_sizes[0] + index_sizes[1];
     size_t num_factor_init_zero = num_factor_dimensions - num_factor_init_random;
 
+    // Independent streams for the linear terms, the factors, and the
+    // choice of which factor terms start large.
+    const random::counter_rng w_rng(random_seed, 0);
+    const random::counter_rng V_rng(random_seed, 1);
+    const random::counter_rng V_scale_rng(random_seed, 2);
+
     in_parallel([&](size_t thread_idx, size_t num_threads) GL_GCC_ONLY(GL_HOT_FLATTEN) {
-        random::seed(hash64(random_seed, thread_idx, num_threads));
 
         // Compute the w part.
         if(enable_linear_features) {
@@ -178,7 +195,7 @@ public:
           size_t end_w_idx = ((thread_idx + 1) * n_total_dimensions) / num_threads;
 
           for(size_t i = start_w_idx; i < end_w_idx; ++i)
-            w[i] = (sd > 0) ? random::fast_uniform<double>(-sd/2, sd/2) : 0;
+            w[i] = (sd > 0) ? w_rng.uniform(i, -sd/2, sd/2) : 0;
         } else {
           w.setZero();
         }
@@ -193,6 +210,7 @@ public:
 
               double lb = nmf_mode ? 0 : -V_sd / 2;
               double ub = nmf_mode ? V_sd : V_sd / 2;
+              size_t idx = i * num_factors() + j;
 
               // Now, to promote diversity at the beginning, only have
               // a handful of the factor terms on each particular
@@ -206,9 +224,9 @@ public:
               // observations, num_factors > 100), this gave good
               // starting values and didn't diverge on reset.
 
-              V(i, j) = (V_sd > 0) ? random::fast_uniform<double>(lb, ub) : 0;
+              V(i, j) = (V_sd > 0) ? V_rng.uniform(idx, lb, ub) : 0;
 
-              if(random::fast_uniform<size_t>(0, num_factors()) > std::min<size_t>(4ULL, num_factors() / 2))
+              if(V_scale_rng.uniform_int(idx, 0, num_factors()) > std::min<size_t>(4ULL, num_factors() / 2))
                 V(i, j) /= 1000;
             }
           }
@@ -502,7 +520,7 @@ public:
   ////////////////////////////////////////////////////////////////////////////////
   // Saving and loading of the model.
 
-  size_t get_version() const { return 1; }
+  size_t get_version() const { return 2; }
 
   /**  Save routine.
    */
@@ -528,7 +546,8 @@ public:
   /** Load routine.
    */
   void load_version(turi::iarchive& iarc, size_t version) {
-    DASSERT_EQ(version, 1);
+    ASSERT_MSG(version == 1 || version == 2,
+               "This model version cannot be loaded. Please re-save your model.");
 
     variant_type terms_v;
 
@@ -550,8 +569,20 @@ public:
 
     // Now dump out the other things.
     double _w0;
-    iarc >> _w0 >> w >> V;
+    if (version == 1) {
+      // Version 1 stored the parameters as plain Eigen matrices.
+      vector_type _w;
+      factor_matrix_type _V;
+      iarc >> _w0 >> _w >> _V;
+      w.resize(_w.size());
+      w = _w;
+      V.resize(_V.rows(), _V.cols());
+      V = _V;
+    } else {
+      iarc >> _w0 >> w >> V;
+    }
     w0 = _w0;
+    parameter_memory.set((w.size() + V.size()) * sizeof(float));
 
     setup_buffers();
   }
@@ -814,6 +845,184 @@ public:
     }
   }
 
+  void get_factors(size_t column_index, size_t index,
+                   std::vector<double>& factors,
+                   double& linear_term) const {
+
+    factors.assign(num_factors(), 0);
+    linear_term = 0;
+
+    if(index >= index_sizes[column_index])
+      return;
+
+    size_t global_index = index_offsets[column_index] + index;
+
+    linear_term = w[global_index];
+
+    if(global_index < size_t(V.rows())) {
+      for(size_t i = 0; i < num_factors(); ++i)
+        factors[i] = V(global_index, i);
+    }
+  }
+
+  /** With only the user and the item in the query, a factorization
+   *  machine scores them as matrix factorization does, since both
+   *  columns are categorical and so neither shifted nor scaled.
+   */
+  bool can_score_users_in_blocks() const {
+    return factor_mode != model_factor_mode::pure_linear_model;
+  }
+
+  void score_items(std::vector<std::pair<size_t, double> >& item_scores,
+                   size_t user) const {
+
+    DASSERT_TRUE(factor_mode != model_factor_mode::pure_linear_model);
+
+    const size_t users_offset = index_offsets[USER_COLUMN_INDEX];
+    const size_t items_offset = index_offsets[ITEM_COLUMN_INDEX];
+    const bool user_is_known = (user < index_sizes[USER_COLUMN_INDEX]);
+
+    for(auto& p : item_scores) {
+      double fx = w0;
+
+      if(user_is_known)
+        fx += w[users_offset + user];
+
+      if(p.first < index_sizes[ITEM_COLUMN_INDEX]) {
+        fx += w[items_offset + p.first];
+
+        if(user_is_known)
+          fx += V.row(users_offset + user).dot(V.row(items_offset + p.first));
+      }
+
+      p.second = loss_model->translate_fx_to_prediction(fx);
+    }
+
+    std::sort(item_scores.begin(), item_scores.end(),
+              [](const std::pair<size_t, double>& p1,
+                 const std::pair<size_t, double>& p2) {
+                return p1.second > p2.second;
+              });
+  }
+
+  /** Scores all the items for a block of users.  The factor products
+   *  are computed as one matrix product per tile of items, sized to
+   *  stay in cache, and each user's top_k is kept in a heap as the
+   *  tile is read, so the full score matrix is never stored.
+   *
+   *  Users and items not seen in training have no factors or linear
+   *  term, as in calculate_fx.
+   */
+  void score_top_k_items(
+      std::vector<std::vector<std::pair<size_t, double> > >& top_items,
+      const std::vector<size_t>& users,
+      size_t num_items,
+      size_t top_k,
+      const std::vector<std::vector<size_t> >& excluded_items) const GL_HOT {
+
+    DASSERT_TRUE(factor_mode != model_factor_mode::pure_linear_model);
+    DASSERT_EQ(users.size(), excluded_items.size());
+
+    static constexpr size_t ITEM_TILE_SIZE = 256;
+
+    typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> score_matrix_type;
+
+    const size_t n_users      = users.size();
+    const size_t users_offset = index_offsets[USER_COLUMN_INDEX];
+    const size_t items_offset = index_offsets[ITEM_COLUMN_INDEX];
+    const size_t n_model_items = std::min(num_items, index_sizes[ITEM_COLUMN_INDEX]);
+
+    top_items.resize(n_users);
+    for(auto& ti : top_items) {
+      ti.clear();
+    }
+
+    if(top_k == 0 || n_users == 0)
+      return;
+
+    // The factors of the users, and the part of their scores that
+    // does not depend on the item.
+    factor_matrix_type U(n_users, num_factors());
+    std::vector<double> adjustment(n_users);
+
+    for(size_t i = 0; i < n_users; ++i) {
+      if(users[i] < index_sizes[USER_COLUMN_INDEX]) {
+        U.row(i) = V.row(users_offset + users[i]);
+        adjustment[i] = w0 + w[users_offset + users[i]];
+      } else {
+        U.row(i).setZero();
+        adjustment[i] = w0;
+      }
+    }
+
+    // Each user's top_k is a min-heap on the score; the position in its
+    // exclusion list moves forward with the items.
+    std::vector<size_t> excluded_pos(n_users, 0);
+
+    auto greater_score = [](const std::pair<size_t, double>& p1,
+                            const std::pair<size_t, double>& p2) {
+      return p1.second > p2.second;
+    };
+
+    auto add_item = [&](size_t i, size_t item, double score) GL_GCC_ONLY(GL_HOT_INLINE) {
+      const std::vector<size_t>& excl = excluded_items[i];
+      size_t& pos = excluded_pos[i];
+
+      while(pos < excl.size() && excl[pos] < item)
+        ++pos;
+
+      if(pos < excl.size() && excl[pos] == item)
+        return;
+
+      std::vector<std::pair<size_t, double> >& heap = top_items[i];
+
+      if(heap.size() < top_k) {
+        heap.push_back({item, score});
+        std::push_heap(heap.begin(), heap.end(), greater_score);
+      } else if(score > heap.front().second) {
+        std::pop_heap(heap.begin(), heap.end(), greater_score);
+        heap.back() = {item, score};
+        std::push_heap(heap.begin(), heap.end(), greater_score);
+      }
+    };
+
+    score_matrix_type tile_scores(n_users, ITEM_TILE_SIZE);
+
+    for(size_t tile_start = 0; tile_start < n_model_items; tile_start += ITEM_TILE_SIZE) {
+      const size_t tile_size = std::min(ITEM_TILE_SIZE, n_model_items - tile_start);
+
+      tile_scores.leftCols(tile_size).noalias() =
+          U * V.middleRows(items_offset + tile_start, tile_size).transpose();
+
+      for(size_t i = 0; i < n_users; ++i) {
+        const float* row_scores = tile_scores.row(i).data();
+
+        for(size_t j = 0; j < tile_size; ++j) {
+          size_t item = tile_start + j;
+          add_item(i, item, adjustment[i] + w[items_offset + item] + row_scores[j]);
+        }
+      }
+    }
+
+    // Items not seen in training.
+    for(size_t i = 0; i < n_users; ++i) {
+      for(size_t item = n_model_items; item < num_items; ++item) {
+        add_item(i, item, adjustment[i]);
+      }
+    }
+
+    for(size_t i = 0; i < n_users; ++i) {
+      std::vector<std::pair<size_t, double> >& heap = top_items[i];
+      std::sort_heap(heap.begin(), heap.end(), greater_score);
+
+      if(loss_model->prediction_is_translated()) {
+        for(auto& p : heap) {
+          p.second = loss_model->translate_fx_to_prediction(p.second);
+        }
+      }
+    }
+  }
+
   /**  Run the recommendations when the routine uses something more
    *   than just the straight matrix factorization.  In this case, we
    *   call the calculate_fx function to get the scores, then get the
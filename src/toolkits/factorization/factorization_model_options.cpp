@@ -166,6 +166,16 @@ void factorization_model::add_options(
     opt.upper_bound = std::numeric_limits<int>::max();
     options.create_option(opt);
 
+    opt.name = "negative_sample_popularity_power";
+    opt.description = ("Unobserved items are sampled with probability proportional to "
+                       "their number of observations (plus one) raised to this power. "
+                       "0 samples them uniformly.");
+    opt.default_value = 0;
+    opt.parameter_type = option_handling::option_info::REAL;
+    opt.lower_bound = 0;
+    opt.upper_bound = 2;
+    options.create_option(opt);
+
     // opt.name = "_ranking_loss_type";
     // opt.description = "The type of ranking loss to use; options are hinge or exponential.";
     // opt.default_value = "logit";
@@ -197,6 +207,25 @@ void factorization_model::add_options(
     opt.upper_bound = std::numeric_limits<int>::max();
     options.create_option(opt);
 
+    opt.name = "ials_linear_solver";
+    opt.description = ("The solver for the per user and per item systems in implicit"
+                       " matrix factorization; 'cg' uses a few conjugate gradient steps"
+                       " warm-started from the previous factors, 'auto' uses it with"
+                       " 64 or more factors.");
+    opt.default_value = "auto";
+    opt.parameter_type = option_handling::option_info::CATEGORICAL;
+    opt.allowed_values = {"auto", "ldlt", "cg"};
+    options.create_option(opt);
+
+    opt.name = "ials_cg_iterations";
+    opt.description = ("The number of conjugate gradient steps per user and per item"
+                       " with ials_linear_solver='cg'.");
+    opt.default_value = 3;
+    opt.parameter_type = option_handling::option_info::INTEGER;
+    opt.lower_bound = 1;
+    opt.upper_bound = 1000;
+    options.create_option(opt);
+
   } else {
 
     opt.name = "regularization";
@@ -79,8 +79,9 @@ class factorization_sgd_interface final : public sgd::sgd_interface_base {
   static constexpr model_factor_mode factor_mode   = GLMModel::factor_mode;
   static constexpr flex_int num_factors_if_known         = GLMModel::num_factors_if_known;
 
-  // Enable item locking if we're in matrix factorization mode.
-  static constexpr bool enable_item_locking = true; // (factor_mode == model_factor_mode::matrix_factorization);
+  // Lock the item of each observation during its update unless the
+  // lock-free (Hogwild) updates are requested with sgd_lock_free.
+  bool enable_item_locking = true;
 
   /**  Trial mode is used to find the sgd step size.
    *
@@ -242,6 +243,10 @@ class factorization_sgd_interface final : public sgd::sgd_interface_base {
     std::vector<variable> v;
 
     factor_type xv_accumulator;
+
+    // Keeps the buffers of different threads, which are written on
+    // every step, off each other's cache lines.
+    char _padding[64];
   };
 
   mutable std::vector<sgd_processing_buffer> buffers, alt_buffers;
@@ -285,6 +290,8 @@ class factorization_sgd_interface final : public sgd::sgd_interface_base {
 
     adagrad_mode = (options.at("solver") == "adagrad");
 
+    enable_item_locking = !(options.count("sgd_lock_free") && bool(options.at("sgd_lock_free")));
+
     if(adagrad_mode)
         adagrad_momentum_weighting = options.at("adagrad_momentum_weighting");
 
@@ -352,11 +359,12 @@ class factorization_sgd_interface final : public sgd::sgd_interface_base {
         break;
     }
 
-    // Set up the locking buffers if needed.
+    // Set up the locking buffers.  These are allocated even in
+    // lock-free mode, as the (unlocked) lock guards still refer to
+    // them.
     static constexpr size_t ITEM_COLUMN_INDEX = 1;
 
-    if(enable_item_locking)
-      item_locks.resize(train_data.metadata()->index_size(ITEM_COLUMN_INDEX));
+    item_locks.resize(train_data.metadata()->index_size(ITEM_COLUMN_INDEX));
 
     // Set up the stuff for adagrad
     if(adagrad_mode) {
@@ -6,9 +6,12 @@
 #ifndef TURI_SGD_RANKING_SGD_SOLVER_BASE_CLASS_H_
 #define TURI_SGD_RANKING_SGD_SOLVER_BASE_CLASS_H_
 
+#include <cmath>
 #include <map>
+#include <memory>
 #include <vector>
 #include <type_traits>
+#include <core/random/alias.hpp>
 #include <core/util/code_optimization.hpp>
 #include <toolkits/ml_data_2/ml_data.hpp>
 #include <toolkits/ml_data_2/ml_data_iterators.hpp>
@@ -37,6 +40,11 @@ class ranking_sgd_solver_base : public sgd::sgd_solver_base {
   double num_sampled_negative_examples;
   size_t random_seed = 0;
 
+  /** Draws items in proportion to their popularity, when the negative
+   *  examples are sampled by popularity; null when they are uniform.
+   */
+  std::shared_ptr<random::alias_sampler> negative_item_sampler;
+
  protected:
 
   /**
@@ -53,6 +61,23 @@ class ranking_sgd_solver_base : public sgd::sgd_solver_base {
       , random_seed(hash64(options.at("random_seed")))
   {
     DASSERT_GE(num_sampled_negative_examples, 1);
+
+    double popularity_power = 0;
+    if(options.count("negative_sample_popularity_power"))
+      popularity_power = options.at("negative_sample_popularity_power");
+
+    if(popularity_power > 0) {
+      const size_t ITEM_COLUMN_INDEX = 1;
+      const auto& item_stats = train_data.metadata()->statistics(ITEM_COLUMN_INDEX);
+      size_t n_items = train_data.metadata()->index_size(ITEM_COLUMN_INDEX);
+
+      // Items seen only in the side data still get sampled now and then.
+      std::vector<double> weights(n_items);
+      for(size_t i = 0; i < n_items; ++i)
+        weights[i] = std::pow(double(item_stats->count(i) + 1), popularity_power);
+
+      negative_item_sampler = std::make_shared<random::alias_sampler>(weights);
+    }
   }
 
   ////////////////////////////////////////////////////////////////////////////////
@@ -475,11 +500,21 @@ class ranking_sgd_solver_base : public sgd::sgd_solver_base {
     // items and sample from that.
 
     if(8 * (n_items - n_rated_items) > n_items) {
+      const bool by_popularity = (negative_item_sampler != nullptr
+                                  && negative_item_sampler->size() == n_items);
+      size_t n_rounds = 0;
+
       while(n_points_picked < num_sampled_negative_examples) {
-        // Get num_sampled_negative_examples candidate points.
+        // Get num_sampled_negative_examples candidate points.  The
+        // popular items are the ones the user most likely rated, so
+        // if the popularity weighted draws keep getting rejected,
+        // finish with uniform draws.
+        bool round_by_popularity = by_popularity && (n_rounds++ < 16);
 
         for(size_t i = 0; i < num_sampled_negative_examples; ++i) {
-          size_t candidate_item = random::fast_uniform<size_t>(0, n_items - 1);
+          size_t candidate_item = (round_by_popularity
+                                   ? negative_item_sampler->sample()
+                                   : random::fast_uniform<size_t>(0, n_items - 1));
           item_observed.prefetch(candidate_item);
           candidate_negative_items[i] = candidate_item;
         }
@@ -550,7 +585,9 @@ class ranking_sgd_solver_base : public sgd::sgd_solver_base {
       }
 
       ////////////////////////////////////////
-      // Step 2.2: Sample randomly from the free items.
+      // Step 2.2: Sample randomly from the free items.  These are
+      // drawn uniformly even when sampling by popularity; the user
+      // has rated nearly everything anyway.
 
       proc_buf.available_item_list_chosen_indices.resize(num_sampled_negative_examples);
       for(size_t i = 0; i < num_sampled_negative_examples; ++i) {
@@ -34,6 +34,7 @@ namespace feature_engineering {
 BEGIN_CLASS_REGISTRATION
 REGISTER_CLASS(sample_transformer)
 REGISTER_CLASS(random_projection)
+REGISTER_CLASS(randomized_pca)
 REGISTER_CLASS(quadratic_features)
 REGISTER_CLASS(one_hot_encoder)
 REGISTER_CLASS(count_thresholder)
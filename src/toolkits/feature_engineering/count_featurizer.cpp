@@ -264,6 +264,13 @@ static gl_sarray make_random_real_laplace_array(const gl_sarray& sequential_arra
       }, flex_type_enum::VECTOR);
 }
 
+std::vector<std::string> count_featurizer::get_fit_columns() const {
+  std::vector<std::string> columns =
+      transform_utils::get_explicit_column_names(exclude, unprocessed_features);
+  if (!columns.empty()) columns.push_back((std::string) options.value("target"));
+  return columns;
+}
+
 gl_sframe count_featurizer::fit_transform(gl_sframe raw) {
   fit(raw);
   return transform(raw);
@@ -77,6 +77,7 @@ class EXPORT count_featurizer : public transformer_base {
                         flexible_type>& _options) override;
   void fit(gl_sframe data) override;
   gl_sframe transform(gl_sframe data) override;
+  std::vector<std::string> get_fit_columns() const override;
   gl_sframe fit_transform(gl_sframe data);
 
   // collect the state in a single shared pointer so that this can be
@@ -8,19 +8,27 @@
 #include <toolkits/feature_engineering/transform_utils.hpp>
 
 #include <model_server/lib/variant_deep_serialize.hpp>
+#include <core/data/sframe/gl_sarray.hpp>
+#include <core/parallel/lambda_omp.hpp>
 #include <core/random/random.hpp>
+#include <core/random/counter_rng.hpp>
 #include <toolkits/supervised_learning/supervised_learning_utils-inl.hpp>
 #include <core/logging/table_printer/table_printer.hpp>
+#include <Eigen/QR>
+#include <Eigen/Eigenvalues>
 #include <sstream>
 
 namespace turi {
 namespace sdk_model {
 namespace feature_engineering {
 
+typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+    row_block_matrix;
+
 #ifdef NDEBUG
-#define GAUSSIAN_PROJECTION_MAX_THREAD_MEMORY 1024 * 1024 * 512 // 512 MB
+#define DIMENSION_REDUCTION_MAX_THREAD_MEMORY 1024 * 1024 * 512 // 512 MB
 #else
-#define GAUSSIAN_PROJECTION_MAX_THREAD_MEMORY 1024 * 128 // 125KB (small enough to test)
+#define DIMENSION_REDUCTION_MAX_THREAD_MEMORY 1024 * 128 // 125KB (small enough to test)
 #endif
 
 
@@ -78,8 +86,8 @@ size_t calculate_num_blocks(const size_t num_examples, const size_t dimension,
   size_t max_block_rows = static_cast<size_t>(std::max((double) 1,
                                                         max_mem_rows));
 
-  logprogress_stream << "Max rows per data block: " << max_block_rows
-                     << std::endl;
+  logstream(LOG_INFO) << "Max rows per data block: " << max_block_rows
+                      << std::endl;
 
   size_t num_blocks = ((num_examples - 1) / max_block_rows) + 1;
   return num_blocks;
@@ -109,7 +117,8 @@ size_t get_unpacked_dimension(const gl_sframe& data,
 
       dimension += 1;
 
-    } else if (feature_type == flex_type_enum::VECTOR) {
+    } else if ((feature_type == flex_type_enum::VECTOR) ||
+               (feature_type == flex_type_enum::ND_VECTOR)) {
       size_t array_length = 0;
       flex_type_enum array_value_type = flex_type_enum::UNDEFINED;
       size_t idx = 0;
@@ -132,7 +141,7 @@ size_t get_unpacked_dimension(const gl_sframe& data,
     } else {
       std::stringstream ss;
       ss << "Column '" << col_name << "' has an inappropriate type. "
-         << "Columns must contain integers, floats, or arrays.";
+         << "Columns must contain integers, floats, arrays, or ndarrays.";
       log_and_throw(ss.str());
     }
   }
@@ -141,64 +150,238 @@ size_t get_unpacked_dimension(const gl_sframe& data,
 }
 
 
-flex_vec random_projection_apply(const sframe_rows::row& row,
-                                 const size_t original_dimension,
-                                 const std::shared_ptr<dense_matrix> projection_matrix_ptr) {
+/*
+ * Read a block of rows of the feature columns into the rows of a dense matrix,
+ * unpacking integer, float, array, and ndarray values in column order.
+ * Ndarrays are unpacked in their canonical (row-major) order.
+ *
+ * \param rows The rows to read, with one column per feature column.
+ * \param original_dimension Unpacked dimension of each row.
+ * \param X Output matrix, resized to rows.num_rows() x original_dimension.
+ */
+void fill_dense_block(const sframe_rows& rows, const size_t original_dimension,
+                      row_block_matrix& X) {
+
+  if (static_cast<size_t>(X.rows()) != rows.num_rows() ||
+      static_cast<size_t>(X.cols()) != original_dimension) {
+    X.resize(rows.num_rows(), original_dimension);
+  }
+
+  size_t i = 0;
+  for (const auto& row : rows) {
+    double* x = X.row(i).data();
+    size_t idx = 0;
+
+    for (size_t j = 0; j < row.size(); ++j) {
+      flex_type_enum col_type = row[j].get_type();
+
+      // Check for missing values.
+      if (col_type == flex_type_enum::UNDEFINED) {
+        std::stringstream ss;
+        ss << "A missing value has been found in the data to be projected. "
+           << "Missing values are not allowed in this data; consider "
+           << "filling these values or dropping the rows with either "
+           << "`SFrame.fillna` or `SFrame.dropna`.";
+        log_and_throw(ss.str());
+      }
+
+      size_t length = row[j].size();
+      if (idx + length > original_dimension) {
+        idx += length;
+        break;
+      }
 
-  // Read data into an eigen dense vector.
-  dense_vector x(original_dimension);
-  size_t idx = 0;
+      if ((col_type == flex_type_enum::INTEGER) ||
+          (col_type == flex_type_enum::FLOAT)) {
+        x[idx++] = row[j];
 
-  for (size_t j = 0; j < row.size(); ++j) {
-    flex_type_enum col_type = row[j].get_type();
+      } else if (col_type == flex_type_enum::VECTOR) {
+        const flex_vec& v = row[j].get<flex_vec>();
+        std::copy(v.begin(), v.end(), x + idx);
+        idx += length;
 
-    // Check for missing values.
-    if (col_type == flex_type_enum::UNDEFINED) {
+      } else if (col_type == flex_type_enum::ND_VECTOR) {
+        row[j].get<flex_nd_vec>().for_each([&](double value) {
+          x[idx++] = value;
+        });
+      }
+    }
+
+    // If the row isn't full, we've got a problem for the matrix
+    // multiplication.
+    if (idx != original_dimension) {
       std::stringstream ss;
-      ss << "A missing value has been found in the data to be transformed. "
-         << "Missing values are not allowed in the transform data; consider "
-         << "filling these values or dropping the rows with either "
-         << "`SFrame.fillna` or `SFrame.dropna`.";
+      ss << "The dimension of the data does not match the "
+         << "transformer's 'original_dimension' field, which was determined in "
+         << "the `fit` method. Please ensure the number of features is the same "
+         << "for all rows of data, including the number of entries in array-type "
+         << "columns.";
       log_and_throw(ss.str());
     }
+    ++i;
+  }
+}
+
+
+/*
+ * Stream the rows of data through block_fn, in blocks small enough to fit in
+ * DIMENSION_REDUCTION_MAX_THREAD_MEMORY per thread.
+ *
+ * Each thread reads a contiguous range of the rows, in order, and calls
+ * block_fn(thread_idx, num_threads, X) for each block X of that range, so
+ * that thread_idx can index per-thread accumulators or output segments.
+ */
+template <typename BlockFunction>
+void for_each_dense_block(const sframe& data, const size_t original_dimension,
+                          BlockFunction&& block_fn) {
+
+  const size_t num_examples = data.size();
+  if (num_examples == 0) {
+    return;
+  }
+
+  size_t num_blocks = calculate_num_blocks(num_examples, original_dimension,
+                                           DIMENSION_REDUCTION_MAX_THREAD_MEMORY);
+  size_t block_rows = ((num_examples - 1) / num_blocks) + 1;
+  auto reader = data.get_reader();
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    size_t row_start = (thread_idx * num_examples) / num_threads;
+    size_t row_end = ((thread_idx + 1) * num_examples) / num_threads;
+
+    sframe_rows rows;
+    row_block_matrix X;
+
+    for (size_t i = row_start; i < row_end; i += block_rows) {
+      reader->read_rows(i, std::min(i + block_rows, row_end), rows);
+      fill_dense_block(rows, original_dimension, X);
+      reader->release_rows(rows);
+      block_fn(thread_idx, num_threads, X);
+    }
+  });
+}
 
-    else if ((col_type == flex_type_enum::INTEGER) ||
-             (col_type == flex_type_enum::FLOAT)) {
 
-      x.coeffRef(idx) = row[j];
-      idx++;
+/*
+ * Project every row of data with one matrix product per block:
+ * Y = X * projection_matrix - offset, where offset (if not empty) is
+ * subtracted from each row.
+ *
+ * \return A vector column of the projected rows, in the order of the data.
+ */
+gl_sarray project_dense_blocks(const sframe& data,
+                               const size_t original_dimension,
+                               const dense_matrix& projection_matrix,
+                               const dense_vector& offset) {
+
+  size_t num_threads = thread_pool::get_instance().size();
+  gl_sarray_writer writer(flex_type_enum::VECTOR, num_threads);
+
+  for_each_dense_block(data, original_dimension,
+      [&](size_t thread_idx, size_t, const row_block_matrix& X) {
+    row_block_matrix Y;
+    Y.noalias() = X * projection_matrix;
+    if (offset.size() > 0) {
+      Y.rowwise() -= offset.transpose();
+    }
 
-    } else if (col_type == flex_type_enum::VECTOR) {
-      for (size_t k = 0; k < row[j].size(); ++k) {
-        x.coeffRef(idx) = row[j][k];
-        idx++;
-      }
+    for (size_t i = 0; i < static_cast<size_t>(Y.rows()); ++i) {
+      writer.write(flex_vec(Y.row(i).data(), Y.row(i).data() + Y.cols()),
+                   thread_idx);
     }
+  });
+
+  return writer.close();
+}
+
+
+/*
+ * Select the feature columns to reduce, the types of which are recorded in
+ * feature_types, and return the unpacked dimension of the data.
+ */
+size_t prepare_feature_columns(const gl_sframe& data, const bool exclude,
+                               const flexible_type& unprocessed_features,
+                               std::vector<std::string>& feature_columns,
+                               std::map<std::string, flex_type_enum>& feature_types) {
+
+  // Get the set of features to work with. `feature_columns` is a vector of
+  // strings.
+  feature_columns = transform_utils::get_column_names(data, exclude,
+                                                      unprocessed_features);
+
+  // Select the features of the right type.
+  std::vector<flex_type_enum> valid_feature_types = {flex_type_enum::FLOAT,
+                                                     flex_type_enum::INTEGER,
+                                                     flex_type_enum::VECTOR,
+                                                     flex_type_enum::ND_VECTOR};
+
+  feature_columns = transform_utils::select_valid_features(data,
+                                                           feature_columns,
+                                                           valid_feature_types);
+
+  // Error out if specified features are missing.
+  transform_utils::validate_feature_columns(data.column_names(),
+                                            feature_columns);
+
+  // Figure out the type of each input feature.
+  feature_types.clear();
+
+  for (auto& col_name : feature_columns){
+    feature_types[col_name] = data[col_name].dtype();
   }
 
-  // If the row isn't full, we've got a problem for the matrix multiplication in
-  // the next step.
-  if (idx != original_dimension) {
-    std::stringstream ss;
-    ss << "The dimension of the transform data does not match the "
-       << "transformer's 'original_dimension' field, which was determined in "
-       << "the `fit` method. Please ensure the number of features is the same "
-       << "for all rows of data, including the number of entries in array-type "
-       << "columns.";
-    log_and_throw(ss.str());
+  // Figure out the original (i.e. ambient) dimension of the data.
+  return get_unpacked_dimension(data, feature_columns, 30);
+}
+
+
+/*
+ * Split the data to transform into the feature columns, returned, and the
+ * other columns, written to output_data. Checks the types and the dimension
+ * of the feature columns against those seen by `fit`.
+ */
+gl_sframe prepare_transform_data(const gl_sframe& data,
+                                 const std::vector<std::string>& feature_columns,
+                                 const std::map<std::string, flex_type_enum>& feature_types,
+                                 const size_t original_dimension,
+                                 gl_sframe& output_data) {
+
+  // Split the input data into feature columns and unprocessed columns. Also
+  // ensures the input data has all of the columns specified in `fit`.
+  gl_sframe transform_data = data.select_columns(feature_columns);
+
+  output_data = data;
+  for (const auto& col_name : feature_columns) {
+    output_data.remove_column(col_name);
   }
 
-  // Embed the row by multiplying by the projection matrix.
-  dense_vector y = x.transpose() * (*projection_matrix_ptr);
+  // Make sure the input data features have the right types.
+  transform_utils::validate_feature_types(feature_columns, feature_types,
+                                          transform_data);
 
-  // Convert the result back to a flex_vec.
-  flex_vec row_out(y.size());
+  // Make sure the input data has the right dimension.
+  size_t dimension_check = get_unpacked_dimension(transform_data,
+                                                  feature_columns,
+                                                  100);
 
-  for (size_t i = 0; i < static_cast<size_t>(y.size()); ++i) {
-    row_out[i] = y[i];
+  if (dimension_check != original_dimension) {
+    std::stringstream ss;
+    ss << "The original dimension of the transform does not match the fitted "
+       << "transformer. Please re-fit with the data whose dimension is "
+       << "correct, or simply use `fit_transform` with the current data.";
+    log_and_throw(ss.str());
   }
 
-  return row_out;
+  return transform_data;
+}
+
+
+/*
+ * Replace the columns of Q with an orthonormal basis of the space they span.
+ */
+void orthonormalize_columns(dense_matrix& Q) {
+  Eigen::HouseholderQR<dense_matrix> qr(Q);
+  Q = qr.householderQ() * dense_matrix::Identity(Q.rows(), Q.cols());
 }
 
 
@@ -288,34 +471,9 @@ void random_projection::fit(gl_sframe data) {
 
   // Feature preprocessing
   // *********************
-
-  // Get the set of features to work with. `feature_columns` is a vector of
-  // strings.
-  feature_columns = transform_utils::get_column_names(data, exclude,
-                                                      unprocessed_features);
-
-  // Select the features of the right type.
-  std::vector<flex_type_enum> valid_feature_types = {flex_type_enum::FLOAT,
-                                                     flex_type_enum::INTEGER,
-                                                     flex_type_enum::VECTOR};
-
-  feature_columns = transform_utils::select_valid_features(data,
-                                                           feature_columns,
-                                                           valid_feature_types);
-
-  // Error out if specified features are missing.
-  transform_utils::validate_feature_columns(data.column_names(),
-                                            feature_columns);
-
-  // Figure out the type of each input feature.
-  feature_types.clear();
-
-  for (auto& col_name : feature_columns){
-    feature_types[col_name] = data[col_name].dtype();
-  }
-
-  // Figure out the original (i.e. ambient) dimension of the data.
-  original_dimension = get_unpacked_dimension(data, feature_columns, 30);
+  original_dimension = prepare_feature_columns(data, exclude,
+                                               unprocessed_features,
+                                               feature_columns, feature_types);
 
 
   // Create the projection matrix
@@ -367,31 +525,11 @@ gl_sframe random_projection::transform(gl_sframe data) {
     log_and_throw(ss.str());
   }
 
-  // Split the input data into feature columns and unprocessed columns. Also
-  // ensures the input data has all of the columns specified in `fit`.
-  gl_sframe transform_data = data.select_columns(feature_columns);
-
-  gl_sframe output_data = data;
-  for (const auto& col_name : feature_columns) {
-    output_data.remove_column(col_name);
-  }
-
-  // Make sure the input data features have the right types.
-  transform_utils::validate_feature_types(feature_columns, feature_types,
-                                          transform_data);
-
-  // Make sure the input data has the right dimension.
-  size_t dimension_check = get_unpacked_dimension(transform_data,
-                                                  feature_columns,
-                                                  100);
-
-  if (dimension_check != original_dimension) {
-    std::stringstream ss;
-    ss << "The original dimension of the transform does not match the created "
-       << "projection matrix. Please re-fit with the data whose dimension is "
-       << "correct, or simply use `fit_transform` with the current data.";
-    log_and_throw(ss.str());
-  }
+  gl_sframe output_data;
+  gl_sframe transform_data = prepare_transform_data(data, feature_columns,
+                                                    feature_types,
+                                                    original_dimension,
+                                                    output_data);
 
   // Make sure the output column name is unique, or get a unique one.
   std::string output_name
@@ -399,16 +537,11 @@ gl_sframe random_projection::transform(gl_sframe data) {
                                            options.value("output_column_name"));
   state["output_column_name"] = to_variant(output_name);
 
-  // Apply the projection to the transform features.
-  size_t local_original_dimension = original_dimension;
-  std::shared_ptr<dense_matrix> local_projection_matrix = projection_matrix;
-
-  output_data[output_name] = transform_data.apply(
-    [=](const sframe_rows::row& x) {
-      return random_projection_apply(x, local_original_dimension,
-                                     local_projection_matrix);
-    },
-    flex_type_enum::VECTOR);
+  // Apply the projection to the transform features, one block of rows at a
+  // time.
+  output_data[output_name] = project_dense_blocks(
+      transform_data.materialize_to_sframe(), original_dimension,
+      *projection_matrix, dense_vector());
 
   return output_data;
 }
@@ -468,6 +601,346 @@ void random_projection::load_version(iarchive& iarc, size_t version) {
 
 
 
+/*********************************
+ ** RandomizedPCA class methods **
+ *********************************/
+
+/**
+ * Define the options manager and set the initial options.
+ *
+ * \param user_opts
+ */
+void randomized_pca::init_options(
+                         const std::map<std::string, flexible_type>& user_opts) {
+
+  DASSERT_TRUE(options.get_option_info().size() == 0);
+
+  options.create_string_option("output_column_name",
+                               "Name of the embedded data in the output SFrame.",
+                               "embedded_features",
+                               true);
+
+  options.create_integer_option("random_seed",
+                                "Random seed for generating the initial subspace",
+                                FLEX_UNDEFINED,
+                                0,
+                                std::numeric_limits<int>::max(),
+                                true);
+
+  options.create_integer_option("embedding_dimension",
+                                "Number of principal components to keep",
+                                2,
+                                1,
+                                std::numeric_limits<int>::max(),
+                                true);
+
+  options.create_integer_option("num_power_iterations",
+                                "Number of subspace iterations over the data",
+                                2,
+                                0,
+                                std::numeric_limits<int>::max(),
+                                true);
+
+  options.create_integer_option("oversampling",
+                                "Number of extra directions in the subspace",
+                                10,
+                                0,
+                                std::numeric_limits<int>::max(),
+                                true);
+
+  std::map<std::string, flexible_type> valid_opts;
+
+  for (const auto& k: user_opts) {
+    if (options.is_option(k.first)) {
+      valid_opts[k.first] = variant_get_value<flexible_type>(k.second);
+    }
+  }
+
+  options.set_options(valid_opts);
+  add_or_update_state(flexmap_to_varmap(options.current_option_values()));
+}
+
+
+/**
+ * Initialize the transformer.
+ *
+ * \param user_opts
+ */
+void randomized_pca::init_transformer(
+                         const std::map<std::string, flexible_type>& user_opts) {
+
+  // Initialize the options and set them in the model's state.
+  init_options(user_opts);
+
+  // Preprocessing of the features lists.
+  unprocessed_features = user_opts.at("features");
+  exclude = user_opts.at("exclude");
+
+  if ((int) exclude == 1) {
+    state["features"] = to_variant(FLEX_UNDEFINED);
+    state["excluded_features"] = to_variant(unprocessed_features);
+
+  } else {
+    state["features"] = to_variant(unprocessed_features);
+    state["excluded_features"] = to_variant(FLEX_UNDEFINED);
+  }
+
+  state["original_dimension"] = to_variant(FLEX_UNDEFINED);
+  state["singular_values"] = to_variant(FLEX_UNDEFINED);
+  state["explained_variance"] = to_variant(FLEX_UNDEFINED);
+  state["explained_variance_ratio"] = to_variant(FLEX_UNDEFINED);
+  state["is_fitted"] = to_variant(false);
+}
+
+
+/**
+ * Fit the principal directions of the data.
+ *
+ * \param data
+ */
+void randomized_pca::fit(gl_sframe data) {
+
+  DASSERT_TRUE(options.get_option_info().size() > 0);
+
+  // Feature preprocessing
+  // *********************
+  original_dimension = prepare_feature_columns(data, exclude,
+                                               unprocessed_features,
+                                               feature_columns, feature_types);
+
+  size_t embedding_dimension
+    = static_cast<size_t>(options.value("embedding_dimension"));
+  size_t num_power_iterations
+    = static_cast<size_t>(options.value("num_power_iterations"));
+  size_t oversampling = static_cast<size_t>(options.value("oversampling"));
+
+  if (embedding_dimension > original_dimension) {
+    std::stringstream ss;
+    ss << "The embedding dimension (" << embedding_dimension << ") cannot be "
+       << "larger than the dimension of the data (" << original_dimension
+       << ").";
+    log_and_throw(ss.str());
+  }
+
+  sframe fit_data = data.select_columns(feature_columns).materialize_to_sframe();
+  const size_t num_examples = fit_data.size();
+
+  if (num_examples == 0) {
+    log_and_throw("Principal components cannot be fit on an empty SFrame.");
+  }
+
+  flexible_type random_seed_option = options.value("random_seed");
+  size_t random_seed;
+
+  if (random_seed_option == FLEX_UNDEFINED) {
+    random_seed = std::time(NULL);
+    options.set_option("random_seed", random_seed);
+  } else {
+    random_seed = static_cast<size_t>(random_seed_option);
+  }
+
+  const size_t d = original_dimension;
+  const size_t subspace_dimension = std::min(embedding_dimension + oversampling,
+                                             d);
+  size_t num_threads = thread_pool::get_instance().size();
+
+  // Column means
+  // ************
+  std::vector<dense_vector> thread_sums(num_threads, dense_vector::Zero(d));
+
+  for_each_dense_block(fit_data, d,
+      [&](size_t thread_idx, size_t, const row_block_matrix& X) {
+    thread_sums[thread_idx] += X.colwise().sum().transpose();
+  });
+
+  mean = dense_vector::Zero(d);
+  for (const auto& s : thread_sums) {
+    mean += s;
+  }
+  mean /= num_examples;
+
+  // Subspace iteration
+  // ******************
+
+  // Z = (X - mu)^T (X - mu) Q, accumulated one block at a time. Also returns
+  // the total sum of squares of the centered data.
+  std::vector<dense_matrix> thread_Z(num_threads);
+  std::vector<double> thread_ss(num_threads);
+
+  auto covariance_times = [&](const dense_matrix& Q, dense_matrix& Z) {
+    for (size_t t = 0; t < num_threads; ++t) {
+      thread_Z[t] = dense_matrix::Zero(d, Q.cols());
+      thread_ss[t] = 0;
+    }
+
+    for_each_dense_block(fit_data, d,
+        [&](size_t thread_idx, size_t, const row_block_matrix& X) {
+      row_block_matrix Xc = X.rowwise() - mean.transpose();
+      dense_matrix XQ;
+      XQ.noalias() = Xc * Q;
+      thread_Z[thread_idx].noalias() += Xc.transpose() * XQ;
+      thread_ss[thread_idx] += Xc.squaredNorm();
+    });
+
+    Z = dense_matrix::Zero(d, Q.cols());
+    double total_ss = 0;
+    for (size_t t = 0; t < num_threads; ++t) {
+      Z += thread_Z[t];
+      total_ss += thread_ss[t];
+    }
+    return total_ss;
+  };
+
+  // The initial subspace is drawn with a counter based generator, so it only
+  // depends on the seed.
+  dense_matrix Q(d, subspace_dimension);
+  random::counter_rng rng(random_seed);
+  rng.fill_normal(0, Q.data(), Q.size());
+  orthonormalize_columns(Q);
+
+  dense_matrix Z;
+  for (size_t iter = 0; iter < num_power_iterations; ++iter) {
+    covariance_times(Q, Z);
+    Q = Z;
+    orthonormalize_columns(Q);
+  }
+
+  // Rayleigh-Ritz on the subspace: the eigenvalues of Q^T C Q approximate the
+  // top eigenvalues of the scatter matrix C.
+  double total_ss = covariance_times(Q, Z);
+  dense_matrix B = Q.transpose() * Z;
+  B = 0.5 * (B + B.transpose());
+  Eigen::SelfAdjointEigenSolver<dense_matrix> eigen_solver(B);
+
+  // The eigenvalues are in increasing order.
+  const dense_vector& eigenvalues = eigen_solver.eigenvalues();
+  const dense_matrix& eigenvectors = eigen_solver.eigenvectors();
+
+  components.resize(d, embedding_dimension);
+  flex_vec singular_values(embedding_dimension);
+  flex_vec explained_variance(embedding_dimension);
+  flex_vec explained_variance_ratio(embedding_dimension);
+  double dof = static_cast<double>(std::max<size_t>(num_examples - 1, 1));
+
+  for (size_t j = 0; j < embedding_dimension; ++j) {
+    size_t src = subspace_dimension - 1 - j;
+    components.col(j) = Q * eigenvectors.col(src);
+
+    // Fix the sign so that the fit is deterministic.
+    dense_matrix::Index max_idx;
+    components.col(j).cwiseAbs().maxCoeff(&max_idx);
+    if (components(max_idx, j) < 0) {
+      components.col(j) *= -1;
+    }
+
+    double lambda = std::max(eigenvalues[src], 0.0);
+    singular_values[j] = std::sqrt(lambda);
+    explained_variance[j] = lambda / dof;
+    explained_variance_ratio[j] = (total_ss > 0) ? lambda / total_ss : 0.0;
+  }
+
+  fitted = true;
+
+  // Update the model attributes visible to the Python user.
+  state["random_seed"] = random_seed;
+  state["is_fitted"] = to_variant(true);
+  state["original_dimension"] = original_dimension;
+  state["features"] = to_variant(feature_columns);
+  state["singular_values"] = to_variant(singular_values);
+  state["explained_variance"] = to_variant(explained_variance);
+  state["explained_variance_ratio"] = to_variant(explained_variance_ratio);
+}
+
+
+/**
+ * Project data onto the principal directions.
+ *
+ * \param data
+ */
+gl_sframe randomized_pca::transform(gl_sframe data) {
+
+  //Check if fitting has already ocurred.
+  if (!fitted) {
+    std::stringstream ss;
+    ss << "The RandomizedPCA object does not yet have principal components. "
+       << "Please use the 'fit' method to compute them, or use "
+       << "'fit_transform' to compute and apply them all at once.";
+    log_and_throw(ss.str());
+  }
+
+  gl_sframe output_data;
+  gl_sframe transform_data = prepare_transform_data(data, feature_columns,
+                                                    feature_types,
+                                                    original_dimension,
+                                                    output_data);
+
+  // Make sure the output column name is unique, or get a unique one.
+  std::string output_name
+    = transform_utils::get_unique_feature_name(output_data.column_names(),
+                                           options.value("output_column_name"));
+  state["output_column_name"] = to_variant(output_name);
+
+  // (X - mu) W = X W - mu^T W
+  dense_vector offset = components.transpose() * mean;
+
+  output_data[output_name] = project_dense_blocks(
+      transform_data.materialize_to_sframe(), original_dimension,
+      components, offset);
+
+  return output_data;
+}
+
+
+/**
+ * Get the version number for a `randomized_pca` object.
+ */
+size_t randomized_pca::get_version() const {
+  return RANDOMIZED_PCA_VERSION;
+}
+
+
+/**
+ * Save a `randomized_pca` object using Turi's oarc.
+ *
+ * \param oarc
+ */
+void randomized_pca::save_impl(oarchive& oarc) const {
+  variant_deep_save(state, oarc);
+  oarc << options
+       << unprocessed_features
+       << feature_columns
+       << feature_types
+       << original_dimension
+       << fitted
+       << exclude;
+
+  if (fitted) {
+    oarc << mean << components;
+  }
+}
+
+
+/**
+ * Load a `randomized_pca` object using Turi's iarc.
+ *
+ * \param iarc
+ * \param version
+ */
+void randomized_pca::load_version(iarchive& iarc, size_t version) {
+  variant_deep_load(state, iarc);
+  iarc >> options
+       >> unprocessed_features
+       >> feature_columns
+       >> feature_types
+       >> original_dimension
+       >> fitted
+       >> exclude;
+
+  if (fitted) {
+    iarc >> mean >> components;
+  }
+}
+
 
 } // namespace feature_engineering
 } // namespace sdk_model
@@ -22,6 +22,10 @@ typedef Eigen::Matrix<double, Eigen::Dynamic, 1> dense_vector;
  * Create a random projection matrix if the dimenions were already set in the
  * constructor, in which case no data is needed.
  *
+ * The projection matrix is created once by `fit`, and `transform` projects
+ * the rows one block at a time with a single matrix product per block.
+ * Integer, float, array, and ndarray columns are unpacked into the rows.
+ *
  * The Gaussian random projection is Y = (1 / \sqrt(k)) X * R, where:
  *   - X is the original data (n x d)
  *   - R is the projection matrix (d x k)
@@ -150,6 +154,133 @@ class EXPORT random_projection : public transformer_base {
   END_CLASS_MEMBER_REGISTRATION
 };
 
+
+/**
+ * Principal component analysis by randomized SVD, streaming the data in blocks
+ * of rows so that it never has to fit in memory.
+ *
+ * The data X (n x d) is centered by its column means mu, and the top k
+ * principal directions W (d x k) are found by subspace iteration on the
+ * covariance (Halko, Martinsson, and Tropp, 2011):
+ *   - Q is an orthonormal basis of a random Gaussian d x (k + p) matrix,
+ *     where p is the `oversampling`.
+ *   - Each of the `num_power_iterations` passes over the data replaces Q with
+ *     an orthonormal basis of (X - mu)^T (X - mu) Q, accumulated one block of
+ *     rows at a time with two matrix products.
+ *   - A last pass computes the small matrix Q^T (X - mu)^T (X - mu) Q, whose
+ *     top k eigenvectors V give W = Q V.
+ *
+ * Only d x (k + p) matrices are kept, so each pass costs O(n d (k + p)) and
+ * runs in parallel over the rows. The transformed data is Y = (X - mu) W.
+ *
+ * Each principal direction is signed so that its entry of largest magnitude
+ * is positive.
+ * -----------------------------------------------------------------------------
+ *
+ * The private members of a randomized_pca instance are as in
+ * random_projection, with:
+ *
+ * mean:
+ *   Column means of the data passed to the `fit` function.
+ *
+ * components:
+ *   The principal directions, one per column.
+ * -----------------------------------------------------------------------------
+ *
+ * The items added to the model's state, in addition to the options defined
+ * in `init_options`, are:
+ *
+ * - original_dimension: dimension of the input data, unpacked.
+ * - features: list of column names to project.
+ * - excluded_features: list of column names to exclude.
+ * - random_seed: seed for generating the initial subspace.
+ * - singular_values: singular values of the centered data, largest first.
+ * - explained_variance: variance of the data along each principal direction.
+ * - explained_variance_ratio: fraction of the total variance along each
+ *   principal direction.
+ */
+class EXPORT randomized_pca : public transformer_base {
+
+  static constexpr size_t RANDOMIZED_PCA_VERSION = 0;
+
+  flexible_type unprocessed_features;
+  std::vector<std::string> feature_columns;
+  std::map<std::string, flex_type_enum> feature_types;
+
+  size_t original_dimension = 0;
+  dense_vector mean;
+  dense_matrix components;
+
+  bool fitted = false;
+  bool exclude = false;
+
+ public:
+
+  virtual inline ~randomized_pca() {}
+
+  /**
+   * Define the options manager and set the initial options.
+   */
+  void init_options(const std::map<std::string, flexible_type>& user_opts) override;
+
+  /**
+   * Get the version number for a `randomized_pca` object.
+   */
+  size_t get_version() const override;
+
+  /**
+   * Save a `randomized_pca` object using Turi's oarc.
+   */
+  void save_impl(oarchive& iarc) const override;
+
+  /**
+   * Load a `randomized_pca` object using Turi's iarc.
+   */
+  void load_version(iarchive & iarc, size_t version) override;
+
+  /**
+   * Initialize the transformer. This is the primary entry points for C++ users.
+   */
+  void init_transformer(const std::map<std::string, flexible_type>& user_opts) override;
+
+  /**
+   * Fit the principal directions, with 2 + num_power_iterations passes over
+   * the data.
+   */
+  void fit(gl_sframe data) override;
+
+  /**
+   * Project data onto the principal directions.
+   */
+  gl_sframe transform(gl_sframe data) override;
+
+  /**
+   * Fit and transform the given data.
+   *
+   * \param data
+   */
+  gl_sframe fit_transform(gl_sframe data) {
+    data.materialize();
+    fit(data);
+    return transform(data);
+  }
+
+  BEGIN_CLASS_MEMBER_REGISTRATION("_RandomizedPCA")
+  REGISTER_CLASS_MEMBER_FUNCTION(randomized_pca::init_transformer, "user_opts")
+  REGISTER_CLASS_MEMBER_FUNCTION(randomized_pca::fit, "data")
+  REGISTER_CLASS_MEMBER_FUNCTION(randomized_pca::transform, "data")
+  REGISTER_CLASS_MEMBER_FUNCTION(randomized_pca::fit_transform, "data")
+  REGISTER_CLASS_MEMBER_FUNCTION(randomized_pca::get_current_options);
+  REGISTER_CLASS_MEMBER_FUNCTION(randomized_pca::list_fields);
+  REGISTER_NAMED_CLASS_MEMBER_FUNCTION("_get_default_options",
+                                       randomized_pca::get_default_options);
+  REGISTER_NAMED_CLASS_MEMBER_FUNCTION("get",
+                                       randomized_pca::get_value_from_state,
+                                       "key");
+
+  END_CLASS_MEMBER_REGISTRATION
+};
+
 } //namespace feature_engineering
 } //namespace sdk_model
 } // namespace turi
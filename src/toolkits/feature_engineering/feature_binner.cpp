@@ -342,6 +342,13 @@ void feature_binner::fit(gl_sframe data){
   fitted = true;
 }
 
+/**
+ * Returns the features named by the user.
+ */
+std::vector<std::string> feature_binner::get_fit_columns() const {
+  return transform_utils::get_explicit_column_names(exclude, unprocessed_features);
+}
+
 /**
  * Transform the given data.
  */
@@ -119,6 +119,11 @@ class EXPORT feature_binner : public transformer_base {
    */
   gl_sframe transform(gl_sframe data) override;
 
+  /**
+   * Returns the features named by the user, unless they are an exclude set.
+   */
+  std::vector<std::string> get_fit_columns() const override;
+
   /**
    * Fit and transform the given data. Intended as an optimization because
    * fit and transform are usually always called together. The default
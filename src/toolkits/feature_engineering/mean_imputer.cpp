@@ -304,6 +304,13 @@ void mean_imputer::fit(gl_sframe data){
 
 }
 
+/**
+ * Returns the features named by the user.
+ */
+std::vector<std::string> mean_imputer::get_fit_columns() const {
+  return transform_utils::get_explicit_column_names(exclude, feature_columns);
+}
+
 /**
  * Transform the given data.
  */
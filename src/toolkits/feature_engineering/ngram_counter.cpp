@@ -6,6 +6,7 @@
 #include <model_server/lib/toolkit_class_macros.hpp>
 #include <model_server/lib/variant_deep_serialize.hpp>
 #include <toolkits/feature_engineering/ngram_counter.hpp>
+#include <toolkits/feature_engineering/token_counting.hpp>
 #include <core/logging/assertions.hpp>
 
 
@@ -432,7 +433,7 @@ void ngram_counter::set_string_filters(){
 
   string_filters = transform_utils::string_filter_list({
     std::make_pair(
-      boost::regex(std::string("([^" + all_delims + "]+)")),   // a token is any word that does not containing a delimiter
+      *string_kernels::cached_regex("([^" + all_delims + "]+)"),   // a token is any word that does not containing a delimiter
       [](const std::string& current){return true;}
       )
   });
@@ -550,6 +551,15 @@ gl_sframe ngram_counter::transform(gl_sframe data){
       output_column_name = output_column_prefix_opt.get<flex_string>() + "." + f;
     }
 
+    // Word n-grams of string columns are tokenized, counted and indexed
+    // in parallel passes over the column, then keyed by n-gram again.
+    if (ngram_type == "word" && feat.dtype() == flex_type_enum::STRING
+        && can_count_tokens(delimiters, to_lower)) {
+      ret_sf[output_column_name] = token_count_dicts(
+          count_tokens(feat, delimiters.get<flex_list>(), to_lower, n));
+      continue;
+    }
+
     std::function<flexible_type(const flexible_type&)> transformfn;
     transform_utils::string_filter_list m_string_filters = string_filters;
     bool m_to_lower = to_lower;
@@ -260,6 +260,13 @@ void one_hot_encoder::fit(gl_sframe data){
   state["feature_encoding"] = to_variant(feature_encoding.close());
 }
 
+/**
+ * Returns the features named by the user.
+ */
+std::vector<std::string> one_hot_encoder::get_fit_columns() const {
+  return transform_utils::get_explicit_column_names(exclude, feature_columns);
+}
+
 /**
  * Transform the given data.
  */
@@ -83,6 +83,11 @@ class EXPORT one_hot_encoder : public transformer_base {
    */
   gl_sframe transform(gl_sframe data) override;
 
+  /**
+   * Returns the features named by the user, unless they are an exclude set.
+   */
+  std::vector<std::string> get_fit_columns() const override;
+
 
   /**
    * Fit and transform the given data. Intended as an optimization because
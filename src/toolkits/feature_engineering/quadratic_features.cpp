@@ -376,6 +376,19 @@ void quadratic_features::fit(gl_sframe training_data) {
 
 }
 
+/**
+ * Returns the columns of the feature pairs named by the user.
+ */
+std::vector<std::string> quadratic_features::get_fit_columns() const {
+  std::set<std::string> columns;
+  if (!exclude) {
+    for (const auto& pair: unprocessed_features) {
+      columns.insert(pair.begin(), pair.end());
+    }
+  }
+  return std::vector<std::string>(columns.begin(), columns.end());
+}
+
 /**
  * Transforms the data.
  */
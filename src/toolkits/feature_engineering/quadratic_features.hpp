@@ -31,7 +31,7 @@ class EXPORT quadratic_features : public transformer_base {
   void init_options(const std::map<std::string, flexible_type>& _options) override;
   void fit(gl_sframe training_data) override;
   gl_sframe transform(gl_sframe training_data) override;
-
+  std::vector<std::string> get_fit_columns() const override;
 
   BEGIN_CLASS_MEMBER_REGISTRATION("_QuadraticFeatures")
   REGISTER_CLASS_MEMBER_FUNCTION(quadratic_features::init_transformer, "_options")
@@ -10,6 +10,7 @@
 
 #include <toolkits/feature_engineering/transform_utils.hpp>
 #include <toolkits/feature_engineering/tfidf.hpp>
+#include <toolkits/feature_engineering/token_counting.hpp>
 #include <toolkits/feature_engineering/topk_indexer.hpp>
 
 namespace turi {
@@ -86,6 +87,36 @@ static void create_topk_index_mapping_for_keys(const gl_sarray& src,
   indexer->finalize();
 }
 
+/**
+ * The delimiters gl_sarray::count_words splits string columns on.
+ */
+static const flex_list& word_delimiters() {
+  static const flex_list delimiters = {"\r", "\v", "\n", "\f", "\t", " "};
+  return delimiters;
+}
+
+/**
+ * Version of create_topk_index_mapping_for_keys for string columns. The
+ * document frequencies of the words come from the same count_tokens pass
+ * that builds the vocabulary, instead of from a column of word counts.
+ * Missing rows count towards the missing value, as their word counts do.
+ */
+static void create_topk_index_mapping_for_words(const gl_sarray& src,
+                               std::shared_ptr<topk_indexer> indexer) {
+  token_counts counts = count_tokens(src, word_delimiters());
+
+  indexer->initialize();
+  for (size_t i = 0; i < counts.vocabulary.size(); ++i) {
+    indexer->insert_or_update(counts.vocabulary[i], 0,
+                              counts.document_frequencies[i]);
+  }
+  size_t num_missing = src.num_missing();
+  if (num_missing > 0) {
+    indexer->insert_or_update(FLEX_UNDEFINED, 0, num_missing);
+  }
+  indexer->finalize();
+}
+
 /**
  * Compute tf-idf score for a given (document, term) pair.
  *
@@ -361,7 +392,7 @@ void tfidf::fit(gl_sframe data){
                      feat));
 
     if (feature_types[feat] == flex_type_enum::STRING){
-      create_topk_index_mapping_for_keys(data[feat].count_words(), index_map[feat]);
+      create_topk_index_mapping_for_words(data[feat], index_map[feat]);
     } else {
       create_topk_index_mapping_for_keys(data[feat], index_map[feat]);
     }
@@ -387,6 +418,13 @@ void tfidf::fit(gl_sframe data){
 
 }
 
+/**
+ * Returns the features named by the user.
+ */
+std::vector<std::string> tfidf::get_fit_columns() const {
+  return transform_utils::get_explicit_column_names(exclude, feature_columns);
+}
+
 /**
  * Transform the given data.
  */
@@ -418,7 +456,7 @@ gl_sframe tfidf::transform(gl_sframe data){
     gl_sarray feat;
 
     if (data[col_name].dtype() == flex_type_enum::STRING){
-      feat = data[col_name].count_words();
+      feat = token_count_dicts(count_tokens(data[col_name], word_delimiters()));
     } else {
       feat = data[col_name];
     }
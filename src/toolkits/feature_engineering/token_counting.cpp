@@ -0,0 +1,312 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+#include <toolkits/feature_engineering/token_counting.hpp>
+#include <core/parallel/lambda_omp.hpp>
+#include <core/parallel/thread_pool.hpp>
+#include <core/util/cityhash_tc.hpp>
+#include <core/logging/assertions.hpp>
+
+namespace turi {
+namespace sdk_model {
+namespace feature_engineering {
+
+namespace {
+
+/**
+ * A token, as characters owned by a cell, a buffer or an arena.
+ */
+struct token_span {
+  const char* data;
+  size_t size;
+};
+
+struct token_span_hash {
+  size_t operator()(const token_span& t) const {
+    return hash64(t.data, t.size);
+  }
+};
+
+struct token_span_equal {
+  bool operator()(const token_span& a, const token_span& b) const {
+    return a.size == b.size && std::memcmp(a.data, b.data, a.size) == 0;
+  }
+};
+
+bool token_span_less(const token_span& a, const token_span& b) {
+  int c = std::memcmp(a.data, b.data, std::min(a.size, b.size));
+  return c < 0 || (c == 0 && a.size < b.size);
+}
+
+/**
+ * Storage for token text that stays in place until the arena is destroyed.
+ */
+class token_arena {
+ public:
+  const char* store(const char* s, size_t n) {
+    if (n > remaining) {
+      size_t chunk_size = std::max<size_t>(65536, n);
+      chunks.emplace_back(new char[chunk_size]);
+      current = chunks.back().get();
+      remaining = chunk_size;
+    }
+    char* out = current;
+    std::memcpy(out, s, n);
+    current += n;
+    remaining -= n;
+    return out;
+  }
+
+ private:
+  std::vector<std::unique_ptr<char[]>> chunks;
+  char* current = nullptr;
+  size_t remaining = 0;
+};
+
+/**
+ * Splits cells into tokens or n-grams without allocating per token. The
+ * buffers are reused from one cell to the next.
+ */
+class ngram_tokenizer {
+ public:
+  ngram_tokenizer(const std::array<bool, 256>& _is_delimiter, bool _to_lower,
+                  size_t _ngram_size)
+    : is_delimiter(_is_delimiter), to_lower(_to_lower), ngram_size(_ngram_size) {}
+
+  /**
+   * Call f(token_span) for each n-gram of str. The span is only valid
+   * during the call.
+   */
+  template <typename Function>
+  void for_each(const std::string& str, Function&& f) {
+    const char* text = str.data();
+    if (to_lower) {
+      lowered.assign(str);
+      std::transform(lowered.begin(), lowered.end(), lowered.begin(), ::tolower);
+      text = lowered.data();
+    }
+
+    // Token boundaries.
+    tokens.clear();
+    size_t i = 0;
+    const size_t n = str.size();
+    while (true) {
+      while (i < n && is_delimiter[(unsigned char)text[i]]) ++i;
+      if (i == n) break;
+      size_t begin = i;
+      while (i < n && !is_delimiter[(unsigned char)text[i]]) ++i;
+      tokens.push_back({begin, i - begin});
+    }
+
+    if (ngram_size == 1) {
+      for (const auto& t : tokens) {
+        f(token_span{text + t.first, t.second});
+      }
+      return;
+    }
+
+    for (size_t j = 0; j + ngram_size <= tokens.size(); ++j) {
+      ngram.clear();
+      for (size_t k = j; k < j + ngram_size; ++k) {
+        if (k > j) ngram.push_back(' ');
+        ngram.append(text + tokens[k].first, tokens[k].second);
+      }
+      f(token_span{ngram.data(), ngram.size()});
+    }
+  }
+
+ private:
+  const std::array<bool, 256>& is_delimiter;
+  bool to_lower;
+  size_t ngram_size;
+
+  std::string lowered;
+  std::string ngram;
+  std::vector<std::pair<size_t, size_t>> tokens;
+};
+
+// Document frequency of a token, and the last row that counted it.
+struct token_stats {
+  size_t document_frequency = 0;
+  size_t last_row = size_t(-1);
+};
+
+typedef std::unordered_map<token_span, token_stats,
+                           token_span_hash, token_span_equal> token_table;
+
+}  // namespace
+
+
+token_counts count_tokens(const gl_sarray& src,
+                          const flex_list& delimiters,
+                          bool to_lower,
+                          size_t ngram_size,
+                          size_t min_document_frequency) {
+
+  if (src.dtype() != flex_type_enum::STRING) {
+    log_and_throw("Invalid type. Token counting requires a column of strings.");
+  }
+  if (ngram_size == 0) {
+    log_and_throw("The n-gram size must be at least 1.");
+  }
+
+  std::array<bool, 256> is_delimiter;
+  is_delimiter.fill(false);
+  for (const auto& d : delimiters) {
+    if (d.get_type() != flex_type_enum::STRING || d.get<flex_string>().size() != 1) {
+      log_and_throw("Invalid delimiter. Delimiters must be single character strings.");
+    }
+    is_delimiter[(unsigned char)d.get<flex_string>()[0]] = true;
+  }
+
+  const size_t src_size = src.size();
+  // One table, arena and output segment per thread of in_parallel, which
+  // runs as many threads as the pool has (or a single one).
+  const size_t num_segments =
+      std::max<size_t>(1, thread_pool::get_instance().size());
+
+  // Pass 1: count the rows of each distinct token, one table per thread.
+  std::vector<token_table> tables(num_segments);
+  std::vector<token_arena> arenas(num_segments);
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    size_t start_idx = src_size * thread_idx / num_threads;
+    size_t end_idx = src_size * (thread_idx + 1) / num_threads;
+
+    auto& table = tables[thread_idx];
+    auto& arena = arenas[thread_idx];
+    ngram_tokenizer tokenizer(is_delimiter, to_lower, ngram_size);
+
+    size_t row = start_idx;
+    for (const auto& v : src.range_iterator(start_idx, end_idx)) {
+      if (v.get_type() == flex_type_enum::STRING) {
+        tokenizer.for_each(v.get<flex_string>(), [&](const token_span& t) {
+          auto it = table.find(t);
+          if (it == table.end()) {
+            token_span stored{arena.store(t.data, t.size), t.size};
+            it = table.emplace(stored, token_stats()).first;
+          }
+          if (it->second.last_row != row) {
+            it->second.last_row = row;
+            ++it->second.document_frequency;
+          }
+        });
+      }
+      ++row;
+    }
+  });
+
+  // Merge the tables. The spans stay in the thread arenas.
+  std::unordered_map<token_span, size_t, token_span_hash, token_span_equal> merged;
+  for (auto& table : tables) {
+    for (const auto& kv : table) {
+      merged[kv.first] += kv.second.document_frequency;
+    }
+    table = token_table();
+  }
+
+  std::vector<std::pair<token_span, size_t>> kept;
+  kept.reserve(merged.size());
+  for (const auto& kv : merged) {
+    if (kv.second >= min_document_frequency) {
+      kept.push_back(kv);
+    }
+  }
+  merged.clear();
+
+  std::sort(kept.begin(), kept.end(),
+            [](const std::pair<token_span, size_t>& a,
+               const std::pair<token_span, size_t>& b) {
+              return a.second > b.second ||
+                     (a.second == b.second && token_span_less(a.first, b.first));
+            });
+
+  token_counts ret;
+  ret.vocabulary.reserve(kept.size());
+  ret.document_frequencies.reserve(kept.size());
+
+  std::unordered_map<token_span, size_t, token_span_hash, token_span_equal> index_map;
+  index_map.reserve(kept.size());
+  for (size_t i = 0; i < kept.size(); ++i) {
+    index_map[kept[i].first] = i;
+    ret.vocabulary.push_back(flex_string(kept[i].first.data, kept[i].first.size));
+    ret.document_frequencies.push_back(kept[i].second);
+  }
+
+  // Pass 2: write the sparse counts of each row.
+  gl_sarray_writer writer(flex_type_enum::DICT, num_segments);
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    size_t start_idx = src_size * thread_idx / num_threads;
+    size_t end_idx = src_size * (thread_idx + 1) / num_threads;
+
+    ngram_tokenizer tokenizer(is_delimiter, to_lower, ngram_size);
+    std::vector<size_t> row_indices;
+
+    for (const auto& v : src.range_iterator(start_idx, end_idx)) {
+      if (v.get_type() != flex_type_enum::STRING) {
+        writer.write(FLEX_UNDEFINED, thread_idx);
+        continue;
+      }
+
+      row_indices.clear();
+      tokenizer.for_each(v.get<flex_string>(), [&](const token_span& t) {
+        auto it = index_map.find(t);
+        if (it != index_map.end()) {
+          row_indices.push_back(it->second);
+        }
+      });
+      std::sort(row_indices.begin(), row_indices.end());
+
+      flex_dict out;
+      for (size_t i = 0; i < row_indices.size(); ) {
+        size_t j = i;
+        while (j < row_indices.size() && row_indices[j] == row_indices[i]) ++j;
+        out.push_back({flex_int(row_indices[i]), flex_int(j - i)});
+        i = j;
+      }
+      writer.write(std::move(out), thread_idx);
+    }
+  });
+
+  ret.counts = writer.close();
+  return ret;
+}
+
+bool can_count_tokens(const flexible_type& delimiters, bool to_lower) {
+  if (delimiters.get_type() != flex_type_enum::LIST) return false;
+  for (const auto& d : delimiters.get<flex_list>()) {
+    if (d.get_type() != flex_type_enum::STRING || d.get<flex_string>().size() != 1) {
+      return false;
+    }
+    char c = d.get<flex_string>()[0];
+    if (to_lower && ::tolower(c) != c) return false;
+  }
+  return true;
+}
+
+gl_sarray token_count_dicts(const token_counts& counts) {
+  auto vocabulary = std::make_shared<const flex_list>(counts.vocabulary);
+  return counts.counts.apply([vocabulary](const flexible_type& row) {
+      const flex_dict& indices = row.get<flex_dict>();
+      flex_dict out;
+      out.reserve(indices.size());
+      for (const auto& kv : indices) {
+        out.push_back({(*vocabulary)[kv.first.get<flex_int>()], kv.second});
+      }
+      return flexible_type(std::move(out));
+    }, flex_type_enum::DICT);
+}
+
+} // feature_engineering
+} // sdk_model
+} // turi
@@ -0,0 +1,80 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_FE_TOKEN_COUNTING_H_
+#define TURI_FE_TOKEN_COUNTING_H_
+
+#include <vector>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/data/sframe/gl_sarray.hpp>
+
+namespace turi {
+namespace sdk_model {
+namespace feature_engineering {
+
+/**
+ * Vocabulary and sparse rows made by count_tokens.
+ */
+struct token_counts {
+
+  /** The tokens kept, by index. */
+  flex_list vocabulary;
+
+  /** Number of rows each token of the vocabulary occurs in. */
+  std::vector<size_t> document_frequencies;
+
+  /**
+   * One dictionary per row, from the index of each token of the row to its
+   * count in the row, in increasing index order. Missing rows stay missing.
+   */
+  gl_sarray counts;
+};
+
+/**
+ * Tokenize a string column, build its vocabulary and index every row, in two
+ * parallel passes over the column.
+ *
+ * Tokens are never allocated as strings per row. They are spans over the
+ * cell (or over a per-thread buffer when lowercasing or joining n-grams),
+ * and each thread keeps its own hash table of distinct tokens, whose text is
+ * copied once into a per-thread arena. The tables are merged into the
+ * vocabulary, and the second pass looks the spans up to write the counts.
+ *
+ * The vocabulary is sorted by decreasing document frequency, then by token,
+ * so the indices do not depend on the number of threads.
+ *
+ * \param[in] src                    SArray of strings.
+ * \param[in] delimiters             Characters that separate tokens; each
+ *                                   must be a one character string.
+ * \param[in] to_lower               Lowercase the tokens.
+ * \param[in] ngram_size             Count runs of this many consecutive
+ *                                   tokens, joined by a space.
+ * \param[in] min_document_frequency Drop tokens that occur in fewer rows.
+ */
+token_counts count_tokens(const gl_sarray& src,
+                          const flex_list& delimiters,
+                          bool to_lower = true,
+                          size_t ngram_size = 1,
+                          size_t min_document_frequency = 1);
+
+/**
+ * True if count_tokens splits strings on these delimiters exactly as the
+ * per-row tokenizers of the word and n-gram counters do: the delimiters
+ * are a list of one character strings, none of which changes when the
+ * string is lowercased before it is split.
+ */
+bool can_count_tokens(const flexible_type& delimiters, bool to_lower);
+
+/**
+ * The rows of count_tokens as {token: count} dictionaries, with the
+ * indices looked up in the vocabulary. Missing rows stay missing.
+ */
+gl_sarray token_count_dicts(const token_counts& counts);
+
+} // feature_engineering
+} // sdk_model
+} // turi
+
+#endif
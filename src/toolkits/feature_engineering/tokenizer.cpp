@@ -153,7 +153,7 @@ void tokenizer::set_string_filters(){
 
       string_filters = transform_utils::string_filter_list({
         std::make_pair(
-          boost::regex(std::string("([^" + all_delims + "]+)")),   // a token is any word that does not containing a delimiter
+          *string_kernels::cached_regex("([^" + all_delims + "]+)"),   // a token is any word that does not containing a delimiter
           [](const std::string& current){return true;}
           )
       });
@@ -7,6 +7,8 @@
 #include <core/storage/sframe_data/sframe.hpp>
 #include <model_server/lib/variant.hpp>
 #include <model_server/lib/variant_deep_serialize.hpp>
+#include <core/generics/concurrent_hash_map.hpp>
+#include <core/parallel/lambda_omp.hpp>
 
 #include <toolkits/feature_engineering/topk_indexer.hpp>
 
@@ -50,21 +52,39 @@ void topk_indexer::finalize() {
   DASSERT_TRUE(values.empty());
   DASSERT_TRUE(counts.empty());
 
-  // Copy all the flexible type values over to the main
-  // values_by_index lookup.
-  size_t global_index = 0;
-  for(const auto& hash_table : threadlocal_accumulator) {
-    for(const auto& kvp : hash_table) {
-      auto it = index_lookup.find(kvp.first);
-      if (it == index_lookup.end()) {
-        index_lookup[kvp.first] = global_index;
-        values.push_back(kvp.second.first);
-        counts.push_back(kvp.second.second);
-        global_index++;
-      } else {
-        counts[it->second] += kvp.second.second;
+  // Merge the per-thread counts, one thread's table per task. The tables
+  // only contend on the shards they have in common.
+  typedef std::pair<flexible_type, size_t> value_count;
+  concurrent_hash_map<hash_value, value_count> merged;
+  parallel_for(0, threadlocal_accumulator.size(), [&](size_t t) {
+      for(const auto& kvp : threadlocal_accumulator[t]) {
+        merged.upsert(kvp.first, kvp.second, [&](value_count& vc) {
+            vc.second += kvp.second.second;
+          });
       }
-    }
+    }, parallel_schedule::DYNAMIC);
+
+  // Give every shard its own range of indices, and copy the values over
+  // to the main values_by_index lookup.
+  std::vector<size_t> next_index = merged.shard_sizes();
+  size_t num_values = 0;
+  for(size_t& n : next_index) {
+    size_t shard_size = n;
+    n = num_values;
+    num_values += shard_size;
+  }
+  std::vector<hash_value> keys(num_values);
+  values.resize(num_values);
+  counts.resize(num_values);
+  merged.parallel_for_each([&](size_t shard, const hash_value& key, value_count& vc) {
+      size_t index = next_index[shard]++;
+      keys[index] = key;
+      values[index] = std::move(vc.first);
+      counts[index] = vc.second;
+    });
+
+  for(size_t i = 0; i < num_values; ++i) {
+    index_lookup[keys[i]] = i;
   }
 
   retain_only_top_k_values();
@@ -10,6 +10,7 @@
 
 #include <core/data/sframe/gl_sframe.hpp>
 #include <core/util/try_finally.hpp>
+#include <core/util/string_kernels.hpp>
 #include <core/parallel/lambda_omp.hpp>
 
 #include <core/data/sframe/gl_sframe.hpp>
@@ -168,6 +169,22 @@ inline std::vector<std::string> get_column_names(const gl_sframe& data,
   }
 }
 
+/**
+ * Returns the columns named by the user, or an empty vector when the columns
+ * depend on the data: all of its columns, or all but an exclude set.
+ *
+ * \param[in] exclude   Flag which determines if feature_columns is an exclude set.
+ * \param[in] feature_columns  Include/Excluded features.
+ */
+inline std::vector<std::string> get_explicit_column_names(bool exclude,
+                   const flexible_type& feature_columns) {
+  if (exclude || feature_columns.get_type() == flex_type_enum::UNDEFINED ||
+      !feature_columns.get<flex_list>().size()) {
+    return {};
+  }
+  return variant_get_value<std::vector<std::string>>(to_variant(feature_columns));
+}
+
 /**
  * Subselect features based on input features.
  *
@@ -767,7 +784,7 @@ inline flex_list tokenize_string(const std::string& to_tokenize,
 
   if (to_lower) {
     std::string str_copy = std::string(to_tokenize);
-    std::transform(str_copy.begin(), str_copy.end(), str_copy.begin(), ::tolower);
+    string_kernels::ascii_to_lower(str_copy);
     previous = {str_copy};
   }
 
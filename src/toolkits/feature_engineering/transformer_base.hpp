@@ -129,6 +129,18 @@ class EXPORT transformer_base : public ml_model_base {
    */
   virtual gl_sframe transform(gl_sframe data) = 0;
 
+  /**
+   * Returns the columns of the data which fit() reads. transform() must
+   * leave every other column of the data as it is, though it may add new
+   * ones. An empty vector, the default, means that any column may be read.
+   *
+   * Lets a \ref transformer_pipeline fit transformers over disjoint columns
+   * in the same pass.
+   */
+  virtual std::vector<std::string> get_fit_columns() const {
+    return {};
+  }
+
   /**
    * Fit and transform the given data. Intended as an optimization because
    * fit and transform are usually always called together. The default
@@ -0,0 +1,91 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <set>
+#include <string>
+#include <vector>
+#include <core/logging/logger.hpp>
+#include <toolkits/feature_engineering/transformer_pipeline.hpp>
+
+namespace turi {
+namespace sdk_model {
+namespace feature_engineering {
+
+/**
+ * Fit every step, a group of steps at a time.
+ */
+void transformer_pipeline::fit(gl_sframe data) {
+  m_num_fit_groups = 0;
+  gl_sframe current = data;
+  size_t begin = 0;
+  while (begin < m_steps.size()) {
+    std::vector<std::string> current_columns = current.column_names();
+    std::set<std::string> available(current_columns.begin(),
+                                    current_columns.end());
+
+    // Grow the group [begin, end) while the next step reads named columns of
+    // the current data which no earlier step of the group reads, and hence
+    // rewrites. An empty entry in step_columns reads everything.
+    std::set<std::string> group_columns;
+    std::vector<std::vector<std::string>> step_columns;
+    size_t end = begin;
+    for (; end < m_steps.size(); ++end) {
+      std::vector<std::string> fit_columns = m_steps[end]->get_fit_columns();
+      std::set<std::string> columns(fit_columns.begin(), fit_columns.end());
+      bool known = !columns.empty();
+      bool conflict = false;
+      for (const auto& c: columns) {
+        if (available.count(c) == 0) known = false;
+        if (group_columns.count(c)) conflict = true;
+      }
+      if (!known) {
+        if (end == begin) {
+          step_columns.emplace_back();
+          ++end;
+        }
+        break;
+      }
+      if (conflict) break;
+      group_columns.insert(columns.begin(), columns.end());
+      step_columns.emplace_back(columns.begin(), columns.end());
+    }
+
+    // The pass of the group: compute the columns it reads through the plan
+    // of the previous steps, once.
+    gl_sframe input = current;
+    if (!step_columns[0].empty()) {
+      input = current.select_columns(std::vector<std::string>(
+          group_columns.begin(), group_columns.end()));
+    }
+    input.materialize();
+    ++m_num_fit_groups;
+    logstream(LOG_DEBUG) << "Fitting steps " << begin << " to " << end - 1
+                         << " of the pipeline in one pass" << std::endl;
+
+    for (size_t i = begin; i < end; ++i) {
+      const auto& columns = step_columns[i - begin];
+      m_steps[i]->fit(columns.empty() ? input : input.select_columns(columns));
+    }
+    for (size_t i = begin; i < end; ++i) {
+      current = m_steps[i]->transform(current);
+    }
+    begin = end;
+  }
+}
+
+/**
+ * Compose the transforms of every step.
+ */
+gl_sframe transformer_pipeline::transform(gl_sframe data) const {
+  gl_sframe ret = data;
+  for (const auto& step: m_steps) {
+    ret = step->transform(ret);
+  }
+  return ret;
+}
+
+} // feature_engineering
+} // sdk_model
+} // turicreate
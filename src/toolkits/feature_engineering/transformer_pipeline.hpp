@@ -0,0 +1,100 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_TRANSFORMER_PIPELINE_H
+#define TURI_TRANSFORMER_PIPELINE_H
+
+#include <memory>
+#include <vector>
+#include <core/data/sframe/gl_sframe.hpp>
+#include <toolkits/feature_engineering/transformer_base.hpp>
+#include <core/export.hpp>
+
+namespace turi{
+namespace sdk_model {
+namespace feature_engineering {
+
+/**
+ * Runs a chain of transformers, each one fit on, and applied to, the output
+ * of the previous one, without materializing an SFrame per step.
+ *
+ *  *) transform : The transforms of all the steps are composed into a single
+ *                 lazy plan, which is executed once, by the consumer of the
+ *                 result.
+ *
+ *  *) fit : Consecutive steps whose fit reads explicitly named columns (see
+ *           \ref transformer_base::get_fit_columns), none of them written by
+ *           an earlier step of the group, are fit together: the columns the
+ *           group reads are computed through the plan of the previous steps
+ *           in one pass, and each step is fit on its own columns of that
+ *           result. Since SFrames are stored by column, a group costs about
+ *           one pass over the data however many steps it has. A step reading
+ *           any column (the features are all, or an exclude set) is fit
+ *           alone on the whole output of the previous steps.
+ *
+ * Example
+ * -------
+ *
+ * transformer_pipeline pipeline({imputer, binner, encoder});
+ * gl_sframe out = pipeline.fit_transform(data);
+ */
+class EXPORT transformer_pipeline {
+ public:
+  transformer_pipeline() = default;
+
+  explicit transformer_pipeline(
+      std::vector<std::shared_ptr<transformer_base>> steps)
+    : m_steps(std::move(steps)) { }
+
+  /// Appends a step to the end of the pipeline.
+  void add_step(std::shared_ptr<transformer_base> step) {
+    m_steps.push_back(std::move(step));
+  }
+
+  const std::vector<std::shared_ptr<transformer_base>>& steps() const {
+    return m_steps;
+  }
+
+  /**
+   * Fits every step, in order.
+   *
+   * \param[in] data  (SFrame of data)
+   */
+  void fit(gl_sframe data);
+
+  /**
+   * Applies the transform of every step, in order. The result is lazy.
+   *
+   * \param[in] data  (SFrame of data)
+   */
+  gl_sframe transform(gl_sframe data) const;
+
+  /**
+   * Fits every step, then transforms the data.
+   *
+   * \param[in] data  (SFrame of data)
+   */
+  gl_sframe fit_transform(gl_sframe data) {
+    fit(data);
+    return transform(data);
+  }
+
+  /**
+   * The number of groups of steps the last call to fit() fit together,
+   * each of which costs about one pass over the data.
+   */
+  size_t num_fit_groups() const {
+    return m_num_fit_groups;
+  }
+
+ private:
+  std::vector<std::shared_ptr<transformer_base>> m_steps;
+  size_t m_num_fit_groups = 0;
+};
+
+} // feature_engineering
+} // sdk_model
+} // turicreate
+#endif
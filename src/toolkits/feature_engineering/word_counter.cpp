@@ -6,6 +6,7 @@
 #include <model_server/lib/toolkit_class_macros.hpp>
 #include <model_server/lib/variant_deep_serialize.hpp>
 #include <toolkits/feature_engineering/word_counter.hpp>
+#include <toolkits/feature_engineering/token_counting.hpp>
 #include <core/logging/assertions.hpp>
 
 
@@ -446,6 +447,15 @@ gl_sframe word_counter::transform(gl_sframe data){
       output_column_name = output_column_prefix_opt.get<flex_string>() + "." + f;
     }
 
+    // String columns are tokenized, counted and indexed in parallel
+    // passes over the column, then keyed by word again.
+    if (!use_ptb_tokenizer && feat.dtype() == flex_type_enum::STRING
+        && can_count_tokens(delimiters, m_to_lower)) {
+      ret_sf[output_column_name] =
+          token_count_dicts(count_tokens(feat, delimiter_list, m_to_lower));
+      continue;
+    }
+
     // Do the first few transformations to check for errors
     feat.head(10).apply(
       transform_fn,
@@ -6,6 +6,7 @@
 #ifndef TURI_UNITY_CONNECTED_COMPONENT
 #define TURI_UNITY_CONNECTED_COMPONENT
 #include <model_server/lib/toolkit_function_specification.hpp>
+#include <core/storage/sgraph_data/sgraph.hpp>
 
 namespace turi {
 namespace connected_component {
@@ -31,6 +32,22 @@ namespace connected_component {
  */
 std::vector<toolkit_function_specification> get_toolkit_function_registration() ;
 
+/**
+ * Computes the weakly connected components of g into the vertex field
+ * "component_id". Returns an SFrame of component id and component size.
+ */
+sframe compute_connected_component(sgraph& g);
+
+/**
+ * Updates the components computed by \ref compute_connected_component()
+ * after vertices and edges were added to g since the watermark: the existing
+ * components are regrouped from the "component_id" field and merged along
+ * the new edges only, without a pass over the old edges. Component ids may
+ * change. Falls back to compute_connected_component() if g has no
+ * "component_id" field.
+ */
+sframe update_connected_component(sgraph& g, const sgraph::delta_watermark& since);
+
 } // namespace connected_component
 } // namespace turi
 #endif
@@ -10,6 +10,9 @@
 #include <core/storage/sframe_interface/unity_sgraph.hpp>
 #include <core/storage/sframe_interface/unity_sframe.hpp>
 #include <core/storage/sgraph_data/sgraph_fast_triple_apply.hpp>
+#include <core/storage/sgraph_data/sgraph_delta.hpp>
+#include <core/storage/sgraph_data/hilbert_parallel_for.hpp>
+#include <core/storage/sframe_data/sarray_reader.hpp>
 #include <core/storage/sframe_data/algorithm.hpp>
 #include <core/storage/sframe_data/groupby_aggregate.hpp>
 #include <core/storage/sframe_data/groupby_aggregate_operators.hpp>
@@ -23,167 +26,72 @@ namespace connected_component {
 
 const std::string COMPONENT_ID_COLUMN = "component_id";
 
+/// Number of edges read at once by a thread
+const size_t EDGE_BATCH_SIZE = 64 * 1024;
+
 /**
- * Standard union find datastructure for connected components.
- *
- * Implements weighted union, and path compression.
+ * Lock free union find over the vertex ids [0, n), for connected components.
  *
- * The \ref union_gorup, and \ref find_root operations are
- * thread safe for finding connected components.
+ * Roots are linked by id: union_group() points the root with the larger id
+ * at the root with the smaller one with a compare and swap, retrying if
+ * another thread moved either root meanwhile. Every parent is then smaller
+ * than its child, so concurrent unions can never form a cycle, and
+ * find_root() can shorten paths (path halving) without locks: losing a race
+ * only skips a shortcut. A single pass over the edges, from any number of
+ * threads at once, leaves every component as one tree.
  */
 class union_find_cc {
  public:
-  union_find_cc(size_t num_vertices) {
-    // initialize parents
-    parents.reserve(num_vertices);
-    parents.resize(num_vertices);
+  union_find_cc(size_t num_vertices) : parents(num_vertices) {
     parallel_for(0, num_vertices, [&](size_t i) { parents[i] = i; });
-
-    // initialize rank
-    rank.reserve(num_vertices);
-    rank.resize(num_vertices, 1);
-  }
-
-  void union_group(size_t group_a, size_t group_b) {
-    // update
-    if (rank[group_a] > rank[group_b]) {
-      parents[group_b] = group_a;
-      rank[group_a] += rank[group_b];
-    } else {
-      parents[group_a] = group_b;
-      rank[group_b] += rank[group_a];
-    }
   }
 
-  // Merge with another union find datastructure
-  union_find_cc& operator+= (const union_find_cc& other) {
-    ASSERT_EQ(parents.size(), other.parents.size());
-
-    // Iterate over "edges" from the other
-    for (size_t i = 0; i < other.parents.size(); ++i) {
-      // Add every "edge" from the other, and perform union if necessary
-      size_t src_root = find_root(i);
-      size_t dst_root = find_root(other.parents[i]);
-      if (src_root != dst_root) {
-        union_group(src_root, dst_root);
+  /// Returns the root of the group of vid. Thread safe.
+  size_t find_root(size_t vid) {
+    while (true) {
+      size_t parent = parents[vid].load(std::memory_order_relaxed);
+      if (parent == vid) return vid;
+      size_t grandparent = parents[parent].load(std::memory_order_relaxed);
+      if (grandparent != parent) {
+        parents[vid].compare_exchange_weak(parent, grandparent, std::memory_order_relaxed);
       }
+      vid = grandparent;
     }
-    return *this;
   }
 
-  size_t find_root(size_t vid) {
-    if (parents[vid] == vid) {
-      return vid;
+  /**
+   * Merges the groups of vertex a and vertex b. Returns false if they were
+   * already the same group. Thread safe.
+   */
+  bool union_group(size_t a, size_t b) {
+    while (true) {
+      a = find_root(a);
+      b = find_root(b);
+      if (a == b) return false;
+      if (a < b) std::swap(a, b);
+      size_t expected = a;
+      if (parents[a].compare_exchange_strong(expected, b)) return true;
     }
-
-    size_t ret = find_root(parents[vid]);
-
-    // path compression
-    parents[vid] = ret;
-    return ret;
-  }
-
-  void clear_rank() {
-    rank.clear();
-    rank.shrink_to_fit();
   }
 
   void clear() {
-    clear_rank();
     parents.clear();
     parents.shrink_to_fit();
   }
 
-
  private:
   /// Length |V|, parents[i] stores the parent vertex id for vertex i.
-  /// If i is root, parents[i] = i
-  std::vector<size_t> parents;
-
-  /// Length |V|, rank[i] stores the rank for component i.
-  /// The rank is approximiate during constructiondue to race condition.
-  std::vector<size_t> rank;
+  /// If i is root, parents[i] = i. Always parents[i] <= i.
+  std::vector<std::atomic<size_t>> parents;
 };
 
 /**
- * Compute connected component on the graph, add a new column to the vertex
- * with name "component_id".
- *
- * Returns an sframe with component id and component size information.
+ * Adds the component id of every vertex to the graph, as the root of its
+ * union find group, and returns an sframe of component id and component size.
  */
-sframe compute_connected_component(sgraph& g) {
-
-  // Initialize component union find data structure
-  size_t nthreads = thread::cpu_count();
-  std::vector<union_find_cc> thread_local_union_find(nthreads, g.num_vertices());
-
-  // For each partition, store the first vertex id
-  // This is the prefix sum of the partition size.
-  std::vector<size_t> partition_base_id(g.get_num_partitions());
-  size_t acc = 0;
-  for (size_t i = 0; i < partition_base_id.size(); ++i) {
-    partition_base_id[i] = acc;
-    acc += g.vertex_partition(i).size();
-  }
-
-  std::atomic<size_t> num_changed(0);
-  sgraph_compute::fast_triple_apply_fn_type apply_fn =
-      [&](sgraph_compute::fast_edge_scope& scope) {
-        size_t tid = thread::thread_id();
-        auto& union_find = thread_local_union_find[tid];
-        auto src_addr = scope.source_vertex_address();
-        auto dst_addr = scope.target_vertex_address();
-
-        // Get vertex id
-        size_t src_vid = partition_base_id[src_addr.partition_id] + src_addr.local_id;
-        size_t dst_vid = partition_base_id[dst_addr.partition_id] + dst_addr.local_id;
-
-        // Find component id
-        size_t src_component_id = union_find.find_root(src_vid);
-        size_t dst_component_id = union_find.find_root(dst_vid);
-
-        // Union two components
-        if (src_component_id != dst_component_id) {
-          union_find.union_group(src_component_id, dst_component_id);
-          ++num_changed;
-        }
-      };
-
-  table_printer table({{"Number of components merged", 0}});
-  table.print_header();
-  while(true) {
-    if (cppipc::must_cancel()) {
-      log_and_throw(std::string("Toolkit canceled by user"));
-    }
-    num_changed = 0;
-
-    // Compute union find in parallel
-    sgraph_compute::fast_triple_apply(g, apply_fn, {}, {});
-
-    // Merge thread local union find structures
-    for (size_t i = 1; i < thread_local_union_find.size(); ++i) {
-      thread_local_union_find[0] += thread_local_union_find[i];
-    }
-
-    // Broadcast the master copy
-    for (size_t i = 1; i < thread_local_union_find.size(); ++i) {
-      thread_local_union_find[i] = thread_local_union_find[0];
-    }
-
-    table.print_row(num_changed);
-    if (num_changed == 0) {
-      break;
-    }
-  }
-  table.print_footer();
-
-  // Converged!
-  // We no longer need the approxmiate rank stored in union_find , clear it and free up some memory
-  // We also don't need copies in other threads, only retain the master copy.
-  for (size_t i = 1; i < thread_local_union_find.size(); ++i) { thread_local_union_find[i].clear(); }
-  auto& union_find = thread_local_union_find[0];
-  union_find.clear_rank();
-
+sframe store_components(sgraph& g,
+                        union_find_cc& union_find,
+                        const std::vector<size_t>& partition_base_id) {
   // Prepare for return results:
   // 1. Vertex data of component id
   // 2. SFrame of component size
@@ -232,6 +140,107 @@ sframe compute_connected_component(sgraph& g) {
   return component_info;
 }
 
+/**
+ * For each partition, the id of its first vertex in the union find structure.
+ * This is the prefix sum of the partition size.
+ */
+std::vector<size_t> get_partition_base_id(const sgraph& g) {
+  std::vector<size_t> partition_base_id(g.get_num_partitions());
+  size_t acc = 0;
+  for (size_t i = 0; i < partition_base_id.size(); ++i) {
+    partition_base_id[i] = acc;
+    acc += g.vertex_partition(i).size();
+  }
+  return partition_base_id;
+}
+
+/**
+ * Compute connected component on the graph, add a new column to the vertex
+ * with name "component_id".
+ *
+ * Returns an sframe with component id and component size information.
+ */
+sframe compute_connected_component(sgraph& g) {
+  std::vector<size_t> partition_base_id = get_partition_base_id(g);
+  union_find_cc union_find(g.num_vertices());
+
+  // One pass over the edge partitions, each read by one thread
+  const size_t nparts = g.get_num_partitions();
+  std::atomic<size_t> num_merged(0);
+  std::atomic<bool> canceled(false);
+  sgraph_compute::hilbert_parallel_for(
+      nparts,
+      [](std::vector<std::pair<size_t, size_t>>) {},
+      [&](std::pair<size_t, size_t> coordinate) {
+        const sframe& edges = g.edge_partition(coordinate.first, coordinate.second);
+        const size_t nrows = edges.num_rows();
+        if (nrows == 0) return;
+        auto src_reader = edges.select_column(sgraph::SRC_COLUMN_NAME)->get_reader();
+        auto dst_reader = edges.select_column(sgraph::DST_COLUMN_NAME)->get_reader();
+        const size_t src_base = partition_base_id[coordinate.first];
+        const size_t dst_base = partition_base_id[coordinate.second];
+        std::vector<flex_int> src(EDGE_BATCH_SIZE), dst(EDGE_BATCH_SIZE);
+        size_t merged = 0;
+        for (size_t row = 0; row < nrows && !canceled; row += EDGE_BATCH_SIZE) {
+          if (cppipc::must_cancel()) {
+            canceled = true;
+            break;
+          }
+          size_t n = std::min(EDGE_BATCH_SIZE, nrows - row);
+          src_reader->read_rows_as(row, row + n, src.data(), 0);
+          dst_reader->read_rows_as(row, row + n, dst.data(), 0);
+          for (size_t k = 0; k < n; ++k) {
+            merged += union_find.union_group(src_base + src[k], dst_base + dst[k]);
+          }
+        }
+        num_merged += merged;
+      });
+  if (canceled) {
+    log_and_throw(std::string("Toolkit canceled by user"));
+  }
+  logprogress_stream << "Number of components merged: " << num_merged.load() << std::endl;
+
+  return store_components(g, union_find, partition_base_id);
+}
+
+
+sframe update_connected_component(sgraph& g, const sgraph::delta_watermark& since) {
+  auto fields = g.get_vertex_fields();
+  if (std::find(fields.begin(), fields.end(), COMPONENT_ID_COLUMN) == fields.end()) {
+    return compute_connected_component(g);
+  }
+  std::vector<size_t> partition_base_id = get_partition_base_id(g);
+  union_find_cc union_find(g.num_vertices());
+
+  // Regroup the vertices of every existing component. Vertices added since
+  // the watermark have no component id and start alone.
+  auto old_component_ids = g.fetch_vertex_data_field_in_memory(COMPONENT_ID_COLUMN);
+  std::unordered_map<flex_int, size_t> component_representative;
+  for (size_t partition_id = 0; partition_id < old_component_ids.size(); ++partition_id) {
+    const auto& ids = old_component_ids[partition_id];
+    for (size_t i = 0; i < ids.size(); ++i) {
+      if (ids[i].get_type() == flex_type_enum::UNDEFINED) continue;
+      size_t vid = partition_base_id[partition_id] + i;
+      auto iter = component_representative.emplace(ids[i].get<flex_int>(), vid).first;
+      if (iter->second != vid) union_find.union_group(iter->second, vid);
+    }
+  }
+  old_component_ids.clear();
+
+  // Merge the components joined by the new edges
+  std::atomic<size_t> num_merged(0);
+  sgraph_compute::delta_edge_apply(g, since,
+      [&](const sgraph_compute::vertex_address& src_addr,
+          const sgraph_compute::vertex_address& dst_addr) {
+        size_t src_vid = partition_base_id[src_addr.partition_id] + src_addr.local_id;
+        size_t dst_vid = partition_base_id[dst_addr.partition_id] + dst_addr.local_id;
+        if (union_find.union_group(src_vid, dst_vid)) ++num_merged;
+      });
+  logprogress_stream << "Number of components merged by new edges: " << num_merged.load() << std::endl;
+
+  return store_components(g, union_find, partition_base_id);
+}
+
 
 /**************************************************************************/
 /*                                                                        */
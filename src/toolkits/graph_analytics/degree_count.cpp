@@ -3,12 +3,14 @@
  * Use of this source code is governed by a BSD-3-clause license that can
  * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
  */
+#include <toolkits/graph_analytics/degree_count.hpp>
 #include <toolkits/graph_analytics/pagerank.hpp>
 #include <model_server/lib/toolkit_function_macros.hpp>
 #include <model_server/lib/toolkit_util.hpp>
 #include <model_server/lib/simple_model.hpp>
 #include <core/storage/sframe_interface/unity_sgraph.hpp>
 #include <core/storage/sgraph_data/sgraph_fast_triple_apply.hpp>
+#include <core/storage/sgraph_data/sgraph_delta.hpp>
 #include <core/storage/sframe_data/algorithm.hpp>
 #include <core/parallel/atomic.hpp>
 #include <core/export.hpp>
@@ -20,29 +22,16 @@ const std::string IN_DEGREE_COLUMN = "in_degree";
 const std::string OUT_DEGREE_COLUMN = "out_degree";
 const std::string ALL_DEGREE_COLUMN = "total_degree";
 
-/**
- * Compute in_degree, out_degree and total_degree for each vertex in the graph,
- * add three new columns to the vertices.
- */
-void compute_degree_count(sgraph& g) {
-
-  // Initialize component ids
-  typedef std::vector<std::vector<size_t>> size_t_column_type;
-  typedef std::vector<std::vector<turi::atomic<size_t>>> atomic_size_t_column_type;
-  atomic_size_t_column_type in_degree_data(sgraph_compute::create_vertex_data<turi::atomic<size_t>>(g));
-  atomic_size_t_column_type out_degree_data(sgraph_compute::create_vertex_data<turi::atomic<size_t>>(g));
-  size_t_column_type all_degree_data = sgraph_compute::create_vertex_data<size_t>(g);
-
-  sgraph_compute::fast_triple_apply_fn_type apply_fn =
-      [&](sgraph_compute::fast_edge_scope& scope) {
-        auto src_addr = scope.source_vertex_address();
-        auto dst_addr = scope.target_vertex_address();
-        out_degree_data[src_addr.partition_id][src_addr.local_id]++;
-        in_degree_data[dst_addr.partition_id][dst_addr.local_id]++;
-      };
+namespace {
 
-  sgraph_compute::fast_triple_apply(g, apply_fn, {}, {});
+typedef std::vector<std::vector<size_t>> size_t_column_type;
+typedef std::vector<std::vector<turi::atomic<size_t>>> atomic_size_t_column_type;
 
+/// Adds the in_degree, out_degree and total_degree columns to the vertices.
+void store_degree_count(sgraph& g,
+                        atomic_size_t_column_type& in_degree_data,
+                        atomic_size_t_column_type& out_degree_data) {
+  size_t_column_type all_degree_data = sgraph_compute::create_vertex_data<size_t>(g);
   parallel_for(0, all_degree_data.size(), [&](size_t i) {
     size_t n = all_degree_data[i].size();
     const auto& in_vec = in_degree_data[i];
@@ -65,6 +54,65 @@ void compute_degree_count(sgraph& g) {
                                        flex_type_enum::INTEGER);
 }
 
+/// Reads a degree column; vertices without a value yet have degree 0.
+atomic_size_t_column_type fetch_degree_column(const sgraph& g, const std::string& column) {
+  atomic_size_t_column_type ret(sgraph_compute::create_vertex_data<turi::atomic<size_t>>(g));
+  auto values = g.fetch_vertex_data_field_in_memory(column);
+  parallel_for(0, ret.size(), [&](size_t i) {
+    for (size_t j = 0; j < ret[i].size(); ++j) {
+      const flexible_type& value = values[i][j];
+      ret[i][j] = (value.get_type() == flex_type_enum::UNDEFINED) ? 0 : (size_t)(flex_int)value;
+    }
+  });
+  return ret;
+}
+
+} // end of anonymous namespace
+
+/**
+ * Compute in_degree, out_degree and total_degree for each vertex in the graph,
+ * add three new columns to the vertices.
+ */
+void compute_degree_count(sgraph& g) {
+
+  // Initialize component ids
+  atomic_size_t_column_type in_degree_data(sgraph_compute::create_vertex_data<turi::atomic<size_t>>(g));
+  atomic_size_t_column_type out_degree_data(sgraph_compute::create_vertex_data<turi::atomic<size_t>>(g));
+
+  sgraph_compute::fast_triple_apply_fn_type apply_fn =
+      [&](sgraph_compute::fast_edge_scope& scope) {
+        auto src_addr = scope.source_vertex_address();
+        auto dst_addr = scope.target_vertex_address();
+        out_degree_data[src_addr.partition_id][src_addr.local_id]++;
+        in_degree_data[dst_addr.partition_id][dst_addr.local_id]++;
+      };
+
+  sgraph_compute::fast_triple_apply(g, apply_fn, {}, {});
+
+  store_degree_count(g, in_degree_data, out_degree_data);
+}
+
+void update_degree_count(sgraph& g, const sgraph::delta_watermark& since) {
+  auto fields = g.get_vertex_fields();
+  for (const auto& column : {IN_DEGREE_COLUMN, OUT_DEGREE_COLUMN, ALL_DEGREE_COLUMN}) {
+    if (std::find(fields.begin(), fields.end(), column) == fields.end()) {
+      compute_degree_count(g);
+      return;
+    }
+  }
+  atomic_size_t_column_type in_degree_data = fetch_degree_column(g, IN_DEGREE_COLUMN);
+  atomic_size_t_column_type out_degree_data = fetch_degree_column(g, OUT_DEGREE_COLUMN);
+
+  sgraph_compute::delta_edge_apply(g, since,
+      [&](const sgraph_compute::vertex_address& src_addr,
+          const sgraph_compute::vertex_address& dst_addr) {
+        out_degree_data[src_addr.partition_id][src_addr.local_id]++;
+        in_degree_data[dst_addr.partition_id][dst_addr.local_id]++;
+      });
+
+  store_degree_count(g, in_degree_data, out_degree_data);
+}
+
 
 /**************************************************************************/
 /*                                                                        */
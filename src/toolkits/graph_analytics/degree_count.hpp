@@ -6,6 +6,7 @@
 #include <model_server/lib/toolkit_function_specification.hpp>
 #ifndef TURI_UNITY_DEGREE_COUNT
 #define TURI_UNITY_DEGREE_COUNT
+#include <core/storage/sgraph_data/sgraph.hpp>
 
 namespace turi {
 namespace degree_count {
@@ -26,6 +27,20 @@ namespace degree_count {
  */
 std::vector<toolkit_function_specification> get_toolkit_function_registration();
 
+/**
+ * Computes the in, out and total degree of every vertex of g, into the
+ * vertex fields "in_degree", "out_degree" and "total_degree".
+ */
+void compute_degree_count(sgraph& g);
+
+/**
+ * Updates the degree fields computed by \ref compute_degree_count() after
+ * edges were added to g since the watermark, scanning only the new edges.
+ * Vertices added since start from degree 0. Falls back to
+ * compute_degree_count() if g has no degree fields.
+ */
+void update_degree_count(sgraph& g, const sgraph::delta_watermark& since);
+
 } // namespace degree_count
 } // namespace turi
 #endif
@@ -9,6 +9,9 @@
 #include <model_server/lib/simple_model.hpp>
 #include <core/storage/sframe_interface/unity_sgraph.hpp>
 #include <core/storage/sgraph_data/sgraph_compute.hpp>
+#include <core/storage/sgraph_data/sgraph_csr.hpp>
+#include <core/parallel/atomic.hpp>
+#include <core/parallel/lambda_omp.hpp>
 #include <core/storage/sframe_data/algorithm.hpp>
 #include <core/logging/table_printer/table_printer.hpp>
 #include <core/export.hpp>
@@ -169,6 +172,114 @@ size_t compute_coloring(sgraph& g) {
   return set_combine.size();
 }
 
+/**************************************************************************/
+/*                                                                        */
+/*                   In Memory Speculative Coloring (CSR)                 */
+/*                                                                        */
+/**************************************************************************/
+typedef sgraph_compute::csr_snapshot::vertex_id_type csr_vertex_id;
+
+/**
+ * Calls fn(u) on every neighbor u != v of v, in either direction.
+ */
+template <typename Fn>
+void for_each_neighbor(const sgraph_compute::csr_snapshot& csr, csr_vertex_id v, Fn fn) {
+  for (auto u = csr.out_begin(v); u != csr.out_end(v); ++u) {
+    if (*u != v) fn(*u);
+  }
+  for (auto u = csr.in_begin(v); u != csr.in_end(v); ++u) {
+    if (*u != v) fn(*u);
+  }
+}
+
+/**
+ * Same as compute_coloring(), on an in memory snapshot, by speculative
+ * parallel greedy coloring.
+ *
+ * Each round, every vertex of the work list takes in parallel the smallest
+ * color none of its neighbors has, reading their colors as they are being
+ * changed. Two neighbors colored at the same time may pick the same color;
+ * the round then checks the work list, and of each such pair the vertex with
+ * the larger id goes back on the work list for the next round. Conflicts
+ * only arise between vertices colored concurrently, so the work list shrinks
+ * quickly, and each round only touches the edges of the vertices in it.
+ */
+size_t csr_coloring(sgraph& g) {
+  sgraph_compute::csr_snapshot csr(g, sgraph_compute::csr_direction::BOTH);
+  const size_t nvertices = csr.num_vertices();
+  std::vector<turi::atomic<size_t>> color(nvertices);
+
+  std::vector<csr_vertex_id> work(nvertices);
+  for (size_t v = 0; v < nvertices; ++v) work[v] = v;
+  const size_t nthreads = thread_pool::get_instance().size() + 1;
+  std::vector<std::vector<csr_vertex_id>> conflicts_per_thread(nthreads);
+  std::vector<size_t> num_colors_per_thread(nthreads, 0);
+
+  table_printer table({{"Number of vertices updated", 0}});
+  table.print_header();
+  while (!work.empty()) {
+    if(cppipc::must_cancel()) {
+      log_and_throw(std::string("Toolkit cancelled by user."));
+    }
+    // assign colors
+    parallel_range_cursor assign_cursor(0, work.size(), parallel_schedule::DYNAMIC, 64);
+    in_parallel([&](size_t thread_id, size_t num_threads) {
+      // forbidden[c] == v + 1 iff a neighbor of v has color c
+      std::vector<size_t> forbidden;
+      size_t chunk_begin, chunk_end;
+      while (assign_cursor.next(chunk_begin, chunk_end)) {
+        for (size_t i = chunk_begin; i < chunk_end; ++i) {
+          csr_vertex_id v = work[i];
+          for_each_neighbor(csr, v, [&](csr_vertex_id u) {
+            size_t c = color[u].value;
+            if (c >= forbidden.size()) forbidden.resize(c + 1, 0);
+            forbidden[c] = v + 1;
+          });
+          size_t c = 0;
+          while (c < forbidden.size() && forbidden[c] == v + 1) ++c;
+          color[v] = c;
+        }
+      }
+    });
+
+    // detect conflicts
+    parallel_range_cursor check_cursor(0, work.size(), parallel_schedule::DYNAMIC, 64);
+    in_parallel([&](size_t thread_id, size_t num_threads) {
+      auto& conflicts = conflicts_per_thread[thread_id];
+      size_t chunk_begin, chunk_end;
+      while (check_cursor.next(chunk_begin, chunk_end)) {
+        for (size_t i = chunk_begin; i < chunk_end; ++i) {
+          csr_vertex_id v = work[i];
+          bool conflict = false;
+          for_each_neighbor(csr, v, [&](csr_vertex_id u) {
+            conflict |= (u < v && color[u].value == color[v].value);
+          });
+          if (conflict) conflicts.push_back(v);
+        }
+      }
+    });
+
+    table.print_row(work.size());
+    work.clear();
+    for (auto& conflicts : conflicts_per_thread) {
+      work.insert(work.end(), conflicts.begin(), conflicts.end());
+      conflicts.clear();
+    }
+  }
+  table.print_footer();
+
+  size_t max_color = 0;
+  for (size_t v = 0; v < nvertices; ++v) max_color = std::max<size_t>(max_color, color[v]);
+  std::vector<bool> used(max_color + 1, false);
+  for (size_t v = 0; v < nvertices; ++v) used[color[v]] = true;
+
+  // the same column type as compute_coloring() produces
+  auto vertex_colors = csr.split_by_partition(color);
+  g.add_vertex_field<turi::atomic<size_t>, flex_float>(vertex_colors, COLOR_COLUMN,
+                                                       flex_type_enum::FLOAT);
+  return std::count(used.begin(), used.end(), true);
+}
+
 /**************************************************************************/
 /*                                                                        */
 /*                             Main Function                              */
@@ -188,7 +299,12 @@ variant_map_type  exec(variant_map_type& params) {
   g.select_vertex_fields({sgraph::VID_COLUMN_NAME});
   g.select_edge_fields({sgraph::SRC_COLUMN_NAME, sgraph::DST_COLUMN_NAME});
 
-  size_t num_colors = compute_coloring(g);
+  size_t num_colors = 0;
+  if (sgraph_compute::csr_snapshot::fits_in_memory(g)) {
+    num_colors = csr_coloring(g);
+  } else {
+    num_colors = compute_coloring(g);
+  }
 
 #ifndef NDEBUG
   validate_coloring(g);
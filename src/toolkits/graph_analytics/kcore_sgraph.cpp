@@ -9,6 +9,9 @@
 #include <model_server/lib/simple_model.hpp>
 #include <core/storage/sframe_interface/unity_sgraph.hpp>
 #include <core/storage/sgraph_data/sgraph_compute.hpp>
+#include <core/storage/sgraph_data/sgraph_csr.hpp>
+#include <core/parallel/atomic.hpp>
+#include <core/parallel/lambda_omp.hpp>
 #include <core/storage/sframe_data/algorithm.hpp>
 #include <atomic>
 #include <core/export.hpp>
@@ -186,6 +189,107 @@ void triple_apply_kcore(sgraph& g) {
   g.remove_edge_field(DELETED_COLUMN);
 }
 
+/**************************************************************************/
+/*                                                                        */
+/*                    In Memory Bucketed Peeling (CSR)                    */
+/*                                                                        */
+/**************************************************************************/
+typedef sgraph_compute::csr_snapshot::vertex_id_type csr_vertex_id;
+
+/**
+ * Computes the same core ids as triple_apply_kcore() on an in memory
+ * snapshot, by peeling vertices out of degree buckets.
+ *
+ * Vertices wait in bucket[d] for the phase k = d: every remaining vertex of
+ * degree at most k is deleted with core id k, in parallel rounds. Deleting a
+ * vertex decrements the degree of its remaining neighbors; the one decrement
+ * which takes a neighbor down to k puts it in the next round, and the others
+ * (lazily) move it to the bucket of its new degree. A vertex thus costs one
+ * pass over its edges, instead of one pass over the graph per round.
+ */
+void csr_kcore(sgraph& g) {
+  sgraph_compute::csr_snapshot csr(g, sgraph_compute::csr_direction::BOTH);
+  const size_t nvertices = csr.num_vertices();
+  const size_t kmin = KMIN, kmax = KMAX;
+
+  std::vector<turi::atomic<size_t>> degree(nvertices);
+  std::vector<turi::atomic<size_t>> core_id(nvertices);
+  parallel_for(0, nvertices, [&](size_t v) {
+    degree[v] = csr.out_degree(v) + csr.in_degree(v);
+    core_id[v] = kmax;
+  });
+  dense_bitset deleted(nvertices);
+  deleted.clear();
+
+  // buckets[k] holds vertices of degree k (or at most kmin for k == kmin),
+  // and may hold stale entries of vertices which since moved on
+  std::vector<std::vector<csr_vertex_id>> buckets(kmax);
+  for (size_t v = 0; v < nvertices; ++v) {
+    size_t d = std::max<size_t>(degree[v], kmin);
+    if (d < kmax) buckets[d].push_back(v);
+  }
+
+  const size_t nthreads = thread_pool::get_instance().size() + 1;
+  std::vector<std::vector<csr_vertex_id>> next_per_thread(nthreads);
+  std::vector<std::vector<std::pair<size_t, csr_vertex_id>>> moved_per_thread(nthreads);
+  size_t vertices_left = nvertices;
+  for (size_t k = kmin; k < kmax && vertices_left > 0; ++k) {
+    if(cppipc::must_cancel()) {
+      log_and_throw(std::string("Toolkit cancelled by user."));
+    }
+    std::vector<csr_vertex_id> frontier;
+    for (csr_vertex_id v : buckets[k]) {
+      if (degree[v] <= k && !deleted.set_bit_unsync(v)) frontier.push_back(v);
+    }
+    buckets[k].clear();
+    buckets[k].shrink_to_fit();
+
+    while (!frontier.empty()) {
+      vertices_left -= frontier.size();
+      parallel_range_cursor cursor(0, frontier.size(), parallel_schedule::DYNAMIC, 64);
+      in_parallel([&](size_t thread_id, size_t num_threads) {
+        auto& next = next_per_thread[thread_id];
+        auto& moved = moved_per_thread[thread_id];
+        auto peel_edge = [&](csr_vertex_id u) {
+          if (deleted.get(u)) return;
+          size_t d = degree[u].dec();
+          if (d == k) {
+            next.push_back(u);
+          } else if (d > k && d < kmax) {
+            moved.emplace_back(d, u);
+          }
+        };
+        size_t chunk_begin, chunk_end;
+        while (cursor.next(chunk_begin, chunk_end)) {
+          for (size_t i = chunk_begin; i < chunk_end; ++i) {
+            csr_vertex_id v = frontier[i];
+            core_id[v] = k;
+            for (auto u = csr.out_begin(v); u != csr.out_end(v); ++u) peel_edge(*u);
+            for (auto u = csr.in_begin(v); u != csr.in_end(v); ++u) peel_edge(*u);
+          }
+        }
+      });
+      frontier.clear();
+      for (size_t t = 0; t < nthreads; ++t) {
+        for (csr_vertex_id u : next_per_thread[t]) {
+          if (!deleted.set_bit_unsync(u)) frontier.push_back(u);
+        }
+        next_per_thread[t].clear();
+        for (const auto& entry : moved_per_thread[t]) {
+          buckets[entry.first].push_back(entry.second);
+        }
+        moved_per_thread[t].clear();
+      }
+    }
+    logprogress_stream << "Finish computing core " << k << "\t Vertices left: "
+                       << vertices_left << std::endl;
+  }
+
+  auto vertex_core_ids = csr.split_by_partition(core_id);
+  g.add_vertex_field<turi::atomic<size_t>, flex_int>(vertex_core_ids, CORE_ID_COLUMN,
+                                                     flex_type_enum::INTEGER);
+}
+
 /**************************************************************************/
 /*                                                                        */
 /*                             Main Function                              */
@@ -207,7 +311,11 @@ variant_map_type exec(variant_map_type& params) {
   g.select_vertex_fields({sgraph::VID_COLUMN_NAME});
   g.select_edge_fields({sgraph::SRC_COLUMN_NAME, sgraph::DST_COLUMN_NAME});
 
-  triple_apply_kcore(g);
+  if (sgraph_compute::csr_snapshot::fits_in_memory(g)) {
+    csr_kcore(g);
+  } else {
+    triple_apply_kcore(g);
+  }
 
   std::shared_ptr<unity_sgraph> result_graph(new unity_sgraph(std::make_shared<sgraph>(g)));
 
@@ -9,6 +9,8 @@
 #include <model_server/lib/simple_model.hpp>
 #include <core/storage/sframe_interface/unity_sgraph.hpp>
 #include <core/storage/sgraph_data/sgraph_fast_triple_apply.hpp>
+#include <core/storage/sgraph_data/sgraph_csr.hpp>
+#include <core/storage/sgraph_data/sgraph_frontier.hpp>
 #include <core/storage/sframe_data/algorithm.hpp>
 #include <core/logging/table_printer/table_printer.hpp>
 #include <core/data/sframe/gl_sarray.hpp>
@@ -70,6 +72,105 @@ namespace label_propagation {
     }
   }
 
+  /**
+   * Runs the label propagation iterations on an in memory CSR snapshot of g,
+   * starting from, and leaving the result in, label_pb (one matrix of class
+   * probabilities per vertex partition).
+   *
+   * Only the active vertices are recomputed: after the first sweep, the
+   * neighbors of the vertices whose class probabilities changed by more than
+   * threshold (in l2 norm) in the previous iteration. Labeled vertices are
+   * clamped, so they never change.
+   */
+  template<typename FLOAT_TYPE, typename MATRIX_TYPE>
+  void run_active_set(sgraph& g,
+                      sgraph_compute::csr_direction direction,
+                      const std::vector<std::vector<flexible_type>>& vertex_labels,
+                      std::vector<MATRIX_TYPE>& label_pb,
+                      size_t num_unlabeled_vertices,
+                      size_t& num_iter,
+                      double& average_l2_delta) {
+    logprogress_stream << "Loading graph in memory" << std::endl;
+    sgraph_compute::csr_snapshot csr(g, direction, weight_field);
+    const size_t nvertices = csr.num_vertices();
+    const size_t num_classes = label_pb.empty() ? 0 : label_pb[0].cols();
+    const bool use_edge_weight = csr.has_weights();
+
+    MATRIX_TYPE cur_pb(nvertices, num_classes);
+    MATRIX_TYPE next_pb(nvertices, num_classes);
+    std::vector<char> is_labeled(nvertices, 0);
+    for (size_t i = 0; i < label_pb.size(); ++i) {
+      size_t begin = csr.partition_begin(i);
+      cur_pb.middleRows(begin, label_pb[i].rows()) = label_pb[i];
+      label_pb[i].resize(0, 0);
+      for (size_t j = 0; j < vertex_labels[i].size(); ++j) {
+        is_labeled[begin + j] = !vertex_labels[i][j].is_na();
+      }
+    }
+
+    sgraph_compute::vertex_frontier active(nvertices), changed(nvertices);
+    active.activate_all();
+
+    table_printer table({{"Iteration", 0}, {"Average l2 change in class probability", 0}});
+    table.print_header();
+    size_t iter = 0;
+    while (max_iterations <= 0 || (int)iter < max_iterations) {
+      ++iter;
+      if(cppipc::must_cancel()) {
+        log_and_throw(std::string("Toolkit cancelled by user."));
+      }
+      logstream(LOG_INFO) << "Label propagation iteration " << iter << ": "
+                          << active.size() << " active vertices" << std::endl;
+
+      // Label Propagation, reading the probabilities of the previous iteration
+      active.parallel_for_each([&](size_t v) {
+        if (is_labeled[v]) return;
+        next_pb.row(v) = cur_pb.row(v) * self_weight;
+        const auto* weights = use_edge_weight ? csr.in_weights(v) : nullptr;
+        for (auto u = csr.in_begin(v); u != csr.in_end(v); ++u) {
+          FLOAT_TYPE weight = weights ? weights[u - csr.in_begin(v)] : 1.0;
+          next_pb.row(v) += cur_pb.row(*u) * weight;
+        }
+        if (undirected) {
+          weights = use_edge_weight ? csr.out_weights(v) : nullptr;
+          for (auto u = csr.out_begin(v); u != csr.out_end(v); ++u) {
+            FLOAT_TYPE weight = weights ? weights[u - csr.out_begin(v)] : 1.0;
+            next_pb.row(v) += cur_pb.row(*u) * weight;
+          }
+        }
+        next_pb.row(v) /= next_pb.row(v).sum();
+      });
+
+      // apply the changes, and find the vertices which changed enough to
+      // wake up their neighbors
+      changed.clear();
+      double total_l2_diff = active.parallel_sum<double>([&](size_t v) {
+        if (is_labeled[v]) return 0.0;
+        double diff = (next_pb.row(v) - cur_pb.row(v)).norm();
+        cur_pb.row(v) = next_pb.row(v);
+        if (diff > threshold) changed.activate(v);
+        return diff;
+      });
+
+      num_iter = iter;
+      average_l2_delta =
+          num_unlabeled_vertices > 0 ? total_l2_diff / num_unlabeled_vertices : 0.0;
+
+      table.print_row(iter, average_l2_delta);
+
+      if (average_l2_delta < threshold)
+        break;
+      sgraph_compute::expand_frontier(csr, changed, active, undirected);
+      if (active.empty())
+        break;
+    }
+    table.print_footer();
+
+    for (size_t i = 0; i < label_pb.size(); ++i) {
+      label_pb[i] = cur_pb.middleRows(csr.partition_begin(i), vertex_labels[i].size());
+    }
+  }
+
   /**
    * Running label propagation on graph g until converence.
    */
@@ -215,66 +316,82 @@ namespace label_propagation {
            }
          };
 
-    // Done with all initializations, this is the real for loop
-    table_printer table({{"Iteration", 0}, {"Average l2 change in class probability", 0}});
-    table.print_header();
-    size_t iter = 0;
-    while (true) {
-      if (max_iterations > 0 && (int)iter >= max_iterations)
-        break;
+    // Run in memory, on the vertices which need it, when the graph fits
+    auto direction = sgraph_compute::csr_direction::BOTH;
+    bool use_active_set = sgraph_compute::csr_snapshot::fits_in_memory(
+        g, direction, use_edge_weight);
+    if (!use_active_set && !undirected) {
+      direction = sgraph_compute::csr_direction::IN;
+      use_active_set = sgraph_compute::csr_snapshot::fits_in_memory(
+          g, direction, use_edge_weight);
+    }
 
-      ++iter;
-      if(cppipc::must_cancel()) {
-        log_and_throw(std::string("Toolkit cancelled by user."));
-      }
+    if (use_active_set) {
+      (*current_label_pb).clear();
+      run_active_set<FLOAT_TYPE>(g, direction, vertex_labels, *prev_label_pb,
+                                 num_unlabeled_vertices, num_iter, average_l2_delta);
+    } else {
+      // Done with all initializations, this is the real for loop
+      table_printer table({{"Iteration", 0}, {"Average l2 change in class probability", 0}});
+      table.print_header();
+      size_t iter = 0;
+      while (true) {
+        if (max_iterations > 0 && (int)iter >= max_iterations)
+          break;
+
+        ++iter;
+        if(cppipc::must_cancel()) {
+          log_and_throw(std::string("Toolkit cancelled by user."));
+        }
 
-      // Stores the total l2 diff in label probability
-      turi::atomic<FLOAT_TYPE> total_l2_diff = 0.0;
+        // Stores the total l2 diff in label probability
+        turi::atomic<FLOAT_TYPE> total_l2_diff = 0.0;
 
-      // initialize with the self weight of the the previous label value
-      for (size_t i = 0; i < num_partitions; ++i) {
-        (*current_label_pb)[i] = (*prev_label_pb)[i] * self_weight;
-      }
+        // initialize with the self weight of the the previous label value
+        for (size_t i = 0; i < num_partitions; ++i) {
+          (*current_label_pb)[i] = (*prev_label_pb)[i] * self_weight;
+        }
 
-      // Label Propagation
-      if (weight_field.empty()) {
-        sgraph_compute::fast_triple_apply(g, apply_fn, {}, {});
-      } else {
-        sgraph_compute::fast_triple_apply(g, apply_fn, {weight_field}, {});
-      }
+        // Label Propagation
+        if (weight_field.empty()) {
+          sgraph_compute::fast_triple_apply(g, apply_fn, {}, {});
+        } else {
+          sgraph_compute::fast_triple_apply(g, apply_fn, {weight_field}, {});
+        }
 
-      // Post processing:
-      // 1. Normalize to probability
-      // 2. Clamp labeled data
-      for (size_t i = 0; i < num_partitions; ++i) {
-        size_t num_vertices_in_partition = vertex_labels[i].size();
-        parallel_for (0, num_vertices_in_partition, [&](size_t j) {
-          if (!vertex_labels[i][j].is_na()) {
-            (*current_label_pb)[i].row(j).setZero();
-            size_t class_label = vertex_labels[i][j];
-            (*current_label_pb)[i](j, class_label) = 1.0;
-          } else {
-            (*current_label_pb)[i].row(j) /= (*current_label_pb)[i].row(j).sum();
-          }
-        });
-        auto diff = (((*current_label_pb)[i] - (*prev_label_pb)[i]).rowwise().norm().sum());
-        total_l2_diff += diff;
-      }
+        // Post processing:
+        // 1. Normalize to probability
+        // 2. Clamp labeled data
+        for (size_t i = 0; i < num_partitions; ++i) {
+          size_t num_vertices_in_partition = vertex_labels[i].size();
+          parallel_for (0, num_vertices_in_partition, [&](size_t j) {
+            if (!vertex_labels[i][j].is_na()) {
+              (*current_label_pb)[i].row(j).setZero();
+              size_t class_label = vertex_labels[i][j];
+              (*current_label_pb)[i](j, class_label) = 1.0;
+            } else {
+              (*current_label_pb)[i].row(j) /= (*current_label_pb)[i].row(j).sum();
+            }
+          });
+          auto diff = (((*current_label_pb)[i] - (*prev_label_pb)[i]).rowwise().norm().sum());
+          total_l2_diff += diff;
+        }
 
-      // swap the current label and the prev label
-      std::swap(current_label_pb, prev_label_pb);
+        // swap the current label and the prev label
+        std::swap(current_label_pb, prev_label_pb);
 
-      // store iteration and delta
-      num_iter = iter;
-      average_l2_delta =
-          num_unlabeled_vertices > 0 ? total_l2_diff / num_unlabeled_vertices : 0.0;
+        // store iteration and delta
+        num_iter = iter;
+        average_l2_delta =
+            num_unlabeled_vertices > 0 ? total_l2_diff / num_unlabeled_vertices : 0.0;
 
-      table.print_row(iter, average_l2_delta);
+        table.print_row(iter, average_l2_delta);
 
-      if (average_l2_delta < threshold)
-        break;
-    } // end of label_propagation iterations
-    table.print_footer();
+        if (average_l2_delta < threshold)
+          break;
+      } // end of label_propagation iterations
+      table.print_footer();
+    }
 
     // Free some memory
     (*current_label_pb).clear();
@@ -9,6 +9,8 @@
 #include <model_server/lib/simple_model.hpp>
 #include <core/storage/sframe_interface/unity_sgraph.hpp>
 #include <core/storage/sgraph_data/sgraph_fast_triple_apply.hpp>
+#include <core/storage/sgraph_data/sgraph_csr.hpp>
+#include <core/storage/sgraph_data/sgraph_frontier.hpp>
 #include <core/storage/sframe_data/algorithm.hpp>
 #include <core/logging/table_printer/table_printer.hpp>
 #include <core/export.hpp>
@@ -181,7 +183,108 @@ void triple_apply_pagerank(sgraph& g, size_t& num_iter, double& total_pagerank,
                                              flex_type_enum::FLOAT);
 }
 
+/**
+ * Same as triple_apply_pagerank, on an in memory CSR snapshot of the graph.
+ * Every vertex pulls the contributions of its in neighbors, so no atomics
+ * are needed.
+ *
+ * Only the active vertices are recomputed: after the first sweep, those with
+ * an in neighbor whose pagerank changed by more than threshold / num_vertices
+ * in the previous iteration. The changes left out add up to less than
+ * threshold, the convergence criterion on the total change.
+ */
+template<typename FLOAT_TYPE>
+void csr_pagerank(sgraph& g, size_t& num_iter, double& total_pagerank, double& total_delta) {
+  logprogress_stream << "Loading graph in memory" << std::endl;
+  // out edges let small frontiers be expanded by pushing
+  auto direction = sgraph_compute::csr_snapshot::fits_in_memory(
+      g, sgraph_compute::csr_direction::BOTH) ?
+      sgraph_compute::csr_direction::BOTH : sgraph_compute::csr_direction::IN;
+  sgraph_compute::csr_snapshot csr(g, direction);
+  const size_t nvertices = csr.num_vertices();
+  const double tolerance = threshold / std::max<size_t>(nvertices, 1);
+
+  std::vector<FLOAT_TYPE> cur_pagerank(nvertices, 1.0);
+  std::vector<FLOAT_TYPE> next_pagerank(nvertices, 0.0);
+  std::vector<FLOAT_TYPE> contribution(nvertices, 0.0);
+  std::vector<FLOAT_TYPE> delta(nvertices, 0.0);
+
+  // what each vertex sends along each of its out edges
+  parallel_for (0, nvertices, [&](size_t v) {
+    size_t degree = csr.out_degree(v);
+    contribution[v] = degree > 0 ? cur_pagerank[v] / degree : 0;
+  });
+
+  sgraph_compute::vertex_frontier active(nvertices), changed(nvertices);
+  active.activate_all();
 
+  num_iter = 0;
+  total_delta = 0.0;
+  total_pagerank = 0.0;
+
+  double w = (1 - reset_probability);
+
+  table_printer table({{"Iteration", 0},
+                                {"L1 change in pagerank", 0}});
+  table.print_header();
+
+  for (size_t iter = 0; iter < (size_t)max_iterations; ++iter) {
+
+    ++num_iter;
+    if(cppipc::must_cancel()) {
+      log_and_throw(std::string("Toolkit cancelled by user."));
+    }
+    logstream(LOG_INFO) << "Pagerank iteration " << iter + 1 << ": "
+                        << active.size() << " active vertices" << std::endl;
+
+    // Pagerank iteration, reading the values of the previous iteration
+    active.parallel_for_each([&](size_t v) {
+      double sum = 0.0;
+      for (auto u = csr.in_begin(v); u != csr.in_end(v); ++u) {
+        sum += contribution[*u];
+      }
+      next_pagerank[v] = reset_probability + w * sum;
+    });
+
+    // apply the changes, and find the vertices which changed enough to
+    // wake up their out neighbors
+    parallel_for (0, nvertices, [&](size_t v) { delta[v] = 0; });
+    changed.clear();
+    total_delta = active.parallel_sum<double>([&](size_t v) {
+      FLOAT_TYPE diff = std::abs<FLOAT_TYPE>(next_pagerank[v] - cur_pagerank[v]);
+      delta[v] = diff;
+      cur_pagerank[v] = next_pagerank[v];
+      size_t degree = csr.out_degree(v);
+      contribution[v] = degree > 0 ? cur_pagerank[v] / degree : 0;
+      if (diff > tolerance) changed.activate(v);
+      return (double)diff;
+    });
+    table.print_row(iter+1, total_delta);
+
+    // check convergence
+    if (total_delta < threshold) {
+      break;
+    }
+    sgraph_compute::expand_frontier(csr, changed, active);
+    if (active.empty()) {
+      break;
+    }
+  } // end of pagerank iterations
+
+  table.print_footer();
+
+  total_pagerank = std::accumulate(cur_pagerank.begin(), cur_pagerank.end(), 0.0);
+
+  // Store result to graph
+  auto pagerank_column = csr.split_by_partition(cur_pagerank);
+  auto delta_column = csr.split_by_partition(delta);
+  g.add_vertex_field<FLOAT_TYPE, flex_float>(pagerank_column,
+                                             PAGERANK_COLUMN,
+                                             flex_type_enum::FLOAT);
+  g.add_vertex_field<FLOAT_TYPE, flex_float>(delta_column,
+                                             DELTA_COLUMN,
+                                             flex_type_enum::FLOAT);
+}
 
 
   /**************************************************************************/
@@ -209,7 +312,14 @@ void triple_apply_pagerank(sgraph& g, size_t& num_iter, double& total_pagerank,
     double delta;
     size_t num_iter;
 
-    if (single_precision) {
+    if (sgraph_compute::csr_snapshot::fits_in_memory(
+            g, sgraph_compute::csr_direction::IN)) {
+      if (single_precision) {
+        csr_pagerank<float>(g, num_iter, total_pagerank, delta);
+      } else {
+        csr_pagerank<double>(g, num_iter, total_pagerank, delta);
+      }
+    } else if (single_precision) {
       triple_apply_pagerank<float>(g, num_iter, total_pagerank, delta);
     } else {
       triple_apply_pagerank<double>(g, num_iter, total_pagerank, delta);
@@ -10,6 +10,7 @@
 #include <core/storage/sframe_interface/unity_sgraph.hpp>
 #include <model_server/lib/toolkit_function_macros.hpp>
 #include <core/storage/sgraph_data/sgraph_compute.hpp>
+#include <core/storage/sgraph_data/sgraph_csr.hpp>
 #include <core/storage/sframe_data/algorithm.hpp>
 #include <core/logging/table_printer/table_printer.hpp>
 #include <atomic>
@@ -161,6 +162,164 @@ void triple_apply_sssp(sgraph& g) {
 
 }
 
+/**
+ * Atomically lowers value to new_value if new_value is smaller. Returns
+ * true if it did.
+ */
+inline bool atomic_min(std::atomic<double>& value, double new_value) {
+  double current = value.load(std::memory_order_relaxed);
+  while (new_value < current) {
+    if (value.compare_exchange_weak(current, new_value, std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ *  Computes the shortest path distance from all vertices to the source vertex
+ *  by delta-stepping over an in memory snapshot of the graph, and replaces
+ *  the DISTANCE_COLUMN of the vertex data with the result.
+ *
+ *  Vertices are kept in buckets of distance width delta, and the buckets are
+ *  settled in increasing order. Within a bucket, the light edges (weight
+ *  <= delta) of its vertices are relaxed in parallel until the bucket stops
+ *  changing; then the heavy edges of every vertex settled in the bucket are
+ *  relaxed once, since they can only reach later buckets. Each edge is
+ *  relaxed a few times instead of once per Bellman-Ford pass over the whole
+ *  graph. delta is the mean edge weight, which makes unweighted graphs a
+ *  parallel breadth first search.
+ */
+void csr_delta_stepping_sssp(sgraph& g) {
+  sgraph_compute::csr_snapshot csr(g, sgraph_compute::csr_direction::OUT,
+                                   UNIFORM_WEIGHTS ? "" : EDGE_WEIGHT_COLUMN);
+  typedef sgraph_compute::csr_snapshot::vertex_id_type vertex_id_type;
+  const size_t nvertices = csr.num_vertices();
+
+  // initial distances, as set up by check_and_init_graph
+  std::vector<std::atomic<double>> dist(nvertices);
+  {
+    auto init = g.fetch_vertex_data_field_in_memory(DISTANCE_COLUMN);
+    for (size_t p = 0; p < init.size(); ++p) {
+      for (size_t i = 0; i < init[p].size(); ++i) {
+        dist[csr.vertex_id(p, i)] = (double)init[p][i];
+      }
+    }
+  }
+
+  double delta = 1.0;
+  if (csr.has_weights() && csr.num_edges() > 0) {
+    double weight_sum = 0;
+    for (size_t v = 0; v < nvertices; ++v) {
+      const double* w = csr.out_weights(v);
+      for (size_t k = 0; k < csr.out_degree(v); ++k) weight_sum += w[k];
+    }
+    if (weight_sum > 0) delta = weight_sum / csr.num_edges();
+  }
+  auto edge_weight = [&](vertex_id_type v, size_t k) {
+    return csr.has_weights() ? csr.out_weights(v)[k] : 1.0;
+  };
+  auto bucket_of = [&](double d) { return (size_t)(d / delta); };
+
+  // buckets of vertices by distance; a vertex may be queued more than once,
+  // and stale entries (whose distance moved to an earlier bucket) are skipped.
+  std::map<size_t, std::vector<vertex_id_type>> buckets;
+  for (size_t v = 0; v < nvertices; ++v) {
+    if (dist[v] < MAX_DIST) buckets[bucket_of(dist[v])].push_back(v);
+  }
+
+  const size_t nthreads = thread_pool::get_instance().size() + 1;
+  std::vector<std::vector<vertex_id_type>> near_per_thread(nthreads);
+  std::vector<std::vector<std::pair<size_t, vertex_id_type>>> far_per_thread(nthreads);
+  std::vector<std::vector<vertex_id_type>> settled_per_thread(nthreads);
+
+  // Relaxes the light or heavy out edges of every vertex of vertices still in
+  // bucket b. Improved vertices which land in bucket b go to near_per_thread,
+  // the others to far_per_thread.
+  auto relax = [&](const std::vector<vertex_id_type>& vertices, size_t b, bool light) {
+    parallel_range_cursor cursor(0, vertices.size(), parallel_schedule::DYNAMIC, 256);
+    in_parallel([&](size_t thread_id, size_t num_threads) {
+      auto& near = near_per_thread[thread_id];
+      auto& far = far_per_thread[thread_id];
+      auto& settled = settled_per_thread[thread_id];
+      size_t chunk_begin, chunk_end;
+      while (cursor.next(chunk_begin, chunk_end)) {
+        for (size_t i = chunk_begin; i < chunk_end; ++i) {
+          vertex_id_type v = vertices[i];
+          double dv = dist[v].load(std::memory_order_relaxed);
+          if (light) {
+            if (bucket_of(dv) != b) continue;
+            settled.push_back(v);
+          }
+          const vertex_id_type* targets = csr.out_begin(v);
+          for (size_t k = 0; k < csr.out_degree(v); ++k) {
+            double w = edge_weight(v, k);
+            if ((w <= delta) != light) continue;
+            double nd = dv + w;
+            if (atomic_min(dist[targets[k]], nd)) {
+              size_t nb = bucket_of(nd);
+              if (nb == b) {
+                near.push_back(targets[k]);
+              } else {
+                far.emplace_back(nb, targets[k]);
+              }
+            }
+          }
+        }
+      }
+    });
+  };
+  auto move_far_to_buckets = [&]() {
+    for (auto& far : far_per_thread) {
+      for (auto& entry : far) buckets[entry.first].push_back(entry.second);
+      far.clear();
+    }
+  };
+
+  table_printer table({{"Buckets settled", 0}, {"Vertices settled", 0}});
+  table.print_header();
+  size_t num_buckets = 0;
+  size_t num_settled = 0;
+  while (!buckets.empty()) {
+    if(cppipc::must_cancel()) {
+      log_and_throw(std::string("Toolkit cancelled by user."));
+    }
+    size_t b = buckets.begin()->first;
+    std::vector<vertex_id_type> frontier = std::move(buckets.begin()->second);
+    buckets.erase(buckets.begin());
+
+    std::vector<vertex_id_type> settled;
+    while (!frontier.empty()) {
+      relax(frontier, b, true);
+      frontier.clear();
+      for (auto& near : near_per_thread) {
+        frontier.insert(frontier.end(), near.begin(), near.end());
+        near.clear();
+      }
+      move_far_to_buckets();
+    }
+    for (auto& s : settled_per_thread) {
+      settled.insert(settled.end(), s.begin(), s.end());
+      s.clear();
+    }
+    std::sort(settled.begin(), settled.end());
+    settled.erase(std::unique(settled.begin(), settled.end()), settled.end());
+    relax(settled, b, false);
+    move_far_to_buckets();
+
+    ++num_buckets;
+    num_settled += settled.size();
+    table.print_progress_row(num_buckets, num_buckets, num_settled);
+  }
+  table.print_row(num_buckets, num_settled);
+  table.print_footer();
+
+  std::vector<double> result(nvertices);
+  parallel_for(0, nvertices, [&](size_t v) { result[v] = dist[v]; });
+  auto distances = csr.split_by_partition(result);
+  g.add_vertex_field<double, flex_float>(distances, DISTANCE_COLUMN, flex_type_enum::FLOAT);
+}
+
 /**
  * Computes the shortest path distance from all vertices to the source vertex.
  * Add a new column named DISTANCE_COLUMN to the vertex data.
@@ -239,7 +398,12 @@ variant_map_type exec(variant_map_type& params) {
     g.select_edge_fields({sgraph::SRC_COLUMN_NAME, sgraph::DST_COLUMN_NAME});
   }
   //compute_sssp(g);
-  triple_apply_sssp(g);
+  if (sgraph_compute::csr_snapshot::fits_in_memory(g, sgraph_compute::csr_direction::OUT,
+                                                   !UNIFORM_WEIGHTS)) {
+    csr_delta_stepping_sssp(g);
+  } else {
+    triple_apply_sssp(g);
+  }
 
   std::shared_ptr<unity_sgraph> result_graph(new unity_sgraph(std::make_shared<sgraph>(g)));
 
@@ -9,6 +9,9 @@
 #include <model_server/lib/simple_model.hpp>
 #include <core/storage/sframe_interface/unity_sgraph.hpp>
 #include <core/storage/sgraph_data/sgraph_compute.hpp>
+#include <core/storage/sgraph_data/sgraph_csr.hpp>
+#include <core/storage/sgraph_data/sorted_intersection.hpp>
+#include <core/parallel/atomic.hpp>
 #include <core/storage/sframe_data/algorithm.hpp>
 #include <core/export.hpp>
 
@@ -76,6 +79,131 @@ size_t count_intersection(const flex_vec& sorted_v1, const flex_vec& sorted_v2)
   return ret;
 }
 
+/**************************************************************************/
+/*                                                                        */
+/*                  In Memory Triangle Counting (CSR)                     */
+/*                                                                        */
+/**************************************************************************/
+typedef sgraph_compute::csr_snapshot::vertex_id_type csr_vertex_id;
+
+/**
+ * Calls fn(u) on every neighbor u != v of v, ignoring edge directions, once
+ * per neighbor and in increasing order, by merging the sorted in and out
+ * neighbor lists of the snapshot.
+ */
+template <typename Fn>
+void for_each_undirected_neighbor(const sgraph_compute::csr_snapshot& csr,
+                                  csr_vertex_id v, Fn fn) {
+  const csr_vertex_id* out = csr.out_begin(v);
+  const csr_vertex_id* out_end = csr.out_end(v);
+  const csr_vertex_id* in = csr.in_begin(v);
+  const csr_vertex_id* in_end = csr.in_end(v);
+  bool has_last = false;
+  csr_vertex_id last = 0;
+  while (out != out_end || in != in_end) {
+    csr_vertex_id u;
+    if (in == in_end || (out != out_end && *out <= *in)) {
+      u = *out++;
+    } else {
+      u = *in++;
+    }
+    if (u == v || (has_last && u == last)) continue;
+    fn(u);
+    has_last = true;
+    last = u;
+  }
+}
+
+/**
+ * Counts the triangles of every vertex of g on an in memory snapshot.
+ *
+ * Every undirected edge is oriented from its lower ranked end to its higher
+ * ranked end, ranking vertices by degree (then id). A triangle is then found
+ * exactly once, from its lowest ranked vertex v, as a common higher ranked
+ * neighbor of v and of one of v's higher ranked neighbors; and since a vertex
+ * has at most O(sqrt(E)) higher ranked neighbors, hubs no longer make the
+ * intersections quadratic. The oriented neighbor lists are sorted arrays,
+ * intersected with \ref sgraph_compute::intersect_sorted().
+ *
+ * Adds the per vertex count to g as VERTEX_COUNT_COLUMN and returns the
+ * total number of triangles.
+ */
+size_t csr_triangle_count(sgraph& g) {
+  sgraph_compute::csr_snapshot csr(g, sgraph_compute::csr_direction::BOTH);
+  const size_t nvertices = csr.num_vertices();
+
+  std::vector<size_t> degree(nvertices);
+  parallel_for(0, nvertices, [&](size_t v) {
+    size_t d = 0;
+    for_each_undirected_neighbor(csr, v, [&](csr_vertex_id) { ++d; });
+    degree[v] = d;
+  });
+  auto ranks_higher = [&](csr_vertex_id u, csr_vertex_id v) {
+    return degree[u] > degree[v] || (degree[u] == degree[v] && u > v);
+  };
+
+  // the oriented neighbor lists, sorted by id
+  std::vector<size_t> offsets(nvertices + 1, 0);
+  parallel_for(0, nvertices, [&](size_t v) {
+    size_t d = 0;
+    for_each_undirected_neighbor(csr, v, [&](csr_vertex_id u) { d += ranks_higher(u, v); });
+    offsets[v + 1] = d;
+  });
+  for (size_t v = 0; v < nvertices; ++v) offsets[v + 1] += offsets[v];
+  std::vector<csr_vertex_id> neighbors(offsets[nvertices]);
+  parallel_for(0, nvertices, [&](size_t v) {
+    size_t pos = offsets[v];
+    for_each_undirected_neighbor(csr, v, [&](csr_vertex_id u) {
+      if (ranks_higher(u, v)) neighbors[pos++] = u;
+    });
+  });
+  degree.clear();
+  degree.shrink_to_fit();
+
+  if(cppipc::must_cancel()) {
+    log_and_throw(std::string("Toolkit cancelled by user."));
+  }
+
+  // vertices cost very different amounts, so take them in small chunks
+  std::vector<turi::atomic<size_t>> triangle_count(nvertices);
+  std::vector<size_t> total_per_thread(thread_pool::get_instance().size() + 1, 0);
+  parallel_range_cursor cursor(0, nvertices, parallel_schedule::DYNAMIC, 64);
+  in_parallel([&](size_t thread_id, size_t num_threads) {
+    std::vector<csr_vertex_id> common;
+    size_t total = 0;
+    size_t chunk_begin, chunk_end;
+    while (cursor.next(chunk_begin, chunk_end)) {
+      for (size_t v = chunk_begin; v < chunk_end; ++v) {
+        const csr_vertex_id* v_begin = neighbors.data() + offsets[v];
+        size_t v_size = offsets[v + 1] - offsets[v];
+        size_t v_triangles = 0;
+        for (size_t k = 0; k < v_size; ++k) {
+          csr_vertex_id u = v_begin[k];
+          size_t u_size = offsets[u + 1] - offsets[u];
+          common.resize(std::min(v_size, u_size));
+          size_t n = sgraph_compute::intersect_sorted(v_begin, v_size,
+                                                      neighbors.data() + offsets[u], u_size,
+                                                      common.data());
+          if (n == 0) continue;
+          v_triangles += n;
+          triangle_count[u].inc(n);
+          for (size_t c = 0; c < n; ++c) triangle_count[common[c]].inc();
+        }
+        if (v_triangles) triangle_count[v].inc(v_triangles);
+        total += v_triangles;
+      }
+    }
+    total_per_thread[thread_id] = total;
+  });
+
+  size_t total_triangles = 0;
+  for (size_t t : total_per_thread) total_triangles += t;
+  auto vertex_counts = csr.split_by_partition(triangle_count);
+  g.add_vertex_field<turi::atomic<size_t>, flex_int>(vertex_counts, VERTEX_COUNT_COLUMN,
+                                                     flex_type_enum::INTEGER);
+  return total_triangles;
+}
+
 /**************************************************************************/
 /*                                                                        */
 /*                    Triangle Counting Implementation                    */
@@ -178,6 +306,14 @@ void make_undirect_graph(sgraph& g) {
  */
 size_t compute_triangle_count(sgraph& g) {
   timer mytimer;
+  if (sgraph_compute::csr_snapshot::fits_in_memory(g)) {
+    logprogress_stream << "Counting triangles in memory..." << std::endl;
+    size_t total_triangles = csr_triangle_count(g);
+    logprogress_stream << "Finished in " << mytimer.current_time() << " secs." << std::endl;
+    logprogress_stream << "Total triangles in the graph : " << total_triangles << std::endl;
+    return total_triangles;
+  }
+
   logprogress_stream << "Initializing vertex ids." << std::endl;
   // add a unique integer id to each vertex at column INT_VID_COLUMN
   init_vertex_id(g);
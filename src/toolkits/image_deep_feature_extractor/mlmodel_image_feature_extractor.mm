@@ -12,6 +12,8 @@
 #include <core/logging/logger.hpp>
 #include <core/parallel/lambda_omp.hpp>
 #include <core/logging/table_printer/table_printer.hpp>
+#include <core/parallel/pthread_tools.hpp>
+#include <ml/neural_net/batch_pipeline.hpp>
 #include <model_server/lib/image_util.hpp>
 #include <toolkits/coreml_export/mlmodel_include.hpp>
 
@@ -368,21 +370,20 @@ mlmodel_image_feature_extractor::extract_features(gl_sarray data, bool verbose,
 
   BOOL use_only_cpu = (turi::fileio::NUM_GPUS == 0);
 
-  std::vector<flexible_type> result(data.size());
-
   mutex mut;
 
   table_printer table(
-        { {"Images Processed", 0}, {"Elapsed Time", 0}, {"Percent Complete", 0} }, 0);
+        { {"Images Processed", 0}, {"Elapsed Time", 0}, {"Images/Second", 0},
+          {"Percent Complete", 0} }, 0);
   if (verbose) {
     logprogress_stream << "Analyzing and extracting image features." << std::endl;
     table.print_header();
   }
 
-  // Lambda converting one flex_image from `data` into a MLFeatureProvider to
-  // feed into the CoreML model. Must be called inside an autorelease pool.
-  auto convert_image_to_feature_provider = [&](size_t i) {
-    flexible_type decoded_image = image_util::resize_image(data[i], model_info.input_width, model_info.input_height, 3, true);
+  // Lambda converting one flex_image into a MLFeatureProvider to feed into the
+  // CoreML model. Must be called inside an autorelease pool.
+  auto convert_image_to_feature_provider = [&](const flexible_type& raw_image) {
+    flexible_type decoded_image = image_util::resize_image(raw_image, model_info.input_width, model_info.input_height, 3, true);
     const flex_image& image = decoded_image.get<flex_image>();
     CVPixelBufferRef buffer = create_pixel_buffer_from_flex_image(image);
     MLFeatureValue* image_feature = [MLFeatureValue featureValueWithPixelBuffer:buffer];
@@ -396,10 +397,8 @@ mlmodel_image_feature_extractor::extract_features(gl_sarray data, bool verbose,
   };
 
   // Lambda converting one MLFeatureProvider output from the CoreML model into
-  // a flex_vec value, written to `result[i]`. Must be called inside an
-  // autorelease pool.
-  auto set_output_vector =
-      [&](size_t i, id<MLFeatureProvider> model_prediction) {
+  // a flex_vec value. Must be called inside an autorelease pool.
+  auto get_output_vector = [&](id<MLFeatureProvider> model_prediction) {
     MLFeatureValue* deep_features = [model_prediction featureValueForName: [NSString stringWithUTF8String: model_info.feature_layer_output_name.c_str()]];
     MLMultiArray* deep_features_values = [deep_features multiArrayValue];
 
@@ -429,21 +428,24 @@ mlmodel_image_feature_extractor::extract_features(gl_sarray data, bool verbose,
       size_t offset = j * stride;
       dest[j] = srcPtr[offset];
     }
-    result[i] = std::move(dest);
+    return dest;
   };
 
-  // Lambda performing feature extraction on one batch of images, writing the
-  // output into `results`. Must be called inside an autorelease pool.
-  auto perform_batch = [&](size_t batch_index) {
-    const size_t batch_offset = batch_index * kBatchSize;
-    const size_t batch_end = std::min(data.size(), batch_offset + kBatchSize);
-    const size_t batch_size = batch_end - batch_offset;
+  // Lambda performing feature extraction on one batch of images, returning
+  // one flex_vec per image.
+  auto perform_batch = [&](std::vector<flexible_type> images) {
+    std::vector<flexible_type> batch_result(images.size());
+
+    @autoreleasepool {
 
-    // Create the batch input for the CoreML model.
+    const size_t batch_size = images.size();
+
+    // Decode, resize and convert the images for the CoreML model.
     NSMutableArray<id<MLFeatureProvider>> *inputs =
         [NSMutableArray arrayWithCapacity:batch_size];
     for (size_t i = 0; i < batch_size; ++i) {
-      [inputs addObject: convert_image_to_feature_provider(batch_offset + i)];
+      [inputs addObject: convert_image_to_feature_provider(images[i])];
+      images[i] = FLEX_UNDEFINED;  // Release the encoded image early.
     }
     NSMutableArray<id<MLFeatureProvider>> *outputs =
         [NSMutableArray arrayWithCapacity:batch_size];
@@ -490,47 +492,80 @@ mlmodel_image_feature_extractor::extract_features(gl_sarray data, bool verbose,
 
     // Convert/copy the output of the CoreML model.
     for (size_t i = 0; i < batch_size; ++i) {
-      set_output_vector(batch_offset + i, outputs[i]);
+      batch_result[i] = get_output_vector(outputs[i]);
     }
-  };
 
-  // Submit batches in parallel, one for each CPU core, so that:
-  // - CoreML is busy all the time, assuming each core can prepare a batch
-  //   faster than CoreML can evaluate the other n - 1 batches.
-  // - Every core is busy, except when there is a backlog of batches.
-  // - The number of batches in flight is bounded (by the number of cores).
-  // - The worker threads do not contend or synchronize with one another, except
-  //   within CoreML and when joining at the very end.
-  std::atomic<size_t> batches_completed(0);
-  const size_t batch_count = (data.size() + kBatchSize - 1) / kBatchSize;
-  parallel_for(0, batch_count, [&](size_t batch_index) {
-    @autoreleasepool {
+    } // end autoreleasepool
 
-      perform_batch(batch_index);
-
-      // Only touch the atomic variable once per iteration
-      const size_t local_batches_completed = ++batches_completed;
-
-      if (verbose && local_batches_completed < batch_count) {
-        std::ostringstream d;
-        // For pretty printing, floor percent done
-        // resolution to the nearest .25% interval.  Do this by multiplying by
-        // 400, then do integer division by the total size, then float divide
-        // by 4.0
-        d << local_batches_completed * 400 / batch_count / 4.0 << '%';
-        table.print_progress_row(local_batches_completed,
-                                 local_batches_completed * kBatchSize,
-                                 progress_time(), d.str());
-      }
+    return batch_result;
+  };
 
-    } // end autoreleasepool
-  });
+  // Read the images in order, one batch at a time, streaming through the
+  // SArray instead of seeking to each row.
+  const size_t num_images = data.size();
+  size_t num_read = 0;
+  auto read_batch = [&](std::vector<flexible_type>* images) {
+    if (num_read == num_images) return false;
+    const size_t batch_end = std::min(num_images, num_read + kBatchSize);
+    images->clear();
+    images->reserve(batch_end - num_read);
+    for (const flexible_type& image : data.range_iterator(num_read, batch_end)) {
+      images->push_back(image);
+    }
+    num_read = batch_end;
+    return true;
+  };
+
+  // Process the batches on one worker per CPU core, so that:
+  // - CoreML is busy all the time, assuming each core can decode and prepare a
+  //   batch faster than CoreML can evaluate the other n - 1 batches.
+  // - Every core is busy, except when there is a backlog of batches.
+  // - The number of batches in flight is bounded by the queue depth, so the
+  //   memory used does not grow with the number of images.
+  // - The features are written out on this thread, in order, while the
+  //   workers go on with the next batches.
+  neural_net::batch_pipeline<std::vector<flexible_type>,
+                             std::vector<flexible_type>>::options opts;
+  opts.num_workers = thread::cpu_count();
+  opts.queue_depth = 2 * opts.num_workers;
+  neural_net::batch_pipeline<std::vector<flexible_type>,
+                             std::vector<flexible_type>>
+      pipeline(read_batch, perform_batch, opts);
+
+  gl_sarray_writer writer(flex_type_enum::VECTOR, 1);
+  const size_t batch_count = (num_images + kBatchSize - 1) / kBatchSize;
+  size_t batches_completed = 0;
+  size_t images_completed = 0;
+  std::vector<flexible_type> features;
+  while (pipeline.next(&features)) {
+    for (flexible_type& f : features) {
+      writer.write(std::move(f), 0);
+    }
+    images_completed += features.size();
+    ++batches_completed;
+
+    if (verbose && batches_completed < batch_count) {
+      std::ostringstream d;
+      // For pretty printing, floor percent done
+      // resolution to the nearest .25% interval.  Do this by multiplying by
+      // 400, then do integer division by the total size, then float divide
+      // by 4.0
+      d << batches_completed * 400 / batch_count / 4.0 << '%';
+      double elapsed = table.elapsed_time();
+      table.print_progress_row(batches_completed, images_completed,
+                               progress_time(),
+                               elapsed > 0 ? images_completed / elapsed : 0.0,
+                               d.str());
+    }
+  }
 
   if (verbose) {
-    table.print_row(data.size(), progress_time(), "100%");
+    double elapsed = table.elapsed_time();
+    table.print_row(num_images, progress_time(),
+                    elapsed > 0 ? num_images / elapsed : 0.0, "100%");
     table.print_footer();
   }
-  return gl_sarray(result, flex_type_enum::VECTOR);
+  return writer.close();
 }
 
 } // namespace image_deep_feature_extractor
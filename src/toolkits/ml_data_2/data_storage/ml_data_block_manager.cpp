@@ -5,6 +5,7 @@
  */
 #include <toolkits/ml_data_2/data_storage/ml_data_block_manager.hpp>
 #include <toolkits/ml_data_2/ml_data.hpp>
+#include <algorithm>
 
 namespace turi { namespace v2 { namespace ml_data_internal {
 
@@ -29,6 +30,61 @@ ml_data_block_manager::ml_data_block_manager(
   }
 }
 
+/** Stops the background loading.
+ */
+ml_data_block_manager::~ml_data_block_manager() {
+  {
+    std::lock_guard<turi::mutex> guard(cache_lock);
+    prefetch_stopping = true;
+    prefetch_cond.notify_all();
+  }
+  if(prefetch_thread.joinable()) prefetch_thread.join();
+}
+
+/** The memory held by a block, roughly.
+ */
+static size_t block_memory(const ml_data_block& block) {
+  size_t ret = block.translated_rows.entry_data.size() * sizeof(entry_value)
+      + block.translated_rows.additional_data.size() * sizeof(flexible_type);
+  for(const auto& c : block.untranslated_columns) {
+    ret += c.size() * sizeof(flexible_type);
+  }
+  return ret;
+}
+
+/** Reads a block from disk.
+ */
+std::shared_ptr<ml_data_block> ml_data_block_manager::load_block(size_t block_index) {
+
+  std::vector<row_data_block> row_block_buffer;
+
+  data_reader->read_rows(block_index, block_index + 1, row_block_buffer);
+
+  ////////////////////////////////////////////////////////////
+  // Step 1.1: Do we have any untranslated columns?
+
+  std::vector<std::vector<flexible_type> >
+      untranslated_column_buffers(untranslated_column_readers.size());
+
+  if(!untranslated_column_buffers.empty()) {
+
+    // Fill out the untranslated column buffers
+    size_t row_start_idx = block_index * row_block_size;
+    size_t row_end_idx = (block_index + 1) * row_block_size;
+
+    for(size_t i = 0; i < untranslated_column_readers.size(); ++i) {
+      untranslated_column_readers[i]->read_rows(
+          row_start_idx, row_end_idx, untranslated_column_buffers[i]);
+    }
+  }
+
+  return std::shared_ptr<ml_data_block>(
+      new ml_data_block{metadata,
+            rm,
+            std::move(row_block_buffer[0]),
+            std::move(untranslated_column_buffers)});
+}
+
 /** Returns a block corresponding to the block index.  Loads from
  *  disk if not in cache.
  */
@@ -53,6 +109,11 @@ std::shared_ptr<ml_data_block> ml_data_block_manager::get_block(size_t block_ind
     }
   }
 
+  // If the block is being loaded in the background, wait for it.
+  while(block_being_prefetched == block_index) {
+    prefetch_cond.wait(guard);
+  }
+
   auto it = row_block_cache.find(block_index);
   std::shared_ptr<ml_data_block> ret;
 
@@ -66,6 +127,22 @@ std::shared_ptr<ml_data_block> ml_data_block_manager::get_block(size_t block_ind
     }
   }
 
+  // Take it from the prefetched blocks if it is there.  It then lives
+  // as long as the iterators using it, like any other block.  A
+  // prefetched copy of a block found in cache is dropped.
+  auto p_it = prefetched_blocks.find(block_index);
+
+  if(p_it != prefetched_blocks.end()) {
+    prefetched_bytes -= std::min(prefetched_bytes, block_memory(*p_it->second));
+
+    if(ret == nullptr) {
+      ret = std::move(p_it->second);
+      row_block_cache[block_index] = ret;
+    }
+
+    prefetched_blocks.erase(p_it);
+  }
+
   // It's not in cache, so create it.
   if(ret == nullptr) {
 
@@ -74,33 +151,7 @@ std::shared_ptr<ml_data_block> ml_data_block_manager::get_block(size_t block_ind
     guard.unlock();
 
     // Need to instantiate it.
-    std::vector<row_data_block> row_block_buffer;
-
-    data_reader->read_rows(block_index, block_index + 1, row_block_buffer);
-
-    ////////////////////////////////////////////////////////////
-    // Step 1.1: Do we have any untranslated columns?
-
-    std::vector<std::vector<flexible_type> >
-        untranslated_column_buffers(untranslated_column_readers.size());
-
-    if(!untranslated_column_buffers.empty()) {
-
-      // Fill out the untranslated column buffers
-      size_t row_start_idx = block_index * row_block_size;
-      size_t row_end_idx = (block_index + 1) * row_block_size;
-
-      for(size_t i = 0; i < untranslated_column_readers.size(); ++i) {
-        untranslated_column_readers[i]->read_rows(
-            row_start_idx, row_end_idx, untranslated_column_buffers[i]);
-      }
-    }
-
-    ret.reset(new ml_data_block
-              {metadata,
-                    rm,
-                    std::move(row_block_buffer[0]),
-                    std::move(untranslated_column_buffers)});
+    ret = load_block(block_index);
 
     // Reaquire the lock on the cache.
     guard.lock();
@@ -128,4 +179,95 @@ std::shared_ptr<ml_data_block> ml_data_block_manager::get_block(size_t block_ind
   return ret;
 }
 
+/** Queues blocks for loading in the background.
+ */
+void ml_data_block_manager::prefetch_blocks(size_t block_begin, size_t block_end) {
+
+  if(ML_DATA_PREFETCH_BLOCKS == 0 || block_begin >= block_end) {
+    return;
+  }
+
+  std::lock_guard<turi::mutex> guard(cache_lock);
+
+  if(prefetch_stopping || prefetched_bytes >= ML_DATA_PREFETCH_MEMORY_BUDGET) {
+    return;
+  }
+
+  bool queued = false;
+
+  for(size_t block_index = block_begin; block_index < block_end; ++block_index) {
+    if(block_index == block_being_prefetched
+       || prefetched_blocks.count(block_index)
+       || std::find(prefetch_queue.begin(), prefetch_queue.end(), block_index)
+           != prefetch_queue.end()) {
+      continue;
+    }
+
+    auto it = row_block_cache.find(block_index);
+    if(it != row_block_cache.end() && !it->second.expired()) {
+      continue;
+    }
+
+    prefetch_queue.push_back(block_index);
+    queued = true;
+  }
+
+  if(!queued) {
+    return;
+  }
+
+  if(!prefetch_thread.joinable()) {
+    prefetch_thread = std::thread([this]() { this->prefetch_loop(); });
+  }
+
+  prefetch_cond.notify_all();
+}
+
+/** The loop of the background loading thread.
+ */
+void ml_data_block_manager::prefetch_loop() {
+
+  std::unique_lock<turi::mutex> guard(cache_lock);
+
+  while(true) {
+    while(!prefetch_stopping && prefetch_queue.empty()) {
+      prefetch_cond.wait(guard);
+    }
+
+    if(prefetch_stopping) {
+      return;
+    }
+
+    size_t block_index = prefetch_queue.front();
+    prefetch_queue.pop_front();
+
+    if(prefetched_blocks.count(block_index)
+       || prefetched_bytes >= ML_DATA_PREFETCH_MEMORY_BUDGET) {
+      continue;
+    }
+
+    block_being_prefetched = block_index;
+    guard.unlock();
+
+    std::shared_ptr<ml_data_block> block;
+
+    try {
+      block = load_block(block_index);
+    } catch(...) {
+      // Any error is raised again when an iterator loads the block
+      // itself.
+    }
+
+    guard.lock();
+    block_being_prefetched = size_t(-1);
+
+    if(block != nullptr) {
+      prefetched_bytes += block_memory(*block);
+      prefetched_blocks[block_index] = std::move(block);
+    }
+
+    prefetch_cond.notify_all();
+  }
+}
+
 }}}
@@ -7,6 +7,19 @@
 #define TURI_ML_DATA_BLOCK_MANAGER_H_
 
 #include <toolkits/ml_data_2/data_storage/ml_data_row_format.hpp>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+namespace turi {
+
+/** Prefetching settings, shared with ml/ml_data; see
+ *  ml/ml_data/data_storage/ml_data_block_manager.hpp.
+ */
+extern size_t ML_DATA_PREFETCH_BLOCKS;
+extern size_t ML_DATA_PREFETCH_MEMORY_BUDGET;
+
+}
 
 
 namespace turi { namespace v2 { namespace ml_data_internal {
@@ -53,6 +66,17 @@ class ml_data_block_manager {
    */
   std::shared_ptr<ml_data_block> get_block(size_t block_index);
 
+  /** Loads the blocks [block_begin, block_end) on a background thread,
+   *  so that get_block() finds them loaded.  Blocks already loaded or
+   *  queued are skipped, and nothing is queued while the prefetched
+   *  blocks not yet read hold ML_DATA_PREFETCH_MEMORY_BUDGET bytes.
+   */
+  void prefetch_blocks(size_t block_begin, size_t block_end);
+
+  /** Stops the background loading.
+   */
+  ~ml_data_block_manager();
+
  private:
 
   /**  The metadata associated with the current block.
@@ -91,6 +115,33 @@ class ml_data_block_manager {
    */
   std::map<size_t, std::weak_ptr<ml_data_block> > row_block_cache;
 
+  /** Reads a block from disk.
+   */
+  std::shared_ptr<ml_data_block> load_block(size_t block_index);
+
+  /** The loop of the background loading thread.
+   */
+  void prefetch_loop();
+
+  /** Blocks to be loaded in the background, in order.  All the
+   *  prefetching state is guarded by cache_lock.
+   */
+  std::deque<size_t> prefetch_queue;
+
+  /** Blocks loaded in the background and not yet returned by
+   *  get_block(), and the memory they take.
+   */
+  std::map<size_t, std::shared_ptr<ml_data_block> > prefetched_blocks;
+  size_t prefetched_bytes = 0;
+
+  /** The block the background thread is loading, or -1.
+   */
+  size_t block_being_prefetched = size_t(-1);
+
+  std::condition_variable_any prefetch_cond;
+  std::thread prefetch_thread;
+  bool prefetch_stopping = false;
+
 };
 
 }}}
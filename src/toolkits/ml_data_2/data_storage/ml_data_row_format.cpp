@@ -7,6 +7,7 @@
 #include <toolkits/ml_data_2/ml_data.hpp>
 #include <toolkits/ml_data_2/metadata.hpp>
 #include <core/globals/globals.hpp>
+#include <ml/ml_data/data_storage/entry_data_codec.hpp>
 #include <cstdint>
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -17,6 +18,39 @@ size_t ML_DATA_TARGET_ROW_BYTE_MINIMUM = 64*1024;
 
 REGISTER_GLOBAL(int64_t, ML_DATA_TARGET_ROW_BYTE_MINIMUM, true);
 
+/** Written in place of the number of entries, which blocks stored as
+ *  plain arrays start with, to mark a block in the compact format.
+ */
+static const size_t COMPACT_ROW_BLOCK_MARKER = 0xc3a5c85c97cb3127ULL;
+
+void row_data_block::load(turi::iarchive& iarc) {
+  size_t header;
+  iarc >> header;
+
+  if(header == COMPACT_ROW_BLOCK_MARKER) {
+    size_t version;
+    iarc >> version;
+    turi::ml_data_internal::load_entry_data(iarc, entry_data, version);
+  } else {
+    // A plain array of header entries.
+    entry_data.resize(header);
+    turi::deserialize(iarc, entry_data.data(), header * sizeof(entry_value));
+  }
+
+  iarc >> additional_data;
+}
+
+void row_data_block::save(turi::oarchive& oarc) const {
+  size_t version = turi::ml_data_internal::ENTRY_DATA_CODEC_VERSION;
+  oarc << COMPACT_ROW_BLOCK_MARKER << version;
+
+  turi::ml_data_internal::save_entry_data(
+      oarc, reinterpret_cast<const uint64_t*>(entry_data.data()),
+      entry_data.size(), version);
+
+  oarc << additional_data;
+}
+
 /** Translates the raw flexible_type data in column_buffer into a
  *  block of rows, indexing it through the metadata classes.  The
  *  output format is described in ml_data.hpp.
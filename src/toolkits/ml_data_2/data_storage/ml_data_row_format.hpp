@@ -162,13 +162,12 @@ struct row_data_block {
   std::vector<entry_value> entry_data;
   std::vector<flexible_type> additional_data;
 
-  void load(turi::iarchive& iarc) {
-    iarc >> entry_data >> additional_data;
-  }
-
-  void save(turi::oarchive& oarc) const {
-    oarc << entry_data << additional_data;
-  }
+  /** Blocks are stored in the compact format of
+   *  ml/ml_data/data_storage/entry_data_codec.hpp; blocks stored as
+   *  plain arrays of entries by earlier versions are still read.
+   */
+  void load(turi::iarchive& iarc);
+  void save(turi::oarchive& oarc) const;
 
 };
 
@@ -0,0 +1,79 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <toolkits/ml_data_2/indexing/column_hash_indexer.hpp>
+#include <core/storage/serialization/serialization_includes.hpp>
+
+namespace turi { namespace v2 { namespace ml_data_internal {
+
+column_hash_indexer::column_hash_indexer()
+{}
+
+void column_hash_indexer::initialize() {
+  if(hash_buckets != 0)
+    return;
+
+  flex_int n_buckets = 0;
+  if(options.count("column_indexer_hash_buckets"))
+    n_buckets = options.at("column_indexer_hash_buckets");
+
+  if(n_buckets <= 0) {
+    log_and_throw("column_indexer_hash_buckets must be positive with the hash indexer.");
+  }
+
+  hash_buckets = n_buckets;
+}
+
+flexible_type column_hash_indexer::map_index_to_value(size_t idx) const {
+  DASSERT_LT(idx, hash_buckets);
+  return flex_int(idx);
+}
+
+std::set<flex_type_enum> column_hash_indexer::extract_key_types() const {
+  return {flex_type_enum::INTEGER};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Serialization routines
+
+size_t column_hash_indexer::get_version() const {
+  return 1;
+}
+
+void column_hash_indexer::save_impl(turi::oarchive& oarc) const {
+  oarc << hash_buckets;
+}
+
+void column_hash_indexer::load_version(turi::iarchive& iarc, size_t version) {
+  ASSERT_TRUE(version == 1);
+  iarc >> hash_buckets;
+}
+
+std::function<flexible_type(const flexible_type&)> column_hash_indexer::deindexing_lambda() const {
+  return [this](const flexible_type& v) -> flexible_type {
+    DASSERT_EQ(v.get_type(), flex_type_enum::INTEGER);
+    return this->map_index_to_value(v.get<flex_int>());
+  };
+}
+
+std::function<flexible_type(const flexible_type&)> column_hash_indexer::indexing_lambda() const {
+  return [this](const flexible_type& v) -> flexible_type {
+    return flexible_type(flex_int(this->immutable_map_value_to_index(v)));
+  };
+}
+
+std::vector<flexible_type> column_hash_indexer::reset_and_return_values() {
+  return {};
+}
+
+void column_hash_indexer::set_values(std::vector<flexible_type>&& values) {
+  ASSERT_MSG(values.empty(), "Values cannot be set on a hashed column.");
+}
+
+std::shared_ptr<column_indexer> column_hash_indexer::create_cleared_copy() const {
+  return std::make_shared<column_hash_indexer>(*this);
+}
+
+}}}
@@ -0,0 +1,135 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_ML2_DATA_HASH_COLUMN_INDEXER_H_
+#define TURI_ML2_DATA_HASH_COLUMN_INDEXER_H_
+
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/util/hash_value.hpp>
+#include <core/util/cityhash_tc.hpp>
+#include <core/logging/assertions.hpp>
+#include <core/storage/serialization/serialization_includes.hpp>
+#include <toolkits/ml_data_2/indexing/column_indexer.hpp>
+
+namespace turi { namespace v2 { namespace ml_data_internal {
+
+/**
+ * An indexer that maps each value to one of a fixed number of
+ * indices by its hash, set by the "column_indexer_hash_buckets"
+ * option.  Nothing is stored per value, so the metadata is constant
+ * size and translating new data never adds to it.  Distinct values
+ * may share an index, and an index maps back only to its bucket
+ * number.
+ */
+class column_hash_indexer final : public column_indexer {
+
+ public:
+
+  column_hash_indexer();
+
+  /** Reads the number of buckets from the options.
+   */
+  void initialize();
+
+  /** Returns the bucket of the "feature" value.
+   *
+   * This method is threadsafe.
+   */
+  size_t map_value_to_index(size_t thread_idx, const flexible_type& feature) GL_HOT {
+    return immutable_map_value_to_index(feature);
+  }
+
+  /** Returns the bucket of the "feature" value.  Never size_t(-1),
+   *  as every value has a bucket.
+   */
+  size_t immutable_map_value_to_index(const flexible_type& feature) const GL_HOT {
+
+    DASSERT_TRUE(
+        mode == ml_column_mode::CATEGORICAL
+        || mode == ml_column_mode::CATEGORICAL_VECTOR
+        || mode == ml_column_mode::DICTIONARY);
+
+    DASSERT_NE(hash_buckets, 0);
+
+    // Check value
+    if( ! (feature.get_type() == flex_type_enum::STRING
+           || feature.get_type() == flex_type_enum::INTEGER
+           || feature.get_type() == flex_type_enum::UNDEFINED) ) {
+
+      log_and_throw(std::string("Value encountered in column '")
+                    + column_name + "' is of type '"
+                    + flex_type_enum_to_name(feature.get_type()) +
+                    "' cannot be mapped to a categorical value." +
+                    " Categorical values must be integer, strings, or None.");
+    }
+
+    return hash64(hash_value(feature).hash()) % hash_buckets;
+  }
+
+  /** Nothing is indexed, so nothing needs to be seen ahead of
+   *  translation.
+   */
+  bool indexes_values() const { return false; }
+
+  /** Call this when all calls to map_value_to_index are completed.
+   */
+  void finalize() {}
+
+  /** Returns the bucket number; the values themselves are not kept.
+   */
+  flexible_type map_index_to_value(size_t idx) const;
+
+  /** The buckets are integers.
+   */
+  std::set<flex_type_enum> extract_key_types() const;
+
+  /** Returns the number of buckets.
+   */
+  inline size_t indexed_column_size() const {
+    return hash_buckets;
+  }
+
+  /** Returns the current version used for the serialization.
+   */
+  size_t get_version() const;
+
+  /**
+   *  Serialize the object (save).
+   */
+  void save_impl(turi::oarchive& oarc) const;
+
+  /**
+   *  Load the object.
+   */
+  void load_version(turi::iarchive& iarc, size_t version);
+
+  /** There are no values to set; only an empty list is accepted.
+   */
+  void set_values(std::vector<flexible_type>&& values);
+
+  std::vector<flexible_type> reset_and_return_values();
+
+  /** Create a copy with the index cleared.
+   */
+  std::shared_ptr<column_indexer> create_cleared_copy() const;
+
+  /** Returns a lambda function that can be used as a lambda function for deindexing
+   *  a column.
+   */
+  std::function<flexible_type(const flexible_type&)> deindexing_lambda() const;
+
+  /** Returns a lambda function that can be used as a lambda function for indexing
+   *  a column.
+   */
+  std::function<flexible_type(const flexible_type&)> indexing_lambda() const;
+
+ private:
+
+  size_t hash_buckets = 0;
+};
+
+}}}
+
+#endif
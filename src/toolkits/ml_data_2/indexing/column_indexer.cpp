@@ -6,6 +6,7 @@
 #include <toolkits/ml_data_2/indexing/column_indexer.hpp>
 
 #include <toolkits/ml_data_2/indexing/column_unique_indexer.hpp>
+#include <toolkits/ml_data_2/indexing/column_hash_indexer.hpp>
 
 #include <core/storage/serialization/serialization_includes.hpp>
 #include <core/storage/sframe_data/sframe.hpp>
@@ -21,8 +22,9 @@ namespace turi { namespace v2 { namespace ml_data_internal {
  *  "unique_indexer" : An indexer in which each value is mapped to a
  *  unique index.  After mapping the values,
  *
- *  "hash_indexer" : An indexer in which each index is simply a 64 bit
- *  hash.  THIS WILL BE IMPLEMENTED IN A LATER PULL REQUEST.
+ *  "hash" : An indexer in which each value is mapped to one of
+ *  column_indexer_hash_buckets indices by its hash.  Nothing is stored
+ *  per value.
  *
  *  To create a new indexer, simply have it inherit COMMENT.
  *
@@ -55,6 +57,8 @@ std::shared_ptr<column_indexer> column_indexer::factory_create(
 
   if(indexer_type == "unique") {
     m.reset(new column_unique_indexer);
+  } else if(indexer_type == "hash") {
+    m.reset(new column_hash_indexer);
   } else {
     ASSERT_MSG(false, (indexer_type + " is not a valid type of indexer.").c_str());
   }
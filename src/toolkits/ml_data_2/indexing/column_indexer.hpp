@@ -80,6 +80,19 @@ class column_indexer {
    */
   virtual void insert_values_into_index(const std::vector<flexible_type>& features) {};
 
+  /** Declares that every value map_value_to_index will be called
+   *  with until finalize() is already in the index, for instance after
+   *  build_column_index_in_parallel.  Indexers may then look values
+   *  up without taking any locks.
+   */
+  void set_all_values_indexed(bool v) { all_values_indexed = v; }
+
+  /** True if map_value_to_index may add new values to the index.
+   *  Indexers whose indices depend only on the value, like the hash
+   *  indexer, need not see the data ahead of translation.
+   */
+  virtual bool indexes_values() const { return true; }
+
   /** Call this when all calls to map_value_to_index are completed.
    */
   virtual void finalize() = 0;
@@ -186,6 +199,12 @@ class column_indexer {
    */
   std::map<std::string, flexible_type> options;
 
+ protected:
+
+  /** Set between initialize() and finalize() when no value is new.
+   */
+  bool all_values_indexed = false;
+
  private:
 
   /** A snapshot of the options needed for creating the class.
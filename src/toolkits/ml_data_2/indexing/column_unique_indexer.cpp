@@ -24,10 +24,6 @@ void column_unique_indexer::initialize() {
 
   DASSERT_TRUE(values_by_index_threadlocal_accumulator.empty());
 
-  // Init the lookup tables.
-  index_by_values_lookup.resize(
-      1 << _column_unique_indexer_first_level_lookup_size_n_bits);
-
   size_t num_threads = thread::cpu_count();
 
   // Initialize the value trackers
@@ -55,6 +51,7 @@ void column_unique_indexer::finalize() {
   }
 
   values_by_index_threadlocal_accumulator.clear();
+  all_values_indexed = false;
   index_modification_lock.unlock();
 }
 
@@ -95,27 +92,20 @@ size_t column_unique_indexer::map_value_to_index(size_t thread_idx, const flexib
 
   hash_value wt(feature);
 
-  // Lock the first level
-  size_t first_index = wt.n_bit_index(_column_unique_indexer_first_level_lookup_size_n_bits);
-  DASSERT_LT(first_index, index_by_values_lookup.size());
-  auto& lock_ht_pair = index_by_values_lookup[first_index];
-
-  lock_ht_pair.first.lock();
-  auto it = lock_ht_pair.second.find(wt);
-
-  size_t index;
-
-  if(it == lock_ht_pair.second.end()) {
-    index = (++_column_size) - 1;
-    values_by_index_threadlocal_accumulator[thread_idx].push_back({index, feature});
-    lock_ht_pair.second[wt] = index;
-  } else {
-    index = it->second;
+  // Once every value is in the index, nothing is inserted; look the
+  // value up without locking its shard.
+  if(all_values_indexed) {
+    size_t index;
+    if(LIKELY(index_by_values_lookup.find_unlocked(wt, index)))
+      return index;
+    DASSERT_MSG(false, "Value missing from a column marked as fully indexed.");
   }
 
-  lock_ht_pair.first.unlock();
-
-  return index;
+  return index_by_values_lookup.find_or_insert(wt, [&]() {
+      size_t index = (++_column_size) - 1;
+      values_by_index_threadlocal_accumulator[thread_idx].push_back({index, feature});
+      return index;
+    }).first;
 }
 
 /** Returns the index associated with the "feature" value.
@@ -153,22 +143,13 @@ size_t column_unique_indexer::immutable_map_value_to_index(
 
   hash_value wt(feature);
 
-  // Lock the first level
-  size_t first_index = wt.n_bit_index(_column_unique_indexer_first_level_lookup_size_n_bits);
-  DASSERT_LT(first_index, index_by_values_lookup.size());
-  auto& lock_ht_pair = index_by_values_lookup[first_index];
-
-  auto it = lock_ht_pair.second.find(wt);
-
-  if(it == lock_ht_pair.second.end()) {
-
+  size_t index;
+  if(index_by_values_lookup.find_unlocked(wt, index)) {
+    // Value found. Returning the index.
+    return index;
+  } else {
     // Value not found.
     return (size_t)(-1);
-
-  } else {
-
-    // Value found. Returning the index.
-    return it->second;
   }
 }
 
@@ -355,9 +336,7 @@ void column_unique_indexer::set_values(std::vector<flexible_type>&& values) {
      || mode == ml_column_mode::CATEGORICAL_VECTOR
      || mode == ml_column_mode::DICTIONARY) {
 
-    // Set the first level of the index_by_values hash lookup
     index_by_values_lookup.clear();
-    index_by_values_lookup.resize(1 << _column_unique_indexer_first_level_lookup_size_n_bits);
 
 
     // Fill the hash table map with the loaded list of values
@@ -366,16 +345,8 @@ void column_unique_indexer::set_values(std::vector<flexible_type>&& values) {
         size_t end_idx = ((thread_idx + 1) * values_by_index_lookup.size()) / num_threads;
 
         for(size_t i = start_idx; i < end_idx; ++i) {
-          hash_value wt(values_by_index_lookup[i]);
-
-          // Lock the first level
-          size_t first_index = wt.n_bit_index(_column_unique_indexer_first_level_lookup_size_n_bits);
-          DASSERT_LT(first_index, index_by_values_lookup.size());
-          auto& lock_ht_pair = index_by_values_lookup[first_index];
-
-          lock_ht_pair.first.lock();
-          lock_ht_pair.second[wt] = i;
-          lock_ht_pair.first.unlock();
+          index_by_values_lookup.insert_or_assign(
+              hash_value(values_by_index_lookup[i]), i);
         }
       });
   }
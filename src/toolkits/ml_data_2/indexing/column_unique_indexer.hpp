@@ -11,21 +11,12 @@
 #include <core/logging/assertions.hpp>
 #include <core/util/bitops.hpp>
 #include <core/storage/serialization/serialization_includes.hpp>
-#include <core/generics/hopscotch_map.hpp>
+#include <core/generics/concurrent_hash_map.hpp>
 #include <core/parallel/pthread_tools.hpp>
 #include <toolkits/ml_data_2/indexing/column_indexer.hpp>
 
 namespace turi { namespace v2 { namespace ml_data_internal {
 
-/**  Use a two-level hash table to store the index mappings.  The
- *  first level is constant size and unlocked, determined by an n-bit
- *  hash.  Each leaf in this one contains a hash table and lock.  This
- *  significantly reduces lock contention.  This
- *  _column_metadata_first_level_lookup_size_n_bits gives the number
- *  of bits used for this first lookup.
- */
-static constexpr int _column_unique_indexer_first_level_lookup_size_n_bits = 8;
-
 /**
  * column_metadata contains "meta data" concerning indexing of a single column
  * of an SFrame. A collection of meta_data column objects is "all" the
@@ -179,8 +170,10 @@ class column_unique_indexer final : public column_indexer {
 
  private:
 
-  std::vector<std::pair<simple_spinlock, hopscotch_map<hash_value, size_t> > >
-  index_by_values_lookup;
+  /** The index of every value, sharded so that threads indexing
+   *  different values rarely wait on each other.
+   */
+  concurrent_hash_map<hash_value, size_t> index_by_values_lookup;
 
   std::vector<std::vector<std::pair<size_t, flexible_type> > >
   values_by_index_threadlocal_accumulator;
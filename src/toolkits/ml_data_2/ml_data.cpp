@@ -11,6 +11,7 @@
 #include <toolkits/ml_data_2/side_features.hpp>
 #include <toolkits/ml_data_2/data_storage/util.hpp>
 #include <model_server/lib/variant_deep_serialize.hpp>
+#include <ml/ml_data/ml_data_cache.hpp>
 
 using namespace turi::v2::ml_data_internal;
 
@@ -191,6 +192,40 @@ void ml_data::fill() {
   ASSERT_MSG(incoming_data != nullptr,
              "fill called out of order; cannot be called twice or after load().");
 
+  ////////////////////////////////////////////////////////////////////////////////
+  // Step 0.  A training fill of data filled the same way before is taken
+  // from the cache.
+
+  std::unique_ptr<ml_data_cache_key> cache_key;
+
+  if(_metadata == nullptr && ML_DATA_CACHE_CAPACITY != 0) {
+    cache_key.reset(new ml_data_cache_key("ml_data_2"));
+    cache_key->add_data(incoming_data->data);
+    cache_key->add(incoming_data->target_column_name);
+    cache_key->add(incoming_data->column_ordering);
+    cache_key->add(incoming_data->options);
+    for(const auto& p : incoming_data->mode_overrides) {
+      cache_key->add(p.first);
+      cache_key->add(int(p.second));
+    }
+    for(const auto& side : incoming_data->incoming_side_features) {
+      cache_key->add_data(side.data);
+      cache_key->add(side.forced_join_column);
+      for(const auto& p : side.mode_overrides) {
+        cache_key->add(p.first);
+        cache_key->add(int(p.second));
+      }
+    }
+
+    auto cached = ml_data_cache::get_instance().lookup<ml_data>(*cache_key);
+    if(cached != nullptr) {
+      logstream(LOG_INFO) << "Reusing cached ml_data." << std::endl;
+      incoming_data.reset();
+      *this = cached->_copy_with_independent_metadata();
+      return;
+    }
+  }
+
   ////////////////////////////////////////////////////////////////////////////////
   // Step 1.  Set up the metadata if need be.
 
@@ -396,6 +431,15 @@ void ml_data::fill() {
   if(sort_by_first_two_columns)
     _sort_user_item_data_blocks();
 
+  ////////////////////////////////////////////////////////////////////////////////
+  // Step 10.  Store the result for the next identical fill.
+
+  // Untranslated columns refer to the source columns, which would then
+  // never be released, so those fills are not stored.
+  if(cache_key != nullptr && untranslated_columns.empty()) {
+    ml_data_cache::get_instance().insert<ml_data>(
+        *cache_key, std::make_shared<ml_data>(_copy_with_independent_metadata()));
+  }
 }
 
 /**
@@ -859,6 +903,36 @@ std::vector<flexible_type> ml_data::translate_row_to_original(const SparseVector
   return ml_data_internal::translate_row_to_original(metadata(), v);
 }
 
+/** Returns a copy sharing the data, but with its own copy of the metadata,
+ *  which a later fill can modify.
+ */
+ml_data ml_data::_copy_with_independent_metadata() const {
+  ml_data ret(*this);
+
+  std::stringstream strm;
+  {
+    turi::oarchive oarc(strm);
+    _metadata->save(oarc);
+  }
+  ret._metadata = std::make_shared<ml_metadata>();
+  {
+    turi::iarchive iarc(strm);
+    ret._metadata->load(iarc);
+  }
+  ret.side_features = ret._metadata->side_features;
+
+  // The row metadata refers to the column metadata, with the target last.
+  for(size_t c_idx = 0; c_idx < ret.rm.metadata_vect.size(); ++c_idx) {
+    ret.rm.metadata_vect[c_idx] =
+        (c_idx < ret._metadata->columns.size()
+         ? ret._metadata->columns[c_idx]
+         : ret._metadata->target);
+  }
+
+  ret._create_block_manager();
+  return ret;
+}
+
 /** Convenience function to create the block manager given the current
  *  data in the model.
  */
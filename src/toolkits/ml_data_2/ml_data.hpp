@@ -346,9 +346,17 @@ class ml_data_block_manager;
  * - "column_indexer_type".
  *
  *   Gives the type of the indexer to use on the columns (default =
- *   "unique").  Currently, only "unique" is available, but "hash" will
- *   be supported in the future.  (See Extending Column Indexing below to
- *   create your own indexer).
+ *   "unique").  With "unique", each distinct value gets its own index.
+ *   With "hash", each value is mapped to one of
+ *   "column_indexer_hash_buckets" indices by its hash; the metadata is
+ *   then constant size and never grows, but distinct values may share
+ *   an index.  (See Extending Column Indexing below to create your own
+ *   indexer).
+ *
+ * - "column_indexer_hash_buckets".
+ *
+ *   The number of indices of each column with the "hash" indexer
+ *   (default = 2^20).
  *
  * - "target_column_indexer_type".
  *
@@ -473,6 +481,7 @@ class ml_data {
       {"shuffle_rows",                           false},
 
       {"column_indexer_type",                    "unique"},
+      {"column_indexer_hash_buckets",            1 << 20},
       {"column_statistics_type",                 "basic-dense"},
 
       {"missing_value_action_on_train",          "error"},
@@ -846,6 +855,11 @@ class ml_data {
    */
   void _create_block_manager();
 
+  /** A copy sharing the data, with its own copy of the metadata.  Used for
+   *  the values stored in, and returned from, the ml_data_cache.
+   */
+  ml_data _copy_with_independent_metadata() const;
+
 
 
   ////////////////////////////////////////////////////////////////////////////////
@@ -7,6 +7,7 @@
 #include <toolkits/ml_data_2/data_storage/ml_data_row_format.hpp>
 #include <toolkits/ml_data_2/side_features.hpp>
 #include <toolkits/ml_data_2/data_storage/util.hpp>
+#include <ml/ml_data/parallel_column_indexing.hpp>
 #include <model_server/lib/variant_deep_serialize.hpp>
 #include <core/util/basic_types.hpp>
 #include <core/util/try_finally.hpp>
@@ -393,6 +394,25 @@ void ml_data::_fill_data_blocks(bool in_training_mode) {
     }
   }
 
+  // With enough rows, index the remaining columns in full before
+  // translating; the translation pass below then only looks values
+  // up, without any contention on the indices.
+  if(!immutable_metadata && num_rows >= ML_DATA_PARALLEL_INDEXING_MIN_ROWS) {
+    for(size_t c_idx = 0; c_idx < rm.total_num_columns; ++c_idx) {
+
+      const auto& m = rm.metadata_vect[c_idx];
+
+      if(m->is_untranslated_column() || !mode_is_indexed(m->mode)
+         || !m->indexer->indexes_values())
+        continue;
+
+      build_column_index_in_parallel(
+          *m->indexer, m->mode, *column_readers[c_idx], 0, num_rows);
+
+      m->indexer->set_all_values_indexed(true);
+    }
+  }
+
   ////////////////////////////////////////////////////////////////////////////////
   // Set the number of rows in each row block.
 
@@ -30,8 +30,13 @@ void basic_column_statistics::initialize() {
   by_thread_row_counts.assign(num_threads, 0);
   by_thread_mean_var_acc.resize(num_threads);
 
-  // Pull in the parallel_threshhold point.
-  parallel_threshhold = ML_DATA_STATS_PARALLEL_ACCESS_THRESHOLD;
+  // Pull in the parallel_threshhold point, lowered so the thread-local
+  // accumulators of all the threads fit in the memory budget.
+  size_t bytes_per_index = sizeof(size_t) + sizeof(element_statistics_accumulator);
+  parallel_threshhold = std::min<size_t>(
+      ML_DATA_STATS_PARALLEL_ACCESS_THRESHOLD,
+      std::max<size_t>(1024, ML_DATA_STATS_THREAD_LOCAL_MEMORY_BUDGET
+                                 / (num_threads * bytes_per_index)));
 }
 
 
@@ -14,7 +14,16 @@
 #include <boost/thread/lock_algorithms.hpp>
 #include <mutex>
 
-namespace turi { namespace v2 { namespace ml_data_internal {
+namespace turi {
+
+/**
+ * The most memory, in bytes, that the thread-local statistics
+ * accumulators of one column may take across all the threads.  Defined
+ * with the ml_data column statistics.
+ */
+extern size_t ML_DATA_STATS_THREAD_LOCAL_MEMORY_BUDGET;
+
+namespace v2 { namespace ml_data_internal {
 
 extern size_t ML_DATA_STATS_PARALLEL_ACCESS_THRESHOLD;
 
@@ -171,9 +180,10 @@ class basic_column_statistics : public column_statistics {
 
   // The issue with having seperate accumulators for each thread is
   // that it can take an inordinate amount of memory.  Thus we use
-  // parallel access for the first million or so items, which are
-  // likely to be the most common.  For the rest, we use a larger one
-  // with locking.
+  // parallel access for the first million or so items (fewer with
+  // many threads; see ML_DATA_STATS_THREAD_LOCAL_MEMORY_BUDGET), which
+  // are likely to be the most common.  For the rest, we use a larger
+  // one with locking.
 
   size_t parallel_threshhold = 1024*1024;
 
@@ -253,7 +263,7 @@ class basic_column_statistics : public column_statistics {
     if(UNLIKELY(idx >= v.size() )) {
 
       // Grow aggressively, since a resize is really expensive.
-      size_t new_size = 2 * (parallel_threshhold + idx + 1);
+      size_t new_size = std::max<size_t>(1024, 2 * (idx + 1));
 
       {
         std::array<std::unique_lock<simple_spinlock>, n_locks> all_locks;
@@ -26,6 +26,7 @@
 #include <limits>
 #include <stack>
 #include <core/logging/table_printer/table_printer.hpp>
+#include <core/parallel/lambda_omp.hpp>
 
 namespace turi {
 namespace nearest_neighbors {
@@ -129,9 +130,7 @@ void ball_tree_neighbors::train(const sframe& X,
   }
 
   node_radii.resize(num_nodes);                      // distance from pivot to furthest node member
-  std::vector<double> first_child_radius (num_nodes, 0);  // distance from the pivot to the first child observation
   std::vector<double> median_dist (num_nodes);   // median of distances to the first child point
-  double middle_dist;                            // the temporary container for the median distance in a node
   membership.resize(num_examples);               // point membership in nodes
   std::vector<double> pivot_dist(num_examples);  // distance from each point to its pivot (at the lowest tree level)
   std::vector<double> first_child_dist(num_examples);  // distance from each point to the first child (at the lowest tree level)
@@ -147,18 +146,66 @@ void ball_tree_neighbors::train(const sframe& X,
   }
 
   size_t num_variables = metadata->num_dimensions();
+  size_t max_num_threads = thread::cpu_count();
+
+  // Each pass over the data runs in parallel. A thread keeps the farthest
+  // point of each node it saw, and these are merged after the pass. Ties go
+  // to the later row, so the tree does not depend on the number of threads.
+  std::vector<std::vector<double>> thread_max_dist(max_num_threads);
+  std::vector<std::vector<size_t>> thread_max_row(max_num_threads);
+
+  auto reset_farthest = [&](size_t num_level_nodes) {
+    for (size_t t = 0; t < max_num_threads; ++t) {
+      thread_max_dist[t].assign(num_level_nodes, -1);
+      thread_max_row[t].assign(num_level_nodes, NONE_FLAG);
+    }
+  };
+
+  auto update_farthest = [&](size_t thread_idx, size_t j, double dist, size_t row) {
+    double& max_dist = thread_max_dist[thread_idx][j];
+    size_t& max_row = thread_max_row[thread_idx][j];
+    if (dist > max_dist || (dist == max_dist && row > max_row)) {
+      max_dist = dist;
+      max_row = row;
+    }
+  };
+
+  auto merge_farthest = [&](size_t j) {
+    std::pair<double, size_t> ret(-1, NONE_FLAG);
+    for (size_t t = 0; t < max_num_threads; ++t) {
+      if (thread_max_row[t][j] == NONE_FLAG) continue;
+      if (thread_max_dist[t][j] > ret.first
+          || (thread_max_dist[t][j] == ret.first && thread_max_row[t][j] > ret.second)) {
+        ret = {thread_max_dist[t][j], thread_max_row[t][j]};
+      }
+    }
+    return ret;
+  };
 
-  // Declare loop variables
-  DenseVector p(num_variables);      // dense pivot observation
-  DenseVector x(num_variables);      // dense generic observation
-  SparseVector x_sp(num_variables);  // sparse pivot observation
-  SparseVector p_sp(num_variables);  // sparse query observation
+  // Make a reference point the pivot of a node.
+  auto set_pivot = [&](size_t idx_node, size_t row) {
+    auto it = mld_ref.get_iterator();
+    it.seek(row);
+    if (is_dense) {
+      pivots[idx_node].resize(num_variables);
+      it.fill_observation(pivots[idx_node]);
+    } else {
+      pivots_sp[idx_node].resize(num_variables);
+      it.fill_observation(pivots_sp[idx_node]);
+    }
+  };
 
-  size_t a;                          // generic row index for a point
-  size_t idx_node;                   // index of the current node
-  size_t idx_node_start;             // index of the first node on a level
-  size_t idx_node_end;               // index of the last node on a level
-  size_t num_level_nodes;            // number of nodes on a level
+  // Distance from the current row to a pivot.
+  auto pivot_distance = [&](const v2::ml_data_iterator& it, size_t idx_node,
+                            DenseVector& x, SparseVector& x_sp) {
+    if (is_dense) {
+      it.fill_observation(x);
+      return c.distance->distance(x, pivots[idx_node]);
+    } else {
+      it.fill_observation(x_sp);
+      return c.distance->distance(x_sp, pivots_sp[idx_node]);
+    }
+  };
 
   // Switch for maintaining balance in the nodes. If a point is exactly on the
   // median this toggle indicates which child node to assign it to.
@@ -168,14 +215,7 @@ void ball_tree_neighbors::train(const sframe& X,
   // Choose the first pivot
   // NOTE: for now this will be the first row of the reference data, but this
   // should probably be chosen randomly.
-
-  if (is_dense) {
-    mld_ref.get_iterator().fill_observation(x);
-    pivots[0] = x;
-  } else {
-    mld_ref.get_iterator().fill_observation(x_sp);
-    pivots_sp[0] = x_sp;
-  }
+  set_pivot(0, 0);
 
 
   table_printer table( {{"Tree level", 0}, {"Elapsed Time", 0} });
@@ -191,95 +231,76 @@ void ball_tree_neighbors::train(const sframe& X,
     }
 
     // Get the node indices for nodes on the current level
-    idx_node_start = std::pow(2, tree_level) - 1;
-    idx_node_end = std::pow(2, (tree_level + 1)) - 2;
-    num_level_nodes = idx_node_end - idx_node_start + 1;
-
+    size_t idx_node_start = std::pow(2, tree_level) - 1;
+    size_t idx_node_end = std::pow(2, (tree_level + 1)) - 2;
+    size_t num_level_nodes = idx_node_end - idx_node_start + 1;
 
-    // First pass over the data
-    for (auto it = mld_ref.get_iterator(); !it.done(); ++it) {
 
-      // Get the required data
-      a = it.row_index();
-      idx_node = membership[a];
-
-      if (is_dense) {
-        p = pivots[idx_node];
-        it.fill_observation(x);
-        pivot_dist[a] = c.distance->distance(x, p);
-
-        // find the largest distance to the pivot and index of the point
-        if (pivot_dist[a] >= node_radii[idx_node]) {
-          node_radii[idx_node] = pivot_dist[a];
-          pivots[2 * idx_node + 1] = x;
-        }
+    // First pass over the data: the radius of each node, and its farthest
+    // point as the first child pivot.
+    reset_farthest(num_level_nodes);
 
-      } else {  // data is not dense
-        p_sp = pivots_sp[idx_node];
-        it.fill_observation(x_sp);
-        pivot_dist[a] = c.distance->distance(x_sp, p_sp);
-
-        // find the largest distance to the pivot and index of the point
-        if (pivot_dist[a] >= node_radii[idx_node]) {
-          node_radii[idx_node] = pivot_dist[a];
-          pivots_sp[2 * idx_node + 1] = x_sp;
-        }
+    in_parallel([&](size_t thread_idx, size_t num_threads) {
+      DenseVector x(num_variables);
+      SparseVector x_sp(num_variables);
+
+      for (auto it = mld_ref.get_iterator(thread_idx, num_threads); !it.done(); ++it) {
+        size_t a = it.row_index();
+        size_t idx_node = membership[a];
+        pivot_dist[a] = pivot_distance(it, idx_node, x, x_sp);
+        update_farthest(thread_idx, idx_node - idx_node_start, pivot_dist[a], a);
       }
-    }
-
-
-    // Create vector of vectors to store the first child distances contiguously
-    // for each node.
-    std::vector<std::vector<double>> node_dists(num_level_nodes);
-
-
-    // Second pass over the data
-    for (auto it = mld_ref.get_iterator(); !it.done(); ++it) {
+    });
 
-      // Get the required data
-      a = it.row_index();
-      idx_node = membership[a];
+    parallel_for(0, num_level_nodes, [&](size_t j) {
+      auto farthest = merge_farthest(j);
+      if (farthest.second != NONE_FLAG) {
+        node_radii[j + idx_node_start] = farthest.first;
+        set_pivot(2 * (j + idx_node_start) + 1, farthest.second);
+      }
+    });
 
-      if (is_dense) {
-        p = pivots[2 * idx_node + 1];
-        it.fill_observation(x);
 
-        // Find all of the distances to the first child and pick the second child
-        // as the point furthest away.
-        first_child_dist[a] = c.distance->distance(x, p);
+    // Second pass over the data: the distances to the first child pivot, and
+    // the point farthest from it as the second child pivot.
+    reset_farthest(num_level_nodes);
 
-        if (first_child_dist[a] >= first_child_radius[idx_node]) {
-          first_child_radius[idx_node] = first_child_dist[a];
-          pivots[2 * idx_node + 2] = x;
-        }
+    in_parallel([&](size_t thread_idx, size_t num_threads) {
+      DenseVector x(num_variables);
+      SparseVector x_sp(num_variables);
+
+      for (auto it = mld_ref.get_iterator(thread_idx, num_threads); !it.done(); ++it) {
+        size_t a = it.row_index();
+        size_t idx_node = membership[a];
+        first_child_dist[a] = pivot_distance(it, 2 * idx_node + 1, x, x_sp);
+        update_farthest(thread_idx, idx_node - idx_node_start, first_child_dist[a], a);
+      }
+    });
 
-      } else { // data is not dense
-        p_sp = pivots_sp[2 * idx_node + 1];
-        it.fill_observation(x_sp);
+    parallel_for(0, num_level_nodes, [&](size_t j) {
+      auto farthest = merge_farthest(j);
+      if (farthest.second != NONE_FLAG) {
+        set_pivot(2 * (j + idx_node_start) + 2, farthest.second);
+      }
+    });
 
-        // Find all of the distances to the first child and pick the second child
-        // as the point furthest away.
-        first_child_dist[a] = c.distance->distance(x_sp, p_sp);
 
-        if (first_child_dist[a] >= first_child_radius[idx_node]) {
-          first_child_radius[idx_node] = first_child_dist[a];
-          pivots_sp[2 * idx_node + 2] = x_sp;
-        }
-      }
+    // Collect the first child distances contiguously for each node.
+    std::vector<std::vector<double>> node_dists(num_level_nodes);
 
-      // Keep the first child distances compiled by node for median computation
-      node_dists[idx_node - idx_node_start].push_back(first_child_dist[a]);
+    for (size_t a = 0; a < num_examples; ++a) {
+      node_dists[membership[a] - idx_node_start].push_back(first_child_dist[a]);
     }
 
 
     // Find the median first child distance for each node
-    for (size_t j = 0; j < num_level_nodes; ++j) {
+    parallel_for(0, num_level_nodes, [&](size_t j) {
       if (node_dists[j].size() > 1) {
 
         std::nth_element(node_dists[j].begin(),
                          node_dists[j].begin() + node_dists[j].size()/2,
                          node_dists[j].end());
-        middle_dist = node_dists[j][node_dists[j].size()/2];
+        double middle_dist = node_dists[j][node_dists[j].size()/2];
 
         // if there are an even number of elements get the median of the middle two
         if (node_dists[j].size() % 2 == 0) {
@@ -295,14 +316,14 @@ void ball_tree_neighbors::train(const sframe& X,
         // set median distance to -1 so that singletons always go to second child
         median_dist[j + idx_node_start] = -1;
       }
-    }
+    });
 
 
     // Third pass over the data
     // - assign each point to a child
     // - careful about maintaining balance here
     for (size_t b = 0; b < num_examples; ++b) {
-      idx_node = membership[b];
+      size_t idx_node = membership[b];
       if (first_child_dist[b] < median_dist[idx_node]) {
         membership[b] = 2 * idx_node + 1;
 
@@ -328,29 +349,27 @@ void ball_tree_neighbors::train(const sframe& X,
 
 
   // Find the radii for each of the leaf nodes
-  for (auto it = mld_ref.get_iterator(); !it.done(); ++it) {
-
-    // Get the required data
-    a = it.row_index();
-    idx_node = membership[a];
-
-    if (is_dense) {
-      // Find the largest distance to the pivot and index of that point
-      p = pivots[idx_node];
-      it.fill_observation(x);
-      pivot_dist[a] = c.distance->distance(x, p);
-
-    } else { // data is not dense
-      // Find the largest distance to the pivot and index of that point
-      p_sp = pivots_sp[idx_node];
-      it.fill_observation(x_sp);
-      pivot_dist[a] = c.distance->distance(x_sp, p_sp);
+  size_t idx_leaf_start = num_nodes / 2;
+  reset_farthest(num_nodes - idx_leaf_start);
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    DenseVector x(num_variables);
+    SparseVector x_sp(num_variables);
+
+    for (auto it = mld_ref.get_iterator(thread_idx, num_threads); !it.done(); ++it) {
+      size_t a = it.row_index();
+      size_t idx_node = membership[a];
+      pivot_dist[a] = pivot_distance(it, idx_node, x, x_sp);
+      update_farthest(thread_idx, idx_node - idx_leaf_start, pivot_dist[a], a);
     }
+  });
 
-    if (pivot_dist[a] >= node_radii[idx_node]) {
-      node_radii[idx_node] = pivot_dist[a];
+  parallel_for(idx_leaf_start, num_nodes, [&](size_t idx_node) {
+    auto farthest = merge_farthest(idx_node - idx_leaf_start);
+    if (farthest.second != NONE_FLAG) {
+      node_radii[idx_node] = std::max(node_radii[idx_node], farthest.first);
     }
-  }
+  });
 
   table.print_row(tree_depth - 1, progress_time());
 
@@ -402,6 +421,7 @@ void ball_tree_neighbors::train(const sframe& X,
   // Re-make the ML data with the row-permuted data for storage in the model
   mld_ref = v2::ml_data(metadata);
   mld_ref.fill(sf_refs);
+  init_leaf_blocks();
 
 
   add_or_update_state({ {"method", "ball_tree"},
@@ -454,6 +474,10 @@ sframe ball_tree_neighbors::query(const v2::ml_data& mld_queries,
   table_printer table({ {"Query points", 0}, {"% Complete.", 0}, {"Elapsed Time", 0}});
   table.print_header();
 
+  // The cost of a query depends on how much of the tree it has to visit, so
+  // threads take small chunks of queries as they go rather than a fixed share.
+  parallel_range_cursor query_cursor(0, num_queries, parallel_schedule::GUIDED, 16);
+
   in_parallel([&](size_t thread_idx, size_t num_threads) GL_GCC_ONLY(GL_HOT) {
 
       // Find the nearest neighbors for each query point
@@ -472,126 +496,120 @@ sframe ball_tree_neighbors::query(const v2::ml_data& mld_queries,
       bool activate_node;            // indicates whether to traverse the node
       double dist_child1;            // distance to the first child pivot of an active node
       double dist_child2;            // distance to the second child pivot of an active node
-      size_t idx_start, idx_end;     // indicate where the reference data starts and stops for leaf nodes
-      double dist;                   // distance between a query point and a leaf reference point
+      std::vector<std::pair<double, size_t>> leaf_dists;  // distances to the members of a leaf
       double min_dist_possible;      // minimum possible distance between a query and a node
 
 
       auto it_ref = mld_ref.get_iterator();
+      auto it_query = mld_queries.get_iterator();
+      size_t chunk_begin = 0, chunk_end = 0;
 
-      // Iterate over query points
-      for (auto it_query = mld_queries.get_iterator(thread_idx, num_threads);
-           !it_query.done(); ++it_query) {
-
-        if (cppipc::must_cancel()) {
-          log_and_throw("Toolkit cancelled by user.");
-        }
-
-        ASSERT_TRUE(it_query.row_index() != NONE_FLAG);
-
-        if (is_dense) {
-          it_query.fill_observation(q);
-        } else {
-          it_query.fill_observation(q_sp);
-        }
-
-        idx_query = it_query.row_index();
-        node_stack.push(0);
-        min_dist_possible = 0;
+      // Iterate over chunks of query points
+      while (query_cursor.next(chunk_begin, chunk_end)) {
+        for (it_query.seek(chunk_begin);
+             !it_query.done() && it_query.row_index() < chunk_end; ++it_query) {
 
+          if (cppipc::must_cancel()) {
+            log_and_throw("Toolkit cancelled by user.");
+          }
 
-        // Loop over nodes in the traversal queue
-        while (!node_stack.empty()) {
-          idx_node = node_stack.top();
-          node_stack.pop();
+          ASSERT_TRUE(it_query.row_index() != NONE_FLAG);
 
-          // Compute the minimum possible distance from the query to the node
           if (is_dense) {
-            min_dist_possible =
-                c.distance->distance(pivots[idx_node], q) - node_radii[idx_node];
+            it_query.fill_observation(q);
           } else {
-            min_dist_possible =
-                c.distance->distance(pivots_sp[idx_node], q_sp) - node_radii[idx_node];
+            it_query.fill_observation(q_sp);
           }
 
-          // Decide if the node needs to be processed
-          activate_node = activate_query_node(kstar, radius, min_dist_possible,
-                                              topk[idx_query].candidates.size(),
-                                              topk[idx_query].get_max_dist());
-
-          if (activate_node) {
+          idx_query = it_query.row_index();
+          node_stack.push(0);
+          min_dist_possible = 0;
 
-            // The active node is internal
-            if (idx_node < num_nodes / 2) {
 
-              // find the closest child pivot to the query
-              if (is_dense) {
-                dist_child1 = c.distance->distance(q, pivots[2 * idx_node + 1]);
-                dist_child2 = c.distance->distance(q, pivots[2 * idx_node + 2]);
-              } else {
-                dist_child1 = c.distance->distance(q_sp, pivots_sp[2 * idx_node + 1]);
-                dist_child2 = c.distance->distance(q_sp, pivots_sp[2 * idx_node + 2]);
-              }
-
-              // add child nodes to the stack, closest on the top
-              if (dist_child1 <= dist_child2) {
-                node_stack.push(2 * idx_node + 2);
-                node_stack.push(2 * idx_node + 1);
-              } else {
-                node_stack.push(2 * idx_node + 1);
-                node_stack.push(2 * idx_node + 2);
-              }
+          // Loop over nodes in the traversal queue
+          while (!node_stack.empty()) {
+            idx_node = node_stack.top();
+            node_stack.pop();
 
-              // The active node is a leaf
+            // Compute the minimum possible distance from the query to the node
+            if (is_dense) {
+              min_dist_possible =
+                  c.distance->distance(pivots[idx_node], q) - node_radii[idx_node];
             } else {
+              min_dist_possible =
+                  c.distance->distance(pivots_sp[idx_node], q_sp) - node_radii[idx_node];
+            }
+
+            // Decide if the node needs to be processed
+            activate_node = activate_query_node(kstar, radius, min_dist_possible,
+                                                topk[idx_query].candidates.size(),
+                                                topk[idx_query].get_max_dist());
+
+            if (activate_node) {
 
-              // figure out where the leaf members are in the reference ml_data
-              idx_start = NONE_FLAG;
-              idx_end = NONE_FLAG;
+              // The active node is internal
+              if (idx_node < num_nodes / 2) {
 
-              for (size_t i = 0; i < membership.size(); i++) {
-                if ((idx_start == NONE_FLAG) && (membership[i] == idx_node)) {
-                  idx_start = i;
+                // find the closest child pivot to the query
+                if (is_dense) {
+                  dist_child1 = c.distance->distance(q, pivots[2 * idx_node + 1]);
+                  dist_child2 = c.distance->distance(q, pivots[2 * idx_node + 2]);
+                } else {
+                  dist_child1 = c.distance->distance(q_sp, pivots_sp[2 * idx_node + 1]);
+                  dist_child2 = c.distance->distance(q_sp, pivots_sp[2 * idx_node + 2]);
                 }
 
-                if ((idx_start != NONE_FLAG) && (membership[i] == idx_node)) {
-                  idx_end = i + 1;
+                // add child nodes to the stack, closest on the top
+                if (dist_child1 <= dist_child2) {
+                  node_stack.push(2 * idx_node + 2);
+                  node_stack.push(2 * idx_node + 1);
+                } else {
+                  node_stack.push(2 * idx_node + 1);
+                  node_stack.push(2 * idx_node + 2);
                 }
-              }
 
-              DASSERT_TRUE(idx_end >= idx_start);
+                // The active node is a leaf
+              } else {
 
-              if ((idx_start == NONE_FLAG) || (idx_end == NONE_FLAG)) {
-                continue;  // if the node is empty, move on to the next node in the stack
-              }
+                // The leaf members are a contiguous block of reference rows.
+                size_t idx_leaf = idx_node - num_nodes / 2;
+                size_t idx_start = leaf_begin[idx_leaf];
+                size_t idx_end = leaf_end[idx_leaf];
 
-              for (it_ref.seek(idx_start); it_ref.row_index() != idx_end; ++it_ref) {
+                if (idx_start == NONE_FLAG) {
+                  continue;  // if the node is empty, move on to the next node in the stack
+                }
+
+                leaf_dists.clear();
 
                 if (is_dense) {
-                  it_ref.fill_observation(x);
-                  dist = c.distance->distance(x, q);
+                  for (size_t r = idx_start; r < idx_end; ++r) {
+                    x = leaf_points.col(r);
+                    leaf_dists.push_back({c.distance->distance(x, q), r});
+                  }
                 } else {
-                  it_ref.fill_observation(x_sp);
-                  dist = c.distance->distance(x_sp, q_sp);
+                  for (it_ref.seek(idx_start); it_ref.row_index() != idx_end; ++it_ref) {
+                    DASSERT_TRUE(it_ref.row_index() != NONE_FLAG);
+                    it_ref.fill_observation(x_sp);
+                    leaf_dists.push_back({c.distance->distance(x_sp, q_sp),
+                                          it_ref.row_index()});
+                  }
                 }
 
-                DASSERT_TRUE(it_ref.row_index() != NONE_FLAG);
-
-                topk[idx_query].evaluate_point(
-                    std::pair<double, size_t>(dist, it_ref.row_index()));
-
-              }  // end the loop over reference points in the leaf
-            }  // end the leaf node processing
-          } // end active node processing
-        } // end tree traversal for a given query point
+                // Merge the whole leaf into the candidates at once.
+                topk[idx_query].evaluate_points(leaf_dists);
+              }  // end the leaf node processing
+            } // end active node processing
+          } // end tree traversal for a given query point
 
-        size_t n_query_points_so_far = (++n_query_points);
+          size_t n_query_points_so_far = (++n_query_points);
 
-        table.print_timed_progress_row( n_query_points_so_far,
-                                        std::floor((4 * 100.0 * n_query_points_so_far) / num_queries) / 4.0,
-                                        progress_time());
+          table.print_timed_progress_row( n_query_points_so_far,
+                                          std::floor((4 * 100.0 * n_query_points_so_far) / num_queries) / 4.0,
+                                          progress_time());
 
-      }  // end the loop over query points
+        }  // end the loop over query points
+      }  // end the loop over chunks
     });
 
   table.print_row("Done", " ", progress_time());
@@ -700,6 +718,45 @@ void ball_tree_neighbors::load_version(turi::iarchive& iarc, size_t version) {
   }
 
   initialize_distances();
+  init_leaf_blocks();
+}
+
+
+/**
+ * Find the reference rows of each leaf, and read the dense reference points.
+ */
+void ball_tree_neighbors::init_leaf_blocks() {
+
+  size_t num_nodes = node_radii.size();
+  size_t idx_leaf_start = num_nodes / 2;
+
+  leaf_begin.assign(num_nodes - idx_leaf_start, NONE_FLAG);
+  leaf_end.assign(num_nodes - idx_leaf_start, NONE_FLAG);
+
+  for (size_t i = 0; i < membership.size(); ++i) {
+    size_t idx_leaf = membership[i] - idx_leaf_start;
+    if (leaf_begin[idx_leaf] == NONE_FLAG) {
+      leaf_begin[idx_leaf] = i;
+    }
+    DASSERT_TRUE(leaf_end[idx_leaf] == NONE_FLAG || leaf_end[idx_leaf] == i);
+    leaf_end[idx_leaf] = i + 1;
+  }
+
+  if (!is_dense) {
+    leaf_points.resize(0, 0);
+    return;
+  }
+
+  size_t num_variables = metadata->num_dimensions();
+  leaf_points.resize(num_variables, mld_ref.size());
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    DenseVector x(num_variables);
+    for (auto it = mld_ref.get_iterator(thread_idx, num_threads); !it.done(); ++it) {
+      it.fill_observation(x);
+      leaf_points.col(it.row_index()) = x;
+    }
+  });
 }
 
 
@@ -42,6 +42,10 @@ namespace nearest_neighbors {
  * - node_radii:
  *     The distance from the pivot of each node to the most distant
  *     reference point belonging to the tree node.
+ *
+ * The reference data is stored grouped by leaf, so the members of each leaf
+ * are a contiguous block of rows. For dense data, the reference points are
+ * also kept in memory in that order, so a leaf is scanned as one block.
  */
 class EXPORT ball_tree_neighbors: public nearest_neighbors_model {
 
@@ -54,6 +58,17 @@ class EXPORT ball_tree_neighbors: public nearest_neighbors_model {
 
   size_t tree_depth;                      // number of levels in the tree
 
+  std::vector<size_t> leaf_begin;        // first reference row of each leaf
+  std::vector<size_t> leaf_end;          // one past the last row of each leaf
+  DenseMatrix leaf_points;               // dense reference points, one per column
+
+  /**
+   * Find the block of reference rows of each leaf, and for dense data read
+   * the reference points into leaf_points. Called once the reference data is
+   * grouped by leaf, after training and after loading.
+   */
+  void init_leaf_blocks();
+
   /**
    * Decide if a node should be activated for a query. Activating a node means
    * it will be traversed in the search for a query's nearest neighbors. For
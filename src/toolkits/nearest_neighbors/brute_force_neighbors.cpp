@@ -59,6 +59,15 @@ void brute_force_neighbors::init_options(const std::map<std::string,
                                "",
                                false);
 
+  options.create_integer_option("num_subspaces",
+                                "If positive, store the reference points product "
+                                "quantized, with one byte per group of features, "
+                                "and return approximate distances",
+                                0,
+                                0,
+                                std::numeric_limits<int>::max(),
+                                true);
+
   options.set_options(_options);
   add_or_update_state(flexmap_to_varmap(options.current_option_values()));
 }
@@ -93,6 +102,35 @@ void brute_force_neighbors::train(const sframe& X,
   // first because the row slicers need the column indices to be sorted.
   initialize_distances();
 
+  // Quantize the reference points if asked to.
+  size_t num_subspaces = (size_t)options.value("num_subspaces");
+
+  if (num_subspaces > 0) {
+    std::string dist_name =
+      extract_distance_function_name(std::get<1>(composite_params[0]));
+    size_t dimension = metadata->num_dimensions();
+
+    if (composite_distances.size() != 1
+        || dimension != mld_ref.max_row_size()
+        || !(dist_name == "euclidean" || dist_name == "squared_euclidean"
+             || dist_name == "cosine")) {
+      log_and_throw("Product quantization (num_subspaces > 0) supports a single "
+                    "euclidean, squared_euclidean, or cosine distance over dense "
+                    "numeric features only.");
+    }
+
+    if (num_subspaces > dimension) {
+      log_and_throw("num_subspaces must be at most the number of features ("
+                    + std::to_string(dimension) + ").");
+    }
+
+    logprogress_stream << "Quantizing the reference data into " << num_subspaces
+                       << " bytes per point." << std::endl;
+
+    pq.train(mld_ref, num_subspaces, dist_name == "cosine");
+    pq.encode(mld_ref, dist_name == "cosine", codes);
+  }
+
   add_or_update_state({ {"method", "brute_force"},
                         {"training_time", t.current_time() - start_time} });
 }
@@ -124,9 +162,22 @@ sframe brute_force_neighbors::query(const v2::ml_data& mld_queries,
   size_t dimension = metadata->num_dimensions();
   std::vector<neighbor_candidates> neighbors;
 
+  // Quantized queries
+  // -----------------
+  if (!pq.empty()) {
+    neighbors.assign(num_query_examples,
+                     neighbor_candidates(-1, kstar, radius, include_self_edges));
+
+    parallel_for(0, num_query_examples, [&](size_t i) {
+      neighbors[i].set_label(i);
+    });
+
+    quantized_query(mld_queries, neighbors, dist_name);
+  }
+
   // Blockwise queries
   // -----------------
-  if (num_query_examples > 20 &&
+  else if (num_query_examples > 20 &&
       dimension > 0 &&                        // must be some numeric data
       dimension <= 10000 &&                   // but not too much (this should really be relative to BLOCKWISE_BRUTE_FORCE_MAX_THREAD_MEMORY)
       dimension == mld_ref.max_row_size() &&  // dense data only for block-wise queries
@@ -212,7 +263,18 @@ sframe brute_force_neighbors::similarity_graph(const size_t k,
   std::vector<neighbor_candidates> neighbors;
   size_t dimension = metadata->num_dimensions();
 
-  if (dimension > 0 && dimension <= 10000 &&  // reasonable dimension
+  if (!pq.empty()) {
+    neighbors.assign(num_examples, neighbor_candidates(-1, kstar, radius,
+                                                       include_self_edges));
+
+    parallel_for(0, num_examples, [&](size_t i) {
+      neighbors[i].set_label(i);
+    });
+
+    quantized_query(mld_ref, neighbors, dist_name);
+  }
+
+  else if (dimension > 0 && dimension <= 10000 &&  // reasonable dimension
       dimension == mld_ref.max_row_size() &&  // dense data
       num_components == 1 &&                  // single component
       (dist_name == "euclidean"
@@ -481,6 +543,79 @@ void brute_force_neighbors::blockwise_query(const v2::ml_data& mld_queries,
 }
 
 
+/**
+ * Find neighbors of queries against the quantized reference points.
+ */
+void brute_force_neighbors::quantized_query(const v2::ml_data& mld_queries,
+                                    std::vector<neighbor_candidates>& neighbors,
+                                    const std::string& dist_name) const {
+
+  logprogress_stream << "Starting quantized querying." << std::endl;
+
+  size_t dimension = metadata->num_dimensions();
+  size_t num_ref_examples = mld_ref.size();
+  size_t num_queries = mld_queries.size();
+  size_t code_size = pq.code_size();
+
+  // Number of reference points whose distances are merged into the
+  // candidates at once.
+  const size_t batch_size = 4096;
+
+  table_printer table({ {"Query points", 0}, {"% Complete.", 0},
+                        {"Elapsed Time", 0}});
+  table.print_header();
+
+  atomic<size_t> n_query_points = 0;
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    DenseVector q(dimension);
+    std::vector<float> dist_table;
+    std::vector<std::pair<double, size_t>> points;
+
+    for (auto it = mld_queries.get_iterator(thread_idx, num_threads); !it.done(); ++it) {
+
+      if (cppipc::must_cancel()) {
+        log_and_throw(std::string("Toolkit cancelled by user."));
+      }
+
+      it.fill_eigen_row(q);
+      if (dist_name == "cosine") {
+        q /= std::max(1e-16, q.norm());
+      }
+      pq.distance_table(q.data(), dist_table);
+
+      for (size_t start = 0; start < num_ref_examples; start += batch_size) {
+        size_t end = std::min(num_ref_examples, start + batch_size);
+        points.resize(end - start);
+
+        for (size_t i = start; i < end; ++i) {
+          double d = pq.table_distance(dist_table, &codes[i * code_size]);
+
+          // For unit vectors, the cosine distance is half the squared
+          // euclidean distance.
+          if (dist_name == "euclidean") {
+            d = std::sqrt(std::max(0.0, d));
+          } else if (dist_name == "cosine") {
+            d = d / 2;
+          }
+          points[i - start] = {d, i};
+        }
+
+        neighbors[it.row_index()].evaluate_points(points);
+      }
+
+      size_t num_points_so_far = ++n_query_points;
+      table.print_timed_progress_row(num_points_so_far,
+                                     (100.0 * num_points_so_far) / num_queries,
+                                     progress_time());
+    }
+  });
+
+  table.print_row("Done", 100, progress_time());
+  table.print_footer();
+}
+
+
 /**
  * Find neighbors of queries in a created brute_force model.
  */
@@ -705,6 +840,8 @@ void brute_force_neighbors::save_impl(turi::oarchive& oarc) const {
        << composite_params
        << untranslated_cols
        << reference_labels;
+
+  oarc << pq << codes;
 }
 
 
@@ -713,7 +850,7 @@ void brute_force_neighbors::save_impl(turi::oarchive& oarc) const {
  */
 void brute_force_neighbors::load_version(turi::iarchive& iarc, size_t version) {
 
-  ASSERT_MSG((version == 0) || (version == 1) || (version == 2),
+  ASSERT_MSG((version == 0) || (version == 1) || (version == 2) || (version == 3),
              "This model version cannot be loaded. Please re-save your model.");
 
 
@@ -771,6 +908,14 @@ void brute_force_neighbors::load_version(turi::iarchive& iarc, size_t version) {
     iarc >> reference_labels;
   }
 
+  // Product quantized reference points, if any.
+  if (version >= 3) {
+    iarc >> pq >> codes;
+  } else {
+    pq = product_quantizer();
+    codes.clear();
+  }
+
   num_examples = variant_get_value<size_t>(state["num_examples"]);
   initialize_distances();
 }
@@ -13,6 +13,7 @@
 
 // Toolkits
 #include <toolkits/nearest_neighbors/nearest_neighbors.hpp>
+#include <toolkits/nearest_neighbors/product_quantizer.hpp>
 
 namespace turi {
 namespace nearest_neighbors {
@@ -25,10 +26,13 @@ class EXPORT brute_force_neighbors: public nearest_neighbors_model {
 
   // bool is_dense = true;                  // Indicates if SparseVector is needed
 
+  product_quantizer pq;                     // trained when num_subspaces > 0
+  std::vector<uint8_t> codes;               // quantized reference points
+
 
  public:
 
-  static constexpr size_t BRUTE_FORCE_NEIGHBORS_VERSION = 2;
+  static constexpr size_t BRUTE_FORCE_NEIGHBORS_VERSION = 3;
 
   /**
    * Destructor. Make sure bad things don't happen
@@ -137,6 +141,21 @@ class EXPORT brute_force_neighbors: public nearest_neighbors_model {
   void blockwise_similarity_graph(std::vector<neighbor_candidates>& neighbors,
                                   const std::string& dist_name) const;
 
+  /**
+   * Find neighbors of queries against the product quantized reference points,
+   * with asymmetric distances: each query builds one table of distances to
+   * the centroids, then scans the codes of all reference points. The
+   * distances returned are approximate. Only used when the model was trained
+   * with num_subspaces > 0.
+   *
+   * \param mld_queries v2::ml_data query data
+   * \param neighbors std::vector<neighbor_candidates> container for results
+   * \param dist_name std::string name of the distance function.
+   */
+  void quantized_query(const v2::ml_data& mld_queries,
+                       std::vector<neighbor_candidates>& neighbors,
+                       const std::string& dist_name) const;
+
 
   inline size_t get_version() const override {
     return BRUTE_FORCE_NEIGHBORS_VERSION;
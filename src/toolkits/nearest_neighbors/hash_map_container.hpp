@@ -6,7 +6,11 @@
 #ifndef TURI_HASH_MAP_CONTAINER_H_
 #define TURI_HASH_MAP_CONTAINER_H_
 
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
 #include <core/parallel/pthread_tools.hpp>
+#include <core/parallel/lambda_omp.hpp>
 #include <core/util/cityhash_tc.hpp>
 
 namespace turi {
@@ -56,6 +60,14 @@ class EXPORT hash_map_container {
     }
   }
 
+  // call func(key, value) on every entry. Not thread safe with update.
+  template <typename Fn>
+  void for_each(Fn func) const {
+    for (const auto& m: maps) {
+      m.for_each(func);
+    }
+  }
+
   void save(turi::oarchive& oarc) const {
     oarc << num_segments << maps;
   }
@@ -106,6 +118,13 @@ class EXPORT hash_map {
     lock.unlock();
   }
 
+  template <typename Fn>
+  void for_each(Fn func) const {
+    for (const auto& kv: umap) {
+      func(kv.first, kv.second);
+    }
+  }
+
   void save(turi::oarchive& oarc) const {
     oarc << umap;
   }
@@ -120,6 +139,145 @@ class EXPORT hash_map {
   V default_value = V();
 };
 
+/**
+ * A read only map from keys to the rows having them, built at once.
+ *
+ * The buckets are stored in three flat arrays: the sorted keys, the offset
+ * of each bucket, and the rows of all the buckets one after the other. This
+ * takes two words per bucket and one per row, where a hash_map_container of
+ * vectors takes a hash node and a heap allocated vector per bucket.
+ *
+ * The keys are split by their hash into segments, which are sorted and
+ * built in parallel. The rows of a bucket are in increasing order.
+ *
+ * \code
+ * compact_bucket_map<size_t> m;
+ * m.build(keys);  // row i has key keys[i]
+ * auto rows = m.get(k);
+ * for (auto it = rows.first; it != rows.second; ++it) { ... }
+ * \endcode
+ */
+template <typename K>
+class compact_bucket_map {
+ public:
+  typedef std::pair<const size_t*, const size_t*> bucket_type;
+
+  // Build the map of row i to key keys[i], for all i.
+  void build(const std::vector<K>& keys) {
+    size_t num_rows = keys.size();
+    num_segments = std::max<size_t>(1, thread::cpu_count() * 4);
+    size_t num_chunks = std::max<size_t>(1, thread::cpu_count());
+
+    // Count the rows of each segment in each chunk of rows
+    std::vector<std::vector<size_t>> counts(num_chunks,
+                                            std::vector<size_t>(num_segments, 0));
+    parallel_for(0, num_chunks, [&](size_t c) {
+      for (size_t i = chunk_begin(c, num_chunks, num_rows);
+           i < chunk_begin(c + 1, num_chunks, num_rows); ++i) {
+        ++counts[c][get_segment_id(keys[i])];
+      }
+    });
+
+    // Scatter the rows by segment, keeping them in order in each segment
+    std::vector<size_t> row_begin(num_segments + 1, 0);
+    size_t pos = 0;
+    for (size_t s = 0; s < num_segments; ++s) {
+      row_begin[s] = pos;
+      for (size_t c = 0; c < num_chunks; ++c) {
+        size_t n = counts[c][s];
+        counts[c][s] = pos;
+        pos += n;
+      }
+    }
+    row_begin[num_segments] = pos;
+
+    rows.resize(num_rows);
+    parallel_for(0, num_chunks, [&](size_t c) {
+      for (size_t i = chunk_begin(c, num_chunks, num_rows);
+           i < chunk_begin(c + 1, num_chunks, num_rows); ++i) {
+        rows[counts[c][get_segment_id(keys[i])]++] = i;
+      }
+    });
+
+    // Sort each segment by key, and find its buckets
+    std::vector<std::vector<K>> segment_keys(num_segments);
+    std::vector<std::vector<size_t>> segment_offsets(num_segments);
+    parallel_for(0, num_segments, [&](size_t s) {
+      auto begin = rows.begin() + row_begin[s];
+      auto end = rows.begin() + row_begin[s + 1];
+      std::stable_sort(begin, end, [&](size_t a, size_t b) {
+          return keys[a] < keys[b];
+        });
+      for (auto it = begin; it != end; ++it) {
+        if (it == begin || keys[*it] != segment_keys[s].back()) {
+          segment_keys[s].push_back(keys[*it]);
+          segment_offsets[s].push_back(it - rows.begin());
+        }
+      }
+    });
+
+    key_begin.assign(num_segments + 1, 0);
+    for (size_t s = 0; s < num_segments; ++s) {
+      key_begin[s + 1] = key_begin[s] + segment_keys[s].size();
+    }
+    bucket_keys.resize(key_begin[num_segments]);
+    offsets.resize(key_begin[num_segments] + 1);
+    parallel_for(0, num_segments, [&](size_t s) {
+      std::copy(segment_keys[s].begin(), segment_keys[s].end(),
+                bucket_keys.begin() + key_begin[s]);
+      std::copy(segment_offsets[s].begin(), segment_offsets[s].end(),
+                offsets.begin() + key_begin[s]);
+    });
+    offsets.back() = num_rows;
+  }
+
+  // The rows with key k, as a [begin, end) range. Empty if there are none.
+  bucket_type get(const K& k) const {
+    if (bucket_keys.empty()) return {nullptr, nullptr};
+    size_t seg_id = get_segment_id(k);
+    auto begin = bucket_keys.begin() + key_begin[seg_id];
+    auto end = bucket_keys.begin() + key_begin[seg_id + 1];
+    auto it = std::lower_bound(begin, end, k);
+    if (it == end || *it != k) return {nullptr, nullptr};
+    size_t idx = it - bucket_keys.begin();
+    return {rows.data() + offsets[idx], rows.data() + offsets[idx + 1]};
+  }
+
+  size_t num_buckets() const { return bucket_keys.size(); }
+
+  void clear() {
+    key_begin.clear();
+    bucket_keys.clear();
+    offsets.clear();
+    rows.clear();
+  }
+
+  void save(turi::oarchive& oarc) const {
+    oarc << num_segments << key_begin << bucket_keys << offsets << rows;
+  }
+
+  void load(turi::iarchive& iarc) {
+    iarc >> num_segments >> key_begin >> bucket_keys >> offsets >> rows;
+  }
+
+ private:
+  size_t num_segments = 1;
+  // buckets of segment s are [key_begin[s], key_begin[s + 1])
+  std::vector<size_t> key_begin;
+  std::vector<K> bucket_keys;
+  // rows of bucket b are rows[offsets[b]], ..., rows[offsets[b + 1] - 1]
+  std::vector<size_t> offsets;
+  std::vector<size_t> rows;
+
+  inline size_t get_segment_id(const K& k) const {
+    return hash64(k) % num_segments;
+  }
+
+  static size_t chunk_begin(size_t c, size_t num_chunks, size_t num_rows) {
+    return (c * num_rows) / num_chunks;
+  }
+};
+
 } // namespace turi
 
 #endif // TURI_HASH_MAP_CONTAINER_H_
@@ -0,0 +1,738 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+// ML Data
+#include <toolkits/ml_data_2/ml_data.hpp>
+#include <toolkits/ml_data_2/metadata.hpp>
+#include <toolkits/ml_data_2/ml_data_iterators.hpp>
+
+// Toolkits
+#include <toolkits/nearest_neighbors/nearest_neighbors.hpp>
+#include <toolkits/nearest_neighbors/hnsw_neighbors.hpp>
+#include <model_server/lib/variant_deep_serialize.hpp>
+
+// Miscellaneous
+#include <timer/timer.hpp>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <string>
+#include <Eigen/Core>
+#include <core/random/random.hpp>
+#include <model_server/lib/toolkit_util.hpp>
+#include <core/logging/table_printer/table_printer.hpp>
+
+
+namespace turi {
+namespace nearest_neighbors {
+
+// Layers above this are never drawn; with the default of 16 connections,
+// reaching it takes about 16^31 points.
+static const size_t HNSW_MAX_LEVEL = 31;
+
+
+/**
+ * Destructor. Make sure bad things don't happen
+ */
+hnsw_neighbors::~hnsw_neighbors(){
+
+}
+
+
+/**
+* Set options
+*/
+void hnsw_neighbors::init_options(const std::map<std::string,
+                                  flexible_type>& _options) {
+
+  options.create_integer_option("max_connections",
+                                "Number of links of each point on the layers of "
+                                "the graph (twice that on the bottom layer)",
+                                16,
+                                2,
+                                1024,
+                                true);
+
+  options.create_integer_option("ef_construction",
+                                "Width of the search for the neighbors of each "
+                                "point while the graph is built",
+                                200,
+                                1,
+                                std::numeric_limits<int>::max(),
+                                true);
+
+  options.create_integer_option("ef_search",
+                                "Width of the search for the neighbors of each "
+                                "query; at least k + 1 is used",
+                                64,
+                                1,
+                                std::numeric_limits<int>::max(),
+                                true);
+
+  options.create_integer_option("num_subspaces",
+                                "If positive, keep the reference points product "
+                                "quantized, with one byte per group of features, "
+                                "and return approximate distances",
+                                0,
+                                0,
+                                std::numeric_limits<int>::max(),
+                                true);
+
+  options.create_string_option("label",
+                               "Name of the reference dataset column with row labels.",
+                               "",
+                               false);
+
+  // Set options and update model state with final option values
+  options.set_options(_options);
+  add_or_update_state(flexmap_to_varmap(options.current_option_values()));
+}
+
+
+/**
+ * Check the distance and the data, and set up the metric.
+ */
+void hnsw_neighbors::init_metric() {
+
+  if (composite_params.size() != 1) {
+    log_and_throw("The HNSW method supports a single distance component only.");
+  }
+
+  if (!is_dense || mld_ref.max_row_size() != metadata->num_dimensions()) {
+    log_and_throw("The HNSW method supports dense numeric features only.");
+  }
+
+  std::string dist_name =
+    extract_distance_function_name(std::get<1>(composite_params[0]));
+
+  take_sqrt = false;
+
+  if (dist_name == "euclidean") {
+    metric = metric_type::SQUARED_EUCLIDEAN;
+    take_sqrt = true;
+  } else if (dist_name == "squared_euclidean") {
+    metric = metric_type::SQUARED_EUCLIDEAN;
+  } else if (dist_name == "manhattan") {
+    metric = metric_type::MANHATTAN;
+  } else if (dist_name == "cosine") {
+    metric = metric_type::COSINE;
+  } else {
+    log_and_throw("The HNSW method supports the euclidean, squared_euclidean, "
+                  "manhattan, and cosine distances only.");
+  }
+
+  dimension = metadata->num_dimensions();
+  max_connections = (size_t)options.value("max_connections");
+
+  size_t num_subspaces = (size_t)options.value("num_subspaces");
+
+  if (num_subspaces > 0 && metric == metric_type::MANHATTAN) {
+    log_and_throw("Product quantization (num_subspaces > 0) supports the "
+                  "euclidean, squared_euclidean, and cosine distances only.");
+  }
+
+  if (num_subspaces > dimension) {
+    log_and_throw("num_subspaces must be at most the number of features ("
+                  + std::to_string(dimension) + ").");
+  }
+}
+
+
+/**
+ * Normalize a point in place if the metric is cosine.
+ */
+void hnsw_neighbors::prepare_point(double* x) const {
+  if (metric == metric_type::COSINE) {
+    Eigen::Map<DenseVector> v(x, dimension);
+    v /= std::max(1e-16, v.norm());
+  }
+}
+
+
+/**
+ * Read the reference points into memory.
+ */
+void hnsw_neighbors::read_points() {
+
+  points.assign(num_examples * dimension, 0);
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    for (auto it = mld_ref.get_iterator(thread_idx, num_threads); !it.done(); ++it) {
+      double* x = &points[it.row_index() * dimension];
+      Eigen::Map<DenseVector> row(x, dimension);
+      it.fill_eigen_row(row);
+      prepare_point(x);
+    }
+  });
+}
+
+
+/**
+ * Set up the search for a prepared point.
+ */
+void hnsw_neighbors::prepare_query(const double* x, query_point& q) const {
+  q.x = x;
+  if (!pq.empty()) {
+    pq.distance_table(x, q.table);
+  }
+}
+
+
+/**
+ * Distance reported to the user.
+ */
+double hnsw_neighbors::output_distance(double d) const {
+  if (take_sqrt) {
+    d = std::sqrt(std::max(0.0, d));
+  }
+  return std::get<2>(composite_params[0]) * d;
+}
+
+
+/**
+ * Start a new search.
+ */
+void hnsw_neighbors::visited_list::reset(size_t n) {
+  if (tags.size() != n) {
+    tags.assign(n, 0);
+    tag = 0;
+  }
+
+  if (++tag == 0) {
+    std::fill(tags.begin(), tags.end(), 0);
+    tag = 1;
+  }
+}
+
+
+/**
+ * Copy the links of a node.
+ */
+void hnsw_neighbors::copy_links(size_t node, size_t layer,
+                                std::vector<simple_spinlock>* locks,
+                                std::vector<uint32_t>& out) const {
+  if (locks) (*locks)[node].lock();
+
+  const uint32_t* links = node_links(node, layer);
+  out.assign(links + 1, links + 1 + links[0]);
+
+  if (locks) (*locks)[node].unlock();
+}
+
+
+/**
+ * Move greedily towards q on one layer.
+ */
+void hnsw_neighbors::greedy_search(const query_point& q, dist_id& cur, size_t layer,
+                                   std::vector<simple_spinlock>* locks) const {
+  std::vector<uint32_t> links;
+  bool changed = true;
+
+  while (changed) {
+    changed = false;
+    copy_links(cur.second, layer, locks, links);
+
+    for (uint32_t n : links) {
+      double d = query_distance(q, n);
+      if (d < cur.first) {
+        cur = dist_id(d, n);
+        changed = true;
+      }
+    }
+  }
+}
+
+
+/**
+ * Best-first search of width ef on one layer.
+ */
+std::vector<hnsw_neighbors::dist_id> hnsw_neighbors::search_layer(
+    const query_point& q, const std::vector<dist_id>& entry_points, size_t ef,
+    size_t layer, visited_list& visited,
+    std::vector<simple_spinlock>* locks) const {
+
+  visited.reset(num_examples);
+
+  // Closest unexpanded points first, and the furthest of the results first.
+  std::priority_queue<dist_id, std::vector<dist_id>, std::greater<dist_id>> candidates;
+  std::priority_queue<dist_id> results;
+
+  for (const auto& p : entry_points) {
+    visited.visit(p.second);
+    candidates.push(p);
+    results.push(p);
+    if (results.size() > ef) results.pop();
+  }
+
+  std::vector<uint32_t> links;
+
+  while (!candidates.empty()) {
+    dist_id c = candidates.top();
+
+    // Nothing left to expand can improve the results.
+    if (results.size() >= ef && c.first > results.top().first) {
+      break;
+    }
+    candidates.pop();
+
+    copy_links(c.second, layer, locks, links);
+
+    for (uint32_t n : links) {
+      if (visited.visit(n)) continue;
+
+      double d = query_distance(q, n);
+
+      if (results.size() < ef || d < results.top().first) {
+        candidates.push(dist_id(d, n));
+        results.push(dist_id(d, n));
+        if (results.size() > ef) results.pop();
+      }
+    }
+  }
+
+  std::vector<dist_id> ret(results.size());
+  for (size_t i = ret.size(); i > 0; --i) {
+    ret[i - 1] = results.top();
+    results.pop();
+  }
+  return ret;
+}
+
+
+/**
+ * Pick at most m neighbors, preferring a spread of directions over the m
+ * closest points.
+ */
+std::vector<hnsw_neighbors::dist_id> hnsw_neighbors::select_neighbors(
+    const std::vector<dist_id>& candidates, size_t m) const {
+
+  std::vector<dist_id> ret;
+  ret.reserve(m);
+
+  for (const auto& c : candidates) {
+    if (ret.size() >= m) break;
+
+    bool keep = true;
+    for (const auto& r : ret) {
+      if (node_distance(c.second, r.second) < c.first) {
+        keep = false;
+        break;
+      }
+    }
+
+    if (keep) ret.push_back(c);
+  }
+
+  return ret;
+}
+
+
+/**
+ * Insert a node into the graph being built.
+ */
+void hnsw_neighbors::insert_node(size_t node, const query_point& q,
+                                 size_t ef_construction,
+                                 std::vector<simple_spinlock>& locks,
+                                 simple_spinlock& entry_lock,
+                                 visited_list& visited) {
+
+  const size_t level = levels[node];
+
+  // A node going above the top layer becomes the entry point; hold the lock
+  // until it is linked in.
+  entry_lock.lock();
+  size_t top = max_level;
+  size_t ep = entry_point;
+  bool new_top = (level > top);
+  if (!new_top) entry_lock.unlock();
+
+  dist_id cur(query_distance(q, ep), ep);
+
+  for (size_t layer = top; layer > level; --layer) {
+    greedy_search(q, cur, layer, &locks);
+  }
+
+  std::vector<dist_id> entry_points = {cur};
+  std::vector<uint32_t> links;
+
+  for (size_t layer = std::min(level, top) + 1; layer-- > 0;) {
+
+    std::vector<dist_id> found =
+      search_layer(q, entry_points, ef_construction, layer, visited, &locks);
+
+    std::vector<dist_id> selected = select_neighbors(found, max_connections);
+
+    {
+      locks[node].lock();
+      uint32_t* l = node_links(node, layer);
+      l[0] = selected.size();
+      for (size_t i = 0; i < selected.size(); ++i) {
+        l[i + 1] = selected[i].second;
+      }
+      locks[node].unlock();
+    }
+
+    // Link back from each neighbor, pruning its links if it has too many.
+    size_t max_degree = (layer == 0) ? 2 * max_connections : max_connections;
+
+    for (const auto& s : selected) {
+      size_t n = s.second;
+      locks[n].lock();
+      uint32_t* l = node_links(n, layer);
+
+      if (l[0] < max_degree) {
+        l[++l[0]] = node;
+      } else {
+        std::vector<dist_id> candidates = {dist_id(s.first, node)};
+        for (size_t i = 1; i <= l[0]; ++i) {
+          candidates.push_back(dist_id(node_distance(n, l[i]), l[i]));
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        std::vector<dist_id> kept = select_neighbors(candidates, max_degree);
+        l[0] = kept.size();
+        for (size_t i = 0; i < kept.size(); ++i) {
+          l[i + 1] = kept[i].second;
+        }
+      }
+
+      locks[n].unlock();
+    }
+
+    entry_points.swap(found);
+  }
+
+  if (new_top) {
+    entry_point = node;
+    max_level = level;
+    entry_lock.unlock();
+  }
+}
+
+
+/**
+ * Search the whole graph for the ef closest points to q.
+ */
+std::vector<hnsw_neighbors::dist_id> hnsw_neighbors::search(
+    const query_point& q, size_t ef, visited_list& visited) const {
+
+  dist_id cur(query_distance(q, entry_point), entry_point);
+
+  for (size_t layer = max_level; layer > 0; --layer) {
+    greedy_search(q, cur, layer, nullptr);
+  }
+
+  return search_layer(q, {cur}, ef, 0, visited, nullptr);
+}
+
+
+/**
+ * Train a HNSW nearest neighbors model.
+ */
+void hnsw_neighbors::train(const sframe& X,
+                           const std::vector<flexible_type>& ref_labels,
+                           const std::vector<dist_component_type>& composite_distance_params,
+                           const std::map<std::string, flexible_type>& opts) {
+
+  logprogress_stream << "Starting HNSW nearest neighbors model training." << std::endl;
+
+  timer t;
+  double start_time = t.current_time();
+
+  // Validate the inputs.
+  init_options(opts);
+  validate_distance_components(composite_distance_params, X);
+
+  // Create the ml_data object for the reference data.
+  initialize_model_data(X, ref_labels);
+
+  // Initialize the distance components. NOTE: this needs data to be initialized
+  // first because the row slicers need the column indices to be sorted.
+  initialize_distances();
+  init_metric();
+
+  if (num_examples >= std::numeric_limits<uint32_t>::max()) {
+    log_and_throw("The HNSW method supports up to 2^32 - 1 reference points.");
+  }
+
+  // Keep the points, or their codes.
+  size_t num_subspaces = (size_t)options.value("num_subspaces");
+
+  if (num_subspaces > 0) {
+    logprogress_stream << "Quantizing the reference data into " << num_subspaces
+                       << " bytes per point." << std::endl;
+
+    bool normalize = (metric == metric_type::COSINE);
+    pq.train(mld_ref, num_subspaces, normalize);
+    pq.encode(mld_ref, normalize, codes);
+    pq.init_symmetric_tables();
+    points.clear();
+  } else {
+    pq = product_quantizer();
+    codes.clear();
+    read_points();
+  }
+
+  // Draw the top layer of each point; the number of points on a layer drops
+  // by a factor of max_connections from one layer to the next.
+  double level_scale = 1.0 / std::log((double)max_connections);
+
+  levels.resize(num_examples);
+  upper_links.assign(num_examples, std::vector<uint32_t>());
+  base_links.assign(num_examples * base_slot_size(), 0);
+
+  for (size_t i = 0; i < num_examples; ++i) {
+    double u = std::max(1e-300, 1.0 - random::rand01());
+    levels[i] = std::min(HNSW_MAX_LEVEL, size_t(-std::log(u) * level_scale));
+    upper_links[i].assign(levels[i] * upper_slot_size(), 0);
+  }
+
+  size_t ef_construction = (size_t)options.value("ef_construction");
+
+  logprogress_stream << "HNSW Options: " << std::endl;
+  logprogress_stream << "  Max connections : " << max_connections << std::endl;
+  logprogress_stream << "  ef_construction : " << ef_construction << std::endl;
+
+  table_printer table({ {"Rows Processed", 0}, {"\% Complete", 0},
+                        {"Elapsed Time", 0}});
+  table.print_header();
+
+  // The first point is the graph; the others are inserted in parallel.
+  entry_point = 0;
+  max_level = levels[0];
+
+  std::vector<simple_spinlock> locks(num_examples);
+  simple_spinlock entry_lock;
+  atomic<size_t> n_inserted = 1;
+
+  // Each point searches for its neighbors with its full features; when the
+  // points are quantized, these are read again from the reference data.
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    visited_list visited;
+    query_point q;
+    DenseVector x(dimension);
+
+    for (auto it = mld_ref.get_iterator(thread_idx, num_threads); !it.done(); ++it) {
+      size_t node = it.row_index();
+      if (node == entry_point) continue;
+
+      if (cppipc::must_cancel()) {
+        log_and_throw("Toolkit cancelled by user.");
+      }
+
+      if (pq.empty()) {
+        prepare_query(point(node), q);
+      } else {
+        it.fill_eigen_row(x);
+        prepare_point(x.data());
+        prepare_query(x.data(), q);
+      }
+
+      insert_node(node, q, ef_construction, locks, entry_lock, visited);
+
+      size_t num_points_so_far = ++n_inserted;
+      table.print_timed_progress_row(num_points_so_far,
+                                     (num_points_so_far * 100) / num_examples,
+                                     progress_time());
+    }
+  });
+
+  table.print_row("Done", "100", progress_time());
+  table.print_footer();
+
+  add_or_update_state({ {"method", "hnsw"},
+                        {"num_layers", max_level + 1},
+                        {"training_time", t.current_time() - start_time} });
+}
+
+
+/**
+ * Find the approximate neighbors of queries in a HNSW model.
+ */
+sframe hnsw_neighbors::query(const v2::ml_data& mld_queries,
+                             const std::vector<flexible_type>& query_labels,
+                             const size_t k, const double radius,
+                             const bool include_self_edges) const {
+
+  size_t num_queries = mld_queries.size();
+
+  // Adjust the value for the max neighbors constraint.
+  size_t kstar;
+
+  if (k == NONE_FLAG) {
+    kstar = NONE_FLAG;
+  } else {
+    kstar = std::min(k, mld_ref.size());
+  }
+
+  // One more than k, in case the query itself is found and dropped.
+  size_t ef = (size_t)options.value("ef_search");
+  if (kstar != NONE_FLAG) {
+    ef = std::max(ef, kstar + 1);
+  }
+
+  std::vector<neighbor_candidates> neighbors(
+      num_queries, neighbor_candidates(-1, kstar, radius, include_self_edges));
+
+  parallel_for(0, num_queries, [&](size_t i) {
+    neighbors[i].set_label(i);
+  });
+
+  table_printer table({ {"Query points", 0}, {"\% Complete", 0},
+                        {"Elapsed Time", 0}});
+  table.print_header();
+
+  atomic<size_t> n_query_points = 0;
+
+  if (num_examples > 0) {
+    in_parallel([&](size_t thread_idx, size_t num_threads) GL_GCC_ONLY(GL_HOT) {
+      DenseVector x(dimension);
+      query_point q;
+      visited_list visited;
+      std::vector<std::pair<double, size_t>> points_found;
+
+      for (auto it = mld_queries.get_iterator(thread_idx, num_threads); !it.done(); ++it) {
+
+        if (cppipc::must_cancel()) {
+          log_and_throw("Toolkit cancelled by user.");
+        }
+
+        it.fill_eigen_row(x);
+        prepare_point(x.data());
+        prepare_query(x.data(), q);
+
+        std::vector<dist_id> found = search(q, ef, visited);
+
+        points_found.resize(found.size());
+        for (size_t i = 0; i < found.size(); ++i) {
+          points_found[i] = {output_distance(found[i].first), found[i].second};
+        }
+        neighbors[it.row_index()].evaluate_points(points_found);
+
+        size_t num_points_so_far = ++n_query_points;
+        table.print_timed_progress_row(num_points_so_far,
+                                       (num_points_so_far * 100) / num_queries,
+                                       progress_time());
+      }
+    });
+  }
+
+  table.print_row("Done", 100.0, progress_time());
+  table.print_footer();
+
+  return write_neighbors_to_sframe(neighbors, reference_labels, query_labels);
+}
+
+
+/**
+ * Find the approximate neighbors of a single point.
+ */
+void hnsw_neighbors::query_single_point(
+    const DenseVector& x, size_t k, size_t ef,
+    std::vector<std::pair<double, size_t>>& neighbors) const {
+
+  DASSERT_EQ(size_t(x.size()), dimension);
+  neighbors.clear();
+
+  if (num_examples == 0 || k == 0) return;
+
+  // Kept from one query to the next on a thread, so that a query does not
+  // clear a mark for every reference point.
+  static thread_local visited_list visited;
+
+  if (ef == 0) {
+    ef = (size_t)options.value("ef_search");
+  }
+
+  DenseVector xq = x;
+  prepare_point(xq.data());
+
+  query_point q;
+  prepare_query(xq.data(), q);
+
+  std::vector<dist_id> found = search(q, std::max(ef, k), visited);
+
+  neighbors.resize(std::min(k, found.size()));
+  for (size_t i = 0; i < neighbors.size(); ++i) {
+    neighbors[i] = {output_distance(found[i].first), found[i].second};
+  }
+}
+
+
+/**
+* Turi Serialization Save
+*/
+void hnsw_neighbors::save_impl(turi::oarchive& oarc) const {
+
+  variant_deep_save(state, oarc);
+
+  std::map<std::string, variant_type> data;
+  data["is_dense"] = to_variant(is_dense);
+
+  variant_deep_save(data, oarc);
+
+  oarc << options
+       << mld_ref
+       << composite_params
+       << untranslated_cols
+       << reference_labels;
+
+  oarc << entry_point
+       << max_level
+       << levels
+       << base_links
+       << upper_links;
+
+  oarc << pq << codes;
+}
+
+
+/**
+ * Turi Serialization Load
+ */
+void hnsw_neighbors::load_version(turi::iarchive& iarc, size_t version) {
+
+  ASSERT_MSG(version == HNSW_NEIGHBORS_VERSION,
+             "This model version cannot be loaded. Please re-save your model.");
+
+  variant_deep_load(state, iarc);
+
+  std::map<std::string, variant_type> data;
+  variant_deep_load(data, iarc);
+
+#define __EXTRACT(var) var = variant_get_value<decltype(var)>(data.at(#var));
+  __EXTRACT(is_dense);
+#undef __EXTRACT
+
+  iarc >> options;
+  iarc >> mld_ref;
+  metadata = mld_ref.metadata();
+
+  iarc >> composite_params;
+  iarc >> untranslated_cols;
+  iarc >> reference_labels;
+
+  iarc >> entry_point
+       >> max_level
+       >> levels
+       >> base_links
+       >> upper_links;
+
+  // Product quantized points, if any.
+  iarc >> pq >> codes;
+
+  num_examples = variant_get_value<size_t>(state["num_examples"]);
+  initialize_distances();
+  init_metric();
+
+  if (pq.empty()) {
+    read_points();
+  }
+}
+
+
+}  // namespace nearest_neighbors
+}  // namespace turi
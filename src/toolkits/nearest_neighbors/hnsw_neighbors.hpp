@@ -0,0 +1,325 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_HNSW_NEIGHBORS_H_
+#define TURI_HNSW_NEIGHBORS_H_
+
+// Toolkits
+#include <toolkits/nearest_neighbors/nearest_neighbors.hpp>
+#include <toolkits/nearest_neighbors/product_quantizer.hpp>
+
+// Miscellaneous
+#include <core/parallel/pthread_tools.hpp>
+
+
+namespace turi {
+namespace nearest_neighbors {
+
+
+/**
+ * HNSW nearest neighbors class
+ * -----------------------------------------------------------------------------
+ *
+ * Implements approximate k-nearest neighbors search over a hierarchical
+ * navigable small world (HNSW) graph.
+ *
+ * Each reference point is a node of a proximity graph, linked to at most
+ * max_connections of its close neighbors (twice that on the bottom layer).
+ * Every point is on the bottom layer, and each point is also on a random
+ * number of the layers above it, with exponentially fewer points per layer.
+ * A search descends greedily from the single entry point on the top layer,
+ * and then runs a best-first search of width ef on the bottom layer. Its
+ * cost grows with the log of the number of points, and unlike the ball tree
+ * it keeps working in high dimensions.
+ *
+ * Points are inserted in parallel, each one searching the graph built so
+ * far for its neighbors (with width ef_construction) and linking to a
+ * spread of them.
+ *
+ * The index supports a single distance component over dense numeric data,
+ * with the euclidean, squared_euclidean, manhattan or cosine distance.
+ *
+ * In addition to the objects contained in the nearest_neighbors_model base
+ * class, the HNSW model contains the following:
+ *
+ * - levels:
+ *     The top layer of each reference point.
+ *
+ * - base_links:
+ *     The links of every point on the bottom layer, in slots of
+ *     2 * max_connections + 1 entries: the number of links, then the links.
+ *
+ * - upper_links:
+ *     The links of each point on the layers above the bottom one, in slots
+ *     of max_connections + 1 entries, one slot per layer.
+ *
+ * The reference points themselves are read back from the reference ml_data
+ * when the model is loaded, so only the graph is serialized.
+ *
+ * With num_subspaces > 0, the points are kept product quantized instead,
+ * one byte per group of features (euclidean, squared_euclidean and cosine
+ * distances only). Queries then use asymmetric distances to the codes, the
+ * graph is built with symmetric distances between codes, and the distances
+ * returned are approximate. The codes are serialized with the graph.
+ */
+class EXPORT hnsw_neighbors: public nearest_neighbors_model {
+
+ public:
+
+  static constexpr size_t HNSW_NEIGHBORS_VERSION = 0;
+
+  /**
+   * Destructor. Make sure bad things don't happen
+   */
+  ~hnsw_neighbors();
+
+  /**
+   * Set the model options. Use the option manager to set these options. The
+   * option manager should throw errors if the options do not satisfy the option
+   * manager's conditions.
+   *
+   * \param[in] opts Options to set
+   */
+  void init_options(const std::map<std::string,flexible_type>& _opts) override;
+
+  /**
+   * Build the HNSW graph over the reference data.
+   *
+   * \param[in] X sframe input feature data
+   * \param[in] ref_labels row labels for the reference dataset
+   * \param[in] composite_distance_params
+   * \param[in] opts model options
+   */
+  void train(const sframe& X, const std::vector<flexible_type>& ref_labels,
+             const std::vector<dist_component_type>& composite_distance_params,
+             const std::map<std::string, flexible_type>& opts) override;
+
+  /**
+   * Find the approximate nearest neighbors of each query.
+   *
+   * Each query searches the graph with width max(ef_search, k + 1), and the
+   * closest points found are the candidate neighbors. With a radius and no
+   * k, only the points within the radius among those ef_search are returned.
+   *
+   * \param[in] mld_queries query data
+   * \param[in] query_labels sframe query labels
+   * \param[in] k size_t max number of neighbors to return for each query
+   * \param[in] radius double max distance for returned neighbors to each query
+   *
+   * \param[out] ret sframe SFrame with four columns: query label, reference
+   * label, distance, and rank.
+   *
+   * \note Assumes that data is already in the right shape.
+   */
+  sframe query(const v2::ml_data& mld_queries,
+               const std::vector<flexible_type>& query_labels,
+               const size_t k, const double radius,
+               const bool include_self_edges) const override;
+
+  /**
+   * Find the approximate nearest neighbors of a single dense point, without
+   * building ml_data for it, e.g. to serve one query at a time.
+   *
+   * \param[in] x The point, with the features of the reference data.
+   * \param[in] k Maximum number of neighbors.
+   * \param[in] ef Search width, at least k; 0 for the ef_search option.
+   * \param[out] neighbors (distance, reference row) pairs, closest first.
+   */
+  void query_single_point(const DenseVector& x, size_t k, size_t ef,
+                          std::vector<std::pair<double, size_t>>& neighbors) const;
+
+  /**
+   * Gets the model version number
+   */
+  inline size_t get_version() const override {
+    return HNSW_NEIGHBORS_VERSION;
+  }
+
+  /**
+   * Turi serialization save
+   */
+  void save_impl(turi::oarchive& oarc) const override;
+
+  /**
+   * Turi serialization load
+   */
+  void load_version(turi::iarchive& iarc, size_t version) override;
+
+  BEGIN_CLASS_MEMBER_REGISTRATION("nearest_neighbors_hnsw")
+  REGISTER_CLASS_MEMBER_FUNCTION(hnsw_neighbors::list_fields)
+  END_CLASS_MEMBER_REGISTRATION
+
+ private:
+
+  typedef std::pair<double, uint32_t> dist_id;
+
+  // Nodes visited by a search, marked with the search's tag.
+  struct visited_list {
+    std::vector<uint32_t> tags;
+    uint32_t tag = 0;
+
+    void reset(size_t n);
+    inline bool visit(size_t i) {
+      if (tags[i] == tag) return true;
+      tags[i] = tag;
+      return false;
+    }
+  };
+
+  enum class metric_type { SQUARED_EUCLIDEAN, MANHATTAN, COSINE };
+
+  // A point searched for: its prepared features, and its table of distances
+  // to the centroids when the points are quantized.
+  struct query_point {
+    const double* x = nullptr;
+    std::vector<float> table;
+  };
+
+  metric_type metric = metric_type::SQUARED_EUCLIDEAN;
+  bool take_sqrt = false;             // report euclidean distances
+  size_t dimension = 0;
+  size_t max_connections = 0;
+  std::vector<double> points;         // reference points, row major
+  product_quantizer pq;               // trained when num_subspaces > 0
+  std::vector<uint8_t> codes;         // quantized reference points
+
+  size_t entry_point = 0;
+  size_t max_level = 0;
+  std::vector<uint32_t> levels;
+  std::vector<uint32_t> base_links;
+  std::vector<std::vector<uint32_t>> upper_links;
+
+  /**
+   * Check the distance and the data, and set up the metric.
+   */
+  void init_metric();
+
+  /**
+   * Read the reference points from mld_ref, normalized for cosine distance.
+   */
+  void read_points();
+
+  /**
+   * Normalize a point in place if the metric is cosine.
+   */
+  void prepare_point(double* x) const;
+
+  inline const double* point(size_t i) const {
+    return &points[i * dimension];
+  }
+
+  /**
+   * Distance used to search the graph, between two prepared points.
+   */
+  inline double search_distance(const double* a, const double* b) const {
+    Eigen::Map<const DenseVector> x(a, dimension);
+    Eigen::Map<const DenseVector> y(b, dimension);
+
+    switch (metric) {
+      case metric_type::SQUARED_EUCLIDEAN: return (x - y).squaredNorm();
+      case metric_type::MANHATTAN: return (x - y).cwiseAbs().sum();
+      case metric_type::COSINE: return 1 - x.dot(y);
+    }
+    return 0;
+  }
+
+  /**
+   * Set up the search for a prepared point.
+   */
+  void prepare_query(const double* x, query_point& q) const;
+
+  /**
+   * Search distance from a query to a reference point.
+   */
+  inline double query_distance(const query_point& q, size_t node) const {
+    if (pq.empty()) {
+      return search_distance(q.x, point(node));
+    }
+    double d = pq.table_distance(q.table, &codes[node * pq.code_size()]);
+    return (metric == metric_type::COSINE) ? d / 2 : d;
+  }
+
+  /**
+   * Search distance between two reference points.
+   */
+  inline double node_distance(size_t a, size_t b) const {
+    if (pq.empty()) {
+      return search_distance(point(a), point(b));
+    }
+    double d = pq.symmetric_distance(&codes[a * pq.code_size()],
+                                     &codes[b * pq.code_size()]);
+    return (metric == metric_type::COSINE) ? d / 2 : d;
+  }
+
+  /**
+   * Distance reported to the user, from a search distance.
+   */
+  double output_distance(double d) const;
+
+  inline size_t base_slot_size() const { return 2 * max_connections + 1; }
+  inline size_t upper_slot_size() const { return max_connections + 1; }
+
+  /**
+   * Links of a node on a layer: the number of links, then the links.
+   */
+  inline uint32_t* node_links(size_t node, size_t layer) {
+    return layer == 0 ? &base_links[node * base_slot_size()]
+                      : &upper_links[node][(layer - 1) * upper_slot_size()];
+  }
+
+  inline const uint32_t* node_links(size_t node, size_t layer) const {
+    return layer == 0 ? &base_links[node * base_slot_size()]
+                      : &upper_links[node][(layer - 1) * upper_slot_size()];
+  }
+
+  /**
+   * Copy the links of a node, taking its lock while the graph is built.
+   */
+  void copy_links(size_t node, size_t layer,
+                  std::vector<simple_spinlock>* locks,
+                  std::vector<uint32_t>& out) const;
+
+  /**
+   * Move greedily towards q on one layer, starting from cur.
+   */
+  void greedy_search(const query_point& q, dist_id& cur, size_t layer,
+                     std::vector<simple_spinlock>* locks) const;
+
+  /**
+   * Best-first search of width ef on one layer. Returns the closest points
+   * found, sorted by distance.
+   */
+  std::vector<dist_id> search_layer(const query_point& q,
+                                    const std::vector<dist_id>& entry_points,
+                                    size_t ef, size_t layer,
+                                    visited_list& visited,
+                                    std::vector<simple_spinlock>* locks) const;
+
+  /**
+   * Pick at most m of the candidates, sorted by distance, skipping those
+   * closer to an already picked point than to the base point.
+   */
+  std::vector<dist_id> select_neighbors(const std::vector<dist_id>& candidates,
+                                        size_t m) const;
+
+  /**
+   * Insert a node into the graph being built.
+   */
+  void insert_node(size_t node, const query_point& q, size_t ef_construction,
+                   std::vector<simple_spinlock>& locks,
+                   simple_spinlock& entry_lock, visited_list& visited);
+
+  /**
+   * Search the whole graph for the ef closest points to q.
+   */
+  std::vector<dist_id> search(const query_point& q, size_t ef,
+                              visited_list& visited) const;
+};
+
+
+}  // namespace nearest_neighbors
+}  // namespace turi
+
+#endif
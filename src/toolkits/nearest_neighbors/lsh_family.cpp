@@ -8,11 +8,46 @@
 #include <toolkits/ml_data_2/ml_data_iterators.hpp>
 
 #include <time.h>
+#include <limits>
+#include <numeric>
+#include <queue>
 #include <boost/functional/hash.hpp>
 
 namespace turi {
 namespace nearest_neighbors {
 
+namespace {
+
+// Probe scores of codes which are the floor of the projections: the squared
+// distances of the projections to the bucket boundaries below and above.
+void floor_probe_scores(const DenseVector& projections,
+                        std::vector<double>* probe_scores) {
+  if (probe_scores == nullptr) return;
+  probe_scores->resize(2 * projections.size());
+  for (size_t i = 0; i < size_t(projections.size()); ++i) {
+    double frac = projections(i) - std::floor(projections(i));
+    (*probe_scores)[2 * i] = frac * frac;
+    (*probe_scores)[2 * i + 1] = (1. - frac) * (1. - frac);
+  }
+}
+
+// Probe scores of codes which are the signs of the projections (0 or 1):
+// the only neighboring bucket is the other sign.
+void sign_probe_scores(const DenseVector& projections,
+                       std::vector<double>* probe_scores) {
+  if (probe_scores == nullptr) return;
+  const double inf = std::numeric_limits<double>::infinity();
+  probe_scores->resize(2 * projections.size());
+  for (size_t i = 0; i < size_t(projections.size()); ++i) {
+    double score = projections(i) * projections(i);
+    bool positive = projections(i) > 0.;
+    (*probe_scores)[2 * i] = positive ? score : inf;
+    (*probe_scores)[2 * i + 1] = positive ? inf : score;
+  }
+}
+
+} // anonymous namespace
+
 
 void lsh_family::init_options(const std::map<std::string, flexible_type>& _opts) {
 
@@ -20,10 +55,109 @@ void lsh_family::init_options(const std::map<std::string, flexible_type>& _opts)
   __EXTRACT(num_tables);
   __EXTRACT(num_projections_per_table);
 #undef __EXTRACT
+  num_probes = 0;
+  if (_opts.count("num_probes")) {
+    num_probes = variant_get_value<size_t>(_opts.at("num_probes"));
+  }
   num_projections = num_tables * num_projections_per_table;
   num_input_dimensions = 0;
 
-  lookup_table.assign(num_tables, hash_map_container<size_t, std::vector<size_t>>());
+  lookup_table.assign(num_tables, compact_bucket_map<size_t>());
+}
+
+void lsh_family::reserve_reference_data(size_t num_ref) {
+  num_reference_data = num_ref;
+  reference_bucket_ids.assign(num_tables * num_reference_data, 0);
+}
+
+void lsh_family::build_tables() {
+  std::vector<size_t> keys(num_reference_data);
+  for (size_t table_idx = 0; table_idx < num_tables; ++table_idx) {
+    std::copy(reference_bucket_ids.begin() + table_idx * num_reference_data,
+              reference_bucket_ids.begin() + (table_idx + 1) * num_reference_data,
+              keys.begin());
+    lookup_table[table_idx].build(keys);
+  }
+  reference_bucket_ids.clear();
+  reference_bucket_ids.shrink_to_fit();
+}
+
+size_t lsh_family::bucket_id(const std::vector<int>& codes, size_t table_idx) const {
+  return boost::hash_range(
+      codes.begin() + table_idx * num_projections_per_table,
+      codes.begin() + std::min((table_idx + 1) * num_projections_per_table, num_projections));
+}
+
+std::vector<std::pair<size_t, std::vector<size_t>>> lsh_family::probing_sequence(
+    const std::vector<double>& probe_scores, size_t max_num_probes) const {
+
+  std::vector<std::pair<size_t, std::vector<size_t>>> ret;
+  if (max_num_probes == 0) return ret;
+  DASSERT_EQ(probe_scores.size(), 2 * num_projections);
+
+  // The perturbations of each table, by increasing score
+  size_t table_size = 2 * num_projections_per_table;
+  std::vector<size_t> sorted(2 * num_projections);
+  for (size_t table_idx = 0; table_idx < num_tables; ++table_idx) {
+    auto begin = sorted.begin() + table_idx * table_size;
+    std::iota(begin, begin + table_size, table_idx * table_size);
+    std::sort(begin, begin + table_size, [&](size_t a, size_t b) {
+        return probe_scores[a] < probe_scores[b];
+      });
+  }
+
+  // A set of perturbations of a table: positions in its sorted perturbations
+  struct probe {
+    double score;
+    size_t table_idx;
+    std::vector<size_t> positions;
+    bool operator>(const probe& other) const { return score > other.score; }
+  };
+  auto score_of = [&](size_t table_idx, size_t position) {
+    return probe_scores[sorted[table_idx * table_size + position]];
+  };
+
+  std::priority_queue<probe, std::vector<probe>, std::greater<probe>> heap;
+  for (size_t table_idx = 0; table_idx < num_tables; ++table_idx) {
+    heap.push({score_of(table_idx, 0), table_idx, {0}});
+  }
+
+  while (!heap.empty() && ret.size() < max_num_probes) {
+    probe top = heap.top();
+    heap.pop();
+    if (top.score == std::numeric_limits<double>::infinity()) break;
+
+    // Shift: replace the last perturbation by the next one.
+    // Expand: add the next one.
+    size_t last = top.positions.back();
+    if (last + 1 < table_size) {
+      probe shifted = top;
+      shifted.positions.back() = last + 1;
+      shifted.score += score_of(top.table_idx, last + 1) - score_of(top.table_idx, last);
+      heap.push(std::move(shifted));
+
+      probe expanded = top;
+      expanded.positions.push_back(last + 1);
+      expanded.score += score_of(top.table_idx, last + 1);
+      heap.push(std::move(expanded));
+    }
+
+    // A set moving a code both down and up is not a probe, but its shifts
+    // and expansions may be.
+    std::vector<size_t> perturbations;
+    bool valid = true;
+    for (size_t pos : top.positions) {
+      size_t p = sorted[top.table_idx * table_size + pos];
+      for (size_t q : perturbations) {
+        if (q / 2 == p / 2) valid = false;
+      }
+      perturbations.push_back(p);
+    }
+    if (valid) {
+      ret.emplace_back(top.table_idx, std::move(perturbations));
+    }
+  }
+  return ret;
 }
 
 void lsh_family::save(turi::oarchive& oarc) const {
@@ -31,6 +165,7 @@ void lsh_family::save(turi::oarchive& oarc) const {
       << num_tables
       << num_projections_per_table
       << num_projections
+      << num_probes
       << lookup_table;
 }
 
@@ -38,19 +173,46 @@ void lsh_family::load(turi::iarchive& iarc) {
   iarc >> num_input_dimensions
       >> num_tables
       >> num_projections_per_table
-      >> num_projections
-      >> lookup_table;
+      >> num_projections;
+
+  if (loading_version >= 2) {
+    iarc >> num_probes >> lookup_table;
+    return;
+  }
+
+  // Version 1 stored a vector of rows per bucket
+  num_probes = 0;
+  std::vector<hash_map_container<size_t, std::vector<size_t>>> old_table;
+  iarc >> old_table;
+  lookup_table.assign(num_tables, compact_bucket_map<size_t>());
+  for (size_t table_idx = 0; table_idx < old_table.size(); ++table_idx) {
+    std::vector<size_t> keys;
+    old_table[table_idx].for_each([&](size_t key, const std::vector<size_t>& rows) {
+        for (size_t row : rows) {
+          if (row >= keys.size()) keys.resize(row + 1);
+          keys[row] = key;
+        }
+      });
+    lookup_table[table_idx].build(keys);
+  }
+}
+
+void lsh_family::load_version(turi::iarchive& iarc, size_t version) {
+  loading_version = version;
+  load(iarc);
 }
 
 std::vector<int> lsh_family::hash_vector_to_codes(const DenseVector& vec,
-                                                  bool is_reference_data) const {
+                                                  bool is_reference_data,
+                                                  std::vector<double>* probe_scores) const {
   log_and_throw(std::string("DenseVector is not supported for LSH ")
                 + distance_type_name());
   return {};
 }
 
 std::vector<int> lsh_family::hash_vector_to_codes(const SparseVector& vec,
-                                                  bool is_reference_data) const {
+                                                  bool is_reference_data,
+                                                  std::vector<double>* probe_scores) const {
   log_and_throw(std::string("SparseVector is not supported for LSH ")
                 + distance_type_name());
   return {};
@@ -116,17 +278,20 @@ void lsh_euclidean::load(turi::iarchive& iarc) {
 }
 
 std::vector<int> lsh_euclidean::hash_vector_to_codes(const DenseVector& vec,
-                                                     bool is_reference_data) const {
+                                                     bool is_reference_data,
+                                                     std::vector<double>* probe_scores) const {
   std::vector<int> ret(num_projections, -1);
   DenseVector hash_vec = rand_mat * vec + rand_vec;
   parallel_for (0, num_projections, [&](size_t hash_idx) {
     ret[hash_idx] = static_cast<int>(std::floor(hash_vec(hash_idx) / w));
   });
+  floor_probe_scores(hash_vec / w, probe_scores);
   return ret;
 }
 
 std::vector<int> lsh_euclidean::hash_vector_to_codes(const SparseVector& vec,
-                                                     bool is_reference_data) const {
+                                                     bool is_reference_data,
+                                                     std::vector<double>* probe_scores) const {
   std::vector<int> ret(num_projections, -1);
   if (vec.nonZeros() == 0) return ret;
 
@@ -134,6 +299,7 @@ std::vector<int> lsh_euclidean::hash_vector_to_codes(const SparseVector& vec,
   parallel_for (0, num_projections, [&](size_t hash_idx) {
     ret[hash_idx] = static_cast<int>(std::floor(hash_vec(hash_idx) / w));
   });
+  floor_probe_scores(hash_vec / w, probe_scores);
   return ret;
 }
 
@@ -201,17 +367,20 @@ void lsh_cosine::load(turi::iarchive& iarc) {
 }
 
 std::vector<int> lsh_cosine::hash_vector_to_codes(const DenseVector& vec,
-                                                  bool is_reference_data) const {
+                                                  bool is_reference_data,
+                                                  std::vector<double>* probe_scores) const {
   std::vector<int> ret(num_projections, -1);
   DenseVector hash_vec = rand_mat * vec;
   parallel_for (0, num_projections, [&](size_t hash_idx) {
     ret[hash_idx] = (hash_vec(hash_idx) > 0.) ? 1 : 0;
   });
+  sign_probe_scores(hash_vec, probe_scores);
   return ret;
 }
 
 std::vector<int> lsh_cosine::hash_vector_to_codes(const SparseVector& vec,
-                                                  bool is_reference_data) const {
+                                                  bool is_reference_data,
+                                                  std::vector<double>* probe_scores) const {
   std::vector<int> ret(num_projections, -1);
 
   if (vec.nonZeros() == 0) return ret;
@@ -220,6 +389,7 @@ std::vector<int> lsh_cosine::hash_vector_to_codes(const SparseVector& vec,
   parallel_for (0, num_projections, [&](size_t hash_idx) {
     ret[hash_idx] = (hash_vec(hash_idx) > 0.) ? 1 : 0;
   });
+  sign_probe_scores(hash_vec, probe_scores);
   return ret;
 }
 
@@ -256,7 +426,8 @@ void lsh_jaccard::load(turi::iarchive& iarc) {
 // The procedure is similar with hash_vector_to_codes(SparseVector)
 // See details in that function
 std::vector<int> lsh_jaccard::hash_vector_to_codes(const DenseVector& vec,
-                                                   bool is_reference_data) const {
+                                                   bool is_reference_data,
+                                                   std::vector<double>* probe_scores) const {
   std::vector<int> ret(num_projections, num_input_dimensions);
 
   // Note that the size of the last chunk might be larger than chunk_size
@@ -283,7 +454,8 @@ std::vector<int> lsh_jaccard::hash_vector_to_codes(const DenseVector& vec,
 }
 
 std::vector<int> lsh_jaccard::hash_vector_to_codes(const SparseVector& vec,
-                                                   bool is_reference_data) const {
+                                                   bool is_reference_data,
+                                                   std::vector<double>* probe_scores) const {
   // Details in
   // http://jmlr.org/proceedings/papers/v32/shrivastava14.pdf
   // Figure 4
@@ -436,7 +608,8 @@ void lsh_dot_product::load(turi::iarchive& iarc) {
 
 // Implementation of section 4.2 of http://jmlr.org/proceedings/papers/v37/neyshabur15.pdf
 std::vector<int> lsh_dot_product::hash_vector_to_codes(const DenseVector& vec,
-                                                       bool is_reference_data) const {
+                                                       bool is_reference_data,
+                                                       std::vector<double>* probe_scores) const {
   std::vector<int> ret(num_projections, -1);
   DenseVector hash_vec(num_projections);
 
@@ -454,12 +627,14 @@ std::vector<int> lsh_dot_product::hash_vector_to_codes(const DenseVector& vec,
   parallel_for (0, num_projections, [&](size_t hash_idx) {
     ret[hash_idx] = (hash_vec(hash_idx) > 0.) ? 1 : 0;
   });
+  sign_probe_scores(hash_vec, probe_scores);
   return ret;
 }
 
 // Implementation of section 4.2 of http://jmlr.org/proceedings/papers/v37/neyshabur15.pdf
 std::vector<int> lsh_dot_product::hash_vector_to_codes(const SparseVector& vec,
-                                                       bool is_reference_data) const {
+                                                       bool is_reference_data,
+                                                       std::vector<double>* probe_scores) const {
   std::vector<int> ret(num_projections, -1);
 
   if (vec.nonZeros() == 0) return ret;
@@ -479,6 +654,7 @@ std::vector<int> lsh_dot_product::hash_vector_to_codes(const SparseVector& vec,
   parallel_for (0, num_projections, [&](size_t hash_idx) {
     ret[hash_idx] = (hash_vec(hash_idx) > 0.) ? 1 : 0;
   });
+  sign_probe_scores(hash_vec, probe_scores);
   return ret;
 }
 
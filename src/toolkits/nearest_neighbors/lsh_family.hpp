@@ -40,33 +40,73 @@ class EXPORT lsh_family {
   // initialize the model. num_input_dimensions is needed
   virtual void init_model(size_t num_dimensions) = 0;
 
-  // add reference data one by one
+  // Make room for the hash codes of num_reference_data reference vectors,
+  // before add_reference_data.
+  void reserve_reference_data(size_t num_reference_data);
+
+  // add reference data one by one, from any number of threads. The tables
+  // are built by build_tables once all the data is added.
   // Only DenseVector and SparseVector are supported
   template <typename T>
   void add_reference_data(size_t ref_id, const T& t);
 
+  // Build the lookup tables of the reference data, in parallel
+  void build_tables();
+
   // Return a set of candidates for the query vector
   // Only DenseVector and SparseVector are supported
   template <typename T>
   std::vector<size_t> query(const T& t) const;
 
+  // The number of buckets probed per table besides the one of the query
+  size_t get_num_probes() const { return num_probes; }
+  void set_num_probes(size_t n) { num_probes = n; }
+
   // save & load
   virtual void save(turi::oarchive& oarc) const;
   virtual void load(turi::iarchive& iarc);
 
+  // load a model saved by version `version` of lsh_neighbors
+  void load_version(turi::iarchive& iarc, size_t version);
+
  protected:
-  // model initialized when add_reference_data is called in the first time
+  // Hash a vector to num_projections codes. For multi-probe queries,
+  // probe_scores (if not null) is filled with 2 * num_projections scores:
+  // the cost of moving code i to code - 1 (entry 2i) and to code + 1
+  // (entry 2i + 1), the squared distance of the projection of the vector
+  // to that neighboring bucket, or infinity if that code does not exist.
+  // It is left empty by families which do not support multi-probe.
   virtual std::vector<int> hash_vector_to_codes(const DenseVector& vec,
-                                                bool is_reference_data) const;
+                                                bool is_reference_data,
+                                                std::vector<double>* probe_scores = nullptr) const;
   virtual std::vector<int> hash_vector_to_codes(const SparseVector& vec,
-                                                bool is_reference_data) const;
+                                                bool is_reference_data,
+                                                std::vector<double>* probe_scores = nullptr) const;
+
+  // The hash of the codes of a table
+  size_t bucket_id(const std::vector<int>& codes, size_t table_idx) const;
+
+  // The probes of a query besides its own buckets, cheapest first, from the
+  // probe_scores of hash_vector_to_codes: (table index, perturbations), where
+  // a perturbation p moves code p / 2 down (p even) or up (p odd).
+  //
+  // This is the query directed probing sequence of Lv et al., "Multi-Probe
+  // LSH: Efficient Indexing for High-Dimensional Similarity Search", with
+  // the probes of all the tables in one sequence.
+  std::vector<std::pair<size_t, std::vector<size_t>>> probing_sequence(
+      const std::vector<double>& probe_scores, size_t max_num_probes) const;
 
  protected:
   size_t num_input_dimensions;
   size_t num_tables;
   size_t num_projections_per_table;
   size_t num_projections;
-  std::vector<hash_map_container<size_t, std::vector<size_t>>> lookup_table;
+  size_t num_probes = 0;
+  size_t loading_version = 0;
+  // bucket ids of the reference data, table by table, until build_tables
+  std::vector<size_t> reference_bucket_ids;
+  size_t num_reference_data = 0;
+  std::vector<compact_bucket_map<size_t>> lookup_table;
 };
 
 
@@ -93,9 +133,11 @@ class EXPORT lsh_euclidean : public lsh_family {
 
  protected:
   virtual std::vector<int> hash_vector_to_codes(const DenseVector& vec,
-                                        bool is_reference_data) const;
+                                        bool is_reference_data,
+                                        std::vector<double>* probe_scores = nullptr) const;
   virtual std::vector<int> hash_vector_to_codes(const SparseVector& vec,
-                                        bool is_reference_data) const;
+                                        bool is_reference_data,
+                                        std::vector<double>* probe_scores = nullptr) const;
 
  protected:
   size_t w;
@@ -152,9 +194,11 @@ class EXPORT lsh_cosine final : public lsh_family {
 
  protected:
   std::vector<int> hash_vector_to_codes(const DenseVector& vec,
-                                        bool is_reference_data) const;
+                                        bool is_reference_data,
+                                        std::vector<double>* probe_scores = nullptr) const;
   std::vector<int> hash_vector_to_codes(const SparseVector& vec,
-                                        bool is_reference_data) const;
+                                        bool is_reference_data,
+                                        std::vector<double>* probe_scores = nullptr) const;
 
  private:
   DenseMatrix rand_mat;
@@ -179,9 +223,11 @@ class EXPORT lsh_jaccard final : public lsh_family {
 
  protected:
   std::vector<int> hash_vector_to_codes(const DenseVector& vec,
-                                        bool is_reference_data) const;
+                                        bool is_reference_data,
+                                        std::vector<double>* probe_scores = nullptr) const;
   std::vector<int> hash_vector_to_codes(const SparseVector& vec,
-                                        bool is_reference_data) const;
+                                        bool is_reference_data,
+                                        std::vector<double>* probe_scores = nullptr) const;
 
   // helper function
   void fill_empty_bins(std::vector<int>& vec) const;
@@ -213,9 +259,11 @@ class EXPORT lsh_dot_product : public lsh_family {
 
  protected:
   std::vector<int> hash_vector_to_codes(const DenseVector& vec,
-                                        bool is_reference_data) const;
+                                        bool is_reference_data,
+                                        std::vector<double>* probe_scores = nullptr) const;
   std::vector<int> hash_vector_to_codes(const SparseVector& vec,
-                                        bool is_reference_data) const;
+                                        bool is_reference_data,
+                                        std::vector<double>* probe_scores = nullptr) const;
 
  private:
   double max_vec_norm;
@@ -256,18 +304,15 @@ void lsh_family::add_reference_data(size_t ref_id, const T& vec) {
   ASSERT_MSG(size_t(vec.size()) == num_input_dimensions,
              "The input dimension does not match the previous ones!");
 
+  DASSERT_LT(ref_id, num_reference_data);
+
   auto hash_vec = hash_vector_to_codes(vec, true);
   DASSERT_TRUE(hash_vec.size() == num_projections);
 
-  parallel_for (0, num_tables, [&](size_t table_idx) {
-    auto hash_bucket_id = boost::hash_range(
-        hash_vec.begin() + table_idx * num_projections_per_table,
-        hash_vec.begin() + std::min((table_idx + 1) * num_projections_per_table, num_projections));
-
-    lookup_table[table_idx].update(hash_bucket_id, [ref_id](std::vector<size_t>& v){
-                                    v.push_back(ref_id);
-                                  });
-  });
+  for (size_t table_idx = 0; table_idx < num_tables; ++table_idx) {
+    reference_bucket_ids[table_idx * num_reference_data + ref_id] =
+        bucket_id(hash_vec, table_idx);
+  }
 }
 
 template <typename T>
@@ -277,15 +322,27 @@ std::vector<size_t> lsh_family::query(const T& vec) const {
              "The input num_dimensions does not match the reference data!");
 
   std::unordered_set<size_t> ret;
-  auto hash_vec = hash_vector_to_codes(vec, false);
+  std::vector<double> probe_scores;
+  auto hash_vec = hash_vector_to_codes(vec, false,
+                                       num_probes > 0 ? &probe_scores : nullptr);
   DASSERT_TRUE(hash_vec.size() == num_projections);
   for (size_t table_idx = 0; table_idx < num_tables; ++table_idx) {
-    auto hash_bucket_id = boost::hash_range(
-        hash_vec.begin() + table_idx * num_projections_per_table,
-        hash_vec.begin() + std::min((table_idx + 1) * num_projections_per_table, num_projections));
+    auto candidates = lookup_table[table_idx].get(bucket_id(hash_vec, table_idx));
+    ret.insert(candidates.first, candidates.second);
+  }
 
-    const auto& candidates = lookup_table[table_idx].get(hash_bucket_id);
-    ret.insert(candidates.cbegin(), candidates.cend());
+  // Multi-probe: the neighboring buckets the query is the closest to
+  if (!probe_scores.empty()) {
+    for (const auto& probe : probing_sequence(probe_scores, num_probes * num_tables)) {
+      for (size_t p : probe.second) {
+        hash_vec[p / 2] += (p % 2 == 0) ? -1 : 1;
+      }
+      auto candidates = lookup_table[probe.first].get(bucket_id(hash_vec, probe.first));
+      ret.insert(candidates.first, candidates.second);
+      for (size_t p : probe.second) {
+        hash_vec[p / 2] -= (p % 2 == 0) ? -1 : 1;
+      }
+    }
   }
 
   std::vector<size_t> ret_vec(ret.begin(), ret.end());
@@ -63,6 +63,14 @@ void lsh_neighbors::init_options(const std::map<std::string,
                             std::numeric_limits<int>::max(),
                             true);
 
+  options.create_integer_option("num_probes",
+                            "number of neighboring buckets probed per table "
+                            "besides the bucket of the query",
+                            0,
+                            0,
+                            std::numeric_limits<int>::max(),
+                            true);
+
   options.create_string_option("label",
                              "Name of the reference dataset column with row labels.",
                              "",
@@ -119,6 +127,7 @@ void lsh_neighbors::train(const sframe& X, const std::vector<flexible_type>& ref
   logprogress_stream << "LSH Options: " << std::endl;
   logprogress_stream << "  Number of tables : " << num_tables << std::endl;
   logprogress_stream << "  Number of projections per table : " << num_projections_per_table << std::endl;
+  logprogress_stream << "  Number of probes per table : " << options.value("num_probes") << std::endl;
 
   table_printer table({ {"Rows Processed", 0}, {"\% Complete", 0},
                         {"Elapsed Time", 0}});
@@ -130,6 +139,7 @@ void lsh_neighbors::train(const sframe& X, const std::vector<flexible_type>& ref
   lsh_model->init_options(options.current_option_values());
   lsh_model->init_model(num_dimensions);
   lsh_model->pre_lsh(mld_ref, is_sparse);
+  lsh_model->reserve_reference_data(mld_ref.size());
 
   turi::atomic<size_t> n_train_points = 0;
 
@@ -163,6 +173,7 @@ void lsh_neighbors::train(const sframe& X, const std::vector<flexible_type>& ref
       }
     }
   });
+  lsh_model->build_tables();
   table.print_row("Done", "100", progress_time());
   table.print_footer();
 
@@ -432,6 +443,7 @@ void lsh_neighbors::save_impl(turi::oarchive& oarc) const {
  */
 void lsh_neighbors::load_version(turi::iarchive& iarc, size_t version) {
 
+  // Version 1 models are converted to the compact lookup tables of version 2
   ASSERT_MSG((version == LSH_NEIGHBORS_VERSION) ||
              (version == LSH_NEIGHBORS_VERSION - 1),
              "This model version cannot be loaded. Please re-save your model.");
@@ -451,7 +463,7 @@ void lsh_neighbors::load_version(turi::iarchive& iarc, size_t version) {
   iarc >> distance_type_name;
   lsh_model = lsh_family::create_lsh_family(distance_type_name);
 
-  iarc >> *lsh_model;
+  lsh_model->load_version(iarc, version);
 
   iarc >> options;
   iarc >> mld_ref;
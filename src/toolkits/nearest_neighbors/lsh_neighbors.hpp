@@ -33,13 +33,18 @@ namespace nearest_neighbors {
  *  You can set k and l by setting num_projections_per_table and
  *  num_tables respectively.
  *
+ *  With num_probes > 0, a query also looks up the neighboring buckets its
+ *  projections are the closest to (multi-probe LSH), num_probes per table
+ *  on average. This gives the recall of many more tables with a few, and
+ *  the memory of the index grows with the number of tables.
+ *
  *
  */
 class EXPORT lsh_neighbors: public nearest_neighbors_model {
 
  public:
 
-  static constexpr size_t LSH_NEIGHBORS_VERSION = 1;
+  static constexpr size_t LSH_NEIGHBORS_VERSION = 2;
 
   /**
    * Destructor. Make sure bad things don't happen
@@ -6,7 +6,9 @@
 // Toolkits
 #include <toolkits/nearest_neighbors/nearest_neighbors.hpp>
 #include <algorithm>
+#include <functional>
 #include <boost/algorithm/string.hpp>
+#include <core/util/fast_top_k.hpp>
 
 // SFrame
 #include <core/storage/sframe_data/sframe_reader.hpp>
@@ -177,14 +179,21 @@ void find_block_neighbors(const DenseMatrix& R, const DenseMatrix& Q,
     log_and_throw("Distance name not understood.");
   }
 
+  // Each column of the (column major) distance matrix holds one query's
+  // distances; select its closest reference points within the block before
+  // touching the shared candidates.
+  std::vector<std::pair<double, size_t>> points(num_ref_examples);
+
   for (size_t j = 0; j < num_query_examples; ++j) {
     size_t idx_query = j + query_offset;
 
     // Find the closest reference points
+    points.resize(num_ref_examples);
+    const double* col = dists.col(j).data();
     for (size_t i = 0; i < num_ref_examples; ++i) {
-      size_t idx_ref = i + ref_offset;
-      neighbors[idx_query].evaluate_point(std::pair<double, size_t>(dists(i, j), idx_ref));
+      points[i] = {col[i], i + ref_offset};
     }
+    neighbors[idx_query].evaluate_points(points);
   }
 }
 
@@ -226,14 +235,23 @@ void off_diag_block_similarity_graph(const DenseMatrix& R, const DenseMatrix& C,
   }
 
   // Update the nearest neighbors. Assume the matrix is not symmetric.
-  for (size_t i = 0; i < num_rows; ++i) {
-    size_t idx_row = i + row_offset;
+  std::vector<std::pair<double, size_t>> points;
+
+  for (size_t j = 0; j < num_cols; ++j) {
+    points.resize(num_rows);
+    const double* col = dists.col(j).data();
+    for (size_t i = 0; i < num_rows; ++i) {
+      points[i] = {col[i], i + row_offset};
+    }
+    neighbors[j + col_offset].evaluate_points(points);
+  }
 
+  for (size_t i = 0; i < num_rows; ++i) {
+    points.resize(num_cols);
     for (size_t j = 0; j < num_cols; ++j) {
-      size_t idx_col = j + col_offset;
-      neighbors[idx_row].evaluate_point(std::pair<double, size_t>(dists(i, j), idx_col));
-      neighbors[idx_col].evaluate_point(std::pair<double, size_t>(dists(i, j), idx_row));
+      points[j] = {dists(i, j), j + col_offset};
     }
+    neighbors[i + row_offset].evaluate_points(points);
   }
 }
 
@@ -819,6 +837,41 @@ double neighbor_candidates::get_radius() const {
 }
 
 
+/**
+ * Add a point to the candidates, with the heap lock held.
+ */
+inline void neighbor_candidates::insert_point_locked(
+    const std::pair<double, size_t>& point) {
+
+  // If k is not defined, meeting the radius constraint is sufficient to add
+  // the point to the candidates *vector*
+  if (k == NONE_FLAG) {
+    candidates.push_back(point);
+
+  // If k is defined, then need to follow the logic of adding to the fixed
+  // length heap.
+  } else {
+
+    // If the heap isn't full, push the point but don't pop any old candidates
+    if (candidates.size() < k) {
+      candidates.push_back(point);
+      std::push_heap(candidates.begin(), candidates.end());
+
+    // If the heap is full and the new point's distances is less than the max
+    // distance, push the new point and pop the existing candidate with the
+    // max distance.
+    } else {
+      if (point.first < candidates[0].first) {
+        candidates.push_back(point);
+        std::push_heap(candidates.begin(), candidates.end());
+        std::pop_heap(candidates.begin(), candidates.end());
+        candidates.pop_back();
+      }
+    }
+  }
+}
+
+
 /**
 * Evaluate a point as a nearest neighbors candidate.
 */
@@ -837,38 +890,43 @@ void neighbor_candidates::evaluate_point(const std::pair<double, size_t>& point)
   // First check if the radius constraint is either undefined or defined and
   // satisfied
   if (((radius >= 0) && (point.first <= radius)) || (radius < 0)) {
-
-    // If k is not defined, meeting the radius constraint is sufficient to add
-    // the point to the candidates *vector*
     heap_lock.lock();
+    insert_point_locked(point);
+    heap_lock.unlock();
+  }
+}
 
-    if (k == NONE_FLAG) {
-      candidates.push_back(point);
 
-    // If k is defined, then need to follow the logic of adding to the fixed
-    // length heap.
-    } else {
+/**
+ * Evaluate a batch of points as nearest neighbors candidates.
+ */
+void neighbor_candidates::evaluate_points(
+    std::vector<std::pair<double, size_t>>& points) {
 
-      // If the heap isn't full, push the point but don't pop any old candidates
-      if (candidates.size() < k) {
-        candidates.push_back(point);
-        std::push_heap(candidates.begin(), candidates.end());
+  if(k == 0)
+    return;
 
-      // If the heap is full and the new point's distances is less than the max
-      // distance, push the new point and pop the existing candidate with the
-      // max distance.
-      } else {
-        if (point.first < candidates[0].first) {
-          candidates.push_back(point);
-          std::push_heap(candidates.begin(), candidates.end());
-          std::pop_heap(candidates.begin(), candidates.end());
-          candidates.pop_back();
-        }
-      }
-    }
+  // Drop the self edge and the points outside the radius.
+  auto drop = [&](const std::pair<double, size_t>& point) {
+    return ((point.second == label) && (!include_self_edges))
+        || ((radius >= 0) && !(point.first <= radius));
+  };
+  points.erase(std::remove_if(points.begin(), points.end(), drop), points.end());
 
-    heap_lock.unlock();
+  // Only the k closest points of the batch can end up in the heap. Ties go
+  // to the lower index, as they would when evaluating the points in order.
+  if (k != NONE_FLAG && points.size() > k) {
+    extract_and_sort_top_k(points, k, std::greater<std::pair<double, size_t>>());
+  }
+
+  if (points.empty())
+    return;
+
+  heap_lock.lock();
+  for (const auto& point : points) {
+    insert_point_locked(point);
   }
+  heap_lock.unlock();
 }
 
 
@@ -576,6 +576,11 @@ class EXPORT nearest_neighbors_model : public ml_model_base {
  *      a candidate. If 'k' is specified and the heap is full, this also pops
  *      off the furthest point in the candidates vector.
  *
+ * - evaluate_points:
+ *      Evaluate a batch of points, e.g. a column of a block distance matrix.
+ *      Only the k closest points of the batch are merged into the
+ *      candidates, under a single lock.
+ *
  * - print_candidates:
  *      Print all of the candidates with logprogress_stream.
  *
@@ -596,6 +601,10 @@ class neighbor_candidates {
   double radius = -1.0;
   simple_spinlock heap_lock;
 
+  // Add a point that passed the self edge and radius checks; the lock must
+  // be held.
+  inline void insert_point_locked(const std::pair<double, size_t>& point);
+
  public:
 
   // each candidate is both an index and distance
@@ -634,6 +643,16 @@ class neighbor_candidates {
    */
   void evaluate_point(const std::pair<double, size_t>& point) GL_HOT_FLATTEN;
 
+  /**
+   * Evaluate a batch of reference points as nearest neighbor candidates. The
+   * result is the same as calling evaluate_point on each of them, but the k
+   * closest points of the batch are selected first and merged with one lock.
+   *
+   * \param[in,out] points Reference points to consider; reordered and
+   * truncated in the process.
+   */
+  void evaluate_points(std::vector<std::pair<double, size_t>>& points) GL_HOT_FLATTEN;
+
   /**
    * Print all of the current candidates.
    */
@@ -0,0 +1,235 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <toolkits/nearest_neighbors/product_quantizer.hpp>
+#include <toolkits/ml_data_2/ml_data_iterators.hpp>
+#include <core/parallel/lambda_omp.hpp>
+#include <core/random/random.hpp>
+#include <core/logging/assertions.hpp>
+#include <algorithm>
+#include <limits>
+
+namespace turi {
+namespace nearest_neighbors {
+
+
+/**
+ * Learn the centroids of each group with k-means.
+ */
+void product_quantizer::train(const DenseMatrix& sample, size_t _num_subspaces,
+                              size_t max_iterations) {
+
+  ASSERT_GT(sample.rows(), 0);
+  ASSERT_GT(_num_subspaces, 0);
+  ASSERT_LE(_num_subspaces, size_t(sample.cols()));
+
+  dimension = sample.cols();
+  num_subspaces = _num_subspaces;
+  num_centroids = std::min<size_t>(256, sample.rows());
+  symmetric_tables.clear();
+
+  sub_begin.resize(num_subspaces + 1);
+  for (size_t j = 0; j <= num_subspaces; ++j) {
+    sub_begin[j] = (j * dimension) / num_subspaces;
+  }
+
+  // Start every group from the same random, distinct sample points.
+  std::vector<size_t> start_rows(sample.rows());
+  for (size_t i = 0; i < start_rows.size(); ++i) {
+    start_rows[i] = i;
+  }
+  random::shuffle(start_rows);
+
+  centroids.assign(num_centroids * dimension, 0);
+  const size_t num_rows = sample.rows();
+
+  parallel_for(0, num_subspaces, [&](size_t j) {
+    const size_t b = sub_begin[j];
+    const size_t d = sub_begin[j + 1] - b;
+
+    auto cent = [&](size_t c) {
+      return Eigen::Map<DenseVector>(&centroids[num_centroids * b + c * d], d);
+    };
+
+    for (size_t c = 0; c < num_centroids; ++c) {
+      cent(c) = sample.block(start_rows[c], b, 1, d).transpose();
+    }
+
+    std::vector<size_t> assignment(num_rows, size_t(-1));
+    DenseMatrix sums(d, num_centroids);
+    std::vector<size_t> counts(num_centroids);
+
+    for (size_t iter = 0; iter < max_iterations; ++iter) {
+      bool changed = false;
+      sums.setZero();
+      std::fill(counts.begin(), counts.end(), 0);
+
+      for (size_t i = 0; i < num_rows; ++i) {
+        DenseVector x = sample.block(i, b, 1, d).transpose();
+        size_t best = 0;
+        double best_dist = std::numeric_limits<double>::max();
+
+        for (size_t c = 0; c < num_centroids; ++c) {
+          double dist = (x - cent(c)).squaredNorm();
+          if (dist < best_dist) {
+            best_dist = dist;
+            best = c;
+          }
+        }
+
+        changed |= (assignment[i] != best);
+        assignment[i] = best;
+        sums.col(best) += x;
+        ++counts[best];
+      }
+
+      if (!changed) break;
+
+      // Empty clusters keep their centroid.
+      for (size_t c = 0; c < num_centroids; ++c) {
+        if (counts[c] > 0) {
+          cent(c) = sums.col(c) / double(counts[c]);
+        }
+      }
+    }
+  });
+}
+
+
+/**
+ * Learn the centroids from a random sample of an ml_data.
+ */
+void product_quantizer::train(const v2::ml_data& data, size_t _num_subspaces,
+                              bool normalize, size_t max_sample_size) {
+
+  v2::ml_data sample_data = data;
+  if (data.size() > max_sample_size) {
+    sample_data = data.create_subsampled_copy(max_sample_size, random::fast_uniform<size_t>(0, size_t(-1)));
+  }
+
+  DenseMatrix sample(sample_data.size(), data.metadata()->num_dimensions());
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    for (auto it = sample_data.get_iterator(thread_idx, num_threads); !it.done(); ++it) {
+      it.fill_eigen_row(sample.row(it.row_index()));
+      if (normalize) {
+        sample.row(it.row_index()) /= std::max(1e-16, sample.row(it.row_index()).norm());
+      }
+    }
+  });
+
+  train(sample, _num_subspaces);
+}
+
+
+/**
+ * Code of a point.
+ */
+void product_quantizer::encode(const double* x, uint8_t* code) const {
+  for (size_t j = 0; j < num_subspaces; ++j) {
+    const size_t d = sub_begin[j + 1] - sub_begin[j];
+    Eigen::Map<const DenseVector> xs(x + sub_begin[j], d);
+
+    size_t best = 0;
+    double best_dist = std::numeric_limits<double>::max();
+    for (size_t c = 0; c < num_centroids; ++c) {
+      double dist = (xs - Eigen::Map<const DenseVector>(centroid(j, c), d)).squaredNorm();
+      if (dist < best_dist) {
+        best_dist = dist;
+        best = c;
+      }
+    }
+    code[j] = uint8_t(best);
+  }
+}
+
+
+/**
+ * Encode all the rows of an ml_data.
+ */
+void product_quantizer::encode(const v2::ml_data& data, bool normalize,
+                               std::vector<uint8_t>& codes) const {
+
+  DASSERT_EQ(data.metadata()->num_dimensions(), dimension);
+  codes.assign(data.size() * code_size(), 0);
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    DenseVector x(dimension);
+    for (auto it = data.get_iterator(thread_idx, num_threads); !it.done(); ++it) {
+      it.fill_eigen_row(x);
+      if (normalize) {
+        x /= std::max(1e-16, x.norm());
+      }
+      encode(x.data(), &codes[it.row_index() * code_size()]);
+    }
+  });
+}
+
+
+/**
+ * Point rebuilt from its code.
+ */
+void product_quantizer::decode(const uint8_t* code, double* x) const {
+  for (size_t j = 0; j < num_subspaces; ++j) {
+    const size_t d = sub_begin[j + 1] - sub_begin[j];
+    std::copy(centroid(j, code[j]), centroid(j, code[j]) + d, x + sub_begin[j]);
+  }
+}
+
+
+/**
+ * Squared distances from each group of x to its centroids.
+ */
+void product_quantizer::distance_table(const double* x,
+                                       std::vector<float>& table) const {
+  table.resize(num_subspaces * num_centroids);
+
+  for (size_t j = 0; j < num_subspaces; ++j) {
+    const size_t d = sub_begin[j + 1] - sub_begin[j];
+    Eigen::Map<const DenseVector> xs(x + sub_begin[j], d);
+
+    for (size_t c = 0; c < num_centroids; ++c) {
+      table[j * num_centroids + c] =
+        (xs - Eigen::Map<const DenseVector>(centroid(j, c), d)).squaredNorm();
+    }
+  }
+}
+
+
+/**
+ * Centroid to centroid distances of each group.
+ */
+void product_quantizer::init_symmetric_tables() {
+  const size_t table_size = num_centroids * num_centroids;
+  symmetric_tables.resize(num_subspaces * table_size);
+
+  parallel_for(0, num_subspaces, [&](size_t j) {
+    const size_t d = sub_begin[j + 1] - sub_begin[j];
+    float* t = &symmetric_tables[j * table_size];
+
+    for (size_t a = 0; a < num_centroids; ++a) {
+      Eigen::Map<const DenseVector> ca(centroid(j, a), d);
+      for (size_t b = 0; b < num_centroids; ++b) {
+        t[a * num_centroids + b] =
+          (ca - Eigen::Map<const DenseVector>(centroid(j, b), d)).squaredNorm();
+      }
+    }
+  });
+}
+
+
+void product_quantizer::save(turi::oarchive& oarc) const {
+  oarc << dimension << num_subspaces << num_centroids << sub_begin << centroids;
+}
+
+
+void product_quantizer::load(turi::iarchive& iarc) {
+  iarc >> dimension >> num_subspaces >> num_centroids >> sub_begin >> centroids;
+  symmetric_tables.clear();
+}
+
+
+}  // namespace nearest_neighbors
+}  // namespace turi
@@ -0,0 +1,159 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_NN_PRODUCT_QUANTIZER_H_
+#define TURI_NN_PRODUCT_QUANTIZER_H_
+
+#include <vector>
+#include <cstdint>
+#include <toolkits/nearest_neighbors/distance_functions.hpp>
+#include <toolkits/ml_data_2/ml_data.hpp>
+#include <core/storage/serialization/serialization_includes.hpp>
+
+namespace turi {
+namespace nearest_neighbors {
+
+
+/**
+ * Product quantizer for dense reference data.
+ * -----------------------------------------------------------------------------
+ *
+ * The features are split into num_subspaces contiguous groups, and each group
+ * is quantized to one of at most 256 centroids learned by k-means on a sample
+ * of the data. A point is then stored as one byte per group: with 512
+ * features and 64 groups, 64 bytes instead of 4096.
+ *
+ * Squared euclidean distances from a full query vector to the stored points
+ * are computed asymmetrically: a table of the distances from each group of
+ * the query to each centroid of that group is built once per query, after
+ * which the distance to a point is a sum of num_subspaces table lookups.
+ * Distances between two stored points can use a precomputed table of the
+ * distances between centroids.
+ *
+ * Cosine distances are handled by the caller, as half the squared euclidean
+ * distance between normalized vectors.
+ */
+class EXPORT product_quantizer {
+
+ public:
+
+  /**
+   * Learn the centroids from sample points.
+   *
+   * \param[in] sample One point per row.
+   * \param[in] num_subspaces Number of groups of features; at most the
+   * number of features.
+   * \param[in] max_iterations Maximum number of k-means iterations.
+   */
+  void train(const DenseMatrix& sample, size_t num_subspaces,
+             size_t max_iterations = 25);
+
+  /**
+   * Learn the centroids from a random sample of the rows of an ml_data.
+   * Dense rows only; with normalize, each row is scaled to unit norm first.
+   */
+  void train(const v2::ml_data& data, size_t num_subspaces, bool normalize,
+             size_t max_sample_size = 256 * 64);
+
+  /**
+   * Number of bytes of a code.
+   */
+  inline size_t code_size() const { return num_subspaces; }
+
+  /**
+   * Number of features of a point.
+   */
+  inline size_t num_dimensions() const { return dimension; }
+
+  /**
+   * Whether the quantizer was trained.
+   */
+  inline bool empty() const { return num_subspaces == 0; }
+
+  /**
+   * Code of a point: the nearest centroid of each group.
+   */
+  void encode(const double* x, uint8_t* code) const;
+
+  /**
+   * Encode all the rows of an ml_data, one code after the other; with
+   * normalize, each row is scaled to unit norm first.
+   */
+  void encode(const v2::ml_data& data, bool normalize,
+              std::vector<uint8_t>& codes) const;
+
+  /**
+   * Point rebuilt from its code.
+   */
+  void decode(const uint8_t* code, double* x) const;
+
+  /**
+   * Squared distances from each group of x to the centroids of the group,
+   * for table_distance.
+   */
+  void distance_table(const double* x, std::vector<float>& table) const;
+
+  /**
+   * Approximate squared euclidean distance from the point of a distance
+   * table to a code.
+   */
+  inline double table_distance(const std::vector<float>& table,
+                               const uint8_t* code) const {
+    double ret = 0;
+    const float* t = table.data();
+    for (size_t j = 0; j < num_subspaces; ++j, t += num_centroids) {
+      ret += t[code[j]];
+    }
+    return ret;
+  }
+
+  /**
+   * Build the centroid to centroid tables used by symmetric_distance.
+   */
+  void init_symmetric_tables();
+
+  /**
+   * Approximate squared euclidean distance between two codes; needs
+   * init_symmetric_tables.
+   */
+  inline double symmetric_distance(const uint8_t* a, const uint8_t* b) const {
+    double ret = 0;
+    const float* t = symmetric_tables.data();
+    const size_t table_size = num_centroids * num_centroids;
+    for (size_t j = 0; j < num_subspaces; ++j, t += table_size) {
+      ret += t[a[j] * num_centroids + b[j]];
+    }
+    return ret;
+  }
+
+  void save(turi::oarchive& oarc) const;
+  void load(turi::iarchive& iarc);
+
+ private:
+
+  size_t dimension = 0;
+  size_t num_subspaces = 0;
+  size_t num_centroids = 0;
+
+  // Features of group j are [sub_begin[j], sub_begin[j + 1]).
+  std::vector<size_t> sub_begin;
+
+  // Centroids of group j: num_centroids rows of its features, starting at
+  // num_centroids * sub_begin[j].
+  std::vector<double> centroids;
+
+  std::vector<float> symmetric_tables;
+
+  inline const double* centroid(size_t j, size_t c) const {
+    return &centroids[num_centroids * sub_begin[j]
+                      + c * (sub_begin[j + 1] - sub_begin[j])];
+  }
+};
+
+
+}  // namespace nearest_neighbors
+}  // namespace turi
+
+#endif
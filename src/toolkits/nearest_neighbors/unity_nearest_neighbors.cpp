@@ -20,6 +20,7 @@
 #include <toolkits/nearest_neighbors/brute_force_neighbors.hpp>
 #include <toolkits/nearest_neighbors/ball_tree_neighbors.hpp>
 #include <toolkits/nearest_neighbors/lsh_neighbors.hpp>
+#include <toolkits/nearest_neighbors/hnsw_neighbors.hpp>
 
 // Miscellaneous
 #include <core/export.hpp>
@@ -35,11 +36,14 @@ std::vector<std::string> get_model_option_keys(std::string model_name) {
 
   // Brute-force
   if (model_name == "nearest_neighbors_brute_force") {
-    return {"label"};
+    return {"label", "num_subspaces"};
   } else if (model_name == "nearest_neighbors_ball_tree") {
     return {"leaf_size", "label"};
   } else if (model_name == "nearest_neighbors_lsh") {
-    return {"num_tables", "num_projections_per_table", "label"};
+    return {"num_tables", "num_projections_per_table", "num_probes", "label"};
+  } else if (model_name == "nearest_neighbors_hnsw") {
+    return {"max_connections", "ef_construction", "ef_search", "num_subspaces",
+            "label"};
   } else { // Not a nearest neighbors model. This should never happen.
     log_and_throw(model_name + " is not a nearest neighbors model.");
     return {};
@@ -185,6 +189,8 @@ variant_map_type train(variant_map_type& params) {
     model.reset(new ball_tree_neighbors);
   } else if (model_name == "nearest_neighbors_lsh"){
     model.reset(new lsh_neighbors);
+  } else if (model_name == "nearest_neighbors_hnsw"){
+    model.reset(new hnsw_neighbors);
   } else {
     log_and_throw(model_name + " is not a nearest neighbors model.");
   }
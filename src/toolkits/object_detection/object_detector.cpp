@@ -19,6 +19,7 @@
 
 #include <core/logging/assertions.hpp>
 #include <core/logging/logger.hpp>
+#include <core/parallel/lambda_omp.hpp>
 #include <core/random/random.hpp>
 #include <toolkits/coreml_export/neural_net_models_exporter.hpp>
 #include <toolkits/object_detection/od_evaluation.hpp>
@@ -86,6 +87,13 @@ constexpr int SPATIAL_REDUCTION = 32;
 
 constexpr float BASE_LEARNING_RATE = 0.001f;
 
+// Threads loading the images of the upcoming batches while the model trains.
+constexpr size_t NUM_PREFETCH_WORKERS = 4;
+
+// Training batches submitted to the model whose loss has not been read yet.
+// The next batch is prepared while this many are in flight.
+constexpr size_t NUM_TRAINING_BATCHES_IN_FLIGHT = 3;
+
 constexpr float DEFAULT_NON_MAXIMUM_SUPPRESSION_THRESHOLD = 0.45f;
 
 constexpr float DEFAULT_CONFIDENCE_THRESHOLD_PREDICT = 0.25f;
@@ -268,6 +276,13 @@ void object_detector::init_options(
       /* default_value     */ "center",
       /* allowed_values    */ {flexible_type("center"), flexible_type("top_left"), flexible_type("bottom_left")},
       /* allowed_overwrite */ false);
+  options.create_string_option(
+      /* name              */ "image_cache_directory",
+      /* description       */
+      "Local directory in which to keep the training images, resized to the "
+      "model input size, so that training does not decode them again",
+      /* default_value     */ FLEX_UNDEFINED,
+      /* allowed_overwrite */ false);
 
   // Validate user-provided options.
   options.set_options(opts);
@@ -703,7 +718,14 @@ void object_detector::perform_predict(gl_sframe data,
       // Pop one batch from the queue.
       image_augmenter::result batch = pending_batches.front();
       pending_batches.pop();
-      for (size_t i = 0; i < batch.annotations_batch.size(); ++i) {
+
+      // Wait for the model output once, before the workers read it.
+      batch.image_batch.data();
+
+      // Decode the predictions of the images of the batch in parallel.
+      const size_t num_images = batch.annotations_batch.size();
+      std::vector<std::vector<image_annotation>> batch_predictions(num_images);
+      parallel_for(0, num_images, [&](size_t i) {
         // For this row (corresponding to one image), extract the prediction.
         shared_float_array raw_prediction = batch.image_batch[i];
 
@@ -713,10 +735,13 @@ void object_detector::perform_predict(gl_sframe data,
                                         confidence_threshold);
 
         // Remove overlapping predictions.
-        predicted_annotations = apply_non_maximum_suppression(
+        batch_predictions[i] = apply_non_maximum_suppression(
             std::move(predicted_annotations), iou_threshold);
+      });
 
-        consumer(predicted_annotations, batch.annotations_batch[i]);
+      // Pass the results on in order.
+      for (size_t i = 0; i < num_images; ++i) {
+        consumer(batch_predictions[i], batch.annotations_batch[i]);
       }
     }
   };
@@ -958,6 +983,24 @@ std::unique_ptr<data_iterator> object_detector::create_iterator(
   iterator_params.image_column_name = read_state<flex_string>("feature");
   iterator_params.class_labels = std::move(class_labels);
   iterator_params.repeat = repeat;
+  iterator_params.num_prefetch_workers = NUM_PREFETCH_WORKERS;
+
+  // Cache the resized training images if requested. Models saved before this
+  // option existed do not have it.
+  auto cache_dir_it = state.find("image_cache_directory");
+  if (repeat && cache_dir_it != state.end() &&
+      variant_get_value<flexible_type>(cache_dir_it->second) != FLEX_UNDEFINED) {
+    iterator_params.image_cache_directory =
+        read_state<flex_string>("image_cache_directory");
+    iterator_params.cached_image_width =
+        read_state<size_t>("grid_width") * SPATIAL_REDUCTION;
+    iterator_params.cached_image_height =
+        read_state<size_t>("grid_height") * SPATIAL_REDUCTION;
+#ifdef __APPLE__
+    // Core Image decodes the images itself, so keep the cached images encoded.
+    iterator_params.decode_cached_images = false;
+#endif
+  }
 
   std::string annotation_origin = read_state<flex_string>("annotation_origin");
   std::string annotation_scale = read_state<flex_string>("annotation_scale");
@@ -1153,9 +1196,22 @@ void object_detector::iterate_training() {
   ASSERT_TRUE(training_data_augmenter_ != nullptr);
   ASSERT_TRUE(training_model_ != nullptr);
 
-  // We want to have no more than two pending batches at a time (double
-  // buffering). We're about to add a new one, so wait until we only have one.
-  wait_for_training_batches(1);
+  // Fetch the next batch of raw images and annotations.
+  flex_int batch_size = read_state<flex_int>("batch_size");
+  std::vector<labeled_image> image_batch =
+      training_data_iterator_->next_batch(static_cast<size_t>(batch_size));
+
+  // Perform data augmentation, while the batches already submitted train.
+  image_augmenter::result augmenter_result =
+      training_data_augmenter_->prepare_images(std::move(image_batch));
+
+  // Encode the labels.
+  shared_float_array label_batch =
+      prepare_label_batch(augmenter_result.annotations_batch);
+
+  // We're about to submit a new batch, so wait until there is room for it,
+  // reading the losses of the oldest batches.
+  wait_for_training_batches(NUM_TRAINING_BATCHES_IN_FLIGHT - 1);
 
   // Update iteration count and check learning rate schedule.
   // TODO: Abstract out the learning rate schedule.
@@ -1177,25 +1233,12 @@ void object_detector::iterate_training() {
   }
 
   // Update the model fields tracking how much training we've done.
-  flex_int batch_size = read_state<flex_int>("batch_size");
   flex_int num_examples = read_state<flex_int>("num_examples");
   add_or_update_state({
       { "training_iterations", iteration_idx + 1 },
       { "training_epochs", (iteration_idx + 1) * batch_size / num_examples },
   });
 
-  // Fetch the next batch of raw images and annotations.
-  std::vector<labeled_image> image_batch =
-      training_data_iterator_->next_batch(static_cast<size_t>(batch_size));
-
-  // Perform data augmentation.
-  image_augmenter::result augmenter_result =
-      training_data_augmenter_->prepare_images(std::move(image_batch));
-
-  // Encode the labels.
-  shared_float_array label_batch =
-      prepare_label_batch(augmenter_result.annotations_batch);
-
   // Submit the batch to the neural net model.
   std::map<std::string, shared_float_array> results = training_model_->train(
       { { "input",  augmenter_result.image_batch },
@@ -5,6 +5,7 @@
 
 #include <core/data/image/io.hpp>
 #include <core/logging/logger.hpp>
+#include <ml/neural_net/image_cache.hpp>
 #include <model_server/lib/image_util.hpp>
 
 namespace turi {
@@ -27,11 +28,37 @@ flex_image get_image(const flexible_type& image_feature) {
   }
 }
 
+// Columns added to the data when the images are cached.
+constexpr char ORIGINAL_WIDTH_COLUMN[] = "__original_width";
+constexpr char ORIGINAL_HEIGHT_COLUMN[] = "__original_height";
+
 gl_sframe get_data(const data_iterator::parameters& params) {
 
   gl_sarray annotations = params.data[params.annotations_column_name];
   gl_sarray images = params.data[params.image_column_name];
 
+  if (params.cached_image_width > 0 && params.cached_image_height > 0) {
+
+    // Decode and resize every image once. Keep the original sizes, since the
+    // annotations may be in pixels.
+    gl_sframe cached = neural_net::resize_images_for_cache(
+        images, params.cached_image_width, params.cached_image_height,
+        /* channels */ 3, params.image_cache_directory,
+        params.decode_cached_images);
+
+    gl_sframe result({ { params.annotations_column_name, annotations      },
+                       { params.image_column_name,       cached["image"]  },
+                       { ORIGINAL_WIDTH_COLUMN,  cached["original_width"]  },
+                       { ORIGINAL_HEIGHT_COLUMN, cached["original_height"] } });
+
+    if (!params.predictions_column_name.empty()) {
+      result[params.predictions_column_name] =
+          params.data[params.predictions_column_name];
+    }
+
+    return result;
+  }
+
   if (images.dtype() == flex_type_enum::IMAGE) {
 
     // Ensure that all images are (losslessly) compressed to minimize the I/O
@@ -278,6 +305,12 @@ simple_data_iterator::simple_data_iterator(const parameters& params)
                        ? -1
                        : data_.column_index(params.predictions_column_name)),
     image_index_(data_.column_index(params.image_column_name)),
+    original_width_index_(data_.contains_column(ORIGINAL_WIDTH_COLUMN)
+                          ? data_.column_index(ORIGINAL_WIDTH_COLUMN)
+                          : -1),
+    original_height_index_(data_.contains_column(ORIGINAL_HEIGHT_COLUMN)
+                           ? data_.column_index(ORIGINAL_HEIGHT_COLUMN)
+                           : -1),
 
     annotation_origin_(params.annotation_origin),
     annotation_scale_(params.annotation_scale),
@@ -297,45 +330,68 @@ simple_data_iterator::simple_data_iterator(const parameters& params)
     next_row_(range_iterator_.begin()),
 
     // Initialize random number generator.
-    random_engine_(params.random_seed)
+    random_engine_(params.random_seed),
+
+    num_prefetch_workers_(params.num_prefetch_workers)
 
 {}
 
 std::vector<labeled_image> simple_data_iterator::next_batch(size_t batch_size) {
 
-  // Accumulate batch_size tuples: (image, annotations, predictions).
-  std::vector<std::tuple<flexible_type,flexible_type,flexible_type>> raw_batch;
-  raw_batch.reserve(batch_size);
-  while (raw_batch.size() < batch_size && next_row_ != range_iterator_.end()) {
+  if (num_prefetch_workers_ == 0) {
+    return process_raw_batch(read_raw_batch(batch_size));
+  }
+
+  if (!prefetcher_) {
+    // Start reading ahead, now that we know the batch size.
+    prefetch_pipeline::options opts;
+    opts.num_workers = num_prefetch_workers_;
+    opts.queue_depth = 2 * num_prefetch_workers_;
+    prefetch_batch_size_ = batch_size;
+    prefetcher_.reset(new prefetch_pipeline(
+        [this, batch_size](raw_batch* out) {
+          *out = read_raw_batch(batch_size);
+          return !out->empty();
+        },
+        [this](raw_batch raw) { return process_raw_batch(raw); },
+        opts));
+  } else if (batch_size != prefetch_batch_size_) {
+    log_and_throw("The batch size must not change while prefetching batches.");
+  }
+
+  // Once the data is exhausted, the batch stays empty.
+  std::vector<labeled_image> result;
+  prefetcher_->next(&result);
+  return result;
+}
+
+simple_data_iterator::raw_batch simple_data_iterator::read_raw_batch(
+    size_t batch_size) {
+
+  // Accumulate the values of batch_size rows.
+  raw_batch result;
+  result.reserve(batch_size);
+  while (result.size() < batch_size && next_row_ != range_iterator_.end()) {
 
     const sframe_rows::row& row = *next_row_;
-    flexible_type preds = FLEX_UNDEFINED;
+    raw_row values;
+    values.image = row[image_index_];
+    values.annotations = row[annotations_index_];
     if (predictions_index_ >= 0) {
-      preds = row[predictions_index_];
+      values.predictions = row[predictions_index_];
+    }
+    if (original_width_index_ >= 0) {
+      values.original_width = row[original_width_index_];
+      values.original_height = row[original_height_index_];
     }
-    raw_batch.emplace_back(row[image_index_], row[annotations_index_], preds);
+    result.push_back(std::move(values));
 
     if (++next_row_ == range_iterator_.end() && repeat_) {
 
       if (shuffle_) {
         // Shuffle the data.
-        // TODO: This heavyweight shuffle operation introduces spikes into the
-        // wall-clock time of this function. SFrame should either provide an
-        // optimized implementation, or we should implement an approach that
-        // amortizes the cost across calls.
-        gl_sarray indices = gl_sarray::from_sequence(0, data_.size());
         std::uniform_int_distribution<uint64_t> dist(0);  // 0 to max uint64_t
-        uint64_t random_mask = dist(random_engine_);
-        auto randomize_indices = [random_mask](const flexible_type& x) {
-          uint64_t masked_index = random_mask ^ x.to<uint64_t>();
-          return flexible_type(hash64(masked_index));
-        };
-        data_.add_column(indices.apply(randomize_indices,
-                                       flex_type_enum::INTEGER,
-                                       /* skip_undefined */ false),
-                         "_random_order");
-        data_ = data_.sort("_random_order");
-        data_.remove_column("_random_order");
+        data_ = data_.shuffle(dist(random_engine_));
       }
 
       // Reset iteration.
@@ -344,23 +400,35 @@ std::vector<labeled_image> simple_data_iterator::next_batch(size_t batch_size) {
     }
   }
 
-  std::vector<labeled_image> result(raw_batch.size());
-  for (size_t i = 0; i < raw_batch.size(); ++i) {
-    flexible_type raw_image, raw_annotations, raw_predictions;
-    std::tie(raw_image, raw_annotations, raw_predictions) = raw_batch[i];
+  return result;
+}
+
+std::vector<labeled_image> simple_data_iterator::process_raw_batch(
+    const raw_batch& raw) const {
+
+  std::vector<labeled_image> result(raw.size());
+  for (size_t i = 0; i < raw.size(); ++i) {
+    const raw_row& values = raw[i];
 
     // Reads the undecoded image data from disk, if necessary.
-    // TODO: Investigate parallelizing this file I/O.
-    result[i].image = get_image(raw_image);
+    result[i].image = get_image(values.image);
+
+    // Pixel annotations refer to the original image, even if it was resized.
+    size_t image_width = result[i].image.m_width;
+    size_t image_height = result[i].image.m_height;
+    if (values.original_width.get_type() == flex_type_enum::INTEGER) {
+      image_width = values.original_width.get<flex_int>();
+      image_height = values.original_height.get<flex_int>();
+    }
 
     result[i].annotations = parse_annotations(
-        raw_annotations, result[i].image.m_width, result[i].image.m_height,
+        values.annotations, image_width, image_height,
         annotation_properties_.class_to_index_map, annotation_origin_, annotation_scale_,
         annotation_position_);
 
-    if (raw_predictions != FLEX_UNDEFINED) {
+    if (values.predictions != FLEX_UNDEFINED) {
       result[i].predictions = parse_annotations(
-          raw_predictions, result[i].image.m_width, result[i].image.m_height,
+          values.predictions, image_width, image_height,
           annotation_properties_.class_to_index_map, annotation_origin_, annotation_scale_,
           annotation_position_);
     }
@@ -7,12 +7,14 @@
 #ifndef TURI_OBJECT_DETECTION_OD_DATA_ITERATOR_HPP_
 #define TURI_OBJECT_DETECTION_OD_DATA_ITERATOR_HPP_
 
+#include <memory>
 #include <random>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include <core/data/sframe/gl_sframe.hpp>
+#include <ml/neural_net/batch_pipeline.hpp>
 #include <ml/neural_net/float_array.hpp>
 #include <ml/neural_net/image_augmentation.hpp>
 
@@ -104,6 +106,28 @@ public:
 
     /** Determines results of shuffle operations if enabled. */
     int random_seed = 0;
+
+    /**
+     * Number of background threads loading the batches ahead of next_batch,
+     * or 0 to load each batch on the calling thread. When prefetching, every
+     * call to next_batch must request the same batch size.
+     */
+    size_t num_prefetch_workers = 0;
+
+    /**
+     * If non-zero, the images are resized to this size once, when the
+     * iterator is created, so that the traversals read the resized images
+     * instead of decoding the originals again. See
+     * neural_net::resize_images_for_cache.
+     */
+    size_t cached_image_width = 0;
+    size_t cached_image_height = 0;
+
+    /** Whether the cached images are decoded, or kept encoded as png. */
+    bool decode_cached_images = true;
+
+    /** If not empty, where to keep the resized images across runs. */
+    std::string image_cache_directory;
   };
 
   virtual ~data_iterator() = default;
@@ -135,11 +159,12 @@ public:
 };
 
 /**
- * Concrete data_iterator implementation that doesn't attempt any
- * parallelization or background I/O.
+ * Concrete data_iterator implementation.
  *
- * \todo This classs should become an abstract_data_iterator base class with
- *       override points for dispatching work to other threads.
+ * Without prefetching, each batch is read and its images loaded on the
+ * calling thread. With num_prefetch_workers > 0, a neural_net::batch_pipeline
+ * reads the rows of the upcoming batches in the background, and loads their
+ * images and parses their annotations in parallel.
  */
 class simple_data_iterator: public data_iterator {
 public:
@@ -167,6 +192,30 @@ private:
     size_t num_instances;
   };
 
+  // The values of a row needed to produce a labeled_image.
+  struct raw_row {
+    flexible_type image;
+    flexible_type annotations;
+    flexible_type predictions = FLEX_UNDEFINED;
+
+    // The size of the image before caching, if cached.
+    flexible_type original_width = FLEX_UNDEFINED;
+    flexible_type original_height = FLEX_UNDEFINED;
+  };
+
+  typedef std::vector<raw_row> raw_batch;
+
+  typedef neural_net::batch_pipeline<raw_batch,
+                                     std::vector<neural_net::labeled_image>>
+      prefetch_pipeline;
+
+  // Takes the next rows, shuffling the data at the end of each traversal.
+  raw_batch read_raw_batch(size_t batch_size);
+
+  // Loads the images and parses the annotations. Safe to call concurrently.
+  std::vector<neural_net::labeled_image> process_raw_batch(
+      const raw_batch& raw) const;
+
   annotation_properties compute_properties(
       const gl_sarray& annotations,
       std::vector<std::string> expected_class_labels);
@@ -175,6 +224,8 @@ private:
   const size_t annotations_index_;
   const ssize_t predictions_index_;
   const size_t image_index_;
+  const ssize_t original_width_index_;
+  const ssize_t original_height_index_;
 
   annotation_origin_enum annotation_origin_;
   annotation_scale_enum annotation_scale_;
@@ -188,6 +239,12 @@ private:
   gl_sframe_range range_iterator_;
   gl_sframe_range::iterator next_row_;
   std::default_random_engine random_engine_;
+
+  const size_t num_prefetch_workers_;
+  size_t prefetch_batch_size_ = 0;
+
+  // Declared last, so that its workers stop before the state they read.
+  std::unique_ptr<prefetch_pipeline> prefetcher_;
 };
 
 }  // object_detection
@@ -10,6 +10,7 @@
 #include <numeric>
 
 #include <core/logging/assertions.hpp>
+#include <core/parallel/lambda_omp.hpp>
 
 namespace turi {
 namespace object_detection {
@@ -112,9 +113,7 @@ private:
 std::vector<image_annotation> apply_non_maximum_suppression(
     std::vector<image_annotation> predictions, float iou_threshold) {
 
-  // We're going to perform this algorithm in place, since it doesn't seem too
-  // much more complex and allows us to avoid any memory allocations whatsoever.
-  // First, sort the predictions first by class and then in descending order of
+  // Sort the predictions first by class and then in descending order of
   // confidence.
   auto comparator = [](const image_annotation& a, const image_annotation& b) {
     if (a.identifier < b.identifier) return true;
@@ -123,64 +122,65 @@ std::vector<image_annotation> apply_non_maximum_suppression(
   };
   std::sort(predictions.begin(), predictions.end(), comparator);
 
-  // Invariant: the range (predictions.begin(), result_end) contains the results
-  // for all classes processed so far.
-  using iterator = std::vector<image_annotation>::iterator;
-  iterator result_end = predictions.begin();
+  // Copy the corners and areas of the boxes into flat arrays, so that the
+  // inner loop below sweeps through contiguous floats, and can reject most
+  // pairs of boxes without computing their intersection.
+  const size_t n = predictions.size();
+  std::vector<float> x_min(n), y_min(n), x_max(n), y_max(n), area(n);
+  for (size_t i = 0; i < n; ++i) {
+    const image_box& box = predictions[i].bounding_box;
+    x_min[i] = box.x;
+    y_min[i] = box.y;
+    x_max[i] = box.x + box.width;
+    y_max[i] = box.y + box.height;
+    area[i] = box.area();
+  }
+  std::vector<char> suppressed(n, 0);
 
-  // Iterate through each class label, one at a time.
-  iterator class_begin = predictions.begin();
-  while (class_begin != predictions.end()) {
+  size_t class_begin = 0;
+  while (class_begin < n) {
 
     // Find the range corresponding to this class label.
-    auto different_class = [=](const image_annotation& ann) {
-      return ann.identifier != class_begin->identifier;
-    };
-    iterator class_end = std::find_if(class_begin + 1, predictions.end(),
-                                      different_class);
-    const iterator next_class_begin = class_end;
-
-    // Filter the predictions for this range to remove overlaps.
-    iterator class_it = class_begin;
-    while (class_it != class_end) {
-
-      // Remove lower-confidence predictions overlapping with *class_it.
-      auto overlaps = [=](const image_annotation& ann) {
-        float iou = compute_iou(class_it->bounding_box, ann.bounding_box);
-        return iou > iou_threshold;
-      };
-      class_end = std::remove_if(class_it + 1, class_end, overlaps);
-
-      // All non-overlapping predictions have been moved (if needed) to the
-      // (possibly smaller) range (class_it, class_end). Whatever's left in
-      // (class_end, next_class_begin) is just garbage now. Move on to the next
-      // kept prediction.
-      ++class_it;
+    const int identifier = predictions[class_begin].identifier;
+    size_t class_end = class_begin + 1;
+    while (class_end < n && predictions[class_end].identifier == identifier) {
+      ++class_end;
     }
 
-    // Add the remaining predictions for this class to our results.
-    if (result_end == class_begin) {
-
-      // We've kept everything so far, so our final results are still a prefix
-      // of the sorted original predictions, plus whatever we've done for this
-      // class.
-      result_end = class_end;
-
-    } else {
-
-      // Copy the results for this class to the end of our accumulated results.
-      // This really just moves these values to an earlier location in
-      // `predictions`.
-      result_end = std::copy(class_begin, class_end, result_end);
+    // Greedily keep each prediction not suppressed by a previous one, and
+    // suppress the lower-confidence predictions overlapping with it.
+    for (size_t i = class_begin; i < class_end; ++i) {
+      if (suppressed[i]) continue;
+
+      for (size_t j = i + 1; j < class_end; ++j) {
+        if (suppressed[j]) continue;
+
+        // Computed as in image_box::clip, so that the results match
+        // compute_iou exactly.
+        float width = std::min(x_max[j], x_max[i]) - std::max(x_min[j], x_min[i]);
+        if (width <= 0.f) continue;
+        float height = std::min(y_max[j], y_max[i]) - std::max(y_min[j], y_min[i]);
+        if (height <= 0.f) continue;
+
+        float intersection_area = width * height;
+        float union_area = area[i] + area[j] - intersection_area;
+        if (intersection_area / union_area > iou_threshold) {
+          suppressed[j] = 1;
+        }
+      }
     }
 
-    // What's left in the range (results_end, next_class_begin) is garbage that
-    // can be overwritten by the next iteration.
-    class_begin = next_class_begin;
+    class_begin = class_end;
   }
 
-  // Take out the garbage.
-  predictions.erase(result_end, predictions.end());
+  // Keep the predictions that were not suppressed, in the same order.
+  size_t num_kept = 0;
+  for (size_t i = 0; i < n; ++i) {
+    if (suppressed[i]) continue;
+    if (num_kept != i) predictions[num_kept] = std::move(predictions[i]);
+    ++num_kept;
+  }
+  predictions.resize(num_kept);
 
   return predictions;
 }
@@ -242,12 +242,11 @@ void average_precision_calculator::add_row(
 
 variant_map_type average_precision_calculator::evaluate() {
 
-  std::vector<std::map<float,float>> raw_average_precisions;
-  raw_average_precisions.reserve(data_.size());
-
-  for (size_t i = 0; i < data_.size(); ++i) {
-    raw_average_precisions.push_back(evaluate_class(i));
-  }
+  // The classes are independent, so evaluate them in parallel.
+  std::vector<std::map<float,float>> raw_average_precisions(data_.size());
+  parallel_for(0, data_.size(), [&](size_t i) {
+    raw_average_precisions[i] = evaluate_class(i);
+  });
 
   // Format the raw results into a variant_map_type.
 
@@ -149,11 +149,18 @@ std::vector<image_annotation> convert_yolo_to_annotations(
 
         // Extract the prediction for this anchor and output grid cell.
         const float* prediction_base = output_cell_base + b * num_predictions;
+
+        // Each class confidence is the object confidence times a class
+        // probability, so skip the (much more expensive) box and softmax
+        // computations for the many anchors whose object confidence alone is
+        // too low.
+        const float conf = sigmoid(prediction_base[4]);
+        if (conf < min_confidence) continue;
+
         const float raw_x = prediction_base[0];
         const float raw_y = prediction_base[1];
         const float raw_w = prediction_base[2];
         const float raw_h = prediction_base[3];
-        const float raw_conf = prediction_base[4];
         const float* one_hot_base = prediction_base + 5;
 
         // Convert from raw output to bounding box (in normalized coordinates)
@@ -164,8 +171,7 @@ std::vector<image_annotation> convert_yolo_to_annotations(
         const float w = std::exp(raw_w) * anchor_w / output_width;
         const float h = std::exp(raw_h) * anchor_h / output_height;
 
-        // Convert overall object confidence and conditional class confidences.
-        const float conf = sigmoid(raw_conf);
+        // Convert the conditional class confidences.
         std::copy(one_hot_base, one_hot_base + num_classes,
                   class_scores.begin());
         apply_softmax(&class_scores);
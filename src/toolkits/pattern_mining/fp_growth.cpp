@@ -14,6 +14,11 @@
 #include <toolkits/feature_engineering/topk_indexer.hpp>
 
 #include <core/util/sys_util.hpp>
+#include <core/parallel/lambda_omp.hpp>
+#include <core/parallel/pthread_tools.hpp>
+
+#include <atomic>
+#include <memory>
 
 namespace turi {
 namespace pattern_mining {
@@ -497,8 +502,35 @@ fp_top_k_results_tree top_k_algorithm(const gl_sarray& database, \
   return closed_itemset_tree;
 }
 
+/**
+ * Results tree of one task of global_top_down_growth. Records the itemsets in
+ * the order they are added, so they can be replayed into the global tree.
+ */
+class fp_task_results_tree : public fp_top_k_results_tree {
+  public:
+    std::vector<std::pair<std::vector<size_t>, size_t>> added_itemsets;
+
+    fp_task_results_tree(const std::vector<size_t>& id_order, \
+        const size_t& k, const size_t& length)
+      : fp_top_k_results_tree(id_order, k, length) {}
+
+    void add_itemset(const std::vector<size_t>& potential_itemset, \
+        const size_t& support) {
+      fp_top_k_results_tree::add_itemset(potential_itemset, support);
+      added_itemsets.emplace_back(potential_itemset, support);
+    }
+};
+
 /**
  * Helper function for top_k_algorithm. Reduces the fp_tree by mining top-down.
+ *
+ * Every itemset mined from the conditional tree of a heading contains that
+ * heading's item, and otherwise only more frequent items, so no itemset of a
+ * later heading can make it redundant. The conditional trees are therefore
+ * mined in parallel, one task per heading, each into its own results tree.
+ * The tasks are merged into closed_itemset_tree in heading order as they
+ * finish, checking redundancy and raising min_support exactly as a serial
+ * pass would. Tasks start from the min_support reached so far.
  */
 void global_top_down_growth(fp_top_k_tree& my_tree,  \
     fp_top_k_results_tree& closed_itemset_tree, size_t& min_support){
@@ -514,61 +546,105 @@ void global_top_down_growth(fp_top_k_tree& my_tree,  \
                        {"Elapsed Time", 16}});
   table.print_header();
 
-  // For each frequent singleton (in increasing order)
-  auto& headings = my_tree.header.headings;
-  size_t counter = 0;
-  for(auto it = headings.begin(); it != headings.end(); it++){
+  const auto& headings = my_tree.header.headings;
+  const size_t num_headings = headings.size();
+  const std::vector<size_t> id_order = my_tree.header.get_ids();
+
+  // Finished tasks waiting to be merged, in heading order.
+  std::vector<std::unique_ptr<fp_task_results_tree>> task_results(num_headings);
+  std::vector<char> task_done(num_headings, false);
+  size_t next_to_merge = 0;
+  size_t num_done = 0;
+  turi::mutex merge_lock;
+
+  // Read by the tasks; only raised under merge_lock.
+  std::atomic<size_t> current_min_support(min_support);
+  std::atomic<size_t> next_task(0);
+
+  // Merge the tasks finished so far. Called with merge_lock held.
+  auto merge_finished_tasks = [&]() {
+    while(next_to_merge < num_headings && task_done[next_to_merge]){
+      auto& task = task_results[next_to_merge];
+      if(task != nullptr){
+        for(const auto& itemset_support: task->added_itemsets){
+          const std::vector<size_t>& itemset = itemset_support.first;
+          const size_t& support = itemset_support.second;
+
+          // Save itemset if it is a closed itemset
+          if((support >= min_support) &&
+              (!closed_itemset_tree.is_itemset_redundant(itemset, support))){
+            closed_itemset_tree.add_itemset(itemset, support);
+
+            // Try to raise min_support
+            size_t current_top_k_bound = closed_itemset_tree.get_min_support_bound();
+            min_support = std::max(min_support, current_top_k_bound);
+          }
+        }
+        task.reset();
+      }
+      next_to_merge++;
+    }
+    current_min_support = min_support;
+  };
 
-    auto& heading = *it;
-    size_t& id = heading.id;
-    size_t& support = heading.support;
-    size_t num_patterns = closed_itemset_tree.min_support_heap.size();
-    table.print_row(counter, num_patterns, support, min_support, progress_time());
-    counter++;
+  // For each frequent singleton (in decreasing order)
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    while(true){
+      size_t i = next_task++;
+      if(i >= num_headings){
+        break;
+      }
 
-    // Check if support in transaction of min_length is large enough
-    // size_t support_at_depth = my_tree.get_support(heading, my_tree.get_min_depth());
-    size_t& support_at_depth = support; // Fix for predict
-    if(support_at_depth >= min_support){
-      std::vector<size_t> new_prefix = my_tree.root_prefix;
-      new_prefix.push_back(id);
+      const fp_tree_heading& heading = headings[i];
+      const size_t& support = heading.support;
+      size_t task_min_support = current_min_support;
+      std::unique_ptr<fp_task_results_tree> task;
+
+      // Check if support in transaction of min_length is large enough
+      if(support >= task_min_support){
+        task.reset(new fp_task_results_tree(id_order, \
+            closed_itemset_tree.top_k, closed_itemset_tree.min_length));
+
+        std::vector<size_t> new_prefix = my_tree.root_prefix;
+        new_prefix.push_back(heading.id);
 
-      // Check if new_prefix could be a closed itemset
-      if(!closed_itemset_tree.is_itemset_redundant(new_prefix,support)){
         // Build conditional database for new prefix
-        fp_top_k_tree new_tree = my_tree.build_cond_tree(heading, min_support);
+        fp_top_k_tree new_tree = my_tree.build_cond_tree(heading, \
+            task_min_support);
 
         // Try to raise min_support
         size_t closed_node_bound = new_tree.get_min_support_bound();
-        min_support = std::max(min_support, closed_node_bound);
-
-        // (Future Optimization) Implement Anchor Bound
-        //  size_t anchor_bound = new_tree.get_anchor_min_support_bound();
-        //  min_support = std::max(min_support, anchor_bound);
+        task_min_support = std::max(task_min_support, closed_node_bound);
 
         // Prune new_tree
-        new_tree.prune_tree(min_support);
+        new_tree.prune_tree(task_min_support);
 
         // Recurse
-        local_bottom_up_growth(new_tree, closed_itemset_tree, \
-            min_support);
+        local_bottom_up_growth(new_tree, *task, task_min_support);
 
         // Save new_prefix if it is a closed itemset
-        if((support >= min_support) &&
-            (!closed_itemset_tree.is_itemset_redundant(new_prefix, support))) {
-          closed_itemset_tree.add_itemset(new_prefix, support);
-
-          // Try to raise min_support
-          size_t current_top_k_bound = closed_itemset_tree.get_min_support_bound();
-          min_support = std::max(min_support, current_top_k_bound);
+        if((support >= task_min_support) &&
+            (!task->is_itemset_redundant(new_prefix, support))) {
+          task->add_itemset(new_prefix, support);
         }
+      }
 
-        // Prune original_tree on new min_support
-        my_tree.prune_tree(min_support);
+      std::lock_guard<turi::mutex> guard(merge_lock);
+      task_results[i] = std::move(task);
+      task_done[i] = true;
+      num_done++;
 
-      }
+      // The conditional tree bounds hold for the whole database.
+      min_support = std::max(min_support, task_min_support);
+      merge_finished_tasks();
+
+      table.print_progress_row(num_done, num_done, \
+          closed_itemset_tree.min_support_heap.size(), support, \
+          min_support, progress_time());
     }
-  }
+  });
+
+  DASSERT_EQ(next_to_merge, num_headings);
 
   // Final row.
   table.print_row("Final",
@@ -5,6 +5,7 @@
  */
 #include <toolkits/pattern_mining/fp_tree.hpp>
 #include <core/util/basic_types.hpp>
+#include <core/parallel/lambda_omp.hpp>
 
 namespace turi {
 namespace pattern_mining {
@@ -321,14 +322,30 @@ namespace pattern_mining {
   std::vector<std::pair<size_t, size_t>> get_item_counts( \
       const gl_sarray& database){
 
+    // Count each range of transactions in parallel
+    std::vector<std::map<size_t, size_t>> thread_frequency_maps(thread::cpu_count());
+    size_t num_transactions = database.size();
+    in_parallel([&](size_t thread_idx, size_t num_threads) {
+      size_t start_idx = num_transactions * thread_idx / num_threads;
+      size_t end_idx = num_transactions * (thread_idx + 1) / num_threads;
+      auto& frequency_map = thread_frequency_maps[thread_idx];
+
+      // For Each Transaction
+      for(const auto& transaction_array: \
+          database.range_iterator(start_idx, end_idx)) {
+        // Get Transaction
+        std::vector<size_t> new_transaction = flex_to_id_vector(transaction_array);
+        // Count Each Item
+        for(const size_t& item_id: new_transaction){
+          frequency_map[item_id]++;
+        }
+      }
+    });
+
     std::map<size_t, size_t> item_frequency_map;
-    // For Each Transaction
-    for(const auto& transaction_array: database.range_iterator()) {
-      // Get Transaction
-      std::vector<size_t> new_transaction = flex_to_id_vector(transaction_array);
-      // Count Each Item
-      for(const size_t& item_id: new_transaction){
-        item_frequency_map[item_id]++;
+    for(const auto& frequency_map: thread_frequency_maps){
+      for(const auto& item_count: frequency_map){
+        item_frequency_map[item_count.first] += item_count.second;
       }
     }
 
@@ -8,6 +8,7 @@
 #include <toolkits/recsys/models/factorization_models.hpp>
 #include <toolkits/nearest_neighbors/nearest_neighbors.hpp>
 #include <toolkits/nearest_neighbors/brute_force_neighbors.hpp>
+#include <toolkits/nearest_neighbors/hnsw_neighbors.hpp>
 #include <core/logging/table_printer/table_printer.hpp>
 
 #include <toolkits/factorization/als.hpp>
@@ -97,6 +98,8 @@ recsys_factorization_model_base::train(const v2::ml_data& training_data_by_user,
   table.print_footer();
 
 
+  item_index.reset();
+
   // Solve by ALS
   if (include_ranking_options()){
     model = als::implicit_als(training_data_by_user,
@@ -232,6 +235,8 @@ recsys_factorization_model_base::train(const v2::ml_data& training_data) {
       ? "factorization_machine"
       : "matrix_factorization");
 
+  item_index.reset();
+
   model = factorization::factorization_model::factory_train(factor_mode, training_data, cur_options);
 
 
@@ -327,13 +332,169 @@ void recsys_factorization_model_base::score_all_items(
   model->score_all_items(scores, query_row, top_k, known_side_features);
 }
 
+bool recsys_factorization_model_base::can_score_users_in_blocks() const {
+  // Side columns or other observation columns add their own terms to
+  // each query.
+  return metadata->num_columns() == 2 && model->can_score_users_in_blocks();
+}
+
+void recsys_factorization_model_base::score_top_k_items(
+    std::vector<std::vector<std::pair<size_t, double> > >& top_items,
+    const std::vector<size_t>& users,
+    size_t num_items,
+    size_t top_k,
+    const std::vector<std::vector<size_t> >& excluded_items) const {
+
+  if(item_index != nullptr) {
+    score_top_k_items_from_index(top_items, users, top_k, excluded_items);
+  } else {
+    model->score_top_k_items(top_items, users, num_items, top_k, excluded_items);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void recsys_factorization_model_base::build_item_index(
+    const std::map<std::string, flexible_type>& index_options) {
+
+  if(model == nullptr) {
+    log_and_throw("build_item_index requires a trained model.");
+  }
+
+  if(options.value("num_factors") == 0 || !can_score_users_in_blocks()) {
+    log_and_throw("build_item_index requires a model trained with num_factors > 0, "
+                  "and with no side data or additional observation columns.");
+  }
+
+  const size_t n_items = model->index_sizes[ITEM_COLUMN_INDEX];
+
+  if(n_items == 0) {
+    log_and_throw("build_item_index requires a model trained with at least one item.");
+  }
+
+  // The factors and linear term of each item, and their squared norm.
+  std::vector<flex_vec> points(n_items);
+  std::vector<double> squared_norms(n_items);
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+    std::vector<double> factors;
+    double linear_term;
+
+    size_t start_idx = (thread_idx * n_items) / num_threads;
+    size_t end_idx   = ((thread_idx + 1) * n_items) / num_threads;
+
+    for(size_t i = start_idx; i < end_idx; ++i) {
+      model->get_factors(ITEM_COLUMN_INDEX, i, factors, linear_term);
+
+      flex_vec& x = points[i];
+      x.reserve(factors.size() + 2);
+      x.assign(factors.begin(), factors.end());
+      x.push_back(linear_term);
+
+      double sq = 0;
+      for(double v : x) sq += v * v;
+      squared_norms[i] = sq;
+    }
+  });
+
+  // The extra coordinate brings every item to the same norm, so the
+  // distance to a query varies only with the inner product.
+  double max_squared_norm = *std::max_element(squared_norms.begin(), squared_norms.end());
+
+  sframe X;
+  X.open_for_write({"factors"}, {flex_type_enum::VECTOR}, "", 1);
+  auto it_out = X.get_output_iterator(0);
+
+  for(size_t i = 0; i < n_items; ++i) {
+    points[i].push_back(std::sqrt(std::max(0.0, max_squared_norm - squared_norms[i])));
+    *it_out = std::vector<flexible_type>{std::move(points[i])};
+    ++it_out;
+  }
+
+  X.close();
+
+  auto fn = function_closure_info();
+  fn.native_fn_name = "_distances.euclidean";
+
+  std::vector<nearest_neighbors::dist_component_type> composite_params
+      = {std::make_tuple(std::vector<std::string>{"factors"}, fn, 1.0)};
+
+  std::vector<flexible_type> item_labels(n_items);
+  for(size_t i = 0; i < n_items; ++i) {
+    item_labels[i] = i;
+  }
+
+  auto new_index = std::make_shared<nearest_neighbors::hnsw_neighbors>();
+  new_index->train(X, item_labels, composite_params, index_options);
+
+  item_index = new_index;
+}
+
+void recsys_factorization_model_base::clear_item_index() {
+  item_index.reset();
+}
+
+/** Recommendations from the item index: for each user, the nearest
+ *  items to [v_u, 1, 0] are found, enough of them to make up for the
+ *  excluded items, and those kept are scored exactly.
+ */
+void recsys_factorization_model_base::score_top_k_items_from_index(
+    std::vector<std::vector<std::pair<size_t, double> > >& top_items,
+    const std::vector<size_t>& users,
+    size_t top_k,
+    const std::vector<std::vector<size_t> >& excluded_items) const {
+
+  DASSERT_EQ(users.size(), excluded_items.size());
+
+  top_items.resize(users.size());
+
+  std::vector<double> factors;
+  double linear_term;
+  nearest_neighbors::DenseVector q;
+  std::vector<std::pair<double, size_t> > neighbors;
+
+  for(size_t i = 0; i < users.size(); ++i) {
+    std::vector<std::pair<size_t, double> >& items = top_items[i];
+    items.clear();
+
+    if(top_k == 0)
+      continue;
+
+    model->get_factors(USER_COLUMN_INDEX, users[i], factors, linear_term);
+
+    q.resize(factors.size() + 2);
+    for(size_t j = 0; j < factors.size(); ++j)
+      q[j] = factors[j];
+    q[factors.size()] = 1;
+    q[factors.size() + 1] = 0;
+
+    const std::vector<size_t>& excl = excluded_items[i];
+
+    item_index->query_single_point(q, top_k + excl.size(), 0, neighbors);
+
+    for(const auto& p : neighbors) {
+      if(items.size() == top_k)
+        break;
+
+      if(!std::binary_search(excl.begin(), excl.end(), p.second))
+        items.push_back({p.second, 0});
+    }
+
+    model->score_items(items, users[i]);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 void recsys_factorization_model_base::internal_save(turi::oarchive& oarc) const {
   oarc << model;
 
-  bool has_nearest_items_model = false;
+  bool has_nearest_items_model = (item_index != nullptr);
   oarc << has_nearest_items_model;
+
+  if (has_nearest_items_model) {
+    oarc << *item_index;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -345,13 +506,22 @@ void recsys_factorization_model_base::internal_load(turi::iarchive& iarc,
   bool has_nearest_items_model;
   iarc >> has_nearest_items_model;
 
+  item_index.reset();
+
   if (has_nearest_items_model) {
-    auto nearest_items_model = std::make_shared<nearest_neighbors::brute_force_neighbors>();
-    iarc >> *nearest_items_model;
+    if (version < 2) {
+      // Unused, and no longer kept.
+      auto nearest_items_model = std::make_shared<nearest_neighbors::brute_force_neighbors>();
+      iarc >> *nearest_items_model;
+    } else {
+      item_index = std::make_shared<nearest_neighbors::hnsw_neighbors>();
+      iarc >> *item_index;
+    }
   }
 
   // Version 0: GLC 1.0, 1.0.1
   // Version 1: GLC 1.1
+  // Version 2: The item index is saved in place of the nearest items model.
   if(version == 0) {
 
     // Create a new option for solver
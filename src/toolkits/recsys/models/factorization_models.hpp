@@ -19,6 +19,10 @@ namespace factorization {
 class factorization_model;
 }
 
+namespace nearest_neighbors {
+class hnsw_neighbors;
+}
+
 namespace recsys {
 
 /** Implements all the factorization stuff -- a thin wrapper to the
@@ -62,7 +66,41 @@ class EXPORT recsys_factorization_model_base : public recsys_model_base {
       const std::vector<v2::ml_data_row_reference>& new_observation_data,
       const std::shared_ptr<v2::ml_data_side_features>& known_side_features) const;
 
-  static constexpr size_t RECSYS_FACTORIZATION_MODEL_VERSION = 1;
+  bool can_score_users_in_blocks() const;
+
+  void score_top_k_items(
+      std::vector<std::vector<std::pair<size_t, double> > >& top_items,
+      const std::vector<size_t>& users,
+      size_t num_items,
+      size_t top_k,
+      const std::vector<std::vector<size_t> >& excluded_items) const;
+
+  /** Builds an approximate index for maximum inner product search over
+   *  the items, used by recommend() in place of scoring every item.
+   *
+   *  Each item's factors and linear term, [v_i, w_i], are extended by
+   *  sqrt(M^2 - |[v_i, w_i]|^2), with M the largest norm over the items,
+   *  so that the euclidean distance from [v_u, 1, 0] ranks the items by
+   *  their score for the user u.  The extended items are then indexed
+   *  by an HNSW graph (see nearest_neighbors::hnsw_neighbors), optionally
+   *  product quantized.  The candidates returned for a user are scored
+   *  exactly before the top_k are taken.
+   *
+   *  The options are those of the HNSW model: max_connections,
+   *  ef_construction, num_subspaces, and ef_search, the search width,
+   *  which trades the time of a query for its recall.
+   *
+   *  Items added after training are not in the index, and are never
+   *  recommended with it.  The index is saved with the model, and
+   *  discarded when the model is trained again.
+   */
+  void build_item_index(const std::map<std::string, flexible_type>& index_options);
+
+  /** Removes the item index, so that recommend() scores every item.
+   */
+  void clear_item_index();
+
+  static constexpr size_t RECSYS_FACTORIZATION_MODEL_VERSION = 2;
 
   inline size_t internal_get_version() const {
     return RECSYS_FACTORIZATION_MODEL_VERSION;
@@ -83,7 +121,13 @@ class EXPORT recsys_factorization_model_base : public recsys_model_base {
                   const v2::ml_data& training_data_by_item);
  private:
   std::shared_ptr<factorization::factorization_model> model;
+  std::shared_ptr<nearest_neighbors::hnsw_neighbors> item_index;
 
+  void score_top_k_items_from_index(
+      std::vector<std::vector<std::pair<size_t, double> > >& top_items,
+      const std::vector<size_t>& users,
+      size_t top_k,
+      const std::vector<std::vector<size_t> >& excluded_items) const;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -103,6 +147,11 @@ class recsys_factorization_model : public recsys_factorization_model_base {
    // TODO: convert interface above to use the extensions methods here
   BEGIN_CLASS_MEMBER_REGISTRATION("factorization_recommender")
   IMPORT_BASE_CLASS_REGISTRATION(recsys_model_base)
+  REGISTER_NAMED_CLASS_MEMBER_FUNCTION("build_item_index",
+                                       recsys_factorization_model_base::build_item_index,
+                                       "options");
+  REGISTER_NAMED_CLASS_MEMBER_FUNCTION("clear_item_index",
+                                       recsys_factorization_model_base::clear_item_index);
   END_CLASS_MEMBER_REGISTRATION
 };
 
@@ -121,6 +170,11 @@ class recsys_ranking_factorization_model : public recsys_factorization_model_bas
    // TODO: convert interface above to use the extensions methods here
   BEGIN_CLASS_MEMBER_REGISTRATION("ranking_factorization_recommender")
   IMPORT_BASE_CLASS_REGISTRATION(recsys_model_base)
+  REGISTER_NAMED_CLASS_MEMBER_FUNCTION("build_item_index",
+                                       recsys_factorization_model_base::build_item_index,
+                                       "options");
+  REGISTER_NAMED_CLASS_MEMBER_FUNCTION("clear_item_index",
+                                       recsys_factorization_model_base::clear_item_index);
   END_CLASS_MEMBER_REGISTRATION
 };
 
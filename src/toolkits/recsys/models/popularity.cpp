@@ -16,6 +16,8 @@
 #include <toolkits/nearest_neighbors/ball_tree_neighbors.hpp>
 
 #include <core/random/random.hpp>
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include <tuple>
 
@@ -68,60 +70,38 @@ std::map<std::string, flexible_type> recsys_popularity::train(const v2::ml_data&
   bool predict_with_counts = !data.has_target();
 
   size_t num_items = metadata->index_size(ITEM_COLUMN_INDEX);
-  item_predictions.resize(num_items);
 
   logprogress_stream << data.size() << " observations to process; with "
                      << num_items << " unique items." << std::endl;
 
-  auto item_indexer = metadata->indexer(ITEM_COLUMN_INDEX);
   auto item_stats = metadata->statistics(ITEM_COLUMN_INDEX);
 
   turi::timer t;
   t.start();
 
-  if(!predict_with_counts) {
-    double global_sum = 0;
+  item_counts.resize(num_items);
+  item_sums.assign(num_items, 0);
+
+  for(size_t item = 0; item < num_items; ++item) {
+    item_counts[item] = item_stats->count(item);
+  }
+
+  num_observations = data.num_rows();
+  global_sum = 0;
 
+  if(!predict_with_counts) {
     std::vector<v2::ml_data_entry> x;
-    std::vector<double> mean_rating(num_items, 0.0);
 
     for(auto it = data.get_iterator(); !it.done(); ++it) {
       it.fill_observation(x);
       size_t item = x[ITEM_COLUMN_INDEX].index;
 
-      mean_rating[item] += it.target_value();
+      item_sums[item] += it.target_value();
       global_sum += it.target_value();
     }
-
-    for(size_t item = 0; item < num_items; ++item) {
-      item_predictions[item] = mean_rating[item] / std::max<size_t>(1, item_stats->count(item));
-    }
-
-    unseen_item_prediction = global_sum / (std::max<size_t>(1, data.num_rows()));
-
-  } else {
-
-    for(size_t item = 0; item < num_items; ++item) {
-      item_predictions[item] = double(item_stats->count(item));
-    }
-
-    unseen_item_prediction = double(num_items) / (std::max<size_t>(1, data.num_rows()));
   }
 
-  // Store the results in an SFrame.
-  sframe items_with_predictions = sframe_from_ranged_generator(
-      {metadata->column_name(ITEM_COLUMN_INDEX), "prediction"},
-      {metadata->column_type(ITEM_COLUMN_INDEX), flex_type_enum::FLOAT},
-      metadata->column_size(ITEM_COLUMN_INDEX),
-      [&](size_t idx, std::vector<flexible_type>& out) {
-        out = {metadata->indexer(ITEM_COLUMN_INDEX)->map_index_to_value(idx),
-               item_predictions[idx]};
-      });
-
-  std::shared_ptr<unity_sframe> ip_usf(new unity_sframe);
-  ip_usf->construct_from_sframe(items_with_predictions);
-
-  add_or_update_state({ {"item_predictions", to_variant(ip_usf)} });
+  finalize_item_predictions();
 
   // And we're done.
   std::map<std::string, flexible_type> ret;
@@ -136,55 +116,80 @@ std::map<std::string, flexible_type> recsys_popularity::train(
   bool predict_with_counts = !metadata->has_target();
 
   size_t num_items = metadata->index_size(ITEM_COLUMN_INDEX);
-  item_predictions.resize(num_items);
 
-  auto item_indexer = metadata->indexer(ITEM_COLUMN_INDEX);
   auto item_stats = metadata->statistics(ITEM_COLUMN_INDEX);
 
   turi::timer t;
   t.start();
 
-  if(!predict_with_counts) {
-    double global_sum = 0;
+  item_counts.resize(num_items);
+  item_sums.assign(num_items, 0);
 
-    std::vector<double> mean_rating(num_items, 0.0);
+  for(size_t item = 0; item < num_items; ++item) {
+    item_counts[item] = item_stats->count(item);
+  }
 
+  num_observations = 0;
+  global_sum = 0;
+
+  if(!predict_with_counts) {
     std::vector<std::vector<std::pair<size_t, double> > > column_data;
 
-    size_t num_obs = 0;
     auto reader = trained_user_items->get_reader();
 
     for(size_t row = 0; row < trained_user_items->size(); ++row) {
       reader->read_rows(row, row + 1 , column_data);
       for(const auto& p : column_data[0]) {
-        mean_rating[p.first] += p.second;
+        item_sums[p.first] += p.second;
         global_sum += p.second;
-        ++num_obs;
+        ++num_observations;
       }
     }
 
+  } else {
+
     for(size_t item = 0; item < num_items; ++item) {
-      item_predictions[item] = mean_rating[item] / std::max<size_t>(1, item_stats->count(item));
+      num_observations += item_counts[item];
+    }
+  }
+
+  finalize_item_predictions();
+
+  // And we're done.
+  std::map<std::string, flexible_type> ret;
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void recsys_popularity::finalize_item_predictions() {
+
+  bool predict_with_counts = !metadata->has_target();
+
+  size_t num_items = item_counts.size();
+  item_predictions.resize(num_items);
+
+  if(!predict_with_counts) {
+    for(size_t item = 0; item < num_items; ++item) {
+      item_predictions[item] = item_sums[item] / std::max<size_t>(1, item_counts[item]);
     }
 
-    unseen_item_prediction = global_sum / (std::max<size_t>(1, num_obs));
+    unseen_item_prediction = global_sum / (std::max<size_t>(1, num_observations));
 
   } else {
 
-    size_t num_obs = 0;
     for(size_t item = 0; item < num_items; ++item) {
-      item_predictions[item] = double(item_stats->count(item));
-      num_obs += item_stats->count(item);
+      item_predictions[item] = double(item_counts[item]);
     }
 
-    unseen_item_prediction = double(num_items) / (std::max<size_t>(1, num_obs));
+    unseen_item_prediction = double(num_items) / (std::max<size_t>(1, num_observations));
   }
 
   // Store the results in an SFrame.
   sframe items_with_predictions = sframe_from_ranged_generator(
       {metadata->column_name(ITEM_COLUMN_INDEX), "prediction"},
       {metadata->column_type(ITEM_COLUMN_INDEX), flex_type_enum::FLOAT},
-      metadata->column_size(ITEM_COLUMN_INDEX),
+      num_items,
       [&](size_t idx, std::vector<flexible_type>& out) {
         out = {metadata->indexer(ITEM_COLUMN_INDEX)->map_index_to_value(idx),
                item_predictions[idx]};
@@ -194,10 +199,203 @@ std::map<std::string, flexible_type> recsys_popularity::train(
   ip_usf->construct_from_sframe(items_with_predictions);
 
   add_or_update_state({ {"item_predictions", to_variant(ip_usf)} });
+}
 
-  // And we're done.
-  std::map<std::string, flexible_type> ret;
-  return ret;
+////////////////////////////////////////////////////////////////////////////////
+
+void recsys_popularity::add_to_user_item_lists(
+    std::map<size_t, std::vector<std::pair<size_t, double> > >& new_lists) {
+
+  typedef std::vector<std::pair<size_t, double> > item_list;
+
+  static constexpr size_t READ_BLOCK_SIZE = 1024;
+
+  const size_t num_users = metadata->column_size(USER_COLUMN_INDEX);
+  const size_t num_old_users = trained_user_items->size();
+
+  auto out = std::make_shared<sarray<item_list> >();
+  out->open_for_write(1);
+  auto it_out = out->get_output_iterator(0);
+
+  auto reader = trained_user_items->get_reader();
+
+  std::vector<item_list> rows;
+  item_list merged;
+  const item_list empty_list;
+
+  auto by_item = [](const std::pair<size_t, double>& a, const std::pair<size_t, double>& b) {
+    return a.first < b.first;
+  };
+
+  auto new_it = new_lists.begin();
+
+  for(size_t block_start = 0; block_start < num_users; block_start += READ_BLOCK_SIZE) {
+    size_t block_end = std::min(block_start + READ_BLOCK_SIZE, num_users);
+
+    rows.clear();
+    if(block_start < num_old_users) {
+      reader->read_rows(block_start, std::min(block_end, num_old_users), rows);
+    }
+
+    for(size_t user = block_start; user < block_end; ++user, ++it_out) {
+      const item_list& old_items = (user - block_start < rows.size()
+                                    ? rows[user - block_start] : empty_list);
+
+      if(new_it == new_lists.end() || new_it->first != user) {
+        *it_out = old_items;
+        continue;
+      }
+
+      item_list& added = new_it->second;
+      std::stable_sort(added.begin(), added.end(), by_item);
+
+      // std::merge puts the old entry first on ties, so the last
+      // entry of each item is the newest one.
+      merged.clear();
+      std::merge(old_items.begin(), old_items.end(), added.begin(), added.end(),
+                 std::back_inserter(merged), by_item);
+
+      size_t n = 0;
+      for(size_t i = 0; i < merged.size(); ++i) {
+        if(n > 0 && merged[n - 1].first == merged[i].first) {
+          merged[n - 1] = merged[i];
+        } else {
+          merged[n++] = merged[i];
+        }
+      }
+      merged.resize(n);
+
+      *it_out = merged;
+      ++new_it;
+    }
+  }
+
+  out->close();
+
+  trained_user_items = out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void recsys_popularity::update(const sframe& new_observation_data) {
+
+  if(metadata->has_target()
+     && !new_observation_data.contains_column(metadata->target_column_name())) {
+    log_and_throw(std::string("Target column '") + metadata->target_column_name()
+                  + "' required to update the model is not present in the new data.");
+  }
+
+  v2::ml_data data = create_ml_data(new_observation_data);
+
+  const bool use_target = metadata->has_target();
+  const size_t num_items = metadata->column_size(ITEM_COLUMN_INDEX);
+
+  item_counts.resize(num_items, 0);
+  item_sums.resize(num_items, 0);
+
+  std::map<size_t, std::vector<std::pair<size_t, double> > > new_lists;
+  std::vector<v2::ml_data_entry> x;
+
+  for(auto it = data.get_iterator(); !it.done(); ++it) {
+    it.fill_observation(x);
+    size_t user = x[USER_COLUMN_INDEX].index;
+    size_t item = x[ITEM_COLUMN_INDEX].index;
+    double target = it.target_value();
+
+    ++item_counts[item];
+    if(use_target) {
+      item_sums[item] += target;
+      global_sum += target;
+    }
+    new_lists[user].push_back({item, target});
+  }
+
+  num_observations += data.num_rows();
+
+  add_to_user_item_lists(new_lists);
+
+  // The new users and items are now part of the model.
+  metadata->set_training_index_sizes_to_current_column_sizes();
+
+  finalize_item_predictions();
+
+  logprogress_stream << "Updated popularity model with " << data.num_rows()
+                     << " observations; now " << num_items << " unique items." << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void recsys_popularity::merge(const recsys_popularity& other) {
+
+  if(metadata->has_target() != other.metadata->has_target()) {
+    log_and_throw("Only popularity models that both have a target, "
+                  "or both have none, can be merged.");
+  }
+
+  for(size_t c : {size_t(USER_COLUMN_INDEX), size_t(ITEM_COLUMN_INDEX)}) {
+    if(metadata->column_name(c) != other.metadata->column_name(c)) {
+      log_and_throw(std::string("Column '") + other.metadata->column_name(c)
+                    + "' of the merged model does not match column '"
+                    + metadata->column_name(c) + "'.");
+    }
+  }
+
+  // Index the other model's users and items here, adding those not
+  // yet known.
+  auto map_indices = [&](size_t column_index) {
+    const auto& src = other.metadata->indexer(column_index);
+    const auto& dest = metadata->indexer(column_index);
+
+    std::vector<size_t> mapping(other.metadata->column_size(column_index));
+
+    dest->initialize();
+    for(size_t i = 0; i < mapping.size(); ++i) {
+      mapping[i] = dest->map_value_to_index(0, src->map_index_to_value(i));
+    }
+    dest->finalize();
+
+    return mapping;
+  };
+
+  std::vector<size_t> user_mapping = map_indices(USER_COLUMN_INDEX);
+  std::vector<size_t> item_mapping = map_indices(ITEM_COLUMN_INDEX);
+
+  const size_t num_items = metadata->column_size(ITEM_COLUMN_INDEX);
+  item_counts.resize(num_items, 0);
+  item_sums.resize(num_items, 0);
+
+  for(size_t i = 0; i < other.item_counts.size(); ++i) {
+    item_counts[item_mapping[i]] += other.item_counts[i];
+    item_sums[item_mapping[i]] += other.item_sums[i];
+  }
+
+  num_observations += other.num_observations;
+  global_sum += other.global_sum;
+
+  // Bring in the other model's known items.
+  std::map<size_t, std::vector<std::pair<size_t, double> > > new_lists;
+  std::vector<std::vector<std::pair<size_t, double> > > rows;
+
+  auto reader = other.trained_user_items->get_reader();
+
+  for(size_t user = 0; user < other.trained_user_items->size(); ++user) {
+    reader->read_rows(user, user + 1, rows);
+
+    if(rows.empty() || rows[0].empty()) {
+      continue;
+    }
+
+    auto& dest = new_lists[user_mapping[user]];
+    for(const auto& p : rows[0]) {
+      dest.push_back({item_mapping[p.first], p.second});
+    }
+  }
+
+  add_to_user_item_lists(new_lists);
+
+  metadata->set_training_index_sizes_to_current_column_sizes();
+
+  finalize_item_predictions();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -316,10 +514,13 @@ void recsys_popularity::internal_save(turi::oarchive& oarc) const {
        << unseen_item_prediction;
   bool has_nearest_items_model = false;
   oarc << has_nearest_items_model;
+
+  // Version 1: the counts and sums the predictions come from.
+  oarc << item_counts << item_sums << num_observations << global_sum;
 }
 
 void recsys_popularity::internal_load(turi::iarchive& iarc, size_t version) {
-  ASSERT_EQ(version, POPULARITY_RECOMMENDER_VERSION);
+  ASSERT_LE(version, POPULARITY_RECOMMENDER_VERSION);
   iarc >> item_predictions
        >> unseen_item_prediction;
 
@@ -331,5 +532,29 @@ void recsys_popularity::internal_load(turi::iarchive& iarc, size_t version) {
   if (has_nearest_items_model) {
     iarc >> *m;
   }
+
+  if(version >= 1) {
+    iarc >> item_counts >> item_sums >> num_observations >> global_sum;
+  } else {
+    // Recover the counts and sums from the training statistics and
+    // the predictions.
+    auto item_stats = metadata->statistics(ITEM_COLUMN_INDEX);
+    size_t num_items = item_predictions.size();
+
+    item_counts.resize(num_items);
+    item_sums.assign(num_items, 0);
+    num_observations = 0;
+
+    for(size_t item = 0; item < num_items; ++item) {
+      item_counts[item] = item_stats->count(item);
+      num_observations += item_counts[item];
+      if(metadata->has_target()) {
+        item_sums[item] = item_predictions[item] * item_counts[item];
+      }
+    }
+
+    global_sum = (metadata->has_target()
+                  ? unseen_item_prediction * num_observations : 0);
+  }
 }
 }}
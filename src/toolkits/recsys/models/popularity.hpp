@@ -8,6 +8,7 @@
 
 #include <vector>
 #include <string>
+#include <map>
 #include <toolkits/recsys/recsys_model_base.hpp>
 #include <toolkits/nearest_neighbors/nearest_neighbors.hpp>
 #include <toolkits/nearest_neighbors/ball_tree_neighbors.hpp>
@@ -69,9 +70,39 @@ class EXPORT recsys_popularity : public recsys_model_base {
       const std::vector<v2::ml_data_row_reference>& new_observation_data,
       const std::shared_ptr<v2::ml_data_side_features>& known_side_features) const override;
 
+  /** Folds new observations into the model without going over the
+   *  training data again.
+   *
+   *  The model keeps the count of observations (and the sum of the
+   *  targets) of each item, so an update only costs a pass over the
+   *  new observations and a pass over the items.  New users and
+   *  items are added.  The new observations are also added to the
+   *  users' known items, so recommend() excludes them.
+   *
+   *  The data must have the user and item columns, and the target
+   *  column if the model was trained with one.
+   */
+  void update(const sframe& new_observation_data);
+
+  /** Merges in another popularity model, e.g. one trained on another
+   *  shard of the data.  Users and items are matched by value.  The
+   *  merged model is the one the union of both training sets would
+   *  have given, up to repeated user-item pairs, which are kept once
+   *  in the known items.
+   */
+  void merge(const recsys_popularity& other);
+
+  void api_update(gl_sframe new_observation_data) {
+    update(new_observation_data.materialize_to_sframe());
+  }
+
+  void api_merge(std::shared_ptr<recsys_popularity> other) {
+    merge(*other);
+  }
+
   /////////////////////////////////////////////////////////////////////////////////
   // Save and load stuff
-  static constexpr size_t POPULARITY_RECOMMENDER_VERSION = 0;
+  static constexpr size_t POPULARITY_RECOMMENDER_VERSION = 1;
 
   inline size_t internal_get_version() const override {
     return POPULARITY_RECOMMENDER_VERSION;
@@ -84,9 +115,33 @@ class EXPORT recsys_popularity : public recsys_model_base {
   double unseen_item_prediction;
   std::shared_ptr<nearest_neighbors::ball_tree_neighbors> nearest_items_model;
 
+  // The state the predictions are computed from; these are
+  // additive, so updates and merges just add to them.
+  std::vector<size_t> item_counts;
+  std::vector<double> item_sums;
+  size_t num_observations = 0;
+  double global_sum = 0;
+
+  /** Computes item_predictions and unseen_item_prediction from the
+   *  counts and sums, and stores them in the state.
+   */
+  void finalize_item_predictions();
+
+  /** Adds (item, target) lists, by user, to trained_user_items.  A
+   *  new entry for an item the user already has replaces it.
+   */
+  void add_to_user_item_lists(
+      std::map<size_t, std::vector<std::pair<size_t, double> > >& new_lists);
+
  public:
   BEGIN_CLASS_MEMBER_REGISTRATION("popularity")
   IMPORT_BASE_CLASS_REGISTRATION(recsys_model_base)
+
+  REGISTER_NAMED_CLASS_MEMBER_FUNCTION("update", recsys_popularity::api_update,
+                                       "new_observation_data");
+
+  REGISTER_NAMED_CLASS_MEMBER_FUNCTION("merge", recsys_popularity::api_merge,
+                                       "other");
   END_CLASS_MEMBER_REGISTRATION
 
 };
@@ -568,6 +568,21 @@ void recsys_model_base::choose_diversely(size_t top_k,
   candidates.resize(chosen_items.size());
 }
 
+std::shared_ptr<const user_item_sets>
+recsys_model_base::get_trained_user_item_sets() const {
+
+  auto sets = std::atomic_load(&trained_user_item_sets);
+
+  if(sets == nullptr || sets->source() != trained_user_items) {
+    // Concurrent callers may each build the sets; any of them will do.
+    sets = std::make_shared<const user_item_sets>(
+        trained_user_items, metadata->column_size(ITEM_COLUMN_INDEX));
+    std::atomic_store(&trained_user_item_sets, sets);
+  }
+
+  return sets;
+}
+
 sframe recsys_model_base::recommend(
     const sframe& query_data,
     size_t top_k,
@@ -875,6 +890,144 @@ sframe recsys_model_base::recommend(
   const std::vector<std::pair<size_t, double> > empty_pair_vector;
   const std::vector<v2::ml_data_row_reference> empty_ref_vector;
 
+  // Sorts the scored items of a query, writes its top_k out and logs
+  // the progress.
+  auto _finish_query = [&](size_t thread_idx, size_t user, uint64_t user_hash_key,
+                           std::vector<item_score_pair>& item_score_list,
+                           sframe::iterator& out,
+                           std::vector<flexible_type>& out_x_v) {
+
+    if(LIKELY(!item_score_list.empty())) {
+      size_t n_qk = std::min(top_k_query_number, item_score_list.size());
+      size_t n_k = std::min(top_k, item_score_list.size());
+
+      // Sort and get the top_k.
+      auto score_sorter = [](const item_score_pair& vi1, const item_score_pair& vi2) {
+        return vi1.second < vi2.second;
+      };
+
+      extract_and_sort_top_k(item_score_list, n_qk, score_sorter);
+
+      if(enable_diversity && n_qk > n_k) {
+        choose_diversely(n_k, item_score_list, hash64(random_seed,user_hash_key), dv_buffers[thread_idx]);
+
+        DASSERT_EQ(item_score_list.size(), n_k);
+      }
+
+      // now append them all to the output sframes
+      for(size_t i = 0; i < n_k; ++i, ++out) {
+        size_t item = item_score_list[i].first;
+        double score = item_score_list[i].second;
+        out_x_v = {metadata->indexer(USER_COLUMN_INDEX)->map_index_to_value(user),
+                   metadata->indexer(ITEM_COLUMN_INDEX)->map_index_to_value(item),
+                   score,
+                   i + 1};
+
+        *out = out_x_v;
+      }
+    }
+
+    size_t cur_n_queries_processed = (++n_queries_processed);
+
+    if(cur_n_queries_processed % 1000 == 0) {
+      logprogress_stream << "recommendations finished on "
+                         << cur_n_queries_processed << "/" << n_queries << " queries."
+                         << " users per second: "
+                         << double(cur_n_queries_processed) / log_timer.current_time()
+                         << std::endl;
+    }
+  };
+
+  // When every user is scored against every item from the model
+  // parameters alone, the model scores blocks of users at once.  Each
+  // user's items to exclude are merged into one sorted list.
+  const bool score_users_in_blocks =
+      (user_processing_mode == ALL || user_processing_mode == LIST)
+      && item_restriction_list.empty()
+      && item_restriction_list_by_user.empty()
+      && current_side_features == nullptr
+      && can_score_users_in_blocks();
+
+  // Each user's known items, shared by all the threads.
+  std::shared_ptr<const user_item_sets> trained_sets;
+
+  if(score_users_in_blocks && exclude_training_interactions) {
+    trained_sets = get_trained_user_item_sets();
+  }
+
+  auto _run_block_recommendations = [&](size_t thread_idx, size_t n_threads)
+    GL_GCC_ONLY(GL_HOT_NOINLINE_FLATTEN) {
+
+      static constexpr size_t USER_BLOCK_SIZE = 64;
+
+      const size_t n_items = metadata->column_size(ITEM_COLUMN_INDEX);
+
+      size_t n_users = (user_processing_mode == ALL
+                        ? metadata->index_size(USER_COLUMN_INDEX)
+                        : user_query_list.size());
+
+      size_t user_index_start = (thread_idx * n_users) / n_threads;
+      size_t user_index_end   = ((thread_idx+1) * n_users) / n_threads;
+
+      auto out = ret.get_output_iterator(thread_idx);
+      std::vector<flexible_type> out_x_v;
+
+      std::vector<size_t> users;
+      std::vector<std::vector<size_t> > excluded_items;
+      std::vector<std::vector<item_score_pair> > top_items;
+
+      for(size_t block_start = user_index_start; block_start < user_index_end;
+          block_start += USER_BLOCK_SIZE) {
+
+        size_t block_end = std::min(block_start + USER_BLOCK_SIZE, user_index_end);
+
+        users.resize(block_end - block_start);
+        excluded_items.resize(users.size());
+
+        for(size_t i = 0; i < users.size(); ++i) {
+          size_t user = (user_processing_mode == ALL
+                         ? block_start + i
+                         : user_query_list[block_start + i]);
+          users[i] = user;
+
+          std::vector<size_t>& excl = excluded_items[i];
+          excl.clear();
+
+          // The known items come out of the sets already sorted, so
+          // only merge when another list was added.
+          bool needs_sort = false;
+
+          auto exc_it = exclusion_lists.find(user);
+          if(exc_it != exclusion_lists.end())
+            excl = exc_it->second;
+
+          if(exclude_training_interactions) {
+            size_t n_before = excl.size();
+            trained_sets->append_items(user, excl);
+            needs_sort = (n_before != 0 && excl.size() != n_before);
+
+            auto nil_it = new_user_item_lookup.find(user);
+            if(nil_it != new_user_item_lookup.end()) {
+              for(const auto& p : nil_it->second)
+                excl.push_back(p.first);
+              needs_sort = true;
+            }
+          }
+
+          if(needs_sort) {
+            std::sort(excl.begin(), excl.end());
+            excl.erase(std::unique(excl.begin(), excl.end()), excl.end());
+          }
+        }
+
+        score_top_k_items(top_items, users, n_items, top_k_query_number, excluded_items);
+
+        for(size_t i = 0; i < users.size(); ++i) {
+          _finish_query(thread_idx, users[i], users[i], top_items[i], out, out_x_v);
+        }
+      }
+  };
+
   auto _run_recommendations = [&](size_t thread_idx, size_t n_threads)
     GL_GCC_ONLY(GL_HOT_NOINLINE_FLATTEN) {
 
@@ -1147,45 +1300,9 @@ sframe recsys_model_base::recommend(
                           new_user_item_list,
                           new_obs_data_vec,
                           current_side_features);
-
-          size_t n_qk = std::min(top_k_query_number, item_score_list.size());
-          size_t n_k = std::min(top_k, item_score_list.size());
-
-          // Sort and get the top_k.
-          auto score_sorter = [](const item_score_pair& vi1, const item_score_pair& vi2) {
-            return vi1.second < vi2.second;
-          };
-
-          extract_and_sort_top_k(item_score_list, n_qk, score_sorter);
-
-          if(enable_diversity && n_qk > n_k) {
-            choose_diversely(n_k, item_score_list, hash64(random_seed,user_hash_key), dv_buffers[thread_idx]);
-
-            DASSERT_EQ(item_score_list.size(), n_k);
-          }
-
-          // now append them all to the output sframes
-          for(size_t i = 0; i < n_k; ++i, ++out) {
-            size_t item = item_score_list[i].first;
-            double score = item_score_list[i].second;
-            out_x_v = {metadata->indexer(USER_COLUMN_INDEX)->map_index_to_value(user),
-                       metadata->indexer(ITEM_COLUMN_INDEX)->map_index_to_value(item),
-                       score,
-                       i + 1};
-
-            *out = out_x_v;
-          }
         }
 
-        size_t cur_n_queries_processed = (++n_queries_processed);
-
-        if(cur_n_queries_processed % 1000 == 0) {
-          logprogress_stream << "recommendations finished on "
-                             << cur_n_queries_processed << "/" << n_queries << " queries."
-                             << " users per second: "
-                             << double(cur_n_queries_processed) / log_timer.current_time()
-                             << std::endl;
-        }
+        _finish_query(thread_idx, user, user_hash_key, item_score_list, out, out_x_v);
 
         ////////////////////////////////////////////////////////////////////////////////
         // Now, do the incrementation
@@ -1206,7 +1323,13 @@ sframe recsys_model_base::recommend(
   // Conditionally run the recommendations based on the number of
   // threads.  If we don't run it in parallel here, it allows lower
   // level algorithms to be parallel.
-  if(n_queries < max_n_threads) {
+  if(score_users_in_blocks) {
+    if(n_queries < max_n_threads) {
+      _run_block_recommendations(0, 1);
+    } else {
+      in_parallel(_run_block_recommendations);
+    }
+  } else if(n_queries < max_n_threads) {
     _run_recommendations(0, 1);
   } else {
     in_parallel(_run_recommendations);
@@ -36,6 +36,7 @@ class column_metadata;
 namespace recsys {
 
 class recsys_popularity;
+class user_item_sets;
 
 
 /** The base class for recsys model classes.  Individual models are
@@ -149,6 +150,27 @@ public:
       const std::vector<v2::ml_data_row_reference>& new_observation_data,
       const std::shared_ptr<v2::ml_data_side_features>& known_side_features) const = 0;
 
+  /** True if the model can score items for blocks of users with
+   *  score_top_k_items, from the users alone.  recommend() then uses it
+   *  in place of score_all_items when there are no side features or
+   *  item restrictions.
+   */
+  virtual bool can_score_users_in_blocks() const { return false; }
+
+  /** Scores all the items [0, num_items) for each of the users, and
+   *  puts the top_k of each user, best first, in top_items.  The
+   *  items in excluded_items (one sorted list per user) are skipped.
+   *  New observation data does not change the scores.
+   */
+  virtual void score_top_k_items(
+      std::vector<std::vector<std::pair<size_t, double> > >& top_items,
+      const std::vector<size_t>& users,
+      size_t num_items,
+      size_t top_k,
+      const std::vector<std::vector<size_t> >& excluded_items) const {
+    ASSERT_MSG(false, "Model cannot score blocks of users.");
+  }
+
 
   // Set additional data for the method
   virtual void set_extra_data(const std::map<std::string, variant_type>& other_data) {}
@@ -189,6 +211,17 @@ public:
   std::shared_ptr<v2::ml_metadata> metadata;
   std::shared_ptr<sarray<std::vector<std::pair<size_t, double> > > > trained_user_items;
 
+  /** The items of each user in trained_user_items, as in-memory sets.
+   *  Built on first use and shared by later calls, until
+   *  trained_user_items changes.  Thread safe.
+   */
+  std::shared_ptr<const user_item_sets> get_trained_user_item_sets() const;
+
+ private:
+  mutable std::shared_ptr<const user_item_sets> trained_user_item_sets;
+
+ public:
+
  /** Creates an ml_data object according to the given schema.  No
    * target column.
    */
@@ -9,7 +9,11 @@
 #include <toolkits/ml_data_2/ml_data.hpp>
 #include <toolkits/ml_data_2/ml_data_iterators.hpp>
 #include <algorithm>
+#include <functional>
+#include <limits>
 #include <core/parallel/pthread_tools.hpp>
+#include <core/parallel/lambda_omp.hpp>
+#include <core/util/bitops.hpp>
 
 namespace turi { namespace recsys {
 
@@ -112,5 +116,117 @@ make_user_item_lists(const v2::ml_data& data) {
   return out;
 }
 
+/** Build the sets in two passes over the user-item lists: the first
+ *  sizes each user, the second fills in the lists and the bitsets.
+ */
+user_item_sets::user_item_sets(
+    const std::shared_ptr<sarray<std::vector<std::pair<size_t, double> > > >& user_item_lists,
+    size_t num_items)
+    : m_source(user_item_lists)
+    , m_num_items(num_items)
+    , words_per_bitset((num_items + 63) / 64) {
+
+  ASSERT_LT(num_items, size_t(std::numeric_limits<uint32_t>::max()));
+
+  const size_t n_users = user_item_lists->size();
+  auto reader = user_item_lists->get_reader();
+
+  static constexpr size_t READ_BLOCK_SIZE = 1024;
+
+  // Calls process_user(user, items) on every user, in parallel.
+  auto for_each_user = [&](const std::function<void(
+      size_t, const std::vector<std::pair<size_t, double> >&)>& process_user) {
+
+    in_parallel([&](size_t thread_idx, size_t num_threads) {
+        size_t start = (thread_idx * n_users) / num_threads;
+        size_t end = ((thread_idx + 1) * n_users) / num_threads;
+
+        std::vector<std::vector<std::pair<size_t, double> > > rows;
+
+        for(size_t block_start = start; block_start < end; block_start += READ_BLOCK_SIZE) {
+          size_t block_end = std::min(block_start + READ_BLOCK_SIZE, end);
+          reader->read_rows(block_start, block_end, rows);
+
+          for(size_t i = 0; i < rows.size(); ++i) {
+            process_user(block_start + i, rows[i]);
+          }
+        }
+      });
+  };
+
+  // Pass 1: the size of each user's set.
+  std::vector<size_t> user_sizes(n_users, 0);
+
+  for_each_user([&](size_t user, const std::vector<std::pair<size_t, double> >& row) {
+      user_sizes[user] = row.size();
+    });
+
+  list_boundaries.assign(n_users + 1, 0);
+  bitset_index.assign(n_users, size_t(NO_BITSET));
+
+  size_t n_list_items = 0;
+  size_t n_bitsets = 0;
+
+  for(size_t user = 0; user < n_users; ++user) {
+    list_boundaries[user] = n_list_items;
+
+    // A bitset takes num_items / 8 bytes, a list 4 bytes per item.
+    if(user_sizes[user] * 32 > num_items) {
+      bitset_index[user] = n_bitsets * words_per_bitset;
+      ++n_bitsets;
+    } else {
+      n_list_items += user_sizes[user];
+    }
+  }
+
+  list_boundaries[n_users] = n_list_items;
+
+  items.resize(n_list_items);
+  bitset_words.assign(n_bitsets * words_per_bitset, 0);
+
+  // Pass 2: fill them in.
+  for_each_user([&](size_t user, const std::vector<std::pair<size_t, double> >& row) {
+      DASSERT_EQ(row.size(), user_sizes[user]);
+
+      if(bitset_index[user] != NO_BITSET) {
+        uint64_t* words = &bitset_words[bitset_index[user]];
+        for(const auto& p : row) {
+          DASSERT_LT(p.first, m_num_items);
+          words[p.first / 64] |= (uint64_t(1) << (p.first % 64));
+        }
+      } else {
+        uint32_t* out = items.data() + list_boundaries[user];
+        for(size_t i = 0; i < row.size(); ++i) {
+          DASSERT_LT(row[i].first, m_num_items);
+          out[i] = uint32_t(row[i].first);
+        }
+      }
+    });
+}
+
+/** Append the items of a user to out, in increasing order.
+ */
+void user_item_sets::append_items(size_t user, std::vector<size_t>& out) const {
+  if(user >= num_users()) {
+    return;
+  }
+
+  size_t b = bitset_index[user];
+
+  if(b != NO_BITSET) {
+    const uint64_t* words = &bitset_words[b];
+    for(size_t w = 0; w < words_per_bitset; ++w) {
+      uint64_t bits = words[w];
+      while(bits != 0) {
+        out.push_back(w * 64 + n_trailing_zeros(bits));
+        bits &= bits - 1;
+      }
+    }
+  } else {
+    out.insert(out.end(), items.begin() + list_boundaries[user],
+               items.begin() + list_boundaries[user + 1]);
+  }
+}
+
 
 }}
@@ -10,6 +10,8 @@
 #include <core/storage/sframe_data/sframe.hpp>
 #include <memory>
 #include <vector>
+#include <algorithm>
+#include <cstdint>
 
 namespace turi { namespace recsys {
 
@@ -33,6 +35,76 @@ namespace turi { namespace recsys {
 std::shared_ptr<sarray<std::vector<std::pair<size_t, double> > > >
 make_user_item_lists(const v2::ml_data& data);
 
+/** The item sets of all users, held in memory for membership tests
+ *  and for listing a user's items without reading the user-item
+ *  lists.
+ *
+ *  Each user's items are stored as a sorted list of 32 bit indices,
+ *  or, if the user has more than 1/32 of the items, as a bitset over
+ *  the items.  A user therefore never takes more than num_items / 8
+ *  bytes.
+ *
+ *  The sets are immutable once built, so they can be shared between
+ *  threads and between calls.
+ */
+class user_item_sets {
+ public:
+
+  /** Build the sets from user-item lists, as returned by
+   *  make_user_item_lists, with row u holding the items of user u.
+   *  Items must be less than num_items.
+   */
+  user_item_sets(
+      const std::shared_ptr<sarray<std::vector<std::pair<size_t, double> > > >& user_item_lists,
+      size_t num_items);
+
+  /** The user-item lists the sets were built from.
+   */
+  const std::shared_ptr<sarray<std::vector<std::pair<size_t, double> > > >& source() const {
+    return m_source;
+  }
+
+  size_t num_users() const { return list_boundaries.size() - 1; }
+
+  /** True if the user has the item.  False for users and items not in
+   *  the sets.
+   */
+  inline bool contains(size_t user, size_t item) const {
+    if(user >= num_users() || item >= m_num_items) {
+      return false;
+    }
+
+    size_t b = bitset_index[user];
+    if(b != NO_BITSET) {
+      const uint64_t* words = &bitset_words[b];
+      return (words[item / 64] >> (item % 64)) & 1;
+    }
+
+    auto first = items.begin() + list_boundaries[user];
+    auto last = items.begin() + list_boundaries[user + 1];
+    return std::binary_search(first, last, uint32_t(item));
+  }
+
+  /** Append the items of a user to out, in increasing order.
+   */
+  void append_items(size_t user, std::vector<size_t>& out) const;
+
+ private:
+  static constexpr size_t NO_BITSET = size_t(-1);
+
+  std::shared_ptr<sarray<std::vector<std::pair<size_t, double> > > > m_source;
+  size_t m_num_items = 0;
+  size_t words_per_bitset = 0;
+
+  // The lists of the users stored as lists; empty for the others.
+  std::vector<size_t> list_boundaries;
+  std::vector<uint32_t> items;
+
+  // The start of each user's bitset in bitset_words, or NO_BITSET.
+  std::vector<size_t> bitset_index;
+  std::vector<uint64_t> bitset_words;
+};
+
 }}
 
 #endif /* _USER_ITEM_LISTS_H_ */
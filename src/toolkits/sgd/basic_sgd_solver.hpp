@@ -30,6 +30,13 @@ class basic_sgd_solver : public sgd_solver_base {
   // Memory to hold things across threads.
   std::vector<std::vector<std::pair<std::vector<v2::ml_data_entry>, double> > > x_buffers;
 
+  // The loss accumulated by each thread.  Updated on every step, so
+  // each one is padded out to its own cache line.
+  struct thread_loss_value {
+    double value = 0;
+    char _padding[64 - sizeof(double)];
+  };
+
  public:
 
   /** Constructor.
@@ -74,7 +81,7 @@ class basic_sgd_solver : public sgd_solver_base {
 
     volatile bool error_detected = false;
 
-    std::vector<double> loss_values(max_num_threads, 0);
+    std::vector<thread_loss_value> loss_values(max_num_threads);
 
     iface->setup_iteration(iteration, step_size);
 
@@ -100,7 +107,8 @@ class basic_sgd_solver : public sgd_solver_base {
         std::vector<std::pair<std::vector<v2::ml_data_entry>, double> >& x_buffer = x_buffers[thread_idx];
         x_buffer.resize(block_size);
 
-        loss_values[thread_idx] = 0;
+        double& loss_value = loss_values[thread_idx].value;
+        loss_value = 0;
 
         while(!error_detected) {
           size_t block_lookup_idx = (++current_block) - 1;
@@ -139,9 +147,9 @@ class basic_sgd_solver : public sgd_solver_base {
               // Do a gradient step.  The loss value is the one at the
               // current point, before the sgd step is performed.
 
-              loss_values[thread_idx] += current_loss_value;
+              loss_value += current_loss_value;
 
-              if(!std::isfinite(loss_values[thread_idx]) ) {
+              if(!std::isfinite(loss_value) ) {
                 logstream(LOG_INFO) << "SGD: Non-finite loss value in thread " << thread_idx << std::endl;
                 error_detected = true;
               }
@@ -157,9 +165,11 @@ class basic_sgd_solver : public sgd_solver_base {
     // Finalize the iteration.
     iface->finalize_iteration();
 
-    double loss_no_regularization
-        = (std::accumulate(loss_values.begin(), loss_values.end(), double(0.0))
-           / std::max(size_t(1), data.size()));
+    double total_loss = 0;
+    for(const thread_loss_value& lv : loss_values)
+      total_loss += lv.value;
+
+    double loss_no_regularization = total_loss / std::max(size_t(1), data.size());
 
     double regularization_penalty = iface->current_regularization_penalty();
 
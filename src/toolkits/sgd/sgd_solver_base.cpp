@@ -12,6 +12,7 @@
 #include <toolkits/sgd/sgd_solver_base.hpp>
 #include <core/logging/assertions.hpp>
 #include <core/logging/table_printer/table_printer.hpp>
+#include <core/logging/trace_events.hpp>
 
 #include <toolkits/ml_data_2/ml_data.hpp>
 
@@ -114,6 +115,14 @@ void sgd_solver_base::add_options(option_manager& options) {
   opt.upper_bound = std::numeric_limits<long>::max();
   options.create_option(opt);
 
+  opt.name = "sgd_lock_free";
+  opt.description = ("If true, threads apply their updates to the model without any locking "
+                     "(Hogwild-style).  This scales better to many threads on sparse data, "
+                     "at the cost of occasionally overwritten updates.");
+  opt.default_value = false;
+  opt.parameter_type = option_handling::option_info::BOOL;
+  options.create_option(opt);
+
   opt.name = "additional_iterations_if_unhealthy";
   opt.description = ("If the model becomes unhealthy and gets reset, allow at most this many additional "
                      "iterations in an attempt to have max_iterations healthy iterations.");
@@ -390,11 +399,14 @@ sgd_solver_base::run_fixed_sgd_step_size(double initial_sgd_step_size) {
 
     double objective_value_estimate, training_loss;
 
-    std::tie(objective_value_estimate, training_loss)
-        = run_iteration(iteration_index,
-                        model_interface.get(),
-                        train_data,
-                        iteration_step_size);
+    {
+      trace::scoped_span span("sgd", "iteration");
+      std::tie(objective_value_estimate, training_loss)
+          = run_iteration(iteration_index,
+                          model_interface.get(),
+                          train_data,
+                          iteration_step_size);
+    }
 
     // Test to see if the model has diverged for any reason
     if(!std::isfinite(objective_value_estimate)) {
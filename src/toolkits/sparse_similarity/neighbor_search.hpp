@@ -9,6 +9,7 @@
 #include <core/storage/sframe_data/sarray.hpp>
 #include <vector>
 #include <core/parallel/pthread_tools.hpp>
+#include <core/parallel/lambda_omp.hpp>
 #include <core/util/try_finally.hpp>
 #include <core/util/dense_bitset.hpp>
 #include <toolkits/sparse_similarity/similarities.hpp>
@@ -311,111 +312,116 @@ void brute_force_all_pairs_similarity_with_vector_reference(
 #endif
 
     // Okay, now that we have a specific block of query data, go
-    // through and perform the nearest neighbors query on it.
+    // through and perform the nearest neighbors query on it.  The
+    // reference rows differ a lot in how many entries they have, so
+    // each thread takes chunks of them as it goes.
+    const size_t n_reference_rows_per_block = 16;
+    parallel_range_cursor reference_cursor(
+        0, num_reference_rows, parallel_schedule::GUIDED, n_reference_rows_per_block);
+
     in_parallel([&](size_t thread_idx, size_t num_threads) GL_GCC_ONLY(GL_HOT_NOINLINE_FLATTEN) {
-        // This is the segment we are responsible for in this thread.
-        size_t reference_row_idx_start = (num_reference_rows * thread_idx) / num_threads;
-        size_t reference_row_idx_end = (num_reference_rows * (thread_idx+1)) / num_threads;
+        size_t reference_row_idx_start = 0, reference_row_idx_end = 0;
 
-        const size_t n_reference_rows_per_block = 16;
         std::vector<std::vector<std::pair<size_t, double> > > reference_rows_v;
 
         std::vector<interaction_data_type> edges(num_query_rows_in_block);
 
-        // Read it in in blocks of n_reference_rows_per_block rows for efficiency.
-        for(size_t outer_idx = reference_row_idx_start;
-            outer_idx < reference_row_idx_end;
-            outer_idx += n_reference_rows_per_block) {
-
-          ////////////////////////////////////////////////////////////////////////////////
-
-          reference_reader->read_rows(
-              outer_idx,
-              std::min(outer_idx + n_reference_rows_per_block, reference_row_idx_end),
-              reference_rows_v);
-
-          if(reference_rows_v.size() != n_reference_rows_per_block) {
-            DASSERT_EQ(outer_idx + reference_rows_v.size(), reference_row_idx_end);
-          }
-
-          // Now over rows in the buffer.
-          for(size_t inner_idx = 0; inner_idx < reference_rows_v.size(); ++inner_idx) {
-
-            // Now, for each row, go through and calculate the full intersection.
-            const size_t ref_idx = outer_idx + inner_idx;
-            const auto& row = reference_rows_v[inner_idx];
+        while(reference_cursor.next(reference_row_idx_start, reference_row_idx_end)) {
+          // Read it in in blocks of n_reference_rows_per_block rows for efficiency.
+          for(size_t outer_idx = reference_row_idx_start;
+              outer_idx < reference_row_idx_end;
+              outer_idx += n_reference_rows_per_block) {
 
-            // Get the information for this particular vertex.
-            item_data_type ref_item_data = reference_item_info[ref_idx].item_data;
+            ////////////////////////////////////////////////////////////////////////////////
 
-            const final_item_data_type& ref_final_item_data
-                = reference_item_info[ref_idx].final_item_data;
+            reference_reader->read_rows(
+                outer_idx,
+                std::min(outer_idx + n_reference_rows_per_block, reference_row_idx_end),
+                reference_rows_v);
 
-            // Zero the edges.
-            edges.assign(num_query_rows_in_block, interaction_data_type());
-
-            // Get the vertex for this one here.
-            for(const auto& p : row) {
-              size_t dim_index = p.first;
-              double ref_value = p.second;
-
-              if(missing_values_are_zero) {
-                // This is in the inner loop, so a lot of time is spent
-                // in this computation.  Try to make it as friendly as
-                // possible to the vectorizer as possible.
-
-                double* __restrict__ bd_ptr = &(block_data[block_data_index(0, dim_index)]);
-                item_data_type* __restrict__ it_data_ptr = block_item_data.data();
-                interaction_data_type* __restrict__ int_data_ptr = edges.data();
-
-                for(int i = 0; i < int(num_query_rows_in_block);
-                    ++i, ++bd_ptr, ++it_data_ptr, ++int_data_ptr) {
+            if(reference_rows_v.size() != n_reference_rows_per_block) {
+              DASSERT_EQ(outer_idx + reference_rows_v.size(), reference_row_idx_end);
+            }
 
-                  similarity.update_interaction_unsafe(
-                      *int_data_ptr,
-                      ref_item_data, *it_data_ptr,
-                      ref_value, *bd_ptr);
-                }
-              } else {
-                for(size_t i = 0; i < num_query_rows_in_block; ++i) {
-                  // branching on individual entries, so can't do
-                  // vectorization here anyway.
-                  double block_data_entry = block_data[block_data_index(i, dim_index)];
-
-                  if(std::isnan(block_data_entry))
-                    continue;
-
-                  // Aggregate it along this edge.
-                  similarity.update_interaction_unsafe(
-                      edges[i],
-                      ref_item_data, block_item_data[i],
-                      ref_value, block_data_entry);
+            // Now over rows in the buffer.
+            for(size_t inner_idx = 0; inner_idx < reference_rows_v.size(); ++inner_idx) {
+
+              // Now, for each row, go through and calculate the full intersection.
+              const size_t ref_idx = outer_idx + inner_idx;
+              const auto& row = reference_rows_v[inner_idx];
+
+              // Get the information for this particular vertex.
+              item_data_type ref_item_data = reference_item_info[ref_idx].item_data;
+
+              const final_item_data_type& ref_final_item_data
+                  = reference_item_info[ref_idx].final_item_data;
+
+              // Zero the edges.
+              edges.assign(num_query_rows_in_block, interaction_data_type());
+
+              // Get the vertex for this one here.
+              for(const auto& p : row) {
+                size_t dim_index = p.first;
+                double ref_value = p.second;
+
+                if(missing_values_are_zero) {
+                  // This is in the inner loop, so a lot of time is spent
+                  // in this computation.  Try to make it as friendly as
+                  // possible to the vectorizer as possible.
+
+                  double* __restrict__ bd_ptr = &(block_data[block_data_index(0, dim_index)]);
+                  item_data_type* __restrict__ it_data_ptr = block_item_data.data();
+                  interaction_data_type* __restrict__ int_data_ptr = edges.data();
+
+                  for(int i = 0; i < int(num_query_rows_in_block);
+                      ++i, ++bd_ptr, ++it_data_ptr, ++int_data_ptr) {
+
+                    similarity.update_interaction_unsafe(
+                        *int_data_ptr,
+                        ref_item_data, *it_data_ptr,
+                        ref_value, *bd_ptr);
+                  }
+                } else {
+                  for(size_t i = 0; i < num_query_rows_in_block; ++i) {
+                    // branching on individual entries, so can't do
+                    // vectorization here anyway.
+                    double block_data_entry = block_data[block_data_index(i, dim_index)];
+
+                    if(std::isnan(block_data_entry))
+                      continue;
+
+                    // Aggregate it along this edge.
+                    similarity.update_interaction_unsafe(
+                        edges[i],
+                        ref_item_data, block_item_data[i],
+                        ref_value, block_data_entry);
+                  }
                 }
               }
-            }
 
-            // Now, go through, finalize the answers, and record them.
-            for(size_t i = 0; i < num_query_rows_in_block; ++i) {
-              size_t query_index = block_query_row_indices[i];
+              // Now, go through, finalize the answers, and record them.
+              for(size_t i = 0; i < num_query_rows_in_block; ++i) {
+                size_t query_index = block_query_row_indices[i];
 
-              if(skip_pair(query_index, ref_idx))
-                continue;
+                if(skip_pair(query_index, ref_idx))
+                  continue;
 
-              // Get the vertex and value info for this query row.
-              const auto& q_item_data = block_item_data[i];
-              const auto& q_final_item_data =
-                  (use_final_item_data ? block_final_item_data[i] : _unused);
+                // Get the vertex and value info for this query row.
+                const auto& q_item_data = block_item_data[i];
+                const auto& q_final_item_data =
+                    (use_final_item_data ? block_final_item_data[i] : _unused);
 
-              // Set up the output value.
-              final_interaction_data_type e_out = final_interaction_data_type();
+                // Set up the output value.
+                final_interaction_data_type e_out = final_interaction_data_type();
 
-              similarity.finalize_interaction(e_out,
-                                              ref_final_item_data, q_final_item_data,
-                                              edges[i],
-                                              ref_item_data, q_item_data);
+                similarity.finalize_interaction(e_out,
+                                                ref_final_item_data, q_final_item_data,
+                                                edges[i],
+                                                ref_item_data, q_item_data);
 
-              // Now do the meat of the operation -- record the result.
-              process_function(ref_idx, query_index, e_out);
+                // Now do the meat of the operation -- record the result.
+                process_function(ref_idx, query_index, e_out);
+              }
             }
           }
         }
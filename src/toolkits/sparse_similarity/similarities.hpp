@@ -394,7 +394,7 @@ class pearson {
   static std::string name() { return "pearson"; }
 
   // At the end, we have
-  struct item_data_type {
+  struct item_data_type : public IS_POD_TYPE {
     size_t count = 0;
     double mean = 0;
     double var_sum = 0;
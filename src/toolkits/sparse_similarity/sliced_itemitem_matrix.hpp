@@ -7,9 +7,12 @@
 #define TURI_SPARSE_SIM_SLICED_MATRIX_UTILITIES_H
 
 #include <vector>
+#include <algorithm>
+#include <cstdint>
 #include <core/logging/assertions.hpp>
 #include <core/parallel/atomic.hpp>
 #include <core/parallel/lambda_omp.hpp>
+#include <core/generics/sparse_parallel_2d_array.hpp>
 
 namespace turi { namespace sparse_sim {
 
@@ -163,6 +166,136 @@ class dense_triangular_itemitem_container {
 
 };
 
+/** A container holding a slice of rows of an upper triangular
+ *  matrix, with the pairs of two frequent items in a dense block and
+ *  all other pairs in a sparse hash table.
+ *
+ *  In item-item matrices with a long tail, nearly all the pairs of
+ *  two frequent items are hit, while pairs involving a rare item
+ *  mostly are not.  Storing the first densely and the rest sparsely
+ *  keeps the memory close to the number of pairs actually hit,
+ *  without paying the hash table cost on the hottest pairs.  The
+ *  dense block only spans the frequent items, so its rows are short
+ *  and stay in cache as a user's frequent items are accumulated.
+ *
+ *  The frequent items are set with set_dense_items before use.  As
+ *  with the other containers, a slice of rows covers the last cols()
+ *  items of the matrix, so row and column indices are relative to
+ *  item (num_items - cols()).  apply() on a sparse pair locks the
+ *  pair; apply() on a dense pair does not.
+ */
+template <typename T>
+class hybrid_triangular_itemitem_container {
+ public:
+
+  typedef T value_type;
+
+  hybrid_triangular_itemitem_container(){}
+
+  /** Sets the items, out of all num_items items of the matrix, whose
+   *  pairs with each other are stored densely.  dense_items must be
+   *  sorted.  This clears the container.
+   */
+  void set_dense_items(size_t num_items, const std::vector<size_t>& _dense_items) {
+    DASSERT_TRUE(std::is_sorted(_dense_items.begin(), _dense_items.end()));
+    DASSERT_LT(_dense_items.size(), size_t(NOT_DENSE));
+
+    dense_items = _dense_items;
+    dense_index.assign(num_items, uint32_t(NOT_DENSE));
+
+    for(size_t i = 0; i < dense_items.size(); ++i) {
+      DASSERT_LT(dense_items[i], num_items);
+      dense_index[dense_items[i]] = uint32_t(i);
+    }
+
+    clear();
+  }
+
+  /**  Clears all the data and the values, and resets the number of
+   *  rows and columns to 0.
+   */
+  void clear() {
+    num_rows = 0;
+    num_cols = 0;
+    dense.clear();
+    sparse.clear();
+  }
+
+  size_t rows() const { return num_rows; }
+  size_t cols() const { return num_cols; }
+
+  /**  Resize and clear the data.
+   */
+  void resize(size_t _num_rows, size_t _num_cols) {
+    DASSERT_LE(_num_rows, _num_cols);
+    DASSERT_LE(_num_cols, dense_index.size());
+
+    num_rows = _num_rows;
+    num_cols = _num_cols;
+    offset = dense_index.size() - num_cols;
+
+    // The dense items in this slice's rows, and all the dense items
+    // from the first of those on as columns.
+    dense_begin = std::lower_bound(dense_items.begin(), dense_items.end(), offset)
+                  - dense_items.begin();
+    size_t dense_end = std::lower_bound(dense_items.begin(), dense_items.end(),
+                                        offset + num_rows) - dense_items.begin();
+
+    dense.resize(dense_end - dense_begin, dense_items.size() - dense_begin);
+
+    sparse.clear();
+    sparse.resize(num_rows, num_cols);
+  }
+
+  /**  Apply a function to a particular element.
+   */
+  template <typename ApplyFunction>
+  GL_HOT_INLINE_FLATTEN
+  void apply(size_t idx_1, size_t idx_2, ApplyFunction&& apply_f) {
+    DASSERT_LT(idx_1, idx_2);
+
+    uint32_t d_1 = dense_index[offset + idx_1];
+    uint32_t d_2 = dense_index[offset + idx_2];
+
+    if(d_1 != NOT_DENSE && d_2 != NOT_DENSE) {
+      dense.apply(d_1 - dense_begin, d_2 - dense_begin, apply_f);
+    } else {
+      sparse.apply(idx_1, idx_2, apply_f);
+    }
+  }
+
+  /**  Process all the elements currently in this container.
+   */
+  template <typename ProcessValueFunction>
+  void apply_all(ProcessValueFunction&& process_interaction) {
+
+    dense.apply_all([&](size_t d_1, size_t d_2, value_type& value) {
+        process_interaction(dense_items[dense_begin + d_1] - offset,
+                            dense_items[dense_begin + d_2] - offset,
+                            value);
+      });
+
+    sparse.apply_all(process_interaction);
+  }
+
+  /** The number of items in the dense block.
+   */
+  size_t num_dense_items() const { return dense_items.size(); }
+
+ private:
+  static constexpr uint32_t NOT_DENSE = uint32_t(-1);
+
+  size_t num_rows = 0, num_cols = 0;
+  size_t offset = 0;
+  size_t dense_begin = 0;
+
+  std::vector<size_t> dense_items;
+  std::vector<uint32_t> dense_index;
+
+  dense_triangular_itemitem_container<value_type> dense;
+  sparse_parallel_2d_array<value_type> sparse;
+};
+
 }}
 
 #endif /* SLICED_MATRIX_UTILITIES_H */
@@ -84,8 +84,8 @@ void sparse_similarity_lookup::add_options(option_manager& options) {
     opt.description = ("The method used for training.");
     opt.default_value = "auto";
     opt.parameter_type = option_handling::option_info::CATEGORICAL;
-    opt.allowed_values = {"auto", "dense", "sparse",
-                          "nn", "nn:dense", "nn:sparse"};
+    opt.allowed_values = {"auto", "dense", "sparse", "hybrid",
+                          "nn", "nn:dense", "nn:sparse", "nn:hybrid"};
     options.create_option(opt);
 }
 
@@ -101,6 +101,33 @@ class sparse_similarity_lookup {
       size_t num_items,
       const std::shared_ptr<sarray<std::vector<std::pair<size_t, double> > > >& data) = 0;
 
+  /** Updates a model trained by train_from_sparse_matrix_sarray after
+   *  new interactions were added to its data, without retraining it.
+   *  data is the full sparse matrix sarray, new interactions
+   *  included, and updated_items lists the items whose interactions
+   *  were added or changed.  Items beyond the ones the model was
+   *  trained on, up to num_items, are new and always updated.
+   *
+   *  Only the similarities involving an updated item can change.
+   *  Those are recomputed exactly from the rows of the data holding
+   *  an updated item, using the item statistics kept from training
+   *  for the other items.  The neighbors of the updated items are
+   *  then chosen again, and the new similarities are merged into the
+   *  neighbors of the other items, keeping the top
+   *  max_item_neighborhood_size.  An item's neighbor whose similarity
+   *  dropped is not replaced by a pair cut from its neighbors before,
+   *  so with truncated neighborhoods the result may differ slightly
+   *  from retraining.
+   *
+   *  The degree_approximation_threshold sampling of training is not
+   *  applied to the updated items.
+   */
+  virtual std::map<std::string, flexible_type>
+  update_from_sparse_matrix_sarray(
+      size_t num_items,
+      const std::shared_ptr<sarray<std::vector<std::pair<size_t, double> > > >& data,
+      const std::vector<size_t>& updated_items) = 0;
+
   /** Sets the lookup tables directly from an sframe of interaction
    *  data.  The interaction data is an sframe containing columns
    *  item_column, similar_item_column, and similarity.  The items and
@@ -17,11 +17,14 @@
 #include <core/generics/sparse_parallel_2d_array.hpp>
 #include <core/storage/sframe_data/sframe.hpp>
 #include <core/storage/sframe_data/sframe_iterators.hpp>
+#include <core/storage/serialization/chunked_archive.hpp>
 #include <core/util/logit_math.hpp>
 #include <core/util/cityhash_tc.hpp>
 #include <core/util/dense_bitset.hpp>
 #include <core/util/sys_util.hpp>
 #include <core/parallel/pthread_tools.hpp>
+#include <numeric>
+#include <unordered_map>
 
 namespace turi { namespace sparse_sim {
 
@@ -90,6 +93,11 @@ class sparse_similarity_lookup_impl : public sparse_similarity_lookup {
   // types use this for processing.
   std::vector<final_item_data_type> final_item_data;
 
+  // The finalized item statistics from training, kept so the lookups
+  // can be updated with new interactions.  Empty if the lookups were
+  // set directly.
+  std::vector<item_data_type> item_data;
+
   ////////////////////////////////////////////////////////////////////////////////
   // Stuff for proper progress printing and tracking.
 
@@ -350,24 +358,16 @@ class sparse_similarity_lookup_impl : public sparse_similarity_lookup {
     item_neighbor_counts.clear();
     item_neighbor_counts.shrink_to_fit();
 
-    // Now, sort each max_item_neighborhood_size spot.
-    atomic<size_t> current_idx = 0;
-
-    in_parallel([&](size_t thread_idx, size_t num_threads) GL_GCC_ONLY(GL_HOT_NOINLINE_FLATTEN) {
-        while(true) {
-          size_t idx = (++current_idx) - 1;
-          if(idx >= total_num_items) {
-            break;
-          }
-
-          std::sort(item_interaction_data.begin() + item_neighbor_boundaries[idx],
-                    item_interaction_data.begin() + item_neighbor_boundaries[idx + 1],
-                    [](const std::pair<size_t, final_interaction_data_type>& p1,
-                       const std::pair<size_t, final_interaction_data_type>& p2) {
-                      return p1.first < p2.first;
-                    });
-        }
-      });
+    // Now, sort each max_item_neighborhood_size spot.  The neighborhoods
+    // differ a lot in size, so they are handed out dynamically.
+    parallel_for(size_t(0), total_num_items, [&](size_t idx) GL_GCC_ONLY(GL_HOT_NOINLINE_FLATTEN) {
+        std::sort(item_interaction_data.begin() + item_neighbor_boundaries[idx],
+                  item_interaction_data.begin() + item_neighbor_boundaries[idx + 1],
+                  [](const std::pair<size_t, final_interaction_data_type>& p1,
+                     const std::pair<size_t, final_interaction_data_type>& p2) {
+                    return p1.first < p2.first;
+                  });
+      }, parallel_schedule::DYNAMIC, 16);
   }
 
   ////////////////////////////////////////////////////////////////////////////////
@@ -385,6 +385,7 @@ class sparse_similarity_lookup_impl : public sparse_similarity_lookup {
       bool add_reverse = false) {
 
     total_num_items = num_items;
+    this->item_data.clear();
 
     {
       std::vector<final_item_data_type> _final_item_data;
@@ -457,11 +458,13 @@ class sparse_similarity_lookup_impl : public sparse_similarity_lookup {
 
   /** Estimates the density of the matrix, so we can get an accurate
    *  picture of how many passes will be needed to properly fit
-   *  everything in memory.
+   *  everything in memory.  If dense_items is given, the density is
+   *  that of the pairs not made of two of those items.
    */
    double estimate_sparse_matrix_density(
       const item_info_vector& item_info,
-      const std::vector<size_t>& items_per_user) {
+      const std::vector<size_t>& items_per_user,
+      const dense_bitset* dense_items = nullptr) {
 
     random::seed(0);
 
@@ -623,12 +626,18 @@ class sparse_similarity_lookup_impl : public sparse_similarity_lookup {
         });
 
     double total_prob = 0;
+    size_t num_counted_samples = 0;
 
     for(const _sample& s : samples) {
+      if(dense_items != nullptr && dense_items->get(s.i) && dense_items->get(s.j)) {
+        continue;
+      }
       total_prob += s.estimated_prob;
+      ++num_counted_samples;
     }
 
-    double estimated_density = total_prob / samples.size();
+    double estimated_density = (num_counted_samples == 0
+                                ? 0 : total_prob / num_counted_samples);
 
     return estimated_density;
   }
@@ -680,6 +689,63 @@ class sparse_similarity_lookup_impl : public sparse_similarity_lookup {
     return estimated_memory_usage_per_element;
   }
 
+  /** Chooses the items whose pairs with each other are held densely
+   *  in the hybrid mode -- the most frequent items, as many as fit in
+   *  half of target_memory_usage.  Returns them sorted by index.
+   */
+  std::vector<size_t> choose_hybrid_dense_items(const item_info_vector& item_info) {
+
+    size_t target_memory_usage = options.at("target_memory_usage");
+    size_t num_items = item_info.size();
+
+    double max_dense_pairs = double(target_memory_usage) / (2 * sizeof(interaction_data_type));
+    size_t num_dense = std::min<size_t>(
+        num_items, size_t(std::floor(0.5 + std::sqrt(2 * max_dense_pairs + 0.25))));
+
+    std::vector<size_t> items(num_items);
+    std::iota(items.begin(), items.end(), size_t(0));
+
+    std::nth_element(items.begin(), items.begin() + num_dense, items.end(),
+                     [&](size_t i, size_t j) {
+                       return item_info[i].num_users > item_info[j].num_users;
+                     });
+
+    items.resize(num_dense);
+    std::sort(items.begin(), items.end());
+    return items;
+  }
+
+  /** Bytes per item in the hybrid case, averaged over the whole
+   *  triangular matrix.
+   */
+  double bytes_per_item_hybrid(const item_info_vector& item_info,
+                               const std::vector<size_t>& items_per_user,
+                               const std::vector<size_t>& dense_items) {
+
+    size_t num_items = item_info.size();
+
+    dense_bitset is_dense(num_items);
+    for(size_t i : dense_items) {
+      is_dense.set_bit(i);
+    }
+
+    double estimated_density = estimate_sparse_matrix_density(
+        item_info, items_per_user, &is_dense);
+
+    logstream(LOG_INFO) << "Estimated density of sparse part of hybrid matrix at "
+                        << estimated_density << ". " << std::endl;
+
+    double num_pairs = 0.5 * double(num_items) * double(num_items);
+    double num_dense_pairs = 0.5 * double(dense_items.size()) * double(dense_items.size());
+
+    double total_bytes =
+        num_dense_pairs * sizeof(interaction_data_type)
+        + (num_pairs - num_dense_pairs) * estimated_density
+          * (1.7 * (sizeof(size_t) + sizeof(interaction_data_type)));
+
+    return total_bytes / std::max(1.0, num_pairs);
+  }
+
   ////////////////////////////////////////////////////////////////////////////////
 
   /** Get the threshold user count value above which we assume the
@@ -1333,6 +1399,11 @@ class sparse_similarity_lookup_impl : public sparse_similarity_lookup {
     calculate_item_processing_colwise(
         item_info, similarity, data, num_items, &items_per_user);
 
+    item_data.resize(num_items);
+    for(size_t i = 0; i < num_items; ++i) {
+      item_data[i] = item_info[i].item_data;
+    }
+
     size_t num_items_remaining = item_info.size();
 
     logprogress_stream << "Setting up lookup tables." << std::endl;
@@ -1500,13 +1571,20 @@ class sparse_similarity_lookup_impl : public sparse_similarity_lookup {
         error_out();
       }
 
+      bool force_sparse = (force_mode == "sparse" || force_mode == "nn:sparse");
+      bool force_hybrid = (force_mode == "hybrid" || force_mode == "nn:hybrid");
+
       // First, try to do a sparse pass.
-      double bpi_sparse = bytes_per_item_sparse(item_info, items_per_user);
+      std::vector<size_t> sparse_slice_structure;
+
+      if(!force_hybrid) {
+        double bpi_sparse = bytes_per_item_sparse(item_info, items_per_user);
 
-      logstream(LOG_INFO) << "Bytes per item in sparse matrix = " << bpi_sparse << std::endl;
+        logstream(LOG_INFO) << "Bytes per item in sparse matrix = " << bpi_sparse << std::endl;
 
-      std::vector<size_t> sparse_slice_structure
-          = calculate_slice_structure(num_items_remaining, max_data_passes, bpi_sparse);
+        sparse_slice_structure
+            = calculate_slice_structure(num_items_remaining, max_data_passes, bpi_sparse);
+      }
 
       bool sparse_possible = !sparse_slice_structure.empty();
 
@@ -1521,9 +1599,32 @@ class sparse_similarity_lookup_impl : public sparse_similarity_lookup {
         logstream(LOG_INFO) << "Number of data passes too high for sparse matrix. " << std::endl;
       }
 
-      // Are we disabling the dense mode by forcing the sparse mode?
-      // If so, then we keep trying until it works in the sparse mode.
-      bool disable_dense = (force_mode == "sparse" || force_mode == "nn:sparse");
+      // Next, the hybrid layout, with the pairs of the most frequent
+      // items held densely and the long tail sparsely.
+      std::vector<size_t> hybrid_dense_items;
+      std::vector<size_t> hybrid_slice_structure;
+
+      if(!force_sparse) {
+        hybrid_dense_items = choose_hybrid_dense_items(item_info);
+
+        double bpi_hybrid = bytes_per_item_hybrid(item_info, items_per_user, hybrid_dense_items);
+
+        logstream(LOG_INFO) << "Bytes per item in hybrid matrix = " << bpi_hybrid << std::endl;
+
+        hybrid_slice_structure
+            = calculate_slice_structure(num_items_remaining, max_data_passes, bpi_hybrid);
+      }
+
+      bool hybrid_possible = !hybrid_slice_structure.empty();
+
+      size_t num_hybrid_passes = (hybrid_possible
+                                  ? hybrid_slice_structure.size() - 1
+                                  : std::numeric_limits<size_t>::max());
+
+      // Are we disabling the dense mode by forcing the sparse or
+      // hybrid mode?  If so, then we keep trying until it works in
+      // that mode.
+      bool disable_dense = (force_sparse || force_hybrid);
 
       // If we are not disabling the dense mode, then attempt to do it
       // by allocating enough of the
@@ -1543,6 +1644,12 @@ class sparse_similarity_lookup_impl : public sparse_similarity_lookup {
           dense_mode_allowed_passes = std::min(8*num_sparse_passes, max_data_passes);
         }
 
+        // The hybrid mode only pays the sparse penalty on the long
+        // tail, so the dense mode needs to be closer to it.
+        if(hybrid_possible) {
+          dense_mode_allowed_passes = std::min(2*num_hybrid_passes, dense_mode_allowed_passes);
+        }
+
         bool success = attempt_dense_pass(dense_mode_allowed_passes);
 
         if(success) {
@@ -1555,7 +1662,39 @@ class sparse_similarity_lookup_impl : public sparse_similarity_lookup {
         }
       }
 
-      // Okay, dense didn't work.  So let's do sparse if possible.
+      // Okay, dense didn't work.  Use the hybrid mode if it takes no
+      // more passes than the sparse mode.
+      if(hybrid_possible && (force_hybrid || num_hybrid_passes <= num_sparse_passes)) {
+
+        if(num_hybrid_passes == 1) {
+          logprogress_stream
+              << "Processing data in one pass using hybrid dense/sparse lookup tables."
+              << std::endl;
+        } else {
+          logprogress_stream
+              << "Processing data in " << num_hybrid_passes
+              << " passes using hybrid dense/sparse lookup tables."
+              << std::endl;
+        }
+
+        hybrid_triangular_itemitem_container<interaction_data_type> hybrid_container;
+        hybrid_container.set_dense_items(num_items_remaining, hybrid_dense_items);
+
+        _train_with_sparse_matrix_sarray(
+            hybrid_container, hybrid_slice_structure, item_info,
+            items_per_user, index_mapper, progress_tracker, data);
+
+        // Record what we actually did for future reference.
+        if(nearest_neighbors_run) {
+          options["training_method"] = "nn:hybrid";
+        } else {
+          options["training_method"] = "hybrid";
+        }
+
+        goto ITEM_SIM_DONE;
+      }
+
+      // Otherwise, do sparse if possible.
       if(sparse_possible) {
 
         if(num_sparse_passes == 1) {
@@ -1633,6 +1772,298 @@ class sparse_similarity_lookup_impl : public sparse_similarity_lookup {
     return ret;
   }
 
+  ////////////////////////////////////////////////////////////////////////////////
+  // Incremental updates
+
+  /**  Update the lookup tables with new interactions.  See
+   *   sparse_similarity_lookup::update_from_sparse_matrix_sarray.
+   */
+  std::map<std::string, flexible_type>
+  update_from_sparse_matrix_sarray(
+      size_t num_items,
+      const std::shared_ptr<sarray<std::vector<std::pair<size_t, double> > > >& data,
+      const std::vector<size_t>& updated_items) {
+
+    turi::timer total_timer;
+    total_timer.start();
+
+    if(item_data.size() != total_num_items) {
+      log_and_throw("Only item similarity lookup tables trained from interaction data "
+                    "can be updated; retrain the model instead.");
+    }
+
+    if(num_items < total_num_items) {
+      log_and_throw("The number of items cannot decrease when updating the "
+                    "item similarity lookup tables.");
+    }
+
+    final_item_data_type _unused;
+    const double threshold = options.at("threshold");
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Step 1: Mark the items to update.  New items always are.
+
+    dense_bitset is_updated(num_items);
+
+    for(size_t item : updated_items) {
+      if(item >= num_items) {
+        log_and_throw("Updated item index out of range.");
+      }
+      is_updated.set_bit(item);
+    }
+
+    for(size_t item = total_num_items; item < num_items; ++item) {
+      is_updated.set_bit(item);
+    }
+
+    std::vector<size_t> changed_items;
+    changed_items.reserve(is_updated.popcount());
+
+    for(size_t item = 0; item < num_items; ++item) {
+      if(is_updated.get(item)) {
+        changed_items.push_back(item);
+      }
+    }
+
+    logprogress_stream << "Updating the similarities of " << changed_items.size()
+                       << " items." << std::endl;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Step 2: Gather the rows holding an updated item.  Every
+    // similarity that changed is computed from these rows alone.
+
+    std::vector<std::vector<std::pair<size_t, double> > > rows;
+    simple_spinlock rows_lock;
+
+    iterate_through_sparse_item_array(
+        data,
+        [&](size_t thread_idx, size_t row_idx,
+            const std::vector<std::pair<size_t, double> >& item_list) {
+
+          for(const auto& p : item_list) {
+            if(p.first < num_items && is_updated.get(p.first)) {
+              std::lock_guard<simple_spinlock> lg(rows_lock);
+              rows.push_back(item_list);
+              break;
+            }
+          }
+        });
+
+    // The rows holding each updated item.
+    std::vector<std::vector<size_t> > rows_by_changed_item(changed_items.size());
+
+    for(size_t r = 0; r < rows.size(); ++r) {
+      for(const auto& p : rows[r]) {
+        if(p.first < num_items && is_updated.get(p.first)) {
+          size_t k = std::lower_bound(changed_items.begin(), changed_items.end(), p.first)
+                     - changed_items.begin();
+          rows_by_changed_item[k].push_back(r);
+        }
+      }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Step 3: Recompute the statistics of the updated items.
+
+    item_data.resize(num_items, item_data_type());
+
+    if(use_final_item_data()) {
+      final_item_data.resize(num_items, final_item_data_type());
+    }
+
+    parallel_for(size_t(0), changed_items.size(), [&](size_t k) {
+        size_t item = changed_items[k];
+        item_data_type v = item_data_type();
+
+        for(size_t r : rows_by_changed_item[k]) {
+          for(const auto& p : rows[r]) {
+            if(p.first == item) {
+              similarity.update_item(v, p.second);
+            }
+          }
+        }
+
+        final_item_data_type fv = final_item_data_type();
+        similarity.finalize_item(fv, v);
+
+        item_data[item] = v;
+        if(use_final_item_data()) {
+          final_item_data[item] = fv;
+        }
+      });
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Step 4: Recompute the similarities of each updated item to every
+    // item it shares a row with, and choose its neighbors.
+
+    std::vector<std::vector<interaction_info_type> > changed_item_neighbors(changed_items.size());
+
+    // The new similarities to the other items, as (item, (updated item, value)).
+    std::vector<std::vector<std::pair<size_t, interaction_info_type> > >
+        incoming_by_thread(thread::cpu_count());
+
+    auto item_comparitor_for = [&](size_t item) {
+      return [&, item](const interaction_info_type& p1, const interaction_info_type& p2) {
+        return similarity.compare_interaction_values(
+            p1.second,
+            p2.second,
+            use_final_item_data() ? final_item_data[item] : _unused,
+            use_final_item_data() ? final_item_data[p1.first] : _unused,
+            use_final_item_data() ? final_item_data[p2.first] : _unused);
+      };
+    };
+
+    auto truncate_neighbors = [&](size_t item, std::vector<interaction_info_type>& neighbors) {
+      if(neighbors.size() > max_item_neighborhood_size) {
+        auto item_comparitor = item_comparitor_for(item);
+        std::nth_element(neighbors.begin(),
+                         neighbors.begin() + max_item_neighborhood_size,
+                         neighbors.end(),
+                         item_comparitor);
+        neighbors.resize(max_item_neighborhood_size);
+      }
+
+      std::sort(neighbors.begin(), neighbors.end(),
+                [](const interaction_info_type& p1, const interaction_info_type& p2) {
+                  return p1.first < p2.first;
+                });
+    };
+
+    parallel_for(size_t(0), changed_items.size(), [&](size_t k) {
+        const size_t item = changed_items[k];
+        auto& incoming = incoming_by_thread[thread::thread_id()];
+
+        std::unordered_map<size_t, interaction_data_type> edges;
+
+        for(size_t r : rows_by_changed_item[k]) {
+          const auto& row = rows[r];
+
+          auto it = std::lower_bound(
+              row.begin(), row.end(), std::make_pair(item, std::numeric_limits<double>::lowest()));
+          DASSERT_TRUE(it != row.end() && it->first == item);
+          const double value = it->second;
+
+          for(const auto& p : row) {
+            if(p.first == item || p.first >= num_items) {
+              continue;
+            }
+
+            // Keep the order of the pair the same as in training.
+            if(item < p.first) {
+              similarity.update_interaction(
+                  edges[p.first], item_data[item], item_data[p.first], value, p.second);
+            } else {
+              similarity.update_interaction(
+                  edges[p.first], item_data[p.first], item_data[item], p.second, value);
+            }
+          }
+        }
+
+        std::vector<interaction_info_type>& neighbors = changed_item_neighbors[k];
+        neighbors.reserve(edges.size());
+
+        for(const auto& e : edges) {
+          const size_t other = e.first;
+          const size_t item_a = std::min(item, other);
+          const size_t item_b = std::max(item, other);
+
+          final_interaction_data_type value = final_interaction_data_type();
+
+          similarity.finalize_interaction(
+              value,
+              use_final_item_data() ? final_item_data[item_a] : _unused,
+              use_final_item_data() ? final_item_data[item_b] : _unused,
+              e.second,
+              item_data[item_a],
+              item_data[item_b]);
+
+          if(!(value > threshold)) {
+            continue;
+          }
+
+          neighbors.push_back({other, value});
+
+          if(!is_updated.get(other)) {
+            incoming.push_back({other, {item, value}});
+          }
+        }
+
+        truncate_neighbors(item, neighbors);
+      }, parallel_schedule::DYNAMIC, 16);
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Step 5: Merge the new similarities into the neighbors of the
+    // other items, and rebuild the lookup tables.
+
+    std::vector<std::pair<size_t, interaction_info_type> > incoming;
+
+    for(auto& v : incoming_by_thread) {
+      incoming.insert(incoming.end(), v.begin(), v.end());
+      v.clear();
+      v.shrink_to_fit();
+    }
+
+    std::sort(incoming.begin(), incoming.end(),
+              [](const std::pair<size_t, interaction_info_type>& p1,
+                 const std::pair<size_t, interaction_info_type>& p2) {
+                return p1.first < p2.first;
+              });
+
+    std::vector<size_t> incoming_boundaries(num_items + 1, 0);
+    for(const auto& p : incoming) {
+      ++incoming_boundaries[p.first + 1];
+    }
+    for(size_t i = 0; i < num_items; ++i) {
+      incoming_boundaries[i + 1] += incoming_boundaries[i];
+    }
+
+    std::vector<std::vector<interaction_info_type> > new_neighbors(num_items);
+
+    parallel_for(size_t(0), num_items, [&](size_t item) {
+        std::vector<interaction_info_type>& neighbors = new_neighbors[item];
+
+        if(is_updated.get(item)) {
+          size_t k = std::lower_bound(changed_items.begin(), changed_items.end(), item)
+                     - changed_items.begin();
+          neighbors = std::move(changed_item_neighbors[k]);
+          return;
+        }
+
+        // Pairs of two items not updated are unchanged.
+        for(size_t i = item_neighbor_boundaries[item]; i < item_neighbor_boundaries[item + 1]; ++i) {
+          if(!is_updated.get(item_interaction_data[i].first)) {
+            neighbors.push_back(item_interaction_data[i]);
+          }
+        }
+
+        for(size_t i = incoming_boundaries[item]; i < incoming_boundaries[item + 1]; ++i) {
+          neighbors.push_back(incoming[i].second);
+        }
+
+        truncate_neighbors(item, neighbors);
+      }, parallel_schedule::DYNAMIC, 16);
+
+    item_neighbor_boundaries.assign(num_items + 1, 0);
+    for(size_t i = 0; i < num_items; ++i) {
+      item_neighbor_boundaries[i + 1] = item_neighbor_boundaries[i] + new_neighbors[i].size();
+    }
+
+    item_interaction_data.resize(item_neighbor_boundaries[num_items]);
+
+    parallel_for(size_t(0), num_items, [&](size_t item) {
+        std::copy(new_neighbors[item].begin(), new_neighbors[item].end(),
+                  item_interaction_data.begin() + item_neighbor_boundaries[item]);
+      });
+
+    total_num_items = num_items;
+
+    std::map<std::string, flexible_type> ret;
+    ret["num_updated_items"] = changed_items.size();
+    ret["num_rows_processed"] = rows.size();
+    ret["update_time"] = total_timer.current_time();
+    return ret;
+  }
+
   ////////////////////////////////////////////////////////////////////////////////
   // Score item for the update
 
@@ -1743,16 +2174,20 @@ class sparse_similarity_lookup_impl : public sparse_similarity_lookup {
   ////////////////////////////////////////////////////////////////////////////////
   // Routines for loading and serialization.
 
-  size_t get_version() const { return 1; }
+  size_t get_version() const { return 3; }
 
   void save(turi::oarchive& oarc) const {
 
     oarc << get_version();
 
+    // The interaction data dominates the model size, so it is written in
+    // compressed chunks which are saved and loaded in parallel.
     oarc << total_num_items
          << final_item_data
-         << item_neighbor_boundaries
-         << item_interaction_data;
+         << item_neighbor_boundaries;
+    save_chunked(oarc, item_interaction_data);
+
+    oarc << item_data;
   }
 
   /** Load things.
@@ -1762,13 +2197,25 @@ class sparse_similarity_lookup_impl : public sparse_similarity_lookup {
 
     iarc >> version;
 
-    ASSERT_MSG(version == 1,
+    ASSERT_MSG(version >= 1 && version <= 3,
                "Item similarity lookup does not support loading from this version.");
 
     iarc >> total_num_items
          >> final_item_data
-         >> item_neighbor_boundaries
-         >> item_interaction_data;
+         >> item_neighbor_boundaries;
+
+    if (version == 1) {
+      iarc >> item_interaction_data;
+    } else {
+      load_chunked(iarc, item_interaction_data);
+    }
+
+    // Version 3: The item statistics are kept for updates.
+    if (version >= 3) {
+      iarc >> item_data;
+    } else {
+      item_data.clear();
+    }
   }
 
   ////////////////////////////////////////////////////////////////////////////////
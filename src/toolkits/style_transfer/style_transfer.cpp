@@ -35,6 +35,9 @@ constexpr size_t DEFAULT_WIDTH = 256;
 
 constexpr size_t DEFAULT_BATCH_SIZE = 1;
 
+// Threads loading the images of the upcoming batches while the model trains.
+constexpr size_t NUM_PREFETCH_WORKERS = 2;
+
 void prepare_images(const image_type& image,
                     std::vector<float>::iterator start_iter, size_t width,
                     size_t height, size_t channels, size_t index) {
@@ -155,6 +158,7 @@ std::unique_ptr<data_iterator> style_transfer::create_iterator(
   iterator_params.content = std::move(content);
   iterator_params.repeat = repeat;
   iterator_params.random_seed = random_seed;
+  iterator_params.num_prefetch_workers = NUM_PREFETCH_WORKERS;
 
   return create_iterator(iterator_params);
 }
@@ -9,6 +9,7 @@
 
 #include <core/data/image/io.hpp>
 #include <core/data/sframe/gl_sframe.hpp>
+#include <core/logging/logger.hpp>
 #include <ml/neural_net/image_augmentation.hpp>
 #include <model_server/lib/image_util.hpp>
 
@@ -41,15 +42,43 @@ style_transfer_data_iterator::style_transfer_data_iterator(
       m_shuffle(params.shuffle),
       m_content_range_iterator(m_content_images.range_iterator()),
       m_content_next_row(m_content_range_iterator.begin()),
-      m_random_engine(params.random_seed) {}
+      m_random_engine(params.random_seed),
+      m_num_prefetch_workers(params.num_prefetch_workers) {}
 
 std::vector<st_example> style_transfer_data_iterator::next_batch(
     size_t batch_size) {
-  std::vector<std::tuple<flexible_type, flexible_type, flexible_type>>
-      raw_batch;
-  raw_batch.reserve(batch_size);
+  if (m_num_prefetch_workers == 0) {
+    return process_raw_batch(read_raw_batch(batch_size));
+  }
+
+  if (!m_prefetcher) {
+    // Start reading ahead, now that we know the batch size.
+    prefetch_pipeline::options opts;
+    opts.num_workers = m_num_prefetch_workers;
+    opts.queue_depth = 2 * m_num_prefetch_workers;
+    m_prefetch_batch_size = batch_size;
+    m_prefetcher.reset(new prefetch_pipeline(
+        [this, batch_size](raw_batch* out) {
+          *out = read_raw_batch(batch_size);
+          return !out->empty();
+        },
+        [](raw_batch raw) { return process_raw_batch(raw); }, opts));
+  } else if (batch_size != m_prefetch_batch_size) {
+    log_and_throw("The batch size must not change while prefetching batches.");
+  }
+
+  // Once the data is exhausted, the batch stays empty.
+  std::vector<st_example> result;
+  m_prefetcher->next(&result);
+  return result;
+}
 
-  while (raw_batch.size() < batch_size &&
+style_transfer_data_iterator::raw_batch
+style_transfer_data_iterator::read_raw_batch(size_t batch_size) {
+  raw_batch result;
+  result.reserve(batch_size);
+
+  while (result.size() < batch_size &&
          m_content_next_row != m_content_range_iterator.end()) {
     const turi::flexible_type& content_image = *m_content_next_row;
 
@@ -57,26 +86,13 @@ std::vector<st_example> style_transfer_data_iterator::next_batch(
     size_t random_style_index = dist(m_random_engine);
     const flexible_type& style_image = m_style_images[random_style_index];
 
-    raw_batch.emplace_back(content_image, style_image, random_style_index);
+    result.emplace_back(content_image, style_image, random_style_index);
 
     if (++m_content_next_row == m_content_range_iterator.end() && m_repeat) {
       if (m_shuffle) {
-        gl_sarray indices =
-            gl_sarray::from_sequence(0, m_content_images.size());
         std::uniform_int_distribution<uint64_t> dist(0);
-        uint64_t random_mask = dist(m_random_engine);
-        auto randomize_indices = [random_mask](const flexible_type& x) {
-          uint64_t masked_index = random_mask ^ x.to<uint64_t>();
-          return flexible_type(hash64(masked_index));
-        };
-
         gl_sframe temp_content({{"content", m_content_images}});
-        temp_content.add_column(
-            indices.apply(randomize_indices, flex_type_enum::INTEGER, false),
-            "_random_order");
-
-        temp_content = temp_content.sort("_random_order");
-        m_content_images = temp_content["content"];
+        m_content_images = temp_content.shuffle(dist(m_random_engine))["content"];
       }
 
       m_content_range_iterator = m_content_images.range_iterator();
@@ -84,11 +100,16 @@ std::vector<st_example> style_transfer_data_iterator::next_batch(
     }
   }
 
-  std::vector<st_example> result(raw_batch.size());
+  return result;
+}
+
+std::vector<st_example> style_transfer_data_iterator::process_raw_batch(
+    const raw_batch& raw) {
+  std::vector<st_example> result(raw.size());
 
-  for (size_t i = 0; i < raw_batch.size(); ++i) {
+  for (size_t i = 0; i < raw.size(); ++i) {
     flexible_type content_image, style_image, style_index;
-    std::tie(content_image, style_image, style_index) = raw_batch[i];
+    std::tie(content_image, style_image, style_index) = raw[i];
 
     result[i].style_image = get_image(style_image);
     result[i].content_image = get_image(content_image);
@@ -8,9 +8,12 @@
 #ifndef __TOOLKITS_STYLE_TRANSFER_DATA_ITERATOR_H_
 #define __TOOLKITS_STYLE_TRANSFER_DATA_ITERATOR_H_
 
+#include <memory>
 #include <random>
+#include <tuple>
 
 #include <core/data/sframe/gl_sarray.hpp>
+#include <ml/neural_net/batch_pipeline.hpp>
 
 namespace turi {
 namespace style_transfer {
@@ -40,6 +43,13 @@ class data_iterator {
 
     /** Determines results of shuffle operations if enabled. */
     int random_seed = 0;
+
+    /**
+     * Number of background threads loading the batches ahead of next_batch,
+     * or 0 to load each batch on the calling thread. When prefetching, every
+     * call to next_batch must request the same batch size.
+     */
+    size_t num_prefetch_workers = 0;
   };
 
   virtual ~data_iterator() = default;
@@ -58,6 +68,19 @@ class style_transfer_data_iterator : public data_iterator {
   std::vector<st_example> next_batch(size_t batch_size) override;
 
  private:
+  // The (content image, style image, style index) values of a batch.
+  typedef std::vector<std::tuple<flexible_type, flexible_type, flexible_type>>
+      raw_batch;
+
+  typedef neural_net::batch_pipeline<raw_batch, std::vector<st_example>>
+      prefetch_pipeline;
+
+  // Takes the next rows, shuffling the data at the end of each traversal.
+  raw_batch read_raw_batch(size_t batch_size);
+
+  // Loads the images. Safe to call concurrently.
+  static std::vector<st_example> process_raw_batch(const raw_batch& raw);
+
   gl_sarray m_style_images;
   gl_sarray m_content_images;
 
@@ -68,6 +91,12 @@ class style_transfer_data_iterator : public data_iterator {
   gl_sarray_range::iterator m_content_next_row;
 
   std::default_random_engine m_random_engine;
+
+  const size_t m_num_prefetch_workers;
+  size_t m_prefetch_batch_size = 0;
+
+  // Declared last, so that its workers stop before the state they read.
+  std::unique_ptr<prefetch_pipeline> m_prefetcher;
 };
 
 }  // namespace style_transfer
@@ -8,6 +8,7 @@
 #include <toolkits/supervised_learning/logistic_regression.hpp>
 #include <toolkits/supervised_learning/classifier_evaluations.hpp>
 #include <toolkits/supervised_learning/automatic_model_creation.hpp>
+#include <toolkits/supervised_learning/hyperparameter_search.hpp>
 #include <model_server/lib/toolkit_function_macros.hpp>
 
 namespace turi { namespace supervised {
@@ -44,6 +45,8 @@ REGISTER_FUNCTION(confusion_matrix, "data", "target", "predicted");
 
 REGISTER_FUNCTION(create_automatic_classifier_model, "data", "target", "validation_data", "options");
 REGISTER_FUNCTION(create_automatic_regression_model, "data", "target", "validation_data", "options");
+REGISTER_FUNCTION(tune_hyperparameters, "model_name", "data", "target",
+                  "validation_data", "trial_options", "options");
 END_FUNCTION_REGISTRATION
 
 }  // namespace supervised
@@ -0,0 +1,373 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <toolkits/supervised_learning/hyperparameter_search.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <core/parallel/lambda_omp.hpp>
+#include <core/parallel/pthread_tools.hpp>
+#include <core/parallel/thread_pool.hpp>
+#include <toolkits/supervised_learning/automatic_model_creation.hpp>
+#include <toolkits/supervised_learning/boosted_trees.hpp>
+#include <toolkits/supervised_learning/decision_tree.hpp>
+#include <toolkits/supervised_learning/linear_regression.hpp>
+#include <toolkits/supervised_learning/linear_svm.hpp>
+#include <toolkits/supervised_learning/logistic_regression.hpp>
+#include <toolkits/supervised_learning/random_forest.hpp>
+#include <toolkits/supervised_learning/supervised_learning_utils-inl.hpp>
+
+namespace turi {
+namespace supervised {
+
+namespace {
+
+// A set of options, and how its model did.
+struct trial {
+  size_t index = 0;
+  std::map<std::string, flexible_type> options;
+  std::shared_ptr<supervised_learning_model_base> model;
+  size_t max_iterations = 0;  // full budget; set on the first run
+  size_t iterations = 0;      // budget of the last run
+  double score = NAN;
+  bool finished = false;      // trained with its full budget
+};
+
+// Returns true if larger values of the metric are better.
+bool higher_is_better(const std::string& metric) {
+  return metric == "accuracy" || metric == "auc" || metric == "f1_score"
+      || metric == "precision" || metric == "recall";
+}
+
+// Number of times n trials can be cut by the reduction factor, leaving at
+// least one.
+size_t num_reductions(size_t n, size_t reduction_factor) {
+  size_t ret = 0;
+  for (; n >= reduction_factor; n /= reduction_factor) {
+    ++ret;
+  }
+  return ret;
+}
+
+/**
+ * Run fn(0), ..., fn(n - 1) concurrently, giving each call about
+ * threads_per_trial threads. The first exception thrown is rethrown once all
+ * the calls are done.
+ */
+void run_trials(size_t n, size_t threads_per_trial,
+                const std::function<void(size_t)>& fn) {
+
+  std::vector<std::exception_ptr> errors(n);
+  auto run = [&](size_t i) {
+    try {
+      fn(i);
+    } catch (...) {
+      errors[i] = std::current_exception();
+    }
+  };
+
+  size_t nworkers = thread_pool::get_instance().size();
+  size_t num_slots = std::min(n, std::max<size_t>(1, nworkers / threads_per_trial));
+
+  if (num_slots <= 1) {
+    // One trial at a time, each with all the workers.
+    for (size_t i = 0; i < n; ++i) {
+      run(i);
+    }
+  } else if (threads_per_trial == 1) {
+    // One trial per worker; parallel loops within a worker run serially.
+    parallel_for(0, n, run);
+  } else {
+    // Each slot runs trials on its own thread, and their parallel loops
+    // share the workers.
+    std::atomic<size_t> next(0);
+    thread_group slots;
+    for (size_t s = 0; s < num_slots; ++s) {
+      slots.launch([&]() {
+        for (size_t i = next++; i < n; i = next++) {
+          run(i);
+        }
+      });
+    }
+    slots.join();
+  }
+
+  for (const auto& e : errors) {
+    if (e) std::rethrow_exception(e);
+  }
+}
+
+}  // namespace
+
+
+std::shared_ptr<supervised_learning_model_base> create_supervised_model(
+    const std::string& model_name) {
+  std::shared_ptr<supervised_learning_model_base> result;
+  if (model_name == "boosted_trees_classifier") {
+    result = std::make_shared<xgboost::boosted_trees_classifier>();
+  } else if (model_name == "boosted_trees_regression") {
+    result = std::make_shared<xgboost::boosted_trees_regression>();
+  } else if (model_name == "random_forest_classifier") {
+    result = std::make_shared<xgboost::random_forest_classifier>();
+  } else if (model_name == "random_forest_regression") {
+    result = std::make_shared<xgboost::random_forest_regression>();
+  } else if (model_name == "decision_tree_classifier") {
+    result = std::make_shared<xgboost::decision_tree_classifier>();
+  } else if (model_name == "decision_tree_regression") {
+    result = std::make_shared<xgboost::decision_tree_regression>();
+  } else if (model_name == "classifier_logistic_regression") {
+    result = std::make_shared<logistic_regression>();
+  } else if (model_name == "classifier_svm") {
+    result = std::make_shared<linear_svm>();
+  } else if (model_name == "regression_linear_regression") {
+    result = std::make_shared<linear_regression>();
+  } else {
+    log_and_throw("Unrecognized Model: " + model_name);
+  }
+  return result;
+}
+
+
+variant_map_type tune_hyperparameters(
+    const std::string& model_name, gl_sframe data, const std::string& target,
+    const variant_type& _validation_data, const flex_list& trial_options,
+    const std::map<std::string, flexible_type>& _options) {
+
+  if (trial_options.empty()) {
+    log_and_throw("At least one set of options must be given.");
+  }
+
+  // Split the options of the search from those shared by every model.
+  std::map<std::string, flexible_type> options = _options;
+  auto take_option = [&](const std::string& name, const flexible_type& default_value) {
+    auto it = options.find(name);
+    if (it == options.end()) return default_value;
+    flexible_type ret = it->second;
+    options.erase(it);
+    return ret;
+  };
+
+  flex_int threads_per_trial = take_option("threads_per_trial", 1).to<flex_int>();
+  std::string early_stopping = take_option("early_stopping", "none").to<flex_string>();
+  flex_int reduction_factor = take_option("reduction_factor", 3).to<flex_int>();
+  flex_int min_iterations = take_option("min_iterations", 1).to<flex_int>();
+  std::string metric = take_option("metric", "auto").to<flex_string>();
+  flexible_type features = take_option("features", flex_undefined());
+
+  if (threads_per_trial < 1) {
+    log_and_throw("threads_per_trial must be at least 1.");
+  }
+  if (reduction_factor < 2) {
+    log_and_throw("reduction_factor must be at least 2.");
+  }
+  if (min_iterations < 1) {
+    log_and_throw("min_iterations must be at least 1.");
+  }
+  if (early_stopping != "none" && early_stopping != "successive_halving"
+      && early_stopping != "hyperband") {
+    log_and_throw("early_stopping must be \"none\", \"successive_halving\" "
+                  "or \"hyperband\".");
+  }
+
+  std::vector<trial> trials(trial_options.size());
+  for (size_t i = 0; i < trials.size(); ++i) {
+    if (trial_options[i].get_type() != flex_type_enum::DICT) {
+      log_and_throw("Each set of options must be a dictionary.");
+    }
+    trials[i].index = i;
+    trials[i].options = options;
+    for (const auto& kv : trial_options[i].get<flex_dict>()) {
+      trials[i].options[kv.first.to<flex_string>()] = kv.second;
+    }
+  }
+
+  // Index the data once, for all the trials.
+  std::shared_ptr<supervised_learning_model_base> proto =
+      create_supervised_model(model_name);
+
+  gl_sframe validation_data;
+  std::tie(data, validation_data) = create_validation_data(data, _validation_data);
+
+  gl_sframe f_data = data;
+  f_data.remove_column(target);
+  if (features.get_type() != flex_type_enum::UNDEFINED) {
+    flex_list _ft = features.to<flex_list>();
+    std::vector<std::string> ftv(_ft.begin(), _ft.end());
+    if (ftv.size() == 0) {
+      log_and_throw("Empty feature set has been specified");
+    }
+    f_data = f_data.select_columns(ftv);
+  }
+
+  sframe X = f_data.materialize_to_sframe();
+  sframe y = data.select_columns({target}).materialize_to_sframe();
+  check_target_column_type(proto->name(), y);
+
+  sframe valid_X, valid_y;
+  if (validation_data.num_columns() != 0) {
+    valid_X = validation_data.select_columns(f_data.column_names()).materialize_to_sframe();
+    valid_y = validation_data.select_columns({target}).materialize_to_sframe();
+    check_target_column_type(proto->name(), valid_y);
+
+    auto valid_filter_names = f_data.column_names();
+    valid_filter_names.push_back(target);
+    validation_data = validation_data.select_columns(valid_filter_names);
+  }
+
+  ml_missing_value_action missing_value_action =
+    proto->support_missing_value() ? ml_missing_value_action::USE_NAN
+                                   : ml_missing_value_action::ERROR;
+
+  std::pair<ml_data, ml_data> train_valid = proto->create_training_data(
+      X, y, valid_X, valid_y, missing_value_action);
+  const ml_data& train_data = train_valid.first;
+  const ml_data& valid_data = train_valid.second;
+  const ml_data& score_data = (valid_data.size() > 0) ? valid_data : train_data;
+
+  if (metric == "auto") {
+    metric = proto->is_classifier() ? "accuracy" : "rmse";
+  }
+  const bool maximize = higher_is_better(metric);
+
+  // Train a trial with its budget cut reductions_left times.
+  auto run = [&](trial& t, size_t reductions_left) {
+    std::shared_ptr<supervised_learning_model_base> model =
+        create_supervised_model(model_name);
+    model->init_from_ml_data(train_data, valid_data);
+    model->init_options(t.options);
+
+    if (early_stopping != "none") {
+      if (t.max_iterations == 0) {
+        if (model->get_current_options().count("max_iterations") == 0) {
+          log_and_throw("Model " + model_name + " has no max_iterations option "
+                        "and cannot be stopped early.");
+        }
+        t.max_iterations = model->get_option_value("max_iterations").to<flex_int>();
+      }
+      size_t iterations = t.max_iterations;
+      for (size_t r = 0; r < reductions_left; ++r) {
+        iterations /= reduction_factor;
+      }
+      t.iterations = std::min(t.max_iterations,
+                              std::max<size_t>(min_iterations, iterations));
+      model->set_options({{"max_iterations", t.iterations}});
+    } else if (model->get_current_options().count("max_iterations")) {
+      t.iterations = model->get_option_value("max_iterations").to<flex_int>();
+    }
+
+    model->train();
+
+    auto ret = model->evaluate(score_data, metric);
+    t.score = variant_get_value<flexible_type>(ret.at(metric)).to<double>();
+    t.model = model;
+    t.finished = (reductions_left == 0);
+  };
+
+  auto better = [&](const trial* a, const trial* b) {
+    return maximize ? (a->score > b->score) : (a->score < b->score);
+  };
+
+  // Successive halving over a bracket of trials.
+  auto run_bracket = [&](std::vector<trial*> bracket, size_t reductions) {
+    for (size_t r = reductions + 1; r-- > 0;) {
+      run_trials(bracket.size(), threads_per_trial,
+                 [&](size_t i) { run(*bracket[i], r); });
+      if (r == 0) break;
+
+      std::stable_sort(bracket.begin(), bracket.end(), better);
+      size_t keep = std::max<size_t>(1, bracket.size() / reduction_factor);
+      for (size_t i = keep; i < bracket.size(); ++i) {
+        bracket[i]->model.reset();
+      }
+      bracket.resize(keep);
+    }
+  };
+
+  std::vector<trial*> all_trials(trials.size());
+  for (size_t i = 0; i < trials.size(); ++i) {
+    all_trials[i] = &trials[i];
+  }
+
+  if (early_stopping == "none") {
+    run_bracket(all_trials, 0);
+
+  } else if (early_stopping == "successive_halving") {
+    run_bracket(all_trials, num_reductions(trials.size(), reduction_factor));
+
+  } else {
+    // Bracket s has s reductions, and a share of the trials proportional to
+    // reduction_factor^s / (s + 1).
+    size_t s_max = num_reductions(trials.size(), reduction_factor);
+    std::vector<double> share(s_max + 1);
+    double total_share = 0;
+    for (size_t s = 0; s <= s_max; ++s) {
+      share[s] = std::pow(double(reduction_factor), double(s)) / (s + 1);
+      total_share += share[s];
+    }
+
+    // Deal the trials out in order, each one to the bracket furthest below
+    // its share, so that neighboring trials land in different brackets.
+    std::vector<std::vector<trial*>> brackets(s_max + 1);
+    for (trial* t : all_trials) {
+      size_t best_s = 0;
+      double best_deficit = -std::numeric_limits<double>::max();
+      for (size_t s = 0; s <= s_max; ++s) {
+        double deficit = share[s] / total_share * (t->index + 1) - brackets[s].size();
+        if (deficit > best_deficit) {
+          best_deficit = deficit;
+          best_s = s;
+        }
+      }
+      brackets[best_s].push_back(t);
+    }
+
+    for (size_t s = s_max + 1; s-- > 0;) {
+      if (brackets[s].empty()) continue;
+      run_bracket(brackets[s],
+                  std::min(s, num_reductions(brackets[s].size(), reduction_factor)));
+    }
+  }
+
+  // The best of the trials trained with their full budget.
+  const trial* best = nullptr;
+  for (const trial& t : trials) {
+    if (t.finished && (best == nullptr || better(&t, best))) {
+      best = &t;
+    }
+  }
+  ASSERT_TRUE(best != nullptr);
+
+  best->model->add_or_update_state({{"validation_data", validation_data}});
+  best->model->add_training_and_validation_metrics(data, validation_data);
+
+  std::vector<flexible_type> trial_column, options_column, iterations_column, score_column;
+  for (const trial& t : trials) {
+    trial_column.push_back(t.index);
+    options_column.push_back(trial_options[t.index]);
+    iterations_column.push_back(t.iterations);
+    score_column.push_back(t.score);
+  }
+
+  gl_sframe results({{"trial", trial_column},
+                     {"options", options_column},
+                     {"iterations", iterations_column},
+                     {metric, score_column}});
+  results = results.select_columns({"trial", "options", "iterations", metric});
+
+  return {{"model", to_variant(best->model)},
+          {"best_trial", to_variant(best->index)},
+          {"results", to_variant(results)}};
+}
+
+}  // namespace supervised
+}  // namespace turi
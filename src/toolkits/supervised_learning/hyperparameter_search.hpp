@@ -0,0 +1,82 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_SUPERVISED_HYPERPARAMETER_SEARCH_H_
+#define TURI_SUPERVISED_HYPERPARAMETER_SEARCH_H_
+
+#include <toolkits/supervised_learning/supervised_learning.hpp>
+
+namespace turi {
+namespace supervised {
+
+/**
+ * Create an untrained supervised model from its registered name, e.g.
+ * "boosted_trees_classifier" or "regression_linear_regression".
+ */
+std::shared_ptr<supervised_learning_model_base> create_supervised_model(
+    const std::string& model_name);
+
+/**
+ * Train one model per set of options and return the best one.
+ * -----------------------------------------------------------------------------
+ *
+ * The training and validation data are indexed into ml_data once, and every
+ * trial is initialized from them, instead of each trial filling its own
+ * ml_data and checking the data again.
+ *
+ * Trials run concurrently. With threads_per_trial = 1 (the default), each
+ * trial runs on one worker thread, so as many trials train at once as there
+ * are workers. With more threads per trial, fewer trials run at once and
+ * their parallel loops share the workers. Progress printed by concurrent
+ * trials is interleaved.
+ *
+ * Trials are scored by a metric on the validation data (on the training
+ * data without validation data). With early stopping, trials start with a
+ * fraction of their max_iterations, and only the best 1 / reduction_factor
+ * of them are trained again with reduction_factor times more iterations,
+ * until the last ones are trained with their full max_iterations:
+ *
+ *  - "successive_halving": one such bracket over all the trials, starting
+ *    from max_iterations / reduction_factor^s, with about one trial left
+ *    after s reductions.
+ *
+ *  - "hyperband": the trials are split over brackets of s, s - 1, ..., 0
+ *    reductions, the more aggressive brackets getting more trials, which
+ *    hedges against stopping slow starters too early.
+ *
+ * A trial trained again starts over with the larger budget.
+ *
+ * \param[in] model_name Registered name of the model to tune.
+ * \param[in] data Training data.
+ * \param[in] target Name of the target column.
+ * \param[in] validation_data "auto", an empty SFrame, or the validation
+ * SFrame, as in create().
+ * \param[in] trial_options One dictionary of model options per trial.
+ * \param[in] options Options of the search, and model options shared by
+ * all the trials:
+ *   - threads_per_trial: Threads used by a trial (default 1).
+ *   - early_stopping: "none" (default), "successive_halving" or
+ *     "hyperband".
+ *   - reduction_factor: Factor by which trials are cut at each reduction
+ *     (default 3).
+ *   - min_iterations: Smallest number of iterations a trial trains for
+ *     (default 1).
+ *   - metric: Metric to select trials with, or "auto" for accuracy
+ *     (classifiers) or rmse (regression).
+ *   - features: Feature columns, as in create().
+ *
+ * \returns A dictionary with the best trained model in "model", the
+ * index of its trial in "best_trial", and an SFrame "results" with the
+ * trial index, its options, the iterations of its last run and its score.
+ */
+variant_map_type tune_hyperparameters(
+    const std::string& model_name, gl_sframe data, const std::string& target,
+    const variant_type& validation_data, const flex_list& trial_options,
+    const std::map<std::string, flexible_type>& options);
+
+}  // namespace supervised
+}  // namespace turi
+
+#endif
@@ -121,7 +121,7 @@ void linear_regression::init_options(const std::map<std::string,
       "Solver used for training",
       "auto",
       {flexible_type("auto"), flexible_type("newton"), flexible_type("lbfgs"),
-      flexible_type("fista")},
+      flexible_type("newton_cg"), flexible_type("fista")},
       false);
 
   options.create_real_option(
@@ -168,6 +168,11 @@ void linear_regression::train(){
   size_t variables =  variant_get_value<size_t>(state.at("num_coefficients"));
   DenseVector init_point(variables);
   init_point.setZero();
+  if (warm_start_coefs.size() > 0) {
+    DASSERT_EQ(warm_start_coefs.size(), variables);
+    init_point = warm_start_coefs;
+    lr_interface->scale_solution(init_point);
+  }
 
   display_regression_training_summary("Linear regression");
   logprogress_stream << "Number of coefficients    : " << variables << std::endl;
@@ -228,7 +233,7 @@ void linear_regression::train(){
 
   std::stringstream ss;
   if (l1_penalty > optimization::OPTIMIZATION_ZERO &&
-      (solver ==  "newton" || solver == "lbfgs")){
+      (solver ==  "newton" || solver == "newton_cg" || solver == "lbfgs")){
     ss << "Solver '" << solver
        << "' not compatible with L1-regularization. "
        << "Try using the option solver='fista'."
@@ -252,6 +257,9 @@ void linear_regression::train(){
   if (solver == "newton"){
     stats = turi::optimization::newton_method(*lr_interface, init_point,
         solver_options, smooth_reg);
+  } else if (solver == "newton_cg"){
+    stats = turi::optimization::newton_cg_method(*lr_interface, init_point,
+        solver_options, smooth_reg);
   } else if (solver == "fista"){
     stats = turi::optimization::accelerated_gradient(*lr_interface,
         init_point, solver_options, reg);
@@ -261,7 +269,7 @@ void linear_regression::train(){
   } else {
       std::ostringstream msg;
       msg << "Solver " << solver << " is not supported." << std::endl;
-      msg << "Supported solvers are (auto, newton, lbfgs, fista)" << std::endl;
+      msg << "Supported solvers are (auto, newton, newton_cg, lbfgs, fista)" << std::endl;
       log_and_throw(msg.str());
   }
 
@@ -337,6 +345,37 @@ flexible_type linear_regression::predict_single_example(
   return x.dot(coefs);
 }
 
+/**
+ * Predict for a batch of examples.
+ */
+std::vector<flexible_type> linear_regression::predict_batch(
+         const DenseMatrix& X,
+         const prediction_type_enum& output_type){
+  DenseVector preds = X * coefs;
+  return std::vector<flexible_type>(preds.data(), preds.data() + preds.size());
+}
+
+/**
+ * The coefficients, for predictions in blocks.
+ */
+bool linear_regression::get_margin_coefficients(DenseMatrix& W) const {
+  W = coefs;
+  return true;
+}
+
+/**
+ * Predictions for a block of examples from their margins.
+ */
+void linear_regression::predict_from_margins(
+         const DenseMatrix& margins,
+         const prediction_type_enum& output_type,
+         std::vector<flexible_type>& out) const {
+  out.resize(margins.rows());
+  for (size_t i = 0; i < out.size(); ++i) {
+    out[i] = margins(i, 0);
+  }
+}
+
 /**
  * Setter for coefficients vector.
  */
@@ -88,6 +88,15 @@ void linear_regression_opt_interface::rescale_solution(DenseVector& coefs) {
   }
 }
 
+/**
+ * Transform a solution to the solver's scale.
+ */
+void linear_regression_opt_interface::scale_solution(DenseVector& coefs) {
+  if(feature_rescaling){
+    scaler->inverse_transform(coefs);
+  }
+}
+
 /**
  * Get the number of variables in the model.
  */
@@ -186,22 +195,28 @@ void linear_regression_opt_interface::compute_first_order_statistics(const
   // Sparse data.
   } else {
       in_parallel([&](size_t thread_idx, size_t num_threads) {
-        SparseVector x(variables);
-        double r = 0;
-        for(auto it = data.get_iterator(thread_idx, num_threads);
-                                                            !it.done(); ++it) {
-          // Fill.
-          fill_reference_encoding(*it, x);
-          x.coeffRef(variables - 1) = 1;
+        const size_t batch_size = reference_encoding_batch_size(data.max_row_size() + 1);
+        SparseRowMatrix x;
+        SparseVector x_row(variables);
+        std::vector<Eigen::Triplet<double> > triplets;
+        DenseVector y(batch_size);
+
+        auto it = data.get_iterator(thread_idx, num_threads);
+        while(size_t n = fill_reference_encoding_batch(
+                it, x, variables, batch_size, x_row, triplets,
+                [&](const ml_data_row_reference& row, size_t i) {
+                  y(i) = row.target_value();
+                  return true;
+                })) {
+
           if(feature_rescaling){
             scaler->transform(x);
           }
 
-          // Compute.
-          r = x.dot(point) - it->target_value();
-          SparseVector G_buffer = 2 * r * x;
-          optimization::vector_add<DenseVector, SparseVector>(G[thread_idx], G_buffer);
-          f[thread_idx] += r * r;
+          // Compute
+          DenseVector r = x * point - y.head(n);
+          G[thread_idx] += 2 * (x.transpose() * r);
+          f[thread_idx] += r.dot(r);
         }
       });
   }
@@ -301,6 +316,57 @@ void linear_regression_opt_interface::compute_second_order_statistics( const
   }
 }
 
+/**
+ * Compute the hessian-vector product: 2 * X^T * (X * direction).  The
+ * hessian does not depend on the point.
+*/
+void linear_regression_opt_interface::compute_hessian_vector_product(
+    const DenseVector& point, const DenseVector& direction,
+    DenseVector& product) {
+
+  std::vector<DenseVector> HV(n_threads, Eigen::MatrixXd::Zero(variables, 1));
+
+  // Dense data.
+  if (this->is_dense) {
+    in_parallel([&](size_t thread_idx, size_t num_threads) {
+      DenseMatrix x(LINEAR_REGRESSION_BATCH_SIZE, variables);
+      auto it = data.get_iterator(thread_idx, num_threads);
+      while(fill_reference_encoding_batch(it, x, LINEAR_REGRESSION_BATCH_SIZE,
+              [](const ml_data_row_reference&, size_t) { return true; })) {
+        if(feature_rescaling){
+          scaler->transform(x);
+        }
+        HV[thread_idx] += 2 * (x.transpose() * (x * direction));
+      }
+    });
+
+  // Sparse data
+  } else {
+    in_parallel([&](size_t thread_idx, size_t num_threads) {
+      const size_t batch_size = reference_encoding_batch_size(data.max_row_size() + 1);
+      SparseRowMatrix x;
+      SparseVector x_row(variables);
+      std::vector<Eigen::Triplet<double> > triplets;
+
+      auto it = data.get_iterator(thread_idx, num_threads);
+      while(fill_reference_encoding_batch(it, x, variables, batch_size, x_row, triplets,
+              [](const ml_data_row_reference&, size_t) { return true; })) {
+        if(feature_rescaling){
+          scaler->transform(x);
+        }
+        DenseVector xd = x * direction;
+        HV[thread_idx] += 2 * (x.transpose() * xd);
+      }
+    });
+  }
+
+  // Reduce on threads.
+  product = HV[0];
+  for(size_t i=1; i < n_threads; i++){
+    product += HV[i];
+  }
+}
+
 void linear_regression_opt_interface::compute_first_order_statistics(const
     DenseVector& point, DenseVector& gradient, double& function_value, const
     size_t mbStart, const size_t mbSize) {
@@ -185,6 +185,11 @@ void linear_svm::train() {
   // ---------------------------------------------------------------------------
   DenseVector init_point(variables);
   init_point.setZero();
+  if (warm_start_coefs.size() > 0) {
+    DASSERT_EQ(warm_start_coefs.size(), variables);
+    init_point = warm_start_coefs;
+    scaled_logistic_svm_interface->scale_solution(init_point);
+  }
 
   // Box constriants for L1 loss SVM
   float penalty = options.value("penalty");
@@ -291,6 +296,56 @@ flexible_type linear_svm::predict_single_example(
   ASSERT_UNREACHABLE();
 }
 
+/**
+ * The coefficients, for predictions in blocks.
+ */
+bool linear_svm::get_margin_coefficients(DenseMatrix& W) const {
+  W = coefs;
+  return true;
+}
+
+/**
+ * Predictions for a block of examples from their margins.
+ */
+void linear_svm::predict_from_margins(
+         const DenseMatrix& margins,
+         const prediction_type_enum& output_type,
+         std::vector<flexible_type>& out) const {
+  out.resize(margins.rows());
+  switch (output_type) {
+    case prediction_type_enum::MARGIN:
+      for (size_t i = 0; i < out.size(); ++i) {
+        out[i] = margins(i, 0);
+      }
+      return;
+
+    case prediction_type_enum::CLASS_INDEX:
+      for (size_t i = 0; i < out.size(); ++i) {
+        out[i] = (margins(i, 0) >= 0.0);
+      }
+      return;
+
+    case prediction_type_enum::NA:
+    case prediction_type_enum::CLASS:
+    {
+      // Only two classes: map them once.
+      flexible_type classes[2] = {
+        ml_mdata->target_indexer()->map_index_to_value(0),
+        ml_mdata->target_indexer()->map_index_to_value(1)};
+      for (size_t i = 0; i < out.size(); ++i) {
+        out[i] = classes[margins(i, 0) >= 0.0];
+      }
+      return;
+    }
+
+    case prediction_type_enum::PROBABILITY:
+    case prediction_type_enum::MAX_PROBABILITY:
+    case prediction_type_enum::RANK:
+    case prediction_type_enum::PROBABILITY_VECTOR:
+      log_and_throw("Output type not supported.");
+  }
+}
+
 /**
  * Predict for a single example.
  */
@@ -106,6 +106,11 @@ class EXPORT linear_svm: public supervised_learning_model_base {
    */
   void set_coefs(const DenseVector& _coefs) override;
 
+  /**
+   * Training can start from the current coefficients.
+   */
+  bool supports_warm_start() const override { return true; }
+
   /**
    * Serialize the object.
    */
@@ -143,6 +148,19 @@ class EXPORT linear_svm: public supervised_learning_model_base {
     const SparseVector& x,
     const prediction_type_enum& output_type=prediction_type_enum::NA) override;
 
+  /**
+   * The coefficients, for predictions in blocks.
+   */
+  bool get_margin_coefficients(DenseMatrix& W) const override;
+
+  /**
+   * Predictions for a block of examples from their margins.
+   */
+  void predict_from_margins(
+    const DenseMatrix& margins,
+    const prediction_type_enum& output_type,
+    std::vector<flexible_type>& out) const override;
+
   /**
    * Make classification using a trained supervised_learning model.
    *
@@ -168,7 +186,7 @@ class EXPORT linear_svm: public supervised_learning_model_base {
   /**
   * Get coefficients for a trained model.
   */
-  void get_coefficients(DenseVector& _coefs) const{
+  void get_coefficients(DenseVector& _coefs) const override {
     _coefs.resize(coefs.size());
     _coefs = coefs;
   }
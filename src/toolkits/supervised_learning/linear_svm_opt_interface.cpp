@@ -174,6 +174,15 @@ void linear_svm_scaled_logistic_opt_interface::rescale_solution(DenseVector& coe
   }
 }
 
+/**
+ * Transform a solution to the solver's scale.
+ */
+void linear_svm_scaled_logistic_opt_interface::scale_solution(DenseVector& coefs) {
+  if(feature_rescaling){
+    scaler->inverse_transform(coefs);
+  }
+}
+
 double linear_svm_scaled_logistic_opt_interface::get_validation_accuracy() {
   DASSERT_TRUE(valid_data.num_rows() > 0);
 
@@ -218,66 +227,82 @@ void linear_svm_scaled_logistic_opt_interface::compute_first_order_statistics(co
   std::vector<double> f(n_threads, 0.0);
   std::vector<DenseVector> G(n_threads, Eigen::MatrixXd::Zero(primal_variables, 1));
 
+  // The rows are read in batches, as rows of a matrix X.  The products
+  // of all the rows with the point are then X * point, and the gradient
+  // is X^T * r, where r_i is the weighted derivative with respect to the
+  // product of row i.
+  auto accumulate_batch = [&](size_t thread_idx, size_t n,
+                              const DenseVector& x_dot_point,
+                              const std::vector<size_t>& class_idx,
+                              DenseVector& r) {
+    r.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      size_t c = class_idx[i];
+      double y = c * 2 - 1.0;
+      double margin = -gamma * (y * x_dot_point(i) - 1);
+      double row_prob = -1.0/(1 + exp(-margin));
+      double row_func;
+      if (margin < -100){
+        row_func = 0;
+      } else if (margin > 50){
+        row_func = margin;
+      } else {
+        row_func = log1p(exp(margin));
+      }
+      f[thread_idx] += class_weights[c] * row_func / gamma;
+      r(i) = class_weights[c] * y * row_prob;
+    }
+  };
+
+  auto record_class = [&](std::vector<size_t>& class_idx) {
+    return [&](const ml_data_row_reference& row, size_t i) {
+      class_idx[i] = row.target_index();
+      return true;
+    };
+  };
+
   // Dense data.
   if (this->is_dense) {
     in_parallel([&](size_t thread_idx, size_t num_threads) {
-      DenseVector x(primal_variables);
-      double y, row_prob, margin, row_func;
-      size_t class_idx = 0;
-      for(auto it = data.get_iterator(thread_idx, num_threads);
-                                                              !it.done(); ++it) {
-        fill_reference_encoding(*it, x);
-        x.coeffRef(primal_variables - 1) = 1;
+      const size_t batch_size = reference_encoding_batch_size(primal_variables);
+      DenseMatrix X(batch_size, primal_variables);
+      DenseVector x_dot_point, r;
+      std::vector<size_t> class_idx(batch_size);
+
+      auto it = data.get_iterator(thread_idx, num_threads);
+      while (size_t n = fill_reference_encoding_batch(
+               it, X, batch_size, record_class(class_idx))) {
         if(feature_rescaling){
-          scaler->transform(x);
+          scaler->transform(X);
         }
 
-        // Map
-        class_idx = it->target_index();
-        y = class_idx * 2 - 1.0;
-        margin = -gamma * (y * x.dot(point) - 1);
-        row_prob = -1.0/(1 + exp(-margin));
-        if (margin < -100){
-          row_func = 0;
-        } else if (margin > 50){
-          row_func = margin;
-        } else {
-          row_func = log1p(exp(margin));
-        }
-        f[thread_idx] += class_weights[class_idx] * row_func / gamma;
-        G[thread_idx] += class_weights[class_idx] * y * x * row_prob;
+        x_dot_point.noalias() = X * point;
+        accumulate_batch(thread_idx, n, x_dot_point, class_idx, r);
+        G[thread_idx].noalias() += X.transpose() * r;
       }
     });
 
   // Sparse data
   } else {
     in_parallel([&](size_t thread_idx, size_t num_threads) {
+      const size_t batch_size = reference_encoding_batch_size(data.max_row_size() + 1);
+      SparseRowMatrix X;
       SparseVector x(primal_variables);
-      double y, row_prob, margin, row_func;
-      size_t class_idx = 0;
-      for(auto it = data.get_iterator(thread_idx, num_threads);
-                                                              !it.done(); ++it) {
-        fill_reference_encoding(*it, x);
-        x.coeffRef(primal_variables - 1) = 1;
+      std::vector<Eigen::Triplet<double> > triplets;
+      DenseVector x_dot_point, r;
+      std::vector<size_t> class_idx(batch_size);
+
+      auto it = data.get_iterator(thread_idx, num_threads);
+      while (size_t n = fill_reference_encoding_batch(
+               it, X, primal_variables, batch_size, x, triplets,
+               record_class(class_idx))) {
         if(feature_rescaling){
-          scaler->transform(x);
+          scaler->transform(X);
         }
 
-        // Map
-        class_idx = it->target_index();
-        y = class_idx * 2 - 1.0;
-        margin = -gamma * (y * x.dot(point) - 1);
-        row_prob = -1.0/(1 + exp(-margin));
-        if (margin < -100){
-          row_func = 0;
-        } else if (margin > 50){
-          row_func = margin;
-        } else {
-          row_func = log1p(exp(margin));
-        }
-        f[thread_idx] += class_weights[class_idx] * row_func / gamma;
-        SparseVector G_tmp = class_weights[class_idx] * y * x * row_prob;
-        optimization::vector_add<DenseVector, SparseVector>(G[thread_idx], G_tmp);
+        x_dot_point = X * point;
+        accumulate_batch(thread_idx, n, x_dot_point, class_idx, r);
+        G[thread_idx] += X.transpose() * r;
       }
     });
   }
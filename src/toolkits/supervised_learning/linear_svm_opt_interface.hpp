@@ -103,6 +103,14 @@ class linear_svm_scaled_logistic_opt_interface: public
    */
   void rescale_solution(DenseVector& coefs);
 
+  /**
+   * Transform a solution from the original scale to the solver's scale, the
+   * inverse of rescale_solution.
+   *
+   * \param[in,out] coefs Solution vector
+   */
+  void scale_solution(DenseVector& coefs);
+
   /**
   * Set the number of threads
   *
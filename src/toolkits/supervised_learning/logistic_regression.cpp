@@ -127,7 +127,7 @@ void logistic_regression::init_options(const std::map<std::string,
       "Solver used for training",
       "auto",
       {flexible_type("auto"), flexible_type("newton"),
-       flexible_type("lbfgs"),
+       flexible_type("lbfgs"), flexible_type("newton_cg"),
        flexible_type("gd"), flexible_type("fista")},
       false);
 
@@ -207,6 +207,11 @@ void logistic_regression::train() {
   // ---------------------------------------------------------------------------
   DenseVector init_point(this->num_coefficients);
   init_point.setZero();
+  if (warm_start_coefs.size() > 0) {
+    DASSERT_EQ(warm_start_coefs.size(), this->num_coefficients);
+    init_point = warm_start_coefs;
+    lr_interface->scale_solution(init_point);
+  }
   if(!m_simple_mode) {
     display_classifier_training_summary("Logistic regression", m_simple_mode);
     if(!m_simple_mode) {
@@ -274,7 +279,7 @@ void logistic_regression::train() {
 
   std::stringstream ss;
   if (l1_penalty > optimization::OPTIMIZATION_ZERO &&
-      (solver ==  "newton" || solver == "lbfgs")){
+      (solver ==  "newton" || solver == "newton_cg" || solver == "lbfgs")){
     ss << "Solver '" << solver
        << "' not compatible with L1-regularization. "
        << "Try using the option solver='fista'."
@@ -301,6 +306,9 @@ void logistic_regression::train() {
   if (solver == "newton") {
     stats = turi::optimization::newton_method(*lr_interface, init_point,
         solver_options, smooth_reg);
+  } else if (solver == "newton_cg") {
+    stats = turi::optimization::newton_cg_method(*lr_interface, init_point,
+        solver_options, smooth_reg);
   } else if (solver == "lbfgs") {
     stats = turi::optimization::lbfgs_compat(lr_interface, init_point,
         solver_options, smooth_reg);
@@ -310,7 +318,7 @@ void logistic_regression::train() {
   } else {
     std::ostringstream msg;
     msg << "Solver " << solver << " is not supported." << std::endl;
-    msg << "Supported solvers are (auto, newton, lbfgs, fista)" << std::endl;
+    msg << "Supported solvers are (auto, newton, newton_cg, lbfgs, fista)" << std::endl;
     log_and_throw(msg.str());
   }
 
@@ -588,6 +596,123 @@ flexible_type logistic_regression::predict_single_example(
   return flex_undefined();
 }
 
+/**
+ * The coefficients, for predictions in blocks: one column per class but the
+ * first (the reference class, whose margin is 0).
+ */
+bool logistic_regression::get_margin_coefficients(DenseMatrix& W) const {
+  size_t variables_per_class = this->num_coefficients / (this->num_classes - 1);
+  W = coefs;
+  W.resize(variables_per_class, this->num_classes - 1);
+  return true;
+}
+
+/**
+ * Predictions for a block of examples from their margins. Same as
+ * predict_single_example(DenseVector).
+ */
+void logistic_regression::predict_from_margins(
+          const DenseMatrix& margins,
+          const prediction_type_enum& output_type,
+          std::vector<flexible_type>& out) const {
+
+  const size_t n = margins.rows();
+  out.resize(n);
+  auto clip = [](double d) { return std::min<double>(std::max<double>(d, 0.0), 1.0); };
+
+  // Binary classification
+  if (this->num_classes == 2) {
+    flexible_type classes[2];
+    if (output_type == prediction_type_enum::CLASS) {
+      classes[0] = ml_mdata->target_indexer()->map_index_to_value(0);
+      classes[1] = ml_mdata->target_indexer()->map_index_to_value(1);
+    }
+    for (size_t i = 0; i < n; ++i) {
+      double margin = margins(i, 0);
+      double row_prob = exp(-log1p(exp(-margin)));
+      switch(output_type) {
+        case prediction_type_enum::MARGIN:
+          out[i] = margin;
+          break;
+        case prediction_type_enum::PROBABILITY:
+        case prediction_type_enum::RANK:
+          out[i] = row_prob;
+          break;
+        case prediction_type_enum::PROBABILITY_VECTOR:
+          out[i] = flex_vec{1.0 - row_prob, row_prob};
+          break;
+        case prediction_type_enum::CLASS_INDEX:
+          out[i] = row_prob >= 0.5;
+          break;
+        case prediction_type_enum::CLASS:
+          out[i] = classes[row_prob >= 0.5];
+          break;
+        case prediction_type_enum::MAX_PROBABILITY:
+        case prediction_type_enum::NA:
+          log_and_throw("Output type not supported");
+      }
+    }
+    return;
+  }
+
+  // Multi-class classification
+  const size_t m = this->num_classes - 1;
+  DenseVector kernel(m), prob(m);
+  for (size_t i = 0; i < n; ++i) {
+    kernel = margins.row(i).transpose().array().exp();
+    prob = kernel / (1 + kernel.sum());
+    switch(output_type) {
+      case prediction_type_enum::PROBABILITY:
+      case prediction_type_enum::PROBABILITY_VECTOR:
+      {
+        flex_vec prob_as_vector(m + 1);
+        prob_as_vector[0] = clip(1 - prob.sum());
+        for (size_t c = 0; c < m; ++c) {
+          prob_as_vector[c + 1] = clip(prob(c));
+        }
+        out[i] = std::move(prob_as_vector);
+        break;
+      }
+      case prediction_type_enum::RANK:
+      case prediction_type_enum::MARGIN:
+      {
+        flex_vec margin(m + 1);
+        margin[0] = 0;
+        for (size_t c = 0; c < m; ++c) {
+          margin[c + 1] = margins(i, c);
+        }
+        out[i] = std::move(margin);
+        break;
+      }
+      case prediction_type_enum::CLASS_INDEX:
+      case prediction_type_enum::CLASS:
+      {
+        double max_margin = 0;
+        size_t class_idx = 0;
+        for (size_t c = 0; c < m; ++c) {
+          if (max_margin < margins(i, c)) {
+            max_margin = margins(i, c);
+            class_idx = c + 1;
+          }
+        }
+        if (output_type == prediction_type_enum::CLASS_INDEX) {
+          out[i] = class_idx;
+        } else {
+          out[i] = ml_mdata->target_indexer()->map_index_to_value(class_idx);
+        }
+        break;
+      }
+      case prediction_type_enum::MAX_PROBABILITY:
+      {
+        out[i] = clip(std::max<double>(1 - prob.sum(), prob.maxCoeff()));
+        break;
+      }
+      case prediction_type_enum::NA:
+        log_and_throw("Output type not supported");
+    }
+  }
+}
+
 /**
  * Make predictions using a trained model using the predict_single_example
  * interface.
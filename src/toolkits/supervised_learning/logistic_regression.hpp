@@ -114,6 +114,11 @@ class EXPORT logistic_regression: public supervised_learning_model_base {
    */
   void set_coefs(const DenseVector& _coefs) override;
 
+  /**
+   * Training can start from the current coefficients.
+   */
+  bool supports_warm_start() const override { return true; }
+
   /**
    * Serialize the object.
    */
@@ -162,10 +167,23 @@ class EXPORT logistic_regression: public supervised_learning_model_base {
     const SparseVector& x,
     const prediction_type_enum& output_type=prediction_type_enum::NA) override;
 
+  /**
+   * The coefficients, for predictions in blocks.
+   */
+  bool get_margin_coefficients(DenseMatrix& W) const override;
+
+  /**
+   * Predictions for a block of examples from their margins.
+   */
+  void predict_from_margins(
+    const DenseMatrix& margins,
+    const prediction_type_enum& output_type,
+    std::vector<flexible_type>& out) const override;
+
   /**
   * Get coefficients for a trained model.
   */
-  void get_coefficients(DenseVector& _coefs) const{
+  void get_coefficients(DenseVector& _coefs) const override {
     _coefs.resize(coefs.size());
     _coefs = coefs;
   }
@@ -141,6 +141,23 @@ void logistic_regression_opt_interface::rescale_solution(DenseVector& coefs) {
   }
 }
 
+/**
+ * Transform a solution to the solver's scale.
+ */
+void logistic_regression_opt_interface::scale_solution(DenseVector& coefs) {
+  if(feature_rescaling){
+    size_t variables_per_class = variables / (classes-1);
+    DenseVector coefs_per_class(variables_per_class);
+    for(size_t i = 0; i < classes - 1; i++){
+      coefs_per_class = coefs.segment(i * variables_per_class,
+                                      variables_per_class);
+      scaler->inverse_transform(coefs_per_class);
+      coefs.segment(i * variables_per_class, variables_per_class) =
+                                                        coefs_per_class;
+    }
+  }
+}
+
 /**
 * Get the number of examples for the model
 */
@@ -243,86 +260,85 @@ void logistic_regression_opt_interface::compute_first_order_statistics(
 
   logstream(LOG_INFO) << "Starting first order stats computation" << std::endl;
 
+  // The rows are read in batches, as rows of a matrix X.  The margins of
+  // all the rows are then X * pointMat, and the gradient is X^T * R,
+  // where row i of R is the weighted gradient with respect to the
+  // margins of row i.
+  auto accumulate_batch = [&](size_t thread_idx, size_t n,
+                              const DenseMatrix& margin,
+                              const std::vector<size_t>& class_idx,
+                              DenseMatrix& R) {
+    R = margin.array().exp();
+    for (size_t i = 0; i < n; ++i) {
+      size_t c = class_idx[i];
+      double kernel_sum = R.row(i).sum();
+      double margin_dot_class = (c > 0) ? margin(i, c - 1) : 0;
+      f[thread_idx] += class_weights[c] * (log1p(kernel_sum) - margin_dot_class);
+
+      R.row(i) /= (1 + kernel_sum);
+      if (c > 0) R(i, c - 1) -= 1;
+      R.row(i) *= class_weights[c];
+    }
+  };
+
   // Dense data.
   if (this->is_dense) {
     in_parallel([&](size_t thread_idx, size_t num_threads) {
-      DenseVector x(variables_per_class);
-      double row_func = 0, margin_dot_class = 0;
-      DenseVector margin(classes - 1), kernel(classes - 1), row_prob(classes -1);
       DenseMatrix pointMat(point);
       pointMat.resize(variables_per_class, classes-1);
-      size_t class_idx = 0;
-      double kernel_sum = 0;
-      for (auto it = data.get_iterator(thread_idx, num_threads); !it.done();
-           ++it) {
-        class_idx = it->target_index();
+      Eigen::Map<DenseMatrix> G_mat(G[thread_idx].data(), variables_per_class, classes-1);
 
-        if(class_idx >= classes) {
-           continue;
-        }
+      const size_t batch_size = reference_encoding_batch_size(variables_per_class);
+      DenseMatrix X(batch_size, variables_per_class);
+      DenseMatrix margin, R;
+      std::vector<size_t> class_idx(batch_size);
+
+      auto it = data.get_iterator(thread_idx, num_threads);
+      while (size_t n = fill_reference_encoding_batch(it, X, batch_size,
+               [&](const ml_data_row_reference& row, size_t i) {
+                 class_idx[i] = row.target_index();
+                 return class_idx[i] < classes;
+               })) {
 
-        fill_reference_encoding(*it, x);
-        x.coeffRef(variables_per_class - 1) = 1;
         if(feature_rescaling){
-          scaler->transform(x);
+          scaler->transform(X);
         }
 
-        class_idx = it->target_index();
-        margin = pointMat.transpose() * x;
-        margin_dot_class = (class_idx > 0) ? margin(class_idx - 1) : 0;
-
-        kernel =  (margin).array().exp();
-        kernel_sum = kernel.sum();
-        row_func = log1p(kernel_sum) - margin_dot_class;
-        row_prob = kernel / (1 + kernel_sum);
-        if (class_idx > 0) row_prob(class_idx - 1) -= 1;
-
-        DenseMatrix G_tmp = class_weights[class_idx] * (x * row_prob.transpose());
-        G[thread_idx] += Eigen::Map<Eigen::VectorXd>(G_tmp.data(), variables);
-        f[thread_idx] += class_weights[class_idx] * row_func;
+        margin.noalias() = X * pointMat;
+        accumulate_batch(thread_idx, n, margin, class_idx, R);
+        G_mat.noalias() += X.transpose() * R;
       }
     });
 
   // Sparse data
   } else {
     in_parallel([&](size_t thread_idx, size_t num_threads) {
-      SparseVector x(variables_per_class);
-      double row_func = 0, margin_dot_class = 0;
-      DenseVector margin(classes - 1), kernel(classes - 1), row_prob(classes -1);
       DenseMatrix pointMat(point);
       pointMat.resize(variables_per_class, classes-1);
-      size_t class_idx = 0;
-      double kernel_sum = 0;
-      for(auto it = data.get_iterator(thread_idx, num_threads);
-                                                              !it.done(); ++it) {
-        class_idx = it->target_index();
+      Eigen::Map<DenseMatrix> G_mat(G[thread_idx].data(), variables_per_class, classes-1);
 
-        if(class_idx >= classes) {
-           continue;
-        }
+      const size_t batch_size = reference_encoding_batch_size(data.max_row_size() + 1);
+      SparseRowMatrix X;
+      SparseVector x(variables_per_class);
+      std::vector<Eigen::Triplet<double> > triplets;
+      DenseMatrix margin, R;
+      std::vector<size_t> class_idx(batch_size);
+
+      auto it = data.get_iterator(thread_idx, num_threads);
+      while (size_t n = fill_reference_encoding_batch(
+               it, X, variables_per_class, batch_size, x, triplets,
+               [&](const ml_data_row_reference& row, size_t i) {
+                 class_idx[i] = row.target_index();
+                 return class_idx[i] < classes;
+               })) {
 
-        fill_reference_encoding(*it, x);
-        x.coeffRef(variables_per_class - 1) = 1;
         if(feature_rescaling){
-          scaler->transform(x);
+          scaler->transform(X);
         }
 
-        class_idx = it->target_index();
-        margin = pointMat.transpose() * x;
-        margin_dot_class = (class_idx > 0) ? margin(class_idx - 1) : 0;
-
-        kernel =  (margin).array().exp();
-        kernel_sum = kernel.sum();
-        row_func = log1p(kernel_sum) - margin_dot_class;
-        row_prob = kernel / (1 + kernel_sum);
-
-        SparseVector G_tmp(variables);
-        if (class_idx > 0) row_prob(class_idx - 1) -= 1;
-        flattened_sparse_vector_outer_prod(x, row_prob, G_tmp);
-        G_tmp *= class_weights[class_idx];
-
-        optimization::vector_add<DenseVector, SparseVector>(G[thread_idx], G_tmp);
-        f[thread_idx] += class_weights[class_idx] * row_func;
+        margin = X * pointMat;
+        accumulate_batch(thread_idx, n, margin, class_idx, R);
+        G_mat += X.transpose() * R;
       }
     });
   }
@@ -478,6 +494,107 @@ void logistic_regression_opt_interface::compute_second_order_statistics(
                       << (t.current_time() - start_time) << "s" << std::endl;
 }
 
+/**
+ * Compute the hessian-vector product
+*/
+void logistic_regression_opt_interface::compute_hessian_vector_product(
+    const DenseVector& point, const DenseVector& direction,
+    DenseVector& product) {
+
+  std::vector<DenseVector> HV(n_threads, Eigen::MatrixXd::Zero(variables, 1));
+  size_t variables_per_class = variables / (classes-1);
+
+  // The hessian of row x is w * (A kron x x^T), with A = diag(p) - p p^T
+  // and p the probabilities of the classes past the first.  With the
+  // direction reshaped to the shape of the coefficients (V), the product
+  // for the row is w * x (A V^T x)^T; over a batch X of rows, this is
+  // X^T * R with row i of R equal to w_i * A_i * (X V)_i.
+  auto accumulate_batch = [&](size_t n, const DenseMatrix& margin,
+                              const DenseMatrix& U,
+                              const std::vector<size_t>& class_idx,
+                              DenseMatrix& R) {
+    R = margin.array().exp();
+    for (size_t i = 0; i < n; ++i) {
+      R.row(i) /= (1 + R.row(i).sum());
+      double pu = R.row(i).dot(U.row(i));
+      R.row(i) = R.row(i).array() * (U.row(i).array() - pu);
+      R.row(i) *= class_weights[class_idx[i]];
+    }
+  };
+
+  // Dense data.
+  if (this->is_dense) {
+    in_parallel([&](size_t thread_idx, size_t num_threads) {
+      DenseMatrix pointMat(point), directionMat(direction);
+      pointMat.resize(variables_per_class, classes-1);
+      directionMat.resize(variables_per_class, classes-1);
+      Eigen::Map<DenseMatrix> HV_mat(HV[thread_idx].data(), variables_per_class, classes-1);
+
+      const size_t batch_size = reference_encoding_batch_size(variables_per_class);
+      DenseMatrix X(batch_size, variables_per_class);
+      DenseMatrix margin, U, R;
+      std::vector<size_t> class_idx(batch_size);
+
+      auto it = data.get_iterator(thread_idx, num_threads);
+      while (size_t n = fill_reference_encoding_batch(it, X, batch_size,
+               [&](const ml_data_row_reference& row, size_t i) {
+                 class_idx[i] = row.target_index();
+                 return class_idx[i] < classes;
+               })) {
+
+        if(feature_rescaling){
+          scaler->transform(X);
+        }
+
+        margin.noalias() = X * pointMat;
+        U.noalias() = X * directionMat;
+        accumulate_batch(n, margin, U, class_idx, R);
+        HV_mat.noalias() += X.transpose() * R;
+      }
+    });
+
+  // Sparse data
+  } else {
+    in_parallel([&](size_t thread_idx, size_t num_threads) {
+      DenseMatrix pointMat(point), directionMat(direction);
+      pointMat.resize(variables_per_class, classes-1);
+      directionMat.resize(variables_per_class, classes-1);
+      Eigen::Map<DenseMatrix> HV_mat(HV[thread_idx].data(), variables_per_class, classes-1);
+
+      const size_t batch_size = reference_encoding_batch_size(data.max_row_size() + 1);
+      SparseRowMatrix X;
+      SparseVector x(variables_per_class);
+      std::vector<Eigen::Triplet<double> > triplets;
+      DenseMatrix margin, U, R;
+      std::vector<size_t> class_idx(batch_size);
+
+      auto it = data.get_iterator(thread_idx, num_threads);
+      while (size_t n = fill_reference_encoding_batch(
+               it, X, variables_per_class, batch_size, x, triplets,
+               [&](const ml_data_row_reference& row, size_t i) {
+                 class_idx[i] = row.target_index();
+                 return class_idx[i] < classes;
+               })) {
+
+        if(feature_rescaling){
+          scaler->transform(X);
+        }
+
+        margin = X * pointMat;
+        U = X * directionMat;
+        accumulate_batch(n, margin, U, class_idx, R);
+        HV_mat += X.transpose() * R;
+      }
+    });
+  }
+
+  // Reduce
+  product = HV[0];
+  for(size_t i=1; i < n_threads; i++){
+    product += HV[i];
+  }
+}
+
 void logistic_regression_opt_interface::compute_first_order_statistics(const
     DenseVector& point, DenseVector& gradient, double& function_value, const
     size_t mbStart, const size_t mbSize) {
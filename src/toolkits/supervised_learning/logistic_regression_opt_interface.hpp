@@ -94,6 +94,14 @@ class logistic_regression_opt_interface: public
    */
   void rescale_solution(DenseVector& coefs);
 
+  /**
+   * Transform a solution from the original scale to the solver's scale, the
+   * inverse of rescale_solution.
+   *
+   * \param[in,out] coefs Solution vector
+   */
+  void scale_solution(DenseVector& coefs);
+
   /**
   * Set the number of threads
   *
@@ -185,6 +193,18 @@ class logistic_regression_opt_interface: public
   void compute_second_order_statistics(const DenseVector &point, DenseMatrix&
       hessian, DenseVector& gradient, double & function_value);
 
+  /**
+   * Compute the product of the hessian at the given point with a
+   * direction, without forming the hessian.
+   *
+   * \param[in]  point      Point at which the hessian is taken.
+   * \param[in]  direction  Vector to multiply the hessian with.
+   * \param[out] product    Hessian times direction.
+   *
+   */
+  void compute_hessian_vector_product(const DenseVector& point,
+      const DenseVector& direction, DenseVector& product);
+
   /**
    * Compute first order statistics at the given point with respect to the
    * validation data. (Gradient & Function value)
@@ -274,6 +274,15 @@ class l2_rescaling: public standardization_interface {
       // L2 norm but that multiple doesn't quite help.
 
       for (size_t k = skip_first ? 1 : 0; k < ml_mdata->index_size(i); ++k) {
+
+        // Categories indexed after training (by a model update) have no
+        // statistics; leave them unscaled.
+        if (ml_mdata->is_categorical(i) && stats->count(k) == 0) {
+          scale(idx) = 1;
+          ++idx;
+          continue;
+        }
+
         double r = std::pow(stats->mean(k), 2) + std::pow(stats->stdev(k), 2);
         scale(idx) = std::sqrt(std::max(r, optimization::OPTIMIZATION_ZERO));
         ++idx;
@@ -306,8 +315,22 @@ class l2_rescaling: public standardization_interface {
    */
   void transform(DenseMatrix &points) const {
     DASSERT_EQ(points.cols(), total_size);
-    for (size_t i = 0; i < size_t(points.rows()); i++) {
-      points.row(i) = points.row(i).cwiseQuotient(scale.transpose());
+    points.array().rowwise() /= scale.transpose().array();
+  }
+
+  /**
+   * Transform rows of points, stored as a sparse row matrix, from the
+   * original space to the standardized space.
+   *
+   * \param[in,out] points Points to be transformed.
+   *
+   */
+  void transform(Eigen::SparseMatrix<double, Eigen::RowMajor> &points) const {
+    DASSERT_EQ(points.cols(), total_size);
+    for (int r = 0; r < points.outerSize(); ++r) {
+      for (Eigen::SparseMatrix<double, Eigen::RowMajor>::InnerIterator i(points, r); i; ++i) {
+        i.valueRef() = i.value() / scale(i.index());
+      }
     }
   }
 
@@ -58,6 +58,19 @@ EXPORT std::shared_ptr<supervised_learning_model_base> create(
     model->support_missing_value() ? ml_missing_value_action::USE_NAN
                                    : ml_missing_value_action::ERROR;
 
+  // Feature hashing is part of the data setup rather than a training
+  // option.
+  if (kwargs.count("feature_hash_buckets")) {
+    flexible_type n_buckets =
+        variant_get_value<flexible_type>(kwargs.at("feature_hash_buckets"));
+    if (n_buckets.get_type() != flex_type_enum::UNDEFINED) {
+      if (n_buckets.get_type() != flex_type_enum::INTEGER || n_buckets < 0) {
+        log_and_throw("feature_hash_buckets must be a non-negative integer.");
+      }
+      model->set_feature_hash_buckets(n_buckets.get<flex_int>());
+    }
+  }
+
   if (kwargs.count("features_validation") == 0) {
     sframe valid_X, valid_y;
     model->init(X, y, valid_X, valid_y, missing_value_action);
@@ -76,6 +89,7 @@ EXPORT std::shared_ptr<supervised_learning_model_base> create(
   // --------------------------------------------------------------------------
   std::map<std::string, flexible_type> opts;
   for (const auto& kvp: kwargs) {
+    if (kvp.first == "feature_hash_buckets") continue;
     if (get_variant_which_name(kvp.second.which()) == "flexible_type"){
       opts[kvp.first] = variant_get_value<flexible_type>(kvp.second);
     }
@@ -93,6 +107,19 @@ void supervised_learning_model_base::init(const sframe& X, const sframe& y,
                                           const sframe& valid_X,
                                           const sframe& valid_y,
                                           ml_missing_value_action missing_value_action) {
+  std::pair<ml_data, ml_data> data = create_training_data(
+      X, y, valid_X, valid_y, missing_value_action);
+  init_from_ml_data(data.first, data.second);
+}
+
+/**
+ * Fill the training and validation ml_data.
+ */
+std::pair<ml_data, ml_data> supervised_learning_model_base::create_training_data(
+    const sframe& X, const sframe& y,
+    const sframe& valid_X,
+    const sframe& valid_y,
+    ml_missing_value_action missing_value_action) const {
   DASSERT_TRUE(y.num_columns() == 1);
 
   // Setup the options for ml_data construction.
@@ -124,8 +151,30 @@ void supervised_learning_model_base::init(const sframe& X, const sframe& y,
 
   // Construct the ml_data.
   ml_data data;
+  data.set_feature_hash_buckets(feature_hash_buckets);
   sframe sf_data = X.add_column(y.select_column(0), target_col);
   data.fill(sf_data, target_col, mode_overides, false, missing_value_action);
+
+  // The validation data is indexed with the training metadata.
+  ml_data valid_data;
+  if (valid_X.num_rows() > 0) {
+    valid_data = ml_data(data.metadata());
+    sframe sf_valid = valid_X.add_column(valid_y.select_column(0), target_col);
+    valid_data.fill(sf_valid,
+                    target_col,
+                    std::map<std::string, ml_column_mode>(),
+                    true,
+                    missing_value_action);
+  }
+
+  return {data, valid_data};
+}
+
+/**
+ * Init from training and validation data already filled.
+ */
+void supervised_learning_model_base::init_from_ml_data(const ml_data& data,
+                                                       const ml_data& valid_data) {
   ml_mdata = data.metadata();
 
   // Update the model
@@ -135,7 +184,7 @@ void supervised_learning_model_base::init(const sframe& X, const sframe& y,
   this->state["target"] =  to_variant((this->ml_mdata)->target_column_name());
   this->state["unpacked_features"] = to_variant(feature_names);
   this->state["features"] = to_variant(feature_column_names);
-  this->state["num_examples"] = X.num_rows();
+  this->state["num_examples"] = data.size();
   this->state["num_features"] = feature_column_names.size();
   this->state["num_unpacked_features"] = feature_names.size();
 
@@ -147,7 +196,7 @@ void supervised_learning_model_base::init(const sframe& X, const sframe& y,
   // user. (see  #3001 for context)
   if (not simple_mode) {
       size_t num_dims = get_number_of_coefficients(this->ml_mdata);
-      if(num_dims >= X.num_rows()) {
+      if(num_dims >= data.size()) {
         std::stringstream ss;
         ss << "WARNING: The number of feature dimensions in this problem is "
            << "very large in comparison with the number of examples. Unless "
@@ -158,13 +207,6 @@ void supervised_learning_model_base::init(const sframe& X, const sframe& y,
       }
   }
 
-  ml_data valid_data;
-  if (valid_X.num_rows() > 0) {
-    valid_data = construct_ml_data_using_current_metadata(valid_X,
-                      valid_y,
-                      missing_value_action);
-  }
-
   // First set which metrics will be computed.
   set_default_evaluation_metric();
   set_default_tracking_metric();
@@ -192,6 +234,79 @@ void supervised_learning_model_base::init(const sframe& X, const sframe& y,
 
 }
 
+/**
+ * Update a trained model with new data, starting from its coefficients.
+ */
+void supervised_learning_model_base::update(
+    const sframe& X, const sframe& y,
+    const std::map<std::string, flexible_type>& _options) {
+  DASSERT_TRUE(y.num_columns() == 1);
+
+  if (!this->supports_warm_start()) {
+    log_and_throw(std::string("Model ") + this->name() + " cannot be updated with new data. "
+                  "Train a new model instead.");
+  }
+  if (this->ml_mdata == nullptr) {
+    log_and_throw("The model must be trained before it is updated.");
+  }
+
+  ml_missing_value_action missing_value_action =
+    this->support_missing_value() ? ml_missing_value_action::USE_NAN
+                                  : ml_missing_value_action::ERROR;
+
+  // Fill the new data with a copy of the metadata, which indexes the new
+  // categories; the model is left untouched if anything below fails.
+  std::shared_ptr<ml_metadata> new_mdata = std::make_shared<ml_metadata>();
+  {
+    std::stringstream strm;
+    {
+      turi::oarchive oarc(strm);
+      this->ml_mdata->save(oarc);
+    }
+    turi::iarchive iarc(strm);
+    new_mdata->load(iarc);
+  }
+
+  std::string target_col = y.column_name(0);
+  ml_data data(new_mdata);
+  sframe sf_data = X.add_column(y.select_column(0), target_col);
+  data.fill(sf_data,
+            target_col,
+            std::map<std::string, ml_column_mode>(),
+            false,
+            missing_value_action);
+
+  if (this->is_classifier()
+      && new_mdata->target_column_size() > new_mdata->target_index_size()) {
+    log_and_throw("The new data contains classes of the target column not "
+                  "seen in training. Train a new model instead.");
+  }
+
+  new_mdata->set_training_index_sizes_to_current_column_sizes();
+
+  // Carry the coefficients over to the extended feature indices.
+  DenseVector coefs;
+  this->get_coefficients(coefs);
+  warm_start_coefs = extend_coefficients(coefs, this->ml_mdata, new_mdata);
+  this->ml_mdata = new_mdata;
+
+  std::vector<std::string> feature_names = ml_mdata->feature_names(false);
+  this->state["unpacked_features"] = to_variant(feature_names);
+  this->state["num_examples"] = X.num_rows();
+  this->state["num_unpacked_features"] = feature_names.size();
+
+  model_specific_init(data, ml_data());
+  this->set_options(_options);
+
+  try {
+    this->train();
+  } catch (...) {
+    warm_start_coefs.resize(0);
+    throw;
+  }
+  warm_start_coefs.resize(0);
+}
+
 /**
  * Impute missing columns with 'None' values.
  */
@@ -412,10 +527,61 @@ sframe supervised_learning_model_base::classify(const ml_data& test_data,
 
 
 
+/**
+ * Predicts the rows of a thread's share of the data in blocks, for a model
+ * with margin coefficients W (see get_margin_coefficients()): the margins of
+ * a block are one matrix product, sparse or dense.
+ *
+ * Calls block_fn(n, row_ids, preds) on each block of n rows, with the row
+ * indices of the rows and their predictions of output_type. preds may be
+ * moved from.
+ */
+template <typename BlockFunction>
+static void predict_margin_blocks(
+    const supervised_learning_model_base& model, const DenseMatrix& W,
+    bool is_dense, const ml_data& data, size_t thread_idx, size_t num_threads,
+    const prediction_type_enum& output_type, BlockFunction&& block_fn) {
+
+  const size_t variables = W.rows();
+  const size_t batch_size = reference_encoding_batch_size(
+      is_dense ? variables : data.max_row_size() + 1);
+  std::vector<size_t> row_ids(batch_size);
+  std::vector<flexible_type> preds;
+  DenseMatrix margins;
+
+  auto it = data.get_iterator(thread_idx, num_threads);
+  auto record_row = [&](const ml_data_row_reference&, size_t i) {
+    row_ids[i] = it.row_index();
+    return true;
+  };
+
+  if (is_dense) {
+    DenseMatrix X(batch_size, variables);
+    while (size_t n = fill_reference_encoding_batch(it, X, batch_size, record_row)) {
+      margins.noalias() = X * W;
+      model.predict_from_margins(margins, output_type, preds);
+      block_fn(n, row_ids, preds);
+    }
+  } else {
+    SparseRowMatrix X;
+    SparseVector x(variables);
+    std::vector<Eigen::Triplet<double> > triplets;
+    while (size_t n = fill_reference_encoding_batch(
+             it, X, variables, batch_size, x, triplets, record_row)) {
+      margins.noalias() = X * W;
+      model.predict_from_margins(margins, output_type, preds);
+      block_fn(n, row_ids, preds);
+    }
+  }
+}
+
 /**
  * Make predictions using a trained model using the predict_single_example
  * interface.
  *
+ * Linear models (see get_margin_coefficients()) are predicted in blocks
+ * instead, each written to the output with one call.
+ *
  * \note There are some noted inefficiencies in this function but I think it is
  * of lower priority to optimize. Chose to optimize if this is a known
  * bottleneck.
@@ -465,6 +631,27 @@ supervised_learning_model_base::predict(const ml_data& test_data,
     ret->set_type(flex_type_enum::FLOAT);
   }
 
+  // Linear models: score blocks of rows at once.
+  DenseMatrix W;
+  if (get_margin_coefficients(W)) {
+    DASSERT_EQ(size_t(W.rows()), variables);
+    bool dense = this->is_dense();
+    in_parallel([&](size_t thread_idx, size_t num_threads) {
+      auto writer = ret->get_output_iterator(thread_idx);
+      predict_margin_blocks(*this, W, dense, test_data, thread_idx, num_threads,
+                            output_type_enum,
+                            [&](size_t n, const std::vector<size_t>& row_ids,
+                                std::vector<flexible_type>& preds) {
+        sframe_rows block;
+        block.add_decoded_column(
+            std::make_shared<std::vector<flexible_type>>(std::move(preds)));
+        *writer = block;
+      });
+    });
+    ret->close();
+    return ret;
+  }
+
   // Iterate through data.
   in_parallel([&](size_t thread_idx, size_t num_threads){
     DenseVector x(variables);
@@ -500,6 +687,29 @@ gl_sarray supervised_learning_model_base::fast_predict(
     const std::string& missing_value_action,
     const std::string& output_type) {
 
+  flex_type_enum ret_type;
+  if (output_type == "class"){
+    ret_type = (this->ml_mdata)->target_column_type();
+  } else if (output_type == "probability_vector"){
+    ret_type = flex_type_enum::VECTOR;
+  } else {
+    ret_type = flex_type_enum::FLOAT;
+  }
+  std::vector<flexible_type> preds =
+      predict_rows(rows, missing_value_action, output_type);
+
+  gl_sarray_writer writer(ret_type, 1 /* 1 segment */);
+  for (const auto& pred : preds) {
+    writer.write(pred, 0);
+  }
+  return writer.close();
+}
+
+std::vector<flexible_type> supervised_learning_model_base::predict_rows(
+    const std::vector<flexible_type>& rows,
+    const std::string& missing_value_action,
+    const std::string& output_type) {
+
   // Initialize.
   size_t variables = 0;
   size_t classes = 0;
@@ -512,20 +722,9 @@ gl_sarray supervised_learning_model_base::fast_predict(
     variables = variables / (classes - 1);
   }
 
-  std::vector<flexible_type> ret(rows.size());
-  flex_type_enum ret_type;
-  if (output_type == "class"){
-    ret_type = (this->ml_mdata)->target_column_type();
-  } else if (output_type == "probability_vector"){
-    ret_type = flex_type_enum::VECTOR;
-  } else {
-    if (output_type == "probability" && variant_get_value<size_t>(state.at("num_classes")) > 2) {
-      log_and_throw("Output type 'probability' is only supported for binary classification. For multi-class classification, use predict_topk() instead.");
-    }
-    ret_type = flex_type_enum::FLOAT;
+  if (output_type == "probability" && variant_get_value<size_t>(state.at("num_classes")) > 2) {
+    log_and_throw("Output type 'probability' is only supported for binary classification. For multi-class classification, use predict_topk() instead.");
   }
-  gl_sarray_writer writer(ret_type, 1 /* 1 segment */);
-
 
   auto na_enum = get_missing_value_enum_from_string(missing_value_action);
   auto pred_type_enum = prediction_type_enum_from_name(output_type);
@@ -534,24 +733,52 @@ gl_sarray supervised_learning_model_base::fast_predict(
       log_and_throw(
           "TypeError: Expecting dictionary as input type for each example.");
     }
+  }
 
-    if (this->is_dense()) {
-      DenseVector dense_vec(variables);
+  // Dense models score all the rows as one batch.
+  if (this->is_dense()) {
+    DenseMatrix X(rows.size(), variables);
+    DenseVector dense_vec(variables);
+    for (size_t i = 0; i < rows.size(); ++i) {
       fill_reference_encoding(ml_data_row_reference::from_row(
-               this->ml_mdata, row.get<flex_dict>(), na_enum), dense_vec);
+               this->ml_mdata, rows[i].get<flex_dict>(), na_enum), dense_vec);
       dense_vec.coeffRef(variables - 1) = 1;
-      flexible_type pred = predict_single_example(dense_vec, pred_type_enum);
-      writer.write(pred, 0);
-    } else {
-      SparseVector sparse_vec(variables);
-      fill_reference_encoding(ml_data_row_reference::from_row(
-               this->ml_mdata, row.get<flex_dict>(), na_enum), sparse_vec);
-      sparse_vec.coeffRef(variables - 1) = 1;
-      flexible_type pred = predict_single_example(sparse_vec, pred_type_enum);
-      writer.write(pred, 0);
+      X.row(i) = dense_vec.transpose();
     }
+    return predict_batch(X, pred_type_enum);
   }
-  return writer.close();
+
+  std::vector<flexible_type> ret;
+  ret.reserve(rows.size());
+  for (const auto& row: rows) {
+    SparseVector sparse_vec(variables);
+    fill_reference_encoding(ml_data_row_reference::from_row(
+             this->ml_mdata, row.get<flex_dict>(), na_enum), sparse_vec);
+    sparse_vec.coeffRef(variables - 1) = 1;
+    ret.push_back(predict_single_example(sparse_vec, pred_type_enum));
+  }
+  return ret;
+}
+
+flexible_type supervised_learning_model_base::serve_predict(
+    const flexible_type& row,
+    const std::string& missing_value_action,
+    const std::string& output_type) {
+
+  std::shared_ptr<micro_batcher> batcher;
+  {
+    std::lock_guard<turi::mutex> guard(serving_lock);
+    auto& b = serving_batchers[{missing_value_action, output_type}];
+    if (!b) {
+      b = std::make_shared<micro_batcher>(
+          [this, missing_value_action, output_type](
+              const std::vector<flexible_type>& rows) {
+            return this->predict_rows(rows, missing_value_action, output_type);
+          });
+    }
+    batcher = b;
+  }
+  return batcher->submit(row);
 }
 
 gl_sframe supervised_learning_model_base::fast_classify(
@@ -589,9 +816,7 @@ gl_sframe supervised_learning_model_base::fast_classify(
 
 /**
  * Make predictions using a trained model using the predict_single_example
- * interface.
- *
- * Has the same trouble as predict when it comes to speed.
+ * interface, or in blocks for linear models, as predict.
  */
 sframe supervised_learning_model_base::predict_topk(
           const ml_data& test_data, const std::string& output_type,
@@ -631,6 +856,63 @@ sframe supervised_learning_model_base::predict_topk(
   }
   sf.open_for_write(col_names, col_types, "", n_threads);
 
+  // The classes of a prediction, the topk first.
+  auto sort_classes = [&](const flexible_type& preds,
+                          std::vector<std::pair<size_t, double>>& out) {
+    // Multiclass
+    if (preds.size() == num_classes) {
+      for (size_t k = 0; k < num_classes; ++k) {
+        out[k] = std::make_pair(k, preds[k]);
+      }
+    // Binary
+    } else {
+      double zero_pred = (output_type_enum == prediction_type_enum::MARGIN) ? 0.0 : 1.0 - (double)preds;
+      out[0] = std::make_pair(0, zero_pred);
+      out[1] = std::make_pair(1, (double) preds);
+    }
+
+    // Sort
+    std::nth_element(out.begin(), out.begin() + topk - 1, out.end(),
+                  boost::bind(&std::pair<size_t, double>::second, _1) >
+                  boost::bind(&std::pair<size_t, double>::second, _2));
+  };
+
+  // Linear models: score blocks of rows at once, the margins of all the
+  // classes with one matrix product.
+  DenseMatrix W;
+  if (get_margin_coefficients(W)) {
+    DASSERT_EQ(size_t(W.rows()), variables);
+    bool dense = this->is_dense();
+    in_parallel([&](size_t thread_idx, size_t num_threads) {
+      auto it_sf = sf.get_output_iterator(thread_idx);
+      std::vector<std::pair<size_t, double>> out(num_classes);
+      predict_margin_blocks(*this, W, dense, test_data, thread_idx, num_threads,
+                            output_type_enum,
+                            [&](size_t n, const std::vector<size_t>& row_ids,
+                                std::vector<flexible_type>& preds) {
+        sframe_rows block;
+        block.resize(3, n * topk);
+        auto& columns = block.get_columns();
+        for (size_t i = 0; i < n; ++i) {
+          sort_classes(preds[i], out);
+          for (size_t k = 0; k < topk; ++k) {
+            size_t j = i * topk + k;
+            (*columns[0])[j] = row_ids[i];
+            (*columns[1])[j] = this->ml_mdata->target_indexer()
+                                   ->map_index_to_value(out[k].first);
+            if (output_type_enum == prediction_type_enum::RANK) {
+              (*columns[2])[j] = k;
+            } else {
+              (*columns[2])[j] = out[k].second;
+            }
+          }
+        }
+        *it_sf = block;
+      });
+    });
+    sf.close();
+    return sf;
+  }
 
   // Iterate through data.
   in_parallel([&](size_t thread_idx, size_t num_threads){
@@ -657,22 +939,7 @@ sframe supervised_learning_model_base::predict_topk(
 	      preds = predict_single_example(x_sp, output_type_enum);
       }
 
-      // Multiclass
-      if (preds.size() == num_classes) {
-        for (size_t k = 0; k < num_classes; ++k) {
-          out[k] = std::make_pair(k, preds[k]);
-        }
-      // Binary
-      } else {
-        double zero_pred = (output_type_enum == prediction_type_enum::MARGIN) ? 0.0 : 1.0 - (double)preds;
-        out[0] = std::make_pair(0, zero_pred);
-        out[1] = std::make_pair(1, (double) preds);
-      }
-
-      // Sort
-      std::nth_element(out.begin(), out.begin() + topk - 1, out.end(),
-                    boost::bind(&std::pair<size_t, double>::second, _1) >
-                    boost::bind(&std::pair<size_t, double>::second, _2));
+      sort_classes(preds, out);
 
       // Write the topk
       for (size_t k = 0; k < topk; ++k) {
@@ -1069,6 +1336,15 @@ void supervised_learning_model_base::api_train(
 
   this->train();
 
+  add_training_and_validation_metrics(data, validation_data);
+}
+
+/**
+ * Add the evaluation of the training and validation data to the state.
+ */
+void supervised_learning_model_base::add_training_and_validation_metrics(
+    gl_sframe data, gl_sframe validation_data) {
+
   if(!get_option_value("disable_posttrain_evaluation")) {
 
     // Add in all the fields for the evaluation into the training statistics.
@@ -1094,6 +1370,29 @@ void supervised_learning_model_base::api_train(
   }
 }
 
+/**
+ * API interface through the unity server.
+ *
+ * Update the model with new data.
+ */
+void supervised_learning_model_base::api_update(
+    gl_sframe data,
+    const std::map<std::string, flexible_type>& _options) {
+
+  std::string target = get_target_name();
+  if (!data.contains_column(target)) {
+    log_and_throw("Target column '" + target + "' not found in the data.");
+  }
+
+  sframe X = data.select_columns(get_feature_names()).materialize_to_sframe();
+  sframe y = data.select_columns({target}).materialize_to_sframe();
+
+  check_empty_data(X);
+  check_target_column_type(this->name(), y);
+
+  this->update(X, y, _options);
+}
+
 /**
  * API interface through the unity server.
  *
@@ -31,6 +31,8 @@
 #include <core/export.hpp>
 
 #include <model_server/lib/toolkit_class_macros.hpp>
+#include <toolkits/util/micro_batcher.hpp>
+#include <core/parallel/mutex.hpp>
 
 // TODO: List of todo's for this file
 //------------------------------------------------------------------------------
@@ -42,6 +44,7 @@ namespace supervised {
 
 class supervised_learning_model_base;
 typedef Eigen::Matrix<double, Eigen::Dynamic,1>  DenseVector;
+typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>  DenseMatrix;
 typedef Eigen::SparseVector<double>  SparseVector;
 
 /**
@@ -183,6 +186,7 @@ class EXPORT supervised_learning_model_base : public ml_model_base {
   std::vector<std::string> metrics;               /* Evaluation metric(s). */
   std::vector<std::string> tracking_metrics;      /* Tracking metric(s). */
   bool show_extra_warnings = true;                /* If true, be more verbose.*/
+  size_t feature_hash_buckets = 0;                /* Hash buckets of categorical features.*/
 
   public:
 
@@ -259,6 +263,60 @@ class EXPORT supervised_learning_model_base : public ml_model_base {
     return 0.0;
   }
 
+  /**
+   * Predict for a batch of examples, one per row of X.
+   *
+   * The default calls predict_single_example() on each row; models which
+   * can score the whole batch at once (e.g. with one matrix product)
+   * override it.
+   *
+   * \param[in] X  Examples, one per row.
+   * \param[in] output_type Type of prediction.
+   *
+   * \returns Prediction for each example.
+   */
+  virtual std::vector<flexible_type> predict_batch(
+          const DenseMatrix& X,
+          const prediction_type_enum& output_type=prediction_type_enum::NA) {
+    std::vector<flexible_type> ret(X.rows());
+    DenseVector x(X.cols());
+    for (size_t i = 0; i < ret.size(); ++i) {
+      x = X.row(i).transpose();
+      ret[i] = predict_single_example(x, output_type);
+    }
+    return ret;
+  }
+
+  /**
+   * For models whose predictions depend on an example only through linear
+   * margins of its reference encoding (the linear models): fills W with the
+   * coefficients, one column per margin, and returns true.
+   *
+   * predict() and predict_topk() then score blocks of rows with a single
+   * (sparse or dense) matrix product, and convert the margins of the block
+   * with predict_from_margins(). Models returning false (the default) are
+   * predicted one row at a time with predict_single_example().
+   */
+  virtual bool get_margin_coefficients(DenseMatrix& W) const {
+    return false;
+  }
+
+  /**
+   * Predictions of output_type for a block of examples, from their margins
+   * (one row per example, one column per column of the coefficients of
+   * get_margin_coefficients()). Same results as predict_single_example().
+   *
+   * \param[in] margins  Margins of the examples.
+   * \param[in] output_type Type of prediction.
+   * \param[out] out Prediction for each example; resized to margins.rows().
+   */
+  virtual void predict_from_margins(
+          const DenseMatrix& margins,
+          const prediction_type_enum& output_type,
+          std::vector<flexible_type>& out) const {
+    log_and_throw("Model does not support batch prediction from margins");
+  }
+
   /**
    * Evaluate the model.
    *
@@ -377,6 +435,34 @@ class EXPORT supervised_learning_model_base : public ml_model_base {
       const std::string& missing_value_action = "error",
       const std::string& output_type = "");
 
+  /**
+   * Predictions for a list of rows, returned in memory rather than written
+   * to an SArray. Used by fast_predict() and serve_predict().
+   *
+   * \param[in] rows List of rows (each row is a flex_dict)
+   * \param[in] missing_value_action Missing value action string
+   * \param[in] output_type Output type.
+   */
+  virtual std::vector<flexible_type> predict_rows(
+      const std::vector<flexible_type>& rows,
+      const std::string& missing_value_action = "error",
+      const std::string& output_type = "");
+
+  /**
+   * Serving path: the prediction for a single row (a flex_dict), for
+   * servers answering many concurrent single-row requests. Rows submitted
+   * concurrently with the same options are scored together by one call to
+   * predict_rows(), see \ref micro_batcher.
+   *
+   * \param[in] row The row (a flex_dict)
+   * \param[in] missing_value_action Missing value action string
+   * \param[in] output_type Output type.
+   */
+  flexible_type serve_predict(
+      const flexible_type& row,
+      const std::string& missing_value_action = "error",
+      const std::string& output_type = "");
+
   /**
    * Fast path predictions given a row of flexible_types.
    *
@@ -426,6 +512,32 @@ class EXPORT supervised_learning_model_base : public ml_model_base {
       const sframe& valid_y=sframe(),
       ml_missing_value_action mva = ml_missing_value_action::ERROR);
 
+  /**
+   * Fill the training and validation ml_data the model would be trained
+   * on, without changing the model. Several models of the same kind can be
+   * initialized from them with init_from_ml_data, so the data is only
+   * indexed once.
+   *
+   * \param[in] X              Predictors
+   * \param[in] y              target
+   * \param[in] valid_X        Validation predictors (may be empty)
+   * \param[in] valid_y        Validation target
+   *
+   * \returns The training data, and the validation data (empty if valid_X is).
+   */
+  std::pair<ml_data, ml_data> create_training_data(
+      const sframe& X, const sframe& y,
+      const sframe& valid_X=sframe(),
+      const sframe& valid_y=sframe(),
+      ml_missing_value_action mva = ml_missing_value_action::ERROR) const;
+
+  /**
+   * Init the model with training and validation data from
+   * create_training_data. The model shares their metadata.
+   */
+  void init_from_ml_data(const ml_data& data,
+                         const ml_data& valid_data = ml_data());
+
   /**
    * A setter for models that use Armadillo for model coefficients.
    */
@@ -433,6 +545,39 @@ class EXPORT supervised_learning_model_base : public ml_model_base {
     DASSERT_TRUE(false);
   }
 
+  /**
+   * A getter for models that use Armadillo for model coefficients.
+   */
+  virtual void get_coefficients(DenseVector& coefs) const {
+    DASSERT_TRUE(false);
+  }
+
+  /**
+   * True if train() can start from the current coefficients, so that the
+   * model can be updated with new data (see update()).
+   */
+  virtual bool supports_warm_start() const { return false; }
+
+  /**
+   * Update a trained model with new data.
+   *
+   * The model is trained again on X and y only, starting from its current
+   * coefficients, so a few iterations over the new rows stand in for a full
+   * retrain on all the data. Categories not seen before extend the feature
+   * indices, with coefficients starting at zero; the target classes of a
+   * classifier cannot change. The options given replace those of the model
+   * (e.g. a small max_iterations).
+   *
+   * The feature statistics used to rescale the features stay those of the
+   * original training data.
+   *
+   * \param[in] X              Predictors
+   * \param[in] y              target
+   * \param[in] _options       Options to change before training.
+   */
+  void update(const sframe& X, const sframe& y,
+              const std::map<std::string, flexible_type>& _options);
+
   /**
    * Set the evaluation metric. Set to RMSE by default.
    */
@@ -448,6 +593,15 @@ class EXPORT supervised_learning_model_base : public ml_model_base {
     tracking_metrics = _metrics;
   }
 
+  /**
+   * Hash the values of categorical and dictionary features to this many
+   * indices per column instead of indexing them; 0 indexes them.  Must
+   * be set before init.
+   */
+  void set_feature_hash_buckets(size_t n_buckets){
+    feature_hash_buckets = n_buckets;
+  }
+
   /**
    * Set the Extra Warnings output. These warnings include telling the user
    * about low-variance features, etc...
@@ -636,6 +790,22 @@ class EXPORT supervised_learning_model_base : public ml_model_base {
                  const variant_type& validation_data,
                  const std::map<std::string, flexible_type>& _options);
 
+  /**
+   * Add the metrics of the trained model on the training and validation
+   * data to its state, as "training_*" and "validation_*" fields, unless
+   * disable_posttrain_evaluation is set.
+   */
+  void add_training_and_validation_metrics(gl_sframe data,
+                                           gl_sframe validation_data);
+
+  /**
+   *  API interface through the unity server.
+   *
+   *  Update the model with new data.
+   */
+  void api_update(gl_sframe data,
+                  const std::map<std::string, flexible_type>& _options);
+
   /**
    *  API interface through the unity server.
    *
@@ -700,6 +870,12 @@ class EXPORT supervised_learning_model_base : public ml_model_base {
                      {"options",
                       to_variant(std::map<std::string, flexible_type>())}});
 
+  REGISTER_NAMED_CLASS_MEMBER_FUNCTION(
+      "update", supervised_learning_model_base::api_update, "data", "options");
+  register_defaults("update",
+                    {{"options",
+                      to_variant(std::map<std::string, flexible_type>())}});
+
   REGISTER_NAMED_CLASS_MEMBER_FUNCTION(
       "predict", supervised_learning_model_base::api_predict, "data",
       "missing_value_action", "output_type");
@@ -715,6 +891,14 @@ class EXPORT supervised_learning_model_base : public ml_model_base {
                     {{"missing_value_action", std::string("auto")},
                      {"output_type", std::string("")}});
 
+  REGISTER_NAMED_CLASS_MEMBER_FUNCTION(
+      "serve_predict", supervised_learning_model_base::serve_predict, "row",
+      "missing_value_action", "output_type");
+
+  register_defaults("serve_predict",
+                    {{"missing_value_action", std::string("auto")},
+                     {"output_type", std::string("")}});
+
   REGISTER_NAMED_CLASS_MEMBER_FUNCTION(
       "predict_topk", supervised_learning_model_base::api_predict_topk, "data",
       "missing_value_action", "output_type", "topk");
@@ -779,6 +963,18 @@ class EXPORT supervised_learning_model_base : public ml_model_base {
  protected:
   ml_missing_value_action get_missing_value_enum_from_string(
       const std::string& missing_value_str) const;
+
+  /**
+   * Starting point of train(), in the layout of the current metadata; empty
+   * to start from zero. Set by update().
+   */
+  DenseVector warm_start_coefs;
+
+ private:
+  // The serve_predict() batchers, by missing value action and output type.
+  turi::mutex serving_lock;
+  std::map<std::pair<std::string, std::string>,
+           std::shared_ptr<micro_batcher>> serving_batchers;
 };
 
 /**
@@ -7,6 +7,8 @@
 #define TURI_SUPERVISED_LEARNING_UTILS_H_
 
 #include <Eigen/LU>
+#include <Eigen/SparseCore>
+#include <algorithm>
 // SFrame
 #include <core/storage/sframe_data/sarray.hpp>
 #include <core/storage/sframe_data/sframe.hpp>
@@ -237,6 +239,93 @@ inline void fill_reference_encoding(
 }
 
 
+/**
+ * Rows of reference encoded data stored as a compressed sparse row
+ * matrix, so that a batch of rows is multiplied in one call.
+ */
+typedef Eigen::SparseMatrix<double, Eigen::RowMajor> SparseRowMatrix;
+
+/**
+ * The number of rows to put in a batch filled by
+ * fill_reference_encoding_batch, given the number of values stored per
+ * row (the number of columns for dense rows): 1000 rows, or fewer for
+ * long rows, to keep each batch within about 8MB.
+ */
+inline size_t reference_encoding_batch_size(size_t row_size) {
+  return std::max<size_t>(1, std::min<size_t>(1000, (1024*1024) / std::max<size_t>(1, row_size)));
+}
+
+/**
+ * Fills the next rows of an iterator into the rows of a dense matrix,
+ * with the reference encoding of fill_reference_encoding and a 1 in
+ * the last column for the intercept.
+ *
+ * [in,out] it The iterator, advanced past the rows read.
+ * [in,out] X The matrix; its number of columns is kept, and its number
+ *            of rows is set to the number of rows filled.
+ * [in] batch_size The most rows to fill.
+ * [in] row_fn Called as row_fn(row_ref, i) before a row is filled as
+ *            row i of X; the row is skipped if it returns false.
+ *
+ * Returns the number of rows filled; 0 only at the end of the iterator.
+ */
+template <typename RowFunction>
+inline size_t fill_reference_encoding_batch(
+    ml_data_iterator& it, DenseMatrix& X, size_t batch_size, RowFunction&& row_fn) {
+
+  const size_t n_columns = X.cols();
+  if(size_t(X.rows()) != batch_size) {
+    X.resize(batch_size, n_columns);
+  }
+
+  size_t n = 0;
+  for(; n < batch_size && !it.done(); ++it) {
+    if(!row_fn(*it, n)) {
+      continue;
+    }
+    fill_reference_encoding(*it, X.row(n));
+    X(n, n_columns - 1) = 1;
+    ++n;
+  }
+
+  if(n < batch_size) {
+    X.conservativeResize(n, n_columns);
+  }
+  return n;
+}
+
+/**
+ * Like the dense version, but fills the rows of a compressed sparse row
+ * matrix with n_columns columns.  x is a buffer for a single row.
+ */
+template <typename RowFunction>
+inline size_t fill_reference_encoding_batch(
+    ml_data_iterator& it, SparseRowMatrix& X, size_t n_columns, size_t batch_size,
+    SparseVector& x, std::vector<Eigen::Triplet<double> >& triplets,
+    RowFunction&& row_fn) {
+
+  triplets.clear();
+  x.resize(n_columns);
+
+  size_t n = 0;
+  for(; n < batch_size && !it.done(); ++it) {
+    if(!row_fn(*it, n)) {
+      continue;
+    }
+    fill_reference_encoding(*it, x);
+    x.coeffRef(n_columns - 1) = 1;
+    for(SparseVector::InnerIterator e(x); e; ++e) {
+      triplets.emplace_back(n, e.index(), e.value());
+    }
+    ++n;
+  }
+
+  X.resize(n, n_columns);
+  X.setFromTriplets(triplets.begin(), triplets.end());
+  return n;
+}
+
+
 /**
  * Warn the user for features with low variance.
  *
@@ -564,6 +653,54 @@ inline size_t get_number_of_coefficients(std::shared_ptr<ml_metadata> metadata){
 }
 
 
+/**
+* Coefficients in the layout of a metadata whose indices were extended with
+* new categories (see supervised_learning_model_base::update). Each
+* coefficient keeps its feature; those of the new features are zero.
+*
+* \params[in] coefs         Coefficients laid out for old_metadata, one block
+*                           per non-reference class for classifiers.
+* \params[in] old_metadata  Metadata of the coefficients.
+* \params[in] new_metadata  The same columns, with index sizes at least as
+*                           large.
+*
+* \returns coefs laid out for new_metadata.
+*/
+inline Eigen::Matrix<double, Eigen::Dynamic, 1> extend_coefficients(
+         const Eigen::Matrix<double, Eigen::Dynamic, 1>& coefs,
+         std::shared_ptr<ml_metadata> old_metadata,
+         std::shared_ptr<ml_metadata> new_metadata) {
+
+  size_t old_size = get_number_of_coefficients(old_metadata);
+  size_t new_size = get_number_of_coefficients(new_metadata);
+  DASSERT_EQ(coefs.size() % old_size, 0);
+  DASSERT_EQ(old_metadata->num_columns(), new_metadata->num_columns());
+  size_t num_blocks = coefs.size() / old_size;
+
+  Eigen::Matrix<double, Eigen::Dynamic, 1> ret =
+    Eigen::Matrix<double, Eigen::Dynamic, 1>::Zero(num_blocks * new_size);
+
+  for (size_t b = 0; b < num_blocks; ++b) {
+    size_t old_idx = b * old_size;
+    size_t new_idx = b * new_size;
+
+    for (size_t i = 0; i < old_metadata->num_columns(); ++i) {
+      size_t skip = old_metadata->is_categorical(i) ? 1 : 0;
+      size_t old_col_size = old_metadata->index_size(i) - skip;
+      size_t new_col_size = new_metadata->index_size(i) - skip;
+      DASSERT_LE(old_col_size, new_col_size);
+
+      ret.segment(new_idx, old_col_size) = coefs.segment(old_idx, old_col_size);
+      old_idx += old_col_size;
+      new_idx += new_col_size;
+    }
+
+    // Intercept
+    ret(new_idx) = coefs(old_idx);
+  }
+  return ret;
+}
+
 /**
 * Add a column of None values to the SFrame of coefficients.
 *
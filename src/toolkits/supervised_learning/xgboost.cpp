@@ -304,7 +304,8 @@ void xgboost_model::_restore_from_checkpoint(const std::string& path) {
 std::vector<float> fast_evaluate(const std::vector<float>& preds,
                                  const learner::MetaInfo& info,
                                  std::vector<xgboost_evalptr>& evaluators) {
-  bool distributed = false;
+  // the metrics of a distributed training are over the rows of all workers
+  bool distributed = rabit::IsDistributed();
   std::vector<float> ret;
   for (auto& e : evaluators) {
     float v = e->Eval(preds, info, distributed);
@@ -587,6 +588,75 @@ std::shared_ptr< sarray<flexible_type> > transform_prediction(const std::vector<
   return sa;
 }
 
+/**
+ * Transform raw prediction values to the output type, in memory.
+ * Same as transform_prediction, for the few rows of fast path predictions.
+ * \param preds holds probability or margin
+ * \param output_type enum for prediction output type
+ * \param num_classes
+ */
+std::vector<flexible_type> transform_prediction_rows(const std::vector<float>& preds,
+                                                     prediction_type_enum output_type,
+                                                     size_t num_classes,
+                                                     std::shared_ptr<ml_metadata> ml_mdata) {
+  std::vector<flexible_type> ret;
+  if (num_classes == 0) {
+    // Regression
+    ret.assign(preds.begin(), preds.end());
+  } else if (num_classes == 2) {
+    //  Binary classification
+    ret.reserve(preds.size());
+    for (float x : preds) {
+      switch(output_type) {
+        case prediction_type_enum::PROBABILITY:
+        case prediction_type_enum::MARGIN:
+          ret.push_back(x);
+          break;
+        case prediction_type_enum::CLASS_INDEX:
+          ret.push_back(flex_int(x >= 0.5));
+          break;
+        case prediction_type_enum::NA:
+        case prediction_type_enum::CLASS:
+          ret.push_back(ml_mdata->target_indexer()->map_index_to_value(x >= 0.5));
+          break;
+        case prediction_type_enum::PROBABILITY_VECTOR:
+          ret.push_back(flex_vec{1.0-x, x});
+          break;
+        default:
+          log_and_throw("Unexpected output type");
+      }
+    }
+  } else {
+    ASSERT_MSG(preds.size() % num_classes == 0, "Unexpected prediction size");
+    // Multiclass classifier
+    size_t num_examples = preds.size() / num_classes;
+    ret.reserve(num_examples);
+    for (size_t i = 0; i < num_examples; ++i) {
+      auto begin_iter = preds.begin() + i * num_classes;
+      auto end_iter = begin_iter + num_classes;
+      auto max_iter = std::max_element(begin_iter, end_iter);
+      switch(output_type) {
+        case prediction_type_enum::MAX_PROBABILITY:
+          ret.push_back(*max_iter);
+          break;
+        case prediction_type_enum::CLASS_INDEX:
+          ret.push_back(flex_int(max_iter - begin_iter));
+          break;
+        case prediction_type_enum::NA:
+        case prediction_type_enum::CLASS:
+          ret.push_back(ml_mdata->target_indexer()->map_index_to_value(max_iter - begin_iter));
+          break;
+        case prediction_type_enum::PROBABILITY_VECTOR:
+          ret.push_back(flex_vec(begin_iter, end_iter));
+          break;
+        default:
+          log_and_throw("Unexpected output type");
+      }
+    }
+  }
+  return ret;
+}
+
 /**
  * Transform raw prediction values to the topk output type.
  * \param preds holds probability or margin
@@ -696,6 +766,46 @@ xgboost_model::xgboost_model() {
 /**
  * create ml_data to iterator object
  */
+void xgboost_model::init(const sframe& X, const sframe& y,
+                         const sframe& valid_X,
+                         const sframe& valid_y,
+                         ml_missing_value_action mva) {
+  if (!rabit::IsDistributed()) {
+    supervised_learning_model_base::init(X, y, valid_X, valid_y, mva);
+    return;
+  }
+
+  // Worker 0 indexes its shard, and the other workers index theirs with its
+  // metadata, so that the features and classes of all the workers match.
+  ml_data data, valid_data;
+  std::string metadata;
+  if (rabit::GetRank() == 0) {
+    std::tie(data, valid_data) = create_training_data(X, y, valid_X, valid_y, mva);
+    std::stringstream strm;
+    oarchive oarc(strm);
+    data.metadata()->save(oarc);
+    metadata = strm.str();
+  }
+  rabit::Broadcast(&metadata, 0);
+
+  if (rabit::GetRank() != 0) {
+    auto mdata = std::make_shared<ml_metadata>();
+    iarchive iarc(metadata.data(), metadata.size());
+    mdata->load(iarc);
+    std::string target_col = y.column_name(0);
+    data = ml_data(mdata);
+    data.fill(X.add_column(y.select_column(0), target_col), target_col,
+              std::map<std::string, ml_column_mode>(), true, mva);
+    if (valid_X.num_rows() > 0) {
+      valid_data = ml_data(mdata);
+      valid_data.fill(valid_X.add_column(valid_y.select_column(0), target_col),
+                      target_col, std::map<std::string, ml_column_mode>(),
+                      true, mva);
+    }
+  }
+  init_from_ml_data(data, valid_data);
+}
+
 void xgboost_model::model_specific_init(const ml_data& data,
                                         const ml_data& valid_data) {
   this->ml_data_ = data;
@@ -733,6 +843,19 @@ void xgboost_model::init_options(const std::map<std::string,flexible_type>& _opt
     int num_batches = _opts.at("_num_batches");
     this->_set_num_batches(num_batches);
   }
+  if (_opts.count("_tree_method") || _opts.count("_max_bin")) {
+    std::string method = "exact";
+    if (_opts.count("_tree_method")) method = _opts.at("_tree_method").to<std::string>();
+    flex_int max_bin = _opts.count("_max_bin") ? _opts.at("_max_bin").to<flex_int>() : max_bin_;
+    if (method != "exact" && method != "hist") {
+      log_and_throw("Option '_tree_method' must be one of 'exact' or 'hist'.");
+    }
+    if (max_bin < 2 || max_bin > 65536) {
+      log_and_throw("Option '_max_bin' must be between 2 and 65536.");
+    }
+    this->_set_tree_method(method == "hist" ? tree_method_enum::HIST : tree_method_enum::EXACT,
+                           max_bin);
+  }
   if (_opts.count("metric")) {
     auto parsed_metrics = parse_tracking_metric(_opts.at("metric"), this->tracking_metrics, this->is_classifier());
     this->set_tracking_metric(parsed_metrics);
@@ -757,6 +880,13 @@ void xgboost_model::_set_num_batches(size_t num_batches) {
   num_batches_ = num_batches;
 }
 
+void xgboost_model::_set_tree_method(tree_method_enum method, size_t max_bin) {
+  logstream(LOG_INFO) << "Set tree method to " << (int)method
+                      << " with " << max_bin << " bins" << std::endl;
+  tree_method_ = method;
+  max_bin_ = max_bin;
+}
+
 std::pair<std::shared_ptr<DMatrixMLData>, std::shared_ptr<DMatrixMLData>> xgboost_model::_init_data() {
   // Class weights
   flexible_type class_weights = flex_undefined();
@@ -768,14 +898,16 @@ std::pair<std::shared_ptr<DMatrixMLData>, std::shared_ptr<DMatrixMLData>> xgboos
   state["num_validation_examples"] = validation_ml_data_.size();
 
   // Set training data
-  std::shared_ptr<DMatrixMLData> ptrain = std::make_shared<DMatrixMLData>(ml_data_, class_weights, storage_mode_, num_batches_);
+  std::shared_ptr<DMatrixMLData> ptrain = std::make_shared<DMatrixMLData>(ml_data_, class_weights, storage_mode_,
+                                                                         num_batches_, tree_method_);
   // Set validation data
   std::shared_ptr<DMatrixMLData> pvalid;
   if (validation_ml_data_.size() > 0) {
     pvalid = std::make_shared<DMatrixMLData>(this->validation_ml_data_,
                                              class_weights,
                                              storage_mode_,
-                                             num_batches_);
+                                             num_batches_,
+                                             tree_method_);
   }
   return {ptrain, pvalid};
 }
@@ -791,7 +923,19 @@ void xgboost_model::_init_learner(std::shared_ptr<DMatrixMLData> ptrain,
     booster_->SetCacheData({ptrain.get()});
   }
   // Subclass configurations
-  if (ptrain->use_extern_memory_) {
+  if (tree_method_ == tree_method_enum::HIST) {
+    booster_->SetParam("max_bin", std::to_string(max_bin_).c_str());
+    if (ptrain->use_extern_memory_) {
+      // Keep the quantized columns on disk, and stream them once per level.
+      booster_->SetParam("hist_page_file", get_temp_name().c_str());
+    }
+    booster_->SetParam("updater", "grow_quantile_histmaker,prune");
+  } else if (ptrain->use_extern_memory_) {
+    booster_->SetParam("updater", "grow_histmaker,prune");
+  }
+  if (rabit::IsDistributed()) {
+    // The histograms of grow_histmaker are summed over the workers with
+    // rabit; the other updaters only see the rows of this worker.
     booster_->SetParam("updater", "grow_histmaker,prune");
   }
   if (!restore_from_checkpoint) {
@@ -1031,7 +1175,8 @@ void xgboost_model::train(void) {
                            tracker.get_validation_metrics(iter),
                            progress_table,
                            timer.current_time());
-      _checkpoint(checkpoint_path.string());
+      // every worker has the same model, so one writes it
+      if (rabit::GetRank() == 0) _checkpoint(checkpoint_path.string());
     }
 
     ++iter;
@@ -1100,14 +1245,12 @@ void xgboost_model::_save_training_state(size_t iteration,
 /**
  * Make predictions using a trained regression model.
  */
-std::shared_ptr< sarray<flexible_type> > xgboost_model::predict_impl(
-    const DMatrix& dmat,
-    const std::string& output_type) {
-
-  std::vector<float> preds;
-
-  // Classification
-  if (this->num_classes() > 2) {
+/**
+ * Rejects output types which only apply to binary classification.
+ */
+static void check_prediction_output_type(const std::string& output_type,
+                                         size_t num_classes) {
+  if (num_classes > 2) {
     if ((output_type == "margin") || (output_type == "probability")) {
       std::stringstream ss;
       ss << "Output type '" << output_type
@@ -1117,6 +1260,14 @@ std::shared_ptr< sarray<flexible_type> > xgboost_model::predict_impl(
       log_and_throw(ss.str());
     }
   }
+}
+
+std::shared_ptr< sarray<flexible_type> > xgboost_model::predict_impl(
+    const DMatrix& dmat,
+    const std::string& output_type) {
+
+  std::vector<float> preds;
+  check_prediction_output_type(output_type, this->num_classes());
   this->xgboost_predict(dmat, output_type=="margin", preds);
   return transform_prediction(preds,
                               prediction_type_enum_from_name(output_type),
@@ -1144,6 +1295,21 @@ gl_sarray xgboost_model::fast_predict(
   return gl_sarray(unity_sa);
 }
 
+std::vector<flexible_type> xgboost_model::predict_rows(
+    const std::vector<flexible_type>& test_data,
+    const std::string& missing_value_action,
+    const std::string& output_type) {
+  auto na_enum = get_missing_value_enum_from_string(missing_value_action);
+  DMatrixSimple dmat = make_simple_dmatrix(test_data, this->ml_mdata, na_enum);
+  std::vector<float> preds;
+  check_prediction_output_type(output_type, this->num_classes());
+  this->xgboost_predict(dmat, output_type=="margin", preds);
+  return transform_prediction_rows(preds,
+                                   prediction_type_enum_from_name(output_type),
+                                   this->num_classes(),
+                                   this->ml_mdata);
+}
+
 gl_sframe xgboost_model::fast_predict_topk(
     const std::vector<flexible_type>& test_data,
     const std::string& missing_value_action,
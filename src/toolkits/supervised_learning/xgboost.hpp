@@ -40,6 +40,15 @@ class DMatrixMLData;
 
 enum class storage_mode_enum : int { IN_MEMORY = 0, EXT_MEMORY = 1, AUTO = 2 };
 
+/**
+ * How the trees are grown: EXACT enumerates every distinct value of the
+ * sorted columns (or proposes candidate splits per level in external memory
+ * mode); HIST quantizes each feature once into at most max_bin bins and
+ * grows the trees from gradient histograms. In external memory mode, HIST
+ * keeps the quantized columns on disk instead of column sorted pages.
+ */
+enum class tree_method_enum : int { EXACT = 0, HIST = 1 };
+
 /**
  * Regression model base class.
  */
@@ -68,6 +77,16 @@ class EXPORT xgboost_model : public supervised_learning_model_base {
    * \param[in] data ML-Data object created by the init function.
    *
    */
+  /**
+   * In a distributed training (see init_distributed_training), indexes
+   * the shard of this worker with the metadata of worker 0, so that every
+   * worker indexes the columns the same way.
+   */
+  void init(const sframe& X, const sframe& y,
+            const sframe& valid_X=sframe(),
+            const sframe& valid_y=sframe(),
+            ml_missing_value_action mva = ml_missing_value_action::ERROR) override;
+
   void model_specific_init(const ml_data& data,
                            const ml_data& valid_data) override;
 
@@ -123,6 +142,15 @@ class EXPORT xgboost_model : public supervised_learning_model_base {
       const std::string& missing_value_action = "error",
       const std::string& output_type="") override;
 
+  /**
+   * Predictions for a list of rows, scored as one batch and returned in
+   * memory.
+   */
+  std::vector<flexible_type> predict_rows(
+      const std::vector<flexible_type>& test_data,
+      const std::string& missing_value_action = "error",
+      const std::string& output_type="") override;
+
   std::shared_ptr<sarray<flexible_type>> predict_impl(
       const ::xgboost::learner::DMatrix& dmat,
       const std::string& output_type="");
@@ -271,6 +299,13 @@ class EXPORT xgboost_model : public supervised_learning_model_base {
    */
   void _set_num_batches(size_t num_batches);
 
+  /**
+   * \internal
+   * Set how the trees are grown, and the number of bins of each
+   * feature when they are grown from histograms.
+   */
+  void _set_tree_method(tree_method_enum method, size_t max_bin);
+
   /**
    * \interal
    */
@@ -307,6 +342,10 @@ protected:
 
   size_t num_batches_ = 0;
 
+  tree_method_enum tree_method_ = tree_method_enum::EXACT;
+
+  size_t max_bin_ = 256;
+
   std::shared_ptr<coreml::MLModelWrapper> _export_xgboost_model(bool is_classifier,
       bool is_random_forest,
       const std::map<std::string, flexible_type>& context);
@@ -0,0 +1,386 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <cstring>
+#include <map>
+#include <memory>
+#include <vector>
+#include <boost/bind.hpp>
+#include <timer/timer.hpp>
+#include <toolkits/supervised_learning/xgboost_allreduce.hpp>
+#include <core/logging/logger.hpp>
+#include <core/parallel/pthread_tools.hpp>
+#include <core/storage/serialization/serialization_includes.hpp>
+#include <core/system/nanosockets/async_reply_socket.hpp>
+#include <core/system/nanosockets/async_request_socket.hpp>
+#include <core/system/nanosockets/zmq_msg_vector.hpp>
+#include <xgboost/subtree/rabit/include/rabit/engine.h>
+
+// The reduction functions of rabit only need the size of the elements
+namespace MPI {
+class Datatype {
+ public:
+  size_t type_size;
+  explicit Datatype(size_t type_size) : type_size(type_size) {}
+};
+}
+
+namespace turi {
+namespace supervised {
+namespace xgboost {
+
+namespace {
+
+using ::rabit::engine::IEngine;
+
+/**
+ * A rabit engine whose collective operations go through worker 0 over
+ * nanosockets: each worker sends its buffer to worker 0, which reduces the
+ * buffers in the order of the ranks, so that every worker gets the same
+ * result bit for bit, and replies the result to all of them.
+ *
+ * Every worker calls the operations in the same order (the xgboost code is
+ * the same on all of them), so the n-th operation of a worker is matched
+ * with the n-th operation of the others by its sequence number.
+ *
+ * There is no fault tolerance: the checkpoints of rabit are not kept. An
+ * operation which the other workers do not join within the timeout fails
+ * the training of every worker waiting on it.
+ */
+class nanosockets_engine : public IEngine {
+ public:
+  void Allreduce(void* sendrecvbuf, size_t type_nbytes, size_t count,
+                 ReduceFunction reducer, PreprocFunction prepare_fun,
+                 void* prepare_arg) override {
+    if (prepare_fun != NULL) prepare_fun(prepare_arg);
+    if (m_num_workers <= 1) return;
+    std::string data(static_cast<char*>(sendrecvbuf), type_nbytes * count);
+    std::string result = collective(data, -1, reducer, type_nbytes, count);
+    memcpy(sendrecvbuf, result.data(), result.size());
+  }
+
+  void Broadcast(void* sendrecvbuf, size_t size, int root) override {
+    if (m_num_workers <= 1) return;
+    std::string data;
+    if ((int)m_rank == root) data.assign(static_cast<char*>(sendrecvbuf), size);
+    std::string result = collective(data, root, NULL, 0, 0);
+    ASSERT_EQ(result.size(), size);
+    memcpy(sendrecvbuf, result.data(), result.size());
+  }
+
+  void InitAfterException() override {
+    log_and_throw("Distributed tree training cannot recover from an error");
+  }
+
+  int LoadCheckPoint(::rabit::Serializable* global_model,
+                     ::rabit::Serializable* local_model) override {
+    return 0;
+  }
+
+  void CheckPoint(const ::rabit::Serializable* global_model,
+                  const ::rabit::Serializable* local_model) override {
+    ++m_version;
+  }
+
+  void LazyCheckPoint(const ::rabit::Serializable* global_model) override {
+    ++m_version;
+  }
+
+  int VersionNumber() const override { return m_version; }
+  int GetRank() const override { return m_rank; }
+  int GetWorldSize() const override { return m_num_workers; }
+  bool IsDistributed() const override { return m_num_workers > 1; }
+  std::string GetHost() const override { return ""; }
+
+  void TrackerPrint(const std::string& msg) override {
+    if (m_rank == 0) logprogress_stream << msg << std::endl;
+  }
+
+  void init(size_t rank, size_t num_workers, const std::string& address,
+            size_t timeout) {
+    finalize();
+    if (num_workers == 0 || rank >= num_workers) {
+      log_and_throw("The rank of a worker must be less than the number of workers");
+    }
+    m_rank = rank;
+    m_num_workers = num_workers;
+    m_timeout = timeout;
+    m_next_sequence = 0;
+    if (num_workers == 1) return;
+    if (rank == 0) {
+      // a handler waits for the other workers, so one per worker
+      m_server.reset(new nanosockets::async_reply_socket(
+          boost::bind(&nanosockets_engine::serve, this, _1, _2),
+          num_workers, address));
+      m_server->start_polling();
+      logstream(LOG_INFO) << "Serving the reductions of " << num_workers
+                          << " workers on " << m_server->get_bound_address()
+                          << std::endl;
+    } else {
+      m_client.reset(new nanosockets::async_request_socket(address, 1));
+    }
+  }
+
+  void finalize() {
+    if (m_server) {
+      m_server->stop_polling();
+      m_server->close();
+      m_server.reset();
+    }
+    if (m_client) {
+      m_client->close();
+      m_client.reset();
+    }
+    m_rounds.clear();
+    m_rank = 0;
+    m_num_workers = 1;
+  }
+
+  ~nanosockets_engine() { finalize(); }
+
+ private:
+  /// A collective operation, as seen by worker 0
+  struct round {
+    /// The buffer of each worker
+    std::vector<std::string> buffers;
+    size_t num_arrived = 0;
+    size_t num_left = 0;
+    bool done = false;
+    /// Some worker gave up waiting for the others
+    bool failed = false;
+    std::string result;
+  };
+
+  size_t m_rank = 0;
+  size_t m_num_workers = 1;
+  int m_version = 0;
+  size_t m_next_sequence = 0;
+  /// Seconds to wait for the other workers in a collective operation
+  size_t m_timeout = 0;
+
+  std::unique_ptr<nanosockets::async_reply_socket> m_server;
+  std::unique_ptr<nanosockets::async_request_socket> m_client;
+
+  mutex m_lock;
+  conditional m_cond;
+  std::map<size_t, round> m_rounds;
+
+  /// The reduction of the operation in progress, set by worker 0
+  ReduceFunction* m_reducer = NULL;
+  size_t m_type_nbytes = 0;
+  size_t m_count = 0;
+
+  /**
+   * Runs the next collective operation: an allreduce if root is -1, and a
+   * broadcast from root otherwise. Returns the result.
+   */
+  std::string collective(std::string& data, int root, ReduceFunction* reducer,
+                         size_t type_nbytes, size_t count) {
+    size_t sequence = m_next_sequence++;
+    if (m_rank == 0) {
+      {
+        std::lock_guard<mutex> guard(m_lock);
+        m_reducer = reducer;
+        m_type_nbytes = type_nbytes;
+        m_count = count;
+      }
+      return contribute(sequence, 0, data, root);
+    }
+
+    std::stringstream strm;
+    oarchive oarc(strm);
+    oarc << sequence << m_rank << root << data;
+    nanosockets::zmq_msg_vector request, reply;
+    request.insert_back(strm.str());
+    if (m_client->request_master(request, reply, m_timeout) != 0) {
+      log_and_throw("Lost the connection to worker 0 of the distributed training");
+    }
+    // the reply is the error, empty on success, then the result
+    nanosockets::nn_msg_t* error = reply.read_next();
+    nanosockets::nn_msg_t* msg = reply.read_next();
+    if (error == NULL || msg == NULL) {
+      log_and_throw("Worker 0 of the distributed training failed");
+    }
+    if (!error->empty()) log_and_throw(*error);
+    return *msg;
+  }
+
+  /**
+   * Adds the buffer of a worker to an operation of worker 0, and waits for
+   * the result.
+   */
+  std::string contribute(size_t sequence, size_t rank, std::string& data, int root) {
+    std::unique_lock<mutex> lock(m_lock);
+    round& r = m_rounds[sequence];
+    if (r.buffers.empty()) {
+      r.buffers.resize(m_num_workers);
+      r.num_left = m_num_workers;
+    }
+    r.buffers[rank].swap(data);
+    ++r.num_arrived;
+    // worker 0 is the last to know the reduction, but it only matters once
+    // every worker has arrived
+    if (r.num_arrived == m_num_workers) {
+      if (root >= 0) {
+        r.result.swap(r.buffers[root]);
+      } else {
+        r.result.swap(r.buffers[0]);
+        MPI::Datatype dtype(m_type_nbytes);
+        for (size_t i = 1; i < m_num_workers; ++i) {
+          ASSERT_EQ(r.buffers[i].size(), r.result.size());
+          m_reducer(r.buffers[i].data(), &(r.result[0]), m_count, dtype);
+        }
+      }
+      r.buffers.clear();
+      r.done = true;
+      m_cond.broadcast();
+    } else {
+      timer ti;
+      while (!r.done && !r.failed) {
+        if (m_timeout > 0 && ti.current_time() >= m_timeout) {
+          // the waiting workers fail with us
+          r.failed = true;
+          m_cond.broadcast();
+          break;
+        }
+        m_cond.timedwait(m_lock, 1);
+      }
+    }
+    if (r.failed) {
+      // the workers which never arrived cannot free the round; finalize()
+      // does
+      log_and_throw("Timed out waiting for the other workers of the "
+                    "distributed training");
+    }
+    std::string result = r.result;
+    if (--r.num_left == 0) m_rounds.erase(sequence);
+    return result;
+  }
+
+  /// Handles the request of a worker other than 0
+  bool serve(nanosockets::zmq_msg_vector& recv, nanosockets::zmq_msg_vector& reply) {
+    nanosockets::nn_msg_t* msg = recv.read_next();
+    ASSERT_TRUE(msg != NULL);
+    iarchive iarc(msg->data(), msg->length());
+    size_t sequence = 0, rank = 0;
+    int root = -1;
+    std::string data;
+    iarc >> sequence >> rank >> root >> data;
+    std::string error, result;
+    try {
+      result = contribute(sequence, rank, data, root);
+    } catch (std::exception& e) {
+      error = e.what();
+    } catch (std::string& e) {
+      error = e;
+    }
+    reply.clear();
+    reply.insert_back(error);
+    reply.insert_back(result);
+    return true;
+  }
+};
+
+nanosockets_engine& get_process_engine() {
+  static nanosockets_engine engine;
+  return engine;
+}
+
+/// The engine of a thread_training_worker of this thread, if any
+thread_local nanosockets_engine* tls_engine = nullptr;
+
+nanosockets_engine& get_engine() {
+  return tls_engine != nullptr ? *tls_engine : get_process_engine();
+}
+
+} // anonymous namespace
+
+void init_distributed_training(size_t rank, size_t num_workers,
+                               const std::string& address,
+                               size_t timeout) {
+  get_process_engine().init(rank, num_workers, address, timeout);
+}
+
+void finalize_distributed_training() {
+  get_process_engine().finalize();
+}
+
+struct thread_training_worker::engine_holder {
+  nanosockets_engine engine;
+};
+
+thread_training_worker::thread_training_worker(size_t rank,
+                                               size_t num_workers,
+                                               const std::string& address,
+                                               size_t timeout)
+    : m_holder(new engine_holder) {
+  if (tls_engine != nullptr) {
+    log_and_throw("This thread is already a worker of a distributed training");
+  }
+  m_holder->engine.init(rank, num_workers, address, timeout);
+  tls_engine = &m_holder->engine;
+}
+
+thread_training_worker::~thread_training_worker() {
+  tls_engine = nullptr;
+  m_holder->engine.finalize();
+}
+
+} // namespace xgboost
+} // namespace supervised
+} // namespace turi
+
+// The engine of the rabit API used by xgboost, in place of the single
+// process engine of rabit (engine_empty.cc).
+namespace rabit {
+namespace engine {
+
+void Init(int argc, char* argv[]) {
+}
+
+void Finalize(void) {
+  turi::supervised::xgboost::get_engine().finalize();
+}
+
+IEngine* GetEngine(void) {
+  return &turi::supervised::xgboost::get_engine();
+}
+
+void Allreduce_(void* sendrecvbuf,
+                size_t type_nbytes,
+                size_t count,
+                IEngine::ReduceFunction red,
+                mpi::DataType dtype,
+                mpi::OpType op,
+                IEngine::PreprocFunction prepare_fun,
+                void* prepare_arg) {
+  GetEngine()->Allreduce(sendrecvbuf, type_nbytes, count, red,
+                         prepare_fun, prepare_arg);
+}
+
+ReduceHandle::ReduceHandle(void)
+    : handle_(NULL), redfunc_(NULL), htype_(NULL) {
+}
+
+ReduceHandle::~ReduceHandle(void) {}
+
+int ReduceHandle::TypeSize(const MPI::Datatype& dtype) {
+  return static_cast<int>(dtype.type_size);
+}
+
+void ReduceHandle::Init(IEngine::ReduceFunction redfunc, size_t type_nbytes) {
+  redfunc_ = redfunc;
+}
+
+void ReduceHandle::Allreduce(void* sendrecvbuf,
+                             size_t type_nbytes, size_t count,
+                             IEngine::PreprocFunction prepare_fun,
+                             void* prepare_arg) {
+  GetEngine()->Allreduce(sendrecvbuf, type_nbytes, count,
+                         redfunc_, prepare_fun, prepare_arg);
+}
+
+}  // namespace engine
+}  // namespace rabit
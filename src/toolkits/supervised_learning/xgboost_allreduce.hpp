@@ -0,0 +1,73 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_XGBOOST_ALLREDUCE_H_
+#define TURI_XGBOOST_ALLREDUCE_H_
+
+#include <memory>
+#include <string>
+#include <core/export.hpp>
+
+namespace turi {
+namespace supervised {
+namespace xgboost {
+
+/**
+ * Joins this process to a data parallel training of boosted trees and
+ * random forests by num_workers processes, on one or many machines.
+ *
+ * Every worker then creates the same model, with the same options, from its
+ * own shard of the rows. The trees are grown from histograms of the
+ * gradients summed over all the workers, so every worker ends with the
+ * same model, that of the whole data.
+ *
+ * The reductions of xgboost (rabit::Allreduce and rabit::Broadcast) go
+ * through worker 0, which listens on address, for instance
+ * "tcp://0.0.0.0:9000", and which the other workers reach at their own form
+ * of the address, for instance "tcp://host0:9000". A reduction which the
+ * other workers do not join within timeout seconds throws, failing the
+ * training.
+ *
+ * The columns are indexed as worker 0 indexes its shard: categories and
+ * classes missing from it are treated by the other workers as unseen at
+ * training time.
+ *
+ * \param rank The rank of this worker, in [0, num_workers).
+ * \param num_workers The number of workers.
+ * \param address Where worker 0 listens.
+ * \param timeout Seconds to wait for the other workers. 0 waits forever.
+ */
+EXPORT void init_distributed_training(size_t rank, size_t num_workers,
+                                      const std::string& address,
+                                      size_t timeout = 3600);
+
+/// Leaves the distributed training. The process trains alone again.
+EXPORT void finalize_distributed_training();
+
+/**
+ * Joins the calling thread, rather than the process, to a distributed
+ * training, as init_distributed_training() does, until destroyed. Several
+ * workers can then run in one process, over an "inproc://" address.
+ */
+class EXPORT thread_training_worker {
+ public:
+  thread_training_worker(size_t rank, size_t num_workers,
+                         const std::string& address,
+                         size_t timeout = 3600);
+  ~thread_training_worker();
+
+  thread_training_worker(const thread_training_worker&) = delete;
+  thread_training_worker& operator=(const thread_training_worker&) = delete;
+
+ private:
+  struct engine_holder;
+  std::unique_ptr<engine_holder> m_holder;
+};
+
+} // namespace xgboost
+} // namespace supervised
+} // namespace turi
+
+#endif
@@ -507,7 +507,9 @@ class DiskPagedFMatrix: public IFMatrix {
   /*! \brief constructor */
   DiskPagedFMatrix(utils::IIterator<RowBatch> *iter,
                      const learner::MetaInfo &info,
-                     size_t num_batches) : info(info), num_batches(num_batches) {
+                     size_t num_batches,
+                     bool row_access_only = false)
+    : info(info), num_batches(num_batches), row_access_only(row_access_only) {
     this->iter_ = iter;
   }
   // destructor
@@ -568,6 +570,7 @@ class DiskPagedFMatrix: public IFMatrix {
    * \brief get the column based  iterator
    */
   virtual utils::IIterator<ColBatch>* ColIterator(void) {
+    utils::Check(!row_access_only, "ColIterator: no column pages in row access mode");
     size_t ncol = this->NumCol();
     col_index_.clear();
     for (size_t i = 0; i < ncol; ++i) {
@@ -581,6 +584,7 @@ class DiskPagedFMatrix: public IFMatrix {
    * \brief colmun based iterator
    */
   virtual utils::IIterator<ColBatch> *ColIterator(const std::vector<bst_uint> &fset) {
+    utils::Check(!row_access_only, "ColIterator: no column pages in row access mode");
     size_t ncol = this->NumCol();
     col_index_.clear();
     for (size_t i = 0; i < fset.size(); ++i) {
@@ -592,7 +596,8 @@ class DiskPagedFMatrix: public IFMatrix {
   }
  protected:
   /*!
-   * \brief intialize column data
+   * \brief intialize column data; in row access mode, only the column sizes
+   *  and the buffered rows, without the column pages
    * \param pkeep probability to keep a row
    */
   void InitColData(float pkeep, size_t max_row_perbatch) {
@@ -610,7 +615,6 @@ class DiskPagedFMatrix: public IFMatrix {
     size_t batch_id = 0;
     while (iter_->Next()) {
       ++batch_id;
-      logstream(LOG_PROGRESS) << "Create disk column page " << batch_id << "/" << num_batches << std::endl;
       auto& rowbatch = iter_->Value();
       size_t base_rowid = rowbatch.base_rowid;
       dense_bitset row_mask(rowbatch.size);
@@ -620,6 +624,17 @@ class DiskPagedFMatrix: public IFMatrix {
           buffered_rowset_.push_back(base_rowid + i);
         }
       }
+      if (row_access_only) {
+        for (size_t i = 0; i < rowbatch.size; ++i) {
+          if (!row_mask.get(i)) continue;
+          RowBatch::Inst inst = rowbatch[i];
+          for (size_t j = 0; j < inst.length; ++j) {
+            ++col_size_[inst[j].index];
+          }
+        }
+        continue;
+      }
+      logstream(LOG_PROGRESS) << "Create disk column page " << batch_id << "/" << num_batches << std::endl;
       col_pages.push_back(DiskPageType());
       auto& new_page = col_pages.back();
       MakeColPage(rowbatch, row_mask, info.num_col(), &(new_page));
@@ -647,13 +662,16 @@ class DiskPagedFMatrix: public IFMatrix {
   ColBatchIter col_iter_;
   // number of batches in both row and col batch iterator
   size_t num_batches;
+  // whether the column pages are skipped, for updaters that only read rows
+  bool row_access_only;
 }; // end of DiskPagedFMatrix
 
 
 DMatrixMLData::DMatrixMLData(const ml_data &data,
   flexible_type class_weights,
   storage_mode_enum storage_mode,
-  size_t num_batches) : DMatrix(kMagic) {
+  size_t num_batches,
+  tree_method_enum tree_method) : DMatrix(kMagic) {
 
   auto metadata = data.metadata();
   info.info.num_row = data.size();
@@ -755,7 +773,10 @@ DMatrixMLData::DMatrixMLData(const ml_data &data,
   } else {
     logstream(LOG_INFO) << "Use external memory storage mode" << std::endl;
     storage_mode = storage_mode_enum::EXT_MEMORY;
-    auto fmat = new DiskPagedFMatrix(it, this->info, num_batches);
+    // The histogram updater quantizes its own copy of the rows, so the
+    // column pages would only be written and never read.
+    bool row_access_only = (tree_method == tree_method_enum::HIST);
+    auto fmat = new DiskPagedFMatrix(it, this->info, num_batches, row_access_only);
     /* Switch to use original xgboost's FMatrixPage backend */
     // auto fmat = new FMatrixPage(it, this->info);
     // auto temp_file = get_temp_name();
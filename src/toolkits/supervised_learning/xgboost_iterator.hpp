@@ -19,7 +19,8 @@ class DMatrixMLData : public ::xgboost::learner::DMatrix {
    DMatrixMLData(const ml_data &data,
                  flexible_type class_weights = flex_undefined(),
                  storage_mode_enum storage_mode = storage_mode_enum::AUTO,
-                 size_t max_row_per_batch = 0);
+                 size_t max_row_per_batch = 0,
+                 tree_method_enum tree_method = tree_method_enum::EXACT);
 
    virtual ~DMatrixMLData(void);
    virtual ::xgboost::IFMatrix *fmat(void) const;
@@ -24,6 +24,8 @@
 #include <timer/timer.hpp>
 #include <Eigen/Core>
 #include <core/parallel/atomic.hpp>
+#include <core/parallel/lambda_omp.hpp>
+#include <numeric>
 
 namespace turi {
 namespace text {
@@ -84,6 +86,13 @@ void cgs_topic_model::init_options(const std::map<std::string,
       false);
 
 
+  options.create_categorical_option(
+      "sampler",
+      "Sampler to use: collapsed Gibbs sampling (gibbs), Metropolis-Hastings with alias tables (alias), or alias for 100 topics or more (auto).",
+      "auto",
+      {flexible_type("auto"), flexible_type("gibbs"), flexible_type("alias")},
+      false);
+
   options.create_real_option(
       "alpha",
       "Hyperparameter for smoothing the number of topics per document. Must be positive.",
@@ -336,6 +345,346 @@ std::map<std::string, size_t> cgs_topic_model::sample_counts(
   return ret;
 }
 
+namespace {
+
+/**
+ * Build a Walker alias table for the n weights w, of sum total: drawing i
+ * uniformly and keeping it with probability prob[i], or else taking
+ * alias[i], draws i with probability w[i] / total.
+ */
+void build_alias_table(const double* w, size_t n, double total,
+                       float* prob, uint32_t* alias,
+                       std::vector<double>& scaled,
+                       std::vector<uint32_t>& small,
+                       std::vector<uint32_t>& large) {
+  scaled.resize(n);
+  small.clear();
+  large.clear();
+
+  for (size_t i = 0; i < n; ++i) {
+    scaled[i] = w[i] * n / total;
+    if (scaled[i] < 1) {
+      small.push_back(i);
+    } else {
+      large.push_back(i);
+    }
+  }
+
+  while (!small.empty() && !large.empty()) {
+    uint32_t s = small.back();
+    small.pop_back();
+    uint32_t l = large.back();
+
+    prob[s] = scaled[s];
+    alias[s] = l;
+    scaled[l] -= 1 - scaled[s];
+    if (scaled[l] < 1) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+
+  // Whatever is left is 1 up to rounding.
+  for (uint32_t i : large) {
+    prob[i] = 1;
+    alias[i] = i;
+  }
+  for (uint32_t i : small) {
+    prob[i] = 1;
+    alias[i] = i;
+  }
+}
+
+inline size_t sample_alias_table(const float* prob, const uint32_t* alias,
+                                 size_t n) {
+  size_t i = random::fast_uniform<size_t>(0, n - 1);
+  return (random::fast_uniform<double>(0, 1) < prob[i]) ? i : alias[i];
+}
+
+/**
+ * Word proposal of the Metropolis-Hastings sampler, proportional to
+ * (n_wk + beta) / (n_k + V beta) for the counts when it is built.
+ *
+ * It is split into n_wk / (n_k + V beta) over the nonzero counts of each
+ * word, with an alias table per word, and beta / (n_k + V beta), with one
+ * alias table shared by all words. The tables then take space in the number
+ * of nonzero word topic counts instead of V x K.
+ */
+class word_topic_proposal {
+ public:
+  void build(const topic_model::count_matrix_type& word_topic_counts,
+             const topic_model::count_vector_type& topic_counts,
+             double _beta, size_t vocab_size) {
+
+    beta = _beta;
+    const size_t num_topics = topic_counts.size();
+
+    inv_denominators.resize(num_topics);
+    std::vector<double> shared_weights(num_topics);
+    for (size_t k = 0; k < num_topics; ++k) {
+      inv_denominators[k] =
+          1.0 / (std::max(topic_counts(0, k), 0) + vocab_size * beta);
+      shared_weights[k] = beta * inv_denominators[k];
+    }
+    shared_mass = std::accumulate(shared_weights.begin(), shared_weights.end(), 0.0);
+    shared_prob.resize(num_topics);
+    shared_alias.resize(num_topics);
+    {
+      std::vector<double> scaled;
+      std::vector<uint32_t> small, large;
+      build_alias_table(shared_weights.data(), num_topics, shared_mass,
+                        shared_prob.data(), shared_alias.data(),
+                        scaled, small, large);
+    }
+
+    // Count the nonzero topics of each word.
+    word_begin.assign(vocab_size + 1, 0);
+    parallel_for(0, vocab_size, [&](size_t w) {
+      size_t nnz = 0;
+      for (size_t k = 0; k < num_topics; ++k) {
+        nnz += (word_topic_counts(w, k) > 0);
+      }
+      word_begin[w + 1] = nnz;
+    });
+    for (size_t w = 0; w < vocab_size; ++w) {
+      word_begin[w + 1] += word_begin[w];
+    }
+
+    const size_t total_nnz = word_begin[vocab_size];
+    topics.resize(total_nnz);
+    counts.resize(total_nnz);
+    prob.resize(total_nnz);
+    alias.resize(total_nnz);
+    word_mass.assign(vocab_size, 0);
+
+    in_parallel([&](size_t thread_idx, size_t num_threads) {
+      std::vector<double> weights, scaled;
+      std::vector<uint32_t> small, large;
+
+      size_t w_begin = (vocab_size * thread_idx) / num_threads;
+      size_t w_end = (vocab_size * (thread_idx + 1)) / num_threads;
+
+      for (size_t w = w_begin; w < w_end; ++w) {
+        size_t pos = word_begin[w];
+        weights.clear();
+        for (size_t k = 0; k < num_topics; ++k) {
+          int c = word_topic_counts(w, k);
+          if (c > 0) {
+            topics[pos] = k;
+            counts[pos] = c;
+            weights.push_back(c * inv_denominators[k]);
+            ++pos;
+          }
+        }
+        DASSERT_EQ(pos, word_begin[w + 1]);
+
+        if (!weights.empty()) {
+          word_mass[w] = std::accumulate(weights.begin(), weights.end(), 0.0);
+          build_alias_table(weights.data(), weights.size(), word_mass[w],
+                            &prob[word_begin[w]], &alias[word_begin[w]],
+                            scaled, small, large);
+        }
+      }
+    });
+  }
+
+  /**
+   * Draw a topic for word w.
+   */
+  inline size_t sample(size_t w) const {
+    const size_t b = word_begin[w];
+    const size_t n = word_begin[w + 1] - b;
+
+    if (n > 0 &&
+        random::fast_uniform<double>(0, word_mass[w] + shared_mass) < word_mass[w]) {
+      return topics[b + sample_alias_table(&prob[b], &alias[b], n)];
+    }
+    return sample_alias_table(shared_prob.data(), shared_alias.data(),
+                              shared_alias.size());
+  }
+
+  /**
+   * Unnormalized probability of drawing topic k for word w.
+   */
+  inline double probability(size_t w, size_t k) const {
+    auto first = topics.begin() + word_begin[w];
+    auto last = topics.begin() + word_begin[w + 1];
+    auto it = std::lower_bound(first, last, uint32_t(k));
+    int c = (it != last && *it == k) ? counts[it - topics.begin()] : 0;
+    return (c + beta) * inv_denominators[k];
+  }
+
+ private:
+  double beta = 0;
+  std::vector<double> inv_denominators;
+
+  double shared_mass = 0;
+  std::vector<float> shared_prob;
+  std::vector<uint32_t> shared_alias;
+
+  std::vector<size_t> word_begin;
+  std::vector<uint32_t> topics;
+  std::vector<int> counts;
+  std::vector<float> prob;
+  std::vector<uint32_t> alias;
+  std::vector<double> word_mass;
+};
+
+}  // namespace
+
+std::map<std::string, size_t> cgs_topic_model::sample_counts_alias(
+    const v2::ml_data& d,
+    count_vector_type& topic_counts,
+    count_matrix_type& doc_topic_counts,
+    std::shared_ptr<sarray<std::vector<size_t> > >& assignments) {
+
+  // Steps per token, alternating the document and the word proposals.
+  const size_t num_mh_steps = 2;
+
+  atomic<size_t> token_count = 0;
+  atomic<size_t> num_different = 0;
+
+  word_topic_proposal word_proposal;
+  word_proposal.build(word_topic_counts, topic_counts, beta, vocab_size);
+  const double vocab_beta = vocab_size * beta;
+
+  // Initialize iterators
+  auto assignments_reader = assignments->get_reader();
+
+  // Create an SArray for new assignments
+  std::shared_ptr<sarray<std::vector<size_t> > > new_assignments(new sarray<std::vector<size_t>>);
+  size_t num_segments = thread::cpu_count();
+  new_assignments->open_for_write(num_segments);
+
+  in_parallel([&](size_t thread_idx, size_t num_threads) {
+
+    std::vector<size_t> doc_assignments;
+    std::vector<size_t> cumulative_counts;
+    std::vector<v2::ml_data_entry> x;
+
+    // Set up SArrays for reading current assignments and writing new ones
+    auto iter = assignments_reader->begin(thread_idx);
+    auto new_assignments_out = new_assignments->get_output_iterator(thread_idx);
+
+    for(auto it = d.get_iterator(thread_idx, num_threads); !it.done(); ++it) {
+
+      size_t doc_id = it.row_index();
+      it.fill_observation(x);
+
+      doc_assignments = *iter;
+      DASSERT_EQ(x.size(), doc_assignments.size());
+
+      // Running counts of the tokens counted in doc_topic_counts, to draw
+      // the topic of a random token of the document.
+      cumulative_counts.resize(x.size() + 1);
+      cumulative_counts[0] = 0;
+      for (size_t j = 0; j < x.size(); ++j) {
+        bool counted = (associations.count(x[j].index) != 0) ||
+                       (x[j].index < vocab_size);
+        cumulative_counts[j + 1] =
+            cumulative_counts[j] + (counted ? size_t(x[j].value) : 0);
+      }
+      const size_t doc_length = cumulative_counts.back();
+
+      // Choose a random spot in the document to try first.   This way we reduce biases.
+      size_t shift = random::fast_uniform<size_t>(0, x.size()-1);
+      for (size_t _j = 0; _j < x.size(); ++_j) {
+        size_t j = (_j + shift) % x.size();
+
+        size_t word_id = x[j].index;
+        int freq = x[j].value;
+        DASSERT_GE(freq, 0);
+
+        // Skip fixed associations and words outside of the vocabulary.
+        if (associations.count(word_id) != 0 || word_id >= vocab_size) {
+          continue;
+        }
+
+        // Remove counts due to current tokens
+        size_t old_topic = doc_assignments[j];
+        __sync_add_and_fetch(&word_topic_counts(word_id, old_topic), -freq);
+        __sync_add_and_fetch(&topic_counts(0, old_topic), -freq);
+        doc_topic_counts(doc_id, old_topic) -= freq;
+
+        // Word factor of the target probability of a topic.
+        auto word_factor = [&](size_t k) GL_GCC_ONLY(GL_HOT_INLINE_FLATTEN) {
+          return (std::max(word_topic_counts(word_id, k), 0) + beta) /
+                 (std::max(topic_counts(0, k), 0) + vocab_beta);
+        };
+
+        const size_t other_length = doc_length - freq;
+        size_t topic = old_topic;
+
+        for (size_t mh = 0; mh < num_mh_steps; ++mh) {
+          size_t proposed;
+          double accept;
+
+          if (mh % 2 == 0) {
+            // Document proposal: the document factors cancel out.
+            double u = random::fast_uniform<double>(0, other_length + num_topics * alpha);
+            if (u < other_length) {
+              // Skip over the current token.
+              size_t pos = size_t(u);
+              if (pos >= cumulative_counts[j]) {
+                pos += freq;
+              }
+              size_t entry = std::upper_bound(cumulative_counts.begin(),
+                                              cumulative_counts.end(), pos)
+                             - cumulative_counts.begin() - 1;
+              proposed = doc_assignments[entry];
+            } else {
+              proposed = random::fast_uniform<size_t>(0, num_topics - 1);
+            }
+            accept = word_factor(proposed) / word_factor(topic);
+
+          } else {
+            // Word proposal: only the proposal probabilities are stale.
+            proposed = word_proposal.sample(word_id);
+            accept = (doc_topic_counts(doc_id, proposed) + alpha) * word_factor(proposed)
+                     * word_proposal.probability(word_id, topic)
+                     / ((doc_topic_counts(doc_id, topic) + alpha) * word_factor(topic)
+                        * word_proposal.probability(word_id, proposed));
+          }
+
+          if (proposed != topic && random::fast_uniform<double>(0, 1) < accept) {
+            topic = proposed;
+          }
+        }
+
+        DASSERT_TRUE(topic < num_topics);
+
+        // Increment counts
+        __sync_add_and_fetch(&word_topic_counts(word_id, topic), freq);
+        __sync_add_and_fetch(&topic_counts(0, topic), freq);
+        doc_topic_counts(doc_id, topic) += freq;
+
+        if (topic != old_topic) {
+          ++num_different;
+          doc_assignments[j] = topic;
+        }
+
+        // Increment counter
+        ++token_count;
+      } // end of words for this document
+
+      // Write assignments for this document
+      *new_assignments_out = doc_assignments;
+      ++new_assignments_out;
+      ++iter;
+    } // end of documents for this thread
+  });
+  new_assignments->close();
+  assignments_reader->reset_iterators();
+
+  // Use these new assignments from now on.
+  assignments = new_assignments;
+
+  std::map<std::string, size_t> ret;
+  ret["token_count"] = (size_t) token_count;
+  ret["num_different"] = (size_t) num_different;
+  return ret;
+}
+
 /**
  * Train a model using collapsed Gibbs sampling.
  */
@@ -405,6 +754,17 @@ void cgs_topic_model::train(std::shared_ptr<sarray<flexible_type>> dataset, bool
 
   auto assignments = forward_sample(d, topic_counts, doc_topic_counts);
 
+  // Models saved before the sampler option existed use Gibbs sampling.
+  std::string sampler = "gibbs";
+  if (options.current_option_values().count("sampler") != 0) {
+    sampler = get_option_value("sampler").get<flex_string>();
+  }
+  bool use_alias = (sampler == "alias") ||
+                   (sampler == "auto" && num_topics >= 100);
+  if (use_alias) {
+    logprogress_stream << "   Using Metropolis-Hastings with alias tables" << std::endl;
+  }
+
   // Step 2. Gibbs sampling
   // -------------------------------------------------------------------------
   // For each (doc, word) pair, we compute the following conditional
@@ -435,7 +795,9 @@ void cgs_topic_model::train(std::shared_ptr<sarray<flexible_type>> dataset, bool
 
     // Reset old assignments before the next iteration
     ti.start();
-    auto info = sample_counts(d, topic_counts, doc_topic_counts, assignments);
+    auto info = use_alias
+        ? sample_counts_alias(d, topic_counts, doc_topic_counts, assignments)
+        : sample_counts(d, topic_counts, doc_topic_counts, assignments);
     double tokens_per_second = info["token_count"] / ti.current_time();
 
     if ((print_interval > 0) &&
@@ -87,6 +87,9 @@ class EXPORT cgs_topic_model : public topic_model {
    *   handle the case where a user has provided a set of topics for
    *   initialization purposes.
    *
+   * With the "sampler" option set to "alias" ("auto" picks it for 100 topics
+   * or more), each pass uses sample_counts_alias instead of sample_counts,
+   * so a token costs O(1) rather than O(K).
    */
   void train(std::shared_ptr<sarray<flexible_type>> data, bool verbose) override;
 
@@ -101,6 +104,27 @@ class EXPORT cgs_topic_model : public topic_model {
                     count_matrix_type& doc_topic_counts,
                     std::shared_ptr<sarray<std::vector<size_t>>>& assignments);
 
+  /**
+   * One pass of Metropolis-Hastings sampling over the documents, in the
+   * style of LightLDA (Yuan et al., 2015). Each token takes steps that
+   * alternate between two proposals, each drawn in O(1):
+   *
+   * - The document proposal, proportional to n_dk + alpha, drawn by taking
+   *   the topic of a random token of the document (or a uniform topic).
+   *
+   * - The word proposal, proportional to (n_wk + beta) / (n_k + V beta) with
+   *   the counts at the start of the pass, drawn from an alias table over
+   *   the nonzero counts of the word and one table shared by all words.
+   *
+   * Documents are sampled in parallel, and the word and topic counts are
+   * updated in place with atomic adds, as in sample_counts.
+   */
+  std::map<std::string, size_t>
+      sample_counts_alias(const v2::ml_data& d,
+                          count_vector_type& topic_counts,
+                          count_matrix_type& doc_topic_counts,
+                          std::shared_ptr<sarray<std::vector<size_t>>>& assignments);
+
   // TODO: convert interface above to use the extensions methods here
   BEGIN_CLASS_MEMBER_REGISTRATION("cgs_topic_model")
   REGISTER_CLASS_MEMBER_FUNCTION(cgs_topic_model::list_fields)
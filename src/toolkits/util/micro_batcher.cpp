@@ -0,0 +1,93 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <toolkits/util/micro_batcher.hpp>
+#include <core/globals/globals.hpp>
+#include <core/logging/logger.hpp>
+#include <core/export.hpp>
+#include <algorithm>
+#include <chrono>
+
+namespace turi {
+
+EXPORT size_t MODEL_SERVING_MAX_BATCH_SIZE = 64;
+EXPORT size_t MODEL_SERVING_MAX_WAIT_US = 200;
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, MODEL_SERVING_MAX_BATCH_SIZE, true,
+                            +[](int64_t val){ return val >= 1; });
+REGISTER_GLOBAL(int64_t, MODEL_SERVING_MAX_WAIT_US, true);
+
+micro_batcher::micro_batcher(batch_function fn, size_t max_batch_size,
+                             size_t max_wait_us)
+    : m_fn(fn),
+      m_max_batch_size(std::max<size_t>(max_batch_size, 1)),
+      m_max_wait_us(max_wait_us) { }
+
+flexible_type micro_batcher::submit(const flexible_type& row) {
+  std::unique_lock<std::mutex> lock(m_lock);
+
+  bool is_leader = false;
+  if (!m_open_batch) {
+    m_open_batch = std::make_shared<batch>();
+    is_leader = true;
+  }
+  std::shared_ptr<batch> b = m_open_batch;
+  size_t index = b->rows.size();
+  b->rows.push_back(row);
+
+  if (b->rows.size() >= m_max_batch_size) {
+    // Full; the next row starts a new batch.
+    m_open_batch.reset();
+    m_cond.notify_all();
+  }
+
+  if (is_leader) {
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::microseconds(m_max_wait_us);
+    while (m_open_batch == b &&
+           m_cond.wait_until(lock, deadline) != std::cv_status::timeout) { }
+    if (m_open_batch == b) m_open_batch.reset();
+
+    // No more rows can join b, so it is read without the lock.
+    lock.unlock();
+    std::vector<flexible_type> results;
+    std::exception_ptr error;
+    try {
+      results = score(b->rows);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    lock.lock();
+    b->results = std::move(results);
+    b->error = error;
+    b->done = true;
+    m_cond.notify_all();
+  } else {
+    while (!b->done) m_cond.wait(lock);
+  }
+
+  if (b->error) {
+    if (b->rows.size() == 1) std::rethrow_exception(b->error);
+    // One bad row fails the whole batch: each row is scored again on its
+    // own, on the thread which submitted it, so that only the requests whose
+    // rows fail see an error.
+    lock.unlock();
+    return score({row})[0];
+  }
+  return b->results[index];
+}
+
+std::vector<flexible_type> micro_batcher::score(
+    const std::vector<flexible_type>& rows) {
+  std::vector<flexible_type> results = m_fn(rows);
+  if (results.size() != rows.size()) {
+    log_and_throw("Batch function returned " +
+                  std::to_string(results.size()) + " results for " +
+                  std::to_string(rows.size()) + " rows.");
+  }
+  return results;
+}
+
+} // namespace turi
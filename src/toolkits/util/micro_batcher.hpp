@@ -0,0 +1,94 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#ifndef TURI_TOOLKITS_UTIL_MICRO_BATCHER_HPP
+#define TURI_TOOLKITS_UTIL_MICRO_BATCHER_HPP
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <core/data/flexible_type/flexible_type.hpp>
+
+namespace turi {
+
+/**
+ * The most rows gathered into one batch by a \ref micro_batcher, unless
+ * given explicitly.
+ */
+extern size_t MODEL_SERVING_MAX_BATCH_SIZE;
+
+/**
+ * The longest time, in microseconds, a \ref micro_batcher waits for more rows
+ * before scoring a batch, unless given explicitly.
+ */
+extern size_t MODEL_SERVING_MAX_WAIT_US;
+
+/**
+ * \ingroup toolkit_util
+ * Gathers single rows submitted concurrently by several threads into batches,
+ * scored with one call of a batch function, so that the cost of each call is
+ * shared by all the rows of the batch.
+ *
+ * The first thread to submit a row into an empty batch waits until the batch
+ * holds max_batch_size rows, or for max_wait_us microseconds, whichever comes
+ * first. It then scores the batch on its own thread and hands each of the
+ * other threads its result. No background thread is involved, so a lone
+ * request waits at most max_wait_us longer than an unbatched one.
+ *
+ * \code
+ * micro_batcher batcher([&](const std::vector<flexible_type>& rows) {
+ *   return model->predict_rows(rows);
+ * });
+ * // From any number of threads:
+ * flexible_type prediction = batcher.submit(row);
+ * \endcode
+ *
+ * The batch function must return one value per row, in order, and may be
+ * called by several threads at once. If it throws on a batch of several
+ * rows, each of them is scored again in a batch of its own, so that an
+ * exception only reaches the threads whose rows fail on their own.
+ */
+class micro_batcher {
+ public:
+  typedef std::function<std::vector<flexible_type>(
+      const std::vector<flexible_type>& rows)> batch_function;
+
+  micro_batcher(batch_function fn,
+                size_t max_batch_size = MODEL_SERVING_MAX_BATCH_SIZE,
+                size_t max_wait_us = MODEL_SERVING_MAX_WAIT_US);
+
+  /**
+   * Scores one row, as part of a batch, and returns its result.
+   */
+  flexible_type submit(const flexible_type& row);
+
+ private:
+  struct batch {
+    std::vector<flexible_type> rows;
+    std::vector<flexible_type> results;
+    std::exception_ptr error;
+    bool done = false;
+  };
+
+  batch_function m_fn;
+  size_t m_max_batch_size;
+  size_t m_max_wait_us;
+
+  std::mutex m_lock;
+  std::condition_variable m_cond;
+  // the batch still accepting rows, if any
+  std::shared_ptr<batch> m_open_batch;
+
+  /// Calls m_fn, and checks that it returns one result per row
+  std::vector<flexible_type> score(const std::vector<flexible_type>& rows);
+
+  micro_batcher(const micro_batcher&) = delete;
+  micro_batcher& operator=(const micro_batcher&) = delete;
+};
+
+} // namespace turi
+#endif
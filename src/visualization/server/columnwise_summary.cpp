@@ -64,6 +64,7 @@ namespace turi {
       }
 
       // now that we've collected columns, pick a batch size and add transformers
+      // (fed by the summary view, which reads the rows for all columns at once)
       gl_sframe gl_sf(sf->select_columns(column_names));
       size_t sf_batch_size = batch_size(gl_sf);
       for (const std::string& col : column_names) {
@@ -72,6 +73,7 @@ namespace turi {
           case flex_type_enum::INTEGER:
           {
             std::shared_ptr<histogram<flex_int>> hist = std::make_shared<histogram<flex_int>>();
+            hist->set_random_block_order(false);
             hist->init(sarr, sf_batch_size);
             column_transformers.push_back(hist);
             break;
@@ -79,6 +81,7 @@ namespace turi {
           case flex_type_enum::FLOAT:
           {
             std::shared_ptr<histogram<flex_float>> hist = std::make_shared<histogram<flex_float>>();
+            hist->set_random_block_order(false);
             hist->init(sarr, sf_batch_size);
             column_transformers.push_back(hist);
             break;
@@ -86,6 +89,7 @@ namespace turi {
           case flex_type_enum::STRING:
           {
             std::shared_ptr<item_frequency> item_freq = std::make_shared<item_frequency>();
+            item_freq->set_random_block_order(false);
             item_freq->init(sarr, sf_batch_size);
             column_transformers.push_back(item_freq);
             break;
@@ -107,7 +111,7 @@ namespace turi {
         column_types.push_back(sarr->dtype());
       }
 
-      std::shared_ptr<summary_view_transformation> summary_view_transformers = std::make_shared<summary_view_transformation>(column_transformers, column_names, column_types, sf->size());
+      std::shared_ptr<summary_view_transformation> summary_view_transformers = std::make_shared<summary_view_transformation>(column_transformers, column_names, column_types, gl_sf);
       std::string summary_view_vega_spec  = summary_view_spec(column_transformers.size());
 
       std::shared_ptr<transformation_base> shared_unity_transformer = std::static_pointer_cast<transformation_base>(summary_view_transformers);
@@ -14,13 +14,17 @@
 #include <visualization/server/batch_size.hpp>
 #include <visualization/server/transformation.hpp>
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <limits>
 #include <thread>
 
 using namespace turi;
 using namespace turi::visualization;
 
 constexpr static size_t NUM_BINS = 60;
+constexpr static size_t POINT_BLOCK_SIZE = 4096;
 static const std::string x_name = "x";
 static const std::string y_name = "y";
 
@@ -80,6 +84,21 @@ void heatmap::init(const gl_sframe& source, size_t batch_size) {
   const auto& x = head[x_name];
   const auto& y = head[y_name];
   m_transformer->init(x.min(), x.max(), y.min(), y.max());
+
+  m_x_reader = source[x_name].materialize_to_sarray()->get_reader();
+  m_y_reader = source[y_name].materialize_to_sarray()->get_reader();
+}
+
+void heatmap::process_range(heatmap_result& result,
+                            size_t begin, size_t end) const {
+  std::vector<double> xs(std::min(POINT_BLOCK_SIZE, end - begin));
+  std::vector<double> ys(xs.size());
+  for (size_t row = begin; row < end; row += POINT_BLOCK_SIZE) {
+    size_t n = std::min(POINT_BLOCK_SIZE, end - row);
+    m_x_reader->read_rows_as(row, row + n, xs.data(), NAN);
+    m_y_reader->read_rows_as(row, row + n, ys.data(), NAN);
+    result.add_points(xs.data(), ys.data(), n);
+  }
 }
 
 std::vector<heatmap_result> heatmap::split_input(size_t num_threads) {
@@ -94,25 +113,6 @@ std::vector<heatmap_result> heatmap::split_input(size_t num_threads) {
   return ret;
 }
 
-static inline size_t get_bin_idx(
-  flex_float value,
-  flex_float min,
-  flex_float max
-) {
-  size_t ret = static_cast<size_t>(
-    std::floor(
-      (static_cast<double>(value - min) /
-       static_cast<double>(max - min)) *
-      static_cast<double>(NUM_BINS)
-    )
-  );
-  if (ret == NUM_BINS) {
-    ret--;
-  }
-  DASSERT_LT(ret, NUM_BINS);
-  return ret;
-}
-
 group_aggregate_value* heatmap_result::new_instance() const {
   heatmap_result* ret = new heatmap_result;
   ret->extrema = extrema; // initialize with the same extrema
@@ -202,12 +202,67 @@ void heatmap_result::widen_y(double value) {
   }
 }
 
+// Bin index of each value along one axis, clamped to the bins. The loop has
+// no branches, so that it vectorizes.
+static void get_bin_indices(const double* values, size_t n,
+                            double min, double max, int32_t* out) {
+  const double range = max - min;
+  const double last_bin = static_cast<double>(NUM_BINS - 1);
+  for (size_t i = 0; i < n; i++) {
+    double t = ((values[i] - min) / range) * static_cast<double>(NUM_BINS);
+    t = (t >= 0.0) ? t : 0.0; // also maps NaN (empty range) to the first bin
+    t = (t < last_bin) ? t : last_bin;
+    out[i] = static_cast<int32_t>(t);
+  }
+}
+
+void heatmap_result::add_points(const double* xs, const double* ys, size_t n) {
+  // bounds of the finite points, to widen the bins once for the whole block
+  std::vector<uint8_t> valid(n);
+  double x_min = std::numeric_limits<double>::infinity();
+  double x_max = -x_min;
+  double y_min = x_min;
+  double y_max = -x_min;
+  size_t num_valid = 0;
+  for (size_t i = 0; i < n; i++) {
+    // x - x is 0 unless x is infinite or NaN
+    bool ok = (xs[i] - xs[i] == 0.0) && (ys[i] - ys[i] == 0.0);
+    valid[i] = ok;
+    num_valid += ok;
+    if (ok) {
+      x_min = std::min(x_min, xs[i]);
+      x_max = std::max(x_max, xs[i]);
+      y_min = std::min(y_min, ys[i]);
+      y_max = std::max(y_max, ys[i]);
+    }
+  }
+  if (num_valid == 0) {
+    return;
+  }
+
+  widen_x(x_min);
+  widen_x(x_max);
+  widen_y(y_min);
+  widen_y(y_max);
+
+  std::vector<int32_t> x_idx(n);
+  std::vector<int32_t> y_idx(n);
+  get_bin_indices(xs, n, extrema.x.get_min(), extrema.x.get_max(), x_idx.data());
+  get_bin_indices(ys, n, extrema.y.get_min(), extrema.y.get_max(), y_idx.data());
+
+  for (size_t i = 0; i < n; i++) {
+    if (valid[i]) {
+      bins[x_idx[i]][y_idx[i]]++;
+    }
+  }
+}
+
 void heatmap_result::add_element_simple(const flexible_type& flex) {
   // expect [x,y] input as float (in flex_list form).
-  flex_list asList = flex.get<flex_list>();
+  const flex_list& asList = flex.get<flex_list>();
   DASSERT_EQ(asList.size(), 2);
-  flexible_type xFlex = asList[0];
-  flexible_type yFlex = asList[1];
+  const flexible_type& xFlex = asList[0];
+  const flexible_type& yFlex = asList[1];
   flex_float x, y;
   switch (xFlex.get_type()) {
     case flex_type_enum::FLOAT:
@@ -230,16 +285,7 @@ void heatmap_result::add_element_simple(const flexible_type& flex) {
       throw std::runtime_error("Expected X axis to be int or float in heatmap.");
   }
 
-  // first, check extrema, resize if needed
-  widen_x(x);
-  widen_y(y);
-
-  // now that the value will fit, determine bin index on both axes
-  size_t x_idx = get_bin_idx(x, extrema.x.get_min(), extrema.x.get_max());
-  size_t y_idx = get_bin_idx(y, extrema.y.get_min(), extrema.y.get_max());
-
-  // and finally increment the count
-  bins[x_idx][y_idx]++;
+  add_points(&x, &y, 1);
 }
 
 void heatmap_result::combine(const group_aggregate_value& generic_other) {
@@ -8,6 +8,7 @@
 #define __TC_VIS_HEATMAP
 
 #include <core/data/sframe/gl_sframe.hpp>
+#include <core/storage/sframe_data/sarray.hpp>
 
 #include "extrema.hpp"
 #include "groupby.hpp"
@@ -31,6 +32,10 @@ namespace visualization {
       heatmap_result();
       void init(double xMin, double xMax, double yMin, double yMax);
 
+      // bins n points at once; points with a missing or non-finite
+      // coordinate are skipped
+      void add_points(const double* xs, const double* ys, size_t n);
+
       // group_aggregate_value methods
       virtual group_aggregate_value* new_instance() const override;
       virtual void add_element_simple(const flexible_type& flex) override;
@@ -54,11 +59,22 @@ namespace visualization {
    *
    * dtype of sarrays can be flex_int or flex_float
    * Heatmap always gives bins as flex_ints (bin counts are positive integers).
+   *
+   * The x and y columns are read as blocks of doubles, without going through
+   * flexible_type, and each thread bins its blocks into its own grid.
    */
   class heatmap : public groupby<heatmap_result> {
     public:
       virtual void init(const gl_sframe& source, size_t batch_size) override;
       virtual std::vector<heatmap_result> split_input(size_t num_threads) override;
+
+    protected:
+      virtual void process_range(heatmap_result& result,
+                                 size_t begin, size_t end) const override;
+
+    private:
+      std::shared_ptr<sarray_reader<flexible_type>> m_x_reader;
+      std::shared_ptr<sarray_reader<flexible_type>> m_y_reader;
   };
 
   std::shared_ptr<Plot> plot_heatmap(
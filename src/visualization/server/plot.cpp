@@ -71,7 +71,7 @@ namespace turi{
           double num_rows_processed =  static_cast<double>(self->m_transformer->get_rows_processed());
           double percent_complete = num_rows_processed/self->m_size_array;
 
-          ew << "{\"data_spec\": " << vd.get_data_spec(percent_complete) << "}\n";
+          ew << "{\"data_spec\": " << vd.get_data_spec(percent_complete, self->m_transformer->vega_sample_data()) << "}\n";
         }
       });
     }
@@ -105,7 +105,7 @@ namespace turi{
       }
       vega_data vd;
       vd << m_transformer->get()->vega_column_data();
-      return vd.get_data_spec(get_percent_complete());
+      return vd.get_data_spec(get_percent_complete(), m_transformer->vega_sample_data());
     }
 
     std::string Plot::get_data() const {
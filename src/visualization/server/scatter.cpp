@@ -10,6 +10,9 @@
 #include "vega_data.hpp"
 #include "vega_spec.hpp"
 
+#include <core/storage/sframe_data/sarray.hpp>
+
+#include <algorithm>
 #include <cmath>
 #include <thread>
 
@@ -53,34 +56,46 @@ size_t scatter::get_batch_size() const{
   return m_sf.size();
 }
 
+static bool is_plottable(const flexible_type& ft) {
+  switch (ft.get_type()) {
+    case flex_type_enum::INTEGER:
+      return true;
+    case flex_type_enum::FLOAT:
+      return std::isfinite(ft.get<flex_float>());
+    default:
+      return false;
+  }
+}
+
 std::string scatter_result::vega_column_data(bool sframe) const {
     std::stringstream ss;
     size_t x = 0;
     size_t size_list = m_sf.size();
 
-    for (size_t i=0; i < size_list; i++) {
+    // read both columns sequentially in chunks, rather than row by row
+    constexpr size_t CHUNK_SIZE = 4096;
+    auto x_reader = m_sf["x"].materialize_to_sarray()->get_reader();
+    auto y_reader = m_sf["y"].materialize_to_sarray()->get_reader();
+    std::vector<flexible_type> xs, ys;
 
-      if (m_sf["x"][i].get_type() == flex_type_enum::UNDEFINED ||
-          m_sf["y"][i].get_type() == flex_type_enum::UNDEFINED) {
-        continue;
-      }
+    for (size_t start = 0; start < size_list; start += CHUNK_SIZE) {
+      size_t end = std::min(start + CHUNK_SIZE, size_list);
+      x_reader->read_rows(start, end, xs);
+      y_reader->read_rows(start, end, ys);
 
-      if (m_sf["x"][i].get_type() == flex_type_enum::FLOAT &&
-          !std::isfinite(m_sf["x"][i].get<flex_float>())) {
-        continue;
-      }
-      if (m_sf["y"][i].get_type() == flex_type_enum::FLOAT &&
-          !std::isfinite(m_sf["y"][i].get<flex_float>())) {
-        continue;
-      }
+      for (size_t i = 0; i < xs.size(); i++) {
+        if (!is_plottable(xs[i]) || !is_plottable(ys[i])) {
+          continue;
+        }
 
-      if(x !=  0){
-        ss << ",";
-      }
+        if(x !=  0){
+          ss << ",";
+        }
 
-      ss << "{\"x\": " + to_string(m_sf["x"][i]) + ", \"y\": " + to_string(m_sf["y"][i]) + "}";
+        ss << "{\"x\": " << to_string(xs[i]) << ", \"y\": " << to_string(ys[i]) << "}";
 
-      x++;
+        x++;
+      }
     }
 
     return ss.str();
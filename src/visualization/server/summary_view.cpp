@@ -4,6 +4,7 @@
 #include <visualization/server/vega_data.hpp>
 #include <visualization/server/vega_spec.hpp>
 #include <math.h>
+#include <algorithm>
 
 using namespace turi;
 using namespace turi::visualization;
@@ -41,8 +42,8 @@ std::string summary_view_transformation_output::vega_column_data(bool sframe) co
   return ss.str();
 }
 
-summary_view_transformation::summary_view_transformation(const std::vector<std::shared_ptr<transformation_base>>& transformers, std::vector<std::string> column_names, std::vector<flex_type_enum> column_types, size_t size)
-  : m_transformers(transformers),  m_column_names(column_names), m_column_types(column_types), m_size(size) {
+summary_view_transformation::summary_view_transformation(const std::vector<std::shared_ptr<transformation_base>>& transformers, std::vector<std::string> column_names, std::vector<flex_type_enum> column_types, const gl_sframe& source)
+  : m_transformers(transformers), m_source(source), m_column_names(column_names), m_column_types(column_types), m_size(source.size()) {
     // 0. Transformers, column_names, and column_types must all be the same length
     // (number of SArray columns to show)
     DASSERT_EQ(transformers.size(), column_names.size());
@@ -58,14 +59,40 @@ summary_view_transformation::summary_view_transformation(const std::vector<std::
         throw std::runtime_error("All transformers being fused must have the same batch size.");
       }
     }
+    // 3. Source must have one column per transformer
+    if (source.num_columns() != transformers.size()) {
+      throw std::runtime_error("Expected one source column per transformer when fusing transformers.");
+    }
 }
 
 std::shared_ptr<transformation_output> summary_view_transformation::get() {
-  std::vector<std::shared_ptr<transformation_output>> outputs;
-  for (size_t i=0; i<m_transformers.size(); i++) {
-    outputs.push_back(m_transformers[i]->get());
+  if (m_rows_processed < m_size) {
+    const size_t start = m_rows_processed;
+    const size_t input_size = std::min(get_batch_size(), m_size - start);
+    const size_t num_columns = m_transformers.size();
+
+    for (auto& transformer : m_transformers) {
+      transformer->start_batch(thread_pool::get_instance().size());
+    }
+
+    // read every row once, and hand each value to its column
+    in_parallel([&](size_t thread_idx, size_t num_threads) {
+      size_t thread_start = start + input_size * thread_idx / num_threads;
+      size_t thread_end = start + input_size * (thread_idx + 1) / num_threads;
+      for (const auto& row : m_source.range_iterator(thread_start, thread_end)) {
+        for (size_t c = 0; c < num_columns; c++) {
+          m_transformers[c]->add_value(thread_idx, row[c]);
+        }
+      }
+    });
+
+    m_outputs.clear();
+    for (auto& transformer : m_transformers) {
+      m_outputs.push_back(transformer->finish_batch(input_size));
+    }
+    m_rows_processed += input_size;
   }
-  return std::make_shared<summary_view_transformation_output>(summary_view_transformation_output(outputs, m_column_names, m_column_types, m_size));
+  return std::make_shared<summary_view_transformation_output>(summary_view_transformation_output(m_outputs, m_column_names, m_column_types, m_size));
 }
 
 bool summary_view_transformation::eof() const {
@@ -2,6 +2,7 @@
 #define _TC_SUMMARY_VIEW
 
 #include <core/data/flexible_type/flexible_type.hpp>
+#include <core/data/sframe/gl_sframe.hpp>
 #include <core/parallel/lambda_omp.hpp>
 
 #include "transformation.hpp"
@@ -21,16 +22,26 @@ class summary_view_transformation_output : public transformation_output {
     virtual std::string vega_column_data(bool sframe = false) const override;
 };
 
+/*
+ * Summarizes every column of an SFrame in a single pass: each batch of rows
+ * is read once, all columns together, in parallel over row ranges, and each
+ * value is fed to the transformation of its column (see
+ * transformation_base::start_batch()). The transformations must be
+ * initialized over the columns of source, in order.
+ */
 class summary_view_transformation : public transformation_base {
   private:
     std::vector<std::shared_ptr<transformation_base>> m_transformers;
+    gl_sframe m_source;
+    size_t m_rows_processed = 0;
+    std::vector<std::shared_ptr<transformation_output>> m_outputs;
 
   public:
     std::vector<std::string> m_column_names;
     std::vector<flex_type_enum> m_column_types;
     size_t m_size;
 
-    summary_view_transformation(const std::vector<std::shared_ptr<transformation_base>>& transformers, std::vector<std::string> column_names, std::vector<flex_type_enum> column_types, size_t size);
+    summary_view_transformation(const std::vector<std::shared_ptr<transformation_base>>& transformers, std::vector<std::string> column_names, std::vector<flex_type_enum> column_types, const gl_sframe& source);
 
     virtual std::shared_ptr<transformation_output> get() override;
     virtual bool eof() const override;
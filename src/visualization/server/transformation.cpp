@@ -5,6 +5,9 @@
  */
 #include "transformation.hpp"
 
+#include <cmath>
+#include <sstream>
+
 namespace turi {
 namespace visualization {
 
@@ -16,4 +19,35 @@ double transformation_base::get_percent_complete() const {
   return ret;
 }
 
+std::string transformation_base::vega_sample_data() const {
+  // Rows read in order are not a sample; only complete results are exact.
+  bool complete = eof();
+  std::stringstream ss;
+  ss << "{\"sampled\": false";
+  ss << ", \"rows\": " << get_rows_processed();
+  ss << ", \"total_rows\": " << get_total_rows();
+  ss << ", \"margin_of_error\": " << (complete ? "0" : "null") << "}";
+  return ss.str();
+}
+
+void transformation_base::start_batch(size_t) {
+  log_and_throw("This transformation cannot be fed values directly.");
+}
+
+void transformation_base::add_value(size_t, const flexible_type&) {
+  log_and_throw("This transformation cannot be fed values directly.");
+}
+
+std::shared_ptr<transformation_output> transformation_base::finish_batch(size_t) {
+  log_and_throw("This transformation cannot be fed values directly.");
+}
+
+double sample_margin_of_error(size_t blocks_processed, size_t total_blocks) {
+  if (blocks_processed == 0) return 1.0;
+  if (blocks_processed >= total_blocks) return 0.0;
+  double b = static_cast<double>(blocks_processed);
+  double fpc = 1.0 - b / static_cast<double>(total_blocks);
+  return 1.96 * std::sqrt(0.25 / b * fpc);
+}
+
 }} // turi::visualization
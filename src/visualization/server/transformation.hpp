@@ -8,10 +8,31 @@
 
 #include <core/data/flexible_type/flexible_type.hpp>
 #include <core/parallel/lambda_omp.hpp>
+#include <core/random/random.hpp>
+
+#include <numeric>
+#include <sstream>
 
 namespace turi {
 namespace visualization {
 
+/* Rows per block when the rows are read in random block order. */
+constexpr size_t SAMPLE_BLOCK_SIZE = 8192;
+
+/* Rows in the first batch read in random block order, kept small so the
+ * first (representative) result comes back quickly. */
+constexpr size_t FIRST_SAMPLE_BATCH_SIZE = 500000;
+
+/*
+ * Half width of the 95% confidence interval of the fraction of rows in any
+ * category (a histogram bin, a frequent item, ...), estimated from the rows
+ * of a random subset of equally sized blocks. Blocks rather than rows are the
+ * sampling unit, since rows of a block are not independent; the bound holds
+ * for the worst case variance of the block fractions (1/4), with the finite
+ * population correction.
+ */
+double sample_margin_of_error(size_t blocks_processed, size_t total_blocks);
+
 class transformation_output {
   public:
     virtual ~transformation_output() = default;
@@ -32,6 +53,23 @@ class transformation_base {
     virtual size_t get_batch_size() const = 0;
     virtual flex_int get_total_rows() const = 0;
     virtual flex_int get_rows_processed() const = 0;
+
+    /* JSON object describing the rows processed so far, published with the
+     * Vega data: whether they are a random sample, how many, and for a
+     * sample, the margin of error of the fractions computed from them. */
+    virtual std::string vega_sample_data() const;
+
+    /*
+     * Fused streaming, for a caller that reads the rows itself and feeds
+     * several transformations from the same pass (see summary_view).
+     * start_batch() makes one partial result per thread, add_value() adds a
+     * value of the source to the partial result of a thread, and
+     * finish_batch() merges the partial results, counts num_rows more rows
+     * as processed and returns the current result.
+     */
+    virtual void start_batch(size_t num_threads);
+    virtual void add_value(size_t thread_idx, const flexible_type& value);
+    virtual std::shared_ptr<transformation_output> finish_batch(size_t num_rows);
 };
 
 class transformation_collection : public std::vector<std::shared_ptr<transformation_base>> {
@@ -50,6 +88,14 @@ class transformation : public transformation_base {
     size_t m_currentIdx = 0;
     bool m_initialized = false;
 
+    // Random block order: the rows of block m_block_order[i] are the rows
+    // [m_block_order[i] * SAMPLE_BLOCK_SIZE, ...) of the source, and blocks
+    // before m_next_block are done. Empty when reading the rows in order.
+    bool m_random_block_order = true;
+    size_t m_sample_seed = 0;
+    std::vector<size_t> m_block_order;
+    size_t m_next_block = 0;
+
   private:
     void check_init(const char * msg, bool initialized) const {
       if (initialized != m_initialized) {
@@ -72,14 +118,49 @@ class transformation : public transformation_base {
     }
     /* Merge multiple transformers into output */
     virtual void merge_results(std::vector<Output>& transformers) = 0;
+    /* Add the rows [begin, end) of the source to a transformer. Called in
+     * parallel, each thread with its own transformer. */
+    virtual void process_range(Output& transformer, size_t begin, size_t end) const {
+      for (const auto& value : m_source.range_iterator(begin, end)) {
+        transformer.add_element_simple(value);
+      }
+    }
+
+    /* Number of rows of a block of the random block order. */
+    size_t block_rows(size_t block) const {
+      return std::min(SAMPLE_BLOCK_SIZE,
+                      m_source.size() - block * SAMPLE_BLOCK_SIZE);
+    }
 
   public:
+    /*
+     * Whether to read the rows in a random block order, shuffled with the
+     * given seed, when the source takes more than one batch (the default).
+     * Partial results then come from a random sample of the rows. Must be
+     * called before init().
+     */
+    void set_random_block_order(bool enabled, size_t seed = 0) {
+      check_init("Block order must be set before the transformer is initialized.", false);
+      m_random_block_order = enabled;
+      m_sample_seed = seed;
+    }
+
     virtual void init(const InputIterable& source, size_t batch_size) {
       check_init("Transformer is already initialized.", false);
       m_batch_size = batch_size;
       m_source = source;
       m_transformer = std::make_shared<Output>();
       m_currentIdx = 0;
+      m_next_block = 0;
+      m_block_order.clear();
+      if (m_random_block_order && m_source.size() > m_batch_size) {
+        size_t num_blocks = (m_source.size() + SAMPLE_BLOCK_SIZE - 1) / SAMPLE_BLOCK_SIZE;
+        m_block_order.resize(num_blocks);
+        std::iota(m_block_order.begin(), m_block_order.end(), 0);
+        random::generator gen;
+        gen.seed(m_sample_seed);
+        gen.shuffle(m_block_order);
+      }
       m_initialized = true;
     }
     virtual bool eof() const override {
@@ -103,14 +184,28 @@ class transformation : public transformation_base {
         return m_transformer;
       }
 
+      // The row ranges of this batch: the next rows in order, or the next
+      // blocks of the random block order.
+      std::vector<std::pair<size_t, size_t>> ranges;
+      size_t input_size = 0;
+      if (m_block_order.empty()) {
+        input_size = std::min(m_batch_size, m_source.size() - m_currentIdx);
+        ranges.emplace_back(m_currentIdx, m_currentIdx + input_size);
+      } else {
+        size_t target = m_batch_size;
+        if (m_currentIdx == 0) target = std::min(target, FIRST_SAMPLE_BATCH_SIZE);
+        while (m_next_block < m_block_order.size() && input_size < target) {
+          size_t block = m_block_order[m_next_block++];
+          size_t block_start = block * SAMPLE_BLOCK_SIZE;
+          ranges.emplace_back(block_start, block_start + block_rows(block));
+          input_size += ranges.back().second - ranges.back().first;
+        }
+      }
+
       const size_t num_threads_reported = thread_pool::get_instance().size();
-      const size_t start = m_currentIdx;
-      const size_t input_size = std::min(m_batch_size, m_source.size() - m_currentIdx);
-      const size_t end = start + input_size;
       auto transformers = this->split_input(num_threads_reported);
-      const auto& source = this->m_source;
       in_parallel(
-        [&transformers, &source, input_size, start]
+        [this, &transformers, &ranges, input_size]
         (size_t thread_idx, size_t num_threads) {
 
         DASSERT_LE(transformers.size(), num_threads);
@@ -120,27 +215,71 @@ class transformation : public transformation_base {
           return;
         }
 
+        // this thread takes the rows [thread_start, thread_end) of the
+        // ranges laid end to end
         auto& transformer = transformers[thread_idx];
-        size_t thread_input_size = input_size / transformers.size();
-        size_t thread_start = start + (thread_idx * thread_input_size);
-        size_t thread_end = thread_idx == transformers.size() - 1 ?
-          start + input_size :
-          thread_start + thread_input_size;
-        DASSERT_LE(thread_end, start + input_size);
-        for (const auto& value : source.range_iterator(thread_start, thread_end)) {
-          transformer.add_element_simple(value);
+        size_t thread_start = input_size * thread_idx / transformers.size();
+        size_t thread_end = input_size * (thread_idx + 1) / transformers.size();
+        size_t offset = 0;
+        for (const auto& range : ranges) {
+          size_t range_size = range.second - range.first;
+          size_t begin = std::max(thread_start, offset);
+          size_t end = std::min(thread_end, offset + range_size);
+          if (begin < end) {
+            this->process_range(transformer, range.first + begin - offset,
+                                range.first + end - offset);
+          }
+          offset += range_size;
+          if (offset >= thread_end) break;
         }
       });
 
       this->merge_results(transformers);
-      m_currentIdx = end;
+      m_currentIdx += input_size;
 
       return m_transformer;
     }
 
+    virtual std::string vega_sample_data() const override {
+      require_init();
+      if (m_block_order.empty() || this->eof()) {
+        return transformation_base::vega_sample_data();
+      }
+      std::stringstream ss;
+      ss << "{\"sampled\": true";
+      ss << ", \"rows\": " << m_currentIdx;
+      ss << ", \"total_rows\": " << m_source.size();
+      ss << ", \"margin_of_error\": "
+         << sample_margin_of_error(m_next_block, m_block_order.size()) << "}";
+      return ss.str();
+    }
+
     virtual size_t get_batch_size() const override {
       return m_batch_size;
     }
+
+    virtual void start_batch(size_t num_threads) override {
+      require_init();
+      m_pending = this->split_input(num_threads);
+    }
+
+    virtual void add_value(size_t thread_idx, const flexible_type& value) override {
+      DASSERT_LT(thread_idx, m_pending.size());
+      m_pending[thread_idx].add_element_simple(value);
+    }
+
+    virtual std::shared_ptr<transformation_output> finish_batch(size_t num_rows) override {
+      require_init();
+      this->merge_results(m_pending);
+      m_pending.clear();
+      m_currentIdx += num_rows;
+      DASSERT_LE(m_currentIdx, m_source.size());
+      return m_transformer;
+    }
+
+  private:
+    // partial results of the batch fed by add_value()
+    std::vector<Output> m_pending;
 };
 
 }}
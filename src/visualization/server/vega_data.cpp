@@ -20,6 +20,12 @@ std::string vega_data::get_data_spec(double progress) {
   return m_spec.str();
 }
 
+std::string vega_data::get_data_spec(double progress, const std::string& sample) {
+  m_spec << "], \"progress\": "+std::to_string(progress);
+  m_spec << ", \"sample\": " << sample << " }";
+  return m_spec.str();
+}
+
 vega_data& vega_data::operator<<(const std::string& vega_string) {
   if (!m_has_spec) {
     m_spec << vega_string;
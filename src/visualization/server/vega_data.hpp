@@ -27,6 +27,10 @@ namespace turi {
 
         virtual vega_data& operator<<(const std::string&);
         virtual std::string get_data_spec(double progress);
+
+        // Also publish how the rows processed so far were sampled
+        // (see transformation_base::vega_sample_data).
+        virtual std::string get_data_spec(double progress, const std::string& sample);
     };
   }
 }
@@ -0,0 +1,427 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at
+ * https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/random/random.hpp>
+#include <core/storage/serialization/serialization_includes.hpp>
+#include <timer/timer.hpp>
+
+using namespace turi;
+
+namespace {
+
+/*
+ * Times the basic operations of flexible_type, per type: construction and
+ * destruction, copies, operator<, hash(), conversion to string,
+ * serialization through oarchive and iarchive, and arithmetic.
+ *
+ * usage: flexible_type_bench [options]
+ *   --filter=hash            only run the cases whose name contains this
+ *   --quick                  shorter runs, for the threshold check
+ *   --check                  fail if a case is slower than its threshold
+ *   --output=results.json    where to write the results
+ *
+ * Times are in nanoseconds per operation, the minimum over several runs.
+ * The thresholds are not absolute times, which depend on the machine and
+ * the build type, but multiples of a reference operation timed in the same
+ * run: constructing and destroying a std::vector<double> of 8 elements (one
+ * allocation). They leave three times the headroom of a release build, so
+ * that the check only fails when dispatching on the type regresses badly
+ * (for instance, an operation falling back to a generic path which converts
+ * or allocates).
+ *
+ * The check runs as the flexible_type_bench_thresholds test of release
+ * builds. Debug builds are slower relative to the allocator, and are not
+ * checked.
+ */
+
+const size_t POOL_SIZE = 1024;
+
+/**
+ * A case times num_ops operations and returns a value depending on all of
+ * them, so that the compiler cannot drop them.
+ */
+typedef std::function<size_t(size_t num_ops)> bench_function;
+
+struct bench_case {
+  std::string name;
+  bench_function run;
+  // The slowest acceptable time, in multiples of the reference operation.
+  // 0 for no threshold.
+  double max_reference_ratio;
+};
+
+struct bench_result {
+  std::string name;
+  double ns_per_op;
+  double reference_ratio;
+  double max_reference_ratio;
+
+  bool passed() const {
+    return max_reference_ratio == 0 || reference_ratio <= max_reference_ratio;
+  }
+};
+
+/// Values of every benchmarked type, made once with a fixed seed.
+struct value_pools {
+  std::map<std::string, std::vector<flexible_type>> values;
+  std::vector<flex_int> ints;
+  std::vector<flex_float> floats;
+  std::vector<flex_string> strings;
+  std::vector<flex_vec> vectors;
+
+  value_pools() {
+    random::seed(1234);
+    for (size_t i = 0; i < POOL_SIZE; ++i) {
+      ints.push_back(random::fast_uniform<flex_int>(-1000000, 1000000));
+      floats.push_back(random::fast_uniform<double>(-1e6, 1e6));
+      std::string s;
+      for (size_t j = 0; j < 16; ++j) s += char('a' + random::fast_uniform<int>(0, 25));
+      strings.push_back(s);
+      flex_vec v(16);
+      for (auto& x : v) x = random::fast_uniform<double>(0, 1);
+      vectors.push_back(v);
+
+      values["integer"].push_back(ints.back());
+      values["float"].push_back(floats.back());
+      values["string"].push_back(strings.back());
+      values["vector"].push_back(vectors.back());
+      values["list"].push_back(flex_list{ints.back(), strings.back(), floats.back()});
+      values["dict"].push_back(flex_dict{{strings.back(), ints.back()},
+                                         {"key", floats.back()}});
+      values["datetime"].push_back(flex_date_time(ints.back() * 1000, 0, 12345));
+      values["undefined"].push_back(FLEX_UNDEFINED);
+    }
+  }
+};
+
+const value_pools& pools() {
+  static value_pools* p = new value_pools;
+  return *p;
+}
+
+const std::vector<std::string> ALL_TYPES =
+    {"integer", "float", "string", "vector", "list", "dict", "datetime", "undefined"};
+
+// Types with a total order under operator<.
+const std::vector<std::string> ORDERED_TYPES = {"integer", "float", "string", "datetime"};
+
+/**
+ * The thresholds, in multiples of the reference operation, by case: three
+ * times what a release build measured, rounded up. Cases not listed are
+ * timed but not checked.
+ */
+const std::map<std::string, double> THRESHOLDS = {
+  {"construct/integer", 2}, {"construct/float", 3},
+  {"construct/string", 8}, {"construct/vector", 8},
+
+  {"copy/integer", 2}, {"copy/float", 2}, {"copy/string", 6}, {"copy/vector", 6},
+  {"copy/list", 6}, {"copy/dict", 6}, {"copy/datetime", 2}, {"copy/undefined", 2},
+
+  {"less/integer", 1.5}, {"less/float", 2}, {"less/string", 3},
+  {"less/datetime", 1.5}, {"less/integer_float", 2},
+
+  {"hash/integer", 1}, {"hash/float", 1}, {"hash/string", 1.5}, {"hash/vector", 4},
+  {"hash/list", 6}, {"hash/dict", 8}, {"hash/datetime", 2}, {"hash/undefined", 1},
+
+  {"to_string/integer", 96}, {"to_string/float", 128}, {"to_string/string", 6},
+  {"to_string/vector", 1024}, {"to_string/list", 384}, {"to_string/dict", 384},
+  {"to_string/datetime", 256}, {"to_string/undefined", 1},
+
+  {"serialize/integer", 1}, {"serialize/float", 1}, {"serialize/string", 2},
+  {"serialize/vector", 3}, {"serialize/list", 8}, {"serialize/dict", 8},
+  {"serialize/datetime", 1}, {"serialize/undefined", 1},
+
+  {"deserialize/integer", 1.5}, {"deserialize/float", 1.5},
+  {"deserialize/string", 12}, {"deserialize/vector", 8},
+  {"deserialize/list", 32}, {"deserialize/dict", 48},
+  {"deserialize/datetime", 2}, {"deserialize/undefined", 1.5},
+
+  {"arithmetic/add_integer", 1.5}, {"arithmetic/add_float", 2},
+  {"arithmetic/add_integer_float", 2}, {"arithmetic/multiply_float", 3},
+  {"arithmetic/add_vector_scalar", 4},
+};
+
+double threshold(const std::string& name) {
+  auto it = THRESHOLDS.find(name);
+  return it == THRESHOLDS.end() ? 0 : it->second;
+}
+
+std::vector<bench_case> make_cases() {
+  std::vector<bench_case> cases;
+  auto add = [&](const std::string& name, bench_function run) {
+    cases.push_back({name, run, threshold(name)});
+  };
+
+  // construction from the native values, and destruction
+  add("construct/integer", [](size_t n) {
+    size_t ret = 0;
+    for (size_t i = 0; i < n; ++i) {
+      flexible_type f(pools().ints[i % POOL_SIZE]);
+      ret += f.get<flex_int>();
+    }
+    return ret;
+  });
+  add("construct/float", [](size_t n) {
+    size_t ret = 0;
+    for (size_t i = 0; i < n; ++i) {
+      flexible_type f(pools().floats[i % POOL_SIZE]);
+      ret += f.get<flex_float>() > 0;
+    }
+    return ret;
+  });
+  add("construct/string", [](size_t n) {
+    size_t ret = 0;
+    for (size_t i = 0; i < n; ++i) {
+      flexible_type f(pools().strings[i % POOL_SIZE]);
+      ret += f.get<flex_string>().size();
+    }
+    return ret;
+  });
+  add("construct/vector", [](size_t n) {
+    size_t ret = 0;
+    for (size_t i = 0; i < n; ++i) {
+      flexible_type f(pools().vectors[i % POOL_SIZE]);
+      ret += f.get<flex_vec>().size();
+    }
+    return ret;
+  });
+
+  for (const auto& type : ALL_TYPES) {
+    const std::vector<flexible_type>* values = &pools().values.at(type);
+
+    add("copy/" + type, [values](size_t n) {
+      size_t ret = 0;
+      for (size_t i = 0; i < n; ++i) {
+        flexible_type f((*values)[i % POOL_SIZE]);
+        ret += size_t(f.get_type());
+      }
+      return ret;
+    });
+
+    add("hash/" + type, [values](size_t n) {
+      size_t ret = 0;
+      for (size_t i = 0; i < n; ++i) ret += (*values)[i % POOL_SIZE].hash();
+      return ret;
+    });
+
+    add("to_string/" + type, [values](size_t n) {
+      size_t ret = 0;
+      for (size_t i = 0; i < n; ++i) ret += (*values)[i % POOL_SIZE].to<flex_string>().size();
+      return ret;
+    });
+
+    add("serialize/" + type, [values](size_t n) {
+      oarchive oarc;
+      size_t ret = 0;
+      for (size_t i = 0; i < n; ++i) {
+        if (i % POOL_SIZE == 0) {
+          ret += oarc.off;
+          oarc.off = 0;
+        }
+        oarc << (*values)[i % POOL_SIZE];
+      }
+      ret += oarc.off;
+      free(oarc.buf);
+      return ret;
+    });
+
+    // the pool serialized once, and read back over and over
+    std::shared_ptr<std::vector<char>> serialized = std::make_shared<std::vector<char>>();
+    {
+      oarchive oarc(*serialized);
+      for (const auto& v : *values) oarc << v;
+      serialized->resize(oarc.off);
+    }
+    add("deserialize/" + type, [serialized](size_t n) {
+      size_t ret = 0;
+      flexible_type f;
+      for (size_t done = 0; done < n; ) {
+        iarchive iarc(serialized->data(), serialized->size());
+        for (size_t i = 0; i < POOL_SIZE && done < n; ++i, ++done) {
+          iarc >> f;
+          ret += size_t(f.get_type());
+        }
+      }
+      return ret;
+    });
+  }
+
+  for (const auto& type : ORDERED_TYPES) {
+    const std::vector<flexible_type>* values = &pools().values.at(type);
+    add("less/" + type, [values](size_t n) {
+      size_t ret = 0;
+      for (size_t i = 0; i < n; ++i) {
+        ret += (*values)[i % POOL_SIZE] < (*values)[(i + 1) % POOL_SIZE];
+      }
+      return ret;
+    });
+  }
+  add("less/integer_float", [](size_t n) {
+    const auto& ints = pools().values.at("integer");
+    const auto& floats = pools().values.at("float");
+    size_t ret = 0;
+    for (size_t i = 0; i < n; ++i) ret += ints[i % POOL_SIZE] < floats[i % POOL_SIZE];
+    return ret;
+  });
+
+  add("arithmetic/add_integer", [](size_t n) {
+    const auto& ints = pools().values.at("integer");
+    flexible_type acc(flex_int(0));
+    for (size_t i = 0; i < n; ++i) acc += ints[i % POOL_SIZE];
+    return size_t(acc.get<flex_int>());
+  });
+  add("arithmetic/add_float", [](size_t n) {
+    const auto& floats = pools().values.at("float");
+    flexible_type acc(flex_float(0));
+    for (size_t i = 0; i < n; ++i) acc += floats[i % POOL_SIZE];
+    return size_t(acc.get<flex_float>() != 0);
+  });
+  add("arithmetic/add_integer_float", [](size_t n) {
+    const auto& ints = pools().values.at("integer");
+    flexible_type acc(flex_float(0));
+    for (size_t i = 0; i < n; ++i) acc += ints[i % POOL_SIZE];
+    return size_t(acc.get<flex_float>() != 0);
+  });
+  add("arithmetic/multiply_float", [](size_t n) {
+    const auto& floats = pools().values.at("float");
+    size_t ret = 0;
+    for (size_t i = 0; i < n; ++i) {
+      flexible_type p = floats[i % POOL_SIZE] * floats[(i + 1) % POOL_SIZE];
+      ret += p.get<flex_float>() > 0;
+    }
+    return ret;
+  });
+  add("arithmetic/add_vector_scalar", [](size_t n) {
+    flexible_type acc(flex_vec(16, 0.0));
+    flexible_type one(1.0);
+    for (size_t i = 0; i < n; ++i) acc += one;
+    return size_t(acc.get<flex_vec>()[0]);
+  });
+
+  return cases;
+}
+
+/// The reference operation the thresholds are relative to.
+size_t reference_operation(size_t n) {
+  size_t ret = 0;
+  for (size_t i = 0; i < n; ++i) {
+    std::vector<double> v(8, double(i));
+    ret += size_t(v[i % 8]);
+  }
+  return ret;
+}
+
+volatile size_t sink = 0;
+
+/**
+ * The minimum time per operation over repetitions runs of at least
+ * min_seconds each, in nanoseconds.
+ */
+double time_per_op(const bench_function& run, double min_seconds, size_t repetitions) {
+  // find a number of operations which takes at least min_seconds
+  size_t num_ops = 1024;
+  timer ti;
+  while (true) {
+    ti.start();
+    sink += run(num_ops);
+    if (ti.current_time() >= min_seconds || num_ops >= (size_t(1) << 32)) break;
+    num_ops *= 4;
+  }
+  double best = 0;
+  for (size_t rep = 0; rep < repetitions; ++rep) {
+    ti.start();
+    sink += run(num_ops);
+    double ns = ti.current_time() * 1e9 / num_ops;
+    if (rep == 0 || ns < best) best = ns;
+  }
+  return best;
+}
+
+std::string to_json(const std::vector<bench_result>& results, double reference_ns) {
+  std::ostringstream out;
+  out << std::setprecision(6);
+  out << "{\n  \"reference_ns\": " << reference_ns << ",\n  \"results\": [\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto& r = results[i];
+    out << "    {\"name\": \"" << r.name << "\", \"ns_per_op\": " << r.ns_per_op
+        << ", \"reference_ratio\": " << r.reference_ratio
+        << ", \"max_reference_ratio\": " << r.max_reference_ratio << "}"
+        << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  out << "  ]\n}\n";
+  return out.str();
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+  std::string filter, output;
+  bool check = false, quick = false;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    auto value = [&](const std::string& flag) {
+      return arg.compare(0, flag.size(), flag) == 0 ? arg.substr(flag.size())
+                                                    : std::string();
+    };
+    if (!value("--filter=").empty()) filter = value("--filter=");
+    else if (!value("--output=").empty()) output = value("--output=");
+    else if (arg == "--check") check = true;
+    else if (arg == "--quick") quick = true;
+    else {
+      std::cout << "usage: " << argv[0]
+                << " [--filter=name] [--quick] [--check] [--output=file.json]\n";
+      return 1;
+    }
+  }
+  double min_seconds = quick ? 0.005 : 0.05;
+  size_t repetitions = quick ? 3 : 7;
+
+  std::vector<bench_case> cases = make_cases();
+
+  double reference_ns = time_per_op(reference_operation, min_seconds, repetitions);
+  std::cout << "reference (vector<double>(8) alloc/free): " << reference_ns << " ns\n";
+
+  std::vector<bench_result> results;
+  size_t num_failed = 0;
+  for (const auto& c : cases) {
+    if (!filter.empty() && c.name.find(filter) == std::string::npos) continue;
+    double ns = time_per_op(c.run, min_seconds, repetitions);
+    bench_result r{c.name, ns, ns / reference_ns, c.max_reference_ratio};
+    results.push_back(r);
+    std::cout << std::left << std::setw(32) << r.name << std::right << std::setw(10)
+              << std::fixed << std::setprecision(2) << r.ns_per_op << " ns  "
+              << std::setw(7) << r.reference_ratio << "x ref";
+    if (r.max_reference_ratio > 0) {
+      std::cout << "  (max " << r.max_reference_ratio << "x)";
+      if (!r.passed()) std::cout << "  SLOW";
+    }
+    std::cout << std::defaultfloat << "\n";
+    if (!r.passed()) ++num_failed;
+  }
+
+  if (!output.empty()) {
+    std::ofstream(output) << to_json(results, reference_ns);
+    std::cout << "Results written to " << output << "\n";
+  }
+
+  if (check && num_failed > 0) {
+    std::cout << num_failed << " case(s) slower than their threshold\n";
+    return 1;
+  }
+  return 0;
+}
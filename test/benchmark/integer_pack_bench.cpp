@@ -0,0 +1,114 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at
+ * https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <core/storage/sframe_data/integer_pack.hpp>
+#include <core/storage/sframe_data/sarray_v2_type_encoding.hpp>
+#include <timer/timer.hpp>
+
+using namespace turi;
+using namespace turi::integer_pack;
+
+namespace {
+
+/*
+ * Compares the scalar bit unpacker against the dispatched (SIMD) unpacker
+ * for every packing width, and then times a full frame of reference decode
+ * of an integer stream into a contiguous buffer.
+ *
+ * usage: integer_pack_bench [number of 128 value blocks]
+ */
+
+typedef void (*unpack_fn)(unsigned char, const uint8_t*, size_t, uint64_t*);
+
+size_t pack_values(unsigned char nbits, const uint64_t* in, size_t len, uint8_t* out) {
+  switch(nbits) {
+   case 1: return pack_1(in, len, out);
+   case 2: return pack_2(in, len, out);
+   case 4: return pack_4(in, len, out);
+   case 8: return pack_8(in, len, out);
+   case 16: return pack_16(in, len, (uint16_t*)out);
+   case 32: return pack_32(in, len, (uint32_t*)out);
+  }
+  return 0;
+}
+
+double time_unpack(unpack_fn fn,
+                   unsigned char nbits,
+                   const std::vector<uint8_t>& packed,
+                   size_t bytes_per_block,
+                   size_t num_blocks,
+                   std::vector<uint64_t>& out) {
+  timer ti;
+  for (size_t b = 0; b < num_blocks; ++b) {
+    fn(nbits, packed.data() + b * bytes_per_block, 128, out.data() + b * 128);
+  }
+  return ti.current_time();
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+  size_t num_blocks = 1 << 16;
+  if (argc > 1) num_blocks = std::atoll(argv[1]);
+  const size_t num_values = 128 * num_blocks;
+
+  std::cout << "Dispatched unpacker: " << unpack_block_implementation() << "\n";
+  std::cout << num_values << " values per run\n\n";
+
+  std::mt19937_64 gen(0);
+  std::vector<uint64_t> values(num_values);
+  std::vector<uint64_t> scalar_out(num_values);
+  std::vector<uint64_t> simd_out(num_values);
+  bool all_match = true;
+
+  for (unsigned char nbits: {1, 2, 4, 8, 16, 32}) {
+    uint64_t mask = (uint64_t(1) << nbits) - 1;
+    for (auto& v: values) v = gen() & mask;
+
+    size_t bytes_per_block = (128 * nbits) / 8;
+    std::vector<uint8_t> packed(bytes_per_block * num_blocks);
+    for (size_t b = 0; b < num_blocks; ++b) {
+      pack_values(nbits, values.data() + b * 128, 128,
+                  packed.data() + b * bytes_per_block);
+    }
+
+    double scalar_time = time_unpack(unpack_block_scalar, nbits, packed,
+                                     bytes_per_block, num_blocks, scalar_out);
+    double simd_time = time_unpack(unpack_block, nbits, packed,
+                                   bytes_per_block, num_blocks, simd_out);
+
+    bool match = (scalar_out == simd_out) && (scalar_out == values);
+    all_match = all_match && match;
+    std::cout << (int)nbits << " bits: scalar " << scalar_time << "s, "
+              << unpack_block_implementation() << " " << simd_time << "s, "
+              << "speedup " << scalar_time / simd_time << "x"
+              << (match ? "" : "  MISMATCH") << "\n";
+  }
+
+  // end to end: frame of reference encode then decode into a flat buffer
+  std::uniform_int_distribution<int64_t> dist(-100000, 100000);
+  for (auto& v: values) v = (uint64_t)dist(gen);
+  oarchive oarc;
+  for (size_t b = 0; b < num_blocks; ++b) {
+    frame_of_reference_encode_128(values.data() + b * 128, 128, oarc);
+  }
+  timer ti;
+  iarchive iarc(oarc.buf, oarc.off);
+  v2_block_impl::decode_number_to_buffer(iarc, num_values, simd_out.data());
+  double decode_time = ti.current_time();
+  bool match = (simd_out == values);
+  all_match = all_match && match;
+  std::cout << "\nframe_of_reference decode: " << decode_time << "s ("
+            << (num_values / decode_time) / 1e6 << "M values/s)"
+            << (match ? "" : "  MISMATCH") << "\n";
+  free(oarc.buf);
+
+  return all_match ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at
+ * https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/storage/sframe_data/sarray.hpp>
+#include <core/storage/sframe_data/algorithm.hpp>
+#include <timer/timer.hpp>
+
+using namespace turi;
+
+namespace {
+
+/*
+ * Times the allocation of flexible_type string payloads from the heap and
+ * from the thread payload cache, and then a full scan of a string sarray,
+ * which allocates and frees one payload per value.
+ *
+ * usage: string_scan_bench [number of strings]
+ */
+
+typedef std::pair<atomic<size_t>, flex_string> string_payload;
+
+// allocates and frees num_rounds blocks of block_size string payloads
+template <typename Allocate, typename Free>
+double time_payloads(size_t num_rounds, size_t block_size,
+                     Allocate allocate, Free free) {
+  std::vector<string_payload*> block(block_size);
+  timer ti;
+  for (size_t r = 0; r < num_rounds; ++r) {
+    for (auto& p: block) p = allocate();
+    for (auto& p: block) free(p);
+  }
+  return ti.current_time();
+}
+
+std::string random_string(std::mt19937_64& gen) {
+  std::uniform_int_distribution<size_t> length(4, 40);
+  std::uniform_int_distribution<int> letter('a', 'z');
+  std::string ret(length(gen), ' ');
+  for (auto& c: ret) c = letter(gen);
+  return ret;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+  size_t num_strings = 4 * 1024 * 1024;
+  if (argc > 1) num_strings = std::atoll(argv[1]);
+
+  const size_t block_size = 1024;
+  const size_t num_rounds = num_strings / block_size;
+  double heap_time = time_payloads(
+      num_rounds, block_size,
+      []() { return new string_payload; },
+      [](string_payload* p) { delete p; });
+  double cache_time = time_payloads(
+      num_rounds, block_size,
+      []() { return flexible_type_impl::new_payload<string_payload>(); },
+      [](string_payload* p) { flexible_type_impl::delete_payload(p); });
+  std::cout << num_rounds * block_size << " string payloads: heap " << heap_time
+            << "s, thread cache " << cache_time << "s, speedup "
+            << heap_time / cache_time << "x\n";
+
+  // end to end: scan a column of distinct strings, so that it is not
+  // dictionary encoded
+  std::mt19937_64 gen(0);
+  std::vector<flexible_type> values;
+  values.reserve(num_strings);
+  for (size_t i = 0; i < num_strings; ++i) values.push_back(random_string(gen));
+  sarray<flexible_type> column;
+  column.open_for_write(1);
+  column.set_type(flex_type_enum::STRING);
+  turi::copy(values.begin(), values.end(), column);
+  column.close();
+  values.clear();
+
+  auto reader = column.get_reader();
+  std::vector<flexible_type> block;
+  size_t total_length = 0;
+  timer ti;
+  for (size_t row = 0; row < num_strings; row += block_size) {
+    reader->read_rows(row, std::min(row + block_size, num_strings), block);
+    for (const auto& v: block) total_length += v.get<flex_string>().size();
+  }
+  double scan_time = ti.current_time();
+  std::cout << "string scan: " << scan_time << "s ("
+            << (num_strings / scan_time) / 1e6 << "M values/s, "
+            << total_length << " characters)\n";
+  return 0;
+}
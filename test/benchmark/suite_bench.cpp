@@ -0,0 +1,407 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at
+ * https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <core/data/sframe/gl_sframe.hpp>
+#include <core/parallel/lambda_omp.hpp>
+#include <core/parallel/thread_pool.hpp>
+#include <core/storage/fileio/temp_files.hpp>
+#include <core/storage/sframe_data/json_lines_parser.hpp>
+#include <core/storage/sframe_data/parallel_csv_parser.hpp>
+#include <core/storage/sframe_data/sframe.hpp>
+#include <core/storage/sframe_data/sframe_rows.hpp>
+#include <core/storage/sframe_data/testing_utils.hpp>
+#include <ml/ml_data/ml_data.hpp>
+#include <toolkits/nearest_neighbors/brute_force_neighbors.hpp>
+#include <toolkits/supervised_learning/boosted_trees.hpp>
+#include <toolkits/supervised_learning/linear_regression.hpp>
+#include <timer/timer.hpp>
+
+using namespace turi;
+
+namespace {
+
+/*
+ * Times the main SFrame operations and toolkits on synthetic data, at
+ * several sizes and thread pool sizes, and writes the results as JSON so
+ * that two builds can be compared.
+ *
+ * usage: suite_bench [options]
+ *   --sizes=100000,1000000   numbers of rows
+ *   --threads=1,4            thread pool sizes (default: 1, 2, 4, ... cpus)
+ *   --repetitions=3          timed runs per case, after one warm-up run
+ *   --filter=groupby         only run the cases whose name contains this
+ *   --output=results.json    where to write the results
+ *   --compare=baseline.json  print the speedup over an earlier output
+ *
+ * The data is generated by make_random_sframe with fixed seeds, so every
+ * run of every build times the same rows. Each case reports the minimum,
+ * median and mean time of its runs; compare medians.
+ */
+
+// Columns of the generated SFrames: 6 numeric, a 5 category integer, a 100
+// category string, and a numeric "target" the features mostly predict.
+const std::string COLUMN_TYPES = "nnnnnnzc";
+const std::vector<std::string> NUMERIC_COLUMNS =
+    {"X1-n", "X2-n", "X3-n", "X4-n", "X5-n", "X6-n"};
+const std::string INT_KEY_COLUMN = "X7-z";
+const std::string STRING_KEY_COLUMN = "X8-c";
+
+typedef std::function<void()> run_function;
+
+/**
+ * A benchmark: setup builds its input for a number of rows (untimed) and
+ * returns the function timed on it.
+ */
+struct bench_case {
+  std::string name;
+  std::function<run_function(const sframe& data, size_t num_rows)> setup;
+};
+
+struct bench_result {
+  std::string name;
+  size_t num_rows;
+  size_t num_threads;
+  std::vector<double> seconds;
+
+  double min() const { return *std::min_element(seconds.begin(), seconds.end()); }
+  double median() const {
+    std::vector<double> s = seconds;
+    std::sort(s.begin(), s.end());
+    return s[s.size() / 2];
+  }
+  double mean() const {
+    double total = 0;
+    for (double t : seconds) total += t;
+    return total / seconds.size();
+  }
+};
+
+std::vector<std::string> feature_columns() {
+  std::vector<std::string> ret = NUMERIC_COLUMNS;
+  ret.push_back(INT_KEY_COLUMN);
+  ret.push_back(STRING_KEY_COLUMN);
+  return ret;
+}
+
+void write_json_lines(const sframe& data, const std::string& path) {
+  std::ofstream out(path);
+  auto reader = data.get_reader();
+  std::vector<std::vector<flexible_type>> rows;
+  const size_t block_size = 16384;
+  out << std::setprecision(17);
+  for (size_t row = 0; row < data.num_rows(); row += block_size) {
+    reader->read_rows(row, row + block_size, rows);
+    for (const auto& r : rows) {
+      out << '{';
+      for (size_t c = 0; c < r.size(); ++c) {
+        if (c > 0) out << ',';
+        out << '"' << data.column_name(c) << "\":";
+        if (r[c].get_type() == flex_type_enum::STRING) {
+          out << '"' << r[c].get<flex_string>() << '"';
+        } else if (r[c].get_type() == flex_type_enum::FLOAT &&
+                   !std::isfinite(r[c].get<flex_float>())) {
+          out << "null";
+        } else {
+          out << r[c];
+        }
+      }
+      out << "}\n";
+    }
+  }
+}
+
+std::vector<bench_case> make_cases() {
+  std::vector<bench_case> cases;
+
+  cases.push_back({"decode", [](const sframe& data, size_t) -> run_function {
+    return [data]() {
+      auto reader = data.get_reader();
+      size_t num_rows = data.num_rows();
+      in_parallel([&](size_t thread_idx, size_t num_threads) {
+        size_t begin = num_rows * thread_idx / num_threads;
+        size_t end = num_rows * (thread_idx + 1) / num_threads;
+        sframe_rows rows;
+        for (size_t row = begin; row < end; row += DEFAULT_SARRAY_READER_BUFFER_SIZE) {
+          reader->read_rows(
+              row, std::min(row + DEFAULT_SARRAY_READER_BUFFER_SIZE, end), rows);
+        }
+      });
+    };
+  }});
+
+  cases.push_back({"filter", [](const sframe& data, size_t) -> run_function {
+    gl_sframe sf(data);
+    return [sf]() {
+      gl_sframe out = sf[sf[NUMERIC_COLUMNS[0]] > 0 && sf[INT_KEY_COLUMN] < 3];
+      out.materialize();
+    };
+  }});
+
+  cases.push_back({"groupby", [](const sframe& data, size_t) -> run_function {
+    gl_sframe sf(data);
+    return [sf]() {
+      gl_sframe out = sf.groupby({STRING_KEY_COLUMN, INT_KEY_COLUMN},
+          {{"count", aggregate::COUNT()},
+           {"sum", aggregate::SUM(NUMERIC_COLUMNS[0])},
+           {"mean", aggregate::AVG(NUMERIC_COLUMNS[1])},
+           {"max", aggregate::MAX(NUMERIC_COLUMNS[2])}});
+      out.materialize();
+    };
+  }});
+
+  cases.push_back({"join", [](const sframe& data, size_t) -> run_function {
+    gl_sframe sf(data);
+    // A dimension table with one row per key.
+    gl_sframe keys = sf.groupby({STRING_KEY_COLUMN},
+                                {{"key_count", aggregate::COUNT()}});
+    keys.materialize();
+    return [sf, keys]() {
+      gl_sframe out = sf.join(keys, {STRING_KEY_COLUMN}, "inner");
+      out.materialize();
+    };
+  }});
+
+  cases.push_back({"sort", [](const sframe& data, size_t) -> run_function {
+    gl_sframe sf(data);
+    return [sf]() {
+      gl_sframe out = sf.sort(NUMERIC_COLUMNS[0]);
+      out.materialize();
+    };
+  }});
+
+  cases.push_back({"csv_ingest", [](const sframe& data, size_t) -> run_function {
+    std::string path = get_temp_name() + ".csv";
+    gl_sframe(data).save(path, "csv");
+    return [path]() {
+      csv_line_tokenizer tokenizer;
+      tokenizer.delimiter = ',';
+      tokenizer.init();
+      sframe frame;
+      frame.init_from_csvs(path, tokenizer,
+                           true,   // header
+                           false,  // do not continue on failure
+                           false,  // do not store errors
+                           std::map<std::string, flex_type_enum>());
+    };
+  }});
+
+  cases.push_back({"json_ingest", [](const sframe& data, size_t) -> run_function {
+    std::string path = get_temp_name() + ".json";
+    write_json_lines(data, path);
+    return [path]() { parse_json_lines(path); };
+  }});
+
+  cases.push_back({"ml_data_fill", [](const sframe& data, size_t) -> run_function {
+    sframe sf = data.select_columns(feature_columns());
+    return [sf]() {
+      ml_data mld;
+      mld.fill(sf);
+    };
+  }});
+
+  cases.push_back({"lbfgs_linear_regression",
+                   [](const sframe& data, size_t) -> run_function {
+    sframe X = data.select_columns(feature_columns());
+    sframe y = data.select_columns({"target"});
+    return [X, y]() {
+      supervised::linear_regression model;
+      model.init(X, y);
+      model.init_options({{"solver", "lbfgs"},
+                          {"max_iterations", 10},
+                          {"convergence_threshold", 1e-10}});
+      model.train();
+    };
+  }});
+
+  cases.push_back({"boosted_trees_regression",
+                   [](const sframe& data, size_t) -> run_function {
+    sframe X = data.select_columns(feature_columns());
+    sframe y = data.select_columns({"target"});
+    return [X, y]() {
+      supervised::xgboost::boosted_trees_regression model;
+      model.init(X, y);
+      model.init_options({{"max_iterations", 10}, {"max_depth", 6}});
+      model.train();
+    };
+  }});
+
+  cases.push_back({"knn_brute_force", [](const sframe& data, size_t) -> run_function {
+    sframe X = data.select_columns(NUMERIC_COLUMNS);
+    sframe queries = make_random_sframe(1000, "nnnnnn", false, 1);
+    std::vector<flexible_type> labels(X.num_rows());
+    for (size_t i = 0; i < labels.size(); ++i) labels[i] = flex_int(i);
+    std::vector<std::vector<flexible_type>> query_labels(queries.num_rows());
+    for (size_t i = 0; i < query_labels.size(); ++i) query_labels[i] = {flex_int(i)};
+    sframe query_label_sf = make_testing_sframe(
+        {"label"}, {flex_type_enum::INTEGER}, query_labels);
+    return [X, labels, queries, query_label_sf]() {
+      function_closure_info fn;
+      fn.native_fn_name = "_distances.euclidean";
+      nearest_neighbors::dist_component_type p =
+          std::make_tuple(X.column_names(), fn, 1.0);
+      std::shared_ptr<nearest_neighbors::nearest_neighbors_model> model(
+          new nearest_neighbors::brute_force_neighbors);
+      model->train(X, labels, {p}, std::map<std::string, flexible_type>());
+      model->query(queries, query_label_sf, 10, -1.0);
+    };
+  }});
+
+  return cases;
+}
+
+std::vector<size_t> parse_sizes(const std::string& s) {
+  std::vector<size_t> ret;
+  std::stringstream ss(s);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (!item.empty()) ret.push_back(std::stoull(item));
+  }
+  return ret;
+}
+
+std::string to_json(const std::vector<bench_result>& results, size_t repetitions) {
+  std::ostringstream out;
+  out << std::setprecision(9);
+  out << "{\n  \"context\": {\"num_cpus\": " << thread::cpu_count()
+      << ", \"repetitions\": " << repetitions
+#ifdef NDEBUG
+      << ", \"build\": \"release\""
+#else
+      << ", \"build\": \"debug\""
+#endif
+      << "},\n  \"results\": [\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto& r = results[i];
+    out << "    {\"name\": \"" << r.name << "\", \"num_rows\": " << r.num_rows
+        << ", \"num_threads\": " << r.num_threads
+        << ", \"min_seconds\": " << r.min()
+        << ", \"median_seconds\": " << r.median()
+        << ", \"mean_seconds\": " << r.mean()
+        << ", \"rows_per_second\": " << r.num_rows / r.median() << "}"
+        << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  out << "  ]\n}\n";
+  return out.str();
+}
+
+std::string result_key(const std::string& name, size_t num_rows, size_t num_threads) {
+  return name + "/" + std::to_string(num_rows) + "/" + std::to_string(num_threads);
+}
+
+// The median times of an earlier output, by result_key.
+std::map<std::string, double> load_baseline(const std::string& path) {
+  std::ifstream in(path);
+  std::string text((std::istreambuf_iterator<char>(in)),
+                   std::istreambuf_iterator<char>());
+  flexible_type doc;
+  if (!parse_json_value(text.data(), text.data() + text.size(), doc) ||
+      doc.get_type() != flex_type_enum::DICT) {
+    log_and_throw("Cannot read benchmark results from " + path);
+  }
+
+  std::map<std::string, double> ret;
+  for (const auto& kv : doc.get<flex_dict>()) {
+    if (kv.first != "results") continue;
+    for (const auto& r : kv.second.get<flex_list>()) {
+      std::map<std::string, flexible_type> fields;
+      for (const auto& f : r.get<flex_dict>()) {
+        fields[f.first.get<flex_string>()] = f.second;
+      }
+      ret[result_key(fields["name"].get<flex_string>(),
+                     fields["num_rows"].to<size_t>(),
+                     fields["num_threads"].to<size_t>())] =
+          fields["median_seconds"].to<double>();
+    }
+  }
+  return ret;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+  std::vector<size_t> sizes = {100000, 1000000};
+  std::vector<size_t> thread_counts;
+  for (size_t t = 1; t < thread::cpu_count(); t *= 2) thread_counts.push_back(t);
+  thread_counts.push_back(thread::cpu_count());
+  size_t repetitions = 3;
+  std::string filter, output = "suite_bench.json", compare;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    auto value = [&](const std::string& flag) {
+      return arg.compare(0, flag.size(), flag) == 0 ? arg.substr(flag.size())
+                                                    : std::string();
+    };
+    if (!value("--sizes=").empty()) sizes = parse_sizes(value("--sizes="));
+    else if (!value("--threads=").empty()) thread_counts = parse_sizes(value("--threads="));
+    else if (!value("--repetitions=").empty()) repetitions = std::stoull(value("--repetitions="));
+    else if (!value("--filter=").empty()) filter = value("--filter=");
+    else if (!value("--output=").empty()) output = value("--output=");
+    else if (!value("--compare=").empty()) compare = value("--compare=");
+    else {
+      std::cout << "usage: " << argv[0] << " [--sizes=N,...] [--threads=N,...]"
+                << " [--repetitions=N] [--filter=name] [--output=file.json]"
+                << " [--compare=baseline.json]\n";
+      return 1;
+    }
+  }
+  repetitions = std::max<size_t>(repetitions, 1);
+
+  auto& pool = thread_pool::get_instance();
+  size_t original_pool_size = pool.size();
+  std::vector<bench_case> cases = make_cases();
+  std::vector<bench_result> results;
+
+  for (size_t num_rows : sizes) {
+    sframe data = make_random_sframe(num_rows, COLUMN_TYPES, true, 0);
+    for (const auto& c : cases) {
+      if (!filter.empty() && c.name.find(filter) == std::string::npos) continue;
+      run_function run = c.setup(data, num_rows);
+      for (size_t num_threads : thread_counts) {
+        pool.resize(num_threads);
+        bench_result r{c.name, num_rows, num_threads, {}};
+        run();  // warm up
+        for (size_t rep = 0; rep < repetitions; ++rep) {
+          timer ti;
+          ti.start();
+          run();
+          r.seconds.push_back(ti.current_time());
+        }
+        std::cout << std::left << std::setw(28) << c.name << " rows "
+                  << std::setw(10) << num_rows << " threads " << std::setw(4)
+                  << num_threads << " median " << r.median() << "s\n";
+        results.push_back(r);
+      }
+    }
+  }
+  pool.resize(original_pool_size);
+
+  std::ofstream(output) << to_json(results, repetitions);
+  std::cout << "Results written to " << output << "\n";
+
+  if (!compare.empty()) {
+    std::map<std::string, double> baseline = load_baseline(compare);
+    std::cout << "\nSpeedup over " << compare << " (> 1 is faster):\n";
+    for (const auto& r : results) {
+      auto it = baseline.find(result_key(r.name, r.num_rows, r.num_threads));
+      if (it == baseline.end()) continue;
+      std::cout << std::left << std::setw(28) << r.name << " rows "
+                << std::setw(10) << r.num_rows << " threads " << std::setw(4)
+                << r.num_threads << " " << it->second / r.median() << "x\n";
+    }
+  }
+  return 0;
+}
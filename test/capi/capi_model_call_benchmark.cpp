@@ -0,0 +1,70 @@
+/* Copyright © 2018 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#include <iostream>
+#include <stdexcept>
+#include <capi/TuriCreate.h>
+#include <capi/impl/capi_wrapper_structs.hpp>
+#include <timer/timer.hpp>
+
+using namespace turi;
+
+static constexpr size_t n_iterations = 100000;
+
+#define CHECK_ERROR(error)                          \
+  do {                                              \
+    if (error != nullptr) {                         \
+      std::cerr << error->value << std::endl;       \
+      throw std::runtime_error(error->value);       \
+    }                                               \
+  } while (false)
+
+// Compares the latency of calling a cheap model method by name, through
+// tc_model_call_method, with calling it through a method handle looked up
+// once with tc_model_method_lookup.
+int main(int argc, char** argv) {
+  tc_error* error = NULL;
+
+  tc_model* model = tc_model_new("boosted_trees_regression", &error);
+  CHECK_ERROR(error);
+
+  {
+    tc_parameters* args = tc_parameters_create_empty(&error);
+    CHECK_ERROR(error);
+
+    timer tt;
+    tt.start();
+    for (size_t i = 0; i < n_iterations; ++i) {
+      tc_variant* ret = tc_model_call_method(model, "is_trained", args, &error);
+      CHECK_ERROR(error);
+      tc_release(ret);
+    }
+    double t = tt.current_time();
+    std::cout << "  tc_model_call_method (" << n_iterations << " calls): "
+              << t << "s, " << (1e6 * t / n_iterations) << "us per call"
+              << std::endl;
+    tc_release(args);
+  }
+
+  {
+    timer tt;
+    tt.start();
+    tc_model_method* method = tc_model_method_lookup(model, "is_trained", &error);
+    CHECK_ERROR(error);
+    for (size_t i = 0; i < n_iterations; ++i) {
+      tc_variant* ret = tc_model_method_call(method, NULL, 0, &error);
+      CHECK_ERROR(error);
+      tc_release(ret);
+    }
+    double t = tt.current_time();
+    std::cout << "  tc_model_method_call (" << n_iterations << " calls): "
+              << t << "s, " << (1e6 * t / n_iterations) << "us per call"
+              << std::endl;
+    tc_release(method);
+  }
+
+  tc_release(model);
+  return 0;
+}
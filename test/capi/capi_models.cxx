@@ -178,6 +178,43 @@ BOOST_AUTO_TEST_CASE(test_boosted_trees_double) {
         tc_release(ret_2);
       }
 
+      // The same predictions through a method handle, omitting the
+      // arguments with default values.
+      {
+        tc_sframe* sf_predict = tc_sframe_create_copy(sf, &error);
+        CAPI_CHECK_ERROR(error);
+        tc_sframe_remove_column(sf_predict, "target", &error);
+        CAPI_CHECK_ERROR(error);
+
+        tc_variant* data_arg = tc_variant_create_from_sframe(sf_predict, &error);
+        CAPI_CHECK_ERROR(error);
+        tc_release(sf_predict);
+
+        tc_model_method* predict = tc_model_method_lookup(model, "predict", &error);
+        CAPI_CHECK_ERROR(error);
+
+        const tc_variant* predict_args[] = {data_arg};
+        tc_variant* ret_3 = tc_model_method_call(predict, predict_args, 1, &error);
+        CAPI_CHECK_ERROR(error);
+
+        tc_sarray* sa = tc_variant_sarray(ret_3, &error);
+        CAPI_CHECK_ERROR(error);
+        TS_ASSERT_EQUALS(tc_sarray_size(sa), data.back().second.size());
+        tc_release(sa);
+        tc_release(ret_3);
+
+        // Too many arguments is an error.
+        const tc_variant* bad_args[] = {data_arg, data_arg, data_arg, data_arg};
+        tc_variant* ret_4 = tc_model_method_call(predict, bad_args, 4, &error);
+        TS_ASSERT(ret_4 == NULL);
+        TS_ASSERT(error != NULL);
+        tc_release(error);
+        error = NULL;
+
+        tc_release(predict);
+        tc_release(data_arg);
+      }
+
       {
         tc_parameters* export_args = tc_parameters_create_empty(&error);
         CAPI_CHECK_ERROR(error);
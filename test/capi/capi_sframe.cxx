@@ -11,6 +11,7 @@
 #include <core/data/sframe/gl_sarray.hpp>
 #include <capi/TuriCreate.h>
 #include <capi/impl/capi_wrapper_structs.hpp>
+#include <core/storage/sframe_data/arrow_interchange.hpp>
 #include <vector>
 #include <iostream>
 #include <ctime>
@@ -2018,3 +2019,54 @@ BOOST_AUTO_TEST_CASE(test_sframe_apply) {
   tc_release(ret);
   tc_release(data);
 }
+
+BOOST_AUTO_TEST_CASE(test_sframe_arrow_roundtrip) {
+  std::vector<double> col1 = {1.0, 2., 5., 0.5};
+  std::vector<double> col2 = {2.0, 2., 3., 0.5};
+
+  tc_error* error = NULL;
+  tc_sframe* sf = tc_sframe_create_empty(&error);
+  CAPI_CHECK_ERROR(error);
+  tc_sarray* sa1 = make_sarray_double(col1);
+  tc_sarray* sa2 = make_sarray_double(col2);
+  tc_sframe_add_column(sf, "col1", sa1, &error);
+  CAPI_CHECK_ERROR(error);
+  tc_sframe_add_column(sf, "col2", sa2, &error);
+  CAPI_CHECK_ERROR(error);
+
+  ArrowSchema schema;
+  ArrowArray array;
+  tc_sframe_export_arrow(sf, &schema, &array, &error);
+  CAPI_CHECK_ERROR(error);
+
+  TS_ASSERT_EQUALS(std::string(schema.format), "+s");
+  TS_ASSERT_EQUALS(schema.n_children, 2);
+  TS_ASSERT_EQUALS(array.length, 4);
+  TS_ASSERT_EQUALS(std::string(schema.children[1]->name), "col2");
+  TS_ASSERT_EQUALS(std::string(schema.children[1]->format), "g");
+  TS_ASSERT_EQUALS(array.children[1]->null_count, 0);
+  const double* values = static_cast<const double*>(array.children[1]->buffers[1]);
+  for (size_t i = 0; i < col2.size(); ++i) {
+    TS_ASSERT_EQUALS(values[i], col2[i]);
+  }
+
+  // the import releases the exported structures
+  tc_sframe* sf2 = tc_sframe_import_arrow(&schema, &array, &error);
+  CAPI_CHECK_ERROR(error);
+  TS_ASSERT(schema.release == NULL);
+  TS_ASSERT(array.release == NULL);
+
+  tc_sarray* out1 = tc_sframe_extract_column_by_name(sf2, "col1", &error);
+  CAPI_CHECK_ERROR(error);
+  TS_ASSERT(tc_sarray_equals(out1, sa1, &error));
+  tc_sarray* out2 = tc_sframe_extract_column_by_name(sf2, "col2", &error);
+  CAPI_CHECK_ERROR(error);
+  TS_ASSERT(tc_sarray_equals(out2, sa2, &error));
+
+  tc_release(out1);
+  tc_release(out2);
+  tc_release(sa1);
+  tc_release(sa2);
+  tc_release(sf2);
+  tc_release(sf);
+}
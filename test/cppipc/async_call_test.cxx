@@ -0,0 +1,53 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <core/system/cppipc/cppipc.hpp>
+#include <core/storage/fileio/temp_files.hpp>
+#include <future>
+#include "test_object_base.hpp"
+
+struct async_call_test {
+  public:
+    void test_async_calls() {
+      std::string server_ipc_file = "ipc://" + turi::get_temp_name();
+      cppipc::comm_server server({}, "", server_ipc_file);
+      server.register_type<test_object_base>([](){ return new test_object_impl;});
+      server.mark_thread_safe("test_object_base::ping");
+      TS_ASSERT(server.is_thread_safe("test_object_base::ping"));
+      TS_ASSERT(!server.is_thread_safe("test_object_base::add"));
+      server.start();
+
+      cppipc::comm_client client({}, server_ipc_file);
+      client.start();
+      {
+        test_object_proxy test_object(client);
+        std::vector<std::future<std::string>> pings;
+        std::vector<std::future<int>> sums;
+        for (size_t i = 0; i < 200; ++i) {
+          pings.push_back(test_object.proxy.async_call(&test_object_base::ping,
+                                                       std::to_string(i)));
+          sums.push_back(test_object.proxy.async_call(&test_object_base::add,
+                                                      (int)i, 1));
+        }
+        for (size_t i = 0; i < 200; ++i) {
+          TS_ASSERT_EQUALS(pings[i].get(), std::to_string(i));
+          TS_ASSERT_EQUALS(sums[i].get(), (int)i + 1);
+        }
+        // void returns, and exceptions are delivered through the future
+        test_object.proxy.async_call(&test_object_base::set_value, 5).get();
+        TS_ASSERT_EQUALS(test_object.get_value(), 5);
+        auto failed = test_object.proxy.async_call(&test_object_base::an_exception);
+        TS_ASSERT_THROWS_ANYTHING(failed.get());
+        // synchronous calls still work alongside
+        TS_ASSERT_EQUALS(test_object.ping("hello"), "hello");
+      }
+      client.stop();
+      server.stop();
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_async_call_test, async_call_test)
+BOOST_AUTO_TEST_CASE(test_async_calls) {
+  async_call_test::test_async_calls();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,83 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <core/system/cppipc/cppipc.hpp>
+#include <core/system/cppipc/server/call_replay.hpp>
+#include <core/storage/fileio/temp_files.hpp>
+#include "test_object_base.hpp"
+
+struct call_replay_test {
+  public:
+    cppipc::call_recording record_session() {
+      std::string server_ipc_file = "ipc://" + turi::get_temp_name();
+      cppipc::comm_server server({}, "", server_ipc_file);
+      server.register_type<test_object_base>([](){ return new test_object_impl;});
+      server.start_recording();
+      server.start();
+
+      cppipc::comm_client client({}, server_ipc_file);
+      client.start();
+      {
+        auto a = std::make_shared<test_object_proxy>(client);
+        auto b = std::make_shared<test_object_proxy>(client);
+        a->set_value(10);
+        b->set_value(3);
+        // objects created by the server, and objects as arguments
+        std::shared_ptr<test_object_base> c = *a - b;
+        TS_ASSERT_EQUALS(c->get_value(), 7);
+        a->subtract_from(std::static_pointer_cast<test_object_base>(b));
+        TS_ASSERT_EQUALS(a->get_value(), 7);
+        TS_ASSERT_THROWS_ANYTHING(a->an_exception());
+      }
+      client.stop();
+      server.stop();
+      TS_ASSERT(server.is_recording());
+      auto ret = server.stop_recording();
+      TS_ASSERT(!server.is_recording());
+      return ret;
+    }
+
+    void test_record_and_replay() {
+      cppipc::call_recording recording = record_session();
+      TS_ASSERT(recording.calls.size() >= 8);
+      size_t num_errors = 0;
+      for (const auto& call : recording.calls) num_errors += call.error;
+      TS_ASSERT_EQUALS(num_errors, 1);
+
+      std::string directory = turi::get_temp_name();
+      cppipc::save_call_recording(recording, directory);
+      cppipc::call_recording loaded = cppipc::load_call_recording(directory);
+      TS_ASSERT_EQUALS(loaded.object_id_seed, recording.object_id_seed);
+      TS_ASSERT_EQUALS(loaded.calls.size(), recording.calls.size());
+      for (size_t i = 0; i < loaded.calls.size(); ++i) {
+        TS_ASSERT_EQUALS(loaded.calls[i].function_name, recording.calls[i].function_name);
+        TS_ASSERT_EQUALS(loaded.calls[i].objectid, recording.calls[i].objectid);
+        TS_ASSERT(loaded.calls[i].body == recording.calls[i].body);
+      }
+      TS_ASSERT_THROWS_ANYTHING(cppipc::load_call_recording(turi::get_temp_name()));
+
+      // replay against a fresh server, which refers to the objects by the
+      // recorded IDs
+      std::string server_ipc_file = "ipc://" + turi::get_temp_name();
+      cppipc::comm_server server({}, "", server_ipc_file);
+      server.register_type<test_object_base>([](){ return new test_object_impl;});
+      server.start();
+      cppipc::comm_client client({}, server_ipc_file);
+      client.start();
+      cppipc::replay_report report = cppipc::replay_calls(client, loaded);
+      client.stop();
+      server.stop();
+
+      TS_ASSERT_EQUALS(report.num_errors, 0);
+      TS_ASSERT_EQUALS(report.num_calls + report.num_skipped, loaded.calls.size());
+      TS_ASSERT(report.methods.count("test_object_base::get_value"));
+      TS_ASSERT_EQUALS(report.methods["test_object_base::get_value"].num_calls, 2);
+      TS_ASSERT(report.to_string().find("test_object_base::subtract_from") != std::string::npos);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_call_replay_test, call_replay_test)
+BOOST_AUTO_TEST_CASE(test_record_and_replay) {
+  call_replay_test::test_record_and_replay();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,78 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <core/system/cppipc/cppipc.hpp>
+#include <core/system/cppipc/server/call_stats.hpp>
+#include <core/storage/fileio/temp_files.hpp>
+#include "test_object_base.hpp"
+
+struct call_stats_test {
+  public:
+    void test_histogram() {
+      cppipc::latency_histogram hist;
+      TS_ASSERT_EQUALS(hist.quantile(0.5), 0);
+      // every bucket bound is its own bucket, and buckets are contiguous
+      for (size_t i = 0; i + 1 < cppipc::latency_histogram::NUM_BUCKETS; ++i) {
+        uint64_t upper = cppipc::latency_histogram::bucket_upper_bound(i);
+        TS_ASSERT_EQUALS(cppipc::latency_histogram::bucket_index(upper), i);
+        TS_ASSERT_EQUALS(cppipc::latency_histogram::bucket_index(upper + 1), i + 1);
+      }
+      TS_ASSERT_EQUALS(cppipc::latency_histogram::bucket_index(uint64_t(-1)),
+                       cppipc::latency_histogram::NUM_BUCKETS - 1);
+
+      for (uint64_t i = 1; i <= 1000; ++i) hist.add(i);
+      TS_ASSERT_EQUALS(hist.count(), 1000);
+      TS_ASSERT_EQUALS(hist.max(), 1000);
+      TS_ASSERT_EQUALS(hist.quantile(1), 1000);
+      // quantiles are upper bounds within 12.5%
+      uint64_t p50 = hist.quantile(0.5), p99 = hist.quantile(0.99);
+      TS_ASSERT(p50 >= 500 && p50 <= 500 * 1.125);
+      TS_ASSERT(p99 >= 990 && p99 <= 1000);
+
+      cppipc::latency_histogram other;
+      other.add(100000);
+      hist.merge(other);
+      TS_ASSERT_EQUALS(hist.count(), 1001);
+      TS_ASSERT_EQUALS(hist.quantile(1), 100000);
+    }
+
+    void test_server_records_calls() {
+      auto& stats = cppipc::call_stats::get_instance();
+      stats.reset();
+      std::string server_ipc_file = "ipc://" + turi::get_temp_name();
+      cppipc::comm_server server({}, "", server_ipc_file);
+      server.register_type<test_object_base>([](){ return new test_object_impl;});
+      server.start();
+
+      cppipc::comm_client client({}, server_ipc_file);
+      client.start();
+      {
+        test_object_proxy test_object(client);
+        for (size_t i = 0; i < 10; ++i) test_object.ping("hello");
+        TS_ASSERT_THROWS_ANYTHING(test_object.an_exception());
+      }
+      client.stop();
+      server.stop();
+
+      auto result = stats.get_stats();
+      TS_ASSERT(result.count("test_object_base::ping"));
+      const auto& ping = result["test_object_base::ping"];
+      TS_ASSERT_EQUALS(ping.num_calls, 10);
+      TS_ASSERT_EQUALS(ping.num_errors, 0);
+      TS_ASSERT_EQUALS(ping.execution_us.count(), 10);
+      TS_ASSERT(ping.request_bytes > 0);
+      TS_ASSERT(ping.reply_bytes > 0);
+      TS_ASSERT_EQUALS(result["test_object_base::an_exception"].num_errors, 1);
+      stats.reset();
+      TS_ASSERT(stats.get_stats().empty());
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_call_stats_test, call_stats_test)
+BOOST_AUTO_TEST_CASE(test_histogram) {
+  call_stats_test::test_histogram();
+}
+BOOST_AUTO_TEST_CASE(test_server_records_calls) {
+  call_stats_test::test_server_records_calls();
+}
+BOOST_AUTO_TEST_SUITE_END()
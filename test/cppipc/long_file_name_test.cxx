@@ -31,6 +31,13 @@ struct test_long_file_name {
       {
         test_object_proxy test_object(client);
         TS_ASSERT_EQUALS(test_object.ping("hello world"), "hello world");
+        // local ipc calls go through the shared memory ring, large replies
+        // through its spill segment
+        if (getenv("TURI_DISABLE_CPPIPC_SHM") == nullptr) {
+          TS_ASSERT(client.using_shared_memory());
+        }
+        TS_ASSERT_EQUALS(test_object.return_big_object(10 * 1024 * 1024).length(),
+                         10 * 1024 * 1024);
       }
       client.stop();
     }
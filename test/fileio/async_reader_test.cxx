@@ -0,0 +1,156 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <core/util/test_macros.hpp>
+#include <core/storage/fileio/async_reader.hpp>
+#include <core/storage/fileio/general_fstream.hpp>
+#include <core/storage/fileio/temp_files.hpp>
+
+using namespace turi;
+
+
+struct async_reader_test {
+
+ public:
+  std::string write_file(const std::string& fname, size_t length) {
+    std::string contents;
+    for (size_t i = 0;i < length; ++i) contents.push_back((char)(i * 31));
+    general_ofstream fout(fname);
+    fout.write(contents.data(), contents.size());
+    fout.close();
+    return contents;
+  }
+
+  void test_overlapping_reads() {
+    std::string fname = get_temp_name();
+    std::string contents = write_file(fname, 1000000);
+    auto& reader = fileio::async_reader::get_instance();
+
+    // many more reads in flight than I/O threads
+    const size_t range = 10000;
+    std::vector<std::shared_ptr<fileio::async_read_request> > reads;
+    for (size_t i = 0; i < 100; ++i) {
+      reads.push_back(reader.read(fname, i * range, range));
+    }
+    for (size_t i = 0; i < reads.size(); ++i) {
+      auto data = reads[i]->get();
+      TS_ASSERT(reads[i]->ready());
+      TS_ASSERT_EQUALS(reads[i]->offset(), i * range);
+      TS_ASSERT(std::string(data->begin(), data->end()) ==
+                contents.substr(i * range, range));
+    }
+    TS_ASSERT_EQUALS(reader.num_in_flight(), 0);
+
+    // ranges past the end are short
+    auto tail = reader.read(fname, contents.size() - 10, 100)->get();
+    TS_ASSERT_EQUALS(tail->size(), 10);
+    auto past_end = reader.read(fname, contents.size() + 10, 100)->get();
+    TS_ASSERT_EQUALS(past_end->size(), 0);
+
+    reader.close_idle_handles(fname);
+    delete_temp_file(fname);
+  }
+
+  void test_callback() {
+    std::string fname = get_temp_name();
+    std::string contents = write_file(fname, 100000);
+    auto& reader = fileio::async_reader::get_instance();
+
+    std::atomic<size_t> num_called(0);
+    std::atomic<size_t> num_matched(0);
+    std::vector<std::shared_ptr<fileio::async_read_request> > reads;
+    for (size_t i = 0; i < 10; ++i) {
+      auto buffer = std::make_shared<std::vector<char> >(5);
+      reads.push_back(reader.read(fname, i * 1000, 1000,
+          [&, i](std::shared_ptr<std::vector<char> >& data,
+                 std::exception_ptr error) {
+            ++num_called;
+            if (!error && std::string(data->begin(), data->end()) ==
+                contents.substr(i * 1000, 1000)) {
+              ++num_matched;
+            }
+          }, buffer));
+    }
+    // the callbacks are called before the requests are ready
+    for (auto& r: reads) r->wait();
+    TS_ASSERT_EQUALS(num_called, 10);
+    TS_ASSERT_EQUALS(num_matched, 10);
+
+    reader.close_idle_handles(fname);
+    delete_temp_file(fname);
+  }
+
+  void test_failed_read() {
+    auto& reader = fileio::async_reader::get_instance();
+    bool error_seen = false;
+    auto request = reader.read(get_temp_name(), 0, 100,
+        [&](std::shared_ptr<std::vector<char> >& data,
+            std::exception_ptr error) {
+          error_seen = (error != nullptr) && !data;
+        });
+    TS_ASSERT_THROWS_ANYTHING(request->get());
+    TS_ASSERT(request->ready());
+    TS_ASSERT(error_seen);
+  }
+
+  /// Reads the file range by range in a coroutine, two ranges in flight.
+  struct range_scanner {
+    DECL_CORO_STATE(next);
+    std::string fname;
+    size_t range = 0;
+    size_t num_ranges = 0;
+    size_t i = 0;
+    std::shared_ptr<fileio::async_read_request> current, ahead;
+    std::string out;
+
+    /// Returns true while the scan is not complete.
+    bool next() {
+      auto& reader = fileio::async_reader::get_instance();
+      CORO_BEGIN(next)
+      current = reader.read(fname, 0, range);
+      for (i = 0; i < num_ranges; ++i) {
+        ahead = reader.read(fname, (i + 1) * range, range);
+        CORO_AWAIT_READ(current, true);
+        {
+        auto data = current->get();
+        out.append(data->begin(), data->end());
+        current = ahead;
+        }
+      }
+      CORO_END
+      return false;
+    }
+  };
+
+  void test_coroutine() {
+    std::string fname = get_temp_name();
+    std::string contents = write_file(fname, 100000);
+    range_scanner scanner;
+    scanner.fname = fname;
+    scanner.range = 10000;
+    scanner.num_ranges = 10;
+    while (scanner.next()) { }
+    TS_ASSERT(scanner.out == contents);
+    scanner.ahead->wait();
+    fileio::async_reader::get_instance().close_idle_handles(fname);
+    delete_temp_file(fname);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_async_reader_test, async_reader_test)
+BOOST_AUTO_TEST_CASE(test_overlapping_reads) {
+  async_reader_test::test_overlapping_reads();
+}
+BOOST_AUTO_TEST_CASE(test_callback) {
+  async_reader_test::test_callback();
+}
+BOOST_AUTO_TEST_CASE(test_failed_read) {
+  async_reader_test::test_failed_read();
+}
+BOOST_AUTO_TEST_CASE(test_coroutine) {
+  async_reader_test::test_coroutine();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -98,6 +98,55 @@ struct block_cache_test {
     }
 
   }
+
+  void test_block_cache_scan_resistance() {
+    block_cache cache;
+    cache.init(get_temp_directories()[0] + "/" + "scan_test_");
+    cache.set_max_capacity(16);
+    cache.set_priority_hint("high_", block_cache::priority::HIGH);
+    cache.set_priority_hint("low_", block_cache::priority::LOW);
+    std::string value(256, 'a');
+    std::string readback;
+
+    TS_ASSERT(cache.write("high_0", value));
+    // hot keys and a low priority key are evicted once by a small scan,
+    // and then fetched again
+    for (size_t i = 0;i < 4; ++i) TS_ASSERT(cache.write("hot_" + std::to_string(i), value));
+    TS_ASSERT(cache.write("low_0", value));
+    for (size_t i = 0;i < 16; ++i) TS_ASSERT(cache.write("warmup_" + std::to_string(i), value));
+    for (size_t i = 0;i < 4; ++i) {
+      TS_ASSERT_EQUALS(cache.read("hot_" + std::to_string(i), readback), -1);
+      TS_ASSERT(cache.write("hot_" + std::to_string(i), value));
+    }
+    TS_ASSERT_EQUALS(cache.read("low_0", readback), -1);
+    TS_ASSERT(cache.write("low_0", value));
+
+    // a long scan, reading every key it writes
+    for (size_t i = 0;i < 1000; ++i) {
+      std::string key = "scan_" + std::to_string(i);
+      TS_ASSERT(cache.write(key, value));
+      TS_ASSERT_EQUALS(cache.read(key, readback), 256);
+      TS_ASSERT_EQUALS(cache.read(key, readback), 256);
+    }
+
+    // keys fetched twice, and the high priority key, survive the scan
+    for (size_t i = 0;i < 4; ++i) {
+      TS_ASSERT_EQUALS(cache.read("hot_" + std::to_string(i), readback), 256);
+    }
+    TS_ASSERT_EQUALS(cache.read("high_0", readback), 256);
+    TS_ASSERT_EQUALS(cache.read("low_0", readback), -1);
+    // only the most recent keys of the scan are still there
+    TS_ASSERT_EQUALS(cache.read("scan_0", readback), -1);
+    TS_ASSERT_EQUALS(cache.read("scan_999", readback), 256);
+
+    TS_ASSERT(cache.get_priority_hint("high_123") == block_cache::priority::HIGH);
+    TS_ASSERT(cache.get_priority_hint("hot_0") == block_cache::priority::NORMAL);
+    // 6 by the warm up scan, 5 making room for the keys fetched again
+    // and one for every key of the long scan
+    TS_ASSERT_EQUALS(cache.evictions(), 6 + 5 + 1000);
+    TS_ASSERT_EQUALS(cache.misses(), 4 + 1 + 1 + 1);
+    TS_ASSERT_EQUALS(cache.hits(), 2000 + 4 + 1 + 1);
+  }
 };
 
 
@@ -108,6 +157,9 @@ BOOST_AUTO_TEST_CASE(test_block_cache) {
 BOOST_AUTO_TEST_CASE(test_block_cache_evict) {
   block_cache_test::test_block_cache_evict();
 }
+BOOST_AUTO_TEST_CASE(test_block_cache_scan_resistance) {
+  block_cache_test::test_block_cache_scan_resistance();
+}
 BOOST_AUTO_TEST_SUITE_END()
 
 #endif
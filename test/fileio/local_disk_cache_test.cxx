@@ -0,0 +1,103 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <boost/filesystem.hpp>
+#include <core/storage/fileio/local_disk_cache.hpp>
+#include <core/storage/fileio/temp_files.hpp>
+#include <core/util/md5.hpp>
+
+using namespace turi;
+namespace fs = boost::filesystem;
+
+struct local_disk_cache_test {
+ public:
+  void test_read_write() {
+    std::string dir = get_temp_name();
+    local_disk_cache cache(dir, 0);
+    std::string value;
+    TS_ASSERT(!cache.read("a", value));
+    TS_ASSERT(cache.write("a", std::string(1000, 'a')));
+    TS_ASSERT(cache.write("b", ""));
+    TS_ASSERT(cache.read("a", value));
+    TS_ASSERT_EQUALS(value, std::string(1000, 'a'));
+    TS_ASSERT(cache.read("b", value));
+    TS_ASSERT_EQUALS(value, "");
+    TS_ASSERT_EQUALS(cache.hits(), 2);
+    TS_ASSERT_EQUALS(cache.misses(), 1);
+
+    // another process using the same directory sees the values
+    local_disk_cache other(dir, 0);
+    TS_ASSERT(other.read("a", value));
+    TS_ASSERT_EQUALS(value, std::string(1000, 'a'));
+
+    // whole files
+    std::string source = get_temp_name();
+    std::string dest = get_temp_name();
+    {
+      std::ofstream fout(source, std::ofstream::binary);
+      fout << "file contents";
+    }
+    TS_ASSERT(!other.copy_to("file", dest));
+    TS_ASSERT(other.write_file("file", source));
+    TS_ASSERT(cache.copy_to("file", dest));
+    std::ifstream fin(dest, std::ifstream::binary);
+    std::string contents((std::istreambuf_iterator<char>(fin)),
+                         std::istreambuf_iterator<char>());
+    TS_ASSERT_EQUALS(contents, "file contents");
+    fin.close();
+
+    fs::remove(source);
+    fs::remove(dest);
+    fs::remove_all(dir);
+  }
+
+  void test_lru_eviction() {
+    std::string dir = get_temp_name();
+    local_disk_cache cache(dir, 1000);
+    std::time_t now = std::time(nullptr);
+    for (std::string key: {"a", "b", "c"}) {
+      TS_ASSERT(cache.write(key, std::string(100, key[0])));
+    }
+    // a, then b, then c were last used
+    fs::last_write_time(fs::path(dir) / md5("a"), now - 300);
+    fs::last_write_time(fs::path(dir) / md5("b"), now - 200);
+    fs::last_write_time(fs::path(dir) / md5("c"), now - 100);
+
+    // reading a makes b the least recently used
+    std::string value;
+    TS_ASSERT(cache.read("a", value));
+    cache.set_max_bytes(250);
+    cache.evict();
+    TS_ASSERT(cache.read("a", value));
+    TS_ASSERT(!cache.read("b", value));
+    TS_ASSERT(cache.read("c", value));
+
+    // writing goes over the limit again, and the new value is kept
+    fs::last_write_time(fs::path(dir) / md5("c"), now - 100);
+    fs::last_write_time(fs::path(dir) / md5("a"), now - 50);
+    TS_ASSERT(cache.write("d", std::string(200, 'd')));
+    size_t total_bytes = 0;
+    for (fs::directory_iterator iter(dir), end; iter != end; ++iter) {
+      if (iter->path().filename() != "lock") total_bytes += fs::file_size(iter->path());
+    }
+    TS_ASSERT_LESS_THAN_EQUALS(total_bytes, 250);
+    TS_ASSERT(!cache.read("c", value));
+    TS_ASSERT(!cache.read("a", value));
+    TS_ASSERT(cache.read("d", value));
+    TS_ASSERT_EQUALS(value, std::string(200, 'd'));
+    fs::remove_all(dir);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_local_disk_cache_test, local_disk_cache_test)
+BOOST_AUTO_TEST_CASE(test_read_write) {
+  local_disk_cache_test::test_read_write();
+}
+BOOST_AUTO_TEST_CASE(test_lru_eviction) {
+  local_disk_cache_test::test_lru_eviction();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,70 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <fstream>
+#include <string>
+#include <core/util/test_macros.hpp>
+#include <core/storage/fileio/mapped_file.hpp>
+#include <core/storage/fileio/temp_files.hpp>
+
+using namespace turi;
+
+
+struct mapped_file_test {
+
+ public:
+
+  void test_mapped_file() {
+    std::string fname = get_temp_name();
+    std::string contents;
+    for (size_t i = 0;i < 100000; ++i) contents.push_back((char)(i * 31));
+    {
+      std::ofstream fout(fname.c_str(), std::ios::binary);
+      fout.write(contents.data(), contents.size());
+    }
+    {
+      fileio::mapped_file mapping(fname);
+      TS_ASSERT(mapping.is_open());
+      TS_ASSERT_EQUALS(mapping.size(), contents.size());
+      TS_ASSERT(std::string(mapping.data(), mapping.size()) == contents);
+      // ranges past the end are ignored
+      mapping.will_need(4097, 100);
+      mapping.will_need(contents.size() - 5, 10000);
+      mapping.will_need(2 * contents.size(), 10);
+    }
+    {
+      fileio::mapped_file mapping("file://" + fname);
+      TS_ASSERT(mapping.is_open());
+      TS_ASSERT_EQUALS(mapping.size(), contents.size());
+    }
+    delete_temp_file(fname);
+  }
+
+  void test_unmappable() {
+    // missing file
+    fileio::mapped_file missing(get_temp_name());
+    TS_ASSERT(!missing.is_open());
+
+    // empty file
+    std::string fname = get_temp_name();
+    { std::ofstream fout(fname.c_str()); }
+    fileio::mapped_file empty(fname);
+    TS_ASSERT(!empty.is_open());
+    delete_temp_file(fname);
+
+    // remote files
+    TS_ASSERT(!fileio::mapped_file::is_local_path("s3://bucket/key"));
+    TS_ASSERT(!fileio::mapped_file::is_local_path("cache://tmp/a"));
+    TS_ASSERT(fileio::mapped_file::is_local_path("/tmp/a"));
+    fileio::mapped_file remote("s3://bucket/key");
+    TS_ASSERT(!remote.is_open());
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_mapped_file_test, mapped_file_test)
+BOOST_AUTO_TEST_CASE(test_mapped_file) {
+  mapped_file_test::test_mapped_file();
+}
+BOOST_AUTO_TEST_CASE(test_unmappable) {
+  mapped_file_test::test_unmappable();
+}
+BOOST_AUTO_TEST_SUITE_END()
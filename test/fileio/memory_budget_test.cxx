@@ -0,0 +1,133 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <string>
+#include <core/storage/fileio/memory_budget.hpp>
+#include <core/storage/fileio/fixed_size_cache_manager.hpp>
+#include <core/storage/fileio/general_fstream.hpp>
+
+using namespace turi::fileio;
+
+struct memory_budget_test {
+ public:
+  memory_budget& budget = memory_budget::get_instance();
+
+  ~memory_budget_test() {
+    FILEIO_MEMORY_BUDGET = 0;
+    fixed_size_cache_manager::get_instance().clear();
+  }
+
+  void test_reservations() {
+    size_t base = budget.reserved();
+    FILEIO_MEMORY_BUDGET = base + 1000;
+    FILEIO_MEMORY_BUDGET_WAIT_MS = 10;
+    TS_ASSERT_EQUALS(budget.available(), 1000);
+
+    {
+      memory_reservation r;
+      TS_ASSERT(r.try_grow(600));
+      TS_ASSERT(!r.try_grow(600));
+      TS_ASSERT_EQUALS(r.size(), 600);
+      TS_ASSERT_EQUALS(budget.available(), 400);
+
+      // takes what is free
+      memory_reservation partial;
+      TS_ASSERT_EQUALS(partial.reserve_up_to(1000, 100), 400);
+      TS_ASSERT_EQUALS(budget.available(), 0);
+      partial.shrink(300);
+      TS_ASSERT_EQUALS(budget.available(), 300);
+
+      // waits, then goes over the budget
+      size_t overcommits = FILEIO_MEMORY_BUDGET_OVERCOMMITS;
+      memory_reservation over;
+      over.grow(500);
+      TS_ASSERT_EQUALS(FILEIO_MEMORY_BUDGET_OVERCOMMITS, overcommits + 1);
+      TS_ASSERT_EQUALS(budget.available(), 0);
+
+      memory_reservation moved(std::move(over));
+      TS_ASSERT_EQUALS(over.size(), 0);
+      TS_ASSERT_EQUALS(moved.size(), 500);
+    }
+    TS_ASSERT_EQUALS(budget.reserved(), base);
+
+    // no limit
+    FILEIO_MEMORY_BUDGET = 0;
+    TS_ASSERT_EQUALS(budget.available(), (size_t)(-1));
+    memory_reservation r;
+    TS_ASSERT_EQUALS(r.reserve_up_to(1 << 30, 0), 1 << 30);
+  }
+
+  void test_spill_callback() {
+    size_t base = budget.reserved();
+    FILEIO_MEMORY_BUDGET = base + 1000;
+
+    // a subsystem holding 800 spillable bytes
+    memory_reservation held;
+    TS_ASSERT(held.try_grow(800));
+    size_t requested = 0;
+    size_t id = budget.register_spill_callback([&](size_t bytes) {
+        requested = bytes;
+        held.release();
+        return (size_t)800;
+      });
+    memory_reservation r;
+    TS_ASSERT(r.try_grow(500));
+    TS_ASSERT_EQUALS(requested, 300);
+    TS_ASSERT_EQUALS(held.size(), 0);
+    budget.unregister_spill_callback(id);
+
+    // nothing left to spill
+    TS_ASSERT(!r.try_grow(600));
+    r.release();
+
+    // a partial reservation spills to get all it asks for, rather than
+    // settling for what is free
+    TS_ASSERT(held.try_grow(800));
+    id = budget.register_spill_callback([&](size_t bytes) {
+        requested = bytes;
+        held.release();
+        return (size_t)800;
+      });
+    TS_ASSERT_EQUALS(r.reserve_up_to(900, 50), 900);
+    TS_ASSERT_EQUALS(requested, 700);
+    budget.unregister_spill_callback(id);
+  }
+
+  void test_cache_spills() {
+    auto& cache = fixed_size_cache_manager::get_instance();
+    FILEIO_MAXIMUM_CACHE_CAPACITY = 1024 * 1024;
+    FILEIO_MAXIMUM_CACHE_CAPACITY_PER_FILE = 1024 * 1024;
+    size_t base = budget.reserved();
+    FILEIO_MEMORY_BUDGET = base + 512 * 1024;
+
+    std::string fname = cache.get_temp_cache_id();
+    {
+      turi::general_ofstream fout(fname);
+      fout << std::string(256 * 1024, 'A');
+    }
+    TS_ASSERT(cache.get_cache(fname)->is_pointer());
+    TS_ASSERT_LESS_THAN(budget.available(), 256 * 1024);
+
+    // a sort needing most of the budget pushes the unused block to disk
+    memory_reservation sort_memory;
+    TS_ASSERT(sort_memory.try_grow(400 * 1024));
+    TS_ASSERT(!cache.get_cache(fname)->is_pointer());
+
+    turi::general_ifstream fin(fname);
+    std::string contents;
+    fin >> contents;
+    TS_ASSERT_EQUALS(contents, std::string(256 * 1024, 'A'));
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_memory_budget_test, memory_budget_test)
+BOOST_AUTO_TEST_CASE(test_reservations) {
+  memory_budget_test::test_reservations();
+}
+BOOST_AUTO_TEST_CASE(test_spill_callback) {
+  memory_budget_test::test_spill_callback();
+}
+BOOST_AUTO_TEST_CASE(test_cache_spills) {
+  memory_budget_test::test_cache_spills();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,7 +4,10 @@
 #include <fstream>
 #include <core/util/test_macros.hpp>
 #include <string>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
 #include <core/storage/fileio/temp_files.hpp>
+#include <core/storage/fileio/fileio_constants.hpp>
 
 using namespace turi;
 
@@ -64,6 +67,39 @@ struct temp_file_test  {
       }
     }
   }
+
+  void test_striped_directories() {
+    std::string original_locations = fileio::get_cache_file_locations();
+    size_t original_min_free = fileio::FILEIO_TEMP_DIRECTORY_MIN_FREE_BYTES;
+    // two directories on the same disk
+    auto base = boost::filesystem::temp_directory_path() /
+                boost::filesystem::unique_path();
+    std::string dira = (base / "a").string(), dirb = (base / "b").string();
+    boost::filesystem::create_directories(dira);
+    boost::filesystem::create_directories(dirb);
+    fileio::set_cache_file_locations(dira + ":" + dirb);
+
+    // used in turn
+    size_t in_a = 0, in_b = 0;
+    for (size_t i = 0; i < 10; ++i) {
+      std::string name = get_temp_name();
+      if (boost::starts_with(name, dira)) ++in_a;
+      if (boost::starts_with(name, dirb)) ++in_b;
+    }
+    TS_ASSERT_EQUALS(in_a, 5);
+    TS_ASSERT_EQUALS(in_b, 5);
+
+    // when all are too full, temp files still go to one of them
+    fileio::FILEIO_TEMP_DIRECTORY_MIN_FREE_BYTES = (size_t)(-1);
+    for (size_t i = 0; i < 4; ++i) {
+      std::string name = get_temp_name();
+      TS_ASSERT(boost::starts_with(name, dira) || boost::starts_with(name, dirb));
+    }
+
+    fileio::FILEIO_TEMP_DIRECTORY_MIN_FREE_BYTES = original_min_free;
+    fileio::set_cache_file_locations(original_locations);
+    boost::filesystem::remove_all(base);
+  }
 };
 
 
@@ -71,4 +107,7 @@ BOOST_FIXTURE_TEST_SUITE(_temp_file_test, temp_file_test)
 BOOST_AUTO_TEST_CASE(test_temp_file) {
   temp_file_test::test_temp_file();
 }
+BOOST_AUTO_TEST_CASE(test_striped_directories) {
+  temp_file_test::test_striped_directories();
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,163 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <random>
+#include <string>
+#include <vector>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/data/flexible_type/date_time_format.hpp>
+
+using namespace turi;
+using namespace turi::flexible_type_impl;
+
+namespace {
+
+const std::vector<std::string> formats = {
+  "%Y-%m-%dT%H:%M:%S%ZP",
+  "%Y%m%dT%H%M%S%F%q",
+  "%Y-%m-%d %H:%M:%S",
+  "%Y-%m-%d %H:%M:%S.%f",
+  "%Y/%m/%d %H:%M:%S%Q",
+  "%Y-%m-%dT%H:%M:%S%F%ZP",
+  "%d.%m.%Y %H:%M",
+  "%y %j %s %T %%",
+  "%d-%b-%Y %H:%M:%S",  // not compiled
+};
+
+bool same_value(const flex_date_time& a, const flex_date_time& b) {
+  return a.posix_timestamp() == b.posix_timestamp() &&
+         a.microsecond() == b.microsecond() &&
+         a.time_zone_offset() == b.time_zone_offset();
+}
+
+/// Returns false if reading throws
+bool try_read(date_time_string_reader& reader, const std::string& s, flex_date_time& out) {
+  try {
+    out = reader.read(s);
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
+} // anonymous namespace
+
+struct date_time_format_test {
+ public:
+  void test_compiled_matches_boost() {
+    std::mt19937_64 rng(1);
+    for (const auto& format: formats) {
+      date_time_string_writer fast_writer(format), boost_writer(format, false);
+      date_time_string_reader fast_reader(format), boost_reader(format, false);
+      for (size_t i = 0; i < 5000; ++i) {
+        int64_t timestamp = int64_t(rng() % 20000000000ULL) - 10000000000LL;
+        int32_t microsecond = rng() % 3 == 0 ? 0 : rng() % 1000000;
+        int32_t tz = rng() % 3 == 0 ? flex_date_time::EMPTY_TIMEZONE : int32_t(rng() % 97) - 48;
+        flex_date_time value(timestamp, tz, microsecond);
+
+        std::string expected = boost_writer.write(value);
+        TS_ASSERT_EQUALS(fast_writer.write(value), expected);
+
+        // read back, sometimes with a character changed, removed or added
+        std::string s = expected;
+        switch (rng() % 4) {
+          case 1: s[rng() % s.size()] = "09:.-+ TZG"[rng() % 10]; break;
+          case 2: s.erase(rng() % s.size(), 1); break;
+          case 3: s.insert(rng() % (s.size() + 1), 1, "09:.-+ TZG"[rng() % 10]); break;
+          default: break;
+        }
+        flex_date_time fast_value, boost_value;
+        bool fast_ok = try_read(fast_reader, s, fast_value);
+        bool boost_ok = try_read(boost_reader, s, boost_value);
+        TS_ASSERT_EQUALS(fast_ok, boost_ok);
+        if (fast_ok && boost_ok) TS_ASSERT(same_value(fast_value, boost_value));
+      }
+    }
+  }
+
+  void test_parse() {
+    date_time_format iso("%Y%m%dT%H%M%S%F%q");
+    TS_ASSERT(iso.can_parse());
+    flex_date_time value;
+    std::string s = "20110121T020304.5";
+    TS_ASSERT(iso.try_parse(s.data(), s.size(), value));
+    TS_ASSERT_EQUALS(value.posix_timestamp(), 1295575384);
+    TS_ASSERT_EQUALS(value.microsecond(), 500000);
+    TS_ASSERT_EQUALS(value.time_zone_offset(), flex_date_time::EMPTY_TIMEZONE);
+    // left to boost
+    s = "20110121T020304+0500";
+    TS_ASSERT(!iso.try_parse(s.data(), s.size(), value));
+    s = "20110230T020304";
+    TS_ASSERT(!iso.try_parse(s.data(), s.size(), value));
+
+    date_time_format posix("%Y-%m-%dT%H:%M:%S%ZP");
+    s = "2011-01-21T02:03:04GMT-05:30";
+    TS_ASSERT(posix.try_parse(s.data(), s.size(), value));
+    TS_ASSERT_EQUALS(value.posix_timestamp(), 1295575384 + 5 * 3600 + 1800);
+    TS_ASSERT_EQUALS(value.time_zone_offset(), -22);
+    s = "2011-01-21T02:03:04";
+    TS_ASSERT(posix.try_parse(s.data(), s.size(), value));
+    TS_ASSERT_EQUALS(value.time_zone_offset(), flex_date_time::EMPTY_TIMEZONE);
+
+    TS_ASSERT(!date_time_format("%d-%b-%Y").can_parse());
+    TS_ASSERT(!date_time_format("%d-%b-%Y").can_format());
+    TS_ASSERT(!date_time_format("%H:%M:%S").can_parse());
+    TS_ASSERT(date_time_format("%H:%M:%S").can_format());
+  }
+
+  void test_format() {
+    date_time_format posix("%Y-%m-%dT%H:%M:%S%F%ZP");
+    std::string out;
+    TS_ASSERT(posix.try_format(flex_date_time(1295575384, 20, 56), out));
+    TS_ASSERT_EQUALS(out, "2011-01-21T07:03:04.000056GMT+05");
+    out.clear();
+    TS_ASSERT(posix.try_format(flex_date_time(1295575384), out));
+    TS_ASSERT_EQUALS(out, "2011-01-21T02:03:04");
+    // offsets which are not whole hours are left to boost
+    out.clear();
+    TS_ASSERT(!posix.try_format(flex_date_time(1295575384, 1), out));
+
+    date_time_string_writer writer("%Y-%m-%dT%H:%M:%S%F%ZP");
+    date_time_string_reader reader("%Y-%m-%dT%H:%M:%S%F%ZP");
+    for (int32_t tz = flex_date_time::TIMEZONE_LOW; tz <= flex_date_time::TIMEZONE_HIGH; tz += 4) {
+      flex_date_time value(1295575384, tz, 123456);
+      flex_date_time back = reader.read(writer.write(value));
+      TS_ASSERT(same_value(back, value));
+    }
+  }
+
+  void test_civil_time() {
+    // 2011-01-21T02:03:04 was a Friday
+    civil_time t = civil_time_from_timestamp(1295575384);
+    TS_ASSERT_EQUALS(t.year, 2011);
+    TS_ASSERT_EQUALS(t.month, 1);
+    TS_ASSERT_EQUALS(t.day, 21);
+    TS_ASSERT_EQUALS(t.hour, 2);
+    TS_ASSERT_EQUALS(t.minute, 3);
+    TS_ASSERT_EQUALS(t.second, 4);
+    TS_ASSERT_EQUALS(t.weekday, 5);
+    TS_ASSERT_EQUALS(t.yearday, 21);
+    t = civil_time_from_timestamp(-1);
+    TS_ASSERT_EQUALS(t.year, 1969);
+    TS_ASSERT_EQUALS(t.month, 12);
+    TS_ASSERT_EQUALS(t.day, 31);
+    TS_ASSERT_EQUALS(t.second, 59);
+    TS_ASSERT_EQUALS(t.weekday, 3);
+    TS_ASSERT_EQUALS(t.yearday, 365);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_date_time_format_test, date_time_format_test)
+BOOST_AUTO_TEST_CASE(test_compiled_matches_boost) {
+  date_time_format_test::test_compiled_matches_boost();
+}
+BOOST_AUTO_TEST_CASE(test_parse) {
+  date_time_format_test::test_parse();
+}
+BOOST_AUTO_TEST_CASE(test_format) {
+  date_time_format_test::test_format();
+}
+BOOST_AUTO_TEST_CASE(test_civil_time) {
+  date_time_format_test::test_civil_time();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -575,3 +575,48 @@ BOOST_AUTO_TEST_CASE(test_equality_fail) {
  bool t = f1 == f2;
  BOOST_TEST(t == false);
 }
+
+BOOST_AUTO_TEST_CASE(test_contiguous_views) {
+ ndarray<int> array1({0,1,2,3,
+                      4,5,6,7,
+                      8,9,10,11},
+                      {3,4},
+                      {4,1});
+ BOOST_TEST(array1.is_contiguous());
+ // rows 1 and 2 share the storage of array1
+ ndarray<int> rows = array1.slice(1, 3);
+ BOOST_TEST(rows.is_contiguous());
+ BOOST_TEST(rows.is_full() == false);
+ BOOST_TEST(&rows.raw_elements() == &array1.raw_elements());
+ BOOST_TEST(rows.sum() == 4+5+6+7+8+9+10+11);
+
+ ndarray<int> flat = rows.reshape({8});
+ BOOST_TEST(&flat.raw_elements() == &array1.raw_elements());
+ std::vector<size_t> desired_shape{8};
+ BOOST_TEST(flat.shape() == desired_shape, tt::per_element());
+ nd_assert_equal(flat, ndarray<int>({4,5,6,7,8,9,10,11}));
+
+ // writing to a view only copies the elements of the view
+ rows += 1;
+ BOOST_TEST(rows.is_full());
+ nd_assert_equal(rows, ndarray<int>({5,6,7,8,9,10,11,12}, {2,4}));
+ nd_assert_equal(array1.slice(1, 3), ndarray<int>({4,5,6,7,8,9,10,11}, {2,4}));
+
+ // a transposed array is not contiguous
+ ndarray<int> transposed({0,1,2,3,4,5}, {3,2}, {1,3});
+ BOOST_TEST(transposed.is_contiguous() == false);
+ nd_assert_equal(transposed.reshape({6}), ndarray<int>({0,3,1,4,2,5}));
+}
+
+BOOST_AUTO_TEST_CASE(test_dot_and_apply) {
+ ndarray<double> array1({1,2,3,4}, {2,2});
+ ndarray<double> array2({1,3,2,4}, {2,2}, {1,2});
+ BOOST_TEST(array1.dot(array2) == 1*1 + 2*2 + 3*3 + 4*4);
+ BOOST_TEST(array1.dot(array1) == 1*1 + 2*2 + 3*3 + 4*4);
+
+ ndarray<double> shared = array1;
+ shared.apply(array2, [](double& a, const double& b) { a = a * 10 + b; });
+ nd_assert_equal(shared, ndarray<double>({11,22,33,44}, {2,2}));
+ // the copy is not modified
+ nd_assert_equal(array1, ndarray<double>({1,2,3,4}, {2,2}));
+}
@@ -9,6 +9,7 @@
 #include <vector>
 #include <iostream>
 #include <typeinfo>       // operator typeid
+#include <thread>
 
 
 #include <core/data/flexible_type/flexible_type.hpp>
@@ -510,6 +511,48 @@ struct new_flexible_type_test  {
       converter_test<std::tuple<size_t, int, double>>(std::tuple<size_t, int, double>{1, -1, 3.0});
       converter_test<std::tuple<double, int, int>>(std::tuple<double,int,int>{1.0, 1, 2});
     }
+
+    void test_payload_cache() {
+      using flexible_type_impl::num_cached_payloads;
+      // freed payloads are kept by the thread which frees them, and reused.
+      // Counted in a new thread, whose cache starts out empty.
+      std::vector<flexible_type> values;
+      std::vector<size_t> num_cached;
+      std::thread first([&]() {
+        num_cached.push_back(num_cached_payloads());
+        for (size_t i = 0; i < 100; ++i) {
+          values.push_back(std::to_string(i) + " is a string long enough to allocate");
+          values.push_back(flex_vec{double(i)});
+          values.push_back(flex_dict{{i, i}});
+        }
+        values.clear();
+        num_cached.push_back(num_cached_payloads());
+        for (size_t i = 0; i < 100; ++i) values.push_back(flex_list{i});
+        num_cached.push_back(num_cached_payloads());
+      });
+      first.join();
+      TS_ASSERT_EQUALS(num_cached, std::vector<size_t>({0, 300, 200}));
+
+      // payloads may be freed by another thread than the one which
+      // allocated them
+      std::thread second([&]() {
+        values.clear();
+        num_cached.push_back(num_cached_payloads());
+      });
+      second.join();
+      TS_ASSERT_EQUALS(num_cached.back(), 100);
+
+      // reused payloads start out empty, and copies are still copy on write
+      std::vector<flexible_type> strings(10, flexible_type("not empty"));
+      for (auto& v : strings) v.mutable_get<flex_string>() += "!";
+      strings.clear();
+      flexible_type s = flex_string();
+      TS_ASSERT_EQUALS(s.get<flex_string>(), "");
+      flexible_type t = s;
+      t.mutable_get<flex_string>() = "changed";
+      TS_ASSERT_EQUALS(s.get<flex_string>(), "");
+      TS_ASSERT_EQUALS(t.get<flex_string>(), "changed");
+    }
 };
 
 BOOST_FIXTURE_TEST_SUITE(_new_flexible_type_test, new_flexible_type_test)
@@ -531,4 +574,7 @@ BOOST_AUTO_TEST_CASE(test_parser) {
 BOOST_AUTO_TEST_CASE(test_flexible_type_converters) {
   new_flexible_type_test::test_flexible_type_converters();
 }
+BOOST_AUTO_TEST_CASE(test_payload_cache) {
+  new_flexible_type_test::test_payload_cache();
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,86 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <string>
+#include <vector>
+#include <boost/spirit/include/qi.hpp>
+#include <core/data/flexible_type/flexible_type_spirit_parser.hpp>
+
+using namespace turi;
+namespace qi = boost::spirit::qi;
+
+struct number_parse_test {
+ public:
+  /// A pseudo random string of length len made of the characters in alphabet.
+  std::string make_string(size_t len, size_t seed, const std::string& alphabet) {
+    std::string s;
+    uint64_t state = seed * 2654435761ULL + 1;
+    for (size_t i = 0; i < len; ++i) {
+      state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+      s.push_back(alphabet[(state >> 33) % alphabet.size()]);
+    }
+    return s;
+  }
+
+  /// int_parse and double_parse must match the Spirit parsers exactly
+  void check_same_as_spirit(flexible_type_parser& parser, const std::string& s) {
+    using boost::spirit::iso8859_1::space;
+    {
+      const char* expected_end = s.c_str();
+      flex_int expected = 0;
+      bool expected_ok = qi::phrase_parse(expected_end, s.c_str() + s.length(),
+                                          qi::long_long, space, expected);
+      const char* end = s.c_str();
+      auto ret = parser.int_parse(&end, s.length());
+      TS_ASSERT_EQUALS(ret.second, expected_ok);
+      if (ret.second && expected_ok) {
+        TS_ASSERT_EQUALS(ret.first.get_type(), flex_type_enum::INTEGER);
+        TS_ASSERT_EQUALS(ret.first.get<flex_int>(), expected);
+        TS_ASSERT_EQUALS(end - s.c_str(), expected_end - s.c_str());
+      }
+    }
+    {
+      const char* expected_end = s.c_str();
+      double expected = 0;
+      bool expected_ok = qi::phrase_parse(expected_end, s.c_str() + s.length(),
+                                          qi::double_, space, expected);
+      const char* end = s.c_str();
+      auto ret = parser.double_parse(&end, s.length());
+      TS_ASSERT_EQUALS(ret.second, expected_ok);
+      if (ret.second && expected_ok) {
+        TS_ASSERT_EQUALS(ret.first.get_type(), flex_type_enum::FLOAT);
+        double value = ret.first.get<flex_float>();
+        // bitwise, so that -0.0 and 0.0 differ
+        TS_ASSERT(memcmp(&value, &expected, sizeof(double)) == 0 ||
+                  (std::isnan(value) && std::isnan(expected)));
+        TS_ASSERT_EQUALS(end - s.c_str(), expected_end - s.c_str());
+      }
+    }
+  }
+
+  void test_numbers() {
+    flexible_type_parser parser;
+    for (std::string s: {"0", "-0", "+0", "1", "-1", "12", " 12 ", "12 ,", "\t-7\r",
+                         "123456789012345678", "-123456789012345678",
+                         "1234567890123456789", "9223372036854775807",
+                         "-9223372036854775808", "9223372036854775808",
+                         "1.5", "-1.5", ".5", "5.", "-.5", "5.e3", "1e5", "1E-5",
+                         "1e+22", "1e23", "1e-22", "1e-23", "3.14159", "0.1",
+                         "9007199254740992", "9007199254740993", "1e", "1e+",
+                         "1ex", "12abc", "1.5.5", "--1", "+-1", "", " ", ".",
+                         "-", "nan", "inf", "-inf", "0x10", "1,2", "00001.5000",
+                         "1e0001", "1e00001", "123456.789e-3",
+                         "12\xa0", "\xa0" "12"}) {
+      check_same_as_spirit(parser, s);
+    }
+    for (size_t seed = 0; seed < 20000; ++seed) {
+      check_same_as_spirit(parser, make_string(seed % 12, seed, "0123456789.-+e "));
+    }
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_number_parse_test, number_parse_test)
+BOOST_AUTO_TEST_CASE(test_numbers) {
+  number_parse_test::test_numbers();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,53 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <thread>
+#include <vector>
+#include <core/generics/bloom_filter.hpp>
+
+using namespace turi;
+
+struct bloom_filter_test {
+ public:
+  void test_bloom_filter() {
+    bloom_filter empty;
+    TS_ASSERT_EQUALS(empty.num_bits(), 0);
+    TS_ASSERT(!empty.may_contain(1));
+
+    const size_t num_keys = 10000;
+    bloom_filter filter(num_keys);
+    TS_ASSERT_EQUALS(filter.num_bits(), bloom_filter::num_bits_for(num_keys));
+    TS_ASSERT_LESS_THAN_EQUALS(num_keys * bloom_filter::DEFAULT_BITS_PER_KEY,
+                               filter.num_bits());
+    // even keys, inserted from several threads
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; ++t) {
+      threads.emplace_back([&, t]() {
+        for (size_t i = t; i < num_keys; i += 4) filter.insert(2 * i);
+      });
+    }
+    for (auto& t : threads) t.join();
+
+    for (size_t i = 0; i < num_keys; ++i) TS_ASSERT(filter.may_contain(2 * i));
+    size_t false_positives = 0;
+    for (size_t i = 0; i < num_keys; ++i) false_positives += filter.may_contain(2 * i + 1);
+    // about 1% expected
+    TS_ASSERT_LESS_THAN(false_positives, num_keys / 20);
+  }
+
+  void test_fixed_bloom_filter() {
+    fixed_bloom_filter<4096, 3> filter;
+    filter.clear();
+    for (size_t i = 0; i < 100; ++i) filter.insert(i * 7919);
+    for (size_t i = 0; i < 100; ++i) TS_ASSERT(filter.may_contain(i * 7919));
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_bloom_filter_test, bloom_filter_test)
+BOOST_AUTO_TEST_CASE(test_bloom_filter) {
+  bloom_filter_test::test_bloom_filter();
+}
+BOOST_AUTO_TEST_CASE(test_fixed_bloom_filter) {
+  bloom_filter_test::test_fixed_bloom_filter();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,120 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <core/generics/concurrent_hash_map.hpp>
+
+using namespace turi;
+
+struct concurrent_hash_map_test {
+ public:
+  void test_sequential() {
+    concurrent_hash_map<size_t, std::string> m(3);
+    TS_ASSERT_EQUALS(m.num_shards(), 4);
+    TS_ASSERT(m.empty());
+
+    TS_ASSERT(m.insert(1, "a"));
+    TS_ASSERT(!m.insert(1, "b"));
+    std::string v;
+    TS_ASSERT(m.find(1, v));
+    TS_ASSERT_EQUALS(v, "a");
+    TS_ASSERT(!m.find(2, v));
+    TS_ASSERT(!m.contains(2));
+
+    m.insert_or_assign(1, "c");
+    TS_ASSERT(m.find_unlocked(1, v));
+    TS_ASSERT_EQUALS(v, "c");
+
+    size_t num_made = 0;
+    auto make = [&]() { ++num_made; return std::string("d"); };
+    TS_ASSERT(m.find_or_insert(2, make) == std::make_pair(std::string("d"), true));
+    TS_ASSERT(m.find_or_insert(2, make) == std::make_pair(std::string("d"), false));
+    TS_ASSERT_EQUALS(num_made, 1);
+
+    TS_ASSERT(!m.upsert(2, "e", [](std::string& s) { s += "!"; }));
+    TS_ASSERT(m.upsert(3, "e", [](std::string& s) { s += "!"; }));
+    m.find(2, v);
+    TS_ASSERT_EQUALS(v, "d!");
+    m.find(3, v);
+    TS_ASSERT_EQUALS(v, "e");
+    TS_ASSERT_EQUALS(m.size(), 3);
+
+    // copies are independent
+    concurrent_hash_map<size_t, std::string> copy(m);
+    m.clear();
+    TS_ASSERT(m.empty());
+    TS_ASSERT_EQUALS(copy.size(), 3);
+    TS_ASSERT(copy.contains(3));
+  }
+
+  void test_concurrent_find_or_insert() {
+    // every thread indexes the same keys; every key must get exactly one
+    // index, and the indices must be 0 ... num_keys - 1
+    const size_t num_keys = 20000;
+    const size_t num_threads = 8;
+    concurrent_hash_map<size_t, size_t> m;
+    std::atomic<size_t> next_index(0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+      threads.emplace_back([&, t]() {
+        for (size_t i = 0; i < num_keys; ++i) {
+          size_t key = (i * 7919 + t * 104729) % num_keys;
+          m.find_or_insert(key, [&]() { return next_index++; });
+        }
+      });
+    }
+    for (auto& t : threads) t.join();
+
+    TS_ASSERT_EQUALS(next_index.load(), num_keys);
+    TS_ASSERT_EQUALS(m.size(), num_keys);
+    std::vector<size_t> seen(num_keys, 0);
+    m.for_each([&](size_t, size_t index) { ++seen[index]; });
+    for (size_t i = 0; i < num_keys; ++i) TS_ASSERT_EQUALS(seen[i], 1);
+  }
+
+  void test_concurrent_upsert() {
+    const size_t num_keys = 1000;
+    const size_t num_threads = 8;
+    concurrent_hash_map<size_t, size_t> m(16);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+      threads.emplace_back([&]() {
+        for (size_t rep = 0; rep < 10; ++rep) {
+          for (size_t i = 0; i < num_keys; ++i) {
+            m.upsert(i, 1, [](size_t& c) { ++c; });
+          }
+        }
+      });
+    }
+    for (auto& t : threads) t.join();
+
+    TS_ASSERT_EQUALS(m.size(), num_keys);
+    std::vector<size_t> shard_sizes = m.shard_sizes();
+    size_t total = 0;
+    for (size_t n : shard_sizes) total += n;
+    TS_ASSERT_EQUALS(total, num_keys);
+
+    std::atomic<size_t> sum(0), num_wrong(0);
+    m.parallel_for_each([&](size_t shard, size_t, size_t& count) {
+      if (shard >= m.num_shards() || count != num_threads * 10) ++num_wrong;
+      sum += count;
+    });
+    TS_ASSERT_EQUALS(num_wrong.load(), 0);
+    TS_ASSERT_EQUALS(sum.load(), num_keys * num_threads * 10);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_concurrent_hash_map_test, concurrent_hash_map_test)
+BOOST_AUTO_TEST_CASE(test_sequential) {
+  concurrent_hash_map_test::test_sequential();
+}
+BOOST_AUTO_TEST_CASE(test_concurrent_find_or_insert) {
+  concurrent_hash_map_test::test_concurrent_find_or_insert();
+}
+BOOST_AUTO_TEST_CASE(test_concurrent_upsert) {
+  concurrent_hash_map_test::test_concurrent_upsert();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,116 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <core/generics/lock_free_ring_queue.hpp>
+#include <core/util/buffer_pool.hpp>
+
+using namespace turi;
+
+struct lock_free_ring_queue_test {
+ public:
+  void test_sequential() {
+    lock_free_ring_queue<int> empty;
+    int v = -1;
+    TS_ASSERT_EQUALS(empty.capacity(), 0);
+    TS_ASSERT(!empty.try_enqueue(1));
+    TS_ASSERT(!empty.try_dequeue(v));
+
+    lock_free_ring_queue<int> q(5);
+    TS_ASSERT_EQUALS(q.capacity(), 8);
+    // fill and drain a few times, wrapping around the ring
+    for (int lap = 0; lap < 3; ++lap) {
+      for (int i = 0; i < 8; ++i) TS_ASSERT(q.try_enqueue(lap * 8 + i));
+      TS_ASSERT(!q.try_enqueue(100));
+      TS_ASSERT_EQUALS(q.approx_size(), 8);
+      for (int i = 0; i < 8; ++i) {
+        TS_ASSERT(q.try_dequeue(v));
+        TS_ASSERT_EQUALS(v, lap * 8 + i);
+      }
+      TS_ASSERT(!q.try_dequeue(v));
+      TS_ASSERT_EQUALS(q.approx_size(), 0);
+    }
+
+    // a failed enqueue leaves the value alone, and dequeued slots do not
+    // keep the values alive
+    lock_free_ring_queue<std::shared_ptr<int>> ptrs(2);
+    auto p = std::make_shared<int>(1);
+    TS_ASSERT(ptrs.try_enqueue(p));
+    TS_ASSERT(ptrs.try_enqueue(p));
+    std::shared_ptr<int> moved = p;
+    TS_ASSERT(!ptrs.try_enqueue(std::move(moved)));
+    TS_ASSERT(moved != nullptr);
+    std::shared_ptr<int> out;
+    TS_ASSERT(ptrs.try_dequeue(out));
+    TS_ASSERT(ptrs.try_dequeue(out));
+    out.reset();
+    moved.reset();
+    TS_ASSERT(p.unique());
+  }
+
+  void test_concurrent() {
+    // every element is dequeued exactly once
+    const size_t num_threads = 4;
+    const size_t num_per_thread = 100000;
+    lock_free_ring_queue<size_t> q(64);
+    std::vector<std::atomic<int>> seen(num_threads * num_per_thread);
+    for (auto& s : seen) s = 0;
+    std::atomic<size_t> num_dequeued(0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+      threads.emplace_back([&, t]() {
+        for (size_t i = 0; i < num_per_thread; ++i) {
+          size_t v = t * num_per_thread + i;
+          while (!q.try_enqueue(v)) std::this_thread::yield();
+        }
+      });
+      threads.emplace_back([&]() {
+        size_t v;
+        while (num_dequeued < num_threads * num_per_thread) {
+          if (q.try_dequeue(v)) {
+            ++seen[v];
+            ++num_dequeued;
+          } else {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+    for (auto& t : threads) t.join();
+    for (size_t i = 0; i < seen.size(); ++i) {
+      if (seen[i] != 1) TS_ASSERT_EQUALS(seen[i], 1);
+    }
+  }
+
+  void test_buffer_pool() {
+    buffer_pool<std::vector<int>> pool(4);
+    auto a = pool.get_new_buffer();
+    a->push_back(1);
+    std::vector<int>* address = a.get();
+    pool.release_buffer(std::move(a));
+    TS_ASSERT(a == nullptr);
+    // released buffers are reused, and come back cleared
+    auto b = pool.get_new_buffer();
+    TS_ASSERT_EQUALS(b.get(), address);
+    TS_ASSERT(b->empty());
+    // buffers dropped without being released are found again
+    b.reset();
+    auto c = pool.get_new_buffer();
+    TS_ASSERT_EQUALS(c.get(), address);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_lock_free_ring_queue_test, lock_free_ring_queue_test)
+BOOST_AUTO_TEST_CASE(test_sequential) {
+  lock_free_ring_queue_test::test_sequential();
+}
+BOOST_AUTO_TEST_CASE(test_concurrent) {
+  lock_free_ring_queue_test::test_concurrent();
+}
+BOOST_AUTO_TEST_CASE(test_buffer_pool) {
+  lock_free_ring_queue_test::test_buffer_pool();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -116,6 +116,30 @@ struct worker_pool_test {
     TS_ASSERT_EQUALS(wk_pool->call_all_workers<int>(good_fun).size(), nworkers);
   }
 
+  void test_elastic_growth() {
+    int timeout = 1;
+    lambda::worker_pool<dummy_worker_proxy> wk_pool(nworkers, {worker_binary}, timeout, 1);
+    TS_ASSERT_EQUALS(wk_pool.num_workers(), 1);
+    TS_ASSERT_EQUALS(wk_pool.max_workers(), nworkers);
+
+    // holding every worker makes the pool grow up to its maximum
+    std::vector<std::unique_ptr<lambda::worker_process<dummy_worker_proxy>>> workers;
+    for (size_t i = 0; i < nworkers; ++i) {
+      workers.push_back(wk_pool.get_worker());
+      TS_ASSERT_EQUALS(wk_pool.num_workers(), i + 1);
+      std::string message = std::to_string(i);
+      TS_ASSERT(workers.back()->proxy->echo(message).compare(message) == 0);
+    }
+    for (auto& worker : workers) wk_pool.release_worker(worker);
+    TS_ASSERT_EQUALS(wk_pool.num_available_workers(), nworkers);
+
+    auto f = [](std::unique_ptr<dummy_worker_proxy>& proxy) {
+      proxy->echo("");
+      return 0;
+    };
+    TS_ASSERT_EQUALS(wk_pool.call_all_workers<int>(f).size(), nworkers);
+  }
+
   std::shared_ptr<lambda::worker_pool<dummy_worker_proxy>> get_worker_pool(size_t poolsize) {
     int timeout = 1;
     std::shared_ptr<lambda::worker_pool<dummy_worker_proxy>> ret;
@@ -153,4 +177,7 @@ BOOST_AUTO_TEST_CASE(test_call_all_workers_with_exception) {
 BOOST_AUTO_TEST_CASE(test_call_all_workers_with_crash_recovery) {
   worker_pool_test::test_call_all_workers_with_crash_recovery();
 }
+BOOST_AUTO_TEST_CASE(test_elastic_growth) {
+  worker_pool_test::test_elastic_growth();
+}
 BOOST_AUTO_TEST_SUITE_END()
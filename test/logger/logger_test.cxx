@@ -5,6 +5,10 @@
 #include <core/logging/logger.hpp>
 #include <core/logging/log_rotate.hpp>
 #include <core/logging/log_level_setter.hpp>
+#include <core/logging/trace_events.hpp>
+#include <core/globals/globals.hpp>
+#include <core/parallel/lambda_omp.hpp>
+#include <core/storage/sframe_data/json_lines_parser.hpp>
 using namespace turi;
 
 struct logger_test {
@@ -37,6 +41,77 @@ struct logger_test {
     TS_ASSERT(std::ifstream("rotate.log.1").good() == false);
     stop_log_rotation();
   }
+
+  void test_trace_events() {
+    // nothing is recorded until the file is set
+    TS_ASSERT(!trace::enabled());
+    TS_ASSERT(globals::set_global("TURI_TRACE_EVENTS_FILE", "trace_events.json")
+              == globals::set_global_error_codes::SUCCESS);
+    TS_ASSERT(trace::enabled());
+
+    parallel_for(size_t(0), size_t(10000), [&](size_t i) {
+      trace::scoped_span span("test", i % 2 ? "odd" : std::string("even"));
+    });
+    globals::set_global("TURI_TRACE_EVENTS_FILE", "");
+    TS_ASSERT(!trace::enabled());
+    {
+      trace::scoped_span span("test", "ignored");
+    }
+
+    std::ifstream fin("trace_events.json");
+    std::string text((std::istreambuf_iterator<char>(fin)),
+                     std::istreambuf_iterator<char>());
+    flexible_type events;
+    TS_ASSERT(parse_json_value(text.data(), text.data() + text.size(), events));
+    TS_ASSERT_EQUALS(events.get_type(), flex_type_enum::LIST);
+
+    size_t num_odd = 0, num_even = 0;
+    for (const auto& e : events.get<flex_list>()) {
+      std::string name;
+      for (const auto& kv : e.get<flex_dict>()) {
+        if (kv.first == "name") name = kv.second.get<flex_string>();
+      }
+      if (name == "odd") ++num_odd;
+      if (name == "even") ++num_even;
+      TS_ASSERT(name != "ignored");
+    }
+    TS_ASSERT_EQUALS(num_odd, 5000);
+    TS_ASSERT_EQUALS(num_even, 5000);
+  }
+
+  void test_async_log() {
+    global_logger().set_log_level(LOG_INFO);
+    global_logger().set_log_to_console(false);
+    global_logger().set_log_file("async.log");
+    global_logger().set_async(true);
+    TS_ASSERT(global_logger().get_async());
+    for (size_t i = 0; i < 1000; ++i) {
+      logstream(LOG_INFO) << "line " << i << std::endl;
+    }
+    global_logger().flush();
+    {
+      // every line is in the file, in order
+      std::ifstream fin("async.log");
+      std::string line;
+      size_t count = 0;
+      while (std::getline(fin, line)) {
+        TS_ASSERT(line.find("line " + std::to_string(count)) != std::string::npos);
+        ++count;
+      }
+      TS_ASSERT_EQUALS(count, 1000);
+    }
+    // lines logged before a switch of file stay in the old one
+    logstream(LOG_INFO) << "last line" << std::endl;
+    global_logger().set_log_file("async2.log");
+    global_logger().set_async(false);
+    TS_ASSERT(!global_logger().get_async());
+    std::ifstream fin("async.log");
+    std::string text((std::istreambuf_iterator<char>(fin)),
+                     std::istreambuf_iterator<char>());
+    TS_ASSERT(text.find("last line") != std::string::npos);
+    global_logger().set_log_file("");
+    global_logger().set_log_to_console(true);
+  }
 };
 
 BOOST_FIXTURE_TEST_SUITE(_logger_test, logger_test)
@@ -49,4 +124,10 @@ BOOST_AUTO_TEST_CASE(test_log_level_setter) {
 BOOST_AUTO_TEST_CASE(test_log_rotation) {
   logger_test::test_log_rotation();
 }
+BOOST_AUTO_TEST_CASE(test_trace_events) {
+  logger_test::test_trace_events();
+}
+BOOST_AUTO_TEST_CASE(test_async_log) {
+  logger_test::test_async_log();
+}
 BOOST_AUTO_TEST_SUITE_END()
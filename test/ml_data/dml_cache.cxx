@@ -0,0 +1,91 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <string>
+#include <vector>
+
+// ML-Data Utils
+#include <ml/ml_data/ml_data.hpp>
+#include <ml/ml_data/ml_data_iterator.hpp>
+#include <ml/ml_data/ml_data_cache.hpp>
+
+// Testing utils common to all of ml_data_iterator
+#include <ml/ml_data/testing_utils.hpp>
+#include <core/storage/sframe_data/testing_utils.hpp>
+
+using namespace turi;
+
+struct test_ml_data_cache  {
+ public:
+
+  static std::vector<std::vector<ml_data_entry> > all_rows(const ml_data& data) {
+    std::vector<std::vector<ml_data_entry> > ret;
+    std::vector<ml_data_entry> x;
+    for(auto it = data.get_iterator(); !it.done(); ++it) {
+      it->fill(x);
+      ret.push_back(x);
+    }
+    return ret;
+  }
+
+  void test_repeated_fill() {
+    ml_data_cache::get_instance().clear();
+    // the cache is off by default
+    size_t old_capacity = ML_DATA_CACHE_CAPACITY;
+    ML_DATA_CACHE_CAPACITY = 4;
+
+    std::vector<std::vector<flexible_type> > raw_data;
+    for(size_t i = 0; i < 1000; ++i) {
+      raw_data.push_back({std::to_string(i % 17), double(i), flex_int(i % 2)});
+    }
+
+    sframe data_sf = make_testing_sframe({"cat", "num", "target"}, raw_data);
+
+    ml_data X1;
+    X1.fill(data_sf, "target");
+    TS_ASSERT_EQUALS(ml_data_cache::get_instance().size(), 1);
+
+    // The same fill is taken from the cache, with its own metadata.
+    ml_data X2;
+    X2.fill(data_sf, "target");
+    TS_ASSERT_EQUALS(ml_data_cache::get_instance().size(), 1);
+    TS_ASSERT(X1.metadata() != X2.metadata());
+    TS_ASSERT_EQUALS(X2.num_rows(), X1.num_rows());
+    TS_ASSERT_EQUALS(X2.metadata()->column_size(0), 17);
+    TS_ASSERT(all_rows(X1) == all_rows(X2));
+
+    // Different filling parameters are a different entry.
+    ml_data X3;
+    X3.fill(data_sf, "num");
+    TS_ASSERT_EQUALS(ml_data_cache::get_instance().size(), 2);
+    TS_ASSERT_EQUALS(X3.metadata()->target_column_name(), "num");
+
+    // Fills with existing metadata are not cached.
+    ml_data X4(X1.metadata());
+    X4.fill(data_sf, "target");
+    TS_ASSERT_EQUALS(ml_data_cache::get_instance().size(), 2);
+
+    // Releasing the data drops its entries.
+    data_sf = sframe();
+    X1 = ml_data();
+    X2 = ml_data();
+    X3 = ml_data();
+    X4 = ml_data();
+    ml_data_cache_key key("none");
+    TS_ASSERT(ml_data_cache::get_instance().lookup<ml_data>(key) == nullptr);
+    TS_ASSERT_EQUALS(ml_data_cache::get_instance().size(), 0);
+
+    ML_DATA_CACHE_CAPACITY = 0;
+    sframe other_sf = make_testing_sframe({"cat", "num", "target"}, raw_data);
+    ml_data X5;
+    X5.fill(other_sf, "target");
+    TS_ASSERT_EQUALS(ml_data_cache::get_instance().size(), 0);
+    ML_DATA_CACHE_CAPACITY = old_capacity;
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_test_ml_data_cache, test_ml_data_cache)
+BOOST_AUTO_TEST_CASE(test_repeated_fill) {
+  test_ml_data_cache::test_repeated_fill();
+}
+BOOST_AUTO_TEST_SUITE_END()
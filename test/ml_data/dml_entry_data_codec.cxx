@@ -0,0 +1,153 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include <ml/ml_data/data_storage/entry_data_codec.hpp>
+#include <ml/ml_data/data_storage/ml_data_row_format.hpp>
+#include <toolkits/ml_data_2/data_storage/ml_data_row_format.hpp>
+
+using namespace turi;
+using namespace turi::ml_data_internal;
+
+struct test_entry_data_codec  {
+ public:
+
+  static uint64_t bits(double v) {
+    uint64_t ret;
+    std::memcpy(&ret, &v, sizeof(double));
+    return ret;
+  }
+
+  static std::vector<uint64_t> mixed_entries(size_t n) {
+    std::mt19937 rng(0);
+    std::vector<uint64_t> ret;
+    for(size_t i = 0; i < n; ++i) {
+      switch(rng() % 7) {
+        case 0: ret.push_back(rng() % 100000); break;                 // index
+        case 1: ret.push_back(size_t(-1)); break;                     // unseen category
+        case 2: ret.push_back(bits(1.0)); break;                      // integer value
+        case 3: ret.push_back(bits(-3.0)); break;                     // negative integer
+        case 4: ret.push_back(bits(0.25 * (rng() % 64))); break;      // exact float
+        case 5: ret.push_back(bits(1.0 / (1 + rng() % 1000))); break; // full double
+        default: ret.push_back(bits(std::numeric_limits<double>::quiet_NaN())); break;
+      }
+    }
+    return ret;
+  }
+
+  static std::string encode(const std::vector<uint64_t>& v, size_t version) {
+    std::stringstream ss;
+    oarchive oarc(ss);
+    save_entry_data(oarc, v.data(), v.size(), version);
+    return ss.str();
+  }
+
+  static std::vector<uint64_t> decode(const std::string& s, size_t version) {
+    std::stringstream ss(s);
+    iarchive iarc(ss);
+    std::vector<uint64_t> ret;
+    load_entry_data(iarc, ret, version);
+    return ret;
+  }
+
+  void test_round_trip() {
+    for(size_t n : {0, 1, 127, 128, 129, 5000}) {
+      std::vector<uint64_t> v = mixed_entries(n);
+      for(size_t version : {1, 2}) {
+        TS_ASSERT(decode(encode(v, version), version) == v);
+      }
+    }
+
+    // All indices.
+    std::vector<uint64_t> indices(1000);
+    for(size_t i = 0; i < indices.size(); ++i) indices[i] = 3 * i;
+    TS_ASSERT(decode(encode(indices, 2), 2) == indices);
+  }
+
+  void test_floats_are_smaller() {
+    std::vector<uint64_t> v;
+    for(size_t i = 0; i < 4096; ++i) {
+      v.push_back(i);
+      v.push_back(bits(0.5 + i));
+    }
+    // 4 bytes less per value, less the bitset of floats.
+    TS_ASSERT_LESS_THAN(encode(v, 2).size() + 3 * 4096, encode(v, 1).size());
+  }
+
+  void test_rounding_opt_in() {
+    std::vector<uint64_t> v = {7, bits(0.1), bits(1e300), bits(0.5)};
+
+    size_t old_value = ML_DATA_ROUND_VALUES_TO_FLOAT32;
+    ML_DATA_ROUND_VALUES_TO_FLOAT32 = 1;
+    std::vector<uint64_t> out = decode(encode(v, 2), 2);
+    ML_DATA_ROUND_VALUES_TO_FLOAT32 = old_value;
+
+    TS_ASSERT_EQUALS(out.size(), 4);
+    TS_ASSERT_EQUALS(out[0], 7);
+    TS_ASSERT_EQUALS(out[1], bits(double(float(0.1))));
+    // Out of the range of floats; kept as is.
+    TS_ASSERT_EQUALS(out[2], bits(1e300));
+    TS_ASSERT_EQUALS(out[3], bits(0.5));
+  }
+
+  void test_row_blocks() {
+    std::vector<uint64_t> v = mixed_entries(1000);
+
+    ml_data_internal::row_data_block b1;
+    b1.entry_data.resize(v.size());
+    std::memcpy(b1.entry_data.data(), v.data(), v.size() * sizeof(uint64_t));
+    b1.additional_data = {flexible_type("a"), flexible_type(2)};
+
+    std::stringstream ss;
+    oarchive oarc(ss);
+    oarc << b1;
+    iarchive iarc(ss);
+    ml_data_internal::row_data_block b1_out;
+    iarc >> b1_out;
+    TS_ASSERT_EQUALS(b1_out.entry_data.size(), v.size());
+    TS_ASSERT(std::memcmp(b1_out.entry_data.data(), v.data(), v.size() * sizeof(uint64_t)) == 0);
+    TS_ASSERT(b1_out.additional_data == b1.additional_data);
+
+    // v2 blocks, in the compact format and as stored by earlier versions.
+    v2::ml_data_internal::row_data_block b2;
+    b2.entry_data.resize(v.size());
+    std::memcpy(b2.entry_data.data(), v.data(), v.size() * sizeof(uint64_t));
+    b2.additional_data = b1.additional_data;
+
+    for(bool legacy : {false, true}) {
+      std::stringstream ss2;
+      oarchive oarc2(ss2);
+      if(legacy) {
+        oarc2 << b2.entry_data << b2.additional_data;
+      } else {
+        oarc2 << b2;
+      }
+      iarchive iarc2(ss2);
+      v2::ml_data_internal::row_data_block b2_out;
+      iarc2 >> b2_out;
+      TS_ASSERT_EQUALS(b2_out.entry_data.size(), v.size());
+      TS_ASSERT(std::memcmp(b2_out.entry_data.data(), v.data(), v.size() * sizeof(uint64_t)) == 0);
+      TS_ASSERT(b2_out.additional_data == b2.additional_data);
+    }
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_test_entry_data_codec, test_entry_data_codec)
+BOOST_AUTO_TEST_CASE(test_round_trip) {
+  test_entry_data_codec::test_round_trip();
+}
+BOOST_AUTO_TEST_CASE(test_floats_are_smaller) {
+  test_entry_data_codec::test_floats_are_smaller();
+}
+BOOST_AUTO_TEST_CASE(test_rounding_opt_in) {
+  test_entry_data_codec::test_rounding_opt_in();
+}
+BOOST_AUTO_TEST_CASE(test_row_blocks) {
+  test_entry_data_codec::test_row_blocks();
+}
+BOOST_AUTO_TEST_SUITE_END()
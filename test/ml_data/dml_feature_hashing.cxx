@@ -0,0 +1,136 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <string>
+#include <vector>
+#include <map>
+
+// ML-Data Utils
+#include <ml/ml_data/ml_data.hpp>
+#include <ml/ml_data/ml_data_iterator.hpp>
+#include <ml/ml_data/ml_data_cache.hpp>
+#include <ml/ml_data/metadata.hpp>
+#include <toolkits/ml_data_2/ml_data.hpp>
+#include <toolkits/ml_data_2/ml_data_iterators.hpp>
+
+// Testing utils common to all of ml_data_iterator
+#include <core/storage/sframe_data/testing_utils.hpp>
+#include <core/util/testing_utils.hpp>
+
+using namespace turi;
+
+struct test_feature_hashing  {
+ public:
+
+  static sframe make_data(size_t n, size_t offset) {
+    std::vector<std::vector<flexible_type> > raw_data;
+    for(size_t i = 0; i < n; ++i) {
+      size_t k = i + offset;
+      flex_dict d = {{std::to_string(k % 1001), 1.0 + (k % 3)}};
+      raw_data.push_back({std::to_string(k % 5003), d, double(k), double(k % 2)});
+    }
+
+    return make_testing_sframe(
+        {"cat", "dict", "num", "target"},
+        {flex_type_enum::STRING, flex_type_enum::DICT,
+         flex_type_enum::FLOAT, flex_type_enum::FLOAT},
+        raw_data);
+  }
+
+  // The index of each categorical value, checking that it is the same
+  // wherever the value appears.
+  static void check_consistent(const ml_data& data, const sframe& sf,
+                               std::map<std::string, size_t>& index_of_value) {
+    std::vector<flexible_type> cat_values;
+    sf.select_column("cat")->get_reader()->read_rows(0, sf.num_rows(), cat_values);
+
+    std::vector<ml_data_entry> x;
+    for(auto it = data.get_iterator(); !it.done(); ++it) {
+      it->fill(x);
+      TS_ASSERT_EQUALS(x.size(), 3);
+      TS_ASSERT_EQUALS(x[0].column_index, 0);
+      TS_ASSERT_LESS_THAN(x[0].index, 64);
+      TS_ASSERT_LESS_THAN(x[1].index, 64);
+
+      std::string v = cat_values[it.row_index()];
+      if(index_of_value.count(v)) {
+        TS_ASSERT_EQUALS(index_of_value.at(v), x[0].index);
+      } else {
+        index_of_value[v] = x[0].index;
+      }
+    }
+  }
+
+  void test_hashed_columns() {
+    size_t old_capacity = ML_DATA_CACHE_CAPACITY;
+    ML_DATA_CACHE_CAPACITY = 0;
+
+    sframe train_sf = make_data(20000, 0);
+
+    ml_data data;
+    data.set_feature_hash_buckets(64);
+    data.fill(train_sf, "target");
+
+    const auto& m = data.metadata();
+    TS_ASSERT_EQUALS(m->column_size(0), 64);
+    TS_ASSERT_EQUALS(m->column_size(1), 64);
+    TS_ASSERT_EQUALS(m->column_size(2), 1);
+    TS_ASSERT_EQUALS(m->indexer(0)->num_hash_buckets(), 64);
+    TS_ASSERT_EQUALS(m->indexer(2)->num_hash_buckets(), 0);
+    TS_ASSERT(m->indexer(0)->map_index_to_value(5) == 5);
+
+    std::map<std::string, size_t> index_of_value;
+    check_consistent(data, train_sf, index_of_value);
+
+    // New values at predict time go to the same buckets and leave the
+    // metadata as it is.
+    sframe test_sf = make_data(1000, 10000000);
+
+    std::shared_ptr<ml_metadata> loaded;
+    save_and_load_object(loaded, m);
+
+    ml_data test_data(loaded);
+    test_data.fill(test_sf, "target");
+
+    TS_ASSERT_EQUALS(loaded->indexer(0)->num_hash_buckets(), 64);
+    TS_ASSERT_EQUALS(loaded->column_size(0), 64);
+    TS_ASSERT_EQUALS(loaded->column_size(1), 64);
+    check_consistent(test_data, test_sf, index_of_value);
+
+    ML_DATA_CACHE_CAPACITY = old_capacity;
+  }
+
+  void test_hashed_columns_ml_data_2() {
+    sframe train_sf = make_data(5000, 0);
+
+    v2::ml_data data({{"column_indexer_type", "hash"},
+                      {"column_indexer_hash_buckets", 64}});
+    data.set_data(train_sf, "target");
+    data.fill();
+
+    TS_ASSERT_EQUALS(data.metadata()->column_size(0), 64);
+    TS_ASSERT_EQUALS(data.metadata()->column_size(1), 64);
+
+    std::vector<v2::ml_data_entry> x;
+    for(auto it = data.get_iterator(); !it.done(); ++it) {
+      it.fill_observation(x);
+      TS_ASSERT_LESS_THAN(x[0].index, 64);
+      TS_ASSERT_LESS_THAN(x[1].index, 64);
+    }
+
+    // Loads as the metadata of ml_data.
+    std::shared_ptr<ml_metadata> loaded;
+    save_and_load_object(loaded, data.metadata());
+    TS_ASSERT_EQUALS(loaded->indexer(0)->num_hash_buckets(), 64);
+    TS_ASSERT_EQUALS(loaded->column_size(0), 64);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_test_feature_hashing, test_feature_hashing)
+BOOST_AUTO_TEST_CASE(test_hashed_columns) {
+  test_feature_hashing::test_hashed_columns();
+}
+BOOST_AUTO_TEST_CASE(test_hashed_columns_ml_data_2) {
+  test_feature_hashing::test_hashed_columns_ml_data_2();
+}
+BOOST_AUTO_TEST_SUITE_END()
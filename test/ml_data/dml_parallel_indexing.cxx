@@ -0,0 +1,129 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <algorithm>
+
+// ML-Data Utils
+#include <ml/ml_data/ml_data.hpp>
+#include <ml/ml_data/ml_data_iterator.hpp>
+#include <ml/ml_data/ml_data_cache.hpp>
+#include <ml/ml_data/parallel_column_indexing.hpp>
+
+// Testing utils common to all of ml_data_iterator
+#include <core/storage/sframe_data/testing_utils.hpp>
+
+using namespace turi;
+
+struct test_parallel_indexing  {
+ public:
+
+  // The rows, with each index replaced by the value it stands for.
+  static std::vector<std::vector<std::tuple<size_t, std::string, double> > >
+  rows_by_value(const ml_data& data) {
+    std::vector<std::vector<std::tuple<size_t, std::string, double> > > ret;
+    std::vector<ml_data_entry> x;
+    for(auto it = data.get_iterator(); !it.done(); ++it) {
+      it->fill(x);
+      std::vector<std::tuple<size_t, std::string, double> > row;
+      for(const auto& e : x) {
+        const auto& value = data.metadata()->indexer(e.column_index)->map_index_to_value(e.index);
+        row.emplace_back(e.column_index, std::string(value), e.value);
+      }
+      std::sort(row.begin(), row.end());
+      ret.push_back(row);
+    }
+    return ret;
+  }
+
+  void test_same_as_indexing_while_translating() {
+    size_t old_capacity = ML_DATA_CACHE_CAPACITY;
+    size_t old_min_rows = ML_DATA_PARALLEL_INDEXING_MIN_ROWS;
+    ML_DATA_CACHE_CAPACITY = 0;
+
+    // Enough rows that most of each column is indexed after the first
+    // 10000, which are always indexed in order.
+    std::vector<std::vector<flexible_type> > raw_data;
+    for(size_t i = 0; i < 50000; ++i) {
+      flex_dict d = {{std::to_string(i % 1001), 1.0 + (i % 3)},
+                     {std::to_string(i % 13), 2.0}};
+      raw_data.push_back({std::to_string((i * 7919) % 20011),
+                          flex_list{flex_int(i % 503), flex_int(i % 97)},
+                          d,
+                          flexible_type(),
+                          double(i)});
+      if(i % 11 == 0) raw_data.back()[3] = flex_int(i % 29);
+    }
+
+    sframe data_sf = make_testing_sframe(
+        {"cat", "list", "dict", "missing", "num"},
+        {flex_type_enum::STRING, flex_type_enum::LIST, flex_type_enum::DICT,
+         flex_type_enum::INTEGER, flex_type_enum::FLOAT},
+        raw_data);
+
+    std::map<std::string, ml_column_mode> modes = {
+      {"list", ml_column_mode::CATEGORICAL_VECTOR},
+      {"missing", ml_column_mode::CATEGORICAL}};
+
+    ML_DATA_PARALLEL_INDEXING_MIN_ROWS = size_t(-1);
+    ml_data X1;
+    X1.fill(data_sf, "", modes);
+
+    ML_DATA_PARALLEL_INDEXING_MIN_ROWS = 0;
+    ml_data X2;
+    X2.fill(data_sf, "", modes);
+
+    ML_DATA_PARALLEL_INDEXING_MIN_ROWS = old_min_rows;
+    ML_DATA_CACHE_CAPACITY = old_capacity;
+
+    TS_ASSERT_EQUALS(X1.num_rows(), X2.num_rows());
+    for(size_t c = 0; c < X1.metadata()->num_columns(); ++c) {
+      TS_ASSERT_EQUALS(X1.metadata()->column_size(c), X2.metadata()->column_size(c));
+    }
+    TS_ASSERT_EQUALS(X2.metadata()->column_size(0), 20011);
+    TS_ASSERT(rows_by_value(X1) == rows_by_value(X2));
+
+    // Statistics are gathered the same way.
+    for(size_t c = 0; c < X1.metadata()->num_columns(); ++c) {
+      if(!mode_is_indexed(X1.metadata()->column_mode(c)))
+        continue;
+      const auto& s1 = X1.metadata()->statistics(c);
+      const auto& s2 = X2.metadata()->statistics(c);
+      for(size_t i = 0; i < X1.metadata()->column_size(c); ++i) {
+        const auto& v = X1.metadata()->indexer(c)->map_index_to_value(i);
+        size_t j = X2.metadata()->indexer(c)->immutable_map_value_to_index(v);
+        TS_ASSERT_EQUALS(s1->count(i), s2->count(j));
+      }
+    }
+  }
+
+  void test_bad_values_still_raise() {
+    size_t old_min_rows = ML_DATA_PARALLEL_INDEXING_MIN_ROWS;
+    ML_DATA_PARALLEL_INDEXING_MIN_ROWS = 0;
+
+    std::vector<std::vector<flexible_type> > raw_data;
+    // Past the rows indexed in order before the parallel indexing.
+    for(size_t i = 0; i < 20000; ++i)
+      raw_data.push_back({flex_list{flex_int(i % 10)}});
+    raw_data[15000][0] = flex_list{flex_int(1), 0.5};
+
+    sframe data_sf = make_testing_sframe({"list"}, {flex_type_enum::LIST}, raw_data);
+
+    ml_data X;
+    TS_ASSERT_THROWS_ANYTHING(X.fill(data_sf, "", {{"list", ml_column_mode::CATEGORICAL_VECTOR}}));
+
+    ML_DATA_PARALLEL_INDEXING_MIN_ROWS = old_min_rows;
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_test_parallel_indexing, test_parallel_indexing)
+BOOST_AUTO_TEST_CASE(test_same_as_indexing_while_translating) {
+  test_parallel_indexing::test_same_as_indexing_while_translating();
+}
+BOOST_AUTO_TEST_CASE(test_bad_values_still_raise) {
+  test_parallel_indexing::test_bad_values_still_raise();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,89 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <string>
+#include <vector>
+
+// ML-Data Utils
+#include <ml/ml_data/ml_data.hpp>
+#include <ml/ml_data/ml_data_iterator.hpp>
+#include <ml/ml_data/ml_data_cache.hpp>
+#include <ml/ml_data/data_storage/ml_data_block_manager.hpp>
+#include <core/parallel/lambda_omp.hpp>
+
+// Testing utils common to all of ml_data_iterator
+#include <core/storage/sframe_data/testing_utils.hpp>
+
+using namespace turi;
+
+struct test_ml_data_prefetch  {
+ public:
+
+  // The rows read by num_threads iterators, in order.
+  static std::vector<std::vector<ml_data_entry> > all_rows(const ml_data& data, size_t num_threads) {
+    std::vector<std::vector<std::vector<ml_data_entry> > > by_thread(num_threads);
+
+    parallel_for(0, num_threads, [&](size_t thread_idx) {
+        std::vector<ml_data_entry> x;
+        for(auto it = data.get_iterator(thread_idx, num_threads); !it.done(); ++it) {
+          it->fill(x);
+          by_thread[thread_idx].push_back(x);
+        }
+      });
+
+    std::vector<std::vector<ml_data_entry> > ret;
+    for(auto& rows : by_thread) {
+      ret.insert(ret.end(), rows.begin(), rows.end());
+    }
+    return ret;
+  }
+
+  void test_prefetched_iteration() {
+    size_t old_capacity = ML_DATA_CACHE_CAPACITY;
+    size_t old_block_bytes = ml_data_internal::ML_DATA_TARGET_ROW_BYTE_MINIMUM;
+    size_t old_prefetch_blocks = ML_DATA_PREFETCH_BLOCKS;
+    size_t old_budget = ML_DATA_PREFETCH_MEMORY_BUDGET;
+
+    ML_DATA_CACHE_CAPACITY = 0;
+
+    // Small blocks, so that each iterator crosses many of them.
+    ml_data_internal::ML_DATA_TARGET_ROW_BYTE_MINIMUM = 1024;
+
+    std::vector<std::vector<flexible_type> > raw_data;
+    for(size_t i = 0; i < 20000; ++i) {
+      raw_data.push_back({std::to_string(i % 101), double(i), flex_list{flex_int(i % 7)}});
+    }
+
+    sframe data_sf = make_testing_sframe(
+        {"cat", "num", "list"},
+        {flex_type_enum::STRING, flex_type_enum::FLOAT, flex_type_enum::LIST},
+        raw_data);
+
+    ml_data data;
+    data.fill(data_sf, "", {{"list", ml_column_mode::CATEGORICAL_VECTOR}});
+
+    ML_DATA_PREFETCH_BLOCKS = 0;
+    auto expected = all_rows(data, 1);
+    TS_ASSERT_EQUALS(expected.size(), 20000);
+
+    for(size_t n_blocks : {1, 4}) {
+      for(size_t budget : {size_t(0), size_t(64*1024), size_t(1024*1024*1024)}) {
+        ML_DATA_PREFETCH_BLOCKS = n_blocks;
+        ML_DATA_PREFETCH_MEMORY_BUDGET = budget;
+        TS_ASSERT(all_rows(data, 1) == expected);
+        TS_ASSERT(all_rows(data, 3) == expected);
+      }
+    }
+
+    ML_DATA_CACHE_CAPACITY = old_capacity;
+    ml_data_internal::ML_DATA_TARGET_ROW_BYTE_MINIMUM = old_block_bytes;
+    ML_DATA_PREFETCH_BLOCKS = old_prefetch_blocks;
+    ML_DATA_PREFETCH_MEMORY_BUDGET = old_budget;
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_test_ml_data_prefetch, test_ml_data_prefetch)
+BOOST_AUTO_TEST_CASE(test_prefetched_iteration) {
+  test_ml_data_prefetch::test_prefetched_iteration();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,67 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <string>
+#include <vector>
+
+// ML-Data Utils
+#include <ml/ml_data/ml_data.hpp>
+#include <ml/ml_data/metadata.hpp>
+#include <ml/ml_data/column_statistics.hpp>
+
+// Testing utils common to all of ml_data_iterator
+#include <core/storage/sframe_data/testing_utils.hpp>
+
+using namespace turi;
+
+struct test_stats_memory_budget  {
+ public:
+
+  void test_same_statistics_within_budget() {
+    size_t old_budget = ML_DATA_STATS_THREAD_LOCAL_MEMORY_BUDGET;
+
+    // Many keys, so that most of them are past the thread-local range
+    // when the budget is small.
+    std::vector<std::vector<flexible_type> > raw_data;
+    for(size_t i = 0; i < 20000; ++i) {
+      flex_dict d = {{std::to_string(i % 5003), 1.0 + (i % 7)},
+                     {std::to_string((i * 31) % 4001), -2.0}};
+      raw_data.push_back({d, std::to_string(i % 3001)});
+    }
+
+    sframe data_sf = make_testing_sframe(
+        {"dict", "cat"}, {flex_type_enum::DICT, flex_type_enum::STRING}, raw_data);
+
+    ml_data X1;
+    X1.fill(data_sf);
+
+    // The smallest budget; 1024 indices are kept per thread.
+    ML_DATA_STATS_THREAD_LOCAL_MEMORY_BUDGET = 0;
+    ml_data X2;
+    X2.fill(data_sf);
+
+    ML_DATA_STATS_THREAD_LOCAL_MEMORY_BUDGET = old_budget;
+
+    for(size_t c = 0; c < X1.metadata()->num_columns(); ++c) {
+      TS_ASSERT_EQUALS(X1.metadata()->column_size(c), X2.metadata()->column_size(c));
+
+      const auto& s1 = X1.metadata()->statistics(c);
+      const auto& s2 = X2.metadata()->statistics(c);
+
+      // The indices may be assigned in a different order.
+      for(size_t i = 0; i < X1.metadata()->column_size(c); ++i) {
+        const auto& v = X1.metadata()->indexer(c)->map_index_to_value(i);
+        size_t j = X2.metadata()->indexer(c)->immutable_map_value_to_index(v);
+        TS_ASSERT_EQUALS(s1->count(i), s2->count(j));
+        TS_ASSERT_DELTA(s1->mean(i), s2->mean(j), 1e-8);
+        TS_ASSERT_DELTA(s1->stdev(i), s2->stdev(j), 1e-8);
+      }
+    }
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_test_stats_memory_budget, test_stats_memory_budget)
+BOOST_AUTO_TEST_CASE(test_same_statistics_within_budget) {
+  test_stats_memory_budget::test_same_statistics_within_budget();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -436,6 +436,31 @@ struct optimization_interface_test  {
       TS_ASSERT(stats.solution.isApprox(solution, 1e-2));
     }
 
+    void test_lbfgs_float32_history(){
+      // Split the history operations across threads, even at this size.
+      size_t old_min_size = optimization::LBFGS_PARALLEL_VECTOR_OPS_MIN_SIZE;
+      optimization::LBFGS_PARALLEL_VECTOR_OPS_MIN_SIZE = 0;
+
+      std::map<std::string, flexible_type> float_opts = opts;
+      float_opts["lbfgs_float32_history"] = true;
+
+      optimization::solver_return stats;
+      stats = turi::optimization::lbfgs_compat(solver_interface,
+          init_point, float_opts);
+
+      optimization::LBFGS_PARALLEL_VECTOR_OPS_MIN_SIZE = old_min_size;
+
+      TS_ASSERT(stats.solution.isApprox(solution, 1e-2));
+    }
+
+    void test_newton_cg(){
+      optimization::solver_return stats;
+      stats = turi::optimization::newton_cg_method(*solver_interface,
+          init_point, opts);
+      TS_ASSERT(stats.solution.isApprox(solution, 1e-2));
+      TS_ASSERT(stats.hessian.size() == 0);
+    }
+
     void test_fista(){
       optimization::solver_return stats;
       stats = turi::optimization::accelerated_gradient(*solver_interface,
@@ -481,6 +506,12 @@ BOOST_AUTO_TEST_CASE(test_newton) {
 BOOST_AUTO_TEST_CASE(test_lbfgs) {
   optimization_interface_test::test_lbfgs();
 }
+BOOST_AUTO_TEST_CASE(test_lbfgs_float32_history) {
+  optimization_interface_test::test_lbfgs_float32_history();
+}
+BOOST_AUTO_TEST_CASE(test_newton_cg) {
+  optimization_interface_test::test_newton_cg();
+}
 BOOST_AUTO_TEST_CASE(test_fista) {
   optimization_interface_test::test_fista();
 }
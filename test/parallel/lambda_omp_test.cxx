@@ -50,6 +50,75 @@ public:
 
   }
 
+  void test_scheduled_parallel_for(void) {
+    for (auto schedule : {parallel_schedule::STATIC,
+                          parallel_schedule::DYNAMIC,
+                          parallel_schedule::GUIDED}) {
+      for (size_t grain_size : {1, 7, 1000, 1000000}) {
+        std::vector<int> ctr(100000);
+        parallel_for(0, ctr.size(), [&](size_t idx) {
+                       ctr[idx]++;
+                     }, schedule, grain_size);
+        for (size_t i = 0; i < ctr.size(); ++i) {
+          TS_ASSERT_EQUALS(ctr[i], 1);
+        }
+
+        size_t sum = fold_reduce(10, ctr.size(),
+                                 [&](size_t idx, size_t& sum) {
+                                   sum += idx;
+                                 }, size_t(0), schedule, grain_size);
+        TS_ASSERT_EQUALS(sum, (ctr.size() - 1) * ctr.size() / 2 - 45);
+      }
+    }
+
+    // empty ranges
+    size_t calls = 0;
+    parallel_for(5, 5, [&](size_t idx) { ++calls; }, parallel_schedule::DYNAMIC);
+    parallel_for(5, 3, [&](size_t idx) { ++calls; }, parallel_schedule::GUIDED);
+    TS_ASSERT_EQUALS(calls, 0);
+  }
+
+  void test_parallel_range_cursor(void) {
+    // guided chunks shrink down to the grain size and cover the range in order
+    parallel_range_cursor cursor(3, 1003, parallel_schedule::GUIDED, 10, 4);
+    size_t chunk_begin = 0, chunk_end = 0;
+    size_t expected_begin = 3, last_length = 1000;
+    while (cursor.next(chunk_begin, chunk_end)) {
+      TS_ASSERT_EQUALS(chunk_begin, expected_begin);
+      TS_ASSERT_LESS_THAN(chunk_begin, chunk_end);
+      TS_ASSERT_LESS_THAN_EQUALS(chunk_end - chunk_begin, last_length);
+      if (chunk_end != 1003) TS_ASSERT_LESS_THAN_EQUALS(10, chunk_end - chunk_begin);
+      last_length = chunk_end - chunk_begin;
+      expected_begin = chunk_end;
+    }
+    TS_ASSERT_EQUALS(expected_begin, 1003);
+    TS_ASSERT(!cursor.next(chunk_begin, chunk_end));
+
+    // dynamic chunks are all of the grain size but the last
+    parallel_range_cursor dynamic_cursor(0, 25, parallel_schedule::DYNAMIC, 10);
+    TS_ASSERT(dynamic_cursor.next(chunk_begin, chunk_end));
+    TS_ASSERT_EQUALS(chunk_end - chunk_begin, 10);
+    TS_ASSERT(dynamic_cursor.next(chunk_begin, chunk_end));
+    TS_ASSERT_EQUALS(chunk_end - chunk_begin, 10);
+    TS_ASSERT(dynamic_cursor.next(chunk_begin, chunk_end));
+    TS_ASSERT_EQUALS(chunk_begin, 20);
+    TS_ASSERT_EQUALS(chunk_end, 25);
+    TS_ASSERT(!dynamic_cursor.next(chunk_begin, chunk_end));
+
+    // shared by all threads, every index is handed out once
+    std::vector<int> ctr(100000);
+    parallel_range_cursor shared_cursor(0, ctr.size(), parallel_schedule::GUIDED);
+    in_parallel([&](size_t thrid, size_t num_threads) {
+                  size_t b = 0, e = 0;
+                  while (shared_cursor.next(b, e)) {
+                    for (size_t i = b; i < e; ++i) ctr[i]++;
+                  }
+                });
+    for (size_t i = 0; i < ctr.size(); ++i) {
+      TS_ASSERT_EQUALS(ctr[i], 1);
+    }
+  }
+
   long fib (long n) {
     if (n <= 2) {
       return 1;
@@ -121,6 +190,12 @@ BOOST_FIXTURE_TEST_SUITE(_lambda_omp_test, lambda_omp_test)
 BOOST_AUTO_TEST_CASE(test_parallel_for) {
   lambda_omp_test::test_parallel_for();
 }
+BOOST_AUTO_TEST_CASE(test_scheduled_parallel_for) {
+  lambda_omp_test::test_scheduled_parallel_for();
+}
+BOOST_AUTO_TEST_CASE(test_parallel_range_cursor) {
+  lambda_omp_test::test_parallel_range_cursor();
+}
 BOOST_AUTO_TEST_CASE(test_parallel_for_fib) {
   lambda_omp_test::test_parallel_for_fib();
 }
@@ -0,0 +1,67 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <core/parallel/numa.hpp>
+#include <core/parallel/pthread_tools.hpp>
+
+using namespace turi;
+
+struct numa_test {
+ public:
+  void test_parse() {
+    auto topology = numa_topology::from_cpu_lists({"0-3,8-11\n", "4-7, 12,13-15"});
+    TS_ASSERT_EQUALS(topology.num_nodes(), 2);
+    TS_ASSERT_EQUALS(topology.node_cpus(0),
+                     std::vector<size_t>({0, 1, 2, 3, 8, 9, 10, 11}));
+    TS_ASSERT_EQUALS(topology.node_cpus(1).size(), 8);
+    TS_ASSERT_EQUALS(topology.node_of_cpu(9), 0);
+    TS_ASSERT_EQUALS(topology.node_of_cpu(12), 1);
+    TS_ASSERT_EQUALS(topology.node_of_cpu(100), 0);
+
+    // nodes without CPUs and garbage are skipped
+    auto skipped = numa_topology::from_cpu_lists({"", "0-1", "x-y", "3-2"});
+    TS_ASSERT_EQUALS(skipped.num_nodes(), 1);
+    TS_ASSERT_EQUALS(skipped.node_cpus(0), std::vector<size_t>({0, 1}));
+
+    // nothing readable is a single node of all CPUs
+    auto single = numa_topology::from_cpu_lists({});
+    TS_ASSERT_EQUALS(single.num_nodes(), 1);
+    TS_ASSERT_EQUALS(single.node_cpus(0).size(), thread::cpu_count());
+  }
+
+  void test_cpu_for_worker() {
+    auto topology = numa_topology::from_cpu_lists({"0,2,4,6", "1,3,5,7"});
+    // one worker per CPU, node by node
+    std::vector<size_t> cpus;
+    for (size_t i = 0; i < 8; ++i) cpus.push_back(topology.cpu_for_worker(i, 8));
+    TS_ASSERT_EQUALS(cpus, std::vector<size_t>({0, 2, 4, 6, 1, 3, 5, 7}));
+
+    // fewer workers are split between the nodes, and spread within them
+    TS_ASSERT_EQUALS(topology.cpu_for_worker(0, 4), 0);
+    TS_ASSERT_EQUALS(topology.cpu_for_worker(1, 4), 4);
+    TS_ASSERT_EQUALS(topology.cpu_for_worker(2, 4), 1);
+    TS_ASSERT_EQUALS(topology.cpu_for_worker(3, 4), 5);
+
+    // more workers than CPUs share them
+    for (size_t i = 0; i < 16; ++i) {
+      size_t cpu = topology.cpu_for_worker(i, 16);
+      TS_ASSERT_EQUALS(topology.node_of_cpu(cpu), i < 8 ? 0 : 1);
+    }
+  }
+
+  void test_local_node() {
+    TS_ASSERT_LESS_THAN(numa_current_node(), numa_topology::get().num_nodes());
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_numa_test, numa_test)
+BOOST_AUTO_TEST_CASE(test_parse) {
+  numa_test::test_parse();
+}
+BOOST_AUTO_TEST_CASE(test_cpu_for_worker) {
+  numa_test::test_cpu_for_worker();
+}
+BOOST_AUTO_TEST_CASE(test_local_node) {
+  numa_test::test_local_node();
+}
+BOOST_AUTO_TEST_SUITE_END()
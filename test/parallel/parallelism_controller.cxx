@@ -0,0 +1,106 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <core/parallel/cpu_quota.hpp>
+#include <core/parallel/parallelism_controller.hpp>
+#include <core/parallel/pthread_tools.hpp>
+
+using namespace turi;
+
+struct parallelism_controller_test {
+ public:
+  void test_parse_cpu_max() {
+    TS_ASSERT_EQUALS(cpu_quota::parse_cpu_max("max 100000\n"), 0);
+    TS_ASSERT_EQUALS(cpu_quota::parse_cpu_max("150000 100000\n"), 1.5);
+    // cgroup v1 quota and period, -1 for no quota
+    TS_ASSERT_EQUALS(cpu_quota::parse_cpu_max("400000\n 100000\n"), 4);
+    TS_ASSERT_EQUALS(cpu_quota::parse_cpu_max("-1\n 100000\n"), 0);
+    TS_ASSERT_EQUALS(cpu_quota::parse_cpu_max(""), 0);
+    TS_ASSERT_EQUALS(cpu_quota::parse_cpu_max("abc 0"), 0);
+  }
+
+  void test_effective_cpus() {
+    cpu_quota q;
+    TS_ASSERT_EQUALS(q.effective_cpus(), 0);
+    q.affinity_cpus = 8;
+    TS_ASSERT_EQUALS(q.effective_cpus(), 8);
+    q.quota_cpus = 1.5;
+    TS_ASSERT_EQUALS(q.effective_cpus(), 2);
+    q.quota_cpus = 0.1;
+    TS_ASSERT_EQUALS(q.effective_cpus(), 1);
+    q.quota_cpus = 32;
+    TS_ASSERT_EQUALS(q.effective_cpus(), 8);
+
+    // the limits of this process are consistent with cpu_count
+    cpu_quota self = cpu_quota::read();
+    if (self.effective_cpus() > 0 && getenv("OMP_NUM_THREADS") == nullptr) {
+      TS_ASSERT(thread::cpu_count() <= self.effective_cpus());
+    }
+  }
+
+  void test_parse_cpu_stat() {
+    auto v2 = cpu_throttle_stats::parse_cpu_stat(
+        "usage_usec 1000\nnr_periods 50\nnr_throttled 5\nthrottled_usec 2500\n");
+    TS_ASSERT(v2.available);
+    TS_ASSERT_EQUALS(v2.nr_periods, 50);
+    TS_ASSERT_EQUALS(v2.nr_throttled, 5);
+    TS_ASSERT_EQUALS(v2.throttled_usec, 2500);
+
+    auto v1 = cpu_throttle_stats::parse_cpu_stat(
+        "nr_periods 10\nnr_throttled 2\nthrottled_time 3000000\n");
+    TS_ASSERT(v1.available);
+    TS_ASSERT_EQUALS(v1.throttled_usec, 3000);
+
+    // without a cpu controller, there is no nr_periods
+    TS_ASSERT(!cpu_throttle_stats::parse_cpu_stat("usage_usec 1000\n").available);
+  }
+
+  void test_controller() {
+    auto& controller = parallelism_controller::get_instance();
+    controller.reset();
+    size_t ncpus = std::max<size_t>(thread::cpu_count(), 1);
+    TS_ASSERT_EQUALS(controller.target(), ncpus);
+    TS_ASSERT_EQUALS(controller.recommended_workers(ncpus + 10), ncpus);
+    TS_ASSERT_EQUALS(controller.recommended_workers(0), 1);
+
+    // throttling backs off
+    controller.report(8, 1.0, 8.0, 0.5);
+    TS_ASSERT_EQUALS(controller.target(), std::min<size_t>(ncpus, 6));
+
+    // short operations are ignored
+    controller.report(8, 0.001, 0, 0.001);
+    TS_ASSERT_EQUALS(controller.target(), std::min<size_t>(ncpus, 6));
+
+    // idle workers lose one
+    controller.reset();
+    controller.report(4, 1.0, 1.0, 0);
+    TS_ASSERT_EQUALS(controller.target(), std::min<size_t>(ncpus, 3));
+
+    // busy, unthrottled workers gain one, up to the CPUs
+    size_t target = controller.target();
+    controller.report(target, 1.0, target * 0.95, 0);
+    TS_ASSERT_EQUALS(controller.target(), std::min(target + 1, ncpus));
+
+    // busy workers of other pools are left room
+    controller.reset();
+    controller.add_external_workers(ncpus);
+    TS_ASSERT_EQUALS(controller.recommended_workers(ncpus), 1);
+    controller.add_external_workers(-int64_t(ncpus));
+    TS_ASSERT_EQUALS(controller.recommended_workers(ncpus), ncpus);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_parallelism_controller_test, parallelism_controller_test)
+BOOST_AUTO_TEST_CASE(test_parse_cpu_max) {
+  parallelism_controller_test::test_parse_cpu_max();
+}
+BOOST_AUTO_TEST_CASE(test_effective_cpus) {
+  parallelism_controller_test::test_effective_cpus();
+}
+BOOST_AUTO_TEST_CASE(test_parse_cpu_stat) {
+  parallelism_controller_test::test_parse_cpu_stat();
+}
+BOOST_AUTO_TEST_CASE(test_controller) {
+  parallelism_controller_test::test_controller();
+}
+BOOST_AUTO_TEST_SUITE_END()
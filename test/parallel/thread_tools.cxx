@@ -88,6 +88,29 @@ void test_pool(){
   TS_ASSERT_EQUALS(testval.value, 0);
 }
 
+void test_nested_pool(){
+  // more joining tasks than threads: joins from within the pool have to
+  // run the inner tasks themselves.
+  for (size_t num_threads: {1, 2, 4}) {
+    thread_pool thpool(num_threads);
+    atomic<size_t> count = 0;
+    parallel_task_queue outer(thpool);
+    for (size_t i = 0;i < 8; ++i) {
+      outer.launch([&]() {
+        TS_ASSERT(thpool.in_pool_thread());
+        parallel_task_queue inner(thpool);
+        for (size_t j = 0;j < 100; ++j) {
+          inner.launch([&]() { count.inc(); });
+        }
+        inner.join();
+      });
+    }
+    outer.join();
+    TS_ASSERT_EQUALS(count.value, 800);
+    TS_ASSERT(!thpool.in_pool_thread());
+  }
+}
+
 void test_pool_exception_forwarding(){
   std::cout << "\n";
   std::cout << "----------------------------------------------------------------\n";
@@ -145,6 +168,10 @@ public:
    test_pool();
   }
 
+  void test_nested_thread_pool(void) {
+    test_nested_pool();
+  }
+
   // TODO: Make this test WORK again
   void thread_group_exception(void) {
     test_group_exception_forwarding();
@@ -160,6 +187,9 @@ BOOST_FIXTURE_TEST_SUITE(_ThreadToolsTestSuite, ThreadToolsTestSuite)
 BOOST_AUTO_TEST_CASE(test_thread_pool) {
   ThreadToolsTestSuite::test_thread_pool();
 }
+BOOST_AUTO_TEST_CASE(test_nested_thread_pool) {
+  ThreadToolsTestSuite::test_nested_thread_pool();
+}
 BOOST_AUTO_TEST_CASE(test_thread_pool_exception) {
   ThreadToolsTestSuite::test_thread_pool_exception();
 }
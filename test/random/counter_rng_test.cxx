@@ -0,0 +1,73 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <cmath>
+#include <vector>
+#include <core/random/counter_rng.hpp>
+
+using namespace turi;
+using namespace turi::random;
+
+struct counter_rng_test {
+ public:
+  void test_known_answer() {
+    // from the Random123 known answer tests
+    auto zero = philox4x32({{0, 0, 0, 0}}, {{0, 0}});
+    TS_ASSERT_EQUALS(zero[0], 0x6627e8d5);
+    TS_ASSERT_EQUALS(zero[1], 0xe169c58d);
+    TS_ASSERT_EQUALS(zero[2], 0xbc57ac4c);
+    TS_ASSERT_EQUALS(zero[3], 0x9b00dbd8);
+  }
+
+  void test_batches_match_single_values() {
+    counter_rng rng(12345);
+    // odd offsets and lengths split the blocks
+    for (size_t first: {0, 1, 7}) {
+      std::vector<double> u(101), z(101);
+      rng.fill_uniform(first, u.data(), u.size(), -1, 3);
+      rng.fill_normal(first, z.data(), z.size(), 2, 0.5);
+      for (size_t k = 0; k < u.size(); ++k) {
+        TS_ASSERT_DELTA(u[k], rng.uniform(first + k, -1, 3), 1e-12);
+        TS_ASSERT_DELTA(z[k], 2 + 0.5 * rng.normal(first + k), 1e-12);
+      }
+    }
+  }
+
+  void test_distribution() {
+    counter_rng rng(7);
+    counter_rng other_stream(7, 1);
+    const size_t n = 200000;
+    std::vector<double> u(n), z(n);
+    rng.fill_uniform(0, u.data(), n);
+    rng.fill_normal(0, z.data(), n);
+    double u_sum = 0, z_sum = 0, z_sq = 0;
+    size_t same = 0;
+    for (size_t i = 0; i < n; ++i) {
+      TS_ASSERT(u[i] >= 0 && u[i] < 1);
+      u_sum += u[i];
+      z_sum += z[i];
+      z_sq += z[i] * z[i];
+      if (rng(i) == other_stream(i)) ++same;
+      uint64_t v = rng.uniform_int(i, 3, 5);
+      TS_ASSERT(v >= 3 && v <= 5);
+    }
+    TS_ASSERT_DELTA(u_sum / n, 0.5, 0.01);
+    TS_ASSERT_DELTA(z_sum / n, 0, 0.01);
+    TS_ASSERT_DELTA(z_sq / n, 1, 0.02);
+    TS_ASSERT_EQUALS(same, 0);
+    // different seeds give different values
+    TS_ASSERT_DIFFERS(counter_rng(8)(0), rng(0));
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_counter_rng_test, counter_rng_test)
+BOOST_AUTO_TEST_CASE(test_known_answer) {
+  counter_rng_test::test_known_answer();
+}
+BOOST_AUTO_TEST_CASE(test_batches_match_single_values) {
+  counter_rng_test::test_batches_match_single_values();
+}
+BOOST_AUTO_TEST_CASE(test_distribution) {
+  counter_rng_test::test_distribution();
+}
+BOOST_AUTO_TEST_SUITE_END()
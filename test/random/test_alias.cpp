@@ -11,6 +11,7 @@
 #include <utility>
 #include <iostream>
 #include <iomanip>
+#include <cmath>
 
 using namespace turi;
 
@@ -91,6 +92,36 @@ std::vector<size_t> count_samples(size_t num_samples, std::vector<double> probs)
   return counts;
 }
 
+/**
+ * Regression check for the outcomes left over once the small and large
+ * outcomes are paired up. With {0, 0.7, 0.7}, rounding leaves outcome 1
+ * just short of probability 1 and without an alias, which used to send
+ * the rest of its mass to the impossible outcome 0.
+ *
+ * \returns true if the table encodes the pmf.
+ */
+bool check_alias_rounding() {
+  auto A = random::alias_sampler({0, 0.7, 0.7});
+  bool ok = (A.size() == 3 && A.probability(0) == 0 &&
+             std::abs(A.probability(1) - 0.5) < 1e-12 &&
+             std::abs(A.probability(2) - 0.5) < 1e-12);
+  for (size_t i = 0; i < 100000; ++i) {
+    if (A.sample() == 0) ok = false;
+  }
+
+  // A large pmf, with an impossible outcome, is encoded up to rounding.
+  auto probs = create_large_pmf(1000);
+  probs[0] = 0;
+  auto B = random::alias_sampler(probs);
+  double total = 0;
+  for (size_t k = 0; k < probs.size(); ++k) total += probs[k];
+  for (size_t k = 0; k < probs.size(); ++k) {
+    if (std::abs(B.probability(k) - probs[k] / total) > 1e-12) ok = false;
+  }
+  if (B.probability(0) != 0) ok = false;
+  return ok;
+}
+
 int main(int argc, char **argv) {
   if (argc < 2) {
     std::cerr << "format: " << argv[0] << " <num_samples>" 
@@ -101,6 +132,11 @@ int main(int argc, char **argv) {
 
   turi::random::seed(1001);
 
+  if (!check_alias_rounding()) {
+    std::cerr << "alias table does not match its pmf" << std::endl;
+    return 1;
+  }
+
   std::cout << "Performance on a small pmf:" << std::endl;
   auto p1 = create_small_pmf();
   run_alias_benchmark(N, p1);
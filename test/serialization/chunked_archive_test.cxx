@@ -0,0 +1,55 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+
+#include <string>
+#include <vector>
+#include <core/storage/serialization/serialization_includes.hpp>
+#include <core/storage/serialization/chunked_archive.hpp>
+#include <core/util/cityhash_tc.hpp>
+
+using namespace turi;
+
+// Saves values in chunks to an in-memory archive, and loads them back.
+template <typename T>
+static void save_and_load(const std::vector<T>& values) {
+  std::vector<char> buf;
+  oarchive oarc(buf);
+  size_t check = 12345;
+  save_chunked(oarc, values);
+  oarc << check;
+  buf.resize(oarc.off);
+
+  iarchive iarc(buf.data(), buf.size());
+  std::vector<T> values_2(3);
+  size_t check_2 = 0;
+  load_chunked(iarc, values_2);
+  iarc >> check_2;
+  TS_ASSERT_EQUALS(check, check_2);
+  TS_ASSERT(values == values_2);
+}
+
+BOOST_AUTO_TEST_CASE(test_chunked_archive) {
+  size_t old_chunk_size = SERIALIZATION_CHUNK_SIZE;
+  SERIALIZATION_CHUNK_SIZE = 1024;
+
+  // compressible values, over many chunks
+  std::vector<std::pair<size_t, double>> pairs(100000);
+  for (size_t i = 0; i < pairs.size(); ++i) pairs[i] = {i % 17, 0.5 * (i % 3)};
+  save_and_load(pairs);
+
+  // incompressible values, stored as is
+  std::vector<size_t> hashes(10000);
+  for (size_t i = 0; i < hashes.size(); ++i) hashes[i] = hash64(i);
+  save_and_load(hashes);
+
+  // variable sized values
+  std::vector<std::string> strings(5000);
+  for (size_t i = 0; i < strings.size(); ++i) strings[i] = std::string(i % 100, 'a' + i % 26);
+  save_and_load(strings);
+
+  save_and_load(std::vector<int>());
+  save_and_load(std::vector<int>(1, 7));
+
+  SERIALIZATION_CHUNK_SIZE = old_chunk_size;
+}
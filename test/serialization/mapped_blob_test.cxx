@@ -0,0 +1,94 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+
+#include <Eigen/Core>
+
+#include <core/storage/serialization/serialization_includes.hpp>
+#include <core/storage/serialization/mapped_eigen_matrix.hpp>
+
+using namespace turi;
+
+typedef Eigen::Matrix<float, Eigen::Dynamic, 8, Eigen::RowMajor> factor_matrix_type;
+
+// Saves X to a directory archive, and loads it back.
+static void save_and_load(const mapped_eigen_matrix<factor_matrix_type>& X,
+                          mapped_eigen_matrix<factor_matrix_type>& X2) {
+  dir_archive archive_write;
+  archive_write.open_directory_for_write("mapped_blob_test");
+  turi::oarchive oarc(archive_write);
+  size_t check = 12345;
+  oarc << X << check;
+  archive_write.close();
+
+  dir_archive archive_read;
+  archive_read.open_directory_for_read("mapped_blob_test");
+  turi::iarchive iarc(archive_read);
+  size_t check_2 = 0;
+  iarc >> X2 >> check_2;
+  TS_ASSERT_EQUALS(check, check_2);
+}
+
+static void check_equal(const Eigen::Ref<const factor_matrix_type>& X,
+                        const Eigen::Ref<const factor_matrix_type>& X2) {
+  TS_ASSERT_EQUALS(X.rows(), X2.rows());
+  TS_ASSERT_EQUALS(X.cols(), X2.cols());
+  TS_ASSERT(X == X2);
+}
+
+BOOST_AUTO_TEST_CASE(test_mapped_matrix) {
+  size_t old_min_file_size = MAPPED_BLOB_MIN_FILE_SIZE;
+
+  for (size_t min_file_size : {size_t(0), size_t(1) << 40}) {
+    MAPPED_BLOB_MIN_FILE_SIZE = min_file_size;
+
+    mapped_eigen_matrix<factor_matrix_type> X;
+    X.resize(1000, 8);
+    TS_ASSERT(X.isZero());
+    X.setRandom();
+
+    mapped_eigen_matrix<factor_matrix_type> X2;
+    save_and_load(X, X2);
+    TS_ASSERT_EQUALS(X2.is_mapped(), min_file_size == 0);
+    check_equal(X, X2);
+
+    // Writes go to private pages, not to the archive.
+    X2.row(3).setZero();
+    TS_ASSERT(X2.row(3).isZero());
+    mapped_eigen_matrix<factor_matrix_type> X3;
+    {
+      dir_archive archive_read;
+      archive_read.open_directory_for_read("mapped_blob_test");
+      turi::iarchive iarc(archive_read);
+      iarc >> X3;
+    }
+    check_equal(X, X3);
+
+    // Copies are held in heap memory.
+    mapped_eigen_matrix<factor_matrix_type> X4(X3);
+    TS_ASSERT(!X4.is_mapped());
+    check_equal(X, X4);
+    X4.row(0).setZero();
+    check_equal(X, X3);
+  }
+
+  MAPPED_BLOB_MIN_FILE_SIZE = old_min_file_size;
+}
+
+BOOST_AUTO_TEST_CASE(test_empty_and_plain_archive) {
+  mapped_eigen_matrix<factor_matrix_type> X, X2;
+  save_and_load(X, X2);
+  TS_ASSERT_EQUALS(X2.rows(), 0);
+
+  // Archives without a directory hold the blob inline.
+  X.resize(10, 8);
+  X.setRandom();
+  std::stringstream strm;
+  turi::oarchive oarc(strm);
+  oarc << X;
+  turi::iarchive iarc(strm);
+  mapped_eigen_matrix<factor_matrix_type> X3;
+  iarc >> X3;
+  TS_ASSERT(!X3.is_mapped());
+  check_equal(X, X3);
+}
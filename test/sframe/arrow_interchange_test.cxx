@@ -0,0 +1,233 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <core/storage/sframe_data/sframe.hpp>
+#include <core/storage/sframe_data/sframe_rows.hpp>
+#include <core/storage/sframe_data/testing_utils.hpp>
+#include <core/storage/sframe_data/arrow_interchange.hpp>
+
+using namespace turi;
+
+struct arrow_interchange_test {
+ public:
+  /// Rows of an int, a float, a string, a datetime and a null column
+  std::vector<std::vector<flexible_type> > make_rows(size_t n) {
+    std::vector<std::vector<flexible_type> > rows;
+    for (size_t i = 0; i < n; ++i) {
+      flexible_type a = i % 5 == 1 ? FLEX_UNDEFINED : flexible_type(flex_int(i) - 7);
+      flexible_type b = i % 9 == 4 ? FLEX_UNDEFINED : flexible_type(flex_float(i) / 4);
+      flexible_type c = i % 11 == 0 ? FLEX_UNDEFINED
+                                    : flexible_type(std::string(i % 17, 'a' + i % 26));
+      flexible_type d = flex_date_time(int64_t(i) * 3600 - 100000,
+                                       flex_date_time::EMPTY_TIMEZONE, i % 1000);
+      rows.push_back({a, b, c, d, FLEX_UNDEFINED});
+    }
+    return rows;
+  }
+
+  sframe make_sframe(size_t n) {
+    return make_testing_sframe({"a", "b", "c", "d", "e"},
+                               {flex_type_enum::INTEGER, flex_type_enum::FLOAT,
+                                flex_type_enum::STRING, flex_type_enum::DATETIME,
+                                flex_type_enum::UNDEFINED},
+                               make_rows(n));
+  }
+
+  void check_rows(const std::vector<std::vector<flexible_type> >& rows,
+                  const std::vector<std::vector<flexible_type> >& expected) {
+    TS_ASSERT_EQUALS(rows.size(), expected.size());
+    for (size_t i = 0; i < rows.size() && i < expected.size(); ++i) {
+      TS_ASSERT_EQUALS(rows[i].size(), expected[i].size());
+      for (size_t j = 0; j < rows[i].size(); ++j) {
+        TS_ASSERT_EQUALS(rows[i][j].get_type(), expected[i][j].get_type());
+        TS_ASSERT(rows[i][j] == expected[i][j]);
+      }
+    }
+  }
+
+  void test_sframe_roundtrip() {
+    for (size_t n: {0, 1, 100, 200000}) {
+      sframe sf = make_sframe(n);
+      ArrowSchema schema;
+      ArrowArray array;
+      export_sframe_to_arrow(sf, &schema, &array);
+      TS_ASSERT_EQUALS(std::string(schema.format), "+s");
+      TS_ASSERT_EQUALS(schema.n_children, 5);
+      TS_ASSERT_EQUALS(array.length, n);
+      std::vector<std::string> formats = {"l", "g", "u", "tsu:", "n"};
+      for (size_t c = 0; c < 5; ++c) {
+        TS_ASSERT_EQUALS(std::string(schema.children[c]->format), formats[c]);
+        TS_ASSERT_EQUALS(std::string(schema.children[c]->name), sf.column_name(c));
+      }
+      TS_ASSERT_EQUALS(array.children[4]->null_count, n);
+
+      sframe back = import_sframe_from_arrow(&schema, &array);
+      TS_ASSERT(schema.release == nullptr);
+      TS_ASSERT(array.release == nullptr);
+      TS_ASSERT(back.column_names() == sf.column_names());
+      TS_ASSERT(back.column_types() == sf.column_types());
+      check_rows(testing_extract_sframe_data(back), make_rows(n));
+    }
+  }
+
+  void test_numeric_buffers() {
+    // without nulls, the numeric columns are decoded without flexible_types
+    std::vector<std::vector<flexible_type> > rows;
+    for (size_t i = 0; i < 100000; ++i) {
+      rows.push_back({flex_int(i * 3), flex_float(i) + 0.5});
+    }
+    sframe sf = make_testing_sframe({"x", "y"},
+                                    {flex_type_enum::INTEGER, flex_type_enum::FLOAT},
+                                    rows);
+    ArrowSchema schema;
+    ArrowArray array;
+    export_sframe_to_arrow(sf, &schema, &array);
+    TS_ASSERT_EQUALS(array.children[0]->null_count, 0);
+    TS_ASSERT(array.children[0]->buffers[0] == nullptr);
+    const int64_t* x = static_cast<const int64_t*>(array.children[0]->buffers[1]);
+    const double* y = static_cast<const double*>(array.children[1]->buffers[1]);
+    for (size_t i = 0; i < rows.size(); ++i) {
+      TS_ASSERT_EQUALS(x[i], int64_t(i * 3));
+      TS_ASSERT_EQUALS(y[i], double(i) + 0.5);
+    }
+    schema.release(&schema);
+    array.release(&array);
+  }
+
+  void test_sframe_rows_roundtrip() {
+    auto rows = make_rows(1000);
+    sframe_rows block;
+    block.resize(5, rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+      for (size_t c = 0; c < 5; ++c) (*block.get_columns()[c])[i] = rows[i][c];
+    }
+    ArrowSchema schema;
+    ArrowArray array;
+    export_sframe_rows_to_arrow(block, {"a", "b", "", "d", "e"},
+                                {flex_type_enum::INTEGER, flex_type_enum::FLOAT,
+                                 flex_type_enum::STRING, flex_type_enum::DATETIME,
+                                 flex_type_enum::UNDEFINED},
+                                &schema, &array);
+    // a slice of the struct
+    array.offset = 10;
+    array.length = 900;
+
+    sframe_rows back;
+    std::vector<std::string> names;
+    std::vector<flex_type_enum> types;
+    import_sframe_rows_from_arrow(&schema, &array, back, names, types);
+    TS_ASSERT_EQUALS(names[2], "X3");
+    TS_ASSERT_EQUALS(types[3], flex_type_enum::DATETIME);
+    std::vector<std::vector<flexible_type> > back_rows, expected;
+    for (size_t i = 0; i < 900; ++i) {
+      back_rows.push_back(back[i]);
+      expected.push_back(rows[i + 10]);
+    }
+    check_rows(back_rows, expected);
+  }
+
+  void test_import_formats() {
+    // a struct of an int32, a boolean, a timestamp in ms and a binary column,
+    // with a validity bitmap on the int32 column
+    int32_t ints[4] = {1, -2, 3, 4};
+    uint8_t int_validity = 0x0b;  // row 2 is null
+    uint8_t bools = 0x05;
+    int64_t millis[4] = {1500, -1500, 0, 86400000};
+    int32_t offsets[5] = {0, 1, 3, 3, 6};
+    const char* data = "abcdef";
+
+    const void* int_buffers[2] = {&int_validity, ints};
+    const void* bool_buffers[2] = {nullptr, &bools};
+    const void* ts_buffers[2] = {nullptr, millis};
+    const void* str_buffers[3] = {nullptr, offsets, data};
+    const void* struct_buffers[1] = {nullptr};
+
+    std::vector<ArrowArray> children(4);
+    std::vector<ArrowSchema> child_schemas(4);
+    const char* formats[4] = {"i", "b", "tsm:UTC", "z"};
+    const char* names[4] = {"i", "b", "t", "s"};
+    const void** buffers[4] = {int_buffers, bool_buffers, ts_buffers, str_buffers};
+    ArrowArray* child_pointers[4];
+    ArrowSchema* child_schema_pointers[4];
+    auto release_schema = [](ArrowSchema* s) { s->release = nullptr; };
+    auto release_array = [](ArrowArray* a) { a->release = nullptr; };
+    for (size_t c = 0; c < 4; ++c) {
+      memset(&children[c], 0, sizeof(ArrowArray));
+      memset(&child_schemas[c], 0, sizeof(ArrowSchema));
+      children[c].length = 4;
+      children[c].null_count = c == 0 ? 1 : 0;
+      children[c].n_buffers = c == 3 ? 3 : 2;
+      children[c].buffers = buffers[c];
+      children[c].release = release_array;
+      child_schemas[c].format = formats[c];
+      child_schemas[c].name = names[c];
+      child_schemas[c].release = release_schema;
+      child_pointers[c] = &children[c];
+      child_schema_pointers[c] = &child_schemas[c];
+    }
+    ArrowSchema schema;
+    memset(&schema, 0, sizeof(schema));
+    schema.format = "+s";
+    schema.name = "";
+    schema.n_children = 4;
+    schema.children = child_schema_pointers;
+    schema.release = release_schema;
+    ArrowArray array;
+    memset(&array, 0, sizeof(array));
+    array.length = 4;
+    array.n_buffers = 1;
+    array.n_children = 4;
+    array.buffers = struct_buffers;
+    array.children = child_pointers;
+    array.release = release_array;
+
+    sframe sf = import_sframe_from_arrow(&schema, &array);
+    TS_ASSERT(schema.release == nullptr);
+    TS_ASSERT(sf.column_types() == std::vector<flex_type_enum>(
+        {flex_type_enum::INTEGER, flex_type_enum::INTEGER,
+         flex_type_enum::DATETIME, flex_type_enum::STRING}));
+    auto tz = flex_date_time::EMPTY_TIMEZONE;
+    check_rows(testing_extract_sframe_data(sf),
+               {{1, 1, flex_date_time(1, tz, 500000), "a"},
+                {-2, 0, flex_date_time(-2, tz, 500000), "bc"},
+                {FLEX_UNDEFINED, 1, flex_date_time(0, tz, 0), ""},
+                {4, 0, flex_date_time(86400, tz, 0), "def"}});
+
+    // unsupported formats are rejected, and the structures still released
+    child_schemas[1].format = "e";
+    schema.release = release_schema;
+    array.release = release_array;
+    TS_ASSERT_THROWS_ANYTHING(import_sframe_from_arrow(&schema, &array));
+    TS_ASSERT(schema.release == nullptr);
+    TS_ASSERT(array.release == nullptr);
+  }
+
+  void test_unsupported_export() {
+    sframe sf = make_testing_sframe({"l"}, {flex_type_enum::LIST},
+                                    {{flex_list{1, 2}}});
+    ArrowSchema schema;
+    ArrowArray array;
+    TS_ASSERT_THROWS_ANYTHING(export_sframe_to_arrow(sf, &schema, &array));
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_arrow_interchange_test, arrow_interchange_test)
+BOOST_AUTO_TEST_CASE(test_sframe_roundtrip) {
+  arrow_interchange_test::test_sframe_roundtrip();
+}
+BOOST_AUTO_TEST_CASE(test_numeric_buffers) {
+  arrow_interchange_test::test_numeric_buffers();
+}
+BOOST_AUTO_TEST_CASE(test_sframe_rows_roundtrip) {
+  arrow_interchange_test::test_sframe_rows_roundtrip();
+}
+BOOST_AUTO_TEST_CASE(test_import_formats) {
+  arrow_interchange_test::test_import_formats();
+}
+BOOST_AUTO_TEST_CASE(test_unsupported_export) {
+  arrow_interchange_test::test_unsupported_export();
+}
+BOOST_AUTO_TEST_SUITE_END()
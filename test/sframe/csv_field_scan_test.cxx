@@ -0,0 +1,130 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <core/storage/sframe_data/csv_field_scan.hpp>
+#include <core/storage/sframe_data/csv_line_tokenizer.hpp>
+
+using namespace turi;
+using namespace csv_field_scan;
+
+struct csv_field_scan_test {
+ public:
+  /// A pseudo random line of length len made of the characters in alphabet.
+  std::string make_line(size_t len, size_t seed, const std::string& alphabet) {
+    std::string line;
+    uint64_t state = seed * 2654435761ULL + 1;
+    for (size_t i = 0; i < len; ++i) {
+      state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+      line.push_back(alphabet[(state >> 33) % alphabet.size()]);
+    }
+    return line;
+  }
+
+  void test_find_separators() {
+    const char specials[4] = {'"', '#', '[', '{'};
+    // the dispatched scan must agree exactly with the scalar one, for every
+    // length around the vector widths
+    for (size_t len = 0; len <= 130; ++len) {
+      for (size_t seed = 0; seed < 20; ++seed) {
+        // one line in 5 has special characters
+        std::string alphabet = seed % 5 ? "ab1 ,,,," : "ab1 ,,,,\"#[{";
+        std::string line = make_line(len, seed, alphabet);
+        std::vector<size_t> expected, out;
+        bool expected_ok = find_separators_scalar(line.data(), line.size(), ',',
+                                                  specials, expected);
+        bool ok = find_separators(line.data(), line.size(), ',', specials, out);
+        TS_ASSERT_EQUALS(ok, expected_ok);
+        TS_ASSERT_EQUALS(ok, line.find_first_of("\"#[{") == std::string::npos);
+        if (ok) {
+          TS_ASSERT(out == expected);
+          size_t num_delimiters = std::count(line.begin(), line.end(), ',');
+          TS_ASSERT_EQUALS(out.size(), num_delimiters);
+          for (size_t pos: out) TS_ASSERT_EQUALS(line[pos], ',');
+        }
+      }
+    }
+    // specials past the first vector are also found
+    std::string line(100, 'a');
+    line[70] = '{';
+    std::vector<size_t> out;
+    TS_ASSERT(!find_separators(line.data(), line.size(), ',', specials, out));
+  }
+
+  /// Tokenizes line with and without the structural scan, expecting the same
+  void check_same_tokens(csv_line_tokenizer tokenizer, const std::string& line) {
+    csv_line_tokenizer scalar = tokenizer;
+    tokenizer.structural_scan = true;
+    tokenizer.init();
+    scalar.structural_scan = false;
+    scalar.init();
+
+    std::vector<std::string> expected, out;
+    bool expected_ok = scalar.tokenize_line(line.data(), line.size(), expected);
+    bool ok = tokenizer.tokenize_line(line.data(), line.size(), out);
+    TS_ASSERT_EQUALS(ok, expected_ok);
+    TS_ASSERT(out == expected);
+
+    // typed parsing, with a wrong number of columns on some lines
+    for (size_t num_columns: {out.size(), out.size() + 1}) {
+      for (flex_type_enum type: {flex_type_enum::STRING,
+                                 flex_type_enum::INTEGER,
+                                 flex_type_enum::UNDEFINED}) {
+        std::vector<flexible_type> typed_expected(num_columns, flexible_type(type));
+        std::vector<flexible_type> typed_out(num_columns, flexible_type(type));
+        std::string buf1 = line, buf2 = line;
+        size_t n_expected = scalar.tokenize_line(&buf1[0], buf1.size(),
+                                                 typed_expected, true);
+        size_t n = tokenizer.tokenize_line(&buf2[0], buf2.size(), typed_out, true);
+        TS_ASSERT_EQUALS(n, n_expected);
+        if (n == n_expected) {
+          for (size_t i = 0; i < n; ++i) {
+            TS_ASSERT_EQUALS(typed_out[i].get_type(), typed_expected[i].get_type());
+            TS_ASSERT(typed_out[i].get_type() == flex_type_enum::UNDEFINED ||
+                      typed_out[i] == typed_expected[i]);
+          }
+        }
+      }
+    }
+  }
+
+  void test_tokenize_same_as_state_machine() {
+    csv_line_tokenizer tokenizer;
+    tokenizer.delimiter = ",";
+    for (std::string line: {"", " ", "1,2,3", "1,2,", ",", ",,", " 1 , 2 ,3 ",
+                            "a,  ,b", "1,\"a,b\",3", "1,2 # comment", "[1,2],3",
+                            "1,{\"a\":1},x", "12,-5,3.5", "a\\b,c"}) {
+      check_same_tokens(tokenizer, line);
+    }
+    for (size_t seed = 0; seed < 200; ++seed) {
+      check_same_tokens(tokenizer, make_line(seed % 70, seed, "12a ,,.-"));
+    }
+
+    tokenizer.skip_initial_space = false;
+    for (size_t seed = 0; seed < 100; ++seed) {
+      check_same_tokens(tokenizer, make_line(seed % 70, seed, "12a ,,.-"));
+    }
+
+    tokenizer.delimiter = "\t";
+    tokenizer.skip_initial_space = true;
+    for (size_t seed = 0; seed < 100; ++seed) {
+      check_same_tokens(tokenizer, make_line(seed % 70, seed, "12a \t\t.-"));
+    }
+
+    tokenizer.na_values = {"NA", ""};
+    for (std::string line: {"1,NA,3", "NA,,", "NA\t\tNA", "1\tNA\t"}) {
+      check_same_tokens(tokenizer, line);
+    }
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_csv_field_scan_test, csv_field_scan_test)
+BOOST_AUTO_TEST_CASE(test_find_separators) {
+  csv_field_scan_test::test_find_separators();
+}
+BOOST_AUTO_TEST_CASE(test_tokenize_same_as_state_machine) {
+  csv_field_scan_test::test_tokenize_same_as_state_machine();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,106 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <core/storage/sframe_data/distinct.hpp>
+#include <core/storage/sframe_data/algorithm.hpp>
+
+using namespace turi;
+
+struct distinct_test {
+
+    /**
+     * Create an sframe with columns "key" and "value". Row i has key
+     * i % num_keys, and value "<key>_<i % value_mod>".
+     */
+    sframe create_input_sframe(size_t num_rows, size_t num_keys, size_t value_mod = 1) {
+      std::vector<std::vector<flexible_type>> rows;
+      for (size_t i = 0; i < num_rows; ++i) {
+        rows.push_back({flex_int(i % num_keys),
+                        flex_string(std::to_string(i % num_keys) + "_" +
+                                    std::to_string(i % value_mod))});
+      }
+      sframe ret;
+      ret.open_for_write({"key", "value"},
+                         {flex_type_enum::INTEGER, flex_type_enum::STRING}, "", 4);
+      turi::copy(rows.begin(), rows.end(), ret);
+      ret.close();
+      return ret;
+    }
+
+    std::vector<std::vector<flexible_type>> read_all(sframe sf) {
+      std::vector<std::vector<flexible_type>> rows;
+      sf.get_reader()->read_rows(0, sf.num_rows(), rows);
+      return rows;
+    }
+
+    /// Checks that out holds each distinct row of in exactly once
+    void check_distinct(sframe in, sframe out) {
+      std::set<std::vector<flexible_type>> expected;
+      for (auto& row: read_all(in)) expected.insert(row);
+      auto rows = read_all(out);
+      std::set<std::vector<flexible_type>> actual(rows.begin(), rows.end());
+      TS_ASSERT_EQUALS(rows.size(), actual.size());
+      TS_ASSERT(actual == expected);
+    }
+
+  public:
+    void test_few_duplicates() {
+      // every row is unique but the last 100
+      sframe in = create_input_sframe(20100, 20000);
+      check_distinct(in, distinct(in));
+    }
+
+    void test_many_duplicates() {
+      sframe in = create_input_sframe(20000, 37);
+      sframe out = distinct(in);
+      TS_ASSERT_EQUALS(out.num_rows(), 37);
+      check_distinct(in, out);
+    }
+
+    void test_small_memory_budget() {
+      // too little memory for the filters: everything goes through the
+      // partitions
+      sframe in = create_input_sframe(20000, 5000);
+      check_distinct(in, distinct(in, {}, 4096));
+    }
+
+    void test_key_columns() {
+      sframe in = create_input_sframe(10000, 100, 7);
+      TS_ASSERT_EQUALS(distinct(in).num_rows(), 700);
+      sframe out = distinct(in, {0});
+      TS_ASSERT_EQUALS(out.num_rows(), 100);
+      std::set<flexible_type> keys;
+      for (auto& row: read_all(out)) {
+        keys.insert(row[0]);
+        // whole rows are kept
+        TS_ASSERT_EQUALS(row[1].get<flex_string>().find(
+            std::to_string(row[0].get<flex_int>()) + "_"), 0);
+      }
+      TS_ASSERT_EQUALS(keys.size(), 100);
+    }
+
+    void test_edge() {
+      sframe empty = create_input_sframe(0, 1);
+      TS_ASSERT_EQUALS(distinct(empty).num_rows(), 0);
+      sframe one = create_input_sframe(1, 1);
+      TS_ASSERT_EQUALS(distinct(one).num_rows(), 1);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_distinct_test, distinct_test)
+BOOST_AUTO_TEST_CASE(test_few_duplicates) {
+  distinct_test::test_few_duplicates();
+}
+BOOST_AUTO_TEST_CASE(test_many_duplicates) {
+  distinct_test::test_many_duplicates();
+}
+BOOST_AUTO_TEST_CASE(test_small_memory_budget) {
+  distinct_test::test_small_memory_budget();
+}
+BOOST_AUTO_TEST_CASE(test_key_columns) {
+  distinct_test::test_key_columns();
+}
+BOOST_AUTO_TEST_CASE(test_edge) {
+  distinct_test::test_edge();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -137,6 +137,35 @@ struct integer_pack_test {
       }
     }
   }
+  void test_unpack_block() {
+    // the dispatched unpacker must agree exactly with the scalar one
+    // for every bit width and every length, including the partial
+    // leading byte used by the sub-byte packings.
+    std::vector<uint64_t> in(128), expected(128), out(128);
+    std::vector<uint8_t> pack(128 * 8);
+    for (unsigned char nbits: {1, 2, 4, 8, 16, 32}) {
+      uint64_t mask = (uint64_t(1) << nbits) - 1;
+      for (size_t len = 1; len <= 128; ++len) {
+        for (size_t i = 0;i < len; ++i) {
+          in[i] = (i * 2654435761ULL + len) & mask;
+        }
+        switch(nbits) {
+         case 1: pack_1(in.data(), len, pack.data()); break;
+         case 2: pack_2(in.data(), len, pack.data()); break;
+         case 4: pack_4(in.data(), len, pack.data()); break;
+         case 8: pack_8(in.data(), len, pack.data()); break;
+         case 16: pack_16(in.data(), len, (uint16_t*)pack.data()); break;
+         case 32: pack_32(in.data(), len, (uint32_t*)pack.data()); break;
+        }
+        unpack_block_scalar(nbits, pack.data(), len, expected.data());
+        unpack_block(nbits, pack.data(), len, out.data());
+        for (size_t i = 0;i < len; ++i) {
+          TS_ASSERT_EQUALS(in[i], expected[i]);
+          TS_ASSERT_EQUALS(expected[i], out[i]);
+        }
+      }
+    }
+  }
   void test_shift_encode() {
     int64_t maxint = std::numeric_limits<int64_t>::max();
     int64_t minint = std::numeric_limits<int64_t>::min();
@@ -165,6 +194,9 @@ BOOST_AUTO_TEST_CASE(test_variable_code) {
 BOOST_AUTO_TEST_CASE(test_pack) {
   integer_pack_test::test_pack();
 }
+BOOST_AUTO_TEST_CASE(test_unpack_block) {
+  integer_pack_test::test_unpack_block();
+}
 BOOST_AUTO_TEST_CASE(test_shift_encode) {
   integer_pack_test::test_shift_encode();
 }
@@ -0,0 +1,157 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <string>
+#include <vector>
+#include <core/storage/fileio/general_fstream.hpp>
+#include <core/storage/fileio/temp_files.hpp>
+#include <core/storage/sframe_data/sframe.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
+#include <core/storage/sframe_data/testing_utils.hpp>
+#include <core/storage/sframe_data/json_lines_parser.hpp>
+
+using namespace turi;
+
+struct json_lines_test {
+ public:
+  std::string write_file(const std::string& contents) {
+    std::string url = get_temp_name() + ".json";
+    general_ofstream fout(url);
+    fout << contents;
+    return url;
+  }
+
+  void test_parse_json_value() {
+    flexible_type v;
+    std::string s = " -42 ";
+    TS_ASSERT(parse_json_value(s.data(), s.data() + s.size(), v));
+    TS_ASSERT(v == flexible_type(flex_int(-42)));
+
+    s = "[1, 2.5, -3e2]";
+    TS_ASSERT(parse_json_value(s.data(), s.data() + s.size(), v));
+    TS_ASSERT_EQUALS(v.get_type(), flex_type_enum::VECTOR);
+    TS_ASSERT(v == flexible_type(flex_vec{1, 2.5, -300}));
+
+    s = "{\"a\": [1, \"x\", null], \"b\\u00e9\": {\"c\": true}}";
+    TS_ASSERT(parse_json_value(s.data(), s.data() + s.size(), v));
+    TS_ASSERT_EQUALS(v.get_type(), flex_type_enum::DICT);
+    const flex_dict& dict = v.get<flex_dict>();
+    TS_ASSERT_EQUALS(dict.size(), 2);
+    TS_ASSERT_EQUALS(dict[0].second.get_type(), flex_type_enum::LIST);
+    TS_ASSERT(dict[1].first == flexible_type("b\xc3\xa9"));
+    TS_ASSERT(dict[1].second.get<flex_dict>()[0].second == flexible_type(1));
+
+    s = "\"\\ud83d\\ude00 \\\"q\\\"\"";
+    TS_ASSERT(parse_json_value(s.data(), s.data() + s.size(), v));
+    TS_ASSERT(v == flexible_type("\xf0\x9f\x98\x80 \"q\""));
+
+    s = "99999999999999999999";
+    TS_ASSERT(parse_json_value(s.data(), s.data() + s.size(), v));
+    TS_ASSERT_EQUALS(v.get_type(), flex_type_enum::FLOAT);
+
+    for (std::string bad: {"", "{", "[1,]", "{\"a\" 1}", "01", "tru", "1 2",
+                           "\"abc", "\"\\x\"", "-", "1."}) {
+      TS_ASSERT(!parse_json_value(bad.data(), bad.data() + bad.size(), v));
+    }
+  }
+
+  void test_schema_inference() {
+    std::string url = write_file(
+        "{\"id\": 1, \"score\": 2, \"name\": \"a\", \"tags\": [1, 2]}\n"
+        "\n"
+        "{\"id\": 2, \"score\": 1.5, \"name\": null, \"tags\": [\"x\"], \"extra\": {\"k\": 1}}\r\n"
+        "{\"name\": \"c\", \"id\": 3, \"mixed\": 1}\n"
+        "{\"id\": 4, \"mixed\": \"s\", \"score\": 3}");
+    sframe sf = parse_json_lines(url);
+    TS_ASSERT(sf.column_names() == std::vector<std::string>(
+        {"id", "score", "name", "tags", "extra", "mixed"}));
+    TS_ASSERT(sf.column_types() == std::vector<flex_type_enum>(
+        {flex_type_enum::INTEGER, flex_type_enum::FLOAT, flex_type_enum::STRING,
+         flex_type_enum::LIST, flex_type_enum::DICT, flex_type_enum::STRING}));
+    auto rows = testing_extract_sframe_data(sf);
+    TS_ASSERT_EQUALS(rows.size(), 4);
+    TS_ASSERT(rows[0][1] == flexible_type(2.0));
+    TS_ASSERT(rows[0][3] == flexible_type(flex_list{1.0, 2.0}));
+    TS_ASSERT(rows[1][2] == FLEX_UNDEFINED);
+    TS_ASSERT(rows[2][2] == flexible_type("c"));
+    TS_ASSERT(rows[2][4] == FLEX_UNDEFINED);
+    // values of string columns which are not strings keep their JSON text
+    TS_ASSERT(rows[2][5] == flexible_type("1"));
+    TS_ASSERT(rows[3][5] == flexible_type("s"));
+  }
+
+  void test_type_hints_and_failures() {
+    std::string url = write_file(
+        "{\"a\": 1, \"b\": \"x\"}\n"
+        "{\"a\": 2.5, \"b\": \"y\"}\n"
+        "not json\n"
+        "{\"a\": 3}\n");
+    json_lines_options options;
+    options.sample_rows = 1;
+    TS_ASSERT_THROWS_ANYTHING(parse_json_lines(url, options));
+
+    options.continue_on_failure = true;
+    options.column_type_hints["c"] = flex_type_enum::FLOAT;
+    sframe sf = parse_json_lines(url, options);
+    TS_ASSERT(sf.column_names() == std::vector<std::string>({"a", "b", "c"}));
+    auto rows = testing_extract_sframe_data(sf);
+    // 2.5 does not fit the inferred INTEGER column
+    TS_ASSERT_EQUALS(rows.size(), 2);
+    TS_ASSERT(rows[1][0] == flexible_type(3));
+    TS_ASSERT(rows[1][1] == FLEX_UNDEFINED);
+
+    options.column_type_hints["a"] = flex_type_enum::FLOAT;
+    sf = parse_json_lines(url, options);
+    TS_ASSERT_EQUALS(sf.num_rows(), 3);
+    TS_ASSERT_EQUALS(sf.column_type(0), flex_type_enum::FLOAT);
+  }
+
+  void test_values() {
+    std::string url = write_file("1\n2\n[3]\n\"4\"\n");
+    sframe sf = parse_json_lines(url);
+    TS_ASSERT(sf.column_names() == std::vector<std::string>({"X1"}));
+    TS_ASSERT_EQUALS(sf.column_type(0), flex_type_enum::STRING);
+    auto rows = testing_extract_sframe_data(sf);
+    TS_ASSERT(rows[2][0] == flexible_type("[3]"));
+    TS_ASSERT(rows[3][0] == flexible_type("4"));
+  }
+
+  void test_ranges() {
+    size_t old_min_range_size = SFRAME_CSV_PARSER_MIN_RANGE_SIZE;
+    SFRAME_CSV_PARSER_MIN_RANGE_SIZE = 1000;
+    std::string contents;
+    size_t n = 20000;
+    for (size_t i = 0; i < n; ++i) {
+      contents += "{\"i\": " + std::to_string(i) + ", \"s\": \"v" +
+                  std::to_string(i % 13) + "\\n\"}\n";
+    }
+    std::string url = write_file(contents);
+    sframe sf = parse_json_lines(url);
+    SFRAME_CSV_PARSER_MIN_RANGE_SIZE = old_min_range_size;
+
+    auto rows = testing_extract_sframe_data(sf);
+    TS_ASSERT_EQUALS(rows.size(), n);
+    for (size_t i = 0; i < rows.size(); ++i) {
+      TS_ASSERT(rows[i][0] == flexible_type(i));
+      TS_ASSERT(rows[i][1] == flexible_type("v" + std::to_string(i % 13) + "\n"));
+    }
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_json_lines_test, json_lines_test)
+BOOST_AUTO_TEST_CASE(test_parse_json_value) {
+  json_lines_test::test_parse_json_value();
+}
+BOOST_AUTO_TEST_CASE(test_schema_inference) {
+  json_lines_test::test_schema_inference();
+}
+BOOST_AUTO_TEST_CASE(test_type_hints_and_failures) {
+  json_lines_test::test_type_hints_and_failures();
+}
+BOOST_AUTO_TEST_CASE(test_values) {
+  json_lines_test::test_values();
+}
+BOOST_AUTO_TEST_CASE(test_ranges) {
+  json_lines_test::test_ranges();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,209 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <string>
+#include <vector>
+#include <core/storage/fileio/general_fstream.hpp>
+#include <core/storage/fileio/temp_files.hpp>
+#include <core/storage/sframe_data/sframe.hpp>
+#include <core/storage/sframe_data/testing_utils.hpp>
+#include <core/storage/sframe_data/parquet_format.hpp>
+#include <core/storage/sframe_data/parquet_reader.hpp>
+#include <core/storage/sframe_data/parquet_writer.hpp>
+#include <core/storage/query_engine/planning/planner.hpp>
+#include <core/storage/query_engine/operators/all_operators.hpp>
+
+using namespace turi;
+using namespace turi::query_eval;
+
+struct parquet_test {
+ public:
+  /// Rows of an int, a float, a string and a datetime column, with nulls
+  std::vector<std::vector<flexible_type> > make_rows(size_t n) {
+    std::vector<std::vector<flexible_type> > rows;
+    for (size_t i = 0; i < n; ++i) {
+      flexible_type a = i % 7 == 3 ? FLEX_UNDEFINED : flexible_type(flex_int(i));
+      flexible_type b = flex_float(i) * 0.5;
+      flexible_type c = i % 11 == 0 ? FLEX_UNDEFINED
+                                    : flexible_type("s" + std::to_string(i % 100));
+      flexible_type d = flex_date_time(1500000000 + i * 60,
+                                       flex_date_time::EMPTY_TIMEZONE, i % 1000);
+      rows.push_back({a, b, c, d});
+    }
+    return rows;
+  }
+
+  parquet_column_range make_range(const std::string& column,
+                                  flexible_type lower, flexible_type upper) {
+    parquet_column_range ret;
+    ret.column = column;
+    ret.lower = lower;
+    ret.upper = upper;
+    return ret;
+  }
+
+  sframe make_sframe(size_t n) {
+    return make_testing_sframe({"a", "b", "c", "d"},
+                               {flex_type_enum::INTEGER, flex_type_enum::FLOAT,
+                                flex_type_enum::STRING, flex_type_enum::DATETIME},
+                               make_rows(n));
+  }
+
+  void check_rows(const sframe& sf, const std::vector<std::vector<flexible_type> >& expected) {
+    auto rows = testing_extract_sframe_data(sf);
+    TS_ASSERT_EQUALS(rows.size(), expected.size());
+    for (size_t i = 0; i < rows.size() && i < expected.size(); ++i) {
+      TS_ASSERT_EQUALS(rows[i].size(), expected[i].size());
+      for (size_t j = 0; j < rows[i].size(); ++j) {
+        TS_ASSERT_EQUALS(rows[i][j].get_type(), expected[i][j].get_type());
+        TS_ASSERT(rows[i][j] == expected[i][j]);
+      }
+    }
+  }
+
+  void test_roundtrip() {
+    std::vector<parquet::compression_codec> codecs = {
+      parquet::compression_codec::UNCOMPRESSED, parquet::compression_codec::SNAPPY,
+      parquet::compression_codec::GZIP, parquet::compression_codec::LZ4_RAW};
+    for (size_t n: {0, 1, 1000, 100000}) {
+      sframe sf = make_sframe(n);
+      for (auto codec: codecs) {
+        std::string url = get_temp_name() + ".parquet";
+        parquet_write_options options;
+        options.codec = codec;
+        options.row_group_size = 30000;
+        write_parquet(sf, url, options);
+
+        parquet_reader reader(url);
+        TS_ASSERT_EQUALS(reader.num_rows(), n);
+        TS_ASSERT_EQUALS(reader.num_row_groups(), (n + 29999) / 30000);
+        TS_ASSERT(reader.column_names() == sf.column_names());
+        TS_ASSERT(reader.column_types() == sf.column_types());
+
+        sframe back = read_parquet(url);
+        TS_ASSERT(back.column_names() == sf.column_names());
+        check_rows(back, make_rows(n));
+      }
+    }
+  }
+
+  void test_select_columns_and_row_groups() {
+    size_t n = 10000;
+    std::string url = get_temp_name() + ".parquet";
+    parquet_write_options options;
+    options.row_group_size = 1000;
+    write_parquet(make_sframe(n), url, options);
+    auto rows = make_rows(n);
+
+    parquet_read_options read_options;
+    read_options.columns = {"c", "a"};
+    // column a is i in row i, except for nulls
+    read_options.row_group_filters = {make_range("a", 2500, 4200)};
+    sframe sf = read_parquet(url, read_options);
+    TS_ASSERT_EQUALS(sf.num_columns(), 2);
+    TS_ASSERT_EQUALS(sf.column_name(0), "c");
+
+    std::vector<std::vector<flexible_type> > expected;
+    for (size_t i = 2000; i < 5000; ++i) expected.push_back({rows[i][2], rows[i][0]});
+    check_rows(sf, expected);
+
+    parquet_reader reader(url);
+    TS_ASSERT(reader.select_row_groups({make_range("a", FLEX_UNDEFINED, 999)}) ==
+              std::vector<size_t>({0}));
+    TS_ASSERT(reader.select_row_groups({make_range("a", 20000, FLEX_UNDEFINED)}).empty());
+    TS_ASSERT(reader.select_row_groups({make_range("c", "s98", "s99")}).size() == 10);
+    TS_ASSERT_THROWS_ANYTHING(reader.select_row_groups({make_range("a", "x", "y")}));
+    TS_ASSERT_THROWS_ANYTHING(reader.column_index("e"));
+  }
+
+  void test_parquet_source_node() {
+    size_t n = 50000;
+    std::string url = get_temp_name() + ".parquet";
+    parquet_write_options options;
+    options.row_group_size = 7000;
+    write_parquet(make_sframe(n), url, options);
+    auto rows = make_rows(n);
+
+    auto reader = std::make_shared<parquet_reader>(url);
+    auto source = op_parquet_source::make_planner_node(reader, {3, 0}, {1, 2, 3});
+    TS_ASSERT_EQUALS(infer_planner_node_length(source), 21000);
+    sframe sf = planner().materialize(source);
+    std::vector<std::vector<flexible_type> > expected;
+    for (size_t i = 7000; i < 28000; ++i) expected.push_back({rows[i][3], rows[i][0]});
+    check_rows(sf, expected);
+
+    // the projection is folded into the source
+    auto all = op_parquet_source::make_planner_node(reader);
+    sf = planner().materialize(op_project::make_planner_node(all, {2}));
+    expected.clear();
+    for (size_t i = 0; i < n; ++i) expected.push_back({rows[i][2]});
+    check_rows(sf, expected);
+  }
+
+  void test_corrupted_file() {
+    std::string url = get_temp_name() + ".parquet";
+    {
+      general_ofstream fout(url);
+      fout << "PAR1 this is not a parquet file";
+    }
+    TS_ASSERT_THROWS_ANYTHING(parquet_reader reader(url));
+  }
+
+  void test_rle_encoding() {
+    for (size_t bit_width: {1, 2, 5, 20}) {
+      std::vector<uint32_t> values;
+      for (size_t i = 0; i < 1000; ++i) {
+        // runs and noise
+        values.push_back((i / 50) % 2 ? 1 : (i * 2654435761u) % (1u << bit_width));
+      }
+      std::string encoded;
+      parquet::rle_encode(values.data(), values.size(), bit_width, encoded);
+      std::vector<uint32_t> decoded(values.size());
+      parquet::rle_decoder decoder(encoded.data(), encoded.size(), bit_width);
+      decoder.decode(decoded.data(), decoded.size());
+      TS_ASSERT(decoded == values);
+    }
+  }
+
+  void test_compression() {
+    std::string data;
+    for (size_t i = 0; i < 200000; ++i) {
+      data += i % 3 ? "abcabc" : std::to_string(i * 7919);
+    }
+    for (auto codec: {parquet::compression_codec::SNAPPY,
+                      parquet::compression_codec::GZIP,
+                      parquet::compression_codec::LZ4_RAW}) {
+      std::string compressed;
+      parquet::compress(codec, data.data(), data.size(), compressed);
+      TS_ASSERT_LESS_THAN(compressed.size(), data.size());
+      std::string decompressed(data.size(), 0);
+      parquet::decompress(codec, compressed.data(), compressed.size(),
+                          &decompressed[0], decompressed.size());
+      TS_ASSERT(decompressed == data);
+      TS_ASSERT_THROWS_ANYTHING(
+          parquet::decompress(codec, compressed.data(), compressed.size() / 2,
+                              &decompressed[0], decompressed.size()));
+    }
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_parquet_test, parquet_test)
+BOOST_AUTO_TEST_CASE(test_roundtrip) {
+  parquet_test::test_roundtrip();
+}
+BOOST_AUTO_TEST_CASE(test_select_columns_and_row_groups) {
+  parquet_test::test_select_columns_and_row_groups();
+}
+BOOST_AUTO_TEST_CASE(test_parquet_source_node) {
+  parquet_test::test_parquet_source_node();
+}
+BOOST_AUTO_TEST_CASE(test_corrupted_file) {
+  parquet_test::test_corrupted_file();
+}
+BOOST_AUTO_TEST_CASE(test_rle_encoding) {
+  parquet_test::test_rle_encoding();
+}
+BOOST_AUTO_TEST_CASE(test_compression) {
+  parquet_test::test_compression();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,10 +1,13 @@
 #define BOOST_TEST_MODULE
 #include <boost/test/unit_test.hpp>
 #include <core/util/test_macros.hpp>
+#include <limits>
 #include <core/storage/fileio/temp_files.hpp>
 #include <core/storage/sframe_data/sarray_v2_block_manager.hpp>
 #include <core/storage/sframe_data/sarray_file_format_v2.hpp>
 #include <core/storage/sframe_data/sarray_index_file.hpp>
+#include <core/storage/sframe_data/sarray_v2_type_encoding.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
 #include <timer/timer.hpp>
 #include <core/random/random.hpp>
 
@@ -569,6 +572,463 @@ struct sarray_file_format_v2_test {
     }
   }
 
+
+  void test_read_rows_as(void) {
+    // column 0 is integers with missing values, column 1 is doubles with
+    // missing values, column 2 is doubles which are all integral, and
+    // column 3 mixes integers and doubles.
+    sarray_group_format_writer_v2<flexible_type> group_writer;
+    std::string test_file_name = get_temp_name() + ".sidx";
+    group_writer.open(test_file_name, 4, 4);
+    const size_t rows_per_segment = 100000;
+    size_t v = 0;
+    for (size_t i = 0;i < 4; ++i) {
+      for (size_t j = 0;j < rows_per_segment; ++j) {
+        flexible_type intval = (flex_int)v - 50000;
+        if (v % 7 == 0) intval = FLEX_UNDEFINED;
+        flexible_type floatval = 0.5 * v - 1000.25;
+        if (v % 5 == 0) floatval = FLEX_UNDEFINED;
+        flexible_type mixedval = (v % 2) ? flexible_type((flex_int)v)
+                                         : flexible_type(0.5 * v);
+        group_writer.write_segment(0, i, intval);
+        group_writer.write_segment(1, i, floatval);
+        group_writer.write_segment(2, i, flexible_type((flex_float)v));
+        group_writer.write_segment(3, i, mixedval);
+        ++v;
+      }
+    }
+    group_writer.close();
+    group_writer.write_index_file();
+    const size_t num_rows = 4 * rows_per_segment;
+
+    for (size_t c = 0; c < 4; ++c) {
+      sarray_format_reader_v2<flexible_type> reader;
+      reader.open(test_file_name + ":" + std::to_string(c));
+      std::vector<flexible_type> expected;
+      reader.read_rows(0, num_rows, expected);
+
+      // read in chunks which do not align with the block boundaries
+      std::vector<flex_float> float_values(num_rows);
+      std::vector<flex_int> int_values(num_rows);
+      for (size_t start = 0; start < num_rows; start += 3001) {
+        size_t end = std::min(start + 3001, num_rows);
+        TS_ASSERT_EQUALS(reader.read_rows_as(start, end,
+                                             &float_values[start], -1.0),
+                         end - start);
+        TS_ASSERT_EQUALS(reader.read_rows_as(start, end,
+                                             &int_values[start], (flex_int)-1),
+                         end - start);
+      }
+      for (size_t i = 0;i < num_rows; ++i) {
+        if (expected[i].get_type() == flex_type_enum::UNDEFINED) {
+          TS_ASSERT_EQUALS(float_values[i], -1.0);
+          TS_ASSERT_EQUALS(int_values[i], -1);
+        } else {
+          if (float_values[i] != (flex_float)expected[i]) {
+            TS_ASSERT_EQUALS(float_values[i], (flex_float)expected[i]);
+          }
+          if (int_values[i] != (flex_int)expected[i]) {
+            TS_ASSERT_EQUALS(int_values[i], (flex_int)expected[i]);
+          }
+        }
+      }
+      // read past the end
+      TS_ASSERT_EQUALS(reader.read_rows_as(num_rows - 5, 2 * num_rows,
+                                           float_values.data(), 0.0), 5);
+    }
+  }
+
+  void test_zone_maps(void) {
+    // column 0 is integers with missing values, column 1 is doubles,
+    // column 2 is strings and column 3 is datetimes.
+    sarray_group_format_writer_v2<flexible_type> group_writer;
+    std::string test_file_name = get_temp_name() + ".sidx";
+    group_writer.open(test_file_name, 2, 4);
+    const size_t rows_per_segment = 50000;
+    size_t v = 0;
+    for (size_t i = 0;i < 2; ++i) {
+      for (size_t j = 0;j < rows_per_segment; ++j) {
+        flexible_type intval = (flex_int)v;
+        if (v % 7 == 0) intval = FLEX_UNDEFINED;
+        group_writer.write_segment(0, i, intval);
+        group_writer.write_segment(1, i, flexible_type(v * 0.1 - 20.0));
+        group_writer.write_segment(2, i, flexible_type("s" + std::to_string(v % 1000)));
+        group_writer.write_segment(3, i, flexible_type(flex_date_time(1500000000 + v, 0, v % 1000)));
+        ++v;
+      }
+    }
+    group_writer.close();
+    group_writer.write_index_file();
+
+    auto group_index = read_array_group_index_file(test_file_name);
+    TS_ASSERT_EQUALS(group_index.columns.size(), 4);
+    for (size_t c = 0; c < 4; ++c) {
+      const auto& column_index = group_index.columns[c];
+      TS_ASSERT_EQUALS(column_index.block_zone_maps.size(), 2);
+      sarray_format_reader_v2<flexible_type> reader;
+      reader.open(column_index);
+      std::vector<flexible_type> values;
+      reader.read_rows(0, 2 * rows_per_segment, values);
+
+      size_t row = 0;
+      for (size_t seg = 0; seg < 2; ++seg) {
+        size_t segment_rows = 0;
+        for (const auto& zone_map: column_index.block_zone_maps[seg]) {
+          TS_ASSERT(zone_map.valid);
+          TS_ASSERT(zone_map.has_bounds);
+          size_t num_undefined = 0;
+          using v2_block_impl::block_predicate;
+          for (size_t i = row; i < row + zone_map.num_elem; ++i) {
+            if (values[i].get_type() == flex_type_enum::UNDEFINED) {
+              ++num_undefined;
+              continue;
+            }
+            TS_ASSERT(zone_map.min_value <= values[i]);
+            TS_ASSERT(values[i] <= zone_map.max_value);
+            // every value in the block must be matched
+            block_predicate pred;
+            pred.op = block_predicate::op_type::EQ;
+            pred.value = values[i];
+            TS_ASSERT(zone_map.may_match(pred));
+          }
+          TS_ASSERT_EQUALS(zone_map.num_undefined, num_undefined);
+          TS_ASSERT(zone_map.num_distinct <= zone_map.num_elem - num_undefined);
+          TS_ASSERT(zone_map.num_distinct > 0);
+
+          // nothing is greater than the maximum
+          block_predicate pred;
+          pred.op = block_predicate::op_type::GT;
+          pred.value = zone_map.max_value;
+          TS_ASSERT(!zone_map.may_match(pred));
+          pred.op = block_predicate::op_type::IS_UNDEFINED;
+          TS_ASSERT_EQUALS(zone_map.may_match(pred), num_undefined > 0);
+          row += zone_map.num_elem;
+          segment_rows += zone_map.num_elem;
+        }
+        TS_ASSERT_EQUALS(segment_rows, column_index.segment_sizes[seg]);
+      }
+    }
+  }
+
+  void test_evaluate_predicate(void) {
+    // column 0 is integers with missing values, column 1 is doubles,
+    // column 2 is dictionary encoded strings and column 3 is datetimes.
+    sarray_group_format_writer_v2<flexible_type> group_writer;
+    std::string test_file_name = get_temp_name() + ".sidx";
+    group_writer.open(test_file_name, 2, 4);
+    const size_t rows_per_segment = 50000;
+    size_t v = 0;
+    for (size_t i = 0;i < 2; ++i) {
+      for (size_t j = 0;j < rows_per_segment; ++j) {
+        flexible_type intval = (flex_int)v;
+        if (v % 7 == 0) intval = FLEX_UNDEFINED;
+        group_writer.write_segment(0, i, intval);
+        group_writer.write_segment(1, i, flexible_type(v * 0.1 - 20.0));
+        group_writer.write_segment(2, i, flexible_type("s" + std::to_string(v % 10)));
+        group_writer.write_segment(3, i, flexible_type(flex_date_time(1500000000 + v, 0, 0)));
+        ++v;
+      }
+    }
+    group_writer.close();
+    group_writer.write_index_file();
+    const size_t num_rows = 2 * rows_per_segment;
+
+    using v2_block_impl::block_predicate;
+    typedef block_predicate::op_type op_type;
+    std::vector<std::vector<flexible_type>> values_to_test{
+      {flexible_type(70000), flexible_type(21.5)},
+      {flexible_type(-20.0), flexible_type(5000.0)},
+      {flexible_type("s3"), flexible_type("s30")},
+      {flexible_type(flex_date_time(1500060000, 0, 0))}};
+    std::vector<op_type> ops{op_type::IS_UNDEFINED, op_type::IS_DEFINED,
+                             op_type::EQ, op_type::NE, op_type::LT,
+                             op_type::LE, op_type::GT, op_type::GE};
+
+    for (size_t c = 0; c < 4; ++c) {
+      sarray_format_reader_v2<flexible_type> reader;
+      reader.open(test_file_name + ":" + std::to_string(c));
+      std::vector<flexible_type> values;
+      reader.read_rows(0, num_rows, values);
+
+      for (const auto& value: values_to_test[c]) {
+        for (op_type op: ops) {
+          block_predicate pred;
+          pred.op = op;
+          pred.value = value;
+          // evaluate in chunks which do not align with the block boundaries
+          dense_bitset selection;
+          for (size_t start = 0; start < num_rows; start += 3001) {
+            size_t end = std::min(start + 3001, num_rows);
+            TS_ASSERT_EQUALS(reader.evaluate_predicate(start, end, pred, selection),
+                             end - start);
+            TS_ASSERT_EQUALS(selection.size(), end - start);
+            for (size_t i = start; i < end; ++i) {
+              if (selection.get(i - start) != pred(values[i])) {
+                TS_ASSERT_EQUALS(selection.get(i - start), pred(values[i]));
+              }
+            }
+          }
+        }
+      }
+      // read past the end
+      block_predicate pred;
+      dense_bitset selection;
+      TS_ASSERT_EQUALS(reader.evaluate_predicate(num_rows - 5, 2 * num_rows,
+                                                 pred, selection), 5);
+      TS_ASSERT_EQUALS(selection.size(), 5);
+    }
+  }
+
+  void test_string_dictionary_encoding(void) {
+    // columns of increasing cardinality. The low cardinality columns are
+    // dictionary encoded and must round trip exactly.
+    std::vector<size_t> cardinalities{1, 10, 500, 3000, 1000000};
+    sarray_group_format_writer_v2<flexible_type> group_writer;
+    std::string test_file_name = get_temp_name() + ".sidx";
+    group_writer.open(test_file_name, 2, cardinalities.size());
+    const size_t rows_per_segment = 200000;
+    size_t v = 0;
+    for (size_t i = 0;i < 2; ++i) {
+      for (size_t j = 0;j < rows_per_segment; ++j) {
+        for (size_t c = 0; c < cardinalities.size(); ++c) {
+          flexible_type val = "country_" + std::to_string((v * 7919) % cardinalities[c]);
+          if (v % 11 == 0) val = FLEX_UNDEFINED;
+          group_writer.write_segment(c, i, val);
+        }
+        ++v;
+      }
+    }
+    group_writer.close();
+    group_writer.write_index_file();
+
+    for (size_t c = 0; c < cardinalities.size(); ++c) {
+      sarray_format_reader_v2<flexible_type> reader;
+      reader.open(test_file_name + ":" + std::to_string(c));
+      std::vector<flexible_type> vals;
+      reader.read_rows(0, 2 * rows_per_segment, vals);
+      TS_ASSERT_EQUALS(vals.size(), 2 * rows_per_segment);
+      for (size_t i = 0;i < vals.size(); ++i) {
+        if (i % 11 == 0) {
+          TS_ASSERT_EQUALS((int)(vals[i].get_type()), (int)flex_type_enum::UNDEFINED);
+        } else {
+          std::string expected = "country_" + std::to_string((i * 7919) % cardinalities[c]);
+          if (vals[i] != expected) TS_ASSERT_EQUALS(vals[i].get<flex_string>(), expected);
+        }
+      }
+    }
+  }
+
+  void test_string_buffer_reuse(void) {
+    // distinct strings of varying lengths, so they are not dictionary
+    // encoded, read in batches into the same buffer
+    auto make_string = [](size_t v) {
+      return std::to_string(v) + std::string(v % 40, 'x');
+    };
+    sarray_group_format_writer_v2<flexible_type> group_writer;
+    std::string test_file_name = get_temp_name() + ".sidx";
+    group_writer.open(test_file_name, 1, 1);
+    const size_t num_rows = 100000;
+    for (size_t v = 0; v < num_rows; ++v) {
+      flexible_type val = make_string(v);
+      if (v % 13 == 0) val = FLEX_UNDEFINED;
+      group_writer.write_segment(0, 0, val);
+    }
+    group_writer.close();
+    group_writer.write_index_file();
+
+    sarray_format_reader_v2<flexible_type> reader;
+    reader.open(test_file_name);
+    std::vector<flexible_type> vals;
+    // values of the previous batch held on to while the buffer is reused
+    std::vector<flexible_type> held;
+    for (size_t row = 0; row < num_rows; row += 1000) {
+      reader.read_rows(row, row + 1000, vals);
+      TS_ASSERT_EQUALS(vals.size(), 1000);
+      for (size_t i = 0; i < held.size(); ++i) {
+        size_t v = row - 1000 + 2 * i;
+        if (v % 13 != 0 && held[i] != make_string(v)) {
+          TS_ASSERT_EQUALS(held[i].get<flex_string>(), make_string(v));
+        }
+      }
+      held.clear();
+      for (size_t i = 0; i < vals.size(); ++i) {
+        size_t v = row + i;
+        if (v % 13 == 0) {
+          TS_ASSERT_EQUALS((int)(vals[i].get_type()), (int)flex_type_enum::UNDEFINED);
+        } else if (vals[i] != make_string(v)) {
+          TS_ASSERT_EQUALS(vals[i].get<flex_string>(), make_string(v));
+        }
+        if (i % 2 == 0) held.push_back(vals[i]);
+      }
+    }
+  }
+
+  void test_integer_encodings(void) {
+    using namespace v2_block_impl;
+    const size_t n = 5000;
+    std::vector<std::vector<flexible_type>> columns(5);
+    for (size_t i = 0; i < n; ++i) {
+      // long runs, evenly spaced values, neither, wrapping deltas and
+      // evenly spaced date times
+      columns[0].push_back(flex_int(i / 100));
+      columns[1].push_back(flex_int(1500000000 + 60 * i));
+      columns[2].push_back(flex_int((i * 7919) % 1000) - 500);
+      columns[3].push_back(i % 2 ? std::numeric_limits<flex_int>::max()
+                                 : std::numeric_limits<flex_int>::min() + flex_int(i));
+      columns[4].push_back(flex_date_time(1500000000 + 60 * i, i < n / 2 ? 20 : -4,
+                                          i < n / 3 ? 0 : 500));
+    }
+    for (auto& column: columns) {
+      for (size_t i = 17; i < n; i += 1009) column[i] = FLEX_UNDEFINED;
+    }
+    std::vector<size_t> max_block_sizes{1000, 2000, 12000, 40000, 3000};
+
+    for (size_t c = 0; c < columns.size(); ++c) {
+      const auto& column = columns[c];
+      block_info info;
+      std::vector<char> buf;
+      oarchive oarc(buf);
+      typed_encode(column, info, oarc);
+      TS_ASSERT_LESS_THAN(info.block_size, max_block_sizes[c]);
+      TS_ASSERT(info.flags & INTEGER_ENCODING_EXTENSION);
+
+      std::vector<flexible_type> decoded;
+      TS_ASSERT(typed_decode(info, buf.data(), info.block_size, decoded));
+      TS_ASSERT(decoded == column);
+      if (column[0].get_type() == flex_type_enum::DATETIME) {
+        for (size_t i = 0; i < n; ++i) {
+          if (column[i].get_type() == flex_type_enum::UNDEFINED) continue;
+          TS_ASSERT_EQUALS(decoded[i].get<flex_date_time>().time_zone_offset(),
+                           column[i].get<flex_date_time>().time_zone_offset());
+        }
+      }
+
+      // read back in batches, skipping every other batch
+      typed_decode_stream stream(info, buf.data(), info.block_size);
+      std::vector<flexible_type> batch(7);
+      for (size_t row = 0; row < n; row += batch.size()) {
+        size_t len = std::min(batch.size(), n - row);
+        if ((row / batch.size()) % 2) {
+          stream.read({nullptr, 0}, len);
+        } else {
+          TS_ASSERT_EQUALS(stream.read({batch.data(), len}, 0), len);
+          for (size_t i = 0; i < len; ++i) TS_ASSERT(batch[i] == column[row + i]);
+        }
+      }
+      if (column[0].get_type() == flex_type_enum::DATETIME) continue;
+
+      std::vector<flex_int> ints(n);
+      TS_ASSERT(typed_decode_as<flex_int>(info, buf.data(), info.block_size, ints.data(), -1));
+      for (size_t i = 0; i < n; ++i) {
+        flex_int expected = column[i].get_type() == flex_type_enum::UNDEFINED
+                            ? -1 : column[i].get<flex_int>();
+        TS_ASSERT_EQUALS(ints[i], expected);
+      }
+      block_predicate pred;
+      pred.op = block_predicate::op_type::LE;
+      pred.value = column[2500];
+      dense_bitset selection;
+      TS_ASSERT(typed_evaluate_predicate(info, buf.data(), info.block_size, pred, selection));
+      for (size_t i = 0; i < n; ++i) TS_ASSERT_EQUALS(selection.get(i), pred(column[i]));
+    }
+  }
+
+  void test_format_version(void) {
+    using namespace v2_block_impl;
+    // only arrays using the extended integer encodings need version 3
+    for (bool integers: {false, true}) {
+      auto value = [&](size_t j) {
+        return integers ? flexible_type(flex_int(j)) : flexible_type(j * 0.5);
+      };
+      sarray_group_format_writer_v2<flexible_type> group_writer;
+      std::string test_file_name = get_temp_name() + ".sidx";
+      group_writer.open(test_file_name, 1, 1);
+      for (size_t j = 0;j < 1000; ++j) group_writer.write_segment(0, 0, value(j));
+      group_writer.close();
+      group_writer.write_index_file();
+
+      auto group_index = read_array_group_index_file(test_file_name);
+      TS_ASSERT_EQUALS(group_index.version,
+                       integers ? SARRAY_INTEGER_ENCODING_VERSION : 2);
+      sarray_format_reader_v2<flexible_type> reader;
+      reader.open(test_file_name + ":0");
+      std::vector<flexible_type> vals;
+      reader.read_rows(0, 1000, vals);
+      TS_ASSERT_EQUALS(vals.size(), 1000);
+      for (size_t j = 0;j < vals.size(); ++j) TS_ASSERT(vals[j] == value(j));
+    }
+
+    // blocks with flags this version does not know are refused
+    std::string test_file_name = get_temp_name() + ".sidx";
+    block_writer writer;
+    writer.init(test_file_name, 1, 1);
+    writer.open_segment(0, test_file_name + ".0000");
+    std::vector<flexible_type> data(100, flexible_type(1.5));
+    std::vector<char> buf;
+    oarchive oarc(buf);
+    block_info info;
+    typed_encode(data, info, oarc);
+    info.flags |= 64;
+    writer.write_block(0, 0, buf.data(), info);
+    writer.close_segment(0);
+    writer.write_index_file();
+    auto read_all = [&]() {
+      sarray_format_reader_v2<flexible_type> reader;
+      reader.open(test_file_name + ":0");
+      std::vector<flexible_type> vals;
+      reader.read_rows(0, 100, vals);
+    };
+    TS_ASSERT_THROWS_ANYTHING(read_all());
+  }
+
+  void test_block_prefetch(void) {
+    // read ahead is only used on segments which are not memory mapped
+    size_t old_mmap = SFRAME_MMAP_LOCAL_SEGMENTS;
+    size_t old_depth = SFRAME_BLOCK_PREFETCH_DEPTH;
+    size_t old_budget = SFRAME_BLOCK_PREFETCH_MEMORY_BUDGET;
+    SFRAME_MMAP_LOCAL_SEGMENTS = 0;
+    SFRAME_BLOCK_PREFETCH_DEPTH = 4;
+
+    sarray_group_format_writer_v2<flexible_type> group_writer;
+    std::string test_file_name = get_temp_name() + ".sidx";
+    group_writer.open(test_file_name, 2, 1);
+    const size_t rows_per_segment = 200000;
+    for (size_t i = 0;i < 2; ++i) {
+      for (size_t j = 0;j < rows_per_segment; ++j) {
+        group_writer.write_segment(0, i, flexible_type(i * rows_per_segment + j));
+      }
+    }
+    group_writer.close();
+    group_writer.write_index_file();
+
+    // a generous budget, a budget smaller than a block, and no budget
+    for (size_t budget: {64 * 1024 * 1024, 1024, 0}) {
+      SFRAME_BLOCK_PREFETCH_MEMORY_BUDGET = budget;
+      // sequential scans, in small and large batches
+      for (size_t batch: {100, 50000}) {
+        sarray_format_reader_v2<flexible_type> reader;
+        reader.open(test_file_name);
+        std::vector<flexible_type> vals;
+        for (size_t row = 0; row < 2 * rows_per_segment; row += batch) {
+          reader.read_rows(row, row + batch, vals);
+          TS_ASSERT_EQUALS(vals.size(), batch);
+          for (size_t i = 0;i < vals.size(); ++i) {
+            if (vals[i] != row + i) TS_ASSERT_EQUALS(vals[i], row + i);
+          }
+        }
+        // backwards scans issue useless read-ahead, but must still be correct
+        for (size_t row = 2 * rows_per_segment; row > 0; row -= batch) {
+          reader.read_rows(row - batch, row, vals);
+          for (size_t i = 0;i < vals.size(); ++i) {
+            if (vals[i] != row - batch + i) TS_ASSERT_EQUALS(vals[i], row - batch + i);
+          }
+        }
+      }
+    }
+    SFRAME_MMAP_LOCAL_SEGMENTS = old_mmap;
+    SFRAME_BLOCK_PREFETCH_DEPTH = old_depth;
+    SFRAME_BLOCK_PREFETCH_MEMORY_BUDGET = old_budget;
+  }
 };
 
 BOOST_FIXTURE_TEST_SUITE(_sarray_file_format_v2_test, sarray_file_format_v2_test)
@@ -587,4 +1047,28 @@ BOOST_AUTO_TEST_CASE(test_typed_random_access) {
 BOOST_AUTO_TEST_CASE(test_missing_values_random_access) {
   sarray_file_format_v2_test::test_missing_values_random_access();
 }
+BOOST_AUTO_TEST_CASE(test_read_rows_as) {
+  sarray_file_format_v2_test::test_read_rows_as();
+}
+BOOST_AUTO_TEST_CASE(test_zone_maps) {
+  sarray_file_format_v2_test::test_zone_maps();
+}
+BOOST_AUTO_TEST_CASE(test_evaluate_predicate) {
+  sarray_file_format_v2_test::test_evaluate_predicate();
+}
+BOOST_AUTO_TEST_CASE(test_string_dictionary_encoding) {
+  sarray_file_format_v2_test::test_string_dictionary_encoding();
+}
+BOOST_AUTO_TEST_CASE(test_string_buffer_reuse) {
+  sarray_file_format_v2_test::test_string_buffer_reuse();
+}
+BOOST_AUTO_TEST_CASE(test_integer_encodings) {
+  sarray_file_format_v2_test::test_integer_encodings();
+}
+BOOST_AUTO_TEST_CASE(test_format_version) {
+  sarray_file_format_v2_test::test_format_version();
+}
+BOOST_AUTO_TEST_CASE(test_block_prefetch) {
+  sarray_file_format_v2_test::test_block_prefetch();
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 #include <core/util/test_macros.hpp>
 #include <core/storage/sframe_data/sarray.hpp>
 #include <core/storage/sframe_data/sarray_v2_encoded_block.hpp>
+#include <core/storage/sframe_data/sarray_v2_type_encoding.hpp>
 #include <core/storage/sframe_data/algorithm.hpp>
 #include <core/storage/fileio/temp_files.hpp>
 
@@ -653,6 +654,62 @@ struct sarray_test {
 
 
 
+  void test_encoded_block_predicate(void) {
+    using v2_block_impl::block_predicate;
+    typedef block_predicate::op_type op_type;
+    // each column with the values it is compared against
+    std::vector<std::vector<flexible_type> > columns(5);
+    std::vector<std::vector<flexible_type> > rhs_values{
+      {0, 100, 37.5, -500},
+      {0, 100, 37.5, -3.5},
+      {"v5", "v50", "", "x"},
+      {"v5", "v500", "", "x"},
+      {flex_list{17}, flex_list{}}};
+    for (size_t i = 0;i < 1000; ++i) {
+      bool missing = (i % 7 == 0);
+      columns[0].push_back(missing ? FLEX_UNDEFINED : flexible_type((flex_int)i - 500));
+      columns[1].push_back(missing ? FLEX_UNDEFINED : flexible_type(i * 0.25));
+      // dictionary encoded
+      columns[2].push_back(missing ? FLEX_UNDEFINED :
+                           flexible_type("v" + std::to_string(i % 13)));
+      // direct encoded
+      columns[3].push_back(missing ? FLEX_UNDEFINED :
+                           flexible_type("v" + std::to_string(i)));
+      // falls back to a full decode
+      columns[4].push_back(missing ? FLEX_UNDEFINED :
+                           flexible_type(flex_list{flexible_type(i)}));
+    }
+    std::vector<op_type> ops{op_type::IS_UNDEFINED, op_type::IS_DEFINED,
+                             op_type::EQ, op_type::NE, op_type::LT,
+                             op_type::LE, op_type::GT, op_type::GE};
+    for (size_t c = 0; c < columns.size(); ++c) {
+      v2_block_impl::block_info info;
+      oarchive oarc;
+      v2_block_impl::typed_encode(columns[c], info, oarc);
+      v2_block_impl::encoded_block eblock(
+          info, std::vector<char>(oarc.buf, oarc.buf + oarc.off));
+      free(oarc.buf);
+      for (auto& rhs: rhs_values[c]) {
+        for (auto op: ops) {
+          // lists only support equality
+          if (rhs.get_type() == flex_type_enum::LIST &&
+              op != op_type::EQ && op != op_type::NE) continue;
+          block_predicate pred;
+          pred.op = op;
+          pred.value = rhs;
+          dense_bitset selection;
+          TS_ASSERT(eblock.evaluate(pred, selection));
+          TS_ASSERT_EQUALS(selection.size(), columns[c].size());
+          for (size_t i = 0;i < columns[c].size(); ++i) {
+            if (selection.get(i) != pred(columns[c][i])) {
+              TS_ASSERT_EQUALS(selection.get(i), pred(columns[c][i]));
+            }
+          }
+        }
+      }
+    }
+  }
+
   void test_sarray_sframe_rows(void) {
     // write the initial sarray
     std::string test_prefix = get_temp_name();
@@ -732,6 +789,9 @@ BOOST_AUTO_TEST_CASE(test_sarray_logical_segments) {
 BOOST_AUTO_TEST_CASE(test_sarray_v2_encoded_block) {
   sarray_test::test_sarray_v2_encoded_block();
 }
+BOOST_AUTO_TEST_CASE(test_encoded_block_predicate) {
+  sarray_test::test_encoded_block_predicate();
+}
 BOOST_AUTO_TEST_CASE(test_sarray_sframe_rows) {
   sarray_test::test_sarray_sframe_rows();
 }
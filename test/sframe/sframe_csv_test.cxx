@@ -7,6 +7,7 @@
 #include <core/storage/sframe_data/sframe.hpp>
 #include <core/storage/sframe_data/algorithm.hpp>
 #include <core/storage/sframe_data/csv_writer.hpp>
+#include <core/storage/sframe_data/testing_utils.hpp>
 #include <core/data/flexible_type/flexible_type.hpp>
 #include <core/data/flexible_type/string_escape.hpp>
 #include <core/storage/sframe_data/parallel_csv_parser.hpp>
@@ -1051,6 +1052,47 @@ struct sframe_test  {
    void test_invalid_csv_cases() {
      evaluate(incorrectly_quoted_1());
    }
+
+   void test_range_split() {
+     // cut even the small test files in as many ranges as there are threads,
+     // so that range boundaries fall in quoted fields and comments
+     size_t min_range_size = SFRAME_CSV_PARSER_MIN_RANGE_SIZE;
+     for (size_t range_size: {1, 3, 7}) {
+       SFRAME_CSV_PARSER_MIN_RANGE_SIZE = range_size;
+       test_csvs();
+       test_quoted_csvs();
+       test_json();
+       test_alternate_line_endings();
+     }
+     SFRAME_CSV_PARSER_MIN_RANGE_SIZE = min_range_size;
+   }
+
+   void test_parallel_write() {
+     // enough rows for several chunks per thread
+     std::vector<std::vector<flexible_type> > rows;
+     for (size_t i = 0; i < 100000; ++i) {
+       rows.push_back({flex_int(i) - 50000, flex_float(i) / 7,
+                       i % 5 ? flexible_type("a,\"" + std::to_string(i)) : FLEX_UNDEFINED,
+                       flex_list{flex_int(i), "b"}});
+     }
+     sframe sf = make_testing_sframe({"a", "b", "c", "d"},
+                                     {flex_type_enum::INTEGER, flex_type_enum::FLOAT,
+                                      flex_type_enum::STRING, flex_type_enum::LIST},
+                                     rows);
+     for (auto quote_level: {csv_writer::csv_quote_level::QUOTE_NONNUMERIC,
+                             csv_writer::csv_quote_level::QUOTE_ALL}) {
+       csv_writer writer;
+       writer.quote_level = quote_level;
+       std::stringstream expected;
+       for (size_t i = 0; i < rows.size(); ++i) {
+         if (i > 0) expected << "> ";
+         writer.write(expected, rows[i]);
+       }
+       std::stringstream parallel;
+       write_csv_rows(parallel, sf, writer, "> ", true);
+       TS_ASSERT(parallel.str() == expected.str());
+     }
+   }
 };
 
 BOOST_FIXTURE_TEST_SUITE(_sframe_test, sframe_test)
@@ -1075,4 +1117,10 @@ BOOST_AUTO_TEST_CASE(test_alternate_line_endings) {
 BOOST_AUTO_TEST_CASE(test_invalid_csv_cases) {
   sframe_test::test_invalid_csv_cases();
 }
+BOOST_AUTO_TEST_CASE(test_range_split) {
+  sframe_test::test_range_split();
+}
+BOOST_AUTO_TEST_CASE(test_parallel_write) {
+  sframe_test::test_parallel_write();
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,112 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <core/random/random.hpp>
+#include <core/storage/sframe_data/sframe.hpp>
+#include <core/storage/sframe_data/sframe_index_mapping.hpp>
+
+using namespace turi;
+
+struct sframe_index_mapping_test {
+  /**
+   * Create an sframe with columns "id" and "name" over 4 segments. Row i has
+   * id i and name "row_i".
+   */
+  sframe create_input_sframe(size_t num_rows) {
+    sframe sf;
+    sf.open_for_write({"id", "name"}, {flex_type_enum::INTEGER, flex_type_enum::STRING}, "", 4);
+    for (size_t segment = 0; segment < 4; ++segment) {
+      auto out = sf.get_output_iterator(segment);
+      for (size_t i = segment * num_rows / 4; i < (segment + 1) * num_rows / 4; ++i) {
+        *out = std::vector<flexible_type>{i, "row_" + std::to_string(i)};
+        ++out;
+      }
+    }
+    sf.close();
+    return sf;
+  }
+
+ public:
+  void test_get_rows() {
+    size_t num_rows = 200000;
+    sframe sf = create_input_sframe(num_rows);
+    sframe_index_mapping index(sf);
+    TS_ASSERT_EQUALS(index.num_rows(), num_rows);
+    TS_ASSERT_EQUALS(index.num_columns(), 2);
+
+    // random rows, repeated, and the first and last ones
+    random::seed(1);
+    std::vector<size_t> rows;
+    for (size_t i = 0; i < 10000; ++i) {
+      rows.push_back(random::fast_uniform<size_t>(0, num_rows - 1));
+    }
+    rows.push_back(0);
+    rows.push_back(num_rows - 1);
+    rows.push_back(rows[0]);
+
+    std::vector<std::vector<flexible_type>> out;
+    index.get_rows(rows, out);
+    TS_ASSERT_EQUALS(out.size(), rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+      TS_ASSERT_EQUALS(out[i][0], flexible_type(rows[i]));
+      TS_ASSERT_EQUALS(out[i][1], flexible_type("row_" + std::to_string(rows[i])));
+    }
+
+    auto row = index.get_row(12345);
+    TS_ASSERT_EQUALS(row[0], 12345);
+
+    index.get_rows({}, out);
+    TS_ASSERT_EQUALS(out.size(), 0);
+    TS_ASSERT_THROWS_ANYTHING(index.get_rows({num_rows}, out));
+  }
+
+  void test_locate() {
+    size_t num_rows = 200000;
+    sframe sf = create_input_sframe(num_rows);
+    sframe_index_mapping index(sf);
+    // offsets grow by one within a block, and restart at 0 on a new block
+    auto prev = index.locate(0, 0);
+    TS_ASSERT_EQUALS(prev.segment, 0);
+    TS_ASSERT_EQUALS(prev.block, 0);
+    TS_ASSERT_EQUALS(prev.offset, 0);
+    for (size_t i = 1; i < num_rows; ++i) {
+      auto loc = index.locate(0, i);
+      if (loc.segment == prev.segment && loc.block == prev.block) {
+        TS_ASSERT_EQUALS(loc.offset, prev.offset + 1);
+      } else {
+        TS_ASSERT_EQUALS(loc.offset, 0);
+      }
+      prev = loc;
+    }
+    TS_ASSERT_EQUALS(index.locate(0, num_rows - 1).segment, 3);
+    TS_ASSERT_EQUALS(index.locate(1, num_rows / 4).segment, 1);
+    TS_ASSERT_THROWS_ANYTHING(index.locate(2, 0));
+    TS_ASSERT_THROWS_ANYTHING(index.locate(0, num_rows));
+  }
+
+  void test_block_cache() {
+    sframe sf = create_input_sframe(1000);
+    sframe_index_mapping index(sf, 16);
+    std::vector<std::vector<flexible_type>> out;
+    // every block needed is decoded once per call
+    index.get_rows({1, 2, 3, 500, 999}, out);
+    size_t misses = index.cache_misses();
+    TS_ASSERT(misses > 0);
+    TS_ASSERT(misses <= 8);
+    index.get_rows({1, 2, 3, 500, 999}, out);
+    TS_ASSERT_EQUALS(index.cache_misses(), misses);
+    TS_ASSERT_EQUALS(out[3][1], "row_500");
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_sframe_index_mapping_test, sframe_index_mapping_test)
+BOOST_AUTO_TEST_CASE(test_get_rows) {
+  sframe_index_mapping_test::test_get_rows();
+}
+BOOST_AUTO_TEST_CASE(test_locate) {
+  sframe_index_mapping_test::test_locate();
+}
+BOOST_AUTO_TEST_CASE(test_block_cache) {
+  sframe_index_mapping_test::test_block_cache();
+}
+BOOST_AUTO_TEST_SUITE_END()
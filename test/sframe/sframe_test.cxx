@@ -3,7 +3,10 @@
 #include <core/util/test_macros.hpp>
 #include <iostream>
 #include <typeinfo>
+#include <set>
 #include <boost/filesystem.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <core/storage/fileio/fs_utils.hpp>
 #include <core/storage/sframe_data/sframe.hpp>
 #include <core/storage/sframe_data/algorithm.hpp>
 #include <core/data/flexible_type/flexible_type.hpp>
@@ -14,6 +17,12 @@
 #include <core/storage/sframe_data/groupby_aggregate.hpp>
 #include <core/storage/sframe_data/groupby_aggregate_operators.hpp>
 #include <core/storage/sframe_data/sframe_saving.hpp>
+#include <core/storage/sframe_data/sframe_compact.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
+#include <core/storage/sframe_data/testing_utils.hpp>
+#include <core/storage/sframe_data/join.hpp>
+#include <core/storage/query_engine/algorithm/groupby_aggregate.hpp>
+#include <core/storage/query_engine/operators/sframe_source.hpp>
 
 BOOST_TEST_DONT_PRINT_LOG_VALUE(std::vector<double>)
 BOOST_TEST_DONT_PRINT_LOG_VALUE(std::vector<std::string>)
@@ -295,6 +304,107 @@ struct sframe_test  {
     }
 
 
+    void test_sframe_save_compression_level() {
+      auto tmp_ptr = new sarray<flexible_type>(test_writer_prefix);
+      std::shared_ptr<sarray<flexible_type> > sa_ptr(tmp_ptr);
+      std::vector<std::shared_ptr<sarray<flexible_type> > > v{sa_ptr, sa_ptr};
+      sframe sf(v);
+
+      std::vector<std::vector<flexible_type> > frame;
+      turi::copy(sf, std::inserter(frame, frame.end()));
+
+      // every level must produce blocks the regular reader can decode
+      for (int64_t level: {0, 4, 16}) {
+        std::string index_file = get_temp_name() + ".frame_idx";
+        sf.save(index_file, level);
+
+        sframe sf2(index_file);
+        TS_ASSERT_EQUALS(sf2.num_rows(), sf.num_rows());
+        TS_ASSERT_EQUALS(sf2.num_columns(), sf.num_columns());
+        std::vector<std::vector<flexible_type> > new_frame;
+        turi::copy(sf2, std::inserter(new_frame, new_frame.end()));
+        TS_ASSERT_EQUALS(new_frame.size(), frame.size());
+        for (size_t i = 0;i < frame.size(); ++i) {
+          TS_ASSERT_EQUALS(new_frame[i].size(), frame[i].size());
+          for (size_t j = 0; j < frame[i].size(); ++j) {
+            TS_ASSERT_EQUALS(new_frame[i][j], frame[i][j]);
+          }
+        }
+      }
+
+      std::string index_file = get_temp_name() + ".frame_idx";
+      TS_ASSERT_THROWS_ANYTHING(sf.save(index_file, 17));
+    }
+
+    void test_sframe_save_column_groups() {
+      // a frame wide enough to be split into several column groups, each
+      // written by its own thread to its own files
+      const size_t num_columns = 10, num_rows = 5000, num_segments = 3;
+      std::vector<std::string> names;
+      std::vector<flex_type_enum> types;
+      for (size_t j = 0;j < num_columns; ++j) {
+        names.push_back("c" + std::to_string(j));
+        types.push_back(j % 3 == 0 ? flex_type_enum::INTEGER :
+                        j % 3 == 1 ? flex_type_enum::STRING :
+                                     flex_type_enum::FLOAT);
+      }
+      auto value = [](size_t i, size_t j) -> flexible_type {
+        if (j % 3 == 0) return flex_int(i * num_columns + j);
+        if (j % 3 == 1) return std::to_string(i) + "-" + std::to_string(j);
+        return double(i) + 0.25 * j;
+      };
+
+      sframe sf;
+      sf.open_for_write(names, types, "", num_segments);
+      for (size_t seg = 0;seg < num_segments; ++seg) {
+        auto iter = sf.get_output_iterator(seg);
+        for (size_t i = seg * num_rows / num_segments;
+             i < (seg + 1) * num_rows / num_segments; ++i) {
+          std::vector<flexible_type> row;
+          for (size_t j = 0;j < num_columns; ++j) row.push_back(value(i, j));
+          *iter = row;
+          ++iter;
+        }
+      }
+      sf.close();
+
+      // the number of groups follows cpu_count()
+      const char* old_nthreads = getenv("OMP_NUM_THREADS");
+      std::string saved_nthreads = old_nthreads ? old_nthreads : "";
+      setenv("OMP_NUM_THREADS", "4", 1);
+      std::string base_name = get_temp_name();
+      std::string index_file = base_name + ".frame_idx";
+      sf.save(index_file);
+      if (old_nthreads) {
+        setenv("OMP_NUM_THREADS", saved_nthreads.c_str(), 1);
+      } else {
+        unsetenv("OMP_NUM_THREADS");
+      }
+
+      for (size_t group = 0;group < 4; ++group) {
+        std::string group_base = base_name + "-" + std::to_string(group);
+        TS_ASSERT(boost::filesystem::exists(group_base + ".sidx"));
+        TS_ASSERT(boost::filesystem::exists(group_base + ".0000"));
+      }
+
+      sframe sf2(index_file);
+      TS_ASSERT_EQUALS(sf2.num_rows(), num_rows);
+      TS_ASSERT_EQUALS(sf2.num_columns(), num_columns);
+      for (size_t j = 0;j < num_columns; ++j) {
+        TS_ASSERT_EQUALS(sf2.column_name(j), names[j]);
+        TS_ASSERT_EQUALS(sf2.column_type(j), types[j]);
+      }
+      std::vector<std::vector<flexible_type> > frame;
+      turi::copy(sf2, std::inserter(frame, frame.end()));
+      TS_ASSERT_EQUALS(frame.size(), num_rows);
+      for (size_t i = 0;i < frame.size(); ++i) {
+        TS_ASSERT_EQUALS(frame[i].size(), num_columns);
+        for (size_t j = 0; j < frame[i].size(); ++j) {
+          if (frame[i][j] != value(i, j)) TS_ASSERT_EQUALS(frame[i][j], value(i, j));
+        }
+      }
+    }
+
     void test_sframe_save_reference_no_copy() {
       // Create an sarray from on-disk representation
       auto tmp_ptr = new sarray<flexible_type>(test_writer_prefix);
@@ -439,6 +549,141 @@ struct sframe_test  {
       TS_ASSERT_EQUALS(newsf.size(), 0);
     }
 
+    void test_sframe_append_in_place() {
+      auto make_rows = [](size_t begin, size_t end) {
+        std::vector<std::vector<flexible_type> > rows;
+        for (size_t i = begin; i < end; ++i) {
+          rows.push_back({flex_int(i), "s" + std::to_string(i)});
+        }
+        return rows;
+      };
+      std::string index = get_temp_name() + ".frame_idx";
+      make_testing_sframe({"a", "b"}, {flex_type_enum::INTEGER, flex_type_enum::STRING},
+                          make_rows(0, 1000)).save(index);
+      sframe before(index);
+
+      // the columns of the appended rows may come in any order
+      sframe_append_in_place(index, make_testing_sframe(
+          {"a", "b"}, {flex_type_enum::INTEGER, flex_type_enum::STRING},
+          make_rows(1000, 1500)));
+      auto swapped = make_rows(1500, 1600);
+      for (auto& row: swapped) std::swap(row[0], row[1]);
+      sframe_append_in_place(index, make_testing_sframe(
+          {"b", "a"}, {flex_type_enum::STRING, flex_type_enum::INTEGER}, swapped));
+
+      sframe after(index);
+      TS_ASSERT(after.column_names() == std::vector<std::string>({"a", "b"}));
+      TS_ASSERT(testing_extract_sframe_data(after) == make_rows(0, 1600));
+      // a reader of the previous version is unaffected
+      TS_ASSERT(testing_extract_sframe_data(before) == make_rows(0, 1000));
+
+      TS_ASSERT_THROWS_ANYTHING(sframe_append_in_place(index, make_testing_sframe(
+          {"a", "b"}, {flex_type_enum::STRING, flex_type_enum::STRING}, {{"x", "y"}})));
+      TS_ASSERT_THROWS_ANYTHING(sframe_append_in_place(index, make_testing_sframe(
+          {"a"}, {flex_type_enum::INTEGER}, {{1}})));
+      TS_ASSERT_EQUALS(sframe(index).num_rows(), 1600);
+    }
+
+    void test_sframe_lazy_columns() {
+      std::vector<std::vector<flexible_type> > rows;
+      for (size_t i = 0; i < 1000; ++i) {
+        rows.push_back({flex_int(i), "s" + std::to_string(i), double(i) / 2});
+      }
+      std::string index = get_temp_name() + ".frame_idx";
+      make_testing_sframe({"a", "b", "c"},
+                          {flex_type_enum::INTEGER, flex_type_enum::STRING,
+                           flex_type_enum::FLOAT}, rows).save(index);
+
+      sframe sf(index);
+      TS_ASSERT(sf.column_types() == std::vector<flex_type_enum>(
+          {flex_type_enum::INTEGER, flex_type_enum::STRING, flex_type_enum::FLOAT}));
+      // a copy shares the columns opened on first use
+      sframe copy = sf;
+      TS_ASSERT_EQUALS(sf.select_column("c").get(), copy.select_column("c").get());
+
+      sframe narrow = sf.select_columns({"c", "a"});
+      std::vector<std::vector<flexible_type> > expected;
+      for (const auto& row: rows) expected.push_back({row[2], row[0]});
+      TS_ASSERT(testing_extract_sframe_data(narrow) == expected);
+      TS_ASSERT(testing_extract_sframe_data(copy) == rows);
+    }
+
+    void test_sframe_read_rows_reuse() {
+      std::vector<std::vector<flexible_type> > data;
+      for (size_t i = 0; i < 100; ++i) data.push_back({flex_int(i), flex_float(i)});
+      sframe sf = make_testing_sframe({"a", "b"},
+                                      {flex_type_enum::INTEGER, flex_type_enum::FLOAT},
+                                      data);
+      auto reader = sf.get_reader();
+      sframe_rows rows;
+      reader->read_rows(0, 50, rows);
+      auto first_column = rows.cget_columns()[0].get();
+
+      // columns owned alone are overwritten in place
+      reader->read_rows(50, 60, rows);
+      TS_ASSERT_EQUALS(rows.cget_columns()[0].get(), first_column);
+      TS_ASSERT(rows[3][0] == flexible_type(53));
+
+      // columns still shared are left to the other owner, not copied
+      sframe_rows kept = rows;
+      reader->read_rows(60, 70, rows);
+      TS_ASSERT(rows.cget_columns()[0].get() != first_column);
+      TS_ASSERT(kept[0][0] == flexible_type(50));
+      TS_ASSERT(rows[0][0] == flexible_type(60));
+
+      // released columns are recycled by the next read
+      std::set<const void*> released{rows.cget_columns()[0].get(),
+                                     rows.cget_columns()[1].get()};
+      reader->release_rows(rows);
+      TS_ASSERT_EQUALS(rows.num_columns(), 0);
+      reader->read_rows(70, 100, rows);
+      TS_ASSERT_EQUALS(released.count(rows.cget_columns()[0].get()), 1);
+      TS_ASSERT_EQUALS(released.count(rows.cget_columns()[1].get()), 1);
+      TS_ASSERT_EQUALS(rows.num_rows(), 30);
+      TS_ASSERT(rows[29][1] == flexible_type(99.0));
+    }
+
+    void test_sframe_background_compaction() {
+      auto make_rows = [](size_t begin, size_t end) {
+        std::vector<std::vector<flexible_type> > rows;
+        for (size_t i = begin; i < end; ++i) {
+          rows.push_back({flex_int(i), "s" + std::to_string(i)});
+        }
+        return rows;
+      };
+      std::string index = get_temp_name() + ".frame_idx";
+      make_testing_sframe({"a", "b"}, {flex_type_enum::INTEGER, flex_type_enum::STRING},
+                          make_rows(0, 100)).save(index);
+      for (size_t i = 1; i < 20; ++i) {
+        sframe_append_in_place(index, make_testing_sframe(
+            {"a", "b"}, {flex_type_enum::INTEGER, flex_type_enum::STRING},
+            make_rows(i * 100, (i + 1) * 100)));
+      }
+      sframe fragmented(index);
+      TS_ASSERT_EQUALS(fragmented.select_column(0)->get_index_info().segment_files.size(), 20);
+
+      auto& service = sframe_compaction_service::get_instance();
+      // in memory: the compacted copy leaves the source untouched
+      auto compacted = service.compact(fragmented, 4);
+      TS_ASSERT(testing_extract_sframe_data(compacted.get()) == make_rows(0, 2000));
+      for (size_t i = 0; i < 2; ++i) {
+        TS_ASSERT(compacted.get().select_column(i)->get_index_info().segment_files.size() <= 4);
+      }
+      TS_ASSERT_EQUALS(fragmented.select_column(0)->get_index_info().segment_files.size(), 20);
+
+      // saved: a new version replaces the frame index
+      TS_ASSERT(service.compact_saved(index, 4).get());
+      service.wait();
+      TS_ASSERT_EQUALS(service.num_pending(), 0);
+      sframe after(index);
+      TS_ASSERT(testing_extract_sframe_data(after) == make_rows(0, 2000));
+      TS_ASSERT(after.select_column(0)->get_index_info().segment_files.size() <= 4);
+      TS_ASSERT(testing_extract_sframe_data(fragmented) == make_rows(0, 2000));
+      TS_ASSERT(!sframe_compact_saved(index, 4));
+
+      TS_ASSERT_THROWS_ANYTHING(service.compact_saved(get_temp_name() + ".frame_idx").get());
+    }
+
     void test_sframe_dataframe_conversion() {
       std::vector<flexible_type> int_col{0,1,2,3,4,5};
       std::vector<flexible_type> float_col{.0,.1,.2,.3,.4,.5};
@@ -1530,6 +1775,192 @@ struct sframe_test  {
   
    }
 
+   void test_sframe_groupby_aggregate_local_table_sizes() {
+     size_t original_local_table_size = SFRAME_GROUPBY_LOCAL_TABLE_SIZE;
+     // a tiny local table, moving groups out all the time
+     SFRAME_GROUPBY_LOCAL_TABLE_SIZE = 4;
+     run_groupby_aggregate_sum_test(1000, 100000, 1000);
+     run_multikey_groupby_aggregate_average_test(1000, 100000, 10);
+     // without radix partitioning
+     SFRAME_GROUPBY_LOCAL_TABLE_SIZE = 0;
+     run_groupby_aggregate_sum_test(1000, 100000, 10);
+     run_multikey_groupby_aggregate_average_test(100, 100000, 1000);
+     SFRAME_GROUPBY_LOCAL_TABLE_SIZE = original_local_table_size;
+   }
+
+   void test_sframe_sorted_groupby_aggregate() {
+     // rows sorted on the key, with groups spanning segment boundaries
+     // (including one spanning several segments) and undefined keys
+     const size_t NUM_ROWS = 100000;
+     sframe input;
+     input.open_for_write({"key", "value"},
+                          {flex_type_enum::INTEGER, flex_type_enum::INTEGER},
+                          "", 1);
+     auto iter = input.get_output_iterator(0);
+     for (size_t i = 0;i < NUM_ROWS; ++i) {
+       flexible_type key = i < 40000 ? flexible_type(FLEX_UNDEFINED)
+                                     : flexible_type(i < 70000 ? 0 : (i - 70000) / 997 + 1);
+       *iter = std::vector<flexible_type>{key, flex_int(i)};
+       ++iter;
+     }
+     input.close();
+
+     auto source = query_eval::op_sframe_source::make_planner_node(input);
+     std::vector<std::pair<std::vector<std::string>,
+                           std::shared_ptr<group_aggregate_value>>> groups{
+       {{"value"}, std::make_shared<groupby_operators::sum>()},
+       {{}, std::make_shared<groupby_operators::count>()},
+       {{"value"}, std::make_shared<groupby_operators::average>()}};
+     auto sorted = query_eval::groupby_aggregate(source, {"key", "value"}, {"key"},
+                                                 {"sum", "count", "avg"}, groups, true);
+     auto hashed = query_eval::groupby_aggregate(source, {"key", "value"}, {"key"},
+                                                 {"sum", "count", "avg"}, groups, false);
+     std::vector<std::vector<flexible_type>> sorted_rows, hashed_rows;
+     sorted->get_reader()->read_rows(0, sorted->num_rows(), sorted_rows);
+     hashed->get_reader()->read_rows(0, hashed->num_rows(), hashed_rows);
+     TS_ASSERT_EQUALS(sorted_rows.size(), 2 + (NUM_ROWS - 70000 + 996) / 997);
+     TS_ASSERT_EQUALS(sorted_rows.size(), hashed_rows.size());
+
+     // the sorted aggregation keeps the order of the input
+     TS_ASSERT_EQUALS((int)sorted_rows[0][0].get_type(), (int)flex_type_enum::UNDEFINED);
+     TS_ASSERT_EQUALS(sorted_rows[0][2], 40000);
+     for (size_t i = 1;i < sorted_rows.size(); ++i) {
+       TS_ASSERT_EQUALS(sorted_rows[i][0], flex_int(i - 1));
+     }
+     std::sort(hashed_rows.begin(), hashed_rows.end(),
+               [](const std::vector<flexible_type>& a, const std::vector<flexible_type>& b) {
+                 return a[3] < b[3];
+               });
+     std::sort(sorted_rows.begin(), sorted_rows.end(),
+               [](const std::vector<flexible_type>& a, const std::vector<flexible_type>& b) {
+                 return a[3] < b[3];
+               });
+     for (size_t i = 0;i < sorted_rows.size(); ++i) {
+       for (size_t j = 1;j < 4; ++j) {
+         TS_ASSERT_EQUALS(sorted_rows[i][j], hashed_rows[i][j]);
+       }
+     }
+   }
+
+   void run_join_test(const std::string& join_type,
+                      size_t max_buffer_size,
+                      size_t expected_rows) {
+     // left: key i, value 10 * i for i in [0, 1000)
+     // right: key i % 1500, value -i for i in [0, 3000)
+     sframe left, right;
+     left.open_for_write({"key", "lvalue"},
+                         {flex_type_enum::INTEGER, flex_type_enum::INTEGER}, "", 2);
+     right.open_for_write({"key", "rvalue"},
+                          {flex_type_enum::INTEGER, flex_type_enum::INTEGER}, "", 4);
+     {
+       auto it = left.get_output_iterator(0);
+       for (size_t i = 0; i < 1000; ++i) {
+         *it = std::vector<flexible_type>{i, 10 * i};
+         ++it;
+       }
+       auto rit = right.get_output_iterator(0);
+       for (size_t i = 0; i < 3000; ++i) {
+         *rit = std::vector<flexible_type>{i % 1500, -(flex_int)i};
+         ++rit;
+       }
+     }
+     left.close();
+     right.close();
+
+     sframe result = turi::join(left, right, join_type, {{"key", "key"}}, {},
+                                max_buffer_size);
+     TS_ASSERT_EQUALS(result.num_rows(), expected_rows);
+     TS_ASSERT_EQUALS(result.column_names(),
+                      std::vector<std::string>({"key", "lvalue", "rvalue"}));
+
+     std::vector<std::vector<flexible_type>> rows;
+     result.get_reader()->read_rows(0, result.num_rows(), rows);
+     for (const auto& row : rows) {
+       flex_int key = row[0];
+       if (key < 1000) {
+         TS_ASSERT_EQUALS(row[1], 10 * key);
+       } else {
+         TS_ASSERT_EQUALS(row[1].get_type(), flex_type_enum::UNDEFINED);
+       }
+       TS_ASSERT(row[2] == -key || row[2] == -(key + 1500));
+     }
+   }
+
+   void test_sframe_join() {
+     size_t original_bits_per_key = SFRAME_JOIN_BLOOM_FILTER_BITS_PER_KEY;
+     // with and without the bloom filter on the partitioned right side
+     for (size_t bits_per_key : {(size_t)10, (size_t)0}) {
+       SFRAME_JOIN_BLOOM_FILTER_BITS_PER_KEY = bits_per_key;
+       for (size_t max_buffer_size : {(size_t)SFRAME_JOIN_BUFFER_NUM_CELLS, (size_t)100}) {
+         // the smaller side fits in memory the first time, and is
+         // partitioned the second
+         run_join_test("inner", max_buffer_size, 2000);
+         run_join_test("left", max_buffer_size, 2000);
+         run_join_test("right", max_buffer_size, 3000);
+         run_join_test("outer", max_buffer_size, 3000);
+       }
+     }
+     SFRAME_JOIN_BLOOM_FILTER_BITS_PER_KEY = original_bits_per_key;
+   }
+
+   void test_sframe_skewed_join() {
+     // left: key i, value 10 * i for i in [0, 1000)
+     // right: 1500 rows of key 7, 500 of key 2000 (not in left), then key
+     // i % 1000, value -i for i in [2000, 3000)
+     sframe left, right;
+     left.open_for_write({"key", "lvalue"},
+                         {flex_type_enum::INTEGER, flex_type_enum::INTEGER}, "", 2);
+     right.open_for_write({"key", "rvalue"},
+                          {flex_type_enum::INTEGER, flex_type_enum::INTEGER}, "", 4);
+     auto right_key = [](flex_int i) -> flex_int {
+       return i < 1500 ? 7 : (i < 2000 ? 2000 : i % 1000);
+     };
+     {
+       auto it = left.get_output_iterator(0);
+       for (size_t i = 0; i < 1000; ++i) {
+         *it = std::vector<flexible_type>{i, 10 * i};
+         ++it;
+       }
+       auto rit = right.get_output_iterator(0);
+       for (size_t i = 0; i < 3000; ++i) {
+         *rit = std::vector<flexible_type>{right_key(i), -(flex_int)i};
+         ++rit;
+       }
+     }
+     left.close();
+     right.close();
+
+     double original_fraction = SFRAME_JOIN_HEAVY_KEY_FRACTION;
+     // with and without the heavy keys joined apart; the small buffer makes
+     // the join partitioned
+     for (double fraction : {0.01, 0.0}) {
+       SFRAME_JOIN_HEAVY_KEY_FRACTION = fraction;
+       for (auto join_type : {"inner", "left", "right", "outer"}) {
+         sframe result = turi::join(left, right, join_type, {{"key", "key"}}, {}, 100);
+         bool keeps_right = std::string(join_type) == "right" ||
+                            std::string(join_type) == "outer";
+         TS_ASSERT_EQUALS(result.num_rows(), keeps_right ? 3000 : 2500);
+
+         std::vector<std::vector<flexible_type>> rows;
+         result.get_reader()->read_rows(0, result.num_rows(), rows);
+         std::set<flex_int> rvalues;
+         for (const auto& row : rows) {
+           flex_int key = row[0];
+           if (key < 1000) {
+             TS_ASSERT_EQUALS(row[1], 10 * key);
+           } else {
+             TS_ASSERT_EQUALS(row[1].get_type(), flex_type_enum::UNDEFINED);
+           }
+           flex_int i = -row[2].get<flex_int>();
+           TS_ASSERT_EQUALS(right_key(i), key);
+           rvalues.insert(i);
+         }
+         TS_ASSERT_EQUALS(rvalues.size(), rows.size());
+       }
+     }
+     SFRAME_JOIN_HEAVY_KEY_FRACTION = original_fraction;
+   }
+
    void test_sframe_groupby_aggregate_negative_tests() {
      sframe input;
      input.open_for_write({"str","int","float"},
@@ -1756,6 +2187,55 @@ struct sframe_test  {
        ++i;
      }
    }
+   void test_sframe_archive_components() {
+     // sframes and sarrays are written in parallel when the archive closes,
+     // and listed in its manifest
+     std::vector<sframe> frames;
+     for (size_t i = 0; i < 4; ++i) {
+       frames.push_back(make_random_sframe(1000 + i, "nsz", false, i));
+     }
+     sarray<flexible_type> sa = *frames[0].select_column(0);
+     std::string dirpath = "sframe_component_test_dir";
+     {
+       turi::dir_archive dir;
+       dir.open_directory_for_write(dirpath);
+       turi::oarchive oarc(dir);
+       for (const auto& frame : frames) {
+         oarc << frame << size_t(7);
+       }
+       oarc << sa;
+       dir.close();
+     }
+
+     {
+       turi::dir_archive dir;
+       dir.open_directory_for_read(dirpath);
+       turi::iarchive iarc(dir);
+       for (const auto& frame : frames) {
+         sframe loaded;
+         size_t marker = 0;
+         iarc >> loaded >> marker;
+         TS_ASSERT_EQUALS(marker, 7);
+         TS_ASSERT(testing_extract_sframe_data(loaded) ==
+                   testing_extract_sframe_data(frame));
+       }
+       sarray<flexible_type> loaded_sa;
+       iarc >> loaded_sa;
+       TS_ASSERT_EQUALS(loaded_sa.size(), sa.size());
+     }
+
+     // an archive missing a component cannot be opened
+     for (const auto& entry : fileio::get_directory_listing(dirpath)) {
+       if (boost::ends_with(entry.first, ".frame_idx")) {
+         fileio::delete_path(entry.first);
+         break;
+       }
+     }
+     turi::dir_archive dir;
+     TS_ASSERT_THROWS_ANYTHING(dir.open_directory_for_read(dirpath));
+     turi::dir_archive::delete_archive(dirpath);
+   }
+
    void test_sframe_ndarray() {
      flex_nd_vec fortran({0,5,1,6,2,7,3,8,4,9},
                           {2,5},
@@ -1816,6 +2296,12 @@ BOOST_AUTO_TEST_CASE(test_empty_sframe) {
 BOOST_AUTO_TEST_CASE(test_sframe_save) {
   sframe_test::test_sframe_save();
 }
+BOOST_AUTO_TEST_CASE(test_sframe_save_compression_level) {
+  sframe_test::test_sframe_save_compression_level();
+}
+BOOST_AUTO_TEST_CASE(test_sframe_save_column_groups) {
+  sframe_test::test_sframe_save_column_groups();
+}
 BOOST_AUTO_TEST_CASE(test_sframe_save_reference_no_copy) {
   sframe_test::test_sframe_save_reference_no_copy();
 }
@@ -1828,6 +2314,18 @@ BOOST_AUTO_TEST_CASE(test_sframe_save_empty_columns) {
 BOOST_AUTO_TEST_CASE(test_sframe_save_really_empty) {
   sframe_test::test_sframe_save_really_empty();
 }
+BOOST_AUTO_TEST_CASE(test_sframe_append_in_place) {
+  sframe_test::test_sframe_append_in_place();
+}
+BOOST_AUTO_TEST_CASE(test_sframe_lazy_columns) {
+  sframe_test::test_sframe_lazy_columns();
+}
+BOOST_AUTO_TEST_CASE(test_sframe_read_rows_reuse) {
+  sframe_test::test_sframe_read_rows_reuse();
+}
+BOOST_AUTO_TEST_CASE(test_sframe_background_compaction) {
+  sframe_test::test_sframe_background_compaction();
+}
 BOOST_AUTO_TEST_CASE(test_sframe_dataframe_conversion) {
   sframe_test::test_sframe_dataframe_conversion();
 }
@@ -1858,6 +2356,18 @@ BOOST_AUTO_TEST_CASE(test_sframe_groupby_aggregate) {
 BOOST_AUTO_TEST_CASE(test_sframe_multikey_groupby_aggregate) {
   sframe_test::test_sframe_multikey_groupby_aggregate();
 }
+BOOST_AUTO_TEST_CASE(test_sframe_groupby_aggregate_local_table_sizes) {
+  sframe_test::test_sframe_groupby_aggregate_local_table_sizes();
+}
+BOOST_AUTO_TEST_CASE(test_sframe_sorted_groupby_aggregate) {
+  sframe_test::test_sframe_sorted_groupby_aggregate();
+}
+BOOST_AUTO_TEST_CASE(test_sframe_join) {
+  sframe_test::test_sframe_join();
+}
+BOOST_AUTO_TEST_CASE(test_sframe_skewed_join) {
+  sframe_test::test_sframe_skewed_join();
+}
 BOOST_AUTO_TEST_CASE(test_sframe_groupby_aggregate_negative_tests) {
   sframe_test::test_sframe_groupby_aggregate_negative_tests();
 }
@@ -1870,6 +2380,9 @@ BOOST_AUTO_TEST_CASE(test_sframe_append) {
 BOOST_AUTO_TEST_CASE(test_sframe_rows) {
   sframe_test::test_sframe_rows();
 }
+BOOST_AUTO_TEST_CASE(test_sframe_archive_components) {
+  sframe_test::test_sframe_archive_components();
+}
 BOOST_AUTO_TEST_CASE(test_sframe_ndarray) {
   sframe_test::test_sframe_ndarray();
 }
@@ -123,6 +123,44 @@ struct shuffle_test {
       }
     }
 
+    /**
+     * Test that random_shuffle permutes the rows, through several buckets
+     * when the memory budget is small.
+     */
+    void test_random_shuffle() {
+      size_t num_rows = 5000;
+      sframe sframe_in = create_input_sframe(num_rows);
+      std::vector<std::vector<flexible_type>> first_rows;
+      for (size_t memory_budget : {0, 16 * 1024}) {
+        sframe sframe_out = random_shuffle(sframe_in, 1234, memory_budget);
+        TS_ASSERT_EQUALS(sframe_out.num_rows(), num_rows);
+        TS_ASSERT_EQUALS(sframe_out.column_names(), sframe_in.column_names());
+
+        std::vector<std::vector<flexible_type>> rows;
+        sframe_out.get_reader()->read_rows(0, num_rows, rows);
+        std::set<flexible_type> ids;
+        size_t num_in_place = 0;
+        for (size_t i = 0; i < rows.size(); ++i) {
+          TS_ASSERT_EQUALS(rows[i].size(), 2);
+          TS_ASSERT_EQUALS(rows[i][0], rows[i][1]);
+          ids.insert(rows[i][0]);
+          if (rows[i][0] == i) ++num_in_place;
+        }
+        TS_ASSERT_EQUALS(ids.size(), num_rows);
+        TS_ASSERT_LESS_THAN(num_in_place, num_rows / 10);
+
+        // the same seed gives the same order, whatever the number of buckets
+        if (first_rows.empty()) {
+          first_rows = rows;
+        } else {
+          TS_ASSERT(rows == first_rows);
+        }
+      }
+
+      sframe empty = random_shuffle(create_input_sframe(0), 1);
+      TS_ASSERT_EQUALS(empty.num_rows(), 0);
+    }
+
     /**
      *
      * Helper function to test we can shuffle an sframe
@@ -173,4 +211,7 @@ BOOST_AUTO_TEST_CASE(test_bench) {
 BOOST_AUTO_TEST_CASE(test_edge) {
   shuffle_test::test_edge();
 }
+BOOST_AUTO_TEST_CASE(test_random_shuffle) {
+  shuffle_test::test_random_shuffle();
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -6,6 +6,8 @@
 #include <core/storage/query_engine/operators/all_operators.hpp>
 #include <core/storage/query_engine/util/aggregates.hpp>
 #include <core/storage/sframe_data/sarray.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
+#include <core/parallel/pthread_tools.hpp>
 
 using namespace turi;
 using namespace turi::query_eval;
@@ -269,6 +271,139 @@ struct basic_end_to_end {
       }
     }
   }
+  void test_morsel_scheduling() {
+    // small morsels so that every segment is split into several morsels
+    size_t old_min_rows = SFRAME_MORSEL_MIN_ROWS;
+    size_t old_morsels = SFRAME_MORSELS_PER_SEGMENT;
+    SFRAME_MORSEL_MIN_ROWS = 1000;
+    SFRAME_MORSELS_PER_SEGMENT = 8;
+
+    const size_t TEST_LENGTH = 200000;
+    std::vector<flexible_type> data;
+    for (size_t i = 0;i < TEST_LENGTH; ++i) data.push_back(i);
+    auto sa = std::make_shared<sarray<flexible_type>>();
+    sa->open_for_write();
+    turi::copy(data.begin(), data.end(), *sa);
+    sa->close();
+
+    auto root = op_sarray_source::make_planner_node(sa);
+    auto add_one =
+        op_transform::make_planner_node(
+            root,
+            [](const sframe_rows::row& a)->flexible_type {
+              return a[0] + 1;
+            },
+            flex_type_enum::INTEGER);
+    auto odd_selector =
+        op_transform::make_planner_node(
+            root,
+            [](const sframe_rows::row& a)->flexible_type {
+              return (flex_int)(a[0]) % 2 == 1;
+            },
+            flex_type_enum::INTEGER);
+    // filter = add_one[odd_selector], i.e. the even numbers from 2
+    auto filter = op_logical_filter::make_planner_node(add_one, odd_selector);
+
+    // materialized output is in order
+    auto res = planner().materialize(filter);
+    std::vector<flexible_type> all_rows;
+    res.select_column(0)->get_reader()->read_rows(0, res.size(), all_rows);
+    TS_ASSERT_EQUALS(all_rows.size(), TEST_LENGTH / 2);
+    for (flex_int i = 0;i < truncate_check<int64_t>(TEST_LENGTH) / 2; ++i) {
+      TS_ASSERT_EQUALS(2*i + 2, all_rows[i]);
+    }
+
+    // rows delivered to a callback are in order within every segment
+    const size_t NUM_SEGMENTS = 4;
+    mutex lock;
+    std::vector<flex_int> last_value(NUM_SEGMENTS, 0);
+    size_t total_rows = 0;
+    bool in_order = true;
+    planner().materialize(
+        filter,
+        [&](size_t segment_id, const std::shared_ptr<sframe_rows>& rows) {
+          std::lock_guard<mutex> guard(lock);
+          for (const auto& row: *rows) {
+            flex_int value = row[0];
+            if (value <= last_value[segment_id]) in_order = false;
+            last_value[segment_id] = value;
+            ++total_rows;
+          }
+          return false;
+        },
+        NUM_SEGMENTS);
+    TS_ASSERT(in_order);
+    TS_ASSERT_EQUALS(total_rows, TEST_LENGTH / 2);
+
+    SFRAME_MORSEL_MIN_ROWS = old_min_rows;
+    SFRAME_MORSELS_PER_SEGMENT = old_morsels;
+  }
+
+  void test_materialize_several() {
+    const size_t TEST_LENGTH = 100000;
+    std::vector<flexible_type> data;
+    for (size_t i = 0;i < TEST_LENGTH; ++i) data.push_back(i);
+    auto sa = std::make_shared<sarray<flexible_type>>();
+    sa->open_for_write();
+    turi::copy(data.begin(), data.end(), *sa);
+    sa->close();
+
+    // a transform, a filter of the transform, and a reduction, all reading
+    // the same source
+    auto root = op_sarray_source::make_planner_node(sa);
+    auto add_one =
+        op_transform::make_planner_node(
+            root,
+            [](const sframe_rows::row& a)->flexible_type {
+              return a[0] + 1;
+            },
+            flex_type_enum::INTEGER);
+    auto even_selector =
+        op_transform::make_planner_node(
+            root,
+            [](const sframe_rows::row& a)->flexible_type {
+              return (flex_int)(a[0]) % 2 == 0;
+            },
+            flex_type_enum::INTEGER);
+    auto filter = op_logical_filter::make_planner_node(add_one, even_selector);
+    auto max_fn = [](const flexible_type& f, flex_int& val) {
+      if (f > val) val = f;
+    };
+    generic_aggregator<flex_int, decltype(max_fn)> agg(max_fn, 0);
+    auto max_node = op_reduce::make_planner_node(root, agg, flex_type_enum::STRING);
+
+    auto res = planner().materialize({add_one, filter, max_node});
+    TS_ASSERT_EQUALS(res.size(), 3);
+
+    std::vector<flexible_type> all_rows;
+    res[0].select_column(0)->get_reader()->read_rows(0, res[0].size(), all_rows);
+    TS_ASSERT_EQUALS(all_rows.size(), TEST_LENGTH);
+    for (flex_int i = 0;i < truncate_check<int64_t>(TEST_LENGTH); ++i) {
+      TS_ASSERT_EQUALS(i + 1, all_rows[i]);
+    }
+
+    res[1].select_column(0)->get_reader()->read_rows(0, res[1].size(), all_rows);
+    TS_ASSERT_EQUALS(all_rows.size(), TEST_LENGTH / 2);
+    for (flex_int i = 0;i < truncate_check<int64_t>(TEST_LENGTH) / 2; ++i) {
+      TS_ASSERT_EQUALS(2*i + 1, all_rows[i]);
+    }
+
+    // one partial maximum per segment
+    res[2].select_column(0)->get_reader()->read_rows(0, res[2].size(), all_rows);
+    flex_int m = 0;
+    for (const auto& row: all_rows) {
+      std::string st = row;
+      iarchive iarc(st.c_str(), st.length());
+      flex_int segment_max;
+      iarc >> segment_max;
+      m = std::max(m, segment_max);
+    }
+    TS_ASSERT_EQUALS(m, TEST_LENGTH - 1);
+
+    // the nodes were replaced by their results
+    TS_ASSERT(is_source_node(filter));
+    TS_ASSERT_EQUALS(infer_planner_node_length(filter), TEST_LENGTH / 2);
+  }
 };
 
 BOOST_FIXTURE_TEST_SUITE(_basic_end_to_end, basic_end_to_end)
@@ -287,4 +422,10 @@ BOOST_AUTO_TEST_CASE(test_reduction_aggregate) {
 BOOST_AUTO_TEST_CASE(test_range_slice) {
   basic_end_to_end::test_range_slice();
 }
+BOOST_AUTO_TEST_CASE(test_morsel_scheduling) {
+  basic_end_to_end::test_morsel_scheduling();
+}
+BOOST_AUTO_TEST_CASE(test_materialize_several) {
+  basic_end_to_end::test_materialize_several();
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,163 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <core/util/test_macros.hpp>
+#include <core/parallel/atomic.hpp>
+#include <core/storage/query_engine/planning/planner.hpp>
+#include <core/storage/query_engine/planning/cost_model.hpp>
+#include <core/storage/query_engine/planning/explain.hpp>
+#include <core/storage/query_engine/operators/all_operators.hpp>
+#include <core/storage/query_engine/operators/batch_expression.hpp>
+#include <core/storage/sframe_interface/unity_sarray_binary_operations.hpp>
+#include <core/storage/sframe_data/sarray.hpp>
+#include <core/storage/sframe_data/algorithm.hpp>
+
+using namespace turi;
+using namespace turi::query_eval;
+
+static const size_t TEST_LENGTH = 10000;
+
+struct cost_model_test {
+ public:
+  std::shared_ptr<sarray<flexible_type>> make_sequence() {
+    std::vector<flexible_type> data;
+    for (size_t i = 0;i < TEST_LENGTH; ++i) data.push_back(i);
+    auto sa = std::make_shared<sarray<flexible_type>>();
+    sa->open_for_write();
+    sa->set_type(flex_type_enum::INTEGER);
+    turi::copy(data.begin(), data.end(), *sa);
+    sa->close();
+    return sa;
+  }
+
+  /// source < value, as a fused expression
+  pnode_ptr make_less_than(pnode_ptr source, flex_int value) {
+    auto fn = unity_sarray_binary_operations::get_binary_operator(
+        flex_type_enum::INTEGER, flex_type_enum::INTEGER, "<");
+    auto expr = batch_expression::make_binary(
+        "<",
+        batch_expression::make_input(0, flex_type_enum::INTEGER),
+        batch_expression::make_constant(value),
+        fn);
+    return op_transform::make_planner_node(
+        source,
+        [expr](const sframe_rows::row& row) { return expr->evaluate_row(row); },
+        flex_type_enum::INTEGER, -1, expr);
+  }
+
+  void test_selectivity() {
+    auto source = op_sarray_source::make_planner_node(make_sequence());
+
+    double s = estimate_selectivity(make_less_than(source, TEST_LENGTH / 4));
+    TS_ASSERT_LESS_THAN(std::abs(s - 0.25), 0.05);
+    TS_ASSERT_EQUALS(estimate_selectivity(make_less_than(source, -1)), 0);
+    TS_ASSERT_EQUALS(estimate_selectivity(make_less_than(source, TEST_LENGTH)), 1);
+
+    // nothing is known about an opaque function
+    auto opaque = op_transform::make_planner_node(
+        source,
+        [](const sframe_rows::row& row)->flexible_type { return row[0] > 5; },
+        flex_type_enum::INTEGER);
+    TS_ASSERT_EQUALS(estimate_selectivity(opaque), DEFAULT_FILTER_SELECTIVITY);
+
+    auto filter = op_logical_filter::make_planner_node(
+        source, make_less_than(source, TEST_LENGTH / 4));
+    TS_ASSERT_LESS_THAN(std::abs(estimate_planner_node_length(filter) - TEST_LENGTH / 4.0),
+                        TEST_LENGTH / 20.0);
+    TS_ASSERT_EQUALS(estimate_planner_node_length(source), TEST_LENGTH);
+
+    TS_ASSERT_LESS_THAN(estimate_planner_node_cost(make_less_than(source, 0)),
+                        estimate_planner_node_cost(opaque));
+  }
+
+  void test_filter_ordering() {
+    auto source = op_sarray_source::make_planner_node(make_sequence());
+
+    // An expensive and unselective filter followed by a cheap and
+    // selective one, which should be applied first.
+    auto num_calls = std::make_shared<atomic<size_t>>(0);
+    auto even = op_transform::make_planner_node(
+        source,
+        [num_calls](const sframe_rows::row& row)->flexible_type {
+          num_calls->inc();
+          return (flex_int)(row[0]) % 2 == 0;
+        },
+        flex_type_enum::INTEGER);
+    auto evens = op_logical_filter::make_planner_node(source, even);
+    auto small_evens = op_logical_filter::make_planner_node(
+        evens, make_less_than(evens, 100));
+
+    auto res = planner().materialize(small_evens);
+    std::vector<flexible_type> all_rows;
+    res.select_column(0)->get_reader()->read_rows(0, res.size(), all_rows);
+    TS_ASSERT_EQUALS(all_rows.size(), 50);
+    for (size_t i = 0;i < all_rows.size(); ++i) {
+      TS_ASSERT_EQUALS(all_rows[i], 2 * i);
+    }
+    TS_ASSERT_LESS_THAN(num_calls->value, TEST_LENGTH);
+  }
+
+  void test_source_predicate() {
+    typedef v2_block_impl::block_predicate::op_type op_type;
+    auto sa = make_sequence();
+
+    v2_block_impl::block_predicate pred;
+    pred.op = op_type::GE;
+    pred.value = TEST_LENGTH - 10;
+    dense_bitset selection;
+    auto reader = sa->get_reader();
+    TS_ASSERT_EQUALS(reader->evaluate_predicate(5, TEST_LENGTH, pred, selection),
+                     TEST_LENGTH - 5);
+    TS_ASSERT_EQUALS(selection.size(), TEST_LENGTH - 5);
+    TS_ASSERT_EQUALS(selection.popcount(), 10);
+    TS_ASSERT(selection.get(TEST_LENGTH - 15));
+    TS_ASSERT(!selection.get(TEST_LENGTH - 16));
+
+    // the comparison is evaluated by a predicate source
+    auto source = op_sarray_source::make_planner_node(sa);
+    auto filter = op_logical_filter::make_planner_node(
+        source, make_less_than(source, 100));
+    auto e = explain_query_plan(filter);
+    TS_ASSERT(std::find(e.applied_transforms.begin(), e.applied_transforms.end(),
+                        "logical_filter(a, transform(sarray_source, x op c)) -> "
+                        "logical_filter(a, sarray_predicate_source)")
+              != e.applied_transforms.end());
+    TS_ASSERT(e.optimized_plan.find(" < 100") != std::string::npos);
+    TS_ASSERT_LESS_THAN(std::abs(e.optimized_rows - 100), 10);
+
+    auto res = planner().materialize(filter);
+    std::vector<flexible_type> all_rows;
+    res.select_column(0)->get_reader()->read_rows(0, res.size(), all_rows);
+    TS_ASSERT_EQUALS(all_rows.size(), 100);
+    for (size_t i = 0;i < all_rows.size(); ++i) {
+      TS_ASSERT_EQUALS(all_rows[i], i);
+    }
+
+    // undefined values satisfy !=, which is left alone
+    auto fn = unity_sarray_binary_operations::get_binary_operator(
+        flex_type_enum::INTEGER, flex_type_enum::INTEGER, "!=");
+    auto ne = batch_expression::make_binary(
+        "!=",
+        batch_expression::make_input(0, flex_type_enum::INTEGER),
+        batch_expression::make_constant(0),
+        fn);
+    auto ne_mask = op_transform::make_planner_node(
+        source,
+        [ne](const sframe_rows::row& row) { return ne->evaluate_row(row); },
+        flex_type_enum::INTEGER, -1, ne);
+    auto e2 = explain_query_plan(op_logical_filter::make_planner_node(source, ne_mask));
+    TS_ASSERT(e2.optimized_plan.find(" != ") == std::string::npos);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_cost_model_test, cost_model_test)
+BOOST_AUTO_TEST_CASE(test_selectivity) {
+  cost_model_test::test_selectivity();
+}
+BOOST_AUTO_TEST_CASE(test_filter_ordering) {
+  cost_model_test::test_filter_ordering();
+}
+BOOST_AUTO_TEST_CASE(test_source_predicate) {
+  cost_model_test::test_source_predicate();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,129 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <sstream>
+#include <boost/filesystem.hpp>
+#include <core/storage/query_engine/execution/distributed_executor.hpp>
+#include <core/storage/query_engine/operators/all_operators.hpp>
+#include <core/storage/query_engine/planning/planner.hpp>
+#include <core/storage/fileio/temp_files.hpp>
+#include <core/storage/serialization/serialization_includes.hpp>
+#include <core/storage/sframe_data/sarray.hpp>
+#include <core/storage/sframe_data/algorithm.hpp>
+
+using namespace turi;
+using namespace turi::query_eval;
+
+static const size_t TEST_LENGTH = 1000;
+
+struct distributed_executor_test {
+ public:
+  /// An array of f(0), f(1), ..., in files another process could open
+  template <typename Fn>
+  std::shared_ptr<sarray<flexible_type>> make_array(Fn f, bool on_disk = true) {
+    std::vector<flexible_type> data;
+    for (size_t i = 0;i < TEST_LENGTH; ++i) data.push_back(f(i));
+    auto sa = std::make_shared<sarray<flexible_type>>();
+    if (on_disk) {
+      sa->open_for_write(get_temp_name() + ".sidx");
+    } else {
+      sa->open_for_write();
+    }
+    sa->set_type(flex_type_enum::INTEGER);
+    turi::copy(data.begin(), data.end(), *sa);
+    sa->close();
+    return sa;
+  }
+
+  /// The odd numbers, twice
+  pnode_ptr make_plan(bool on_disk = true) {
+    auto values = op_sarray_source::make_planner_node(
+        make_array([](size_t i) { return flex_int(i); }, on_disk));
+    auto odd = op_sarray_source::make_planner_node(
+        make_array([](size_t i) { return flex_int(i % 2); }, on_disk));
+    auto filtered = op_logical_filter::make_planner_node(values, odd);
+    return op_union::make_planner_node(filtered, filtered);
+  }
+
+  std::vector<std::vector<flexible_type>> rows(sframe sf) {
+    std::vector<std::vector<flexible_type>> ret;
+    turi::copy(sf, std::inserter(ret, ret.end()));
+    return ret;
+  }
+
+  void test_save_load_plan() {
+    auto plan = make_plan();
+    TS_ASSERT(is_portable_plan(plan));
+    std::stringstream strm;
+    oarchive oarc(strm);
+    save_plan(oarc, plan);
+    iarchive iarc(strm);
+    auto loaded = load_plan(iarc);
+    // the filter read by both sides of the union is shared
+    TS_ASSERT(loaded->inputs[0] == loaded->inputs[1]);
+    TS_ASSERT(rows(planner().materialize(loaded)) == rows(planner().materialize(plan)));
+
+    // arrays in the in-memory cache cannot be opened elsewhere
+    TS_ASSERT(!is_portable_plan(make_plan(false)));
+  }
+
+  void test_distributed_materialize() {
+    distributed_query_worker worker1, worker2;
+    std::string output_directory = get_temp_name();
+    boost::filesystem::create_directories(output_directory);
+    distributed_executor executor({worker1.address(), worker2.address()},
+                                  output_directory);
+
+    auto plan = make_plan();
+    TS_ASSERT(executor.can_distribute(plan));
+    sframe result = executor.materialize(plan, {"a", "b"});
+    TS_ASSERT_EQUALS(result.num_rows(), TEST_LENGTH / 2);
+    TS_ASSERT_EQUALS(result.column_name(1), "b");
+    // the slices were written by the workers to the output directory
+    TS_ASSERT(!boost::filesystem::is_empty(output_directory));
+    auto values = rows(result);
+    for (size_t i = 0; i < values.size(); ++i) {
+      TS_ASSERT_EQUALS(values[i][0], flex_int(2 * i + 1));
+      TS_ASSERT_EQUALS(values[i][1], flex_int(2 * i + 1));
+    }
+
+    // plans which cannot be moved run locally
+    auto local_plan = make_plan(false);
+    TS_ASSERT(!executor.can_distribute(local_plan));
+    TS_ASSERT(rows(executor.materialize(local_plan)) == values);
+  }
+
+  void test_unreachable_worker_fallback() {
+    distributed_query_worker worker;
+    std::string dead_address;
+    {
+      // a worker which went away
+      distributed_query_worker dead_worker;
+      dead_address = dead_worker.address();
+    }
+    std::string output_directory = get_temp_name();
+    boost::filesystem::create_directories(output_directory);
+    distributed_executor executor({worker.address(), dead_address},
+                                  output_directory, 2, 1);
+
+    // the slices of the dead worker are materialized locally
+    sframe result = executor.materialize(make_plan());
+    auto values = rows(result);
+    TS_ASSERT_EQUALS(values.size(), TEST_LENGTH / 2);
+    for (size_t i = 0; i < values.size(); ++i) {
+      TS_ASSERT_EQUALS(values[i][0], flex_int(2 * i + 1));
+    }
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_distributed_executor_test, distributed_executor_test)
+BOOST_AUTO_TEST_CASE(test_save_load_plan) {
+  distributed_executor_test::test_save_load_plan();
+}
+BOOST_AUTO_TEST_CASE(test_distributed_materialize) {
+  distributed_executor_test::test_distributed_materialize();
+}
+BOOST_AUTO_TEST_CASE(test_unreachable_worker_fallback) {
+  distributed_executor_test::test_unreachable_worker_fallback();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,68 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <core/util/test_macros.hpp>
+#include <core/storage/query_engine/planning/explain.hpp>
+#include <core/storage/query_engine/operators/all_operators.hpp>
+#include <core/storage/sframe_data/sarray.hpp>
+#include <core/storage/sframe_data/algorithm.hpp>
+
+using namespace turi;
+using namespace turi::query_eval;
+
+static const size_t TEST_LENGTH = 1000;
+
+struct explain_test {
+ public:
+  std::shared_ptr<sarray<flexible_type>> make_sequence() {
+    std::vector<flexible_type> data;
+    for (size_t i = 0;i < TEST_LENGTH; ++i) data.push_back(i);
+    auto sa = std::make_shared<sarray<flexible_type>>();
+    sa->open_for_write();
+    sa->set_type(flex_type_enum::INTEGER);
+    turi::copy(data.begin(), data.end(), *sa);
+    sa->close();
+    return sa;
+  }
+
+  void test_explain() {
+    auto a = op_sarray_source::make_planner_node(make_sequence());
+    auto b = op_sarray_source::make_planner_node(make_sequence());
+    auto both = op_union::make_planner_node(a, b);
+    auto second = op_project::make_planner_node(both, {1});
+    auto second_input = second->inputs[0];
+
+    auto e = explain_query_plan(second);
+    TS_ASSERT_EQUALS(e.logical_rows, TEST_LENGTH);
+    TS_ASSERT_EQUALS(e.optimized_rows, TEST_LENGTH);
+    TS_ASSERT(!e.applied_transforms.empty());
+    TS_ASSERT_LESS_THAN_EQUALS(e.optimized_cost, e.logical_cost);
+
+    // one line per node; the union is optimized away
+    TS_ASSERT_EQUALS(std::count(e.logical_plan.begin(), e.logical_plan.end(), '\n'), 4);
+    TS_ASSERT_LESS_THAN(std::count(e.optimized_plan.begin(), e.optimized_plan.end(), '\n'), 4);
+    TS_ASSERT(e.logical_plan.find("Union") != std::string::npos);
+    TS_ASSERT(e.optimized_plan.find("Union") == std::string::npos);
+    TS_ASSERT(e.logical_plan_dot.find("digraph") != std::string::npos);
+
+    // the plan itself is untouched
+    TS_ASSERT(second->inputs[0] == second_input);
+    TS_ASSERT(second_input->inputs[0] == a);
+
+    auto m = e.to_map();
+    TS_ASSERT_EQUALS(m.at("text").get<flex_string>(), e.to_string());
+    TS_ASSERT_EQUALS(m.at("applied_transforms").size(), e.applied_transforms.size());
+
+    materialize_options no_opt;
+    no_opt.disable_optimization = true;
+    auto e2 = explain_query_plan(second, no_opt);
+    TS_ASSERT(e2.applied_transforms.empty());
+    TS_ASSERT_EQUALS(e2.optimized_plan, e2.logical_plan);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_explain_test, explain_test)
+BOOST_AUTO_TEST_CASE(test_explain) {
+  explain_test::test_explain();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,127 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <core/storage/query_engine/planning/planner.hpp>
+#include <core/storage/query_engine/planning/materialization_cache.hpp>
+#include <core/storage/query_engine/operators/all_operators.hpp>
+#include <core/storage/query_engine/operators/batch_expression.hpp>
+#include <core/storage/sframe_interface/unity_sarray_binary_operations.hpp>
+#include <core/storage/sframe_data/sarray.hpp>
+#include <core/storage/sframe_data/algorithm.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
+
+using namespace turi;
+using namespace turi::query_eval;
+
+static const size_t TEST_LENGTH = 1000;
+
+struct materialization_cache_test {
+ public:
+  std::shared_ptr<sarray<flexible_type>> make_sequence() {
+    std::vector<flexible_type> data;
+    for (size_t i = 0;i < TEST_LENGTH; ++i) data.push_back(i);
+    auto sa = std::make_shared<sarray<flexible_type>>();
+    sa->open_for_write();
+    sa->set_type(flex_type_enum::INTEGER);
+    turi::copy(data.begin(), data.end(), *sa);
+    sa->close();
+    return sa;
+  }
+
+  /// source * 2, as a fused expression
+  pnode_ptr make_double(pnode_ptr source) {
+    auto fn = unity_sarray_binary_operations::get_binary_operator(
+        flex_type_enum::INTEGER, flex_type_enum::INTEGER, "*");
+    auto expr = batch_expression::make_binary(
+        "*",
+        batch_expression::make_input(0, flex_type_enum::INTEGER),
+        batch_expression::make_constant(2),
+        fn);
+    return op_transform::make_planner_node(
+        source,
+        [expr](const sframe_rows::row& row) { return expr->evaluate_row(row); },
+        flex_type_enum::INTEGER, -1, expr);
+  }
+
+  void test_reuse() {
+    auto& cache = materialization_cache::get_instance();
+    cache.clear();
+    auto sa = make_sequence();
+
+    // two separately built, identical graphs
+    auto first = make_double(op_sarray_source::make_planner_node(sa));
+    auto second = make_double(op_sarray_source::make_planner_node(sa));
+    TS_ASSERT(materialization_cache::make_key(first).key ==
+              materialization_cache::make_key(second).key);
+    TS_ASSERT(materialization_cache::make_key(first).key !=
+              materialization_cache::make_key(
+                  make_double(op_sarray_source::make_planner_node(sa, 0, 10))).key);
+
+    sframe first_result = planner().materialize(first);
+    TS_ASSERT_EQUALS(cache.size(), 1);
+    sframe second_result = planner().materialize(second);
+    TS_ASSERT_EQUALS(cache.size(), 1);
+    // the second query reads the columns written by the first
+    TS_ASSERT(first_result.select_column(0) == second_result.select_column(0));
+
+    std::vector<flexible_type> all_rows;
+    second_result.select_column(0)->get_reader()->read_rows(0, second_result.size(), all_rows);
+    TS_ASSERT_EQUALS(all_rows.size(), TEST_LENGTH);
+    for (size_t i = 0;i < TEST_LENGTH; ++i) {
+      TS_ASSERT_EQUALS(all_rows[i], 2 * i);
+    }
+
+    // queries with opaque functions are never cached
+    auto opaque = op_transform::make_planner_node(
+        op_sarray_source::make_planner_node(sa),
+        [](const sframe_rows::row& row)->flexible_type { return row[0] + 1; },
+        flex_type_enum::INTEGER);
+    TS_ASSERT(materialization_cache::make_key(opaque).key.empty());
+    planner().materialize(opaque);
+    TS_ASSERT_EQUALS(cache.size(), 1);
+    cache.clear();
+  }
+
+  void test_invalidation() {
+    auto& cache = materialization_cache::get_instance();
+    cache.clear();
+    auto sa = make_sequence();
+    planner().materialize(make_double(op_sarray_source::make_planner_node(sa)));
+    TS_ASSERT_EQUALS(cache.size(), 1);
+
+    // once the source is gone, the entry is dropped on the next access
+    sa.reset();
+    std::vector<std::shared_ptr<sarray<flexible_type>>> columns;
+    auto other = make_sequence();
+    TS_ASSERT(!cache.lookup(
+        materialization_cache::make_key(make_double(op_sarray_source::make_planner_node(other))),
+        columns));
+    TS_ASSERT_EQUALS(cache.size(), 0);
+  }
+
+  void test_capacity() {
+    auto& cache = materialization_cache::get_instance();
+    cache.clear();
+    size_t old_capacity = SFRAME_MATERIALIZATION_CACHE_CAPACITY;
+    SFRAME_MATERIALIZATION_CACHE_CAPACITY = 2;
+    auto sa = make_sequence();
+    for (size_t i = 0; i < 4; ++i) {
+      planner().materialize(make_double(op_sarray_source::make_planner_node(sa, 0, 10 + i)));
+    }
+    TS_ASSERT_EQUALS(cache.size(), 2);
+    SFRAME_MATERIALIZATION_CACHE_CAPACITY = old_capacity;
+    cache.clear();
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_materialization_cache_test, materialization_cache_test)
+BOOST_AUTO_TEST_CASE(test_reuse) {
+  materialization_cache_test::test_reuse();
+}
+BOOST_AUTO_TEST_CASE(test_invalidation) {
+  materialization_cache_test::test_invalidation();
+}
+BOOST_AUTO_TEST_CASE(test_capacity) {
+  materialization_cache_test::test_capacity();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,111 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <core/random/random.hpp>
+#include <core/storage/query_engine/algorithm/normalized_key_sort.hpp>
+#include <core/storage/query_engine/algorithm/sort_comparator.hpp>
+
+using namespace turi;
+using namespace turi::query_eval;
+
+struct normalized_key_sort_test {
+ public:
+  flexible_type random_value(flex_type_enum type) {
+    if (random::fast_uniform<size_t>(0, 20) == 0) return FLEX_UNDEFINED;
+    switch (type) {
+     case flex_type_enum::INTEGER: {
+       flex_int extremes[] = {std::numeric_limits<flex_int>::min(),
+                              std::numeric_limits<flex_int>::max(), 0, -1};
+       if (random::fast_uniform<size_t>(0, 50) == 0) {
+         return extremes[random::fast_uniform<size_t>(0, 3)];
+       }
+       return random::fast_uniform<flex_int>(-1000, 1000);
+     }
+     case flex_type_enum::FLOAT: {
+       if (random::fast_uniform<size_t>(0, 50) == 0) return -0.0;
+       return random::fast_uniform<flex_int>(-1000, 1000) / 8.0;
+     }
+     case flex_type_enum::STRING: {
+       // long common prefixes, embedded zeros and high bytes
+       std::string s = random::fast_uniform<size_t>(0, 1) ? "prefix__" : "";
+       size_t len = random::fast_uniform<size_t>(0, 10);
+       const char chars[] = {'\0', 'a', 'b', 'z', '\xff'};
+       for (size_t i = 0; i < len; ++i) s += chars[random::fast_uniform<size_t>(0, 4)];
+       return s;
+     }
+     case flex_type_enum::DATETIME:
+       return flex_date_time(random::fast_uniform<flex_int>(-100, 100),
+                             0, random::fast_uniform<int32_t>(0, 3));
+     case flex_type_enum::VECTOR:
+       return flex_vec{(double)random::fast_uniform<flex_int>(0, 10)};
+     default:
+       return FLEX_UNDEFINED;
+    }
+  }
+
+  void check(const std::vector<flex_type_enum>& types,
+             const std::vector<bool>& sort_orders,
+             size_t num_rows) {
+    std::vector<std::vector<flexible_type>> rows(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+      for (auto type: types) rows[i].push_back(random_value(type));
+      rows[i].push_back(i);
+    }
+    std::vector<size_t> sort_columns(types.size());
+    std::iota(sort_columns.begin(), sort_columns.end(), 0);
+    less_than_partial_function comparator(sort_columns, sort_orders);
+    normalized_key_sort(rows, sort_orders,
+                        [](const std::vector<flexible_type>& row, size_t i)
+                            -> const flexible_type& { return row[i]; },
+                        comparator);
+    TS_ASSERT_EQUALS(rows.size(), num_rows);
+    for (size_t i = 1; i < rows.size(); ++i) {
+      TS_ASSERT(!comparator(rows[i], rows[i - 1]));
+    }
+    // nothing is lost or duplicated
+    std::vector<bool> seen(num_rows, false);
+    for (const auto& row: rows) seen[row.back().get<flex_int>()] = true;
+    TS_ASSERT(std::all_of(seen.begin(), seen.end(), [](bool b) { return b; }));
+  }
+
+  void test_single_key() {
+    for (auto type: {flex_type_enum::INTEGER, flex_type_enum::FLOAT,
+                     flex_type_enum::STRING, flex_type_enum::DATETIME}) {
+      check({type}, {true}, 1000);
+      check({type}, {false}, 1000);
+    }
+  }
+
+  void test_multiple_keys() {
+    check({flex_type_enum::STRING, flex_type_enum::INTEGER}, {true, false}, 200000);
+    check({flex_type_enum::INTEGER, flex_type_enum::FLOAT, flex_type_enum::STRING},
+          {false, true, true}, 10000);
+    check({flex_type_enum::DATETIME, flex_type_enum::STRING}, {true, true}, 10000);
+  }
+
+  void test_fallback() {
+    // vectors are not normalized, and neither are mixed types
+    check({flex_type_enum::VECTOR, flex_type_enum::INTEGER}, {true, true}, 1000);
+    std::vector<std::vector<flexible_type>> rows{{1}, {2.5}, {0.5}, {FLEX_UNDEFINED}, {2}};
+    less_than_full_function comparator({true});
+    normalized_key_sort(rows, {true},
+                        [](const std::vector<flexible_type>& row, size_t i)
+                            -> const flexible_type& { return row[i]; },
+                        comparator);
+    for (size_t i = 1; i < rows.size(); ++i) {
+      TS_ASSERT(!comparator(rows[i], rows[i - 1]));
+    }
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_normalized_key_sort_test, normalized_key_sort_test)
+BOOST_AUTO_TEST_CASE(test_single_key) {
+  normalized_key_sort_test::test_single_key();
+}
+BOOST_AUTO_TEST_CASE(test_multiple_keys) {
+  normalized_key_sort_test::test_multiple_keys();
+}
+BOOST_AUTO_TEST_CASE(test_fallback) {
+  normalized_key_sort_test::test_fallback();
+}
+BOOST_AUTO_TEST_SUITE_END()
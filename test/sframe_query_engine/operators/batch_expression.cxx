@@ -0,0 +1,230 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <core/storage/query_engine/execution/execution_node.hpp>
+#include <core/storage/query_engine/operators/sarray_source.hpp>
+#include <core/storage/query_engine/operators/transform.hpp>
+#include <core/storage/query_engine/operators/binary_transform.hpp>
+#include <core/storage/query_engine/operators/batch_expression.hpp>
+#include <core/storage/sframe_interface/unity_sarray_binary_operations.hpp>
+#include <core/storage/sframe_data/sarray.hpp>
+#include <core/storage/sframe_data/algorithm.hpp>
+
+#include "check_node.hpp"
+
+using namespace turi;
+using namespace turi::query_eval;
+
+struct batch_expression_test {
+ public:
+  /**
+   * The scalar function of a binary operator, with the undefined handling
+   * of unity_sarray::vector_operator.
+   */
+  static batch_scalar_fn make_scalar_fn(const std::string& op,
+                                        flex_type_enum left,
+                                        flex_type_enum right) {
+    auto fn = unity_sarray_binary_operations::get_binary_operator(left, right, op);
+    if (op == "&" || op == "|") return fn;
+    return [=](const flexible_type& l, const flexible_type& r)->flexible_type {
+      if (l.get_type() == flex_type_enum::UNDEFINED ||
+          r.get_type() == flex_type_enum::UNDEFINED) {
+        if (op == "==") return l.get_type() == r.get_type();
+        if (op == "!=") return l.get_type() != r.get_type();
+        return FLEX_UNDEFINED;
+      }
+      return fn(l, r);
+    };
+  }
+
+  static batch_expression_ptr make_binary(const std::string& op,
+                                          batch_expression_ptr left,
+                                          batch_expression_ptr right) {
+    return batch_expression::make_binary(
+        op, left, right, make_scalar_fn(op, left->value_type, right->value_type));
+  }
+
+  static batch_expression_ptr make_cast(batch_expression_ptr child,
+                                        flex_type_enum type) {
+    return batch_expression::make_cast(
+        child, type, [type](const flexible_type& f, const flexible_type&)->flexible_type {
+          if (f.get_type() == flex_type_enum::UNDEFINED) return f;
+          flexible_type ret(type);
+          ret.soft_assign(f);
+          return ret;
+        });
+  }
+
+  static flexible_type random_value(std::mt19937& gen, flex_type_enum type) {
+    int r = gen() % 10;
+    if (r == 0) return FLEX_UNDEFINED;
+    if (type == flex_type_enum::FLOAT) {
+      if (r == 1) return flex_float(NAN);
+      if (r == 2) return flex_float(1e300);
+      return flex_float((int)(gen() % 21) - 10) / 4.0;
+    }
+    if (r == 1) return flex_int(std::numeric_limits<flex_int>::max());
+    return flex_int((int)(gen() % 21) - 10);
+  }
+
+  static bool same_value(const flexible_type& a, const flexible_type& b) {
+    if (a.get_type() != b.get_type()) return false;
+    if (a.get_type() == flex_type_enum::FLOAT &&
+        std::isnan(a.get<flex_float>())) {
+      return std::isnan(b.get<flex_float>());
+    }
+    return a.identical(b);
+  }
+
+  std::shared_ptr<sarray<flexible_type>> make_sarray(const std::vector<flexible_type>& data,
+                                                     flex_type_enum type) {
+    auto sa = std::make_shared<sarray<flexible_type>>();
+    sa->open_for_write();
+    sa->set_type(type);
+    turi::copy(data.begin(), data.end(), *sa);
+    sa->close();
+    return sa;
+  }
+
+  void test_matches_row_evaluation() {
+    // random expression trees over random batches containing undefined
+    // values, NaNs and overflowing values.
+    std::mt19937 gen(0);
+    std::vector<std::string> ops{"+", "-", "*", "/", "<", ">", "<=", ">=",
+                                 "==", "!=", "&", "|"};
+    std::vector<flex_type_enum> types{flex_type_enum::INTEGER, flex_type_enum::FLOAT};
+    for (size_t trial = 0; trial < 500; ++trial) {
+      flex_type_enum left_type = types[gen() % 2];
+      flex_type_enum right_type = types[gen() % 2];
+      size_t num_rows = gen() % 200;
+      auto left_column = std::make_shared<std::vector<flexible_type>>();
+      auto right_column = std::make_shared<std::vector<flexible_type>>();
+      for (size_t i = 0; i < num_rows; ++i) {
+        left_column->push_back(random_value(gen, left_type));
+        right_column->push_back(random_value(gen, right_type));
+      }
+      sframe_rows left, right;
+      left.add_decoded_column(left_column);
+      right.add_decoded_column(right_column);
+
+      std::function<batch_expression_ptr(size_t)> build =
+          [&](size_t depth)->batch_expression_ptr {
+        int kind = gen() % 4;
+        if (depth == 0 || kind == 0) {
+          int leaf = gen() % 3;
+          if (leaf == 0) return batch_expression::make_input(0, left_type);
+          if (leaf == 1) return batch_expression::make_input(1, right_type);
+          flexible_type value = random_value(gen, types[gen() % 2]);
+          if (value.get_type() == flex_type_enum::UNDEFINED) value = 3;
+          return batch_expression::make_constant(value);
+        } else if (kind == 1) {
+          auto child = build(depth - 1);
+          return make_cast(child, child->value_type == flex_type_enum::INTEGER ?
+                                  flex_type_enum::FLOAT : flex_type_enum::INTEGER);
+        } else {
+          auto l = build(depth - 1);
+          auto r = build(depth - 1);
+          return make_binary(ops[gen() % ops.size()], l, r);
+        }
+      };
+      auto expr = build(3);
+
+      std::vector<flexible_type> out;
+      expr->evaluate_batch(left, right, out);
+      TS_ASSERT_EQUALS(out.size(), num_rows);
+      for (size_t i = 0; i < num_rows; ++i) {
+        auto expected = expr->evaluate_row(sframe_rows::row(&left, i),
+                                           sframe_rows::row(&right, i));
+        TS_ASSERT(same_value(out[i], expected));
+      }
+    }
+  }
+
+  void test_binary_transform() {
+    // (a * 2 + b) > 3
+    std::vector<flexible_type> a{0, 1, 2, FLEX_UNDEFINED, 4, 5, -3};
+    std::vector<flexible_type> b{0.5, 1.5, FLEX_UNDEFINED, 3.5, -10.0, 0.0, 9.0};
+    auto expr = make_binary(
+        ">",
+        make_binary("+",
+                    make_binary("*",
+                                batch_expression::make_input(0, flex_type_enum::INTEGER),
+                                batch_expression::make_constant(2)),
+                    batch_expression::make_input(1, flex_type_enum::FLOAT)),
+        batch_expression::make_constant(3));
+    TS_ASSERT(expr->value_type == flex_type_enum::INTEGER);
+    TS_ASSERT(expr->uses_second_input());
+    TS_ASSERT_EQUALS(expr->num_nodes(), 7);
+
+    std::vector<flexible_type> expected{0, 1, FLEX_UNDEFINED, FLEX_UNDEFINED, 0, 1, 0};
+    binary_transform_type fn = [expr](const sframe_rows::row& l,
+                                      const sframe_rows::row& r) {
+      return expr->evaluate_row(l, r);
+    };
+    auto left_node = std::make_shared<execution_node>(
+        std::make_shared<op_sarray_source>(make_sarray(a, flex_type_enum::INTEGER)));
+    auto right_node = std::make_shared<execution_node>(
+        std::make_shared<op_sarray_source>(make_sarray(b, flex_type_enum::FLOAT)));
+    auto node = std::make_shared<execution_node>(
+        std::make_shared<op_binary_transform>(fn, flex_type_enum::INTEGER, expr),
+        std::vector<std::shared_ptr<execution_node>>({left_node, right_node}));
+    check_node(node, expected);
+  }
+
+  void test_transform_cast() {
+    // int(a / 2)
+    std::vector<flexible_type> a{0, 1, -3, FLEX_UNDEFINED, 7};
+    auto expr = make_cast(
+        make_binary("/",
+                    batch_expression::make_input(0, flex_type_enum::INTEGER),
+                    batch_expression::make_constant(2)),
+        flex_type_enum::INTEGER);
+    TS_ASSERT(!expr->uses_second_input());
+    std::vector<flexible_type> expected{0, 0, -1, FLEX_UNDEFINED, 3};
+    transform_type fn = [expr](const sframe_rows::row& row) {
+      return expr->evaluate_row(row);
+    };
+    auto source_node = std::make_shared<execution_node>(
+        std::make_shared<op_sarray_source>(make_sarray(a, flex_type_enum::INTEGER)));
+    auto node = std::make_shared<execution_node>(
+        std::make_shared<op_transform>(fn, flex_type_enum::INTEGER, -1, expr),
+        std::vector<std::shared_ptr<execution_node>>({source_node}));
+    check_node(node, expected);
+  }
+
+  void test_with_input() {
+    auto expr = make_binary("-",
+                            batch_expression::make_input(0, flex_type_enum::FLOAT),
+                            batch_expression::make_constant(1.0));
+    TS_ASSERT(!expr->uses_second_input());
+    auto moved = expr->with_input(1);
+    TS_ASSERT(moved->uses_second_input());
+    TS_ASSERT(!expr->uses_second_input());
+    TS_ASSERT(moved->value_type == flex_type_enum::FLOAT);
+
+    TS_ASSERT(batch_expression::supports_operator("*", flex_type_enum::INTEGER,
+                                                  flex_type_enum::FLOAT));
+    TS_ASSERT(!batch_expression::supports_operator("%", flex_type_enum::INTEGER,
+                                                   flex_type_enum::INTEGER));
+    TS_ASSERT(!batch_expression::supports_operator("+", flex_type_enum::VECTOR,
+                                                   flex_type_enum::FLOAT));
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_batch_expression_test, batch_expression_test)
+BOOST_AUTO_TEST_CASE(test_matches_row_evaluation) {
+  batch_expression_test::test_matches_row_evaluation();
+}
+BOOST_AUTO_TEST_CASE(test_binary_transform) {
+  batch_expression_test::test_binary_transform();
+}
+BOOST_AUTO_TEST_CASE(test_transform_cast) {
+  batch_expression_test::test_transform_cast();
+}
+BOOST_AUTO_TEST_CASE(test_with_input) {
+  batch_expression_test::test_with_input();
+}
+BOOST_AUTO_TEST_SUITE_END()
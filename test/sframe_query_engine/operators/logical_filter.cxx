@@ -6,6 +6,7 @@
 #include <core/storage/query_engine/operators/logical_filter.hpp>
 #include <core/storage/sframe_data/sarray.hpp>
 #include <core/storage/sframe_data/algorithm.hpp>
+#include <core/storage/sframe_data/sframe_config.hpp>
 
 #include "check_node.hpp"
 
@@ -90,6 +91,30 @@ struct logical_filter_test {
     check_node(node, expected);
   }
 
+  void test_filter_blocks() {
+    // blocks which pass entirely, partially, or not at all, in turn
+    size_t block_size = sframe_config::SFRAME_READ_BATCH_SIZE;
+    size_t num_rows = 7 * block_size + 17;
+    std::vector<flexible_type> data, filter, expected;
+    for (size_t i = 0; i < num_rows; ++i) {
+      size_t block = i / block_size;
+      bool keep = (block % 3 == 0) || (block % 3 == 1 && i % 3 == 0);
+      data.push_back(flexible_type(std::to_string(i)));
+      filter.push_back(keep);
+      if (keep) expected.push_back(data.back());
+    }
+    auto data_sa = std::make_shared<sarray<flexible_type>>();
+    data_sa->open_for_write();
+    turi::copy(data.begin(), data.end(), *data_sa);
+    data_sa->close();
+    auto filter_sa = std::make_shared<sarray<flexible_type>>();
+    filter_sa->open_for_write();
+    turi::copy(filter.begin(), filter.end(), *filter_sa);
+    filter_sa->close();
+
+    auto node = make_node(op_sarray_source(data_sa), op_sarray_source(filter_sa));
+    check_node(node, expected);
+  }
 
   std::shared_ptr<sarray<flexible_type>> get_data_sarray() {
     std::vector<flexible_type> data{0,1,2,3,4,5};
@@ -123,4 +148,7 @@ BOOST_AUTO_TEST_CASE(test_filter_all) {
 BOOST_AUTO_TEST_CASE(test_filter_even) {
   logical_filter_test::test_filter_even();
 }
+BOOST_AUTO_TEST_CASE(test_filter_blocks) {
+  logical_filter_test::test_filter_blocks();
+}
 BOOST_AUTO_TEST_SUITE_END()
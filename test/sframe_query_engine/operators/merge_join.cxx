@@ -0,0 +1,155 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <sstream>
+#include <core/storage/query_engine/operators/all_operators.hpp>
+#include <core/storage/query_engine/operators/operator_properties.hpp>
+#include <core/storage/query_engine/algorithm/merge_join.hpp>
+#include <core/storage/sframe_data/join.hpp>
+#include <core/storage/sframe_data/sframe.hpp>
+
+using namespace turi;
+using namespace turi::query_eval;
+
+struct merge_join_test {
+ public:
+  /**
+   * Makes an sframe with columns "key" and "value" from rows, written in
+   * order over num_segments segments.
+   */
+  sframe make_sframe(const std::vector<std::vector<flexible_type>>& rows,
+                     size_t num_segments = 3) {
+    sframe sf;
+    sf.open_for_write({"key", "value"},
+                      {flex_type_enum::INTEGER, flex_type_enum::INTEGER},
+                      "", num_segments);
+    for (size_t seg = 0; seg < num_segments; ++seg) {
+      auto it = sf.get_output_iterator(seg);
+      size_t begin = rows.size() * seg / num_segments;
+      size_t end = rows.size() * (seg + 1) / num_segments;
+      for (size_t i = begin; i < end; ++i) {
+        *it = rows[i];
+        ++it;
+      }
+    }
+    sf.close();
+    return sf;
+  }
+
+  /// The rows of an sframe printed and sorted, to compare in any order.
+  std::vector<std::string> sorted_rows(sframe& sf) {
+    std::vector<std::vector<flexible_type>> rows;
+    sf.get_reader()->read_rows(0, sf.num_rows(), rows);
+    std::vector<std::string> ret;
+    for (const auto& row: rows) {
+      std::ostringstream strm;
+      for (const auto& v: row) {
+        if (v.get_type() == flex_type_enum::UNDEFINED) strm << "None|";
+        else strm << v << "|";
+      }
+      ret.push_back(strm.str());
+    }
+    std::sort(ret.begin(), ret.end());
+    return ret;
+  }
+
+  void test_is_sorted_by() {
+    std::vector<std::vector<flexible_type>> rows;
+    for (size_t i = 0; i < 1000; ++i) rows.push_back({i / 3, (i * 7919) % 1000});
+    sframe sf = make_sframe(rows);
+    auto source = op_sframe_source::make_planner_node(sf);
+    TS_ASSERT(is_sorted_by(source, {0}));
+    TS_ASSERT(!is_sorted_by(source, {1}));
+    TS_ASSERT(!is_sorted_by(source, {0, 1}));
+
+    // projections map the columns through
+    auto swapped = op_project::make_planner_node(source, {1, 0});
+    TS_ASSERT(is_sorted_by(swapped, {1}));
+    TS_ASSERT(!is_sorted_by(swapped, {0}));
+
+    // filters keep the order
+    auto filtered = op_logical_filter::make_planner_node(
+        source, op_project::make_planner_node(source, {1}));
+    TS_ASSERT(is_sorted_by(filtered, {0}));
+
+    // missing values are never sorted
+    rows[500][0] = FLEX_UNDEFINED;
+    sframe with_missing = make_sframe(rows);
+    TS_ASSERT(!is_sorted_by(op_sframe_source::make_planner_node(with_missing), {0}));
+
+    // the order across segments matters
+    std::reverse(rows.begin(), rows.end());
+    sframe reversed = make_sframe(rows);
+    TS_ASSERT(!is_sorted_by(op_sframe_source::make_planner_node(reversed), {0}));
+  }
+
+  void test_join_types() {
+    // keys 0, 0, 1, 1, ... 99, 99 on the left, and 50 x 3, ... 149 x 3 on
+    // the right
+    std::vector<std::vector<flexible_type>> left_rows, right_rows;
+    for (size_t i = 0; i < 200; ++i) left_rows.push_back({i / 2, i});
+    for (size_t i = 0; i < 300; ++i) right_rows.push_back({i / 3 + 50, -(flex_int)i});
+    sframe left = make_sframe(left_rows, 2);
+    sframe right = make_sframe(right_rows, 5);
+    TS_ASSERT(can_merge_join(left, right, {{"key", "key"}}));
+    TS_ASSERT(!can_merge_join(left, right, {{"value", "key"}}));
+
+    for (std::string join_type: {"inner", "left", "right", "outer"}) {
+      sframe merged = query_eval::join(left, right, join_type, {{"key", "key"}}, {});
+      sframe hashed = turi::join(left, right, join_type, {{"key", "key"}}, {});
+      TS_ASSERT_EQUALS(merged.column_names(), hashed.column_names());
+      TS_ASSERT_EQUALS(merged.column_names(),
+                       std::vector<std::string>({"key", "value", "value.1"}));
+      TS_ASSERT_EQUALS(merged.num_rows(), hashed.num_rows());
+      TS_ASSERT(sorted_rows(merged) == sorted_rows(hashed));
+    }
+
+    sframe renamed = query_eval::join(left, right, "inner", {{"key", "key"}},
+                                      {{"value", "right_value"}});
+    TS_ASSERT_EQUALS(renamed.column_names(),
+                     std::vector<std::string>({"key", "value", "right_value"}));
+    TS_ASSERT_EQUALS(renamed.num_rows(), 50 * 2 * 3);
+  }
+
+  void test_empty_side() {
+    std::vector<std::vector<flexible_type>> rows;
+    for (size_t i = 0; i < 100; ++i) rows.push_back({i, i});
+    sframe full = make_sframe(rows);
+    sframe empty = make_sframe({});
+    TS_ASSERT(can_merge_join(full, empty, {{"key", "key"}}));
+
+    sframe inner = query_eval::join(full, empty, "inner", {{"key", "key"}}, {});
+    TS_ASSERT_EQUALS(inner.num_rows(), 0);
+    TS_ASSERT_EQUALS(inner.num_columns(), 3);
+
+    sframe left = query_eval::join(full, empty, "left", {{"key", "key"}}, {});
+    TS_ASSERT_EQUALS(left.num_rows(), 100);
+    std::vector<std::vector<flexible_type>> result;
+    left.get_reader()->read_rows(0, left.num_rows(), result);
+    for (size_t i = 0; i < result.size(); ++i) {
+      TS_ASSERT_EQUALS(result[i][0], i);
+      TS_ASSERT_EQUALS(result[i][2].get_type(), flex_type_enum::UNDEFINED);
+    }
+
+    sframe right = query_eval::join(empty, full, "right", {{"key", "key"}}, {});
+    TS_ASSERT_EQUALS(right.num_rows(), 100);
+    right.get_reader()->read_rows(0, right.num_rows(), result);
+    for (size_t i = 0; i < result.size(); ++i) {
+      TS_ASSERT_EQUALS(result[i][0], i);
+      TS_ASSERT_EQUALS(result[i][1].get_type(), flex_type_enum::UNDEFINED);
+      TS_ASSERT_EQUALS(result[i][2], i);
+    }
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_merge_join_test, merge_join_test)
+BOOST_AUTO_TEST_CASE(test_is_sorted_by) {
+  merge_join_test::test_is_sorted_by();
+}
+BOOST_AUTO_TEST_CASE(test_join_types) {
+  merge_join_test::test_join_types();
+}
+BOOST_AUTO_TEST_CASE(test_empty_side) {
+  merge_join_test::test_empty_side();
+}
+BOOST_AUTO_TEST_SUITE_END()
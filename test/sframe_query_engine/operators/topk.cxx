@@ -0,0 +1,114 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <core/storage/query_engine/operators/all_operators.hpp>
+#include <core/storage/query_engine/algorithm/ec_sort.hpp>
+#include <core/storage/query_engine/algorithm/topk.hpp>
+#include <core/storage/query_engine/planning/planner.hpp>
+#include <core/storage/sframe_data/sframe.hpp>
+#include <core/storage/sframe_data/sframe_constants.hpp>
+
+using namespace turi;
+using namespace turi::query_eval;
+
+struct topk_test {
+ public:
+  /**
+   * Makes an sframe with columns "a", "b" and "id": a and b are in a small
+   * range, with a few missing values in a.
+   */
+  sframe make_sframe(size_t num_rows, size_t num_segments = 4) {
+    sframe sf;
+    sf.open_for_write({"a", "b", "id"},
+                      {flex_type_enum::INTEGER, flex_type_enum::INTEGER,
+                       flex_type_enum::INTEGER},
+                      "", num_segments);
+    for (size_t seg = 0; seg < num_segments; ++seg) {
+      auto it = sf.get_output_iterator(seg);
+      for (size_t i = num_rows * seg / num_segments;
+           i < num_rows * (seg + 1) / num_segments; ++i) {
+        flexible_type a = (i * 7919) % 97;
+        if (i % 31 == 0) a = FLEX_UNDEFINED;
+        *it = std::vector<flexible_type>{a, (i * 104729) % 13, i};
+        ++it;
+      }
+    }
+    sf.close();
+    return sf;
+  }
+
+  /// The sort keys of the rows of an sframe
+  std::vector<std::vector<flexible_type>> keys(const sframe& sf,
+                                               const std::vector<size_t>& columns) {
+    std::vector<std::vector<flexible_type>> rows, ret;
+    sf.get_reader()->read_rows(0, sf.num_rows(), rows);
+    for (const auto& row: rows) {
+      std::vector<flexible_type> key;
+      for (size_t c: columns) key.push_back(row[c]);
+      ret.push_back(key);
+    }
+    return ret;
+  }
+
+  void check(const sframe& sf,
+             const std::vector<size_t>& columns,
+             const std::vector<bool>& orders,
+             size_t k) {
+    auto source = op_sframe_source::make_planner_node(sf);
+    auto top = topk(source, sf.column_names(), columns, orders, k);
+    auto sorted = ec_sort(source, sf.column_names(), columns, orders);
+    TS_ASSERT_EQUALS(top->column_names(), sf.column_names());
+    TS_ASSERT_EQUALS(top->num_rows(), std::min(k, sf.num_rows()));
+    auto top_keys = keys(*top, columns);
+    auto sorted_keys = keys(*sorted, columns);
+    sorted_keys.resize(top_keys.size());
+    TS_ASSERT(top_keys == sorted_keys);
+  }
+
+  void test_topk() {
+    sframe sf = make_sframe(10000);
+    for (size_t k: {0, 1, 5, 100, 2000}) {
+      check(sf, {0}, {true}, k);
+      check(sf, {0}, {false}, k);
+      check(sf, {1, 0}, {false, true}, k);
+    }
+  }
+
+  void test_large_k() {
+    sframe sf = make_sframe(1000);
+    check(sf, {0, 2}, {true, false}, 1000);
+    check(sf, {0, 2}, {true, false}, 5000);
+
+    // falls back to a sort
+    size_t old_max_cells = SFRAME_TOPK_MAX_NUM_CELLS;
+    SFRAME_TOPK_MAX_NUM_CELLS = 10;
+    check(sf, {1}, {true}, 50);
+    SFRAME_TOPK_MAX_NUM_CELLS = old_max_cells;
+  }
+
+  void test_operator() {
+    // each segment outputs its own top k, in order
+    sframe sf = make_sframe(1000);
+    auto node = op_topk::make_planner_node(op_sframe_source::make_planner_node(sf),
+                                           {2}, {false}, 10);
+    sframe res = planner().materialize(node);
+    TS_ASSERT_LESS_THAN_EQUALS(10, res.num_rows());
+    std::vector<std::vector<flexible_type>> rows;
+    res.get_reader()->read_rows(0, res.num_rows(), rows);
+    bool found_last = false;
+    for (const auto& row: rows) found_last |= (row[2] == 999);
+    TS_ASSERT(found_last);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_topk_test, topk_test)
+BOOST_AUTO_TEST_CASE(test_topk) {
+  topk_test::test_topk();
+}
+BOOST_AUTO_TEST_CASE(test_large_k) {
+  topk_test::test_large_k();
+}
+BOOST_AUTO_TEST_CASE(test_operator) {
+  topk_test::test_operator();
+}
+BOOST_AUTO_TEST_SUITE_END()
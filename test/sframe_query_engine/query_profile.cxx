@@ -0,0 +1,135 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <core/storage/query_engine/planning/planner.hpp>
+#include <core/storage/query_engine/execution/query_profile.hpp>
+#include <core/storage/query_engine/operators/all_operators.hpp>
+#include <core/storage/sframe_data/sarray.hpp>
+#include <core/storage/sframe_data/algorithm.hpp>
+#include <core/storage/sframe_data/sarray_v2_block_manager.hpp>
+
+using namespace turi;
+using namespace turi::query_eval;
+
+static const size_t TEST_LENGTH = 10000;
+
+struct query_profile_test {
+ public:
+  std::shared_ptr<sarray<flexible_type>> make_sequence() {
+    std::vector<flexible_type> data;
+    for (size_t i = 0;i < TEST_LENGTH; ++i) data.push_back(i);
+    auto sa = std::make_shared<sarray<flexible_type>>();
+    sa->open_for_write();
+    sa->set_type(flex_type_enum::INTEGER);
+    turi::copy(data.begin(), data.end(), *sa);
+    sa->close();
+    return sa;
+  }
+
+  const operator_profile* find_operator(const query_profile::stage& s,
+                                        const std::string& name) {
+    for (const auto& op: s.operators) {
+      if (op.name == name) return &op;
+    }
+    return nullptr;
+  }
+
+  void test_filter_profile() {
+    auto source = op_sarray_source::make_planner_node(make_sequence());
+    auto even = op_transform::make_planner_node(
+        source,
+        [](const sframe_rows::row& row)->flexible_type {
+          return (flex_int)(row[0]) % 2 == 0;
+        },
+        flex_type_enum::INTEGER);
+    auto evens = op_logical_filter::make_planner_node(source, even);
+
+    materialize_options exec_params;
+    exec_params.profile = std::make_shared<query_profile>();
+    auto res = planner().materialize(evens, exec_params);
+    TS_ASSERT_EQUALS(res.size(), TEST_LENGTH / 2);
+
+    auto stages = exec_params.profile->stages();
+    TS_ASSERT_EQUALS(stages.size(), 1);
+    const auto& s = stages[0];
+    TS_ASSERT_LESS_THAN_EQUALS(1, s.num_runs);
+    TS_ASSERT_EQUALS(s.operators[0].name, "logical_filter");
+    TS_ASSERT_EQUALS(s.operators[0].inputs.size(), 2);
+    TS_ASSERT_EQUALS(s.operators[0].rows_in, 2 * TEST_LENGTH);
+    TS_ASSERT_EQUALS(s.operators[0].rows_out, TEST_LENGTH / 2);
+
+    // the source is shared by the filter and the transform
+    const operator_profile* src = find_operator(s, "sarray_source");
+    TS_ASSERT(src != nullptr);
+    TS_ASSERT_EQUALS(src->rows_in, 0);
+    TS_ASSERT_EQUALS(src->rows_out, TEST_LENGTH);
+    TS_ASSERT_LESS_THAN(0, src->self.bytes_read);
+    TS_ASSERT_EQUALS(s.operators[0].self.bytes_read, 0);
+    TS_ASSERT_LESS_THAN(0, src->self.io.blocks_read);
+    TS_ASSERT_EQUALS(src->self.io.bytes_read, src->self.bytes_read);
+    TS_ASSERT_EQUALS(s.operators[0].self.io.blocks_read, 0);
+
+    const operator_profile* transform = find_operator(s, "transform");
+    TS_ASSERT(transform != nullptr);
+    TS_ASSERT_EQUALS(transform->rows_in, TEST_LENGTH);
+    TS_ASSERT_EQUALS(transform->rows_out, TEST_LENGTH);
+    TS_ASSERT_LESS_THAN_EQUALS(0, transform->self.wall_time);
+    TS_ASSERT_LESS_THAN_EQUALS(0, transform->self.cpu_time);
+
+    std::string printed = exec_params.profile->to_string();
+    TS_ASSERT(printed.find("Stage 1") != std::string::npos);
+    TS_ASSERT(printed.find("logical_filter") != std::string::npos);
+    TS_ASSERT(printed.find("(see above)") != std::string::npos);
+    TS_ASSERT(printed.find("sequentiality") != std::string::npos);
+    TS_ASSERT_EQUALS(exec_params.profile->io_stats().blocks_read,
+                     src->self.io.blocks_read);
+
+    flexible_type as_list = exec_params.profile->to_flexible_type();
+    TS_ASSERT_EQUALS(as_list.size(), 1);
+  }
+
+  void test_block_io_stats() {
+    auto sa = make_sequence();
+    auto& manager = v2_block_impl::block_manager::get_instance();
+    auto before = manager.thread_io_stats();
+    std::vector<flexible_type> rows;
+    sa->get_reader()->read_rows(0, TEST_LENGTH, rows);
+    auto first = manager.thread_io_stats() - before;
+    TS_ASSERT_LESS_THAN(0, first.blocks_read);
+    TS_ASSERT_EQUALS(first.blocks_reread, 0);
+    TS_ASSERT_EQUALS(first.sequentiality(), 1);
+    TS_ASSERT_LESS_THAN(0, first.bytes_read);
+
+    // a second scan goes back to the file for every block
+    sa->get_reader()->read_rows(0, TEST_LENGTH, rows);
+    auto second = manager.thread_io_stats() - before - first;
+    TS_ASSERT_EQUALS(second.blocks_read, first.blocks_read);
+    TS_ASSERT_EQUALS(second.blocks_reread, second.blocks_read);
+
+    auto columns = manager.get_io_stats();
+    TS_ASSERT(!columns.empty());
+    manager.reset_io_stats();
+    TS_ASSERT(manager.get_io_stats().empty());
+  }
+
+  void test_materialized_source() {
+    // nothing is left to execute on a source
+    auto source = op_sarray_source::make_planner_node(make_sequence());
+    materialize_options exec_params;
+    exec_params.profile = std::make_shared<query_profile>();
+    planner().materialize(source, exec_params);
+    TS_ASSERT_EQUALS(exec_params.profile->to_string(), "Nothing was executed\n");
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_query_profile_test, query_profile_test)
+BOOST_AUTO_TEST_CASE(test_filter_profile) {
+  query_profile_test::test_filter_profile();
+}
+BOOST_AUTO_TEST_CASE(test_block_io_stats) {
+  query_profile_test::test_block_io_stats();
+}
+BOOST_AUTO_TEST_CASE(test_materialized_source) {
+  query_profile_test::test_materialized_source();
+}
+BOOST_AUTO_TEST_SUITE_END()
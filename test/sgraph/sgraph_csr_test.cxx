@@ -0,0 +1,176 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <core/storage/sgraph_data/sgraph.hpp>
+#include <core/storage/sgraph_data/sgraph_csr.hpp>
+#include <core/storage/sgraph_data/sgraph_frontier.hpp>
+#include <core/storage/sgraph_data/sgraph_constants.hpp>
+#include <core/storage/sgraph_data/sorted_intersection.hpp>
+#include <set>
+#include <random>
+
+#include "sgraph_test_util.hpp"
+
+using namespace turi;
+using sgraph_compute::csr_snapshot;
+using sgraph_compute::csr_direction;
+
+struct sgraph_csr_test  {
+
+public:
+
+/**
+ * The original vertex ids of the graph, indexed by csr vertex id
+ */
+std::vector<flex_int> original_ids(sgraph& g, const csr_snapshot& csr) {
+  auto vdata = g.fetch_vertex_data_field_in_memory("__id");
+  std::vector<flex_int> ret(csr.num_vertices());
+  for (size_t p = 0; p < vdata.size(); ++p) {
+    for (size_t i = 0; i < vdata[p].size(); ++i) {
+      ret[csr.vertex_id(p, i)] = vdata[p][i];
+      auto addr = csr.address(csr.vertex_id(p, i));
+      TS_ASSERT_EQUALS(addr.partition_id, p);
+      TS_ASSERT_EQUALS(addr.local_id, i);
+    }
+  }
+  return ret;
+}
+
+void test_ring_graph() {
+  size_t n_vertex = 20;
+  sgraph g = create_ring_graph(n_vertex, 4, true /* both directions */);
+  csr_snapshot csr(g);
+  TS_ASSERT_EQUALS(csr.num_vertices(), n_vertex);
+  TS_ASSERT_EQUALS(csr.num_edges(), 2 * n_vertex);
+  TS_ASSERT(csr.has_in_edges());
+  TS_ASSERT(csr.has_out_edges());
+  TS_ASSERT(!csr.has_weights());
+
+  auto ids = original_ids(g, csr);
+  for (size_t v = 0; v < n_vertex; ++v) {
+    TS_ASSERT_EQUALS(csr.out_degree(v), 2);
+    TS_ASSERT_EQUALS(csr.in_degree(v), 2);
+    TS_ASSERT(std::is_sorted(csr.out_begin(v), csr.out_end(v)));
+    std::set<flex_int> neighbors;
+    for (auto u = csr.out_begin(v); u != csr.out_end(v); ++u) neighbors.insert(ids[*u]);
+    flex_int id = ids[v];
+    TS_ASSERT(neighbors == std::set<flex_int>({(id + 1) % (flex_int)n_vertex,
+                                                (id + (flex_int)n_vertex - 1) % (flex_int)n_vertex}));
+    TS_ASSERT(std::equal(csr.out_begin(v), csr.out_end(v), csr.in_begin(v)));
+  }
+}
+
+void test_weighted_in_edges() {
+  size_t n_vertex = 50;
+  std::vector<flexible_type> sources, targets, weights;
+  for (size_t i = 0; i < n_vertex; ++i) {
+    sources.push_back(i);
+    targets.push_back((i + 1) % n_vertex);
+    weights.push_back(0.5 * i);
+  }
+  sgraph g(4);
+  g.add_edges(create_sframe({{"source", flex_type_enum::INTEGER, sources},
+                             {"target", flex_type_enum::INTEGER, targets},
+                             {"weight", flex_type_enum::FLOAT, weights}}),
+              "source", "target");
+
+  TS_ASSERT(csr_snapshot::fits_in_memory(g, csr_direction::IN, true));
+  csr_snapshot csr(g, csr_direction::IN, "weight");
+  TS_ASSERT(csr.has_in_edges());
+  TS_ASSERT(!csr.has_out_edges());
+  TS_ASSERT(csr.has_weights());
+  auto ids = original_ids(g, csr);
+  for (size_t v = 0; v < n_vertex; ++v) {
+    TS_ASSERT_EQUALS(csr.out_degree(v), 1);
+    TS_ASSERT_EQUALS(csr.in_degree(v), 1);
+    flex_int source = ids[*csr.in_begin(v)];
+    TS_ASSERT_EQUALS((source + 1) % (flex_int)n_vertex, ids[v]);
+    TS_ASSERT_EQUALS(csr.in_weights(v)[0], 0.5 * source);
+  }
+  TS_ASSERT_THROWS_ANYTHING(csr_snapshot(g, csr_direction::IN, "nonexistent"));
+
+  size_t old_max_memory = SGRAPH_CSR_SNAPSHOT_MAX_MEMORY;
+  SGRAPH_CSR_SNAPSHOT_MAX_MEMORY = 16;
+  TS_ASSERT(!csr_snapshot::fits_in_memory(g));
+  SGRAPH_CSR_SNAPSHOT_MAX_MEMORY = old_max_memory;
+}
+
+void test_frontier() {
+  size_t n_vertex = 1000;
+  sgraph g = create_ring_graph(n_vertex, 4, false /* one direction */);
+  csr_snapshot csr(g);
+  auto ids = original_ids(g, csr);
+  std::vector<size_t> vid_of(n_vertex);
+  for (size_t v = 0; v < n_vertex; ++v) vid_of[ids[v]] = v;
+
+  sgraph_compute::vertex_frontier changed(n_vertex), next(n_vertex);
+  TS_ASSERT(changed.empty());
+  changed.activate(vid_of[10]);
+  changed.activate(vid_of[999]);
+  TS_ASSERT_EQUALS(changed.size(), 2);
+  size_t old_ratio = SGRAPH_FRONTIER_PULL_RATIO;
+  // a huge ratio always pushes, a ratio of 1 pulls unless nothing changed
+  for (size_t ratio : {size_t(1000000), size_t(1)}) {
+    SGRAPH_FRONTIER_PULL_RATIO = ratio;
+    sgraph_compute::expand_frontier(csr, changed, next);
+    TS_ASSERT_EQUALS(next.size(), 2);
+    TS_ASSERT(next.is_active(vid_of[11]));
+    TS_ASSERT(next.is_active(vid_of[0]));
+
+    sgraph_compute::expand_frontier(csr, changed, next, true /* undirected */);
+    TS_ASSERT_EQUALS(next.size(), 4);
+    TS_ASSERT(next.is_active(vid_of[9]));
+    TS_ASSERT(next.is_active(vid_of[998]));
+  }
+  SGRAPH_FRONTIER_PULL_RATIO = old_ratio;
+
+  changed.activate_all();
+  TS_ASSERT_EQUALS(changed.size(), n_vertex);
+  size_t degree_sum = changed.parallel_sum([&](size_t v) { return csr.out_degree(v); });
+  TS_ASSERT_EQUALS(degree_sum, n_vertex);
+  changed.clear();
+  sgraph_compute::expand_frontier(csr, changed, next);
+  TS_ASSERT(next.empty());
+}
+
+void test_sorted_intersection() {
+  std::mt19937 rng(0);
+  for (size_t trial = 0; trial < 1000; ++trial) {
+    // every third pair is lopsided enough to gallop
+    size_t na = rng() % 100;
+    size_t nb = (trial % 3 == 0) ? rng() % 10000 : rng() % 100;
+    uint32_t range = 1 + rng() % 2000;
+    std::set<uint32_t> sa, sb;
+    for (size_t i = 0; i < na; ++i) sa.insert(rng() % range);
+    for (size_t i = 0; i < nb; ++i) sb.insert(rng() % range);
+    std::vector<uint32_t> a(sa.begin(), sa.end()), b(sb.begin(), sb.end());
+    std::vector<uint32_t> expected;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                          std::back_inserter(expected));
+
+    std::vector<uint32_t> out(std::min(a.size(), b.size()));
+    size_t n = sgraph_compute::intersect_sorted(a.data(), a.size(), b.data(), b.size(), out.data());
+    TS_ASSERT(std::vector<uint32_t>(out.begin(), out.begin() + n) == expected);
+    n = sgraph_compute::intersect_sorted_scalar(a.data(), a.size(), b.data(), b.size(), out.data());
+    TS_ASSERT(std::vector<uint32_t>(out.begin(), out.begin() + n) == expected);
+  }
+  std::string impl = sgraph_compute::intersect_sorted_implementation();
+  TS_ASSERT(impl == "avx2" || impl == "scalar");
+}
+
+};
+
+BOOST_FIXTURE_TEST_SUITE(_sgraph_csr_test, sgraph_csr_test)
+BOOST_AUTO_TEST_CASE(test_ring_graph) {
+  sgraph_csr_test::test_ring_graph();
+}
+BOOST_AUTO_TEST_CASE(test_weighted_in_edges) {
+  sgraph_csr_test::test_weighted_in_edges();
+}
+BOOST_AUTO_TEST_CASE(test_frontier) {
+  sgraph_csr_test::test_frontier();
+}
+BOOST_AUTO_TEST_CASE(test_sorted_intersection) {
+  sgraph_csr_test::test_sorted_intersection();
+}
+BOOST_AUTO_TEST_SUITE_END()
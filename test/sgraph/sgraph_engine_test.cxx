@@ -3,6 +3,7 @@
 #include <core/util/test_macros.hpp>
 #include <core/storage/sgraph_data/sgraph.hpp>
 #include <core/storage/sgraph_data/sgraph_engine.hpp>
+#include <core/storage/sgraph_data/sgraph_constants.hpp>
 
 #include "sgraph_test_util.hpp"
 #include "sgraph_check_degree_count.hpp"
@@ -104,6 +105,16 @@ public:
    check_pagerank(pagerank_fn);
  }
 
+ void test_bounded_cache() {
+   // a pass can only hold a couple of blocks, so vertex data is reloaded
+   // and partial combine results are spilled between passes
+   size_t old_max_blocks = SGRAPH_ENGINE_MAX_RESIDENT_BLOCKS;
+   SGRAPH_ENGINE_MAX_RESIDENT_BLOCKS = 3;
+   check_degree_count(degree_count_fn);
+   check_pagerank(pagerank_fn);
+   SGRAPH_ENGINE_MAX_RESIDENT_BLOCKS = old_max_blocks;
+ }
+
 };
 
 BOOST_FIXTURE_TEST_SUITE(_sgraph_engine_test, sgraph_engine_test)
@@ -113,4 +124,7 @@ BOOST_AUTO_TEST_CASE(test_degree_count) {
 BOOST_AUTO_TEST_CASE(test_pagerank) {
   sgraph_engine_test::test_pagerank();
 }
+BOOST_AUTO_TEST_CASE(test_bounded_cache) {
+  sgraph_engine_test::test_bounded_cache();
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -2,7 +2,11 @@
 #include <boost/test/unit_test.hpp>
 #include <core/util/test_macros.hpp>
 #include <core/storage/sgraph_data/sgraph.hpp>
+#include <core/storage/sgraph_data/sgraph_delta.hpp>
+#include <core/storage/sgraph_data/sgraph_partition.hpp>
+#include <core/parallel/mutex.hpp>
 #include <core/storage/sframe_data/algorithm.hpp>
+#include <set>
 #include "sgraph_test_util.hpp"
 
 using namespace turi;
@@ -289,6 +293,103 @@ struct sgraph_test  {
     assert_vector_equals(expected_vfield_types, g.get_vertex_field_types());
     assert_vector_equals(expected_efield_types, g.get_edge_field_types());
   }
+
+  void test_incremental_edges() {
+    size_t n_vertex = 20;
+    sgraph g = create_ring_graph(n_vertex, 4);
+    auto old_vids = g.fetch_vertex_data_field_in_memory(sgraph::VID_COLUMN_NAME);
+    auto since = g.get_delta_watermark();
+
+    // 5 edges between existing vertices, 5 from new vertices
+    std::vector<flexible_type> sources, targets;
+    for (size_t i = 0; i < 5; ++i) {
+      sources.push_back(i);
+      targets.push_back(i + 5);
+      sources.push_back(100 + i);
+      targets.push_back(i);
+    }
+    g.add_edges(create_sframe({{"source", flex_type_enum::INTEGER, sources},
+                               {"target", flex_type_enum::INTEGER, targets}}),
+                "source", "target");
+    TS_ASSERT_EQUALS(g.num_vertices(), n_vertex + 5);
+    TS_ASSERT_EQUALS(g.num_edges(), n_vertex + 10);
+    TS_ASSERT_EQUALS(sgraph_compute::num_edges_since(g, since), 10);
+
+    // existing vertices keep their rows
+    auto vids = g.fetch_vertex_data_field_in_memory(sgraph::VID_COLUMN_NAME);
+    for (size_t p = 0; p < vids.size(); ++p) {
+      TS_ASSERT(std::equal(old_vids[p].begin(), old_vids[p].end(), vids[p].begin()));
+    }
+
+    auto new_edges = [&]() {
+      std::set<std::pair<flex_int, flex_int>> ret;
+      turi::mutex lock;
+      sgraph_compute::delta_edge_apply(g, since,
+          [&](const sgraph_compute::vertex_address& src,
+              const sgraph_compute::vertex_address& dst) {
+            std::lock_guard<turi::mutex> guard(lock);
+            ret.insert({vids[src.partition_id][src.local_id],
+                        vids[dst.partition_id][dst.local_id]});
+          });
+      return ret;
+    };
+    auto edges = new_edges();
+    TS_ASSERT_EQUALS(edges.size(), 10);
+    for (flex_int i = 0; i < 5; ++i) {
+      TS_ASSERT(edges.count({i, i + 5}));
+      TS_ASSERT(edges.count({100 + i, i}));
+    }
+
+    // compaction keeps the watermark valid
+    g.compact(1);
+    for (size_t i = 0; i < g.get_num_partitions(); ++i) {
+      for (size_t j = 0; j < g.get_num_partitions(); ++j) {
+        TS_ASSERT_LESS_THAN_EQUALS(g.edge_partition(i, j).select_column(0)->num_segments(), 1);
+      }
+    }
+    TS_ASSERT(new_edges() == edges);
+    TS_ASSERT(g.get_delta_watermark().edge_partition_sizes != since.edge_partition_sizes);
+
+    sgraph smaller = create_ring_graph(n_vertex, 4);
+    TS_ASSERT_THROWS_ANYTHING(smaller.validate_delta_watermark(g.get_delta_watermark()));
+    sgraph other_partitions = create_ring_graph(n_vertex, 8);
+    TS_ASSERT_THROWS_ANYTHING(other_partitions.validate_delta_watermark(since));
+  }
+
+  void test_partition_stats() {
+    size_t n_vertex = 100;
+    sgraph g = create_ring_graph(n_vertex, 8);
+    auto stats = sgraph_compute::compute_partition_stats(g);
+    TS_ASSERT_EQUALS(stats.num_partitions, 8);
+    TS_ASSERT_EQUALS(stats.edge_partition_sizes.size(), 64);
+    TS_ASSERT_LESS_THAN_EQUALS(1.0, stats.vertex_balance);
+    TS_ASSERT_LESS_THAN_EQUALS(1.0, stats.edge_balance);
+    // every vertex has one out edge and one in edge, in at most 2 partitions
+    TS_ASSERT_LESS_THAN_EQUALS(1.0, stats.replication_factor);
+    TS_ASSERT_LESS_THAN_EQUALS(stats.replication_factor, 2.0);
+    TS_ASSERT_LESS_THAN_EQUALS(n_vertex, stats.vertex_rows_loaded_per_pass);
+
+    // one batch loads every partition once; one edge partition at a time
+    // loads at least as much
+    std::vector<size_t> sizes(4, 10);
+    TS_ASSERT_EQUALS(sgraph_compute::estimate_vertex_rows_loaded(sizes, 16), 40);
+    TS_ASSERT_LESS_THAN_EQUALS(40, sgraph_compute::estimate_vertex_rows_loaded(sizes, 1));
+
+    size_t suggested = sgraph_compute::suggest_num_partitions(g);
+    TS_ASSERT_LESS_THAN_EQUALS(2, suggested);
+    sgraph h = sgraph_compute::repartition(g, 2);
+    TS_ASSERT_EQUALS(h.get_num_partitions(), 2);
+    TS_ASSERT_EQUALS(h.num_vertices(), g.num_vertices());
+    TS_ASSERT_EQUALS(h.num_edges(), g.num_edges());
+    TS_ASSERT(h.get_vertex_fields() == g.get_vertex_fields());
+    size_t old_num_threads = SGRAPH_HILBERT_CURVE_PARALLEL_FOR_NUM_THREADS;
+    SGRAPH_HILBERT_CURVE_PARALLEL_FOR_NUM_THREADS = 4;
+    auto h_stats = sgraph_compute::compute_partition_stats(h);
+    TS_ASSERT_EQUALS(h_stats.vertex_rows_loaded_per_pass, n_vertex);
+    TS_ASSERT_EQUALS(h_stats.vertex_load_factor, 1.0);
+    SGRAPH_HILBERT_CURVE_PARALLEL_FOR_NUM_THREADS = old_num_threads;
+    TS_ASSERT_THROWS_ANYTHING(sgraph_compute::repartition(g, 3));
+  }
 };
 
 BOOST_FIXTURE_TEST_SUITE(_sgraph_test, sgraph_test)
@@ -313,4 +414,10 @@ BOOST_AUTO_TEST_CASE(test_star_graph) {
 BOOST_AUTO_TEST_CASE(test_graph_field_query) {
   sgraph_test::test_graph_field_query();
 }
+BOOST_AUTO_TEST_CASE(test_incremental_edges) {
+  sgraph_test::test_incremental_edges();
+}
+BOOST_AUTO_TEST_CASE(test_partition_stats) {
+  sgraph_test::test_partition_stats();
+}
 BOOST_AUTO_TEST_SUITE_END()
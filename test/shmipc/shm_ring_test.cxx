@@ -0,0 +1,129 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <shmipc/shm_ring.hpp>
+#include <core/parallel/pthread_tools.hpp>
+using namespace turi;
+// small rings, so that messages wrap around and large ones spill
+const size_t RING_SIZE = 1024;
+struct shm_ring_test {
+ public:
+  shmipc::ring_channel server;
+  shmipc::ring_channel client;
+
+  void server_process() {
+    auto ret = server.wait_for_connect(60);
+    TS_ASSERT(ret);
+    // echoes every message back
+    while(1) {
+      const char* c = nullptr;
+      size_t len = 0;
+      if (!server.receive(&c, &len, 10)) {
+        TS_FAIL("Ring server timeout waiting for client");
+        break;
+      }
+      if (len == 3 && strncmp(c, "end", 3) == 0) {
+        server.release_received();
+        break;
+      }
+      std::string message(c, len);
+      server.release_received();
+      TS_ASSERT(server.send(message.c_str(), message.length(), 10));
+    }
+  }
+
+  void client_process(const std::string& address) {
+    auto ret = client.connect(address, 60);
+    TS_ASSERT(ret);
+    std::vector<std::string> messages;
+    // odd lengths around the ring size, and a few which spill
+    for (size_t i = 0; i < 200; ++i) messages.push_back(std::string(i * 7 % 301, 'a' + i % 26));
+    for (size_t len : {1000, 5000, 100000, 3000}) messages.push_back(std::string(len, 'x'));
+    messages.push_back("");
+    for (auto& message: messages) {
+      TS_ASSERT(client.send(message.c_str(), message.length(), 10));
+      const char* c = nullptr;
+      size_t len = 0;
+      TS_ASSERT(client.receive(&c, &len, 10));
+      TS_ASSERT_EQUALS(std::string(c, len), message);
+      client.release_received();
+    }
+    client.send("end", 3);
+  }
+
+  void test_echo() {
+    TS_ASSERT(server.bind("", RING_SIZE));
+    std::string address = server.get_shared_memory_name();
+    thread_group group;
+    group.launch([=](){ this->server_process(); });
+    group.launch([=](){ this->client_process(address); });
+    group.join();
+  }
+
+  void test_shutdown() {
+    shmipc::ring_channel s, c;
+    TS_ASSERT(s.bind("", RING_SIZE));
+    std::string address = s.get_shared_memory_name();
+    thread_group group;
+    group.launch([&](){ TS_ASSERT(s.wait_for_connect(60)); });
+    TS_ASSERT(c.connect(address, 60));
+    group.join();
+    TS_ASSERT(c.is_connected());
+    s.shutdown();
+    const char* buf = nullptr;
+    size_t len = 0;
+    TS_ASSERT(!c.receive(&buf, &len, 1));
+    TS_ASSERT(!c.is_connected());
+  }
+
+  void test_blocking_wait() {
+    shmipc::ring_channel s, c;
+    TS_ASSERT(s.bind("", RING_SIZE));
+    std::string address = s.get_shared_memory_name();
+    thread_group group;
+    group.launch([&](){ TS_ASSERT(s.wait_for_connect(60)); });
+    TS_ASSERT(c.connect(address, 60));
+    group.join();
+
+    const char* buf = nullptr;
+    size_t len = 0;
+    // an empty ring times out
+    auto start = std::chrono::steady_clock::now();
+    TS_ASSERT(!c.receive(&buf, &len, 1));
+    TS_ASSERT(std::chrono::steady_clock::now() - start >= std::chrono::seconds(1));
+    TS_ASSERT(c.is_connected());
+
+    // a receive without timeout blocks until a message arrives
+    group.launch([&](){
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      TS_ASSERT(s.send("hello", 5, 10));
+    });
+    TS_ASSERT(c.receive(&buf, &len));
+    TS_ASSERT_EQUALS(std::string(buf, len), "hello");
+    c.release_received();
+    group.join();
+
+    // and until the channel is shut down
+    group.launch([&](){
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      c.shutdown();
+    });
+    TS_ASSERT(!s.receive(&buf, &len));
+    group.join();
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_shm_ring_test, shm_ring_test)
+BOOST_AUTO_TEST_CASE(test_echo) {
+  shm_ring_test::test_echo();
+}
+BOOST_AUTO_TEST_CASE(test_shutdown) {
+  shm_ring_test::test_shutdown();
+}
+BOOST_AUTO_TEST_CASE(test_blocking_wait) {
+  shm_ring_test::test_blocking_wait();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,9 +1,12 @@
 #define BOOST_TEST_MODULE
 #include <boost/test/unit_test.hpp>
 #include <core/util/test_macros.hpp>
+#include <cmath>
+#include <sstream>
 #include <string>
 #include <iostream>
 #include <ml/sketches/hyperloglog.hpp>
+#include <core/storage/serialization/serialization_includes.hpp>
 #include <core/random/random.hpp>
 struct hyperloglog_test {
   void random_integer_length_test(size_t len, 
@@ -62,6 +65,70 @@ struct hyperloglog_test {
     TS_ASSERT_EQUALS(hll.estimate(), sequential_hll.estimate());
   }
  public:
+  void test_sparse_to_dense() {
+    using turi::sketches::hyperloglog;
+    hyperloglog hll(12);
+    // Small cardinalities stay sparse and are nearly exact.
+    for (size_t i = 0; i < 100; ++i) hll.add(i);
+    TS_ASSERT(hll.is_sparse());
+    TS_ASSERT_LESS_THAN(std::abs(hll.estimate() - 100), 1);
+
+    for (size_t i = 0; i < 100000; ++i) hll.add(i);
+    TS_ASSERT(!hll.is_sparse());
+    TS_ASSERT_LESS_THAN(std::abs(hll.estimate() - 100000), 2 * hll.error_bound());
+  }
+
+  void test_combine_sparse_and_dense() {
+    using turi::sketches::hyperloglog;
+    hyperloglog small(12), large(12), sequential(12);
+    for (size_t i = 0; i < 50; ++i) {
+      small.add(i);
+      sequential.add(i);
+    }
+    for (size_t i = 25; i < 50000; ++i) {
+      large.add(i);
+      sequential.add(i);
+    }
+    TS_ASSERT(small.is_sparse());
+    TS_ASSERT(!large.is_sparse());
+
+    hyperloglog a = small;
+    a.combine(large);
+    hyperloglog b = large;
+    b.combine(small);
+    TS_ASSERT_EQUALS(a.estimate(), sequential.estimate());
+    TS_ASSERT_EQUALS(b.estimate(), sequential.estimate());
+  }
+
+  void test_flexible_type_and_strings() {
+    using turi::sketches::hyperloglog;
+    hyperloglog hll(12);
+    for (size_t i = 0; i < 3; ++i) {
+      hll.add(turi::flexible_type("a"));
+      hll.add(turi::flexible_type(1));
+      hll.add(turi::flexible_type(1.5));
+      hll.add(std::string("b"));
+    }
+    TS_ASSERT_LESS_THAN(std::abs(hll.estimate() - 4), 0.01);
+  }
+
+  void test_save_load() {
+    using turi::sketches::hyperloglog;
+    for (size_t n : {10, 100000}) {
+      hyperloglog hll(12);
+      for (size_t i = 0; i < n; ++i) hll.add(i);
+
+      std::stringstream stream;
+      turi::oarchive oarc(stream);
+      oarc << hll;
+      hyperloglog loaded;
+      turi::iarchive iarc(stream);
+      iarc >> loaded;
+      TS_ASSERT_EQUALS(loaded.is_sparse(), hll.is_sparse());
+      TS_ASSERT_EQUALS(loaded.estimate(), hll.estimate());
+    }
+  }
+
   void test_stuff() {
     turi::random::seed(1001);
     std::vector<size_t> lens{1024, 65536, 1024*1024};
@@ -94,6 +161,18 @@ struct hyperloglog_test {
 };
 
 BOOST_FIXTURE_TEST_SUITE(_hyperloglog_test, hyperloglog_test)
+BOOST_AUTO_TEST_CASE(test_sparse_to_dense) {
+  hyperloglog_test::test_sparse_to_dense();
+}
+BOOST_AUTO_TEST_CASE(test_combine_sparse_and_dense) {
+  hyperloglog_test::test_combine_sparse_and_dense();
+}
+BOOST_AUTO_TEST_CASE(test_flexible_type_and_strings) {
+  hyperloglog_test::test_flexible_type_and_strings();
+}
+BOOST_AUTO_TEST_CASE(test_save_load) {
+  hyperloglog_test::test_save_load();
+}
 BOOST_AUTO_TEST_CASE(test_stuff) {
   hyperloglog_test::test_stuff();
 }
@@ -4,6 +4,7 @@
 #include <string>
 #include <iostream>
 #include <set>
+#include <sstream>
 #include <unordered_map>
 #include <core/data/flexible_type/flexible_type.hpp>
 #include <ml/sketches/space_saving_flextype.hpp>
@@ -106,6 +107,29 @@ struct space_saving_test {
     std::cout << "\n Time: " << ti.current_time() << "\n";
   }
   
+  void test_save_load() {
+    space_saving_flextype ss(0.01);
+    for (size_t i = 0; i < 10000; ++i) {
+      ss.add(flex_int(i % 7 == 0 ? 0 : i));
+      ss.add(flexible_type(i % 5 == 0 ? "a" : "b"));
+    }
+    auto items = ss.frequent_items();
+
+    std::stringstream stream;
+    oarchive oarc(stream);
+    oarc << ss;
+    space_saving_flextype loaded;
+    iarchive iarc(stream);
+    iarc >> loaded;
+
+    auto loaded_items = loaded.frequent_items();
+    std::unordered_map<flexible_type, size_t> expected(items.begin(), items.end());
+    std::unordered_map<flexible_type, size_t> actual(loaded_items.begin(),
+                                                     loaded_items.end());
+    TS_ASSERT(expected == actual);
+    TS_ASSERT_EQUALS(loaded.size(), ss.size());
+  }
+
   void test_stuff() {
     turi::random::seed(1001);
     std::vector<size_t> lens{1024, 65536, 256*1024};
@@ -189,6 +213,9 @@ BOOST_FIXTURE_TEST_SUITE(_space_saving_test, space_saving_test)
 BOOST_AUTO_TEST_CASE(test_perf) {
   space_saving_test::test_perf();
 }
+BOOST_AUTO_TEST_CASE(test_save_load) {
+  space_saving_test::test_save_load();
+}
 BOOST_AUTO_TEST_CASE(test_stuff) {
   space_saving_test::test_stuff();
 }
@@ -187,6 +187,66 @@ struct gl_timeseries_test  {
     }
 
 
+    void test_slice_with_time_index() {
+
+      // Several blocks of the time index, with repeated times.
+      const size_t n = 3 * time_index::BLOCK_SIZE + 100;
+      std::vector<flexible_type> times;
+      std::vector<flexible_type> values;
+      for (size_t i = 0; i < n; ++i) {
+        times.push_back(flex_date_time(1500000000 + i / 3, 0));
+        values.push_back(flex_int(i));
+      }
+      gl_sframe sf;
+      sf["index"] = gl_sarray(times);
+      sf["a"] = gl_sarray(values);
+
+      gl_timeseries ts;
+      ts.init(sf, "index", true);
+      auto index_col = sf["index"];
+
+      std::vector<std::pair<size_t, size_t>> bounds = {
+          {0, 10}, {5, 5}, {1365, 1366}, {4000, 9000}, {0, n}, {n, n + 10},
+          {9000, 4000}};
+      for (const auto& bound : bounds) {
+        flexible_type start = flex_date_time(1500000000 + bound.first, 0);
+        flexible_type end = flex_date_time(1500000000 + bound.second, 0);
+        for (const std::string closed : {"left", "right", "both", "neither"}) {
+          gl_sarray sel1 = (closed == "left" || closed == "both")
+                               ? (index_col >= start) : (index_col > start);
+          gl_sarray sel2 = (closed == "right" || closed == "both")
+                               ? (index_col <= end) : (index_col < end);
+          gl_sframe expected = sf[sel1 && sel2];
+          gl_timeseries out = ts.slice(start, end, closed);
+          _assert_sframe_equals(out.get_sframe(), expected);
+        }
+      }
+    }
+
+    void test_group_by_hash() {
+
+      // Keys interleaved, times decreasing within each key.
+      const size_t n = 5000;
+      std::vector<flexible_type> times, keys;
+      for (size_t i = 0; i < n; ++i) {
+        times.push_back(flex_date_time(1500000000 + n - i, 0));
+        keys.push_back(flex_int(i % 7));
+      }
+      gl_sframe sf;
+      sf["index"] = gl_sarray(times);
+      sf["key"] = gl_sarray(keys);
+
+      gl_grouped_timeseries grouped;
+      grouped.group(sf, "index", {"key"});
+      TS_ASSERT_EQUALS(grouped.num_groups(), 7);
+
+      for (size_t k = 0; k < 7; ++k) {
+        gl_sframe group = grouped.get_group({flex_int(k)});
+        gl_sframe expected = sf[sf["key"] == flex_int(k)].sort("index");
+        _assert_sframe_equals(group, expected);
+      }
+    }
+
     std::vector<flexible_type> _to_vec(gl_sarray sa) {
       std::vector<flexible_type> ret;
       for (auto& v: sa.range_iterator()) { ret.push_back(v); }
@@ -237,4 +297,10 @@ BOOST_AUTO_TEST_CASE(test_resample_corner_cases) {
 BOOST_AUTO_TEST_CASE(test_basic_resample_all_interpolation) {
   gl_timeseries_test::test_basic_resample_all_interpolation();
 }
+BOOST_AUTO_TEST_CASE(test_slice_with_time_index) {
+  gl_timeseries_test::test_slice_with_time_index();
+}
+BOOST_AUTO_TEST_CASE(test_group_by_hash) {
+  gl_timeseries_test::test_group_by_hash();
+}
 BOOST_AUTO_TEST_SUITE_END()
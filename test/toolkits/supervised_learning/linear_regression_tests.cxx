@@ -13,6 +13,7 @@
 #include <ml/optimization/utils.hpp>
 #include <toolkits/supervised_learning/linear_regression.hpp>
 #include <toolkits/supervised_learning/linear_regression_opt_interface.hpp>
+#include <toolkits/supervised_learning/hyperparameter_search.hpp>
 #include <core/storage/sframe_data/testing_utils.hpp>
 
 using namespace turi;
@@ -196,6 +197,97 @@ struct linear_regression_test  {
       {"features", 10}};
     run_linear_regression_test(opts);
   }
+
+  // Updating with new data, including a new category.
+  void test_linear_regression_update() {
+    std::map<std::string, double> category_effect = {
+      {"a", 0}, {"b", 1}, {"z", 3}};
+
+    auto make_data = [&](const std::vector<std::string>& categories,
+                         size_t examples, sframe& X, sframe& y) {
+      std::vector<std::vector<flexible_type>> X_data, y_data;
+      for(size_t i=0; i < examples; i++){
+        double x = double(i % 17) / 17;
+        const std::string& c = categories[i % categories.size()];
+        X_data.push_back({x, c});
+        y_data.push_back({2 * x + category_effect[c] + 0.5});
+      }
+      X = make_testing_sframe({"x", "c"},
+          {flex_type_enum::FLOAT, flex_type_enum::STRING}, X_data);
+      y = make_testing_sframe({"target"}, {flex_type_enum::FLOAT}, y_data);
+    };
+
+    std::map<std::string, flexible_type> options = {
+      {"solver", "newton"},
+      {"l2_penalty", 0.0}};
+
+    sframe X, y, X_new, y_new;
+    make_data({"a", "b"}, 200, X, y);
+    make_data({"a", "b", "z"}, 300, X_new, y_new);
+
+    std::shared_ptr<linear_regression> model;
+    model.reset(new linear_regression);
+    model->init(X, y);
+    model->init_options(options);
+    model->train();
+
+    DenseVector coefs;
+    model->get_coefficients(coefs);
+    TS_ASSERT_EQUALS(coefs.size(), 3);  // x, b, intercept
+
+    model->update(X_new, y_new, {{"max_iterations", 5}});
+
+    DenseVector new_coefs;
+    model->get_coefficients(new_coefs);
+    TS_ASSERT_EQUALS(new_coefs.size(), 4);  // x, b, z, intercept
+    TS_ASSERT_DELTA(new_coefs(0), 2, 1e-3);
+    TS_ASSERT_DELTA(new_coefs(1), 1, 1e-3);
+    TS_ASSERT_DELTA(new_coefs(2), 3, 1e-3);
+    TS_ASSERT_DELTA(new_coefs(3), 0.5, 1e-3);
+    TS_ASSERT(model->get_current_options().at("max_iterations") == 5);
+
+    // The new category is known to predictions.
+    ml_data data = model->construct_ml_data_using_current_metadata(X_new, y_new);
+    std::vector<flexible_type> preds;
+    model->predict(data)->get_reader()->read_rows(0, 3, preds);
+    TS_ASSERT_DELTA(preds[2].to<double>(), 2 * (2.0 / 17) + 3.5, 1e-3);
+  }
+
+  // Tuning the penalty over shared data, with successive halving.
+  void test_linear_regression_tuning() {
+    std::vector<std::vector<flexible_type>> rows;
+    for(size_t i=0; i < 300; i++){
+      double x = double(i % 17) / 17;
+      rows.push_back({x, 2 * x + 0.5});
+    }
+    gl_sframe data(make_testing_sframe({"x", "target"},
+        {flex_type_enum::FLOAT, flex_type_enum::FLOAT}, rows));
+
+    flex_list trial_options = {
+      flex_dict{{"l2_penalty", 100.0}},
+      flex_dict{{"l2_penalty", 0.0}},
+      flex_dict{{"l2_penalty", 10.0}},
+      flex_dict{{"l2_penalty", 1.0}}};
+
+    variant_map_type ret = tune_hyperparameters(
+        "regression_linear_regression", data, "target", to_variant(data),
+        trial_options,
+        {{"solver", "newton"}, {"early_stopping", "successive_halving"}});
+
+    TS_ASSERT_EQUALS(variant_get_value<size_t>(ret.at("best_trial")), 1);
+
+    gl_sframe results = variant_get_value<gl_sframe>(ret.at("results"));
+    TS_ASSERT_EQUALS(results.size(), 4);
+    TS_ASSERT(results["iterations"][1] == 10);  // the full budget
+    TS_ASSERT(results["iterations"][0] == 3);   // cut after a third of it
+    TS_ASSERT_DELTA(results["rmse"][1].to<double>(), 0, 1e-6);
+
+    auto model = variant_get_value<std::shared_ptr<linear_regression>>(ret.at("model"));
+    DenseVector coefs;
+    model->get_coefficients(coefs);
+    TS_ASSERT_DELTA(coefs(0), 2, 1e-3);
+    TS_ASSERT_DELTA(coefs(1), 0.5, 1e-3);
+  }
 };
 
 
@@ -313,6 +405,13 @@ void run_linear_regression_opt_interface_test(std::map<std::string,
     TS_ASSERT(gradient.isApprox(_gradient));
     TS_ASSERT(hessian.isApprox(_hessian));
 
+    // Check the hessian-vector product against the hessian.
+    DenseVector direction(variables);
+    direction.setRandom();
+    DenseVector hv(variables);
+    lr_interface->compute_hessian_vector_product(point, direction, hv);
+    TS_ASSERT(hv.isApprox(hessian * direction, 1e-8));
+
   }
 
   model.reset();
@@ -349,6 +448,12 @@ BOOST_AUTO_TEST_CASE(test_linear_regression_basic_2d) {
 BOOST_AUTO_TEST_CASE(test_linear_regression_small) {
   linear_regression_test::test_linear_regression_small();
 }
+BOOST_AUTO_TEST_CASE(test_linear_regression_update) {
+  linear_regression_test::test_linear_regression_update();
+}
+BOOST_AUTO_TEST_CASE(test_linear_regression_tuning) {
+  linear_regression_test::test_linear_regression_tuning();
+}
 BOOST_AUTO_TEST_SUITE_END()
 BOOST_FIXTURE_TEST_SUITE(_linear_regression_opt_interface_test, linear_regression_opt_interface_test)
 BOOST_AUTO_TEST_CASE(test_linear_regression_opt_interface_basic_2d) {
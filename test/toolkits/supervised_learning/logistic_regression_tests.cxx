@@ -211,6 +211,69 @@ void run_logistic_regression_test(std::map<std::string, flexible_type> opts) {
 /**
  *  Check logistic regression
 */
+/**
+ * Block predictions of a multiclass model match the predictions of each row.
+ */
+void run_logistic_regression_block_predict_test(size_t examples, size_t features) {
+
+  std::vector<std::string> feature_names;
+  std::vector<flex_type_enum> feature_types;
+  for(size_t i=0; i < features; i++){
+    feature_names.push_back(std::to_string(i));
+    feature_types.push_back(flex_type_enum::FLOAT);
+  }
+
+  std::vector<std::vector<flexible_type>> y_data;
+  std::vector<std::vector<flexible_type>> X_data;
+  for(size_t i=0; i < examples; i++){
+    DenseVector x(features);
+    x.setRandom();
+    X_data.push_back(std::vector<flexible_type>(x.data(), x.data() + features));
+    // The class is the largest of the first 3 features.
+    size_t c = 0;
+    for(size_t k=1; k < 3; k++){
+      if (x(k) > x(c)) c = k;
+    }
+    y_data.push_back({std::to_string(c)});
+  }
+
+  sframe X = make_testing_sframe(feature_names, feature_types, X_data);
+  sframe y = make_testing_sframe({"target"}, {flex_type_enum::STRING}, y_data);
+  std::shared_ptr<logistic_regression> model(new logistic_regression);
+  model->init(X,y);
+  model->init_options({{"max_iterations", 5}});
+  model->train();
+
+  ml_data data = model->construct_ml_data_using_current_metadata(X);
+  std::vector<flexible_type> pred_prob, pred_class;
+  model->predict(data, "probability_vector")->get_reader()->read_rows(0, examples, pred_prob);
+  model->predict(data, "class")->get_reader()->read_rows(0, examples, pred_class);
+  auto topk = testing_extract_sframe_data(model->predict_topk(data, "probability", 1));
+  TS_ASSERT_EQUALS(topk.size(), examples);
+
+  for(size_t i=0; i < examples; i++){
+    DenseVector x(features + 1);
+    for(size_t k=0; k < features; k++){
+      x(k) = X_data[i][k];
+    }
+    x(features) = 1;
+    flexible_type expected = model->predict_single_example(
+        x, prediction_type_enum::PROBABILITY_VECTOR);
+    TS_ASSERT_EQUALS(pred_prob[i].size(), 3);
+    double max_prob = 0;
+    for(size_t c=0; c < 3; c++){
+      TS_ASSERT_DELTA(pred_prob[i][c], expected[c], 1e-10);
+      max_prob = std::max<double>(max_prob, expected[c]);
+    }
+    TS_ASSERT_EQUALS(pred_class[i],
+                     model->predict_single_example(x, prediction_type_enum::CLASS));
+
+    TS_ASSERT_EQUALS(topk[i][0], i);
+    TS_ASSERT_EQUALS(topk[i][1], pred_class[i]);
+    TS_ASSERT_DELTA(topk[i][2], max_prob, 1e-10);
+  }
+}
+
 struct logistic_regression_test  {
   public:
 
@@ -228,6 +291,10 @@ struct logistic_regression_test  {
     run_logistic_regression_test(opts);
   }
 
+  void test_logistic_regression_block_predict() {
+    run_logistic_regression_block_predict_test(2500, 6);
+  }
+
 };
 
 
@@ -341,6 +408,13 @@ void run_logistic_regression_opt_interface_test(std::map<std::string,
     TS_ASSERT(gradient.isApprox(_gradient));
     TS_ASSERT(hessian.isApprox(_hessian));
 
+    // Check the hessian-vector product against the hessian.
+    DenseVector direction(variables);
+    direction.setRandom();
+    DenseVector hv(variables);
+    lr_interface->compute_hessian_vector_product(point, direction, hv);
+    TS_ASSERT(hv.isApprox(hessian * direction, 1e-8));
+
   }
 
   model.reset();
@@ -377,6 +451,9 @@ BOOST_AUTO_TEST_CASE(test_logistic_regression_basic_2d) {
 BOOST_AUTO_TEST_CASE(test_logistic_regression_small) {
   logistic_regression_test::test_logistic_regression_small();
 }
+BOOST_AUTO_TEST_CASE(test_logistic_regression_block_predict) {
+  logistic_regression_test::test_logistic_regression_block_predict();
+}
 BOOST_AUTO_TEST_SUITE_END()
 BOOST_FIXTURE_TEST_SUITE(_logistic_regression_opt_interface_test, logistic_regression_opt_interface_test)
 BOOST_AUTO_TEST_CASE(test_logistic_regression_opt_interface_basic_2d) {
@@ -0,0 +1,123 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <atomic>
+#include <thread>
+#include <stdexcept>
+#include <toolkits/util/micro_batcher.hpp>
+
+using namespace turi;
+
+struct micro_batcher_test {
+
+ public:
+
+  void test_concurrent_rows() {
+    std::atomic<size_t> num_calls(0);
+    std::atomic<size_t> max_batch(0);
+    micro_batcher batcher([&](const std::vector<flexible_type>& rows) {
+        ++num_calls;
+        size_t n = rows.size();
+        size_t m = max_batch;
+        while (n > m && !max_batch.compare_exchange_weak(m, n)) { }
+        std::vector<flexible_type> ret;
+        for (const auto& r : rows) ret.push_back(r.get<flex_int>() * 2);
+        return ret;
+      }, 8, 20000 /* 20ms */);
+
+    size_t num_threads = 32;
+    size_t rows_per_thread = 20;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> num_wrong(0);
+    for (size_t t = 0; t < num_threads; ++t) {
+      threads.emplace_back([&, t]() {
+          for (size_t i = 0; i < rows_per_thread; ++i) {
+            flex_int v = t * rows_per_thread + i;
+            if (batcher.submit(v) != 2 * v) ++num_wrong;
+          }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    TS_ASSERT_EQUALS(num_wrong, 0);
+    TS_ASSERT(max_batch <= 8);
+    // concurrent rows share calls
+    TS_ASSERT(num_calls < num_threads * rows_per_thread);
+  }
+
+  void test_lone_row() {
+    micro_batcher batcher([](const std::vector<flexible_type>& rows) {
+        return rows;
+      }, 64, 1000);
+    for (flex_int i = 0; i < 10; ++i) {
+      TS_ASSERT_EQUALS(batcher.submit(i), i);
+    }
+  }
+
+  void test_errors() {
+    micro_batcher failing([](const std::vector<flexible_type>& rows)
+                              -> std::vector<flexible_type> {
+        throw std::runtime_error("bad row");
+      }, 4, 1000);
+    TS_ASSERT_THROWS_ANYTHING(failing.submit(1));
+
+    micro_batcher short_results([](const std::vector<flexible_type>& rows) {
+        return std::vector<flexible_type>();
+      }, 4, 1000);
+    TS_ASSERT_THROWS_ANYTHING(short_results.submit(1));
+  }
+
+  /**
+   * A row which fails its batch only fails its own request.
+   */
+  void test_error_isolation() {
+    micro_batcher batcher([](const std::vector<flexible_type>& rows) {
+        std::vector<flexible_type> ret;
+        for (const auto& r : rows) {
+          if (r.get<flex_int>() < 0) throw std::runtime_error("bad row");
+          ret.push_back(r.get<flex_int>() * 2);
+        }
+        return ret;
+      }, 8, 20000 /* 20ms */);
+
+    size_t num_threads = 16;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> num_wrong(0);
+    std::atomic<size_t> num_errors(0);
+    for (size_t t = 0; t < num_threads; ++t) {
+      threads.emplace_back([&, t]() {
+          flex_int v = (t % 4 == 0) ? -flex_int(t) - 1 : flex_int(t);
+          try {
+            if (batcher.submit(v) != 2 * v) ++num_wrong;
+          } catch (...) {
+            if (v >= 0) ++num_wrong;
+            ++num_errors;
+          }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    TS_ASSERT_EQUALS(num_wrong, 0);
+    TS_ASSERT_EQUALS(num_errors, num_threads / 4);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_micro_batcher_test, micro_batcher_test)
+BOOST_AUTO_TEST_CASE(test_concurrent_rows) {
+  micro_batcher_test::test_concurrent_rows();
+}
+BOOST_AUTO_TEST_CASE(test_lone_row) {
+  micro_batcher_test::test_lone_row();
+}
+BOOST_AUTO_TEST_CASE(test_errors) {
+  micro_batcher_test::test_errors();
+}
+BOOST_AUTO_TEST_CASE(test_error_isolation) {
+  micro_batcher_test::test_error_isolation();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,6 +1,10 @@
 #define BOOST_TEST_MODULE
 #include <boost/test/unit_test.hpp>
 #include <core/util/test_macros.hpp>
+#include <random>
+#include <core/storage/fileio/temp_files.hpp>
+#include <core/parallel/pthread_tools.hpp>
+#include <toolkits/supervised_learning/xgboost_allreduce.hpp>
 
 #define XGBOOST_CUSTOMIZE_MSG_
 #include <xgboost/src/io/simple_fmatrix-inl.hpp>
@@ -130,6 +134,143 @@ struct decision_tree_test {
     TS_ASSERT_DELTA(preds[7], -.25, DELTA);
     TS_ASSERT_DELTA(preds[8], 2.0, DELTA);
   }
+
+  std::vector<float> train_and_predict(DMatrixSimple& data, const std::string& updater,
+                                       const std::string& page_file = "",
+                                       DMatrixSimple* test = nullptr) {
+    BoostLearner gbm;
+    set_options(gbm, "reg:linear");
+    gbm.SetParam("max_depth", "4");
+    gbm.SetParam("lambda", "1.0");
+    gbm.SetParam("eta", "0.5");
+    gbm.SetParam("updater", updater.c_str());
+    if (!page_file.empty()) {
+      gbm.SetParam("hist_page_file", page_file.c_str());
+    }
+    gbm.SetCacheData({&data});
+    gbm.InitModel();
+    gbm.CheckInit(&data);
+    for (int i = 0; i < 3; ++i) {
+      gbm.UpdateOneIter(i, data);
+    }
+    std::vector<float> preds;
+    gbm.Predict(test != nullptr ? *test : data, true, &preds, 0, false);
+    return preds;
+  }
+
+  void test_quantile_histmaker() {
+    // Fewer distinct values than bins, so the histogram splits are the
+    // exact ones.  Feature 2 is missing in a third of the rows.
+    std::mt19937 rng(1);
+    DMatrixSimple data;
+    for (size_t i = 0; i < 2000; ++i) {
+      float x0 = rng() % 10, x1 = rng() % 50, x2 = rng() % 7;
+      std::vector<RowBatch::Entry> row = {RowBatch::Entry(0, x0), RowBatch::Entry(1, x1)};
+      bool has_x2 = (i % 3 != 0);
+      if (has_x2) row.push_back(RowBatch::Entry(2, x2));
+      data.AddRow(row);
+      float noise = (rng() % 1000) / 1000.0f;
+      data.info.labels.push_back((x0 > 4 ? 2.0f : -1.0f) + 0.1f * x1 +
+                                 (has_x2 ? x2 : -5.0f) + noise);
+    }
+
+    std::vector<float> exact = train_and_predict(data, "grow_colmaker,prune");
+    std::vector<float> hist = train_and_predict(data, "grow_quantile_histmaker,prune");
+    TS_ASSERT_EQUALS(exact.size(), hist.size());
+    for (size_t i = 0; i < exact.size(); ++i) {
+      TS_ASSERT_DELTA(exact[i], hist[i], 1e-4);
+    }
+
+    // The same trees from the quantized columns kept on disk.
+    std::vector<float> paged = train_and_predict(data, "grow_quantile_histmaker,prune",
+                                                 turi::get_temp_name());
+    TS_ASSERT_EQUALS(exact.size(), paged.size());
+    for (size_t i = 0; i < exact.size(); ++i) {
+      TS_ASSERT_DELTA(exact[i], paged[i], 1e-4);
+    }
+  }
+
+  void test_flat_prediction() {
+    // The same rows, one matrix with a prediction buffer, as in training,
+    // and one without, which is scored from the flattened trees.
+    std::mt19937 rng(2);
+    DMatrixSimple data, test;
+    for (size_t i = 0; i < 1000; ++i) {
+      std::vector<RowBatch::Entry> row;
+      for (unsigned j = 0; j < 4; ++j) {
+        if (rng() % 5 != 0) row.push_back(RowBatch::Entry(j, (rng() % 100) / 10.0f));
+      }
+      data.AddRow(row);
+      test.AddRow(row);
+      data.info.labels.push_back(rng() % 3);
+    }
+
+    BoostLearner gbm;
+    set_options(gbm, "multi:softmax");
+    gbm.SetParam("num_class", "3");
+    gbm.SetParam("max_depth", "4");
+    gbm.SetCacheData({&data});
+    gbm.InitModel();
+    gbm.CheckInit(&data);
+    for (int i = 0; i < 5; ++i) {
+      gbm.UpdateOneIter(i, data);
+    }
+
+    for (unsigned ntree_limit : {0, 2}) {
+      std::vector<float> expected, preds;
+      gbm.Predict(data, true, &expected, ntree_limit, false);
+      gbm.Predict(test, true, &preds, ntree_limit, false);
+      TS_ASSERT_EQUALS(expected.size(), 3000);
+      TS_ASSERT_EQUALS(preds.size(), expected.size());
+      for (size_t i = 0; i < expected.size(); ++i) {
+        TS_ASSERT_EQUALS(preds[i], expected[i]);
+      }
+    }
+  }
+
+  void test_distributed_training() {
+    // Two workers in threads, each with every other row. Fewer distinct
+    // values than sketch entries, so the histogram splits are the exact ones.
+    std::mt19937 rng(3);
+    DMatrixSimple data, shards[2];
+    for (size_t i = 0; i < 1000; ++i) {
+      float x0 = rng() % 10, x1 = rng() % 15;
+      std::vector<RowBatch::Entry> row = {RowBatch::Entry(0, x0), RowBatch::Entry(1, x1)};
+      float label = (x0 > 4 ? 2.0f : -1.0f) + 0.1f * x1 + (rng() % 1000) / 1000.0f;
+      data.AddRow(row);
+      data.info.labels.push_back(label);
+      shards[i % 2].AddRow(row);
+      shards[i % 2].info.labels.push_back(label);
+    }
+    std::vector<float> expected = train_and_predict(data, "grow_colmaker,prune");
+
+    std::vector<float> preds[2];
+    turi::thread_group threads;
+    for (size_t rank = 0; rank < 2; ++rank) {
+      threads.launch([&, rank]() {
+        turi::supervised::xgboost::thread_training_worker worker(
+            rank, 2, "inproc://xgboost_distributed_training_test", 60);
+        preds[rank] = train_and_predict(shards[rank], "grow_histmaker,prune", "", &data);
+      });
+    }
+    threads.join();
+
+    // both workers end with the model of the whole data
+    for (size_t rank = 0; rank < 2; ++rank) {
+      TS_ASSERT_EQUALS(preds[rank].size(), expected.size());
+      for (size_t i = 0; i < expected.size(); ++i) {
+        TS_ASSERT_DELTA(preds[rank][i], expected[i], 1e-4);
+      }
+    }
+  }
+
+  void test_distributed_timeout() {
+    // worker 1 never joins
+    turi::supervised::xgboost::thread_training_worker worker(
+        0, 2, "inproc://xgboost_distributed_timeout_test", 1);
+    std::vector<float> values(4, 1.0f);
+    TS_ASSERT_THROWS_ANYTHING(rabit::Allreduce<rabit::op::Sum>(values.data(), values.size()));
+  }
 };
 
 BOOST_FIXTURE_TEST_SUITE(_decision_tree_test, decision_tree_test)
@@ -142,4 +283,16 @@ BOOST_AUTO_TEST_CASE(test_classifier) {
 BOOST_AUTO_TEST_CASE(test_multiclass_classifier) {
   decision_tree_test::test_multiclass_classifier();
 }
+BOOST_AUTO_TEST_CASE(test_quantile_histmaker) {
+  decision_tree_test::test_quantile_histmaker();
+}
+BOOST_AUTO_TEST_CASE(test_flat_prediction) {
+  decision_tree_test::test_flat_prediction();
+}
+BOOST_AUTO_TEST_CASE(test_distributed_training) {
+  decision_tree_test::test_distributed_training();
+}
+BOOST_AUTO_TEST_CASE(test_distributed_timeout) {
+  decision_tree_test::test_distributed_timeout();
+}
 BOOST_AUTO_TEST_SUITE_END()
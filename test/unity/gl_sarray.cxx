@@ -7,6 +7,10 @@
 #include <boost/test/unit_test.hpp>
 #include <core/util/test_macros.hpp>
 #include <boost/range/combine.hpp>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
 #include <core/data/sframe/gl_sarray.hpp>
 #include <core/parallel/lambda_omp.hpp>
 #include <core/data/sframe/gl_sframe.hpp>
@@ -438,6 +442,81 @@ struct gl_sarray_test {
       _assert_sarray_equals(result,{flex_undefined(),
         flex_undefined(),flex_undefined(),1.5,2.5,3.5,4.5,5.5,6.5,7.5});
     }
+
+    void test_rolling_apply_incremental() {
+      // window of 61 values, from 50 before to 10 after, over several segments
+      const ssize_t start = -50, end = 10;
+      std::vector<flexible_type> values;
+      for (size_t i = 0; i < 3000; ++i) {
+        if (i % 7 == 3) values.push_back(flex_undefined());
+        else values.push_back(double((i * 37) % 101) - 50.25);
+      }
+      gl_sarray floats(values, flex_type_enum::FLOAT);
+
+      auto window_values = [&](ssize_t row) {
+        std::vector<double> ret;
+        for (ssize_t j = row + start; j <= row + end; ++j) {
+          if (j >= 0 && j < ssize_t(values.size()) &&
+              values[j].get_type() != flex_type_enum::UNDEFINED) {
+            ret.push_back(values[j]);
+          }
+        }
+        return ret;
+      };
+
+      auto check = [&](const std::string& name,
+                       std::function<double(const std::vector<double>&)> expected) {
+        gl_sarray result = floats.builtin_rolling_apply(name, start, end, 1);
+        TS_ASSERT_EQUALS(result.size(), values.size());
+        std::vector<flexible_type> out;
+        for (const auto& v : result.range_iterator()) out.push_back(v);
+        for (size_t i = 0; i < values.size(); ++i) {
+          double e = expected(window_values(i));
+          TS_ASSERT_LESS_THAN(std::abs(double(out[i]) - e), 1e-9 * (1 + std::abs(e)));
+        }
+      };
+
+      check("__builtin__sum__", [](const std::vector<double>& w) {
+        return std::accumulate(w.begin(), w.end(), 0.0);
+      });
+      check("__builtin__avg__", [](const std::vector<double>& w) {
+        return std::accumulate(w.begin(), w.end(), 0.0) / w.size();
+      });
+      check("__builtin__var__", [](const std::vector<double>& w) {
+        double mean = std::accumulate(w.begin(), w.end(), 0.0) / w.size();
+        double m2 = 0;
+        for (double x : w) m2 += (x - mean) * (x - mean);
+        return w.size() <= 1 ? 0.0 : m2 / w.size();
+      });
+      check("__builtin__min__", [](const std::vector<double>& w) {
+        return *std::min_element(w.begin(), w.end());
+      });
+      check("__builtin__max__", [](const std::vector<double>& w) {
+        return *std::max_element(w.begin(), w.end());
+      });
+      check("__builtin__nonnull__count__", [](const std::vector<double>& w) {
+        return double(w.size());
+      });
+
+      // integer sums are exact, and the windows at the ends are incomplete
+      gl_sarray ints{1, 2, 3, 4, 5};
+      _assert_sarray_equals(ints.builtin_rolling_apply("__builtin__sum__", -1, 1, 2),
+                            {3, 6, 9, 12, 9});
+      _assert_sarray_equals(ints.builtin_rolling_apply("__builtin__max__", -2, 0),
+                            {flex_undefined(), flex_undefined(), 3, 4, 5});
+    }
+
+    void test_rolling_apply_sketches() {
+      gl_sarray a{0,1,2,3,4,5};
+      auto result = a.builtin_rolling_apply(std::string("__builtin__quantile__[1.0]"), -2, 0);
+      _assert_sarray_equals(result,{flex_undefined(), flex_undefined(),
+        flex_vec{2}, flex_vec{3}, flex_vec{4}, flex_vec{5}});
+
+      gl_sarray b{1,1,2,2,2,3};
+      auto top = b.builtin_rolling_apply(std::string("__builtin__approx__top__k__1"), -2, 0);
+      _assert_sarray_equals(top,{flex_undefined(), flex_undefined(),
+        flex_dict{{1, 2}}, flex_dict{{2, 2}}, flex_dict{{2, 3}}, flex_dict{{2, 2}}});
+    }
    
     void test_sarray() {
       gl_sarray sa{1,2,3,4,5,6};
@@ -671,6 +750,12 @@ BOOST_AUTO_TEST_CASE(test_slice) {
 BOOST_AUTO_TEST_CASE(test_rolling_apply) {
   gl_sarray_test::test_rolling_apply();
 }
+BOOST_AUTO_TEST_CASE(test_rolling_apply_incremental) {
+  gl_sarray_test::test_rolling_apply_incremental();
+}
+BOOST_AUTO_TEST_CASE(test_rolling_apply_sketches) {
+  gl_sarray_test::test_rolling_apply_sketches();
+}
 BOOST_AUTO_TEST_CASE(test_sarray) {
   gl_sarray_test::test_sarray();
 }
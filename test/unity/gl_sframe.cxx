@@ -14,6 +14,7 @@
 #include <boost/filesystem.hpp>
 #include <core/parallel/lambda_omp.hpp>
 #include <core/storage/sframe_data/sframe.hpp>
+#include <core/storage/sframe_data/sframe_key_index.hpp>
 #include <core/storage/sframe_data/testing_utils.hpp>
 
 using namespace turi;
@@ -122,6 +123,26 @@ struct gl_sframe_test {
 
     }
 
+    void test_block_sample() {
+      // small samples of a materialized frame read the sampled rows only
+      auto sf = gl_sframe({{"id", gl_sarray::from_sequence(0, 100000)}});
+      sf.materialize();
+      gl_sframe sf1 = sf.sample(0.005, 1);
+      _assert_sframe_equals(sf1, sf.sample(0.005, 1));
+      TS_ASSERT_LESS_THAN(0, sf1.size());
+      TS_ASSERT_LESS_THAN(sf1.size(), 1000);
+      for (size_t i = 1; i < sf1.size(); ++i) {
+        TS_ASSERT_LESS_THAN(sf1["id"][i - 1], sf1["id"][i]);
+      }
+
+      TS_ASSERT_EQUALS(sf.sample(0.005, 2, true).size(), 500);
+
+      gl_sframe sfa, sfb;
+      std::tie(sfa, sfb) = sf.random_split(0.005, 3, true);
+      TS_ASSERT_EQUALS(sfa.size(), 500);
+      _assert_sframe_equals(sf, sfa.append(sfb).sort("id"));
+    }
+
     void test_groupby() {
       gl_sframe sf;
       sf["a"] = gl_sarray({"a","a","a","a","a","b","b","b","b","b"});
@@ -130,6 +151,28 @@ struct gl_sframe_test {
       _assert_sframe_equals(sf2, gl_sframe{{"a", {"a","b"}}, {"bsum", {10, 10}}, {"bcount", {5, 5}}});
     }
 
+    void test_approx_count_distinct_groupby() {
+      gl_sframe sf;
+      sf["a"] = gl_sarray({"a","a","a","a","a","b","b","b","b","b"});
+      sf["b"] = gl_sarray({1, 2, 2, 3, 3, 1, 1, 1, 1, 1});
+      gl_sframe sf2 = sf.groupby({"a"}, {{"bcount", aggregate::APPROX_COUNT_DISTINCT("b")},
+                                         {"bexact", aggregate::COUNT_DISTINCT("b")}}).sort("a");
+      _assert_sframe_equals(sf2, gl_sframe{{"a", {"a","b"}}, {"bcount", {3, 1}}, {"bexact", {3, 1}}});
+    }
+
+    void test_approx_top_k_groupby() {
+      gl_sframe sf;
+      sf["a"] = gl_sarray({"a","a","a","a","a","b","b","b","b","b"});
+      sf["b"] = gl_sarray({1, 2, 2, 3, 3, 1, 1, 1, 1, 1});
+      gl_sframe sf2 = sf.groupby({"a"}, {{"top", aggregate::APPROX_TOP_K("b", 1)}}).sort("a");
+      TS_ASSERT_EQUALS(sf2.size(), 2);
+      flex_dict top_a = sf2["top"][0].get<flex_dict>();
+      TS_ASSERT_EQUALS(top_a.size(), 1);
+      TS_ASSERT(top_a[0].first == 2 || top_a[0].first == 3);
+      TS_ASSERT_EQUALS(top_a[0].second, 2);
+      TS_ASSERT(sf2["top"][1] == flexible_type(flex_dict{{1, 5}}));
+    }
+
     void test_vector_groupby(){
       gl_sframe sf;
       sf["a"] = gl_sarray({"a","a","b","b"});
@@ -265,6 +308,52 @@ struct gl_sframe_test {
       sf3["a"] = sf3["a"].astype(flex_type_enum::INTEGER);
       _assert_sframe_equals(sf3, sf4);
     }
+    void test_stack_dict() {
+      // dictionaries of up to 999 keys, so that one batch of input rows
+      // writes several batches of output rows
+      std::vector<flexible_type> ids, dicts;
+      size_t num_values = 0;
+      for (size_t i = 0; i < 1000; ++i) {
+        ids.push_back(i);
+        if (i % 10 == 0) {
+          dicts.push_back(FLEX_UNDEFINED);
+        } else if (i % 10 == 1) {
+          dicts.push_back(flex_dict());
+        } else {
+          flex_dict d;
+          for (size_t j = 0; j < i; ++j) {
+            d.push_back({"k" + std::to_string(j), i * 1000 + j});
+          }
+          dicts.push_back(d);
+          num_values += i;
+        }
+      }
+      gl_sframe sf({{"id", ids}, {"d", gl_sarray(dicts, flex_type_enum::DICT)}});
+
+      auto dropped = sf.stack("d", std::vector<std::string>{"key", "value"}, true);
+      TS_ASSERT_EQUALS(dropped.size(), num_values);
+      auto kept = sf.stack("d", std::vector<std::string>{"key", "value"}, false);
+      TS_ASSERT_EQUALS(kept.size(), num_values + 200);
+      TS_ASSERT_EQUALS(kept.column_names(),
+                       (std::vector<std::string>{"id", "key", "value"}));
+
+      std::vector<size_t> count(1000, 0);
+      for (const auto& row: kept.range_iterator()) {
+        size_t i = row[0].get<flex_int>();
+        if (i % 10 < 2) {
+          TS_ASSERT(row[1] == FLEX_UNDEFINED);
+          TS_ASSERT(row[2] == FLEX_UNDEFINED);
+        } else {
+          size_t j = row[2].get<flex_int>() - i * 1000;
+          TS_ASSERT_EQUALS(row[1], flexible_type("k" + std::to_string(j)));
+        }
+        ++count[i];
+      }
+      for (size_t i = 0; i < 1000; ++i) {
+        TS_ASSERT_EQUALS(count[i], i % 10 < 2 ? 1 : i);
+      }
+    }
+
     void test_unique() {
       _assert_sframe_equals(_make_reference_frame().unique().sort("a"), _make_reference_frame());
       gl_sframe sf;
@@ -337,6 +426,82 @@ struct gl_sframe_test {
       _assert_sarray_equals(g["id"], {1,2,3,4,5});
     }
 
+    void test_key_index() {
+      // ids in runs of 3, then scattered
+      std::vector<flexible_type> ids, names;
+      std::vector<size_t> rows_of_7;
+      for (size_t i = 0; i < 3000; ++i) {
+        size_t id = i < 1500 ? i / 3 : (i * 7) % 500;
+        ids.push_back(id);
+        names.push_back("n" + std::to_string(i));
+        if (id == 7) rows_of_7.push_back(i);
+      }
+      ids[10] = FLEX_UNDEFINED;
+      gl_sframe g({{"id", ids}, {"name", names}});
+      const std::string tempstr = boost::filesystem::unique_path().string();
+      g.save(tempstr);
+      gl_sframe sf(tempstr);
+
+      gl_sarray keys({5, 7, 1000});
+      auto expected_by = sf.filter_by(keys, "id").sort("name");
+      auto expected_eq = sf[sf["id"] == 7].sort("name");
+      TS_ASSERT_EQUALS(expected_eq.size(), rows_of_7.size());
+
+      sf.create_key_index("id");
+      _assert_sframe_equals(sf.filter_by(keys, "id").sort("name"), expected_by);
+      _assert_sframe_equals(sf[sf["id"] == 7].sort("name"), expected_eq);
+      TS_ASSERT_EQUALS(sf[sf["id"] == 1000].size(), 0);
+      // a float is not a key of an integer column, but still compares equal
+      TS_ASSERT_EQUALS(sf[sf["id"] == 7.0].size(), rows_of_7.size());
+      // the excluded rows are still found by a join
+      TS_ASSERT_EQUALS(sf.filter_by(keys, "id", true).size(),
+                       sf.size() - expected_by.size());
+
+      // the index was saved next to the sframe, for this column only
+      auto sframe_ptr =
+          std::static_pointer_cast<unity_sframe>(sf.get_proxy())->get_underlying_sframe();
+      std::string index_file = sframe_key_index::index_file(*sframe_ptr, 0);
+      TS_ASSERT(!index_file.empty());
+      auto loaded = sframe_key_index::load(index_file, sframe_ptr->select_column(0));
+      TS_ASSERT(loaded != nullptr);
+      TS_ASSERT_EQUALS(loaded->num_rows(), 3000);
+      TS_ASSERT(loaded->find_rows({7}) == rows_of_7);
+      TS_ASSERT(sframe_key_index::load(index_file, sframe_ptr->select_column(1)) == nullptr);
+
+      sf.create_key_index("name", false);
+      auto found = sf.filter_by(gl_sarray({"n42", "n2999", "x"}), "name");
+      TS_ASSERT_EQUALS(found.size(), 2);
+      TS_ASSERT_EQUALS(found["name"][0], "n42");
+    }
+
+    void test_fillna_columns() {
+      gl_sframe sf;
+      sf["a"] = gl_sarray({1, FLEX_UNDEFINED, 3, FLEX_UNDEFINED});
+      sf["b"] = gl_sarray({1.5, 2.5, FLEX_UNDEFINED, NAN});
+      sf["c"] = gl_sarray({"x", FLEX_UNDEFINED, "z", "w"});
+      sf["d"] = gl_sarray({FLEX_UNDEFINED, 1, 2, 3});
+
+      gl_sframe filled = sf.fillna({{"a", 0}, {"b", 0}, {"c", "none"}});
+      TS_ASSERT(filled.column_names() == sf.column_names());
+      TS_ASSERT(filled.column_types() == sf.column_types());
+      TS_ASSERT((filled["a"] == gl_sarray({1, 0, 3, 0})).all());
+      TS_ASSERT_EQUALS(filled["b"][2].get_type(), flex_type_enum::FLOAT);
+      TS_ASSERT((filled["b"] == gl_sarray({1.5, 2.5, 0.0, 0.0})).all());
+      TS_ASSERT((filled["c"] == gl_sarray({"x", "none", "z", "w"})).all());
+      // columns not listed keep their missing values
+      TS_ASSERT_EQUALS(filled["d"].num_missing(), 1);
+
+      // same result as one fillna per column
+      gl_sframe chained = sf.fillna("a", 0).fillna("b", 0).fillna("c", "none");
+      for (const auto& name: sf.column_names()) {
+        TS_ASSERT_EQUALS(filled[name].size(), chained[name].size());
+      }
+      TS_ASSERT((filled["a"] == chained["a"]).all());
+
+      TS_ASSERT_THROWS_ANYTHING(sf.fillna({{"a", "text"}}));
+      TS_ASSERT_THROWS_ANYTHING(sf.fillna({{"missing", 0}}));
+    }
+
     void test_parallel_range_iterator() {
       turi::gl_sframe sf;
       sf.add_column(gl_sarray::from_const(0, 1000), "src_1");
@@ -488,9 +653,18 @@ BOOST_AUTO_TEST_CASE(test_sample) {
 BOOST_AUTO_TEST_CASE(test_sample_split) {
   gl_sframe_test::test_sample_split();
 }
+BOOST_AUTO_TEST_CASE(test_block_sample) {
+  gl_sframe_test::test_block_sample();
+}
 BOOST_AUTO_TEST_CASE(test_groupby) {
   gl_sframe_test::test_groupby();
 }
+BOOST_AUTO_TEST_CASE(test_approx_count_distinct_groupby) {
+  gl_sframe_test::test_approx_count_distinct_groupby();
+}
+BOOST_AUTO_TEST_CASE(test_approx_top_k_groupby) {
+  gl_sframe_test::test_approx_top_k_groupby();
+}
 BOOST_AUTO_TEST_CASE(test_vector_groupby) {
   gl_sframe_test::test_vector_groupby();
 }
@@ -512,6 +686,9 @@ BOOST_AUTO_TEST_CASE(test_pack_unpack2) {
 BOOST_AUTO_TEST_CASE(test_stack_unstack) {
   gl_sframe_test::test_stack_unstack();
 }
+BOOST_AUTO_TEST_CASE(test_stack_dict) {
+  gl_sframe_test::test_stack_dict();
+}
 BOOST_AUTO_TEST_CASE(test_unique) {
   gl_sframe_test::test_unique();
 }
@@ -533,6 +710,12 @@ BOOST_AUTO_TEST_CASE(test_filter_by_exclude) {
 BOOST_AUTO_TEST_CASE(test_save) {
   gl_sframe_test::test_save();
 }
+BOOST_AUTO_TEST_CASE(test_key_index) {
+  gl_sframe_test::test_key_index();
+}
+BOOST_AUTO_TEST_CASE(test_fillna_columns) {
+  gl_sframe_test::test_fillna_columns();
+}
 BOOST_AUTO_TEST_CASE(test_parallel_range_iterator) {
   gl_sframe_test::test_parallel_range_iterator();
 }
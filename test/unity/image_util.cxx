@@ -417,3 +417,46 @@ BOOST_AUTO_TEST_CASE(test_load_images_nonrecursive) {
   // Clean up.
   TS_ASSERT(fileio::delete_path_recursive(temp_dir));
 }
+
+BOOST_AUTO_TEST_CASE(test_scaled_jpeg_decode) {
+
+  const std::string temp_dir = get_temp_name();
+  TS_ASSERT(fileio::create_directory_or_throw(temp_dir));
+  const std::string path = temp_dir + "/image.jpg";
+
+  std::map<std::string, image_descriptor> descriptors_by_path;
+  descriptors_by_path[path] = {48, 64, 3, Format::JPG};
+  write_test_images(descriptors_by_path);
+
+  image_type image = read_image(path, /* format_hint */ "");
+  const char* data = reinterpret_cast<const char*>(image.get_image_data());
+  TS_ASSERT_EQUALS(static_cast<size_t>(image.m_format),
+                   static_cast<size_t>(Format::JPG));
+
+  // 64x48 scaled by 1/4 is the smallest size covering 10x10.
+  size_t width, height, channels;
+  parse_jpeg_scaled(data, image.m_image_data_size, 10, 10,
+                    width, height, channels);
+  TS_ASSERT_EQUALS(width, 16);
+  TS_ASSERT_EQUALS(height, 12);
+  TS_ASSERT_EQUALS(channels, 3);
+
+  // No scaling covers a size larger than the image.
+  parse_jpeg_scaled(data, image.m_image_data_size, 100, 10,
+                    width, height, channels);
+  TS_ASSERT_EQUALS(width, 64);
+  TS_ASSERT_EQUALS(height, 48);
+
+  std::vector<char> buf(16 * 12 * 3);
+  decode_jpeg_scaled(data, image.m_image_data_size, 10, 10,
+                     buf.data(), buf.size());
+  TS_ASSERT_THROWS_ANYTHING(decode_jpeg_scaled(
+      data, image.m_image_data_size, 10, 10, buf.data(), buf.size() - 1));
+
+  // Resizing goes through the scaled decode and still hits the exact size.
+  _test_resize_impl(image, 10, 10, 3, true);
+  _test_resize_impl(image, 12, 16, 1, true);
+  _test_resize_impl(image, 10, 10, 3, false);
+
+  TS_ASSERT(fileio::delete_path_recursive(temp_dir));
+}
@@ -0,0 +1,140 @@
+/* Copyright © 2019 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define BOOST_TEST_MODULE test_ac_data_iterator
+
+#include <toolkits/activity_classification/ac_data_iterator.hpp>
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+
+namespace turi {
+namespace activity_classification {
+namespace {
+
+using neural_net::shared_float_array;
+
+// Returns parameters for two sessions: "a" with 5 samples and "b" with 2. The
+// feature of each sample is its row index. With a prediction window of 2 and 2
+// predictions per chunk, the chunks are a[0:4], a[4:5] and b[0:2].
+data_iterator::parameters create_data() {
+  data_iterator::parameters result;
+  result.data = gl_sframe({
+      {"session", flex_list{"a", "a", "a", "a", "a", "b", "b"}},
+      {"f", flex_list{0, 1, 2, 3, 4, 5, 6}},
+      {"target", flex_list{"x", "x", "y", "y", "y", "y", "x"}},
+  });
+  result.target_column_name = "target";
+  result.session_id_column_name = "session";
+  result.feature_column_names = {"f"};
+  result.prediction_window = 2;
+  result.predictions_in_chunk = 2;
+  return result;
+}
+
+std::vector<float> to_vector(const shared_float_array& array) {
+  return std::vector<float>(array.data(), array.data() + array.size());
+}
+
+void check_batches(data_iterator* iterator) {
+  TS_ASSERT(iterator->has_next_batch());
+  data_iterator::batch batch = iterator->next_batch(2);
+
+  TS_ASSERT_EQUALS(batch.batch_info.size(), 2);
+  TS_ASSERT_EQUALS(batch.batch_info[0].session_id, flexible_type("a"));
+  TS_ASSERT_EQUALS(batch.batch_info[0].num_samples, 4);
+  TS_ASSERT_EQUALS(batch.batch_info[1].session_id, flexible_type("a"));
+  TS_ASSERT_EQUALS(batch.batch_info[1].num_samples, 1);
+
+  TS_ASSERT_EQUALS(batch.features.dim(), 4);
+  TS_ASSERT_EQUALS(batch.features.shape()[0], 2);
+  TS_ASSERT_EQUALS(batch.features.shape()[2], 4);
+  TS_ASSERT_EQUALS(batch.features.shape()[3], 1);
+  TS_ASSERT(to_vector(batch.features) ==
+            std::vector<float>({0, 1, 2, 3, 4, 0, 0, 0}));
+  TS_ASSERT(to_vector(batch.labels_per_row) ==
+            std::vector<float>({0, 0, 1, 1, 1, 0, 0, 0}));
+  TS_ASSERT(to_vector(batch.labels) == std::vector<float>({0, 1, 1, 0}));
+  TS_ASSERT(to_vector(batch.weights) == std::vector<float>({1, 1, 1, 0}));
+
+  TS_ASSERT(iterator->has_next_batch());
+  batch = iterator->next_batch(2);
+
+  // The second batch holds one chunk, then padding.
+  TS_ASSERT_EQUALS(batch.batch_info.size(), 1);
+  TS_ASSERT_EQUALS(batch.batch_info[0].session_id, flexible_type("b"));
+  TS_ASSERT_EQUALS(batch.batch_info[0].num_samples, 2);
+  TS_ASSERT(to_vector(batch.features) ==
+            std::vector<float>({5, 6, 0, 0, 0, 0, 0, 0}));
+  TS_ASSERT(to_vector(batch.labels) == std::vector<float>({0, 0, 0, 0}));
+  TS_ASSERT(to_vector(batch.weights) == std::vector<float>({1, 0, 0, 0}));
+
+  TS_ASSERT(!iterator->has_next_batch());
+}
+
+BOOST_AUTO_TEST_CASE(test_simple_data_iterator_chunks_sessions) {
+  simple_data_iterator iterator(create_data());
+
+  TS_ASSERT_EQUALS(iterator.class_labels(), flex_list({"x", "y"}));
+  TS_ASSERT(iterator.session_id_type() == flex_type_enum::STRING);
+
+  check_batches(&iterator);
+
+  // A second traversal gives the same batches.
+  iterator.reset();
+  check_batches(&iterator);
+}
+
+BOOST_AUTO_TEST_CASE(test_simple_data_iterator_reset_mid_session) {
+  simple_data_iterator iterator(create_data());
+
+  // Stop after the first chunk of session "a".
+  data_iterator::batch batch = iterator.next_batch(1);
+  TS_ASSERT_EQUALS(batch.batch_info.size(), 1);
+  TS_ASSERT_EQUALS(batch.batch_info[0].num_samples, 4);
+
+  iterator.reset();
+  check_batches(&iterator);
+}
+
+BOOST_AUTO_TEST_CASE(test_simple_data_iterator_with_prefetching) {
+  data_iterator::parameters params = create_data();
+  params.num_prefetch_workers = 2;
+  simple_data_iterator iterator(params);
+
+  check_batches(&iterator);
+  iterator.reset();
+  check_batches(&iterator);
+}
+
+BOOST_AUTO_TEST_CASE(test_simple_data_iterator_with_augmentation) {
+  data_iterator::parameters params = create_data();
+  params.is_train = true;
+  params.use_data_augmentation = true;
+  simple_data_iterator iterator(params);
+
+  // Session "a" starts at sample 0 or 1, giving chunks a[0:4] and a[4:5], or
+  // just a[1:5]. Session "b" is not longer than a prediction window, so it is
+  // not offset.
+  size_t num_samples = 0;
+  size_t num_chunks = 0;
+  while (iterator.has_next_batch()) {
+    data_iterator::batch batch = iterator.next_batch(2);
+    for (const data_iterator::batch::chunk_info& info : batch.batch_info) {
+      TS_ASSERT_LESS_THAN_EQUALS(info.num_samples, 4);
+      num_samples += info.num_samples;
+      ++num_chunks;
+    }
+  }
+  TS_ASSERT((num_samples == 7 && num_chunks == 3) ||
+            (num_samples == 6 && num_chunks == 2));
+}
+
+}  // namespace
+}  // namespace activity_classification
+}  // namespace turi
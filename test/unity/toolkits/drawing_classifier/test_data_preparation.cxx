@@ -0,0 +1,115 @@
+/* Copyright © 2019 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define BOOST_TEST_MODULE test_data_preparation
+
+#include <toolkits/drawing_classifier/data_preparation.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+
+namespace turi {
+namespace drawing_classifier {
+
+namespace {
+
+flex_dict make_point(double x, double y) {
+  return {{"x", x}, {"y", y}};
+}
+
+// A horizontal line across the top and a vertical line down the left.
+flex_list make_corner_drawing() {
+  flex_list top;
+  for (int x = 0; x <= 100; x += 10) top.push_back(make_point(x, 0));
+  flex_list left;
+  for (int y = 0; y <= 100; y += 10) left.push_back(make_point(0, y));
+  return {top, left};
+}
+
+double pixel(const flex_nd_vec& bitmap, size_t row, size_t col) {
+  return bitmap[row * 28 + col];
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(test_rasterize_drawings_to_arrays) {
+  gl_sarray drawings(std::vector<flexible_type>{make_corner_drawing()});
+  gl_sarray bitmaps = rasterize_drawings(drawings, flex_type_enum::ND_VECTOR);
+
+  TS_ASSERT_EQUALS(bitmaps.size(), 1);
+  TS_ASSERT(bitmaps.dtype() == flex_type_enum::ND_VECTOR);
+  flex_nd_vec bitmap = bitmaps[0].get<flex_nd_vec>();
+  TS_ASSERT(bitmap.shape() == std::vector<size_t>({28, 28, 1}));
+
+  // The strokes cover the top-left corner, not the far corner.
+  TS_ASSERT_EQUALS(pixel(bitmap, 0, 14), 255.0);
+  TS_ASSERT_EQUALS(pixel(bitmap, 14, 0), 255.0);
+  TS_ASSERT_EQUALS(pixel(bitmap, 27, 27), 0.0);
+  TS_ASSERT_EQUALS(pixel(bitmap, 14, 14), 0.0);
+
+  // The edge of the stroke is anti-aliased.
+  bool found_partial = false;
+  for (size_t row = 0; row < 28; ++row) {
+    double v = pixel(bitmap, row, 20);
+    TS_ASSERT(v >= 0.0 && v <= 255.0);
+    if (v > 0.0 && v < 255.0) found_partial = true;
+  }
+  TS_ASSERT(found_partial);
+}
+
+BOOST_AUTO_TEST_CASE(test_rasterize_drawings_keeps_row_order) {
+  // Enough rows that every thread gets a segment.
+  std::vector<flexible_type> drawings;
+  for (size_t i = 0; i < 100; ++i) {
+    flex_list stroke;
+    stroke.push_back(make_point(0, 0));
+    stroke.push_back(make_point(100, i % 2 == 0 ? 100 : 0));
+    drawings.push_back(flex_list{stroke});
+  }
+  gl_sarray bitmaps = rasterize_drawings(gl_sarray(drawings),
+                                         flex_type_enum::ND_VECTOR);
+  TS_ASSERT_EQUALS(bitmaps.size(), 100);
+
+  size_t i = 0;
+  for (const flexible_type& v : bitmaps.range_iterator()) {
+    const flex_nd_vec& bitmap = v.get<flex_nd_vec>();
+    if (i % 2 == 0) {
+      // A diagonal.
+      TS_ASSERT_EQUALS(pixel(bitmap, 14, 14), 255.0);
+    } else {
+      // A horizontal line along the top.
+      TS_ASSERT_EQUALS(pixel(bitmap, 0, 14), 255.0);
+      TS_ASSERT_EQUALS(pixel(bitmap, 14, 14), 0.0);
+    }
+    ++i;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_prepare_data_produces_images) {
+  gl_sframe data({{"drawing", gl_sarray({make_corner_drawing(),
+                                         make_corner_drawing()})},
+                  {"label", gl_sarray({"a", "b"})}});
+  gl_sframe prepared = _drawing_classifier_prepare_data(data, "drawing");
+
+  TS_ASSERT_EQUALS(prepared.size(), 2);
+  TS_ASSERT(prepared["drawing"].dtype() == flex_type_enum::IMAGE);
+  flex_image image = prepared["drawing"][0].get<flex_image>();
+  TS_ASSERT_EQUALS(image.m_height, 28);
+  TS_ASSERT_EQUALS(image.m_width, 28);
+  TS_ASSERT_EQUALS(image.m_channels, 1);
+  TS_ASSERT(prepared["label"][1] == flexible_type("b"));
+}
+
+BOOST_AUTO_TEST_CASE(test_rasterize_drawings_rejects_bad_points) {
+  flex_list stroke;
+  stroke.push_back(flex_dict{{"x", 1.0}});
+  gl_sarray drawings(std::vector<flexible_type>{flex_list{stroke}});
+  TS_ASSERT_THROWS_ANYTHING(
+      rasterize_drawings(drawings, flex_type_enum::ND_VECTOR));
+}
+
+}  // namespace drawing_classifier
+}  // namespace turi
@@ -0,0 +1,163 @@
+
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <cmath>
+#include <string>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/data/sframe/gl_sframe.hpp>
+#include <toolkits/feature_engineering/dimension_reduction.hpp>
+
+using namespace turi;
+using namespace turi::sdk_model::feature_engineering;
+
+
+/**
+ * Points spread along (0.6, 0.8, 0) with t = 1, ..., 8, plus a small
+ * uncorrelated spread along (0, 0, 1). The principal directions are exactly
+ * these two, with eigenvalues 42 and 0.08 of the scatter matrix.
+ */
+static const std::vector<double> s_values = {1, -1, -1, 1, 1, -1, -1, 1};
+
+std::vector<double> make_point(size_t i) {
+  double t = i + 1;
+  return {0.6 * t, 0.8 * t, 0.1 * s_values[i]};
+}
+
+gl_sframe make_pca_data(bool as_ndarray) {
+  std::vector<flexible_type> points;
+  for (size_t i = 0; i < s_values.size(); ++i) {
+    if (as_ndarray) {
+      points.push_back(flex_nd_vec(make_point(i), {1, 3}));
+    } else {
+      points.push_back(flex_vec(make_point(i)));
+    }
+  }
+  return gl_sframe({{"x", gl_sarray(points)}});
+}
+
+
+std::shared_ptr<randomized_pca> make_pca(size_t embedding_dimension,
+                                         size_t oversampling) {
+  std::map<std::string, flexible_type> user_opts = {
+    {"features", FLEX_UNDEFINED},
+    {"exclude", false},
+    {"embedding_dimension", embedding_dimension},
+    {"oversampling", oversampling},
+    {"random_seed", 7}};
+
+  std::shared_ptr<randomized_pca> pca;
+  pca.reset(new randomized_pca);
+  pca->init_transformer(user_opts);
+  return pca;
+}
+
+
+/**
+ * Check the projection of make_pca_data onto its two principal directions.
+ */
+void check_projection(gl_sframe& sf_embed) {
+  TS_ASSERT_EQUALS(sf_embed.size(), s_values.size());
+
+  for (size_t i = 0; i < s_values.size(); ++i) {
+    flex_vec y = sf_embed["embedded_features"][i];
+    TS_ASSERT_EQUALS(y.size(), 2);
+    TS_ASSERT(std::abs(y[0] - (i + 1 - 4.5)) < 1e-8);
+    TS_ASSERT(std::abs(y[1] - 0.1 * s_values[i]) < 1e-8);
+  }
+}
+
+
+/**
+ * Main test driver
+ * -----------------------------------------------------------------------------
+ */
+struct randomized_pca_test  {
+
+ public:
+
+  /**
+   * The fit finds the principal directions and their variances, both with a
+   * subspace as large as the data and with a subspace of exactly
+   * embedding_dimension directions, which needs the power iterations.
+   */
+  void test_fit_principal_directions() {
+    for (size_t oversampling : {0, 10}) {
+      auto pca = make_pca(2, oversampling);
+      gl_sframe sf_embed = pca->fit_transform(make_pca_data(false));
+      check_projection(sf_embed);
+
+      flex_vec singular_values = variant_get_value<flexible_type>(
+          pca->get_value_from_state("singular_values"));
+      TS_ASSERT(std::abs(singular_values[0] - std::sqrt(42.0)) < 1e-8);
+      TS_ASSERT(std::abs(singular_values[1] - std::sqrt(0.08)) < 1e-8);
+
+      flex_vec explained_variance = variant_get_value<flexible_type>(
+          pca->get_value_from_state("explained_variance"));
+      TS_ASSERT(std::abs(explained_variance[0] - 6.0) < 1e-8);
+
+      flex_vec ratio = variant_get_value<flexible_type>(
+          pca->get_value_from_state("explained_variance_ratio"));
+      TS_ASSERT(std::abs(ratio[0] + ratio[1] - 1.0) < 1e-8);
+    }
+  }
+
+  /**
+   * Ndarray columns are unpacked like array columns.
+   */
+  void test_ndarray_columns() {
+    auto pca = make_pca(2, 10);
+    gl_sframe sf_embed = pca->fit_transform(make_pca_data(true));
+    check_projection(sf_embed);
+
+    TS_ASSERT_EQUALS(variant_get_value<size_t>(
+        pca->get_value_from_state("original_dimension")), 3);
+  }
+
+  /**
+   * The embedding dimension cannot exceed the dimension of the data.
+   */
+  void test_embedding_dimension_too_large() {
+    auto pca = make_pca(4, 10);
+    TS_ASSERT_THROWS_ANYTHING(pca->fit(make_pca_data(false)));
+  }
+
+  /**
+   * Make sure save and loading a model doesn't change the transformation.
+   */
+  void test_save_and_load() {
+    auto pca = make_pca(2, 10);
+    gl_sframe data = make_pca_data(false);
+    pca->fit(data);
+
+    dir_archive archive_write;
+    archive_write.open_directory_for_write("randomized_pca_cxx_test");
+    turi::oarchive oarc(archive_write);
+    oarc << *pca;
+    archive_write.close();
+
+    std::shared_ptr<randomized_pca> loaded(new randomized_pca);
+    dir_archive archive_read;
+    archive_read.open_directory_for_read("randomized_pca_cxx_test");
+    turi::iarchive iarc(archive_read);
+    iarc >> *loaded;
+
+    gl_sframe sf_embed = loaded->transform(data);
+    check_projection(sf_embed);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_randomized_pca_test, randomized_pca_test)
+BOOST_AUTO_TEST_CASE(test_fit_principal_directions) {
+  randomized_pca_test::test_fit_principal_directions();
+}
+BOOST_AUTO_TEST_CASE(test_ndarray_columns) {
+  randomized_pca_test::test_ndarray_columns();
+}
+BOOST_AUTO_TEST_CASE(test_embedding_dimension_too_large) {
+  randomized_pca_test::test_embedding_dimension_too_large();
+}
+BOOST_AUTO_TEST_CASE(test_save_and_load) {
+  randomized_pca_test::test_save_and_load();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,150 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <vector>
+#include <string>
+#include <map>
+
+#include <core/data/sframe/gl_sarray.hpp>
+#include <toolkits/feature_engineering/token_counting.hpp>
+
+using namespace turi;
+using namespace turi::sdk_model::feature_engineering;
+
+struct token_counting_test {
+
+ public:
+
+  void test_count_tokens() {
+    gl_sarray src({"The cat, the hat", "", FLEX_UNDEFINED, "a cat  sat", "The end"});
+
+    token_counts ret = count_tokens(src, {" ", ","});
+
+    // Sorted by document frequency, then by token.
+    flex_list expected_vocabulary = {"cat", "the", "a", "end", "hat", "sat"};
+    std::vector<size_t> expected_frequencies = {2, 2, 1, 1, 1, 1};
+    TS_ASSERT_EQUALS(ret.vocabulary.size(), expected_vocabulary.size());
+    for (size_t i = 0; i < expected_vocabulary.size(); ++i) {
+      TS_ASSERT_EQUALS(ret.vocabulary[i], expected_vocabulary[i]);
+      TS_ASSERT_EQUALS(ret.document_frequencies[i], expected_frequencies[i]);
+    }
+
+    TS_ASSERT_EQUALS(ret.counts.size(), src.size());
+    std::vector<flexible_type> rows;
+    for (const auto& v : ret.counts.range_iterator()) {
+      rows.push_back(v);
+    }
+    TS_ASSERT(rows[0] == flexible_type(flex_dict{{0, 1}, {1, 2}, {4, 1}}));
+    TS_ASSERT(rows[1] == flexible_type(flex_dict{}));
+    TS_ASSERT(rows[2].get_type() == flex_type_enum::UNDEFINED);
+    TS_ASSERT(rows[3] == flexible_type(flex_dict{{0, 1}, {2, 1}, {5, 1}}));
+    TS_ASSERT(rows[4] == flexible_type(flex_dict{{1, 1}, {3, 1}}));
+  }
+
+  void test_count_ngrams() {
+    gl_sarray src({"a b c", "A B", "b c d"});
+
+    token_counts ret = count_tokens(src, {" "}, true, 2, 2);
+
+    // "a b" and "b c" occur in two rows, "c d" in one.
+    TS_ASSERT_EQUALS(ret.vocabulary.size(), 2);
+    TS_ASSERT_EQUALS(ret.vocabulary[0], "a b");
+    TS_ASSERT_EQUALS(ret.vocabulary[1], "b c");
+
+    std::vector<flexible_type> rows;
+    for (const auto& v : ret.counts.range_iterator()) {
+      rows.push_back(v);
+    }
+    TS_ASSERT(rows[0] == flexible_type(flex_dict{{0, 1}, {1, 1}}));
+    TS_ASSERT(rows[1] == flexible_type(flex_dict{{0, 1}}));
+    TS_ASSERT(rows[2] == flexible_type(flex_dict{{1, 1}}));
+  }
+
+  void test_count_tokens_large() {
+    // Enough rows for every thread to get some.
+    std::vector<flexible_type> values;
+    std::map<std::string, size_t> expected;
+    for (size_t i = 0; i < 5000; ++i) {
+      std::string s = "w" + std::to_string(i % 7) + " w" + std::to_string(i % 11)
+                      + " w" + std::to_string(i % 7);
+      values.push_back(s);
+      expected["w" + std::to_string(i % 7)]++;
+      if (i % 11 != i % 7) {
+        expected["w" + std::to_string(i % 11)]++;
+      }
+    }
+    gl_sarray src(values);
+    token_counts ret = count_tokens(src, {" "}, false);
+
+    TS_ASSERT_EQUALS(ret.vocabulary.size(), expected.size());
+    for (size_t i = 0; i < ret.vocabulary.size(); ++i) {
+      TS_ASSERT_EQUALS(ret.document_frequencies[i],
+                       expected.at(ret.vocabulary[i].get<flex_string>()));
+      if (i > 0) {
+        TS_ASSERT(ret.document_frequencies[i - 1] >= ret.document_frequencies[i]);
+      }
+    }
+
+    size_t row = 0;
+    for (const auto& v : ret.counts.range_iterator()) {
+      flex_int total = 0;
+      for (const auto& kv : v.get<flex_dict>()) {
+        total += kv.second.get<flex_int>();
+      }
+      TS_ASSERT_EQUALS(total, 3);
+      TS_ASSERT_EQUALS(v.get<flex_dict>().size(), (row % 11 == row % 7) ? 1 : 2);
+      ++row;
+    }
+    TS_ASSERT_EQUALS(row, 5000);
+  }
+
+  void test_count_tokens_errors() {
+    TS_ASSERT_THROWS_ANYTHING(count_tokens(gl_sarray({1, 2}), {" "}));
+    TS_ASSERT_THROWS_ANYTHING(count_tokens(gl_sarray({"a b"}), {"  "}));
+    TS_ASSERT_THROWS_ANYTHING(count_tokens(gl_sarray({"a b"}), {" "}, true, 0));
+  }
+
+  void test_token_count_dicts() {
+    gl_sarray src({"The cat, the hat", FLEX_UNDEFINED, "a cat"});
+
+    gl_sarray ret = token_count_dicts(count_tokens(src, {" ", ","}));
+
+    std::vector<flexible_type> rows;
+    for (const auto& v : ret.range_iterator()) {
+      rows.push_back(v);
+    }
+    TS_ASSERT_EQUALS(rows.size(), 3);
+    TS_ASSERT(rows[0] == flexible_type(flex_dict{{"cat", 1}, {"the", 2}, {"hat", 1}}));
+    TS_ASSERT(rows[1].get_type() == flex_type_enum::UNDEFINED);
+    TS_ASSERT(rows[2] == flexible_type(flex_dict{{"cat", 1}, {"a", 1}}));
+  }
+
+  void test_can_count_tokens() {
+    TS_ASSERT(can_count_tokens(flex_list{" ", ","}, true));
+    TS_ASSERT(can_count_tokens(flex_list{"A"}, false));
+    TS_ASSERT(!can_count_tokens(flex_list{"A"}, true));
+    TS_ASSERT(!can_count_tokens(flex_list{"ab"}, false));
+    TS_ASSERT(!can_count_tokens(FLEX_UNDEFINED, false));
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_token_counting_test, token_counting_test)
+BOOST_AUTO_TEST_CASE(test_count_tokens) {
+  token_counting_test::test_count_tokens();
+}
+BOOST_AUTO_TEST_CASE(test_count_ngrams) {
+  token_counting_test::test_count_ngrams();
+}
+BOOST_AUTO_TEST_CASE(test_count_tokens_large) {
+  token_counting_test::test_count_tokens_large();
+}
+BOOST_AUTO_TEST_CASE(test_count_tokens_errors) {
+  token_counting_test::test_count_tokens_errors();
+}
+BOOST_AUTO_TEST_CASE(test_token_count_dicts) {
+  token_counting_test::test_token_count_dicts();
+}
+BOOST_AUTO_TEST_CASE(test_can_count_tokens) {
+  token_counting_test::test_can_count_tokens();
+}
+BOOST_AUTO_TEST_SUITE_END()
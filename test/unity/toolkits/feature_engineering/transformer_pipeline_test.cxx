@@ -0,0 +1,67 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <vector>
+#include <string>
+
+#include <core/data/sframe/gl_sframe.hpp>
+#include <toolkits/feature_engineering/mean_imputer.hpp>
+#include <toolkits/feature_engineering/transformer_pipeline.hpp>
+
+using namespace turi;
+using namespace turi::sdk_model::feature_engineering;
+
+/**
+ * A mean imputer of the given features, or of every column if empty.
+ */
+std::shared_ptr<transformer_base> make_imputer(flex_list features) {
+  auto model = std::make_shared<mean_imputer>();
+  std::map<std::string, flexible_type> options;
+  options["features"] = features.empty() ? FLEX_UNDEFINED : flexible_type(features);
+  options["exclude"] = false;
+  model->init_transformer(options);
+  return model;
+}
+
+flex_list values(const gl_sarray& column) {
+  flex_list ret;
+  for (const auto& v: column.range_iterator()) ret.push_back(v);
+  return ret;
+}
+
+std::vector<std::shared_ptr<transformer_base>> make_steps() {
+  return {make_imputer({"a"}), make_imputer({"b"}), make_imputer({"a"}),
+          make_imputer({})};
+}
+
+struct transformer_pipeline_test {
+ public:
+  void test_fit_groups() {
+    gl_sframe data{{"a", {1, FLEX_UNDEFINED, 3, 5}},
+                   {"b", {2.0, 4.0, FLEX_UNDEFINED, 6.0}},
+                   {"c", {FLEX_UNDEFINED, 1, 1, 1}}};
+
+    transformer_pipeline pipeline(make_steps());
+    gl_sframe out = pipeline.fit_transform(data);
+    // {a, b}, then a again, then every column
+    TS_ASSERT_EQUALS(pipeline.num_fit_groups(), 3);
+
+    // the same as fitting and transforming one step at a time
+    gl_sframe expected = data;
+    for (const auto& step: make_steps()) {
+      expected = step->fit_transform(expected);
+    }
+    TS_ASSERT(out.column_names() == expected.column_names());
+    for (const auto& name: expected.column_names()) {
+      TS_ASSERT(values(out[name]) == values(expected[name]));
+    }
+    TS_ASSERT(values(out["a"]) == flex_list({1, 3, 3, 5}));
+    TS_ASSERT(values(out["c"]) == flex_list({1, 1, 1, 1}));
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_transformer_pipeline_test, transformer_pipeline_test)
+BOOST_AUTO_TEST_CASE(test_fit_groups) {
+  transformer_pipeline_test::test_fit_groups();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -286,6 +286,32 @@ struct word_counter_test  {
       {"exclude", false}}; 
     run_bad_input_list_test(opts);
   }
+
+  void test_string_column_matches_list_column() {
+    // String columns are counted in bulk, lists of strings row by row.
+    gl_sframe data({{"string", {"The cat the hat", FLEX_UNDEFINED, "", "a\tCat"}},
+                    {"list", {flex_list{"The cat the hat"}, FLEX_UNDEFINED,
+                              flex_list{""}, flex_list{"a\tCat"}}}});
+    std::map<std::string, flexible_type> opts = {
+      {"to_lower", true},
+      {"delimiters", flex_list({"\r", "\v", "\n", "\f", "\t", " "})},
+      {"exclude", false}};
+    std::shared_ptr<word_counter> model = init_model(data, opts);
+    gl_sframe out_sf = model->transform(data);
+
+    for (const auto& row : out_sf.range_iterator()) {
+      TS_ASSERT_EQUALS(row[0].get_type(), row[1].get_type());
+      if (row[0].get_type() != flex_type_enum::DICT) continue;
+      std::map<flex_string, flexible_type> from_string, from_list;
+      for (const auto& kv : row[0].get<flex_dict>()) {
+        from_string[kv.first.get<flex_string>()] = kv.second;
+      }
+      for (const auto& kv : row[1].get<flex_dict>()) {
+        from_list[kv.first.get<flex_string>()] = kv.second;
+      }
+      TS_ASSERT(from_string == from_list);
+    }
+  }
 };
 
 BOOST_FIXTURE_TEST_SUITE(_word_counter_test, word_counter_test)
@@ -301,4 +327,7 @@ BOOST_AUTO_TEST_CASE(test_bad_input_dict) {
 BOOST_AUTO_TEST_CASE(test_bad_input_list) {
   word_counter_test::test_bad_input_list();
 }
+BOOST_AUTO_TEST_CASE(test_string_column_matches_list_column) {
+  word_counter_test::test_string_column_matches_list_column();
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,191 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <core/data/sframe/gl_sframe.hpp>
+#include <core/data/sframe/gl_sgraph.hpp>
+#include <core/storage/sframe_interface/unity_sgraph.hpp>
+#include <model_server/lib/simple_model.hpp>
+#include <model_server/lib/variant.hpp>
+#include <model_server/lib/variant_converter.hpp>
+#include <toolkits/graph_analytics/graph_coloring.hpp>
+#include <toolkits/graph_analytics/kcore.hpp>
+#include <toolkits/graph_analytics/sssp.hpp>
+
+using namespace turi;
+
+/**
+ * Runs the "create" function of a graph analytics toolkit, and returns the
+ * fields of the model it returns.
+ */
+variant_map_type run_toolkit(const std::vector<toolkit_function_specification>& specs,
+                             const gl_sgraph& g,
+                             variant_map_type params) {
+  params["graph"] = to_variant(std::shared_ptr<unity_sgraph>(g));
+  for (const auto& spec : specs) {
+    if (spec.name != "create") continue;
+    variant_map_type response = variant_get_value<variant_map_type>(
+        spec.native_execute_function({to_variant(params)}));
+    auto model = std::dynamic_pointer_cast<simple_model>(
+        variant_get_value<std::shared_ptr<model_base>>(response.at("model")));
+    TS_ASSERT(model != nullptr);
+    return model->params;
+  }
+  TS_FAIL("No create function");
+  return variant_map_type();
+}
+
+/**
+ * Returns a vertex field of the graph of a model, by vertex id.
+ */
+std::map<flex_int, flexible_type> vertex_values(const variant_map_type& model,
+                                                const std::string& field) {
+  gl_sgraph g(variant_get_value<std::shared_ptr<unity_sgraph>>(model.at("graph")));
+  gl_sframe vertices = g.get_vertices();
+  std::map<flex_int, flexible_type> ret;
+  for (const auto& row : vertices[{"__id", field}].range_iterator()) {
+    ret[row[0].get<flex_int>()] = row[1];
+  }
+  return ret;
+}
+
+/**
+ * A weighted directed graph where 5 and 6 cannot be reached from 1, 6 being
+ * isolated.
+ */
+gl_sgraph make_weighted_graph() {
+  gl_sframe vertices{{"__id", {1, 2, 3, 4, 5, 6}}};
+  gl_sframe edges{{"__src_id", {1, 2, 1, 3, 5}},
+                  {"__dst_id", {2, 3, 3, 4, 1}},
+                  {"weight", {1.0, 1.0, 5.0, 2.5, 1.0}}};
+  return gl_sgraph(vertices, edges, "__id", "__src_id", "__dst_id");
+}
+
+/**
+ * A clique of 4 vertices (the 3-core), 5 connected to two of them (core 2),
+ * 6 connected to 5 (core 1) and the isolated 7 (core 0).
+ */
+gl_sgraph make_core_graph() {
+  gl_sframe vertices{{"__id", {1, 2, 3, 4, 5, 6, 7}}};
+  gl_sframe edges{{"__src_id", {1, 1, 1, 2, 2, 3, 5, 5, 6}},
+                  {"__dst_id", {2, 3, 4, 3, 4, 4, 1, 2, 5}}};
+  return gl_sgraph(vertices, edges, "__id", "__src_id", "__dst_id");
+}
+
+struct graph_analytics_test {
+ public:
+
+  void test_sssp_weighted() {
+    auto model = run_toolkit(sssp::get_toolkit_function_registration(),
+                             make_weighted_graph(),
+                             {{"source_vid", 1}, {"weight_field", "weight"}});
+    auto distance = vertex_values(model, "distance");
+    TS_ASSERT_EQUALS(distance.size(), 6);
+    TS_ASSERT_EQUALS((double)distance[1], 0.0);
+    TS_ASSERT_EQUALS((double)distance[2], 1.0);
+    // the two hop path is shorter than the direct edge
+    TS_ASSERT_EQUALS((double)distance[3], 2.0);
+    TS_ASSERT_EQUALS((double)distance[4], 4.5);
+    // unreachable vertices stay at max_distance
+    TS_ASSERT_EQUALS((double)distance[5], 1e30);
+    TS_ASSERT_EQUALS((double)distance[6], 1e30);
+  }
+
+  void test_sssp_uniform_weights() {
+    auto model = run_toolkit(sssp::get_toolkit_function_registration(),
+                             make_weighted_graph(),
+                             {{"source_vid", 1}});
+    auto distance = vertex_values(model, "distance");
+    TS_ASSERT_EQUALS((double)distance[1], 0.0);
+    TS_ASSERT_EQUALS((double)distance[2], 1.0);
+    TS_ASSERT_EQUALS((double)distance[3], 1.0);
+    TS_ASSERT_EQUALS((double)distance[4], 2.0);
+    TS_ASSERT_EQUALS((double)distance[5], 1e30);
+    TS_ASSERT_EQUALS((double)distance[6], 1e30);
+  }
+
+  void test_sssp_max_distance() {
+    auto model = run_toolkit(sssp::get_toolkit_function_registration(),
+                             make_weighted_graph(),
+                             {{"source_vid", 1}, {"weight_field", "weight"},
+                              {"max_distance", 3.0}});
+    auto distance = vertex_values(model, "distance");
+    TS_ASSERT_EQUALS((double)distance[3], 2.0);
+    // beyond max_distance
+    TS_ASSERT((double)distance[4] >= 3.0);
+  }
+
+  void test_sssp_missing_source() {
+    TS_ASSERT_THROWS_ANYTHING(run_toolkit(sssp::get_toolkit_function_registration(),
+                                          make_weighted_graph(),
+                                          {{"source_vid", 100}}));
+  }
+
+  void test_kcore() {
+    auto model = run_toolkit(kcore::get_toolkit_function_registration(),
+                             make_core_graph(), {{"kmin", 0}, {"kmax", 10}});
+    auto core_id = vertex_values(model, "core_id");
+    TS_ASSERT_EQUALS(core_id.size(), 7);
+    for (flex_int v : {1, 2, 3, 4}) TS_ASSERT_EQUALS(core_id[v], 3);
+    TS_ASSERT_EQUALS(core_id[5], 2);
+    TS_ASSERT_EQUALS(core_id[6], 1);
+    TS_ASSERT_EQUALS(core_id[7], 0);
+  }
+
+  void test_kcore_kmax() {
+    // cores at or above kmax are reported as kmax
+    auto model = run_toolkit(kcore::get_toolkit_function_registration(),
+                             make_core_graph(), {{"kmin", 0}, {"kmax", 2}});
+    auto core_id = vertex_values(model, "core_id");
+    for (flex_int v : {1, 2, 3, 4, 5}) TS_ASSERT_EQUALS(core_id[v], 2);
+    TS_ASSERT_EQUALS(core_id[6], 1);
+    TS_ASSERT_EQUALS(core_id[7], 0);
+  }
+
+  void test_graph_coloring() {
+    gl_sgraph g = make_core_graph();
+    auto model = run_toolkit(graph_coloring::get_toolkit_function_registration(),
+                             g, {});
+    auto color_id = vertex_values(model, "color_id");
+    TS_ASSERT_EQUALS(color_id.size(), 7);
+
+    // no edge joins two vertices of the same color
+    for (const auto& row : g.get_edges().range_iterator()) {
+      TS_ASSERT(color_id[row[0].get<flex_int>()] != color_id[row[1].get<flex_int>()]);
+    }
+    std::set<flexible_type> colors;
+    for (const auto& kv : color_id) colors.insert(kv.second);
+    size_t num_colors = variant_get_value<size_t>(model.at("num_colors"));
+    TS_ASSERT_EQUALS(colors.size(), num_colors);
+    // the clique needs 4 colors
+    TS_ASSERT(num_colors >= 4);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_graph_analytics_test, graph_analytics_test)
+BOOST_AUTO_TEST_CASE(test_sssp_weighted) {
+  graph_analytics_test::test_sssp_weighted();
+}
+BOOST_AUTO_TEST_CASE(test_sssp_uniform_weights) {
+  graph_analytics_test::test_sssp_uniform_weights();
+}
+BOOST_AUTO_TEST_CASE(test_sssp_max_distance) {
+  graph_analytics_test::test_sssp_max_distance();
+}
+BOOST_AUTO_TEST_CASE(test_sssp_missing_source) {
+  graph_analytics_test::test_sssp_missing_source();
+}
+BOOST_AUTO_TEST_CASE(test_kcore) {
+  graph_analytics_test::test_kcore();
+}
+BOOST_AUTO_TEST_CASE(test_kcore_kmax) {
+  graph_analytics_test::test_kcore_kmax();
+}
+BOOST_AUTO_TEST_CASE(test_graph_coloring) {
+  graph_analytics_test::test_graph_coloring();
+}
+BOOST_AUTO_TEST_SUITE_END()
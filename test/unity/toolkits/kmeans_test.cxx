@@ -20,6 +20,7 @@ void run_kmeans_test(std::map<std::string, flexible_type> opts) {
   bool custom_centers = opts.at("custom_centers");
   size_t max_iterations = opts.at("max_iterations");
   std::string feature_column_types = opts.at("feature_column_types");
+  std::string method = opts.count("method") ? opts.at("method") : "elkan";
   bool has_target_column = false;
 
   sframe raw_data;
@@ -36,15 +37,20 @@ void run_kmeans_test(std::map<std::string, flexible_type> opts) {
     {"num_clusters", num_clusters},
     {"max_iterations", max_iterations}
   };
+  if (opts.count("batch_size")) {
+    options["batch_size"] = opts.at("batch_size");
+  }
 
   // Train the model
   std::shared_ptr<kmeans::kmeans_model> model;
   model.reset(new kmeans::kmeans_model);
   model->init_options(options);
-  model->train(raw_data, init_centers, "elkan");
+  model->train(raw_data, init_centers, method);
 
   // Get predictions with the model.
   sframe predictions = model->predict(raw_data);
+  TS_ASSERT_EQUALS(predictions.num_rows(), num_examples);
+  TS_ASSERT_EQUALS(model->get_cluster_info().num_rows(), num_clusters);
 
 
   // Test save and load
@@ -130,6 +136,31 @@ struct kmeans_test  {
       {"feature_column_types", "v"}}; 
     run_kmeans_test(opts);    
   }
+
+  void test_kmeans_minibatch() {
+    std::map<std::string, flexible_type> opts = {
+      {"num_examples", 500},
+      {"num_clusters", 4},
+      {"max_iterations", 10},
+      {"custom_centers", false},
+      {"method", "minibatch"},
+      {"batch_size", 50},
+      {"feature_column_types", "nn"}};
+    run_kmeans_test(opts);
+  }
+
+  void test_kmeans_parallel_init() {
+    size_t old_value = kmeans::KMEANS_PARALLEL_INIT_MIN_CLUSTERS;
+    kmeans::KMEANS_PARALLEL_INIT_MIN_CLUSTERS = 1;
+    std::map<std::string, flexible_type> opts = {
+      {"num_examples", 500},
+      {"num_clusters", 20},
+      {"max_iterations", 10},
+      {"custom_centers", false},
+      {"feature_column_types", "nnv"}};
+    run_kmeans_test(opts);
+    kmeans::KMEANS_PARALLEL_INIT_MIN_CLUSTERS = old_value;
+  }
 };
 
 
@@ -149,4 +180,10 @@ BOOST_AUTO_TEST_CASE(test_kmeans_dict_input) {
 BOOST_AUTO_TEST_CASE(test_kmeans_vector_input) {
   kmeans_test::test_kmeans_vector_input();
 }
+BOOST_AUTO_TEST_CASE(test_kmeans_minibatch) {
+  kmeans_test::test_kmeans_minibatch();
+}
+BOOST_AUTO_TEST_CASE(test_kmeans_parallel_init) {
+  kmeans_test::test_kmeans_parallel_init();
+}
 BOOST_AUTO_TEST_SUITE_END()
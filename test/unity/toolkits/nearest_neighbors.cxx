@@ -35,6 +35,8 @@
 #include <toolkits/nearest_neighbors/ball_tree_neighbors.hpp>
 #include <toolkits/nearest_neighbors/brute_force_neighbors.hpp>
 #include <toolkits/nearest_neighbors/lsh_neighbors.hpp>
+#include <toolkits/nearest_neighbors/hnsw_neighbors.hpp>
+#include <toolkits/nearest_neighbors/product_quantizer.hpp>
 
 
 using namespace turi;
@@ -134,6 +136,157 @@ struct test_nearest_neighbors_utils  {
 
     ASSERT_EQ(dists, ans);
   }
+
+  void test_batch_candidate_evaluation() {
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> u(0, 10);
+
+    std::vector<std::pair<double, size_t>> points;
+    for (size_t i = 0; i < 200; ++i) {
+      // Rounded, so that there are ties.
+      points.push_back({std::floor(u(rng)), i});
+    }
+
+    for (size_t k : {size_t(0), size_t(1), size_t(5), size_t(50), size_t(-1)}) {
+      for (double radius : {-1.0, 3.0}) {
+        for (bool self_edges : {true, false}) {
+          nearest_neighbors::neighbor_candidates one(7, k, radius, self_edges);
+          nearest_neighbors::neighbor_candidates batch(7, k, radius, self_edges);
+
+          // Two batches, as for two reference blocks.
+          for (size_t b = 0; b < 2; ++b) {
+            std::vector<std::pair<double, size_t>> block(
+                points.begin() + b * 100, points.begin() + (b + 1) * 100);
+            for (const auto& p : block) {
+              one.evaluate_point(p);
+            }
+            batch.evaluate_points(block);
+          }
+
+          one.sort_candidates();
+          batch.sort_candidates();
+          TS_ASSERT(one.candidates == batch.candidates);
+        }
+      }
+    }
+  }
+
+  // Quantized distances are the exact distances to the decoded points.
+  void test_product_quantizer() {
+    random::seed(0);
+    std::mt19937 rng(0);
+    std::normal_distribution<double> g;
+
+    size_t n = 500, d = 10, m = 4;
+    nearest_neighbors::DenseMatrix X(n, d);
+    for (size_t i = 0; i < n; ++i) {
+      for (size_t j = 0; j < d; ++j) {
+        X(i, j) = g(rng);
+      }
+    }
+
+    nearest_neighbors::product_quantizer pq;
+    pq.train(X, m);
+    pq.init_symmetric_tables();
+    TS_ASSERT_EQUALS(pq.code_size(), m);
+
+    std::vector<uint8_t> codes(n * m);
+    for (size_t i = 0; i < n; ++i) {
+      nearest_neighbors::DenseVector x = X.row(i).transpose();
+      pq.encode(x.data(), &codes[i * m]);
+    }
+
+    nearest_neighbors::DenseVector q(d), a(d), b(d);
+    for (size_t j = 0; j < d; ++j) {
+      q(j) = g(rng);
+    }
+    std::vector<float> table;
+    pq.distance_table(q.data(), table);
+
+    for (size_t i = 0; i + 1 < n; i += 7) {
+      pq.decode(&codes[i * m], a.data());
+      pq.decode(&codes[(i + 1) * m], b.data());
+      TS_ASSERT_DELTA(pq.table_distance(table, &codes[i * m]),
+                      (q - a).squaredNorm(), 1e-4);
+      TS_ASSERT_DELTA(pq.symmetric_distance(&codes[i * m], &codes[(i + 1) * m]),
+                      (a - b).squaredNorm(), 1e-4);
+    }
+  }
+
+  void test_compact_bucket_map() {
+    size_t n = 10000;
+    std::vector<size_t> keys(n);
+    for (size_t i = 0; i < n; ++i) {
+      keys[i] = hash64(i % 37);
+    }
+
+    compact_bucket_map<size_t> m;
+    m.build(keys);
+    TS_ASSERT_EQUALS(m.num_buckets(), 37);
+
+    for (size_t k = 0; k < 37; ++k) {
+      auto rows = m.get(hash64(k));
+      std::vector<size_t> found(rows.first, rows.second);
+      TS_ASSERT_EQUALS(found.size(), (n - k - 1) / 37 + 1);
+      for (size_t j = 0; j < found.size(); ++j) {
+        TS_ASSERT_EQUALS(found[j], k + 37 * j);
+      }
+    }
+    auto none = m.get(hash64(size_t(37)));
+    TS_ASSERT(none.first == none.second);
+  }
+
+  // Multi-probe queries find all the candidates of the exact buckets, and
+  // more.
+  void test_lsh_multi_probe() {
+    random::seed(0);
+    std::mt19937 rng(0);
+    std::normal_distribution<double> g;
+
+    size_t n = 2000, d = 8;
+    auto random_vector = [&]() {
+      nearest_neighbors::DenseVector v(d);
+      for (size_t j = 0; j < d; ++j) {
+        v(j) = g(rng);
+      }
+      return v;
+    };
+
+    for (std::string distance : {"euclidean", "cosine"}) {
+      auto lsh = nearest_neighbors::lsh_family::create_lsh_family(distance);
+      lsh->init_options({{"num_tables", 2}, {"num_projections_per_table", 6}});
+      lsh->init_model(d);
+      lsh->reserve_reference_data(n);
+      std::vector<nearest_neighbors::DenseVector> refs;
+      for (size_t i = 0; i < n; ++i) {
+        refs.push_back(random_vector());
+        lsh->add_reference_data(i, refs.back());
+      }
+      lsh->build_tables();
+
+      for (size_t i = 0; i < n; i += 97) {
+        auto candidates = lsh->query(refs[i]);
+        TS_ASSERT(std::find(candidates.begin(), candidates.end(), i) != candidates.end());
+      }
+
+      size_t num_exact = 0, num_probed = 0;
+      for (size_t q = 0; q < 100; ++q) {
+        nearest_neighbors::DenseVector v = random_vector();
+        lsh->set_num_probes(0);
+        auto exact = lsh->query(v);
+        lsh->set_num_probes(4);
+        auto probed = lsh->query(v);
+
+        std::set<size_t> probed_set(probed.begin(), probed.end());
+        for (size_t e : exact) {
+          TS_ASSERT(probed_set.count(e));
+        }
+        num_exact += exact.size();
+        num_probed += probed.size();
+      }
+      TS_ASSERT_LESS_THAN(num_exact, num_probed);
+    }
+  }
 };
 
 
@@ -180,6 +333,8 @@ public:
       m.reset(new nearest_neighbors::ball_tree_neighbors);
     } else if (model == "lsh") {
       m.reset(new nearest_neighbors::lsh_neighbors);
+    } else if (model == "hnsw") {
+      m.reset(new nearest_neighbors::hnsw_neighbors);
     }
 
     // Train the model, compute the similarity graph, and check both
@@ -316,6 +471,26 @@ public:
   void test_lsh_data3() {
     run_sim_graph_test("lsh", "d", "euclidean");  // dictionary
   }
+
+  void test_hnsw_dist1() {
+    run_sim_graph_test("hnsw", "nnn", "euclidean");
+  }
+
+  void test_hnsw_dist2() {
+    run_sim_graph_test("hnsw", "nnn", "squared_euclidean");
+  }
+
+  void test_hnsw_dist3() {
+    run_sim_graph_test("hnsw", "nnn", "manhattan");
+  }
+
+  void test_hnsw_dist4() {
+    run_sim_graph_test("hnsw", "nnn", "cosine");
+  }
+
+  void test_hnsw_data1() {
+    run_sim_graph_test("hnsw", "V", "euclidean");  // 1000 numeric features
+  }
 };
 
 
@@ -326,7 +501,8 @@ struct test_nn_consistency  {
   void run_nn_test(const std::string& model,
                    size_t n,
                    const std::string& run_string,
-                   const std::string& distance) {
+                   const std::string& distance,
+                   const std::map<std::string, flexible_type>& options = {}) {
     
     global_logger().set_log_level(LOG_ERROR);
 
@@ -362,6 +538,10 @@ struct test_nn_consistency  {
       nn.reset(new nearest_neighbors::lsh_neighbors);
       nn_sl_1.reset(new nearest_neighbors::lsh_neighbors);
       nn_sl_2.reset(new nearest_neighbors::lsh_neighbors);
+    } else if (model == "hnsw") {
+      nn.reset(new nearest_neighbors::hnsw_neighbors);
+      nn_sl_1.reset(new nearest_neighbors::hnsw_neighbors);
+      nn_sl_2.reset(new nearest_neighbors::hnsw_neighbors);
     }
 
     // Temp: Need to construct a set of composite params
@@ -371,7 +551,7 @@ struct test_nn_consistency  {
     nearest_neighbors::dist_component_type p = std::make_tuple(data[0].column_names(), fn, 1.0);
     std::vector<nearest_neighbors::dist_component_type> composite_params = {p};
 
-    std::map<std::string, flexible_type> nn_options;
+    std::map<std::string, flexible_type> nn_options = options;
     
     if (model == "lsh") {
       nn_options["num_tables"] = 4;
@@ -423,6 +603,105 @@ struct test_nn_consistency  {
     run_nn_test("ball_tree", 30, "n", "euclidean");
   }
 
+  // A deep tree, built in parallel, finds the exact neighbors.
+  void test_ball_tree_deep() {
+    global_logger().set_log_level(LOG_ERROR);
+    random::seed(0);
+
+    size_t k = 5;
+    sframe data = make_random_sframe(2000, "nnnn", false);
+    sframe queries = make_random_sframe(100, "nnnn", false);
+
+    auto fn = function_closure_info();
+    fn.native_fn_name = "_distances.euclidean";
+    std::vector<nearest_neighbors::dist_component_type> composite_params =
+      {std::make_tuple(data.column_names(), fn, 1.0)};
+
+    std::shared_ptr<nearest_neighbors::nearest_neighbors_model> exact, tree;
+    exact.reset(new nearest_neighbors::brute_force_neighbors);
+    tree.reset(new nearest_neighbors::ball_tree_neighbors);
+    exact->train(data, composite_params, {});
+    tree->train(data, composite_params, {{"leaf_size", 20}});
+
+    auto neighbor_pairs = [](const sframe& result) {
+      std::set<std::pair<flexible_type, flexible_type>> ret;
+      for (const auto& row : testing_extract_sframe_data(result)) {
+        ret.insert({row[0], row[1]});
+      }
+      return ret;
+    };
+
+    TS_ASSERT(neighbor_pairs(exact->query(queries, k, -1))
+              == neighbor_pairs(tree->query(queries, k, -1)));
+  }
+
+  void test_hnsw_euclidean() {
+    run_nn_test("hnsw", 500, "nnnnnn", "euclidean");
+  }
+
+  void test_hnsw_manhattan() {
+    run_nn_test("hnsw", 500, "nnnnnn", "manhattan");
+  }
+
+  void test_hnsw_cosine() {
+    run_nn_test("hnsw", 500, "V", "cosine");
+  }
+
+  void test_hnsw_quantized() {
+    run_nn_test("hnsw", 500, "nnnnnn", "euclidean", {{"num_subspaces", 3}});
+  }
+
+  void test_brute_force_quantized_1() {
+    run_nn_test("brute_force", 100, "nnnnnn", "squared_euclidean",
+                {{"num_subspaces", 3}});
+  }
+
+  void test_brute_force_quantized_2() {
+    run_nn_test("brute_force", 100, "V", "cosine", {{"num_subspaces", 4}});
+  }
+
+  // The approximate neighbors should mostly be the exact ones.
+  void test_hnsw_recall() {
+    global_logger().set_log_level(LOG_ERROR);
+    random::seed(0);
+
+    size_t n = 3000;
+    size_t k = 10;
+    sframe data = make_random_sframe(n, "nnnnnnnn", false);
+    sframe queries = make_random_sframe(200, "nnnnnnnn", false);
+
+    auto fn = function_closure_info();
+    fn.native_fn_name = "_distances.euclidean";
+    std::vector<nearest_neighbors::dist_component_type> composite_params =
+      {std::make_tuple(data.column_names(), fn, 1.0)};
+
+    std::shared_ptr<nearest_neighbors::nearest_neighbors_model> exact, approx;
+    exact.reset(new nearest_neighbors::brute_force_neighbors);
+    approx.reset(new nearest_neighbors::hnsw_neighbors);
+    exact->train(data, composite_params, {});
+    approx->train(data, composite_params, {{"max_connections", 8}});
+
+    // (query label, reference label) pairs of each result.
+    auto neighbor_pairs = [](const sframe& result) {
+      std::set<std::pair<flexible_type, flexible_type>> ret;
+      for (const auto& row : testing_extract_sframe_data(result)) {
+        ret.insert({row[0], row[1]});
+      }
+      return ret;
+    };
+
+    auto expected = neighbor_pairs(exact->query(queries, k, -1));
+    auto found = neighbor_pairs(approx->query(queries, k, -1));
+
+    TS_ASSERT_EQUALS(found.size(), 200 * k);
+
+    size_t hits = 0;
+    for (const auto& p : found) {
+      hits += expected.count(p);
+    }
+    TS_ASSERT_LESS_THAN(0.9 * expected.size(), hits);
+  }
+
   void test_ball_tree_n_2() {
     run_nn_test("ball_tree", 30, "n", "manhattan");
   }
@@ -653,6 +932,18 @@ BOOST_AUTO_TEST_CASE(test_block_number_calculation) {
 BOOST_AUTO_TEST_CASE(test_all_pairs_squared_euclidean) {
   test_nearest_neighbors_utils::test_all_pairs_squared_euclidean();
 }
+BOOST_AUTO_TEST_CASE(test_batch_candidate_evaluation) {
+  test_nearest_neighbors_utils::test_batch_candidate_evaluation();
+}
+BOOST_AUTO_TEST_CASE(test_product_quantizer) {
+  test_nearest_neighbors_utils::test_product_quantizer();
+}
+BOOST_AUTO_TEST_CASE(test_compact_bucket_map) {
+  test_nearest_neighbors_utils::test_compact_bucket_map();
+}
+BOOST_AUTO_TEST_CASE(test_lsh_multi_probe) {
+  test_nearest_neighbors_utils::test_lsh_multi_probe();
+}
 BOOST_AUTO_TEST_SUITE_END()
 BOOST_FIXTURE_TEST_SUITE(_test_similarity_graph, test_similarity_graph)
 BOOST_AUTO_TEST_CASE(test_brute_force_dist1) {
@@ -718,11 +1009,50 @@ BOOST_AUTO_TEST_CASE(test_lsh_data2) {
 BOOST_AUTO_TEST_CASE(test_lsh_data3) {
   test_similarity_graph::test_lsh_data3();
 }
+BOOST_AUTO_TEST_CASE(test_hnsw_dist1) {
+  test_similarity_graph::test_hnsw_dist1();
+}
+BOOST_AUTO_TEST_CASE(test_hnsw_dist2) {
+  test_similarity_graph::test_hnsw_dist2();
+}
+BOOST_AUTO_TEST_CASE(test_hnsw_dist3) {
+  test_similarity_graph::test_hnsw_dist3();
+}
+BOOST_AUTO_TEST_CASE(test_hnsw_dist4) {
+  test_similarity_graph::test_hnsw_dist4();
+}
+BOOST_AUTO_TEST_CASE(test_hnsw_data1) {
+  test_similarity_graph::test_hnsw_data1();
+}
 BOOST_AUTO_TEST_SUITE_END()
 BOOST_FIXTURE_TEST_SUITE(_test_nn_consistency, test_nn_consistency)
 BOOST_AUTO_TEST_CASE(test_ball_tree_n_1) {
   test_nn_consistency::test_ball_tree_n_1();
 }
+BOOST_AUTO_TEST_CASE(test_hnsw_euclidean) {
+  test_nn_consistency::test_hnsw_euclidean();
+}
+BOOST_AUTO_TEST_CASE(test_hnsw_manhattan) {
+  test_nn_consistency::test_hnsw_manhattan();
+}
+BOOST_AUTO_TEST_CASE(test_hnsw_cosine) {
+  test_nn_consistency::test_hnsw_cosine();
+}
+BOOST_AUTO_TEST_CASE(test_ball_tree_deep) {
+  test_nn_consistency::test_ball_tree_deep();
+}
+BOOST_AUTO_TEST_CASE(test_hnsw_quantized) {
+  test_nn_consistency::test_hnsw_quantized();
+}
+BOOST_AUTO_TEST_CASE(test_brute_force_quantized_1) {
+  test_nn_consistency::test_brute_force_quantized_1();
+}
+BOOST_AUTO_TEST_CASE(test_brute_force_quantized_2) {
+  test_nn_consistency::test_brute_force_quantized_2();
+}
+BOOST_AUTO_TEST_CASE(test_hnsw_recall) {
+  test_nn_consistency::test_hnsw_recall();
+}
 BOOST_AUTO_TEST_CASE(test_ball_tree_n_2) {
   test_nn_consistency::test_ball_tree_n_2();
 }
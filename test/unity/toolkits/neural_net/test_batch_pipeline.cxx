@@ -0,0 +1,146 @@
+/* Copyright © 2019 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define BOOST_TEST_MODULE test_batch_pipeline
+
+#include <ml/neural_net/batch_pipeline.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+
+namespace turi {
+namespace neural_net {
+namespace {
+
+typedef batch_pipeline<int, int> int_pipeline;
+
+// Returns a read function yielding 0, 1, ..., n - 1.
+int_pipeline::read_function count_to(int n, std::atomic<int>* num_read) {
+  return [n, num_read](int* out) {
+    int i = (*num_read)++;
+    if (i >= n) return false;
+    *out = i;
+    return true;
+  };
+}
+
+BOOST_AUTO_TEST_CASE(test_ordered_output) {
+  std::atomic<int> num_read(0);
+  int_pipeline::options opts;
+  opts.num_workers = 4;
+  opts.queue_depth = 3;
+
+  int_pipeline pipeline(count_to(100, &num_read),
+                        [](int x) { return 2 * x; }, opts);
+
+  int batch;
+  for (int i = 0; i < 100; ++i) {
+    TS_ASSERT(pipeline.has_next());
+    TS_ASSERT(pipeline.next(&batch));
+    TS_ASSERT_EQUALS(batch, 2 * i);
+  }
+  TS_ASSERT(!pipeline.has_next());
+  TS_ASSERT(!pipeline.next(&batch));
+  TS_ASSERT(!pipeline.next(&batch));
+}
+
+BOOST_AUTO_TEST_CASE(test_unordered_output) {
+  std::atomic<int> num_read(0);
+  int_pipeline::options opts;
+  opts.num_workers = 4;
+  opts.ordered = false;
+
+  int_pipeline pipeline(count_to(100, &num_read),
+                        [](int x) { return x; }, opts);
+
+  std::vector<int> batches;
+  int batch;
+  while (pipeline.next(&batch)) {
+    batches.push_back(batch);
+  }
+
+  std::sort(batches.begin(), batches.end());
+  TS_ASSERT_EQUALS(batches.size(), 100);
+  for (int i = 0; i < 100; ++i) {
+    TS_ASSERT_EQUALS(batches[i], i);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_bounded_queue) {
+  std::atomic<int> num_read(0);
+  int_pipeline::options opts;
+  opts.num_workers = 2;
+  opts.queue_depth = 5;
+
+  int_pipeline pipeline(count_to(1000, &num_read),
+                        [](int x) { return x; }, opts);
+
+  // Wait for the first batch; the workers then stop after queue_depth reads.
+  int batch;
+  TS_ASSERT(pipeline.next(&batch));
+  TS_ASSERT(pipeline.has_next());
+  TS_ASSERT(num_read.load() <= 6);
+}
+
+BOOST_AUTO_TEST_CASE(test_process_error) {
+  std::atomic<int> num_read(0);
+  int_pipeline::options opts;
+  opts.num_workers = 3;
+
+  int_pipeline pipeline(count_to(100, &num_read),
+                        [](int x) {
+                          if (x == 5) throw std::runtime_error("bad batch");
+                          return x;
+                        }, opts);
+
+  int batch;
+  for (int i = 0; i < 5; ++i) {
+    TS_ASSERT(pipeline.next(&batch));
+    TS_ASSERT_EQUALS(batch, i);
+  }
+  TS_ASSERT_THROWS_ANYTHING(pipeline.next(&batch));
+
+  // The pipeline ends once the batches read before the failure come out.
+  while (pipeline.next(&batch)) {
+    TS_ASSERT(batch > 5);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_read_error) {
+  int_pipeline::options opts;
+  int_pipeline pipeline([](int*) -> bool { throw std::runtime_error("bad"); },
+                        [](int x) { return x; }, opts);
+
+  int batch;
+  TS_ASSERT_THROWS_ANYTHING(pipeline.next(&batch));
+  TS_ASSERT(!pipeline.next(&batch));
+}
+
+BOOST_AUTO_TEST_CASE(test_destroy_before_end) {
+  // The destructor must not wait for the source to be exhausted.
+  std::atomic<int> num_read(0);
+  int_pipeline::options opts;
+  opts.num_workers = 4;
+  {
+    int_pipeline pipeline([&num_read](int* out) {
+                            *out = num_read++;
+                            return true;
+                          },
+                          [](int x) { return x; }, opts);
+    int batch;
+    TS_ASSERT(pipeline.next(&batch));
+  }
+  TS_ASSERT(num_read.load() > 0);
+}
+
+}  // namespace
+}  // namespace neural_net
+}  // namespace turi
@@ -0,0 +1,184 @@
+/* Copyright © 2019 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define BOOST_TEST_MODULE test_float_array
+
+#include <ml/neural_net/float_array.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+
+namespace turi {
+namespace neural_net {
+namespace {
+
+BOOST_AUTO_TEST_CASE(test_float16_conversion) {
+  const half_float_type f16 = half_float_type::FLOAT16;
+
+  // Exactly representable values.
+  TS_ASSERT_EQUALS(float_to_half(0.f, f16), 0x0000);
+  TS_ASSERT_EQUALS(float_to_half(-0.f, f16), 0x8000);
+  TS_ASSERT_EQUALS(float_to_half(1.f, f16), 0x3c00);
+  TS_ASSERT_EQUALS(float_to_half(-2.f, f16), 0xc000);
+  TS_ASSERT_EQUALS(float_to_half(65504.f, f16), 0x7bff);
+  TS_ASSERT_EQUALS(float_to_half(std::ldexp(1.f, -24), f16), 0x0001);
+  TS_ASSERT_EQUALS(float_to_half(std::ldexp(1.f, -14), f16), 0x0400);
+
+  // Rounding to nearest, ties to even.
+  TS_ASSERT_EQUALS(float_to_half(1.f + std::ldexp(1.f, -11), f16), 0x3c00);
+  TS_ASSERT_EQUALS(float_to_half(1.f + 3 * std::ldexp(1.f, -11), f16), 0x3c02);
+  TS_ASSERT_EQUALS(float_to_half(std::ldexp(1.f, -25), f16), 0x0000);
+  TS_ASSERT_EQUALS(float_to_half(std::ldexp(3.f, -26), f16), 0x0001);
+
+  // Overflow and special values.
+  TS_ASSERT_EQUALS(float_to_half(65520.f, f16), 0x7c00);
+  TS_ASSERT_EQUALS(float_to_half(1e10f, f16), 0x7c00);
+  TS_ASSERT_EQUALS(
+      float_to_half(-std::numeric_limits<float>::infinity(), f16), 0xfc00);
+  TS_ASSERT(std::isnan(half_to_float(
+      float_to_half(std::numeric_limits<float>::quiet_NaN(), f16), f16)));
+
+  // Every finite half value survives the round trip through float.
+  for (uint32_t h = 0; h < 0x10000; ++h) {
+    if ((h & 0x7c00) == 0x7c00) continue;
+    uint16_t value = static_cast<uint16_t>(h);
+    TS_ASSERT_EQUALS(float_to_half(half_to_float(value, f16), f16), value);
+  }
+  TS_ASSERT_EQUALS(half_to_float(0x0001, f16), std::ldexp(1.f, -24));
+  TS_ASSERT_EQUALS(half_to_float(0x3555, f16), 0.333251953125f);
+}
+
+BOOST_AUTO_TEST_CASE(test_bfloat16_conversion) {
+  const half_float_type bf16 = half_float_type::BFLOAT16;
+
+  TS_ASSERT_EQUALS(float_to_half(1.f, bf16), 0x3f80);
+  TS_ASSERT_EQUALS(float_to_half(-2.f, bf16), 0xc000);
+  TS_ASSERT_EQUALS(float_to_half(1e10f, bf16), 0x5015);
+  TS_ASSERT_EQUALS(half_to_float(0x3f80, bf16), 1.f);
+
+  // Ties to even.
+  TS_ASSERT_EQUALS(float_to_half(1.f + std::ldexp(1.f, -8), bf16), 0x3f80);
+  TS_ASSERT_EQUALS(float_to_half(1.f + 3 * std::ldexp(1.f, -8), bf16), 0x3f82);
+
+  TS_ASSERT(std::isnan(half_to_float(
+      float_to_half(std::numeric_limits<float>::quiet_NaN(), bf16), bf16)));
+}
+
+BOOST_AUTO_TEST_CASE(test_half_float_buffer) {
+  std::vector<float> values = {0.5f, -1.25f, 3.f, 1000.f, 0.1f, -7.f};
+  shared_float_array source = shared_float_array::wrap(values, {2, 3});
+
+  for (half_float_type type :
+       {half_float_type::FLOAT16, half_float_type::BFLOAT16}) {
+    half_float_buffer half(source, type);
+    TS_ASSERT(half.type() == type);
+    TS_ASSERT_EQUALS(half.size(), 6);
+    TS_ASSERT_EQUALS(half.dim(), 2);
+    TS_ASSERT_EQUALS(half.shape()[0], 2);
+    TS_ASSERT_EQUALS(half.shape()[1], 3);
+
+    shared_float_array widened = half.to_float();
+    TS_ASSERT_EQUALS(widened.dim(), 2);
+    TS_ASSERT_EQUALS(widened.size(), 6);
+    for (size_t i = 0; i < values.size(); ++i) {
+      TS_ASSERT_EQUALS(widened.data()[i], half.value(i));
+      TS_ASSERT_DELTA(widened.data()[i], values[i],
+                      std::abs(values[i]) / 100);
+    }
+
+    // Copying the raw 16-bit values gives the same array.
+    half_float_buffer copy(half.data(), {6}, type);
+    TS_ASSERT_EQUALS(copy.dim(), 1);
+    TS_ASSERT(std::equal(half.data(), half.data() + 6, copy.data()));
+  }
+
+  // Scalars stay scalars.
+  half_float_buffer scalar(shared_float_array::wrap(2.5f),
+                           half_float_type::FLOAT16);
+  TS_ASSERT_EQUALS(scalar.dim(), 0);
+  TS_ASSERT_EQUALS(scalar.to_float().data()[0], 2.5f);
+}
+
+BOOST_AUTO_TEST_CASE(test_float_buffer_pool_reuses_buffers) {
+  float_buffer_pool pool(2);
+
+  std::vector<float> data = pool.acquire(6);
+  TS_ASSERT_EQUALS(data.size(), 6);
+  data[3] = 1.f;
+  const float* storage = data.data();
+
+  shared_float_array array = pool.wrap(std::move(data), {2, 3});
+  TS_ASSERT_EQUALS(array.data(), storage);
+  TS_ASSERT_EQUALS(array.data()[3], 1.f);
+
+  // Views keep the buffer out of the pool.
+  shared_float_array row = array[1];
+  array = shared_float_array();
+  TS_ASSERT_EQUALS(pool.num_free_buffers(), 0);
+  TS_ASSERT_EQUALS(row.data()[0], 1.f);
+  row = shared_float_array();
+  TS_ASSERT_EQUALS(pool.num_free_buffers(), 1);
+
+  // The storage comes back zeroed, for a request no larger than before.
+  std::vector<float> reused = pool.acquire(4);
+  TS_ASSERT_EQUALS(reused.data(), storage);
+  TS_ASSERT_EQUALS(reused.size(), 4);
+  TS_ASSERT(std::all_of(reused.begin(), reused.end(),
+                        [](float x) { return x == 0.f; }));
+  TS_ASSERT_EQUALS(pool.num_free_buffers(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_float_buffer_pool_best_fit) {
+  float_buffer_pool pool(2);
+
+  std::vector<float> large = pool.acquire(100);
+  std::vector<float> small = pool.acquire(10);
+  const float* large_storage = large.data();
+  const float* small_storage = small.data();
+  pool.wrap(std::move(large), {100});
+  pool.wrap(std::move(small), {10});
+  TS_ASSERT_EQUALS(pool.num_free_buffers(), 2);
+
+  // A small request takes the small buffer, leaving the large one.
+  TS_ASSERT_EQUALS(pool.acquire(5).data(), small_storage);
+  TS_ASSERT_EQUALS(pool.acquire(50).data(), large_storage);
+
+  // Requests larger than every free buffer allocate.
+  pool.wrap(pool.acquire(10), {10});
+  TS_ASSERT_EQUALS(pool.num_free_buffers(), 1);
+  pool.acquire(20);
+  TS_ASSERT_EQUALS(pool.num_free_buffers(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_float_buffer_pool_limits_free_buffers) {
+  float_buffer_pool pool(1);
+  shared_float_array a = pool.wrap(pool.acquire(3), {3});
+  shared_float_array b = pool.wrap(pool.acquire(3), {3});
+  a = shared_float_array();
+  b = shared_float_array();
+  TS_ASSERT_EQUALS(pool.num_free_buffers(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_float_buffer_pool_outlived_by_arrays) {
+  shared_float_array array;
+  {
+    float_buffer_pool pool;
+    std::vector<float> data = pool.acquire(2);
+    data[1] = 2.f;
+    array = pool.wrap(std::move(data), {2});
+  }
+  TS_ASSERT_EQUALS(array.data()[1], 2.f);
+  array = shared_float_array();
+}
+
+}  // namespace
+}  // namespace neural_net
+}  // namespace turi
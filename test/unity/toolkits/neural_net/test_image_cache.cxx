@@ -0,0 +1,90 @@
+/* Copyright © 2019 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define BOOST_TEST_MODULE test_image_cache
+
+#include <ml/neural_net/image_cache.hpp>
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include <core/storage/fileio/fs_utils.hpp>
+#include <core/storage/fileio/temp_files.hpp>
+#include <core/util/test_macros.hpp>
+
+namespace turi {
+namespace neural_net {
+namespace {
+
+flex_image make_image(size_t height, size_t width, unsigned char value) {
+  std::vector<char> buffer(height * width * 3, static_cast<char>(value));
+  return flex_image(buffer.data(), height, width, 3, buffer.size(),
+                    IMAGE_TYPE_CURRENT_VERSION,
+                    static_cast<int>(Format::RAW_ARRAY));
+}
+
+BOOST_AUTO_TEST_CASE(test_image_column_hash) {
+  gl_sarray images({make_image(8, 8, 1), make_image(8, 8, 2)});
+  gl_sarray same({make_image(8, 8, 1), make_image(8, 8, 2)});
+  gl_sarray swapped({make_image(8, 8, 2), make_image(8, 8, 1)});
+  gl_sarray changed({make_image(8, 8, 1), make_image(8, 8, 3)});
+
+  TS_ASSERT_EQUALS(image_column_hash(images), image_column_hash(same));
+  TS_ASSERT_DIFFERS(image_column_hash(images), image_column_hash(swapped));
+  TS_ASSERT_DIFFERS(image_column_hash(images), image_column_hash(changed));
+}
+
+BOOST_AUTO_TEST_CASE(test_resize_images_for_cache) {
+  gl_sarray images({make_image(20, 30, 7), FLEX_UNDEFINED, make_image(8, 4, 9)});
+
+  gl_sframe cached = resize_images_for_cache(images, 6, 5, 3);
+  TS_ASSERT_EQUALS(cached.size(), 3);
+
+  std::vector<std::vector<flexible_type>> rows;
+  for (const auto& row : cached.range_iterator()) {
+    rows.emplace_back(row.begin(), row.end());
+  }
+  size_t image_index = cached.column_index("image");
+  size_t width_index = cached.column_index("original_width");
+  size_t height_index = cached.column_index("original_height");
+
+  const flex_image& first = rows[0][image_index].get<flex_image>();
+  TS_ASSERT(first.is_decoded());
+  TS_ASSERT_EQUALS(first.m_width, 6);
+  TS_ASSERT_EQUALS(first.m_height, 5);
+  TS_ASSERT_EQUALS(static_cast<int>(first.get_image_data()[0]), 7);
+  TS_ASSERT_EQUALS(rows[0][width_index], 30);
+  TS_ASSERT_EQUALS(rows[0][height_index], 20);
+
+  TS_ASSERT_EQUALS(rows[1][image_index].get_type(), flex_type_enum::UNDEFINED);
+  TS_ASSERT_EQUALS(rows[2][width_index], 4);
+  TS_ASSERT_EQUALS(rows[2][height_index], 8);
+}
+
+BOOST_AUTO_TEST_CASE(test_resize_images_for_cache_directory) {
+  const std::string cache_dir = get_temp_name();
+  TS_ASSERT(fileio::create_directory_or_throw(cache_dir));
+
+  gl_sarray images({make_image(20, 30, 7), make_image(8, 4, 9)});
+  gl_sframe first = resize_images_for_cache(images, 6, 5, 3, cache_dir);
+
+  // The second call loads the saved SFrame.
+  gl_sframe second = resize_images_for_cache(images, 6, 5, 3, cache_dir);
+  TS_ASSERT_EQUALS(second.size(), 2);
+  TS_ASSERT_EQUALS(fileio::get_directory_listing(cache_dir).size(), 1);
+
+  // Other images or another size make another entry.
+  resize_images_for_cache(images, 4, 4, 3, cache_dir);
+  gl_sarray other({make_image(20, 30, 8), make_image(8, 4, 9)});
+  resize_images_for_cache(other, 6, 5, 3, cache_dir);
+  TS_ASSERT_EQUALS(fileio::get_directory_listing(cache_dir).size(), 3);
+
+  TS_ASSERT(fileio::delete_path_recursive(cache_dir));
+}
+
+}  // namespace
+}  // namespace neural_net
+}  // namespace turi
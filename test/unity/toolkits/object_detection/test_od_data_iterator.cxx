@@ -120,6 +120,44 @@ BOOST_AUTO_TEST_CASE(test_simple_data_iterator) {
 
 }
 
+BOOST_AUTO_TEST_CASE(test_simple_data_iterator_with_cached_images) {
+
+  static constexpr size_t NUM_ROWS = 6;
+  static constexpr size_t BATCH_SIZE = 4;
+
+  data_iterator::parameters params = create_data(NUM_ROWS);
+  params.cached_image_width = IMAGE_WIDTH / 2;
+  params.cached_image_height = IMAGE_HEIGHT / 4;
+  params.num_prefetch_workers = 2;
+
+  simple_data_iterator data_source(params);
+
+  for (size_t b = 0; b < 3; ++b) {
+    std::vector<labeled_image> batch = data_source.next_batch(BATCH_SIZE);
+    TS_ASSERT_EQUALS(batch.size(), BATCH_SIZE);
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+      const labeled_image& example = batch[i];
+      size_t row = (b * BATCH_SIZE + i) % NUM_ROWS;
+
+      // The images come out decoded, at the cached size.
+      TS_ASSERT(example.image.is_decoded());
+      TS_ASSERT_EQUALS(example.image.m_width, IMAGE_WIDTH / 2);
+      TS_ASSERT_EQUALS(example.image.m_height, IMAGE_HEIGHT / 4);
+      TS_ASSERT_EQUALS(static_cast<size_t>(example.image.get_image_data()[0]),
+                       row % 256);
+
+      // The pixel annotations are still relative to the original size.
+      TS_ASSERT_EQUALS(example.annotations.size(), 1);
+      TS_ASSERT_EQUALS(example.annotations[0].bounding_box,
+                       image_box(static_cast<float>(row % 112) / IMAGE_WIDTH,
+                                 static_cast<float>(row / 112) / IMAGE_HEIGHT,
+                                 16.f / IMAGE_WIDTH,
+                                 16.f / IMAGE_HEIGHT));
+    }
+  }
+}
+
 BOOST_AUTO_TEST_CASE(test_simple_data_iterator_with_different_coordinate_systems) {
 
   auto create_data_opts = [](const std::string annotation_origin,
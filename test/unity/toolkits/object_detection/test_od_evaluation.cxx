@@ -100,6 +100,31 @@ BOOST_AUTO_TEST_CASE(test_nms_with_overlap_across_classes) {
   TS_ASSERT(result[1] == predictions[1]);
 }
 
+BOOST_AUTO_TEST_CASE(test_nms_with_chained_overlaps) {
+
+  // Define three predictions for the same class in a row, each overlapping the
+  // next one, in increasing order of confidence from right to left.
+  std::vector<image_annotation> predictions(3);
+  predictions[0].identifier = 1;
+  predictions[0].confidence = 0.5f;
+  predictions[0].bounding_box = image_box(0.5f, 0.f, 0.4f, 0.4f);
+  predictions[1].identifier = 1;
+  predictions[1].confidence = 0.7f;
+  predictions[1].bounding_box = image_box(0.3f, 0.f, 0.4f, 0.4f);
+  predictions[2].identifier = 1;
+  predictions[2].confidence = 0.9f;
+  predictions[2].bounding_box = image_box(0.1f, 0.f, 0.4f, 0.4f);
+
+  // The middle prediction is suppressed by the most confident one, so it does
+  // not suppress the least confident one, which does not overlap enough with
+  // the most confident one.
+  std::vector<image_annotation> result =
+      apply_non_maximum_suppression(predictions, 0.3f);
+  TS_ASSERT_EQUALS(result.size(), 2);
+  TS_ASSERT(result[0] == predictions[2]);
+  TS_ASSERT(result[1] == predictions[0]);
+}
+
 BOOST_AUTO_TEST_CASE(test_average_precision_iou_threshold) {
 
   // Ground truth label on entire unit square, for convenience.
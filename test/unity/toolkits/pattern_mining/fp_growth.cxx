@@ -6,6 +6,7 @@
 #include <string>
 #include <functional>
 #include <random>
+#include <algorithm>
 
 #include <core/data/sframe/gl_sframe.hpp>
 #include <core/storage/sframe_interface/unity_sframe.hpp>
@@ -361,6 +362,83 @@ struct fp_growth_test  {
 
       }
 
+    void testTOPKAlgorithm7(void){
+      // Check against brute force on enough headings to mine in parallel
+      std::vector<size_t> items = {0, 1, 2, 3, 4, 5, 10, 11, 12};
+      std::vector<std::vector<size_t>> transactions;
+      std::vector<flexible_type> rows;
+      for(size_t i = 0; i < 60; i++){
+        std::vector<size_t> transaction;
+        for(size_t j = 0; j <= i % 6; j++){
+          transaction.push_back(j);
+        }
+        transaction.push_back(10 + i % 3);
+        if(i % 4 == 0){
+          transaction.push_back(11);
+        }
+        std::sort(transaction.begin(), transaction.end());
+        transaction.erase(std::unique(transaction.begin(), transaction.end()),
+                          transaction.end());
+        transactions.push_back(transaction);
+        rows.push_back(flex_list(transaction.begin(), transaction.end()));
+      }
+      gl_sarray database = gl_sarray(rows);
+      size_t min_support = 4;
+
+      // Closed itemsets: no single item can be added keeping the support.
+      auto get_support = [&](const std::vector<size_t>& itemset) {
+        size_t support = 0;
+        for(const auto& transaction: transactions){
+          if(std::includes(transaction.begin(), transaction.end(),
+                           itemset.begin(), itemset.end())){
+            support++;
+          }
+        }
+        return support;
+      };
+      size_t expected_num_closed = 0;
+      for(size_t mask = 1; mask < (size_t(1) << items.size()); mask++){
+        std::vector<size_t> itemset;
+        for(size_t j = 0; j < items.size(); j++){
+          if(mask & (size_t(1) << j)){
+            itemset.push_back(items[j]);
+          }
+        }
+        size_t support = get_support(itemset);
+        if(support < min_support){
+          continue;
+        }
+        bool is_closed = true;
+        for(size_t j = 0; j < items.size(); j++){
+          if(!(mask & (size_t(1) << j))){
+            std::vector<size_t> superset = itemset;
+            superset.push_back(items[j]);
+            std::sort(superset.begin(), superset.end());
+            if(get_support(superset) == support){
+              is_closed = false;
+              break;
+            }
+          }
+        }
+        expected_num_closed += is_closed;
+      }
+
+      fp_top_k_results_tree closed_itemset_tree;
+      closed_itemset_tree = top_k_algorithm(database, min_support);
+      gl_sframe closed_itemset = closed_itemset_tree.get_closed_itemsets();
+
+      TS_ASSERT_EQUALS(min_support, 4);
+      TS_ASSERT_EQUALS(closed_itemset.size(), expected_num_closed);
+      for(const auto& row: closed_itemset.range_iterator()){
+        std::vector<size_t> itemset;
+        for(const auto& item: row[0].get<flex_list>()){
+          itemset.push_back(item.to<size_t>());
+        }
+        std::sort(itemset.begin(), itemset.end());
+        TS_ASSERT_EQUALS(row[1].to<size_t>(), get_support(itemset));
+      }
+    }
+
 
 
 
@@ -400,4 +478,7 @@ BOOST_AUTO_TEST_CASE(testTOPKAlgorithm5) {
 BOOST_AUTO_TEST_CASE(testTOPKAlgorithm6) {
   fp_growth_test::testTOPKAlgorithm6();
 }
+BOOST_AUTO_TEST_CASE(testTOPKAlgorithm7) {
+  fp_growth_test::testTOPKAlgorithm7();
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -11,6 +11,7 @@ const bool enable_expensive_tests = false;
 #include <vector>
 #include <string>
 #include <functional>
+#include <cmath>
 
 #include <core/random/random.hpp>
 
@@ -63,6 +64,18 @@ struct matrix_factorization_tests  {
 
     test_convergence({8, 1}, opts, "mf");
   }
+
+  // // ////////////////////////////////////////////////////////////////////////////////
+
+  void test_mf_se_8_factors_lock_free() {
+    // Hogwild-style updates, without the item locks, must still converge.
+    std::map<std::string, flexible_type> opts = {
+      {"n_observations",      100 },
+      {"num_factors",         8 },
+      {"sgd_lock_free",       true } };
+
+    test_convergence({8, 1}, opts, "mf");
+  }
   // // ////////////////////////////////////////////////////////////////////////////////
 
   void test_mf_se_many_factors() {
@@ -258,6 +271,43 @@ struct regressions  {
     DASSERT_LT(initial_objective, 100);
   }
 
+  void test_ials_cg_matches_ldlt() {
+    std::vector<std::vector<flexible_type> > Xv(300);
+
+    for(size_t i = 0; i < 300; ++i) {
+      Xv[i] = {i % 10, (7 * i) % 30, 1 + (i % 3)};
+    }
+
+    sframe X = make_testing_sframe({"user_id", "item_id", "target"}, Xv);
+
+    // With as many steps as factors, conjugate gradient solves each
+    // system exactly, so both solvers follow the same path.
+    auto final_objective = [&](const std::string& linear_solver) {
+      std::shared_ptr<recsys::recsys_model_base> model(new recsys_ranking_factorization_model);
+
+      model->init_options({
+          {"solver", "ials"},
+          {"ials_linear_solver", linear_solver},
+          {"ials_cg_iterations", 16},
+          {"num_factors", 8},
+          {"max_iterations", 5},
+          {"regularization", 1e-4},
+          {"random_seed", 0}
+        });
+      model->setup_and_train(X);
+
+      std::map<std::string, variant_type> state = model->get_state();
+      auto training_stats
+          = variant_get_value<std::map<std::string, variant_type> >(state["training_stats"]);
+      return variant_get_value<double>(training_stats["final_objective_value"]);
+    };
+
+    double ldlt_objective = final_objective("ldlt");
+    double cg_objective = final_objective("cg");
+
+    TS_ASSERT_DELTA(ldlt_objective, cg_objective, 1e-3 * (1 + std::abs(ldlt_objective)));
+  }
+
   void test_sgd_regularization_oddity() {
 
     // The side column exactly predicts the target column; 
@@ -348,6 +398,9 @@ BOOST_AUTO_TEST_CASE(test_mf_se_mf_no_factors) {
 BOOST_AUTO_TEST_CASE(test_mf_se_8_factors) {
   matrix_factorization_tests::test_mf_se_8_factors();
 }
+BOOST_AUTO_TEST_CASE(test_mf_se_8_factors_lock_free) {
+  matrix_factorization_tests::test_mf_se_8_factors_lock_free();
+}
 BOOST_AUTO_TEST_CASE(test_mf_se_many_factors) {
   matrix_factorization_tests::test_mf_se_many_factors();
 }
@@ -393,6 +446,9 @@ BOOST_FIXTURE_TEST_SUITE(_regressions, regressions)
 BOOST_AUTO_TEST_CASE(test_initialization_regression) {
   regressions::test_initialization_regression();
 }
+BOOST_AUTO_TEST_CASE(test_ials_cg_matches_ldlt) {
+  regressions::test_ials_cg_matches_ldlt();
+}
 BOOST_AUTO_TEST_CASE(test_sgd_regularization_oddity) {
   regressions::test_sgd_regularization_oddity();
 }
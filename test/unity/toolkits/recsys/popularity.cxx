@@ -470,10 +470,97 @@ struct recsys_popularity_test  {
       }
     }
   }
+
+  void test_popularity_update_and_merge() {
+
+    // The second part has new users and new items.
+    std::vector<std::vector<flexible_type> > data_a, data_b, data_all;
+
+    random::seed(1);
+
+    for(size_t i = 0; i < 2000; ++i) {
+      size_t user = random::fast_uniform<size_t>(0, 99);
+      size_t item = random::fast_uniform<size_t>(0, 9);
+      data_a.push_back({user, item, 0.5 * item + (user % 3)});
+    }
+
+    for(size_t i = 0; i < 1000; ++i) {
+      size_t user = random::fast_uniform<size_t>(50, 149);
+      size_t item = random::fast_uniform<size_t>(0, 14);
+      data_b.push_back({user, item, 0.5 * item + (user % 3)});
+    }
+
+    data_all = data_a;
+    data_all.insert(data_all.end(), data_b.begin(), data_b.end());
+
+    std::vector<std::string> names = {"user", "item", "rating"};
+    std::vector<flex_type_enum> types =
+        {flex_type_enum::INTEGER, flex_type_enum::INTEGER, flex_type_enum::FLOAT};
+
+    std::map<std::string, flexible_type> opts =
+        { {"user_id", "user"}, {"item_id", "item"}, {"target", "rating"} };
+
+    auto train_model = [&](const std::vector<std::vector<flexible_type> >& rows) {
+      std::shared_ptr<recsys::recsys_popularity> m(new recsys::recsys_popularity());
+      m->init_options(opts);
+      m->setup_and_train(make_testing_sframe(names, types, rows));
+      return m;
+    };
+
+    auto model_all = train_model(data_all);
+
+    auto model_updated = train_model(data_a);
+    model_updated->update(make_testing_sframe(names, types, data_b));
+
+    auto model_merged = train_model(data_a);
+    model_merged->merge(*train_model(data_b));
+
+    std::vector<std::vector<flexible_type> > pred_rows;
+    for(size_t item = 0; item < 16; ++item) {
+      pred_rows.push_back({0, item});
+    }
+
+    sframe pred_sf = make_testing_sframe(
+        {"user", "item"}, {flex_type_enum::INTEGER, flex_type_enum::INTEGER}, pred_rows);
+
+    auto predictions = [&](const std::shared_ptr<recsys::recsys_popularity>& m) {
+      return testing_extract_column<double>(
+          m->predict(m->create_ml_data(pred_sf)).select_column(0));
+    };
+
+    std::vector<double> expected = predictions(model_all);
+
+    for(const auto& m : {model_updated, model_merged}) {
+      // The new observations are excluded from recommendations.  This
+      // goes first, as predicting indexes the unseen item 15.
+      size_t user = data_b[0][0];
+      std::set<size_t> known;
+      for(const auto& row : data_all) {
+        if(size_t(row[0]) == user) known.insert(size_t(row[1]));
+      }
+
+      sframe query = make_testing_sframe({"user"}, {flex_type_enum::INTEGER}, {{user}});
+      auto recs = testing_extract_sframe_data(m->recommend(query, 15));
+
+      ASSERT_EQ(recs.size(), 15 - known.size());
+      for(const auto& r : recs) {
+        ASSERT_TRUE(known.count(size_t(r[1])) == 0);
+      }
+
+      std::vector<double> actual = predictions(m);
+      ASSERT_EQ(actual.size(), expected.size());
+      for(size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_DELTA(actual[i], expected[i], 1e-8);
+      }
+    }
+  }
 };
 
 BOOST_FIXTURE_TEST_SUITE(_recsys_popularity_test, recsys_popularity_test)
 BOOST_AUTO_TEST_CASE(test_popularity) {
   recsys_popularity_test::test_popularity();
 }
+BOOST_AUTO_TEST_CASE(test_popularity_update_and_merge) {
+  recsys_popularity_test::test_popularity_update_and_merge();
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,167 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <core/random/random.hpp>
+#include <core/storage/sframe_data/testing_utils.hpp>
+#include <core/util/dense_bitset.hpp>
+#include <toolkits/factorization/loss_model_profiles.hpp>
+#include <toolkits/factorization/ranking_sgd_solver_base.hpp>
+#include <toolkits/ml_data_2/metadata.hpp>
+#include <toolkits/ml_data_2/ml_data.hpp>
+#include <toolkits/sgd/sgd_interface.hpp>
+
+using namespace turi;
+
+/**
+ * An interface scoring every candidate the same, so that the negative
+ * example chosen is the first candidate drawn.
+ */
+class constant_score_interface : public sgd::sgd_interface_base {
+ public:
+  void setup_optimization(size_t, bool) {}
+  double calculate_loss(const v2::ml_data&) const { return 0; }
+  double reported_loss_value(double loss) const { return loss; }
+  std::string reported_loss_name() const { return "loss"; }
+  double current_regularization_penalty() const { return 0; }
+  double apply_sgd_step(size_t, const std::vector<v2::ml_data_entry>&,
+                        double, double) { return 0; }
+
+  double calculate_fx(size_t, const std::vector<v2::ml_data_entry>&) const {
+    return 0;
+  }
+
+  factorization::loss_squared_error loss_model;
+};
+
+/**
+ * Exposes the negative example sampling of the ranking solvers.
+ */
+class negative_sampling_solver
+    : public factorization::ranking_sgd_solver_base<constant_score_interface> {
+  typedef factorization::ranking_sgd_solver_base<constant_score_interface> Base;
+
+ public:
+  negative_sampling_solver(const std::shared_ptr<constant_score_interface>& iface,
+                           const v2::ml_data& data,
+                           const std::map<std::string, flexible_type>& options)
+      : Base(iface, data, options)
+      , m_iface(iface)
+  {}
+
+  /** Samples the negative item of one observation of a user.
+   */
+  size_t sample_negative_item(const v2::ml_data& data,
+                              const std::vector<v2::ml_data_entry>& x,
+                              const dense_bitset& item_observed,
+                              size_t n_items, size_t n_rated_items) {
+    std::vector<v2::ml_data_entry> negative_x;
+    double fx = this->choose_negative_example(
+        0, data, m_iface.get(), negative_x, x, item_observed,
+        1, n_items, n_rated_items, m_proc_buf);
+    TS_ASSERT(std::isfinite(fx));
+    return negative_x[1].index;
+  }
+
+ private:
+  std::pair<double, double> run_sgd_thread(
+      size_t, size_t, size_t, size_t, size_t, const v2::ml_data&,
+      constant_score_interface*, double, volatile bool&) {
+    return {0, 0};
+  }
+
+  std::pair<double, double> run_loss_calculation_thread(
+      size_t, size_t, const v2::ml_data&, constant_score_interface*) const {
+    return {0, 0};
+  }
+
+  std::shared_ptr<constant_score_interface> m_iface;
+  neg_sample_proc_buffer m_proc_buf;
+};
+
+struct ranking_negative_sampling_test {
+ public:
+
+  /**
+   * Returns the fraction of the negative items drawn for user "u0" which
+   * are the popular item, sampling with the given popularity power.
+   *
+   * "popular" is rated by 50 users and "i0", ..., "i18" by one user each.
+   * "u0" rated only "i18", so the popular item is 1 of the 19 it can draw.
+   */
+  double popular_item_fraction(double popularity_power) {
+    std::vector<std::vector<flexible_type> > rows;
+    rows.push_back({"u0", "i18"});
+    for (size_t u = 1; u <= 50; ++u) {
+      rows.push_back({"u" + std::to_string(u), "popular"});
+    }
+    for (size_t i = 0; i < 18; ++i) {
+      rows.push_back({"u51", "i" + std::to_string(i)});
+    }
+    sframe raw_data = make_testing_sframe(
+        {"user_id", "item_id"},
+        {flex_type_enum::STRING, flex_type_enum::STRING}, rows);
+
+    v2::ml_data data;
+    data.fill(raw_data);
+
+    const auto& user_indexer = data.metadata()->indexer(0);
+    const auto& item_indexer = data.metadata()->indexer(1);
+    size_t n_items = data.metadata()->index_size(1);
+    TS_ASSERT_EQUALS(n_items, 20);
+
+    size_t user = user_indexer->immutable_map_value_to_index("u0");
+    size_t rated_item = item_indexer->immutable_map_value_to_index("i18");
+    size_t popular_item = item_indexer->immutable_map_value_to_index("popular");
+
+    std::map<std::string, flexible_type> options = {
+      {"num_sampled_negative_examples", 1},
+      {"random_seed", 0},
+      {"negative_sample_popularity_power", popularity_power}};
+
+    auto iface = std::make_shared<constant_score_interface>();
+    negative_sampling_solver solver(iface, data, options);
+
+    dense_bitset item_observed(n_items);
+    item_observed.clear();
+    item_observed.set_bit(rated_item);
+    std::vector<v2::ml_data_entry> x = {{0, user, 1}, {1, rated_item, 1}};
+
+    random::seed(0);
+    const size_t num_samples = 2000;
+    size_t num_popular = 0;
+    for (size_t i = 0; i < num_samples; ++i) {
+      size_t item = solver.sample_negative_item(data, x, item_observed, n_items, 1);
+      TS_ASSERT_DIFFERS(item, rated_item);
+      if (item == popular_item) ++num_popular;
+    }
+    return double(num_popular) / num_samples;
+  }
+
+  void test_uniform_sampling() {
+    // 1 in 19 when uniform
+    TS_ASSERT_LESS_THAN(popular_item_fraction(0), 0.15);
+  }
+
+  void test_popularity_sampling() {
+    // weights (50 + 1) for the popular item and (1 + 1) for the 18 others
+    // it can draw, so 51 / 87 of the draws
+    double fraction = popular_item_fraction(1);
+    TS_ASSERT_LESS_THAN(0.5, fraction);
+    TS_ASSERT_LESS_THAN(fraction, 0.67);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_ranking_negative_sampling_test, ranking_negative_sampling_test)
+BOOST_AUTO_TEST_CASE(test_uniform_sampling) {
+  ranking_negative_sampling_test::test_uniform_sampling();
+}
+BOOST_AUTO_TEST_CASE(test_popularity_sampling) {
+  ranking_negative_sampling_test::test_popularity_sampling();
+}
+BOOST_AUTO_TEST_SUITE_END()
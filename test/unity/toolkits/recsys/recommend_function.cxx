@@ -8,6 +8,7 @@
 #include <core/util/test_macros.hpp>
 #include <vector>
 #include <string>
+#include <map>
 
 #include <core/random/random.hpp>
 
@@ -606,6 +607,115 @@ struct recsys_recommend  {
   void test_diversity_itemcf() {
     _run_test_diversity<recsys::recsys_itemcf>();
   }
+
+  // Scoring blocks of users gives the same recommendations as scoring
+  // the items of each user one at a time.
+  void test_block_scoring_mf() {
+
+    sframe data = make_random_sframe(1000, "CC");
+
+    data.set_column_name(0, "user");
+    data.set_column_name(1, "item");
+
+    std::unique_ptr<recsys::recsys_model_base> model(
+        new recsys::recsys_ranking_factorization_model);
+
+    std::map<std::string, flexible_type> opts;
+    opts["item_id"] = "item";
+    opts["user_id"] = "user";
+    opts["target"] = "";
+    model->init_options(opts);
+
+    model->setup_and_train(data);
+
+    ASSERT_TRUE(model->can_score_users_in_blocks());
+
+    // Restricting to all the items forces the per-user path.
+    sframe all_items = data.select_columns({"item"});
+    sframe pairs = data.select_columns({"user", "item"});
+
+    for(bool exclude_training : {true, false}) {
+      sframe exclusions = exclude_training ? sframe() : pairs;
+
+      sframe res_block = model->recommend(sframe(), 10, sframe(), exclusions,
+                                          sframe(), sframe(), sframe(), exclude_training);
+
+      sframe res_single = model->recommend(sframe(), 10, all_items, exclusions,
+                                           sframe(), sframe(), sframe(), exclude_training);
+
+      std::vector<flex_list> res = testing_extract_sframe_data(res_block);
+      std::vector<flex_list> res_2 = testing_extract_sframe_data(res_single);
+
+      ASSERT_EQ(res.size(), res_2.size());
+
+      for(size_t i = 0; i < res.size(); ++i) {
+        ASSERT_TRUE(res[i][0] == res_2[i][0]);
+        ASSERT_TRUE(res[i][1] == res_2[i][1]);
+        ASSERT_TRUE(res[i][3] == res_2[i][3]);
+        ASSERT_LT(std::abs(res[i][2].to<double>() - res_2[i][2].to<double>()), 1e-4);
+      }
+    }
+  }
+
+  // The item index recommends nearly the same items as scoring every
+  // item, with the same scores.
+  void test_item_index_recall() {
+
+    sframe data = make_random_sframe(5000, "CC");
+
+    data.set_column_name(0, "user");
+    data.set_column_name(1, "item");
+
+    std::unique_ptr<recsys::recsys_factorization_model_base> model(
+        new recsys::recsys_ranking_factorization_model);
+
+    std::map<std::string, flexible_type> opts;
+    opts["item_id"] = "item";
+    opts["user_id"] = "user";
+    opts["target"] = "";
+    model->init_options(opts);
+
+    model->setup_and_train(data);
+
+    const size_t top_k = 10;
+
+    sframe res_exact = model->recommend(sframe(), top_k);
+
+    model->build_item_index({{"ef_search", 100}});
+
+    sframe res_index = model->recommend(sframe(), top_k);
+
+    std::vector<flex_list> res = testing_extract_sframe_data(res_exact);
+    std::vector<flex_list> res_2 = testing_extract_sframe_data(res_index);
+
+    ASSERT_EQ(res.size(), res_2.size());
+
+    std::map<std::pair<flexible_type, flexible_type>, double> exact_scores;
+
+    for(const auto& row : res) {
+      exact_scores[{row[0], row[1]}] = row[2].to<double>();
+    }
+
+    size_t num_found = 0;
+    for(const auto& row : res_2) {
+      auto it = exact_scores.find({row[0], row[1]});
+      if(it != exact_scores.end()) {
+        ++num_found;
+        ASSERT_LT(std::abs(it->second - row[2].to<double>()), 1e-4);
+      }
+    }
+
+    ASSERT_GE(num_found, 0.9 * res.size());
+
+    // Without the index, every item is scored again.
+    model->clear_item_index();
+    std::vector<flex_list> res_3 = testing_extract_sframe_data(model->recommend(sframe(), top_k));
+
+    ASSERT_EQ(res.size(), res_3.size());
+    for(size_t i = 0; i < res.size(); ++i) {
+      ASSERT_TRUE(res[i][1] == res_3[i][1]);
+    }
+  }
   
 }; 
 
@@ -634,4 +744,10 @@ BOOST_AUTO_TEST_CASE(test_diversity_mf) {
 BOOST_AUTO_TEST_CASE(test_diversity_itemcf) {
   recsys_recommend::test_diversity_itemcf();
 }
+BOOST_AUTO_TEST_CASE(test_block_scoring_mf) {
+  recsys_recommend::test_block_scoring_mf();
+}
+BOOST_AUTO_TEST_CASE(test_item_index_recall) {
+  recsys_recommend::test_item_index_recall();
+}
 BOOST_AUTO_TEST_SUITE_END()
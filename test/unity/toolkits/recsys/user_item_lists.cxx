@@ -112,6 +112,32 @@ struct user_item_lists  {
         ASSERT_DELTA(p.second, known_user_item_lists[user][(size_t)p.first], 1e-6);
       }
     }
+
+    // The in-memory sets must hold the same items.
+    size_t num_items = data.metadata()->column_size(1);
+    user_item_sets sets(test_list_sarray, num_items);
+
+    ASSERT_EQ(sets.num_users(), test_lists.size());
+
+    std::vector<size_t> items;
+    for(size_t user = 0; user < test_lists.size(); ++user) {
+      items.clear();
+      sets.append_items(user, items);
+
+      ASSERT_EQ(items.size(), known_user_item_lists[user].size());
+
+      size_t i = 0;
+      for(const auto& p : known_user_item_lists[user]) {
+        ASSERT_EQ(items[i++], p.first);
+        ASSERT_TRUE(sets.contains(user, p.first));
+      }
+
+      for(size_t item = 0; item < std::min<size_t>(num_items, 64); ++item) {
+        ASSERT_EQ(sets.contains(user, item), known_user_item_lists[user].count(item) != 0);
+      }
+    }
+
+    ASSERT_FALSE(sets.contains(test_lists.size(), 0));
   }
 
   void test_small_1() {
@@ -8,6 +8,7 @@
 #include <core/util/test_macros.hpp>
 #include <vector>
 #include <string>
+#include <set>
 #include <core/random/random.hpp>
 #include <core/storage/sframe_data/testing_utils.hpp>
 #include <core/util/testing_utils.hpp>
@@ -41,9 +42,9 @@ void run_test(
                              * (std::max<size_t>(16, (data.size() / 4))));
 
   std::vector<std::string> training_methods =
-    {"auto", "dense", "sparse",
+    {"auto", "dense", "sparse", "hybrid",
      "nn",
-     "nn:dense", "nn:sparse"};
+     "nn:dense", "nn:sparse", "nn:hybrid"};
 
 
   std::vector<std::shared_ptr<sparse_similarity_lookup> > models;
@@ -99,7 +100,7 @@ void run_approximation_tests(
                              * (std::max<size_t>(16, (data.size() / 4))));
 
   std::vector<std::string> training_methods =
-      {"dense", "sparse"};
+      {"dense", "sparse", "hybrid"};
 
   for(size_t degree_approximation_threshold = 10;
       degree_approximation_threshold < 50;
@@ -127,6 +128,64 @@ void run_approximation_tests(
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+
+/** Train on part of the data, update with the rest, and check that the
+ *  result is the same as training on all of it.
+ */
+void run_update_test(const std::string& similarity,
+                     size_t n, size_t m, double p,
+                     bool allow_negative, bool binary) {
+
+  random::seed(n*m + 17);
+
+  auto data = generate(n, m, p, allow_negative, binary);
+
+  size_t num_items = 0;
+  for(const auto& row : data) {
+    for(const auto& p : row) {
+      num_items = std::max(num_items, p.first + 1);
+    }
+  }
+
+  // Hold out about 5% of the interactions, and all of the last item.
+  std::vector<std::vector<std::pair<size_t, double> > > old_data(data.size());
+  std::set<size_t> updated_items;
+
+  for(size_t i = 0; i < data.size(); ++i) {
+    for(const auto& p : data[i]) {
+      if(p.first + 1 == num_items || random::fast_uniform<size_t>(0, 19) == 0) {
+        updated_items.insert(p.first);
+      } else {
+        old_data[i].push_back(p);
+      }
+    }
+  }
+
+  std::map<std::string, flexible_type> options = {
+    { "max_data_passes", 20},
+    { "max_item_neighborhood_size", num_items},
+    { "degree_approximation_threshold", 2048},
+    { "target_memory_usage", size_t(1024*1024*1024)},
+    { "threshold", 0},
+    { "sparse_density_estimation_sample_size", 10*1024 },
+    { "training_method", "auto" } };
+
+  auto model = sparse_similarity_lookup::create(similarity, options);
+  model->train_from_sparse_matrix_sarray(num_items - 1, make_testing_sarray(old_data));
+
+  auto data_sa = make_testing_sarray(data);
+
+  model->update_from_sparse_matrix_sarray(
+      num_items, data_sa,
+      std::vector<size_t>(updated_items.begin(), updated_items.end()));
+
+  auto full_model = sparse_similarity_lookup::create(similarity, options);
+  full_model->train_from_sparse_matrix_sarray(num_items, data_sa);
+
+  TS_ASSERT(full_model->_debug_check_equal(*model));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 void run_random_test(const std::string& similarity,
@@ -233,6 +292,18 @@ struct item_sim_consistency {
   }
 
 
+  void test_update_jaccard() {
+    run_update_test("jaccard", 200, 50, 0.2, false, true);
+  }
+
+  void test_update_cosine() {
+    run_update_test("cosine", 200, 50, 0.2, true, false);
+  }
+
+  void test_update_pearson() {
+    run_update_test("pearson", 200, 50, 0.2, true, false);
+  }
+
   void test_regression_cosine_finalize_prediction_correctness() {
     turi::sparse_sim::cosine cs_sim;
 
@@ -294,6 +365,15 @@ BOOST_AUTO_TEST_CASE(test_random_3_pearson_1000m25) {
 BOOST_AUTO_TEST_CASE(test_random_4_pearson_4000m100) {
   item_sim_consistency::test_random_4_pearson_4000m100();
 }
+BOOST_AUTO_TEST_CASE(test_update_jaccard) {
+  item_sim_consistency::test_update_jaccard();
+}
+BOOST_AUTO_TEST_CASE(test_update_cosine) {
+  item_sim_consistency::test_update_cosine();
+}
+BOOST_AUTO_TEST_CASE(test_update_pearson) {
+  item_sim_consistency::test_update_pearson();
+}
 BOOST_AUTO_TEST_CASE(test_regression_cosine_finalize_prediction_correctness) {
   item_sim_consistency::test_regression_cosine_finalize_prediction_correctness();
 }
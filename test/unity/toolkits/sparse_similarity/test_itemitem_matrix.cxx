@@ -18,6 +18,8 @@
 #include <toolkits/sparse_similarity/sliced_itemitem_matrix.hpp>
 #include <core/util/cityhash_tc.hpp>
 #include <core/parallel/lambda_omp.hpp>
+#include <core/parallel/pthread_tools.hpp>
+#include <mutex>
 
 using namespace turi;
 using namespace turi::sparse_sim;
@@ -113,6 +115,53 @@ struct test_itemitem_matrix  {
         DASSERT_EQ(value, i + j);
       });
   }
+
+  void _test_hybrid_access(size_t num_items, size_t n, size_t m) {
+    std::vector<size_t> dense_items;
+    for(size_t i = 0; i < num_items; i += 3) {
+      dense_items.push_back(i);
+    }
+
+    hybrid_triangular_itemitem_container<size_t> X;
+    X.set_dense_items(num_items, dense_items);
+    X.resize(n, m);
+
+    TS_ASSERT_EQUALS(X.rows(), n);
+    TS_ASSERT_EQUALS(X.cols(), m);
+
+    parallel_for(size_t(0), n, [&](size_t i) {
+        for(size_t j = i + 1; j < m; ++j) {
+          X.apply(i, j, [&](size_t& value) { value += hash64(i, j); });
+        }
+      });
+
+    std::vector<int> hit(n * m, 0);
+    simple_spinlock hit_lock;
+
+    X.apply_all([&](size_t i, size_t j, size_t value) {
+        std::lock_guard<simple_spinlock> lg(hit_lock);
+        DASSERT_LT(i, n);
+        DASSERT_LT(j, m);
+        DASSERT_LT(i, j);
+
+        ++hit[i * m + j];
+        DASSERT_EQ(value, hash64(i, j));
+      });
+
+    for(size_t i = 0; i < n; ++i) {
+      for(size_t j = 0; j < m; ++j) {
+        DASSERT_EQ(hit[i * m + j], (i < j) ? 1 : 0);
+      }
+    }
+  }
+
+  void test_hybrid_full() {
+    _test_hybrid_access(20, 20, 20);
+  }
+
+  void test_hybrid_slice() {
+    _test_hybrid_access(50, 7, 23);
+  }
 };
 
 BOOST_FIXTURE_TEST_SUITE(_test_itemitem_matrix, test_itemitem_matrix)
@@ -134,4 +183,10 @@ BOOST_AUTO_TEST_CASE(test_nonsymmetric_19_20) {
 BOOST_AUTO_TEST_CASE(test_parallel_access) {
   test_itemitem_matrix::test_parallel_access();
 }
+BOOST_AUTO_TEST_CASE(test_hybrid_full) {
+  test_itemitem_matrix::test_hybrid_full();
+}
+BOOST_AUTO_TEST_CASE(test_hybrid_slice) {
+  test_itemitem_matrix::test_hybrid_slice();
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -7,6 +7,7 @@
 #include <core/storage/sframe_interface/unity_sframe.hpp>
 #include <core/storage/sframe_data/sframe.hpp>
 
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <core/random/random.hpp>
@@ -119,6 +120,52 @@ BOOST_AUTO_TEST_CASE(test_roc_curve) {
     //sf.debug_print();
 }
 
+BOOST_AUTO_TEST_CASE(test_auc_parallel_binned) {
+    size_t num_observations = 200000;
+    random::seed(0);
+
+    std::vector<flexible_type> predictions(num_observations);
+    std::vector<flexible_type> targets(num_observations);
+    std::vector<std::pair<double, size_t>> scored(num_observations);
+    for (size_t i = 0; i < num_observations; ++i) {
+      size_t target = random::fast_uniform<size_t>(0, 1);
+      double pred = 0.5 * random::fast_uniform<double>(0, 1) + 0.3 * target;
+      targets[i] = target;
+      predictions[i] = pred;
+      scored[i] = {pred, target};
+    }
+
+    // Exact AUC: the fraction of (positive, negative) pairs ranked in order.
+    std::sort(scored.begin(), scored.end());
+    double num_pos = 0, num_neg = 0, ordered_pairs = 0;
+    for (const auto& p : scored) {
+      if (p.second == 1) {
+        num_pos += 1;
+        ordered_pairs += num_neg;
+      } else {
+        num_neg += 1;
+      }
+    }
+    double true_auc = ordered_pairs / (num_pos * num_neg);
+
+    std::shared_ptr<unity_sarray> unity_targets_sa = std::make_shared<unity_sarray>();
+    unity_targets_sa->construct_from_sarray(
+        make_testing_sarray(flex_type_enum::INTEGER, targets));
+    std::shared_ptr<unity_sarray> unity_predictions_sa = std::make_shared<unity_sarray>();
+    unity_predictions_sa->construct_from_sarray(
+        make_testing_sarray(flex_type_enum::FLOAT, predictions));
+
+    for (size_t num_bins : {1000, 100000}) {
+      std::map<std::string, flexible_type> kwargs {
+                 {"average", FLEX_UNDEFINED},
+                 {"binary", true},
+                 {"num_bins", num_bins}};
+      variant_type result = evaluation::_supervised_streaming_evaluator(
+               unity_targets_sa, unity_predictions_sa, "auc", kwargs);
+      TS_ASSERT_LESS_THAN(std::abs(variant_get_value<double>(result) - true_auc),
+                          2.0 / num_bins);
+    }
+}
 
 BOOST_AUTO_TEST_CASE(test_accuracy) {
     size_t num_observations = 5000;
@@ -186,6 +186,42 @@ struct topic_model_test {
 
   }
 
+  void test_topic_model_alias_sampler() {
+
+    // Initialize topic model with the above SArray
+    std::map<std::string, flexible_type> options;
+    options["verbose"] = false;
+    options["num_topics"] = 3;
+    options["num_iterations"] = 50;
+    options["print_interval"] = 10;
+    options["num_burnin"] = 3;
+    options["alpha"] = .1;
+    options["beta"] = .01;
+    options["sampler"] = "alias";
+    auto dataset = sa->get_underlying_sarray();
+
+    std::shared_ptr<cgs_topic_model> m;
+    m.reset(new cgs_topic_model);
+    m->init_options(options);
+    m->init_validation(dataset, dataset);
+    m->train(dataset, false);
+    TS_ASSERT(m->is_trained());
+
+    // Test retrieval of most probable words per topic
+    for (size_t topic_id = 0; topic_id < 3; ++topic_id) {
+      auto top_words = m->get_topic(topic_id, 2);
+      TS_ASSERT_EQUALS(top_words.first.size(), 2);
+      TS_ASSERT(top_words.second[0] >= top_words.second[1]);
+      TS_ASSERT(top_words.second[0] + top_words.second[1] <= 1.0);
+    }
+
+    // Continue from the learned topics.
+    m->set_topics(m->get_topics_matrix(), m->get_vocabulary(), 1000);
+    m->train(dataset, false);
+    auto pred_counts = m->predict_counts(dataset, 10);
+    TS_ASSERT_EQUALS(pred_counts.rows(), dataset->size());
+  }
+
   void test_alias_solver() {
     // Initialize topic model with the above SArray
     std::map<std::string, flexible_type> options;
@@ -248,6 +284,9 @@ BOOST_AUTO_TEST_CASE(test_sparse_mat) {
 BOOST_AUTO_TEST_CASE(test_topic_model) {
   topic_model_test::test_topic_model();
 }
+BOOST_AUTO_TEST_CASE(test_topic_model_alias_sampler) {
+  topic_model_test::test_topic_model_alias_sampler();
+}
 BOOST_AUTO_TEST_CASE(test_alias_solver) {
   topic_model_test::test_alias_solver();
 }
@@ -196,7 +196,45 @@ struct unity_sketch_test {
     std::shared_ptr<unity_sketch_base> sketch(new unity_sketch);
     std::static_pointer_cast<unity_sketch>(sketch)->construct_from_sarray(intl);
   }
-  
+
+  void test_cached_vector_sketch() {
+    std::shared_ptr<unity_sarray_base> vecs(new unity_sarray);
+    std::vector<flexible_type> vec;
+    for (size_t i = 0; i < 20000; ++i) {
+      if (i % 10 == 0) {
+        vec.emplace_back(flex_type_enum::UNDEFINED);
+      } else {
+        vec.emplace_back(flex_vec{double(i % 7), double(i % 3)});
+      }
+    }
+    std::static_pointer_cast<unity_sarray>(vecs)->construct_from_vector(vec, flex_type_enum::VECTOR);
+
+    std::vector<flexible_type> keys = {flex_int(1)};
+    std::shared_ptr<unity_sketch> first(new unity_sketch);
+    first->construct_from_sarray(vecs, false, keys);
+    std::shared_ptr<unity_sketch> second(new unity_sketch);
+    second->construct_from_sarray(vecs, false, keys);
+
+    for (auto sketch : {first, second}) {
+      TS_ASSERT(sketch->sketch_ready());
+      TS_ASSERT_EQUALS(sketch->size(), 20000);
+      TS_ASSERT_EQUALS(sketch->num_undefined(), 2000);
+
+      auto elements = sketch->element_summary();
+      TS_ASSERT_EQUALS(elements->size(), 36000);
+      TS_ASSERT_EQUALS(elements->min(), 0.0);
+      TS_ASSERT_EQUALS(elements->max(), 6.0);
+
+      auto sub_sketches = sketch->element_sub_sketch({});
+      TS_ASSERT_EQUALS(sub_sketches.size(), 1);
+      auto column = sub_sketches[flex_int(1)];
+      TS_ASSERT_EQUALS(column->num_undefined(), 2000);
+      TS_ASSERT_EQUALS(column->get_quantile(0.0), 0.0);
+      TS_ASSERT_EQUALS(column->get_quantile(1.0), 2.0);
+    }
+    TS_ASSERT_EQUALS(first->element_summary()->num_unique(),
+                     second->element_summary()->num_unique());
+  }
 };
 
 BOOST_FIXTURE_TEST_SUITE(_unity_sketch_test, unity_sketch_test)
@@ -221,4 +259,7 @@ BOOST_AUTO_TEST_CASE(test_nan_handling_3) {
 BOOST_AUTO_TEST_CASE(test_int_regression_case_1) {
   unity_sketch_test::test_int_regression_case_1();
 }
+BOOST_AUTO_TEST_CASE(test_cached_vector_sketch) {
+  unity_sketch_test::test_cached_vector_sketch();
+}
 BOOST_AUTO_TEST_SUITE_END()
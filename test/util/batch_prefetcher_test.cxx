@@ -0,0 +1,79 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <stdexcept>
+#include <core/util/batch_prefetcher.hpp>
+
+using namespace turi;
+
+
+struct batch_prefetcher_test {
+
+ public:
+
+  // a generator of the integers [0, n)
+  static batch_prefetcher<size_t>::generator_type counter(size_t n, size_t* next) {
+    return [=](std::vector<size_t>& batch, size_t len) {
+      while (batch.size() < len && *next < n) batch.push_back((*next)++);
+    };
+  }
+
+  void test_sequence() {
+    for (size_t max_batches : {0, 1, 3}) {
+      size_t next = 0;
+      batch_prefetcher<size_t> prefetcher(counter(1000, &next), max_batches);
+      // lengths which do not match the batches already produced
+      size_t expected = 0;
+      for (size_t len : {1, 7, 100, 3, 64, 500}) {
+        auto values = prefetcher.get_next(len);
+        TS_ASSERT_EQUALS(values.size(), len);
+        for (size_t v : values) TS_ASSERT_EQUALS(v, expected++);
+      }
+      auto values = prefetcher.get_next(1000);
+      TS_ASSERT_EQUALS(values.size(), 1000 - expected);
+      for (size_t v : values) TS_ASSERT_EQUALS(v, expected++);
+      TS_ASSERT_EQUALS(prefetcher.get_next(10).size(), 0);
+    }
+  }
+
+  void test_stop_early() {
+    // destroying the prefetcher stops the producer before the end
+    size_t next = 0;
+    {
+      batch_prefetcher<size_t> prefetcher(counter(size_t(-1), &next), 2);
+      TS_ASSERT_EQUALS(prefetcher.get_next(10).size(), 10);
+    }
+    // the read ahead is bounded by the number of batches
+    TS_ASSERT_LESS_THAN_EQUALS(next, 40);
+  }
+
+  void test_exception() {
+    size_t next = 0;
+    auto count = counter(100, &next);
+    batch_prefetcher<size_t> prefetcher(
+        [&](std::vector<size_t>& batch, size_t len) {
+          if (next >= 20) throw std::runtime_error("read failure");
+          count(batch, len);
+        }, 2);
+    TS_ASSERT_EQUALS(prefetcher.get_next(10).size(), 10);
+    TS_ASSERT_EQUALS(prefetcher.get_next(10).size(), 10);
+    TS_ASSERT_THROWS_ANYTHING(prefetcher.get_next(10));
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_batch_prefetcher_test, batch_prefetcher_test)
+BOOST_AUTO_TEST_CASE(test_sequence) {
+  batch_prefetcher_test::test_sequence();
+}
+BOOST_AUTO_TEST_CASE(test_stop_early) {
+  batch_prefetcher_test::test_stop_early();
+}
+BOOST_AUTO_TEST_CASE(test_exception) {
+  batch_prefetcher_test::test_exception();
+}
+BOOST_AUTO_TEST_SUITE_END()
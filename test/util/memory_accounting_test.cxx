@@ -0,0 +1,114 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <core/globals/memory_accounting.hpp>
+#include <core/parallel/lambda_omp.hpp>
+
+using namespace turi;
+using namespace turi::memory_accounting;
+
+
+struct memory_accounting_test {
+
+ public:
+
+  void test_tag() {
+    memory_tag& tag = get_tag("test_tag");
+    // the same name returns the same tag
+    TS_ASSERT_EQUALS(&tag, &get_tag("test_tag"));
+
+    parallel_for(size_t(0), size_t(1000), [&](size_t) {
+      tag.allocate(10);
+      tag.release(10);
+    });
+    TS_ASSERT_EQUALS(tag.current(), 0);
+    TS_ASSERT_LESS_THAN(0, tag.peak());
+
+    tag.allocate(100);
+    tag.allocate(50);
+    tag.release(120);
+    TS_ASSERT_EQUALS(tag.current(), 30);
+    TS_ASSERT(tag.peak() >= 150);
+
+    TS_ASSERT_EQUALS(get_usage()["test_tag"].current, 30);
+    reset_peaks();
+    TS_ASSERT_EQUALS(tag.peak(), 30);
+    tag.release(30);
+  }
+
+  void test_tagged_memory() {
+    memory_tag& tag = get_tag("test_tagged_memory");
+    {
+      tagged_memory m(tag);
+      m.add(100);
+      m.set(40);
+      TS_ASSERT_EQUALS(tag.current(), 40);
+
+      // copies hold their own bytes
+      tagged_memory copy(m);
+      TS_ASSERT_EQUALS(copy.size(), 40);
+      TS_ASSERT_EQUALS(tag.current(), 80);
+    }
+    TS_ASSERT_EQUALS(tag.current(), 0);
+    TS_ASSERT_EQUALS(tag.peak(), 100);
+  }
+
+  void test_high_water_scope() {
+    memory_tag& held = get_tag("test_scope_held");
+    memory_tag& grown = get_tag("test_scope_grown");
+    held.allocate(1000);
+
+    high_water_scope outer;
+    {
+      high_water_scope inner;
+      // below what was held when the scopes were opened
+      held.release(500);
+      held.allocate(200);
+
+      grown.allocate(300);
+      grown.release(300);
+      grown.allocate(100);
+
+      auto peaks = inner.peaks();
+      TS_ASSERT_EQUALS(peaks.count("test_scope_held"), 0);
+      TS_ASSERT_EQUALS(peaks["test_scope_grown"], 300);
+    }
+
+    // tags registered after a scope is opened count from nothing
+    get_tag("test_scope_new").allocate(64);
+    held.allocate(400);
+
+    auto peaks = outer.peaks();
+    TS_ASSERT_EQUALS(peaks["test_scope_held"], 1100);
+    TS_ASSERT_EQUALS(peaks["test_scope_grown"], 300);
+    TS_ASSERT_EQUALS(peaks["test_scope_new"], 64);
+    TS_ASSERT(outer.summary().find("test_scope_new: 64 B") != std::string::npos);
+  }
+
+  void test_format_bytes() {
+    TS_ASSERT_EQUALS(format_bytes(0), "0 B");
+    TS_ASSERT_EQUALS(format_bytes(1023), "1023 B");
+    TS_ASSERT_EQUALS(format_bytes(1536), "1.5 KB");
+    TS_ASSERT_EQUALS(format_bytes(size_t(3) << 30), "3.0 GB");
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_memory_accounting_test, memory_accounting_test)
+BOOST_AUTO_TEST_CASE(test_tag) {
+  memory_accounting_test::test_tag();
+}
+BOOST_AUTO_TEST_CASE(test_tagged_memory) {
+  memory_accounting_test::test_tagged_memory();
+}
+BOOST_AUTO_TEST_CASE(test_high_water_scope) {
+  memory_accounting_test::test_high_water_scope();
+}
+BOOST_AUTO_TEST_CASE(test_format_bytes) {
+  memory_accounting_test::test_format_bytes();
+}
+BOOST_AUTO_TEST_SUITE_END()
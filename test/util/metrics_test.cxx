@@ -0,0 +1,101 @@
+/* Copyright © 2017 Apple Inc. All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-3-clause license that can
+ * be found in the LICENSE.txt file or at https://opensource.org/licenses/BSD-3-Clause
+ */
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <core/globals/metrics.hpp>
+#include <core/data/flexible_type/flexible_type.hpp>
+#include <core/parallel/lambda_omp.hpp>
+
+using namespace turi;
+
+
+struct metrics_test {
+
+ public:
+
+  void test_counter() {
+    metrics::counter& c = metrics::get_counter("test_counter", "A test counter.");
+    // the same name returns the same counter
+    TS_ASSERT_EQUALS(&c, &metrics::get_counter("test_counter"));
+
+    parallel_for(size_t(0), size_t(100000), [&](size_t) { ++c; });
+    c += 5;
+    TS_ASSERT_EQUALS(c.value(), 100005);
+    TS_ASSERT_EQUALS(metrics::list_metrics()["test_counter"], 100005);
+
+    // a name can only be registered as one kind of metric
+    TS_ASSERT_THROWS_ANYTHING(metrics::get_gauge("test_counter"));
+  }
+
+  void test_gauges() {
+    metrics::gauge& g = metrics::get_gauge("test_gauge");
+    g.set(10);
+    g.add(-3);
+    TS_ASSERT_EQUALS(g.value(), 7);
+
+    int64_t v = 42;
+    metrics::register_gauge_function("test_gauge_function", "",
+                                     [&v]() { return v; });
+    TS_ASSERT_EQUALS(metrics::list_metrics()["test_gauge_function"], 42);
+    v = 43;
+    TS_ASSERT_EQUALS(metrics::list_metrics()["test_gauge_function"], 43);
+    metrics::register_gauge_function("test_gauge_function", "",
+                                     []() { return int64_t(0); });
+  }
+
+  void test_histogram() {
+    metrics::histogram& h = metrics::get_histogram("test_histogram", "Sizes.");
+    for (int64_t v : {0, 1, 2, 3, 4, 1000}) h.observe(v);
+    TS_ASSERT_EQUALS(h.count(), 6);
+    TS_ASSERT_EQUALS(h.sum(), 1010);
+
+    int64_t buckets[metrics::histogram::NUM_BUCKETS];
+    h.buckets(buckets);
+    TS_ASSERT_EQUALS(buckets[0], 1);   // 0
+    TS_ASSERT_EQUALS(buckets[1], 1);   // 1
+    TS_ASSERT_EQUALS(buckets[2], 2);   // 2, 3
+    TS_ASSERT_EQUALS(buckets[3], 1);   // 4
+    TS_ASSERT_EQUALS(buckets[10], 1);  // 1000
+
+    auto listed = metrics::list_metrics();
+    TS_ASSERT_EQUALS(listed["test_histogram_count"], 6);
+    TS_ASSERT_EQUALS(listed["test_histogram_sum"], 1010);
+  }
+
+  void test_prometheus_text() {
+    metrics::get_counter("test_text_counter", "Things counted.") += 3;
+    metrics::get_histogram("test_text_histogram").observe(2);
+    std::string text = metrics::prometheus_text();
+
+    TS_ASSERT(text.find("# HELP turi_test_text_counter Things counted.\n")
+              != std::string::npos);
+    TS_ASSERT(text.find("# TYPE turi_test_text_counter counter\n"
+                        "turi_test_text_counter 3\n") != std::string::npos);
+    TS_ASSERT(text.find("turi_test_text_histogram_bucket{le=\"1\"} 0\n")
+              != std::string::npos);
+    TS_ASSERT(text.find("turi_test_text_histogram_bucket{le=\"3\"} 1\n")
+              != std::string::npos);
+    TS_ASSERT(text.find("turi_test_text_histogram_bucket{le=\"+Inf\"} 1\n")
+              != std::string::npos);
+    TS_ASSERT(text.find("turi_thread_pool_queue_depth ") != std::string::npos);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_metrics_test, metrics_test)
+BOOST_AUTO_TEST_CASE(test_counter) {
+  metrics_test::test_counter();
+}
+BOOST_AUTO_TEST_CASE(test_gauges) {
+  metrics_test::test_gauges();
+}
+BOOST_AUTO_TEST_CASE(test_histogram) {
+  metrics_test::test_histogram();
+}
+BOOST_AUTO_TEST_CASE(test_prometheus_text) {
+  metrics_test::test_prometheus_text();
+}
+BOOST_AUTO_TEST_SUITE_END()
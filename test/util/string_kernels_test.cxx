@@ -0,0 +1,98 @@
+#define BOOST_TEST_MODULE
+#include <boost/test/unit_test.hpp>
+#include <core/util/test_macros.hpp>
+#include <algorithm>
+#include <cctype>
+#include <random>
+#include <string>
+#include <core/util/string_kernels.hpp>
+
+using namespace turi;
+using namespace turi::string_kernels;
+
+struct string_kernels_test {
+ public:
+  void test_substring_search() {
+    // small alphabets make for many partial matches
+    std::mt19937 rng(1);
+    for (size_t i = 0; i < 20000; ++i) {
+      std::string haystack, needle;
+      size_t haystack_len = rng() % 40;
+      size_t needle_len = rng() % 5;
+      for (size_t j = 0; j < haystack_len; ++j) haystack.push_back("ab\x80\x01"[rng() % 4]);
+      for (size_t j = 0; j < needle_len; ++j) needle.push_back("ab\x80\x01"[rng() % 4]);
+      substring_searcher searcher(needle);
+      TS_ASSERT_EQUALS(searcher.find(haystack.data(), haystack.size()),
+                       haystack.find(needle));
+      TS_ASSERT_EQUALS(searcher.contained_in(haystack),
+                       haystack.find(needle) != std::string::npos);
+    }
+    substring_searcher searcher("needle");
+    std::string haystack(1000, 'n');
+    TS_ASSERT(!searcher.contained_in(haystack));
+    haystack.replace(993, 6, "needle");
+    TS_ASSERT_EQUALS(searcher.find(haystack.data(), haystack.size()), 993);
+  }
+
+  void test_case_conversion() {
+    std::string all;
+    for (int c = 0; c < 256; ++c) all.push_back((char)c);
+    for (size_t offset = 0; offset < 8; ++offset) {
+      std::string s = all.substr(offset) + all.substr(0, offset);
+      std::string lower = s, upper = s, expected_lower = s, expected_upper = s;
+      ascii_to_lower(lower);
+      ascii_to_upper(upper);
+      for (auto& c: expected_lower) {
+        if (c >= 'A' && c <= 'Z') c = c - 'A' + 'a';
+      }
+      for (auto& c: expected_upper) {
+        if (c >= 'a' && c <= 'z') c = c - 'a' + 'A';
+      }
+      TS_ASSERT_EQUALS(lower, expected_lower);
+      TS_ASSERT_EQUALS(upper, expected_upper);
+    }
+    std::string s = "Hello WORLD, \xc3\x89t\xc3\xa9 Zebra";
+    ascii_to_lower(s);
+    TS_ASSERT_EQUALS(s, "hello world, \xc3\x89t\xc3\xa9 zebra");
+  }
+
+  void test_tokens() {
+    delimiter_set delimiters(" ,\n");
+    std::vector<std::string> tokens;
+    auto collect = [&](const char* s, size_t len) { tokens.emplace_back(s, len); };
+    std::string s = " hello, world\n\nfoo";
+    delimiters.for_each_token(s.data(), s.size(), collect);
+    TS_ASSERT_EQUALS(tokens.size(), 3);
+    TS_ASSERT_EQUALS(tokens[0], "hello");
+    TS_ASSERT_EQUALS(tokens[1], "world");
+    TS_ASSERT_EQUALS(tokens[2], "foo");
+    tokens.clear();
+    s = " ,, ";
+    delimiters.for_each_token(s.data(), s.size(), collect);
+    TS_ASSERT_EQUALS(tokens.size(), 0);
+  }
+
+  void test_regex_cache() {
+    auto a = cached_regex("[a-z]+");
+    auto b = cached_regex("[a-z]+");
+    TS_ASSERT_EQUALS(a.get(), b.get());
+    TS_ASSERT(boost::regex_match(std::string("abc"), *a));
+    TS_ASSERT(!boost::regex_match(std::string("ab1"), *a));
+    TS_ASSERT_THROWS_ANYTHING(cached_regex("[a-"));
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(_string_kernels_test, string_kernels_test)
+BOOST_AUTO_TEST_CASE(test_substring_search) {
+  string_kernels_test::test_substring_search();
+}
+BOOST_AUTO_TEST_CASE(test_case_conversion) {
+  string_kernels_test::test_case_conversion();
+}
+BOOST_AUTO_TEST_CASE(test_tokens) {
+  string_kernels_test::test_tokens();
+}
+BOOST_AUTO_TEST_CASE(test_regex_cache) {
+  string_kernels_test::test_regex_cache();
+}
+BOOST_AUTO_TEST_SUITE_END()